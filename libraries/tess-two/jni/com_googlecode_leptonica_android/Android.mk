@@ -31,6 +31,12 @@ LOCAL_SRC_FILES += \
   pix.cpp \
   pixa.cpp \
   utilities.cpp \
+  bitmapconvert.cpp \
+  parallel.cpp \
+  backgroundnorm.cpp \
+  pagedewarp.cpp \
+  rotate.cpp \
+  scale.cpp \
   readfile.cpp \
   writefile.cpp \
   jni.cpp
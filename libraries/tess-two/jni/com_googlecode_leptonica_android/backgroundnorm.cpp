@@ -0,0 +1,725 @@
+/*
+ * Copyright 2017, Google Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "backgroundnorm.h"
+#include "parallel.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__SSE2__)
+#define SSE2_BUILD 1
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define NEON_BUILD 1
+#include <arm_neon.h>
+#endif
+
+// Number of rows of an image that go through a horizontal pass together,
+// one in each byte of a vector.
+static const l_int32 kLanes = 16;
+
+/*********************
+ * Vector primitives *
+ *********************/
+
+// Sets dst to the bytewise maximum (dilate) or minimum of a and b. dst may
+// be a.
+static inline void extremeBytes(l_uint8 *dst, const l_uint8 *a, const l_uint8 *b, l_int32 n,
+                                bool dilate) {
+  l_int32 i = 0;
+#if defined(SSE2_BUILD)
+  for (; i + 16 <= n; i += 16) {
+    __m128i va = _mm_loadu_si128((const __m128i *) (a + i));
+    __m128i vb = _mm_loadu_si128((const __m128i *) (b + i));
+    _mm_storeu_si128((__m128i *) (dst + i), dilate ? _mm_max_epu8(va, vb) : _mm_min_epu8(va, vb));
+  }
+#elif defined(NEON_BUILD)
+  for (; i + 16 <= n; i += 16) {
+    uint8x16_t va = vld1q_u8(a + i);
+    uint8x16_t vb = vld1q_u8(b + i);
+    vst1q_u8(dst + i, dilate ? vmaxq_u8(va, vb) : vminq_u8(va, vb));
+  }
+#endif
+  if (dilate) {
+    for (; i < n; i++) {
+      dst[i] = L_MAX(a[i], b[i]);
+    }
+  } else {
+    for (; i < n; i++) {
+      dst[i] = L_MIN(a[i], b[i]);
+    }
+  }
+}
+
+// Sets dst[i] to min(255, (src[i] * (256 * hi[i] + lo[i])) / 256), which is
+// src[i] * hi[i] + (src[i] * lo[i]) / 256, so that all products fit in 16
+// bits.
+static void scaleBytes(const l_uint8 *src, const l_uint8 *hi, const l_uint8 *lo, l_int32 n,
+                       l_uint8 *dst) {
+  l_int32 i = 0;
+#if defined(SSE2_BUILD)
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i max = _mm_set1_epi16(255);
+  for (; i + 16 <= n; i += 16) {
+    __m128i s = _mm_loadu_si128((const __m128i *) (src + i));
+    __m128i h = _mm_loadu_si128((const __m128i *) (hi + i));
+    __m128i l = _mm_loadu_si128((const __m128i *) (lo + i));
+    __m128i s0 = _mm_unpacklo_epi8(s, zero);
+    __m128i s1 = _mm_unpackhi_epi8(s, zero);
+    __m128i t0 = _mm_adds_epu16(_mm_mullo_epi16(s0, _mm_unpacklo_epi8(h, zero)),
+                                _mm_srli_epi16(_mm_mullo_epi16(s0, _mm_unpacklo_epi8(l, zero)), 8));
+    __m128i t1 = _mm_adds_epu16(_mm_mullo_epi16(s1, _mm_unpackhi_epi8(h, zero)),
+                                _mm_srli_epi16(_mm_mullo_epi16(s1, _mm_unpackhi_epi8(l, zero)), 8));
+    // min(t, 255) as t - max(t - 255, 0), there being no unsigned 16 bit min.
+    t0 = _mm_sub_epi16(t0, _mm_subs_epu16(t0, max));
+    t1 = _mm_sub_epi16(t1, _mm_subs_epu16(t1, max));
+    _mm_storeu_si128((__m128i *) (dst + i), _mm_packus_epi16(t0, t1));
+  }
+#elif defined(NEON_BUILD)
+  for (; i + 8 <= n; i += 8) {
+    uint8x8_t s = vld1_u8(src + i);
+    uint16x8_t t = vqaddq_u16(vmull_u8(s, vld1_u8(hi + i)),
+                              vshrq_n_u16(vmull_u8(s, vld1_u8(lo + i)), 8));
+    vst1_u8(dst + i, vqmovn_u16(t));
+  }
+#endif
+  for (; i < n; i++) {
+    l_uint32 t = src[i] * hi[i] + ((src[i] * lo[i]) >> 8);
+    dst[i] = (l_uint8) L_MIN(t, 255);
+  }
+}
+
+/*******************
+ * Grey morphology *
+ *******************/
+
+// Runs a van Herk/Gil-Werman pass over a sequence of count elements of n
+// bytes each, the i-th at src + i * srcStride. For each o in [first, last)
+// it writes the bytewise extreme of the elements in [o - size / 2,
+// o + size / 2] that lie in the sequence to dst + (o - first) * dstStride.
+// work holds size + 1 elements, and identity one element of 0 for a
+// dilation or 255 for an erosion, which stands in for elements outside the
+// sequence.
+static void vhgwPass(const l_uint8 *src, l_int32 srcStride, l_int32 count, l_int32 n,
+                     l_uint8 *dst, l_int32 dstStride, l_int32 first, l_int32 last, l_int32 size,
+                     bool dilate, l_uint8 *work, const l_uint8 *identity) {
+  l_int32 half = size / 2;
+  l_uint8 *suffix = work;
+  l_uint8 *prefix = work + size * n;
+
+#define ELEMENT(i) ((i) >= 0 && (i) < count ? src + (i) * srcStride : identity)
+  for (l_int32 start = first - half; start + half < last; start += size) {
+    // Extremes from each element of the block to its end.
+    memcpy(suffix + (size - 1) * n, ELEMENT(start + size - 1), n);
+    for (l_int32 j = size - 2; j >= 0; j--) {
+      extremeBytes(suffix + j * n, suffix + (j + 1) * n, ELEMENT(start + j), n, dilate);
+    }
+
+    // The window of output start + half + j is the end of this block from
+    // j on, and the first j elements of the next block.
+    l_int32 o = start + half;
+    memcpy(dst + (o - first) * dstStride, suffix, n);
+    memcpy(prefix, ELEMENT(start + size), n);
+    for (l_int32 j = 1; j < size && o + j < last; j++) {
+      extremeBytes(dst + (o + j - first) * dstStride, suffix + j * n, prefix, n, dilate);
+      extremeBytes(prefix, prefix, ELEMENT(start + size + j), n, dilate);
+    }
+  }
+#undef ELEMENT
+}
+
+// One pass of a closing, from pixs to pixd, which have the same size.
+struct MorphPass {
+  PIX *pixs;
+  PIX *pixd;
+  l_int32 size;
+  bool dilate;
+};
+
+// Vertical pass over the rows [first, last). Pix rows are processed whole,
+// since the byte order in a word does not matter to a bytewise extreme.
+static void verticalPassRows(void *arg, l_int32 first, l_int32 last) {
+  MorphPass *pass = (MorphPass *) arg;
+  l_int32 rowBytes = 4 * pixGetWpl(pass->pixs);
+  l_uint8 *work = (l_uint8 *) malloc((pass->size + 2) * rowBytes);
+  if (work == NULL) {
+    return;
+  }
+  l_uint8 *identity = work + (pass->size + 1) * rowBytes;
+  memset(identity, pass->dilate ? 0 : 255, rowBytes);
+
+  vhgwPass((const l_uint8 *) pixGetData(pass->pixs), rowBytes, pixGetHeight(pass->pixs),
+           rowBytes, (l_uint8 *) pixGetData(pass->pixd) + first * rowBytes, rowBytes, first,
+           last, pass->size, pass->dilate, work, identity);
+
+  free(work);
+}
+
+// Horizontal pass over the groups of kLanes rows [first, last). The pixels
+// of a group are interleaved so that each element of the sequence holds a
+// column of the group.
+static void horizontalPassGroups(void *arg, l_int32 first, l_int32 last) {
+  MorphPass *pass = (MorphPass *) arg;
+  l_int32 w, h;
+  pixGetDimensions(pass->pixs, &w, &h, NULL);
+  l_int32 wpls = pixGetWpl(pass->pixs);
+  l_int32 wpld = pixGetWpl(pass->pixd);
+  l_uint8 *columns = (l_uint8 *) malloc((2 * w + pass->size + 2) * kLanes);
+  if (columns == NULL) {
+    return;
+  }
+  l_uint8 *extremes = columns + w * kLanes;
+  l_uint8 *work = extremes + w * kLanes;
+  l_uint8 *identity = work + (pass->size + 1) * kLanes;
+  memset(identity, pass->dilate ? 0 : 255, kLanes);
+
+  for (l_int32 group = first; group < last; group++) {
+    l_int32 y0 = group * kLanes;
+    l_int32 rows = L_MIN(kLanes, h - y0);
+    memset(columns, 0, w * kLanes);
+    for (l_int32 lane = 0; lane < rows; lane++) {
+      const l_uint32 *line = pixGetData(pass->pixs) + (y0 + lane) * wpls;
+      for (l_int32 x = 0; x < w; x++) {
+        columns[x * kLanes + lane] = GET_DATA_BYTE(line, x);
+      }
+    }
+
+    vhgwPass(columns, kLanes, w, kLanes, extremes, kLanes, 0, w, pass->size, pass->dilate,
+             work, identity);
+
+    for (l_int32 lane = 0; lane < rows; lane++) {
+      l_uint32 *line = pixGetData(pass->pixd) + (y0 + lane) * wpld;
+      for (l_int32 x = 0; x < w; x++) {
+        SET_DATA_BYTE(line, x, extremes[x * kLanes + lane]);
+      }
+    }
+  }
+
+  free(columns);
+}
+
+PIX *closeGrayParallel(PIX *pixs, l_int32 hsize, l_int32 vsize, l_int32 numThreads) {
+  if (pixs == NULL || pixGetDepth(pixs) != 8 || hsize < 1 || vsize < 1) {
+    return NULL;
+  }
+  hsize |= 1;
+  vsize |= 1;
+  if (hsize == 1 && vsize == 1) {
+    return pixCopy(NULL, pixs);
+  }
+
+  // The extremes over the brick are those over its rows of those over its
+  // columns, in either order, so a closing is a dilation and an erosion in
+  // each direction. Passes alternate between two images.
+  PIX *pixt[2] = { pixCreateTemplate(pixs), pixCreateTemplate(pixs) };
+  if (pixt[0] == NULL || pixt[1] == NULL) {
+    pixDestroy(&pixt[0]);
+    pixDestroy(&pixt[1]);
+    return NULL;
+  }
+
+  l_int32 h = pixGetHeight(pixs);
+  PIX *pixSrc = pixs;
+  l_int32 next = 0;
+  for (l_int32 step = 0; step < 4; step++) {
+    bool horizontal = (step % 2) == 0;
+    MorphPass pass;
+    pass.size = horizontal ? hsize : vsize;
+    if (pass.size == 1) {
+      continue;
+    }
+    pass.pixs = pixSrc;
+    pass.pixd = pixt[next];
+    pass.dilate = step < 2;
+    if (horizontal) {
+      runParallel(horizontalPassGroups, &pass, (h + kLanes - 1) / kLanes, 1, numThreads);
+    } else {
+      // Each chunk also reads size / 2 rows on either side of it.
+      runParallel(verticalPassRows, &pass, h, 4 * vsize, numThreads);
+    }
+    pixSrc = pixt[next];
+    next = 1 - next;
+  }
+
+  PIX *pixd = pixSrc;
+  pixDestroy(&pixt[next]);
+  pixSetPadBits(pixd, 0);
+  pixCopyResolution(pixd, pixs);
+
+  return pixd;
+}
+
+/**************************
+ * Background application *
+ **************************/
+
+struct MapApplication {
+  PIX *pixs;
+  PIX *pixm[3];  // the grey map, or the red, green and blue maps
+  PIX *pixd;
+  l_int32 sx;
+  l_int32 sy;
+};
+
+// Returns the map that scales the byte at pixel order position x of an
+// image line, or NULL for bytes that are set to 0: those beyond the image
+// and, at 32 bpp, alpha.
+static PIX *mapOfByte(const MapApplication *app, l_int32 x, l_int32 w, l_int32 d,
+                      l_int32 *index) {
+  if (d == 8) {
+    *index = x;
+    return x < w ? app->pixm[0] : NULL;
+  }
+  *index = x / 4;
+  l_int32 shift = 24 - 8 * (x % 4);
+  if (shift == L_RED_SHIFT) {
+    return app->pixm[0];
+  } else if (shift == L_GREEN_SHIFT) {
+    return app->pixm[1];
+  } else if (shift == L_BLUE_SHIFT) {
+    return app->pixm[2];
+  }
+  return NULL;
+}
+
+// Applies the map rows [first, last), each to sy rows of the image.
+static void applyMapRows(void *arg, l_int32 first, l_int32 last) {
+  MapApplication *app = (MapApplication *) arg;
+  l_int32 w, h, d, wm;
+  pixGetDimensions(app->pixs, &w, &h, &d);
+  wm = pixGetWidth(app->pixm[0]);
+  l_int32 wpls = pixGetWpl(app->pixs);
+  l_int32 wpld = pixGetWpl(app->pixd);
+  l_int32 wplm = pixGetWpl(app->pixm[0]);
+  l_int32 rowBytes = 4 * wpls;
+  l_uint8 *hi = (l_uint8 *) malloc(2 * rowBytes);
+  if (hi == NULL) {
+    return;
+  }
+  l_uint8 *lo = hi + rowBytes;
+
+  for (l_int32 i = first; i < last; i++) {
+    // The factor of every byte of a row, in the order of the Pix words.
+    // Pixels beyond the map are left 0, as by Leptonica.
+    for (l_int32 b = 0; b < rowBytes; b++) {
+#ifdef L_BIG_ENDIAN
+      l_int32 x = b;
+#else
+      l_int32 x = b ^ 3;
+#endif
+      l_int32 index;
+      PIX *pixm = mapOfByte(app, x, w, d, &index);
+      l_int32 j = index / app->sx;
+      l_uint32 val16 = (pixm != NULL && j < wm)
+          ? GET_DATA_TWO_BYTES(pixGetData(pixm) + i * wplm, j) : 0;
+      hi[b] = (l_uint8) (val16 >> 8);
+      lo[b] = (l_uint8) (val16 & 0xff);
+    }
+
+    l_int32 y1 = L_MIN(h, (i + 1) * app->sy);
+    for (l_int32 y = i * app->sy; y < y1; y++) {
+      scaleBytes((const l_uint8 *) (pixGetData(app->pixs) + y * wpls), hi, lo, rowBytes,
+                 (l_uint8 *) (pixGetData(app->pixd) + y * wpld));
+    }
+  }
+
+  free(hi);
+}
+
+PIX *applyInvBackgroundGrayMapParallel(PIX *pixs, PIX *pixm, l_int32 sx, l_int32 sy,
+                                       l_int32 numThreads) {
+  if (pixs == NULL || pixGetDepth(pixs) != 8 || pixGetColormap(pixs) != NULL ||
+      pixm == NULL || pixGetDepth(pixm) != 16 || sx <= 0 || sy <= 0) {
+    return NULL;
+  }
+
+  MapApplication app;
+  app.pixs = pixs;
+  app.pixm[0] = pixm;
+  app.pixd = pixCreateTemplate(pixs);
+  app.sx = sx;
+  app.sy = sy;
+  if (app.pixd == NULL) {
+    return NULL;
+  }
+
+  l_int32 rows = L_MIN(pixGetHeight(pixm), (pixGetHeight(pixs) + sy - 1) / sy);
+  runParallel(applyMapRows, &app, rows, 1, numThreads);
+
+  return app.pixd;
+}
+
+PIX *applyInvBackgroundRGBMapParallel(PIX *pixs, PIX *pixmr, PIX *pixmg, PIX *pixmb,
+                                      l_int32 sx, l_int32 sy, l_int32 numThreads) {
+  if (pixs == NULL || pixGetDepth(pixs) != 32 || pixmr == NULL || pixmg == NULL ||
+      pixmb == NULL || pixGetDepth(pixmr) != 16 || !pixSizesEqual(pixmr, pixmg) ||
+      !pixSizesEqual(pixmr, pixmb) || sx <= 0 || sy <= 0) {
+    return NULL;
+  }
+
+  MapApplication app;
+  app.pixs = pixs;
+  app.pixm[0] = pixmr;
+  app.pixm[1] = pixmg;
+  app.pixm[2] = pixmb;
+  app.pixd = pixCreateTemplate(pixs);
+  app.sx = sx;
+  app.sy = sy;
+  if (app.pixd == NULL) {
+    return NULL;
+  }
+
+  l_int32 rows = L_MIN(pixGetHeight(pixmr), (pixGetHeight(pixs) + sy - 1) / sy);
+  runParallel(applyMapRows, &app, rows, 1, numThreads);
+
+  return app.pixd;
+}
+
+PIX *backgroundNormParallel(PIX *pixs, l_int32 sx, l_int32 sy, l_int32 thresh,
+                            l_int32 mincount, l_int32 bgval, l_int32 smoothx, l_int32 smoothy,
+                            l_int32 numThreads) {
+  l_int32 d = pixs ? pixGetDepth(pixs) : 0;
+  if ((d != 8 && d != 32) || pixGetColormap(pixs) != NULL || sx < 4 || sy < 4 ||
+      mincount > sx * sy) {
+    // Leptonica reports the errors, and warns of a mincount it changes.
+    return pixBackgroundNorm(pixs, NULL, NULL, sx, sy, thresh, mincount, bgval, smoothx,
+                             smoothy);
+  }
+
+  // The steps of pixBackgroundNorm, without the image mask. The maps are
+  // at the tile scale, so only their application is worth splitting.
+  PIX *pixd = NULL;
+  if (d == 8) {
+    PIX *pixm = NULL;
+    pixGetBackgroundGrayMap(pixs, NULL, sx, sy, thresh, mincount, &pixm);
+    if (pixm == NULL) {
+      return pixCopy(NULL, pixs);
+    }
+    PIX *pixmi = pixGetInvBackgroundMap(pixm, bgval, smoothx, smoothy);
+    if (pixmi != NULL) {
+      pixd = applyInvBackgroundGrayMapParallel(pixs, pixmi, sx, sy, numThreads);
+    }
+    pixDestroy(&pixm);
+    pixDestroy(&pixmi);
+  } else {
+    PIX *pixmr = NULL, *pixmg = NULL, *pixmb = NULL;
+    pixGetBackgroundRGBMap(pixs, NULL, NULL, sx, sy, thresh, mincount, &pixmr, &pixmg, &pixmb);
+    if (pixmr == NULL || pixmg == NULL || pixmb == NULL) {
+      pixDestroy(&pixmr);
+      pixDestroy(&pixmg);
+      pixDestroy(&pixmb);
+      return pixCopy(NULL, pixs);
+    }
+    PIX *pixmri = pixGetInvBackgroundMap(pixmr, bgval, smoothx, smoothy);
+    PIX *pixmgi = pixGetInvBackgroundMap(pixmg, bgval, smoothx, smoothy);
+    PIX *pixmbi = pixGetInvBackgroundMap(pixmb, bgval, smoothx, smoothy);
+    if (pixmri != NULL && pixmgi != NULL && pixmbi != NULL) {
+      pixd = applyInvBackgroundRGBMapParallel(pixs, pixmri, pixmgi, pixmbi, sx, sy,
+                                              numThreads);
+    }
+    pixDestroy(&pixmr);
+    pixDestroy(&pixmg);
+    pixDestroy(&pixmb);
+    pixDestroy(&pixmri);
+    pixDestroy(&pixmgi);
+    pixDestroy(&pixmbi);
+  }
+  if (pixd != NULL) {
+    pixCopyResolution(pixd, pixs);
+  }
+
+  return pixd;
+}
+
+PIX *backgroundNormMorphParallel(PIX *pixs, l_int32 reduction, l_int32 size, l_int32 bgval,
+                                 l_int32 numThreads) {
+  if (pixs == NULL || pixGetDepth(pixs) != 8 || pixGetColormap(pixs) != NULL ||
+      reduction < 2 || reduction > 16 || size < 1) {
+    // Leptonica handles colour and reports the errors.
+    return pixBackgroundNormMorph(pixs, NULL, reduction, size, bgval);
+  }
+
+  // The steps of pixGetBackgroundGrayMapMorph, without the image mask.
+  l_int32 w, h;
+  pixGetDimensions(pixs, &w, &h, NULL);
+  l_float32 scale = 1. / (l_float32) reduction;
+  PIX *pixr = pixScaleBySampling(pixs, scale, scale);
+  PIX *pixc = closeGrayParallel(pixr, size, size, numThreads);
+  PIX *pixm = pixc ? pixExtendByReplication(pixc, 1, 1) : NULL;
+  pixDestroy(&pixr);
+  pixDestroy(&pixc);
+  if (pixm == NULL || pixFillMapHoles(pixm, w / reduction, h / reduction, L_FILL_BLACK)) {
+    pixDestroy(&pixm);
+    return NULL;
+  }
+
+  PIX *pixmi = pixGetInvBackgroundMap(pixm, bgval, 0, 0);
+  PIX *pixd = NULL;
+  if (pixmi != NULL) {
+    pixd = applyInvBackgroundGrayMapParallel(pixs, pixmi, reduction, reduction, numThreads);
+  }
+  pixDestroy(&pixm);
+  pixDestroy(&pixmi);
+  if (pixd != NULL) {
+    pixCopyResolution(pixd, pixs);
+  }
+
+  return pixd;
+}
+
+/*************************
+ * Contrast normalization *
+ *************************/
+
+// Number of LUTs of the linear TRC, one for each difference between the
+// max and min of a tile.
+static const l_int32 kTrcCount = 256;
+
+struct TileExtremes {
+  PIX *pixs;
+  PIX *pixmin;
+  PIX *pixmax;
+  l_int32 xfact;
+  l_int32 yfact;
+};
+
+// Finds the min and max of the tiles in the tile rows [first, last), as
+// pixScaleGrayMinMax does for each. The rows of a tile row are reduced to
+// bytewise extremes a whole Pix row at a time, and then each tile to the
+// extremes of its columns, so that each pixel is read once for both.
+static void extremeTileRows(void *arg, l_int32 first, l_int32 last) {
+  TileExtremes *ext = (TileExtremes *) arg;
+  l_int32 wd = pixGetWidth(ext->pixmin);
+  l_int32 wpls = pixGetWpl(ext->pixs);
+  l_int32 wpld = pixGetWpl(ext->pixmin);
+  l_int32 rowBytes = 4 * wpls;
+  l_uint32 *rowmin = (l_uint32 *) malloc(2 * rowBytes);
+  if (rowmin == NULL) {
+    return;
+  }
+  l_uint32 *rowmax = rowmin + wpls;
+
+  for (l_int32 i = first; i < last; i++) {
+    const l_uint32 *lines = pixGetData(ext->pixs) + i * ext->yfact * wpls;
+    memcpy(rowmin, lines, rowBytes);
+    memcpy(rowmax, lines, rowBytes);
+    for (l_int32 k = 1; k < ext->yfact; k++) {
+      const l_uint8 *row = (const l_uint8 *) (lines + k * wpls);
+      extremeBytes((l_uint8 *) rowmin, (const l_uint8 *) rowmin, row, rowBytes, false);
+      extremeBytes((l_uint8 *) rowmax, (const l_uint8 *) rowmax, row, rowBytes, true);
+    }
+
+    l_uint32 *linemin = pixGetData(ext->pixmin) + i * wpld;
+    l_uint32 *linemax = pixGetData(ext->pixmax) + i * wpld;
+    for (l_int32 j = 0; j < wd; j++) {
+      l_int32 minval = 255, maxval = 0;
+      for (l_int32 x = j * ext->xfact; x < (j + 1) * ext->xfact; x++) {
+        minval = L_MIN(minval, (l_int32) GET_DATA_BYTE(rowmin, x));
+        maxval = L_MAX(maxval, (l_int32) GET_DATA_BYTE(rowmax, x));
+      }
+      SET_DATA_BYTE(linemin, j, minval);
+      SET_DATA_BYTE(linemax, j, maxval);
+    }
+  }
+
+  free(rowmin);
+}
+
+l_int32 minMaxTilesParallel(PIX *pixs, l_int32 sx, l_int32 sy, l_int32 mindiff,
+                            l_int32 smoothx, l_int32 smoothy, PIX **ppixmin, PIX **ppixmax,
+                            l_int32 numThreads) {
+  if (ppixmin == NULL || ppixmax == NULL || pixs == NULL || pixGetDepth(pixs) != 8 ||
+      pixGetColormap(pixs) != NULL || sx < 5 || sy < 5 || smoothx < 0 || smoothy < 0 ||
+      smoothx > 5 || smoothy > 5) {
+    // Leptonica reports the errors.
+    return pixMinMaxTiles(pixs, sx, sy, mindiff, smoothx, smoothy, ppixmin, ppixmax);
+  }
+  *ppixmin = *ppixmax = NULL;
+
+  // The tiles of pixScaleGrayMinMax: whole tiles only, or a single tile
+  // of the whole width or height if there is not one.
+  l_int32 w, h;
+  pixGetDimensions(pixs, &w, &h, NULL);
+  TileExtremes ext;
+  ext.pixs = pixs;
+  ext.xfact = (w / sx == 0) ? w : sx;
+  ext.yfact = (h / sy == 0) ? h : sy;
+  l_int32 wd = w / ext.xfact;
+  l_int32 hd = h / ext.yfact;
+  ext.pixmin = pixCreate(wd, hd, 8);
+  ext.pixmax = pixCreate(wd, hd, 8);
+  if (ext.pixmin == NULL || ext.pixmax == NULL) {
+    pixDestroy(&ext.pixmin);
+    pixDestroy(&ext.pixmax);
+    return 1;
+  }
+  runParallel(extremeTileRows, &ext, hd, 1, numThreads);
+
+  // The rest of pixMinMaxTiles works on the maps.
+  PIX *pixmin = pixExtendByReplication(ext.pixmin, 1, 1);
+  PIX *pixmax = pixExtendByReplication(ext.pixmax, 1, 1);
+  pixDestroy(&ext.pixmin);
+  pixDestroy(&ext.pixmax);
+  if (pixmin == NULL || pixmax == NULL) {
+    pixDestroy(&pixmin);
+    pixDestroy(&pixmax);
+    return 1;
+  }
+  pixAddConstantGray(pixmin, 1);
+  pixAddConstantGray(pixmax, 1);
+  pixSetLowContrast(pixmin, pixmax, mindiff);
+  l_int32 wm, hm;
+  pixGetDimensions(pixmin, &wm, &hm, NULL);
+  pixFillMapHoles(pixmin, wm, hm, L_FILL_BLACK);
+  pixFillMapHoles(pixmax, wm, hm, L_FILL_BLACK);
+  if (smoothx > 0 || smoothy > 0) {
+    smoothx = L_MIN(smoothx, (wm - 1) / 2);
+    smoothy = L_MIN(smoothy, (hm - 1) / 2);
+    *ppixmin = pixBlockconv(pixmin, smoothx, smoothy);
+    *ppixmax = pixBlockconv(pixmax, smoothx, smoothy);
+  } else {
+    *ppixmin = pixClone(pixmin);
+    *ppixmax = pixClone(pixmax);
+  }
+  pixDestroy(&pixmin);
+  pixDestroy(&pixmax);
+  if (*ppixmin == NULL || *ppixmax == NULL) {
+    pixDestroy(ppixmin);
+    pixDestroy(ppixmax);
+    return 1;
+  }
+  pixCopyResolution(*ppixmin, pixs);
+  pixCopyResolution(*ppixmax, pixs);
+
+  return 0;
+}
+
+struct TrcApplication {
+  PIX *pixs;
+  PIX *pixmin;
+  PIX *pixmax;
+  PIX *pixd;
+  l_int32 sx;
+  l_int32 sy;
+  const l_uint8 *luts;  // kTrcCount LUTs of 256 entries
+};
+
+// Maps the rows of the image in the tile rows [first, last), a whole line
+// at a time. Each line is copied, and then each tile of it that has a
+// valid min and max goes through the LUT for their difference, as in
+// pixLinearTRCTiled. Pixels outside the map, and the pad bits, keep their
+// values.
+static void trcTileRows(void *arg, l_int32 first, l_int32 last) {
+  TrcApplication *app = (TrcApplication *) arg;
+  l_int32 w, h, wt, ht;
+  pixGetDimensions(app->pixs, &w, &h, NULL);
+  pixGetDimensions(app->pixmin, &wt, &ht, NULL);
+  l_int32 wpls = pixGetWpl(app->pixs);
+  l_int32 wpld = pixGetWpl(app->pixd);
+  l_int32 wplt = pixGetWpl(app->pixmin);
+  l_int32 nx = L_MIN(wt, (w + app->sx - 1) / app->sx);
+
+  for (l_int32 i = first; i < last; i++) {
+    const l_uint32 *linemin = pixGetData(app->pixmin) + i * wplt;
+    const l_uint32 *linemax = pixGetData(app->pixmax) + i * wplt;
+    l_int32 y1 = L_MIN(h, (i + 1) * app->sy);
+    for (l_int32 y = i * app->sy; y < y1; y++) {
+      const l_uint32 *lines = pixGetData(app->pixs) + y * wpls;
+      l_uint32 *lined = pixGetData(app->pixd) + y * wpld;
+      if (lined != lines) {
+        memcpy(lined, lines, 4 * wpls);
+      }
+      if (i >= ht) {
+        continue;
+      }
+      for (l_int32 j = 0; j < nx; j++) {
+        l_int32 minval = GET_DATA_BYTE(linemin, j);
+        l_int32 diff = GET_DATA_BYTE(linemax, j) - minval;
+        if (diff <= 0) {  // not expected, and left unchanged
+          continue;
+        }
+        const l_uint8 *lut = app->luts + 256 * diff;
+        l_int32 x1 = L_MIN(w, (j + 1) * app->sx);
+        for (l_int32 x = j * app->sx; x < x1; x++) {
+          l_int32 sval = GET_DATA_BYTE(lined, x) - minval;
+          SET_DATA_BYTE(lined, x, lut[L_MAX(0, sval)]);
+        }
+      }
+    }
+  }
+}
+
+PIX *linearTRCTiledParallel(PIX *pixs, l_int32 sx, l_int32 sy, PIX *pixmin, PIX *pixmax,
+                            l_int32 numThreads) {
+  if (pixs == NULL || pixGetDepth(pixs) != 8 || pixGetColormap(pixs) != NULL ||
+      pixmin == NULL || pixmax == NULL || pixGetDepth(pixmin) != 8 ||
+      !pixSizesEqual(pixmin, pixmax) || sx < 5 || sy < 5) {
+    return NULL;
+  }
+
+  // The LUTs of iaaGetLinearTRC, made up front for all differences so
+  // that the threads only read them.
+  l_uint8 *luts = (l_uint8 *) malloc(kTrcCount * 256);
+  if (luts == NULL) {
+    return NULL;
+  }
+  memset(luts, 128, 256);
+  for (l_int32 diff = 1; diff < kTrcCount; diff++) {
+    l_uint8 *lut = luts + 256 * diff;
+    l_float32 factor = 255. / (l_float32) diff;
+    for (l_int32 i = 0; i < 256; i++) {
+      lut[i] = (i <= diff) ? (l_uint8) (l_int32) (factor * i + 0.5) : 255;
+    }
+  }
+
+  TrcApplication app;
+  app.pixs = pixs;
+  app.pixmin = pixmin;
+  app.pixmax = pixmax;
+  app.pixd = pixCreateTemplateNoInit(pixs);
+  app.sx = sx;
+  app.sy = sy;
+  app.luts = luts;
+  if (app.pixd != NULL) {
+    runParallel(trcTileRows, &app, (pixGetHeight(pixs) + sy - 1) / sy, 1, numThreads);
+  }
+
+  free(luts);
+  return app.pixd;
+}
+
+PIX *contrastNormParallel(PIX *pixs, l_int32 sx, l_int32 sy, l_int32 mindiff, l_int32 smoothx,
+                          l_int32 smoothy, l_int32 numThreads) {
+  if (pixs == NULL || pixGetDepth(pixs) != 8 || pixGetColormap(pixs) != NULL || sx < 5 ||
+      sy < 5 || smoothx < 0 || smoothy < 0 || smoothx > 5 || smoothy > 5) {
+    // Leptonica reports the errors.
+    return pixContrastNorm(NULL, pixs, sx, sy, mindiff, smoothx, smoothy);
+  }
+
+  // Measuring the tiles and mapping them are the two passes over the
+  // image; the map is made without a copy of pixs.
+  PIX *pixmin = NULL, *pixmax = NULL;
+  PIX *pixd = NULL;
+  if (minMaxTilesParallel(pixs, sx, sy, mindiff, smoothx, smoothy, &pixmin, &pixmax,
+                          numThreads) == 0) {
+    pixd = linearTRCTiledParallel(pixs, sx, sy, pixmin, pixmax, numThreads);
+  }
+  pixDestroy(&pixmin);
+  pixDestroy(&pixmax);
+
+  return pixd;
+}
@@ -0,0 +1,70 @@
+/*
+ * Copyright 2017, Google Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LEPTONICA_JNI_BACKGROUNDNORM_H
+#define LEPTONICA_JNI_BACKGROUNDNORM_H
+
+#include <allheaders.h>
+
+// Background and contrast normalization split across threads, with SSE2 and
+// NEON versions of the inner loops where the build targets them. The
+// results are the same as those of the Leptonica functions named.
+// numThreads <= 0 uses one thread per core.
+
+// Closes an 8 bpp image with an hsize x vsize brick, as pixCloseGray.
+PIX *closeGrayParallel(PIX *pixs, l_int32 hsize, l_int32 vsize, l_int32 numThreads);
+
+// Multiplies an 8 bpp image by a 16 bpp inverse background map of sx x sy
+// tiles, as pixApplyInvBackgroundGrayMap.
+PIX *applyInvBackgroundGrayMapParallel(PIX *pixs, PIX *pixm, l_int32 sx, l_int32 sy,
+                                       l_int32 numThreads);
+
+// Multiplies the components of a 32 bpp image by 16 bpp inverse background
+// maps of sx x sy tiles, as pixApplyInvBackgroundRGBMap.
+PIX *applyInvBackgroundRGBMapParallel(PIX *pixs, PIX *pixmr, PIX *pixmg, PIX *pixmb,
+                                      l_int32 sx, l_int32 sy, l_int32 numThreads);
+
+// Normalizes the background of an 8 or 32 bpp image, as pixBackgroundNorm
+// with no image mask or grey image. Anything else is passed on to
+// pixBackgroundNorm.
+PIX *backgroundNormParallel(PIX *pixs, l_int32 sx, l_int32 sy, l_int32 thresh,
+                            l_int32 mincount, l_int32 bgval, l_int32 smoothx, l_int32 smoothy,
+                            l_int32 numThreads);
+
+// Normalizes the background of an 8 bpp image, as pixBackgroundNormMorph
+// with no image mask. Other depths are passed on to pixBackgroundNormMorph.
+PIX *backgroundNormMorphParallel(PIX *pixs, l_int32 reduction, l_int32 size, l_int32 bgval,
+                                 l_int32 numThreads);
+
+// Finds the smoothed min and max of each sx x sy tile of an 8 bpp image, as
+// pixMinMaxTiles. Both are found in one pass over the image, a band of tile
+// rows per thread. Invalid arguments are passed on to pixMinMaxTiles.
+l_int32 minMaxTilesParallel(PIX *pixs, l_int32 sx, l_int32 sy, l_int32 mindiff,
+                            l_int32 smoothx, l_int32 smoothy, PIX **ppixmin, PIX **ppixmax,
+                            l_int32 numThreads);
+
+// Maps each sx x sy tile of an 8 bpp image linearly from the min and max
+// in pixmin and pixmax to the full range, as pixLinearTRCTiled with a null
+// pixd. The image is read and written once, a band of tile rows per thread.
+PIX *linearTRCTiledParallel(PIX *pixs, l_int32 sx, l_int32 sy, PIX *pixmin, PIX *pixmax,
+                            l_int32 numThreads);
+
+// Expands the contrast of each tile of an 8 bpp image, as pixContrastNorm
+// with a null pixd. Invalid arguments are passed on to pixContrastNorm.
+PIX *contrastNormParallel(PIX *pixs, l_int32 sx, l_int32 sy, l_int32 mindiff, l_int32 smoothx,
+                          l_int32 smoothy, l_int32 numThreads);
+
+#endif
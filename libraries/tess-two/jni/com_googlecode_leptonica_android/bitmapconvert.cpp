@@ -0,0 +1,279 @@
+/*
+ * Copyright 2017, Google Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "bitmapconvert.h"
+
+#include <string.h>
+
+// The vector code assumes a little-endian host, as Android always is.
+#ifndef L_BIG_ENDIAN
+#if defined(__SSE2__)
+#define SSE2_BUILD 1
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define NEON_BUILD 1
+#include <arm_neon.h>
+#endif
+#endif
+
+// A luma formula in 16 bit integers: grey is the top 16 bits of
+// (red * r + green * g + blue * b + bias) * multiplier, which is exact for
+// the formulas given, and can not overflow 16 bits before the multiply.
+struct LumaWeights {
+  l_uint16 red;
+  l_uint16 green;
+  l_uint16 blue;
+  l_uint16 bias;
+  l_uint16 multiplier;
+};
+
+static const LumaWeights kLumaWeights[LUMA_FORMULA_COUNT] = {
+  // (r + g + b) / 3, as 21846 / 65536 takes the floor of x / 3 for x < 768.
+  { 1, 1, 1, 0, 21846 },
+  // (3 r + 5 g + 2 b + 5) / 10, the rounded Leptonica weights, as
+  // 6554 / 65536 takes the floor of x / 10 for x < 2560.
+  { 3, 5, 2, 5, 6554 },
+  // (77 r + 150 g + 29 b + 128) / 256.
+  { 77, 150, 29, 128, 256 },
+};
+
+static inline l_uint32 lumaOf(const LumaWeights &weights, l_uint32 r, l_uint32 g, l_uint32 b) {
+  l_uint32 sum = weights.red * r + weights.green * g + weights.blue * b + weights.bias;
+  return (sum * weights.multiplier) >> 16;
+}
+
+// Opaque black and white RGBA_8888 pixels, four for each value of a nibble
+// of a 1 bpp row, in which a set bit is black.
+static const l_uint8 kNibblePixels[16][16] = {
+#define BW(bit) (bit) ? 0x00 : 0xff, (bit) ? 0x00 : 0xff, (bit) ? 0x00 : 0xff, 0xff
+#define NIBBLE(n) { BW((n) & 8), BW((n) & 4), BW((n) & 2), BW((n) & 1) }
+  NIBBLE(0), NIBBLE(1), NIBBLE(2), NIBBLE(3), NIBBLE(4), NIBBLE(5), NIBBLE(6), NIBBLE(7),
+  NIBBLE(8), NIBBLE(9), NIBBLE(10), NIBBLE(11), NIBBLE(12), NIBBLE(13), NIBBLE(14), NIBBLE(15),
+#undef NIBBLE
+#undef BW
+};
+
+#ifdef SSE2_BUILD
+
+// Reverses the bytes of each word, between memory order and Pix order.
+static inline __m128i byteSwap32(__m128i v) {
+  v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+  v = _mm_shufflelo_epi16(v, _MM_SHUFFLE(2, 3, 0, 1));
+  return _mm_shufflehi_epi16(v, _MM_SHUFFLE(2, 3, 0, 1));
+}
+
+// Returns the luma of 8 pixels given as 16 bit channels.
+static inline __m128i lumaOf8(const LumaWeights &weights, __m128i r, __m128i g, __m128i b) {
+  __m128i sum = _mm_add_epi16(_mm_mullo_epi16(r, _mm_set1_epi16(weights.red)),
+                              _mm_mullo_epi16(g, _mm_set1_epi16(weights.green)));
+  sum = _mm_add_epi16(sum, _mm_mullo_epi16(b, _mm_set1_epi16(weights.blue)));
+  sum = _mm_add_epi16(sum, _mm_set1_epi16(weights.bias));
+  return _mm_mulhi_epu16(sum, _mm_set1_epi16(weights.multiplier));
+}
+
+// Returns the luma of the 8 RGBA_8888 pixels in p0 and p1.
+static inline __m128i lumaOfRGBA8(const LumaWeights &weights, __m128i p0, __m128i p1) {
+  const __m128i mask = _mm_set1_epi32(0xff);
+  __m128i r = _mm_packs_epi32(_mm_and_si128(p0, mask), _mm_and_si128(p1, mask));
+  __m128i g = _mm_packs_epi32(_mm_and_si128(_mm_srli_epi32(p0, 8), mask),
+                              _mm_and_si128(_mm_srli_epi32(p1, 8), mask));
+  __m128i b = _mm_packs_epi32(_mm_and_si128(_mm_srli_epi32(p0, 16), mask),
+                              _mm_and_si128(_mm_srli_epi32(p1, 16), mask));
+  return lumaOf8(weights, r, g, b);
+}
+
+// Returns the luma of 8 RGB_565 pixels.
+static inline __m128i lumaOfRGB565(const LumaWeights &weights, __m128i p) {
+  __m128i r = _mm_srli_epi16(p, 11);
+  __m128i g = _mm_and_si128(_mm_srli_epi16(p, 5), _mm_set1_epi16(0x3f));
+  __m128i b = _mm_and_si128(p, _mm_set1_epi16(0x1f));
+  r = _mm_or_si128(_mm_slli_epi16(r, 3), _mm_srli_epi16(r, 2));
+  g = _mm_or_si128(_mm_slli_epi16(g, 2), _mm_srli_epi16(g, 4));
+  b = _mm_or_si128(_mm_slli_epi16(b, 3), _mm_srli_epi16(b, 2));
+  return lumaOf8(weights, r, g, b);
+}
+
+#endif  // SSE2_BUILD
+
+#ifdef NEON_BUILD
+
+// Returns the luma of 8 pixels given as 16 bit channels.
+static inline uint8x8_t lumaOf8(const LumaWeights &weights, uint16x8_t r, uint16x8_t g,
+                                uint16x8_t b) {
+  uint16x8_t sum = vdupq_n_u16(weights.bias);
+  sum = vmlaq_n_u16(sum, r, weights.red);
+  sum = vmlaq_n_u16(sum, g, weights.green);
+  sum = vmlaq_n_u16(sum, b, weights.blue);
+  uint32x4_t lo = vmull_n_u16(vget_low_u16(sum), weights.multiplier);
+  uint32x4_t hi = vmull_n_u16(vget_high_u16(sum), weights.multiplier);
+  return vmovn_u16(vcombine_u16(vshrn_n_u32(lo, 16), vshrn_n_u32(hi, 16)));
+}
+
+// Returns the luma of 8 RGB_565 pixels.
+static inline uint8x8_t lumaOfRGB565(const LumaWeights &weights, uint16x8_t p) {
+  uint16x8_t r = vshrq_n_u16(p, 11);
+  uint16x8_t g = vandq_u16(vshrq_n_u16(p, 5), vdupq_n_u16(0x3f));
+  uint16x8_t b = vandq_u16(p, vdupq_n_u16(0x1f));
+  r = vorrq_u16(vshlq_n_u16(r, 3), vshrq_n_u16(r, 2));
+  g = vorrq_u16(vshlq_n_u16(g, 2), vshrq_n_u16(g, 4));
+  b = vorrq_u16(vshlq_n_u16(b, 3), vshrq_n_u16(b, 2));
+  return lumaOf8(weights, r, g, b);
+}
+
+#endif  // NEON_BUILD
+
+void convertRGBA8888RowToGrey(const l_uint8 *src, l_int32 width, LumaFormula formula,
+                              l_uint32 *dst) {
+  const LumaWeights &weights = kLumaWeights[formula];
+  l_int32 x = 0;
+#if defined(SSE2_BUILD)
+  for (; x + 16 <= width; x += 16) {
+    const __m128i *pixels = (const __m128i *) (src + 4 * x);
+    __m128i lo = lumaOfRGBA8(weights, _mm_loadu_si128(pixels), _mm_loadu_si128(pixels + 1));
+    __m128i hi = lumaOfRGBA8(weights, _mm_loadu_si128(pixels + 2), _mm_loadu_si128(pixels + 3));
+    _mm_storeu_si128((__m128i *) (dst + x / 4), byteSwap32(_mm_packus_epi16(lo, hi)));
+  }
+#elif defined(NEON_BUILD)
+  for (; x + 16 <= width; x += 16) {
+    uint8x16x4_t pixels = vld4q_u8(src + 4 * x);
+    uint8x8_t lo = lumaOf8(weights, vmovl_u8(vget_low_u8(pixels.val[0])),
+                           vmovl_u8(vget_low_u8(pixels.val[1])),
+                           vmovl_u8(vget_low_u8(pixels.val[2])));
+    uint8x8_t hi = lumaOf8(weights, vmovl_u8(vget_high_u8(pixels.val[0])),
+                           vmovl_u8(vget_high_u8(pixels.val[1])),
+                           vmovl_u8(vget_high_u8(pixels.val[2])));
+    vst1q_u8((uint8_t *) (dst + x / 4), vrev32q_u8(vcombine_u8(lo, hi)));
+  }
+#endif
+  for (; x < width; x++) {
+    const l_uint8 *pixel = src + 4 * x;
+    SET_DATA_BYTE(dst, x, lumaOf(weights, pixel[0], pixel[1], pixel[2]));
+  }
+}
+
+void convertRGB565RowToGrey(const l_uint16 *src, l_int32 width, LumaFormula formula,
+                            l_uint32 *dst) {
+  const LumaWeights &weights = kLumaWeights[formula];
+  l_int32 x = 0;
+#if defined(SSE2_BUILD)
+  for (; x + 16 <= width; x += 16) {
+    const __m128i *pixels = (const __m128i *) (src + x);
+    __m128i lo = lumaOfRGB565(weights, _mm_loadu_si128(pixels));
+    __m128i hi = lumaOfRGB565(weights, _mm_loadu_si128(pixels + 1));
+    _mm_storeu_si128((__m128i *) (dst + x / 4), byteSwap32(_mm_packus_epi16(lo, hi)));
+  }
+#elif defined(NEON_BUILD)
+  for (; x + 16 <= width; x += 16) {
+    uint8x8_t lo = lumaOfRGB565(weights, vld1q_u16(src + x));
+    uint8x8_t hi = lumaOfRGB565(weights, vld1q_u16(src + x + 8));
+    vst1q_u8((uint8_t *) (dst + x / 4), vrev32q_u8(vcombine_u8(lo, hi)));
+  }
+#endif
+  for (; x < width; x++) {
+    l_uint32 r = src[x] >> 11;
+    l_uint32 g = (src[x] >> 5) & 0x3f;
+    l_uint32 b = src[x] & 0x1f;
+    SET_DATA_BYTE(dst, x, lumaOf(weights, (r << 3) | (r >> 2), (g << 2) | (g >> 4),
+                                 (b << 3) | (b >> 2)));
+  }
+}
+
+void convertBytesRowToGrey(const l_uint8 *src, l_int32 width, l_uint32 *dst) {
+  l_int32 x = 0;
+#if defined(SSE2_BUILD)
+  for (; x + 16 <= width; x += 16) {
+    __m128i pixels = _mm_loadu_si128((const __m128i *) (src + x));
+    _mm_storeu_si128((__m128i *) (dst + x / 4), byteSwap32(pixels));
+  }
+#elif defined(NEON_BUILD)
+  for (; x + 16 <= width; x += 16) {
+    vst1q_u8((uint8_t *) (dst + x / 4), vrev32q_u8(vld1q_u8(src + x)));
+  }
+#endif
+  for (; x < width; x++) {
+    SET_DATA_BYTE(dst, x, src[x]);
+  }
+}
+
+void convertGreyRowToRGBA8888(const l_uint32 *src, l_int32 width, l_uint8 *dst) {
+  l_int32 x = 0;
+#if defined(SSE2_BUILD)
+  const __m128i alpha = _mm_set1_epi32((int) 0xff000000);
+  for (; x + 16 <= width; x += 16) {
+    __m128i grey = byteSwap32(_mm_loadu_si128((const __m128i *) (src + x / 4)));
+    __m128i lo = _mm_unpacklo_epi8(grey, grey);
+    __m128i hi = _mm_unpackhi_epi8(grey, grey);
+    __m128i *pixels = (__m128i *) (dst + 4 * x);
+    _mm_storeu_si128(pixels, _mm_or_si128(_mm_unpacklo_epi16(lo, lo), alpha));
+    _mm_storeu_si128(pixels + 1, _mm_or_si128(_mm_unpackhi_epi16(lo, lo), alpha));
+    _mm_storeu_si128(pixels + 2, _mm_or_si128(_mm_unpacklo_epi16(hi, hi), alpha));
+    _mm_storeu_si128(pixels + 3, _mm_or_si128(_mm_unpackhi_epi16(hi, hi), alpha));
+  }
+#elif defined(NEON_BUILD)
+  uint8x16x4_t pixels;
+  pixels.val[3] = vdupq_n_u8(0xff);
+  for (; x + 16 <= width; x += 16) {
+    uint8x16_t grey = vrev32q_u8(vld1q_u8((const uint8_t *) (src + x / 4)));
+    pixels.val[0] = pixels.val[1] = pixels.val[2] = grey;
+    vst4q_u8(dst + 4 * x, pixels);
+  }
+#endif
+  for (; x < width; x++) {
+    l_uint8 *pixel = dst + 4 * x;
+    pixel[0] = pixel[1] = pixel[2] = GET_DATA_BYTE(src, x);
+    pixel[3] = 0xff;
+  }
+}
+
+void convertBinaryRowToRGBA8888(const l_uint32 *src, l_int32 width, l_uint8 *dst) {
+  // Four pixels at a time from a table is as fast as vector code would be.
+  l_int32 x = 0;
+  for (; x + 8 <= width; x += 8) {
+    l_int32 bits = GET_DATA_BYTE(src, x / 8);
+    memcpy(dst + 4 * x, kNibblePixels[bits >> 4], 16);
+    memcpy(dst + 4 * x + 16, kNibblePixels[bits & 0xf], 16);
+  }
+  for (; x < width; x++) {
+    l_uint8 *pixel = dst + 4 * x;
+    pixel[0] = pixel[1] = pixel[2] = GET_DATA_BIT(src, x) ? 0x00 : 0xff;
+    pixel[3] = 0xff;
+  }
+}
+
+void convertRGBRowToRGBA8888(const l_uint32 *src, l_int32 width, bool hasAlpha,
+                             l_uint8 *dst) {
+  l_int32 x = 0;
+#if defined(SSE2_BUILD)
+  const __m128i alpha = _mm_set1_epi32(hasAlpha ? 0 : (int) 0xff000000);
+  for (; x + 4 <= width; x += 4) {
+    __m128i pixels = byteSwap32(_mm_loadu_si128((const __m128i *) (src + x)));
+    _mm_storeu_si128((__m128i *) (dst + 4 * x), _mm_or_si128(pixels, alpha));
+  }
+#elif defined(NEON_BUILD)
+  const uint32x4_t alpha = vdupq_n_u32(hasAlpha ? 0 : 0xff000000);
+  for (; x + 4 <= width; x += 4) {
+    uint8x16_t pixels = vrev32q_u8(vld1q_u8((const uint8_t *) (src + x)));
+    vst1q_u8(dst + 4 * x, vreinterpretq_u8_u32(vorrq_u32(vreinterpretq_u32_u8(pixels), alpha)));
+  }
+#endif
+  for (; x < width; x++) {
+    l_uint8 *pixel = dst + 4 * x;
+    pixel[0] = GET_DATA_BYTE(src + x, COLOR_RED);
+    pixel[1] = GET_DATA_BYTE(src + x, COLOR_GREEN);
+    pixel[2] = GET_DATA_BYTE(src + x, COLOR_BLUE);
+    pixel[3] = hasAlpha ? GET_DATA_BYTE(src + x, L_ALPHA_CHANNEL) : 0xff;
+  }
+}
@@ -0,0 +1,59 @@
+/*
+ * Copyright 2017, Google Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LEPTONICA_JNI_BITMAPCONVERT_H
+#define LEPTONICA_JNI_BITMAPCONVERT_H
+
+#include <allheaders.h>
+
+// Row conversions between Android bitmaps and Pix, with SSE2 and NEON
+// versions where the build targets them. A bitmap row holds its pixels in
+// memory order, while a Pix row keeps its leftmost pixel in the most
+// significant byte of each word.
+
+// Formulas reducing red, green and blue to grey. These are the values of
+// ReadFile.LUMA_*.
+enum LumaFormula {
+  LUMA_AVERAGE,    // (r + g + b) / 3
+  LUMA_LEPTONICA,  // 0.3 r + 0.5 g + 0.2 b, as pixConvertRGBToGray
+  LUMA_BT601,      // 0.299 r + 0.587 g + 0.114 b
+  LUMA_FORMULA_COUNT
+};
+
+// Reduces a row of RGBA_8888 pixels to an 8 bpp Pix row.
+void convertRGBA8888RowToGrey(const l_uint8 *src, l_int32 width, LumaFormula formula,
+                              l_uint32 *dst);
+
+// Reduces a row of RGB_565 pixels to an 8 bpp Pix row.
+void convertRGB565RowToGrey(const l_uint16 *src, l_int32 width, LumaFormula formula,
+                            l_uint32 *dst);
+
+// Copies a row of 8 bit pixels, such as those of an ALPHA_8 bitmap or the Y
+// plane of a camera frame, to an 8 bpp Pix row.
+void convertBytesRowToGrey(const l_uint8 *src, l_int32 width, l_uint32 *dst);
+
+// Expands an 8 bpp Pix row to opaque RGBA_8888 pixels.
+void convertGreyRowToRGBA8888(const l_uint32 *src, l_int32 width, l_uint8 *dst);
+
+// Expands a 1 bpp Pix row to opaque black and white RGBA_8888 pixels.
+void convertBinaryRowToRGBA8888(const l_uint32 *src, l_int32 width, l_uint8 *dst);
+
+// Copies a 32 bpp Pix row to RGBA_8888 pixels, making them opaque unless
+// the Pix has an alpha channel.
+void convertRGBRowToRGBA8888(const l_uint32 *src, l_int32 width, bool hasAlpha,
+                             l_uint8 *dst);
+
+#endif
@@ -26,6 +26,13 @@ void Java_com_googlecode_leptonica_android_Boxa_nativeDestroy(JNIEnv *env, jclas
 }
 
 
+jint Java_com_googlecode_leptonica_android_Boxa_nativeGetCount(JNIEnv *env, jclass clazz,
+                                                             jlong nativeBoxa) {
+  BOXA *boxa = (BOXA *) nativeBoxa;
+
+  return (jint) boxaGetCount(boxa);
+}
+
 jboolean Java_com_googlecode_leptonica_android_Boxa_nativeGetGeometry(JNIEnv *env, jclass clazz,
                                                                      jlong nativeBoxa,
                                                                      jint index,
@@ -48,6 +55,35 @@ jboolean Java_com_googlecode_leptonica_android_Boxa_nativeGetGeometry(JNIEnv *en
   return JNI_TRUE;
 }
 
+jintArray Java_com_googlecode_leptonica_android_Boxa_nativeGetAllGeometry(JNIEnv *env,
+                                                                         jclass clazz,
+                                                                         jlong nativeBoxa) {
+  BOXA *boxa = (BOXA *) nativeBoxa;
+  l_int32 count = boxaGetCount(boxa);
+  jintArray dimensions = env->NewIntArray(4 * count);
+
+  if (dimensions == NULL) {
+    return NULL;
+  }
+
+  jint *dimensionArray = env->GetIntArrayElements(dimensions, NULL);
+  l_int32 x, y, w, h;
+
+  for (l_int32 i = 0; i < count; i++) {
+    if (boxaGetBoxGeometry(boxa, i, &x, &y, &w, &h)) {
+      x = y = w = h = 0;
+    }
+    dimensionArray[4 * i] = x;
+    dimensionArray[4 * i + 1] = y;
+    dimensionArray[4 * i + 2] = w;
+    dimensionArray[4 * i + 3] = h;
+  }
+
+  env->ReleaseIntArrayElements(dimensions, dimensionArray, 0);
+
+  return dimensions;
+}
+
 #ifdef __cplusplus
 }
 #endif  /* __cplusplus */
@@ -0,0 +1,331 @@
+/*
+ * Copyright 2017, Google Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "pagedewarp.h"
+#include "parallel.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// Cells on each side of the grid of a page fingerprint.
+static const l_int32 kFingerprintSide = 32;
+static const l_int32 kFingerprintCells = kFingerprintSide * kFingerprintSide;
+
+// Grey level below which pixels are foreground in the binary image that the
+// model is built on, as for skew detection.
+static const l_int32 kBinaryThreshold = 130;
+
+// Grey value of the pixels that the disparity brings in from outside the
+// image, as in dewarpSinglePage.
+static const l_int32 kGrayIn = 255;
+
+// Smallest band of rows that a thread applies the disparity to.
+static const l_int32 kMinRowsPerChunk = 16;
+
+struct DewarpModel {
+  // The model of the page, or NULL if no valid one could be built.
+  L_DEWARPA *dewa;
+  // Size of the page image, or 0 if there is no page.
+  l_int32 w;
+  l_int32 h;
+  // Parameters the model was built with.
+  l_int32 sampling;
+  l_int32 minLines;
+  l_int32 useBoth;
+  // Black fraction of each cell of the half size binary image, out of 255.
+  l_uint8 fingerprint[kFingerprintCells];
+};
+
+DewarpModel *dewarpModelCreate() {
+  DewarpModel *model = (DewarpModel *) calloc(1, sizeof(DewarpModel));
+  return model;
+}
+
+void dewarpModelDestroy(DewarpModel **pmodel) {
+  if (*pmodel == NULL) {
+    return;
+  }
+  dewarpModelReset(*pmodel);
+  free(*pmodel);
+  *pmodel = NULL;
+}
+
+void dewarpModelReset(DewarpModel *model) {
+  dewarpaDestroy(&model->dewa);
+  model->w = model->h = 0;
+}
+
+/***************
+ * Model build *
+ ***************/
+
+// Returns a binary copy of pixs at half size.
+static PIX *halfSizeBinary(PIX *pixs) {
+  if (pixGetDepth(pixs) == 1) {
+    return pixReduceRankBinary2(pixs, 1, NULL);
+  }
+
+  PIX *pixg;
+  if (pixGetDepth(pixs) == 8 && pixGetColormap(pixs) == NULL) {
+    pixg = pixClone(pixs);
+  } else {
+    pixg = pixConvertTo8(pixs, FALSE);
+  }
+  if (pixg == NULL) {
+    return NULL;
+  }
+  PIX *pixb = pixScaleGrayToBinaryFast(pixg, 2, kBinaryThreshold);
+  pixDestroy(&pixg);
+  return pixb;
+}
+
+// Fills fingerprint with the black fraction of each cell of a grid over
+// pixb, out of 255.
+static void pageFingerprint(PIX *pixb, l_uint8 *fingerprint) {
+  l_int32 w = pixGetWidth(pixb);
+  l_int32 h = pixGetHeight(pixb);
+  l_int32 wpl = pixGetWpl(pixb);
+  const l_uint32 *data = pixGetData(pixb);
+  l_int32 counts[kFingerprintCells];
+
+  memset(counts, 0, sizeof(counts));
+  for (l_int32 y = 0; y < h; y++) {
+    const l_uint32 *line = data + y * wpl;
+    l_int32 *cellRow = counts + (y * kFingerprintSide / h) * kFingerprintSide;
+    for (l_int32 i = 0; i < wpl; i++) {
+      // Text pages are mostly white, so most words are skipped whole.
+      if (line[i] == 0) {
+        continue;
+      }
+      l_int32 xEnd = L_MIN(w, 32 * i + 32);
+      for (l_int32 x = 32 * i; x < xEnd; x++) {
+        if (GET_DATA_BIT(line, x)) {
+          cellRow[x * kFingerprintSide / w]++;
+        }
+      }
+    }
+  }
+
+  for (l_int32 cy = 0; cy < kFingerprintSide; cy++) {
+    // The rows and columns that fall in a cell, as they are assigned above.
+    l_int32 rows = ((cy + 1) * h + kFingerprintSide - 1) / kFingerprintSide -
+                   (cy * h + kFingerprintSide - 1) / kFingerprintSide;
+    for (l_int32 cx = 0; cx < kFingerprintSide; cx++) {
+      l_int32 cols = ((cx + 1) * w + kFingerprintSide - 1) / kFingerprintSide -
+                     (cx * w + kFingerprintSide - 1) / kFingerprintSide;
+      l_int32 cell = cy * kFingerprintSide + cx;
+      l_int32 area = rows * cols;
+      fingerprint[cell] = area > 0 ? (l_uint8) (counts[cell] * 255 / area) : 0;
+    }
+  }
+}
+
+// Returns true if model holds the page of an image of w x h with the given
+// fingerprint, for the given parameters.
+static bool isSamePage(const DewarpModel *model, l_int32 w, l_int32 h,
+                       const l_uint8 *fingerprint, l_int32 sampling, l_int32 minLines,
+                       l_int32 useBoth, l_float32 maxDiff) {
+  if (model->w != w || model->h != h || model->sampling != sampling ||
+      model->minLines != minLines || model->useBoth != useBoth) {
+    return false;
+  }
+  l_int32 totalDiff = 0;
+  for (l_int32 c = 0; c < kFingerprintCells; c++) {
+    totalDiff += abs(fingerprint[c] - model->fingerprint[c]);
+  }
+  return totalDiff * 100.0 / (255 * kFingerprintCells) <= maxDiff;
+}
+
+// Builds the page model of the half size binary image pixb. Returns NULL
+// if no valid model can be built.
+static L_DEWARPA *buildPageModel(PIX *pixb, l_int32 sampling, l_int32 minLines,
+                                 l_int32 useBoth) {
+  L_DEWARPA *dewa = dewarpaCreate(1, sampling, 2, minLines, 0);
+  if (dewa == NULL) {
+    return NULL;
+  }
+  dewarpaUseBothArrays(dewa, useBoth);
+
+  L_DEWARP *dew = dewarpCreate(pixb, 0);
+  if (dew == NULL) {
+    dewarpaDestroy(&dewa);
+    return NULL;
+  }
+  dewarpaInsertDewarp(dewa, dew);
+  dewarpBuildPageModel(dew, NULL);
+  // Marks the model valid if its curvatures are plausible.
+  dewarpaInsertRefModels(dewa, 0, 0);
+
+  dew = dewarpaGetDewarp(dewa, 0);
+  if (dew == NULL || dew->hasref || !dew->vvalid) {
+    dewarpaDestroy(&dewa);
+    return NULL;
+  }
+  // The binary image is only needed to build the model.
+  pixDestroy(&dew->pixs);
+  return dewa;
+}
+
+/*************
+ * Disparity *
+ *************/
+
+// The disparity fpix applied to pixs, into pixd, shared by the threads that
+// each fill a band of rows of pixd.
+struct DisparityJob {
+  PIX *pixs;
+  FPIX *fpix;
+  bool vertical;
+  PIX *pixd;
+};
+
+// Copies pixel jsrc of the d bpp row lines to pixel j of lined, which is
+// white, as pixApplyVertDisparity and pixApplyHorizDisparity do.
+static inline void copyPixel(l_uint32 *lined, l_int32 j, const l_uint32 *lines, l_int32 jsrc,
+                             l_int32 d) {
+  if (d == 1) {
+    if (GET_DATA_BIT(lines, jsrc)) {
+      SET_DATA_BIT(lined, j);
+    }
+  } else if (d == 8) {
+    SET_DATA_BYTE(lined, j, GET_DATA_BYTE(lines, jsrc));
+  } else {
+    lined[j] = lines[jsrc];
+  }
+}
+
+static void applyDisparityRows(void *arg, l_int32 first, l_int32 last) {
+  DisparityJob *job = (DisparityJob *) arg;
+  l_int32 w, h, d;
+  pixGetDimensions(job->pixs, &w, &h, &d);
+  const l_uint32 *datas = pixGetData(job->pixs);
+  l_int32 wpls = pixGetWpl(job->pixs);
+  l_uint32 *datad = pixGetData(job->pixd);
+  l_int32 wpld = pixGetWpl(job->pixd);
+  const l_float32 *dataf = fpixGetData(job->fpix);
+  l_int32 wplf = fpixGetWpl(job->fpix);
+
+  for (l_int32 i = first; i < last; i++) {
+    l_uint32 *lined = datad + i * wpld;
+    const l_float32 *linef = dataf + i * wplf;
+    if (job->vertical) {
+      for (l_int32 j = 0; j < w; j++) {
+        l_int32 isrc = (l_int32) (i - linef[j] + 0.5);
+        if (isrc >= 0 && isrc < h) {
+          copyPixel(lined, j, datas + isrc * wpls, j, d);
+        }
+      }
+    } else {
+      const l_uint32 *lines = datas + i * wpls;
+      for (l_int32 j = 0; j < w; j++) {
+        l_int32 jsrc = (l_int32) (j - linef[j] + 0.5);
+        if (jsrc >= 0 && jsrc < w) {
+          copyPixel(lined, j, lines, jsrc, d);
+        }
+      }
+    }
+  }
+}
+
+// Applies the vertical or horizontal full resolution disparity fpix to
+// pixs, as pixApplyVertDisparity or pixApplyHorizDisparity with a grayin
+// of kGrayIn.
+static PIX *applyDisparityParallel(PIX *pixs, FPIX *fpix, bool vertical,
+                                   l_int32 numThreads) {
+  l_int32 w, h, fw, fh;
+  pixGetDimensions(pixs, &w, &h, NULL);
+  fpixGetDimensions(fpix, &fw, &fh);
+  if (fw < w || fh < h) {
+    return NULL;
+  }
+
+  PIX *pixd = pixCreateTemplate(pixs);
+  if (pixd == NULL) {
+    return NULL;
+  }
+  pixSetAllGray(pixd, kGrayIn);
+
+  DisparityJob job;
+  job.pixs = pixs;
+  job.fpix = fpix;
+  job.vertical = vertical;
+  job.pixd = pixd;
+  runParallel(applyDisparityRows, &job, h, kMinRowsPerChunk, numThreads);
+
+  return pixd;
+}
+
+// Applies the model of dewa to pixs, as dewarpaApplyDisparity. The full
+// resolution disparity arrays are kept in the model for the next frames.
+static PIX *applyPageModel(L_DEWARPA *dewa, PIX *pixs, l_int32 numThreads) {
+  L_DEWARP *dew = dewarpaGetDewarp(dewa, 0);
+  dewarpPopulateFullRes(dew, pixs, 0, 0);
+  if (dew->fullvdispar == NULL) {
+    return NULL;
+  }
+
+  PIX *pixv = applyDisparityParallel(pixs, dew->fullvdispar, true, numThreads);
+  if (pixv == NULL || !dewa->useboth || !dew->hsuccess || !dew->hvalid ||
+      dew->skip_horiz || dew->fullhdispar == NULL) {
+    return pixv;
+  }
+
+  PIX *pixh = applyDisparityParallel(pixv, dew->fullhdispar, false, numThreads);
+  if (pixh == NULL) {
+    return pixv;
+  }
+  pixDestroy(&pixv);
+  return pixh;
+}
+
+PIX *dewarpPageParallel(PIX *pixs, DewarpModel *model, l_int32 sampling, l_int32 minLines,
+                        l_int32 useBoth, l_float32 maxDiff, l_int32 numThreads) {
+  l_int32 w, h, d;
+  pixGetDimensions(pixs, &w, &h, &d);
+  if (d != 1 && d != 8 && d != 32) {
+    return NULL;
+  }
+
+  PIX *pixb = halfSizeBinary(pixs);
+  if (pixb == NULL) {
+    return NULL;
+  }
+  l_uint8 fingerprint[kFingerprintCells];
+  pageFingerprint(pixb, fingerprint);
+
+  DewarpModel single;
+  memset(&single, 0, sizeof(single));
+  DewarpModel *page = model != NULL ? model : &single;
+  // A reused page keeps the fingerprint it was built with, so that a slow
+  // drift of the frames does not carry a stale model along.
+  if (!isSamePage(page, w, h, fingerprint, sampling, minLines, useBoth, maxDiff)) {
+    dewarpModelReset(page);
+    page->dewa = buildPageModel(pixb, sampling, minLines, useBoth);
+    page->w = w;
+    page->h = h;
+    page->sampling = sampling;
+    page->minLines = minLines;
+    page->useBoth = useBoth;
+    memcpy(page->fingerprint, fingerprint, sizeof(fingerprint));
+  }
+  pixDestroy(&pixb);
+
+  PIX *pixd = page->dewa != NULL ? applyPageModel(page->dewa, pixs, numThreads) : pixs;
+  if (page == &single) {
+    dewarpModelReset(&single);
+  }
+  return pixd;
+}
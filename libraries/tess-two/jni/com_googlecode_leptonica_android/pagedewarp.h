@@ -0,0 +1,50 @@
+/*
+ * Copyright 2017, Google Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LEPTONICA_JNI_PAGEDEWARP_H
+#define LEPTONICA_JNI_PAGEDEWARP_H
+
+#include <allheaders.h>
+
+// Dewarping of camera captures of curved book pages with Leptonica's page
+// model. The model is built on a binary copy of the image at half size, as
+// dewarpaCreate allows, and the disparity is applied in bands of rows on
+// several threads, with the same results as dewarpaApplyDisparity.
+
+// The model of the last page dewarped, kept so that the consecutive frames
+// of the same page reuse it instead of building it again.
+struct DewarpModel;
+
+DewarpModel *dewarpModelCreate();
+
+void dewarpModelDestroy(DewarpModel **pmodel);
+
+// Forgets the page of the model, so that the next image builds it again.
+void dewarpModelReset(DewarpModel *model);
+
+// Returns pixs (1, 8 or 32 bpp) with its text lines straightened, or pixs
+// itself when no valid model can be built for it. sampling and minLines are
+// as for dewarpaCreate, and horizontal disparity is also corrected if
+// useBoth. If model is not NULL and the image has the size of the page it
+// holds, and a fingerprint of black fractions on a 32x32 grid of the half
+// size binary image differs from that page's by at most maxDiff percent on
+// average, the model (or the lack of one) of that page is reused. Otherwise
+// the model is built for this image and replaces it. numThreads <= 0 uses
+// one thread per core. Returns NULL on error.
+PIX *dewarpPageParallel(PIX *pixs, DewarpModel *model, l_int32 sampling, l_int32 minLines,
+                        l_int32 useBoth, l_float32 maxDiff, l_int32 numThreads);
+
+#endif
@@ -0,0 +1,85 @@
+/*
+ * Copyright 2017, Google Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "parallel.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+// Work shared by the threads of runParallel, which take chunks of the range
+// [0, count) in turn.
+struct RangeJob {
+  RangeFunction fn;
+  void *arg;
+  l_int32 count;
+  l_int32 chunk;
+  l_int32 next;
+  pthread_mutex_t mutex;
+};
+
+static void *rangeWorker(void *data) {
+  RangeJob *job = (RangeJob *) data;
+
+  for (;;) {
+    pthread_mutex_lock(&job->mutex);
+    l_int32 first = job->next;
+    job->next = L_MIN(job->count, first + job->chunk);
+    pthread_mutex_unlock(&job->mutex);
+    if (first >= job->count) {
+      break;
+    }
+    job->fn(job->arg, first, L_MIN(job->count, first + job->chunk));
+  }
+
+  return NULL;
+}
+
+void runParallel(RangeFunction fn, void *arg, l_int32 count, l_int32 minChunk,
+                 l_int32 numThreads) {
+  if (numThreads <= 0) {
+    numThreads = (l_int32) sysconf(_SC_NPROCESSORS_ONLN);
+  }
+  // A few chunks per thread even out the load without much overhead.
+  l_int32 chunk = L_MAX(minChunk, count / (4 * L_MAX(1, numThreads)));
+  chunk = L_MAX(1, chunk);
+  numThreads = L_MAX(1, L_MIN(numThreads, (count + chunk - 1) / chunk));
+  if (numThreads == 1) {
+    fn(arg, 0, count);
+    return;
+  }
+
+  RangeJob job;
+  job.fn = fn;
+  job.arg = arg;
+  job.count = count;
+  job.chunk = chunk;
+  job.next = 0;
+  pthread_mutex_init(&job.mutex, NULL);
+
+  pthread_t *threads = (pthread_t *) malloc((numThreads - 1) * sizeof(pthread_t));
+  l_int32 started = 0;
+  while (threads != NULL && started < numThreads - 1 &&
+         pthread_create(&threads[started], NULL, rangeWorker, &job) == 0) {
+    started++;
+  }
+  rangeWorker(&job);
+  for (l_int32 t = 0; t < started; t++) {
+    pthread_join(threads[t], NULL);
+  }
+  free(threads);
+  pthread_mutex_destroy(&job.mutex);
+}
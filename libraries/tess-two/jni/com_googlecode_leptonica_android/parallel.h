@@ -0,0 +1,30 @@
+/*
+ * Copyright 2017, Google Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LEPTONICA_JNI_PARALLEL_H
+#define LEPTONICA_JNI_PARALLEL_H
+
+#include <allheaders.h>
+
+typedef void (*RangeFunction)(void *arg, l_int32 first, l_int32 last);
+
+// Calls fn on chunks of [0, count), such as bands of image rows, with at
+// least minChunk items in each, from numThreads threads, the calling thread
+// being one of them. numThreads <= 0 uses one thread per core.
+void runParallel(RangeFunction fn, void *arg, l_int32 count, l_int32 minChunk,
+                 l_int32 numThreads);
+
+#endif
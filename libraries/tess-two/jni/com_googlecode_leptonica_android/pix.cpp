@@ -15,8 +15,107 @@
  */
 
 #include "common.h"
+#include "bitmapconvert.h"
+#include <pthread.h>
 #include <string.h>
 
+// Converts an argb color to a pixel value of depth d.
+static l_uint32 PixelFromArgb(l_int32 d, jint argbColor) {
+  // These shift values are based on RGBA_8888
+  l_uint8 r = (argbColor >> SK_R32_SHIFT) & 0xFF;
+  l_uint8 g = (argbColor >> SK_G32_SHIFT) & 0xFF;
+  l_uint8 b = (argbColor >> SK_B32_SHIFT) & 0xFF;
+  l_uint8 a = (argbColor >> SK_A32_SHIFT) & 0xFF;
+  l_uint8 gray = ((r + g + b) / 3) & 0xFF;
+
+  l_uint32 color;
+
+  switch (d) {
+    case 1: // 1-bit binary
+      color = gray > 128 ? 1 : 0;
+      break;
+    case 2: // 2-bit grayscale
+      color = gray >> 6;
+      break;
+    case 4: // 4-bit grayscale
+      color = gray >> 4;
+      break;
+    case 8: // 8-bit grayscale
+      color = gray;
+      break;
+    case 24: // 24-bit RGB
+      SET_DATA_BYTE(&color, COLOR_RED, r);
+      SET_DATA_BYTE(&color, COLOR_GREEN, g);
+      SET_DATA_BYTE(&color, COLOR_BLUE, b);
+      break;
+    case 32: // 32-bit ARGB
+      SET_DATA_BYTE(&color, COLOR_RED, r);
+      SET_DATA_BYTE(&color, COLOR_GREEN, g);
+      SET_DATA_BYTE(&color, COLOR_BLUE, b);
+      SET_DATA_BYTE(&color, L_ALPHA_CHANNEL, a);
+      break;
+    default: // unsupported
+      LOGE("Not a supported color depth: %d", d);
+      color = 0;
+      break;
+  }
+
+  return color;
+}
+
+// Converts a pixel value of depth d to an argb color.
+static jint ArgbFromPixel(l_int32 d, l_uint32 pixel) {
+  l_uint32 color;
+  l_uint8 a, r, g, b;
+
+  switch (d) {
+    case 1: // 1-bit binary
+      a = 0xFF;
+      r = g = b = (pixel == 0 ? 0x00 : 0xFF);
+      break;
+    case 2: // 2-bit grayscale
+      a = 0xFF;
+      r = g = b = (pixel << 6 | pixel << 4 | pixel);
+      break;
+    case 4: // 4-bit grayscale
+      a = 0xFF;
+      r = g = b = (pixel << 4 | pixel);
+      break;
+    case 8: // 8-bit grayscale
+      a = 0xFF;
+      r = g = b = pixel;
+      break;
+    case 24: // 24-bit RGB
+      a = 0xFF;
+      r = (pixel >> L_RED_SHIFT) & 0xFF;
+      g = (pixel >> L_GREEN_SHIFT) & 0xFF;
+      b = (pixel >> L_BLUE_SHIFT) & 0xFF;
+      break;
+    case 32: // 32-bit RGBA
+      r = (pixel >> L_RED_SHIFT) & 0xFF;
+      g = (pixel >> L_GREEN_SHIFT) & 0xFF;
+      b = (pixel >> L_BLUE_SHIFT) & 0xFF;
+      a = (pixel >> L_ALPHA_SHIFT) & 0xFF;
+      break;
+    default: // Not supported
+      LOGE("Not a supported color depth: %d", d);
+      a = r = g = b = 0x00;
+      break;
+  }
+
+  color = a << SK_A32_SHIFT;
+  color |= r << SK_R32_SHIFT;
+  color |= g << SK_G32_SHIFT;
+  color |= b << SK_B32_SHIFT;
+
+  return (jint) color;
+}
+
+// Returns true if the pixels of depth d can be read and written in bulk.
+static bool IsBulkDepth(l_int32 d) {
+  return d == 1 || d == 2 || d == 4 || d == 8 || d == 32;
+}
+
 #ifdef __cplusplus
 extern "C" {
 #endif  /* __cplusplus */
@@ -44,6 +143,130 @@ jlong Java_com_googlecode_leptonica_android_Pix_nativeCreateFromData(JNIEnv *env
   return (jlong) pix;
 }
 
+// Makes an 8 bpp Pix of the Y plane of a camera frame, given its row stride,
+// or returns NULL if the plane does not fit in len bytes.
+static PIX *createPixFromYPlane(const l_uint8 *plane, jlong len, l_int32 w, l_int32 h,
+                                l_int32 rowStride) {
+  if (w <= 0 || h <= 0 || rowStride < w || len < (jlong) rowStride * (h - 1) + w) {
+    LOGE("Y plane of %dx%d with row stride %d does not fit in %lld bytes!", w, h, rowStride,
+         (long long) len);
+    return NULL;
+  }
+
+  PIX *pix = pixCreateNoInit(w, h, 8);
+  if (pix == NULL) {
+    return NULL;
+  }
+
+  // Leptonica keeps pixels in big-endian word order, so the rows are copied
+  // even when the stride matches.
+  l_uint32 *dst = pixGetData(pix);
+  l_int32 wpl = pixGetWpl(pix);
+  for (int y = 0; y < h; y++) {
+    convertBytesRowToGrey(plane + y * rowStride, w, dst + y * wpl);
+  }
+
+  return pix;
+}
+
+jlong Java_com_googlecode_leptonica_android_Pix_nativeCreateFromYUVBytes(JNIEnv *env,
+                                                                         jclass clazz,
+                                                                         jbyteArray data,
+                                                                         jint w, jint h,
+                                                                         jint rowStride) {
+  jlong len = env->GetArrayLength(data);
+  void *data_array = env->GetPrimitiveArrayCritical(data, NULL);
+  if (data_array == NULL) {
+    return (jlong) NULL;
+  }
+
+  PIX *pix = createPixFromYPlane((l_uint8 *) data_array, len, (l_int32) w, (l_int32) h,
+                                 (l_int32) rowStride);
+
+  env->ReleasePrimitiveArrayCritical(data, data_array, JNI_ABORT);
+
+  return (jlong) pix;
+}
+
+jlong Java_com_googlecode_leptonica_android_Pix_nativeCreateFromYUVBuffer(JNIEnv *env,
+                                                                          jclass clazz,
+                                                                          jobject buffer,
+                                                                          jint w, jint h,
+                                                                          jint rowStride) {
+  l_uint8 *plane = (l_uint8 *) env->GetDirectBufferAddress(buffer);
+  jlong capacity = env->GetDirectBufferCapacity(buffer);
+  if (plane == NULL || capacity < 0) {
+    LOGE("Buffer is not a direct buffer!");
+    return (jlong) NULL;
+  }
+
+  PIX *pix = createPixFromYPlane(plane, capacity, (l_int32) w, (l_int32) h,
+                                 (l_int32) rowStride);
+
+  return (jlong) pix;
+}
+
+// Leptonica's memory store keeps its state in a global without locking, and
+// pix are made and destroyed on many threads, so every call goes through
+// this lock.
+static pthread_mutex_t poolMutex = PTHREAD_MUTEX_INITIALIZER;
+static bool poolEnabled = false;
+
+static void *poolAlloc(size_t nbytes) {
+  pthread_mutex_lock(&poolMutex);
+  void *data = pmsCustomAlloc(nbytes);
+  pthread_mutex_unlock(&poolMutex);
+  return data;
+}
+
+static void poolDealloc(void *data) {
+  pthread_mutex_lock(&poolMutex);
+  pmsCustomDealloc(data);
+  pthread_mutex_unlock(&poolMutex);
+}
+
+jboolean Java_com_googlecode_leptonica_android_Pix_nativeEnablePool(JNIEnv *env, jclass clazz,
+                                                                    jint smallest,
+                                                                    jintArray counts) {
+  jsize levels = env->GetArrayLength(counts);
+  if (smallest <= 0 || levels <= 0 || levels > 16) {
+    LOGE("Invalid pool size classes!");
+    return JNI_FALSE;
+  }
+
+  // pmsCreate adds up the store size in an l_int32.
+  jint *countArray = env->GetIntArrayElements(counts, NULL);
+  NUMA *numalloc = numaCreate(levels);
+  long long total = 0;
+  for (jsize i = 0; i < levels; i++) {
+    total += (long long) L_MAX(0, countArray[i]) * smallest * (1 << i);
+    numaAddNumber(numalloc, (l_float32) L_MAX(0, countArray[i]));
+  }
+  env->ReleaseIntArrayElements(counts, countArray, JNI_ABORT);
+
+  jboolean result = JNI_FALSE;
+  pthread_mutex_lock(&poolMutex);
+  if (poolEnabled) {
+    LOGE("Pool is already enabled!");
+  } else if (total > 0x7fffffffLL) {
+    LOGE("Pool of %lld bytes is too large!", total);
+  } else if (pmsCreate((size_t) smallest / 2, (size_t) smallest, numalloc, NULL)) {
+    LOGE("Could not allocate a pool of %lld bytes!", total);
+    pmsDestroy();
+  } else {
+    // Data allocated before this point came from malloc, lies outside the
+    // store and is simply freed by pmsCustomDealloc. The store is never
+    // destroyed, since live pix may hold its chunks.
+    setPixMemoryManager(poolAlloc, poolDealloc);
+    poolEnabled = true;
+    result = JNI_TRUE;
+  }
+  pthread_mutex_unlock(&poolMutex);
+  numaDestroy(&numalloc);
+
+  return result;
+}
+
 jbyteArray Java_com_googlecode_leptonica_android_Pix_nativeGetData(JNIEnv *env, jclass clazz,
                                                                    jlong nativePix, jbyteArray data) {
   PIX *pix = (PIX *) nativePix;
@@ -60,6 +283,16 @@ jbyteArray Java_com_googlecode_leptonica_android_Pix_nativeGetData(JNIEnv *env,
   return result;
 }
 
+jobject Java_com_googlecode_leptonica_android_Pix_nativeGetDataBuffer(JNIEnv *env, jclass clazz,
+                                                                      jlong nativePix) {
+  PIX *pix = (PIX *) nativePix;
+
+  jlong size = 4 * (jlong) pixGetWpl(pix) * pixGetHeight(pix);
+
+  // A view of the pix data itself, valid for as long as the pix is.
+  return env->NewDirectByteBuffer(pixGetData(pix), size);
+}
+
 jlong Java_com_googlecode_leptonica_android_Pix_nativeClone(JNIEnv *env, jclass clazz,
                                                             jlong nativePix) {
   PIX *pixs = (PIX *) nativePix;
@@ -148,46 +381,7 @@ void Java_com_googlecode_leptonica_android_Pix_nativeSetPixel(JNIEnv *env, jclas
   l_int32 x = (l_int32) xCoord;
   l_int32 y = (l_int32) yCoord;
 
-  // These shift values are based on RGBA_8888
-  l_uint8 r = (argbColor >> SK_R32_SHIFT) & 0xFF;
-  l_uint8 g = (argbColor >> SK_G32_SHIFT) & 0xFF;
-  l_uint8 b = (argbColor >> SK_B32_SHIFT) & 0xFF;
-  l_uint8 a = (argbColor >> SK_A32_SHIFT) & 0xFF;
-  l_uint8 gray = ((r + g + b) / 3) & 0xFF;
-
-  l_uint32 color;
-
-  switch (d) {
-    case 1: // 1-bit binary
-      color = gray > 128 ? 1 : 0;
-      break;
-    case 2: // 2-bit grayscale
-      color = gray >> 6;
-      break;
-    case 4: // 4-bit grayscale
-      color = gray >> 4;
-      break;
-    case 8: // 8-bit grayscale
-      color = gray;
-      break;
-    case 24: // 24-bit RGB
-      SET_DATA_BYTE(&color, COLOR_RED, r);
-      SET_DATA_BYTE(&color, COLOR_GREEN, g);
-      SET_DATA_BYTE(&color, COLOR_BLUE, b);
-      break;
-    case 32: // 32-bit ARGB
-      SET_DATA_BYTE(&color, COLOR_RED, r);
-      SET_DATA_BYTE(&color, COLOR_GREEN, g);
-      SET_DATA_BYTE(&color, COLOR_BLUE, b);
-      SET_DATA_BYTE(&color, L_ALPHA_CHANNEL, a);
-      break;
-    default: // unsupported
-      LOGE("Not a supported color depth: %d", d);
-      color = 0;
-      break;
-  }
-
-  pixSetPixel(pix, x, y, color);
+  pixSetPixel(pix, x, y, PixelFromArgb(d, argbColor));
 }
 
 jint Java_com_googlecode_leptonica_android_Pix_nativeGetPixel(JNIEnv *env, jclass clazz,
@@ -198,52 +392,112 @@ jint Java_com_googlecode_leptonica_android_Pix_nativeGetPixel(JNIEnv *env, jclas
   l_int32 x = (l_int32) xCoord;
   l_int32 y = (l_int32) yCoord;
   l_uint32 pixel;
-  l_uint32 color;
-  l_uint8 a, r, g, b;
 
   pixGetPixel(pix, x, y, &pixel);
 
-  switch (d) {
-    case 1: // 1-bit binary
-      a = 0xFF;
-      r = g = b = (pixel == 0 ? 0x00 : 0xFF);
-      break;
-    case 2: // 2-bit grayscale
-      a = 0xFF;
-      r = g = b = (pixel << 6 | pixel << 4 | pixel);
-      break;
-    case 4: // 4-bit grayscale
-      a = 0xFF;
-      r = g = b = (pixel << 4 | pixel);
-      break;
-    case 8: // 8-bit grayscale
-      a = 0xFF;
-      r = g = b = pixel;
-      break;
-    case 24: // 24-bit RGB
-      a = 0xFF;
-      r = (pixel >> L_RED_SHIFT) & 0xFF;
-      g = (pixel >> L_GREEN_SHIFT) & 0xFF;
-      b = (pixel >> L_BLUE_SHIFT) & 0xFF;
-      break;
-    case 32: // 32-bit RGBA
-      r = (pixel >> L_RED_SHIFT) & 0xFF;
-      g = (pixel >> L_GREEN_SHIFT) & 0xFF;
-      b = (pixel >> L_BLUE_SHIFT) & 0xFF;
-      a = (pixel >> L_ALPHA_SHIFT) & 0xFF;
-      break;
-    default: // Not supported
-      LOGE("Not a supported color depth: %d", d);
-      a = r = g = b = 0x00;
-      break;
+  return ArgbFromPixel(d, pixel);
+}
+
+jboolean Java_com_googlecode_leptonica_android_Pix_nativeGetPixels(JNIEnv *env, jclass clazz,
+                                                                   jlong nativePix, jint x,
+                                                                   jint y, jint w, jint h,
+                                                                   jintArray pixels) {
+  PIX *pix = (PIX *) nativePix;
+  l_int32 d = pixGetDepth(pix);
+  l_int32 wpl = pixGetWpl(pix);
+  l_uint32 *data = pixGetData(pix);
+
+  if (!IsBulkDepth(d)) {
+    LOGE("Not a supported color depth: %d", d);
+    return JNI_FALSE;
   }
 
-  color = a << SK_A32_SHIFT;
-  color |= r << SK_R32_SHIFT;
-  color |= g << SK_G32_SHIFT;
-  color |= b << SK_B32_SHIFT;
+  jint *argb = (jint *) env->GetPrimitiveArrayCritical(pixels, NULL);
+  if (argb == NULL) {
+    return JNI_FALSE;
+  }
 
-  return (jint) color;
+  for (int row = 0; row < h; row++) {
+    const l_uint32 *line = data + (y + row) * wpl;
+    jint *out = argb + row * w;
+    for (int col = 0; col < w; col++) {
+      l_int32 px = x + col;
+      l_uint32 pixel;
+      switch (d) {
+        case 1:
+          pixel = GET_DATA_BIT(line, px);
+          break;
+        case 2:
+          pixel = GET_DATA_DIBIT(line, px);
+          break;
+        case 4:
+          pixel = GET_DATA_QBIT(line, px);
+          break;
+        case 8:
+          pixel = GET_DATA_BYTE(line, px);
+          break;
+        default:
+          pixel = line[px];
+          break;
+      }
+      out[col] = ArgbFromPixel(d, pixel);
+    }
+  }
+
+  env->ReleasePrimitiveArrayCritical(pixels, argb, 0);
+
+  return JNI_TRUE;
+}
+
+jboolean Java_com_googlecode_leptonica_android_Pix_nativeSetPixels(JNIEnv *env, jclass clazz,
+                                                                   jlong nativePix, jint x,
+                                                                   jint y, jint w, jint h,
+                                                                   jintArray pixels) {
+  PIX *pix = (PIX *) nativePix;
+  l_int32 d = pixGetDepth(pix);
+  l_int32 wpl = pixGetWpl(pix);
+  l_uint32 *data = pixGetData(pix);
+
+  if (!IsBulkDepth(d)) {
+    LOGE("Not a supported color depth: %d", d);
+    return JNI_FALSE;
+  }
+
+  jint *argb = (jint *) env->GetPrimitiveArrayCritical(pixels, NULL);
+  if (argb == NULL) {
+    return JNI_FALSE;
+  }
+
+  for (int row = 0; row < h; row++) {
+    l_uint32 *line = data + (y + row) * wpl;
+    const jint *in = argb + row * w;
+    for (int col = 0; col < w; col++) {
+      l_int32 px = x + col;
+      l_uint32 pixel = PixelFromArgb(d, in[col]);
+      switch (d) {
+        case 1:
+          SET_DATA_BIT_VAL(line, px, pixel);
+          break;
+        case 2:
+          SET_DATA_DIBIT(line, px, pixel);
+          break;
+        case 4:
+          SET_DATA_QBIT(line, px, pixel);
+          break;
+        case 8:
+          SET_DATA_BYTE(line, px, pixel);
+          break;
+        default:
+          line[px] = pixel;
+          break;
+      }
+    }
+  }
+
+  // The array was only read.
+  env->ReleasePrimitiveArrayCritical(pixels, argb, JNI_ABORT);
+
+  return JNI_TRUE;
 }
 
 #ifdef __cplusplus
@@ -212,6 +212,35 @@ jboolean Java_com_googlecode_leptonica_android_Pixa_nativeGetBoxGeometry(JNIEnv
   return JNI_TRUE;
 }
 
+jintArray Java_com_googlecode_leptonica_android_Pixa_nativeGetAllBoxGeometry(JNIEnv *env,
+                                                                            jclass clazz,
+                                                                            jlong nativePixa) {
+  PIXA *pixa = (PIXA *) nativePixa;
+  l_int32 count = pixaGetCount(pixa);
+  jintArray dimensions = env->NewIntArray(4 * count);
+
+  if (dimensions == NULL) {
+    return NULL;
+  }
+
+  jint *dimensionArray = env->GetIntArrayElements(dimensions, NULL);
+  l_int32 x, y, w, h;
+
+  for (l_int32 i = 0; i < count; i++) {
+    if (pixaGetBoxGeometry(pixa, i, &x, &y, &w, &h)) {
+      x = y = w = h = 0;
+    }
+    dimensionArray[4 * i] = x;
+    dimensionArray[4 * i + 1] = y;
+    dimensionArray[4 * i + 2] = w;
+    dimensionArray[4 * i + 3] = h;
+  }
+
+  env->ReleaseIntArrayElements(dimensions, dimensionArray, 0);
+
+  return dimensions;
+}
+
 #ifdef __cplusplus
 }
 #endif  /* __cplusplus */
@@ -15,6 +15,8 @@
  */
 
 #include "common.h"
+#include "bitmapconvert.h"
+#include "scale.h"
 
 #include <string.h>
 #include <android/bitmap.h>
@@ -27,6 +29,91 @@ extern "C" {
  * ReadFile *
  ************/
 
+// Decodes an image from data, or from the file filename if data is NULL,
+// at scale times its size and in 8 bpp grey if grey is set. JPEG images are
+// reduced by the largest factor of 1, 2, 4 or 8 that keeps them at least
+// that size while decoding, and to grey by decoding luminance only; the
+// rest of the scaling and the conversion of other formats follow decoding.
+static PIX *readScaled(const l_uint8 *data, size_t size, const char *filename, l_float32 scale,
+                       bool grey) {
+  l_int32 format = IFF_UNKNOWN;
+  if (data != NULL) {
+    findFileFormatBuffer(data, &format);
+  } else {
+    findFileFormat(filename, &format);
+  }
+
+  l_int32 reduction = 1;
+  PIX *pixs;
+  if (format == IFF_JFIF_JPEG) {
+    while (reduction < 8 && scale * (2 * reduction) <= 1.0) {
+      reduction *= 2;
+    }
+    l_int32 hint = grey ? L_JPEG_READ_LUMINANCE : 0;
+    pixs = (data != NULL) ? pixReadMemJpeg(data, size, 0, reduction, NULL, hint)
+                          : pixReadJpeg(filename, 0, reduction, NULL, hint);
+  } else {
+    pixs = (data != NULL) ? pixReadMem(data, size) : pixRead(filename);
+  }
+  if (pixs == NULL) {
+    LOGE("Failed to decode image");
+    return NULL;
+  }
+
+  if (grey && (pixGetDepth(pixs) != 8 || pixGetColormap(pixs) != NULL)) {
+    PIX *pixt = pixConvertTo8(pixs, FALSE);
+    pixDestroy(&pixs);
+    pixs = pixt;
+  }
+
+  l_float32 remaining = scale * reduction;
+  if (pixs != NULL && remaining < 1.0) {
+    PIX *pixt = scaleParallel(pixs, remaining, remaining, 0);
+    pixDestroy(&pixs);
+    pixs = pixt;
+  }
+
+  return pixs;
+}
+
+jlong Java_com_googlecode_leptonica_android_ReadFile_nativeReadMemScaled(JNIEnv *env,
+                                                                         jclass clazz,
+                                                                         jbyteArray image,
+                                                                         jfloat scale,
+                                                                         jboolean grey) {
+  jbyte *image_buffer = env->GetByteArrayElements(image, NULL);
+  if (image_buffer == NULL) {
+    LOGE("could not read image data!");
+    return (jlong) NULL;
+  }
+  int buffer_length = env->GetArrayLength(image);
+
+  PIX *pix = readScaled((const l_uint8 *) image_buffer, buffer_length, NULL, (l_float32) scale,
+                        grey == JNI_TRUE);
+
+  env->ReleaseByteArrayElements(image, image_buffer, JNI_ABORT);
+
+  return (jlong) pix;
+}
+
+jlong Java_com_googlecode_leptonica_android_ReadFile_nativeReadFileScaled(JNIEnv *env,
+                                                                          jclass clazz,
+                                                                          jstring fileName,
+                                                                          jfloat scale,
+                                                                          jboolean grey) {
+  const char *c_fileName = env->GetStringUTFChars(fileName, NULL);
+  if (c_fileName == NULL) {
+    LOGE("could not extract fileName string!");
+    return (jlong) NULL;
+  }
+
+  PIX *pix = readScaled(NULL, 0, c_fileName, (l_float32) scale, grey == JNI_TRUE);
+
+  env->ReleaseStringUTFChars(fileName, c_fileName);
+
+  return (jlong) pix;
+}
+
 jlong Java_com_googlecode_leptonica_android_ReadFile_nativeReadMem(JNIEnv *env, jclass clazz,
                                                                    jbyteArray image, jint length) {
   jbyte *image_buffer = env->GetByteArrayElements(image, NULL);
@@ -111,8 +198,8 @@ jlong Java_com_googlecode_leptonica_android_ReadFile_nativeReadFile(JNIEnv *env,
 }
 
 jlong Java_com_googlecode_leptonica_android_ReadFile_nativeReadBitmap(JNIEnv *env, jclass clazz,
-                                                                      jobject bitmap) {
-  l_int32 w, h, d;
+                                                                      jobject bitmap,
+                                                                      jint lumaFormula) {
   AndroidBitmapInfo info;
   void* pixels;
   int ret;
@@ -122,8 +209,15 @@ jlong Java_com_googlecode_leptonica_android_ReadFile_nativeReadBitmap(JNIEnv *en
     return (jlong) NULL;
   }
 
-  if (info.format != ANDROID_BITMAP_FORMAT_RGBA_8888) {
-    LOGE("Bitmap format is not RGBA_8888!");
+  if (info.format != ANDROID_BITMAP_FORMAT_RGBA_8888 &&
+      info.format != ANDROID_BITMAP_FORMAT_RGB_565 &&
+      info.format != ANDROID_BITMAP_FORMAT_A_8) {
+    LOGE("Bitmap format is not RGBA_8888, RGB_565 or A_8!");
+    return (jlong) NULL;
+  }
+
+  if (lumaFormula < 0 || lumaFormula >= LUMA_FORMULA_COUNT) {
+    LOGE("Invalid luma formula %d!", lumaFormula);
     return (jlong) NULL;
   }
 
@@ -132,31 +226,25 @@ jlong Java_com_googlecode_leptonica_android_ReadFile_nativeReadBitmap(JNIEnv *en
     return (jlong) NULL;
   }
 
-  PIX *pixd = pixCreate(info.width, info.height, 8);
-
-  l_uint32 *src = (l_uint32 *) pixels;
-  l_int32 srcWpl = (info.stride / 4);
-  l_uint32 *dst = pixGetData(pixd);
-  l_int32 dstWpl = pixGetWpl(pixd);
-  l_uint8 a, r, g, b, pixel8;
-
-  for (int y = 0; y < info.height; y++) {
-    l_uint32 *dst_line = dst + (y * dstWpl);
-    l_uint32 *src_line = src + (y * srcWpl);
-
-    for (int x = 0; x < info.width; x++) {
-      // Get pixel from RGBA_8888
-      r = *src_line >> SK_R32_SHIFT;
-      g = *src_line >> SK_G32_SHIFT;
-      b = *src_line >> SK_B32_SHIFT;
-      a = *src_line >> SK_A32_SHIFT;
-      pixel8 = (l_uint8)((r + g + b) / 3);
-
-      // Set pixel to LUMA_8
-      SET_DATA_BYTE(dst_line, x, pixel8);
-
-      // Move to the next pixel
-      src_line++;
+  PIX *pixd = pixCreateNoInit(info.width, info.height, 8);
+
+  if (pixd != NULL) {
+    l_uint8 *src = (l_uint8 *) pixels;
+    l_uint32 *dst = pixGetData(pixd);
+    l_int32 dstWpl = pixGetWpl(pixd);
+
+    for (int y = 0; y < info.height; y++) {
+      l_uint8 *src_line = src + y * info.stride;
+      l_uint32 *dst_line = dst + y * dstWpl;
+
+      if (info.format == ANDROID_BITMAP_FORMAT_RGBA_8888) {
+        convertRGBA8888RowToGrey(src_line, info.width, (LumaFormula) lumaFormula, dst_line);
+      } else if (info.format == ANDROID_BITMAP_FORMAT_RGB_565) {
+        convertRGB565RowToGrey((l_uint16 *) src_line, info.width, (LumaFormula) lumaFormula,
+                               dst_line);
+      } else {
+        convertBytesRowToGrey(src_line, info.width, dst_line);
+      }
     }
   }
 
@@ -0,0 +1,379 @@
+/*
+ * Copyright 2017, Google Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "rotate.h"
+#include "parallel.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Limits, in radians, as in Leptonica's rotate.c and rotateshear.c.
+static const l_float32 kMinAngleToRotate = 0.001;
+static const l_float32 kMax2ShearAngle = 0.06;
+static const l_float32 kLimitShearAngle = 0.35;
+static const l_float32 kMax1bppShearAngle = 0.06;
+
+// Destination rows filled together, so that the strips of a vertical shear
+// are copied while the rows are in cache.
+static const l_int32 kRowsPerBlock = 32;
+
+/**********
+ * Shears *
+ **********/
+
+// Marks a row of rowShift that no band of a horizontal shear covers.
+static const l_int32 kNoShift = 0x7fffffff;
+
+// size rows (columns) of the source starting at start, which a horizontal
+// (vertical) shear moves by shift columns (rows).
+struct ShearBand {
+  l_int32 start;
+  l_int32 size;
+  l_int32 shift;
+};
+
+// A horizontal shear followed by a vertical one, into pixd, shared by the
+// threads that each fill a band of rows of pixd. The source is pixs at
+// (xoff, yoff) on a canvas of the size of pixd, the rest of which is the
+// incoming colour; that is how pixEmbedForRotation enlarges an image.
+struct ShearJob {
+  PIX *pixs;
+  l_int32 xoff;
+  l_int32 yoff;
+  PIX *pixd;
+  // The horizontal shift of each row of the canvas, or kNoShift.
+  const l_int32 *rowShift;
+  // The vertical shifts of strips of columns.
+  const ShearBand *strips;
+  l_int32 count;
+  l_uint8 fill;
+};
+
+// Lists the bands that pixHShear (pixVShear) copies for a shear by radang
+// about loc, in bands, which holds length + 2 entries. Returns the number
+// of bands.
+static l_int32 findShearBands(l_int32 length, l_int32 loc, l_float32 radang, bool horizontal,
+                              ShearBand *bands) {
+  l_int32 sign = L_SIGN(radang);
+  l_float32 tanangle = tan(radang);
+  l_float32 invangle = L_ABS(1. / tanangle);
+  l_int32 initincr = (l_int32) (invangle / 2.);
+  l_int32 count = 0;
+  l_int32 incr, shift, pos;
+
+  bands[count].start = loc - initincr;
+  bands[count].size = 2 * initincr;
+  bands[count++].shift = 0;
+
+  for (shift = 1, pos = loc + initincr; pos < length; shift++) {
+    incr = (l_int32) (invangle * (shift + 0.5) + 0.5) - (pos - loc);
+    if (length - pos < incr) {
+      incr = length - pos;
+    }
+    bands[count].start = pos;
+    bands[count].size = incr;
+    bands[count++].shift = horizontal ? -sign * shift : sign * shift;
+    pos += incr;
+  }
+
+  for (shift = -1, pos = loc - initincr; pos > 0; shift--) {
+    incr = (pos - loc) - (l_int32) (invangle * (shift - 0.5) + 0.5);
+    if (pos < incr) {
+      incr = pos;
+    }
+    bands[count].start = pos - incr;
+    bands[count].size = incr;
+    bands[count++].shift = horizontal ? -sign * shift : sign * shift;
+    pos -= incr;
+  }
+
+  return count;
+}
+
+// Returns word i of a row of wpl words, or 0 outside the row.
+static inline l_uint32 rowWord(const l_uint32 *line, l_int32 i, l_int32 wpl) {
+  return (i >= 0 && i < wpl) ? line[i] : 0;
+}
+
+// Copies n pixels of the d bpp row src of wpls words, from pixel sx on, to
+// the row dst from pixel dx on.
+static void copyPixels(l_uint32 *dst, l_int32 dx, const l_uint32 *src, l_int32 wpls,
+                       l_int32 sx, l_int32 n, l_int32 d) {
+  l_int32 b0 = dx * d;
+  l_int32 b1 = (dx + n) * d;
+  l_int32 first = b0 >> 5;
+  l_int32 last = (b1 - 1) >> 5;
+  // Pixels are stored from the most significant bit of each word.
+  l_uint32 head = 0xffffffff >> (b0 & 31);
+  l_uint32 tail = (b1 & 31) ? ~(0xffffffff >> (b1 & 31)) : 0xffffffff;
+
+  // Destination bit b is source bit b + delta, so destination word i is
+  // made of source words i + offset and i + offset + 1 shifted by k.
+  l_int32 delta = sx * d - b0;
+  l_int32 k = delta & 31;
+  l_int32 offset = (delta - k) / 32;
+
+#define SOURCE_WORD(i) \
+  (k ? (rowWord(src, (i) + offset, wpls) << k) | \
+       (rowWord(src, (i) + offset + 1, wpls) >> (32 - k)) \
+     : rowWord(src, (i) + offset, wpls))
+  if (first == last) {
+    l_uint32 mask = head & tail;
+    dst[first] = (dst[first] & ~mask) | (SOURCE_WORD(first) & mask);
+    return;
+  }
+  dst[first] = (dst[first] & ~head) | (SOURCE_WORD(first) & head);
+  dst[last] = (dst[last] & ~tail) | (SOURCE_WORD(last) & tail);
+#undef SOURCE_WORD
+
+  // Whole words in between read only source words within the row.
+  const l_uint32 *s = src + offset;
+  if (k == 0) {
+    memcpy(dst + first + 1, s + first + 1, (last - first - 1) * sizeof(l_uint32));
+  } else {
+    for (l_int32 i = first + 1; i < last; i++) {
+      dst[i] = (s[i] << k) | (s[i + 1] >> (32 - k));
+    }
+  }
+}
+
+// Fills the rows [first, last) of the sheared image, a block at a time.
+static void shearRows(void *arg, l_int32 first, l_int32 last) {
+  ShearJob *job = (ShearJob *) arg;
+  l_int32 ws, hs, d, w, h;
+  pixGetDimensions(job->pixs, &ws, &hs, &d);
+  pixGetDimensions(job->pixd, &w, &h, NULL);
+  l_int32 wpls = pixGetWpl(job->pixs);
+  l_int32 wpld = pixGetWpl(job->pixd);
+  const l_uint32 *datas = pixGetData(job->pixs);
+  l_uint32 *datad = pixGetData(job->pixd);
+  // The pixels of the last word of a row, padding being left 0.
+  l_uint32 lastMask = ((w * d) & 31) ? ~(0xffffffff >> ((w * d) & 31)) : 0xffffffff;
+
+  for (l_int32 y0 = first; y0 < last; y0 += kRowsPerBlock) {
+    l_int32 y1 = L_MIN(last, y0 + kRowsPerBlock);
+    // The incoming colour, as by pixSetBlackOrWhite.
+    memset(datad + y0 * wpld, job->fill, 4 * (y1 - y0) * wpld);
+    if (job->fill != 0) {
+      for (l_int32 y = y0; y < y1; y++) {
+        datad[y * wpld + wpld - 1] &= lastMask;
+      }
+    }
+
+    // Strips of columns are copied a row at a time, row y taking columns
+    // of row y - shift of the horizontally sheared canvas, which are in
+    // turn columns of a row of pixs.
+    for (l_int32 i = 0; i < job->count; i++) {
+      const ShearBand *strip = job->strips + i;
+      l_int32 a = L_MAX(strip->shift, y0);
+      l_int32 b = L_MIN(strip->shift + h, y1);
+      for (l_int32 y = a; y < b; y++) {
+        l_int32 r = y - strip->shift;
+        l_int32 rs = r - job->yoff;
+        l_int32 hshift = job->rowShift[r];
+        if (rs < 0 || rs >= hs || hshift == kNoShift) {
+          continue;
+        }
+        l_int32 x0 = L_MAX(L_MAX(strip->start, 0), hshift + job->xoff);
+        l_int32 x1 = L_MIN(L_MIN(strip->start + strip->size, w), hshift + job->xoff + ws);
+        if (x0 < x1) {
+          copyPixels(datad + y * wpld, x0, datas + rs * wpls, wpls, x0 - hshift - job->xoff,
+                     x1 - x0, d);
+        }
+      }
+    }
+  }
+}
+
+// Shears pixs, placed at (xoff, yoff) on a canvas the size of pixd,
+// horizontally by hangle about row ycen, as pixHShear, then vertically by
+// vangle about column xcen, as pixVShear, into pixd. An angle of 0 skips
+// that shear. The angles are well within (-pi/2, pi/2). Returns pixd, or
+// NULL if out of memory.
+static PIX *shear(PIX *pixs, l_int32 xoff, l_int32 yoff, PIX *pixd, l_float32 hangle,
+                  l_float32 vangle, l_int32 incolor, l_int32 numThreads) {
+  l_int32 w, h;
+  pixGetDimensions(pixd, &w, &h, NULL);
+  l_int32 *rowShift = (l_int32 *) malloc(h * sizeof(l_int32));
+  ShearBand *bands = (ShearBand *) malloc((L_MAX(w, h) + 2) * sizeof(ShearBand));
+  if (rowShift == NULL || bands == NULL) {
+    free(rowShift);
+    free(bands);
+    pixDestroy(&pixd);
+    return NULL;
+  }
+
+  for (l_int32 y = 0; y < h; y++) {
+    rowShift[y] = 0;
+  }
+  if (hangle != 0.0 && tan(hangle) != 0.0) {
+    l_int32 count = findShearBands(h, h / 2, hangle, true, bands);
+    for (l_int32 y = 0; y < h; y++) {
+      rowShift[y] = kNoShift;
+    }
+    for (l_int32 i = 0; i < count; i++) {
+      for (l_int32 y = L_MAX(bands[i].start, 0); y < L_MIN(bands[i].start + bands[i].size, h);
+           y++) {
+        rowShift[y] = bands[i].shift;
+      }
+    }
+  }
+
+  ShearJob job;
+  job.pixs = pixs;
+  job.xoff = xoff;
+  job.yoff = yoff;
+  job.pixd = pixd;
+  job.rowShift = rowShift;
+  job.strips = bands;
+  if (vangle != 0.0 && tan(vangle) != 0.0) {
+    job.count = findShearBands(w, w / 2, vangle, false, bands);
+  } else {
+    bands[0].start = 0;
+    bands[0].size = w;
+    bands[0].shift = 0;
+    job.count = 1;
+  }
+  job.fill = ((pixGetDepth(pixs) == 1) == (incolor == L_BRING_IN_WHITE)) ? 0 : 0xff;
+  runParallel(shearRows, &job, h, kRowsPerBlock, numThreads);
+
+  free(rowShift);
+  free(bands);
+  return pixd;
+}
+
+/************
+ * Rotation *
+ ************/
+
+// Rotates pixs, placed at (xoff, yoff) on a w x h canvas of the incoming
+// colour, about the center of the canvas, as pixRotateShearCenter of the
+// canvas. The 2 shears are done in one pass, and the last 2 of 3 shears.
+static PIX *rotatePlaced(PIX *pixs, l_int32 xoff, l_int32 yoff, l_int32 w, l_int32 h,
+                         l_float32 angle, l_int32 incolor, l_int32 numThreads) {
+  // The canvas is made as by pixEmbedForRotation.
+  PIX *pixd;
+  if (w == pixGetWidth(pixs) && h == pixGetHeight(pixs)) {
+    pixd = pixCreateTemplate(pixs);
+  } else {
+    pixd = pixCreate(w, h, pixGetDepth(pixs));
+    if (pixd != NULL) {
+      pixCopyResolution(pixd, pixs);
+      pixCopySpp(pixd, pixs);
+      pixCopyText(pixd, pixs);
+    }
+  }
+  if (pixd == NULL) {
+    return NULL;
+  }
+
+  if (L_ABS(angle) <= kMax2ShearAngle) {
+    return shear(pixs, xoff, yoff, pixd, angle, angle, incolor, numThreads);
+  }
+
+  PIX *pix1 = shear(pixs, xoff, yoff, pixd, 0.0, angle / 2., incolor, numThreads);
+  PIX *pix2 = pix1 ? pixCreateTemplate(pix1) : NULL;
+  l_float32 hangle = atan(sin(angle));
+  pixd = pix2 ? shear(pix1, 0, 0, pix2, hangle, angle / 2., incolor, numThreads) : NULL;
+  pixDestroy(&pix1);
+
+  return pixd;
+}
+
+// Rotates an image with an alpha component as pixRotateShear does it.
+static PIX *rotateWithAlpha(PIX *pixs, l_float32 angle, l_int32 incolor, l_int32 numThreads) {
+  l_int32 w, h;
+  pixGetDimensions(pixs, &w, &h, NULL);
+  PIX *pixd = rotatePlaced(pixs, 0, 0, w, h, angle, incolor, numThreads);
+
+  if (pixd != NULL && pixGetDepth(pixs) == 32 && pixGetSpp(pixs) == 4) {
+    // L_BRING_IN_WHITE brings in opaque for the alpha component.
+    PIX *pix1 = pixGetRGBComponent(pixs, L_ALPHA_CHANNEL);
+    PIX *pix2 = pix1 ? rotatePlaced(pix1, 0, 0, w, h, angle, L_BRING_IN_WHITE, numThreads)
+                     : NULL;
+    pixSetRGBComponent(pixd, pix2, L_ALPHA_CHANNEL);
+    pixDestroy(&pix1);
+    pixDestroy(&pix2);
+  }
+
+  return pixd;
+}
+
+PIX *rotateShearCenterParallel(PIX *pixs, l_float32 angle, l_int32 incolor, l_int32 numThreads) {
+  if (pixs == NULL || pixGetColormap(pixs) != NULL ||
+      (incolor != L_BRING_IN_WHITE && incolor != L_BRING_IN_BLACK) ||
+      L_ABS(angle) > kLimitShearAngle) {
+    // Leptonica handles colormaps and reports the errors.
+    return pixRotateShearCenter(pixs, angle, incolor);
+  }
+  if (L_ABS(angle) < kMinAngleToRotate) {
+    return pixClone(pixs);
+  }
+
+  return rotateWithAlpha(pixs, angle, incolor, numThreads);
+}
+
+PIX *rotateParallel(PIX *pixs, l_float32 angle, l_int32 type, l_int32 incolor, l_int32 width,
+                    l_int32 height, l_int32 numThreads) {
+  if (pixs == NULL || pixGetColormap(pixs) != NULL || L_ABS(angle) < kMinAngleToRotate ||
+      (type != L_ROTATE_SHEAR && type != L_ROTATE_AREA_MAP && type != L_ROTATE_SAMPLING) ||
+      (incolor != L_BRING_IN_WHITE && incolor != L_BRING_IN_BLACK)) {
+    // Leptonica handles colormaps and reports the errors.
+    return pixRotate(pixs, angle, type, incolor, width, height);
+  }
+
+  // The choice of pixRotate between shear and sampling.
+  if (pixGetDepth(pixs) == 1) {
+    type = (L_ABS(angle) > kMax1bppShearAngle) ? L_ROTATE_SAMPLING : L_ROTATE_SHEAR;
+  } else if (L_ABS(angle) > kLimitShearAngle && type == L_ROTATE_SHEAR) {
+    type = L_ROTATE_SAMPLING;
+  }
+  if (type != L_ROTATE_SHEAR) {
+    return pixRotate(pixs, angle, type, incolor, width, height);
+  }
+
+  // The size pixEmbedForRotation enlarges the image to, if it does.
+  l_int32 w, h;
+  pixGetDimensions(pixs, &w, &h, NULL);
+  l_int32 maxside = (l_int32) (sqrt((l_float64) (width * width) +
+                                    (l_float64) (height * height)) + 0.5);
+  if (w >= maxside && h >= maxside) {
+    return rotateWithAlpha(pixs, angle, incolor, numThreads);
+  }
+  l_float64 cosa = cos(angle);
+  l_float64 sina = sin(angle);
+  l_float64 fw = (l_float64) w;
+  l_float64 fh = (l_float64) h;
+  l_int32 w1 = (l_int32) (L_ABS(fw * cosa - fh * sina) + 0.5);
+  l_int32 w2 = (l_int32) (L_ABS(-fw * cosa - fh * sina) + 0.5);
+  l_int32 h1 = (l_int32) (L_ABS(fw * sina + fh * cosa) + 0.5);
+  l_int32 h2 = (l_int32) (L_ABS(-fw * sina + fh * cosa) + 0.5);
+  l_int32 wnew = L_MAX(w, L_MAX(w1, w2));
+  l_int32 hnew = L_MAX(h, L_MAX(h1, h2));
+
+  if (pixGetSpp(pixs) == 4) {
+    // The alpha component is embedded in the incoming colour but rotated
+    // bringing in opaque, which one pass cannot do.
+    PIX *pixt = pixEmbedForRotation(pixs, angle, incolor, width, height);
+    PIX *pixd = pixt ? rotateWithAlpha(pixt, angle, incolor, numThreads) : NULL;
+    pixDestroy(&pixt);
+    return pixd;
+  }
+
+  return rotatePlaced(pixs, (wnew - w) / 2, (hnew - h) / 2, wnew, hnew, angle, incolor,
+                      numThreads);
+}
@@ -0,0 +1,36 @@
+/*
+ * Copyright 2017, Google Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LEPTONICA_JNI_ROTATE_H
+#define LEPTONICA_JNI_ROTATE_H
+
+#include <allheaders.h>
+
+// Shear rotation split across bands of rows. The results are the same as
+// those of the Leptonica functions named. numThreads <= 0 uses one thread
+// per core.
+
+// Rotates an image about its center by 2 or 3 shears, as
+// pixRotateShearCenter. Colormapped images and angles too large for shear
+// rotation are passed on to pixRotateShearCenter.
+PIX *rotateShearCenterParallel(PIX *pixs, l_float32 angle, l_int32 incolor, l_int32 numThreads);
+
+// Rotates an image about its center, as pixRotate. Only shear rotation is
+// split across threads; the other types are passed on to pixRotate.
+PIX *rotateParallel(PIX *pixs, l_float32 angle, l_int32 type, l_int32 incolor, l_int32 width,
+                    l_int32 height, l_int32 numThreads);
+
+#endif
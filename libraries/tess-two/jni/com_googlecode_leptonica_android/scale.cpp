@@ -0,0 +1,645 @@
+/*
+ * Copyright 2017, Google Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "scale.h"
+#include "parallel.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__SSE2__)
+#define SSE2_BUILD 1
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define NEON_BUILD 1
+#include <arm_neon.h>
+#endif
+
+// Fewest destination rows given to a thread.
+static const l_int32 kMinRowsPerThread = 8;
+
+// The index, among the bytes of a Pix row, of the 8 bpp pixel x.
+static inline l_int32 byteOffset(l_int32 x) {
+#ifdef L_BIG_ENDIAN
+  return x;
+#else
+  return x ^ 3;
+#endif
+}
+
+// The index, among the bytes of a 32 bpp pixel, of the component at shift.
+static inline l_int32 componentOffset(l_int32 shift) {
+#ifdef L_BIG_ENDIAN
+  return 3 - shift / 8;
+#else
+  return shift / 8;
+#endif
+}
+
+static const l_int32 kShifts[3] = {L_RED_SHIFT, L_GREEN_SHIFT, L_BLUE_SHIFT};
+
+/*********************
+ * Vector primitives *
+ *********************/
+
+// Adds weight * src[i] to sums[i].
+static void addWeightedBytes(l_uint32 *sums, const l_uint8 *src, l_int32 n, l_int32 weight) {
+  l_int32 i = 0;
+#if defined(SSE2_BUILD)
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i w = _mm_set1_epi16((short) weight);
+  for (; i + 16 <= n; i += 16) {
+    __m128i s = _mm_loadu_si128((const __m128i *) (src + i));
+    __m128i lo = _mm_mullo_epi16(_mm_unpacklo_epi8(s, zero), w);
+    __m128i hi = _mm_mullo_epi16(_mm_unpackhi_epi8(s, zero), w);
+    __m128i *d = (__m128i *) (sums + i);
+    _mm_storeu_si128(d, _mm_add_epi32(_mm_loadu_si128(d), _mm_unpacklo_epi16(lo, zero)));
+    _mm_storeu_si128(d + 1, _mm_add_epi32(_mm_loadu_si128(d + 1), _mm_unpackhi_epi16(lo, zero)));
+    _mm_storeu_si128(d + 2, _mm_add_epi32(_mm_loadu_si128(d + 2), _mm_unpacklo_epi16(hi, zero)));
+    _mm_storeu_si128(d + 3, _mm_add_epi32(_mm_loadu_si128(d + 3), _mm_unpackhi_epi16(hi, zero)));
+  }
+#elif defined(NEON_BUILD)
+  for (; i + 16 <= n; i += 16) {
+    uint8x16_t s = vld1q_u8(src + i);
+    uint16x8_t lo = vmovl_u8(vget_low_u8(s));
+    uint16x8_t hi = vmovl_u8(vget_high_u8(s));
+    vst1q_u32(sums + i, vmlal_n_u16(vld1q_u32(sums + i), vget_low_u16(lo), (uint16_t) weight));
+    vst1q_u32(sums + i + 4,
+              vmlal_n_u16(vld1q_u32(sums + i + 4), vget_high_u16(lo), (uint16_t) weight));
+    vst1q_u32(sums + i + 8,
+              vmlal_n_u16(vld1q_u32(sums + i + 8), vget_low_u16(hi), (uint16_t) weight));
+    vst1q_u32(sums + i + 12,
+              vmlal_n_u16(vld1q_u32(sums + i + 12), vget_high_u16(hi), (uint16_t) weight));
+  }
+#endif
+  for (; i < n; i++) {
+    sums[i] += weight * src[i];
+  }
+}
+
+// Sets dst[i] to (16 - fraction) * a[i] + fraction * b[i], fraction being
+// in [0, 16).
+static void blendBytes(l_uint16 *dst, const l_uint8 *a, const l_uint8 *b, l_int32 n,
+                       l_int32 fraction) {
+  l_int32 i = 0;
+#if defined(SSE2_BUILD)
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i wa = _mm_set1_epi16((short) (16 - fraction));
+  const __m128i wb = _mm_set1_epi16((short) fraction);
+  for (; i + 16 <= n; i += 16) {
+    __m128i va = _mm_loadu_si128((const __m128i *) (a + i));
+    __m128i vb = _mm_loadu_si128((const __m128i *) (b + i));
+    __m128i lo = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(va, zero), wa),
+                               _mm_mullo_epi16(_mm_unpacklo_epi8(vb, zero), wb));
+    __m128i hi = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(va, zero), wa),
+                               _mm_mullo_epi16(_mm_unpackhi_epi8(vb, zero), wb));
+    _mm_storeu_si128((__m128i *) (dst + i), lo);
+    _mm_storeu_si128((__m128i *) (dst + i + 8), hi);
+  }
+#elif defined(NEON_BUILD)
+  const uint8x8_t wa = vdup_n_u8((uint8_t) (16 - fraction));
+  const uint8x8_t wb = vdup_n_u8((uint8_t) fraction);
+  for (; i + 8 <= n; i += 8) {
+    vst1q_u16(dst + i, vmlal_u8(vmull_u8(vld1_u8(a + i), wa), vld1_u8(b + i), wb));
+  }
+#endif
+  for (; i < n; i++) {
+    dst[i] = (l_uint16) ((16 - fraction) * a[i] + fraction * b[i]);
+  }
+}
+
+// Sets dst[i] to a[i] + b[i].
+static void addBytes(l_uint16 *dst, const l_uint8 *a, const l_uint8 *b, l_int32 n) {
+  l_int32 i = 0;
+#if defined(SSE2_BUILD)
+  const __m128i zero = _mm_setzero_si128();
+  for (; i + 16 <= n; i += 16) {
+    __m128i va = _mm_loadu_si128((const __m128i *) (a + i));
+    __m128i vb = _mm_loadu_si128((const __m128i *) (b + i));
+    _mm_storeu_si128((__m128i *) (dst + i),
+                     _mm_add_epi16(_mm_unpacklo_epi8(va, zero), _mm_unpacklo_epi8(vb, zero)));
+    _mm_storeu_si128((__m128i *) (dst + i + 8),
+                     _mm_add_epi16(_mm_unpackhi_epi8(va, zero), _mm_unpackhi_epi8(vb, zero)));
+  }
+#elif defined(NEON_BUILD)
+  for (; i + 8 <= n; i += 8) {
+    vst1q_u16(dst + i, vaddl_u8(vld1_u8(a + i), vld1_u8(b + i)));
+  }
+#endif
+  for (; i < n; i++) {
+    dst[i] = (l_uint16) (a[i] + b[i]);
+  }
+}
+
+/**************
+ * Row bands  *
+ **************/
+
+// A scaling of pixs into pixd, shared by the threads that each fill a band
+// of rows of pixd.
+struct ScaleJob {
+  PIX *pixs;
+  PIX *pixd;
+  l_float32 scy;
+  // For each column of pixd, the source columns and fractions it is made
+  // from: xup, xuf, xlp and xlf for area mapping, xp, xf and x1 for linear
+  // interpolation.
+  const l_int32 *columns;
+};
+
+// Area mapping of the rows [first, last), as scaleGrayAreaMapLow and
+// scaleColorAreaMapLow. The weights of the source pixels are the product of
+// a row weight and a column weight, so each row of sums over the source
+// rows is taken a vector at a time, and the columns are summed from it.
+static void areaMapRows(void *arg, l_int32 first, l_int32 last) {
+  ScaleJob *job = (ScaleJob *) arg;
+  l_int32 ws, hs, d;
+  pixGetDimensions(job->pixs, &ws, &hs, &d);
+  l_int32 wd = pixGetWidth(job->pixd);
+  l_int32 wpls = pixGetWpl(job->pixs);
+  l_int32 wpld = pixGetWpl(job->pixd);
+  l_int32 rowBytes = 4 * wpls;
+  const l_uint32 *datas = pixGetData(job->pixs);
+  l_uint32 *sums = (l_uint32 *) malloc(rowBytes * sizeof(l_uint32));
+  if (sums == NULL) {
+    return;
+  }
+
+  for (l_int32 i = first; i < last; i++) {
+    l_int32 yu = (l_int32) (job->scy * i);
+    l_int32 yl = (l_int32) (job->scy * (i + 1.0));
+    l_int32 yup = yu >> 4;
+    l_int32 yuf = yu & 0x0f;
+    l_int32 ylp = yl >> 4;
+    l_int32 ylf = yl & 0x0f;
+    l_int32 dely = ylp - yup;
+    const l_uint32 *lines = datas + yup * wpls;
+    l_uint32 *lined = pixGetData(job->pixd) + i * wpld;
+    bool nearEdge = ylp > hs - 2;
+
+    if (!nearEdge) {
+      memset(sums, 0, rowBytes * sizeof(l_uint32));
+      addWeightedBytes(sums, (const l_uint8 *) lines, rowBytes, 16 - yuf);
+      for (l_int32 k = 1; k < dely; k++) {
+        addWeightedBytes(sums, (const l_uint8 *) (lines + k * wpls), rowBytes, 16);
+      }
+      if (ylf > 0) {
+        addWeightedBytes(sums, (const l_uint8 *) (lines + dely * wpls), rowBytes, ylf);
+      }
+    }
+    l_int32 areay = (16 - yuf) + 16 * (dely - 1) + ylf;
+
+    for (l_int32 j = 0; j < wd; j++) {
+      const l_int32 *column = job->columns + 4 * j;
+      l_int32 xup = column[0];
+      l_int32 xuf = column[1];
+      l_int32 xlp = column[2];
+      l_int32 xlf = column[3];
+
+      // If near the edge, just use a src pixel value.
+      if (nearEdge || xlp > ws - 2) {
+        if (d == 8) {
+          SET_DATA_BYTE(lined, j, GET_DATA_BYTE(lines, xup));
+        } else {
+          lined[j] = lines[xup];
+        }
+        continue;
+      }
+
+      l_int32 area = ((16 - xuf) + 16 * (xlp - xup - 1) + xlf) * areay;
+      if (d == 8) {
+        l_uint32 inner = 0;
+        for (l_int32 x = xup + 1; x < xlp; x++) {
+          inner += sums[byteOffset(x)];
+        }
+        l_uint32 sum = (16 - xuf) * sums[byteOffset(xup)] + 16 * inner +
+                       xlf * sums[byteOffset(xlp)];
+        SET_DATA_BYTE(lined, j, (sum + 128) / area);
+      } else {
+        l_int32 val[3];
+        for (l_int32 c = 0; c < 3; c++) {
+          const l_uint32 *component = sums + componentOffset(kShifts[c]);
+          l_uint32 inner = 0;
+          for (l_int32 x = xup + 1; x < xlp; x++) {
+            inner += component[4 * x];
+          }
+          l_uint32 sum = (16 - xuf) * component[4 * xup] + 16 * inner +
+                         xlf * component[4 * xlp];
+          val[c] = (l_int32) ((sum + 128) / area);
+        }
+        composeRGBPixel(val[0], val[1], val[2], lined + j);
+      }
+    }
+  }
+
+  free(sums);
+}
+
+// Sets dst[j], for the n columns described by columns, to the interpolation
+// between the 32 bpp pixels xp and x1 of a row of blend, with the alpha
+// component 0.
+static void interpolateColorColumns(l_uint32 *dst, const l_uint16 *blend,
+                                    const l_int32 *columns, l_int32 n) {
+  const l_uint32 colorMask = ~(0xffU << L_ALPHA_SHIFT);
+  l_int32 j = 0;
+#if defined(SSE2_BUILD)
+  // Sums are at most 16 * 4080 + 128, so they fit 16 bits unsigned.
+  const __m128i mask = _mm_set1_epi32((int) colorMask);
+  const __m128i round = _mm_set1_epi16(128);
+  for (; j + 2 <= n; j += 2) {
+    const l_int32 *c0 = columns + 3 * j;
+    const l_int32 *c1 = c0 + 3;
+    __m128i p = _mm_unpacklo_epi64(_mm_loadl_epi64((const __m128i *) (blend + 4 * c0[0])),
+                                   _mm_loadl_epi64((const __m128i *) (blend + 4 * c1[0])));
+    __m128i p1 = _mm_unpacklo_epi64(_mm_loadl_epi64((const __m128i *) (blend + 4 * c0[2])),
+                                    _mm_loadl_epi64((const __m128i *) (blend + 4 * c1[2])));
+    __m128i w = _mm_unpacklo_epi64(_mm_set1_epi16((short) (16 - c0[1])),
+                                   _mm_set1_epi16((short) (16 - c1[1])));
+    __m128i w1 = _mm_unpacklo_epi64(_mm_set1_epi16((short) c0[1]), _mm_set1_epi16((short) c1[1]));
+    __m128i sum = _mm_add_epi16(_mm_add_epi16(_mm_mullo_epi16(p, w), _mm_mullo_epi16(p1, w1)),
+                                round);
+    sum = _mm_srli_epi16(sum, 8);
+    _mm_storel_epi64((__m128i *) (dst + j), _mm_and_si128(_mm_packus_epi16(sum, sum), mask));
+  }
+#elif defined(NEON_BUILD)
+  const uint32x2_t mask = vdup_n_u32(colorMask);
+  for (; j + 2 <= n; j += 2) {
+    const l_int32 *c0 = columns + 3 * j;
+    const l_int32 *c1 = c0 + 3;
+    uint16x8_t p = vcombine_u16(vld1_u16(blend + 4 * c0[0]), vld1_u16(blend + 4 * c1[0]));
+    uint16x8_t p1 = vcombine_u16(vld1_u16(blend + 4 * c0[2]), vld1_u16(blend + 4 * c1[2]));
+    uint16x8_t w = vcombine_u16(vdup_n_u16((uint16_t) (16 - c0[1])),
+                                vdup_n_u16((uint16_t) (16 - c1[1])));
+    uint16x8_t w1 = vcombine_u16(vdup_n_u16((uint16_t) c0[1]), vdup_n_u16((uint16_t) c1[1]));
+    uint16x8_t sum = vmlaq_u16(vmulq_u16(p, w), p1, w1);
+    uint8x8_t val = vraddhn_u16(sum, vdupq_n_u16(0));
+    vst1_u32(dst + j, vand_u32(vreinterpret_u32_u8(val), mask));
+  }
+#endif
+  for (; j < n; j++) {
+    const l_int32 *column = columns + 3 * j;
+    l_int32 xp = column[0];
+    l_int32 xf = column[1];
+    l_int32 x1 = column[2];
+    l_int32 val[3];
+    for (l_int32 c = 0; c < 3; c++) {
+      l_int32 offset = componentOffset(kShifts[c]);
+      l_int32 sum = (16 - xf) * blend[4 * xp + offset] + xf * blend[4 * x1 + offset];
+      val[c] = ((sum + 128) >> 8) & 0xff;
+    }
+    composeRGBPixel(val[0], val[1], val[2], dst + j);
+  }
+}
+
+// Linear interpolation of the rows [first, last), as scaleGrayLILow and
+// scaleColorLILow: each row is blended from two source rows a vector at a
+// time, then each pixel from two columns of the blend.
+static void linearRows(void *arg, l_int32 first, l_int32 last) {
+  ScaleJob *job = (ScaleJob *) arg;
+  l_int32 hs = pixGetHeight(job->pixs);
+  l_int32 d = pixGetDepth(job->pixs);
+  l_int32 wd = pixGetWidth(job->pixd);
+  l_int32 wpls = pixGetWpl(job->pixs);
+  l_int32 wpld = pixGetWpl(job->pixd);
+  l_int32 rowBytes = 4 * wpls;
+  const l_uint32 *datas = pixGetData(job->pixs);
+  l_uint16 *blend = (l_uint16 *) malloc(rowBytes * sizeof(l_uint16));
+  if (blend == NULL) {
+    return;
+  }
+
+  for (l_int32 i = first; i < last; i++) {
+    l_int32 ypm = (l_int32) (job->scy * (l_float32) i);
+    l_int32 yp = ypm >> 4;
+    l_int32 yf = ypm & 0x0f;
+    l_int32 y1 = (yp > hs - 2) ? yp : yp + 1;
+    l_uint32 *lined = pixGetData(job->pixd) + i * wpld;
+    blendBytes(blend, (const l_uint8 *) (datas + yp * wpls),
+               (const l_uint8 *) (datas + y1 * wpls), rowBytes, yf);
+    if (d == 32) {
+      interpolateColorColumns(lined, blend, job->columns, wd);
+      continue;
+    }
+
+    for (l_int32 j = 0; j < wd; j++) {
+      const l_int32 *column = job->columns + 3 * j;
+      l_int32 xp = column[0];
+      l_int32 xf = column[1];
+      l_int32 x1 = column[2];
+      l_int32 sum = (16 - xf) * blend[byteOffset(xp)] + xf * blend[byteOffset(x1)];
+      SET_DATA_BYTE(lined, j, (sum + 128) / 256);
+    }
+  }
+
+  free(blend);
+}
+
+// Sets dst to the averages, truncated, of the 2x2 blocks of 8 bpp pixels
+// of the row pair whose bytewise sums are pairs, n pixels in all.
+static void averageGrayPairs(l_uint32 *dst, const l_uint16 *pairs, l_int32 n) {
+  l_int32 j = 0;
+#if !defined(L_BIG_ENDIAN) && defined(SSE2_BUILD)
+  // Each destination word comes from two source words; on little endian
+  // machines its bytes are the pair sums of the second source word, then
+  // those of the first.
+  const __m128i ones = _mm_set1_epi16(1);
+  for (; j + 16 <= n; j += 16) {
+    const __m128i *src = (const __m128i *) (pairs + 2 * j);
+    __m128i s0 = _mm_madd_epi16(_mm_loadu_si128(src), ones);
+    __m128i s1 = _mm_madd_epi16(_mm_loadu_si128(src + 1), ones);
+    __m128i s2 = _mm_madd_epi16(_mm_loadu_si128(src + 2), ones);
+    __m128i s3 = _mm_madd_epi16(_mm_loadu_si128(src + 3), ones);
+    s0 = _mm_shuffle_epi32(_mm_srli_epi32(s0, 2), _MM_SHUFFLE(1, 0, 3, 2));
+    s1 = _mm_shuffle_epi32(_mm_srli_epi32(s1, 2), _MM_SHUFFLE(1, 0, 3, 2));
+    s2 = _mm_shuffle_epi32(_mm_srli_epi32(s2, 2), _MM_SHUFFLE(1, 0, 3, 2));
+    s3 = _mm_shuffle_epi32(_mm_srli_epi32(s3, 2), _MM_SHUFFLE(1, 0, 3, 2));
+    _mm_storeu_si128((__m128i *) (dst + j / 4),
+                     _mm_packus_epi16(_mm_packs_epi32(s0, s1), _mm_packs_epi32(s2, s3)));
+  }
+#elif !defined(L_BIG_ENDIAN) && defined(NEON_BUILD)
+  for (; j + 8 <= n; j += 8) {
+    uint16x8_t s0 = vld1q_u16(pairs + 2 * j);
+    uint16x8_t s1 = vld1q_u16(pairs + 2 * j + 8);
+    uint8x8_t avg = vshrn_n_u16(vcombine_u16(vpadd_u16(vget_low_u16(s0), vget_high_u16(s0)),
+                                             vpadd_u16(vget_low_u16(s1), vget_high_u16(s1))),
+                                2);
+    vst1_u8((uint8_t *) (dst + j / 4), vreinterpret_u8_u16(vrev32_u16(vreinterpret_u16_u8(avg))));
+  }
+#endif
+  for (; j < n; j++) {
+    SET_DATA_BYTE(dst, j, (pairs[byteOffset(2 * j)] + pairs[byteOffset(2 * j + 1)]) >> 2);
+  }
+}
+
+// Sets dst to the averages, truncated, of the 2x2 blocks of 32 bpp pixels
+// of the row pair whose bytewise sums are pairs, n pixels in all, with the
+// alpha component 0.
+static void averageColorPairs(l_uint32 *dst, const l_uint16 *pairs, l_int32 n) {
+  const l_uint32 colorMask = ~(0xffU << L_ALPHA_SHIFT);
+  l_int32 j = 0;
+#if defined(SSE2_BUILD)
+  const __m128i mask = _mm_set1_epi32((int) colorMask);
+  for (; j + 2 <= n; j += 2) {
+    const __m128i *src = (const __m128i *) (pairs + 8 * j);
+    __m128i p01 = _mm_loadu_si128(src);
+    __m128i p23 = _mm_loadu_si128(src + 1);
+    p01 = _mm_add_epi16(p01, _mm_srli_si128(p01, 8));
+    p23 = _mm_add_epi16(p23, _mm_srli_si128(p23, 8));
+    __m128i avg = _mm_srli_epi16(_mm_unpacklo_epi64(p01, p23), 2);
+    _mm_storel_epi64((__m128i *) (dst + j), _mm_and_si128(_mm_packus_epi16(avg, avg), mask));
+  }
+#elif defined(NEON_BUILD)
+  const uint32x2_t mask = vdup_n_u32(colorMask);
+  for (; j + 2 <= n; j += 2) {
+    uint16x8_t p01 = vld1q_u16(pairs + 8 * j);
+    uint16x8_t p23 = vld1q_u16(pairs + 8 * j + 8);
+    uint8x8_t avg = vshrn_n_u16(vcombine_u16(vadd_u16(vget_low_u16(p01), vget_high_u16(p01)),
+                                             vadd_u16(vget_low_u16(p23), vget_high_u16(p23))),
+                                2);
+    vst1_u32(dst + j, vand_u32(vreinterpret_u32_u8(avg), mask));
+  }
+#endif
+  for (; j < n; j++) {
+    l_int32 val[3];
+    for (l_int32 c = 0; c < 3; c++) {
+      l_int32 offset = 8 * j + componentOffset(kShifts[c]);
+      val[c] = (pairs[offset] + pairs[offset + 4]) >> 2;
+    }
+    composeRGBPixel(val[0], val[1], val[2], dst + j);
+  }
+}
+
+// 2x reduction of the rows [first, last), as scaleAreaMapLow2.
+static void areaMap2Rows(void *arg, l_int32 first, l_int32 last) {
+  ScaleJob *job = (ScaleJob *) arg;
+  l_int32 d = pixGetDepth(job->pixs);
+  l_int32 wd = pixGetWidth(job->pixd);
+  l_int32 wpls = pixGetWpl(job->pixs);
+  l_int32 wpld = pixGetWpl(job->pixd);
+  l_int32 rowBytes = 4 * wpls;
+  const l_uint32 *datas = pixGetData(job->pixs);
+  l_uint16 *pairs = (l_uint16 *) malloc(rowBytes * sizeof(l_uint16));
+  if (pairs == NULL) {
+    return;
+  }
+
+  for (l_int32 i = first; i < last; i++) {
+    const l_uint32 *lines = datas + 2 * i * wpls;
+    l_uint32 *lined = pixGetData(job->pixd) + i * wpld;
+    addBytes(pairs, (const l_uint8 *) lines, (const l_uint8 *) (lines + wpls), rowBytes);
+    if (d == 8) {
+      averageGrayPairs(lined, pairs, wd);
+    } else {
+      averageColorPairs(lined, pairs, wd);
+    }
+  }
+
+  free(pairs);
+}
+
+/***********
+ * Scaling *
+ ***********/
+
+// Reduces an 8 or 32 bpp image by 2, as pixScaleAreaMap2.
+static PIX *scaleAreaMap2(PIX *pixs, l_int32 numThreads) {
+  l_int32 wd = pixGetWidth(pixs) / 2;
+  l_int32 hd = pixGetHeight(pixs) / 2;
+  if (wd < 1 || hd < 1) {
+    return NULL;
+  }
+
+  ScaleJob job;
+  job.pixs = pixs;
+  job.pixd = pixCreate(wd, hd, pixGetDepth(pixs));
+  job.scy = 0.0;
+  job.columns = NULL;
+  if (job.pixd == NULL) {
+    return NULL;
+  }
+  pixCopyInputFormat(job.pixd, pixs);
+  pixCopyResolution(job.pixd, pixs);
+  pixScaleResolution(job.pixd, 0.5, 0.5);
+
+  runParallel(areaMap2Rows, &job, hd, kMinRowsPerThread, numThreads);
+  if (pixGetSpp(pixs) == 4) {
+    pixScaleAndTransferAlpha(job.pixd, pixs, 0.5, 0.5);
+  }
+
+  return job.pixd;
+}
+
+// Reduces an 8 or 32 bpp image by factors below 0.7, as pixScaleAreaMap.
+static PIX *scaleAreaMap(PIX *pixs, l_float32 scalex, l_float32 scaley, l_int32 numThreads) {
+  // Special cases: 2x, 4x, 8x, 16x reduction.
+  if (scalex == scaley &&
+      (scalex == 0.5 || scalex == 0.25 || scalex == 0.125 || scalex == 0.0625)) {
+    PIX *pixd = pixClone(pixs);
+    for (l_float32 scale = 1.0; scale > scalex && pixd != NULL; scale /= 2) {
+      PIX *pixt = scaleAreaMap2(pixd, numThreads);
+      pixDestroy(&pixd);
+      pixd = pixt;
+    }
+    return pixd;
+  }
+
+  l_int32 ws, hs, d;
+  pixGetDimensions(pixs, &ws, &hs, &d);
+  l_int32 wd = (l_int32) (scalex * (l_float32) ws + 0.5);
+  l_int32 hd = (l_int32) (scaley * (l_float32) hs + 0.5);
+  if (wd < 1 || hd < 1) {
+    return NULL;
+  }
+
+  l_int32 *columns = (l_int32 *) malloc(4 * wd * sizeof(l_int32));
+  if (columns == NULL) {
+    return NULL;
+  }
+  l_float32 scx = 16. * (l_float32) ws / (l_float32) wd;
+  for (l_int32 j = 0; j < wd; j++) {
+    l_int32 xu = (l_int32) (scx * j);
+    l_int32 xl = (l_int32) (scx * (j + 1.0));
+    columns[4 * j] = xu >> 4;
+    columns[4 * j + 1] = xu & 0x0f;
+    columns[4 * j + 2] = xl >> 4;
+    columns[4 * j + 3] = xl & 0x0f;
+  }
+
+  ScaleJob job;
+  job.pixs = pixs;
+  job.pixd = pixCreate(wd, hd, d);
+  job.scy = 16. * (l_float32) hs / (l_float32) hd;
+  job.columns = columns;
+  if (job.pixd != NULL) {
+    pixCopyInputFormat(job.pixd, pixs);
+    pixCopyResolution(job.pixd, pixs);
+    pixScaleResolution(job.pixd, scalex, scaley);
+
+    runParallel(areaMapRows, &job, hd, kMinRowsPerThread, numThreads);
+    if (d == 32 && pixGetSpp(pixs) == 4) {
+      pixScaleAndTransferAlpha(job.pixd, pixs, scalex, scaley);
+    }
+  }
+
+  free(columns);
+  return job.pixd;
+}
+
+// Scales an 8 or 32 bpp image by factors of 0.7 or more, as pixScaleGrayLI
+// and pixScaleColorLI.
+static PIX *scaleLI(PIX *pixs, l_float32 scalex, l_float32 scaley, l_int32 numThreads) {
+  l_int32 ws, hs, d;
+  pixGetDimensions(pixs, &ws, &hs, &d);
+
+  // Leptonica has its own code for these.
+  if ((scalex == 1.0 && scaley == 1.0) || (scalex == 2.0 && scaley == 2.0) ||
+      (scalex == 4.0 && scaley == 4.0)) {
+    return (d == 8) ? pixScaleGrayLI(pixs, scalex, scaley) : pixScaleColorLI(pixs, scalex, scaley);
+  }
+
+  l_int32 wd = (l_int32) (scalex * (l_float32) ws + 0.5);
+  l_int32 hd = (l_int32) (scaley * (l_float32) hs + 0.5);
+  if (wd < 1 || hd < 1) {
+    return NULL;
+  }
+
+  l_int32 *columns = (l_int32 *) malloc(3 * wd * sizeof(l_int32));
+  if (columns == NULL) {
+    return NULL;
+  }
+  l_float32 scx = 16. * (l_float32) ws / (l_float32) wd;
+  for (l_int32 j = 0; j < wd; j++) {
+    l_int32 xpm = (l_int32) (scx * (l_float32) j);
+    l_int32 xp = xpm >> 4;
+    columns[3 * j] = xp;
+    columns[3 * j + 1] = xpm & 0x0f;
+    columns[3 * j + 2] = (xp > ws - 2) ? xp : xp + 1;
+  }
+
+  ScaleJob job;
+  job.pixs = pixs;
+  job.pixd = pixCreate(wd, hd, d);
+  job.scy = 16. * (l_float32) hs / (l_float32) hd;
+  job.columns = columns;
+  if (job.pixd != NULL) {
+    if (d == 8) {
+      pixCopyText(job.pixd, pixs);
+    }
+    pixCopyResolution(job.pixd, pixs);
+    pixCopyInputFormat(job.pixd, pixs);
+    pixScaleResolution(job.pixd, scalex, scaley);
+
+    runParallel(linearRows, &job, hd, kMinRowsPerThread, numThreads);
+    if (d == 32 && pixGetSpp(pixs) == 4) {
+      pixScaleAndTransferAlpha(job.pixd, pixs, scalex, scaley);
+    }
+  }
+
+  free(columns);
+  return job.pixd;
+}
+
+PIX *scaleGeneralParallel(PIX *pixs, l_float32 scalex, l_float32 scaley, l_float32 sharpfract,
+                          l_int32 sharpwidth, l_int32 numThreads) {
+  if (pixs == NULL || pixGetDepth(pixs) == 1 || scalex <= 0.0 || scaley <= 0.0 ||
+      (scalex == 1.0 && scaley == 1.0)) {
+    // Leptonica scales binary images, copies and reports the errors.
+    return pixScaleGeneral(pixs, scalex, scaley, sharpfract, sharpwidth);
+  }
+  l_int32 d = pixGetDepth(pixs);
+  if (d != 2 && d != 4 && d != 8 && d != 16 && d != 32) {
+    return pixScaleGeneral(pixs, scalex, scaley, sharpfract, sharpwidth);
+  }
+
+  // Remove colormap; clone if possible; result is either 8 or 32 bpp.
+  PIX *pixt = pixConvertTo8Or32(pixs, L_CLONE, 0);
+  if (pixt == NULL) {
+    return NULL;
+  }
+
+  l_float32 maxscale = L_MAX(scalex, scaley);
+  bool sharpen = sharpfract > 0.0 && sharpwidth > 0;
+  PIX *pixt2;
+  if (maxscale < 0.7) {
+    pixt2 = scaleAreaMap(pixt, scalex, scaley, numThreads);
+    sharpen = sharpen && maxscale > 0.2;
+  } else {
+    pixt2 = scaleLI(pixt, scalex, scaley, numThreads);
+    sharpen = sharpen && maxscale < 1.4;
+  }
+  pixDestroy(&pixt);
+  if (pixt2 == NULL) {
+    return NULL;
+  }
+
+  PIX *pixd = sharpen ? pixUnsharpMasking(pixt2, sharpwidth, sharpfract) : pixClone(pixt2);
+  pixDestroy(&pixt2);
+  if (pixd != NULL) {
+    pixCopyText(pixd, pixs);
+    pixCopyInputFormat(pixd, pixs);
+  }
+
+  return pixd;
+}
+
+PIX *scaleParallel(PIX *pixs, l_float32 scalex, l_float32 scaley, l_int32 numThreads) {
+  // Reduce the default sharpening factors by 2 if maxscale < 0.7.
+  l_float32 maxscale = L_MAX(scalex, scaley);
+  l_float32 sharpfract = (maxscale < 0.7) ? 0.2 : 0.4;
+  l_int32 sharpwidth = (maxscale < 0.7) ? 1 : 2;
+
+  return scaleGeneralParallel(pixs, scalex, scaley, sharpfract, sharpwidth, numThreads);
+}
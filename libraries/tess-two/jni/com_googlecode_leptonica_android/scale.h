@@ -0,0 +1,36 @@
+/*
+ * Copyright 2017, Google Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LEPTONICA_JNI_SCALE_H
+#define LEPTONICA_JNI_SCALE_H
+
+#include <allheaders.h>
+
+// Scaling of 8 and 32 bpp images split across bands of rows, with SSE2 and
+// NEON versions of the inner loops where the build targets them. The
+// results are the same as those of the Leptonica functions named. 1 bpp
+// images and the 2x and 4x linear interpolation special cases are passed on
+// to Leptonica. numThreads <= 0 uses one thread per core.
+
+// Scales an image by area mapping when reducing by more than 0.7, and by
+// linear interpolation otherwise, then sharpens it, as pixScaleGeneral.
+PIX *scaleGeneralParallel(PIX *pixs, l_float32 scalex, l_float32 scaley, l_float32 sharpfract,
+                          l_int32 sharpwidth, l_int32 numThreads);
+
+// Scales an image with the default sharpening, as pixScale.
+PIX *scaleParallel(PIX *pixs, l_float32 scalex, l_float32 scaley, l_int32 numThreads);
+
+#endif
@@ -28,8 +28,8 @@
  * \file conncomp.c
  * <pre>
  *
- *    Connected component counting and extraction, using Heckbert's
- *    stack-based filling algorithm.
+ *    Connected component counting and extraction, using union-find
+ *    labelling of runs, and Heckbert's stack-based filling algorithm.
  *
  *      4- and 8-connected components: counts, bounding boxes and images
  *
@@ -58,33 +58,35 @@
  *           static void    pushFillseg()
  *           static void    popFillseg()
  *
- *  The basic method in pixConnCompBB() is very simple.  We scan the
- *  image in raster order, looking for the next ON pixel.  When it
- *  is found, we erase it and every pixel of the 4- or 8-connected
- *  component to which it belongs, using Heckbert's seedfill
- *  algorithm.  As pixels are erased, we keep track of the
- *  minimum rectangle that encloses all erased pixels; after
- *  the connected component has been erased, we save its
- *  bounding box in an array of boxes.  When all pixels in the
- *  image have been erased, we have an array that describes every
- *  4- or 8-connected component in terms of its bounding box.
+ *      Static helper functions for labelling runs with union-find:
+ *           static CCRUNS *ccRunsCreate()
+ *           static void    ccRunsDestroy()
+ *           static l_int32 ccRunsAddLine()
+ *           static l_int32 ccRunsAdd()
+ *           static l_int32 ccRunsFind()
+ *           static l_int32 ccRunsLabel()
+ *           static l_int32 *ccRunsGetBoxes()
+ *           static void    lineRangeSet()
+ *           static l_int32 leadingZeros()
  *
- *  pixConnCompPixa() is a slight variation on pixConnCompBB(),
- *  where we additionally save an array of images (in a Pixa)
- *  of each of the 4- or 8-connected components.  This is done trivially
- *  by maintaining two temporary images.  We erase a component from one,
- *  and use the bounding box to extract the pixels within the b.b.
- *  from each of the two images.  An XOR between these subimages
- *  gives the erased component.  Then we erase the component from the
- *  second image using the XOR again, with the extracted component
- *  placed on the second image at the location of the bounding box.
- *  Rasterop does all the work.  At the end, we have an array
- *  of the 4- or 8-connected components, as well as an array of the
- *  bounding boxes that describe where they came from in the original image.
+ *  The top-level calls make a single raster scan of the image.
+ *  Each line is encoded as the runs of ON pixels on it, and each
+ *  run is joined, in a union-find forest, with the runs on the line
+ *  above that it touches: those that overlap it for 4-connectivity,
+ *  and also those that meet it at a corner for 8-connectivity.
+ *  The union always makes the earlier run the root, so the root of
+ *  each tree is the run that holds the first pixel of the component
+ *  in raster order.  A second pass over the runs then numbers the
+ *  components in raster order of their first pixel, which is the
+ *  order in which the stack-based filling finds them, and sums up
+ *  the bounding boxes, or paints the runs into an image of each c.c.
+ *  Every pixel is read once, and the work on the runs is nearly
+ *  linear in their number, however the components are shaped.
  *
- *  If you just want the number of connected components, pixCountConnComp()
- *  is a bit faster than pixConnCompBB(), because it doesn't have to
- *  keep track of the bounding rectangles for each c.c.
+ *  The stack-based fill, pixSeedfillBB() and friends, erases the
+ *  single c.c. that holds a given pixel.  It uses Heckbert's seedfill
+ *  algorithm, keeping track of the minimum rectangle that encloses
+ *  all erased pixels.
  * </pre>
  */
 
@@ -105,6 +107,22 @@ struct FillSeg
 };
 typedef struct FillSeg    FILLSEG;
 
+/*!
+ * \brief   The struct CCRuns holds the runs of ON pixels in a 1 bpp image,
+ *  in raster order, with a union-find forest that joins the runs of
+ *  each connected component.
+ */
+struct CCRuns
+{
+    l_int32    n;        /*!< number of runs */
+    l_int32    nalloc;   /*!< size of allocated arrays */
+    l_int32   *y;        /*!< line of each run */
+    l_int32   *xstart;   /*!< first pixel of each run */
+    l_int32   *xend;     /*!< last pixel of each run */
+    l_int32   *parent;   /*!< parent in the forest; c.c. after labelling */
+};
+typedef struct CCRuns    CCRUNS;
+
 
     /* Static accessors for FillSegs on a stack */
 static void pushFillsegBB(L_STACK *stack, l_int32 xleft, l_int32 xright,
@@ -116,6 +134,25 @@ static void pushFillseg(L_STACK *stack, l_int32 xleft, l_int32 xright,
 static void popFillseg(L_STACK *stack, l_int32 *pxleft, l_int32 *pxright,
                        l_int32 *py, l_int32 *pdy);
 
+    /* Static helpers for union-find labelling of runs */
+static CCRUNS *ccRunsCreate(PIX *pixs, l_int32 connectivity);
+static void ccRunsDestroy(CCRUNS **pruns);
+static l_int32 ccRunsAddLine(CCRUNS *runs, l_uint32 *line, l_int32 w,
+                             l_int32 y);
+static l_int32 ccRunsAdd(CCRUNS *runs, l_int32 y, l_int32 xstart,
+                         l_int32 xend);
+static l_int32 ccRunsFind(CCRUNS *runs, l_int32 i);
+static l_int32 ccRunsLabel(CCRUNS *runs);
+static l_int32 *ccRunsGetBoxes(CCRUNS *runs, l_int32 ncomp);
+static void lineRangeSet(l_uint32 *line, l_int32 xstart, l_int32 xend);
+
+    /* Number of leading zero bits in a word that is not 0 */
+#if defined(__GNUC__)
+#define  LEADING_ZEROS(word)    __builtin_clz(word)
+#else
+static l_int32 leadingZeros(l_uint32 word);
+#define  LEADING_ZEROS(word)    leadingZeros(word)
+#endif  /* __GNUC__ */
 
 #ifndef  NO_CONSOLE_IO
 #define   DEBUG    0
@@ -176,10 +213,9 @@ pixConnComp(PIX     *pixs,
  *      (1) This finds bounding boxes of 4- or 8-connected components
  *          in a binary image, and saves images of each c.c
  *          in a pixa array.
- *      (2) It sets up 2 temporary pix, and for each c.c. that is
- *          located in raster order, it erases the c.c. from one pix,
- *          then uses the b.b. to extract the c.c. from the two pix using
- *          an XOR, and finally erases the c.c. from the second pix.
+ *      (2) The c.c. are found by union-find labelling of the runs of
+ *          ON pixels, in raster order of their first pixel.  Each
+ *          image is made from the runs of its c.c.
  *      (3) A clone of the returned boxa (where all boxes in the array
  *          are clones) is inserted into the pixa.
  *      (4) If the input is valid, this always returns a boxa and a pixa.
@@ -191,13 +227,13 @@ pixConnCompPixa(PIX     *pixs,
                 PIXA   **ppixa,
                 l_int32  connectivity)
 {
-l_int32   h, iszero;
-l_int32   x, y, xstart, ystart;
-PIX      *pix1, *pix2, *pix3, *pix4;
-PIXA     *pixa;
-BOX      *box;
-BOXA     *boxa;
-L_STACK  *stack, *auxstack;
+l_int32    i, iszero, ncomp, c, wpl;
+l_int32   *bb;
+l_uint32  *data;
+PIX       *pix1;
+PIXA      *pixa;
+BOXA      *boxa;
+CCRUNS    *runs;
 
     PROCNAME("pixConnCompPixa");
 
@@ -209,76 +245,59 @@ L_STACK  *stack, *auxstack;
     if (connectivity != 4 && connectivity != 8)
         return (BOXA *)ERROR_PTR("connectivity not 4 or 8", procName, NULL);
 
-    pix1 = pix2 = pix3 = pix4 = NULL;
-    stack = NULL;
     pixa = pixaCreate(0);
-    boxa = NULL;
     *ppixa = pixa;
     pixZero(pixs, &iszero);
     if (iszero)
         return boxaCreate(1);  /* return empty boxa and empty pixa */
 
-    pix1 = pixCopy(NULL, pixs);
-    pix2 = pixCopy(NULL, pixs);
-    if (!pix1 || !pix2) {
-        L_ERROR("pix1 or pix2 not made\n", procName);
+    if ((runs = ccRunsCreate(pixs, connectivity)) == NULL) {
         pixaDestroy(ppixa);
-        goto cleanup;
+        return (BOXA *)ERROR_PTR("runs not made", procName, NULL);
     }
-
-    h = pixGetHeight(pixs);
-    if ((stack = lstackCreate(h)) == NULL) {
-        L_ERROR("stack not made\n", procName);
+    ncomp = ccRunsLabel(runs);
+    if ((bb = ccRunsGetBoxes(runs, ncomp)) == NULL) {
+        ccRunsDestroy(&runs);
         pixaDestroy(ppixa);
-        goto cleanup;
+        return (BOXA *)ERROR_PTR("bb not made", procName, NULL);
     }
-    auxstack = lstackCreate(0);
-    stack->auxstack = auxstack;
-    boxa = boxaCreate(0);
-
-    xstart = 0;
-    ystart = 0;
-    while (1) {
-        if (!nextOnPixelInRaster(pix1, xstart, ystart, &x, &y))
-            break;
 
-        if ((box = pixSeedfillBB(pix1, stack, x, y, connectivity)) == NULL) {
+        /* Make an empty image of each c.c. and paint its runs into it */
+    boxa = boxaCreate(ncomp);
+    for (c = 0; c < ncomp; c++) {
+        boxaAddBox(boxa, boxCreate(bb[4 * c], bb[4 * c + 1],
+                                   bb[4 * c + 2] - bb[4 * c] + 1,
+                                   bb[4 * c + 3] - bb[4 * c + 1] + 1),
+                   L_INSERT);
+        if ((pix1 = pixCreate(bb[4 * c + 2] - bb[4 * c] + 1,
+                              bb[4 * c + 3] - bb[4 * c + 1] + 1, 1)) == NULL) {
+            L_ERROR("pix1 not made\n", procName);
             boxaDestroy(&boxa);
             pixaDestroy(ppixa);
-            L_ERROR("box not made\n", procName);
             goto cleanup;
         }
-        boxaAddBox(boxa, box, L_INSERT);
-
-            /* Save the c.c. and remove from pix2 as well */
-        pix3 = pixClipRectangle(pix1, box, NULL);
-        pix4 = pixClipRectangle(pix2, box, NULL);
-        pixXor(pix3, pix3, pix4);
-        pixRasterop(pix2, box->x, box->y, box->w, box->h, PIX_SRC ^ PIX_DST,
-                    pix3, 0, 0);
-        pixaAddPix(pixa, pix3, L_INSERT);
-        pixDestroy(&pix4);
-
-        xstart = x;
-        ystart = y;
+        pixCopyResolution(pix1, pixs);
+        pixCopyColormap(pix1, pixs);
+        pixaAddPix(pixa, pix1, L_INSERT);
+    }
+    for (i = 0; i < runs->n; i++) {
+        c = runs->parent[i];
+        pix1 = pixa->pix[c];
+        data = pixGetData(pix1);
+        wpl = pixGetWpl(pix1);
+        lineRangeSet(data + (runs->y[i] - bb[4 * c + 1]) * wpl,
+                     runs->xstart[i] - bb[4 * c],
+                     runs->xend[i] - bb[4 * c]);
     }
-
-#if  DEBUG
-    pixCountPixels(pix1, &iszero, NULL);
-    fprintf(stderr, "Number of remaining pixels = %d\n", iszero);
-    pixWrite("junkremain", pix1, IFF_PNG);
-#endif  /* DEBUG */
 
         /* Remove old boxa of pixa and replace with a copy */
     boxaDestroy(&pixa->boxa);
     pixa->boxa = boxaCopy(boxa, L_COPY);
     *ppixa = pixa;
 
-        /* Cleanup, freeing the fillsegs on each stack */
 cleanup:
-    lstackDestroy(&stack, TRUE);
-    pixDestroy(&pix1);
-    pixDestroy(&pix2);
+    LEPT_FREE(bb);
+    ccRunsDestroy(&runs);
     return boxa;
 }
 
@@ -294,21 +313,19 @@ cleanup:
  * Notes:
  *     (1) Finds bounding boxes of 4- or 8-connected components
  *         in a binary image.
- *     (2) This works on a copy of the input pix.  The c.c. are located
- *         in raster order and erased one at a time.  In the process,
- *         the b.b. is computed and saved.
+ *     (2) The c.c. are found by union-find labelling of the runs of
+ *         ON pixels, and their b.b. are saved in raster order of
+ *         the first pixel of each c.c.
  * </pre>
  */
 BOXA *
 pixConnCompBB(PIX     *pixs,
               l_int32  connectivity)
 {
-l_int32   h, iszero;
-l_int32   x, y, xstart, ystart;
-PIX      *pix1;
-BOX      *box;
+l_int32   iszero, ncomp, c;
+l_int32  *bb;
 BOXA     *boxa;
-L_STACK  *stack, *auxstack;
+CCRUNS   *runs;
 
     PROCNAME("pixConnCompBB");
 
@@ -317,52 +334,26 @@ L_STACK  *stack, *auxstack;
     if (connectivity != 4 && connectivity != 8)
         return (BOXA *)ERROR_PTR("connectivity not 4 or 8", procName, NULL);
 
-    boxa = NULL;
-    pix1 = NULL;
-    stack = NULL;
     pixZero(pixs, &iszero);
     if (iszero)
         return boxaCreate(1);  /* return empty boxa */
 
-    if ((pix1 = pixCopy(NULL, pixs)) == NULL)
-        return (BOXA *)ERROR_PTR("pix1 not made", procName, NULL);
-
-    h = pixGetHeight(pixs);
-    if ((stack = lstackCreate(h)) == NULL) {
-        L_ERROR("stack not made\n", procName);
-        goto cleanup;
-    }
-    auxstack = lstackCreate(0);
-    stack->auxstack = auxstack;
-    boxa = boxaCreate(0);
-
-    xstart = 0;
-    ystart = 0;
-    while (1) {
-        if (!nextOnPixelInRaster(pix1, xstart, ystart, &x, &y))
-            break;
-
-        if ((box = pixSeedfillBB(pix1, stack, x, y, connectivity)) == NULL) {
-            L_ERROR("box not made\n", procName);
-            boxaDestroy(&boxa);
-            goto cleanup;
-        }
-        boxaAddBox(boxa, box, L_INSERT);
-
-        xstart = x;
-        ystart = y;
+    if ((runs = ccRunsCreate(pixs, connectivity)) == NULL)
+        return (BOXA *)ERROR_PTR("runs not made", procName, NULL);
+    ncomp = ccRunsLabel(runs);
+    bb = ccRunsGetBoxes(runs, ncomp);
+    ccRunsDestroy(&runs);
+    if (!bb)
+        return (BOXA *)ERROR_PTR("bb not made", procName, NULL);
+
+    boxa = boxaCreate(ncomp);
+    for (c = 0; c < ncomp; c++) {
+        boxaAddBox(boxa, boxCreate(bb[4 * c], bb[4 * c + 1],
+                                   bb[4 * c + 2] - bb[4 * c] + 1,
+                                   bb[4 * c + 3] - bb[4 * c + 1] + 1),
+                   L_INSERT);
     }
-
-#if  DEBUG
-    pixCountPixels(pix1, &iszero, NULL);
-    fprintf(stderr, "Number of remaining pixels = %d\n", iszero);
-    pixWrite("junkremain", pix1, IFF_PNG);
-#endif  /* DEBUG */
-
-        /* Cleanup, freeing the fillsegs on each stack */
-cleanup:
-    lstackDestroy(&stack, TRUE);
-    pixDestroy(&pix1);
+    LEPT_FREE(bb);
     return boxa;
 }
 
@@ -378,18 +369,16 @@ cleanup:
  * Notes:
  *     (1 This is the top-level call for getting the number of
  *         4- or 8-connected components in a 1 bpp image.
- *     2 It works on a copy of the input pix.  The c.c. are located
- *         in raster order and erased one at a time.
+ *     2 It counts the trees of the union-find forest over the runs
+ *         of ON pixels.
  */
 l_int32
 pixCountConnComp(PIX      *pixs,
                  l_int32   connectivity,
                  l_int32  *pcount)
 {
-l_int32   h, iszero;
-l_int32   x, y, xstart, ystart;
-PIX      *pix1;
-L_STACK  *stack, *auxstack;
+l_int32  iszero;
+CCRUNS  *runs;
 
     PROCNAME("pixCountConnComp");
 
@@ -401,36 +390,14 @@ L_STACK  *stack, *auxstack;
     if (connectivity != 4 && connectivity != 8)
         return ERROR_INT("connectivity not 4 or 8", procName, 1);
 
-    stack = NULL;
     pixZero(pixs, &iszero);
     if (iszero)
         return 0;
 
-    if ((pix1 = pixCopy(NULL, pixs)) == NULL)
-        return ERROR_INT("pix1 not made", procName, 1);
-    h = pixGetHeight(pixs);
-    if ((stack = lstackCreate(h)) == NULL) {
-        pixDestroy(&pix1);
-        return ERROR_INT("stack not made\n", procName, 1);
-    }
-    auxstack = lstackCreate(0);
-    stack->auxstack = auxstack;
-
-    xstart = 0;
-    ystart = 0;
-    while (1) {
-        if (!nextOnPixelInRaster(pix1, xstart, ystart, &x, &y))
-            break;
-
-        pixSeedfill(pix1, stack, x, y, connectivity);
-        (*pcount)++;
-        xstart = x;
-        ystart = y;
-    }
-
-        /* Cleanup, freeing the fillsegs on each stack */
-    lstackDestroy(&stack, TRUE);
-    pixDestroy(&pix1);
+    if ((runs = ccRunsCreate(pixs, connectivity)) == NULL)
+        return ERROR_INT("runs not made", procName, 1);
+    *pcount = ccRunsLabel(runs);
+    ccRunsDestroy(&runs);
     return 0;
 }
 
@@ -1244,3 +1211,349 @@ L_STACK  *auxstack;
     lstackAdd(auxstack, fseg);
     return;
 }
+
+
+/*-----------------------------------------------------------------------*
+ *            Static helpers for union-find labelling of runs            *
+ *-----------------------------------------------------------------------*/
+/*!
+ * \brief   ccRunsCreate()
+ *
+ * \param[in]    pixs 1 bpp
+ * \param[in]    connectivity 4 or 8
+ * \return  runs, or NULL on error
+ *
+ * <pre>
+ * Notes:
+ *      (1) This encodes each line of pixs as its runs of ON pixels,
+ *          and joins each run to the runs on the line above that are
+ *          4- or 8-connected to it.  Only the pixels within the width
+ *          of pixs are used; the pad bits are ignored.
+ *      (2) The runs on two lines are both in increasing order of x,
+ *          so they are merged in a single pass over the two lines,
+ *          always stepping past the run that ends first.
+ * </pre>
+ */
+static CCRUNS *
+ccRunsCreate(PIX     *pixs,
+             l_int32  connectivity)
+{
+l_int32    w, h, wpl, i, j, k, d, ri, rk;
+l_int32    prevstart, prevend, start;
+l_uint32  *data;
+CCRUNS    *runs;
+
+    PROCNAME("ccRunsCreate");
+
+    if ((runs = (CCRUNS *)LEPT_CALLOC(1, sizeof(CCRUNS))) == NULL)
+        return (CCRUNS *)ERROR_PTR("runs not made", procName, NULL);
+
+    pixGetDimensions(pixs, &w, &h, NULL);
+    data = pixGetData(pixs);
+    wpl = pixGetWpl(pixs);
+    d = (connectivity == 8) ? 1 : 0;  /* corners also touch */
+    prevstart = prevend = 0;
+    for (i = 0; i < h; i++) {
+        start = runs->n;
+        if (ccRunsAddLine(runs, data + i * wpl, w, i)) {
+            ccRunsDestroy(&runs);
+            return (CCRUNS *)ERROR_PTR("runs not added", procName, NULL);
+        }
+
+            /* Join to the touching runs on the line above; the root
+             * of each tree is always its earliest run */
+        j = prevstart;
+        k = start;
+        while (j < prevend && k < runs->n) {
+            if (runs->xstart[j] <= runs->xend[k] + d &&
+                runs->xend[j] + d >= runs->xstart[k]) {
+                ri = ccRunsFind(runs, j);
+                rk = ccRunsFind(runs, k);
+                if (ri < rk)
+                    runs->parent[rk] = ri;
+                else if (rk < ri)
+                    runs->parent[ri] = rk;
+            }
+            if (runs->xend[j] < runs->xend[k])
+                j++;
+            else
+                k++;
+        }
+        prevstart = start;
+        prevend = runs->n;
+    }
+
+    return runs;
+}
+
+
+/*!
+ * \brief   ccRunsDestroy()
+ *
+ * \param[in,out]   pruns will be set to null before returning
+ * \return  void
+ */
+static void
+ccRunsDestroy(CCRUNS  **pruns)
+{
+CCRUNS  *runs;
+
+    if (!pruns || (runs = *pruns) == NULL)
+        return;
+    LEPT_FREE(runs->y);
+    LEPT_FREE(runs->xstart);
+    LEPT_FREE(runs->xend);
+    LEPT_FREE(runs->parent);
+    LEPT_FREE(runs);
+    *pruns = NULL;
+}
+
+
+/*!
+ * \brief   ccRunsAddLine()
+ *
+ * \param[in]    runs
+ * \param[in]    line  of 1 bpp image data
+ * \param[in]    w     width in pixels
+ * \param[in]    y     line number
+ * \return  0 if OK, 1 on error
+ *
+ * <pre>
+ * Notes:
+ *      (1) Words that are all OFF outside a run, or all ON inside one,
+ *          are skipped whole.  Otherwise each edge of a run is found by
+ *          counting the leading zeros of the word, shifted past the
+ *          previous edge and inverted inside a run.
+ *      (2) Each new run is the root of its own tree.
+ * </pre>
+ */
+static l_int32
+ccRunsAddLine(CCRUNS    *runs,
+              l_uint32  *line,
+              l_int32    w,
+              l_int32    y)
+{
+l_int32   j, nwords, bit, inrun, xstart;
+l_uint32  word, rest;
+
+    PROCNAME("ccRunsAddLine");
+
+    nwords = (w + 31) / 32;
+    inrun = FALSE;
+    xstart = 0;
+    for (j = 0; j < nwords; j++) {
+        word = line[j];
+        if (j == nwords - 1 && (w & 31))
+            word &= 0xffffffff << (32 - (w & 31));
+        if ((!inrun && word == 0) || (inrun && word == 0xffffffff))
+            continue;
+
+        bit = 0;
+        while (bit < 32) {
+            rest = (inrun) ? ~word << bit : word << bit;
+            if (!rest)
+                break;
+            bit += LEADING_ZEROS(rest);
+            if (inrun) {
+                if (ccRunsAdd(runs, y, xstart, 32 * j + bit - 1))
+                    return ERROR_INT("run not added", procName, 1);
+            } else {
+                xstart = 32 * j + bit;
+            }
+            inrun = !inrun;
+        }
+    }
+    if (inrun && ccRunsAdd(runs, y, xstart, w - 1))
+        return ERROR_INT("run not added", procName, 1);
+    return 0;
+}
+
+
+/*!
+ * \brief   ccRunsAdd()
+ *
+ * \param[in]    runs
+ * \param[in]    y              line number
+ * \param[in]    xstart, xend   first and last pixel of the run
+ * \return  0 if OK, 1 on error
+ */
+static l_int32
+ccRunsAdd(CCRUNS  *runs,
+          l_int32  y,
+          l_int32  xstart,
+          l_int32  xend)
+{
+l_int32  n, nalloc, oldsize, newsize;
+
+    PROCNAME("ccRunsAdd");
+
+    n = runs->n;
+    if (n >= runs->nalloc) {
+        nalloc = L_MAX(2 * runs->nalloc, 1024);
+        oldsize = sizeof(l_int32) * runs->nalloc;
+        newsize = sizeof(l_int32) * nalloc;
+        if ((runs->y = (l_int32 *)reallocNew((void **)&runs->y,
+                                             oldsize, newsize)) == NULL ||
+            (runs->xstart = (l_int32 *)reallocNew((void **)&runs->xstart,
+                                                  oldsize, newsize)) == NULL ||
+            (runs->xend = (l_int32 *)reallocNew((void **)&runs->xend,
+                                                oldsize, newsize)) == NULL ||
+            (runs->parent = (l_int32 *)reallocNew((void **)&runs->parent,
+                                                  oldsize, newsize)) == NULL)
+            return ERROR_INT("runs not extended", procName, 1);
+        runs->nalloc = nalloc;
+    }
+    runs->y[n] = y;
+    runs->xstart[n] = xstart;
+    runs->xend[n] = xend;
+    runs->parent[n] = n;
+    runs->n++;
+    return 0;
+}
+
+
+/*!
+ * \brief   ccRunsFind()
+ *
+ * \param[in]    runs
+ * \param[in]    i     index of a run
+ * \return  index of the root of the tree that holds run i
+ *
+ * <pre>
+ * Notes:
+ *      (1) This halves the path from i to the root as it goes.
+ * </pre>
+ */
+static l_int32
+ccRunsFind(CCRUNS  *runs,
+           l_int32  i)
+{
+l_int32  *parent;
+
+    parent = runs->parent;
+    while (parent[i] != i) {
+        parent[i] = parent[parent[i]];
+        i = parent[i];
+    }
+    return i;
+}
+
+
+/*!
+ * \brief   ccRunsLabel()
+ *
+ * \param[in]    runs
+ * \return  number of c.c.
+ *
+ * <pre>
+ * Notes:
+ *      (1) This replaces the parent of each run by the index of its c.c.,
+ *          numbering the c.c. in the order of their roots, which is the
+ *          raster order of the first pixel of each c.c.
+ *      (2) A parent always comes before its child, so the runs can be
+ *          relabelled in order: the parent of a non-root run has already
+ *          been given the index of its c.c.
+ * </pre>
+ */
+static l_int32
+ccRunsLabel(CCRUNS  *runs)
+{
+l_int32   i, ncomp;
+l_int32  *parent;
+
+    parent = runs->parent;
+    ncomp = 0;
+    for (i = 0; i < runs->n; i++) {
+        if (parent[i] == i)
+            parent[i] = ncomp++;
+        else
+            parent[i] = parent[parent[i]];
+    }
+    return ncomp;
+}
+
+
+/*!
+ * \brief   ccRunsGetBoxes()
+ *
+ * \param[in]    runs   after ccRunsLabel()
+ * \param[in]    ncomp  number of c.c.
+ * \return  array of {xmin, ymin, xmax, ymax} for each c.c., or NULL on error
+ */
+static l_int32 *
+ccRunsGetBoxes(CCRUNS  *runs,
+               l_int32  ncomp)
+{
+l_int32   i, c;
+l_int32  *bb;
+
+    PROCNAME("ccRunsGetBoxes");
+
+    if ((bb = (l_int32 *)LEPT_CALLOC(4 * ncomp + 1, sizeof(l_int32))) == NULL)
+        return (l_int32 *)ERROR_PTR("bb not made", procName, NULL);
+    for (c = 0; c < ncomp; c++) {
+        bb[4 * c] = bb[4 * c + 1] = 1 << 30;
+        bb[4 * c + 2] = bb[4 * c + 3] = -1;
+    }
+    for (i = 0; i < runs->n; i++) {
+        c = 4 * runs->parent[i];
+        bb[c] = L_MIN(bb[c], runs->xstart[i]);
+        bb[c + 1] = L_MIN(bb[c + 1], runs->y[i]);
+        bb[c + 2] = L_MAX(bb[c + 2], runs->xend[i]);
+        bb[c + 3] = L_MAX(bb[c + 3], runs->y[i]);
+    }
+    return bb;
+}
+
+
+/*!
+ * \brief   lineRangeSet()
+ *
+ * \param[in]    line  of 1 bpp image data
+ * \param[in]    xstart, xend  first and last pixel of the range
+ * \return  void
+ */
+static void
+lineRangeSet(l_uint32  *line,
+             l_int32    xstart,
+             l_int32    xend)
+{
+l_int32   j, jstart, jend;
+l_uint32  lmask, rmask;
+
+    jstart = xstart >> 5;
+    jend = xend >> 5;
+    lmask = 0xffffffff >> (xstart & 31);
+    rmask = 0xffffffff << (31 - (xend & 31));
+    if (jstart == jend) {
+        line[jstart] |= lmask & rmask;
+        return;
+    }
+    line[jstart] |= lmask;
+    for (j = jstart + 1; j < jend; j++)
+        line[j] = 0xffffffff;
+    line[jend] |= rmask;
+}
+
+
+#if !defined(__GNUC__)
+/*!
+ * \brief   leadingZeros()
+ *
+ * \param[in]    word  not 0
+ * \return  number of 0 bits above the highest 1 bit
+ */
+static l_int32
+leadingZeros(l_uint32  word)
+{
+l_int32  n;
+
+    n = 0;
+    if (!(word & 0xffff0000)) { n += 16; word <<= 16; }
+    if (!(word & 0xff000000)) { n += 8; word <<= 8; }
+    if (!(word & 0xf0000000)) { n += 4; word <<= 4; }
+    if (!(word & 0xc0000000)) { n += 2; word <<= 2; }
+    if (!(word & 0x80000000)) n += 1;
+    return n;
+}
+#endif  /* !__GNUC__ */
@@ -53,6 +53,13 @@
  *           PIX     *pixUnsharpMaskingGrayFast()
  *           PIX     *pixUnsharpMaskingGray1D()
  *           PIX     *pixUnsharpMaskingGray2D()
+ *           PIX     *pixUnsharpMaskingGeneral()
+ *           static l_int32  unsharpMaskingLow()
+ *           static void     unsharpGetLine()
+ *           static void     unsharpSetLine()
+ *           static void     unsharpLine3()
+ *           static void     unsharpLine5()
+ *           static void     unsharpLineBox()
  *
  *      Hue and saturation modification
  *           PIX     *pixModifyHue()
@@ -105,8 +112,8 @@
  *      It's not the fastest way to do this, but the method is
  *      easily understood.
  *
- *      Unsharp masking is never in-place, and returns a clone if no
- *      operation is to be performed.
+ *      Unsharp masking returns a clone if no operation is to be
+ *      performed.  It can be done in-place with pixUnsharpMaskingGeneral().
  * </pre>
  */
 
@@ -114,6 +121,33 @@
 #include <math.h>
 #include "allheaders.h"
 
+    /* Vector unsharp masking of lines, on little-endian hosts.
+     * The NEON code divides, which only A64 has in vector form. */
+#ifndef L_BIG_ENDIAN
+#if defined(__SSE2__)
+#define  ENHANCE_SSE2   1
+#include <emmintrin.h>
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#define  ENHANCE_NEON   1
+#include <arm_neon.h>
+#endif
+#endif  /* ~L_BIG_ENDIAN */
+
+static l_int32 unsharpMaskingLow(PIX *pixd, PIX *pixs, l_int32 halfwidth,
+                                 l_float32 fract);
+static void unsharpGetLine(l_uint8 **bufs, l_uint32 *line, l_int32 w,
+                           l_int32 d);
+static void unsharpSetLine(l_uint32 *lined, l_uint8 **bufs, l_uint32 *lines,
+                           l_int32 w, l_int32 d, l_int32 spp);
+static void unsharpLine3(l_uint8 *bufd, l_uint8 *buf0, l_uint8 *buf1,
+                         l_uint8 *buf2, l_int32 w, l_float32 fract);
+static void unsharpLine5(l_uint8 *bufd, l_uint8 **bufs, l_int32 w,
+                         l_float32 fract, l_uint16 *colsum);
+static void unsharpLineBox(l_uint8 *bufd, l_uint8 *bufs, l_uint32 *colsum,
+                           l_uint32 *rowsum, l_int32 w, l_int32 wc,
+                           l_int32 edgerow, l_float32 normh, l_float32 norm,
+                           l_float32 fract);
+
     /* Scales contrast enhancement factor to have a useful range
      * between 0.0 and 1.0 */
 static const l_float32  ENHANCE_SCALE_FACTOR = 5.;
@@ -901,49 +935,11 @@ pixUnsharpMasking(PIX       *pixs,
                   l_int32    halfwidth,
                   l_float32  fract)
 {
-l_int32  d;
-PIX     *pixt, *pixd, *pixr, *pixrs, *pixg, *pixgs, *pixb, *pixbs;
-
     PROCNAME("pixUnsharpMasking");
 
     if (!pixs || (pixGetDepth(pixs) == 1))
         return (PIX *)ERROR_PTR("pixs not defined or 1 bpp", procName, NULL);
-    if (fract <= 0.0 || halfwidth <= 0) {
-        L_WARNING("no sharpening requested; clone returned\n", procName);
-        return pixClone(pixs);
-    }
-
-    if (halfwidth == 1 || halfwidth == 2)
-        return pixUnsharpMaskingFast(pixs, halfwidth, fract, L_BOTH_DIRECTIONS);
-
-        /* Remove colormap; clone if possible; result is either 8 or 32 bpp */
-    if ((pixt = pixConvertTo8Or32(pixs, L_CLONE, 0)) == NULL)
-        return (PIX *)ERROR_PTR("pixt not made", procName, NULL);
-
-        /* Sharpen */
-    d = pixGetDepth(pixt);
-    if (d == 8) {
-        pixd = pixUnsharpMaskingGray(pixt, halfwidth, fract);
-    } else {  /* d == 32 */
-        pixr = pixGetRGBComponent(pixs, COLOR_RED);
-        pixrs = pixUnsharpMaskingGray(pixr, halfwidth, fract);
-        pixDestroy(&pixr);
-        pixg = pixGetRGBComponent(pixs, COLOR_GREEN);
-        pixgs = pixUnsharpMaskingGray(pixg, halfwidth, fract);
-        pixDestroy(&pixg);
-        pixb = pixGetRGBComponent(pixs, COLOR_BLUE);
-        pixbs = pixUnsharpMaskingGray(pixb, halfwidth, fract);
-        pixDestroy(&pixb);
-        pixd = pixCreateRGBImage(pixrs, pixgs, pixbs);
-        pixDestroy(&pixrs);
-        pixDestroy(&pixgs);
-        pixDestroy(&pixbs);
-        if (pixGetSpp(pixs) == 4)
-            pixScaleAndTransferAlpha(pixd, pixs, 1.0, 1.0);
-    }
-
-    pixDestroy(&pixt);
-    return pixd;
+    return pixUnsharpMaskingGeneral(NULL, pixs, halfwidth, fract);
 }
 
 
@@ -963,6 +959,9 @@ PIX     *pixt, *pixd, *pixr, *pixrs, *pixg, *pixgs, *pixb, *pixbs;
  *      (2) The fract parameter is typically taken in the range:
  *          0.2 < fract < 0.7
  *      (3) Returns a clone if no sharpening is requested.
+ *      (4) This is pixs plus %fract times the difference between pixs
+ *          and pixBlockconvGray() of pixs, computed in one pass by
+ *          pixUnsharpMaskingGeneral().
  * </pre>
  */
 PIX *
@@ -971,8 +970,6 @@ pixUnsharpMaskingGray(PIX       *pixs,
                       l_float32  fract)
 {
 l_int32  w, h, d;
-PIX     *pixc, *pixd;
-PIXACC  *pixacc;
 
     PROCNAME("pixUnsharpMaskingGray");
 
@@ -985,42 +982,7 @@ PIXACC  *pixacc;
         L_WARNING("no sharpening requested; clone returned\n", procName);
         return pixClone(pixs);
     }
-    if (halfwidth == 1 || halfwidth == 2)
-        return pixUnsharpMaskingGrayFast(pixs, halfwidth, fract,
-                                         L_BOTH_DIRECTIONS);
-
-    if ((pixc = pixBlockconvGray(pixs, NULL, halfwidth, halfwidth)) == NULL)
-        return (PIX *)ERROR_PTR("pixc not made", procName, NULL);
-
-        /* Steps:
-         *    (1) edge image is pixs - pixc  (this is highpass part)
-         *    (2) multiply edge image by fract
-         *    (3) add fraction of edge to pixs
-         *
-         * To show how this is done with both interfaces to arithmetic
-         * on integer Pix, here is the implementation in the lower-level
-         * function calls:
-         *    pixt = pixInitAccumulate(w, h, 0x10000000)) == NULL)
-         *    pixAccumulate(pixt, pixs, L_ARITH_ADD);
-         *    pixAccumulate(pixt, pixc, L_ARITH_SUBTRACT);
-         *    pixMultConstAccumulate(pixt, fract, 0x10000000);
-         *    pixAccumulate(pixt, pixs, L_ARITH_ADD);
-         *    pixd = pixFinalAccumulate(pixt, 0x10000000, 8)) == NULL)
-         *    pixDestroy(&pixt);
-         *
-         * The code below does the same thing using the Pixacc accumulator,
-         * hiding the details of the offset that is needed for subtraction.
-         */
-    pixacc = pixaccCreate(w, h, 1);
-    pixaccAdd(pixacc, pixs);
-    pixaccSubtract(pixacc, pixc);
-    pixaccMultConst(pixacc, fract);
-    pixaccAdd(pixacc, pixs);
-    pixd = pixaccFinal(pixacc, 8);
-    pixaccDestroy(&pixacc);
-
-    pixDestroy(&pixc);
-    return pixd;
+    return pixUnsharpMaskingGeneral(NULL, pixs, halfwidth, fract);
 }
 
 
@@ -1085,6 +1047,9 @@ PIX     *pixt, *pixd, *pixr, *pixrs, *pixg, *pixgs, *pixb, *pixbs;
         direction != L_BOTH_DIRECTIONS)
         return (PIX *)ERROR_PTR("invalid direction", procName, NULL);
 
+    if (direction == L_BOTH_DIRECTIONS)
+        return pixUnsharpMaskingGeneral(NULL, pixs, halfwidth, fract);
+
         /* Remove colormap; clone if possible; result is either 8 or 32 bpp */
     if ((pixt = pixConvertTo8Or32(pixs, L_CLONE, 0)) == NULL)
         return (PIX *)ERROR_PTR("pixt not made", procName, NULL);
@@ -1314,6 +1279,7 @@ PIX       *pixd;
  *      (1) For halfwidth == 1, we implement the full sharpening filter
  *          directly.  For halfwidth == 2, we implement the the lowpass
  *          filter separably and then compute the sharpening result locally.
+ *          Both are done a line at a time by pixUnsharpMaskingGeneral().
  *      (2) Returns a clone if no sharpening is requested.
  * </pre>
  */
@@ -1322,12 +1288,7 @@ pixUnsharpMaskingGray2D(PIX       *pixs,
                         l_int32    halfwidth,
                         l_float32  fract)
 {
-l_int32     w, h, d, wpls, wpld, wplf, i, j, ival, sval;
-l_uint32   *datas, *datad, *lines, *lines0, *lines1, *lines2, *lined;
-l_float32   val, a[9];
-l_float32  *dataf, *linef, *linef0, *linef1, *linef2, *linef3, *linef4;
-PIX        *pixd;
-FPIX       *fpix;
+l_int32  w, h, d;
 
     PROCNAME("pixUnsharpMaskingGray2D");
 
@@ -1343,91 +1304,728 @@ FPIX       *fpix;
     if (halfwidth != 1 && halfwidth != 2)
         return (PIX *)ERROR_PTR("halfwidth must be 1 or 2", procName, NULL);
 
-    pixd = pixCopyBorder(NULL, pixs, halfwidth, halfwidth,
-                         halfwidth, halfwidth);
-    datad = pixGetData(pixd);
-    wpld = pixGetWpl(pixd);
+    return pixUnsharpMaskingGeneral(NULL, pixs, halfwidth, fract);
+}
+
+
+/*!
+ * \brief   pixUnsharpMaskingGeneral()
+ *
+ * \param[in]    pixd [optional] can be null or equal to pixs
+ * \param[in]    pixs all depths except 1 bpp; with or without colormaps
+ * \param[in]    halfwidth  "half-width" of smoothing filter
+ * \param[in]    fract  fraction of edge added back into image
+ * \return  pixd, or NULL on error
+ *
+ * <pre>
+ * Notes:
+ *      (1) pixd must either be null or equal to pixs.
+ *          For in-place operation, set pixd == pixs:
+ *             pixUnsharpMaskingGeneral(pixs, pixs, ...);
+ *          To get a new image, set pixd == null:
+ *             pixd = pixUnsharpMaskingGeneral(NULL, pixs, ...);
+ *          In-place operation requires pixs to be 8 or 32 bpp without
+ *          a colormap.
+ *      (2) The result is that of pixUnsharpMaskingGray2D() for
+ *          %halfwidth 1 and 2, and of pixUnsharpMaskingGray() for larger
+ *          %halfwidth, on each component of an rgb image.
+ *      (3) This is done in one pass.  The source lines are copied, a
+ *          component at a time and in pixel order, into a ring of line
+ *          buffers, and each dest line is smoothed, subtracted and added
+ *          back from those buffers, with SSE2 or NEON where available.
+ *          The smoothing is separable: column sums of the lines are
+ *          summed along the line.  No image-sized temporaries are made,
+ *          and a dest line is written only after all the source lines
+ *          it depends on have been copied, so pixd can be pixs.
+ *      (4) Returns a clone if no sharpening is requested; or pixd,
+ *          unchanged, for in-place operation.
+ * </pre>
+ */
+PIX *
+pixUnsharpMaskingGeneral(PIX       *pixd,
+                         PIX       *pixs,
+                         l_int32    halfwidth,
+                         l_float32  fract)
+{
+l_int32  d;
+PIX     *pixt;
+
+    PROCNAME("pixUnsharpMaskingGeneral");
+
+    if (!pixs || (pixGetDepth(pixs) == 1))
+        return (PIX *)ERROR_PTR("pixs not defined or 1 bpp", procName, pixd);
+    if (pixd && pixd != pixs)
+        return (PIX *)ERROR_PTR("pixd not null or == pixs", procName, pixd);
+    if (fract <= 0.0 || halfwidth <= 0) {
+        L_WARNING("no sharpening requested; clone returned\n", procName);
+        return (pixd) ? pixd : pixClone(pixs);
+    }
+
+    d = pixGetDepth(pixs);
+    if (pixGetColormap(pixs) || (d != 8 && d != 32)) {
+        if (pixd)
+            return (PIX *)ERROR_PTR("in-place needs 8 or 32 bpp; no cmap",
+                                    procName, pixd);
+            /* Remove colormap; result is either 8 or 32 bpp.  Any alpha
+             * in the colormap is not carried over. */
+        if ((pixt = pixConvertTo8Or32(pixs, L_CLONE, 0)) == NULL)
+            return (PIX *)ERROR_PTR("pixt not made", procName, NULL);
+        if (pixGetDepth(pixt) == 32)
+            pixSetSpp(pixt, 3);
+        if (unsharpMaskingLow(pixt, pixt, halfwidth, fract)) {
+            pixDestroy(&pixt);
+            return (PIX *)ERROR_PTR("pixt not sharpened", procName, NULL);
+        }
+        return pixt;
+    }
+
+    if (pixd) {
+        pixt = pixd;
+    } else {
+        if ((pixt = pixCreateTemplateNoInit(pixs)) == NULL)
+            return (PIX *)ERROR_PTR("pixd not made", procName, NULL);
+    }
+    if (unsharpMaskingLow(pixt, pixs, halfwidth, fract)) {
+        if (!pixd)
+            pixDestroy(&pixt);
+        return (PIX *)ERROR_PTR("pixd not sharpened", procName, pixd);
+    }
+    return pixt;
+}
+
+
+/*!
+ * \brief   unsharpMaskingLow()
+ *
+ * \param[in]    pixd 8 or 32 bpp; same size and depth as pixs; can be pixs
+ * \param[in]    pixs 8 or 32 bpp; no colormap
+ * \param[in]    halfwidth  "half-width" of smoothing filter; > 0
+ * \param[in]    fract  fraction of edge added back into image
+ * \return  0 if OK, 1 on error
+ *
+ * <pre>
+ * Notes:
+ *      (1) Every pixel of pixd is written.  For 32 bpp, the alpha
+ *          component is copied from pixs if it has 4 spp, and is
+ *          otherwise set to 0.
+ *      (2) For %halfwidth 1 and 2, the pixels within %halfwidth of the
+ *          image boundary are copied from pixs.
+ *      (3) For larger %halfwidth, the smoothed value is exactly what
+ *          pixBlockconvGray() gives.  That is, for line i, the column
+ *          sums are over lines max(i - hc, 1) to min(i + hc, h - 1), the
+ *          line sums are over the same range of columns, and the pixels
+ *          within hc lines or wc columns of the boundary are
+ *          renormalized.  The sharpened value is then exactly what the
+ *          Pixacc arithmetic in pixUnsharpMaskingGray() used to give.
+ *      (4) The ring holds the 2 * hc + 2 most recent source lines, which
+ *          are the lines that the column sums need to add and subtract.
+ * </pre>
+ */
+static l_int32
+unsharpMaskingLow(PIX       *pixd,
+                  PIX       *pixs,
+                  l_int32    halfwidth,
+                  l_float32  fract)
+{
+l_int32    w, h, d, spp, wpls, wpld, nch, ch, wc, hc, fhc, box;
+l_int32    nslots, bw, i, j, k, row, nrows, edgerow, hn;
+l_uint8   *ringdata, *outdata, *zeroline, *bufs[3], *bufd[3], *buf5[5];
+l_uint8   *src;
+l_uint16  *colsum16;
+l_uint32  *datas, *datad, *colsum, *rowsum;
+l_float32  norm, normh;
+
+    PROCNAME("unsharpMaskingLow");
+
+    pixGetDimensions(pixs, &w, &h, &d);
+    spp = pixGetSpp(pixs);
+    nch = (d == 8) ? 1 : 3;
+    if (halfwidth <= 2) {
+        box = FALSE;
+        wc = hc = halfwidth;
+    } else {  /* reduce the kernel as pixBlockconvGray() does */
+        box = TRUE;
+        wc = hc = halfwidth;
+        if (w < 2 * wc + 1 || h < 2 * hc + 1) {
+            wc = L_MIN(wc, (w - 1) / 2);
+            hc = L_MIN(hc, (h - 1) / 2);
+            L_WARNING("kernel too large; reducing!\n", procName);
+            L_INFO("wc = %d, hc = %d\n", procName, wc, hc);
+        }
+    }
+    fhc = 2 * hc + 1;
+    norm = 1. / ((2 * wc + 1) * fhc);
+
+        /* Lines have room for the vector code to read past the end */
+    nslots = 2 * hc + 2;
+    bw = w + 32;
+    ringdata = (l_uint8 *)LEPT_CALLOC((size_t)nslots * nch * bw,
+                                      sizeof(l_uint8));
+    outdata = (l_uint8 *)LEPT_CALLOC((size_t)nch * bw, sizeof(l_uint8));
+    zeroline = (l_uint8 *)LEPT_CALLOC(bw, sizeof(l_uint8));
+    colsum16 = (l_uint16 *)LEPT_CALLOC(bw, sizeof(l_uint16));
+    colsum = (l_uint32 *)LEPT_CALLOC((size_t)nch * w, sizeof(l_uint32));
+    rowsum = (l_uint32 *)LEPT_CALLOC(bw, sizeof(l_uint32));
+    if (!ringdata || !outdata || !zeroline || !colsum16 || !colsum ||
+        !rowsum) {
+        LEPT_FREE(ringdata);
+        LEPT_FREE(outdata);
+        LEPT_FREE(zeroline);
+        LEPT_FREE(colsum16);
+        LEPT_FREE(colsum);
+        LEPT_FREE(rowsum);
+        return ERROR_INT("buffers not made", procName, 1);
+    }
+
+#define  RINGLINE(r, c)  (ringdata + ((size_t)((r) % nslots) * nch + (c)) * bw)
+
     datas = pixGetData(pixs);
     wpls = pixGetWpl(pixs);
+    datad = pixGetData(pixd);
+    wpld = pixGetWpl(pixd);
+    for (ch = 0; ch < nch; ch++)
+        bufd[ch] = outdata + ch * bw;
+    nrows = 0;  /* number of source lines copied to the ring */
+    for (i = 0; i < h; i++) {
+            /* Copy the source lines up to i + hc, which is before pixd
+             * line i is written.  For box smoothing, the column sums
+             * are over lines max(i - hc, 1) to min(i + hc, h - 1). */
+        for (; nrows <= L_MIN(i + hc, h - 1); nrows++) {
+            for (ch = 0; ch < nch; ch++)
+                bufs[ch] = RINGLINE(nrows, ch);
+            unsharpGetLine(bufs, datas + nrows * wpls, w, d);
+            if (box && nrows > 0) {
+                for (ch = 0; ch < nch; ch++) {
+                    for (j = 0; j < w; j++)
+                        colsum[ch * w + j] += bufs[ch][j];
+                }
+            }
+        }
+        if (box && (row = i - hc - 1) >= 1) {
+            for (ch = 0; ch < nch; ch++) {
+                src = RINGLINE(row, ch);
+                for (j = 0; j < w; j++)
+                    colsum[ch * w + j] -= src[j];
+            }
+        }
 
-    if (halfwidth == 1) {
-        for (i = 0; i < 9; i++)
-            a[i] = -fract / 9.0;
-        a[4] = 1.0 + fract * 8.0 / 9.0;
-        for (i = 1; i < h - 1; i++) {
-            lines0 = datas + (i - 1) * wpls;
-            lines1 = datas + i * wpls;
-            lines2 = datas + (i + 1) * wpls;
-            lined = datad + i * wpld;
-            for (j = 1; j < w - 1; j++) {
-                val = a[0] * GET_DATA_BYTE(lines0, j - 1) +
-                      a[1] * GET_DATA_BYTE(lines0, j) +
-                      a[2] * GET_DATA_BYTE(lines0, j + 1) +
-                      a[3] * GET_DATA_BYTE(lines1, j - 1) +
-                      a[4] * GET_DATA_BYTE(lines1, j) +
-                      a[5] * GET_DATA_BYTE(lines1, j + 1) +
-                      a[6] * GET_DATA_BYTE(lines2, j - 1) +
-                      a[7] * GET_DATA_BYTE(lines2, j) +
-                      a[8] * GET_DATA_BYTE(lines2, j + 1);
-                ival = (l_int32)(val + 0.5);
-                ival = L_MAX(0, ival);
-                ival = L_MIN(255, ival);
-                SET_DATA_BYTE(lined, j, ival);
+        for (ch = 0; ch < nch; ch++) {
+            src = RINGLINE(i, ch);
+            bufs[ch] = bufd[ch];
+            if (!box) {
+                if (i < hc || i >= h - hc || w < 2 * wc + 1) {
+                    bufs[ch] = src;  /* boundary line; copy */
+                    continue;
+                }
+                if (hc == 1) {
+                    unsharpLine3(bufd[ch], RINGLINE(i - 1, ch), src,
+                                 RINGLINE(i + 1, ch), w, fract);
+                } else {  /* hc == 2 */
+                        /* The lines within 2 of the image boundary
+                         * add 0 to the sums, as they always have */
+                    for (k = 0; k < 5; k++) {
+                        row = i - 2 + k;
+                        buf5[k] = (row < 2 || row >= h - 2) ?
+                                  zeroline : RINGLINE(row, ch);
+                    }
+                    buf5[2] = src;
+                    unsharpLine5(bufd[ch], buf5, w, fract, colsum16);
+                }
+                for (j = 0; j < wc; j++) {
+                    bufd[ch][j] = src[j];
+                    bufd[ch][w - 1 - j] = src[w - 1 - j];
+                }
+            } else if (wc == 0 && hc == 0) {
+                bufs[ch] = src;  /* no smoothing, so no change */
+            } else {
+                edgerow = TRUE;
+                if (i <= hc)
+                    hn = hc + i;
+                else if (i >= h - hc)
+                    hn = hc + h - i;
+                else
+                    edgerow = FALSE;
+                normh = (edgerow) ? (l_float32)fhc / (l_float32)hn : 1.0;
+                unsharpLineBox(bufd[ch], src, colsum + ch * w, rowsum, w, wc,
+                               edgerow, normh, norm, fract);
             }
         }
+        unsharpSetLine(datad + i * wpld, bufs, datas + i * wpls, w, d, spp);
+    }
 
-        return pixd;
+#undef  RINGLINE
+
+    LEPT_FREE(ringdata);
+    LEPT_FREE(outdata);
+    LEPT_FREE(zeroline);
+    LEPT_FREE(colsum16);
+    LEPT_FREE(colsum);
+    LEPT_FREE(rowsum);
+    return 0;
+}
+
+
+/*!
+ * \brief   unsharpGetLine()
+ *
+ * \param[in]    bufs    1 buffer for 8 bpp; 3 (r, g, b) for 32 bpp
+ * \param[in]    line    src line
+ * \param[in]    w       width in pixels
+ * \param[in]    d       8 or 32
+ * \return  void
+ */
+static void
+unsharpGetLine(l_uint8  **bufs,
+               l_uint32  *line,
+               l_int32    w,
+               l_int32    d)
+{
+l_int32   j;
+l_uint32  word;
+
+    if (d == 8) {
+        for (j = 0; j + 3 < w; j += 4) {
+            word = line[j >> 2];
+            bufs[0][j] = word >> 24;
+            bufs[0][j + 1] = (word >> 16) & 0xff;
+            bufs[0][j + 2] = (word >> 8) & 0xff;
+            bufs[0][j + 3] = word & 0xff;
+        }
+        for (; j < w; j++)
+            bufs[0][j] = GET_DATA_BYTE(line, j);
+    } else {  /* d == 32 */
+        for (j = 0; j < w; j++) {
+            word = line[j];
+            bufs[0][j] = (word >> L_RED_SHIFT) & 0xff;
+            bufs[1][j] = (word >> L_GREEN_SHIFT) & 0xff;
+            bufs[2][j] = (word >> L_BLUE_SHIFT) & 0xff;
+        }
     }
+    return;
+}
 
-        /* For halfwidth == 2, do the low pass separably.  Store
-         * the result of horizontal smoothing in an intermediate fpix. */
-    fpix = fpixCreate(w, h);
-    dataf = fpixGetData(fpix);
-    wplf = fpixGetWpl(fpix);
-    for (i = 2; i < h - 2; i++) {
-        lines = datas + i * wpls;
-        linef = dataf + i * wplf;
-        for (j = 2; j < w - 2; j++) {
-            val = GET_DATA_BYTE(lines, j - 2) +
-                  GET_DATA_BYTE(lines, j - 1) +
-                  GET_DATA_BYTE(lines, j) +
-                  GET_DATA_BYTE(lines, j + 1) +
-                  GET_DATA_BYTE(lines, j + 2);
-            linef[j] = val;
+
+/*!
+ * \brief   unsharpSetLine()
+ *
+ * \param[in]    lined   dest line
+ * \param[in]    bufs    1 buffer for 8 bpp; 3 (r, g, b) for 32 bpp
+ * \param[in]    lines   src line, for the alpha component; can be lined
+ * \param[in]    w       width in pixels
+ * \param[in]    d       8 or 32
+ * \param[in]    spp     of the src; alpha is copied if 4
+ * \return  void
+ */
+static void
+unsharpSetLine(l_uint32  *lined,
+               l_uint8  **bufs,
+               l_uint32  *lines,
+               l_int32    w,
+               l_int32    d,
+               l_int32    spp)
+{
+l_int32   j;
+l_uint32  amask;
+
+    if (d == 8) {
+        for (j = 0; j + 3 < w; j += 4) {
+            lined[j >> 2] = ((l_uint32)bufs[0][j] << 24) |
+                            ((l_uint32)bufs[0][j + 1] << 16) |
+                            ((l_uint32)bufs[0][j + 2] << 8) |
+                            bufs[0][j + 3];
+        }
+        for (; j < w; j++)
+            SET_DATA_BYTE(lined, j, bufs[0][j]);
+    } else {  /* d == 32 */
+        amask = (spp == 4) ? 0xff << L_ALPHA_SHIFT : 0;
+        for (j = 0; j < w; j++) {
+            lined[j] = ((l_uint32)bufs[0][j] << L_RED_SHIFT) |
+                       ((l_uint32)bufs[1][j] << L_GREEN_SHIFT) |
+                       ((l_uint32)bufs[2][j] << L_BLUE_SHIFT) |
+                       (lines[j] & amask);
         }
     }
+    return;
+}
 
-        /* Do vertical smoothing to finish the low-pass filter.
-         * At each pixel, if L is the lowpass value, I is the
-         * src pixel value and f is the fraction of highpass to
-         * be added to I, then the highpass filter value is
-         *     H = I - L
-         * and the new sharpened value is
-         *     N = I + f * H.
-         */
-    for (i = 2; i < h - 2; i++) {
-        linef0 = dataf + (i - 2) * wplf;
-        linef1 = dataf + (i - 1) * wplf;
-        linef2 = dataf + i * wplf;
-        linef3 = dataf + (i + 1) * wplf;
-        linef4 = dataf + (i + 2) * wplf;
-        lined = datad + i * wpld;
-        lines = datas + i * wpls;
-        for (j = 2; j < w - 2; j++) {
-            val = 0.04 * (linef0[j] + linef1[j] + linef2[j] +
-                          linef3[j] + linef4[j]);  /* L: lowpass filter value */
-            sval = GET_DATA_BYTE(lines, j);   /* I: source pixel */
-            ival = (l_int32)(sval + fract * (sval - val) + 0.5);
-            ival = L_MAX(0, ival);
-            ival = L_MIN(255, ival);
-            SET_DATA_BYTE(lined, j, ival);
+
+    /* Vector helpers for the line functions below.  Each converts 16
+     * bytes at p to 4 vectors of 4 floats, or rounds 4 vectors of floats
+     * as (l_int32)(x + 0.5) does for x >= 0, and clips them to 16 bytes.
+     * Rounding is done by truncating x to t and adding 1 if x - t >= 0.5;
+     * x - t is exact, so this is the same as adding 0.5 in double
+     * precision, and it gives a value <= 0 for any x < 0. */
+#if defined(ENHANCE_SSE2)
+#define  LOAD_FLOAT16(p, f)  { \
+    __m128i  b_, lo_, hi_; \
+    b_ = _mm_loadu_si128((const __m128i *)(p)); \
+    lo_ = _mm_unpacklo_epi8(b_, zero); \
+    hi_ = _mm_unpackhi_epi8(b_, zero); \
+    f[0] = _mm_cvtepi32_ps(_mm_unpacklo_epi16(lo_, zero)); \
+    f[1] = _mm_cvtepi32_ps(_mm_unpackhi_epi16(lo_, zero)); \
+    f[2] = _mm_cvtepi32_ps(_mm_unpacklo_epi16(hi_, zero)); \
+    f[3] = _mm_cvtepi32_ps(_mm_unpackhi_epi16(hi_, zero)); }
+#define  ROUND_INT4(x, t)  { \
+    t = _mm_cvttps_epi32(x); \
+    t = _mm_sub_epi32(t, _mm_castps_si128(_mm_cmpge_ps( \
+            _mm_sub_ps(x, _mm_cvtepi32_ps(t)), half))); }
+#define  STORE_CLIPPED16(p, t)  \
+    _mm_storeu_si128((__m128i *)(p), _mm_packus_epi16( \
+        _mm_packs_epi32(t[0], t[1]), _mm_packs_epi32(t[2], t[3])))
+#elif defined(ENHANCE_NEON)
+#define  LOAD_FLOAT16(p, f)  { \
+    uint8x16_t  b_; \
+    uint16x8_t  lo_, hi_; \
+    b_ = vld1q_u8(p); \
+    lo_ = vmovl_u8(vget_low_u8(b_)); \
+    hi_ = vmovl_u8(vget_high_u8(b_)); \
+    f[0] = vcvtq_f32_u32(vmovl_u16(vget_low_u16(lo_))); \
+    f[1] = vcvtq_f32_u32(vmovl_u16(vget_high_u16(lo_))); \
+    f[2] = vcvtq_f32_u32(vmovl_u16(vget_low_u16(hi_))); \
+    f[3] = vcvtq_f32_u32(vmovl_u16(vget_high_u16(hi_))); }
+#define  ROUND_INT4(x, t)  { \
+    t = vcvtq_s32_f32(x); \
+    t = vsubq_s32(t, vreinterpretq_s32_u32(vcgeq_f32( \
+            vsubq_f32(x, vcvtq_f32_s32(t)), half))); }
+#define  STORE_CLIPPED16(p, t)  \
+    vst1q_u8((p), vcombine_u8( \
+        vqmovun_s16(vcombine_s16(vqmovn_s32(t[0]), vqmovn_s32(t[1]))), \
+        vqmovun_s16(vcombine_s16(vqmovn_s32(t[2]), vqmovn_s32(t[3])))))
+#endif  /* ENHANCE_SSE2 */
+
+
+/*!
+ * \brief   unsharpLine3()
+ *
+ * \param[in]    bufd    dest; gets pixels 1 to w - 2
+ * \param[in]    buf0, buf1, buf2   src lines above, at and below bufd
+ * \param[in]    w       width in pixels
+ * \param[in]    fract   fraction of edge added back into image
+ * \return  void
+ *
+ * <pre>
+ * Notes:
+ *      (1) This is the 3x3 sharpening filter of pixUnsharpMaskingGray2D(),
+ *          with the same float products summed in the same order.
+ * </pre>
+ */
+static void
+unsharpLine3(l_uint8   *bufd,
+             l_uint8   *buf0,
+             l_uint8   *buf1,
+             l_uint8   *buf2,
+             l_int32    w,
+             l_float32  fract)
+{
+l_int32    j, ival;
+l_float32  val, a, ac;
+
+    a = -fract / 9.0;  /* all but the center */
+    ac = 1.0 + fract * 8.0 / 9.0;
+    j = 1;
+#if defined(ENHANCE_SSE2) || defined(ENHANCE_NEON)
+    {
+    l_int32   k, q;
+    l_uint8  *bufk;
+#if defined(ENHANCE_SSE2)
+    __m128i  zero, t[4];
+    __m128   half, va, vac, coef, f[4], sum[4];
+
+    zero = _mm_setzero_si128();
+    half = _mm_set1_ps(0.5f);
+    va = _mm_set1_ps(a);
+    vac = _mm_set1_ps(ac);
+#define  MUL(x, y)  _mm_mul_ps(x, y)
+#define  ADD(x, y)  _mm_add_ps(x, y)
+#else
+    int32x4_t    t[4];
+    float32x4_t  half, va, vac, coef, f[4], sum[4];
+
+    half = vdupq_n_f32(0.5f);
+    va = vdupq_n_f32(a);
+    vac = vdupq_n_f32(ac);
+#define  MUL(x, y)  vmulq_f32(x, y)
+#define  ADD(x, y)  vaddq_f32(x, y)
+#endif  /* ENHANCE_SSE2 */
+    for (; j + 16 <= w - 1; j += 16) {
+        for (k = 0; k < 9; k++) {
+            bufk = (k < 3) ? buf0 : (k < 6) ? buf1 : buf2;
+            LOAD_FLOAT16(bufk + j + k % 3 - 1, f);
+            coef = (k == 4) ? vac : va;
+            for (q = 0; q < 4; q++)
+                sum[q] = (k == 0) ? MUL(coef, f[q]) :
+                                    ADD(sum[q], MUL(coef, f[q]));
         }
+        for (q = 0; q < 4; q++)
+            ROUND_INT4(sum[q], t[q]);
+        STORE_CLIPPED16(bufd + j, t);
+    }
+#undef  MUL
+#undef  ADD
+    }
+#endif  /* ENHANCE_SSE2 || ENHANCE_NEON */
+
+    for (; j < w - 1; j++) {
+        val = a * buf0[j - 1] + a * buf0[j] + a * buf0[j + 1] +
+              a * buf1[j - 1] + ac * buf1[j] + a * buf1[j + 1] +
+              a * buf2[j - 1] + a * buf2[j] + a * buf2[j + 1];
+        ival = (l_int32)(val + 0.5);
+        ival = L_MAX(0, ival);
+        ival = L_MIN(255, ival);
+        bufd[j] = ival;
     }
+    return;
+}
 
-    fpixDestroy(&fpix);
-    return pixd;
+
+/*!
+ * \brief   unsharpLine5()
+ *
+ * \param[in]    bufd    dest; gets pixels 2 to w - 3
+ * \param[in]    bufs    5 src lines, from 2 above to 2 below bufd
+ * \param[in]    w       width in pixels
+ * \param[in]    fract   fraction of edge added back into image
+ * \param[in]    colsum  buffer of at least w + 8
+ * \return  void
+ *
+ * <pre>
+ * Notes:
+ *      (1) This is the 5x5 filter of pixUnsharpMaskingGray2D(): the
+ *          lowpass value is the sum of the 25 pixels times 0.04, in
+ *          float.  The vector code divides the sum by 25 instead, which
+ *          gives the same float for every possible sum.
+ * </pre>
+ */
+static void
+unsharpLine5(l_uint8   *bufd,
+             l_uint8  **bufs,
+             l_int32    w,
+             l_float32  fract,
+             l_uint16  *colsum)
+{
+l_int32    j, sum, sval, ival;
+l_float32  val;
+
+    for (j = 0; j < w; j++)
+        colsum[j] = bufs[0][j] + bufs[1][j] + bufs[2][j] + bufs[3][j] +
+                    bufs[4][j];
+
+    j = 2;
+#if defined(ENHANCE_SSE2)
+    {
+    l_int32  q;
+    __m128i  zero, s16, sv16, t[2];
+    __m128   half, vfract, v25, x, sv;
+
+    zero = _mm_setzero_si128();
+    half = _mm_set1_ps(0.5f);
+    vfract = _mm_set1_ps(fract);
+    v25 = _mm_set1_ps(25.0f);
+    for (; j + 8 <= w - 2; j += 8) {
+        s16 = _mm_add_epi16(
+                  _mm_add_epi16(
+                      _mm_loadu_si128((const __m128i *)(colsum + j - 2)),
+                      _mm_loadu_si128((const __m128i *)(colsum + j - 1))),
+                  _mm_add_epi16(
+                      _mm_loadu_si128((const __m128i *)(colsum + j)),
+                      _mm_loadu_si128((const __m128i *)(colsum + j + 1))));
+        s16 = _mm_add_epi16(s16,
+                  _mm_loadu_si128((const __m128i *)(colsum + j + 2)));
+        sv16 = _mm_unpacklo_epi8(
+                   _mm_loadl_epi64((const __m128i *)(bufs[2] + j)), zero);
+        for (q = 0; q < 2; q++) {
+            x = _mm_div_ps(_mm_cvtepi32_ps((q == 0) ?
+                               _mm_unpacklo_epi16(s16, zero) :
+                               _mm_unpackhi_epi16(s16, zero)), v25);
+            sv = _mm_cvtepi32_ps((q == 0) ? _mm_unpacklo_epi16(sv16, zero) :
+                                            _mm_unpackhi_epi16(sv16, zero));
+            x = _mm_add_ps(sv, _mm_mul_ps(vfract, _mm_sub_ps(sv, x)));
+            ROUND_INT4(x, t[q]);
+        }
+        _mm_storel_epi64((__m128i *)(bufd + j),
+                         _mm_packus_epi16(_mm_packs_epi32(t[0], t[1]), zero));
+    }
+    }
+#elif defined(ENHANCE_NEON)
+    {
+    l_int32      q;
+    uint16x8_t   s16, sv16;
+    int32x4_t    t[2];
+    float32x4_t  half, vfract, v25, x, sv;
+
+    half = vdupq_n_f32(0.5f);
+    vfract = vdupq_n_f32(fract);
+    v25 = vdupq_n_f32(25.0f);
+    for (; j + 8 <= w - 2; j += 8) {
+        s16 = vaddq_u16(vaddq_u16(vld1q_u16(colsum + j - 2),
+                                  vld1q_u16(colsum + j - 1)),
+                        vaddq_u16(vld1q_u16(colsum + j),
+                                  vld1q_u16(colsum + j + 1)));
+        s16 = vaddq_u16(s16, vld1q_u16(colsum + j + 2));
+        sv16 = vmovl_u8(vld1_u8(bufs[2] + j));
+        for (q = 0; q < 2; q++) {
+            x = vdivq_f32(vcvtq_f32_u32(vmovl_u16((q == 0) ?
+                              vget_low_u16(s16) : vget_high_u16(s16))), v25);
+            sv = vcvtq_f32_u32(vmovl_u16((q == 0) ? vget_low_u16(sv16) :
+                                                    vget_high_u16(sv16)));
+            x = vaddq_f32(sv, vmulq_f32(vfract, vsubq_f32(sv, x)));
+            ROUND_INT4(x, t[q]);
+        }
+        vst1_u8(bufd + j, vqmovun_s16(vcombine_s16(vqmovn_s32(t[0]),
+                                                   vqmovn_s32(t[1]))));
+    }
+    }
+#endif  /* ENHANCE_SSE2 */
+
+    for (; j < w - 2; j++) {
+        sum = colsum[j - 2] + colsum[j - 1] + colsum[j] + colsum[j + 1] +
+              colsum[j + 2];
+        val = 0.04 * sum;  /* L: lowpass filter value */
+        sval = bufs[2][j];   /* I: source pixel */
+        ival = (l_int32)(sval + fract * (sval - val) + 0.5);
+        ival = L_MAX(0, ival);
+        ival = L_MIN(255, ival);
+        bufd[j] = ival;
+    }
+    return;
+}
+
+
+/*!
+ * \brief   unsharpLineBox()
+ *
+ * \param[in]    bufd     dest
+ * \param[in]    bufs     src line at bufd
+ * \param[in]    colsum   column sums for this line
+ * \param[in]    rowsum   buffer of at least w + 4
+ * \param[in]    w        width in pixels
+ * \param[in]    wc       half-width of the smoothing
+ * \param[in]    edgerow  1 if within hc lines of the top or bottom
+ * \param[in]    normh    renormalization for an edge line
+ * \param[in]    norm     1 / (area of the smoothing filter)
+ * \param[in]    fract    fraction of edge added back into image
+ * \return  void
+ *
+ * <pre>
+ * Notes:
+ *      (1) The smoothed value, and its renormalization near the image
+ *          boundary, use the same float expressions as blockconvLow().
+ *          The line sum for column j is over columns max(j - wc, 1) to
+ *          min(j + wc, w - 1), taken from the running sum of colsum.
+ *      (2) The sharpened value is the src plus the truncated float
+ *          product of fract and (src - smoothed), as in
+ *          pixMultConstAccumulate().
+ *      (3) Away from the image boundary, 16 pixels at a time are done
+ *          with SSE2 or NEON where available.
+ * </pre>
+ */
+static void
+unsharpLineBox(l_uint8   *bufd,
+               l_uint8   *bufs,
+               l_uint32  *colsum,
+               l_uint32  *rowsum,
+               l_int32    w,
+               l_int32    wc,
+               l_int32    edgerow,
+               l_float32  normh,
+               l_float32  norm,
+               l_float32  fract)
+{
+l_int32    j, jvec, jmin, jmax, fwc, wmwc, wn, sval, dval;
+l_uint32   val;
+l_float32  normw;
+
+    fwc = 2 * wc + 1;
+    wmwc = w - wc;
+    rowsum[0] = colsum[0];
+    for (j = 1; j < w; j++)
+        rowsum[j] = rowsum[j - 1] + colsum[j];
+
+        /* Columns wc + 1 to jvec - 1 of a line away from the top
+         * and bottom are done by the vector code */
+    jvec = wc + 1;
+#if defined(ENHANCE_SSE2) || defined(ENHANCE_NEON)
+    if (!edgerow) {
+    l_int32  q;
+#if defined(ENHANCE_SSE2)
+    __m128i  zero, sum, c, sv, t[4];
+    __m128   half, vnorm, vfract, f[4];
+
+    zero = _mm_setzero_si128();
+    half = _mm_set1_ps(0.5f);
+    vnorm = _mm_set1_ps(norm);
+    vfract = _mm_set1_ps(fract);
+    for (j = jvec; j + 16 <= wmwc; j += 16) {
+        LOAD_FLOAT16(bufs + j, f);
+        for (q = 0; q < 4; q++) {
+            sum = _mm_sub_epi32(
+                _mm_loadu_si128((const __m128i *)(rowsum + j + 4 * q + wc)),
+                _mm_loadu_si128((const __m128i *)(rowsum + j + 4 * q
+                                                  - wc - 1)));
+            ROUND_INT4(_mm_mul_ps(vnorm, _mm_cvtepi32_ps(sum)), c);
+            sv = _mm_cvttps_epi32(f[q]);
+            t[q] = _mm_cvttps_epi32(_mm_mul_ps(
+                       _mm_cvtepi32_ps(_mm_sub_epi32(sv, c)), vfract));
+            t[q] = _mm_add_epi32(sv, t[q]);
+        }
+        STORE_CLIPPED16(bufd + j, t);
+    }
+#else
+    uint32x4_t   sum;
+    int32x4_t    c, sv, t[4];
+    float32x4_t  half, vnorm, vfract, f[4];
+
+    half = vdupq_n_f32(0.5f);
+    vnorm = vdupq_n_f32(norm);
+    vfract = vdupq_n_f32(fract);
+    for (j = jvec; j + 16 <= wmwc; j += 16) {
+        LOAD_FLOAT16(bufs + j, f);
+        for (q = 0; q < 4; q++) {
+            sum = vsubq_u32(vld1q_u32(rowsum + j + 4 * q + wc),
+                            vld1q_u32(rowsum + j + 4 * q - wc - 1));
+            ROUND_INT4(vmulq_f32(vnorm, vcvtq_f32_u32(sum)), c);
+            sv = vcvtq_s32_f32(f[q]);
+            t[q] = vcvtq_s32_f32(vmulq_f32(vcvtq_f32_s32(vsubq_s32(sv, c)),
+                                           vfract));
+            t[q] = vaddq_s32(sv, t[q]);
+        }
+        STORE_CLIPPED16(bufd + j, t);
+    }
+#endif  /* ENHANCE_SSE2 */
+    jvec = j;
+    }
+#endif  /* ENHANCE_SSE2 || ENHANCE_NEON */
+
+    for (j = 0; j < w; j++) {
+        if (j == wc + 1) {
+            j = jvec;
+            if (j >= w) break;
+        }
+        jmin = L_MAX(j - 1 - wc, 0);
+        jmax = L_MIN(j + wc, w - 1);
+        val = rowsum[jmax] - rowsum[jmin];
+        val = (l_uint8)(norm * val + 0.5);
+        if (j <= wc || j >= wmwc) {
+            wn = (j <= wc) ? wc + j : wc + w - j;
+            normw = (l_float32)fwc / (l_float32)wn;   /* > 1 */
+            if (edgerow)
+                val = (l_uint8)L_MIN(val * normh * normw, 255);
+            else
+                val = (l_uint8)L_MIN(val * normw, 255);
+        } else if (edgerow) {
+            val = (l_uint8)L_MIN(val * normh, 255);
+        }
+        sval = bufs[j];
+        dval = sval + (l_int32)((sval - (l_int32)val) * fract);
+        dval = L_MAX(0, dval);
+        bufd[j] = L_MIN(255, dval);
+    }
+    return;
 }
 
+#undef  LOAD_FLOAT16
+#undef  ROUND_INT4
+#undef  STORE_CLIPPED16
 
 
 /*-----------------------------------------------------------------------*
@@ -58,6 +58,17 @@
 #include <string.h>
 #include "allheaders.h"
 
+    /* Vector thresholding of 8 bpp lines, on little-endian hosts */
+#ifndef L_BIG_ENDIAN
+#if defined(__SSE2__)
+#define  GRAYQUANT_SSE2   1
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define  GRAYQUANT_NEON   1
+#include <arm_neon.h>
+#endif
+#endif  /* ~L_BIG_ENDIAN */
+
 #ifndef  NO_CONSOLE_IO
 #define DEBUG_UNROLLING 0
 #endif   /* ~NO_CONSOLE_IO */
@@ -266,6 +277,10 @@ l_uint32  *lines, *lined;
 /*
  *  thresholdToBinaryLineLow()
  *
+ *  For 8 bpp, with 0 < thresh < 256, 32 pixels at a time are compared
+ *  with SSE2 or NEON where available.  The words of each 16 pixels are
+ *  first put in the order that makes the compare mask come out with
+ *  the leftmost pixel in the most significant bit.
  */
 void
 thresholdToBinaryLineLow(l_uint32  *lined,
@@ -337,8 +352,66 @@ l_uint32 sword, dword;
 #endif
         break;
     case 8:
+        j = scount = dcount = 0;
+#if defined(GRAYQUANT_SSE2)
+        if (thresh > 0 && thresh < 256) {
+            __m128i  bias, vthresh, a, b;
+            l_uint32 ma, mb;
+
+                /* Unsigned compare as signed compare of (val ^ 0x80) */
+            bias = _mm_set1_epi8((char)0x80);
+            vthresh = _mm_set1_epi8((char)(thresh ^ 0x80));
+            for (; j + 31 < w; j += 32) {
+                    /* Reverse the 4 words, giving pixels 15 down to 0 */
+                a = _mm_shuffle_epi32(
+                        _mm_loadu_si128((const __m128i *)(lines + scount)),
+                        0x1b);
+                b = _mm_shuffle_epi32(
+                        _mm_loadu_si128((const __m128i *)(lines + scount + 4)),
+                        0x1b);
+                ma = _mm_movemask_epi8(
+                         _mm_cmplt_epi8(_mm_xor_si128(a, bias), vthresh));
+                mb = _mm_movemask_epi8(
+                         _mm_cmplt_epi8(_mm_xor_si128(b, bias), vthresh));
+                lined[dcount++] = (ma << 16) | mb;
+                scount += 8;
+            }
+        }
+#elif defined(GRAYQUANT_NEON)
+        if (thresh > 0 && thresh < 256) {
+            static const l_uint8  bitval[16] = {128, 64, 32, 16, 8, 4, 2, 1,
+                                                128, 64, 32, 16, 8, 4, 2, 1};
+            uint8x16_t  vthresh, vbits, a, b;
+            uint8x8_t   sum;
+            l_uint32    ma, mb;
+            const l_uint8  *src;
+
+            vthresh = vdupq_n_u8((l_uint8)thresh);
+            vbits = vld1q_u8(bitval);
+            for (; j + 31 < w; j += 32) {
+                    /* Reverse the bytes of each word, giving pixels 0 to 15,
+                     * and add up the bits of each 8 pixels pairwise */
+                src = (const l_uint8 *)(lines + scount);
+                a = vrev32q_u8(vld1q_u8(src));
+                a = vandq_u8(vcltq_u8(a, vthresh), vbits);
+                b = vrev32q_u8(vld1q_u8(src + 16));
+                b = vandq_u8(vcltq_u8(b, vthresh), vbits);
+                sum = vpadd_u8(vget_low_u8(a), vget_high_u8(a));
+                sum = vpadd_u8(sum, sum);
+                sum = vpadd_u8(sum, sum);
+                ma = (vget_lane_u8(sum, 0) << 8) | vget_lane_u8(sum, 1);
+                sum = vpadd_u8(vget_low_u8(b), vget_high_u8(b));
+                sum = vpadd_u8(sum, sum);
+                sum = vpadd_u8(sum, sum);
+                mb = (vget_lane_u8(sum, 0) << 8) | vget_lane_u8(sum, 1);
+                lined[dcount++] = (ma << 16) | mb;
+                scount += 8;
+            }
+        }
+#endif  /* GRAYQUANT_SSE2 */
+
             /* Unrolled as 8 source words, 1 dest word */
-        for (j = 0, scount = 0, dcount = 0; j + 31 < w; j += 32) {
+        for (; j + 31 < w; j += 32) {
             dword = 0;
             for (k = 0; k < 8; k++) {
                 sword = lines[scount++];
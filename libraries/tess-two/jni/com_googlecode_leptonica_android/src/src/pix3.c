@@ -97,7 +97,8 @@
  *    Representative tile near but outside region
  *           l_int32     pixFindRepCloseTile()
  *
- *    Static helper function
+ *    Static helper functions
+ *           static l_int32  countPixelsInLine()
  *           static BOXA    *findTileRegionsForSearch()
  * </pre>
  */
@@ -106,6 +107,18 @@
 #include <math.h>
 #include "allheaders.h"
 
+    /* Bit counting works on whole 32-bit words, so the vector code
+     * does not depend on byte order. */
+#if defined(__SSE2__)
+#define  COUNT_SSE2   1
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define  COUNT_NEON   1
+#include <arm_neon.h>
+#endif
+
+static l_int32 countPixelsInLine(const l_uint32 *line, l_int32 fullwords,
+                                 l_uint32 endmask, l_int32 *tab);
 static BOXA *findTileRegionsForSearch(BOX *box, l_int32 w, l_int32 h,
                                       l_int32 searchdir, l_int32 mindist,
                                       l_int32 tsize, l_int32 ntiles);
@@ -1773,7 +1786,7 @@ pixCountPixels(PIX      *pix,
                l_int32  *tab8)
 {
 l_uint32   endmask;
-l_int32    w, h, wpl, i, j;
+l_int32    w, h, wpl, i;
 l_int32    fullwords, endbits, sum;
 l_int32   *tab;
 l_uint32  *data;
@@ -1799,26 +1812,8 @@ l_uint32  *data;
     endmask = (endbits == 0) ? 0 : (0xffffffffU << (32 - endbits));
 
     sum = 0;
-    for (i = 0; i < h; i++, data += wpl) {
-        for (j = 0; j < fullwords; j++) {
-            l_uint32 word = data[j];
-            if (word) {
-                sum += tab[word & 0xff] +
-                       tab[(word >> 8) & 0xff] +
-                       tab[(word >> 16) & 0xff] +
-                       tab[(word >> 24) & 0xff];
-            }
-        }
-        if (endbits) {
-            l_uint32 word = data[j] & endmask;
-            if (word) {
-                sum += tab[word & 0xff] +
-                       tab[(word >> 8) & 0xff] +
-                       tab[(word >> 16) & 0xff] +
-                       tab[(word >> 24) & 0xff];
-            }
-        }
-    }
+    for (i = 0; i < h; i++, data += wpl)
+        sum += countPixelsInLine(data, fullwords, endmask, tab);
     *pcount = sum;
 
     if (!tab8)
@@ -1827,6 +1822,100 @@ l_uint32  *data;
 }
 
 
+/*!
+ * \brief   countPixelsInLine()
+ *
+ * \param[in]    line        start of a 1 bpp raster line
+ * \param[in]    fullwords   number of words with all 32 bits in the image
+ * \param[in]    endmask     mask for the bits of the last, partial word;
+ *                           0 if there is no partial word
+ * \param[in]    tab         8-bit pixel lookup table
+ * \return  number of ON pixels in the line
+ *
+ * <pre>
+ * Notes:
+ *      (1) With SSE2 or NEON, runs of 4 full words are counted in a
+ *          vector register: SSE2 with a bitwise tree of adds followed
+ *          by a sum of absolute differences, and NEON with its byte
+ *          popcount.  The remaining words go through %tab.
+ * </pre>
+ */
+static l_int32
+countPixelsInLine(const l_uint32  *line,
+                  l_int32          fullwords,
+                  l_uint32         endmask,
+                  l_int32         *tab)
+{
+l_int32   j, sum;
+l_uint32  word;
+
+    sum = 0;
+    j = 0;
+#if COUNT_SSE2
+    if (fullwords >= 4) {
+        const __m128i  m1 = _mm_set1_epi8(0x55);
+        const __m128i  m2 = _mm_set1_epi8(0x33);
+        const __m128i  m4 = _mm_set1_epi8(0x0f);
+        const __m128i  zero = _mm_setzero_si128();
+        __m128i        x, acc;
+
+        acc = zero;
+        for (; j + 4 <= fullwords; j += 4) {
+            x = _mm_loadu_si128((const __m128i *)(line + j));
+            x = _mm_sub_epi8(x, _mm_and_si128(_mm_srli_epi64(x, 1), m1));
+            x = _mm_add_epi8(_mm_and_si128(x, m2),
+                             _mm_and_si128(_mm_srli_epi64(x, 2), m2));
+            x = _mm_and_si128(_mm_add_epi8(x, _mm_srli_epi64(x, 4)), m4);
+            acc = _mm_add_epi64(acc, _mm_sad_epu8(x, zero));
+        }
+        sum = _mm_cvtsi128_si32(acc) +
+              _mm_cvtsi128_si32(_mm_srli_si128(acc, 8));
+    }
+#elif COUNT_NEON
+    if (fullwords >= 4) {
+        l_int32     k;
+        uint16x8_t  acc16;
+        uint32x4_t  acc32;
+        uint64x2_t  acc64;
+
+            /* Each 16-bit lane gains at most 16 per step; flush to
+             * 32 bits before it can overflow. */
+        acc32 = vdupq_n_u32(0);
+        while (j + 4 <= fullwords) {
+            acc16 = vdupq_n_u16(0);
+            for (k = 0; k < 2048 && j + 4 <= fullwords; k++, j += 4) {
+                acc16 = vpadalq_u8(acc16,
+                            vcntq_u8(vld1q_u8((const uint8_t *)(line + j))));
+            }
+            acc32 = vpadalq_u16(acc32, acc16);
+        }
+        acc64 = vpaddlq_u32(acc32);
+        sum = (l_int32)(vgetq_lane_u64(acc64, 0) + vgetq_lane_u64(acc64, 1));
+    }
+#endif  /* COUNT_SSE2 */
+
+    for (; j < fullwords; j++) {
+        word = line[j];
+        if (word) {
+            sum += tab[word & 0xff] +
+                   tab[(word >> 8) & 0xff] +
+                   tab[(word >> 16) & 0xff] +
+                   tab[(word >> 24) & 0xff];
+        }
+    }
+    if (endmask) {
+        word = line[j] & endmask;
+        if (word) {
+            sum += tab[word & 0xff] +
+                   tab[(word >> 8) & 0xff] +
+                   tab[(word >> 16) & 0xff] +
+                   tab[(word >> 24) & 0xff];
+        }
+    }
+    return sum;
+}
+
+
 /*!
  * \brief   pixCountByRow()
  *
@@ -2022,9 +2111,9 @@ pixCountPixelsInRow(PIX      *pix,
                     l_int32  *pcount,
                     l_int32  *tab8)
 {
-l_uint32   word, endmask;
-l_int32    j, w, h, wpl;
-l_int32    fullwords, endbits, sum;
+l_uint32   endmask;
+l_int32    w, h, wpl;
+l_int32    fullwords, endbits;
 l_int32   *tab;
 l_uint32  *line;
 
@@ -2050,26 +2139,7 @@ l_uint32  *line;
     else
         tab = tab8;
 
-    sum = 0;
-    for (j = 0; j < fullwords; j++) {
-        word = line[j];
-        if (word) {
-            sum += tab[word & 0xff] +
-                   tab[(word >> 8) & 0xff] +
-                   tab[(word >> 16) & 0xff] +
-                   tab[(word >> 24) & 0xff];
-        }
-    }
-    if (endbits) {
-        word = line[j] & endmask;
-        if (word) {
-            sum += tab[word & 0xff] +
-                   tab[(word >> 8) & 0xff] +
-                   tab[(word >> 16) & 0xff] +
-                   tab[(word >> 24) & 0xff];
-        }
-    }
-    *pcount = sum;
+    *pcount = countPixelsInLine(line, fullwords, endmask, tab);
 
     if (!tab8)
         LEPT_FREE(tab);
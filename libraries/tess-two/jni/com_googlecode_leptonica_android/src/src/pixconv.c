@@ -45,6 +45,7 @@
  *      Conversion from RGB color to grayscale
  *           PIX        *pixConvertRGBToLuminance()
  *           PIX        *pixConvertRGBToGray()
+ *           static l_int32  rgbToGrayLineVector()
  *           PIX        *pixConvertRGBToGrayFast()
  *           PIX        *pixConvertRGBToGrayMinMax()
  *           PIX        *pixConvertRGBToGraySatBoost()
@@ -149,6 +150,21 @@
 #include <math.h>
 #include "allheaders.h"
 
+    /* Vector RGB to gray conversion, on little-endian hosts */
+#ifndef L_BIG_ENDIAN
+#if defined(__SSE2__)
+#define  CONVERT_SSE2   1
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define  CONVERT_NEON   1
+#include <arm_neon.h>
+#endif
+#endif  /* ~L_BIG_ENDIAN */
+
+static l_int32 rgbToGrayLineVector(l_uint32 *lined, l_uint32 *lines,
+                                   l_int32 w, l_float32 rwt, l_float32 gwt,
+                                   l_float32 bwt);
+
 /* ------- Set neutral point for min/max boost conversion to gray ------ */
    /* Call l_setNeutralBoostVal() to change this */
 static l_int32  var_NEUTRAL_BOOST_VAL = 180;
@@ -316,7 +332,7 @@ pixRemoveColormap(PIX     *pixs,
                   l_int32  type)
 {
 l_int32    sval, rval, gval, bval, val0, val1;
-l_int32    i, j, k, w, h, d, wpls, wpld, ncolors, count;
+l_int32    i, j, k, w, h, d, wpls, wpld, ncolors, count, nbad;
 l_int32    opaque, colorfound, blackwhite;
 l_int32   *rmap, *gmap, *bmap, *amap, *graymap;
 l_uint32  *datas, *lines, *datad, *lined, *lut;
@@ -550,7 +566,10 @@ PIX       *pixd;
             pixSetSpp(pixd, 4);
         datad = pixGetData(pixd);
         wpld = pixGetWpl(pixd);
-        lut = (l_uint32 *)LEPT_CALLOC(ncolors, sizeof(l_uint32));
+            /* The lut has an entry for every pixel value, so that the
+             * inner loops need no bounds check.  Values without a color
+             * map to 0, which is what those pixels were left at before. */
+        lut = (l_uint32 *)LEPT_CALLOC(1 << d, sizeof(l_uint32));
         for (i = 0; i < ncolors; i++) {
             if (type == REMOVE_CMAP_TO_FULL_COLOR)
                 composeRGBPixel(rmap[i], gmap[i], bmap[i], lut + i);
@@ -558,10 +577,26 @@ PIX       *pixd;
                 composeRGBAPixel(rmap[i], gmap[i], bmap[i], amap[i], lut + i);
         }
 
+        nbad = 0;
         for (i = 0; i < h; i++) {
             lines = datas + i * wpls;
             lined = datad + i * wpld;
-            for (j = 0; j < w; j++) {
+            j = 0;
+            if (d == 8) {
+                    /* Unrolled 4x */
+                for (count = 0; j + 3 < w; j += 4, count++) {
+                    sword = lines[count];
+                    lined[j] = lut[sword >> 24];
+                    lined[j + 1] = lut[(sword >> 16) & 0xff];
+                    lined[j + 2] = lut[(sword >> 8) & 0xff];
+                    lined[j + 3] = lut[sword & 0xff];
+                    nbad += ((l_int32)(sword >> 24) >= ncolors) +
+                            ((l_int32)((sword >> 16) & 0xff) >= ncolors) +
+                            ((l_int32)((sword >> 8) & 0xff) >= ncolors) +
+                            ((l_int32)(sword & 0xff) >= ncolors);
+                }
+            }
+            for (; j < w; j++) {
                 if (d == 8)
                     sval = GET_DATA_BYTE(lines, j);
                 else if (d == 4)
@@ -570,12 +605,12 @@ PIX       *pixd;
                     sval = GET_DATA_DIBIT(lines, j);
                 else  /* (d == 1) */
                     sval = GET_DATA_BIT(lines, j);
-                if (sval >= ncolors)
-                    L_WARNING("pixel value out of bounds\n", procName);
-                else
-                    lined[j] = lut[sval];
+                nbad += (sval >= ncolors);
+                lined[j] = lut[sval];
             }
         }
+        if (nbad > 0)
+            L_WARNING("%d pixel values out of bounds\n", procName, nbad);
         LEPT_FREE(lut);
     }
 
@@ -791,7 +826,8 @@ PIX       *pixd;
     for (i = 0; i < h; i++) {
         lines = datas + i * wpls;
         lined = datad + i * wpld;
-        for (j = 0; j < w; j++) {
+        j = rgbToGrayLineVector(lined, lines, w, rwt, gwt, bwt);
+        for (; j < w; j++) {
             word = *(lines + j);
             val = (l_int32)(rwt * ((word >> L_RED_SHIFT) & 0xff) +
                             gwt * ((word >> L_GREEN_SHIFT) & 0xff) +
@@ -804,6 +840,127 @@ PIX       *pixd;
 }
 
 
+/*!
+ * \brief   rgbToGrayLineVector()
+ *
+ * \param[in]    lined   8 bpp dest line
+ * \param[in]    lines   32 bpp src line
+ * \param[in]    w       width in pixels
+ * \param[in]    rwt, gwt, bwt  weights, as used by pixConvertRGBToGray()
+ * \return  number of pixels converted; always a multiple of 16
+ *
+ * <pre>
+ * Notes:
+ *      (1) Converts 16 pixels at a time with SSE2 or NEON, and returns 0
+ *          where neither is available.  The caller does the rest of the
+ *          line.
+ *      (2) The gray value is computed in single precision floats with
+ *          the same products and sums, in the same order, as the scalar
+ *          code in pixConvertRGBToGray(), so the results are identical
+ *          unless the compiler fuses the scalar multiply-adds.
+ *          Instead of adding 0.5 in double precision and truncating,
+ *          the sum s is truncated to t and t is incremented if
+ *          s - t >= 0.5.  s - t is exact, so this is also identical.
+ *          A fixed-point weighted sum would be faster still, but it
+ *          rounds differently and changes some gray values by 1.
+ *      (3) The 16 gray bytes come out in pixel order and are swapped
+ *          within each 32-bit word to the byte order of an 8 bpp line.
+ * </pre>
+ */
+static l_int32
+rgbToGrayLineVector(l_uint32  *lined,
+                    l_uint32  *lines,
+                    l_int32    w,
+                    l_float32  rwt,
+                    l_float32  gwt,
+                    l_float32  bwt)
+{
+l_int32  j;
+
+    j = 0;
+#if defined(CONVERT_SSE2)
+    {
+    l_int32  k;
+    __m128i  mask, rshift, gshift, bshift, v, t[4], p16a, p16b, p8;
+    __m128   rw, gw, bw, half, s, frac;
+
+    mask = _mm_set1_epi32(0xff);
+    rshift = _mm_cvtsi32_si128(L_RED_SHIFT);
+    gshift = _mm_cvtsi32_si128(L_GREEN_SHIFT);
+    bshift = _mm_cvtsi32_si128(L_BLUE_SHIFT);
+    rw = _mm_set1_ps(rwt);
+    gw = _mm_set1_ps(gwt);
+    bw = _mm_set1_ps(bwt);
+    half = _mm_set1_ps(0.5f);
+    for (; j + 16 <= w; j += 16) {
+        for (k = 0; k < 4; k++) {
+            v = _mm_loadu_si128((const __m128i *)(lines + j + 4 * k));
+            s = _mm_add_ps(
+                    _mm_add_ps(
+                        _mm_mul_ps(rw, _mm_cvtepi32_ps(
+                            _mm_and_si128(_mm_srl_epi32(v, rshift), mask))),
+                        _mm_mul_ps(gw, _mm_cvtepi32_ps(
+                            _mm_and_si128(_mm_srl_epi32(v, gshift), mask)))),
+                    _mm_mul_ps(bw, _mm_cvtepi32_ps(
+                        _mm_and_si128(_mm_srl_epi32(v, bshift), mask))));
+            t[k] = _mm_cvttps_epi32(s);
+            frac = _mm_sub_ps(s, _mm_cvtepi32_ps(t[k]));
+                /* the compare is all ones, i.e., -1, where it rounds up */
+            t[k] = _mm_sub_epi32(t[k],
+                                 _mm_castps_si128(_mm_cmpge_ps(frac, half)));
+        }
+        p16a = _mm_packs_epi32(t[0], t[1]);
+        p16b = _mm_packs_epi32(t[2], t[3]);
+        p8 = _mm_packus_epi16(p16a, p16b);
+            /* Reverse the bytes in each word */
+        p8 = _mm_or_si128(_mm_slli_epi16(p8, 8), _mm_srli_epi16(p8, 8));
+        p8 = _mm_shufflehi_epi16(_mm_shufflelo_epi16(p8, 0xb1), 0xb1);
+        _mm_storeu_si128((__m128i *)(lined + j / 4), p8);
+    }
+    }
+#elif defined(CONVERT_NEON)
+    {
+    l_int32      k;
+    uint32x4_t   mask, v, t[4], ge;
+    int32x4_t    rshift, gshift, bshift;
+    float32x4_t  rw, gw, bw, half, s, frac;
+    uint8x16_t   p8;
+
+    mask = vdupq_n_u32(0xff);
+    rshift = vdupq_n_s32(-L_RED_SHIFT);  /* negative shifts go right */
+    gshift = vdupq_n_s32(-L_GREEN_SHIFT);
+    bshift = vdupq_n_s32(-L_BLUE_SHIFT);
+    rw = vdupq_n_f32(rwt);
+    gw = vdupq_n_f32(gwt);
+    bw = vdupq_n_f32(bwt);
+    half = vdupq_n_f32(0.5f);
+    for (; j + 16 <= w; j += 16) {
+        for (k = 0; k < 4; k++) {
+            v = vld1q_u32(lines + j + 4 * k);
+            s = vaddq_f32(
+                    vaddq_f32(
+                        vmulq_f32(rw, vcvtq_f32_u32(
+                            vandq_u32(vshlq_u32(v, rshift), mask))),
+                        vmulq_f32(gw, vcvtq_f32_u32(
+                            vandq_u32(vshlq_u32(v, gshift), mask)))),
+                    vmulq_f32(bw, vcvtq_f32_u32(
+                        vandq_u32(vshlq_u32(v, bshift), mask))));
+            t[k] = vcvtq_u32_f32(s);
+            frac = vsubq_f32(s, vcvtq_f32_u32(t[k]));
+            ge = vcgeq_f32(frac, half);
+            t[k] = vsubq_u32(t[k], ge);
+        }
+        p8 = vcombine_u8(
+                 vmovn_u16(vcombine_u16(vmovn_u32(t[0]), vmovn_u32(t[1]))),
+                 vmovn_u16(vcombine_u16(vmovn_u32(t[2]), vmovn_u32(t[3]))));
+        vst1q_u8((uint8_t *)(lined + j / 4), vrev32q_u8(p8));
+    }
+    }
+#endif  /* CONVERT_SSE2 */
+    return j;
+}
+
+
 /*!
  * \brief   pixConvertRGBToGrayFast()
  *
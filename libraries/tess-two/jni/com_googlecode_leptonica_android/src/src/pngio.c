@@ -115,6 +115,17 @@
 
 #include "png.h"
 
+    /* Vector byte swaps, on the little-endian hosts that need them */
+#ifndef L_BIG_ENDIAN
+#if defined(__SSE2__)
+#define  PNG_SSE2_SWAP   1
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define  PNG_NEON_SWAP   1
+#include <arm_neon.h>
+#endif
+#endif  /* ~L_BIG_ENDIAN */
+
 #if  HAVE_LIBZ
 #include "zlib.h"
 #else
@@ -127,6 +138,8 @@
 static l_int32   var_PNG_STRIP_16_TO_8 = 1;
 
 
+static void pngSwapLineBytes(l_uint32 *line, l_int32 wpl);
+
 #ifndef  NO_CONSOLE_IO
 #define  DEBUG_READ     0
 #define  DEBUG_WRITE    0
@@ -158,34 +171,31 @@ static l_int32   var_PNG_STRIP_16_TO_8 = 1;
  *              Transparency is usually associated with the white background.
  *          (c) spp = 1, d = 8 with colormap and alpha in the trans array.
  *              Each color in the colormap has a separate transparency value.
- *      (4) We use the high level png interface, where the transforms are set
- *          up in advance and the header and image are read with a single
- *          call.  The more complicated interface, where the header is
- *          read first and the buffers for the raster image are user-
- *          allocated before reading the image, works for single images,
- *          but I could not get it to work properly for the successive
- *          png reads that are required by pixaReadStream().
+ *      (4) The image is decoded a row at a time straight into the pix,
+ *          so there is never a second copy of the raster in memory.
+ *          libpng converts rgb, rgba, gray + alpha and palette + alpha
+ *          rows to the byte order of 32 bpp pix words as it decodes
+ *          them, and rows of 16 bpp and less only have their bytes
+ *          swapped into words.  The rest of the file is read with
+ *          png_read_end(), which leaves the stream at the end of the
+ *          image, as successive reads by pixaReadStream() require.
  * </pre>
  */
 PIX *
 pixReadStreamPng(FILE  *fp)
 {
-l_uint8      byte;
-l_int32      rval, gval, bval;
-l_int32      i, j, k, index, ncolors, bitval;
-l_int32      wpl, d, spp, cindex, tRNS;
-l_uint32     png_transforms;
-l_uint32    *data, *line, *ppixel;
-int          num_palette, num_text, num_trans;
+l_int32      i, pass, npasses, wpl, d, spp, tRNS, blackwhite;
+l_int32      rval, gval, bval, val0, val1;
+int          num_palette, num_text;
 png_byte     bit_depth, color_type, channels;
 png_uint_32  w, h, rowbytes;
 png_uint_32  xres, yres;
-png_bytep    rowptr, trans;
-png_bytep   *row_pointers;
+png_bytep    scratch;
 png_structp  png_ptr;
 png_infop    info_ptr, end_info;
 png_colorp   palette;
 png_textp    text_ptr;  /* ptr to text_chunk */
+l_uint32    *data, *line;
 PIX         *pix, *pixt;
 PIXCMAP     *cmap;
 
@@ -193,7 +203,6 @@ PIXCMAP     *cmap;
 
     if (!fp)
         return (PIX *)ERROR_PTR("fp not defined", procName, NULL);
-    pix = NULL;
 
         /* Allocate the 3 data structures */
     if ((png_ptr = png_create_read_struct(PNG_LIBPNG_VER_STRING,
@@ -217,63 +226,80 @@ PIXCMAP     *cmap;
     }
 
     png_init_io(png_ptr, fp);
+    png_read_info(png_ptr, info_ptr);
 
-        /* ---------------------------------------------------------- *
-         *  Set the transforms flags.  Whatever happens here,
-         *  NEVER invert 1 bpp using PNG_TRANSFORM_INVERT_MONO.
-         *  Also, do not use PNG_TRANSFORM_EXPAND, which would
-         *  expand all images with bpp < 8 to 8 bpp.
-         * ---------------------------------------------------------- */
-        /* To strip 16 --> 8 bit depth, use PNG_TRANSFORM_STRIP_16 */
-    if (var_PNG_STRIP_16_TO_8 == 1) {  /* our default */
-        png_transforms = PNG_TRANSFORM_STRIP_16;
-    } else {
-        png_transforms = PNG_TRANSFORM_IDENTITY;
-        L_INFO("not stripping 16 --> 8 in png reading\n", procName);
-    }
-
-        /* Read it */
-    png_read_png(png_ptr, info_ptr, png_transforms, NULL);
-
-    row_pointers = png_get_rows(png_ptr, info_ptr);
     w = png_get_image_width(png_ptr, info_ptr);
     h = png_get_image_height(png_ptr, info_ptr);
     bit_depth = png_get_bit_depth(png_ptr, info_ptr);
-    rowbytes = png_get_rowbytes(png_ptr, info_ptr);
     color_type = png_get_color_type(png_ptr, info_ptr);
     channels = png_get_channels(png_ptr, info_ptr);
     spp = channels;
     tRNS = png_get_valid(png_ptr, info_ptr, PNG_INFO_tRNS) ? 1 : 0;
 
-    if (spp == 1) {
-        d = bit_depth;
-    } else {  /* spp == 2 (gray + alpha), spp == 3 (rgb), spp == 4 (rgba) */
-        d = 4 * bit_depth;
-    }
-
-        /* Remove if/when this is implemented for all bit_depths */
-    if (spp == 3 && bit_depth != 8) {
-        fprintf(stderr, "Help: spp = 3 and depth = %d != 8\n!!", bit_depth);
-        png_destroy_read_struct(&png_ptr, &info_ptr, &end_info);
-        return (PIX *)ERROR_PTR("not implemented for this depth",
-            procName, NULL);
+        /* ---------------------------------------------------------- *
+         *  Set the transforms.  Whatever happens here, NEVER invert
+         *  1 bpp using png_set_invert_mono().  Also, only expand
+         *  images with bpp < 8 to 8 bpp when they have alpha.
+         * ---------------------------------------------------------- */
+    if (bit_depth == 16) {
+        if (var_PNG_STRIP_16_TO_8 == 1) {  /* our default */
+            png_set_strip_16(png_ptr);
+            bit_depth = 8;
+        } else {
+            L_INFO("not stripping 16 --> 8 in png reading\n", procName);
+            if (spp != 1) {
+                png_destroy_read_struct(&png_ptr, &info_ptr, &end_info);
+                return (PIX *)ERROR_PTR("16 bps only implemented for gray",
+                                        procName, NULL);
+            }
+        }
     }
 
-    if (color_type == PNG_COLOR_TYPE_PALETTE ||
-        color_type == PNG_COLOR_MASK_PALETTE) {   /* generate a colormap */
+    cmap = NULL;
+    if (color_type == PNG_COLOR_TYPE_PALETTE && tRNS) {
+            /* Palette + alpha: expand to rgba */
+        L_INFO("converting (cmap + alpha) ==> RGBA\n", procName);
+        png_set_palette_to_rgb(png_ptr);
+        png_set_tRNS_to_alpha(png_ptr);
+        spp = 4;
+    } else if (color_type == PNG_COLOR_TYPE_PALETTE) {
+            /* Generate a colormap */
         png_get_PLTE(png_ptr, info_ptr, &palette, &num_palette);
-        cmap = pixcmapCreate(d);  /* spp == 1 */
-        for (cindex = 0; cindex < num_palette; cindex++) {
-            rval = palette[cindex].red;
-            gval = palette[cindex].green;
-            bval = palette[cindex].blue;
+        cmap = pixcmapCreate(bit_depth);
+        for (i = 0; i < num_palette; i++) {
+            rval = palette[i].red;
+            gval = palette[i].green;
+            bval = palette[i].blue;
             pixcmapAddColor(cmap, rval, gval, bval);
         }
+    } else if (spp == 2) {
+            /* Gray + alpha: copy gray value into r, g and b */
+        L_INFO("converting (gray + alpha) ==> RGBA\n", procName);
+        png_set_gray_to_rgb(png_ptr);
+        spp = 4;
+    }
+    if (spp == 3 || spp == 4) {
+            /* Components in the byte order of a 32 bpp pix word */
+#ifdef L_BIG_ENDIAN
+        if (spp == 3)
+            png_set_filler(png_ptr, 0, PNG_FILLER_AFTER);
+#else
+        png_set_bgr(png_ptr);
+        if (spp == 3)
+            png_set_filler(png_ptr, 0, PNG_FILLER_BEFORE);
+        else
+            png_set_swap_alpha(png_ptr);
+#endif  /* L_BIG_ENDIAN */
+        d = 32;
     } else {
-        cmap = NULL;
+        d = bit_depth;
     }
+    npasses = png_set_interlace_handling(png_ptr);
+    png_read_update_info(png_ptr, info_ptr);
+    rowbytes = png_get_rowbytes(png_ptr, info_ptr);
 
     if ((pix = pixCreate(w, h, d)) == NULL) {
+        pixcmapDestroy(&cmap);
         png_destroy_read_struct(&png_ptr, &info_ptr, &end_info);
         return (PIX *)ERROR_PTR("pix not made", procName, NULL);
     }
@@ -282,183 +308,94 @@ PIXCMAP     *cmap;
     data = pixGetData(pix);
     pixSetColormap(pix, cmap);
     pixSetSpp(pix, spp);
-
-    if (spp == 1 && !tRNS) {  /* copy straight from buffer to pix */
-        for (i = 0; i < h; i++) {
-            line = data + i * wpl;
-            rowptr = row_pointers[i];
-            for (j = 0; j < rowbytes; j++) {
-                    SET_DATA_BYTE(line, j, rowptr[j]);
-            }
-        }
-    } else if (spp == 2) {  /* grayscale + alpha; convert to RGBA */
-        L_INFO("converting (gray + alpha) ==> RGBA\n", procName);
-        for (i = 0; i < h; i++) {
-            ppixel = data + i * wpl;
-            rowptr = row_pointers[i];
-            for (j = k = 0; j < w; j++) {
-                    /* Copy gray value into r, g and b */
-                SET_DATA_BYTE(ppixel, COLOR_RED, rowptr[k]);
-                SET_DATA_BYTE(ppixel, COLOR_GREEN, rowptr[k]);
-                SET_DATA_BYTE(ppixel, COLOR_BLUE, rowptr[k++]);
-                SET_DATA_BYTE(ppixel, L_ALPHA_CHANNEL, rowptr[k++]);
-                ppixel++;
-            }
-        }
-        pixSetSpp(pix, 4);  /* we do not support 2 spp pix */
-    } else if (spp == 3 || spp == 4) {
-        for (i = 0; i < h; i++) {
-            ppixel = data + i * wpl;
-            rowptr = row_pointers[i];
-            for (j = k = 0; j < w; j++) {
-                SET_DATA_BYTE(ppixel, COLOR_RED, rowptr[k++]);
-                SET_DATA_BYTE(ppixel, COLOR_GREEN, rowptr[k++]);
-                SET_DATA_BYTE(ppixel, COLOR_BLUE, rowptr[k++]);
-                if (spp == 4)
-                    SET_DATA_BYTE(ppixel, L_ALPHA_CHANNEL, rowptr[k++]);
-                ppixel++;
-            }
-        }
+    if (rowbytes > 4 * wpl) {
+        pixDestroy(&pix);
+        png_destroy_read_struct(&png_ptr, &info_ptr, &end_info);
+        return (PIX *)ERROR_PTR("png row larger than pix line", procName, NULL);
     }
 
-        /* Special spp == 1 cases with transparency:
-         *    (1) 8 bpp without colormap; assume full transparency
-         *    (2) 1 bpp with colormap + trans array (for alpha)
-         *    (3) 8 bpp with colormap + trans array (for alpha)
-         * These all require converting to RGBA */
-    if (spp == 1 && tRNS) {
-        if (!cmap) {
-                /* Case 1: make fully transparent RGBA image */
-            L_INFO("transparency, 1 spp, no colormap, no transparency array: "
-                   "convention is fully transparent image\n", procName);
-            L_INFO("converting (fully transparent 1 spp) ==> RGBA\n", procName);
+        /* Gray with a transparent value: by convention, a fully
+         * transparent RGBA image.  The rows are decoded into a scratch
+         * row only to get past them. */
+    scratch = NULL;
+    if (spp == 1 && tRNS && !cmap) {
+        L_INFO("transparency, 1 spp, no colormap, no transparency array: "
+               "convention is fully transparent image\n", procName);
+        L_INFO("converting (fully transparent 1 spp) ==> RGBA\n", procName);
+        pixDestroy(&pix);
+        pix = pixCreate(w, h, 32);  /* init to alpha = 0 (transparent) */
+        scratch = (png_bytep)LEPT_CALLOC(rowbytes, 1);
+        if (!pix || !scratch) {
             pixDestroy(&pix);
-            pix = pixCreate(w, h, 32);  /* init to alpha = 0 (transparent) */
-            pixSetSpp(pix, 4);
-        } else {
-            L_INFO("converting (cmap + alpha) ==> RGBA\n", procName);
-
-                /* Grab the transparency array */
-            png_get_tRNS(png_ptr, info_ptr, &trans, &num_trans, NULL);
-            if (!trans) {  /* invalid png file */
-                pixDestroy(&pix);
-                png_destroy_read_struct(&png_ptr, &info_ptr, &end_info);
-                return (PIX *)ERROR_PTR("cmap, tRNS, but no transparency array",
-                                        procName, NULL);
-            }
-
-                /* Save the cmap and destroy the pix */
-            cmap = pixcmapCopy(pixGetColormap(pix));
-            ncolors = pixcmapGetCount(cmap);
-            pixDestroy(&pix);
-
-                /* Start over with 32 bit RGBA */
-            pix = pixCreate(w, h, 32);
-            wpl = pixGetWpl(pix);
-            data = pixGetData(pix);
-            pixSetSpp(pix, 4);
-
-#if DEBUG_READ
-            fprintf(stderr, "ncolors = %d, num_trans = %d\n",
-                    ncolors, num_trans);
-            for (i = 0; i < ncolors; i++) {
-                pixcmapGetColor(cmap, i, &rval, &gval, &bval);
-                if (i < num_trans) {
-                    fprintf(stderr, "(r,g,b,a) = (%d,%d,%d,%d)\n",
-                            rval, gval, bval, trans[i]);
-                } else {
-                    fprintf(stderr, "(r,g,b,a) = (%d,%d,%d,<<255>>)\n",
-                            rval, gval, bval);
-                }
-            }
-#endif  /* DEBUG_READ */
-
-                /* Extract the data and convert to RGBA */
-            if (d == 1) {
-                    /* Case 2: 1 bpp with transparency (usually) behind white */
-                L_INFO("converting 1 bpp cmap with alpha ==> RGBA\n", procName);
-                if (num_trans == 1)
-                    L_INFO("num_trans = 1; second color opaque by default\n",
-                           procName);
-                for (i = 0; i < h; i++) {
-                    ppixel = data + i * wpl;
-                    rowptr = row_pointers[i];
-                    for (j = 0, index = 0; j < rowbytes; j++) {
-                        byte = rowptr[j];
-                        for (k = 0; k < 8 && index < w; k++, index++) {
-                            bitval = (byte >> (7 - k)) & 1;
-                            pixcmapGetColor(cmap, bitval, &rval, &gval, &bval);
-                            composeRGBPixel(rval, gval, bval, ppixel);
-                            SET_DATA_BYTE(ppixel, L_ALPHA_CHANNEL,
-                                      bitval < num_trans ? trans[bitval] : 255);
-                            ppixel++;
-                        }
-                    }
-                }
-            } else if (d == 8) {
-                    /* Case 3: 8 bpp with cmap and associated transparency */
-                L_INFO("converting 8 bpp cmap with alpha ==> RGBA\n", procName);
-                for (i = 0; i < h; i++) {
-                    ppixel = data + i * wpl;
-                    rowptr = row_pointers[i];
-                    for (j = 0; j < w; j++) {
-                        index = rowptr[j];
-                        pixcmapGetColor(cmap, index, &rval, &gval, &bval);
-                        composeRGBPixel(rval, gval, bval, ppixel);
-                            /* Assume missing entries to be 255 (opaque)
-                             * according to the spec:
-                             * http://www.w3.org/TR/PNG/#11tRNS */
-                        SET_DATA_BYTE(ppixel, L_ALPHA_CHANNEL,
-                                      index < num_trans ? trans[index] : 255);
-                        ppixel++;
-                    }
-                }
-            } else {
-                L_ERROR("spp == 1, cmap, trans array, invalid depth: %d\n",
-                        procName, d);
-            }
-            pixcmapDestroy(&cmap);
+            LEPT_FREE(scratch);
+            png_destroy_read_struct(&png_ptr, &info_ptr, &end_info);
+            return (PIX *)ERROR_PTR("pix or row not made", procName, NULL);
         }
+        pixSetSpp(pix, 4);
+    }
+
+        /* From here on, errors must also free the pix and scratch row */
+    if (setjmp(png_jmpbuf(png_ptr))) {
+        pixDestroy(&pix);
+        LEPT_FREE(scratch);
+        png_destroy_read_struct(&png_ptr, &info_ptr, &end_info);
+        return (PIX *)ERROR_PTR("internal png error", procName, NULL);
     }
 
-#if  DEBUG_READ
-    if (cmap) {
-        for (i = 0; i < 16; i++) {
-            fprintf(stderr, "[%d] = %d\n", i,
-                   ((l_uint8 *)(cmap->array))[i]);
+        /* Decode each row into its pix line.  An interlaced image is
+         * built up in the lines over several passes, so its bytes can
+         * only be swapped at the end. */
+    for (pass = 0; pass < npasses; pass++) {
+        for (i = 0; i < h; i++) {
+            line = data + i * wpl;
+            png_read_row(png_ptr, scratch ? scratch : (png_bytep)line, NULL);
+            if (!scratch && d <= 16 && npasses == 1)
+                pngSwapLineBytes(line, wpl);
         }
     }
-#endif  /* DEBUG_READ */
+    if (!scratch && d <= 16 && npasses > 1) {
+        for (i = 0; i < h; i++)
+            pngSwapLineBytes(data + i * wpl, wpl);
+    }
+    png_read_end(png_ptr, info_ptr);
+    LEPT_FREE(scratch);
 
         /* Final adjustments for bpp = 1.
          *   + If there is no colormap, the image must be inverted because
          *     png stores black pixels as 0.
-         *   + We have already handled the case of cmapped, 1 bpp pix
-         *     with transparency, where the output pix is 32 bpp RGBA.
-         *     If there is no transparency but the pix has a colormap,
-         *     we remove the colormap, because functions operating on
-         *     1 bpp images in leptonica assume no colormap.
+         *   + The cmapped, 1 bpp pix with transparency has already been
+         *     rendered as a 32 bpp, spp = 4 rgba pix.  If there is no
+         *     transparency but the pix has a colormap, we remove the
+         *     colormap, because functions operating on 1 bpp images in
+         *     leptonica assume no colormap.
          *   + The colormap must be removed in such a way that the pixel
          *     values are not changed.  If the values are only black and
-         *     white, we return a 1 bpp image; if gray, return an 8 bpp pix;
-         *     otherwise, return a 32 bpp rgb pix.
+         *     white, we return a 1 bpp image, which is done in place; if
+         *     gray, return an 8 bpp pix; otherwise, return a 32 bpp rgb pix.
          *
-         * Note that we cannot use the PNG_TRANSFORM_INVERT_MONO flag
-         * to do the inversion, because that flag (since version 1.0.9)
-         * inverts 8 bpp grayscale as well, which we don't want to do.
+         * Note that we cannot use png_set_invert_mono() to do the
+         * inversion, because it (since version 1.0.9) inverts 8 bpp
+         * grayscale as well, which we don't want to do.
          * (It also doesn't work if there is a colormap.)
-         *
-         * Note that if the input png is a 1-bit with colormap and
-         * transparency, it has already been rendered as a 32 bpp,
-         * spp = 4 rgba pix.
          */
     if (pixGetDepth(pix) == 1) {
         if (!cmap) {
             pixInvert(pix, pix);
         } else {
-            pixt = pixRemoveColormap(pix, REMOVE_CMAP_BASED_ON_SRC);
-            pixDestroy(&pix);
-            pix = pixt;
+            pixcmapIsBlackAndWhite(cmap, &blackwhite);
+            if (blackwhite) {
+                pixcmapGetColor(cmap, 0, &rval, &gval, &bval);
+                val0 = rval + gval + bval;
+                pixcmapGetColor(cmap, 1, &rval, &gval, &bval);
+                val1 = rval + gval + bval;
+                pixDestroyColormap(pix);
+                if (val0 < val1)  /* photometrically inverted from standard */
+                    pixInvert(pix, pix);
+            } else {
+                pixt = pixRemoveColormap(pix, REMOVE_CMAP_BASED_ON_SRC);
+                pixDestroy(&pix);
+                pix = pixt;
+            }
         }
     }
 
@@ -477,6 +414,58 @@ PIXCMAP     *cmap;
 }
 
 
+/*!
+ * \brief   pngSwapLineBytes()
+ *
+ * \param[in]    line of pix data, holding png row bytes in memory order
+ * \param[in]    wpl number of 32 bit words in the line
+ * \return  void
+ *
+ * <pre>
+ * Notes:
+ *      (1) On little-endians, this reverses the bytes of each word in
+ *          place, turning the bytes of a png row into pix words.  It
+ *          does the same as pixEndianByteSwap(), a line at a time and
+ *          4 words at a time where it can, so that it can be done while
+ *          the line is still in the cache.  On big-endians it does nothing.
+ * </pre>
+ */
+static void
+pngSwapLineBytes(l_uint32  *line,
+                 l_int32    wpl)
+{
+#ifndef L_BIG_ENDIAN
+l_int32   j;
+l_uint32  word;
+
+    j = 0;
+#ifdef PNG_SSE2_SWAP
+    for (; j + 4 <= wpl; j += 4) {
+        __m128i  v;
+        v = _mm_loadu_si128((const __m128i *)(line + j));
+        v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+        v = _mm_shufflelo_epi16(v, _MM_SHUFFLE(2, 3, 0, 1));
+        v = _mm_shufflehi_epi16(v, _MM_SHUFFLE(2, 3, 0, 1));
+        _mm_storeu_si128((__m128i *)(line + j), v);
+    }
+#elif defined(PNG_NEON_SWAP)
+    for (; j + 4 <= wpl; j += 4) {
+        uint8x16_t  v;
+        v = vld1q_u8((const uint8_t *)(line + j));
+        vst1q_u8((uint8_t *)(line + j), vrev32q_u8(v));
+    }
+#endif  /* PNG_SSE2_SWAP */
+    for (; j < wpl; j++) {
+        word = line[j];
+        line[j] = (word >> 24) |
+                  ((word >> 8) & 0x0000ff00) |
+                  ((word << 8) & 0x00ff0000) |
+                  (word << 24);
+    }
+#endif  /* ~L_BIG_ENDIAN */
+}
+
+
 /*!
  * \brief   readHeaderPng()
  *
@@ -35,6 +35,8 @@
  *
  *      Low level src and dest
  *           void            rasteropLow()
+ *           static void     rasteropBlitLow()
+ *           static void     rasteropVectorLow()
  *           static void     rasteropWordAlignedLow()
  *           static void     rasteropVAlignedLow()
  *           static void     rasteropGeneralLow()
@@ -45,8 +47,21 @@
 #include <string.h>
 #include "allheaders.h"
 
+    /* The vector code works on whole 32-bit words, so it does not
+     * depend on byte order. */
+#if defined(__SSE2__)
+#define  ROP_SSE2     1
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define  ROP_NEON     1
+#include <arm_neon.h>
+#endif
+
 #define COMBINE_PARTIAL(d, s, m)     ( ((d) & ~(m)) | ((s) & (m)) )
 
+    /* Minimum number of full dest words in a row for the vector path */
+static const l_int32  MIN_VECTOR_WORDS = 4;
+
 static const l_int32  SHIFT_LEFT  = 0;
 static const l_int32  SHIFT_RIGHT = 1;
 
@@ -58,6 +73,18 @@ static void rasteropUniGeneralLow(l_uint32 *datad, l_int32 dwpl, l_int32 dx,
                                   l_int32 dy, l_int32 dw, l_int32  dh,
                                   l_int32 op);
 
+static void rasteropBlitLow(l_uint32 *datad, l_int32 dwpl, l_int32 dx,
+                            l_int32 dy, l_int32 dw, l_int32 dh,
+                            l_int32 op, l_uint32 *datas, l_int32 swpl,
+                            l_int32 sx, l_int32 sy);
+
+#if ROP_SSE2 || ROP_NEON
+static void rasteropVectorLow(l_uint32 *datad, l_int32 dwpl, l_int32 dx,
+                              l_int32 dy, l_int32 dw, l_int32 dh,
+                              l_int32 op, l_uint32 *datas, l_int32 swpl,
+                              l_int32 sx, l_int32 sy);
+#endif  /* ROP_SSE2 || ROP_NEON */
+
 static void rasteropWordAlignedLow(l_uint32 *datad, l_int32 dwpl, l_int32 dx,
                                    l_int32 dy, l_int32 dw, l_int32 dh,
                                    l_int32 op, l_uint32 *datas, l_int32 swpl,
@@ -553,9 +580,68 @@ l_int32  dhangw, shangw, dhangh, shangh;
     if ((dw <= 0) || (dh <= 0))
         return;
 
+#if ROP_SSE2 || ROP_NEON
    /* -------------------------------------------------------*
-    *       dispatch to aligned or non-aligned blitters
+    *   with SSE2 or NEON, do the full dest words of each row
+    *   with vector code, and blit the partial words at the
+    *   two ends.  Only ops that use the src are handled here,
+    *   and in-place ops keep the word-by-word order.
     * -------------------------------------------------------*/
+    if (datas != datad && (op & ~0xf) == 0 && ((op ^ (op >> 2)) & 3)) {
+        l_int32  dxa, dxb;  /* first and last + 1 column of full words */
+        dxa = (dx + 31) & ~31;
+        dxb = (dx + dw) & ~31;
+        if (dxb - dxa >= 32 * MIN_VECTOR_WORDS) {
+            rasteropVectorLow(datad, dwpl, dxa, dy, dxb - dxa, dh, op,
+                              datas, swpl, sx + dxa - dx, sy);
+            if (dxa > dx)
+                rasteropBlitLow(datad, dwpl, dx, dy, dxa - dx, dh, op,
+                                datas, swpl, sx, sy);
+            if (dx + dw > dxb)
+                rasteropBlitLow(datad, dwpl, dxb, dy, dx + dw - dxb, dh, op,
+                                datas, swpl, sx + dxb - dx, sy);
+            return;
+        }
+    }
+#endif  /* ROP_SSE2 || ROP_NEON */
+
+    rasteropBlitLow(datad, dwpl, dx, dy, dw, dh, op, datas, swpl, sx, sy);
+    return;
+}
+
+
+/*!
+ * \brief   rasteropBlitLow()
+ *
+ * \param[in]    datad  ptr to dest image data
+ * \param[in]    dwpl   wpl of dest
+ * \param[in]    dx     x val of UL corner of dest rectangle
+ * \param[in]    dy     y val of UL corner of dest rectangle
+ * \param[in]    dw     width of dest rectangle
+ * \param[in]    dh     height of dest rectangle
+ * \param[in]    op     op code
+ * \param[in]    datas  ptr to src image data
+ * \param[in]    swpl   wpl of src
+ * \param[in]    sx     x val of UL corner of src rectangle
+ * \param[in]    sy     y val of UL corner of src rectangle
+ * \return  void
+ *
+ *  Action: dispatches a clipped rasterop, with all horizontal
+ *          dimensions in bits, to the aligned or non-aligned blitters.
+ */
+static void
+rasteropBlitLow(l_uint32  *datad,
+                l_int32    dwpl,
+                l_int32    dx,
+                l_int32    dy,
+                l_int32    dw,
+                l_int32    dh,
+                l_int32    op,
+                l_uint32  *datas,
+                l_int32    swpl,
+                l_int32    sx,
+                l_int32    sy)
+{
     if (((dx & 31) == 0) && ((sx & 31) == 0))
         rasteropWordAlignedLow(datad, dwpl, dx, dy, dw, dh, op,
                                datas, swpl, sx, sy);
@@ -565,9 +651,131 @@ l_int32  dhangw, shangw, dhangh, shangh;
     else
         rasteropGeneralLow(datad, dwpl, dx, dy, dw, dh, op,
                            datas, swpl, sx, sy);
+    return;
+}
+
+
+#if ROP_SSE2 || ROP_NEON
+/*--------------------------------------------------------------------*
+ *          Static low-level rasterop on full words with SIMD         *
+ *--------------------------------------------------------------------*/
+/*!
+ * \brief   rasteropVectorLow()
+ *
+ * \param[in]    datad  ptr to dest image data
+ * \param[in]    dwpl   wpl of dest
+ * \param[in]    dx     x val of UL corner of dest rectangle
+ * \param[in]    dy     y val of UL corner of dest rectangle
+ * \param[in]    dw     width of dest rectangle
+ * \param[in]    dh     height of dest rectangle
+ * \param[in]    op     op code
+ * \param[in]    datas  ptr to src image data
+ * \param[in]    swpl   wpl of src
+ * \param[in]    sx     x val of UL corner of src rectangle
+ * \param[in]    sy     y val of UL corner of src rectangle
+ * \return  void
+ *
+ *  This is called with dx & 31 == 0 and dw & 31 == 0, so that
+ *  every dest word is written in full.  The src can have any
+ *  alignment: with shift = sx & 31, each src word is made from
+ *  two adjacent words, as in rasteropGeneralLow(), and the vector
+ *  shifts cover both the aligned and the unaligned cases.
+ *
+ *  Instead of a loop for each op, the op code is used as the
+ *  truth table that it is.  Written as an XOR of ANDs,
+ *      d = c0 ^ (cs & s) ^ (cd & d) ^ (csd & s & d)
+ *  where each coefficient is either all 0s or all 1s.
+ */
+static void
+rasteropVectorLow(l_uint32  *datad,
+                  l_int32    dwpl,
+                  l_int32    dx,
+                  l_int32    dy,
+                  l_int32    dw,
+                  l_int32    dh,
+                  l_int32    op,
+                  l_uint32  *datas,
+                  l_int32    swpl,
+                  l_int32    sx,
+                  l_int32    sy)
+{
+l_int32    nw, shift, rshift, i, j;
+l_uint32   c0, cs, cd, csd, sword;
+l_uint32  *lines, *lined;
+#if ROP_SSE2
+__m128i    vc0, vcs, vcd, vcsd, vlshift, vrshift, vs, vd;
+#else
+uint32x4_t vc0, vcs, vcd, vcsd, vs, vd;
+int32x4_t  vlshift, vrshift;
+#endif  /* ROP_SSE2 */
+
+    nw = dw >> 5;
+    shift = sx & 31;
+    rshift = 32 - shift;
+
+        /* Bit 0 of op is the result for s = 0, d = 0; bit 1 for
+         * s = 0, d = 1; bit 2 for s = 1, d = 0; bit 3 for s = d = 1 */
+    c0 = (op & 1) ? 0xffffffff : 0;
+    cs = ((op ^ (op >> 2)) & 1) ? 0xffffffff : 0;
+    cd = ((op ^ (op >> 1)) & 1) ? 0xffffffff : 0;
+    csd = ((op ^ (op >> 1) ^ (op >> 2) ^ (op >> 3)) & 1) ? 0xffffffff : 0;
+#if ROP_SSE2
+    vc0 = _mm_set1_epi32((int)c0);
+    vcs = _mm_set1_epi32((int)cs);
+    vcd = _mm_set1_epi32((int)cd);
+    vcsd = _mm_set1_epi32((int)csd);
+    vlshift = _mm_cvtsi32_si128(shift);
+    vrshift = _mm_cvtsi32_si128(rshift);
+#else
+    vc0 = vdupq_n_u32(c0);
+    vcs = vdupq_n_u32(cs);
+    vcd = vdupq_n_u32(cd);
+    vcsd = vdupq_n_u32(csd);
+    vlshift = vdupq_n_s32(shift);
+    vrshift = vdupq_n_s32(-rshift);  /* negative count shifts right */
+#endif  /* ROP_SSE2 */
+
+    for (i = 0; i < dh; i++) {
+        lines = datas + (sy + i) * swpl + (sx >> 5);
+        lined = datad + (dy + i) * dwpl + (dx >> 5);
+        j = 0;
+#if ROP_SSE2
+        for (; j + 4 <= nw; j += 4) {
+            vs = _mm_loadu_si128((const __m128i *)(lines + j));
+            if (shift) {
+                vd = _mm_loadu_si128((const __m128i *)(lines + j + 1));
+                vs = _mm_or_si128(_mm_sll_epi32(vs, vlshift),
+                                  _mm_srl_epi32(vd, vrshift));
+            }
+            vd = _mm_loadu_si128((const __m128i *)(lined + j));
+            vd = _mm_and_si128(vd, _mm_xor_si128(vcd, _mm_and_si128(vcsd, vs)));
+            vd = _mm_xor_si128(_mm_xor_si128(vc0, _mm_and_si128(vcs, vs)), vd);
+            _mm_storeu_si128((__m128i *)(lined + j), vd);
+        }
+#else
+        for (; j + 4 <= nw; j += 4) {
+            vs = vld1q_u32(lines + j);
+            if (shift) {
+                vs = vorrq_u32(vshlq_u32(vs, vlshift),
+                               vshlq_u32(vld1q_u32(lines + j + 1), vrshift));
+            }
+            vd = vld1q_u32(lined + j);
+            vd = vandq_u32(vd, veorq_u32(vcd, vandq_u32(vcsd, vs)));
+            vd = veorq_u32(veorq_u32(vc0, vandq_u32(vcs, vs)), vd);
+            vst1q_u32(lined + j, vd);
+        }
+#endif  /* ROP_SSE2 */
+        for (; j < nw; j++) {
+            sword = lines[j];
+            if (shift)
+                sword = (sword << shift) | (lines[j + 1] >> rshift);
+            lined[j] = c0 ^ (cs & sword) ^ (lined[j] & (cd ^ (csd & sword)));
+        }
+    }
 
     return;
 }
+#endif  /* ROP_SSE2 || ROP_NEON */
 
 
 /*--------------------------------------------------------------------*
@@ -36,6 +36,11 @@
  *
  *      90-degree rotation (both directions)
  *            PIX             *pixRotate90()
+ *            static void      rotate90Tiled()
+ *            static void      rotateTile8()
+ *            static void      rotateTile32()
+ *            static void      rotate90Low1()
+ *            static void      transposeBits32()
  *
  *      Left-right flip
  *            PIX             *pixFlipLR()
@@ -53,6 +58,32 @@
 #include <string.h>
 #include "allheaders.h"
 
+    /* Vector tile transposes, on little-endian hosts */
+#ifndef L_BIG_ENDIAN
+#if defined(__SSE2__)
+#define  ROTATE_SSE2   1
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define  ROTATE_NEON   1
+#include <arm_neon.h>
+#endif
+#endif  /* ~L_BIG_ENDIAN */
+
+    /* Width in pixels of the strips of pixd that are filled tile by
+     * tile, so that each line of a strip is a whole cache line */
+static const l_int32  ROTATE_STRIP_BYTES = 64;
+
+static void rotate90Tiled(l_uint32 *datad, l_int32 wd, l_int32 hd,
+                          l_int32 wpld, l_uint32 *datas, l_int32 wpls,
+                          l_int32 d, l_int32 direction);
+static void rotateTile8(l_uint32 *lines, l_int32 sstep, l_uint32 *lined,
+                        l_int32 dstep);
+static void rotateTile32(l_uint32 *lines, l_int32 sstep, l_uint32 *lined,
+                         l_int32 dstep);
+static void rotate90Low1(l_uint32 *datad, l_int32 wd, l_int32 hd,
+                         l_int32 wpld, l_uint32 *datas, l_int32 wpls,
+                         l_int32 direction);
+static void transposeBits32(l_uint32 *a);
 static l_uint8 *makeReverseByteTab1(void);
 static l_uint8 *makeReverseByteTab2(void);
 static l_uint8 *makeReverseByteTab4(void);
@@ -157,6 +188,12 @@ l_int32  d;
  *      (1) This does a 90 degree rotation of the image about the center,
  *          either cw or ccw, returning a new pix.
  *      (2) The direction must be either 1 (cw) or -1 (ccw).
+ *      (3) For 1, 8 and 32 bpp the image is moved in small square tiles,
+ *          which are transposed in registers: 32x32 bits, 8x8 bytes and
+ *          4x4 words, respectively.  The tiles are visited in strips of
+ *          pixd that are a cache line wide, so each line of pixs and
+ *          of pixd is read or written a cache line at a time rather
+ *          than a pixel at a time.
  * </pre>
  */
 PIX *
@@ -164,8 +201,8 @@ pixRotate90(PIX     *pixs,
             l_int32  direction)
 {
 l_int32    wd, hd, d, wpls, wpld;
-l_int32    i, j, k, m, iend, nswords;
-l_uint32   val, word;
+l_int32    i, j;
+l_uint32   val;
 l_uint32  *lines, *datas, *lined, *datad;
 PIX       *pixd;
 
@@ -191,19 +228,17 @@ PIX       *pixd;
     datad = pixGetData(pixd);
     wpld = pixGetWpl(pixd);
 
+    if (d == 1) {
+        rotate90Low1(datad, wd, hd, wpld, datas, wpls, direction);
+        return pixd;
+    } else if (d == 8 || d == 32) {
+        rotate90Tiled(datad, wd, hd, wpld, datas, wpls, d, direction);
+        return pixd;
+    }
+
     if (direction == 1) {  /* clockwise */
         switch (d)
         {
-            case 32:
-                for (i = 0; i < hd; i++) {
-                    lined = datad + i * wpld;
-                    lines = datas + (wd - 1) * wpls;
-                    for (j = 0; j < wd; j++) {
-                        lined[j] = lines[i];
-                        lines -= wpls;
-                    }
-                }
-                break;
             case 16:
                 for (i = 0; i < hd; i++) {
                     lined = datad + i * wpld;
@@ -215,17 +250,6 @@ PIX       *pixd;
                     }
                 }
                 break;
-            case 8:
-                for (i = 0; i < hd; i++) {
-                    lined = datad + i * wpld;
-                    lines = datas + (wd - 1) * wpls;
-                    for (j = 0; j < wd; j++) {
-                        if ((val = GET_DATA_BYTE(lines, i)))
-                            SET_DATA_BYTE(lined, j, val);
-                        lines -= wpls;
-                    }
-                }
-                break;
             case 4:
                 for (i = 0; i < hd; i++) {
                     lined = datad + i * wpld;
@@ -248,32 +272,6 @@ PIX       *pixd;
                     }
                 }
                 break;
-            case 1:
-                nswords = hd / 32;
-                for (j = 0; j < wd; j++) {
-                    lined = datad;
-                    lines = datas + (wd - 1 - j) * wpls;
-                    for (k = 0; k < nswords; k++) {
-                        word = lines[k];
-                        if (!word) {
-                            lined += 32 * wpld;
-                            continue;
-                        } else {
-                            iend = 32 * (k + 1);
-                            for (m = 0, i = 32 * k; i < iend; i++, m++) {
-                                if ((word << m) & 0x80000000)
-                                    SET_DATA_BIT(lined, j);
-                                lined += wpld;
-                            }
-                        }
-                    }
-                    for (i = 32 * nswords; i < hd; i++) {
-                        if (GET_DATA_BIT(lines, i))
-                            SET_DATA_BIT(lined, j);
-                        lined += wpld;
-                    }
-                }
-                break;
             default:
                 pixDestroy(&pixd);
                 L_ERROR("illegal depth: %d\n", procName, d);
@@ -282,16 +280,6 @@ PIX       *pixd;
     } else  {     /* direction counter-clockwise */
         switch (d)
         {
-            case 32:
-                for (i = 0; i < hd; i++) {
-                    lined = datad + i * wpld;
-                    lines = datas;
-                    for (j = 0; j < wd; j++) {
-                        lined[j] = lines[hd - 1 - i];
-                        lines += wpls;
-                    }
-                }
-                break;
             case 16:
                 for (i = 0; i < hd; i++) {
                     lined = datad + i * wpld;
@@ -303,17 +291,6 @@ PIX       *pixd;
                     }
                 }
                 break;
-            case 8:
-                for (i = 0; i < hd; i++) {
-                    lined = datad + i * wpld;
-                    lines = datas;
-                    for (j = 0; j < wd; j++) {
-                        if ((val = GET_DATA_BYTE(lines, hd - 1 - i)))
-                            SET_DATA_BYTE(lined, j, val);
-                        lines += wpls;
-                    }
-                }
-                break;
             case 4:
                 for (i = 0; i < hd; i++) {
                     lined = datad + i * wpld;
@@ -336,32 +313,6 @@ PIX       *pixd;
                     }
                 }
                 break;
-            case 1:
-                nswords = hd / 32;
-                for (j = 0; j < wd; j++) {
-                    lined = datad + (hd - 1) * wpld;
-                    lines = datas + (wd - 1 - j) * wpls;
-                    for (k = 0; k < nswords; k++) {
-                        word = lines[k];
-                        if (!word) {
-                            lined -= 32 * wpld;
-                            continue;
-                        } else {
-                            iend = 32 * (k + 1);
-                            for (m = 0, i = 32 * k; i < iend; i++, m++) {
-                                if ((word << m) & 0x80000000)
-                                    SET_DATA_BIT(lined, wd - 1 - j);
-                                lined -= wpld;
-                            }
-                        }
-                    }
-                    for (i = 32 * nswords; i < hd; i++) {
-                        if (GET_DATA_BIT(lines, i))
-                            SET_DATA_BIT(lined, wd - 1 - j);
-                        lined -= wpld;
-                    }
-                }
-                break;
             default:
                 pixDestroy(&pixd);
                 L_ERROR("illegal depth: %d\n", procName, d);
@@ -373,6 +324,370 @@ PIX       *pixd;
 }
 
 
+/*!
+ * \brief   rotate90Tiled()
+ *
+ * \param[in]    datad  data of pixd, which is 0
+ * \param[in]    wd, hd, wpld  size of pixd
+ * \param[in]    datas, wpls   pixs, which is hd wide and wd high
+ * \param[in]    d             8 or 32 bpp
+ * \param[in]    direction     1 = clockwise,  -1 = counter-clockwise
+ * \return  void
+ *
+ * <pre>
+ * Notes:
+ *      (1) A tile of pixs, 8x8 pixels at 8 bpp or 4x4 at 32 bpp, starting
+ *          at column y of pixs, goes to the tile at column x of pixd.
+ *          Going clockwise, the lines of the tile are read from the
+ *          bottom up and line y + k of pixd gets column y + k of pixs;
+ *          going counter-clockwise, the lines are read from the top
+ *          down and line hd - 1 - y - k gets column y + k.
+ *      (2) The pixels of pixd that are not in whole tiles, at the
+ *          right side and at the bottom (cw) or top (ccw), are then
+ *          copied one at a time.
+ * </pre>
+ */
+static void
+rotate90Tiled(l_uint32  *datad,
+              l_int32    wd,
+              l_int32    hd,
+              l_int32    wpld,
+              l_uint32  *datas,
+              l_int32    wpls,
+              l_int32    d,
+              l_int32    direction)
+{
+l_int32    tile, wtile, htile, strip, xs, xsend, x, y, i, j, c;
+l_int32    sstep, dstep;
+l_uint32  *lines, *lined;
+
+    tile = (d == 8) ? 8 : 4;
+    wtile = wd - (wd % tile);  /* columns of pixd in whole tiles */
+    htile = hd - (hd % tile);  /* columns of pixs in whole tiles */
+    strip = 8 * ROTATE_STRIP_BYTES / d;
+
+    for (xs = 0; xs < wtile; xs += strip) {
+        xsend = L_MIN(xs + strip, wtile);
+        for (y = 0; y < htile; y += tile) {
+            for (x = xs; x < xsend; x += tile) {
+                if (direction == 1) {
+                    lines = datas + (wd - 1 - x) * wpls + y * d / 32;
+                    lined = datad + y * wpld + x * d / 32;
+                    sstep = -wpls;
+                    dstep = wpld;
+                } else {
+                    lines = datas + x * wpls + y * d / 32;
+                    lined = datad + (hd - 1 - y) * wpld + x * d / 32;
+                    sstep = wpls;
+                    dstep = -wpld;
+                }
+                if (d == 8)
+                    rotateTile8(lines, sstep, lined, dstep);
+                else
+                    rotateTile32(lines, sstep, lined, dstep);
+            }
+        }
+    }
+
+        /* Pixels that are not in whole tiles */
+    for (i = 0; i < hd; i++) {
+        lined = datad + i * wpld;
+        c = (direction == 1) ? i : hd - 1 - i;  /* column of pixs */
+        for (j = (c < htile) ? wtile : 0; j < wd; j++) {
+            lines = datas + ((direction == 1) ? wd - 1 - j : j) * wpls;
+            if (d == 8)
+                SET_DATA_BYTE(lined, j, GET_DATA_BYTE(lines, c));
+            else
+                lined[j] = lines[c];
+        }
+    }
+}
+
+
+/*!
+ * \brief   rotateTile8()
+ *
+ * \param[in]    lines  first line of an 8x8 tile of 8 bpp pixs
+ * \param[in]    sstep  words from each line of the tile to the next
+ * \param[in]    lined  line of pixd that gets the first column
+ * \param[in]    dstep  words from each line of pixd to the next
+ * \return  void
+ *
+ * <pre>
+ * Notes:
+ *      (1) Pixel m of line k of pixd is set to pixel k of line m of
+ *          the tile.  The tile and the lines of pixd are word aligned.
+ *      (2) The vector versions load each line of the tile as 8 bytes,
+ *          reverse the bytes of each word to put the pixels in order,
+ *          and transpose with three rounds of interleaving.  Without
+ *          them, each 4x4 block of pixels is transposed within four
+ *          words using shifts and masks, independent of byte order.
+ * </pre>
+ */
+static void
+rotateTile8(l_uint32  *lines,
+            l_int32    sstep,
+            l_uint32  *lined,
+            l_int32    dstep)
+{
+#if defined(ROTATE_SSE2)
+l_int32  m, q;
+__m128i  r[8], a[4], b[4], c;
+
+    for (m = 0; m < 8; m++) {
+        r[m] = _mm_loadl_epi64((const __m128i *)(lines + m * sstep));
+        r[m] = _mm_or_si128(_mm_slli_epi16(r[m], 8), _mm_srli_epi16(r[m], 8));
+        r[m] = _mm_shufflelo_epi16(r[m], _MM_SHUFFLE(2, 3, 0, 1));
+    }
+    for (m = 0; m < 4; m++)  /* pairs of lines, pixel by pixel */
+        a[m] = _mm_unpacklo_epi8(r[2 * m], r[2 * m + 1]);
+    b[0] = _mm_unpacklo_epi16(a[0], a[1]);  /* lines 0-3, pixels 0-3 */
+    b[1] = _mm_unpackhi_epi16(a[0], a[1]);  /* lines 0-3, pixels 4-7 */
+    b[2] = _mm_unpacklo_epi16(a[2], a[3]);  /* lines 4-7, pixels 0-3 */
+    b[3] = _mm_unpackhi_epi16(a[2], a[3]);  /* lines 4-7, pixels 4-7 */
+    for (q = 0; q < 4; q++) {  /* columns 2q and 2q + 1 */
+        if (q < 2)
+            c = (q == 0) ? _mm_unpacklo_epi32(b[0], b[2])
+                         : _mm_unpackhi_epi32(b[0], b[2]);
+        else
+            c = (q == 2) ? _mm_unpacklo_epi32(b[1], b[3])
+                         : _mm_unpackhi_epi32(b[1], b[3]);
+        c = _mm_or_si128(_mm_slli_epi16(c, 8), _mm_srli_epi16(c, 8));
+        c = _mm_shufflelo_epi16(c, _MM_SHUFFLE(2, 3, 0, 1));
+        c = _mm_shufflehi_epi16(c, _MM_SHUFFLE(2, 3, 0, 1));
+        _mm_storel_epi64((__m128i *)(lined + 2 * q * dstep), c);
+        _mm_storel_epi64((__m128i *)(lined + (2 * q + 1) * dstep),
+                         _mm_unpackhi_epi64(c, c));
+    }
+#elif defined(ROTATE_NEON)
+l_int32      m;
+uint8x8_t    r[8];
+uint8x8x2_t  t01, t23, t45, t67;
+uint16x4x2_t u02, u13, u46, u57;
+uint32x2x2_t v04, v15, v26, v37;
+
+    for (m = 0; m < 8; m++)
+        r[m] = vrev32_u8(vld1_u8((const uint8_t *)(lines + m * sstep)));
+    t01 = vtrn_u8(r[0], r[1]);
+    t23 = vtrn_u8(r[2], r[3]);
+    t45 = vtrn_u8(r[4], r[5]);
+    t67 = vtrn_u8(r[6], r[7]);
+    u02 = vtrn_u16(vreinterpret_u16_u8(t01.val[0]),
+                   vreinterpret_u16_u8(t23.val[0]));
+    u13 = vtrn_u16(vreinterpret_u16_u8(t01.val[1]),
+                   vreinterpret_u16_u8(t23.val[1]));
+    u46 = vtrn_u16(vreinterpret_u16_u8(t45.val[0]),
+                   vreinterpret_u16_u8(t67.val[0]));
+    u57 = vtrn_u16(vreinterpret_u16_u8(t45.val[1]),
+                   vreinterpret_u16_u8(t67.val[1]));
+    v04 = vtrn_u32(vreinterpret_u32_u16(u02.val[0]),
+                   vreinterpret_u32_u16(u46.val[0]));
+    v15 = vtrn_u32(vreinterpret_u32_u16(u13.val[0]),
+                   vreinterpret_u32_u16(u57.val[0]));
+    v26 = vtrn_u32(vreinterpret_u32_u16(u02.val[1]),
+                   vreinterpret_u32_u16(u46.val[1]));
+    v37 = vtrn_u32(vreinterpret_u32_u16(u13.val[1]),
+                   vreinterpret_u32_u16(u57.val[1]));
+    vst1_u8((uint8_t *)lined,
+            vrev32_u8(vreinterpret_u8_u32(v04.val[0])));
+    vst1_u8((uint8_t *)(lined + dstep),
+            vrev32_u8(vreinterpret_u8_u32(v15.val[0])));
+    vst1_u8((uint8_t *)(lined + 2 * dstep),
+            vrev32_u8(vreinterpret_u8_u32(v26.val[0])));
+    vst1_u8((uint8_t *)(lined + 3 * dstep),
+            vrev32_u8(vreinterpret_u8_u32(v37.val[0])));
+    vst1_u8((uint8_t *)(lined + 4 * dstep),
+            vrev32_u8(vreinterpret_u8_u32(v04.val[1])));
+    vst1_u8((uint8_t *)(lined + 5 * dstep),
+            vrev32_u8(vreinterpret_u8_u32(v15.val[1])));
+    vst1_u8((uint8_t *)(lined + 6 * dstep),
+            vrev32_u8(vreinterpret_u8_u32(v26.val[1])));
+    vst1_u8((uint8_t *)(lined + 7 * dstep),
+            vrev32_u8(vreinterpret_u8_u32(v37.val[1])));
+#else
+l_int32   q, g;
+l_uint32  r0, r1, r2, r3, t0, t1, t2, t3;
+l_uint32 *line;
+
+    for (q = 0; q < 2; q++) {  /* word of each line of the tile */
+        for (g = 0; g < 2; g++) {  /* group of 4 lines; word of pixd */
+            line = lines + 4 * g * sstep + q;
+            r0 = line[0];
+            r1 = line[sstep];
+            r2 = line[2 * sstep];
+            r3 = line[3 * sstep];
+            t0 = (r0 & 0xff00ff00) | ((r1 >> 8) & 0x00ff00ff);
+            t1 = ((r0 << 8) & 0xff00ff00) | (r1 & 0x00ff00ff);
+            t2 = (r2 & 0xff00ff00) | ((r3 >> 8) & 0x00ff00ff);
+            t3 = ((r2 << 8) & 0xff00ff00) | (r3 & 0x00ff00ff);
+            line = lined + 4 * q * dstep + g;
+            line[0] = (t0 & 0xffff0000) | (t2 >> 16);
+            line[dstep] = (t1 & 0xffff0000) | (t3 >> 16);
+            line[2 * dstep] = (t0 << 16) | (t2 & 0x0000ffff);
+            line[3 * dstep] = (t1 << 16) | (t3 & 0x0000ffff);
+        }
+    }
+#endif  /* ROTATE_SSE2 */
+}
+
+
+/*!
+ * \brief   rotateTile32()
+ *
+ * \param[in]    lines  first line of a 4x4 tile of 32 bpp pixs
+ * \param[in]    sstep  words from each line of the tile to the next
+ * \param[in]    lined  line of pixd that gets the first column
+ * \param[in]    dstep  words from each line of pixd to the next
+ * \return  void
+ *
+ * <pre>
+ * Notes:
+ *      (1) Pixel m of line k of pixd is set to pixel k of line m of
+ *          the tile.
+ * </pre>
+ */
+static void
+rotateTile32(l_uint32  *lines,
+             l_int32    sstep,
+             l_uint32  *lined,
+             l_int32    dstep)
+{
+#if defined(ROTATE_SSE2)
+__m128i  r0, r1, r2, r3, t0, t1, t2, t3;
+
+    r0 = _mm_loadu_si128((const __m128i *)lines);
+    r1 = _mm_loadu_si128((const __m128i *)(lines + sstep));
+    r2 = _mm_loadu_si128((const __m128i *)(lines + 2 * sstep));
+    r3 = _mm_loadu_si128((const __m128i *)(lines + 3 * sstep));
+    t0 = _mm_unpacklo_epi32(r0, r1);
+    t1 = _mm_unpacklo_epi32(r2, r3);
+    t2 = _mm_unpackhi_epi32(r0, r1);
+    t3 = _mm_unpackhi_epi32(r2, r3);
+    _mm_storeu_si128((__m128i *)lined, _mm_unpacklo_epi64(t0, t1));
+    _mm_storeu_si128((__m128i *)(lined + dstep), _mm_unpackhi_epi64(t0, t1));
+    _mm_storeu_si128((__m128i *)(lined + 2 * dstep),
+                     _mm_unpacklo_epi64(t2, t3));
+    _mm_storeu_si128((__m128i *)(lined + 3 * dstep),
+                     _mm_unpackhi_epi64(t2, t3));
+#elif defined(ROTATE_NEON)
+uint32x4x2_t  t01, t23;
+
+    t01 = vtrnq_u32(vld1q_u32(lines), vld1q_u32(lines + sstep));
+    t23 = vtrnq_u32(vld1q_u32(lines + 2 * sstep),
+                    vld1q_u32(lines + 3 * sstep));
+    vst1q_u32(lined, vcombine_u32(vget_low_u32(t01.val[0]),
+                                  vget_low_u32(t23.val[0])));
+    vst1q_u32(lined + dstep, vcombine_u32(vget_low_u32(t01.val[1]),
+                                          vget_low_u32(t23.val[1])));
+    vst1q_u32(lined + 2 * dstep, vcombine_u32(vget_high_u32(t01.val[0]),
+                                              vget_high_u32(t23.val[0])));
+    vst1q_u32(lined + 3 * dstep, vcombine_u32(vget_high_u32(t01.val[1]),
+                                              vget_high_u32(t23.val[1])));
+#else
+l_int32  k, m;
+
+    for (k = 0; k < 4; k++) {
+        for (m = 0; m < 4; m++)
+            lined[k * dstep + m] = lines[m * sstep + k];
+    }
+#endif  /* ROTATE_SSE2 */
+}
+
+
+/*!
+ * \brief   rotate90Low1()
+ *
+ * \param[in]    datad  data of pixd, which is 0
+ * \param[in]    wd, hd, wpld  size of pixd
+ * \param[in]    datas, wpls   pixs, which is hd wide and wd high
+ * \param[in]    direction     1 = clockwise,  -1 = counter-clockwise
+ * \return  void
+ *
+ * <pre>
+ * Notes:
+ *      (1) Word x of pixd is made from the same word of the 32 lines
+ *          of pixs that go to its pixels, by a 32x32 bit transpose.
+ *          Lines of pixs beyond its height give 0; columns beyond
+ *          its width, which are pad bits, are not written to pixd.
+ *      (2) Tiles that are all 0 are skipped, since pixd starts out 0.
+ * </pre>
+ */
+static void
+rotate90Low1(l_uint32  *datad,
+             l_int32    wd,
+             l_int32    hd,
+             l_int32    wpld,
+             l_uint32  *datas,
+             l_int32    wpls,
+             l_int32    direction)
+{
+l_int32   nwords, strip, xs, xsend, xw, cw, c, m, k, x;
+l_uint32  any;
+l_uint32  a[32];
+
+    nwords = (hd + 31) / 32;  /* words of pixs that hold pixels */
+    strip = ROTATE_STRIP_BYTES / 4;
+    for (xs = 0; xs < wpld; xs += strip) {
+        xsend = L_MIN(xs + strip, wpld);
+        for (cw = 0; cw < nwords; cw++) {
+            for (xw = xs; xw < xsend; xw++) {
+                any = 0;
+                for (m = 0; m < 32; m++) {
+                    x = 32 * xw + m;
+                    if (x < wd)
+                        a[m] = datas[((direction == 1) ? wd - 1 - x : x) *
+                                     wpls + cw];
+                    else
+                        a[m] = 0;
+                    any |= a[m];
+                }
+                if (!any)
+                    continue;
+                transposeBits32(a);
+                for (k = 0; k < 32; k++) {
+                    if ((c = 32 * cw + k) >= hd)  /* column of pixs */
+                        break;
+                    datad[((direction == 1) ? c : hd - 1 - c) * wpld + xw] =
+                        a[k];
+                }
+            }
+        }
+    }
+}
+
+
+/*!
+ * \brief   transposeBits32()
+ *
+ * \param[in]    a  32 words, each a line of 32 1 bpp pixels
+ * \return  void
+ *
+ * <pre>
+ * Notes:
+ *      (1) This transposes the 32x32 bit matrix in place, so that
+ *          pixel m of word k becomes pixel k of word m.  It swaps
+ *          the off-diagonal 16x16 blocks, then the 8x8 blocks within
+ *          them, and so on down to single bits, with shifts and
+ *          masks (from Hacker's Delight, section 7-3).
+ * </pre>
+ */
+static void
+transposeBits32(l_uint32  *a)
+{
+l_int32   j, k;
+l_uint32  m, t;
+
+    m = 0x0000ffff;
+    for (j = 16; j != 0; j >>= 1, m ^= (m << j)) {
+        for (k = 0; k < 32; k = (k + j + 1) & ~j) {
+            t = (a[k] ^ (a[k + j] >> j)) & m;
+            a[k] ^= t;
+            a[k + j] ^= (t << j);
+        }
+    }
+}
+
+
 /*------------------------------------------------------------------*
  *                            Left-right flip                       *
  *------------------------------------------------------------------*/
@@ -400,13 +715,15 @@ PIX       *pixd;
  *      (4) If an existing pixd is not the same size as pixs, the
  *          image data will be reallocated.
  *      (5) The pixel access routines allow a trivial implementation.
- *          However, for d \< 8, it is more efficient to right-justify
+ *          However, for d \< 32, it is more efficient to right-justify
  *          each line to a 32-bit boundary and then extract bytes and
  *          do pixel reversing.   In those cases, as in the 180 degree
  *          rotation, we right-shift the data (if necessary) to
  *          right-justify on the 32 bit boundary, and then read the
  *          bytes off each raster line in reverse order, reversing
- *          the pixels in each byte using a table.  These functions
+ *          the pixels in each byte using a table.  For 8 and 16 bpp,
+ *          whole words are read in reverse order and the bytes or
+ *          halfwords in each word are swapped.  These functions
  *          for 1, 2 and 4 bpp were tested against the "trivial"
  *          version (shown here for 4 bpp):
  *              for (i = 0; i \< h; i++) {
@@ -476,22 +793,39 @@ l_uint32  *line, *data, *buffer;
             }
             break;
         case 16:
+            extra = (w * d) & 31;
+            if (extra)
+                shift = 2 - extra / 16;
+            else
+                shift = 0;
+            if (shift)
+                rasteropHipLow(data, h, d, wpl, 0, h, shift);
+
             for (i = 0; i < h; i++) {
                 line = data + i * wpl;
                 memcpy(buffer, line, bpl);
-                for (j = 0; j < w; j++) {
-                    val = GET_DATA_TWO_BYTES(buffer, w - 1 - j);
-                    SET_DATA_TWO_BYTES(line, j, val);
+                for (j = 0; j < wpl; j++) {
+                    val = buffer[wpl - 1 - j];
+                    line[j] = (val << 16) | (val >> 16);
                 }
             }
             break;
         case 8:
+            extra = (w * d) & 31;
+            if (extra)
+                shift = 4 - extra / 8;
+            else
+                shift = 0;
+            if (shift)
+                rasteropHipLow(data, h, d, wpl, 0, h, shift);
+
             for (i = 0; i < h; i++) {
                 line = data + i * wpl;
                 memcpy(buffer, line, bpl);
-                for (j = 0; j < w; j++) {
-                    val = GET_DATA_BYTE(buffer, w - 1 - j);
-                    SET_DATA_BYTE(line, j, val);
+                for (j = 0; j < wpl; j++) {
+                    val = buffer[wpl - 1 - j];
+                    line[j] = (val >> 24) | ((val >> 8) & 0x0000ff00) |
+                              ((val << 8) & 0x00ff0000) | (val << 24);
                 }
             }
             break;
@@ -30,6 +30,11 @@
  *
  *      Binary seedfill (source: Luc Vincent)
  *               PIX      *pixSeedfillBinary()
+ *        static l_int32   seedfillBinaryRuns()
+ *        static l_int32   nextOnPixelInRange()
+ *        static l_int32   runStartInLine()
+ *        static l_int32   runEndInLine()
+ *        static void      setRangeInLine()
  *               PIX      *pixSeedfillBinaryRestricted()
  *
  *      Applications of binary seedfill to find and fill holes,
@@ -92,6 +97,14 @@
  *      At this point, the seed has entirely filled the region it
  *      is allowed to, as delimited by the mask image.
  *
+ *      When the seed and the mask are the same size, the binary
+ *      seedfill is instead done in one pass over runs of the mask.
+ *      Each seed pixel in the mask fills the run that holds it, and
+ *      each filled run fills the runs on the lines above and below
+ *      that it touches, until no more are reached.  The time then
+ *      depends on the size of the filled region, not on how far
+ *      the fill has to wind through the mask.
+ *
  *      The grayscale seedfill is a straightforward generalization
  *      of the binary seedfill, and is described in seedfillLowGray().
  *
@@ -165,9 +178,26 @@
   /* Two-way (UL --> LR, LR --> UL) sweep iterations; typically need only 4 */
 static const l_int32  MAX_ITERS = 40;
 
-    /* Static function */
+    /* Static functions */
+static l_int32 seedfillBinaryRuns(PIX *pixd, PIX *pixm, l_int32 connectivity);
+static l_int32 nextOnPixelInRange(l_uint32 *linea, l_uint32 *lineb,
+                                  l_int32 x, l_int32 xmax);
+static l_int32 runStartInLine(l_uint32 *line, l_int32 x);
+static l_int32 runEndInLine(l_uint32 *line, l_int32 x, l_int32 w);
+static void setRangeInLine(l_uint32 *line, l_int32 xstart, l_int32 xend);
 static l_int32 pixQualifyLocalMinima(PIX *pixs, PIX *pixm, l_int32 maxval);
 
+    /* Number of leading and trailing zero bits in a word that is not 0 */
+#if defined(__GNUC__)
+#define  LEADING_ZEROS(word)     __builtin_clz(word)
+#define  TRAILING_ZEROS(word)    __builtin_ctz(word)
+#else
+static l_int32 leadingZeros(l_uint32 word);
+static l_int32 trailingZeros(l_uint32 word);
+#define  LEADING_ZEROS(word)     leadingZeros(word)
+#define  TRAILING_ZEROS(word)    trailingZeros(word)
+#endif  /* __GNUC__ */
+
 
 /*-----------------------------------------------------------------------*
  *              Vincent's Iterative Binary Seedfill method               *
@@ -201,6 +231,11 @@ static l_int32 pixQualifyLocalMinima(PIX *pixs, PIX *pixm, l_int32 maxval);
  *          a few pixels in each direction.  If the sizes differ,
  *          the clipping is handled by the low-level function
  *          seedfillBinaryLow().
+ *      (6) If the sizes are the same, the fill is done in one pass
+ *          over the runs of pixm by seedfillBinaryRuns().  This gives
+ *          the result that the sweeps converge to, and unlike them it
+ *          does not stop short after MAX_ITERS for a mask that winds
+ *          back and forth.
  * </pre>
  */
 PIX *
@@ -227,6 +262,15 @@ PIX       *pixt;
     if ((pixd = pixCopy(pixd, pixs)) == NULL)
         return (PIX *)ERROR_PTR("pixd not made", procName, NULL);
 
+    pixSetPadBits(pixm, 0);
+
+        /* Fill in one pass if no clipping is needed */
+    if (pixSizesEqual(pixd, pixm)) {
+        if (seedfillBinaryRuns(pixd, pixm, connectivity))
+            L_ERROR("fill not completed\n", procName);
+        return pixd;
+    }
+
         /* pixt is used to test for completion */
     if ((pixt = pixCreateTemplate(pixs)) == NULL)
         return (PIX *)ERROR_PTR("pixt not made", procName, pixd);
@@ -238,8 +282,6 @@ PIX       *pixt;
     wpld = pixGetWpl(pixd);
     wplm = pixGetWpl(pixm);
 
-    pixSetPadBits(pixm, 0);
-
     for (i = 0; i < MAX_ITERS; i++) {
         pixCopy(pixt, pixd);
         seedfillBinaryLow(datad, hd, wpld, datam, hm, wplm, connectivity);
@@ -257,6 +299,238 @@ PIX       *pixt;
 }
 
 
+/*!
+ * \brief   seedfillBinaryRuns()
+ *
+ * \param[in]    pixd  1 bpp seed; filled in place
+ * \param[in]    pixm  1 bpp filling mask, the same size as pixd,
+ *                     with its pad bits cleared
+ * \param[in]    connectivity  4 or 8
+ * \return  0 if OK, 1 on error
+ *
+ * <pre>
+ * Notes:
+ *      (1) Each seed pixel that is in the mask, and not yet filled,
+ *          fills the run of the mask that holds it.  Every filled run
+ *          is put on a stack, and each run taken off the stack fills
+ *          the runs of the mask on the lines above and below that are
+ *          4- or 8-connected to it and not yet filled, and puts them
+ *          on the stack in turn.
+ *      (2) A run is filled and stacked only once, so the c.c. of the
+ *          mask that hold seed pixels are filled in one pass and the
+ *          rest of the mask is never visited.  All the searches for
+ *          ON pixels and run ends go a word at a time.
+ * </pre>
+ */
+static l_int32
+seedfillBinaryRuns(PIX     *pixd,
+                   PIX     *pixm,
+                   l_int32  connectivity)
+{
+l_int32    w, h, wpld, wplm, wpls, d, y, x, ny, x1, x2, xs, xe;
+l_int32    ry, rxs, rxe, n, nalloc;
+l_int32   *stack;
+l_uint32  *datad, *datam, *datas, *lined, *linem;
+PIX       *pixs;
+
+    PROCNAME("seedfillBinaryRuns");
+
+        /* Keep the seed pixels in the mask, and start from empty */
+    if ((pixs = pixAnd(NULL, pixd, pixm)) == NULL)
+        return ERROR_INT("pixs not made", procName, 1);
+    nalloc = 3 * 1024;  /* y, xstart and xend of each stacked run */
+    if ((stack = (l_int32 *)LEPT_CALLOC(nalloc, sizeof(l_int32))) == NULL) {
+        pixDestroy(&pixs);
+        return ERROR_INT("stack not made", procName, 1);
+    }
+    pixClearAll(pixd);
+
+    pixGetDimensions(pixd, &w, &h, NULL);
+    datad = pixGetData(pixd);
+    datam = pixGetData(pixm);
+    datas = pixGetData(pixs);
+    wpld = pixGetWpl(pixd);
+    wplm = pixGetWpl(pixm);
+    wpls = pixGetWpl(pixs);
+    d = (connectivity == 8) ? 1 : 0;  /* corners also touch */
+    n = 0;
+    for (y = 0; y < h; y++) {
+        x = 0;
+        while ((x = nextOnPixelInRange(datas + y * wpls, datad + y * wpld,
+                                       x, w - 1)) >= 0) {
+            linem = datam + y * wplm;
+            xs = runStartInLine(linem, x);
+            xe = runEndInLine(linem, x, w);
+            setRangeInLine(datad + y * wpld, xs, xe);
+            stack[0] = y;
+            stack[1] = xs;
+            stack[2] = xe;
+            n = 3;
+            x = xe + 1;
+
+                /* Fill the c.c. of the mask that holds this run */
+            while (n > 0) {
+                n -= 3;
+                ry = stack[n];
+                rxs = stack[n + 1];
+                rxe = stack[n + 2];
+                for (ny = ry - 1; ny <= ry + 1; ny += 2) {
+                    if (ny < 0 || ny >= h)
+                        continue;
+                    linem = datam + ny * wplm;
+                    lined = datad + ny * wpld;
+                    x1 = L_MAX(0, rxs - d);
+                    x2 = L_MIN(w - 1, rxe + d);
+                    while ((x1 = nextOnPixelInRange(linem, lined,
+                                                    x1, x2)) >= 0) {
+                        xs = runStartInLine(linem, x1);
+                        xe = runEndInLine(linem, x1, w);
+                        setRangeInLine(lined, xs, xe);
+                        if (n + 3 > nalloc) {
+                            if ((stack = (l_int32 *)reallocNew((void **)&stack,
+                                    sizeof(l_int32) * nalloc,
+                                    2 * sizeof(l_int32) * nalloc)) == NULL) {
+                                pixDestroy(&pixs);
+                                return ERROR_INT("stack not extended",
+                                                 procName, 1);
+                            }
+                            nalloc *= 2;
+                        }
+                        stack[n] = ny;
+                        stack[n + 1] = xs;
+                        stack[n + 2] = xe;
+                        n += 3;
+                        x1 = xe + 2;  /* the next run starts after a gap */
+                    }
+                }
+            }
+        }
+    }
+
+    LEPT_FREE(stack);
+    pixDestroy(&pixs);
+    return 0;
+}
+
+
+/*!
+ * \brief   nextOnPixelInRange()
+ *
+ * \param[in]    linea, lineb  lines of 1 bpp image data
+ * \param[in]    x      first pixel to look at
+ * \param[in]    xmax   last pixel to look at
+ * \return  first pixel in [x, xmax] that is ON in linea and OFF in lineb,
+ *              or -1 if there is none
+ */
+static l_int32
+nextOnPixelInRange(l_uint32  *linea,
+                   l_uint32  *lineb,
+                   l_int32    x,
+                   l_int32    xmax)
+{
+l_int32   j, jmax;
+l_uint32  word;
+
+    if (x > xmax)
+        return -1;
+    j = x >> 5;
+    jmax = xmax >> 5;
+    word = linea[j] & ~lineb[j] & (0xffffffff >> (x & 31));
+    while (!word) {
+        if (++j > jmax)
+            return -1;
+        word = linea[j] & ~lineb[j];
+    }
+    x = 32 * j + LEADING_ZEROS(word);
+    return (x <= xmax) ? x : -1;
+}
+
+
+/*!
+ * \brief   runStartInLine()
+ *
+ * \param[in]    line  of 1 bpp image data
+ * \param[in]    x     an ON pixel
+ * \return  first pixel of the run of ON pixels that holds x
+ */
+static l_int32
+runStartInLine(l_uint32  *line,
+               l_int32    x)
+{
+l_int32   j;
+l_uint32  word;
+
+        /* OFF pixels to the left of x in its word */
+    j = x >> 5;
+    word = (x & 31) ? ~line[j] & (0xffffffff << (32 - (x & 31))) : 0;
+    while (!word) {
+        if (--j < 0)
+            return 0;
+        word = ~line[j];
+    }
+    return 32 * j + 32 - TRAILING_ZEROS(word);
+}
+
+
+/*!
+ * \brief   runEndInLine()
+ *
+ * \param[in]    line  of 1 bpp image data, with the pad bits cleared
+ * \param[in]    x     an ON pixel
+ * \param[in]    w     width in pixels
+ * \return  last pixel of the run of ON pixels that holds x
+ */
+static l_int32
+runEndInLine(l_uint32  *line,
+             l_int32    x,
+             l_int32    w)
+{
+l_int32   j, nwords;
+l_uint32  word;
+
+        /* OFF pixels to the right of x in its word */
+    j = x >> 5;
+    nwords = (w + 31) / 32;
+    word = ~line[j] & (0xffffffff >> (x & 31));
+    while (!word) {
+        if (++j >= nwords)
+            return w - 1;
+        word = ~line[j];
+    }
+    return 32 * j + LEADING_ZEROS(word) - 1;
+}
+
+
+/*!
+ * \brief   setRangeInLine()
+ *
+ * \param[in]    line  of 1 bpp image data
+ * \param[in]    xstart, xend  first and last pixel to set
+ * \return  void
+ */
+static void
+setRangeInLine(l_uint32  *line,
+               l_int32    xstart,
+               l_int32    xend)
+{
+l_int32   j, jstart, jend;
+l_uint32  lmask, rmask;
+
+    jstart = xstart >> 5;
+    jend = xend >> 5;
+    lmask = 0xffffffff >> (xstart & 31);
+    rmask = 0xffffffff << (31 - (xend & 31));
+    if (jstart == jend) {
+        line[jstart] |= lmask & rmask;
+        return;
+    }
+    line[jstart] |= lmask;
+    for (j = jstart + 1; j < jend; j++)
+        line[j] = 0xffffffff;
+    line[jend] |= rmask;
+}
+
+
 /*!
  * \brief   pixSeedfillBinaryRestricted()
  *
@@ -1664,3 +1938,47 @@ PIX  *pixt;
     pixDestroy(&pixt);
     return pixd;
 }
+
+
+#if !defined(__GNUC__)
+/*!
+ * \brief   leadingZeros()
+ *
+ * \param[in]    word  not 0
+ * \return  number of 0 bits above the highest 1 bit
+ */
+static l_int32
+leadingZeros(l_uint32  word)
+{
+l_int32  n;
+
+    n = 0;
+    if (!(word & 0xffff0000)) { n += 16; word <<= 16; }
+    if (!(word & 0xff000000)) { n += 8; word <<= 8; }
+    if (!(word & 0xf0000000)) { n += 4; word <<= 4; }
+    if (!(word & 0xc0000000)) { n += 2; word <<= 2; }
+    if (!(word & 0x80000000)) n += 1;
+    return n;
+}
+
+
+/*!
+ * \brief   trailingZeros()
+ *
+ * \param[in]    word  not 0
+ * \return  number of 0 bits below the lowest 1 bit
+ */
+static l_int32
+trailingZeros(l_uint32  word)
+{
+l_int32  n;
+
+    n = 0;
+    if (!(word & 0x0000ffff)) { n += 16; word >>= 16; }
+    if (!(word & 0x000000ff)) { n += 8; word >>= 8; }
+    if (!(word & 0x0000000f)) { n += 4; word >>= 4; }
+    if (!(word & 0x00000003)) { n += 2; word >>= 2; }
+    if (!(word & 0x00000001)) n += 1;
+    return n;
+}
+#endif  /* !__GNUC__ */
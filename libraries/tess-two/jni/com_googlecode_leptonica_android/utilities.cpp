@@ -15,8 +15,16 @@
  */
 
 #include "common.h"
+#include "backgroundnorm.h"
+#include "pagedewarp.h"
+#include "rotate.h"
+#include "scale.h"
 
+#include <math.h>
+#include <pthread.h>
 #include <string.h>
+#include <time.h>
+#include <unistd.h>
 #include <android/bitmap.h>
 
 #ifdef __cplusplus
@@ -36,8 +44,26 @@ jlong Java_com_googlecode_leptonica_android_AdaptiveMap_nativeBackgroundNormMorp
   // Normalizes the background of each element in pixa.
 
   PIX *pixs = (PIX *) nativePix;
-  PIX *pixd = pixBackgroundNormMorph(pixs, NULL, (l_int32) reduction, (l_int32) size,
-                                     (l_int32) bgval);
+  PIX *pixd = backgroundNormMorphParallel(pixs, (l_int32) reduction, (l_int32) size,
+                                          (l_int32) bgval, 0);
+
+  return jlong(pixd);
+}
+
+jlong Java_com_googlecode_leptonica_android_AdaptiveMap_nativeBackgroundNorm(JNIEnv *env,
+                                                                             jclass clazz,
+                                                                             jlong nativePix,
+                                                                             jint sizeX,
+                                                                             jint sizeY,
+                                                                             jint thresh,
+                                                                             jint minCount,
+                                                                             jint bgval,
+                                                                             jint smoothX,
+                                                                             jint smoothY) {
+  PIX *pixs = (PIX *) nativePix;
+  PIX *pixd = backgroundNormParallel(pixs, (l_int32) sizeX, (l_int32) sizeY, (l_int32) thresh,
+                                     (l_int32) minCount, (l_int32) bgval, (l_int32) smoothX,
+                                     (l_int32) smoothY, 0);
 
   return jlong(pixd);
 }
@@ -52,8 +78,8 @@ jlong Java_com_googlecode_leptonica_android_AdaptiveMap_nativePixContrastNorm(JN
                                                                               jint smoothY) {
 
   PIX *pixs = (PIX *) nativePix;
-  PIX *pixd = pixContrastNorm(NULL, pixs, (l_int32) sizeX, (l_int32) sizeY,
-                                     (l_int32) minDiff, (l_int32) smoothX, (l_int32) smoothY);
+  PIX *pixd = contrastNormParallel(pixs, (l_int32) sizeX, (l_int32) sizeY, (l_int32) minDiff,
+                                   (l_int32) smoothX, (l_int32) smoothY, 0);
 
   return jlong(pixd);
 }
@@ -101,6 +127,234 @@ jlong Java_com_googlecode_leptonica_android_Binarize_nativeSauvolaBinarizeTiled(
   return jlong(pixd);
 }
 
+// Shared state of the workers of sauvolaBinarizeTiledParallel.
+struct SauvolaTiling {
+  PIXTILING *pt;
+  PIX *pixd;
+  l_int32 whsize;
+  l_float32 factor;
+  l_int32 ntiles;
+  l_int32 next_tile;  // next tile to be taken, guarded by mutex
+  l_int32 failed;     // guarded by mutex
+  pthread_mutex_t mutex;
+};
+
+// Sauvola-binarizes a tile that has a border of whsize + 1 pixels on every
+// side, returning the 1 bpp result without the border, or NULL on error.
+// This gives exactly the output of pixSauvolaBinarize(pixs, whsize, factor,
+// 0, ...), but instead of full-tile accumulators (the mean square one in
+// double) it keeps 32 bit sums of each column over the window rows, updated
+// a row at a time, and takes running differences of their prefix sums along
+// the row. Unsigned arithmetic wraps, so a difference is exact as long as
+// the sum over one window fits in 32 bits, whatever the size of the tile;
+// larger windows are left to Leptonica.
+static PIX *sauvolaBinarizeTile(PIX *pixs, l_int32 whsize, l_float32 factor) {
+  l_int32 wincr = 2 * whsize + 1;
+  if ((l_float64) wincr * wincr * 255 * 255 > 0xffffffffu) {
+    PIX *pixd = NULL;
+    pixSauvolaBinarize(pixs, whsize, factor, 0, NULL, NULL, NULL, &pixd);
+    return pixd;
+  }
+
+  l_int32 w, h;
+  pixGetDimensions(pixs, &w, &h, NULL);
+  l_int32 wd = w - 2 * (whsize + 1);
+  l_int32 hd = h - 2 * (whsize + 1);
+  if (pixGetDepth(pixs) != 8 || wd < 2 || hd < 2) {
+    return NULL;
+  }
+  PIX *pixd = pixCreate(wd, hd, 1);
+  l_uint32 *buffer = (l_uint32 *) malloc(4 * (w + 1) * sizeof(l_uint32));
+  if (pixd == NULL || buffer == NULL) {
+    pixDestroy(&pixd);
+    free(buffer);
+    return NULL;
+  }
+  l_uint32 *colsum = buffer;
+  l_uint32 *colsq = colsum + w;
+  // Prefix sums of the column sums, with a leading 0.
+  l_uint32 *rowsum = colsq + w;
+  l_uint32 *rowsq = rowsum + w + 1;
+
+  l_uint32 *datas = pixGetData(pixs);
+  l_uint32 *datad = pixGetData(pixd);
+  l_int32 wpls = pixGetWpl(pixs);
+  l_int32 wpld = pixGetWpl(pixd);
+  // The same normalizations, in the same precision, as pixWindowedMean and
+  // pixWindowedMeanSquare, so the thresholds match Leptonica's.
+  l_float32 norm = 1.0 / (wincr * wincr);
+  l_float64 normsq = 1.0 / (wincr * wincr);
+
+  // Like Leptonica's accumulators, the window of output row i covers source
+  // rows i + 1 to i + wincr, and that of column j columns j + 1 to j + wincr.
+  memset(colsum, 0, 2 * w * sizeof(l_uint32));
+  for (l_int32 y = 1; y < wincr; y++) {
+    l_uint32 *lines = datas + y * wpls;
+    for (l_int32 x = 0; x < w; x++) {
+      l_uint32 val = GET_DATA_BYTE(lines, x);
+      colsum[x] += val;
+      colsq[x] += val * val;
+    }
+  }
+  rowsum[0] = rowsq[0] = 0;
+  for (l_int32 i = 0; i < hd; i++) {
+    l_uint32 *linein = datas + (i + wincr) * wpls;
+    for (l_int32 x = 0; x < w; x++) {
+      l_uint32 val = GET_DATA_BYTE(linein, x);
+      colsum[x] += val;
+      colsq[x] += val * val;
+    }
+    for (l_int32 x = 0; x < w; x++) {
+      rowsum[x + 1] = rowsum[x] + colsum[x];
+      rowsq[x + 1] = rowsq[x] + colsq[x];
+    }
+
+    l_uint32 *lines = datas + (i + whsize + 1) * wpls;
+    l_uint32 *lined = datad + i * wpld;
+    for (l_int32 j = 0; j < wd; j++) {
+      l_uint32 sum = rowsum[j + wincr + 1] - rowsum[j + 1];
+      l_uint32 sumsq = rowsq[j + wincr + 1] - rowsq[j + 1];
+      l_int32 mv = (l_uint8) (norm * sum);
+      l_int32 ms = (l_uint32) (normsq * sumsq);
+      l_float32 sd = sqrtf((l_float32) (ms - mv * mv));
+      l_int32 thresh = (l_int32) (mv * (1.0 - factor * (1.0 - sd / 128.)));
+      if (GET_DATA_BYTE(lines, j + whsize + 1) < (thresh & 0xff)) {
+        SET_DATA_BIT(lined, j);
+      }
+    }
+
+    l_uint32 *lineout = datas + (i + 1) * wpls;
+    for (l_int32 x = 0; x < w; x++) {
+      l_uint32 val = GET_DATA_BYTE(lineout, x);
+      colsum[x] -= val;
+      colsq[x] -= val * val;
+    }
+  }
+
+  free(buffer);
+  return pixd;
+}
+
+// Binarizes tiles taken from the shared tiling until there are none left.
+static void *sauvolaTileWorker(void *arg) {
+  SauvolaTiling *tiling = (SauvolaTiling *) arg;
+  l_int32 nx, ny;
+  pixTilingGetCount(tiling->pt, &nx, &ny);
+
+  for (;;) {
+    pthread_mutex_lock(&tiling->mutex);
+    l_int32 tile = tiling->failed ? tiling->ntiles : tiling->next_tile++;
+    pthread_mutex_unlock(&tiling->mutex);
+    if (tile >= tiling->ntiles) {
+      break;
+    }
+
+    l_int32 i = tile / nx;
+    l_int32 j = tile % nx;
+    PIX *pixt = pixTilingGetTile(tiling->pt, i, j);
+    PIX *tiled = pixt ? sauvolaBinarizeTile(pixt, tiling->whsize, tiling->factor) : NULL;
+    pixDestroy(&pixt);
+
+    // Neighbouring tiles can share words of pixd, so painting is serialized.
+    pthread_mutex_lock(&tiling->mutex);
+    if (tiled == NULL || pixTilingPaintTile(tiling->pixd, i, j, tiled, tiling->pt)) {
+      tiling->failed = 1;
+    }
+    pthread_mutex_unlock(&tiling->mutex);
+    pixDestroy(&tiled);
+  }
+
+  return NULL;
+}
+
+// Does what pixSauvolaBinarizeTiled does, on numThreads threads (one per
+// core if numThreads <= 0) taking the tiles of the same PIXTILING in turn,
+// each binarized by sauvolaBinarizeTile.
+static PIX *sauvolaBinarizeTiledParallel(PIX *pixs, l_int32 whsize, l_float32 factor,
+                                         l_int32 nx, l_int32 ny, l_int32 numThreads) {
+  if (pixs == NULL || pixGetDepth(pixs) != 8 || pixGetColormap(pixs)) {
+    return NULL;
+  }
+  l_int32 w, h;
+  pixGetDimensions(pixs, &w, &h, NULL);
+  if (whsize < 2 || w < 2 * whsize + 3 || h < 2 * whsize + 3 || factor < 0.0) {
+    return NULL;
+  }
+
+  // Tiles must be at least (whsize + 2) x (whsize + 2).
+  nx = L_MAX(1, L_MIN(nx, w / (whsize + 2)));
+  ny = L_MAX(1, L_MIN(ny, h / (whsize + 2)));
+  if (nx == 1 && ny == 1) {
+    PIX *pixb = pixAddMirroredBorder(pixs, whsize + 1, whsize + 1, whsize + 1, whsize + 1);
+    PIX *pixd = pixb ? sauvolaBinarizeTile(pixb, whsize, factor) : NULL;
+    pixDestroy(&pixb);
+    if (pixd) {
+      pixCopyResolution(pixd, pixs);
+    }
+    return pixd;
+  }
+
+  SauvolaTiling tiling;
+  tiling.pixd = pixCreate(w, h, 1);
+  tiling.pt = pixTilingCreate(pixs, nx, ny, 0, 0, whsize + 1, whsize + 1);
+  if (tiling.pixd == NULL || tiling.pt == NULL) {
+    pixDestroy(&tiling.pixd);
+    pixTilingDestroy(&tiling.pt);
+    return NULL;
+  }
+  pixTilingNoStripOnPaint(tiling.pt);  // sauvolaBinarizeTile does the stripping
+  pixCopyResolution(tiling.pixd, pixs);
+  tiling.whsize = whsize;
+  tiling.factor = factor;
+  tiling.ntiles = nx * ny;
+  tiling.next_tile = 0;
+  tiling.failed = 0;
+  pthread_mutex_init(&tiling.mutex, NULL);
+
+  if (numThreads <= 0) {
+    numThreads = (l_int32) sysconf(_SC_NPROCESSORS_ONLN);
+  }
+  numThreads = L_MAX(1, L_MIN(numThreads, tiling.ntiles));
+
+  // The calling thread is one of the workers, and does all the work if no
+  // other thread can be started.
+  pthread_t *threads = (pthread_t *) malloc(numThreads * sizeof(pthread_t));
+  l_int32 started = 0;
+  while (threads != NULL && started < numThreads - 1 &&
+         pthread_create(&threads[started], NULL, sauvolaTileWorker, &tiling) == 0) {
+    started++;
+  }
+  sauvolaTileWorker(&tiling);
+  for (l_int32 t = 0; t < started; t++) {
+    pthread_join(threads[t], NULL);
+  }
+  free(threads);
+
+  pthread_mutex_destroy(&tiling.mutex);
+  pixTilingDestroy(&tiling.pt);
+  if (tiling.failed) {
+    pixDestroy(&tiling.pixd);
+  }
+
+  return tiling.pixd;
+}
+
+jlong Java_com_googlecode_leptonica_android_Binarize_nativeSauvolaBinarizeTiledParallel(JNIEnv *env,
+                                                                                        jclass clazz,
+                                                                                        jlong nativePix,
+                                                                                        jint whsize,
+                                                                                        jfloat factor,
+                                                                                        jint nx,
+                                                                                        jint ny,
+                                                                                        jint numThreads) {
+
+  PIX *pixs = (PIX *) nativePix;
+  PIX *pixd = sauvolaBinarizeTiledParallel(pixs, (l_int32) whsize, (l_float32) factor,
+                                           (l_int32) nx, (l_int32) ny, (l_int32) numThreads);
+
+  return jlong(pixd);
+}
+
 /********
  * Clip *
  ********/
@@ -141,6 +395,19 @@ jlong Java_com_googlecode_leptonica_android_Edge_nativePixSobelEdgeFilter(JNIEnv
   return jlong(pixd);
 }
 
+jboolean Java_com_googlecode_leptonica_android_Edge_nativePixSobelEdgeFilterInPlace(JNIEnv *env,
+                                                                                    jclass clazz,
+                                                                                    jlong nativePix,
+                                                                                    jint orientFlag) {
+  PIX *pixs = (PIX *) nativePix;
+
+  if (!pixSobelEdgeFilterGeneral(pixs, pixs, (l_int32) orientFlag)) {
+    return JNI_FALSE;
+  }
+
+  return JNI_TRUE;
+}
+
 /***********
  * Enhance *
  ***********/
@@ -155,6 +422,20 @@ jlong Java_com_googlecode_leptonica_android_Enhance_nativeUnsharpMasking(JNIEnv
   return jlong(pixd);
 }
 
+jboolean Java_com_googlecode_leptonica_android_Enhance_nativeUnsharpMaskingInPlace(JNIEnv *env,
+                                                                                   jclass clazz,
+                                                                                   jlong nativePix,
+                                                                                   jint halfwidth,
+                                                                                   jfloat fract) {
+  PIX *pixs = (PIX *) nativePix;
+
+  if (!pixUnsharpMaskingGeneral(pixs, pixs, (l_int32) halfwidth, (l_float32) fract)) {
+    return JNI_FALSE;
+  }
+
+  return JNI_TRUE;
+}
+
 /*************
  * GrayQuant *
  *************/
@@ -218,6 +499,175 @@ jlong Java_com_googlecode_leptonica_android_MorphApp_nativePixFastTophat(JNIEnv
   return jlong(pixd);
 }
 
+/**********************
+ * PreprocessPipeline *
+ **********************/
+
+// Values of PreprocessPipeline.OP_*. Each op is followed in the parameter
+// array by PIPELINE_PARAMS_PER_OP values, unused ones being ignored.
+enum PipelineOp {
+  PIPELINE_CONVERT_TO_GREY,  // no parameters
+  PIPELINE_DESKEW,           // sweep range, sweep delta, sweep reduction,
+                             // search reduction, min angle, min confidence
+  PIPELINE_BACKGROUND_NORM,  // reduction, size, bgval
+  PIPELINE_SAUVOLA,          // whsize, factor, nx, ny, threads
+  PIPELINE_OTSU,             // sizeX, sizeY, smoothX, smoothY, score fraction
+  PIPELINE_DEWARP,           // sampling, min lines, use both, max diff, threads
+  PIPELINE_OP_COUNT
+};
+
+static const l_int32 PIPELINE_PARAMS_PER_OP = 6;
+
+// Grey level below which pixels are foreground when binarizing for skew
+// detection, as in pixDeskew.
+static const l_int32 DESKEW_BINARY_THRESHOLD = 130;
+
+static double pipelineClockMs() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+// Finds the skew of pixs and returns it rotated straight, or pixs itself
+// when the skew is too small or too uncertain to be worth a rotation.
+static PIX *pipelineDeskew(PIX *pixs, const jfloat *params, l_float32 *pangle) {
+  l_float32 sweepRange = params[0];
+  l_float32 sweepDelta = params[1];
+  l_int32 sweepReduction = (l_int32) params[2];
+  l_int32 searchReduction = (l_int32) params[3];
+  l_float32 minAngle = params[4];
+  l_float32 minConfidence = params[5];
+
+  PIX *pixb;
+  if (pixGetDepth(pixs) == 1) {
+    pixb = pixClone(pixs);
+  } else {
+    pixb = pixConvertTo1(pixs, DESKEW_BINARY_THRESHOLD);
+  }
+  if (pixb == NULL) {
+    return NULL;
+  }
+
+  l_float32 angle, conf;
+  l_int32 failed = pixFindSkewSweepAndSearch(pixb, &angle, &conf, sweepReduction,
+                                             searchReduction, sweepRange, sweepDelta,
+                                             (l_float32) 0.01);
+  pixDestroy(&pixb);
+  if (failed || conf < minConfidence || L_ABS(angle) < minAngle) {
+    return pixs;
+  }
+
+  PIX *pixd = pixRotate(pixs, angle * (l_float32) (3.1415926535 / 180.0), L_ROTATE_AREA_MAP,
+                        L_BRING_IN_WHITE, 0, 0);
+  if (pixd != NULL) {
+    *pangle = angle;
+  }
+  return pixd;
+}
+
+// Runs one op on pixs. Returns the new image, pixs itself when the op has
+// nothing to do, or NULL on error.
+static PIX *runPipelineOp(PIX *pixs, l_int32 op, const jfloat *params, DewarpModel *model,
+                          l_float32 *pangle) {
+  PIX *pixd = NULL;
+
+  switch (op) {
+    case PIPELINE_CONVERT_TO_GREY:
+      if (pixGetDepth(pixs) == 8 && pixGetColormap(pixs) == NULL) {
+        return pixs;
+      }
+      return pixConvertTo8(pixs, FALSE);
+    case PIPELINE_DESKEW:
+      return pipelineDeskew(pixs, params, pangle);
+    case PIPELINE_BACKGROUND_NORM:
+      return backgroundNormMorphParallel(pixs, (l_int32) params[0], (l_int32) params[1],
+                                         (l_int32) params[2], 0);
+    case PIPELINE_SAUVOLA:
+      return sauvolaBinarizeTiledParallel(pixs, (l_int32) params[0], params[1],
+                                          (l_int32) params[2], (l_int32) params[3],
+                                          (l_int32) params[4]);
+    case PIPELINE_OTSU:
+      if (pixOtsuAdaptiveThreshold(pixs, (l_int32) params[0], (l_int32) params[1],
+                                   (l_int32) params[2], (l_int32) params[3], params[4],
+                                   NULL, &pixd)) {
+        return NULL;
+      }
+      return pixd;
+    case PIPELINE_DEWARP:
+      return dewarpPageParallel(pixs, model, (l_int32) params[0], (l_int32) params[1],
+                                (l_int32) params[2], params[3], (l_int32) params[4]);
+    default:
+      LOGE("Unknown preprocessing op %d", op);
+      return NULL;
+  }
+}
+
+jlong Java_com_googlecode_leptonica_android_PreprocessPipeline_nativeProcess(JNIEnv *env,
+                                                                             jclass clazz,
+                                                                             jlong nativePix,
+                                                                             jintArray ops,
+                                                                             jfloatArray params,
+                                                                             jlong nativeModel,
+                                                                             jdoubleArray timings,
+                                                                             jfloatArray angle) {
+  PIX *pixs = (PIX *) nativePix;
+  DewarpModel *model = (DewarpModel *) nativeModel;
+  jsize numOps = env->GetArrayLength(ops);
+
+  if (env->GetArrayLength(params) < numOps * PIPELINE_PARAMS_PER_OP ||
+      env->GetArrayLength(timings) < numOps) {
+    LOGE("Preprocessing parameters do not match the ops");
+    return (jlong) 0;
+  }
+
+  jint *opArray = env->GetIntArrayElements(ops, NULL);
+  jfloat *paramArray = env->GetFloatArrayElements(params, NULL);
+  double *opTimes = (double *) calloc(numOps > 0 ? numOps : 1, sizeof(double));
+  l_float32 deskewAngle = 0.0f;
+
+  // Each intermediate image is freed as soon as the next op has read it, so
+  // no more than two page images are alive at once.
+  PIX *pixd = pixClone(pixs);
+  for (jsize i = 0; i < numOps && pixd != NULL; i++) {
+    double start = pipelineClockMs();
+    PIX *pixt = runPipelineOp(pixd, opArray[i], paramArray + i * PIPELINE_PARAMS_PER_OP,
+                              model, &deskewAngle);
+    if (pixt != pixd) {
+      pixDestroy(&pixd);
+      pixd = pixt;
+    }
+    opTimes[i] = pipelineClockMs() - start;
+  }
+
+  env->ReleaseIntArrayElements(ops, opArray, JNI_ABORT);
+  env->ReleaseFloatArrayElements(params, paramArray, JNI_ABORT);
+  env->SetDoubleArrayRegion(timings, 0, numOps, opTimes);
+  free(opTimes);
+  if (angle != NULL && env->GetArrayLength(angle) > 0) {
+    env->SetFloatArrayRegion(angle, 0, 1, &deskewAngle);
+  }
+
+  return jlong(pixd);
+}
+
+jlong Java_com_googlecode_leptonica_android_PreprocessPipeline_nativeCreateDewarpModel(JNIEnv *env,
+                                                                                       jclass clazz) {
+  return (jlong) dewarpModelCreate();
+}
+
+void Java_com_googlecode_leptonica_android_PreprocessPipeline_nativeResetDewarpModel(JNIEnv *env,
+                                                                                     jclass clazz,
+                                                                                     jlong nativeModel) {
+  dewarpModelReset((DewarpModel *) nativeModel);
+}
+
+void Java_com_googlecode_leptonica_android_PreprocessPipeline_nativeDestroyDewarpModel(JNIEnv *env,
+                                                                                       jclass clazz,
+                                                                                       jlong nativeModel) {
+  DewarpModel *model = (DewarpModel *) nativeModel;
+  dewarpModelDestroy(&model);
+}
+
 /*********
  * Scale *
  *********/
@@ -226,14 +676,14 @@ jlong Java_com_googlecode_leptonica_android_Scale_nativeScaleGeneral(JNIEnv *env
                                                                      jlong nativePix, jfloat scaleX,
                                                                      jfloat scaleY, jfloat sharpfract, jint sharpwidth) {
   PIX *pixs = (Pix *) nativePix;
-  return (jlong) pixScaleGeneral(pixs, (l_float32) scaleX, (l_float32) scaleY,(l_float32) sharpfract, (l_int32) sharpwidth);
+  return (jlong) scaleGeneralParallel(pixs, (l_float32) scaleX, (l_float32) scaleY,(l_float32) sharpfract, (l_int32) sharpwidth, 0);
 }
 
 jlong Java_com_googlecode_leptonica_android_Scale_nativeScale(JNIEnv *env, jclass clazz,
                                                               jlong nativePix, jfloat scaleX,
                                                               jfloat scaleY) {
   PIX *pixs = (Pix *) nativePix;
-  PIX *pixd = pixScale(pixs, (l_float32) scaleX, (l_float32) scaleY);
+  PIX *pixd = scaleParallel(pixs, (l_float32) scaleX, (l_float32) scaleY, 0);
 
   return jlong(pixd);
 }
@@ -265,6 +715,51 @@ jfloat Java_com_googlecode_leptonica_android_Skew_nativeFindSkew(JNIEnv *env, jc
   return (jfloat) 0;
 }
 
+jfloat Java_com_googlecode_leptonica_android_Skew_nativeFindSkewCoarseToFine(JNIEnv *env,
+                                                                             jclass clazz,
+                                                                             jlong nativePix,
+                                                                             jfloat sweepRange,
+                                                                             jfloat sweepDelta,
+                                                                             jint coarseReduction,
+                                                                             jfloat fineRange,
+                                                                             jfloat fineDelta,
+                                                                             jint fineReduction,
+                                                                             jfloat minDelta,
+                                                                             jfloat earlyExitConf,
+                                                                             jfloat minConf) {
+  PIX *pixs = (PIX *) nativePix;
+
+  l_float32 angle, conf;
+
+  // Coarse sweep and search, all on the coarse reduction.
+  if (pixFindSkewSweepAndSearch(pixs, &angle, &conf, (l_int32) coarseReduction,
+                                (l_int32) coarseReduction, (l_float32) sweepRange,
+                                (l_float32) sweepDelta, (l_float32) sweepDelta / 10)) {
+    return (jfloat) 0;
+  }
+
+  // Only refine a result that is not already confident, in a narrow range.
+  if (conf < earlyExitConf) {
+    l_float32 fineAngle, fineConf, endScore;
+    l_int32 sweepReduction = L_MIN(2 * fineReduction, coarseReduction);
+
+    if (!pixFindSkewSweepAndSearchScorePivot(pixs, &fineAngle, &fineConf, &endScore,
+                                             sweepReduction, (l_int32) fineReduction,
+                                             angle, (l_float32) fineRange,
+                                             (l_float32) fineDelta, (l_float32) minDelta,
+                                             L_SHEAR_ABOUT_CORNER) && fineConf > conf) {
+      angle = fineAngle;
+      conf = fineConf;
+    }
+  }
+
+  if (conf < minConf) {
+    return (jfloat) 0;
+  }
+
+  return (jfloat) angle;
+}
+
 /**********
  * Rotate *
  **********/
@@ -284,10 +779,12 @@ jlong Java_com_googlecode_leptonica_android_Rotate_nativeRotate(JNIEnv *env, jcl
   if (bpp == 1 && quality == JNI_TRUE) {
     pixd = pixRotateBinaryNice(pixs, radians, L_BRING_IN_WHITE);
   } else {
-    type = quality == JNI_TRUE ? L_ROTATE_AREA_MAP : L_ROTATE_SAMPLING;
+    // Shear rotation, which pixRotate turns into sampling above about 20
+    // degrees, is split across all cores.
+    type = quality == JNI_TRUE ? L_ROTATE_AREA_MAP : L_ROTATE_SHEAR;
     w = (resize == JNI_TRUE) ? w : 0;
     h = (resize == JNI_TRUE) ? h : 0;
-    pixd = pixRotate(pixs, radians, type, L_BRING_IN_WHITE, w, h);
+    pixd = rotateParallel(pixs, radians, type, L_BRING_IN_WHITE, w, h, 0);
   }
 
   return jlong(pixd);
@@ -15,6 +15,7 @@
  */
 
 #include "common.h"
+#include "bitmapconvert.h"
 
 #include <string.h>
 #include <android/bitmap.h>
@@ -100,47 +101,37 @@ jboolean Java_com_googlecode_leptonica_android_WriteFile_nativeWriteBitmap(JNIEn
     return JNI_FALSE;
   }
 
+  if (d != 1 && d != 8 && d != 32) {
+    LOGE("Pix depth %d is not 1, 8 or 32!", d);
+    return JNI_FALSE;
+  }
+
   if ((ret = AndroidBitmap_lockPixels(env, bitmap, &pixels)) < 0) {
     LOGE("AndroidBitmap_lockPixels() failed ! error=%d", ret);
     return JNI_FALSE;
   }
 
-  pixEndianByteSwap(pixs);
-
+  // The rows are converted from the Pix as they are copied, so the Pix is
+  // left as it was.
   l_uint8 *dst = (l_uint8 *) pixels;
-  l_uint8 *src = (l_uint8 *) pixGetData(pixs);
-  l_int32 dstBpl = info.stride;
-  l_int32 srcBpl = 4 * pixGetWpl(pixs);
+  l_uint32 *src = pixGetData(pixs);
+  l_int32 srcWpl = pixGetWpl(pixs);
+  bool hasAlpha = pixGetSpp(pixs) == 4;
 
   LOGI("Writing 32bpp RGBA bitmap (w=%d, h=%d, stride=%d) from %dbpp Pix (wpl=%d)", info.width,
-       info.height, info.stride, d, pixGetWpl(pixs));
+       info.height, info.stride, d, srcWpl);
 
   for (int dy = 0; dy < info.height; dy++) {
-    l_uint8 *dstx = dst;
-    l_uint8 *srcx = src;
-
     if (d == 32) {
-      memcpy(dst, src, 4 * info.width);
+      convertRGBRowToRGBA8888(src, info.width, hasAlpha, dst);
     } else if (d == 8) {
-      for (int dw = 0; dw < info.width; dw++) {
-        dstx[0] = dstx[1] = dstx[2] = srcx[0];
-        dstx[3] = 0xFF;
-
-        dstx += 4;
-        srcx += 1;
-      }
-    } else if (d == 1) {
-      for (int dw = 0; dw < info.width; dw++) {
-        dstx[0] = dstx[1] = dstx[2] = (1 << (7 - (dw & 7)) & srcx[0]) ? 0x00 : 0xFF;
-        dstx[3] = 0xFF;
-
-        dstx += 4;
-        srcx += ((dw % 8) == 7) ? 1 : 0;
-      }
+      convertGreyRowToRGBA8888(src, info.width, dst);
+    } else {
+      convertBinaryRowToRGBA8888(src, info.width, dst);
     }
 
-    dst += dstBpl;
-    src += srcBpl;
+    dst += info.stride;
+    src += srcWpl;
   }
 
   AndroidBitmap_unlockPixels(env, bitmap);
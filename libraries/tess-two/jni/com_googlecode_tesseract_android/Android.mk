@@ -7,6 +7,7 @@ LOCAL_MODULE := libtess
 # tesseract (minus executable)
 
 BLACKLIST_SRC_FILES := \
+  %api/tessbench.cpp \
   %api/tesseractmain.cpp \
   %viewer/svpaint.cpp
 
@@ -30,6 +31,15 @@ TESSERACT_SRC_FILES := \
 LOCAL_SRC_FILES := \
   $(filter-out $(BLACKLIST_SRC_FILES),$(subst $(LOCAL_PATH)/,,$(TESSERACT_SRC_FILES)))
 
+# The NEON kernels in arch/ are also built for armeabi-v7a, whose baseline
+# has no NEON. SIMDDetect asks cpufeatures whether the device has it before
+# any of them is picked, so the rest of the library still runs without.
+
+ifeq ($(TARGET_ARCH_ABI),armeabi-v7a)
+LOCAL_SRC_FILES := $(patsubst %neon.cpp,%neon.cpp.neon,$(LOCAL_SRC_FILES))
+LOCAL_STATIC_LIBRARIES += cpufeatures
+endif
+
 LOCAL_C_INCLUDES := \
   $(TESSERACT_PATH)/api \
   $(TESSERACT_PATH)/arch \
@@ -60,6 +70,57 @@ LOCAL_CFLAGS := \
   -Wno-shift-negative-value \
   -D_GLIBCXX_PERMIT_BACKWARD_HASH   # fix for android-ndk-r8e/sources/cxx-stl/gnu-libstdc++/4.6/include/ext/hash_map:61:30: fatal error: backward_warning.h: No such file or directory
 
+# OpenCL, off by default. Build with TESSERACT_OPENCL=true and
+# OPENCL_INCLUDE_PATH set to a directory holding the Khronos CL/ headers to
+# offload image preprocessing to the GPU. No OpenCL library is linked: the
+# vendor's libOpenCL.so is looked up at run time, and devices without one
+# run on the CPU as usual.
+
+ifeq ($(TESSERACT_OPENCL),true)
+LOCAL_CFLAGS += \
+  -DUSE_OPENCL \
+  -DCL_USE_DEPRECATED_OPENCL_1_2_APIS
+
+LOCAL_C_INCLUDES += \
+  $(OPENCL_INCLUDE_PATH)
+
+LOCAL_LDLIBS += \
+  -ldl
+endif
+
+# Vulkan, off by default. Build with TESSERACT_VULKAN=true to run the same
+# preprocessing through Vulkan compute on devices that have no OpenCL
+# driver. It needs APP_PLATFORM android-24 or later for the Vulkan headers,
+# and APP_STL c++_static for the NDK's shaderc, which compiles the shaders
+# when Tesseract starts. libvulkan.so is looked up at run time.
+
+ifeq ($(TESSERACT_VULKAN),true)
+LOCAL_CFLAGS += \
+  -DUSE_VULKAN
+
+LOCAL_STATIC_LIBRARIES += \
+  shaderc
+
+LOCAL_LDLIBS += \
+  -ldl
+endif
+
+# Production, off by default. Build with TESSERACT_PRODUCTION=true to compile
+# out the blamer hooks and the debug output guarded by tdebug and tdebug_on,
+# for apps that never set the *_debug params. Compare the two builds with
+# tessbench on the same images.
+
+ifeq ($(TESSERACT_PRODUCTION),true)
+LOCAL_CFLAGS += \
+  -DNO_BLAMER \
+  -DTESS_MAX_DEBUG_LEVEL=0
+endif
+
+# The tesseract flags, also used by tessbench.
+
+TESSERACT_C_INCLUDES := $(LOCAL_C_INCLUDES)
+TESSERACT_CFLAGS := $(LOCAL_CFLAGS)
+
 # jni
 
 LOCAL_SRC_FILES += \
@@ -71,6 +132,7 @@ LOCAL_C_INCLUDES += \
   $(LOCAL_PATH)
 
 LOCAL_LDLIBS += \
+  -landroid \
   -latomic \
   -ljnigraphics \
   -llog
@@ -82,3 +144,28 @@ LOCAL_SHARED_LIBRARIES := liblept
 LOCAL_DISABLE_FORMAT_STRING_CHECKS := true
 
 include $(BUILD_SHARED_LIBRARY)
+
+# tessbench, off by default. Build with TESSERACT_BENCH=true for a command
+# line benchmark of the native pipeline, to push with the libraries and run
+# through adb shell. See src/api/tessbench.cpp for its options and output.
+
+ifeq ($(TESSERACT_BENCH),true)
+include $(CLEAR_VARS)
+
+LOCAL_MODULE := tessbench
+LOCAL_SRC_FILES := src/api/tessbench.cpp
+LOCAL_C_INCLUDES := $(TESSERACT_C_INCLUDES)
+LOCAL_CFLAGS := $(TESSERACT_CFLAGS)
+LOCAL_LDLIBS := -latomic
+LOCAL_SHARED_LIBRARIES := libtess liblept
+
+include $(BUILD_EXECUTABLE)
+endif
+
+ifeq ($(TESSERACT_VULKAN),true)
+$(call import-module,third_party/shaderc)
+endif
+
+ifeq ($(TARGET_ARCH_ABI),armeabi-v7a)
+$(call import-module,android/cpufeatures)
+endif
@@ -63,18 +63,27 @@
 #include "pgedit.h"
 #include "paramsd.h"
 #include "output.h"
+#include "memoryusage.h"
+#include "pagearena.h"
 #include "globaloc.h"
 #include "globals.h"
 #include "edgblob.h"
 #include "equationdetect.h"
+#include "framehistory.h"
 #include "tessbox.h"
 #include "makerow.h"
 #include "otsuthr.h"
 #include "osdetect.h"
 #include "params.h"
 #include "renderer.h"
+#include "serialis.h"
 #include "strngs.h"
+#include "taskscheduler.h"
+#include "textbuffer.h"
+#include "threadpool.h"
+#include "tiffindex.h"
 #include "openclwrapper.h"
+#include "vulkanwrapper.h"
 
 BOOL_VAR(stream_filelist, FALSE, "Stream a filelist from stdin");
 
@@ -99,6 +108,8 @@ const char* kInputFile = "noname.tif";
 const char* kOldVarsFile = "failed_vars.txt";
 /** Max string length of an int.  */
 const int kMaxIntSize = 22;
+/** Max string length of a double printed with full precision.  */
+const int kMaxDoubleSize = 32;
 /**
  * Minimum believable resolution. Used as a default if there is no other
  * information, as it is safer to under-estimate than over-estimate.
@@ -107,10 +118,57 @@ const int kMinCredibleResolution = 70;
 /** Maximum believable resolution.  */
 const int kMaxCredibleResolution = 2400;
 
+// The fingerprint of a binary page for the result cache is the fraction of
+// black pixels in each cell of a kFingerprintSize x kFingerprintSize grid.
+const int kFingerprintSize = 32;
+
+// What a page must match to reuse the results of another.
+struct PageKey {
+  PageKey() : valid(false), left(0), top(0), width(0), height(0) {}
+
+  bool valid;
+  // The rectangle of the image.
+  int left, top, width, height;
+  // The parameters, which include the whitelist and the page segmentation
+  // mode, as GetParamsSnapshot writes them.
+  GenericVector<char> params;
+  // The black fraction of each cell, scaled to 255.
+  GenericVector<uinT8> fingerprint;
+};
+
+// The results of the last recognized page, and the key of the current page
+// to set them aside with, for tessedit_result_cache.
+struct ResultCache {
+  ResultCache()
+    : page_res(NULL), block_list(NULL), paragraph_models(NULL) {}
+  ~ResultCache() { Clear(); }
+
+  void Clear() {
+    delete page_res;
+    page_res = NULL;
+    delete block_list;
+    block_list = NULL;
+    if (paragraph_models != NULL) {
+      paragraph_models->delete_data_pointers();
+      delete paragraph_models;
+      paragraph_models = NULL;
+    }
+    key.valid = false;
+  }
+
+  PageKey page_key;
+  PageKey key;
+  PAGE_RES* page_res;
+  BLOCK_LIST* block_list;
+  GenericVector<ParagraphModel*>* paragraph_models;
+};
+
 TessBaseAPI::TessBaseAPI()
   : tesseract_(NULL),
     osd_tesseract_(NULL),
     equ_detect_(NULL),
+    frame_history_(NULL),
+    result_cache_(NULL),
     // Thresholder is initialized to NULL here, but will be set before use by:
     // A constructor of a derived API,  SetThresholder(), or
     // created implicitly when used in InternalSetImage.
@@ -118,6 +176,12 @@ TessBaseAPI::TessBaseAPI()
     paragraph_models_(NULL),
     block_list_(NULL),
     page_res_(NULL),
+    arena_stats_(new PageArenaStats),
+    page_peak_bytes_(0),
+    params_snapshot_(NULL),
+    word_workers_(NULL),
+    tables_(NULL),
+    priority_regions_(NULL),
     input_file_(NULL),
     output_file_(NULL),
     datapath_(NULL),
@@ -132,6 +196,9 @@ TessBaseAPI::TessBaseAPI()
 
 TessBaseAPI::~TessBaseAPI() {
   End();
+  delete arena_stats_;
+  delete params_snapshot_;
+  boxaDestroy(&priority_regions_);
 }
 
 /**
@@ -173,6 +240,22 @@ size_t TessBaseAPI::getOpenCLDevice(void **data) {
   return 0;
 }
 
+void TessBaseAPI::SetOpenCLCacheDir(const char* dir) {
+#ifdef USE_OPENCL
+  OpenclDevice::SetCacheDir(dir);
+#endif
+}
+
+bool TessBaseAPI::GetOpenCLRoutes(STRING* report) {
+  *report = "";
+#ifdef USE_OPENCL
+  OpenclDevice::GetRoutes(report);
+  return true;
+#else
+  return false;
+#endif
+}
+
 /**
  * Writes the thresholded image to stderr as a PBM file on receipt of a
  * SIGSEGV, SIGFPE, or SIGBUS signal. (Linux/Unix only).
@@ -192,6 +275,11 @@ void TessBaseAPI::CatchSignals() {
 #endif
 }
 
+void TessBaseAPI::ConfigureWorkerThreads(int num_workers,
+                                         bool big_cores_only) {
+  TaskScheduler::Configure(num_workers, big_cores_only);
+}
+
 /**
  * Set the name of the input file. Needed only for training and
  * loading a UNLV zone file.
@@ -217,6 +305,14 @@ bool TessBaseAPI::SetVariable(const char* name, const char* value) {
                               tesseract_->params());
 }
 
+int TessBaseAPI::SetVariables(const char* const* name_values,
+                              int num_variables) {
+  if (tesseract_ == NULL) tesseract_ = new Tesseract;
+  return ParamUtils::SetParams(name_values, num_variables,
+                               SET_PARAM_CONSTRAINT_NON_INIT_ONLY,
+                               tesseract_->params());
+}
+
 bool TessBaseAPI::SetDebugVariable(const char* name, const char* value) {
   if (tesseract_ == NULL) tesseract_ = new Tesseract;
   return ParamUtils::SetParam(name, value, SET_PARAM_CONSTRAINT_DEBUG_ONLY,
@@ -224,30 +320,26 @@ bool TessBaseAPI::SetDebugVariable(const char* name, const char* value) {
 }
 
 bool TessBaseAPI::GetIntVariable(const char *name, int *value) const {
-  IntParam *p = ParamUtils::FindParam<IntParam>(
-      name, GlobalParams()->int_params, tesseract_->params()->int_params);
+  IntParam *p = ParamUtils::FindParam<IntParam>(name, tesseract_->params());
   if (p == NULL) return false;
   *value = (inT32)(*p);
   return true;
 }
 
 bool TessBaseAPI::GetBoolVariable(const char *name, bool *value) const {
-  BoolParam *p = ParamUtils::FindParam<BoolParam>(
-      name, GlobalParams()->bool_params, tesseract_->params()->bool_params);
+  BoolParam *p = ParamUtils::FindParam<BoolParam>(name, tesseract_->params());
   if (p == NULL) return false;
   *value = (BOOL8)(*p);
   return true;
 }
 
 const char *TessBaseAPI::GetStringVariable(const char *name) const {
-  StringParam *p = ParamUtils::FindParam<StringParam>(
-      name, GlobalParams()->string_params, tesseract_->params()->string_params);
+  StringParam *p = ParamUtils::FindParam<StringParam>(name, tesseract_->params());
   return (p != NULL) ? p->string() : NULL;
 }
 
 bool TessBaseAPI::GetDoubleVariable(const char *name, double *value) const {
-  DoubleParam *p = ParamUtils::FindParam<DoubleParam>(
-      name, GlobalParams()->double_params, tesseract_->params()->double_params);
+  DoubleParam *p = ParamUtils::FindParam<DoubleParam>(name, tesseract_->params());
   if (p == NULL) return false;
   *value = (double)(*p);
   return true;
@@ -288,19 +380,24 @@ int TessBaseAPI::Init(const char* datapath, const char* language,
       (datapath_ == NULL || language_ == NULL ||
        *datapath_ != datapath || last_oem_requested_ != oem ||
        (*language_ != language && tesseract_->lang != language))) {
+    ClearWordWorkers();
     delete tesseract_;
     tesseract_ = NULL;
   }
   // PERF_COUNT_SUB("delete tesseract_")
 #ifdef USE_OPENCL
-  OpenclDevice od;
-  od.InitEnv();
+  // Compiles the kernels, or loads them from the cache, in the background.
+  OpenclDevice::InitEnvAsync();
+#endif
+#ifdef USE_VULKAN
+  VulkanDevice::InitEnvAsync();
 #endif
-  PERF_COUNT_SUB("OD::InitEnv()")
+  PERF_COUNT_SUB("OD::InitEnvAsync()")
   bool reset_classifier = true;
   if (tesseract_ == NULL) {
     reset_classifier = false;
     tesseract_ = new Tesseract;
+    tesseract_->set_params_snapshot(params_snapshot_);
     if (tesseract_->init_tesseract(
         datapath, output_file_ != NULL ? output_file_->string() : NULL,
         language, oem, configs, configs_size, vars_vec, vars_values,
@@ -333,6 +430,105 @@ int TessBaseAPI::Init(const char* datapath, const char* language,
   return 0;
 }
 
+int TessBaseAPI::InitLike(const TessBaseAPI& source) {
+  if (source.tesseract_ == NULL || source.datapath_ == NULL ||
+      source.language_ == NULL)
+    return -1;
+  // Pass every member parameter of source as an init variable, so that
+  // even the ones that only take effect at Init are copied.
+  ParamsVectors* params = source.tesseract_->params();
+  GenericVector<STRING> vars_vec;
+  GenericVector<STRING> vars_values;
+  char value[kMaxDoubleSize];
+  for (int i = 0; i < params->int_params.size(); ++i) {
+    snprintf(value, sizeof(value), "%d",
+             static_cast<inT32>(*params->int_params[i]));
+    vars_vec.push_back(params->int_params[i]->name_str());
+    vars_values.push_back(value);
+  }
+  for (int i = 0; i < params->bool_params.size(); ++i) {
+    vars_vec.push_back(params->bool_params[i]->name_str());
+    vars_values.push_back(*params->bool_params[i] ? "1" : "0");
+  }
+  for (int i = 0; i < params->string_params.size(); ++i) {
+    vars_vec.push_back(params->string_params[i]->name_str());
+    vars_values.push_back(params->string_params[i]->string());
+  }
+  for (int i = 0; i < params->double_params.size(); ++i) {
+    snprintf(value, sizeof(value), "%.17g",
+             static_cast<double>(*params->double_params[i]));
+    vars_vec.push_back(params->double_params[i]->name_str());
+    vars_values.push_back(value);
+  }
+  return Init(source.datapath_->string(), source.language_->string(),
+              source.last_oem_requested_, NULL, 0, &vars_vec, &vars_values,
+              false);
+}
+
+// Copies the values of the member params of source to target, which has
+// the same params as it was initialized with the same languages.
+static void CopyMemberParams(Tesseract* source, Tesseract* target) {
+  ParamsVectors* from = source->params();
+  ParamsVectors* to = target->params();
+  for (int i = 0; i < from->int_params.size(); ++i)
+    to->int_params[i]->set_value(*from->int_params[i]);
+  for (int i = 0; i < from->bool_params.size(); ++i)
+    to->bool_params[i]->set_value(*from->bool_params[i]);
+  for (int i = 0; i < from->string_params.size(); ++i)
+    to->string_params[i]->set_value(*from->string_params[i]);
+  for (int i = 0; i < from->double_params.size(); ++i)
+    to->double_params[i]->set_value(*from->double_params[i]);
+}
+
+void TessBaseAPI::PrepareWorkers(int num_workers) {
+  if (num_workers <= 0 && word_workers_ == NULL) return;
+  if (word_workers_ == NULL) word_workers_ = new GenericVector<TessBaseAPI*>;
+  while (word_workers_->size() > MAX(num_workers, 0))
+    delete word_workers_->pop_back();
+  while (word_workers_->size() < num_workers) {
+    TessBaseAPI* worker = new TessBaseAPI;
+    if (worker->InitLike(*this) != 0) {
+      delete worker;
+      break;
+    }
+    word_workers_->push_back(worker);
+  }
+  for (int i = 0; i < word_workers_->size(); ++i) {
+    Tesseract* engine = (*word_workers_)[i]->tesseract_;
+    // Variables may have been set since the worker was made.
+    CopyMemberParams(tesseract_, engine);
+    for (int s = 0; s < engine->num_sub_langs() &&
+         s < tesseract_->num_sub_langs(); ++s) {
+      CopyMemberParams(tesseract_->get_sub_lang(s), engine->get_sub_lang(s));
+    }
+    // The workers only recognize on the threads of tesseract_.
+    engine->tessedit_parallelize.set_value(0);
+    engine->tessedit_parallel_words.set_value(false);
+    engine->SetBlackAndWhitelist();
+  }
+}
+
+void TessBaseAPI::PrepareWordWorkers() {
+  // The workers are busy with the cells of RecognizeTables.
+  if (tesseract_->recognizing_in_parallel()) return;
+  PrepareWorkers(tesseract_->tessedit_parallel_words
+                 ? tesseract_->tessedit_parallelize - 1 : 0);
+  if (word_workers_ == NULL) return;
+  GenericVector<Tesseract*> engines;
+  for (int i = 0; i < word_workers_->size(); ++i)
+    engines.push_back((*word_workers_)[i]->tesseract_);
+  tesseract_->set_word_workers(engines);
+}
+
+void TessBaseAPI::ClearWordWorkers() {
+  if (word_workers_ == NULL) return;
+  word_workers_->delete_data_pointers();
+  delete word_workers_;
+  word_workers_ = NULL;
+  if (tesseract_ != NULL)
+    tesseract_->set_word_workers(GenericVector<Tesseract*>());
+}
+
 /**
  * Returns the languages string used in the last valid initialization.
  * If the last initialization specified "deu+hin" then that will be
@@ -432,10 +628,37 @@ int TessBaseAPI::InitLangMod(const char* datapath, const char* language) {
 void TessBaseAPI::InitForAnalysePage() {
   if (tesseract_ == NULL) {
     tesseract_ = new Tesseract;
+    if (params_snapshot_ != NULL) {
+      TFile fp;
+      fp.Open(&(*params_snapshot_)[0], params_snapshot_->size());
+      if (!ParamUtils::DeSerializeParams(&fp, tesseract_->params()))
+        tprintf("Invalid params snapshot\n");
+    }
     tesseract_->InitAdaptiveClassifier(false);
   }
 }
 
+/** Writes the current parameters to data. See SetParamsSnapshot. */
+bool TessBaseAPI::GetParamsSnapshot(GenericVector<char>* data) const {
+  if (tesseract_ == NULL) return false;
+  data->truncate(0);
+  TFile fp;
+  fp.OpenWrite(data);
+  return ParamUtils::SerializeParams(tesseract_->params(), &fp);
+}
+
+/** Keeps a copy of data to set the parameters of the next Init. */
+void TessBaseAPI::SetParamsSnapshot(const char* data, int size) {
+  if (data == NULL || size <= 0) {
+    delete params_snapshot_;
+    params_snapshot_ = NULL;
+    return;
+  }
+  if (params_snapshot_ == NULL) params_snapshot_ = new GenericVector<char>;
+  params_snapshot_->init_to_size(size, 0);
+  memcpy(&(*params_snapshot_)[0], data, size);
+}
+
 /**
  * Read a "config" file containing a set of parameter name, value pairs.
  * Searches the standard places: tessdata/configs, tessdata/tessconfigs
@@ -511,6 +734,47 @@ void TessBaseAPI::ClearAdaptiveClassifier() {
   tesseract_->ResetDocumentDictionary();
 }
 
+/** Forgets all per-document state but keeps the loaded models. */
+void TessBaseAPI::ResetForNewDocument(bool keep_adaptive) {
+  Clear();
+  ClearFrameHistory();
+  if (tesseract_ == NULL)
+    return;
+  tesseract_->ResetForNewDocument(keep_adaptive);
+}
+
+bool TessBaseAPI::GetClassifyCacheStats(int* hits, int* misses) const {
+  if (tesseract_ == NULL || tesseract_->classify_cache() == NULL)
+    return false;
+  *hits = tesseract_->classify_cache()->hits();
+  *misses = tesseract_->classify_cache()->misses();
+  return true;
+}
+
+bool TessBaseAPI::SaveAdaptiveState(GenericVector<char>* buffer) const {
+  if (tesseract_ == NULL) return false;
+  buffer->truncate(0);
+  return tesseract_->SaveAdaptiveState(buffer);
+}
+
+bool TessBaseAPI::LoadAdaptiveState(const char* data, int size) {
+  if (tesseract_ == NULL || data == NULL || size <= 0) return false;
+  return tesseract_->LoadAdaptiveState(data, size);
+}
+
+bool TessBaseAPI::SetCharNgramTable(const char* data, int size) {
+  if (tesseract_ == NULL || data == NULL || size <= 0) return false;
+  TFile fp;
+  if (!fp.Open(data, size)) return false;
+  CharNgramTable* table = new CharNgramTable;
+  if (!table->DeSerialize(false, &fp)) {
+    delete table;
+    return false;
+  }
+  tesseract_->getDict().SetCharNgramTable(table);
+  return true;
+}
+
 /**
  * Provide an image for Tesseract to recognize. Format is as
  * TesseractRect above. Copies the image buffer and converts to Pix.
@@ -550,6 +814,39 @@ void TessBaseAPI::SetImage(Pix* pix) {
   }
 }
 
+/**
+ * Provide an image for Tesseract to recognize as rows of 32 bit RGBA
+ * pixels, with the bytes in R, G, B, A order in memory, as locked from an
+ * Android RGBA_8888 bitmap. The pixels are converted to greyscale straight
+ * into the thresholder, without an intermediate Pix, and the grey histogram
+ * is gathered on the way so Otsu thresholding of the full image needs no
+ * extra pass. Tesseract takes its own copy, so the rows need not persist
+ * after this call.
+ */
+void TessBaseAPI::SetRGBAImageAsGrey(const unsigned char* rgba,
+                                     int width, int height,
+                                     int bytes_per_line) {
+  if (InternalSetImage()) {
+    thresholder_->SetRGBAImageAsGrey(rgba, width, height, bytes_per_line);
+    SetInputImage(thresholder_->GetPixRect());
+  }
+}
+
+/**
+ * Provide an image for Tesseract to recognize as rows of 8 bit grey pixels,
+ * such as the Y plane of a camera frame. The rows are copied straight into
+ * the thresholder with the grey histogram gathered on the way, so they need
+ * not persist after this call.
+ */
+void TessBaseAPI::SetGreyImage(const unsigned char* grey,
+                               int width, int height,
+                               int bytes_per_line) {
+  if (InternalSetImage()) {
+    thresholder_->SetGreyImage(grey, width, height, bytes_per_line);
+    SetInputImage(thresholder_->GetPixRect());
+  }
+}
+
 /**
  * Restrict recognition to a sub-rectangle of the image. Call after SetImage.
  * Each SetRectangle clears the recogntion results so multiple rectangles
@@ -562,6 +859,19 @@ void TessBaseAPI::SetRectangle(int left, int top, int width, int height) {
   ClearResults();
 }
 
+void TessBaseAPI::SetPriorityRegions(const Boxa* regions) {
+  boxaDestroy(&priority_regions_);
+  if (regions != NULL && boxaGetCount(const_cast<Boxa*>(regions)) > 0)
+    priority_regions_ = boxaCopy(const_cast<Boxa*>(regions), L_COPY);
+}
+
+void TessBaseAPI::SetPriorityPoint(int x, int y) {
+  Boxa* regions = boxaCreate(1);
+  boxaAddBox(regions, boxCreate(x, y, 1, 1), L_INSERT);
+  SetPriorityRegions(regions);
+  boxaDestroy(&regions);
+}
+
 /**
  * ONLY available after SetImage if you have Leptonica installed.
  * Get a copy of the internal thresholded image from Tesseract.
@@ -718,6 +1028,46 @@ Boxa* TessBaseAPI::GetComponentImages(PageIteratorLevel level,
   return boxa;
 }
 
+/**
+ * Returns the image of the component at the given index in the Boxa that
+ * GetComponentImages returns for the same level, text_only, raw_image and
+ * raw_padding, or NULL if there is no such component.
+ */
+Pix* TessBaseAPI::GetComponentImage(PageIteratorLevel level, bool text_only,
+                                    bool raw_image, const int raw_padding,
+                                    int index) {
+  if (index < 0)
+    return NULL;
+  PageIterator* page_it = GetIterator();
+  if (page_it == NULL)
+    page_it = AnalyseLayout();
+  if (page_it == NULL)
+    return NULL;  // Failed.
+
+  // Count the components the same way as GetComponentImages.
+  int left, top, right, bottom;
+  Pix* pix = NULL;
+  int component_index = 0;
+  do {
+    bool has_box = raw_image
+        ? page_it->BoundingBox(level, raw_padding, &left, &top, &right, &bottom)
+        : page_it->BoundingBoxInternal(level, &left, &top, &right, &bottom);
+    if (!has_box || (text_only && !PTIsTextType(page_it->BlockType())))
+      continue;
+    if (component_index++ < index)
+      continue;
+    if (raw_image) {
+      pix = page_it->GetImage(level, raw_padding, GetInputImage(), &left,
+                              &top);
+    } else {
+      pix = page_it->GetBinaryImage(level);
+    }
+    break;
+  } while (page_it->Next(level));
+  delete page_it;
+  return pix;
+}
+
 int TessBaseAPI::GetThresholdedImageScaleFactor() const {
   if (thresholder_ == NULL) {
     return 0;
@@ -817,11 +1167,57 @@ PageIterator* TessBaseAPI::AnalyseLayout(bool merge_similar_words) {
     return new PageIterator(
         page_res_, tesseract_, thresholder_->GetScaleFactor(),
         thresholder_->GetScaledYResolution(),
-        rect_left_, rect_top_, rect_width_, rect_height_);
+        rect_left_, rect_top_, rect_width_, rect_height_,
+        thresholder_->GetReductionFactor());
   }
   return NULL;
 }
 
+/**
+ * Finds the text lines of the image without recognition or full layout
+ * analysis. See the header for details.
+ */
+Boxa* TessBaseAPI::DetectTextLines(Numa** scores) {
+  if (scores != NULL) *scores = NULL;
+  if (thresholder_ == NULL || thresholder_->IsEmpty()) {
+    tprintf("Please call SetImage before attempting text detection.\n");
+    return NULL;
+  }
+  if (tesseract_ == NULL) {
+    tesseract_ = new Tesseract;
+    tesseract_->InitAdaptiveClassifier(false);
+  }
+  if (tesseract_->pix_binary() == NULL)
+    Threshold(tesseract_->mutable_pix_binary());
+  if (tesseract_->ImageWidth() > MAX_INT16 ||
+      tesseract_->ImageHeight() > MAX_INT16) {
+    tprintf("Image too large: (%d, %d)\n",
+            tesseract_->ImageWidth(), tesseract_->ImageHeight());
+    return NULL;
+  }
+  GenericVector<TBOX> lines;
+  GenericVector<float> line_scores;
+  tesseract_->DetectTextLines(&lines, &line_scores);
+  // Convert to the top-down coordinates of the original image.
+  int scale = thresholder_->GetScaleFactor();
+  int reduction = thresholder_->GetReductionFactor();
+  int pix_height = pixGetHeight(tesseract_->pix_binary());
+  Boxa* boxa = boxaCreate(lines.size());
+  if (scores != NULL) *scores = numaCreate(lines.size());
+  for (int i = 0; i < lines.size(); ++i) {
+    const TBOX& box = lines[i];
+    int left = box.left() * reduction / scale + rect_left_;
+    int top = (pix_height - box.top()) * reduction / scale + rect_top_;
+    int right = (box.right() * reduction + scale - 1) / scale + rect_left_;
+    int bottom = ((pix_height - box.bottom()) * reduction + scale - 1) / scale +
+                 rect_top_;
+    boxaAddBox(boxa, boxCreate(left, top, right - left, bottom - top),
+               L_INSERT);
+    if (scores != NULL) numaAddNumber(*scores, line_scores[i]);
+  }
+  return boxa;
+}
+
 /**
  * Recognize the tesseract global image and return the result as Tesseract
  * internal structures.
@@ -829,8 +1225,28 @@ PageIterator* TessBaseAPI::AnalyseLayout(bool merge_similar_words) {
 int TessBaseAPI::Recognize(ETEXT_DESC* monitor) {
   if (tesseract_ == NULL)
     return -1;
-  if (FindLines() != 0)
+  // Layout analysis checks the monitor between its stages too.
+  tesseract_->set_layout_monitor(monitor);
+  int find_lines_result = FindLines();
+  bool layout_cancelled =
+      find_lines_result != 0 && tesseract_->LayoutCancelled();
+  tesseract_->set_layout_monitor(NULL);
+  if (layout_cancelled) {
+    // As when recognition is cancelled, the page has the results found so
+    // far, which are none, but they are not for the result cache.
+    block_list_->clear();
+    if (result_cache_ != NULL) result_cache_->page_key.valid = false;
+    delete page_res_;
+    page_res_ = new PAGE_RES(false, block_list_,
+                             &tesseract_->prev_word_best_choice_);
+    recognition_done_ = true;
     return -1;
+  }
+  if (find_lines_result != 0)
+    return -1;
+  // FindLines took the results from the result cache.
+  if (recognition_done_)
+    return 0;
   delete page_res_;
   if (block_list_->empty()) {
     page_res_ = new PAGE_RES(false, block_list_,
@@ -846,62 +1262,839 @@ int TessBaseAPI::Recognize(ETEXT_DESC* monitor) {
     page_res_ = tesseract_->ApplyBoxes(*input_file_, false, block_list_);
   } else {
     // TODO(rays) LSTM here.
+    PageArena* arena = NULL;
+    if (tesseract_->tessedit_page_arena)
+      arena = new PageArena(arena_stats_);
+    PageArena::Scope arena_scope(arena);
     page_res_ = new PAGE_RES(false,
                              block_list_, &tesseract_->prev_word_best_choice_);
+    page_res_->arena = arena;
   }
   if (page_res_ == NULL) {
     return -1;
   }
+  // The words made while recognizing go in the arena of the page, if any.
+  PageArena::Scope arena_scope(page_res_->arena);
   if (tesseract_->tessedit_make_boxes_from_boxes) {
     tesseract_->CorrectClassifyWords(page_res_);
     return 0;
   }
 
-  if (truth_cb_ != NULL) {
-    tesseract_->wordrec_run_blamer.set_value(true);
-    PageIterator *page_it = new PageIterator(
-            page_res_, tesseract_, thresholder_->GetScaleFactor(),
-            thresholder_->GetScaledYResolution(),
-            rect_left_, rect_top_, rect_width_, rect_height_);
-    truth_cb_->Run(tesseract_->getDict().getUnicharset(),
-                   image_height_, page_it, this->tesseract()->pix_grey());
-    delete page_it;
+  if (truth_cb_ != NULL) {
+    tesseract_->wordrec_run_blamer.set_value(true);
+    PageIterator *page_it = new PageIterator(
+            page_res_, tesseract_, thresholder_->GetScaleFactor(),
+            thresholder_->GetScaledYResolution(),
+            rect_left_, rect_top_, rect_width_, rect_height_,
+            thresholder_->GetReductionFactor());
+    truth_cb_->Run(tesseract_->getDict().getUnicharset(),
+                   image_height_, page_it, this->tesseract()->pix_grey());
+    delete page_it;
+  }
+
+  int result = 0;
+  if (tesseract_->interactive_display_mode) {
+    #ifndef GRAPHICS_DISABLED
+    tesseract_->pgeditor_main(rect_width_, rect_height_, page_res_);
+    #endif  // GRAPHICS_DISABLED
+    // The page_res is invalid after an interactive session, so cleanup
+    // in a way that lets us continue to the next page without crashing.
+    delete page_res_;
+    page_res_ = NULL;
+    return -1;
+  } else if (tesseract_->tessedit_train_from_boxes) {
+    STRING fontname;
+    ExtractFontName(*output_file_, &fontname);
+    tesseract_->ApplyBoxTraining(fontname, page_res_);
+  } else if (tesseract_->tessedit_ambigs_training) {
+    FILE *training_output_file = tesseract_->init_recog_training(*input_file_);
+    // OCR the page segmented into words by tesseract.
+    tesseract_->recog_training_segmented(
+        *input_file_, page_res_, monitor, training_output_file);
+    fclose(training_output_file);
+  } else {
+    // Now run the main recognition.
+    bool wait_for_text = true;
+    GetBoolVariable("paragraph_text_based", &wait_for_text);
+    if (!wait_for_text) DetectParagraphs(false);
+    PrepareWordWorkers();
+    TessCallback1<const PAGE_RES_IT&>* line_callback = NULL;
+    if (monitor != NULL && monitor->line_callback != NULL) {
+      line_callback = NewPermanentTessCallback(this, &TessBaseAPI::ReportLine,
+                                               monitor);
+    }
+    tesseract_->set_line_callback(line_callback);
+    GenericVector<TBOX> priority_boxes;
+    GetPriorityBoxes(&priority_boxes);
+    tesseract_->set_priority_boxes(priority_boxes);
+    bool recognized =
+        tesseract_->recog_all_words(page_res_, monitor, NULL, NULL, 0);
+    tesseract_->set_line_callback(NULL);
+    tesseract_->set_priority_boxes(GenericVector<TBOX>());
+    delete line_callback;
+    if (recognized) {
+      if (wait_for_text && tesseract_->paragraph_on_demand) {
+        page_res_->paragraph_detector =
+            NewTessCallback(this, &TessBaseAPI::DetectParagraphs, true);
+      } else if (wait_for_text) {
+        DetectParagraphs(true);
+      }
+    } else {
+      result = -1;
+    }
+  }
+  page_peak_bytes_ = MAX(page_peak_bytes_, PageMemoryUsed());
+  return result;
+}
+
+void TessBaseAPI::GetPriorityBoxes(GenericVector<TBOX>* boxes) {
+  boxes->truncate(0);
+  if (priority_regions_ == NULL) return;
+  // The inverse of the mapping of the iterators to image coordinates.
+  int scale = thresholder_->GetScaleFactor();
+  int reduction = thresholder_->GetReductionFactor();
+  int height = pixGetHeight(tesseract_->pix_binary());
+  int num_regions = boxaGetCount(priority_regions_);
+  for (int r = 0; r < num_regions; ++r) {
+    l_int32 x, y, w, h;
+    boxaGetBoxGeometry(priority_regions_, r, &x, &y, &w, &h);
+    int left = (x - rect_left_) * scale / reduction;
+    int top = (y - rect_top_) * scale / reduction;
+    int right = (x + w - rect_left_) * scale / reduction;
+    int bottom = (y + h - rect_top_) * scale / reduction;
+    boxes->push_back(TBOX(left, height - bottom, right, height - top));
+  }
+}
+
+void TessBaseAPI::ReportLine(ETEXT_DESC* monitor, const PAGE_RES_IT& line) {
+  LTRResultIterator* it = GetLTRIterator();
+  if (it == NULL) return;
+  // The line is at most a page of words away.
+  while (!it->PositionedAtSameWord(&line) && it->Next(RIL_WORD)) {}
+  if (it->PositionedAtSameWord(&line))
+    (*monitor->line_callback)(monitor->line_this, it);
+  delete it;
+}
+
+/**
+ * Recognize a list of rectangles of the current image, thresholding the
+ * whole image once instead of once per rectangle.
+ */
+char* TessBaseAPI::RecognizeRegions(const Boxa* regions, PageSegMode mode,
+                                    ETEXT_DESC* monitor, int* confidences) {
+  if (tesseract_ == NULL || regions == NULL)
+    return NULL;
+  if (thresholder_ == NULL || thresholder_->IsEmpty()) {
+    tprintf("Please call SetImage before attempting recognition.");
+    return NULL;
+  }
+  int saved_left, saved_top, saved_width, saved_height;
+  int image_width, image_height;
+  thresholder_->GetImageSizes(&saved_left, &saved_top,
+                              &saved_width, &saved_height,
+                              &image_width, &image_height);
+  PageSegMode saved_mode = GetPageSegMode();
+  SetPageSegMode(mode);
+
+  Pix* page_binary;
+  Pix* page_grey;
+  Pix* page_thresholds;
+  ThresholdPage(&page_binary, &page_grey, &page_thresholds);
+
+  // Each region's text is appended with its terminating '\0', which STRING
+  // cannot hold.
+  GenericVector<char> text;
+  int num_regions = boxaGetCount(const_cast<Boxa*>(regions));
+  for (int i = 0; i < num_regions; ++i) {
+    if (confidences != NULL) confidences[i] = 0;
+    Box* box = boxaGetBox(const_cast<Boxa*>(regions), i, L_CLONE);
+    Box* clipped = box != NULL && page_binary != NULL
+        ? boxClipToRectangle(box, image_width, image_height) : NULL;
+    boxDestroy(&box);
+    l_int32 x, y, w, h;
+    if (clipped != NULL &&
+        boxGetGeometry(clipped, &x, &y, &w, &h) == 0 && w > 0 && h > 0) {
+      int confidence;
+      char* region_text = RecognizeClippedRegion(page_binary, page_grey,
+                                                 page_thresholds, x, y, w, h,
+                                                 monitor, &confidence);
+      if (region_text != NULL) {
+        for (const char* ch = region_text; *ch != '\0'; ++ch)
+          text.push_back(*ch);
+        delete [] region_text;
+        if (confidences != NULL) confidences[i] = confidence;
+      }
+    }
+    boxDestroy(&clipped);
+    text.push_back('\0');
+  }
+  pixDestroy(&page_binary);
+  pixDestroy(&page_grey);
+  pixDestroy(&page_thresholds);
+
+  SetPageSegMode(saved_mode);
+  SetRectangle(saved_left, saved_top, saved_width, saved_height);
+  char* result = new char[text.size() + 1];
+  for (int i = 0; i < text.size(); ++i)
+    result[i] = text[i];
+  result[text.size()] = '\0';
+  return result;
+}
+
+/**
+ * Recognizes only the text regions found in a reduced copy of the image.
+ * See the header for details.
+ */
+char* TessBaseAPI::RecognizeTextRegions(int reduction, PageSegMode mode,
+                                        ETEXT_DESC* monitor, Boxa** regions,
+                                        int** confidences) {
+  if (regions != NULL) *regions = NULL;
+  if (confidences != NULL) *confidences = NULL;
+  if (tesseract_ == NULL)
+    return NULL;
+  if (thresholder_ == NULL || thresholder_->IsEmpty()) {
+    tprintf("Please call SetImage before attempting recognition.");
+    return NULL;
+  }
+  int saved_left, saved_top, saved_width, saved_height;
+  int image_width, image_height;
+  thresholder_->GetImageSizes(&saved_left, &saved_top,
+                              &saved_width, &saved_height,
+                              &image_width, &image_height);
+  Boxa* found = FindTextRegions(reduction);
+  if (found == NULL)
+    return NULL;
+  PageSegMode saved_mode = GetPageSegMode();
+  SetPageSegMode(mode);
+
+  STRING text;
+  int num_regions = boxaGetCount(found);
+  int* region_confs = new int[num_regions + 1];
+  for (int i = 0; i < num_regions; ++i) {
+    region_confs[i] = 0;
+    l_int32 x, y, w, h;
+    boxaGetBoxGeometry(found, i, &x, &y, &w, &h);
+    // Only this rectangle of the full resolution image is thresholded.
+    SetRectangle(x, y, w, h);
+    if (Recognize(monitor) < 0)
+      continue;
+    char* region_text = GetUTF8Text();
+    if (region_text != NULL) {
+      text += region_text;
+      delete [] region_text;
+      region_confs[i] = MeanTextConf();
+    }
+  }
+
+  SetPageSegMode(saved_mode);
+  SetRectangle(saved_left, saved_top, saved_width, saved_height);
+  if (confidences != NULL)
+    *confidences = region_confs;
+  else
+    delete [] region_confs;
+  if (regions != NULL)
+    *regions = found;
+  else
+    boxaDestroy(&found);
+  char* result = new char[text.length() + 1];
+  strncpy(result, text.string(), text.length() + 1);
+  return result;
+}
+
+// A block of one strip of RecognizeStrips, in image coordinates. parent is
+// the index of a block of an earlier strip that it continues, or its own.
+struct StripBlock {
+  int left, top, right, bottom;
+  int parent;
+};
+
+// A text line of RecognizeStrips, in image coordinates, and its block.
+struct StripLine {
+  int block;
+  int left, top, right, bottom;
+  int conf;
+  STRING text;
+};
+
+// Returns the index of the first block of the blocks joined to block b.
+static int FirstStripBlock(const GenericVector<StripBlock>& blocks, int b) {
+  while (blocks[b].parent != b) b = blocks[b].parent;
+  return b;
+}
+
+// Adds the lines of it, which iterates over the results of a strip, whose
+// middles lie in [own_top, own_bottom), and the blocks that have any.
+static void CollectStripLines(ResultIterator* it, int own_top,
+                              int own_bottom,
+                              GenericVector<StripBlock>* blocks,
+                              GenericVector<StripLine>* lines) {
+  // The block of the strip that it is in, and the last one added.
+  int strip_block = -1;
+  int added_block = -1;
+  it->Begin();
+  do {
+    if (it->IsAtBeginningOf(RIL_BLOCK)) ++strip_block;
+    if (it->Empty(RIL_TEXTLINE)) continue;
+    StripLine line;
+    it->BoundingBox(RIL_TEXTLINE, &line.left, &line.top, &line.right,
+                    &line.bottom);
+    int middle = (line.top + line.bottom) / 2;
+    if (middle < own_top || middle >= own_bottom) continue;
+    if (added_block != strip_block) {
+      StripBlock block;
+      it->BoundingBox(RIL_BLOCK, &block.left, &block.top, &block.right,
+                      &block.bottom);
+      block.parent = blocks->size();
+      blocks->push_back(block);
+      added_block = strip_block;
+    }
+    char* text = it->GetUTF8Text(RIL_TEXTLINE);
+    if (text == NULL) continue;
+    line.block = blocks->size() - 1;
+    line.conf = static_cast<int>(it->Confidence(RIL_TEXTLINE));
+    line.text = text;
+    delete [] text;
+    lines->push_back(line);
+  } while (it->Next(RIL_TEXTLINE));
+}
+
+/**
+ * Recognizes the current rectangle in overlapping strips.
+ * See the header for details.
+ */
+char* TessBaseAPI::RecognizeStrips(int strip_height, int overlap,
+                                   ETEXT_DESC* monitor, Boxa** lines,
+                                   int** confidences) {
+  if (lines != NULL) *lines = NULL;
+  if (confidences != NULL) *confidences = NULL;
+  if (tesseract_ == NULL || overlap < 0 || strip_height <= overlap)
+    return NULL;
+  if (thresholder_ == NULL || thresholder_->IsEmpty()) {
+    tprintf("Please call SetImage before attempting recognition.");
+    return NULL;
+  }
+  int saved_left, saved_top, saved_width, saved_height;
+  int image_width, image_height;
+  thresholder_->GetImageSizes(&saved_left, &saved_top,
+                              &saved_width, &saved_height,
+                              &image_width, &image_height);
+  int step = strip_height - overlap;
+  int end = saved_top + saved_height;
+  GenericVector<StripBlock> blocks;
+  GenericVector<StripLine> strip_lines;
+  // The seam between the strips above and below, where the blocks of the
+  // strip above start in blocks.
+  int seam = saved_top;
+  int first_block_above = 0;
+  for (int strip = 0, top = saved_top; top < end; ++strip, top += step) {
+    int height = MIN(strip_height, end - top);
+    // The lines of the overlaps go to the strip in which they are furthest
+    // from the edge.
+    int own_bottom = top + height >= end ? end : top + step + overlap / 2;
+    int first_block = blocks.size();
+    // Only this strip of the image is thresholded and segmented.
+    SetRectangle(saved_left, top, saved_width, height);
+    if (Recognize(monitor) >= 0) {
+      ResultIterator* it = GetIterator();
+      if (it != NULL) {
+        CollectStripLines(it, seam, own_bottom, &blocks, &strip_lines);
+        delete it;
+      }
+    }
+    // Join the blocks that cross the seam to those of the strip above that
+    // they overlap horizontally by more than half the narrower one.
+    for (int b = first_block; strip > 0 && b < blocks.size(); ++b) {
+      for (int a = first_block_above; a < first_block; ++a) {
+        if (blocks[a].bottom < seam || blocks[b].top > seam) continue;
+        int x_overlap = MIN(blocks[a].right, blocks[b].right) -
+            MAX(blocks[a].left, blocks[b].left);
+        int min_width = MIN(blocks[a].right - blocks[a].left,
+                            blocks[b].right - blocks[b].left);
+        if (x_overlap * 2 > min_width) {
+          blocks[b].parent = FirstStripBlock(blocks, a);
+          break;
+        }
+      }
+    }
+    ClearResults();
+    seam = own_bottom;
+    first_block_above = first_block;
+    if (top + height >= end) break;
+  }
+  SetRectangle(saved_left, saved_top, saved_width, saved_height);
+
+  // Output the lines block by block, the blocks in order of their first
+  // line, and the lines of each in the order they were found.
+  STRING text;
+  Boxa* line_boxes = boxaCreate(strip_lines.size());
+  int* line_confs = new int[strip_lines.size() + 1];
+  int num_lines = 0;
+  for (int b = 0; b < blocks.size(); ++b) {
+    if (blocks[b].parent != b) continue;
+    for (int l = 0; l < strip_lines.size(); ++l) {
+      const StripLine& line = strip_lines[l];
+      if (FirstStripBlock(blocks, line.block) != b) continue;
+      text += line.text;
+      boxaAddBox(line_boxes,
+                 boxCreate(line.left, line.top, line.right - line.left,
+                           line.bottom - line.top), L_INSERT);
+      line_confs[num_lines++] = line.conf;
+    }
+    text += "\n";
+  }
+  if (confidences != NULL)
+    *confidences = line_confs;
+  else
+    delete [] line_confs;
+  if (lines != NULL)
+    *lines = line_boxes;
+  else
+    boxaDestroy(&line_boxes);
+  char* result = new char[text.length() + 1];
+  strncpy(result, text.string(), text.length() + 1);
+  return result;
+}
+
+// Returns pix reduced by the largest power of 2 that is no bigger than
+// *reduction, and sets *reduction to it. Areas are averaged, as grey or
+// color, so thin strokes that subsampling would drop still show up.
+static Pix* ReduceForTextDetection(Pix* pix, int* reduction) {
+  Pix* reduced = pixGetDepth(pix) == 8 || pixGetDepth(pix) == 32
+      ? pixClone(pix) : pixConvertTo8(pix, false);
+  int factor = 1;
+  while (reduced != NULL && factor * 2 <= *reduction) {
+    Pix* half = pixScaleAreaMap2(reduced);
+    pixDestroy(&reduced);
+    reduced = half;
+    factor *= 2;
+  }
+  *reduction = factor;
+  return reduced;
+}
+
+/**
+ * Finds the text regions of the current rectangle on a reduced copy.
+ * See the header for details.
+ */
+Boxa* TessBaseAPI::FindTextRegions(int reduction) {
+  int left, top, width, height, image_width, image_height;
+  thresholder_->GetImageSizes(&left, &top, &width, &height,
+                              &image_width, &image_height);
+  Pix* source = thresholder_->GetPixRect();
+  Pix* reduced = source != NULL
+      ? ReduceForTextDetection(source, &reduction) : NULL;
+  pixDestroy(&source);
+  if (reduced == NULL)
+    return NULL;
+  // Threshold the reduced image in the same way as the full one would be.
+  ImageThresholder reduced_thresholder;
+  reduced_thresholder.SetImage(reduced);
+  pixDestroy(&reduced);
+  reduced_thresholder.SetThresholdMethod(
+      static_cast<ThresholdMethod>(
+          static_cast<int>(tesseract_->tessedit_thresholding_method)),
+      tesseract_->thresholding_window_size, tesseract_->thresholding_kfactor,
+      tesseract_->thresholding_tile_size,
+      tesseract_->thresholding_smooth_kernel_size,
+      tesseract_->thresholding_score_fraction);
+  Pix* binary = NULL;
+  reduced_thresholder.ThresholdToPix(GetPageSegMode(), &binary);
+  if (binary == NULL)
+    return NULL;
+
+  // Find the lines on the reduced binary image in place of the page image.
+  ClearResults();
+  Pix** page_binary = tesseract_->mutable_pix_binary();
+  pixDestroy(page_binary);
+  *page_binary = binary;
+  int resolution = ClipToRange(thresholder_->GetScaledEstimatedResolution(),
+                               kMinCredibleResolution,
+                               kMaxCredibleResolution);
+  tesseract_->set_source_resolution(MAX(resolution / reduction, 1));
+  GenericVector<TBOX> lines;
+  GenericVector<float> scores;
+  tesseract_->DetectTextLines(&lines, &scores);
+  int binary_width = pixGetWidth(binary);
+  int binary_height = pixGetHeight(binary);
+  pixDestroy(page_binary);
+
+  // Pad the lines, so the regions keep their ascenders, descenders and the
+  // ends of words, and merge those that then overlap.
+  Boxa* padded = boxaCreate(lines.size());
+  for (int i = 0; i < lines.size(); ++i) {
+    const TBOX& line = lines[i];
+    int pad = line.height() / 2;
+    int x0 = MAX(line.left() - pad, 0);
+    int x1 = MIN(line.right() + pad, binary_width);
+    int y0 = MAX(binary_height - line.top() - pad, 0);
+    int y1 = MIN(binary_height - line.bottom() + pad, binary_height);
+    if (x1 <= x0 || y1 <= y0) continue;
+    boxaAddBox(padded, boxCreate(x0 * reduction + left, y0 * reduction + top,
+                                 (x1 - x0) * reduction,
+                                 (y1 - y0) * reduction), L_INSERT);
+  }
+  if (boxaGetCount(padded) == 0)
+    return padded;
+  Boxa* merged = boxaCombineOverlaps(padded);
+  boxaDestroy(&padded);
+  if (merged == NULL)
+    return NULL;
+  Boxa* sorted = boxaSort(merged, L_SORT_BY_Y, L_SORT_INCREASING, NULL);
+  boxaDestroy(&merged);
+  return sorted;
+}
+
+/** Copies text to *line_text without the trailing newlines. */
+static void SetFrameLineText(const char* text, STRING* line_text) {
+  *line_text = text != NULL ? text : "";
+  int length = line_text->length();
+  while (length > 0 && (*line_text)[length - 1] == '\n') --length;
+  line_text->truncate_at(length);
+}
+
+/**
+ * Recognize the current image as a frame of a video stream, reusing the
+ * lines of the previous frame that have not changed.
+ */
+int TessBaseAPI::RecognizeFrame(ETEXT_DESC* monitor) {
+  if (tesseract_ == NULL)
+    return -1;
+  if (thresholder_ == NULL || thresholder_->IsEmpty()) {
+    tprintf("Please call SetImage before attempting recognition.");
+    return -1;
+  }
+  if (frame_history_ == NULL)
+    frame_history_ = new FrameHistory;
+  Pix* page_binary;
+  Pix* page_grey;
+  Pix* page_thresholds;
+  ThresholdPage(&page_binary, &page_grey, &page_thresholds);
+  if (page_binary == NULL) {
+    pixDestroy(&page_grey);
+    pixDestroy(&page_thresholds);
+    return -1;
+  }
+  int image_width = pixGetWidth(page_binary);
+  int image_height = pixGetHeight(page_binary);
+
+  // Find the lines of the previous frame that no longer match this one.
+  GenericVector<int> changed_lines;
+  bool reuse = frame_history_->Align(page_binary,
+                                     tesseract_->stream_max_motion);
+  if (reuse) {
+    double max_change = tesseract_->stream_line_change_fraction;
+    const GenericVector<FrameLine>& lines = frame_history_->lines();
+    for (int i = 0; i < lines.size(); ++i) {
+      const FrameLine& line = lines[i];
+      if (line.left < 0 || line.top < 0 ||
+          line.left + line.width > image_width ||
+          line.top + line.height > image_height ||
+          frame_history_->ChangedFraction(page_binary, line.left, line.top,
+                                          line.width, line.height) >
+              max_change)
+        changed_lines.push_back(i);
+    }
+    reuse = changed_lines.size() * 2 <= lines.size() &&
+        frame_history_->ChangedFractionOutsideLines(page_binary) <= max_change;
+  }
+
+  int result = -1;
+  if (reuse) {
+    PageSegMode saved_mode = GetPageSegMode();
+    SetPageSegMode(PSM_SINGLE_LINE);
+    for (int c = 0; c < changed_lines.size(); ++c) {
+      FrameLine* line = &(*frame_history_->mutable_lines())[changed_lines[c]];
+      // Clip the line to the frame, with a margin for the line finder.
+      int margin = line->height / 4;
+      int left = MAX(line->left - margin, 0);
+      int top = MAX(line->top - margin, 0);
+      int right = MIN(line->left + line->width + margin, image_width);
+      int bottom = MIN(line->top + line->height + margin, image_height);
+      line->text = "";
+      line->confidence = 0;
+      if (right <= left || bottom <= top)
+        continue;
+      char* text = RecognizeClippedRegion(page_binary, page_grey,
+                                          page_thresholds, left, top,
+                                          right - left, bottom - top,
+                                          monitor, &line->confidence);
+      SetFrameLineText(text, &line->text);
+      delete [] text;
+    }
+    SetPageSegMode(saved_mode);
+    SetRectangle(0, 0, image_width, image_height);
+    frame_history_->SetFrame(page_binary);
+    result = changed_lines.size();
+  } else {
+    // Full layout analysis and recognition of the frame. Threshold has
+    // already given the grey and threshold images to tesseract_.
+    frame_history_->Reset(page_binary);
+    *tesseract_->mutable_pix_binary() = pixClone(page_binary);
+    if (Recognize(monitor) == 0) {
+      ResultIterator* res_it = GetIterator();
+      while (!res_it->Empty(RIL_BLOCK)) {
+        if (res_it->Empty(RIL_WORD)) {
+          res_it->Next(RIL_WORD);
+          continue;
+        }
+        FrameLine line;
+        int right, bottom;
+        res_it->BoundingBox(RIL_TEXTLINE, &line.left, &line.top,
+                            &right, &bottom);
+        line.width = right - line.left;
+        line.height = bottom - line.top;
+        line.confidence = static_cast<int>(res_it->Confidence(RIL_TEXTLINE));
+        char* text = res_it->GetUTF8Text(RIL_TEXTLINE);
+        SetFrameLineText(text, &line.text);
+        delete [] text;
+        frame_history_->mutable_lines()->push_back(line);
+        res_it->Next(RIL_TEXTLINE);
+      }
+      delete res_it;
+      result = frame_history_->lines().size();
+    } else {
+      frame_history_->Clear();
+    }
+  }
+  pixDestroy(&page_binary);
+  pixDestroy(&page_grey);
+  pixDestroy(&page_thresholds);
+  return result;
+}
+
+/** Return the text of the lines of the last frame. */
+char* TessBaseAPI::GetFrameText() {
+  if (frame_history_ == NULL || frame_history_->empty())
+    return NULL;
+  STRING text;
+  const GenericVector<FrameLine>& lines = frame_history_->lines();
+  for (int i = 0; i < lines.size(); ++i) {
+    text += lines[i].text;
+    text += "\n";
+  }
+  char* result = new char[text.length() + 1];
+  strcpy(result, text.string());
+  return result;
+}
+
+/** Return the boxes and confidences of the lines of the last frame. */
+Boxa* TessBaseAPI::GetFrameLines(int** confidences) {
+  if (frame_history_ == NULL || frame_history_->empty())
+    return NULL;
+  const GenericVector<FrameLine>& lines = frame_history_->lines();
+  Boxa* boxa = boxaCreate(lines.size());
+  if (confidences != NULL)
+    *confidences = new int[lines.size()];
+  for (int i = 0; i < lines.size(); ++i) {
+    boxaAddBox(boxa, boxCreate(lines[i].left, lines[i].top,
+                               lines[i].width, lines[i].height), L_INSERT);
+    if (confidences != NULL)
+      (*confidences)[i] = lines[i].confidence;
+  }
+  return boxa;
+}
+
+void TessBaseAPI::ClearFrameHistory() {
+  if (frame_history_ != NULL)
+    frame_history_->Clear();
+}
+
+// A table found by RecognizeTables. Each cell is kept as a FrameLine, with
+// its box in image coordinates, its text and its confidence.
+struct RecognizedTable {
+  RecognizedTable() : rows(0), columns(0) {}
+
+  int rows;
+  int columns;
+  GenericVector<FrameLine> cells;
+};
+
+// The cells of all the tables of RecognizeTables, shared out between the
+// engines, and the page images to clip them from.
+struct TableCellJob {
+  Pix* binary;
+  Pix* grey;
+  Pix* thresholds;
+  ETEXT_DESC* monitor;
+  GenericVector<FrameLine*> cells;
+  GenericVector<TessBaseAPI*> engines;
+};
+
+void TessBaseAPI::RecognizeTableCells(TableCellJob* job, int engine) {
+  TessBaseAPI* api = job->engines[engine];
+  for (int c = engine; c < job->cells.size(); c += job->engines.size()) {
+    FrameLine* cell = job->cells[c];
+    char* text = api->RecognizeClippedRegion(job->binary, job->grey,
+                                             job->thresholds, cell->left,
+                                             cell->top, cell->width,
+                                             cell->height, job->monitor,
+                                             &cell->confidence);
+    if (text != NULL) cell->text = text;
+    delete [] text;
+  }
+}
+
+/**
+ * Find the tables of the image by layout analysis, and recognize each cell
+ * of their grids on its own, in parallel.
+ */
+int TessBaseAPI::RecognizeTables(PageSegMode cell_mode, ETEXT_DESC* monitor) {
+  if (tesseract_ == NULL)
+    return -1;
+  if (thresholder_ == NULL || thresholder_->IsEmpty()) {
+    tprintf("Please call SetImage before attempting recognition.");
+    return -1;
+  }
+  ClearTables();
+  int saved_left, saved_top, saved_width, saved_height;
+  int image_width, image_height;
+  thresholder_->GetImageSizes(&saved_left, &saved_top,
+                              &saved_width, &saved_height,
+                              &image_width, &image_height);
+  Pix* page_binary;
+  Pix* page_grey;
+  Pix* page_thresholds;
+  ThresholdPage(&page_binary, &page_grey, &page_thresholds);
+  if (page_binary == NULL) {
+    pixDestroy(&page_grey);
+    pixDestroy(&page_thresholds);
+    SetRectangle(saved_left, saved_top, saved_width, saved_height);
+    return -1;
+  }
+  image_width = pixGetWidth(page_binary);
+  image_height = pixGetHeight(page_binary);
+  // Layout analysis of the whole page finds the tables. It removes the rule
+  // lines from pix_binary in place, so from page_binary as well, and they
+  // are not read as part of the cells.
+  *tesseract_->mutable_pix_binary() = pixClone(page_binary);
+  if (FindLines() != 0) {
+    pixDestroy(&page_binary);
+    pixDestroy(&page_grey);
+    pixDestroy(&page_thresholds);
+    SetRectangle(saved_left, saved_top, saved_width, saved_height);
+    return -1;
+  }
+  if (tables_ == NULL)
+    tables_ = new GenericVector<RecognizedTable*>;
+  TableCellJob job;
+  job.binary = page_binary;
+  job.grey = page_grey;
+  job.thresholds = page_thresholds;
+  job.monitor = monitor;
+  const GenericVector<TableCells>& found = tesseract_->table_cells();
+  for (int t = 0; t < found.size(); ++t) {
+    RecognizedTable* table = new RecognizedTable;
+    table->rows = found[t].rows;
+    table->columns = found[t].columns;
+    table->cells.init_to_size(found[t].cells.size(), FrameLine());
+    for (int c = 0; c < found[t].cells.size(); ++c) {
+      // Tesseract boxes are bottom-up, clipped to the image.
+      const TBOX& box = found[t].cells[c];
+      int left = MAX(box.left(), 0);
+      int top = MAX(image_height - box.top(), 0);
+      int right = MIN(box.right(), image_width);
+      int bottom = MIN(image_height - box.bottom(), image_height);
+      if (right <= left || bottom <= top)
+        continue;
+      FrameLine* cell = &table->cells[c];
+      cell->left = left;
+      cell->top = top;
+      cell->width = right - left;
+      cell->height = bottom - top;
+      job.cells.push_back(cell);
+    }
+    tables_->push_back(table);
+  }
+
+  PageSegMode saved_mode = GetPageSegMode();
+  SetPageSegMode(cell_mode);
+  job.engines.push_back(this);
+  ThreadPool* thread_pool = job.cells.size() > 1
+      ? tesseract_->RecognitionThreadPool() : NULL;
+  if (thread_pool != NULL) {
+    PrepareWorkers(tesseract_->tessedit_parallelize - 1);
+    // All the engines classify from a snapshot of the adapted templates of
+    // tesseract_, as the word workers of pass 1 do.
+    tesseract_->SetClassifyFromSnapshot(true);
+    tesseract_->SetRecognizingInParallel(true);
+    for (int i = 0; word_workers_ != NULL && i < word_workers_->size(); ++i) {
+      TessBaseAPI* worker = (*word_workers_)[i];
+      worker->SetImage(page_binary);
+      worker->tesseract_->PrepareWordWorker(*tesseract_);
+      job.engines.push_back(worker);
+    }
+    // Progress and cancellation of several engines at once can't be
+    // reported through one monitor.
+    job.monitor = NULL;
+  }
+  if (job.engines.size() > 1) {
+    TessCallback1<int>* recognize =
+        NewPermanentTessCallback(&RecognizeTableCells, &job);
+    thread_pool->ParallelFor(job.engines.size(), recognize);
+    delete recognize;
+    for (int e = 1; e < job.engines.size(); ++e)
+      job.engines[e]->Clear();
+  } else {
+    RecognizeTableCells(&job, 0);
+  }
+  if (thread_pool != NULL) {
+    tesseract_->SetRecognizingInParallel(false);
+    tesseract_->SetClassifyFromSnapshot(false);
+  }
+  pixDestroy(&page_binary);
+  pixDestroy(&page_grey);
+  pixDestroy(&page_thresholds);
+
+  SetPageSegMode(saved_mode);
+  SetRectangle(saved_left, saved_top, saved_width, saved_height);
+  return tables_->size();
+}
+
+/** Return the cell boxes and confidences of a table of RecognizeTables. */
+Boxa* TessBaseAPI::GetTableCells(int table, int* rows, int* columns,
+                                 int** confidences) {
+  if (tables_ == NULL || table < 0 || table >= tables_->size())
+    return NULL;
+  const RecognizedTable& found = *(*tables_)[table];
+  *rows = found.rows;
+  *columns = found.columns;
+  Boxa* boxa = boxaCreate(found.cells.size());
+  if (confidences != NULL)
+    *confidences = new int[found.cells.size()];
+  for (int c = 0; c < found.cells.size(); ++c) {
+    const FrameLine& cell = found.cells[c];
+    boxaAddBox(boxa, boxCreate(cell.left, cell.top, cell.width, cell.height),
+               L_INSERT);
+    if (confidences != NULL)
+      (*confidences)[c] = cell.confidence;
   }
+  return boxa;
+}
 
-  int result = 0;
-  if (tesseract_->interactive_display_mode) {
-    #ifndef GRAPHICS_DISABLED
-    tesseract_->pgeditor_main(rect_width_, rect_height_, page_res_);
-    #endif  // GRAPHICS_DISABLED
-    // The page_res is invalid after an interactive session, so cleanup
-    // in a way that lets us continue to the next page without crashing.
-    delete page_res_;
-    page_res_ = NULL;
-    return -1;
-  } else if (tesseract_->tessedit_train_from_boxes) {
-    STRING fontname;
-    ExtractFontName(*output_file_, &fontname);
-    tesseract_->ApplyBoxTraining(fontname, page_res_);
-  } else if (tesseract_->tessedit_ambigs_training) {
-    FILE *training_output_file = tesseract_->init_recog_training(*input_file_);
-    // OCR the page segmented into words by tesseract.
-    tesseract_->recog_training_segmented(
-        *input_file_, page_res_, monitor, training_output_file);
-    fclose(training_output_file);
-  } else {
-    // Now run the main recognition.
-    bool wait_for_text = true;
-    GetBoolVariable("paragraph_text_based", &wait_for_text);
-    if (!wait_for_text) DetectParagraphs(false);
-    if (tesseract_->recog_all_words(page_res_, monitor, NULL, NULL, 0)) {
-      if (wait_for_text) DetectParagraphs(true);
-    } else {
-      result = -1;
-    }
+/** Return the text of the cells of a table of RecognizeTables. */
+char* TessBaseAPI::GetTableText(int table) {
+  if (tables_ == NULL || table < 0 || table >= tables_->size())
+    return NULL;
+  const GenericVector<FrameLine>& cells = (*tables_)[table]->cells;
+  int length = 0;
+  for (int c = 0; c < cells.size(); ++c)
+    length += cells[c].text.length() + 1;
+  char* result = new char[length + 1];
+  char* ptr = result;
+  for (int c = 0; c < cells.size(); ++c) {
+    strcpy(ptr, cells[c].text.string());
+    ptr += cells[c].text.length() + 1;
   }
+  *ptr = '\0';
   return result;
 }
 
+void TessBaseAPI::ClearTables() {
+  if (tables_ == NULL) return;
+  tables_->delete_data_pointers();
+  tables_->clear();
+}
+
 /** Tests the chopper by exhaustively running chop_one_blob. */
 int TessBaseAPI::RecognizeForChopTest(ETEXT_DESC* monitor) {
   if (tesseract_ == NULL)
@@ -1022,28 +2215,35 @@ bool TessBaseAPI::ProcessPagesMultipageTiff(const l_uint8 *data,
                                             int timeout_millisec,
                                             TessResultRenderer* renderer,
                                             int tessedit_page_number) {
-#ifndef ANDROID_BUILD
   Pix *pix = NULL;
-#ifdef USE_OPENCL
+#ifdef USE_OPENCL_TIFF
   OpenclDevice od;
-#endif  // USE_OPENCL
+#endif  // USE_OPENCL_TIFF
   int page = (tessedit_page_number >= 0) ? tessedit_page_number : 0;
   size_t offset = 0;
+  if (page > 0) {
+    // Go straight to the requested page instead of decoding the ones
+    // before it.
+    TiffPageIndex index;
+    bool indexed = (data) ? index.Open(data, size) : index.Open(filename);
+    if (!indexed || page >= index.NumPages()) return true;
+    offset = index.Offset(page);
+  }
   for (; ; ++page) {
     if (tessedit_page_number >= 0)
       page = tessedit_page_number;
-#ifdef USE_OPENCL
+#ifdef USE_OPENCL_TIFF
     if ( od.selectedDeviceIsOpenCL() ) {
       pix = (data) ?
           od.pixReadMemTiffCl(data, size, page) :
           od.pixReadTiffCl(filename, page);
     } else {
-#endif  // USE_OPENCL
+#endif  // USE_OPENCL_TIFF
     pix = (data) ? pixReadMemFromMultipageTiff(data, size, &offset)
                  : pixReadFromMultipageTiff(filename, &offset);
-#ifdef USE_OPENCL
+#ifdef USE_OPENCL_TIFF
     }
-#endif  // USE_OPENCL
+#endif  // USE_OPENCL_TIFF
     if (pix == NULL) break;
     tprintf("Page %d\n", page + 1);
     char page_str[kMaxIntSize];
@@ -1057,9 +2257,6 @@ bool TessBaseAPI::ProcessPagesMultipageTiff(const l_uint8 *data,
     if (!offset) break;
   }
   return true;
-#else
-  return false;
-#endif
 }
 
 // Master ProcessPages calls ProcessPagesInternal and then does any post-
@@ -1069,14 +2266,29 @@ bool TessBaseAPI::ProcessPages(const char* filename, const char* retry_config,
                                TessResultRenderer* renderer) {
   bool result =
       ProcessPagesInternal(filename, retry_config, timeout_millisec, renderer);
-  if (result) {
-    if (tesseract_->tessedit_train_from_boxes &&
-        !tesseract_->WriteTRFile(*output_file_)) {
-      tprintf("Write of TR file failed: %s\n", output_file_->string());
-      return false;
-    }
+  return result && WriteTrainingOutput();
+}
+
+bool TessBaseAPI::ProcessPagesFromMemory(const unsigned char* data,
+                                         size_t size, const char* name,
+                                         const char* retry_config,
+                                         int timeout_millisec,
+                                         TessResultRenderer* renderer) {
+  if (data == NULL || size == 0) return false;
+  if (name == NULL) name = "";
+  bool result = ProcessPagesData(data, size, name, retry_config,
+                                 timeout_millisec, renderer);
+  return result && WriteTrainingOutput();
+}
+
+// Writes what a training mode has gathered over the pages processed.
+bool TessBaseAPI::WriteTrainingOutput() {
+  if (tesseract_->tessedit_train_from_boxes &&
+      !tesseract_->WriteTRFile(*output_file_)) {
+    tprintf("Write of TR file failed: %s\n", output_file_->string());
+    return false;
   }
-  return result;
+  return true;
 }
 
 // In the ideal scenario, Tesseract will start working on data as soon
@@ -1119,18 +2331,30 @@ bool TessBaseAPI::ProcessPagesInternal(const char* filename,
                (std::istreambuf_iterator<char>()));
     data = reinterpret_cast<const l_uint8 *>(buf.data());
   }
+  bool result = ProcessPagesData(data, buf.size(), filename, retry_config,
+                                 timeout_millisec, renderer);
+  PERF_COUNT_END
+  return result;
+}
 
+// Processes the document in data, or in the file filename if data is NULL,
+// whose format is detected from its content.
+bool TessBaseAPI::ProcessPagesData(const l_uint8 *data, size_t size,
+                                   const char* filename,
+                                   const char* retry_config,
+                                   int timeout_millisec,
+                                   TessResultRenderer* renderer) {
   // Here is our autodetection
   int format;
-  int r = (stdInput) ?
+  int r = (data) ?
       findFileFormatBuffer(data, &format) :
       findFileFormat(filename, &format);
 
   // Maybe we have a filelist
   if (r != 0 || format == IFF_UNKNOWN) {
     STRING s;
-    if (stdInput) {
-      s = buf.c_str();
+    if (data) {
+      s = std::string(reinterpret_cast<const char *>(data), size).c_str();
     } else {
       std::ifstream t(filename);
       std::string u((std::istreambuf_iterator<char>(t)),
@@ -1151,7 +2375,7 @@ bool TessBaseAPI::ProcessPagesInternal(const char* filename,
   // Fail early if we can, before producing any output
   Pix *pix = NULL;
   if (!tiff) {
-    pix = (stdInput) ? pixReadMem(data, buf.size()) : pixRead(filename);
+    pix = (data) ? pixReadMem(data, size) : pixRead(filename);
     if (pix == NULL) {
       return false;
     }
@@ -1165,7 +2389,7 @@ bool TessBaseAPI::ProcessPagesInternal(const char* filename,
 
   // Produce output
   r = (tiff) ?
-      ProcessPagesMultipageTiff(data, buf.size(), filename, retry_config,
+      ProcessPagesMultipageTiff(data, size, filename, retry_config,
                                 timeout_millisec, renderer,
                                 tesseract_->tessedit_page_number) :
       ProcessPage(pix, 0, filename, retry_config,
@@ -1178,7 +2402,6 @@ bool TessBaseAPI::ProcessPagesInternal(const char* filename,
   if (!r || (renderer && !renderer->EndDocument())) {
     return false;
   }
-  PERF_COUNT_END
   return true;
 }
 
@@ -1236,8 +2459,17 @@ bool TessBaseAPI::ProcessPage(Pix* pix, int page_index, const char* filename,
   }
 
   if (renderer && !failed) {
+    StageTimer timer(tesseract_->mutable_stage_timings(), STAGE_RENDERING);
     failed = !renderer->AddImage(this);
   }
+  if (tesseract_->tessedit_timing_debug) {
+    const StageTimings& timings = tesseract_->stage_timings();
+    for (int i = 0; i < STAGE_COUNT; ++i) {
+      PageStage stage = static_cast<PageStage>(i);
+      tprintf("%s: %.1f ms\n", StageTimings::Name(stage),
+              timings.msecs[stage]);
+    }
+  }
 
   PERF_COUNT_END
   return !failed;
@@ -1253,7 +2485,8 @@ LTRResultIterator* TessBaseAPI::GetLTRIterator() {
   return new LTRResultIterator(
       page_res_, tesseract_,
       thresholder_->GetScaleFactor(), thresholder_->GetScaledYResolution(),
-      rect_left_, rect_top_, rect_width_, rect_height_);
+      rect_left_, rect_top_, rect_width_, rect_height_,
+      thresholder_->GetReductionFactor());
 }
 
 /**
@@ -1270,7 +2503,8 @@ ResultIterator* TessBaseAPI::GetIterator() {
   return ResultIterator::StartOfParagraph(LTRResultIterator(
       page_res_, tesseract_,
       thresholder_->GetScaleFactor(), thresholder_->GetScaledYResolution(),
-      rect_left_, rect_top_, rect_width_, rect_height_));
+      rect_left_, rect_top_, rect_width_, rect_height_,
+      thresholder_->GetReductionFactor()));
 }
 
 /**
@@ -1287,7 +2521,8 @@ MutableIterator* TessBaseAPI::GetMutableIterator() {
   return new MutableIterator(page_res_, tesseract_,
                              thresholder_->GetScaleFactor(),
                              thresholder_->GetScaledYResolution(),
-                             rect_left_, rect_top_, rect_width_, rect_height_);
+                             rect_left_, rect_top_, rect_width_, rect_height_,
+                             thresholder_->GetReductionFactor());
 }
 
 /** Make a text string from the internal data structures. */
@@ -1332,10 +2567,10 @@ static tesseract::Orientation GetBlockTextOrientation(const PageIterator *it) {
  */
 static void AddBaselineCoordsTohOCR(const PageIterator *it,
                                     PageIteratorLevel level,
-                                    STRING* hocr_str) {
+                                    TextBuffer* hocr_str) {
   tesseract::Orientation orientation = GetBlockTextOrientation(it);
   if (orientation != ORIENTATION_PAGE_UP) {
-    hocr_str->add_str_int("; textangle ", 360 - orientation * 90);
+    hocr_str->AppendInt("; textangle ", 360 - orientation * 90);
     return;
   }
 
@@ -1365,35 +2600,30 @@ static void AddBaselineCoordsTohOCR(const PageIterator *it,
   p1 = (y2 - y1) / static_cast<double>(x2 - x1);
   p0 = y1 - static_cast<double>(p1 * x1);
 
-  hocr_str->add_str_double("; baseline ", round(p1 * 1000.0) / 1000.0);
-  hocr_str->add_str_double(" ", round(p0 * 1000.0) / 1000.0);
+  hocr_str->AppendDouble("; baseline ", round(p1 * 1000.0) / 1000.0);
+  hocr_str->AppendDouble(" ", round(p0 * 1000.0) / 1000.0);
 }
 
-static void AddIdTohOCR(STRING* hocr_str, const std::string base, int num1,
+static void AddIdTohOCR(TextBuffer* hocr_str, const char* base, int num1,
                         int num2) {
-  const size_t BUFSIZE = 64;
-  char id_buffer[BUFSIZE];
-  if (num2 >= 0) {
-    snprintf(id_buffer, BUFSIZE - 1, "%s_%d_%d", base.c_str(), num1, num2);
-  } else {
-    snprintf(id_buffer, BUFSIZE - 1, "%s_%d", base.c_str(), num1);
-  }
-  id_buffer[BUFSIZE - 1] = '\0';
-  *hocr_str += " id='";
-  *hocr_str += id_buffer;
-  *hocr_str += "'";
+  hocr_str->Append(" id='");
+  hocr_str->Append(base);
+  hocr_str->AppendInt("_", num1);
+  if (num2 >= 0)
+    hocr_str->AppendInt("_", num2);
+  hocr_str->Append('\'');
 }
 
 static void AddBoxTohOCR(const ResultIterator* it, PageIteratorLevel level,
-                         STRING* hocr_str) {
+                         TextBuffer* hocr_str) {
   int left, top, right, bottom;
   it->BoundingBox(level, &left, &top, &right, &bottom);
   // This is the only place we use double quotes instead of single quotes,
   // but it may too late to change for consistency
-  hocr_str->add_str_int(" title=\"bbox ", left);
-  hocr_str->add_str_int(" ", top);
-  hocr_str->add_str_int(" ", right);
-  hocr_str->add_str_int(" ", bottom);
+  hocr_str->AppendInt(" title=\"bbox ", left);
+  hocr_str->AppendInt(" ", top);
+  hocr_str->AppendInt(" ", right);
+  hocr_str->AppendInt(" ", bottom);
   // Add baseline coordinates & heights for textlines only.
   if (level == RIL_TEXTLINE) {
     AddBaselineCoordsTohOCR(it, level, hocr_str);
@@ -1401,21 +2631,40 @@ static void AddBoxTohOCR(const ResultIterator* it, PageIteratorLevel level,
     float row_height, descenders, ascenders;  // row attributes
     it->RowAttributes(&row_height, &descenders, &ascenders);
     // TODO(rays): Do we want to limit these to a single decimal place?
-    hocr_str->add_str_double("; x_size ", row_height);
-    hocr_str->add_str_double("; x_descenders ", descenders * -1);
-    hocr_str->add_str_double("; x_ascenders ", ascenders);
+    hocr_str->AppendDouble("; x_size ", row_height);
+    hocr_str->AppendDouble("; x_descenders ", descenders * -1);
+    hocr_str->AppendDouble("; x_ascenders ", ascenders);
   }
-  *hocr_str += "\">";
+  hocr_str->Append("\">");
 }
 
 static void AddBoxToTSV(const PageIterator* it, PageIteratorLevel level,
-                        STRING* hocr_str) {
+                        TextBuffer* hocr_str) {
   int left, top, right, bottom;
   it->BoundingBox(level, &left, &top, &right, &bottom);
-  hocr_str->add_str_int("\t", left);
-  hocr_str->add_str_int("\t", top);
-  hocr_str->add_str_int("\t", right - left);
-  hocr_str->add_str_int("\t", bottom - top);
+  hocr_str->AppendInt("\t", left);
+  hocr_str->AppendInt("\t", top);
+  hocr_str->AppendInt("\t", right - left);
+  hocr_str->AppendInt("\t", bottom - top);
+}
+
+// Returns the size that the hOCR or TSV text of page_res is unlikely to
+// exceed, given what it takes per word and per character, so that the
+// text buffer is allocated once.
+static int EstimateTextSize(PAGE_RES* page_res, int bytes_per_word,
+                            int bytes_per_char) {
+  const int kPageBytes = 1024;
+  int words = 0;
+  int chars = 0;
+  PAGE_RES_IT page_res_it(page_res);
+  for (page_res_it.restart_page(); page_res_it.word() != NULL;
+       page_res_it.forward()) {
+    ++words;
+    const WERD_CHOICE* choice = page_res_it.word()->best_choice;
+    if (choice != NULL)
+      chars += choice->length();
+  }
+  return kPageBytes + words * bytes_per_word + chars * bytes_per_char;
 }
 
 /**
@@ -1449,7 +2698,12 @@ char* TessBaseAPI::GetHOCRText(ETEXT_DESC* monitor, int page_number) {
   bool font_info = false;
   GetBoolVariable("hocr_font_info", &font_info);
 
-  STRING hocr_str("");
+  // Word spans take about 100 bytes and their lines and paragraphs some
+  // more, and a character may be escaped or take 4 bytes of UTF-8.
+  const int kHOcrWordBytes = 160;
+  const int kHOcrCharBytes = 6;
+  TextBuffer hocr_str(EstimateTextSize(page_res_, kHOcrWordBytes,
+                                       kHOcrCharBytes));
 
   if (input_file_ == NULL)
       SetInputName(NULL);
@@ -1471,20 +2725,20 @@ char* TessBaseAPI::GetHOCRText(ETEXT_DESC* monitor, int page_number) {
   delete[] utf8_str;
 #endif
 
-  hocr_str += "  <div class='ocr_page'";
+  hocr_str.Append("  <div class='ocr_page'");
   AddIdTohOCR(&hocr_str, "page", page_id, -1);
-  hocr_str += " title='image \"";
+  hocr_str.Append(" title='image \"");
   if (input_file_) {
-    hocr_str += HOcrEscape(input_file_->string());
+    hocr_str.AppendEscaped(input_file_->string());
   } else {
-    hocr_str += "unknown";
+    hocr_str.Append("unknown");
   }
-  hocr_str.add_str_int("\"; bbox ", rect_left_);
-  hocr_str.add_str_int(" ", rect_top_);
-  hocr_str.add_str_int(" ", rect_width_);
-  hocr_str.add_str_int(" ", rect_height_);
-  hocr_str.add_str_int("; ppageno ", page_number);
-  hocr_str += "'>\n";
+  hocr_str.AppendInt("\"; bbox ", rect_left_);
+  hocr_str.AppendInt(" ", rect_top_);
+  hocr_str.AppendInt(" ", rect_width_);
+  hocr_str.AppendInt(" ", rect_height_);
+  hocr_str.AppendInt("; ppageno ", page_number);
+  hocr_str.Append("'>\n");
 
   ResultIterator *res_it = GetIterator();
   while (!res_it->Empty(RIL_BLOCK)) {
@@ -1496,33 +2750,33 @@ char* TessBaseAPI::GetHOCRText(ETEXT_DESC* monitor, int page_number) {
     // Open any new block/paragraph/textline.
     if (res_it->IsAtBeginningOf(RIL_BLOCK)) {
       para_is_ltr = true;  // reset to default direction
-      hocr_str += "   <div class='ocr_carea'";
+      hocr_str.Append("   <div class='ocr_carea'");
       AddIdTohOCR(&hocr_str, "block", page_id, bcnt);
       AddBoxTohOCR(res_it, RIL_BLOCK, &hocr_str);
     }
     if (res_it->IsAtBeginningOf(RIL_PARA)) {
-      hocr_str += "\n    <p class='ocr_par'";
+      hocr_str.Append("\n    <p class='ocr_par'");
       para_is_ltr = res_it->ParagraphIsLtr();
       if (!para_is_ltr) {
-        hocr_str += " dir='rtl'";
+        hocr_str.Append(" dir='rtl'");
       }
       AddIdTohOCR(&hocr_str, "par", page_id, pcnt);
       paragraph_lang = res_it->WordRecognitionLanguage();
       if (paragraph_lang) {
-        hocr_str += " lang='";
-        hocr_str += paragraph_lang;
-        hocr_str += "'";
+        hocr_str.Append(" lang='");
+        hocr_str.Append(paragraph_lang);
+        hocr_str.Append("'");
       }
       AddBoxTohOCR(res_it, RIL_PARA, &hocr_str);
     }
     if (res_it->IsAtBeginningOf(RIL_TEXTLINE)) {
-      hocr_str += "\n     <span class='ocr_line'";
+      hocr_str.Append("\n     <span class='ocr_line'");
       AddIdTohOCR(&hocr_str, "line", page_id, lcnt);
       AddBoxTohOCR(res_it, RIL_TEXTLINE, &hocr_str);
     }
 
     // Now, process the word...
-    hocr_str += "<span class='ocrx_word'";
+    hocr_str.Append("<span class='ocrx_word'");
     AddIdTohOCR(&hocr_str, "word", page_id, wcnt);
     int left, top, right, bottom;
     bool bold, italic, underlined, monospace, serif, smallcaps;
@@ -1532,77 +2786,75 @@ char* TessBaseAPI::GetHOCRText(ETEXT_DESC* monitor, int page_number) {
     font_name = res_it->WordFontAttributes(&bold, &italic, &underlined,
                                            &monospace, &serif, &smallcaps,
                                            &pointsize, &font_id);
-    hocr_str.add_str_int(" title='bbox ", left);
-    hocr_str.add_str_int(" ", top);
-    hocr_str.add_str_int(" ", right);
-    hocr_str.add_str_int(" ", bottom);
-    hocr_str.add_str_int("; x_wconf ", res_it->Confidence(RIL_WORD));
+    hocr_str.AppendInt(" title='bbox ", left);
+    hocr_str.AppendInt(" ", top);
+    hocr_str.AppendInt(" ", right);
+    hocr_str.AppendInt(" ", bottom);
+    hocr_str.AppendInt("; x_wconf ", res_it->Confidence(RIL_WORD));
     if (font_info) {
       if (font_name) {
-        hocr_str += "; x_font ";
-        hocr_str += HOcrEscape(font_name);
+        hocr_str.Append("; x_font ");
+        hocr_str.AppendEscaped(font_name);
       }
-      hocr_str.add_str_int("; x_fsize ", pointsize);
+      hocr_str.AppendInt("; x_fsize ", pointsize);
     }
-    hocr_str += "'";
+    hocr_str.Append("'");
     const char* lang = res_it->WordRecognitionLanguage();
     if (lang && (!paragraph_lang || strcmp(lang, paragraph_lang))) {
-      hocr_str += " lang='";
-      hocr_str += lang;
-      hocr_str += "'";
+      hocr_str.Append(" lang='");
+      hocr_str.Append(lang);
+      hocr_str.Append("'");
     }
     switch (res_it->WordDirection()) {
       // Only emit direction if different from current paragraph direction
       case DIR_LEFT_TO_RIGHT:
-        if (!para_is_ltr) hocr_str += " dir='ltr'";
+        if (!para_is_ltr) hocr_str.Append(" dir='ltr'");
         break;
       case DIR_RIGHT_TO_LEFT:
-        if (para_is_ltr) hocr_str += " dir='rtl'";
+        if (para_is_ltr) hocr_str.Append(" dir='rtl'");
         break;
       case DIR_MIX:
       case DIR_NEUTRAL:
       default:  // Do nothing.
         break;
     }
-    hocr_str += ">";
+    hocr_str.Append(">");
     bool last_word_in_line = res_it->IsAtFinalElement(RIL_TEXTLINE, RIL_WORD);
     bool last_word_in_para = res_it->IsAtFinalElement(RIL_PARA, RIL_WORD);
     bool last_word_in_block = res_it->IsAtFinalElement(RIL_BLOCK, RIL_WORD);
-    if (bold) hocr_str += "<strong>";
-    if (italic) hocr_str += "<em>";
+    if (bold) hocr_str.Append("<strong>");
+    if (italic) hocr_str.Append("<em>");
     do {
       const char *grapheme = res_it->GetUTF8Text(RIL_SYMBOL);
       if (grapheme && grapheme[0] != 0) {
-        hocr_str += HOcrEscape(grapheme);
+        hocr_str.AppendEscaped(grapheme);
       }
       delete []grapheme;
       res_it->Next(RIL_SYMBOL);
     } while (!res_it->Empty(RIL_BLOCK) && !res_it->IsAtBeginningOf(RIL_WORD));
-    if (italic) hocr_str += "</em>";
-    if (bold) hocr_str += "</strong>";
-    hocr_str += "</span> ";
+    if (italic) hocr_str.Append("</em>");
+    if (bold) hocr_str.Append("</strong>");
+    hocr_str.Append("</span> ");
     wcnt++;
     // Close any ending block/paragraph/textline.
     if (last_word_in_line) {
-      hocr_str += "\n     </span>";
+      hocr_str.Append("\n     </span>");
       lcnt++;
     }
     if (last_word_in_para) {
-      hocr_str += "\n    </p>\n";
+      hocr_str.Append("\n    </p>\n");
       pcnt++;
       para_is_ltr = true;  // back to default direction
     }
     if (last_word_in_block) {
-      hocr_str += "   </div>\n";
+      hocr_str.Append("   </div>\n");
       bcnt++;
     }
   }
-  hocr_str += "  </div>\n";
+  hocr_str.Append("  </div>\n");
 
-  char *ret = new char[hocr_str.length() + 1];
-  strcpy(ret, hocr_str.string());
   delete res_it;
-  return ret;
+  return hocr_str.Release();
 }
 
 /**
@@ -1616,21 +2868,26 @@ char* TessBaseAPI::GetTSVText(int page_number) {
   int lcnt = 1, bcnt = 1, pcnt = 1, wcnt = 1;
   int page_id = page_number + 1;  // we use 1-based page numbers.
 
-  STRING tsv_str("");
+  // A word row takes about 50 bytes, and its line and paragraph rows some
+  // more.
+  const int kTSVWordBytes = 80;
+  const int kTSVCharBytes = 4;
+  TextBuffer tsv_str(EstimateTextSize(page_res_, kTSVWordBytes,
+                                      kTSVCharBytes));
 
   int page_num = page_id, block_num = 0, par_num = 0, line_num = 0,
       word_num = 0;
 
-  tsv_str.add_str_int("1\t", page_num);  // level 1 - page
-  tsv_str.add_str_int("\t", block_num);
-  tsv_str.add_str_int("\t", par_num);
-  tsv_str.add_str_int("\t", line_num);
-  tsv_str.add_str_int("\t", word_num);
-  tsv_str.add_str_int("\t", rect_left_);
-  tsv_str.add_str_int("\t", rect_top_);
-  tsv_str.add_str_int("\t", rect_width_);
-  tsv_str.add_str_int("\t", rect_height_);
-  tsv_str += "\t-1\t\n";
+  tsv_str.AppendInt("1\t", page_num);  // level 1 - page
+  tsv_str.AppendInt("\t", block_num);
+  tsv_str.AppendInt("\t", par_num);
+  tsv_str.AppendInt("\t", line_num);
+  tsv_str.AppendInt("\t", word_num);
+  tsv_str.AppendInt("\t", rect_left_);
+  tsv_str.AppendInt("\t", rect_top_);
+  tsv_str.AppendInt("\t", rect_width_);
+  tsv_str.AppendInt("\t", rect_height_);
+  tsv_str.Append("\t-1\t\n");
 
   ResultIterator* res_it = GetIterator();
   while (!res_it->Empty(RIL_BLOCK)) {
@@ -1642,33 +2899,33 @@ char* TessBaseAPI::GetTSVText(int page_number) {
     // Add rows for any new block/paragraph/textline.
     if (res_it->IsAtBeginningOf(RIL_BLOCK)) {
       block_num++, par_num = 0, line_num = 0, word_num = 0;
-      tsv_str.add_str_int("2\t", page_num);  // level 2 - block
-      tsv_str.add_str_int("\t", block_num);
-      tsv_str.add_str_int("\t", par_num);
-      tsv_str.add_str_int("\t", line_num);
-      tsv_str.add_str_int("\t", word_num);
+      tsv_str.AppendInt("2\t", page_num);  // level 2 - block
+      tsv_str.AppendInt("\t", block_num);
+      tsv_str.AppendInt("\t", par_num);
+      tsv_str.AppendInt("\t", line_num);
+      tsv_str.AppendInt("\t", word_num);
       AddBoxToTSV(res_it, RIL_BLOCK, &tsv_str);
-      tsv_str += "\t-1\t\n";  // end of row for block
+      tsv_str.Append("\t-1\t\n");  // end of row for block
     }
     if (res_it->IsAtBeginningOf(RIL_PARA)) {
       par_num++, line_num = 0, word_num = 0;
-      tsv_str.add_str_int("3\t", page_num);  // level 3 - paragraph
-      tsv_str.add_str_int("\t", block_num);
-      tsv_str.add_str_int("\t", par_num);
-      tsv_str.add_str_int("\t", line_num);
-      tsv_str.add_str_int("\t", word_num);
+      tsv_str.AppendInt("3\t", page_num);  // level 3 - paragraph
+      tsv_str.AppendInt("\t", block_num);
+      tsv_str.AppendInt("\t", par_num);
+      tsv_str.AppendInt("\t", line_num);
+      tsv_str.AppendInt("\t", word_num);
       AddBoxToTSV(res_it, RIL_PARA, &tsv_str);
-      tsv_str += "\t-1\t\n";  // end of row for para
+      tsv_str.Append("\t-1\t\n");  // end of row for para
     }
     if (res_it->IsAtBeginningOf(RIL_TEXTLINE)) {
       line_num++, word_num = 0;
-      tsv_str.add_str_int("4\t", page_num);  // level 4 - line
-      tsv_str.add_str_int("\t", block_num);
-      tsv_str.add_str_int("\t", par_num);
-      tsv_str.add_str_int("\t", line_num);
-      tsv_str.add_str_int("\t", word_num);
+      tsv_str.AppendInt("4\t", page_num);  // level 4 - line
+      tsv_str.AppendInt("\t", block_num);
+      tsv_str.AppendInt("\t", par_num);
+      tsv_str.AppendInt("\t", line_num);
+      tsv_str.AppendInt("\t", word_num);
       AddBoxToTSV(res_it, RIL_TEXTLINE, &tsv_str);
-      tsv_str += "\t-1\t\n";  // end of row for line
+      tsv_str.Append("\t-1\t\n");  // end of row for line
     }
 
     // Now, process the word...
@@ -1681,17 +2938,17 @@ char* TessBaseAPI::GetTSVText(int page_number) {
         res_it->WordFontAttributes(&bold, &italic, &underlined, &monospace,
                                    &serif, &smallcaps, &pointsize, &font_id);
     word_num++;
-    tsv_str.add_str_int("5\t", page_num);  // level 5 - word
-    tsv_str.add_str_int("\t", block_num);
-    tsv_str.add_str_int("\t", par_num);
-    tsv_str.add_str_int("\t", line_num);
-    tsv_str.add_str_int("\t", word_num);
-    tsv_str.add_str_int("\t", left);
-    tsv_str.add_str_int("\t", top);
-    tsv_str.add_str_int("\t", right - left);
-    tsv_str.add_str_int("\t", bottom - top);
-    tsv_str.add_str_int("\t", res_it->Confidence(RIL_WORD));
-    tsv_str += "\t";
+    tsv_str.AppendInt("5\t", page_num);  // level 5 - word
+    tsv_str.AppendInt("\t", block_num);
+    tsv_str.AppendInt("\t", par_num);
+    tsv_str.AppendInt("\t", line_num);
+    tsv_str.AppendInt("\t", word_num);
+    tsv_str.AppendInt("\t", left);
+    tsv_str.AppendInt("\t", top);
+    tsv_str.AppendInt("\t", right - left);
+    tsv_str.AppendInt("\t", bottom - top);
+    tsv_str.AppendInt("\t", res_it->Confidence(RIL_WORD));
+    tsv_str.Append("\t");
 
     // Increment counts if at end of block/paragraph/textline.
     if (res_it->IsAtFinalElement(RIL_TEXTLINE, RIL_WORD)) lcnt++;
@@ -1699,17 +2956,232 @@ char* TessBaseAPI::GetTSVText(int page_number) {
     if (res_it->IsAtFinalElement(RIL_BLOCK, RIL_WORD)) bcnt++;
 
     do {
-      tsv_str += res_it->GetUTF8Text(RIL_SYMBOL);
+      char* grapheme = res_it->GetUTF8Text(RIL_SYMBOL);
+      if (grapheme != NULL)
+        tsv_str.Append(grapheme);
+      delete[] grapheme;
       res_it->Next(RIL_SYMBOL);
     } while (!res_it->Empty(RIL_BLOCK) && !res_it->IsAtBeginningOf(RIL_WORD));
-    tsv_str += "\n";  // end of row
+    tsv_str.Append("\n");  // end of row
     wcnt++;
   }
 
-  char* ret = new char[tsv_str.length() + 1];
-  strcpy(ret, tsv_str.string());
   delete res_it;
-  return ret;
+  return tsv_str.Release();
+}
+
+static void AddBoxToJSON(const PageIterator* it, PageIteratorLevel level,
+                         TextBuffer* json_str) {
+  int left, top, right, bottom;
+  it->BoundingBox(level, &left, &top, &right, &bottom);
+  json_str->AppendInt("\"bbox\":[", left);
+  json_str->AppendInt(",", top);
+  json_str->AppendInt(",", right);
+  json_str->AppendInt(",", bottom);
+  json_str->Append(']');
+}
+
+// Adds the box, the baseline if there is one and the confidence of the
+// element at level, as the first members of its object.
+static void AddElementToJSON(const ResultIterator* it,
+                             PageIteratorLevel level, TextBuffer* json_str) {
+  json_str->Append('{');
+  AddBoxToJSON(it, level, json_str);
+  int x1, y1, x2, y2;
+  if (level == RIL_TEXTLINE && it->Baseline(level, &x1, &y1, &x2, &y2)) {
+    json_str->AppendInt(",\"baseline\":[", x1);
+    json_str->AppendInt(",", y1);
+    json_str->AppendInt(",", x2);
+    json_str->AppendInt(",", y2);
+    json_str->Append(']');
+  }
+  json_str->AppendDouble(",\"conf\":", it->Confidence(level));
+}
+
+/**
+ * Make a JSON object of the page from the internal data structures.
+ * page_number is 0-based but will appear in the output as 1-based.
+ */
+char* TessBaseAPI::GetJSONText(int page_number) {
+  if (tesseract_ == NULL || (page_res_ == NULL && Recognize(NULL) < 0))
+    return NULL;
+
+  // A word object with its box and confidence takes about 60 bytes, and
+  // each of its symbols about as much again.
+  const int kJSONWordBytes = 100;
+  const int kJSONCharBytes = 64;
+  TextBuffer json_str(EstimateTextSize(page_res_, kJSONWordBytes,
+                                       kJSONCharBytes));
+  // The text of the current word, escaped while its symbols are written.
+  TextBuffer word_text(64);
+
+  if (input_file_ == NULL)
+      SetInputName(NULL);
+
+  json_str.AppendInt("{\"page\":", page_number + 1);
+  json_str.Append(",\"image\":\"");
+  json_str.AppendJsonEscaped(input_file_->string());
+  json_str.AppendInt("\",\"bbox\":[", rect_left_);
+  json_str.AppendInt(",", rect_top_);
+  json_str.AppendInt(",", rect_left_ + rect_width_);
+  json_str.AppendInt(",", rect_top_ + rect_height_);
+  json_str.Append("],\"blocks\":[");
+
+  bool first_block = true;
+  ResultIterator* res_it = GetIterator();
+  while (!res_it->Empty(RIL_BLOCK)) {
+    if (res_it->Empty(RIL_WORD)) {
+      res_it->Next(RIL_WORD);
+      continue;
+    }
+
+    // Open objects for any new block/paragraph/textline, each separated
+    // from the one before it unless it is the first of its parent.
+    if (res_it->IsAtBeginningOf(RIL_BLOCK)) {
+      if (!first_block) json_str.Append(',');
+      first_block = false;
+      AddElementToJSON(res_it, RIL_BLOCK, &json_str);
+      json_str.Append(",\"paragraphs\":[");
+    }
+    if (res_it->IsAtBeginningOf(RIL_PARA)) {
+      if (!res_it->IsAtBeginningOf(RIL_BLOCK)) json_str.Append(',');
+      AddElementToJSON(res_it, RIL_PARA, &json_str);
+      json_str.Append(res_it->ParagraphIsLtr() ? ",\"ltr\":true"
+                                               : ",\"ltr\":false");
+      json_str.Append(",\"lines\":[");
+    }
+    if (res_it->IsAtBeginningOf(RIL_TEXTLINE)) {
+      if (!res_it->IsAtBeginningOf(RIL_PARA)) json_str.Append(',');
+      AddElementToJSON(res_it, RIL_TEXTLINE, &json_str);
+      json_str.Append(",\"words\":[");
+    }
+
+    // Now, process the word...
+    if (!res_it->IsAtBeginningOf(RIL_TEXTLINE)) json_str.Append(',');
+    AddElementToJSON(res_it, RIL_WORD, &json_str);
+    json_str.Append(",\"symbols\":[");
+    bool last_word_in_line = res_it->IsAtFinalElement(RIL_TEXTLINE, RIL_WORD);
+    bool last_word_in_para = res_it->IsAtFinalElement(RIL_PARA, RIL_WORD);
+    bool last_word_in_block = res_it->IsAtFinalElement(RIL_BLOCK, RIL_WORD);
+    word_text.clear();
+    do {
+      if (!res_it->IsAtBeginningOf(RIL_WORD)) json_str.Append(',');
+      AddElementToJSON(res_it, RIL_SYMBOL, &json_str);
+      json_str.Append(",\"text\":\"");
+      int text_start = json_str.length();
+      char* grapheme = res_it->GetUTF8Text(RIL_SYMBOL);
+      if (grapheme != NULL)
+        json_str.AppendJsonEscaped(grapheme);
+      delete[] grapheme;
+      word_text.Append(json_str.data() + text_start,
+                       json_str.length() - text_start);
+      json_str.Append("\"}");
+      res_it->Next(RIL_SYMBOL);
+    } while (!res_it->Empty(RIL_BLOCK) && !res_it->IsAtBeginningOf(RIL_WORD));
+    json_str.Append("],\"text\":\"");
+    json_str.Append(word_text);
+    json_str.Append("\"}");
+
+    // Close the textline/paragraph/block the word ends.
+    if (last_word_in_line) json_str.Append("]}");
+    if (last_word_in_para) json_str.Append("]}");
+    if (last_word_in_block) json_str.Append("]}");
+  }
+  json_str.Append("]}");
+
+  delete res_it;
+  return json_str.Release();
+}
+
+/**
+ * Make a flat binary buffer of the results at the given level, in the
+ * layout described in baseapi.h.
+ */
+char* TessBaseAPI::GetResultsPacked(PageIteratorLevel level, int* size) {
+  if (tesseract_ == NULL ||
+      (!recognition_done_ && Recognize(NULL) < 0))
+    return NULL;
+
+  GenericVector<inT32> records;
+  GenericVector<char> pool;
+  ResultIterator* res_it = GetIterator();
+  while (!res_it->Empty(RIL_BLOCK)) {
+    if (res_it->Empty(RIL_WORD)) {
+      res_it->Next(RIL_WORD);
+      continue;
+    }
+    int left, top, right, bottom;
+    res_it->BoundingBox(level, &left, &top, &right, &bottom);
+    float confidence = res_it->Confidence(level);
+    inT32 confidence_bits;
+    memcpy(&confidence_bits, &confidence, sizeof(confidence_bits));
+
+    int text_offset = pool.size();
+    char* text = res_it->GetUTF8Text(level);
+    if (text != NULL) {
+      for (const char* ch = text; *ch != '\0'; ++ch)
+        pool.push_back(*ch);
+      delete [] text;
+    }
+    int text_length = pool.size() - text_offset;
+    pool.push_back('\0');
+
+    int flags = 0;
+    int pointsize = 0, font_id = -1;
+    if (level == RIL_WORD || level == RIL_SYMBOL) {
+      bool bold, italic, underlined, monospace, serif, smallcaps;
+      if (res_it->WordFontAttributes(&bold, &italic, &underlined, &monospace,
+                                     &serif, &smallcaps, &pointsize,
+                                     &font_id) != NULL) {
+        if (bold) flags |= PRF_BOLD;
+        if (italic) flags |= PRF_ITALIC;
+        if (underlined) flags |= PRF_UNDERLINED;
+        if (monospace) flags |= PRF_MONOSPACE;
+        if (serif) flags |= PRF_SERIF;
+        if (smallcaps) flags |= PRF_SMALLCAPS;
+      } else {
+        pointsize = 0;
+        font_id = -1;
+      }
+    }
+    if (level == RIL_WORD) {
+      if (res_it->WordIsFromDictionary()) flags |= PRF_FROM_DICTIONARY;
+      if (res_it->WordIsNumeric()) flags |= PRF_NUMERIC;
+    }
+    if (res_it->IsAtBeginningOf(RIL_BLOCK)) flags |= PRF_BLOCK_START;
+    if (res_it->IsAtBeginningOf(RIL_PARA)) flags |= PRF_PARA_START;
+    if (res_it->IsAtBeginningOf(RIL_TEXTLINE)) flags |= PRF_LINE_START;
+
+    records.push_back(left);
+    records.push_back(top);
+    records.push_back(right);
+    records.push_back(bottom);
+    records.push_back(confidence_bits);
+    records.push_back(text_offset);
+    records.push_back(text_length);
+    records.push_back(flags);
+    records.push_back(pointsize);
+    records.push_back(font_id);
+    res_it->Next(level);
+  }
+  delete res_it;
+
+  inT32 header[kPackedResultsHeaderSize] = {
+    kPackedResultsVersion, level,
+    records.size() / kPackedResultsRecordSize,
+    kPackedResultsRecordSize * static_cast<int>(sizeof(inT32)),
+    pool.size()
+  };
+  int header_bytes = sizeof(header);
+  int record_bytes = records.size() * sizeof(inT32);
+  *size = header_bytes + record_bytes + pool.size();
+  char* result = new char[*size];
+  memcpy(result, header, header_bytes);
+  if (record_bytes > 0)
+    memcpy(result + header_bytes, &records[0], record_bytes);
+  if (pool.size() > 0)
+    memcpy(result + header_bytes + record_bytes, &pool[0], pool.size());
+  return result;
 }
 
 /** The 5 numbers output for each box (the usual 4 and a page number.) */
@@ -2108,6 +3580,10 @@ void TessBaseAPI::End() {
     delete paragraph_models_;
     paragraph_models_ = NULL;
   }
+  // The cached results refer to the languages of tesseract_.
+  delete result_cache_;
+  result_cache_ = NULL;
+  ClearWordWorkers();
   if (tesseract_ != NULL) {
     delete tesseract_;
     if (osd_tesseract_ == tesseract_)
@@ -2122,6 +3598,15 @@ void TessBaseAPI::End() {
     delete equ_detect_;
     equ_detect_ = NULL;
   }
+  if (frame_history_ != NULL) {
+    delete frame_history_;
+    frame_history_ = NULL;
+  }
+  if (tables_ != NULL) {
+    ClearTables();
+    delete tables_;
+    tables_ = NULL;
+  }
   if (input_file_ != NULL) {
     delete input_file_;
     input_file_ = NULL;
@@ -2141,12 +3626,68 @@ void TessBaseAPI::End() {
 }
 
 // Clear any library-level memory caches.
-// There are a variety of expensive-to-load constant data structures (mostly
-// language dictionaries) that are cached globally -- surviving the Init()
-// and End() of individual TessBaseAPI's.  This function allows the clearing
-// of these caches.
+// There are a variety of expensive-to-load constant data structures (language
+// dictionaries and classifier templates) that are cached globally --
+// surviving the Init() and End() of individual TessBaseAPI's.  This function
+// allows the clearing of these caches.
 void TessBaseAPI::ClearPersistentCache() {
+  Dict::GlobalDawgCache()->ReleasePreloadedDawgs();
   Dict::GlobalDawgCache()->DeleteUnusedDawgs();
+  Classify::GlobalModelCache()->DeleteUnusedModels();
+}
+
+// The languages to load for PreloadLanguages.
+struct PreloadJob {
+  STRING data_dir;
+  GenericVector<STRING> langs;
+};
+
+// Loads the dawgs of each language of job into the global cache and
+// deletes job.
+static void RunPreloadJob(PreloadJob* job) {
+  for (int i = 0; i < job->langs.size(); ++i) {
+    STRING data_file_name = job->data_dir + job->langs[i];
+    data_file_name += ".";
+    data_file_name += kTrainedDataSuffix;
+    // The defaults of map_dawgs_in_place, compile_dawg_lookup and
+    // index_dawg_words, which the first Dict to load a dawg gets anyway.
+    Dict::GlobalDawgCache()->PreloadDawgs(job->langs[i],
+                                          data_file_name.string(), 0, false,
+                                          true, true);
+  }
+  delete job;
+}
+
+#ifndef _WIN32
+static void* PreloadThreadEntry(void* job) {
+  RunPreloadJob(static_cast<PreloadJob*>(job));
+  return NULL;
+}
+#endif
+
+bool TessBaseAPI::PreloadLanguages(const char* datapath,
+                                   const char* language) {
+  PreloadJob* job = new PreloadJob;
+  // Finds the tessdata directory the same way Init does.
+  CCUtil paths;
+  paths.main_setup(datapath, "");
+  job->data_dir = paths.datadir;
+  GenericVector<STRING> langs;
+  STRING(language != NULL ? language : "eng").split('+', &langs);
+  for (int i = 0; i < langs.size(); ++i) {
+    // Languages that Init would not load are skipped.
+    if (langs[i].length() > 0 && langs[i][0] != '~')
+      job->langs.push_back(langs[i]);
+  }
+#ifndef _WIN32
+  pthread_t thread;
+  if (pthread_create(&thread, NULL, &PreloadThreadEntry, job) == 0) {
+    pthread_detach(thread);
+    return true;
+  }
+#endif
+  RunPreloadJob(job);
+  return false;
 }
 
 /**
@@ -2156,6 +3697,22 @@ void TessBaseAPI::ClearPersistentCache() {
 int TessBaseAPI::IsValidWord(const char *word) {
   return tesseract_->getDict().valid_word(word);
 }
+
+int TessBaseAPI::AddUserWords(const char* const* words) {
+  if (tesseract_ == NULL) return 0;
+  return tesseract_->AddUserWords(words);
+}
+
+int TessBaseAPI::AddUserPatterns(const char* const* patterns) {
+  if (tesseract_ == NULL) return 0;
+  return tesseract_->AddUserPatterns(patterns);
+}
+
+void TessBaseAPI::ClearUserWords() {
+  if (tesseract_ == NULL) return;
+  tesseract_->ClearUserWords();
+}
+
 // Returns true if utf8_character is defined in the UniCharset.
 bool TessBaseAPI::IsValidCharacter(const char *utf8_character) {
     return tesseract_->unicharset.contains_unichar(utf8_character);
@@ -2241,6 +3798,34 @@ bool TessBaseAPI::InternalSetImage() {
   return true;
 }
 
+// Fewest character-like blobs that give a credible median blob height.
+const int kMinAutoScaleBlobs = 20;
+
+// Returns the median height in pixels of the character-like blobs of the
+// binary image, which are found on a 2x reduction of it for speed, or 0 if
+// there are too few of them.
+static int MedianBlobHeight(Pix* binary) {
+  Pix* reduced = pixReduceRankBinaryCascade(binary, 1, 0, 0, 0);
+  if (reduced == NULL) return 0;
+  Boxa* boxa = pixConnCompBB(reduced, 8);
+  int max_height = pixGetHeight(reduced) / 4;
+  pixDestroy(&reduced);
+  if (boxa == NULL) return 0;
+  GenericVector<int> heights;
+  int num_boxes = boxaGetCount(boxa);
+  for (int b = 0; b < num_boxes; ++b) {
+    int width, height;
+    boxaGetBoxGeometry(boxa, b, NULL, NULL, &width, &height);
+    // Specks, rules and pictures are not characters.
+    if (height >= 3 && height <= max_height && width <= 3 * height)
+      heights.push_back(height);
+  }
+  boxaDestroy(&boxa);
+  if (heights.size() < kMinAutoScaleBlobs) return 0;
+  heights.sort();
+  return 2 * heights[heights.size() / 2];
+}
+
 /**
  * Run the thresholder to make the thresholded image, returned in pix,
  * which must not be NULL. *pix must be initialized to NULL, or point
@@ -2249,6 +3834,8 @@ bool TessBaseAPI::InternalSetImage() {
  */
 void TessBaseAPI::Threshold(Pix** pix) {
   ASSERT_HOST(pix != NULL);
+  StageTimer timer(tesseract_ != NULL ? tesseract_->mutable_stage_timings()
+                                      : NULL, STAGE_THRESHOLD);
   if (*pix != NULL)
     pixDestroy(pix);
   // Zero resolution messes up the algorithms, so make sure it is credible.
@@ -2263,7 +3850,29 @@ void TessBaseAPI::Threshold(Pix** pix) {
   PageSegMode pageseg_mode =
       static_cast<PageSegMode>(
           static_cast<int>(tesseract_->tessedit_pageseg_mode));
+  thresholder_->SetThresholdMethod(
+      static_cast<ThresholdMethod>(
+          static_cast<int>(tesseract_->tessedit_thresholding_method)),
+      tesseract_->thresholding_window_size, tesseract_->thresholding_kfactor,
+      tesseract_->thresholding_tile_size,
+      tesseract_->thresholding_smooth_kernel_size,
+      tesseract_->thresholding_score_fraction);
   thresholder_->ThresholdToPix(pageseg_mode, pix);
+  int max_xheight = tesseract_->tessedit_auto_scale_xheight;
+  if (max_xheight > 0 && thresholder_->GetReductionFactor() == 1) {
+    // Text larger than max_xheight is reduced by the smallest integer factor
+    // that brings it within, and thresholded again at the reduced size. The
+    // median blob height stands in for the x-height, as most characters
+    // are lower case.
+    int reduction = (MedianBlobHeight(*pix) + max_xheight - 1) / max_xheight;
+    if (reduction > 1) {
+      thresholder_->ReduceRectangle(reduction);
+      if (thresholder_->GetReductionFactor() > 1) {
+        pixDestroy(pix);
+        thresholder_->ThresholdToPix(pageseg_mode, pix);
+      }
+    }
+  }
   thresholder_->GetImageSizes(&rect_left_, &rect_top_,
                               &rect_width_, &rect_height_,
                               &image_width_, &image_height_);
@@ -2289,7 +3898,146 @@ void TessBaseAPI::Threshold(Pix** pix) {
   SavePixForCrash(estimated_res, *pix);
 }
 
+/**
+ * Threshold the whole image and keep its images, so that parts of it can be
+ * recognized without thresholding again.
+ */
+void TessBaseAPI::ThresholdPage(Pix** binary, Pix** grey, Pix** thresholds) {
+  int left, top, width, height, image_width, image_height;
+  thresholder_->GetImageSizes(&left, &top, &width, &height,
+                              &image_width, &image_height);
+  SetRectangle(0, 0, image_width, image_height);
+  *binary = NULL;
+  Threshold(binary);
+  *grey = tesseract_->pix_grey() != NULL
+      ? pixClone(tesseract_->pix_grey()) : NULL;
+  *thresholds = tesseract_->pix_thresholds() != NULL
+      ? pixClone(tesseract_->pix_thresholds()) : NULL;
+}
+
+/**
+ * Recognize a rectangle of a page from ThresholdPage by handing the clipped
+ * page images to Tesseract in place of thresholding the rectangle.
+ */
+char* TessBaseAPI::RecognizeClippedRegion(Pix* binary, Pix* grey,
+                                          Pix* thresholds,
+                                          int left, int top,
+                                          int width, int height,
+                                          ETEXT_DESC* monitor,
+                                          int* confidence) {
+  *confidence = 0;
+  // SetRectangle clears the previous region, including its images.
+  SetRectangle(left, top, width, height);
+  thresholder_->GetImageSizes(&rect_left_, &rect_top_,
+                              &rect_width_, &rect_height_,
+                              &image_width_, &image_height_);
+  Box* box = boxCreate(left, top, width, height);
+  *tesseract_->mutable_pix_binary() = pixClipRectangle(binary, box, NULL);
+  if (grey != NULL) {
+    tesseract_->set_pix_grey(pixClipRectangle(grey, box, NULL));
+    tesseract_->set_pix_thresholds(pixClipRectangle(thresholds, box, NULL));
+  }
+  boxDestroy(&box);
+  if (Recognize(monitor) != 0)
+    return NULL;
+  *confidence = MeanTextConf();
+  return GetUTF8Text();
+}
+
 /** Find lines from the image making the BLOCK_LIST. */
+// Sets *fingerprint to the black fraction of each cell of binary, which is
+// at least kFingerprintSize pixels in each direction.
+static void FingerprintPage(Pix* binary, GenericVector<uinT8>* fingerprint) {
+  int width = pixGetWidth(binary);
+  int height = pixGetHeight(binary);
+  l_int32* sum_tab = makePixelSumTab8();
+  fingerprint->truncate(0);
+  for (int y = 0; y < kFingerprintSize; ++y) {
+    int top = y * height / kFingerprintSize;
+    int bottom = (y + 1) * height / kFingerprintSize;
+    for (int x = 0; x < kFingerprintSize; ++x) {
+      int left = x * width / kFingerprintSize;
+      int right = (x + 1) * width / kFingerprintSize;
+      Box* cell = boxCreate(left, top, right - left, bottom - top);
+      Pix* cell_pix = pixClipRectangle(binary, cell, NULL);
+      boxDestroy(&cell);
+      l_int32 count = 0;
+      if (cell_pix != NULL) pixCountPixels(cell_pix, &count, sum_tab);
+      pixDestroy(&cell_pix);
+      fingerprint->push_back(
+          count * 255 / ((right - left) * (bottom - top)));
+    }
+  }
+  lept_free(sum_tab);
+}
+
+bool TessBaseAPI::CachePageResults() {
+  if (!recognition_done_ || tesseract_ == NULL ||
+      !tesseract_->tessedit_result_cache || result_cache_ == NULL ||
+      !result_cache_->page_key.valid)
+    return false;
+  result_cache_->Clear();
+  result_cache_->key = result_cache_->page_key;
+  result_cache_->page_res = page_res_;
+  // The results point into the blocks and the paragraph models.
+  result_cache_->block_list = block_list_;
+  block_list_ = new BLOCK_LIST;
+  result_cache_->paragraph_models = paragraph_models_;
+  paragraph_models_ = NULL;
+  return true;
+}
+
+bool TessBaseAPI::RestoreCachedResults() {
+  if (!tesseract_->tessedit_result_cache) {
+    delete result_cache_;
+    result_cache_ = NULL;
+    return false;
+  }
+  Pix* binary = tesseract_->pix_binary();
+  if (binary == NULL || pixGetWidth(binary) < kFingerprintSize ||
+      pixGetHeight(binary) < kFingerprintSize)
+    return false;
+  if (result_cache_ == NULL) result_cache_ = new ResultCache;
+  PageKey* page_key = &result_cache_->page_key;
+  page_key->left = rect_left_;
+  page_key->top = rect_top_;
+  page_key->width = rect_width_;
+  page_key->height = rect_height_;
+  GetParamsSnapshot(&page_key->params);
+  FingerprintPage(binary, &page_key->fingerprint);
+  page_key->valid = true;
+  const PageKey& key = result_cache_->key;
+  if (!key.valid || key.left != page_key->left || key.top != page_key->top ||
+      key.width != page_key->width || key.height != page_key->height ||
+      key.params.size() != page_key->params.size() ||
+      (!key.params.empty() &&
+       memcmp(&key.params[0], &page_key->params[0], key.params.size()) != 0))
+    return false;
+  int total_diff = 0;
+  for (int c = 0; c < key.fingerprint.size(); ++c)
+    total_diff += abs(key.fingerprint[c] - page_key->fingerprint[c]);
+  if (total_diff * 100.0 / (255 * key.fingerprint.size()) >
+      tesseract_->tessedit_result_cache_diff)
+    return false;
+  // Take the results back, keeping the key of the page they were made for,
+  // so a slow drift of the image doesn't carry them along.
+  delete page_res_;
+  page_res_ = result_cache_->page_res;
+  result_cache_->page_res = NULL;
+  delete block_list_;
+  block_list_ = result_cache_->block_list;
+  result_cache_->block_list = NULL;
+  if (paragraph_models_ != NULL) {
+    paragraph_models_->delete_data_pointers();
+    delete paragraph_models_;
+  }
+  paragraph_models_ = result_cache_->paragraph_models;
+  result_cache_->paragraph_models = NULL;
+  *page_key = key;
+  recognition_done_ = true;
+  return true;
+}
+
 int TessBaseAPI::FindLines() {
   if (thresholder_ == NULL || thresholder_->IsEmpty()) {
     tprintf("Please call SetImage before attempting recognition.");
@@ -2312,6 +4060,9 @@ int TessBaseAPI::FindLines() {
             tesseract_->ImageWidth(), tesseract_->ImageHeight());
     return -1;
   }
+  // The same page again needs no layout analysis or recognition.
+  if (RestoreCachedResults())
+    return 0;
 
   tesseract_->PrepareForPageseg();
 
@@ -2343,6 +4094,14 @@ int TessBaseAPI::FindLines() {
       }
     }
   }
+  if (osd_tess != NULL && osd_tess != tesseract_) {
+    // OSD classifies on the same threads and stops at the same margin as
+    // the main language.
+    osd_tess->tessedit_parallelize.set_value(
+        tesseract_->tessedit_parallelize);
+    osd_tess->min_orientation_margin.set_value(
+        tesseract_->min_orientation_margin);
+  }
 
   if (tesseract_->SegmentPage(input_file_, block_list_, osd_tess, &osr) < 0)
     return -1;
@@ -2357,10 +4116,11 @@ void TessBaseAPI::ClearResults() {
   if (tesseract_ != NULL) {
     tesseract_->Clear();
   }
-  if (page_res_ != NULL) {
+  if (page_res_ != NULL && !CachePageResults()) {
     delete page_res_;
-    page_res_ = NULL;
   }
+  page_res_ = NULL;
+  if (result_cache_ != NULL) result_cache_->page_key.valid = false;
   recognition_done_ = false;
   if (block_list_ == NULL)
     block_list_ = new BLOCK_LIST;
@@ -2422,6 +4182,83 @@ bool TessBaseAPI::DetectOS(OSResults* osr) {
   return orientation_and_script_detection(*input_file_, osr, tesseract_);
 }
 
+const LayoutTimings* TessBaseAPI::GetLayoutTimings() const {
+  if (tesseract_ == NULL)
+    return NULL;
+  return &tesseract_->layout_timings();
+}
+
+const StageTimings* TessBaseAPI::GetTimings() const {
+  if (tesseract_ == NULL)
+    return NULL;
+  return &tesseract_->stage_timings();
+}
+
+const PageCounts* TessBaseAPI::GetPageCounts() const {
+  if (tesseract_ == NULL)
+    return NULL;
+  return &tesseract_->page_counts();
+}
+
+const PageArenaStats& TessBaseAPI::GetPageArenaStats() const {
+  return *arena_stats_;
+}
+
+// Adds the bytes of the raster of pix to *bytes, unless its raster is one
+// of those already seen, as pixClone shares it.
+static void AddPixBytes(Pix* pix, GenericVector<const void*>* seen,
+                        inT64* bytes) {
+  if (pix == NULL || seen->contains(pixGetData(pix))) return;
+  seen->push_back(pixGetData(pix));
+  *bytes += static_cast<inT64>(pixGetWpl(pix)) * pixGetHeight(pix) *
+      sizeof(l_uint32);
+}
+
+// Returns the bytes of the images of the page held by tesseract.
+static inT64 PageImageBytes(const Tesseract* tesseract) {
+  inT64 bytes = 0;
+  GenericVector<const void*> seen;
+  AddPixBytes(tesseract->pix_original(), &seen, &bytes);
+  AddPixBytes(tesseract->pix_binary(), &seen, &bytes);
+  AddPixBytes(tesseract->pix_grey(), &seen, &bytes);
+  AddPixBytes(tesseract->pix_thresholds(), &seen, &bytes);
+  AddPixBytes(tesseract->scaled_color(), &seen, &bytes);
+  return bytes;
+}
+
+inT64 TessBaseAPI::PageMemoryUsed() const {
+  inT64 bytes = 0;
+  if (tesseract_ != NULL) bytes += PageImageBytes(tesseract_);
+  if (page_res_ != NULL) bytes += page_res_->MemoryUsed();
+  return bytes;
+}
+
+bool TessBaseAPI::GetMemoryUsage(MemoryUsage* usage) const {
+  usage->Clear();
+  if (tesseract_ == NULL)
+    return false;
+  tesseract_->AddMemoryUsage(usage);
+  if (osd_tesseract_ != NULL && osd_tesseract_ != tesseract_)
+    osd_tesseract_->AddMemoryUsage(usage);
+  usage->bytes[MEMORY_IMAGES] = PageImageBytes(tesseract_);
+  if (page_res_ != NULL)
+    usage->bytes[MEMORY_PAGE_RESULTS] = page_res_->MemoryUsed();
+  usage->page_peak_bytes = MAX(page_peak_bytes_,
+                               usage->bytes[MEMORY_IMAGES] +
+                               usage->bytes[MEMORY_PAGE_RESULTS]);
+  usage->peak_resident_bytes = MemoryUsage::PeakResidentBytes();
+  return true;
+}
+
+void TessBaseAPI::SetPageSkew(float angle) {
+  if (tesseract_ != NULL)
+    tesseract_->SetPageSkew(angle);
+}
+
+bool TessBaseAPI::GetPageSkew(float* angle) const {
+  return tesseract_ != NULL && tesseract_->GetPageSkew(angle);
+}
+
 void TessBaseAPI::set_min_orientation_margin(double margin) {
   tesseract_->min_orientation_margin.set_value(margin);
 }
@@ -2634,19 +4471,57 @@ PAGE_RES* TessBaseAPI::RecognitionPass2(BLOCK_LIST* block_list,
   return pass1_result;
 }
 
+// The blocks of a page to detect the paragraphs of, each with the models
+// found for it.
+struct ParagraphJob {
+  int debug_level;
+  bool after_text_recognition;
+  PointerVector<MutableIterator> block_starts;
+  GenericVector<GenericVector<ParagraphModel*> > models;
+};
+
+// Detects the paragraphs of block b of the job. The blocks are independent,
+// so they may run in parallel.
+static void DetectBlockParagraphs(ParagraphJob* job, int b) {
+  ::tesseract::DetectParagraphs(job->debug_level, job->after_text_recognition,
+                                job->block_starts[b], &job->models[b]);
+}
+
 void TessBaseAPI::DetectParagraphs(bool after_text_recognition) {
   int debug_level = 0;
   GetIntVariable("paragraph_debug_level", &debug_level);
   if (paragraph_models_ == NULL)
     paragraph_models_ = new GenericVector<ParagraphModel*>;
   MutableIterator *result_it = GetMutableIterator();
-  do {  // Detect paragraphs for this block
-    GenericVector<ParagraphModel *> models;
-    ::tesseract::DetectParagraphs(debug_level, after_text_recognition,
-                                  result_it, &models);
-    *paragraph_models_ += models;
+  ParagraphJob job;
+  job.debug_level = debug_level;
+  job.after_text_recognition = after_text_recognition;
+  do {
+    job.block_starts.push_back(new MutableIterator(*result_it));
   } while (result_it->Next(RIL_BLOCK));
   delete result_it;
+  job.models.init_to_size(job.block_starts.size(),
+                          GenericVector<ParagraphModel*>());
+  // Debug output of several blocks at once would be unreadable.
+  ThreadPool* thread_pool =
+      debug_level == 0 ? tesseract_->RecognitionThreadPool() : NULL;
+  if (thread_pool != NULL && thread_pool->num_threads() > 1 &&
+      job.block_starts.size() > 1) {
+    // Iterating the page updates prev_word_best_choice, which is only wanted
+    // during recognition and would be written by every block at once.
+    WERD_CHOICE** prev_word_best_choice = page_res_->prev_word_best_choice;
+    page_res_->prev_word_best_choice = NULL;
+    TessCallback1<int>* detect =
+        NewPermanentTessCallback(&DetectBlockParagraphs, &job);
+    thread_pool->ParallelFor(job.block_starts.size(), detect);
+    delete detect;
+    page_res_->prev_word_best_choice = prev_word_best_choice;
+  } else {
+    for (int b = 0; b < job.block_starts.size(); ++b)
+      DetectBlockParagraphs(&job, b);
+  }
+  for (int b = 0; b < job.models.size(); ++b)
+    *paragraph_models_ += job.models[b];
 }
 
 struct TESS_CHAR : ELIST_LINK {
@@ -53,6 +53,7 @@ struct Pix;
 struct Box;
 struct Pixa;
 struct Boxa;
+struct Numa;
 class ETEXT_DESC;
 struct OSResults;
 class TBOX;
@@ -71,7 +72,16 @@ class CubeRecoContext;
 class Dawg;
 class Dict;
 class EquationDetect;
+class FrameHistory;
+struct LayoutTimings;
+struct MemoryUsage;
+struct StageTimings;
+struct PageCounts;
+struct PageArenaStats;
 class PageIterator;
+struct RecognizedTable;
+struct ResultCache;
+struct TableCellJob;
 class LTRResultIterator;
 class ResultIterator;
 class MutableIterator;
@@ -96,6 +106,28 @@ typedef void (Wordrec::*FillLatticeFunc)(const MATRIX &ratings,
 typedef TessCallback4<const UNICHARSET &, int, PageIterator *, Pix *>
     TruthCallback;
 
+/** Layout version of the buffer made by TessBaseAPI::GetResultsPacked. */
+const int kPackedResultsVersion = 1;
+/** Number of 32 bit values in the header of a packed results buffer. */
+const int kPackedResultsHeaderSize = 5;
+/** Number of 32 bit values in each record of a packed results buffer. */
+const int kPackedResultsRecordSize = 10;
+
+/** Bits of the flags value of a record made by GetResultsPacked. */
+enum PackedResultFlag {
+  PRF_BOLD            = 0x001,
+  PRF_ITALIC          = 0x002,
+  PRF_UNDERLINED      = 0x004,
+  PRF_MONOSPACE       = 0x008,
+  PRF_SERIF           = 0x010,
+  PRF_SMALLCAPS       = 0x020,
+  PRF_FROM_DICTIONARY = 0x040,  // The word is in one of the dictionaries.
+  PRF_NUMERIC         = 0x080,  // The word is a number.
+  PRF_BLOCK_START     = 0x100,  // The element begins a block.
+  PRF_PARA_START      = 0x200,  // The element begins a paragraph.
+  PRF_LINE_START      = 0x400,  // The element begins a text line.
+};
+
 /**
  * Base class for all tesseract APIs.
  * Specific classes can add ability to work on different inputs or produce
@@ -103,6 +135,18 @@ typedef TessCallback4<const UNICHARSET &, int, PageIterator *, Pix *>
  * This class is mostly an interface layer on top of the Tesseract instance
  * class to hide the data types so that users of this class don't have to
  * include any other Tesseract headers.
+ *
+ * Reentrancy: an instance must only be used by one thread at a time, apart
+ * from the ETEXT_DESC cancel callback given to Recognize, which may be
+ * triggered from any thread. Separate instances share no mutable state
+ * except the global parameters, so a pool of instances, one per thread,
+ * recognizes in parallel. The caches of data shared between instances
+ * (traineddata files, dawgs, classifiers) and tprintf lock internally.
+ * The global parameters are those that don't belong to the Tesseract class,
+ * such as most textord and classify parameters and debug_file. Setting one,
+ * through SetVariable, the configs given to Init or SetParamsSnapshot,
+ * changes it for every instance, so do that before any instance starts
+ * recognizing in another thread.
  */
 class TESS_API TessBaseAPI {
  public:
@@ -123,12 +167,36 @@ class TESS_API TessBaseAPI {
    */
   static size_t getOpenCLDevice(void **device);
 
+  /**
+   * Sets the directory where the compiled OpenCL kernels and the device
+   * profile are kept between runs. Call before the first Init. Does nothing
+   * if built without OpenCL.
+   */
+  static void SetOpenCLCacheDir(const char* dir);
+
+  /**
+   * Sets report to a line per OpenCL operation and image size, giving
+   * whether it currently runs on the device or on the CPU and the recent
+   * times of both. Returns false if built without OpenCL.
+   */
+  static bool GetOpenCLRoutes(STRING* report);
+
   /**
    * Writes the thresholded image to stderr as a PBM file on receipt of a
    * SIGSEGV, SIGFPE, or SIGBUS signal. (Linux/Unix only).
    */
   static void CatchSignals();
 
+  /**
+   * Sets the number of worker threads that all the engines of the process
+   * share for their parallel work, or one less than the number of cores if
+   * num_workers is negative (the default), and whether the workers run only
+   * on the fastest cores of a big.LITTLE CPU. The threads of each engine are
+   * still limited by its tessedit_parallelize. Must not be called while any
+   * engine is recognizing.
+   */
+  static void ConfigureWorkerThreads(int num_workers, bool big_cores_only);
+
   /**
    * Set the name of the input file. Needed for training and
    * reading a UNLV zone file, and for searchable PDF output.
@@ -166,6 +234,12 @@ class TESS_API TessBaseAPI {
    */
   bool SetVariable(const char* name, const char* value);
   bool SetDebugVariable(const char* name, const char* value);
+  /**
+   * Sets num_variables parameters as SetVariable would, from name_values,
+   * which holds each name followed by its value. Returns the number of
+   * names that were found.
+   */
+  int SetVariables(const char* const* name_values, int num_variables);
 
   /**
    * Returns true if the parameter was found among Tesseract parameters.
@@ -181,6 +255,22 @@ class TESS_API TessBaseAPI {
    */
   const char *GetStringVariable(const char *name) const;
 
+  /**
+   * Writes the values of all the parameters, as left by Init and any later
+   * SetVariable, to data in a binary form that SetParamsSnapshot accepts.
+   * Returns false if Init has not been called.
+   */
+  bool GetParamsSnapshot(GenericVector<char>* data) const;
+  /**
+   * Makes later calls to Init and InitForAnalysePage set the parameters
+   * from a copy of the size bytes of data, as made by GetParamsSnapshot,
+   * instead of parsing the language config and the config files. The
+   * snapshot must come from an Init with the same language and configs.
+   * Variables passed to Init are still applied after it. A NULL data or
+   * a size of 0 clears the snapshot.
+   */
+  void SetParamsSnapshot(const char* data, int size);
+
   /**
    * Print Tesseract parameters to the given file.
    */
@@ -192,11 +282,11 @@ class TESS_API TessBaseAPI {
   bool GetVariableAsString(const char *name, STRING *val);
 
   /**
-   * Instances are now mostly thread-safe and totally independent,
-   * but some global parameters remain. Basically it is safe to use multiple
-   * TessBaseAPIs in different threads in parallel, UNLESS:
-   * you use SetVariable on some of the Params in classify and textord.
-   * If you do, then the effect will be to change it for all your instances.
+   * Instances are independent, apart from the global parameters, so it is
+   * safe to use multiple TessBaseAPIs in different threads in parallel
+   * UNLESS you use SetVariable on some of the Params in classify and
+   * textord. If you do, then the effect will be to change it for all your
+   * instances. See the class comment for what is reentrant.
    *
    * Start tesseract. Returns zero on success and -1 on failure.
    * NOTE that the only members that may be called before Init are those
@@ -241,6 +331,16 @@ class TESS_API TessBaseAPI {
     return Init(datapath, language, OEM_DEFAULT, NULL, 0, NULL, NULL, false);
   }
 
+  /**
+   * Initializes this instance with the datapath, languages and engine mode
+   * of source, which must have been initialized, and with the current
+   * values of all of its parameters, so that both recognize alike. The
+   * classifier templates and dictionaries are shared through the
+   * library-level caches rather than loaded a second time.
+   * Returns zero on success and -1 on failure.
+   */
+  int InitLike(const TessBaseAPI& source);
+
   /**
    * Returns the languages string used in the last valid initialization.
    * If the last initialization specified "deu+hin" then that will be
@@ -324,6 +424,47 @@ class TESS_API TessBaseAPI {
    */
   void ClearAdaptiveClassifier();
 
+  /**
+   * Cheaply prepares for a new document without reloading anything: Clear()s
+   * the image and results, forgets the frame history, the document
+   * dictionary and, unless keep_adaptive, the adaptive classifier. Loaded
+   * models and variables are kept, so there is no need to End and Init
+   * again between documents.
+   */
+  void ResetForNewDocument(bool keep_adaptive = false);
+
+  /**
+   * Returns in *hits and *misses the counts of the cache of blob
+   * classifications enabled by classify_cache_size, since the classifier was
+   * initialized. Returns false, leaving them unchanged, if there is no cache.
+   */
+  bool GetClassifyCacheStats(int* hits, int* misses) const;
+
+  /**
+   * Saves what the adaptive classifier has learned so far to buffer, so that
+   * LoadAdaptiveState can restore it later, for example when the app
+   * restarts, instead of learning from scratch. Returns false if there is
+   * no adaptive classifier.
+   */
+  bool SaveAdaptiveState(GenericVector<char>* buffer) const;
+
+  /**
+   * Replaces the adaptive classifier with one saved by SaveAdaptiveState.
+   * Returns false, changing nothing, if the data is invalid or was saved with
+   * a different language or traineddata file.
+   */
+  bool LoadAdaptiveState(const char* data, int size);
+
+  /**
+   * Replaces the character ngram model of the language model with a
+   * compiled CharNgramTable, in the format of the char-ngram tessdata
+   * component, which then takes precedence over any loaded from the
+   * traineddata. The model is used while language_model_ngram_table_on is
+   * set, as it is by default. Returns false, changing nothing, if the data
+   * is invalid.
+   */
+  bool SetCharNgramTable(const char* data, int size);
+
   /**
    * @defgroup AdvancedAPI Advanced API
    * The following methods break TesseractRect into pieces, so you can
@@ -352,6 +493,29 @@ class TESS_API TessBaseAPI {
    */
   void SetImage(Pix* pix);
 
+  /**
+   * Provide an image for Tesseract to recognize as rows of 32 bit RGBA
+   * pixels, with the bytes in R, G, B, A order in memory, as locked from an
+   * Android RGBA_8888 bitmap. The pixels are converted to greyscale straight
+   * into the thresholder, without an intermediate Pix, and the grey histogram
+   * is gathered on the way so Otsu thresholding of the full image needs no
+   * extra pass. Tesseract takes its own copy, so the rows need not persist
+   * after this call.
+   */
+  void SetRGBAImageAsGrey(const unsigned char* rgba, int width, int height,
+                          int bytes_per_line);
+
+  /**
+   * Provide an image for Tesseract to recognize as rows of 8 bit grey
+   * pixels, such as the Y (luma) plane that starts an Android NV21 or
+   * YUV_420_888 camera frame, bytes_per_line being its row stride. The
+   * rows are taken as the grey image, with no color conversion, and the
+   * grey histogram is gathered while they are copied, as for
+   * SetRGBAImageAsGrey. The rows need not persist after this call.
+   */
+  void SetGreyImage(const unsigned char* grey, int width, int height,
+                    int bytes_per_line);
+
   /**
    * Set the resolution of the source image in pixels per inch so font size
    * information can be calculated in results.  Call this after SetImage().
@@ -365,6 +529,17 @@ class TESS_API TessBaseAPI {
    */
   void SetRectangle(int left, int top, int width, int height);
 
+  /**
+   * Makes Recognize recognize the words nearest to the given regions of the
+   * image first, in image coordinates, instead of in page order, so that with
+   * a deadline or the word callback of the monitor it can stop as soon as it
+   * has the words that matter. Copies the regions, which stay in use until
+   * replaced. NULL or empty to recognize in page order again.
+   */
+  void SetPriorityRegions(const Boxa* regions);
+  /** As SetPriorityRegions, with the single point x, y of the image. */
+  void SetPriorityPoint(int x, int y);
+
   /**
    * In extreme cases only, usually with a subclass of Thresholder, it
    * is possible to provide a different Thresholder. The Thresholder may
@@ -463,6 +638,18 @@ class TESS_API TessBaseAPI {
     return GetComponentImages(level, text_only, false, 0, pixa, blockids, NULL);
   }
 
+  /**
+   * Returns the image of the component at the given index in the Boxa that
+   * GetComponentImages returns for the same level, text_only, raw_image and
+   * raw_padding, or NULL if there is no such component. Calling
+   * GetComponentImages with a NULL pixa and then this for just the
+   * components that are wanted avoids making an image for every component.
+   * pixDestroy after use.
+   */
+  Pix* GetComponentImage(const PageIteratorLevel level, const bool text_only,
+                         const bool raw_image, const int raw_padding,
+                         int index);
+
   /**
    * Returns the scale factor of the thresholded image that would be returned by
    * GetThresholdedImage() and the various GetX() methods that call
@@ -478,6 +665,20 @@ class TESS_API TessBaseAPI {
    */
   void DumpPGM(const char* filename);
 
+  /**
+   * Fast text detection, for deciding whether and where there is text before
+   * running full OCR. Finds the text lines of the image from its connected
+   * components, stroke widths and textline projection only, without the
+   * line, image, tab and column finding of AnalyseLayout, and without
+   * recognition. Set tessedit_layout_reduction to 2 or 4 to run it on a
+   * reduced image for more speed.
+   * Returns the boxes of the lines in image coordinates, and, if scores is
+   * not NULL, a Numa of the likelihood, in [0, 1], that each line is text.
+   * Returns NULL on error. The Boxa must be boxaDestroyed and the Numa
+   * numaDestroyed by the caller. The current results are not changed.
+   */
+  Boxa* DetectTextLines(Numa** scores);
+
   /**
    * Runs page layout analysis in the mode set by SetPageSegMode.
    * May optionally be called prior to Recognize to get access to just
@@ -512,6 +713,143 @@ class TESS_API TessBaseAPI {
   /** Variant on Recognize used for testing chopper. */
   int RecognizeForChopTest(ETEXT_DESC* monitor);
 
+  /**
+   * Recognizes each box of regions as if by SetRectangle, Recognize and
+   * GetUTF8Text, but thresholds the whole image only once and clips the
+   * binary image for each region, so many small fields of one photo can be
+   * read without thresholding the image again for every field.
+   * Boxes are in the coordinates of the image given to SetImage and are
+   * clipped to it. mode is the page segmentation mode used for every region,
+   * eg PSM_SINGLE_LINE; the previous mode is restored afterwards.
+   * Returns a newly allocated buffer, to be deleted with delete [], holding
+   * the UTF-8 text of every region in order, each terminated by a '\0',
+   * or NULL on error. A region that could not be recognized has empty text.
+   * If confidences is not NULL it must have room for one entry per box; it
+   * receives the MeanTextConf of each region.
+   * As with SetRectangle, the previous recognition results are cleared, and
+   * the rectangle is reset to the one that was set before the call.
+   */
+  char* RecognizeRegions(const Boxa* regions, PageSegMode mode,
+                         ETEXT_DESC* monitor, int* confidences);
+
+  /**
+   * Recognizes the image from SetImage as the next frame of a video stream.
+   * The text lines found in the previous frame are kept: the global motion
+   * between the frames is estimated, and only the lines whose thresholded
+   * content changed by more than stream_line_change_fraction are recognized
+   * again, each as a single line. The whole frame goes through layout
+   * analysis and recognition again if there is no previous frame, the
+   * motion is larger than stream_max_motion, text has appeared outside the
+   * known lines, or more than half of the lines have changed.
+   * Read the results with GetFrameText or GetFrameLines; the other result
+   * functions do not describe the frame after a partial update.
+   * Returns the number of lines that were recognized, so 0 if all of them
+   * were reused, or -1 on error.
+   */
+  int RecognizeFrame(ETEXT_DESC* monitor);
+
+  /**
+   * Two-stage recognition for images, such as camera frames, that are mostly
+   * not text. The text lines are first found by DetectTextLines on a copy of
+   * the image reduced by reduction (rounded down to a power of 2) and
+   * thresholded at that size, and are padded and merged into regions. Only
+   * those regions are then thresholded and recognized at full resolution,
+   * each as SetRectangle, Recognize and GetUTF8Text would, in the given page
+   * segmentation mode, eg PSM_SINGLE_BLOCK, so the time taken grows with the
+   * amount of text rather than the size of the image.
+   * Returns the UTF-8 text of the regions from top to bottom, to be deleted
+   * with delete [], or NULL on error. If regions is not NULL it is set to
+   * the boxes of the regions in image coordinates, to be destroyed with
+   * boxaDestroy, and if confidences is not NULL it is set to an array, to be
+   * deleted with delete [], of the MeanTextConf of each region.
+   * As with SetRectangle, the previous recognition results are cleared, and
+   * the rectangle is reset to the one that was set before the call.
+   */
+  char* RecognizeTextRegions(int reduction, PageSegMode mode,
+                             ETEXT_DESC* monitor, Boxa** regions,
+                             int** confidences);
+
+  /**
+   * Recognizes the current rectangle of a very large image, such as an
+   * engineering drawing, in horizontal strips of strip_height rows that
+   * overlap by overlap rows. Each strip is thresholded, segmented and
+   * recognized on its own in the current page segmentation mode, as if by
+   * SetRectangle and Recognize, so the memory used for thresholding, layout
+   * analysis and recognition depends on the size of a strip and not of the
+   * image. A text line is kept from the strip where its middle is furthest
+   * from the seams, so overlap should be more than the height of the tallest
+   * line. Blocks that cross a seam are joined to the block of the next strip
+   * that they overlap, and the text is output block by block.
+   * Returns the UTF-8 text of the lines, to be deleted with delete [], or
+   * NULL on error. If lines is not NULL it is set to the boxes of the lines,
+   * in image coordinates and in the order of the text, to be destroyed with
+   * boxaDestroy, and if confidences is not NULL it is set to an array, to be
+   * deleted with delete [], of the confidence of each line.
+   * As with SetRectangle, the previous recognition results are cleared, and
+   * the rectangle is reset to the one that was set before the call.
+   */
+  char* RecognizeStrips(int strip_height, int overlap, ETEXT_DESC* monitor,
+                        Boxa** lines, int** confidences);
+
+  /**
+   * Returns the text of the lines of the last RecognizeFrame, in reading
+   * order with a newline after each line, as UTF-8 to be deleted with the
+   * delete [] operator. Returns NULL if there is no frame.
+   */
+  char* GetFrameText();
+
+  /**
+   * Returns the boxes, in image coordinates and reading order, of the lines
+   * of the last RecognizeFrame, to be destroyed with boxaDestroy. If
+   * confidences is not NULL it is set to an array, to be deleted with
+   * delete [], of the confidence of each line. Returns NULL if there is no
+   * frame.
+   */
+  Boxa* GetFrameLines(int** confidences);
+
+  /** Forgets the previous frame, so the next RecognizeFrame starts over. */
+  void ClearFrameHistory();
+
+  /**
+   * Finds the tables of the image from SetImage by layout analysis of the
+   * whole image in the current page segmentation mode, which must find
+   * columns, eg PSM_AUTO, and then recognizes each cell of the grid that the
+   * TableRecognizer found for a table on its own in cell_mode, eg
+   * PSM_SINGLE_LINE, as RecognizeRegions does.
+   * If tessedit_parallelize is above 1, the cells are shared out between
+   * this and tessedit_parallelize - 1 workers initialized like it, which
+   * recognize them alongside each other against a snapshot of the adapted
+   * templates, without learning from them, so the text doesn't depend on
+   * which engine read a cell. monitor is only used if the cells are
+   * recognized serially.
+   * Tables are only found with textord_tabfind_find_tables and
+   * textord_tablefind_recognize_tables set, and not on pages whose text was
+   * found to be rotated.
+   * Read the results with GetTableCells and GetTableText.
+   * As with SetRectangle, the previous recognition results are cleared, and
+   * the rectangle is reset to the one that was set before the call.
+   * Returns the number of tables found, or -1 on error.
+   */
+  int RecognizeTables(PageSegMode cell_mode, ETEXT_DESC* monitor);
+
+  /**
+   * Returns the boxes, in image coordinates, of the cells of the given table
+   * of the last RecognizeTables, row by row from the top and left to right
+   * within a row, to be destroyed with boxaDestroy. rows and columns receive
+   * the size of the grid. If confidences is not NULL it is set to an array,
+   * to be deleted with delete [], of the confidence of each cell.
+   * Returns NULL if there is no such table.
+   */
+  Boxa* GetTableCells(int table, int* rows, int* columns, int** confidences);
+
+  /**
+   * Returns the UTF-8 text of the cells of the given table of the last
+   * RecognizeTables, in the order of GetTableCells, each terminated by a
+   * '\0', in a buffer to be deleted with delete [], or NULL if there is no
+   * such table.
+   */
+  char* GetTableText(int table);
+
   /**
    * Turns images into symbolic text.
    *
@@ -540,6 +878,17 @@ class TESS_API TessBaseAPI {
   bool ProcessPagesInternal(const char* filename, const char* retry_config,
                             int timeout_millisec, TessResultRenderer* renderer);
 
+  /**
+   * Like ProcessPages, but on a document held in memory: a single image,
+   * a multi-page TIFF or a plain text list of image filenames, of size
+   * bytes at data. name is only used as metadata, like the filename given
+   * to ProcessPage, and may be NULL.
+   */
+  bool ProcessPagesFromMemory(const unsigned char* data, size_t size,
+                              const char* name, const char* retry_config,
+                              int timeout_millisec,
+                              TessResultRenderer* renderer);
+
   /**
    * Turn a single image into symbolic text.
    *
@@ -602,6 +951,40 @@ class TESS_API TessBaseAPI {
    */
   char* GetTSVText(int page_number);
 
+  /**
+   * Make a JSON object of the page from the internal data structures, with
+   * its blocks, paragraphs, lines, words and symbols nested in reading
+   * order, each with its bounding box as [left, top, right, bottom] and its
+   * confidence, lines with their baselines, and words and symbols with
+   * their text. It is written straight from the result iterator, so a
+   * machine consumer need not parse hOCR to get the same information.
+   * page_number is 0-based but will appear in the output as 1-based.
+   */
+  char* GetJSONText(int page_number);
+
+  /**
+   * Serializes the results at the given level into one flat buffer, so that
+   * a caller on the other side of a language boundary, such as JNI, can read
+   * all of them at once instead of making several iterator calls per element.
+   * Returns a buffer to be freed with the delete [] operator and sets *size
+   * to its length in bytes, or returns NULL on error.
+   * Every value is 32 bits wide and in native byte order. The buffer holds a
+   * header of kPackedResultsHeaderSize values:
+   *   kPackedResultsVersion, level, number of records, size of a record in
+   *   bytes, size of the string pool in bytes,
+   * then the records, in reading order, then the string pool. Each record is:
+   *   left, top, right, bottom: the BoundingBox in image coordinates,
+   *   confidence: a float, as from Confidence(level),
+   *   text offset and text length in bytes of the UTF-8 text in the string
+   *   pool, which is also '\0' terminated there,
+   *   flags: a bit mask of PackedResultFlag,
+   *   point size and font id: as from WordFontAttributes.
+   * Font attributes, point size and font id are only filled in at RIL_WORD
+   * and RIL_SYMBOL, and dictionary/numeric flags only at RIL_WORD; otherwise
+   * the flags are clear and point size and font id are 0 and -1.
+   */
+  char* GetResultsPacked(PageIteratorLevel level, int* size);
+
   /**
    * The recognized text is returned as a char* which is coded in the same
    * format as a box file used in training. Returned string must be freed with
@@ -675,13 +1058,26 @@ class TESS_API TessBaseAPI {
 
   /**
    * Clear any library-level memory caches.
-   * There are a variety of expensive-to-load constant data structures (mostly
-   * language dictionaries) that are cached globally -- surviving the Init()
-   * and End() of individual TessBaseAPI's.  This function allows the clearing
-   * of these caches.
+   * There are a variety of expensive-to-load constant data structures
+   * (language dictionaries and classifier templates) that are cached
+   * globally -- surviving the Init() and End() of individual TessBaseAPI's.
+   * This function allows the clearing of these caches, including any
+   * dictionaries held by PreloadLanguages.
    **/
   static void ClearPersistentCache();
 
+  /**
+   * Starts loading the dictionaries of the given languages into the
+   * library-level cache on a background thread and returns at once, so that
+   * a later Init with the same datapath and languages does not have to wait
+   * for them. language is '+'-separated as for Init. An Init that starts
+   * while a dictionary is still loading waits for that load rather than
+   * repeating it. The dictionaries stay cached until ClearPersistentCache.
+   * Returns false if the thread could not be started, in which case the
+   * dictionaries have been loaded before returning.
+   */
+  static bool PreloadLanguages(const char* datapath, const char* language);
+
   /**
    * Check whether a word is valid according to Tesseract's language model
    * @return 0 if the word is invalid, non-zero if valid.
@@ -689,6 +1085,24 @@ class TESS_API TessBaseAPI {
    * in a separate API at some future time.
    */
   int IsValidWord(const char *word);
+  /**
+   * Adds the given UTF-8 words, terminated by a NULL pointer, to the user
+   * words of the loaded languages without reloading anything else, so that
+   * IsValidWord and recognition accept them from the next page on.
+   * Returns the number of words that could be expressed in the unicharset.
+   * Must not be called while a page is being recognized.
+   */
+  int AddUserWords(const char* const* words);
+  /**
+   * As AddUserWords for user patterns, written as in a user-patterns file.
+   * Works only if user_patterns_suffix or user_patterns_file was set at Init.
+   */
+  int AddUserPatterns(const char* const* patterns);
+  /**
+   * Removes all user words and user patterns, including those loaded at
+   * Init.
+   */
+  void ClearUserWords();
   // Returns true if utf8_character is defined in the UniCharset.
   bool IsValidCharacter(const char *utf8_character);
 
@@ -712,6 +1126,63 @@ class TESS_API TessBaseAPI {
    */
   bool DetectOS(OSResults*);
 
+  /**
+   * Returns the wall-clock time in milliseconds taken by each stage of the
+   * layout analysis of the last page, or NULL if not initialized.
+   * Setting tessedit_parallelize above 1 runs independent stages
+   * concurrently, unless tessedit_parallel_layout is false.
+   */
+  const LayoutTimings* GetLayoutTimings() const;
+
+  /**
+   * Returns the wall-clock time in milliseconds taken by each stage of the
+   * current page, from thresholding to rendering, or NULL if not
+   * initialized. The times are also available to progress callbacks
+   * through ETEXT_DESC::timings while the page is recognized.
+   */
+  const StageTimings* GetTimings() const;
+
+  /**
+   * Returns the counts of the hot-path work done to recognize the current
+   * page, such as blobs classified and chops tried, or NULL if not
+   * initialized. The counts are gathered once recognition of the page has
+   * finished.
+   */
+  const PageCounts* GetPageCounts() const;
+
+  /**
+   * Returns the totals of the page arenas used so far, including the
+   * high-water mark of the memory taken by any one page. With
+   * tessedit_page_arena set, the words of each page recognized are made in
+   * an arena that is freed at once when the results are cleared, which is
+   * when the page is counted.
+   */
+  const PageArenaStats& GetPageArenaStats() const;
+
+  /**
+   * Fills usage with the bytes of memory used by each component of the
+   * loaded languages, the images and the results of the current page, the
+   * most used by the images and results of any page so far, and the peak
+   * resident size of the process. Returns false if not initialized.
+   * The sizes are worked out by walking the data structures, which for the
+   * page results takes about as long as a pass over the words.
+   */
+  bool GetMemoryUsage(MemoryUsage* usage) const;
+
+  /**
+   * Sets the skew of the current image in degrees, with the sign convention
+   * of Leptonica's pixFindSkew, when it is already known, so layout analysis
+   * starts its tab search from it instead of estimating it again.
+   * Call after SetImage.
+   */
+  void SetPageSkew(float angle);
+  /**
+   * Returns true, with the skew in degrees in *angle, if the skew of the
+   * current image was set by SetPageSkew or found by layout analysis
+   * (with textord_estimate_page_skew).
+   */
+  bool GetPageSkew(float* angle) const;
+
   /** This method returns the features associated with the input image. */
   void GetFeaturesForBlob(TBLOB* blob, INT_FEATURE_STRUCT* int_features,
                           int* num_features, int* feature_outline_index);
@@ -798,6 +1269,33 @@ class TESS_API TessBaseAPI {
    */
   TESS_LOCAL virtual void Threshold(Pix** pix);
 
+  /**
+   * Thresholds the whole image, resetting the rectangle to all of it, and
+   * returns clones of the binary image and, unless the source is binary, of
+   * the grey and threshold images, for use with RecognizeClippedRegion.
+   */
+  TESS_LOCAL void ThresholdPage(Pix** binary, Pix** grey, Pix** thresholds);
+
+  /**
+   * Returns the boxes, in image coordinates and sorted from top to bottom,
+   * of the text regions that RecognizeTextRegions recognizes, found in the
+   * current rectangle reduced by reduction. Returns NULL on error.
+   */
+  TESS_LOCAL Boxa* FindTextRegions(int reduction);
+
+  /**
+   * Recognizes the given rectangle, which must lie inside the image, of a
+   * page thresholded by ThresholdPage without thresholding it again.
+   * Returns the UTF-8 text, to be deleted with delete [], or NULL on error,
+   * and sets *confidence to the mean confidence of the text.
+   */
+  TESS_LOCAL char* RecognizeClippedRegion(Pix* binary, Pix* grey,
+                                          Pix* thresholds,
+                                          int left, int top,
+                                          int width, int height,
+                                          ETEXT_DESC* monitor,
+                                          int* confidence);
+
   /**
    * Find lines from the image making the BLOCK_LIST.
    * @return 0 on success.
@@ -807,6 +1305,19 @@ class TESS_API TessBaseAPI {
   /** Delete the pageres and block list ready for a new page. */
   void ClearResults();
 
+  /**
+   * Moves the results of the current page to the result cache, if
+   * tessedit_result_cache is set and the page was recognized, and returns
+   * true if it did.
+   */
+  TESS_LOCAL bool CachePageResults();
+  /**
+   * Sets the key of the thresholded current page, and if it matches the
+   * page in the result cache, takes back the results of that page and
+   * returns true.
+   */
+  TESS_LOCAL bool RestoreCachedResults();
+
   /**
    * Return an LTR Result Iterator -- used only for training, as we really want
    * to ignore all BiDi smarts at that point.
@@ -822,6 +1333,44 @@ class TESS_API TessBaseAPI {
    */
   TESS_LOCAL int TextLength(int* blob_count);
 
+  /**
+   * Returns the bytes used by the images and the results of the current
+   * page.
+   */
+  TESS_LOCAL inT64 PageMemoryUsed() const;
+
+  /**
+   * Makes sure that there are num_workers workers, initialized like this one
+   * and with its current parameters, to recognize alongside it.
+   */
+  TESS_LOCAL void PrepareWorkers(int num_workers);
+  /**
+   * Makes sure that there are tessedit_parallelize - 1 word workers if
+   * tessedit_parallel_words is set, or none if not, and hands them to
+   * tesseract_ for pass 1.
+   */
+  TESS_LOCAL void PrepareWordWorkers();
+  /** Deletes the word workers. */
+  TESS_LOCAL void ClearWordWorkers();
+
+  /**
+   * Recognizes the cells of job that are given to the engine of the given
+   * index: every job->engines.size()th cell from that index.
+   */
+  TESS_LOCAL static void RecognizeTableCells(TableCellJob* job, int engine);
+  /** Deletes the tables of the last RecognizeTables. */
+  TESS_LOCAL void ClearTables();
+  /**
+   * Runs the line callback of monitor with an iterator at the text line of
+   * the page that starts at line, as Recognize passes final lines.
+   */
+  TESS_LOCAL void ReportLine(ETEXT_DESC* monitor, const PAGE_RES_IT& line);
+  /**
+   * Sets *boxes to the priority regions in the coordinates of the page
+   * being recognized.
+   */
+  TESS_LOCAL void GetPriorityBoxes(GenericVector<TBOX>* boxes);
+
   /** @defgroup ocropusAddOns ocropus add-ons */
   /* @{ */
 
@@ -865,10 +1414,18 @@ class TESS_API TessBaseAPI {
   Tesseract*        tesseract_;       ///< The underlying data object.
   Tesseract*        osd_tesseract_;   ///< For orientation & script detection.
   EquationDetect*   equ_detect_;      ///<The equation detector.
+  FrameHistory*     frame_history_;   ///< Previous frame for RecognizeFrame.
+  ResultCache*      result_cache_;    ///< See tessedit_result_cache.
   ImageThresholder* thresholder_;     ///< Image thresholding module.
   GenericVector<ParagraphModel *>* paragraph_models_;
   BLOCK_LIST*       block_list_;      ///< The page layout.
   PAGE_RES*         page_res_;        ///< The page-level data.
+  PageArenaStats*   arena_stats_;     ///< Totals of the page arenas.
+  inT64             page_peak_bytes_; ///< See GetMemoryUsage.
+  GenericVector<char>* params_snapshot_;  ///< See SetParamsSnapshot.
+  GenericVector<TessBaseAPI*>* word_workers_;  ///< See PrepareWorkers.
+  GenericVector<RecognizedTable*>* tables_;  ///< See RecognizeTables.
+  Boxa*             priority_regions_;  ///< See SetPriorityRegions.
   STRING*           input_file_;      ///< Name used by training code.
   STRING*           output_file_;     ///< Name used by debug code.
   STRING*           datapath_;        ///< Current location of tessdata.
@@ -897,6 +1454,13 @@ class TESS_API TessBaseAPI {
                             const char* retry_config, int timeout_millisec,
                             TessResultRenderer* renderer,
                             int tessedit_page_number);
+  // Processes the document in data, or in the file filename if data is
+  // NULL, after detecting its format.
+  bool ProcessPagesData(const unsigned char *data, size_t size,
+                        const char* filename, const char* retry_config,
+                        int timeout_millisec, TessResultRenderer* renderer);
+  // Writes the output of a training mode after ProcessPages.
+  bool WriteTrainingOutput();
   // TIFF supports multipage so gets special consideration.
   bool ProcessPagesMultipageTiff(const unsigned char *data,
                                  size_t size,
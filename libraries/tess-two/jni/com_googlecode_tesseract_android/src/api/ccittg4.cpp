@@ -0,0 +1,224 @@
+///////////////////////////////////////////////////////////////////////
+// File:        ccittg4.cpp
+// Description: CCITT Group 4 encoding of binary page images for PDF output.
+//
+// (C) Copyright 2016, Google Inc.
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////
+
+#include "ccittg4.h"
+
+#include "allheaders.h"
+#include "host.h"
+
+namespace tesseract {
+
+// A code word of ITU-T T.4, right-aligned in code.
+struct FaxCode {
+  uinT16 code;
+  uinT8 length;
+};
+
+// Terminating codes for runs of 0 to 63 white pixels.
+static const FaxCode kWhiteTerminating[64] = {
+  {0x35, 8}, {0x07, 6}, {0x07, 4}, {0x08, 4}, {0x0b, 4}, {0x0c, 4},
+  {0x0e, 4}, {0x0f, 4}, {0x13, 5}, {0x14, 5}, {0x07, 5}, {0x08, 5},
+  {0x08, 6}, {0x03, 6}, {0x34, 6}, {0x35, 6}, {0x2a, 6}, {0x2b, 6},
+  {0x27, 7}, {0x0c, 7}, {0x08, 7}, {0x17, 7}, {0x03, 7}, {0x04, 7},
+  {0x28, 7}, {0x2b, 7}, {0x13, 7}, {0x24, 7}, {0x18, 7}, {0x02, 8},
+  {0x03, 8}, {0x1a, 8}, {0x1b, 8}, {0x12, 8}, {0x13, 8}, {0x14, 8},
+  {0x15, 8}, {0x16, 8}, {0x17, 8}, {0x28, 8}, {0x29, 8}, {0x2a, 8},
+  {0x2b, 8}, {0x2c, 8}, {0x2d, 8}, {0x04, 8}, {0x05, 8}, {0x0a, 8},
+  {0x0b, 8}, {0x52, 8}, {0x53, 8}, {0x54, 8}, {0x55, 8}, {0x24, 8},
+  {0x25, 8}, {0x58, 8}, {0x59, 8}, {0x5a, 8}, {0x5b, 8}, {0x4a, 8},
+  {0x4b, 8}, {0x32, 8}, {0x33, 8}, {0x34, 8},
+};
+
+// Make-up codes for runs of 64 to 1728 white pixels, in steps of 64.
+static const FaxCode kWhiteMakeup[27] = {
+  {0x1b, 5}, {0x12, 5}, {0x17, 6}, {0x37, 7}, {0x36, 8}, {0x37, 8},
+  {0x64, 8}, {0x65, 8}, {0x68, 8}, {0x67, 8}, {0xcc, 9}, {0xcd, 9},
+  {0xd2, 9}, {0xd3, 9}, {0xd4, 9}, {0xd5, 9}, {0xd6, 9}, {0xd7, 9},
+  {0xd8, 9}, {0xd9, 9}, {0xda, 9}, {0xdb, 9}, {0x98, 9}, {0x99, 9},
+  {0x9a, 9}, {0x18, 6}, {0x9b, 9},
+};
+
+// Terminating codes for runs of 0 to 63 black pixels.
+static const FaxCode kBlackTerminating[64] = {
+  {0x37, 10}, {0x02, 3}, {0x03, 2}, {0x02, 2}, {0x03, 3}, {0x03, 4},
+  {0x02, 4}, {0x03, 5}, {0x05, 6}, {0x04, 6}, {0x04, 7}, {0x05, 7},
+  {0x07, 7}, {0x04, 8}, {0x07, 8}, {0x18, 9}, {0x17, 10}, {0x18, 10},
+  {0x08, 10}, {0x67, 11}, {0x68, 11}, {0x6c, 11}, {0x37, 11}, {0x28, 11},
+  {0x17, 11}, {0x18, 11}, {0xca, 12}, {0xcb, 12}, {0xcc, 12}, {0xcd, 12},
+  {0x68, 12}, {0x69, 12}, {0x6a, 12}, {0x6b, 12}, {0xd2, 12}, {0xd3, 12},
+  {0xd4, 12}, {0xd5, 12}, {0xd6, 12}, {0xd7, 12}, {0x6c, 12}, {0x6d, 12},
+  {0xda, 12}, {0xdb, 12}, {0x54, 12}, {0x55, 12}, {0x56, 12}, {0x57, 12},
+  {0x64, 12}, {0x65, 12}, {0x52, 12}, {0x53, 12}, {0x24, 12}, {0x37, 12},
+  {0x38, 12}, {0x27, 12}, {0x28, 12}, {0x58, 12}, {0x59, 12}, {0x2b, 12},
+  {0x2c, 12}, {0x5a, 12}, {0x66, 12}, {0x67, 12},
+};
+
+// Make-up codes for runs of 64 to 1728 black pixels, in steps of 64.
+static const FaxCode kBlackMakeup[27] = {
+  {0x0f, 10}, {0xc8, 12}, {0xc9, 12}, {0x5b, 12}, {0x33, 12}, {0x34, 12},
+  {0x35, 12}, {0x6c, 13}, {0x6d, 13}, {0x4a, 13}, {0x4b, 13}, {0x4c, 13},
+  {0x4d, 13}, {0x72, 13}, {0x73, 13}, {0x74, 13}, {0x75, 13}, {0x76, 13},
+  {0x77, 13}, {0x52, 13}, {0x53, 13}, {0x54, 13}, {0x55, 13}, {0x5a, 13},
+  {0x5b, 13}, {0x64, 13}, {0x65, 13},
+};
+
+// Make-up codes for runs of 1792 to 2560 pixels of either colour.
+static const FaxCode kExtendedMakeup[13] = {
+  {0x08, 11}, {0x0c, 11}, {0x0d, 11}, {0x12, 12}, {0x13, 12}, {0x14, 12},
+  {0x15, 12}, {0x16, 12}, {0x17, 12}, {0x1c, 12}, {0x1d, 12}, {0x1e, 12},
+  {0x1f, 12},
+};
+
+static const FaxCode kPassCode = {0x1, 4};
+static const FaxCode kHorizontalCode = {0x1, 3};
+// Vertical mode codes, indexed by b1 - a1 + 3: VR3 to VR1, V0, VL1 to VL3.
+static const FaxCode kVerticalCodes[7] = {
+  {0x03, 7}, {0x03, 6}, {0x3, 3}, {0x1, 1}, {0x2, 3}, {0x02, 6}, {0x02, 7},
+};
+static const FaxCode kEndOfLine = {0x001, 12};
+
+// Packs code words into bytes, most significant bit first.
+class FaxBitWriter {
+ public:
+  explicit FaxBitWriter(GenericVector<unsigned char>* data)
+    : data_(data), bits_(0), count_(0) {}
+
+  void Put(const FaxCode& code) {
+    bits_ = (bits_ << code.length) | code.code;
+    count_ += code.length;
+    while (count_ >= 8) {
+      count_ -= 8;
+      data_->push_back(static_cast<unsigned char>(bits_ >> count_));
+    }
+  }
+
+  // Writes a run of run pixels of the given colour as make-up codes
+  // followed by a terminating code.
+  void PutRun(int run, bool black) {
+    while (run >= 2560 + 64) {
+      Put(kExtendedMakeup[12]);
+      run -= 2560;
+    }
+    if (run >= 64) {
+      int steps = run >> 6;
+      if (steps <= 27)
+        Put(black ? kBlackMakeup[steps - 1] : kWhiteMakeup[steps - 1]);
+      else
+        Put(kExtendedMakeup[steps - 28]);
+      run -= steps << 6;
+    }
+    Put(black ? kBlackTerminating[run] : kWhiteTerminating[run]);
+  }
+
+  // Pads the last byte with zeros.
+  void Flush() {
+    if (count_ > 0)
+      data_->push_back(static_cast<unsigned char>(bits_ << (8 - count_)));
+    count_ = 0;
+  }
+
+ private:
+  GenericVector<unsigned char>* data_;
+  uinT32 bits_;
+  int count_;
+};
+
+// Returns the index of the most significant set bit of a non-zero word,
+// counting from the top, which is the leftmost pixel in Leptonica order.
+static inline int first_set_bit(uinT32 word) {
+#ifdef __GNUC__
+  return __builtin_clz(word);
+#else
+  int bit = 0;
+  for (; (word & 0x80000000u) == 0; word <<= 1)
+    ++bit;
+  return bit;
+#endif
+}
+
+static inline int pixel(const uinT32* line, int x) {
+  return (line[x >> 5] >> (31 - (x & 31))) & 1;
+}
+
+// Returns the first x' >= x whose pixel is not color, or width if there is
+// none, a word at a time.
+static int next_change(const uinT32* line, int x, int width, int color) {
+  if (x >= width) return width;
+  uinT32 flip = color ? 0xffffffffu : 0;
+  int w = x >> 5;
+  uinT32 word = (line[w] ^ flip) & (0xffffffffu >> (x & 31));
+  while (word == 0) {
+    if ((++w << 5) >= width) return width;
+    word = line[w] ^ flip;
+  }
+  x = (w << 5) + first_set_bit(word);
+  return x < width ? x : width;
+}
+
+bool EncodeCCITTG4(Pix* pix, GenericVector<unsigned char>* data) {
+  if (pix == NULL || pixGetDepth(pix) != 1) return false;
+  int width = pixGetWidth(pix);
+  int height = pixGetHeight(pix);
+  int wpl = pixGetWpl(pix);
+  // The line above the first one is white.
+  GenericVector<uinT32> white;
+  white.init_to_size(wpl, 0);
+
+  data->truncate(0);
+  data->reserve(wpl * height / 8 + 16);
+  FaxBitWriter writer(data);
+  const uinT32* ref = &white[0];
+  const uinT32* line = pixGetData(pix);
+  for (int y = 0; y < height; ++y, ref = line, line += wpl) {
+    // a0 starts on an imaginary white pixel before the line, and the
+    // changing elements a1, b1 and b2 are as defined in T.4 4.2.1.3.
+    int a0 = 0;
+    int a1 = pixel(line, 0) ? 0 : next_change(line, 0, width, 0);
+    int b1 = pixel(ref, 0) ? 0 : next_change(ref, 0, width, 0);
+    for (;;) {
+      int b2 = b1 < width ? next_change(ref, b1, width, pixel(ref, b1))
+                          : width;
+      if (b2 < a1) {
+        writer.Put(kPassCode);
+        a0 = b2;
+      } else if (b1 - a1 >= -3 && b1 - a1 <= 3) {
+        writer.Put(kVerticalCodes[b1 - a1 + 3]);
+        a0 = a1;
+      } else {
+        int a2 = a1 < width ? next_change(line, a1, width, pixel(line, a1))
+                            : width;
+        bool black = a0 + a1 != 0 && pixel(line, a0);
+        writer.Put(kHorizontalCode);
+        writer.PutRun(a1 - a0, black);
+        writer.PutRun(a2 - a1, !black);
+        a0 = a2;
+      }
+      if (a0 >= width) break;
+      int color = pixel(line, a0);
+      a1 = next_change(line, a0, width, color);
+      b1 = next_change(ref, a0, width, !color);
+      b1 = next_change(ref, b1, width, color);
+    }
+  }
+  // EOFB
+  writer.Put(kEndOfLine);
+  writer.Put(kEndOfLine);
+  writer.Flush();
+  return true;
+}
+
+}  // namespace tesseract
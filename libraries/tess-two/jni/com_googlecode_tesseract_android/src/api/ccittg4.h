@@ -0,0 +1,37 @@
+///////////////////////////////////////////////////////////////////////
+// File:        ccittg4.h
+// Description: CCITT Group 4 encoding of binary page images for PDF output.
+//
+// (C) Copyright 2016, Google Inc.
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////
+
+#ifndef TESSERACT_API_CCITTG4_H_
+#define TESSERACT_API_CCITTG4_H_
+
+#include "genericvector.h"
+
+struct Pix;
+
+namespace tesseract {
+
+// Encodes a 1 bpp image with CCITT T.6 (Group 4) two-dimensional coding,
+// with set pixels as black, into *data, ending with an EOFB. This is the
+// stream that /CCITTFaxDecode with /K -1 expects, and the strip data of a
+// G4 TIFF with min-is-white photometry. Unlike Leptonica's G4 output it
+// needs neither libtiff nor a temporary file. Returns false if pix is not
+// 1 bpp.
+bool EncodeCCITTG4(Pix* pix, GenericVector<unsigned char>* data);
+
+}  // namespace tesseract
+
+#endif  // TESSERACT_API_CCITTG4_H_
@@ -0,0 +1,424 @@
+///////////////////////////////////////////////////////////////////////
+// File:        docpipeline.cpp
+// Description: Multi-page document processing with decoding, recognition
+//              and rendering of different pages overlapped.
+//
+// (C) Copyright 2016, Google Inc.
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////
+
+#include "docpipeline.h"
+
+#ifndef _WIN32
+#include <pthread.h>
+#endif
+
+#include "allheaders.h"
+#include "baseapi.h"
+#include "renderer.h"
+#include "tiffindex.h"
+#include "tprintf.h"
+
+namespace tesseract {
+
+// Yields the pages of a document in order, from a list of image files or
+// from a single image or multipage TIFF file.
+class PageSource {
+ public:
+  // Each named image is one page.
+  explicit PageSource(const GenericVector<STRING>* filenames)
+    : filenames_(filenames), tiff_(false), offset_(0), page_(0),
+      selected_page_(-1), done_(false), failed_(false) {}
+  // A single image, or all the images of a TIFF if tiff is true.
+  PageSource(const char* filename, bool tiff)
+    : filenames_(NULL), filename_(filename), tiff_(tiff), offset_(0),
+      page_(0), selected_page_(-1), done_(false), failed_(false) {}
+
+  // Restricts a file list or TIFF to the given page, if it is not negative.
+  void SelectPage(int page) { selected_page_ = page; }
+
+  // Decodes the next page and sets *index to its page number and *name to
+  // the file it came from. Returns NULL when there are no more pages, or if
+  // a page could not be read, in which case failed() is true.
+  Pix* Next(int* index, STRING* name);
+
+  bool failed() const { return failed_; }
+
+ private:
+  const GenericVector<STRING>* filenames_;
+  STRING filename_;
+  bool tiff_;
+  // Position of the next page in a TIFF.
+  size_t offset_;
+  // Page number of the next page.
+  int page_;
+  int selected_page_;
+  bool done_;
+  bool failed_;
+};
+
+Pix* PageSource::Next(int* index, STRING* name) {
+  // Pages of a file list are skipped without reading them.
+  if (filenames_ != NULL && page_ < selected_page_)
+    page_ = selected_page_;
+  while (!done_) {
+    Pix* pix = NULL;
+    if (filenames_ != NULL) {
+      if (page_ >= filenames_->size()) {
+        done_ = true;
+        break;
+      }
+      *name = (*filenames_)[page_];
+      pix = pixRead(name->string());
+      if (pix == NULL) {
+        tprintf("Image file %s cannot be read!\n", name->string());
+        failed_ = done_ = true;
+        break;
+      }
+    } else if (tiff_) {
+      *name = filename_;
+      if (page_ < selected_page_) {
+        // Go straight to the selected page instead of decoding the ones
+        // before it.
+        TiffPageIndex index;
+        if (!index.Open(filename_.string()) ||
+            selected_page_ >= index.NumPages()) {
+          done_ = true;
+          break;
+        }
+        offset_ = index.Offset(selected_page_);
+        page_ = selected_page_;
+      }
+      pix = pixReadFromMultipageTiff(filename_.string(), &offset_);
+      if (pix == NULL || offset_ == 0) done_ = true;
+      if (pix == NULL) break;
+    } else {
+      *name = filename_;
+      pix = pixRead(filename_.string());
+      done_ = true;
+      if (pix == NULL) {
+        failed_ = true;
+        break;
+      }
+    }
+    *index = page_++;
+    if (*index < selected_page_) {
+      pixDestroy(&pix);
+      continue;
+    }
+    if (selected_page_ >= 0) done_ = true;
+    return pix;
+  }
+  return NULL;
+}
+
+#ifndef _WIN32
+// A decoded page, from decoding until it has been rendered.
+struct PipelinePage {
+  PipelinePage() : pix(NULL), index(-1) {}
+
+  Pix* pix;
+  int index;
+  STRING name;
+};
+
+// The state shared by the stages while a document is processed. All of it
+// is guarded by mutex, and cond is broadcast whenever any of it changes.
+struct PipelineRun {
+  PageSource* source;
+  GenericVector<TessBaseAPI*>* recognizers;
+  int timeout_millisec;
+  pthread_mutex_t mutex;
+  pthread_cond_t cond;
+  // Decoded pages waiting for a recognizer, as a ring of queue.size()
+  // entries starting at queue_start.
+  GenericVector<PipelinePage> queue;
+  int queue_start;
+  int queue_count;
+  bool decoding_done;
+  // The page each recognizer has recognized and is holding for the
+  // renderer. Its pix is NULL while there is none.
+  GenericVector<PipelinePage> recognized;
+  int running_recognizers;
+  // Page number of the next page to render.
+  int next_page;
+  bool failed;
+};
+
+// Argument of a recognizer thread.
+struct RecognizerArg {
+  PipelineRun* run;
+  int recognizer;
+};
+#endif  // _WIN32
+
+DocumentPipeline::DocumentPipeline(TessBaseAPI* api, int num_recognizers,
+                                   int queue_depth)
+  : queue_depth_(queue_depth > 0 ? queue_depth : 1) {
+  recognizers_.push_back(api);
+#ifndef _WIN32
+  for (int r = 1; r < num_recognizers; ++r) {
+    TessBaseAPI* recognizer = new TessBaseAPI;
+    if (recognizer->InitLike(*api) != 0) {
+      tprintf("Warning: could only initialize %d of %d recognizers\n", r,
+              num_recognizers);
+      delete recognizer;
+      break;
+    }
+    recognizers_.push_back(recognizer);
+  }
+#endif
+}
+
+DocumentPipeline::~DocumentPipeline() {
+  for (int r = 1; r < recognizers_.size(); ++r)
+    delete recognizers_[r];
+}
+
+bool DocumentPipeline::ProcessPages(const char* filename,
+                                    int timeout_millisec,
+                                    TessResultRenderer* renderer) {
+  int page_number = -1;
+  recognizers_[0]->GetIntVariable("tessedit_page_number", &page_number);
+
+  int format;
+  int r = findFileFormat(filename, &format);
+  if (r != 0 || format == IFF_UNKNOWN) {
+    // Maybe we have a filelist.
+    GenericVector<char> data;
+    if (!LoadDataFromFile(filename, &data) || data.empty()) return false;
+    STRING text(&data[0], data.size());
+    GenericVector<STRING> lines;
+    text.split('\n', &lines);
+    for (int i = 0; i < lines.size(); ++i) {
+      int length = lines[i].length();
+      while (length > 0 && lines[i][length - 1] == '\r')
+        lines[i].truncate_at(--length);
+    }
+    if (lines.empty()) return false;
+    PageSource source(&lines);
+    source.SelectPage(page_number);
+    return ProcessDocument(&source, "", timeout_millisec, renderer);
+  }
+
+  bool tiff = (format == IFF_TIFF || format == IFF_TIFF_PACKBITS ||
+               format == IFF_TIFF_RLE || format == IFF_TIFF_G3 ||
+               format == IFF_TIFF_G4 || format == IFF_TIFF_LZW ||
+               format == IFF_TIFF_ZIP);
+  PageSource source(filename, tiff);
+  if (tiff) source.SelectPage(page_number);
+  return ProcessDocument(&source, "", timeout_millisec, renderer);
+}
+
+bool DocumentPipeline::ProcessFiles(const GenericVector<STRING>& filenames,
+                                    const char* title, int timeout_millisec,
+                                    TessResultRenderer* renderer) {
+  PageSource source(&filenames);
+  return ProcessDocument(&source, title, timeout_millisec, renderer);
+}
+
+bool DocumentPipeline::ProcessDocument(PageSource* source, const char* title,
+                                       int timeout_millisec,
+                                       TessResultRenderer* renderer) {
+  if (renderer && !renderer->BeginDocument(title)) return false;
+  bool started = false;
+  bool result = ProcessInParallel(source, timeout_millisec, renderer,
+                                  &started);
+  if (!started)
+    result = ProcessSerially(source, timeout_millisec, renderer);
+  if (!result || (renderer && !renderer->EndDocument())) return false;
+  return true;
+}
+
+bool DocumentPipeline::ProcessSerially(PageSource* source,
+                                       int timeout_millisec,
+                                       TessResultRenderer* renderer) {
+  int index;
+  STRING name;
+  Pix* pix;
+  while ((pix = source->Next(&index, &name)) != NULL) {
+    bool r = recognizers_[0]->ProcessPage(pix, index, name.string(), NULL,
+                                          timeout_millisec, renderer);
+    pixDestroy(&pix);
+    if (!r) return false;
+  }
+  return !source->failed();
+}
+
+#ifndef _WIN32
+bool DocumentPipeline::ProcessInParallel(PageSource* source,
+                                         int timeout_millisec,
+                                         TessResultRenderer* renderer,
+                                         bool* started) {
+  *started = false;
+  PipelineRun run;
+  run.source = source;
+  run.recognizers = &recognizers_;
+  run.timeout_millisec = timeout_millisec;
+  pthread_mutex_init(&run.mutex, NULL);
+  pthread_cond_init(&run.cond, NULL);
+  run.queue.init_to_size(queue_depth_, PipelinePage());
+  run.queue_start = 0;
+  run.queue_count = 0;
+  run.decoding_done = false;
+  run.recognized.init_to_size(recognizers_.size(), PipelinePage());
+  run.running_recognizers = 0;
+  run.next_page = -1;
+  run.failed = false;
+
+  GenericVector<RecognizerArg> args;
+  args.init_to_size(recognizers_.size(), RecognizerArg());
+  GenericVector<pthread_t> threads;
+  for (int r = 0; r < recognizers_.size(); ++r) {
+    args[r].run = &run;
+    args[r].recognizer = r;
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, &DocumentPipeline::RecognizerEntry,
+                       &args[r]) != 0) {
+      tprintf("Warning: could only start %d of %d recognizers\n", r,
+              recognizers_.size());
+      break;
+    }
+    threads.push_back(thread);
+  }
+  pthread_mutex_lock(&run.mutex);
+  run.running_recognizers = threads.size();
+  pthread_mutex_unlock(&run.mutex);
+
+  pthread_t decoder;
+  if (!threads.empty() &&
+      pthread_create(&decoder, NULL, &DocumentPipeline::DecoderEntry,
+                     &run) == 0) {
+    *started = true;
+    RenderPages(&run, renderer);
+    pthread_join(decoder, NULL);
+  } else {
+    // Nothing has been decoded yet, so the caller can start over serially.
+    pthread_mutex_lock(&run.mutex);
+    run.failed = true;
+    pthread_cond_broadcast(&run.cond);
+    pthread_mutex_unlock(&run.mutex);
+  }
+  for (int t = 0; t < threads.size(); ++t)
+    pthread_join(threads[t], NULL);
+
+  // Free the pages left behind by a failure.
+  for (int i = 0; i < run.queue.size(); ++i)
+    pixDestroy(&run.queue[i].pix);
+  for (int r = 0; r < run.recognized.size(); ++r)
+    pixDestroy(&run.recognized[r].pix);
+  pthread_cond_destroy(&run.cond);
+  pthread_mutex_destroy(&run.mutex);
+  return !run.failed;
+}
+
+void DocumentPipeline::RenderPages(PipelineRun* run,
+                                   TessResultRenderer* renderer) {
+  pthread_mutex_lock(&run->mutex);
+  while (!run->failed) {
+    int r = 0;
+    while (r < run->recognized.size() &&
+           (run->recognized[r].pix == NULL ||
+            run->recognized[r].index != run->next_page)) {
+      ++r;
+    }
+    if (r < run->recognized.size()) {
+      // The recognizer waits for its page to be rendered, so its results
+      // can be read without the lock.
+      pthread_mutex_unlock(&run->mutex);
+      bool ok = renderer == NULL || renderer->AddImage((*run->recognizers)[r]);
+      pthread_mutex_lock(&run->mutex);
+      pixDestroy(&run->recognized[r].pix);
+      ++run->next_page;
+      if (!ok) run->failed = true;
+      pthread_cond_broadcast(&run->cond);
+    } else if (run->decoding_done && run->queue_count == 0 &&
+               run->running_recognizers == 0) {
+      break;
+    } else {
+      pthread_cond_wait(&run->cond, &run->mutex);
+    }
+  }
+  pthread_mutex_unlock(&run->mutex);
+}
+
+void* DocumentPipeline::DecoderEntry(void* arg) {
+  PipelineRun* run = static_cast<PipelineRun*>(arg);
+  int capacity = run->queue.size();
+  pthread_mutex_lock(&run->mutex);
+  while (!run->failed) {
+    while (run->queue_count == capacity && !run->failed)
+      pthread_cond_wait(&run->cond, &run->mutex);
+    if (run->failed) break;
+    // Decode without the lock, so the other stages carry on meanwhile.
+    pthread_mutex_unlock(&run->mutex);
+    PipelinePage page;
+    page.pix = run->source->Next(&page.index, &page.name);
+    pthread_mutex_lock(&run->mutex);
+    if (page.pix == NULL) break;
+    if (run->next_page < 0) run->next_page = page.index;
+    int tail = (run->queue_start + run->queue_count) % capacity;
+    run->queue[tail] = page;
+    ++run->queue_count;
+    pthread_cond_broadcast(&run->cond);
+  }
+  run->decoding_done = true;
+  if (run->source->failed()) run->failed = true;
+  pthread_cond_broadcast(&run->cond);
+  pthread_mutex_unlock(&run->mutex);
+  return NULL;
+}
+
+void* DocumentPipeline::RecognizerEntry(void* arg) {
+  PipelineRun* run = static_cast<RecognizerArg*>(arg)->run;
+  int r = static_cast<RecognizerArg*>(arg)->recognizer;
+  TessBaseAPI* api = (*run->recognizers)[r];
+  pthread_mutex_lock(&run->mutex);
+  while (!run->failed) {
+    while (run->queue_count == 0 && !run->decoding_done && !run->failed)
+      pthread_cond_wait(&run->cond, &run->mutex);
+    if (run->failed || run->queue_count == 0) break;
+    PipelinePage page = run->queue[run->queue_start];
+    run->queue[run->queue_start].pix = NULL;
+    run->queue_start = (run->queue_start + 1) % run->queue.size();
+    --run->queue_count;
+    pthread_cond_broadcast(&run->cond);
+    pthread_mutex_unlock(&run->mutex);
+
+    tprintf("Page %d : %s\n", page.index, page.name.string());
+    bool ok = api->ProcessPage(page.pix, page.index, page.name.string(), NULL,
+                               run->timeout_millisec, NULL);
+
+    pthread_mutex_lock(&run->mutex);
+    run->recognized[r] = page;
+    if (!ok) run->failed = true;
+    pthread_cond_broadcast(&run->cond);
+    // Hold on to the results until the renderer has read them.
+    while (run->recognized[r].pix != NULL && !run->failed)
+      pthread_cond_wait(&run->cond, &run->mutex);
+  }
+  --run->running_recognizers;
+  pthread_cond_broadcast(&run->cond);
+  pthread_mutex_unlock(&run->mutex);
+  return NULL;
+}
+#else
+bool DocumentPipeline::ProcessInParallel(PageSource* source,
+                                         int timeout_millisec,
+                                         TessResultRenderer* renderer,
+                                         bool* started) {
+  *started = false;
+  return false;
+}
+#endif  // _WIN32
+
+}  // namespace tesseract
@@ -0,0 +1,95 @@
+///////////////////////////////////////////////////////////////////////
+// File:        docpipeline.h
+// Description: Multi-page document processing with decoding, recognition
+//              and rendering of different pages overlapped.
+//
+// (C) Copyright 2016, Google Inc.
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////
+
+#ifndef TESSERACT_API_DOCPIPELINE_H_
+#define TESSERACT_API_DOCPIPELINE_H_
+
+#include "genericvector.h"
+#include "platform.h"
+#include "strngs.h"
+
+namespace tesseract {
+
+class PageSource;
+class TessBaseAPI;
+class TessResultRenderer;
+struct PipelineRun;
+
+// Processes the pages of a document as TessBaseAPI::ProcessPages does, but
+// in three stages that work on different pages at once: one thread decodes
+// the pages in order, several recognizers each recognize a page, and the
+// calling thread hands the results to the renderer in page order. At most
+// queue_depth decoded pages wait for a recognizer, and each recognizer
+// keeps its page until it has been rendered, so memory stays bounded
+// however long the document is. A document then takes about as long as its
+// slowest stage rather than the sum of all of them.
+//
+// The output is the same as that of TessBaseAPI::ProcessPages, except that
+// retry configs are not supported, since switching configs goes through a
+// file shared by all instances. On platforms without pthreads, or if the
+// threads cannot be started, the pages are processed one at a time.
+class TESS_API DocumentPipeline {
+ public:
+  // api must have been initialized, and must not be used elsewhere while
+  // the pipeline processes a document. It is the first recognizer, and
+  // num_recognizers - 1 more are initialized like it with
+  // TessBaseAPI::InitLike, sharing its classifier and dictionaries.
+  DocumentPipeline(TessBaseAPI* api, int num_recognizers, int queue_depth);
+  ~DocumentPipeline();
+
+  // Number of recognizers that could be initialized, including api.
+  int num_recognizers() const { return recognizers_.size(); }
+
+  // Processes a single image, a multipage TIFF, or a text file naming one
+  // image per line, as TessBaseAPI::ProcessPages. tessedit_page_number of
+  // api selects a single page if it is not negative.
+  bool ProcessPages(const char* filename, int timeout_millisec,
+                    TessResultRenderer* renderer);
+
+  // Processes the named images, each of which is one page, into a document
+  // with the given title.
+  bool ProcessFiles(const GenericVector<STRING>& filenames, const char* title,
+                    int timeout_millisec, TessResultRenderer* renderer);
+
+ private:
+  // Runs the document of source between BeginDocument and EndDocument.
+  bool ProcessDocument(PageSource* source, const char* title,
+                       int timeout_millisec, TessResultRenderer* renderer);
+  // Processes the pages one at a time with the first recognizer.
+  bool ProcessSerially(PageSource* source, int timeout_millisec,
+                       TessResultRenderer* renderer);
+  // Processes the pages with the decoder and recognizer threads. Returns
+  // false in *started if no thread could be started, in which case no page
+  // has been read.
+  bool ProcessInParallel(PageSource* source, int timeout_millisec,
+                         TessResultRenderer* renderer, bool* started);
+  // Renders the recognized pages in order as they become available, on
+  // the calling thread, until the document is done or has failed.
+  void RenderPages(PipelineRun* run, TessResultRenderer* renderer);
+
+  static void* DecoderEntry(void* arg);
+  static void* RecognizerEntry(void* arg);
+
+  // recognizers_[0] is the api passed in. The others are owned.
+  GenericVector<TessBaseAPI*> recognizers_;
+  int queue_depth_;
+};
+
+}  // namespace tesseract
+
+#endif  // TESSERACT_API_DOCPIPELINE_H_
@@ -22,15 +22,21 @@
 
 #include "allheaders.h"
 #include "baseapi.h"
+#include "ccittg4.h"
 #include "math.h"
 #include "renderer.h"
 #include "strngs.h"
+#include "textbuffer.h"
 #include "tprintf.h"
 
 #ifdef _MSC_VER
 #include "mathfix.h"
 #endif
 
+#ifndef _WIN32
+#include <pthread.h>
+#endif
+
 /*
 
 Design notes from Ken Sharp, with light editing.
@@ -174,6 +180,15 @@ const int kBasicBufSize = 2048;
 // If the font is 10 pts, nominal character width is 5 pts
 const int kCharWidth = 2;
 
+// End of an image object, after its stream data.
+const char kImageObjectEnd[] =
+    "endstream\n"
+    "endobj\n";
+
+// Initial size of the content stream buffer of a page, enough for the
+// text of a dense page, so that it seldom has to grow.
+const int kPageTextSize = 1 << 16;
+
 /**********************************************************************
  * PDF Renderer interface implementation
  **********************************************************************/
@@ -182,9 +197,33 @@ TessPDFRenderer::TessPDFRenderer(const char* outputbase, const char *datadir)
     : TessResultRenderer(outputbase, "pdf") {
   obj_  = 0;
   datadir_ = datadir;
+  page_jpeg_ = NULL;
+  page_jpeg_size_ = 0;
+  grey_image_reduction_ = 0;
+  pending_page_ = NULL;
   offsets_.push_back(0);
 }
 
+TessPDFRenderer::TessPDFRenderer(int fd, const char *datadir)
+    : TessResultRenderer(fd, "pdf") {
+  obj_  = 0;
+  datadir_ = datadir;
+  page_jpeg_ = NULL;
+  page_jpeg_size_ = 0;
+  grey_image_reduction_ = 0;
+  pending_page_ = NULL;
+  offsets_.push_back(0);
+}
+
+void TessPDFRenderer::SetPageJpeg(const char *data, int size) {
+  page_jpeg_ = data;
+  page_jpeg_size_ = data != NULL ? size : 0;
+}
+
+void TessPDFRenderer::SetGreyImageReduction(int reduction) {
+  grey_image_reduction_ = MAX(reduction, 0);
+}
+
 void TessPDFRenderer::AppendPDFObjectDIY(size_t objectsize) {
   offsets_.push_back(objectsize + offsets_.back());
   obj_++;
@@ -304,7 +343,7 @@ void ClipBaseline(int ppi, int x1, int y1, int x2, int y2,
 
 char* TessPDFRenderer::GetPDFTextObjects(TessBaseAPI* api,
                                          double width, double height) {
-  STRING pdf_str("");
+  TextBuffer pdf_str(kPageTextSize);
   double ppi = api->GetSourceYResolution();
 
   // These initial conditions are all arbitrary and will be overwritten
@@ -322,21 +361,23 @@ char* TessPDFRenderer::GetPDFTextObjects(TessBaseAPI* api,
   // TODO(jbreiden) This marries the text and image together.
   // Slightly cleaner from an abstraction standpoint if this were to
   // live inside a separate text object.
-  pdf_str += "q ";
-  pdf_str.add_str_double("", prec(width));
-  pdf_str += " 0 0 ";
-  pdf_str.add_str_double("", prec(height));
-  pdf_str += " 0 0 cm /Im1 Do Q\n";
+  pdf_str.Append("q ");
+  pdf_str.AppendDouble("", prec(width));
+  pdf_str.Append(" 0 0 ");
+  pdf_str.AppendDouble("", prec(height));
+  pdf_str.Append(" 0 0 cm /Im1 Do Q\n");
 
   int line_x1 = 0;
   int line_y1 = 0;
   int line_x2 = 0;
   int line_y2 = 0;
 
+  // Reused for the text of every word.
+  TextBuffer pdf_word(kBasicBufSize);
   ResultIterator *res_it = api->GetIterator();
   while (!res_it->Empty(RIL_BLOCK)) {
     if (res_it->IsAtBeginningOf(RIL_BLOCK)) {
-      pdf_str += "BT\n3 Tr";     // Begin text object, use invisible ink
+      pdf_str.Append("BT\n3 Tr");     // Begin text object, use invisible ink
       old_fontsize = 0;          // Every block will declare its fontsize
       new_block = true;          // Every block will declare its affine matrix
     }
@@ -388,20 +429,20 @@ char* TessPDFRenderer::GetPDFTextObjects(TessBaseAPI* api,
     if (writing_direction != old_writing_direction || new_block) {
       AffineMatrix(writing_direction,
                    line_x1, line_y1, line_x2, line_y2, &a, &b, &c, &d);
-      pdf_str.add_str_double(" ", prec(a));  // . This affine matrix
-      pdf_str.add_str_double(" ", prec(b));  // . sets the coordinate
-      pdf_str.add_str_double(" ", prec(c));  // . system for all
-      pdf_str.add_str_double(" ", prec(d));  // . text that follows.
-      pdf_str.add_str_double(" ", prec(x));  // .
-      pdf_str.add_str_double(" ", prec(y));  // .
-      pdf_str += (" Tm ");                   // Place cursor absolutely
+      pdf_str.AppendDouble(" ", prec(a));  // . This affine matrix
+      pdf_str.AppendDouble(" ", prec(b));  // . sets the coordinate
+      pdf_str.AppendDouble(" ", prec(c));  // . system for all
+      pdf_str.AppendDouble(" ", prec(d));  // . text that follows.
+      pdf_str.AppendDouble(" ", prec(x));  // .
+      pdf_str.AppendDouble(" ", prec(y));  // .
+      pdf_str.Append(" Tm ");              // Place cursor absolutely
       new_block = false;
     } else {
       double dx = x - old_x;
       double dy = y - old_y;
-      pdf_str.add_str_double(" ", prec(dx * a + dy * b));
-      pdf_str.add_str_double(" ", prec(dx * c + dy * d));
-      pdf_str += (" Td ");                   // Relative moveto
+      pdf_str.AppendDouble(" ", prec(dx * a + dy * b));
+      pdf_str.AppendDouble(" ", prec(dx * c + dy * d));
+      pdf_str.Append(" Td ");              // Relative moveto
     }
     old_x = x;
     old_y = y;
@@ -422,21 +463,20 @@ char* TessPDFRenderer::GetPDFTextObjects(TessBaseAPI* api,
       if (fontsize != old_fontsize) {
         char textfont[20];
         snprintf(textfont, sizeof(textfont), "/f-0-0 %d Tf ", fontsize);
-        pdf_str += textfont;
+        pdf_str.Append(textfont);
         old_fontsize = fontsize;
       }
     }
 
     bool last_word_in_line = res_it->IsAtFinalElement(RIL_TEXTLINE, RIL_WORD);
     bool last_word_in_block = res_it->IsAtFinalElement(RIL_BLOCK, RIL_WORD);
-    STRING pdf_word("");
+    pdf_word.clear();
     int pdf_word_len = 0;
     do {
       const char *grapheme = res_it->GetUTF8Text(RIL_SYMBOL);
       if (grapheme && grapheme[0] != '\0') {
         GenericVector<int> unicodes;
         UNICHAR::UTF8ToUnicode(grapheme, &unicodes);
-        char utf16[20];
         for (int i = 0; i < unicodes.length(); i++) {
           int code = unicodes[i];
           // Convert to UTF-16BE https://en.wikipedia.org/wiki/UTF-16
@@ -444,16 +484,17 @@ char* TessPDFRenderer::GetPDFTextObjects(TessBaseAPI* api,
             tprintf("Dropping invalid codepoint %d\n", code);
             continue;
           }
+          pdf_word.Append('<');
           if (code < 0x10000) {
-            snprintf(utf16, sizeof(utf16), "<%04X>", code);
+            pdf_word.AppendHex4(code);
           } else {
             int a = code - 0x010000;
             int high_surrogate = (0x03FF & (a >> 10)) + 0xD800;
             int low_surrogate = (0x03FF & a) + 0xDC00;
-            snprintf(utf16, sizeof(utf16), "<%04X%04X>",
-                     high_surrogate, low_surrogate);
+            pdf_word.AppendHex4(high_surrogate);
+            pdf_word.AppendHex4(low_surrogate);
           }
-          pdf_word += utf16;
+          pdf_word.Append('>');
           pdf_word_len++;
         }
       }
@@ -463,23 +504,21 @@ char* TessPDFRenderer::GetPDFTextObjects(TessBaseAPI* api,
     if (word_length > 0 && pdf_word_len > 0 && fontsize > 0) {
       double h_stretch =
           kCharWidth * prec(100.0 * word_length / (fontsize * pdf_word_len));
-      pdf_str.add_str_double("", h_stretch);
-      pdf_str += " Tz";          // horizontal stretch
-      pdf_str += " [ ";
-      pdf_str += pdf_word;       // UTF-16BE representation
-      pdf_str += " ] TJ";        // show the text
+      pdf_str.AppendDouble("", h_stretch);
+      pdf_str.Append(" Tz");     // horizontal stretch
+      pdf_str.Append(" [ ");
+      pdf_str.Append(pdf_word);  // UTF-16BE representation
+      pdf_str.Append(" ] TJ");   // show the text
     }
     if (last_word_in_line) {
-      pdf_str += " \n";
+      pdf_str.Append(" \n");
     }
     if (last_word_in_block) {
-      pdf_str += "ET\n";         // end the text object
+      pdf_str.Append("ET\n");   // end the text object
     }
   }
-  char *ret = new char[pdf_str.length() + 1];
-  strcpy(ret, pdf_str.string());
   delete res_it;
-  return ret;
+  return pdf_str.Release();
 }
 
 bool TessPDFRenderer::BeginDocumentHandler() {
@@ -684,38 +723,153 @@ bool TessPDFRenderer::BeginDocumentHandler() {
   return true;
 }
 
-bool TessPDFRenderer::imageToPDFObj(Pix *pix,
-                                    char *filename,
-                                    long int objnum,
-                                    char **pdf_object,
-                                    long int *pdf_object_size) {
+// Returns true if the size bytes of JPEG data can be embedded as they are
+// as the image of pix, which must have been decoded from them. They can't
+// if they don't have the size of pix, and so aren't the image that was
+// recognized, or if they are CMYK or YCCK, as there is no colorspace for
+// those below. Sets *spp to their samples per pixel.
+static bool canEmbedJpegData(Pix *pix, const char *data, int size, int *spp) {
+  l_int32 w, h, ycck, cmyk;
+  const l_uint8 *bytes = reinterpret_cast<const l_uint8 *>(data);
+  return !readHeaderMemJpeg(bytes, size, &w, &h, spp, &ycck, &cmyk) &&
+      !ycck && !cmyk && (*spp == 1 || *spp == 3) &&
+      w == pixGetWidth(pix) && h == pixGetHeight(pix);
+}
+
+// Returns true if filename is embedded as it is by l_generateCIDataForPdf,
+// without looking at the image decoded from it.
+static bool isEmbeddedAsIs(const char *filename) {
+  int format = IFF_UNKNOWN;
+  if (filename[0] != '\0')
+    findFileFormat(filename, &format);
+  return format == IFF_JFIF_JPEG || format == IFF_JP2;
+}
+
+// Wraps JPEG data held in memory for embedding as it is, or returns NULL
+// if canEmbedJpegData says it can't be.
+static L_COMP_DATA *jpegDataToCIData(Pix *pix, const char *data, int size) {
+  int spp;
+  if (!canEmbedJpegData(pix, data, size, &spp))
+    return NULL;
+  L_COMP_DATA *cid =
+      static_cast<L_COMP_DATA *>(lept_calloc(1, sizeof(L_COMP_DATA)));
+  l_uint8 *datacomp = static_cast<l_uint8 *>(lept_calloc(size, 1));
+  if (!cid || !datacomp) {
+    lept_free(cid);
+    lept_free(datacomp);
+    return NULL;
+  }
+  memcpy(datacomp, data, size);
+  cid->type = L_JPEG_ENCODE;
+  cid->datacomp = datacomp;
+  cid->nbytescomp = size;
+  cid->w = pixGetWidth(pix);
+  cid->h = pixGetHeight(pix);
+  cid->bps = 8;
+  cid->spp = spp;
+  cid->res = pixGetXRes(pix);
+  return cid;
+}
+
+// Encodes a 1 bpp pix with CCITT G4. Leptonica's own G4 encoder goes
+// through libtiff and a temporary file, and is missing where Leptonica is
+// built without libtiff, as on Android, where binary pages could not be
+// added at all.
+static L_COMP_DATA *g4DataToCIData(Pix *pix) {
+  GenericVector<unsigned char> g4;
+  if (!tesseract::EncodeCCITTG4(pix, &g4))
+    return NULL;
+  L_COMP_DATA *cid =
+      static_cast<L_COMP_DATA *>(lept_calloc(1, sizeof(L_COMP_DATA)));
+  l_uint8 *datacomp = static_cast<l_uint8 *>(lept_calloc(g4.size(), 1));
+  if (!cid || !datacomp) {
+    lept_free(cid);
+    lept_free(datacomp);
+    return NULL;
+  }
+  memcpy(datacomp, &g4[0], g4.size());
+  cid->type = L_G4_ENCODE;
+  cid->datacomp = datacomp;
+  cid->nbytescomp = g4.size();
+  cid->w = pixGetWidth(pix);
+  cid->h = pixGetHeight(pix);
+  cid->bps = 1;
+  cid->spp = 1;
+  cid->res = pixGetXRes(pix);
+  return cid;
+}
+
+// Compresses the image of a page as imageToPDFObj does, but returns its
+// PDF object in pieces: everything up to the stream data in *header, and the
+// stream data itself in *pcid, which the caller must destroy. The object
+// ends with kImageObjectEnd. The data can then be written out without
+// another copy of it being made. If jpeg is not NULL, it holds the
+// jpeg_size bytes of the JPEG file pix was decoded from, which are embedded
+// instead of encoding pix again. If grey_reduction is positive, a pix that
+// has to be encoded, other than a binary one, is encoded as a grey JPEG
+// reduced by that factor.
+static bool imageToPDFObjParts(Pix *pix,
+                               char *filename,
+                               const char *jpeg,
+                               int jpeg_size,
+                               int grey_reduction,
+                               long int objnum,
+                               STRING *header,
+                               L_COMP_DATA **pcid) {
   size_t n;
   char b0[kBasicBufSize];
   char b1[kBasicBufSize];
   char b2[kBasicBufSize];
-  if (!pdf_object_size || !pdf_object)
-    return false;
-  *pdf_object = NULL;
-  *pdf_object_size = 0;
+  *pcid = NULL;
   if (!filename)
     return false;
 
   L_COMP_DATA *cid = NULL;
   const int kJpegQuality = 85;
 
+  if (jpeg != NULL && jpeg_size > 0)
+    cid = jpegDataToCIData(pix, jpeg, jpeg_size);
+  if (!cid && !isEmbeddedAsIs(filename)) {
+    // Only the header of pix is needed if its data or file is embedded.
+    if (!pixGetData(pix))
+      return false;
+    // Binary images are always smaller as G4 than as Flate, even when the
+    // Flate data could be taken from a PNG file as it is.
+    if (pixGetDepth(pix) == 1 && !pixGetColormap(pix)) {
+      cid = g4DataToCIData(pix);
+    } else if (grey_reduction > 0) {
+      // Area mapping averages whole blocks of pixels, which keeps thin
+      // strokes that subsampling would lose.
+      Pix *grey = pixConvertTo8(pix, FALSE);
+      if (grey && grey_reduction > 1) {
+        float scale = 1.0f / grey_reduction;
+        Pix *reduced = pixScaleAreaMap(grey, scale, scale);
+        pixDestroy(&grey);
+        grey = reduced;
+      }
+      if (!grey || pixGenerateCIData(grey, L_JPEG_ENCODE, kJpegQuality, 0,
+                                     &cid)) {
+        l_CIDataDestroy(&cid);
+      }
+      pixDestroy(&grey);
+    }
+  }
+
   // TODO(jbreiden) Leptonica 1.71 doesn't correctly handle certain
   // types of PNG files, especially if there are 2 samples per pixel.
   // We can get rid of this logic after Leptonica 1.72 is released and
   // has propagated everywhere. Bug discussion as follows.
   // https://code.google.com/p/tesseract-ocr/issues/detail?id=1300
-  int format, sad;
-  findFileFormat(filename, &format);
-  if (pixGetSpp(pix) == 4 && format == IFF_PNG) {
-    Pix *p1 = pixAlphaBlendUniform(pix, 0xffffff00);
-    sad = pixGenerateCIData(p1, L_FLATE_ENCODE, 0, 0, &cid);
-    pixDestroy(&p1);
-  } else {
-    sad = l_generateCIDataForPdf(filename, pix, kJpegQuality, &cid);
+  int format, sad = 0;
+  if (!cid) {
+    findFileFormat(filename, &format);
+    if (pixGetSpp(pix) == 4 && format == IFF_PNG) {
+      Pix *p1 = pixAlphaBlendUniform(pix, 0xffffff00);
+      sad = pixGenerateCIData(p1, L_FLATE_ENCODE, 0, 0, &cid);
+      pixDestroy(&p1);
+    } else {
+      sad = l_generateCIDataForPdf(filename, pix, kJpegQuality, &cid);
+    }
   }
 
   if (sad || !cid) {
@@ -807,43 +961,141 @@ bool TessPDFRenderer::imageToPDFObj(Pix *pix,
     return false;
   }
 
-  const char *b3 =
-      "endstream\n"
-      "endobj\n";
+  *header = b1;
+  *header += colorspace;
+  *header += b2;
+  *pcid = cid;
+  return true;
+}
+
+bool TessPDFRenderer::imageToPDFObj(Pix *pix,
+                                    char *filename,
+                                    long int objnum,
+                                    char **pdf_object,
+                                    long int *pdf_object_size) {
+  if (!pdf_object_size || !pdf_object)
+    return false;
+  *pdf_object = NULL;
+  *pdf_object_size = 0;
 
-  size_t b1_len = strlen(b1);
-  size_t b2_len = strlen(b2);
-  size_t b3_len = strlen(b3);
-  size_t colorspace_len = strlen(colorspace);
+  STRING header;
+  L_COMP_DATA *cid;
+  if (!imageToPDFObjParts(pix, filename, NULL, 0, 0, objnum, &header, &cid))
+    return false;
 
-  *pdf_object_size =
-      b1_len + colorspace_len + b2_len + cid->nbytescomp + b3_len;
+  size_t header_len = header.length();
+  size_t end_len = strlen(kImageObjectEnd);
+  *pdf_object_size = header_len + cid->nbytescomp + end_len;
   *pdf_object = new char[*pdf_object_size];
 
   char *p = *pdf_object;
-  memcpy(p, b1, b1_len);
-  p += b1_len;
-  memcpy(p, colorspace, colorspace_len);
-  p += colorspace_len;
-  memcpy(p, b2, b2_len);
-  p += b2_len;
+  memcpy(p, header.string(), header_len);
+  p += header_len;
   memcpy(p, cid->datacomp, cid->nbytescomp);
   p += cid->nbytescomp;
-  memcpy(p, b3, b3_len);
+  memcpy(p, kImageObjectEnd, end_len);
   l_CIDataDestroy(&cid);
   return true;
 }
 
-bool TessPDFRenderer::AddImageHandler(TessBaseAPI* api) {
+// A page whose content stream and image are compressed on a worker thread
+// while the next page is recognized, and written out after that.
+struct PDFPage {
+  PDFPage()
+    : text(NULL), pix(NULL), grey_reduction(0), comp_text(NULL),
+      comp_text_len(0), cid(NULL), ok(false), threaded(false) {}
+  ~PDFPage() {
+    delete[] text;
+    pixDestroy(&pix);
+    lept_free(comp_text);
+    l_CIDataDestroy(&cid);
+  }
+
+  // What the page is made from. Nothing here is shared with the
+  // TessBaseAPI, which moves on to the next page meanwhile.
+  double width;                // in points
+  double height;
+  long int image_objnum;
+  char *text;                  // uncompressed content stream
+  Pix *pix;                    // copy of the image, or just its header if
+                               // it is embedded from filename or jpeg
+  STRING filename;
+  GenericVector<char> jpeg;    // data the image was decoded from, if given
+  int grey_reduction;          // see SetGreyImageReduction
+
+  // What it is made into.
+  unsigned char *comp_text;
+  size_t comp_text_len;
+  STRING image_header;
+  L_COMP_DATA *cid;
+  bool ok;
+
+#ifndef _WIN32
+  pthread_t thread;
+#endif
+  bool threaded;
+};
+
+static void CompressPDFPage(PDFPage *page) {
+  page->comp_text =
+      zlibCompress(reinterpret_cast<unsigned char *>(page->text),
+                   strlen(page->text), &page->comp_text_len);
+  page->ok = page->comp_text != NULL &&
+      imageToPDFObjParts(page->pix,
+                         const_cast<char *>(page->filename.string()),
+                         page->jpeg.empty() ? NULL : &page->jpeg[0],
+                         page->jpeg.size(), page->grey_reduction,
+                         page->image_objnum,
+                         &page->image_header, &page->cid);
+}
+
+#ifndef _WIN32
+static void *CompressPDFPageEntry(void *arg) {
+  CompressPDFPage(static_cast<PDFPage *>(arg));
+  return NULL;
+}
+#endif
+
+TessPDFRenderer::~TessPDFRenderer() {
+  WaitForPage();
+  delete pending_page_;
+}
+
+void TessPDFRenderer::StartPage(PDFPage *page) {
+  pending_page_ = page;
+#ifndef _WIN32
+  page->threaded =
+      pthread_create(&page->thread, NULL, &CompressPDFPageEntry, page) == 0;
+  if (page->threaded)
+    return;
+#endif
+  CompressPDFPage(page);
+}
+
+void TessPDFRenderer::WaitForPage() {
+#ifndef _WIN32
+  if (pending_page_ != NULL && pending_page_->threaded) {
+    pthread_join(pending_page_->thread, NULL);
+    pending_page_->threaded = false;
+  }
+#endif
+}
+
+bool TessPDFRenderer::FlushPage() {
+  if (pending_page_ == NULL)
+    return true;
+  WaitForPage();
+  bool ok = WritePage(pending_page_);
+  delete pending_page_;
+  pending_page_ = NULL;
+  return ok;
+}
+
+bool TessPDFRenderer::WritePage(PDFPage *page) {
   size_t n;
   char buf[kBasicBufSize];
-  Pix *pix = api->GetInputImage();
-  char *filename = (char *)api->GetInputName();
-  int ppi = api->GetSourceYResolution();
-  if (!pix || ppi <= 0)
+  if (!page->ok)
     return false;
-  double width = pixGetWidth(pix) * 72.0 / ppi;
-  double height = pixGetHeight(pix) * 72.0 / ppi;
 
   // PAGE
   n = snprintf(buf, sizeof(buf),
@@ -863,8 +1115,8 @@ bool TessPDFRenderer::AddImageHandler(TessBaseAPI* api) {
                "endobj\n",
                obj_,
                2L,            // Pages object
-               width,
-               height,
+               page->width,
+               page->height,
                obj_ + 1,      // Contents object
                obj_ + 2,      // Image object
                3L);           // Type0 Font
@@ -873,30 +1125,18 @@ bool TessPDFRenderer::AddImageHandler(TessBaseAPI* api) {
   AppendPDFObject(buf);
 
   // CONTENTS
-  char* pdftext = GetPDFTextObjects(api, width, height);
-  long pdftext_len = strlen(pdftext);
-  unsigned char *pdftext_casted = reinterpret_cast<unsigned char *>(pdftext);
-  size_t len;
-  unsigned char *comp_pdftext =
-      zlibCompress(pdftext_casted, pdftext_len, &len);
-  long comp_pdftext_len = len;
+  long comp_pdftext_len = page->comp_text_len;
   n = snprintf(buf, sizeof(buf),
                "%ld 0 obj\n"
                "<<\n"
                "  /Length %ld /Filter /FlateDecode\n"
                ">>\n"
                "stream\n", obj_, comp_pdftext_len);
-  if (n >= sizeof(buf)) {
-    delete[] pdftext;
-    lept_free(comp_pdftext);
-    return false;
-  }
+  if (n >= sizeof(buf)) return false;
   AppendString(buf);
   long objsize = strlen(buf);
-  AppendData(reinterpret_cast<char *>(comp_pdftext), comp_pdftext_len);
+  AppendData(reinterpret_cast<char *>(page->comp_text), comp_pdftext_len);
   objsize += comp_pdftext_len;
-  lept_free(comp_pdftext);
-  delete[] pdftext;
   const char *b2 =
       "endstream\n"
       "endobj\n";
@@ -904,21 +1144,70 @@ bool TessPDFRenderer::AddImageHandler(TessBaseAPI* api) {
   objsize += strlen(b2);
   AppendPDFObjectDIY(objsize);
 
-  char *pdf_object;
-  if (!imageToPDFObj(pix, filename, obj_, &pdf_object, &objsize)) {
-    return false;
-  }
-  AppendData(pdf_object, objsize);
+  // IMAGE, written straight from the compressed data.
+  L_COMP_DATA *cid = page->cid;
+  AppendString(page->image_header.string());
+  AppendData(reinterpret_cast<char *>(cid->datacomp), cid->nbytescomp);
+  AppendString(kImageObjectEnd);
+  objsize = page->image_header.length() + cid->nbytescomp +
+      strlen(kImageObjectEnd);
   AppendPDFObjectDIY(objsize);
-  delete[] pdf_object;
   return true;
 }
 
+bool TessPDFRenderer::AddImageHandler(TessBaseAPI* api) {
+  Pix *pix = api->GetInputImage();
+  char *filename = (char *)api->GetInputName();
+  // The JPEG data only ever belongs to this page.
+  const char *page_jpeg = page_jpeg_;
+  int page_jpeg_size = page_jpeg_size_;
+  page_jpeg_ = NULL;
+  page_jpeg_size_ = 0;
+  int ppi = api->GetSourceYResolution();
+  if (!pix || !filename || ppi <= 0)
+    return false;
+
+  PDFPage *page = new PDFPage;
+  page->width = pixGetWidth(pix) * 72.0 / ppi;
+  page->height = pixGetHeight(pix) * 72.0 / ppi;
+  page->text = GetPDFTextObjects(api, page->width, page->height);
+  page->filename = filename;
+  page->grey_reduction = grey_image_reduction_;
+  int spp;
+  if (page_jpeg != NULL &&
+      canEmbedJpegData(pix, page_jpeg, page_jpeg_size, &spp)) {
+    page->jpeg.resize_no_init(page_jpeg_size);
+    memcpy(&page->jpeg[0], page_jpeg, page_jpeg_size);
+  }
+  // Copying the image data is only needed when it will be encoded.
+  if (!page->jpeg.empty() || isEmbeddedAsIs(filename)) {
+    page->pix = pixCreateHeader(pixGetWidth(pix), pixGetHeight(pix),
+                                pixGetDepth(pix));
+    pixCopyResolution(page->pix, pix);
+  } else {
+    page->pix = pixCopy(NULL, pix);
+  }
+
+  // The previous page has had all the time this one took to be recognized
+  // to be compressed, and has to be written before this one.
+  bool ok = FlushPage();
+  if (!page->pix) {
+    delete page;
+    return false;
+  }
+  page->image_objnum = obj_ + 2;
+  StartPage(page);
+  return ok;
+}
+
 
 bool TessPDFRenderer::EndDocumentHandler() {
   size_t n;
   char buf[kBasicBufSize];
 
+  if (!FlushPage())
+    return false;
+
   // We reserved the /Pages object number early, so that the /Page
   // objects could refer to their parent. We finally have enough
   // information to go fill it in. Using lower level calls to manipulate
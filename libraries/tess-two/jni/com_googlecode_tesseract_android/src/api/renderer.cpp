@@ -19,10 +19,18 @@
 #include "config_auto.h"
 #endif
 
+#include <stdio.h>
 #include <string.h>
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
 #include "baseapi.h"
 #include "genericvector.h"
+#include "pagecounters.h"
 #include "renderer.h"
+#include "textbuffer.h"
 
 namespace tesseract {
 
@@ -45,6 +53,26 @@ TessResultRenderer::TessResultRenderer(const char *outputbase,
   }
 }
 
+TessResultRenderer::TessResultRenderer(int fd, const char* extension)
+    : file_extension_(extension),
+      title_(""), imagenum_(-1),
+      fout_(NULL),
+      next_(NULL),
+      happy_(true) {
+#ifdef _WIN32
+  int own_fd = _dup(fd);
+  if (own_fd >= 0 && (fout_ = _fdopen(own_fd, "wb")) == NULL) _close(own_fd);
+#else
+  int own_fd = dup(fd);
+  if (own_fd >= 0 && (fout_ = fdopen(own_fd, "wb")) == NULL) close(own_fd);
+#endif
+  if (fout_ == NULL) {
+    // Keep a valid stream for the destructor.
+    fout_ = stdout;
+    happy_ = false;
+  }
+}
+
 TessResultRenderer::~TessResultRenderer() {
  if (fout_ != stdout)
     fclose(fout_);
@@ -81,6 +109,7 @@ bool TessResultRenderer::AddImage(TessBaseAPI* api) {
   if (!happy_) return false;
   ++imagenum_;
   bool ok = AddImageHandler(api);
+  if (fflush(fout_) != 0) happy_ = ok = false;
   if (next_) {
     ok = next_->AddImage(api) && ok;
   }
@@ -228,6 +257,40 @@ bool TessTsvRenderer::AddImageHandler(TessBaseAPI* api) {
   return true;
 }
 
+/**********************************************************************
+ * JSON Text Renderer interface implementation
+ **********************************************************************/
+TessJsonRenderer::TessJsonRenderer(const char* outputbase)
+    : TessResultRenderer(outputbase, "json"), first_page_(true) {
+}
+
+bool TessJsonRenderer::BeginDocumentHandler() {
+  first_page_ = true;
+  TextBuffer header(64);
+  header.Append("{\"title\":\"");
+  header.AppendJsonEscaped(title());
+  header.Append("\",\"pages\":[\n");
+  AppendData(header.data(), header.length());
+  return true;
+}
+
+bool TessJsonRenderer::EndDocumentHandler() {
+  AppendString("\n]}\n");
+  return true;
+}
+
+bool TessJsonRenderer::AddImageHandler(TessBaseAPI* api) {
+  char* json = api->GetJSONText(imagenum());
+  if (json == NULL) return false;
+
+  if (!first_page_) AppendString(",\n");
+  first_page_ = false;
+  AppendString(json);
+  delete[] json;
+
+  return true;
+}
+
 /**********************************************************************
  * UNLV Text Renderer interface implementation
  **********************************************************************/
@@ -262,6 +325,41 @@ bool TessBoxTextRenderer::AddImageHandler(TessBaseAPI* api) {
   return true;
 }
 
+/**********************************************************************
+ * Counters Renderer interface implementation
+ **********************************************************************/
+TessCountersRenderer::TessCountersRenderer(const char* outputbase)
+    : TessResultRenderer(outputbase, "counters") {}
+
+bool TessCountersRenderer::BeginDocumentHandler() {
+  STRING header("page");
+  for (int i = 0; i < COUNTER_COUNT; ++i) {
+    header += "\t";
+    header += PageCounts::Name(static_cast<PageCounter>(i));
+  }
+  header += "\n";
+  AppendString(header.string());
+  return true;
+}
+
+bool TessCountersRenderer::AddImageHandler(TessBaseAPI* api) {
+  const PageCounts* counts = api->GetPageCounts();
+  if (counts == NULL) return false;
+
+  STRING line;
+  line.add_str_int("", imagenum() + 1);
+  for (int i = 0; i < COUNTER_COUNT; ++i) {
+    char value[32];
+    snprintf(value, sizeof(value), "\t%lld",
+             static_cast<long long>(counts->counts[i]));
+    line += value;
+  }
+  line += "\n";
+  AppendString(line.string());
+
+  return true;
+}
+
 /**********************************************************************
  * Osd Text Renderer interface implementation
  **********************************************************************/
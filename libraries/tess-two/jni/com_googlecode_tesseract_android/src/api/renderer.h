@@ -28,6 +28,7 @@
 namespace tesseract {
 
 class TessBaseAPI;
+struct PDFPage;
 
 /**
  * Interface for rendering tesseract results into a document, such as text,
@@ -62,6 +63,8 @@ class TESS_API TessResultRenderer {
 
     /**
      * Adds the recognized text from the source image to the current document.
+     * The output is flushed after each image, so that only the current page
+     * is ever held in memory and a failure to write shows at once.
      * Invalid if BeginDocument not yet called.
      *
      * Note that this API is a bit weird but is designed to fit into the
@@ -104,6 +107,14 @@ class TESS_API TessResultRenderer {
     TessResultRenderer(const char *outputbase,
                        const char* extension);
 
+    /**
+     * As above, but writes to a duplicate of the open file descriptor fd,
+     * which the caller still owns and may close once this returns. This
+     * allows writing to a pipe or socket, or to a file that was opened by
+     * another process and handed over.
+     */
+    TessResultRenderer(int fd, const char* extension);
+
     // Hook for specialized handling in BeginDocument()
     virtual bool BeginDocumentHandler();
 
@@ -179,14 +190,56 @@ class TESS_API TessTsvRenderer : public TessResultRenderer {
   bool font_info_;              // whether to print font information
 };
 
+/**
+ * Renders Tesseract output into a JSON document of the form
+ * {"title":..., "pages":[...]}, with a page object as from GetJSONText
+ * for each image.
+ */
+class TESS_API TessJsonRenderer : public TessResultRenderer {
+ public:
+  explicit TessJsonRenderer(const char* outputbase);
+
+ protected:
+  virtual bool BeginDocumentHandler();
+  virtual bool AddImageHandler(TessBaseAPI* api);
+  virtual bool EndDocumentHandler();
+
+ private:
+  bool first_page_;             // whether no page has been written yet
+};
+
 /**
  * Renders tesseract output into searchable PDF
  */
+// The text layer of a page is taken from the TessBaseAPI when the page is
+// added, but it and the image are compressed on a worker thread while the
+// next page is recognized, and the page is written when the next one is
+// added or the document ends. A page that fails to compress makes that
+// next call fail.
 class TESS_API TessPDFRenderer : public TessResultRenderer {
  public:
   // datadir is the location of the TESSDATA. We need it because
   // we load a custom PDF font from this location.
   TessPDFRenderer(const char *outputbase, const char *datadir);
+  // Writes to a duplicate of the open file descriptor fd instead of a
+  // named file.
+  TessPDFRenderer(int fd, const char *datadir);
+  virtual ~TessPDFRenderer();
+
+  // Embeds the size bytes of JPEG data as the image of the next page added,
+  // instead of encoding its image again, if the data has the size of that
+  // image and can be embedded as it is. The data must be that of the file
+  // the image was decoded from, and must stay valid until the page has been
+  // added. It applies to that page only.
+  void SetPageJpeg(const char *data, int size);
+
+  // Encodes the image of every page added after this as an 8 bpp grey JPEG
+  // reduced by the given factor, instead of at its own depth and size, when
+  // it has to be encoded at all. Searchable PDFs rarely need more than that
+  // for the image under the text, and it is much quicker to encode and much
+  // smaller. 0, the default, turns this off, and 1 converts to grey only.
+  // Binary images, which are better off as G4, are never converted.
+  void SetGreyImageReduction(int reduction);
 
  protected:
   virtual bool BeginDocumentHandler();
@@ -203,6 +256,10 @@ class TESS_API TessPDFRenderer : public TessResultRenderer {
   GenericVector<long int> offsets_;  // offset of every PDF object in bytes
   GenericVector<long int> pages_;    // object number for every /Page object
   const char *datadir_;              // where to find the custom font
+  const char *page_jpeg_;            // JPEG data for the next page, or NULL
+  int page_jpeg_size_;
+  int grey_image_reduction_;         // see SetGreyImageReduction
+  PDFPage *pending_page_;            // being compressed, or NULL
   // Bookkeeping only. DIY = Do It Yourself.
   void AppendPDFObjectDIY(size_t objectsize);
   // Bookkeeping + emit data.
@@ -213,6 +270,16 @@ class TESS_API TessPDFRenderer : public TessResultRenderer {
   // Turn an image into a PDF object. Only transcode if we have to.
   static bool imageToPDFObj(Pix *pix, char *filename, long int objnum,
                           char **pdf_object, long int *pdf_object_size);
+  // Starts compressing page, which becomes the pending page, on a worker
+  // thread, or compresses it right away if there are no threads.
+  void StartPage(PDFPage *page);
+  // Waits until the pending page, if any, has been compressed.
+  void WaitForPage();
+  // Waits for the pending page, if any, and writes it out. Returns false
+  // if it could not be compressed or written.
+  bool FlushPage();
+  // Writes the objects of a compressed page.
+  bool WritePage(PDFPage *page);
 };
 
 
@@ -238,6 +305,19 @@ class TESS_API TessBoxTextRenderer : public TessResultRenderer {
   virtual bool AddImageHandler(TessBaseAPI* api);
 };
 
+/**
+ * Renders the hot-path counts of each page, as a tab separated line after
+ * a line of their names, to tell pathological pages apart.
+ */
+class TESS_API TessCountersRenderer : public TessResultRenderer {
+ public:
+  explicit TessCountersRenderer(const char* outputbase);
+
+ protected:
+  virtual bool BeginDocumentHandler();
+  virtual bool AddImageHandler(TessBaseAPI* api);
+};
+
 /**
  * Renders tesseract output into an osd text string
  */
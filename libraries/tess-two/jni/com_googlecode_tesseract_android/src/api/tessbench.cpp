@@ -0,0 +1,472 @@
+///////////////////////////////////////////////////////////////////////
+// File:        tessbench.cpp
+// Description: Benchmark of the native OCR pipeline over a fixed corpus.
+//
+// (C) Copyright 2016, Google Inc.
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////
+
+// Runs every image of a corpus through thresholding, layout, recognition
+// and rendering, once per engine mode, and writes one JSON object per mode
+// to stdout: throughput, p50/p99 page and stage latency, C++ allocations
+// per page, the mean hot-path counters and the peak resident set size. The
+// images are read in the order given and the same pages are recognized in
+// every iteration, so runs on the same build and device are comparable.
+// The peak RSS is that of the process, so it covers the modes run before;
+// run one --oem per process to compare the modes' memory.
+//
+// With --micro, instead times the binarization kernels on each image, as 8
+// bit grey and as 32 bit color: ThresholdRectToPix with the SIMD row kernels
+// forced off and on, and HistogramRect, which has no SIMD form, writing one
+// JSON object per image and depth. No traineddata is needed.
+//
+// Usage: tessbench [options] datapath lang image... [@listfile...]
+//        tessbench --micro [options] image... [@listfile...]
+//   --oem 0,1,2        engine modes to run, as in tesseract --oem
+//   --psm N            page segmentation mode
+//   --iterations N     timed passes over the corpus (3)
+//   --warmup N         untimed passes first, to load and adapt (1)
+//   --outputbase path  where the text, hOCR and TSV renderers write
+//   -c var=value       sets a Tesseract variable after Init
+//   --micro            times the thresholding kernels only
+
+#ifdef HAVE_CONFIG_H
+#include "config_auto.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+#include <atomic>
+#include <new>
+#include "allheaders.h"
+#include "baseapi.h"
+#include "genericvector.h"
+#include "otsuthr.h"
+#include "pagecounters.h"
+#include "renderer.h"
+#include "simddetect.h"
+#include "stagetimer.h"
+#include "strngs.h"
+#include "thresholder.h"
+
+// Every C++ allocation of the process, counted by the operator new below,
+// which replaces the library's own.
+static std::atomic<long long> num_allocations(0);
+
+void* operator new(size_t size) {
+  ++num_allocations;
+  void* ptr = malloc(size != 0 ? size : 1);
+  if (ptr == NULL) throw std::bad_alloc();
+  return ptr;
+}
+
+void* operator new[](size_t size) {
+  return operator new(size);
+}
+
+void operator delete(void* ptr) noexcept {
+  free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+  free(ptr);
+}
+
+namespace {
+
+struct BenchOptions {
+  BenchOptions()
+    : micro(false), psm(-1), iterations(3), warmup(1),
+      outputbase("tessbench"), datapath(NULL), lang(NULL) {}
+
+  bool micro;
+  GenericVector<int> oems;
+  int psm;
+  int iterations;
+  int warmup;
+  const char* outputbase;
+  const char* datapath;
+  const char* lang;
+  GenericVector<STRING> vars;
+  GenericVector<STRING> values;
+  GenericVector<STRING> images;
+};
+
+// The measurements of one page in one timed iteration.
+struct PageSample {
+  double msecs;
+  double megapixels;
+  long long allocations;
+  tesseract::StageTimings timings;
+  tesseract::PageCounts counts;
+};
+
+double NowMillis() {
+  struct timeval now;
+  gettimeofday(&now, NULL);
+  return now.tv_sec * 1000.0 + now.tv_usec / 1000.0;
+}
+
+// Returns the peak resident set size of the process so far, in kB, or -1
+// where it is not known.
+long PeakRssKb() {
+#ifndef _WIN32
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) == 0) return usage.ru_maxrss;
+#endif
+  return -1;
+}
+
+// Returns the nearest-rank percentile of values, which it sorts.
+double Percentile(GenericVector<double>* values, double percent) {
+  if (values->empty()) return 0.0;
+  values->sort();
+  int rank = static_cast<int>(percent / 100.0 * values->size() + 0.5);
+  if (rank < 1) rank = 1;
+  if (rank > values->size()) rank = values->size();
+  return (*values)[rank - 1];
+}
+
+void Usage(const char* program) {
+  fprintf(stderr,
+          "Usage: %s [--oem 0,1,2] [--psm N] [--iterations N] [--warmup N]\n"
+          "       [--outputbase path] [-c var=value]... datapath lang\n"
+          "       image... [@listfile...]\n"
+          "       %s --micro [--iterations N] [--warmup N] image...\n"
+          "       [@listfile...]\n", program, program);
+  exit(1);
+}
+
+// Adds the images named, one per line, in the file at path.
+void ReadImageList(const char* path, GenericVector<STRING>* images) {
+  FILE* fp = fopen(path, "r");
+  if (fp == NULL) {
+    fprintf(stderr, "Cannot open image list %s\n", path);
+    exit(1);
+  }
+  char line[1024];
+  while (fgets(line, sizeof(line), fp) != NULL) {
+    int length = strlen(line);
+    while (length > 0 && (line[length - 1] == '\n' || line[length - 1] == '\r'))
+      line[--length] = '\0';
+    if (length > 0 && line[0] != '#') images->push_back(STRING(line));
+  }
+  fclose(fp);
+}
+
+void ParseArgs(int argc, char** argv, BenchOptions* options) {
+  int arg = 1;
+  for (; arg < argc && argv[arg][0] == '-'; ++arg) {
+    const char* flag = argv[arg];
+    if (strcmp(flag, "--micro") == 0) {
+      options->micro = true;
+      continue;
+    }
+    if (arg + 1 >= argc) Usage(argv[0]);
+    const char* value = argv[++arg];
+    if (strcmp(flag, "--oem") == 0) {
+      for (const char* p = value; *p != '\0'; ++p) {
+        if (*p >= '0' && *p <= '9') options->oems.push_back(*p - '0');
+      }
+    } else if (strcmp(flag, "--psm") == 0) {
+      options->psm = atoi(value);
+    } else if (strcmp(flag, "--iterations") == 0) {
+      options->iterations = atoi(value);
+    } else if (strcmp(flag, "--warmup") == 0) {
+      options->warmup = atoi(value);
+    } else if (strcmp(flag, "--outputbase") == 0) {
+      options->outputbase = value;
+    } else if (strcmp(flag, "-c") == 0) {
+      const char* equals = strchr(value, '=');
+      if (equals == NULL) Usage(argv[0]);
+      STRING var(value);
+      var.truncate_at(equals - value);
+      options->vars.push_back(var);
+      options->values.push_back(STRING(equals + 1));
+    } else {
+      Usage(argv[0]);
+    }
+  }
+  if (argc - arg < (options->micro ? 1 : 3) || options->iterations < 1)
+    Usage(argv[0]);
+  if (!options->micro) {
+    options->datapath = argv[arg++];
+    options->lang = argv[arg++];
+  }
+  for (; arg < argc; ++arg) {
+    if (argv[arg][0] == '@')
+      ReadImageList(argv[arg] + 1, &options->images);
+    else
+      options->images.push_back(STRING(argv[arg]));
+  }
+  if (options->images.empty()) Usage(argv[0]);
+  if (options->oems.empty()) {
+    options->oems.push_back(tesseract::OEM_TESSERACT_ONLY);
+    options->oems.push_back(tesseract::OEM_CUBE_ONLY);
+    options->oems.push_back(tesseract::OEM_TESSERACT_CUBE_COMBINED);
+  }
+}
+
+// Writes the p50 and p99 of values as a JSON object.
+void PrintPercentiles(GenericVector<double>* values) {
+  double p50 = Percentile(values, 50.0);
+  double p99 = Percentile(values, 99.0);
+  printf("{\"p50\":%.3f,\"p99\":%.3f}", p50, p99);
+}
+
+// Runs the whole corpus through api once, adding a sample per page to
+// samples if it is not NULL. Returns false if a page failed.
+bool RunCorpus(const BenchOptions& options, tesseract::TessBaseAPI* api,
+               GenericVector<PageSample>* samples) {
+  tesseract::TessResultRenderer* renderer =
+      new tesseract::TessTextRenderer(options.outputbase);
+  renderer->insert(new tesseract::TessHOcrRenderer(options.outputbase));
+  renderer->insert(new tesseract::TessTsvRenderer(options.outputbase));
+  bool ok = renderer->BeginDocument("tessbench");
+  for (int i = 0; ok && i < options.images.size(); ++i) {
+    const char* filename = options.images[i].string();
+    Pix* pix = pixRead(filename);
+    if (pix == NULL) {
+      fprintf(stderr, "Cannot open input file: %s\n", filename);
+      ok = false;
+      break;
+    }
+    long long allocations = num_allocations;
+    double start = NowMillis();
+    ok = api->ProcessPage(pix, i, filename, NULL, 0, renderer);
+    double msecs = NowMillis() - start;
+    if (samples != NULL) {
+      PageSample sample;
+      sample.msecs = msecs;
+      sample.megapixels = pixGetWidth(pix) * pixGetHeight(pix) / 1.0e6;
+      sample.allocations = num_allocations - allocations;
+      const tesseract::StageTimings* timings = api->GetTimings();
+      if (timings != NULL) sample.timings = *timings;
+      const tesseract::PageCounts* counts = api->GetPageCounts();
+      if (counts != NULL) sample.counts = *counts;
+      samples->push_back(sample);
+    }
+    pixDestroy(&pix);
+    if (!ok) fprintf(stderr, "Error during processing of %s\n", filename);
+  }
+  ok = renderer->EndDocument() && ok;
+  delete renderer;
+  return ok;
+}
+
+// Benchmarks one engine mode, writing its results as a line of JSON.
+// Returns false if it could not be run.
+bool RunEngineMode(const BenchOptions& options, int oem) {
+  tesseract::TessBaseAPI api;
+  if (api.Init(options.datapath, options.lang,
+               static_cast<tesseract::OcrEngineMode>(oem)) != 0) {
+    printf("{\"oem\":%d,\"lang\":\"%s\",\"error\":\"init\"}\n", oem,
+           options.lang);
+    return false;
+  }
+  for (int v = 0; v < options.vars.size(); ++v) {
+    if (!api.SetVariable(options.vars[v].string(),
+                         options.values[v].string())) {
+      fprintf(stderr, "Could not set variable %s\n", options.vars[v].string());
+    }
+  }
+  if (options.psm >= 0)
+    api.SetPageSegMode(static_cast<tesseract::PageSegMode>(options.psm));
+  for (int w = 0; w < options.warmup; ++w) {
+    if (!RunCorpus(options, &api, NULL)) {
+      printf("{\"oem\":%d,\"lang\":\"%s\",\"error\":\"recognition\"}\n", oem,
+             options.lang);
+      return false;
+    }
+  }
+  GenericVector<PageSample> samples;
+  for (int it = 0; it < options.iterations; ++it) {
+    if (!RunCorpus(options, &api, &samples)) {
+      printf("{\"oem\":%d,\"lang\":\"%s\",\"error\":\"recognition\"}\n", oem,
+             options.lang);
+      return false;
+    }
+  }
+
+  double total_msecs = 0.0;
+  double total_megapixels = 0.0;
+  GenericVector<double> latencies;
+  GenericVector<double> allocations;
+  tesseract::PageCounts counts;
+  for (int s = 0; s < samples.size(); ++s) {
+    counts.Add(samples[s].counts);
+    total_msecs += samples[s].msecs;
+    total_megapixels += samples[s].megapixels;
+    latencies.push_back(samples[s].msecs);
+    allocations.push_back(static_cast<double>(samples[s].allocations));
+  }
+  double seconds = total_msecs / 1000.0;
+  printf("{\"oem\":%d,\"lang\":\"%s\",\"pages\":%d,\"iterations\":%d,",
+         oem, options.lang, options.images.size(), options.iterations);
+  printf("\"pages_per_sec\":%.3f,\"megapixels_per_sec\":%.3f,",
+         seconds > 0.0 ? samples.size() / seconds : 0.0,
+         seconds > 0.0 ? total_megapixels / seconds : 0.0);
+  printf("\"latency_ms\":");
+  PrintPercentiles(&latencies);
+  printf(",\"stages_ms\":{");
+  for (int stage = 0; stage < tesseract::STAGE_COUNT; ++stage) {
+    GenericVector<double> msecs;
+    for (int s = 0; s < samples.size(); ++s)
+      msecs.push_back(samples[s].timings.msecs[stage]);
+    printf("%s\"%s\":", stage > 0 ? "," : "",
+           tesseract::StageTimings::Name(
+               static_cast<tesseract::PageStage>(stage)));
+    PrintPercentiles(&msecs);
+  }
+  printf("},\"allocations_per_page\":");
+  PrintPercentiles(&allocations);
+  printf(",\"counters_per_page\":{");
+  for (int c = 0; c < tesseract::COUNTER_COUNT; ++c) {
+    printf("%s\"%s\":%.1f", c > 0 ? "," : "",
+           tesseract::PageCounts::Name(static_cast<tesseract::PageCounter>(c)),
+           static_cast<double>(counts.counts[c]) / samples.size());
+  }
+  printf("},\"peak_rss_kb\":%ld}\n", PeakRssKb());
+  fflush(stdout);
+  api.End();
+  return true;
+}
+
+// Gives the benchmark the row binarization of ImageThresholder.
+class MicroThresholder : public tesseract::ImageThresholder {
+ public:
+  // Binarizes the whole image given to SetImage by ThresholdRectToPix.
+  Pix* Threshold(int num_channels, const int* thresholds,
+                 const int* hi_values) const {
+    Pix* pix = NULL;
+    ThresholdRectToPix(pix_, num_channels, thresholds, hi_values, &pix);
+    return pix;
+  }
+};
+
+// Returns the name of the row kernel that ThresholdRectToPix uses when SIMD
+// is enabled.
+const char* SimdKernelName() {
+  if (tesseract::SIMDDetect::IsAVX2Available()) return "avx2";
+  if (tesseract::SIMDDetect::IsSSE2Available()) return "sse2";
+  if (tesseract::SIMDDetect::IsNEONAvailable()) return "neon";
+  return "none";
+}
+
+// Thresholds pix options.warmup times untimed, then options.iterations
+// times, adding the msecs of each timed pass to msecs. Returns the last
+// result.
+Pix* TimeThreshold(const BenchOptions& options,
+                   const MicroThresholder& thresholder, int num_channels,
+                   const int* thresholds, const int* hi_values,
+                   GenericVector<double>* msecs) {
+  Pix* result = NULL;
+  for (int it = -options.warmup; it < options.iterations; ++it) {
+    pixDestroy(&result);
+    double start = NowMillis();
+    result = thresholder.Threshold(num_channels, thresholds, hi_values);
+    if (it >= 0) msecs->push_back(NowMillis() - start);
+  }
+  return result;
+}
+
+// Times the thresholding kernels on src, writing the results as a line of
+// JSON.
+void RunMicroImage(const BenchOptions& options, const char* filename,
+                   Pix* src) {
+  int width = pixGetWidth(src);
+  int height = pixGetHeight(src);
+  int* thresholds = NULL;
+  int* hi_values = NULL;
+  int num_channels = tesseract::OtsuThreshold(src, 0, 0, width, height,
+                                              &thresholds, &hi_values);
+  MicroThresholder thresholder;
+  thresholder.SetImage(src);
+  GenericVector<double> scalar_msecs;
+  tesseract::SIMDDetect::SetEnabled(false);
+  Pix* scalar_pix = TimeThreshold(options, thresholder, num_channels,
+                                  thresholds, hi_values, &scalar_msecs);
+  tesseract::SIMDDetect::SetEnabled(true);
+  GenericVector<double> simd_msecs;
+  Pix* simd_pix = TimeThreshold(options, thresholder, num_channels,
+                                thresholds, hi_values, &simd_msecs);
+  l_int32 same = 0;
+  pixEqual(scalar_pix, simd_pix, &same);
+  pixDestroy(&scalar_pix);
+  pixDestroy(&simd_pix);
+  delete [] thresholds;
+  delete [] hi_values;
+
+  GenericVector<double> histogram_msecs;
+  int histogram[tesseract::kHistogramSize];
+  for (int it = -options.warmup; it < options.iterations; ++it) {
+    double start = NowMillis();
+    for (int ch = 0; ch < num_channels; ++ch)
+      tesseract::HistogramRect(src, ch, 0, 0, width, height, histogram);
+    if (it >= 0) histogram_msecs.push_back(NowMillis() - start);
+  }
+
+  printf("{\"micro\":\"%s\",\"depth\":%d,\"megapixels\":%.3f,"
+         "\"iterations\":%d,\"kernel\":\"%s\",\"scalar_ms\":",
+         filename, pixGetDepth(src), width * height / 1.0e6,
+         options.iterations, SimdKernelName());
+  PrintPercentiles(&scalar_msecs);
+  printf(",\"simd_ms\":");
+  PrintPercentiles(&simd_msecs);
+  printf(",\"bit_exact\":%s,\"histogram_ms\":", same ? "true" : "false");
+  PrintPercentiles(&histogram_msecs);
+  printf("}\n");
+  fflush(stdout);
+}
+
+// Runs the --micro benchmark on every image. Returns false if an image
+// could not be read.
+bool RunMicro(const BenchOptions& options) {
+  bool ok = true;
+  for (int i = 0; i < options.images.size(); ++i) {
+    const char* filename = options.images[i].string();
+    Pix* pix = pixRead(filename);
+    if (pix == NULL) {
+      fprintf(stderr, "Cannot open input file: %s\n", filename);
+      ok = false;
+      continue;
+    }
+    Pix* grey = pixConvertTo8(pix, false);
+    Pix* color = pixConvertTo32(pix);
+    if (grey != NULL) RunMicroImage(options, filename, grey);
+    if (color != NULL) RunMicroImage(options, filename, color);
+    pixDestroy(&grey);
+    pixDestroy(&color);
+    pixDestroy(&pix);
+  }
+  return ok;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  // Disable debugging and informational messages from Leptonica.
+  setMsgSeverity(L_SEVERITY_WARNING);
+  BenchOptions options;
+  ParseArgs(argc, argv, &options);
+  if (options.micro) return RunMicro(options) ? 0 : 1;
+  int failures = 0;
+  for (int i = 0; i < options.oems.size(); ++i) {
+    if (!RunEngineMode(options, options.oems[i])) ++failures;
+  }
+  return failures == options.oems.size() ? 1 : 0;
+}
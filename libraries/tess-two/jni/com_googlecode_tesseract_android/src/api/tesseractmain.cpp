@@ -27,8 +27,13 @@
 #include "allheaders.h"
 #include "baseapi.h"
 #include "basedir.h"
+#include "ccutil.h"
+#include "params.h"
 #include "renderer.h"
+#include "stagetimer.h"
 #include "strngs.h"
+#include "taskscheduler.h"
+#include "tesscallback.h"
 #include "tprintf.h"
 #include "openclwrapper.h"
 #include "osdetect.h"
@@ -92,8 +97,9 @@ void PrintUsage(const char* program) {
       "  %s --help | --help-psm | --help-oem | --version\n"
       "  %s --list-langs [--tessdata-dir PATH]\n"
       "  %s --print-parameters [options...] [configfile...]\n"
-      "  %s imagename|stdin outputbase|stdout [options...] [configfile...]\n",
-      program, program, program, program);
+      "  %s imagename|stdin outputbase|stdout [options...] [configfile...]\n"
+      "  %s --batch N [options...] [configfile...]\n",
+      program, program, program, program, program);
 }
 
 void PrintHelpForPSM() {
@@ -143,9 +149,27 @@ void PrintHelpMessage(const char* program) {
       "                        Multiple -c arguments are allowed.\n"
       "  --psm NUM             Specify page segmentation mode.\n"
       "  --oem NUM             Specify OCR Engine mode.\n"
+      "  --batch N             Read jobs from stdin and run them on N\n"
+      "                        engines that share the loaded model.\n"
       "NOTE: These options must occur before any configfile.\n";
 
   printf("\n%s\n", ocr_options);
+
+  const char* batch_help =
+      "Batch mode:\n"
+      "  Each line of stdin is a job of tab-separated fields:\n"
+      "    imagename outputbase [renderers [VAR=VALUE...]]\n"
+      "  renderers is a comma-separated list of txt, hocr, tsv, json, pdf,\n"
+      "  unlv, box and counters, or empty for those of the configfiles.\n"
+      "  The variables are set for the job only, and must be engine\n"
+      "  variables: global ones are shared by all the engines, so a job\n"
+      "  that sets one fails, and they must be set with -c instead. Lines\n"
+      "  may be at most 4095 bytes long; longer ones fail as a whole. As\n"
+      "  each job completes, a line is written to stdout: ok, outputbase\n"
+      "  and milliseconds, or error, outputbase and the reason,\n"
+      "  tab-separated.\n";
+
+  printf("%s\n", batch_help);
   PrintHelpForPSM();
   PrintHelpForOEM();
 
@@ -228,7 +252,7 @@ void ParseArgs(const int argc, char** argv, const char** lang,
                GenericVector<STRING>* vars_vec,
                GenericVector<STRING>* vars_values, int* arg_i,
                tesseract::PageSegMode* pagesegmode,
-               tesseract::OcrEngineMode* enginemode) {
+               tesseract::OcrEngineMode* enginemode, int* batch_workers) {
   if (argc == 1) {
     PrintHelpMessage(argv[0]);
     exit(0);
@@ -255,7 +279,10 @@ void ParseArgs(const int argc, char** argv, const char** lang,
 
   bool noocr = false;
   int i = 1;
-  while (i < argc && (*outputbase == NULL || argv[i][0] == '-')) {
+  // In batch mode the jobs name the images, so the first argument that is
+  // not an option is a configfile.
+  while (i < argc && ((*outputbase == NULL && *batch_workers == 0) ||
+                      argv[i][0] == '-')) {
     if (strcmp(argv[i], "-l") == 0 && i + 1 < argc) {
       *lang = argv[i + 1];
       ++i;
@@ -284,6 +311,9 @@ void ParseArgs(const int argc, char** argv, const char** lang,
     } else if (strcmp(argv[i], "--oem") == 0 && i + 1 < argc) {
       *enginemode = static_cast<tesseract::OcrEngineMode>(atoi(argv[i + 1]));
       ++i;
+    } else if (strcmp(argv[i], "--batch") == 0 && i + 1 < argc) {
+      *batch_workers = MAX(atoi(argv[i + 1]), 1);
+      ++i;
     } else if (strcmp(argv[i], "--print-parameters") == 0) {
       noocr = true;
       *print_parameters = true;
@@ -305,12 +335,25 @@ void ParseArgs(const int argc, char** argv, const char** lang,
     noocr = true;
   }
 
-  if (*outputbase == NULL && noocr == false) {
+  if (*outputbase == NULL && noocr == false && *batch_workers == 0) {
     PrintHelpMessage(argv[0]);
     exit(1);
   }
 }
 
+// Makes the first of renderers the root of the others.
+void ChainRenderers(
+    tesseract::PointerVector<tesseract::TessResultRenderer>* renderers) {
+  if (!renderers->empty()) {
+    // Since the PointerVector auto-deletes, null-out the renderers that are
+    // added to the root, and leave the root in the vector.
+    for (int r = 1; r < renderers->size(); ++r) {
+      (*renderers)[0]->insert((*renderers)[r]);
+      (*renderers)[r] = NULL;
+    }
+  }
+}
+
 void PreloadRenderers(
     tesseract::TessBaseAPI* api,
     tesseract::PointerVector<tesseract::TessResultRenderer>* renderers,
@@ -335,6 +378,11 @@ void PreloadRenderers(
           new tesseract::TessTsvRenderer(outputbase, font_info));
     }
 
+    api->GetBoolVariable("tessedit_create_json", &b);
+    if (b) {
+      renderers->push_back(new tesseract::TessJsonRenderer(outputbase));
+    }
+
     api->GetBoolVariable("tessedit_create_pdf", &b);
     if (b) {
       renderers->push_back(
@@ -355,18 +403,247 @@ void PreloadRenderers(
     if (b || renderers->empty()) {
       renderers->push_back(new tesseract::TessTextRenderer(outputbase));
     }
+
+    api->GetBoolVariable("tessedit_create_counters", &b);
+    if (b) {
+      renderers->push_back(new tesseract::TessCountersRenderer(outputbase));
+    }
   }
+  ChainRenderers(renderers);
+}
 
-  if (!renderers->empty()) {
-    // Since the PointerVector auto-deletes, null-out the renderers that are
-    // added to the root, and leave the root in the vector.
-    for (int r = 1; r < renderers->size(); ++r) {
-      (*renderers)[0]->insert((*renderers)[r]);
-      (*renderers)[r] = NULL;
+// Returns a new renderer of the given batch mode name, or NULL if there is
+// no such renderer.
+tesseract::TessResultRenderer* NewRendererByName(tesseract::TessBaseAPI* api,
+                                                 const char* name,
+                                                 const char* outputbase) {
+  bool font_info = false;
+  api->GetBoolVariable("hocr_font_info", &font_info);
+  if (strcmp(name, "txt") == 0)
+    return new tesseract::TessTextRenderer(outputbase);
+  if (strcmp(name, "hocr") == 0)
+    return new tesseract::TessHOcrRenderer(outputbase, font_info);
+  if (strcmp(name, "tsv") == 0)
+    return new tesseract::TessTsvRenderer(outputbase, font_info);
+  if (strcmp(name, "json") == 0)
+    return new tesseract::TessJsonRenderer(outputbase);
+  if (strcmp(name, "pdf") == 0)
+    return new tesseract::TessPDFRenderer(outputbase, api->GetDatapath());
+  if (strcmp(name, "unlv") == 0)
+    return new tesseract::TessUnlvRenderer(outputbase);
+  if (strcmp(name, "box") == 0)
+    return new tesseract::TessBoxTextRenderer(outputbase);
+  if (strcmp(name, "counters") == 0)
+    return new tesseract::TessCountersRenderer(outputbase);
+  return NULL;
+}
+
+// Returns true if params has one with the given name.
+template <class T>
+bool HasParam(const GenericVector<T*>& params, const char* name) {
+  for (int i = 0; i < params.size(); ++i) {
+    if (strcmp(params[i]->name_str(), name) == 0) return true;
+  }
+  return false;
+}
+
+// Returns true if name is a global variable, which is shared by all the
+// engines rather than copied into each.
+bool IsGlobalVariable(const char* name) {
+  const tesseract::ParamsVectors* globals = GlobalParams();
+  return HasParam(globals->int_params, name) ||
+         HasParam(globals->bool_params, name) ||
+         HasParam(globals->string_params, name) ||
+         HasParam(globals->double_params, name);
+}
+
+// The engines of batch mode and the streams they share.
+struct BatchContext {
+  BatchContext() : num_failed(0) {}
+
+  // One engine per worker, each used by one thread at a time.
+  GenericVector<tesseract::TessBaseAPI*> engines;
+  // Guards reading the jobs from stdin.
+  tesseract::CCUtilMutex input_mutex;
+  // Guards writing the completions to stdout, and num_failed.
+  tesseract::CCUtilMutex output_mutex;
+  int num_failed;
+};
+
+// Runs the job of a line of stdin on api. Returns false with *error set
+// if it could not.
+bool RunBatchJob(tesseract::TessBaseAPI* api, char* line, STRING* outputbase,
+                 STRING* error) {
+  GenericVector<char*> fields;
+  for (char* field = line; field != NULL;) {
+    char* tab = strchr(field, '\t');
+    if (tab != NULL) *tab++ = '\0';
+    fields.push_back(field);
+    field = tab;
+  }
+  if (fields.size() < 2 || fields[0][0] == '\0' || fields[1][0] == '\0') {
+    *error = "expected imagename and outputbase";
+    return false;
+  }
+  const char* image = fields[0];
+  *outputbase = fields[1];
+  // The jobs and the completions have stdin and stdout.
+  if (strcmp(image, "-") == 0 || strcmp(image, "stdin") == 0 ||
+      strcmp(fields[1], "-") == 0 || strcmp(fields[1], "stdout") == 0) {
+    *error = "stdin and stdout are not available in batch mode";
+    return false;
+  }
+  // Set the variables of the job, keeping the values to restore.
+  GenericVector<STRING> names;
+  GenericVector<STRING> old_values;
+  bool ok = true;
+  for (int f = 3; f < fields.size(); ++f) {
+    char* equals = strchr(fields[f], '=');
+    if (equals == NULL) {
+      *error = "missing = in ";
+      *error += fields[f];
+      ok = false;
+      break;
+    }
+    *equals = '\0';
+    // Setting a global variable for one job would change the jobs running
+    // on the other engines too.
+    if (IsGlobalVariable(fields[f])) {
+      *error = "global variable must be set with -c: ";
+      *error += fields[f];
+      ok = false;
+      break;
+    }
+    STRING old_value;
+    if (!api->GetVariableAsString(fields[f], &old_value) ||
+        !api->SetVariable(fields[f], equals + 1)) {
+      *error = "could not set ";
+      *error += fields[f];
+      ok = false;
+      break;
+    }
+    names.push_back(fields[f]);
+    old_values.push_back(old_value);
+  }
+  if (ok) {
+    tesseract::PointerVector<tesseract::TessResultRenderer> renderers;
+    if (fields.size() < 3 || fields[2][0] == '\0') {
+      PreloadRenderers(api, &renderers, api->GetPageSegMode(), fields[1]);
+    } else {
+      // strtok is not reentrant, and the other workers parse jobs too.
+      for (char* name = fields[2]; name != NULL && ok;) {
+        char* comma = strchr(name, ',');
+        if (comma != NULL) *comma++ = '\0';
+        tesseract::TessResultRenderer* renderer =
+            NewRendererByName(api, name, fields[1]);
+        if (renderer == NULL) {
+          *error = "unknown renderer ";
+          *error += name;
+          ok = false;
+        } else {
+          renderers.push_back(renderer);
+        }
+        name = comma;
+      }
+      ChainRenderers(&renderers);
+    }
+    if (ok) {
+      api->SetOutputName(fields[1]);
+      if (!api->ProcessPages(image, NULL, 0, renderers[0])) {
+        *error = "error during processing";
+        ok = false;
+      }
+    }
+  }
+  for (int v = names.size() - 1; v >= 0; --v)
+    api->SetVariable(names[v].string(), old_values[v].string());
+  return ok;
+}
+
+// Runs the jobs of stdin on the given engine of context until there are no
+// more.
+void RunBatchWorker(BatchContext* context, int engine) {
+  tesseract::TessBaseAPI* api = context->engines[engine];
+  char line[4096];
+  for (;;) {
+    context->input_mutex.Lock();
+    bool have_job = fgets(line, sizeof(line), stdin) != NULL;
+    // A line that does not fit is skipped whole, rather than read as
+    // several jobs. One that only lacks room for its newline fits.
+    bool too_long = false;
+    if (have_job && strchr(line, '\n') == NULL) {
+      int ch = getc(stdin);
+      if (ch != '\n' && ch != EOF) {
+        too_long = true;
+        while (ch != '\n' && ch != EOF) ch = getc(stdin);
+      }
+    }
+    context->input_mutex.Unlock();
+    if (!have_job) break;
+    line[strcspn(line, "\r\n")] = '\0';
+    if (line[0] == '\0' && !too_long) continue;
+    double start = tesseract::StageTimings::NowMillis();
+    STRING outputbase;
+    STRING error;
+    bool ok = false;
+    if (too_long) {
+      error.add_str_int("line longer than the limit of ",
+                        static_cast<int>(sizeof(line)) - 1);
+      error += " bytes";
+    } else {
+      ok = RunBatchJob(api, line, &outputbase, &error);
+    }
+    double msecs = tesseract::StageTimings::NowMillis() - start;
+    context->output_mutex.Lock();
+    if (ok) {
+      printf("ok\t%s\t%.0f\n", outputbase.string(), msecs);
+    } else {
+      printf("error\t%s\t%s\n", outputbase.string(), error.string());
+      ++context->num_failed;
     }
+    fflush(stdout);
+    context->output_mutex.Unlock();
   }
 }
 
+// Runs the jobs of stdin on num_workers engines made like api, which must
+// be initialized, at the same time. Returns the number of jobs that failed,
+// or -1 if the engines could not be made.
+int RunBatch(tesseract::TessBaseAPI* api, int num_workers) {
+  BatchContext context;
+  context.engines.push_back(api);
+  while (context.engines.size() < num_workers) {
+    // The model is loaded once, and the other engines share it through the
+    // library caches.
+    tesseract::TessBaseAPI* engine = new tesseract::TessBaseAPI;
+    if (engine->InitLike(*api) != 0) {
+      delete engine;
+      break;
+    }
+    context.engines.push_back(engine);
+  }
+  int num_engines = context.engines.size();
+  if (num_engines < num_workers) {
+    fprintf(stderr, "Could only initialize %d of %d engines.\n",
+            num_engines, num_workers);
+    for (int e = 1; e < num_engines; ++e) delete context.engines[e];
+    return -1;
+  }
+  // The workers of the loop wait for jobs, so the scheduler needs one for
+  // each engine but the one of this thread.
+  tesseract::TaskScheduler* scheduler = tesseract::TaskScheduler::Get();
+  if (scheduler->num_workers() < num_engines - 1) {
+    tesseract::TaskScheduler::Configure(num_engines - 1, false);
+    scheduler = tesseract::TaskScheduler::Get();
+  }
+  TessCallback1<int>* worker =
+      NewPermanentTessCallback(&RunBatchWorker, &context);
+  scheduler->ParallelFor(num_engines, num_engines, worker, NULL);
+  delete worker;
+  for (int e = 1; e < num_engines; ++e) delete context.engines[e];
+  return context.num_failed;
+}
+
 /**********************************************************************
  *  main()
  *
@@ -382,6 +659,7 @@ int main(int argc, char** argv) {
   int arg_i = 1;
   tesseract::PageSegMode pagesegmode = tesseract::PSM_AUTO;
   tesseract::OcrEngineMode enginemode = tesseract::OEM_DEFAULT;
+  int batch_workers = 0;
   /* main() calls functions like ParseArgs which call exit().
    * This results in memory leaks if vars_vec and vars_values are
    * declared as auto variables (destructor is not called then). */
@@ -400,7 +678,7 @@ int main(int argc, char** argv) {
 
   ParseArgs(argc, argv, &lang, &image, &outputbase, &datapath, &list_langs,
             &print_parameters, &vars_vec, &vars_values, &arg_i, &pagesegmode,
-            &enginemode);
+            &enginemode, &batch_workers);
 
   bool banner = false;
   if (outputbase != NULL && strcmp(outputbase, "-") &&
@@ -437,6 +715,11 @@ int main(int argc, char** argv) {
 
   FixPageSegMode(&api, pagesegmode);
 
+  if (batch_workers > 0) {
+    int num_failed = RunBatch(&api, batch_workers);
+    exit(num_failed == 0 ? 0 : 1);
+  }
+
   if (pagesegmode == tesseract::PSM_AUTO_ONLY) {
     int ret_val = 0;
 
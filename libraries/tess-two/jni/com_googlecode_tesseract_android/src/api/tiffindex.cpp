@@ -0,0 +1,135 @@
+///////////////////////////////////////////////////////////////////////
+// File:        tiffindex.cpp
+// Description: Index of the pages of a multipage TIFF for random access.
+//
+// (C) Copyright 2016, Google Inc.
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////
+
+#include "tiffindex.h"
+
+#include <string.h>
+#include "allheaders.h"
+
+namespace tesseract {
+
+// Returns the unsigned integer of length bytes in the byte order of the file.
+static uinT64 GetValue(const unsigned char* bytes, int length,
+                       bool big_endian) {
+  uinT64 value = 0;
+  for (int i = 0; i < length; ++i) {
+    int b = big_endian ? i : length - 1 - i;
+    value = (value << 8) | bytes[b];
+  }
+  return value;
+}
+
+TiffPageIndex::TiffPageIndex() : data_(NULL), size_(0) {}
+
+bool TiffPageIndex::Open(const char* filename) {
+  filename_ = filename;
+  data_ = NULL;
+  size_ = 0;
+  offsets_.truncate(0);
+  FILE* fp = fopen(filename, "rb");
+  if (fp == NULL) return false;
+  bool result = false;
+  if (fseek(fp, 0, SEEK_END) == 0) {
+    long size = ftell(fp);
+    if (size > 0) {
+      size_ = size;
+      result = Index(fp);
+    }
+  }
+  fclose(fp);
+  return result;
+}
+
+bool TiffPageIndex::Open(const unsigned char* data, size_t size) {
+  filename_ = "";
+  data_ = data;
+  size_ = size;
+  offsets_.truncate(0);
+  return data != NULL && Index(NULL);
+}
+
+Pix* TiffPageIndex::ReadPage(int page) const {
+  if (page < 0 || page >= offsets_.size()) return NULL;
+  size_t offset = Offset(page);
+  return data_ != NULL
+      ? pixReadMemFromMultipageTiff(data_, size_, &offset)
+      : pixReadFromMultipageTiff(filename_.string(), &offset);
+}
+
+bool TiffPageIndex::Index(FILE* fp) {
+  unsigned char bytes[16];
+  if (!ReadAt(fp, 0, 8, bytes)) return false;
+  bool big_endian;
+  if (bytes[0] == 'I' && bytes[1] == 'I')
+    big_endian = false;
+  else if (bytes[0] == 'M' && bytes[1] == 'M')
+    big_endian = true;
+  else
+    return false;
+  int version = GetValue(bytes + 2, 2, big_endian);
+  bool bigtiff = version == 43;
+  if (version != 42 && !bigtiff) return false;
+  uinT64 offset;
+  if (bigtiff) {
+    if (!ReadAt(fp, 0, 16, bytes)) return false;
+    offset = GetValue(bytes + 8, 8, big_endian);
+  } else {
+    offset = GetValue(bytes + 4, 4, big_endian);
+  }
+  // A directory is a count of entries, the entries and the offset of the
+  // next directory.
+  const int count_size = bigtiff ? 8 : 2;
+  const int entry_size = bigtiff ? 20 : 12;
+  const int next_size = bigtiff ? 8 : 4;
+  // A chain that loops back on itself never ends, but a file cannot hold
+  // more directories than this.
+  const uinT64 max_pages = size_ / (count_size + next_size);
+  while (offset != 0) {
+    if (static_cast<uinT64>(offsets_.size()) >= max_pages) {
+      offsets_.truncate(0);
+      return false;
+    }
+    uinT64 count;
+    if (!ReadAt(fp, offset, count_size, bytes) ||
+        (count = GetValue(bytes, count_size, big_endian)) > size_) {
+      break;
+    }
+    offsets_.push_back(offset);
+    // As libtiff does, the pages before a broken link are kept.
+    if (!ReadAt(fp, offset + count_size + count * entry_size, next_size,
+                bytes)) {
+      break;
+    }
+    offset = GetValue(bytes, next_size, big_endian);
+  }
+  return !offsets_.empty();
+}
+
+bool TiffPageIndex::ReadAt(FILE* fp, inT64 offset, int length,
+                           unsigned char* buffer) const {
+  if (offset < 0 || static_cast<uinT64>(offset) + length > size_)
+    return false;
+  if (fp == NULL) {
+    memcpy(buffer, data_ + offset, length);
+    return true;
+  }
+  return offset <= MAX_INT32 && fseek(fp, static_cast<long>(offset),
+                                      SEEK_SET) == 0 &&
+         fread(buffer, 1, length, fp) == static_cast<size_t>(length);
+}
+
+}  // namespace tesseract
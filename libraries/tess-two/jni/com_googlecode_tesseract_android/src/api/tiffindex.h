@@ -0,0 +1,71 @@
+///////////////////////////////////////////////////////////////////////
+// File:        tiffindex.h
+// Description: Index of the pages of a multipage TIFF for random access.
+//
+// (C) Copyright 2016, Google Inc.
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////
+
+#ifndef TESSERACT_API_TIFFINDEX_H_
+#define TESSERACT_API_TIFFINDEX_H_
+
+#include <stdio.h>
+#include "genericvector.h"
+#include "strngs.h"
+
+struct Pix;
+
+namespace tesseract {
+
+// The offsets of the image file directories of a TIFF, one per page, found
+// once by following the chain of directories without decoding any image.
+// Any page can then be read directly, where pixReadFromMultipageTiff and
+// pixReadMemFromMultipageTiff only give the offset of the page after the
+// one they decode. Classic and BigTIFF files are both understood.
+class TiffPageIndex {
+ public:
+  TiffPageIndex();
+
+  // Indexes the TIFF file filename. Returns false if it is not a TIFF or
+  // its directories cannot be read.
+  bool Open(const char* filename);
+  // Indexes the TIFF of size bytes at data, which must outlive *this.
+  bool Open(const unsigned char* data, size_t size);
+
+  int NumPages() const { return offsets_.size(); }
+  // Returns the offset of the given page, in the form that the offset
+  // argument of pixReadFromMultipageTiff expects.
+  size_t Offset(int page) const {
+    return page == 0 ? 0 : static_cast<size_t>(offsets_[page]);
+  }
+  // Decodes the given page. Must be pixDestroyed after use. Returns NULL
+  // on error. As each call reads on its own, several threads may read
+  // pages at once.
+  Pix* ReadPage(int page) const;
+
+ private:
+  // Follows the chain of directories from the header, reading from fp if
+  // it is not NULL and from data_ otherwise.
+  bool Index(FILE* fp);
+  // Reads length bytes at offset into buffer. Returns false if they are
+  // not all there.
+  bool ReadAt(FILE* fp, inT64 offset, int length, unsigned char* buffer) const;
+
+  STRING filename_;
+  const unsigned char* data_;
+  size_t size_;
+  GenericVector<inT64> offsets_;
+};
+
+}  // namespace tesseract
+
+#endif  // TESSERACT_API_TIFFINDEX_H_
@@ -0,0 +1,78 @@
+///////////////////////////////////////////////////////////////////////
+// File:        classpruneravx2.cpp
+// Description: AVX2 class pruner kernel.
+//
+// (C) Copyright 2017, Google Inc.
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+///////////////////////////////////////////////////////////////////////
+
+#include "classprunersimd.h"
+
+#if defined(__i386__) || defined(__x86_64__)
+#include <immintrin.h>
+// Compiled for AVX2 per function, so the rest of the library keeps the
+// baseline ABI and this is only called when SIMDDetect finds AVX2.
+#define AVX2_TARGET __attribute__((target("avx2")))
+#endif
+
+namespace tesseract {
+
+#ifdef AVX2_TARGET
+
+// The 32 counts of a pruner are kept in 4 registers of 8 lanes while all the
+// features are added, and only written to class_counts at the end.
+AVX2_TARGET int ClassPrunerScoresAVX2(const uinT32* const* pruners,
+                                      int num_pruners, const int* offsets,
+                                      int num_features, int* class_counts) {
+  const __m256i mask = _mm256_set1_epi32(3);
+  // Lane i of the low/high half moves the weight of class i/i + 8 of a word
+  // to the bottom bits.
+  const __m256i low_shifts = _mm256_setr_epi32(0, 2, 4, 6, 8, 10, 12, 14);
+  const __m256i high_shifts =
+      _mm256_setr_epi32(16, 18, 20, 22, 24, 26, 28, 30);
+  for (int p = 0; p < num_pruners; ++p) {
+    const uinT32* pruner = pruners[p];
+    __m256i sums[4];
+    for (int i = 0; i < 4; ++i) sums[i] = _mm256_setzero_si256();
+    for (int f = 0; f < num_features; ++f) {
+      const uinT32* bucket = pruner + offsets[f];
+      for (int w = 0; w < kClassPrunerWordsPerBucket; ++w) {
+        __m256i v = _mm256_set1_epi32(bucket[w]);
+        sums[2 * w] = _mm256_add_epi32(
+            sums[2 * w], _mm256_and_si256(_mm256_srlv_epi32(v, low_shifts),
+                                          mask));
+        sums[2 * w + 1] = _mm256_add_epi32(
+            sums[2 * w + 1],
+            _mm256_and_si256(_mm256_srlv_epi32(v, high_shifts), mask));
+      }
+    }
+    __m256i* counts =
+        reinterpret_cast<__m256i*>(class_counts + p * kClassPrunerClasses);
+    for (int i = 0; i < 4; ++i) {
+      _mm256_storeu_si256(
+          counts + i, _mm256_add_epi32(_mm256_loadu_si256(counts + i),
+                                       sums[i]));
+    }
+  }
+  return num_pruners;
+}
+
+#else  // AVX2_TARGET
+
+int ClassPrunerScoresAVX2(const uinT32* const* pruners, int num_pruners,
+                          const int* offsets, int num_features,
+                          int* class_counts) {
+  return 0;
+}
+
+#endif  // AVX2_TARGET
+
+}  // namespace tesseract
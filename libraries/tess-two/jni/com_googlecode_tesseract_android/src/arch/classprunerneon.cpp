@@ -0,0 +1,79 @@
+///////////////////////////////////////////////////////////////////////
+// File:        classprunerneon.cpp
+// Description: NEON class pruner kernel.
+//
+// (C) Copyright 2017, Google Inc.
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+///////////////////////////////////////////////////////////////////////
+
+#include "classprunersimd.h"
+
+#if defined(__aarch64__) || defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define NEON_BUILD 1
+#include <arm_neon.h>
+#endif
+
+namespace tesseract {
+
+#ifdef NEON_BUILD
+
+// Right shifts, as negative left shifts, that move the weight of class
+// 4g + i of a word to the bottom bits of lane i.
+static const int32_t kGroupShifts[4][4] = {
+  { 0, -2, -4, -6 },
+  { -8, -10, -12, -14 },
+  { -16, -18, -20, -22 },
+  { -24, -26, -28, -30 }
+};
+
+// The 32 counts of a pruner are kept in 8 registers of 4 lanes while all the
+// features are added, and only written to class_counts at the end.
+int ClassPrunerScoresNEON(const uinT32* const* pruners, int num_pruners,
+                          const int* offsets, int num_features,
+                          int* class_counts) {
+  const uint32x4_t mask = vdupq_n_u32(3);
+  int32x4_t shifts[4];
+  for (int g = 0; g < 4; ++g) shifts[g] = vld1q_s32(kGroupShifts[g]);
+  for (int p = 0; p < num_pruners; ++p) {
+    const uinT32* pruner = pruners[p];
+    uint32x4_t sums[8];
+    for (int i = 0; i < 8; ++i) sums[i] = vdupq_n_u32(0);
+    for (int f = 0; f < num_features; ++f) {
+      const uinT32* bucket = pruner + offsets[f];
+      for (int w = 0; w < kClassPrunerWordsPerBucket; ++w) {
+        uint32x4_t v = vdupq_n_u32(bucket[w]);
+        for (int g = 0; g < 4; ++g) {
+          sums[4 * w + g] = vaddq_u32(
+              sums[4 * w + g], vandq_u32(vshlq_u32(v, shifts[g]), mask));
+        }
+      }
+    }
+    int32_t* counts = class_counts + p * kClassPrunerClasses;
+    for (int i = 0; i < 8; ++i) {
+      vst1q_s32(counts + 4 * i,
+                vaddq_s32(vld1q_s32(counts + 4 * i),
+                          vreinterpretq_s32_u32(sums[i])));
+    }
+  }
+  return num_pruners;
+}
+
+#else  // NEON_BUILD
+
+int ClassPrunerScoresNEON(const uinT32* const* pruners, int num_pruners,
+                          const int* offsets, int num_features,
+                          int* class_counts) {
+  return 0;
+}
+
+#endif  // NEON_BUILD
+
+}  // namespace tesseract
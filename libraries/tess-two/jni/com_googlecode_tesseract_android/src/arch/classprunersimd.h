@@ -0,0 +1,56 @@
+///////////////////////////////////////////////////////////////////////
+// File:        classprunersimd.h
+// Description: SIMD kernels that sum the class pruner weights of the
+//              features of a blob.
+//
+// (C) Copyright 2017, Google Inc.
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+///////////////////////////////////////////////////////////////////////
+
+#ifndef TESSERACT_ARCH_CLASSPRUNERSIMD_H_
+#define TESSERACT_ARCH_CLASSPRUNERSIMD_H_
+
+#include "host.h"
+
+namespace tesseract {
+
+// Number of classes covered by one class pruner, and of weights in each of
+// the kClassPrunerWordsPerBucket words of one of its buckets.
+const int kClassPrunerClasses = 32;
+const int kClassPrunerWordsPerBucket = 2;
+const int kClassPrunerClassesPerWord = 16;
+
+// The kernels below add up the weights of a blob's features in the same way
+// as the scalar loop in ClassPruner::ComputeScores, giving identical counts.
+// pruners[p] points to the first word of class pruner p, which covers the
+// classes [32p, 32p + 32). offsets[f] is the index, in every pruner, of the
+// two words of the bucket that feature f falls in. Word w of a bucket holds
+// the 2 bit weight of class 16w + i in bits 2i and 2i + 1.
+// For each pruner, the sum over all the features of each class weight is
+// added to class_counts[32p + i]. Kernels return the number of pruners they
+// handled, starting from the first. Kernels that are not compiled for the
+// current architecture handle none and return 0.
+typedef int (*ClassPrunerScoresFunc)(const uinT32* const* pruners,
+                                     int num_pruners, const int* offsets,
+                                     int num_features, int* class_counts);
+int ClassPrunerScoresSSE2(const uinT32* const* pruners, int num_pruners,
+                          const int* offsets, int num_features,
+                          int* class_counts);
+int ClassPrunerScoresAVX2(const uinT32* const* pruners, int num_pruners,
+                          const int* offsets, int num_features,
+                          int* class_counts);
+int ClassPrunerScoresNEON(const uinT32* const* pruners, int num_pruners,
+                          const int* offsets, int num_features,
+                          int* class_counts);
+
+}  // namespace tesseract
+
+#endif  // TESSERACT_ARCH_CLASSPRUNERSIMD_H_
@@ -0,0 +1,76 @@
+///////////////////////////////////////////////////////////////////////
+// File:        classprunersse.cpp
+// Description: SSE2 class pruner kernel.
+//
+// (C) Copyright 2017, Google Inc.
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+///////////////////////////////////////////////////////////////////////
+
+#include "classprunersimd.h"
+
+#if defined(__i386__) || defined(__x86_64__)
+#include <emmintrin.h>
+#define SSE2_TARGET __attribute__((target("sse2")))
+#endif
+
+namespace tesseract {
+
+#ifdef SSE2_TARGET
+
+// The 32 counts of a pruner are kept in 8 registers of 4 lanes while all the
+// features are added, and only written to class_counts at the end.
+SSE2_TARGET int ClassPrunerScoresSSE2(const uinT32* const* pruners,
+                                      int num_pruners, const int* offsets,
+                                      int num_features, int* class_counts) {
+  const __m128i mask = _mm_set1_epi32(3);
+  for (int p = 0; p < num_pruners; ++p) {
+    const uinT32* pruner = pruners[p];
+    __m128i sums[8];
+    for (int i = 0; i < 8; ++i) sums[i] = _mm_setzero_si128();
+    for (int f = 0; f < num_features; ++f) {
+      const uinT32* bucket = pruner + offsets[f];
+      for (int w = 0; w < kClassPrunerWordsPerBucket; ++w) {
+        uinT32 word = bucket[w];
+        // Lane i holds the word shifted right by 2i, so the weight of class
+        // 4g + i of the word is in the bottom bits of lane i after a further
+        // shift by 8g.
+        __m128i v = _mm_set_epi32(word >> 6, word >> 4, word >> 2, word);
+        __m128i* word_sums = sums + 4 * w;
+        word_sums[0] = _mm_add_epi32(word_sums[0], _mm_and_si128(v, mask));
+        word_sums[1] = _mm_add_epi32(
+            word_sums[1], _mm_and_si128(_mm_srli_epi32(v, 8), mask));
+        word_sums[2] = _mm_add_epi32(
+            word_sums[2], _mm_and_si128(_mm_srli_epi32(v, 16), mask));
+        word_sums[3] = _mm_add_epi32(
+            word_sums[3], _mm_and_si128(_mm_srli_epi32(v, 24), mask));
+      }
+    }
+    __m128i* counts =
+        reinterpret_cast<__m128i*>(class_counts + p * kClassPrunerClasses);
+    for (int i = 0; i < 8; ++i) {
+      _mm_storeu_si128(counts + i,
+                       _mm_add_epi32(_mm_loadu_si128(counts + i), sums[i]));
+    }
+  }
+  return num_pruners;
+}
+
+#else  // SSE2_TARGET
+
+int ClassPrunerScoresSSE2(const uinT32* const* pruners, int num_pruners,
+                          const int* offsets, int num_features,
+                          int* class_counts) {
+  return 0;
+}
+
+#endif  // SSE2_TARGET
+
+}  // namespace tesseract
@@ -0,0 +1,62 @@
+///////////////////////////////////////////////////////////////////////
+// File:        dawgneon.cpp
+// Description: NEON dawg child search kernel.
+//
+// (C) Copyright 2017, Google Inc.
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+///////////////////////////////////////////////////////////////////////
+
+#include "dawgsimd.h"
+
+#if defined(__aarch64__) || defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define NEON_BUILD 1
+#include <arm_neon.h>
+#endif
+
+namespace tesseract {
+
+#ifdef NEON_BUILD
+
+bool FindEdgeKeyNEON(const uinT32* keys, int count, uinT32 mask,
+                     uinT32 target, int* index) {
+  const uint32x4_t mask_v = vdupq_n_u32(mask);
+  const uint32x4_t target_v = vdupq_n_u32(target);
+  for (int i = 0; i < count; i += 4) {
+    uint32x4_t eq = vceqq_u32(vandq_u32(vld1q_u32(keys + i), mask_v),
+                              target_v);
+    // Narrow each lane to 16 bits so that the 4 results fit in 64.
+    uint64_t bits = vget_lane_u64(vreinterpret_u64_u16(vmovn_u32(eq)), 0);
+    // Lanes past count belong to the next node.
+    if (count - i < 4) bits &= (1ULL << (16 * (count - i))) - 1;
+    if (bits != 0) {
+      int lane = 0;
+      while ((bits & 0xffff) == 0) {
+        bits >>= 16;
+        ++lane;
+      }
+      *index = i + lane;
+      return true;
+    }
+  }
+  *index = -1;
+  return true;
+}
+
+#else  // NEON_BUILD
+
+bool FindEdgeKeyNEON(const uinT32* keys, int count, uinT32 mask,
+                     uinT32 target, int* index) {
+  return false;
+}
+
+#endif  // NEON_BUILD
+
+}  // namespace tesseract
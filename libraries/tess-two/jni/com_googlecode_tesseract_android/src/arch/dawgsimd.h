@@ -0,0 +1,42 @@
+///////////////////////////////////////////////////////////////////////
+// File:        dawgsimd.h
+// Description: SIMD kernels for finding the child of a dawg node.
+//
+// (C) Copyright 2017, Google Inc.
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+///////////////////////////////////////////////////////////////////////
+
+#ifndef TESSERACT_ARCH_DAWGSIMD_H_
+#define TESSERACT_ARCH_DAWGSIMD_H_
+
+#include "host.h"
+
+namespace tesseract {
+
+// Number of keys that the kernels may read past the end of a node, which
+// the owner of the keys must pad the array with.
+const int kDawgEdgeKeyPadding = 3;
+
+// Sets *index to the first i < count for which (keys[i] & mask) == target,
+// or to -1 if there is none, as the scalar loop in SquishedDawg would.
+// keys[count + kDawgEdgeKeyPadding - 1] must be readable. Returns false,
+// having set nothing, if not compiled for the current architecture, in which
+// case the caller must use the scalar loop.
+typedef bool (*EdgeKeySearchFunc)(const uinT32* keys, int count, uinT32 mask,
+                                  uinT32 target, int* index);
+bool FindEdgeKeySSE2(const uinT32* keys, int count, uinT32 mask,
+                     uinT32 target, int* index);
+bool FindEdgeKeyNEON(const uinT32* keys, int count, uinT32 mask,
+                     uinT32 target, int* index);
+
+}  // namespace tesseract
+
+#endif  // TESSERACT_ARCH_DAWGSIMD_H_
@@ -0,0 +1,58 @@
+///////////////////////////////////////////////////////////////////////
+// File:        dawgsse.cpp
+// Description: SSE2 dawg child search kernel.
+//
+// (C) Copyright 2017, Google Inc.
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+///////////////////////////////////////////////////////////////////////
+
+#include "dawgsimd.h"
+
+#if defined(__i386__) || defined(__x86_64__)
+#include <emmintrin.h>
+#define SSE2_TARGET __attribute__((target("sse2")))
+#endif
+
+namespace tesseract {
+
+#ifdef SSE2_TARGET
+
+SSE2_TARGET bool FindEdgeKeySSE2(const uinT32* keys, int count, uinT32 mask,
+                                 uinT32 target, int* index) {
+  const __m128i mask_v = _mm_set1_epi32(static_cast<int>(mask));
+  const __m128i target_v = _mm_set1_epi32(static_cast<int>(target));
+  for (int i = 0; i < count; i += 4) {
+    __m128i k = _mm_loadu_si128(reinterpret_cast<const __m128i*>(keys + i));
+    __m128i eq = _mm_cmpeq_epi32(_mm_and_si128(k, mask_v), target_v);
+    int bits = _mm_movemask_ps(_mm_castsi128_ps(eq));
+    // Lanes past count belong to the next node.
+    if (count - i < 4) bits &= (1 << (count - i)) - 1;
+    if (bits != 0) {
+      int lane = 0;
+      while ((bits & (1 << lane)) == 0) ++lane;
+      *index = i + lane;
+      return true;
+    }
+  }
+  *index = -1;
+  return true;
+}
+
+#else  // SSE2_TARGET
+
+bool FindEdgeKeySSE2(const uinT32* keys, int count, uinT32 mask,
+                     uinT32 target, int* index) {
+  return false;
+}
+
+#endif  // SSE2_TARGET
+
+}  // namespace tesseract
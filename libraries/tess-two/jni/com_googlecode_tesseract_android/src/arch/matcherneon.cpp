@@ -0,0 +1,103 @@
+///////////////////////////////////////////////////////////////////////
+// File:        matcherneon.cpp
+// Description: NEON integer matcher evidence kernels.
+//
+// (C) Copyright 2017, Google Inc.
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+///////////////////////////////////////////////////////////////////////
+
+#include "matchersimd.h"
+
+#if defined(__aarch64__) || defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define NEON_BUILD 1
+#include <arm_neon.h>
+#endif
+
+namespace tesseract {
+
+#ifdef NEON_BUILD
+
+static const uinT8 kConfigBits[16] = {
+  1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128
+};
+static const uinT8 kLaneIndex[24] = {
+  0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11,
+  12, 13, 14, 15, 16, 17, 18, 19, 20, 21, 22, 23
+};
+
+bool UpdateProtoEvidenceNEON(uinT32 config_word, uinT8 evidence, int length,
+                             uinT8* config_evidence, uinT8* proto_evidence) {
+  if (length > kProtoEvidenceLength) return false;
+  const uint8x16_t ev = vdupq_n_u8(evidence);
+
+  // Spread each bit of the config word over a byte, so that configs can be
+  // raised to the evidence with one max per 16 configs.
+  const uint8x16_t bits = vld1q_u8(kConfigBits);
+  for (int i = 0; i < 2; ++i) {
+    uint8x16_t bytes =
+        vcombine_u8(vdup_n_u8((config_word >> (16 * i)) & 0xff),
+                    vdup_n_u8((config_word >> (16 * i + 8)) & 0xff));
+    uint8x16_t mask = vtstq_u8(bytes, bits);
+    uinT8* config_ptr = config_evidence + 16 * i;
+    vst1q_u8(config_ptr, vmaxq_u8(vld1q_u8(config_ptr), vandq_u8(mask, ev)));
+  }
+
+  // Inserting into a decreasing list is the same as taking, for each entry,
+  // max(entry, min(previous entry, evidence)), with +infinity before the
+  // first entry.
+  uint8x16_t lo = vld1q_u8(proto_evidence);
+  uint8x8_t hi = vld1_u8(proto_evidence + 16);
+  uint8x16_t prev_lo = vextq_u8(vdupq_n_u8(0xff), lo, 15);
+  uint8x8_t prev_hi = vext_u8(vget_high_u8(lo), hi, 7);
+  uint8x16_t new_lo = vmaxq_u8(lo, vminq_u8(prev_lo, ev));
+  uint8x8_t new_hi = vmax_u8(hi, vmin_u8(prev_hi, vget_low_u8(ev)));
+  uint8x16_t len = vdupq_n_u8(static_cast<uinT8>(length));
+  uint8x16_t lo_mask = vcltq_u8(vld1q_u8(kLaneIndex), len);
+  uint8x8_t hi_mask = vclt_u8(vld1_u8(kLaneIndex + 16), vget_low_u8(len));
+  vst1q_u8(proto_evidence, vbslq_u8(lo_mask, new_lo, lo));
+  vst1_u8(proto_evidence + 16, vbsl_u8(hi_mask, new_hi, hi));
+  return true;
+}
+
+bool SumProtoEvidenceNEON(const uinT8* proto_evidence, const uinT8* lengths,
+                          int num_protos, int* sums) {
+  if (!ProtoLengthsFit(lengths, num_protos)) return false;
+  const uint8x16_t lo_index = vld1q_u8(kLaneIndex);
+  const uint8x8_t hi_index = vld1_u8(kLaneIndex + 16);
+  for (int p = 0; p < num_protos; ++p) {
+    const uinT8* row = proto_evidence + p * kProtoEvidenceLength;
+    uint8x16_t len = vdupq_n_u8(lengths[p]);
+    uint8x16_t lo = vandq_u8(vld1q_u8(row), vcltq_u8(lo_index, len));
+    uint8x8_t hi = vand_u8(vld1_u8(row + 16),
+                           vclt_u8(hi_index, vget_low_u8(len)));
+    uint16x8_t sum16 = vaddw_u8(vpaddlq_u8(lo), hi);
+    uint64x2_t sum64 = vpaddlq_u32(vpaddlq_u16(sum16));
+    sums[p] = static_cast<int>(vgetq_lane_u64(sum64, 0) +
+                               vgetq_lane_u64(sum64, 1));
+  }
+  return true;
+}
+
+#else  // NEON_BUILD
+
+bool UpdateProtoEvidenceNEON(uinT32 config_word, uinT8 evidence, int length,
+                             uinT8* config_evidence, uinT8* proto_evidence) {
+  return false;
+}
+
+bool SumProtoEvidenceNEON(const uinT8* proto_evidence, const uinT8* lengths,
+                          int num_protos, int* sums) {
+  return false;
+}
+
+#endif  // NEON_BUILD
+
+}  // namespace tesseract
@@ -0,0 +1,70 @@
+///////////////////////////////////////////////////////////////////////
+// File:        matchersimd.h
+// Description: SIMD kernels for the proto and config evidence tables of
+//              the integer matcher.
+//
+// (C) Copyright 2017, Google Inc.
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+///////////////////////////////////////////////////////////////////////
+
+#ifndef TESSERACT_ARCH_MATCHERSIMD_H_
+#define TESSERACT_ARCH_MATCHERSIMD_H_
+
+#include "host.h"
+
+namespace tesseract {
+
+// Number of bytes in a row of proto evidence, and of config evidence bytes
+// that one config word covers.
+const int kProtoEvidenceLength = 24;
+const int kConfigEvidenceLength = 32;
+
+// The kernels below give exactly the same tables as the scalar loops in
+// IntegerMatcher::UpdateTablesForFeature and
+// ScratchEvidence::UpdateSumOfProtoEvidences. Each returns false, having
+// changed nothing, if it cannot handle its input (a proto longer than
+// kProtoEvidenceLength) or is not compiled for the current architecture, in
+// which case the caller must use the scalar code.
+
+// Records the evidence of one feature for one proto. config_evidence[c]
+// becomes at least evidence for every bit c set in config_word, and evidence
+// is inserted into the first length bytes of proto_evidence, which are in
+// decreasing order, so the smallest of them drops out.
+typedef bool (*ProtoEvidenceFunc)(uinT32 config_word, uinT8 evidence,
+                                  int length, uinT8* config_evidence,
+                                  uinT8* proto_evidence);
+bool UpdateProtoEvidenceSSE2(uinT32 config_word, uinT8 evidence, int length,
+                             uinT8* config_evidence, uinT8* proto_evidence);
+bool UpdateProtoEvidenceNEON(uinT32 config_word, uinT8 evidence, int length,
+                             uinT8* config_evidence, uinT8* proto_evidence);
+
+// Sets sums[p] to the sum of the first lengths[p] bytes of row p of
+// proto_evidence, for each of the num_protos rows, which are
+// kProtoEvidenceLength bytes apart.
+typedef bool (*ProtoEvidenceSumFunc)(const uinT8* proto_evidence,
+                                     const uinT8* lengths, int num_protos,
+                                     int* sums);
+bool SumProtoEvidenceSSE2(const uinT8* proto_evidence, const uinT8* lengths,
+                          int num_protos, int* sums);
+bool SumProtoEvidenceNEON(const uinT8* proto_evidence, const uinT8* lengths,
+                          int num_protos, int* sums);
+
+// Returns true if all num_protos lengths fit in a row.
+inline bool ProtoLengthsFit(const uinT8* lengths, int num_protos) {
+  for (int p = 0; p < num_protos; ++p) {
+    if (lengths[p] > kProtoEvidenceLength) return false;
+  }
+  return true;
+}
+
+}  // namespace tesseract
+
+#endif  // TESSERACT_ARCH_MATCHERSIMD_H_
@@ -0,0 +1,122 @@
+///////////////////////////////////////////////////////////////////////
+// File:        matchersse.cpp
+// Description: SSE2 integer matcher evidence kernels.
+//
+// (C) Copyright 2017, Google Inc.
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+///////////////////////////////////////////////////////////////////////
+
+#include "matchersimd.h"
+
+#if defined(__i386__) || defined(__x86_64__)
+#include <emmintrin.h>
+#define SSE2_TARGET __attribute__((target("sse2")))
+#endif
+
+namespace tesseract {
+
+#ifdef SSE2_TARGET
+
+// Returns a mask of the lanes of a row of proto evidence, split into the
+// first 16 bytes and the last 8, that are below length.
+SSE2_TARGET static inline void LengthMasks(int length, __m128i* lo_mask,
+                                           __m128i* hi_mask) {
+  const __m128i lo_index = _mm_setr_epi8(0, 1, 2, 3, 4, 5, 6, 7,
+                                         8, 9, 10, 11, 12, 13, 14, 15);
+  const __m128i hi_index = _mm_setr_epi8(16, 17, 18, 19, 20, 21, 22, 23,
+                                         24, 25, 26, 27, 28, 29, 30, 31);
+  const __m128i len = _mm_set1_epi8(static_cast<char>(length));
+  *lo_mask = _mm_cmpgt_epi8(len, lo_index);
+  *hi_mask = _mm_cmpgt_epi8(len, hi_index);
+}
+
+SSE2_TARGET bool UpdateProtoEvidenceSSE2(uinT32 config_word, uinT8 evidence,
+                                         int length, uinT8* config_evidence,
+                                         uinT8* proto_evidence) {
+  if (length > kProtoEvidenceLength) return false;
+  const __m128i ev = _mm_set1_epi8(static_cast<char>(evidence));
+
+  // Spread each bit of the config word over a byte, so that configs can be
+  // raised to the evidence with one max per 16 configs.
+  const __m128i bits = _mm_setr_epi8(1, 2, 4, 8, 16, 32, 64, -128,
+                                     1, 2, 4, 8, 16, 32, 64, -128);
+  __m128i bytes = _mm_cvtsi32_si128(static_cast<int>(config_word));
+  bytes = _mm_unpacklo_epi8(bytes, bytes);
+  bytes = _mm_unpacklo_epi16(bytes, bytes);
+  __m128i configs[2] = {
+    _mm_unpacklo_epi32(bytes, bytes), _mm_unpackhi_epi32(bytes, bytes)
+  };
+  __m128i* config_ptr = reinterpret_cast<__m128i*>(config_evidence);
+  for (int i = 0; i < 2; ++i) {
+    __m128i mask = _mm_cmpeq_epi8(_mm_and_si128(configs[i], bits), bits);
+    __m128i old_value = _mm_loadu_si128(config_ptr + i);
+    _mm_storeu_si128(config_ptr + i,
+                     _mm_max_epu8(old_value, _mm_and_si128(mask, ev)));
+  }
+
+  // Inserting into a decreasing list is the same as taking, for each entry,
+  // max(entry, min(previous entry, evidence)), with +infinity before the
+  // first entry.
+  __m128i lo = _mm_loadu_si128(reinterpret_cast<__m128i*>(proto_evidence));
+  __m128i hi = _mm_loadl_epi64(
+      reinterpret_cast<__m128i*>(proto_evidence + 16));
+  __m128i prev_lo = _mm_or_si128(_mm_slli_si128(lo, 1),
+                                 _mm_cvtsi32_si128(0xff));
+  __m128i prev_hi = _mm_or_si128(_mm_slli_si128(hi, 1),
+                                 _mm_srli_si128(lo, 15));
+  __m128i new_lo = _mm_max_epu8(lo, _mm_min_epu8(prev_lo, ev));
+  __m128i new_hi = _mm_max_epu8(hi, _mm_min_epu8(prev_hi, ev));
+  __m128i lo_mask, hi_mask;
+  LengthMasks(length, &lo_mask, &hi_mask);
+  new_lo = _mm_or_si128(_mm_and_si128(lo_mask, new_lo),
+                        _mm_andnot_si128(lo_mask, lo));
+  new_hi = _mm_or_si128(_mm_and_si128(hi_mask, new_hi),
+                        _mm_andnot_si128(hi_mask, hi));
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(proto_evidence), new_lo);
+  _mm_storel_epi64(reinterpret_cast<__m128i*>(proto_evidence + 16), new_hi);
+  return true;
+}
+
+SSE2_TARGET bool SumProtoEvidenceSSE2(const uinT8* proto_evidence,
+                                      const uinT8* lengths, int num_protos,
+                                      int* sums) {
+  if (!ProtoLengthsFit(lengths, num_protos)) return false;
+  const __m128i zero = _mm_setzero_si128();
+  for (int p = 0; p < num_protos; ++p) {
+    const uinT8* row = proto_evidence + p * kProtoEvidenceLength;
+    __m128i lo_mask, hi_mask;
+    LengthMasks(lengths[p], &lo_mask, &hi_mask);
+    __m128i lo = _mm_and_si128(
+        lo_mask, _mm_loadu_si128(reinterpret_cast<const __m128i*>(row)));
+    __m128i hi = _mm_and_si128(
+        hi_mask, _mm_loadl_epi64(reinterpret_cast<const __m128i*>(row + 16)));
+    // Sum of absolute differences with zero adds up each group of 8 bytes.
+    __m128i sum = _mm_add_epi64(_mm_sad_epu8(lo, zero), _mm_sad_epu8(hi, zero));
+    sums[p] = _mm_cvtsi128_si32(sum) + _mm_cvtsi128_si32(_mm_srli_si128(sum, 8));
+  }
+  return true;
+}
+
+#else  // SSE2_TARGET
+
+bool UpdateProtoEvidenceSSE2(uinT32 config_word, uinT8 evidence, int length,
+                             uinT8* config_evidence, uinT8* proto_evidence) {
+  return false;
+}
+
+bool SumProtoEvidenceSSE2(const uinT8* proto_evidence, const uinT8* lengths,
+                          int num_protos, int* sums) {
+  return false;
+}
+
+#endif  // SSE2_TARGET
+
+}  // namespace tesseract
@@ -0,0 +1,84 @@
+///////////////////////////////////////////////////////////////////////
+// File:        morphavx2.cpp
+// Description: AVX2 row kernels for binary brick morphology.
+//
+// (C) Copyright 2017, Google Inc.
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+///////////////////////////////////////////////////////////////////////
+
+#include "morphsimd.h"
+
+#if defined(__i386__) || defined(__x86_64__)
+#include <immintrin.h>
+// Compiled for AVX2 per function, so the rest of the library keeps the
+// baseline ABI and these are only called when SIMDDetect finds AVX2.
+#define AVX2_TARGET __attribute__((target("avx2")))
+#endif
+
+namespace tesseract {
+
+#ifdef AVX2_TARGET
+
+// Combines 8 words with OR, or with AND if erode.
+AVX2_TARGET static inline __m256i Combine(__m256i a, __m256i b, bool erode) {
+  return erode ? _mm256_and_si256(a, b) : _mm256_or_si256(a, b);
+}
+
+AVX2_TARGET int CombineRowsAVX2(const uinT32* a, const uinT32* b, int words,
+                                bool erode, uinT32* dst) {
+  int n = words & ~7;
+  for (int i = 0; i < n; i += 8) {
+    __m256i va = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+    __m256i vb = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i),
+                        Combine(va, vb, erode));
+  }
+  return n;
+}
+
+AVX2_TARGET int CombineShiftedRowAVX2(const uinT32* a, const uinT32* b,
+                                      int shift, int words, bool erode,
+                                      uinT32* dst) {
+  // Shifts by 32 or more give 0, so a shift of 0 needs no special case.
+  const __m128i left = _mm_cvtsi32_si128(shift);
+  const __m128i right = _mm_cvtsi32_si128(32 - shift);
+  int n = words & ~7;
+  for (int i = 0; i < n; i += 8) {
+    __m256i lo =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i));
+    __m256i hi =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i + 1));
+    __m256i s = _mm256_or_si256(_mm256_sll_epi32(lo, left),
+                                _mm256_srl_epi32(hi, right));
+    if (a != NULL) {
+      __m256i va = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+      s = Combine(va, s, erode);
+    }
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), s);
+  }
+  return n;
+}
+
+#else  // AVX2_TARGET
+
+int CombineRowsAVX2(const uinT32* a, const uinT32* b, int words, bool erode,
+                    uinT32* dst) {
+  return 0;
+}
+
+int CombineShiftedRowAVX2(const uinT32* a, const uinT32* b, int shift,
+                          int words, bool erode, uinT32* dst) {
+  return 0;
+}
+
+#endif  // AVX2_TARGET
+
+}  // namespace tesseract
@@ -0,0 +1,72 @@
+///////////////////////////////////////////////////////////////////////
+// File:        morphneon.cpp
+// Description: NEON row kernels for binary brick morphology.
+//
+// (C) Copyright 2017, Google Inc.
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+///////////////////////////////////////////////////////////////////////
+
+#include "morphsimd.h"
+
+#if defined(__aarch64__) || defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define NEON_BUILD 1
+#include <arm_neon.h>
+#endif
+
+namespace tesseract {
+
+#ifdef NEON_BUILD
+
+// Combines 4 words with OR, or with AND if erode.
+static inline uint32x4_t Combine(uint32x4_t a, uint32x4_t b, bool erode) {
+  return erode ? vandq_u32(a, b) : vorrq_u32(a, b);
+}
+
+int CombineRowsNEON(const uinT32* a, const uinT32* b, int words, bool erode,
+                    uinT32* dst) {
+  int n = words & ~3;
+  for (int i = 0; i < n; i += 4)
+    vst1q_u32(dst + i, Combine(vld1q_u32(a + i), vld1q_u32(b + i), erode));
+  return n;
+}
+
+int CombineShiftedRowNEON(const uinT32* a, const uinT32* b, int shift,
+                          int words, bool erode, uinT32* dst) {
+  // vshlq shifts right for negative counts, and gives 0 for a count of
+  // -32, so a shift of 0 needs no special case.
+  const int32x4_t left = vdupq_n_s32(shift);
+  const int32x4_t right = vdupq_n_s32(shift - 32);
+  int n = words & ~3;
+  for (int i = 0; i < n; i += 4) {
+    uint32x4_t s = vorrq_u32(vshlq_u32(vld1q_u32(b + i), left),
+                             vshlq_u32(vld1q_u32(b + i + 1), right));
+    if (a != NULL)
+      s = Combine(vld1q_u32(a + i), s, erode);
+    vst1q_u32(dst + i, s);
+  }
+  return n;
+}
+
+#else  // NEON_BUILD
+
+int CombineRowsNEON(const uinT32* a, const uinT32* b, int words, bool erode,
+                    uinT32* dst) {
+  return 0;
+}
+
+int CombineShiftedRowNEON(const uinT32* a, const uinT32* b, int shift,
+                          int words, bool erode, uinT32* dst) {
+  return 0;
+}
+
+#endif  // NEON_BUILD
+
+}  // namespace tesseract
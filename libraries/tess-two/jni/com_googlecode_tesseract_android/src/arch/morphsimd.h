@@ -0,0 +1,60 @@
+///////////////////////////////////////////////////////////////////////
+// File:        morphsimd.h
+// Description: SIMD kernels that combine rows of a 1 bit image for binary
+//              brick morphology.
+//
+// (C) Copyright 2017, Google Inc.
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+///////////////////////////////////////////////////////////////////////
+
+#ifndef TESSERACT_ARCH_MORPHSIMD_H_
+#define TESSERACT_ARCH_MORPHSIMD_H_
+
+#include "host.h"
+
+namespace tesseract {
+
+// The kernels work on rows of Leptonica 1 bpp words, in which pixel p of a
+// word is bit 31 - p, so they do not depend on the byte order of the host.
+// A dilation combines words with OR and an erosion (erode true) with AND.
+// Each kernel handles whole groups of its vector width only and returns the
+// number of words it processed, leaving the rest of the row to the caller.
+// Kernels that are not compiled for the current architecture process
+// nothing and return 0.
+
+// Sets dst[i] = a[i] op b[i]. dst may be a or b.
+typedef int (*CombineRowsFunc)(const uinT32* a, const uinT32* b, int words,
+                               bool erode, uinT32* dst);
+int CombineRowsSSE2(const uinT32* a, const uinT32* b, int words, bool erode,
+                    uinT32* dst);
+int CombineRowsAVX2(const uinT32* a, const uinT32* b, int words, bool erode,
+                    uinT32* dst);
+int CombineRowsNEON(const uinT32* a, const uinT32* b, int words, bool erode,
+                    uinT32* dst);
+
+// Sets dst[i] = a[i] op s[i], where s is the row b moved left by shift
+// pixels, for 0 <= shift < 32:
+//   s[i] = (b[i] << shift) | (b[i + 1] >> (32 - shift)),
+// so b[words] is read as well. If a is NULL, dst[i] = s[i]. dst may be a,
+// and it may be b too, as the words are processed in increasing order.
+typedef int (*CombineShiftedRowFunc)(const uinT32* a, const uinT32* b,
+                                     int shift, int words, bool erode,
+                                     uinT32* dst);
+int CombineShiftedRowSSE2(const uinT32* a, const uinT32* b, int shift,
+                          int words, bool erode, uinT32* dst);
+int CombineShiftedRowAVX2(const uinT32* a, const uinT32* b, int shift,
+                          int words, bool erode, uinT32* dst);
+int CombineShiftedRowNEON(const uinT32* a, const uinT32* b, int shift,
+                          int words, bool erode, uinT32* dst);
+
+}  // namespace tesseract
+
+#endif  // TESSERACT_ARCH_MORPHSIMD_H_
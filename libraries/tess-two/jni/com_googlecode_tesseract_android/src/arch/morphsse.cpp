@@ -0,0 +1,79 @@
+///////////////////////////////////////////////////////////////////////
+// File:        morphsse.cpp
+// Description: SSE2 row kernels for binary brick morphology.
+//
+// (C) Copyright 2017, Google Inc.
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+///////////////////////////////////////////////////////////////////////
+
+#include "morphsimd.h"
+
+#if defined(__i386__) || defined(__x86_64__)
+#include <emmintrin.h>
+#define SSE2_TARGET __attribute__((target("sse2")))
+#endif
+
+namespace tesseract {
+
+#ifdef SSE2_TARGET
+
+// Combines 4 words with OR, or with AND if erode.
+SSE2_TARGET static inline __m128i Combine(__m128i a, __m128i b, bool erode) {
+  return erode ? _mm_and_si128(a, b) : _mm_or_si128(a, b);
+}
+
+SSE2_TARGET int CombineRowsSSE2(const uinT32* a, const uinT32* b, int words,
+                                bool erode, uinT32* dst) {
+  int n = words & ~3;
+  for (int i = 0; i < n; i += 4) {
+    __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+    __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i),
+                     Combine(va, vb, erode));
+  }
+  return n;
+}
+
+SSE2_TARGET int CombineShiftedRowSSE2(const uinT32* a, const uinT32* b,
+                                      int shift, int words, bool erode,
+                                      uinT32* dst) {
+  // Shifts by 32 or more give 0, so a shift of 0 needs no special case.
+  const __m128i left = _mm_cvtsi32_si128(shift);
+  const __m128i right = _mm_cvtsi32_si128(32 - shift);
+  int n = words & ~3;
+  for (int i = 0; i < n; i += 4) {
+    __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+    __m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i + 1));
+    __m128i s = _mm_or_si128(_mm_sll_epi32(lo, left), _mm_srl_epi32(hi, right));
+    if (a != NULL) {
+      s = Combine(_mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i)), s,
+                  erode);
+    }
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), s);
+  }
+  return n;
+}
+
+#else  // SSE2_TARGET
+
+int CombineRowsSSE2(const uinT32* a, const uinT32* b, int words, bool erode,
+                    uinT32* dst) {
+  return 0;
+}
+
+int CombineShiftedRowSSE2(const uinT32* a, const uinT32* b, int shift,
+                          int words, bool erode, uinT32* dst) {
+  return 0;
+}
+
+#endif  // SSE2_TARGET
+
+}  // namespace tesseract
@@ -0,0 +1,72 @@
+///////////////////////////////////////////////////////////////////////
+// File:        netavx2.cpp
+// Description: AVX2 int8 dense layer kernel for NeuralNet.
+//
+// (C) Copyright 2017, Google Inc.
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+///////////////////////////////////////////////////////////////////////
+
+#include "netsimd.h"
+
+#if defined(__i386__) || defined(__x86_64__)
+#include <immintrin.h>
+// Compiled for AVX2 per function, so the rest of the library keeps the
+// baseline ABI and this is only called when SIMDDetect finds AVX2.
+#define AVX2_TARGET __attribute__((target("avx2")))
+#endif
+
+namespace tesseract {
+
+#ifdef AVX2_TARGET
+
+// As DenseLayerInt8SSSE3, on 32 weights at a time, with a final 16 when the
+// stride is an odd multiple of kDenseLayerInt8Padding. Integer sums, so the
+// result is the same as that of the other kernels.
+AVX2_TARGET bool DenseLayerInt8AVX2(const inT8* weights, const uinT8* inputs,
+                                    int stride, int num_outputs,
+                                    inT32* sums) {
+  const __m256i ones = _mm256_set1_epi16(1);
+  const int wide_end = stride & ~31;
+  for (int o = 0; o < num_outputs; ++o, weights += stride) {
+    __m256i acc = _mm256_setzero_si256();
+    for (int i = 0; i < wide_end; i += 32) {
+      __m256i pairs = _mm256_maddubs_epi16(
+          _mm256_loadu_si256(reinterpret_cast<const __m256i*>(inputs + i)),
+          _mm256_loadu_si256(reinterpret_cast<const __m256i*>(weights + i)));
+      acc = _mm256_add_epi32(acc, _mm256_madd_epi16(pairs, ones));
+    }
+    __m128i sum = _mm_add_epi32(_mm256_castsi256_si128(acc),
+                                _mm256_extracti128_si256(acc, 1));
+    if (wide_end < stride) {
+      __m128i pairs = _mm_maddubs_epi16(
+          _mm_loadu_si128(reinterpret_cast<const __m128i*>(inputs + wide_end)),
+          _mm_loadu_si128(
+              reinterpret_cast<const __m128i*>(weights + wide_end)));
+      sum = _mm_add_epi32(sum,
+                          _mm_madd_epi16(pairs, _mm256_castsi256_si128(ones)));
+    }
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(1, 0, 3, 2)));
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(2, 3, 0, 1)));
+    sums[o] = _mm_cvtsi128_si32(sum);
+  }
+  return true;
+}
+
+#else  // AVX2_TARGET
+
+bool DenseLayerInt8AVX2(const inT8* weights, const uinT8* inputs, int stride,
+                        int num_outputs, inT32* sums) {
+  return false;
+}
+
+#endif  // AVX2_TARGET
+
+}  // namespace tesseract
@@ -0,0 +1,78 @@
+///////////////////////////////////////////////////////////////////////
+// File:        netneon.cpp
+// Description: NEON dense layer kernels for NeuralNet.
+//
+// (C) Copyright 2017, Google Inc.
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+///////////////////////////////////////////////////////////////////////
+
+#include "netsimd.h"
+
+#if defined(__aarch64__) || defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define NEON_BUILD 1
+#include <arm_neon.h>
+#endif
+
+namespace tesseract {
+
+#ifdef NEON_BUILD
+
+bool DenseLayerNEON(const float* weights, const float* inputs, int stride,
+                    int num_outputs, float* sums) {
+  for (int o = 0; o < num_outputs; ++o, weights += stride) {
+    float32x4_t acc = vdupq_n_f32(0.0f);
+    for (int i = 0; i < stride; i += 4)
+      acc = vmlaq_f32(acc, vld1q_f32(weights + i), vld1q_f32(inputs + i));
+    float32x2_t pair = vadd_f32(vget_low_f32(acc), vget_high_f32(acc));
+    sums[o] = vget_lane_f32(vpadd_f32(pair, pair), 0);
+  }
+  return true;
+}
+
+// Uses the sdot instruction when compiled for a core that has it, else
+// widening multiplies. The inputs are at most 127, so they can be taken as
+// signed, and a pair of products fits in 16 bits.
+bool DenseLayerInt8NEON(const inT8* weights, const uinT8* inputs, int stride,
+                        int num_outputs, inT32* sums) {
+  for (int o = 0; o < num_outputs; ++o, weights += stride) {
+    int32x4_t acc = vdupq_n_s32(0);
+    for (int i = 0; i < stride; i += 16) {
+      int8x16_t w = vld1q_s8(weights + i);
+      int8x16_t x = vreinterpretq_s8_u8(vld1q_u8(inputs + i));
+#ifdef __ARM_FEATURE_DOTPROD
+      acc = vdotq_s32(acc, w, x);
+#else
+      int16x8_t pairs = vmull_s8(vget_low_s8(w), vget_low_s8(x));
+      pairs = vmlal_s8(pairs, vget_high_s8(w), vget_high_s8(x));
+      acc = vpadalq_s16(acc, pairs);
+#endif
+    }
+    int32x2_t pair = vadd_s32(vget_low_s32(acc), vget_high_s32(acc));
+    sums[o] = vget_lane_s32(vpadd_s32(pair, pair), 0);
+  }
+  return true;
+}
+
+#else  // NEON_BUILD
+
+bool DenseLayerNEON(const float* weights, const float* inputs, int stride,
+                    int num_outputs, float* sums) {
+  return false;
+}
+
+bool DenseLayerInt8NEON(const inT8* weights, const uinT8* inputs, int stride,
+                        int num_outputs, inT32* sums) {
+  return false;
+}
+
+#endif  // NEON_BUILD
+
+}  // namespace tesseract
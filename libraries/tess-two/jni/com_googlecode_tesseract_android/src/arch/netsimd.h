@@ -0,0 +1,58 @@
+///////////////////////////////////////////////////////////////////////
+// File:        netsimd.h
+// Description: SIMD kernels for the dense layers of a NeuralNet.
+//
+// (C) Copyright 2017, Google Inc.
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+///////////////////////////////////////////////////////////////////////
+
+#ifndef TESSERACT_ARCH_NETSIMD_H_
+#define TESSERACT_ARCH_NETSIMD_H_
+
+#include "host.h"
+
+namespace tesseract {
+
+// Number of floats that the rows of a dense weight matrix, and the input
+// vector, are padded to a multiple of with zeros.
+const int kDenseLayerPadding = 4;
+
+// Sets sums[o] to the dot product of the stride weights of row o of weights
+// with the stride inputs, for each of the num_outputs rows, which are stride
+// floats apart. stride must be a multiple of kDenseLayerPadding. Returns
+// false, having set nothing, if not compiled for the current architecture,
+// in which case the caller must use a scalar loop.
+typedef bool (*DenseLayerFunc)(const float* weights, const float* inputs,
+                               int stride, int num_outputs, float* sums);
+bool DenseLayerSSE2(const float* weights, const float* inputs, int stride,
+                    int num_outputs, float* sums);
+bool DenseLayerNEON(const float* weights, const float* inputs, int stride,
+                    int num_outputs, float* sums);
+
+// Number of weights that the rows of an int8 weight matrix are padded to a
+// multiple of with zeros.
+const int kDenseLayerInt8Padding = 16;
+
+// Integer version of DenseLayerFunc, for int8 weights and inputs quantized
+// to [0, 127], so that no pair of products can overflow 16 bits. stride must
+// be a multiple of kDenseLayerInt8Padding.
+typedef bool (*DenseLayerInt8Func)(const inT8* weights, const uinT8* inputs,
+                                   int stride, int num_outputs, inT32* sums);
+bool DenseLayerInt8SSSE3(const inT8* weights, const uinT8* inputs, int stride,
+                         int num_outputs, inT32* sums);
+bool DenseLayerInt8AVX2(const inT8* weights, const uinT8* inputs, int stride,
+                        int num_outputs, inT32* sums);
+bool DenseLayerInt8NEON(const inT8* weights, const uinT8* inputs, int stride,
+                        int num_outputs, inT32* sums);
+
+}  // namespace tesseract
+
+#endif  // TESSERACT_ARCH_NETSIMD_H_
@@ -0,0 +1,81 @@
+///////////////////////////////////////////////////////////////////////
+// File:        netsse.cpp
+// Description: SSE2 and SSSE3 dense layer kernels for NeuralNet.
+//
+// (C) Copyright 2017, Google Inc.
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+///////////////////////////////////////////////////////////////////////
+
+#include "netsimd.h"
+
+#if defined(__i386__) || defined(__x86_64__)
+#include <emmintrin.h>
+#include <tmmintrin.h>
+#define SSE2_TARGET __attribute__((target("sse2")))
+#define SSSE3_TARGET __attribute__((target("ssse3")))
+#endif
+
+namespace tesseract {
+
+#ifdef SSE2_TARGET
+
+SSE2_TARGET bool DenseLayerSSE2(const float* weights, const float* inputs,
+                                int stride, int num_outputs, float* sums) {
+  for (int o = 0; o < num_outputs; ++o, weights += stride) {
+    __m128 acc = _mm_setzero_ps();
+    for (int i = 0; i < stride; i += 4) {
+      acc = _mm_add_ps(acc, _mm_mul_ps(_mm_loadu_ps(weights + i),
+                                       _mm_loadu_ps(inputs + i)));
+    }
+    // Add the high pair to the low pair, then the two that are left.
+    acc = _mm_add_ps(acc, _mm_movehl_ps(acc, acc));
+    acc = _mm_add_ss(acc, _mm_shuffle_ps(acc, acc, 1));
+    sums[o] = _mm_cvtss_f32(acc);
+  }
+  return true;
+}
+
+SSSE3_TARGET bool DenseLayerInt8SSSE3(const inT8* weights,
+                                      const uinT8* inputs, int stride,
+                                      int num_outputs, inT32* sums) {
+  const __m128i ones = _mm_set1_epi16(1);
+  for (int o = 0; o < num_outputs; ++o, weights += stride) {
+    __m128i acc = _mm_setzero_si128();
+    for (int i = 0; i < stride; i += 16) {
+      // Unsigned inputs times signed weights, adjacent pairs summed to 16
+      // bits, which the 7 bit inputs keep from saturating, then to 32.
+      __m128i pairs = _mm_maddubs_epi16(
+          _mm_loadu_si128(reinterpret_cast<const __m128i*>(inputs + i)),
+          _mm_loadu_si128(reinterpret_cast<const __m128i*>(weights + i)));
+      acc = _mm_add_epi32(acc, _mm_madd_epi16(pairs, ones));
+    }
+    acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, _MM_SHUFFLE(1, 0, 3, 2)));
+    acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, _MM_SHUFFLE(2, 3, 0, 1)));
+    sums[o] = _mm_cvtsi128_si32(acc);
+  }
+  return true;
+}
+
+#else  // SSE2_TARGET
+
+bool DenseLayerSSE2(const float* weights, const float* inputs, int stride,
+                    int num_outputs, float* sums) {
+  return false;
+}
+
+bool DenseLayerInt8SSSE3(const inT8* weights, const uinT8* inputs, int stride,
+                         int num_outputs, inT32* sums) {
+  return false;
+}
+
+#endif  // SSE2_TARGET
+
+}  // namespace tesseract
@@ -0,0 +1,80 @@
+///////////////////////////////////////////////////////////////////////
+// File:        simddetect.cpp
+// Description: Architecture detector.
+//
+// (C) Copyright 2017, Google Inc.
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+///////////////////////////////////////////////////////////////////////
+
+#include "simddetect.h"
+
+#if defined(__i386__) || defined(__x86_64__)
+#define X86_BUILD 1
+#include <cpuid.h>
+#elif defined(__arm__) && defined(__ANDROID__)
+#define ARM32_ANDROID_BUILD 1
+#include <cpu-features.h>
+#endif
+
+namespace tesseract {
+
+SIMDDetect SIMDDetect::detector;
+
+bool SIMDDetect::enabled_ = true;
+// If true, then the instruction set is available.
+bool SIMDDetect::sse2_available_ = false;
+bool SIMDDetect::ssse3_available_ = false;
+bool SIMDDetect::sse41_available_ = false;
+bool SIMDDetect::avx2_available_ = false;
+bool SIMDDetect::neon_available_ = false;
+
+#ifdef X86_BUILD
+// Returns the XCR0 register, which tells which register sets the OS saves.
+static unsigned int ReadXCR0() {
+  unsigned int eax, edx;
+  __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+  return eax;
+}
+#endif
+
+// Constructor.
+// Tests the architecture in a system-dependent way to detect AVX, SSE and
+// any other available SIMD equipment.
+SIMDDetect::SIMDDetect() {
+#ifdef X86_BUILD
+  unsigned int eax, ebx, ecx, edx;
+  if (__get_cpuid(1, &eax, &ebx, &ecx, &edx) != 0) {
+    sse2_available_ = (edx & bit_SSE2) != 0;
+    ssse3_available_ = (ecx & bit_SSSE3) != 0;
+    sse41_available_ = (ecx & bit_SSE4_1) != 0;
+    // AVX needs the OS to save the ymm registers as well as the CPU flag.
+    bool avx_available = (ecx & bit_AVX) != 0 && (ecx & bit_OSXSAVE) != 0 &&
+                         (ReadXCR0() & 6) == 6;
+    if (avx_available && __get_cpuid_max(0, NULL) >= 7) {
+      __cpuid_count(7, 0, eax, ebx, ecx, edx);
+      avx2_available_ = (ebx & bit_AVX2) != 0;
+    }
+  }
+#elif defined(__aarch64__)
+  // ARMv8 always has NEON.
+  neon_available_ = true;
+#elif defined(ARM32_ANDROID_BUILD)
+  // armeabi-v7a does not guarantee NEON, but the *neon.cpp kernels are built
+  // with it anyway, so ask the kernel what this device has.
+  neon_available_ = android_getCpuFamily() == ANDROID_CPU_FAMILY_ARM &&
+                    (android_getCpuFeatures() & ANDROID_CPU_ARM_FEATURE_NEON);
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+  // A 32 bit ARM build compiled with NEON can only run where it is present.
+  neon_available_ = true;
+#endif
+}
+
+}  // namespace tesseract
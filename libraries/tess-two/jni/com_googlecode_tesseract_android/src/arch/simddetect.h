@@ -0,0 +1,64 @@
+///////////////////////////////////////////////////////////////////////
+// File:        simddetect.h
+// Description: Architecture detector.
+//
+// (C) Copyright 2017, Google Inc.
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+///////////////////////////////////////////////////////////////////////
+
+#ifndef TESSERACT_ARCH_SIMDDETECT_H_
+#define TESSERACT_ARCH_SIMDDETECT_H_
+
+#include "platform.h"
+
+namespace tesseract {
+
+// Architecture detector. Add code here to detect any other architectures for
+// SIMD-based faster kernels. Intended to be a single static object, but it
+// does no real harm to have more than one.
+class TESS_API SIMDDetect {
+ public:
+  // Returns true if SSE2 is available on this system.
+  static inline bool IsSSE2Available() { return enabled_ && sse2_available_; }
+  // Returns true if SSSE3 is available on this system.
+  static inline bool IsSSSE3Available() { return enabled_ && ssse3_available_; }
+  // Returns true if SSE4.1 is available on this system.
+  static inline bool IsSSE41Available() { return enabled_ && sse41_available_; }
+  // Returns true if AVX2 is available on this system, including OS support
+  // for saving the wide registers.
+  static inline bool IsAVX2Available() { return enabled_ && avx2_available_; }
+  // Returns true if NEON is available on this system.
+  static inline bool IsNEONAvailable() { return enabled_ && neon_available_; }
+  // While enabled is false, reports every instruction set as unavailable, so
+  // that code which checks before each use falls back to its scalar path.
+  // For benchmarks that compare the two; not thread-safe.
+  static void SetEnabled(bool enabled) { enabled_ = enabled; }
+
+ private:
+  // Constructor, must set all static member variables.
+  SIMDDetect();
+
+ private:
+  // Singleton.
+  static SIMDDetect detector;
+  // False while SetEnabled(false) is in force.
+  static bool enabled_;
+  // If true, then the instruction set is available.
+  static bool sse2_available_;
+  static bool ssse3_available_;
+  static bool sse41_available_;
+  static bool avx2_available_;
+  static bool neon_available_;
+};
+
+}  // namespace tesseract
+
+#endif  // TESSERACT_ARCH_SIMDDETECT_H_
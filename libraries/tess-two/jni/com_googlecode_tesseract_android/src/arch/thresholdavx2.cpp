@@ -0,0 +1,98 @@
+///////////////////////////////////////////////////////////////////////
+// File:        thresholdavx2.cpp
+// Description: AVX2 row thresholding kernels.
+//
+// (C) Copyright 2017, Google Inc.
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+///////////////////////////////////////////////////////////////////////
+
+#include "thresholdsimd.h"
+
+#if defined(__i386__) || defined(__x86_64__)
+#include <immintrin.h>
+// Compiled for AVX2 per function, so the rest of the library keeps the
+// baseline ABI and these are only called when SIMDDetect finds AVX2.
+#define AVX2_TARGET __attribute__((target("avx2")))
+#endif
+
+namespace tesseract {
+
+#ifdef AVX2_TARGET
+
+// Returns the 4 bytes as a word in little-endian memory order.
+static inline int PackBytes(const uinT8* bytes) {
+  return bytes[0] | (bytes[1] << 8) | (bytes[2] << 16) | (bytes[3] << 24);
+}
+
+// Binarizes a row of 8 bit grey pixels, one output word per vector.
+AVX2_TARGET int ThresholdGreyRowAVX2(const uinT32* src, int width,
+                                     int threshold, int hi_value,
+                                     uinT32* dst) {
+  const __m256i thresh = _mm256_set1_epi8(static_cast<char>(threshold));
+  const __m256i zero = _mm256_setzero_si256();
+  // The compare gives pixel <= threshold, which is foreground for a
+  // hi_value of 1 and background for a hi_value of 0.
+  const uinT32 invert = hi_value == 0 ? 0xffffffffu : 0;
+  const __m256i* data = reinterpret_cast<const __m256i*>(src);
+  int num_words = width / 32;
+  for (int w = 0; w < num_words; ++w, ++data) {
+    __m256i pixels = _mm256_loadu_si256(data);
+    pixels = _mm256_cmpeq_epi8(_mm256_subs_epu8(pixels, thresh), zero);
+    uinT32 mask = static_cast<uinT32>(_mm256_movemask_epi8(pixels));
+    dst[w] = GreyMaskToWord(mask ^ invert);
+  }
+  return num_words * 32;
+}
+
+// Binarizes a row of 4 channel pixels, 8 pixels per vector.
+AVX2_TARGET int ThresholdColorRowAVX2(const uinT32* src, int width,
+                                      const int* thresholds,
+                                      const int* hi_values, uinT32* dst) {
+  uinT8 threshold_bytes[4], invert_bytes[4], active_bytes[4];
+  ColorThresholdBytes(thresholds, hi_values, threshold_bytes, invert_bytes,
+                      active_bytes);
+  const __m256i thresh = _mm256_set1_epi32(PackBytes(threshold_bytes));
+  const __m256i invert = _mm256_set1_epi32(PackBytes(invert_bytes));
+  const __m256i active = _mm256_set1_epi32(PackBytes(active_bytes));
+  const __m256i zero = _mm256_setzero_si256();
+  const __m256i* data = reinterpret_cast<const __m256i*>(src);
+  int num_words = width / 32;
+  for (int w = 0; w < num_words; ++w) {
+    uinT32 word = 0;
+    for (int group = 0; group < 4; ++group, ++data) {
+      __m256i pixels = _mm256_loadu_si256(data);
+      __m256i fg = _mm256_cmpeq_epi8(_mm256_subs_epu8(pixels, thresh), zero);
+      fg = _mm256_and_si256(_mm256_xor_si256(fg, invert), active);
+      // A pixel is background only if no channel voted for foreground.
+      __m256i bg = _mm256_cmpeq_epi32(fg, zero);
+      uinT32 bits = ~_mm256_movemask_ps(_mm256_castsi256_ps(bg)) & 0xff;
+      word = (word << 8) | (ReverseNibble(bits) << 4) | ReverseNibble(bits >> 4);
+    }
+    dst[w] = word;
+  }
+  return num_words * 32;
+}
+
+#else  // AVX2_TARGET
+
+int ThresholdGreyRowAVX2(const uinT32* src, int width, int threshold,
+                         int hi_value, uinT32* dst) {
+  return 0;
+}
+
+int ThresholdColorRowAVX2(const uinT32* src, int width, const int* thresholds,
+                          const int* hi_values, uinT32* dst) {
+  return 0;
+}
+
+#endif  // AVX2_TARGET
+
+}  // namespace tesseract
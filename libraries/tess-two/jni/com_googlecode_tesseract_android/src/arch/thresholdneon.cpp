@@ -0,0 +1,110 @@
+///////////////////////////////////////////////////////////////////////
+// File:        thresholdneon.cpp
+// Description: NEON row thresholding kernels.
+//
+// (C) Copyright 2017, Google Inc.
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+///////////////////////////////////////////////////////////////////////
+
+#include "thresholdsimd.h"
+
+#if defined(__aarch64__) || defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define NEON_BUILD 1
+#include <arm_neon.h>
+#endif
+
+namespace tesseract {
+
+#ifdef NEON_BUILD
+
+// Weight of each pixel within its output byte, most significant bit first.
+static const uinT8 kGreyBitWeights[16] = {
+  128, 64, 32, 16, 8, 4, 2, 1, 128, 64, 32, 16, 8, 4, 2, 1
+};
+// Weight of each pixel within its output nibble.
+static const uinT32 kColorBitWeights[4] = { 8, 4, 2, 1 };
+
+// Binarizes a row of 8 bit grey pixels, 32 pixels per output word.
+int ThresholdGreyRowNEON(const uinT32* src, int width, int threshold,
+                         int hi_value, uinT32* dst) {
+  const uint8x16_t thresh = vdupq_n_u8(static_cast<uinT8>(threshold));
+  // The compare gives pixel <= threshold, which is foreground for a
+  // hi_value of 1 and background for a hi_value of 0.
+  const uint8x16_t invert = vdupq_n_u8(hi_value == 0 ? 0xff : 0);
+  const uint8x16_t weights = vld1q_u8(kGreyBitWeights);
+  const uinT8* data = reinterpret_cast<const uinT8*>(src);
+  int num_words = width / 32;
+  for (int w = 0; w < num_words; ++w, data += 32) {
+    // Put the pixels back in order: Leptonica keeps pixel 0 in the most
+    // significant byte of each word.
+    uint8x16_t lo = vrev32q_u8(vld1q_u8(data));
+    uint8x16_t hi = vrev32q_u8(vld1q_u8(data + 16));
+    lo = vandq_u8(veorq_u8(vcleq_u8(lo, thresh), invert), weights);
+    hi = vandq_u8(veorq_u8(vcleq_u8(hi, thresh), invert), weights);
+    // Pairwise adds collapse each run of 8 weighted pixels into one byte.
+    uint8x8_t sums = vpadd_u8(vpadd_u8(vget_low_u8(lo), vget_high_u8(lo)),
+                              vpadd_u8(vget_low_u8(hi), vget_high_u8(hi)));
+    sums = vpadd_u8(sums, sums);
+    dst[w] = __builtin_bswap32(vget_lane_u32(vreinterpret_u32_u8(sums), 0));
+  }
+  return num_words * 32;
+}
+
+// Binarizes a row of 4 channel pixels, 4 pixels per vector.
+int ThresholdColorRowNEON(const uinT32* src, int width, const int* thresholds,
+                          const int* hi_values, uinT32* dst) {
+  uinT8 threshold_bytes[4], invert_bytes[4], active_bytes[4];
+  ColorThresholdBytes(thresholds, hi_values, threshold_bytes, invert_bytes,
+                      active_bytes);
+  uinT8 lanes[3][16];
+  for (int i = 0; i < 16; ++i) {
+    lanes[0][i] = threshold_bytes[i & 3];
+    lanes[1][i] = invert_bytes[i & 3];
+    lanes[2][i] = active_bytes[i & 3];
+  }
+  const uint8x16_t thresh = vld1q_u8(lanes[0]);
+  const uint8x16_t invert = vld1q_u8(lanes[1]);
+  const uint8x16_t active = vld1q_u8(lanes[2]);
+  const uint32x4_t weights = vld1q_u32(kColorBitWeights);
+  const uinT8* data = reinterpret_cast<const uinT8*>(src);
+  int num_words = width / 32;
+  for (int w = 0; w < num_words; ++w) {
+    uinT32 word = 0;
+    for (int group = 0; group < 8; ++group, data += 16) {
+      uint8x16_t fg = vcleq_u8(vld1q_u8(data), thresh);
+      fg = vandq_u8(veorq_u8(fg, invert), active);
+      // A pixel is foreground if any channel voted for it.
+      uint32x4_t votes = vreinterpretq_u32_u8(fg);
+      uint32x4_t bits = vandq_u32(vtstq_u32(votes, votes), weights);
+      uint32x2_t sums = vpadd_u32(vget_low_u32(bits), vget_high_u32(bits));
+      sums = vpadd_u32(sums, sums);
+      word = (word << 4) | vget_lane_u32(sums, 0);
+    }
+    dst[w] = word;
+  }
+  return num_words * 32;
+}
+
+#else  // NEON_BUILD
+
+int ThresholdGreyRowNEON(const uinT32* src, int width, int threshold,
+                         int hi_value, uinT32* dst) {
+  return 0;
+}
+
+int ThresholdColorRowNEON(const uinT32* src, int width, const int* thresholds,
+                          const int* hi_values, uinT32* dst) {
+  return 0;
+}
+
+#endif  // NEON_BUILD
+
+}  // namespace tesseract
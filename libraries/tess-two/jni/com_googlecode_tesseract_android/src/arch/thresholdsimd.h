@@ -0,0 +1,97 @@
+///////////////////////////////////////////////////////////////////////
+// File:        thresholdsimd.h
+// Description: SIMD kernels that binarize rows of an 8 bit or 32 bit image.
+//
+// (C) Copyright 2017, Google Inc.
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+///////////////////////////////////////////////////////////////////////
+
+#ifndef TESSERACT_ARCH_THRESHOLDSIMD_H_
+#define TESSERACT_ARCH_THRESHOLDSIMD_H_
+
+#include "host.h"
+
+namespace tesseract {
+
+// The row kernels below produce exactly the same bits as the scalar loop in
+// ImageThresholder::ThresholdRectToPix. A pixel becomes foreground (a set
+// bit) if any channel c with hi_values[c] >= 0 satisfies
+// (pixel[c] > thresholds[c]) == (hi_values[c] == 0).
+// All thresholds of channels in use must be in [0, 255].
+//
+// src points to the Leptonica words that hold the first pixel of the row,
+// which for an 8 bit image must be the first byte of its word. dst points to
+// the first output word. Each kernel handles whole groups of 32 pixels only,
+// overwriting the corresponding dst words, and returns the number of pixels
+// it processed, leaving the rest of the row to the caller. Kernels that are
+// not compiled for the current architecture process nothing and return 0.
+// They all assume a little-endian host, like every Android ABI.
+
+// Binarizes a row of 8 bit grey pixels.
+typedef int (*GreyRowThresholdFunc)(const uinT32* src, int width,
+                                    int threshold, int hi_value, uinT32* dst);
+int ThresholdGreyRowSSE2(const uinT32* src, int width, int threshold,
+                         int hi_value, uinT32* dst);
+int ThresholdGreyRowAVX2(const uinT32* src, int width, int threshold,
+                         int hi_value, uinT32* dst);
+int ThresholdGreyRowNEON(const uinT32* src, int width, int threshold,
+                         int hi_value, uinT32* dst);
+
+// Binarizes a row of 4 channel (32 bit) pixels.
+typedef int (*ColorRowThresholdFunc)(const uinT32* src, int width,
+                                     const int* thresholds,
+                                     const int* hi_values, uinT32* dst);
+int ThresholdColorRowSSE2(const uinT32* src, int width, const int* thresholds,
+                          const int* hi_values, uinT32* dst);
+int ThresholdColorRowAVX2(const uinT32* src, int width, const int* thresholds,
+                          const int* hi_values, uinT32* dst);
+int ThresholdColorRowNEON(const uinT32* src, int width, const int* thresholds,
+                          const int* hi_values, uinT32* dst);
+
+// Helpers shared by the kernels to build per-byte constants for a 32 bit
+// pixel. In memory on a little-endian host, channel c of a Leptonica pixel
+// is byte 3 - c of its word.
+// Sets threshold_bytes to the clipped threshold of each channel byte,
+// invert_bytes to 0xff for channels that are foreground when high, and
+// active_bytes to 0xff for channels in use.
+inline void ColorThresholdBytes(const int* thresholds, const int* hi_values,
+                                uinT8* threshold_bytes, uinT8* invert_bytes,
+                                uinT8* active_bytes) {
+  for (int c = 0; c < 4; ++c) {
+    int t = thresholds[c];
+    threshold_bytes[3 - c] = static_cast<uinT8>(t < 0 ? 0 : (t > 255 ? 255 : t));
+    invert_bytes[3 - c] = hi_values[c] == 0 ? 0xff : 0;
+    active_bytes[3 - c] = hi_values[c] >= 0 ? 0xff : 0;
+  }
+}
+
+// Converts a mask with bit i set for the little-endian memory byte i of a
+// 32 pixel, 8 bit row segment into the Leptonica output word, in which pixel
+// p is bit 31 - p. Memory byte i holds pixel i ^ 3, so bit i must move to bit
+// 28 ^ i, which reverses the order of the 8 nibbles.
+inline uinT32 GreyMaskToWord(uinT32 mask) {
+  mask = (mask >> 16) | (mask << 16);
+  mask = ((mask & 0x00ff00ffu) << 8) | ((mask >> 8) & 0x00ff00ffu);
+  return ((mask & 0x0f0f0f0fu) << 4) | ((mask >> 4) & 0x0f0f0f0fu);
+}
+
+// Reverses the bits of the bottom nibble.
+inline uinT32 ReverseNibble(uinT32 nibble) {
+  static const uinT8 kReversed[16] = {
+    0x0, 0x8, 0x4, 0xc, 0x2, 0xa, 0x6, 0xe,
+    0x1, 0x9, 0x5, 0xd, 0x3, 0xb, 0x7, 0xf
+  };
+  return kReversed[nibble & 0xf];
+}
+
+}  // namespace tesseract
+
+#endif  // TESSERACT_ARCH_THRESHOLDSIMD_H_
@@ -0,0 +1,100 @@
+///////////////////////////////////////////////////////////////////////
+// File:        thresholdsse.cpp
+// Description: SSE2 row thresholding kernels.
+//
+// (C) Copyright 2017, Google Inc.
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+///////////////////////////////////////////////////////////////////////
+
+#include "thresholdsimd.h"
+
+#if defined(__i386__) || defined(__x86_64__)
+#include <emmintrin.h>
+#define SSE2_TARGET __attribute__((target("sse2")))
+#endif
+
+namespace tesseract {
+
+#ifdef SSE2_TARGET
+
+// Returns the 4 bytes as a word in little-endian memory order.
+static inline int PackBytes(const uinT8* bytes) {
+  return bytes[0] | (bytes[1] << 8) | (bytes[2] << 16) | (bytes[3] << 24);
+}
+
+// Binarizes a row of 8 bit grey pixels, 32 pixels per output word.
+SSE2_TARGET int ThresholdGreyRowSSE2(const uinT32* src, int width,
+                                     int threshold, int hi_value,
+                                     uinT32* dst) {
+  const __m128i thresh = _mm_set1_epi8(static_cast<char>(threshold));
+  const __m128i zero = _mm_setzero_si128();
+  // The compare gives pixel <= threshold, which is foreground for a
+  // hi_value of 1 and background for a hi_value of 0.
+  const uinT32 invert = hi_value == 0 ? 0xffffffffu : 0;
+  const __m128i* data = reinterpret_cast<const __m128i*>(src);
+  int num_words = width / 32;
+  for (int w = 0; w < num_words; ++w, data += 2) {
+    __m128i lo = _mm_loadu_si128(data);
+    __m128i hi = _mm_loadu_si128(data + 1);
+    // saturating subtract is zero exactly when pixel <= threshold.
+    lo = _mm_cmpeq_epi8(_mm_subs_epu8(lo, thresh), zero);
+    hi = _mm_cmpeq_epi8(_mm_subs_epu8(hi, thresh), zero);
+    uinT32 mask = static_cast<uinT32>(_mm_movemask_epi8(lo)) |
+                  (static_cast<uinT32>(_mm_movemask_epi8(hi)) << 16);
+    dst[w] = GreyMaskToWord(mask ^ invert);
+  }
+  return num_words * 32;
+}
+
+// Binarizes a row of 4 channel pixels, 4 pixels per vector.
+SSE2_TARGET int ThresholdColorRowSSE2(const uinT32* src, int width,
+                                      const int* thresholds,
+                                      const int* hi_values, uinT32* dst) {
+  uinT8 threshold_bytes[4], invert_bytes[4], active_bytes[4];
+  ColorThresholdBytes(thresholds, hi_values, threshold_bytes, invert_bytes,
+                      active_bytes);
+  const __m128i thresh = _mm_set1_epi32(PackBytes(threshold_bytes));
+  const __m128i invert = _mm_set1_epi32(PackBytes(invert_bytes));
+  const __m128i active = _mm_set1_epi32(PackBytes(active_bytes));
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i* data = reinterpret_cast<const __m128i*>(src);
+  int num_words = width / 32;
+  for (int w = 0; w < num_words; ++w) {
+    uinT32 word = 0;
+    for (int group = 0; group < 8; ++group, ++data) {
+      __m128i pixels = _mm_loadu_si128(data);
+      __m128i fg = _mm_cmpeq_epi8(_mm_subs_epu8(pixels, thresh), zero);
+      fg = _mm_and_si128(_mm_xor_si128(fg, invert), active);
+      // A pixel is background only if no channel voted for foreground.
+      __m128i bg = _mm_cmpeq_epi32(fg, zero);
+      uinT32 bits = ~_mm_movemask_ps(_mm_castsi128_ps(bg)) & 0xf;
+      word = (word << 4) | ReverseNibble(bits);
+    }
+    dst[w] = word;
+  }
+  return num_words * 32;
+}
+
+#else  // SSE2_TARGET
+
+int ThresholdGreyRowSSE2(const uinT32* src, int width, int threshold,
+                         int hi_value, uinT32* dst) {
+  return 0;
+}
+
+int ThresholdColorRowSSE2(const uinT32* src, int width, const int* thresholds,
+                          const int* hi_values, uinT32* dst) {
+  return 0;
+}
+
+#endif  // SSE2_TARGET
+
+}  // namespace tesseract
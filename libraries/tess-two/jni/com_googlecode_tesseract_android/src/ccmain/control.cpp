@@ -151,6 +151,7 @@ void Tesseract::SetupAllWordsPassN(int pass_n,
   PAGE_RES_IT page_res_it(page_res);
   for (page_res_it.restart_page(); page_res_it.word() != NULL;
        page_res_it.forward()) {
+    if (pass_n > 1 && page_res_it.block()->fast_confident) continue;
     if (target_word_box == NULL ||
         ProcessTargetWord(page_res_it.word()->word->bounding_box(),
                           *target_word_box, word_config, 1)) {
@@ -164,16 +165,31 @@ void Tesseract::SetupAllWordsPassN(int pass_n,
   }
 }
 
+// Returns true if words set up for recognition by a and by b are normalized
+// the same way.
+static bool SameNormalization(const Tesseract* a, const Tesseract* b) {
+  return (a->tessedit_ocr_engine_mode == OEM_CUBE_ONLY) ==
+             (b->tessedit_ocr_engine_mode == OEM_CUBE_ONLY) &&
+         a->classify_bln_numeric_mode == b->classify_bln_numeric_mode &&
+         a->textord_use_cjk_fp_model == b->textord_use_cjk_fp_model &&
+         a->poly_allow_detailed_fx == b->poly_allow_detailed_fx;
+}
+
 // Sets up the single word ready for whichever engine is to be run.
+// The outlines are approximated and normalized once, by the first setup of
+// each kind of normalization, and the other languages copy the result.
 void Tesseract::SetupWordPassN(int pass_n, WordData* word) {
   if (pass_n == 1 || !word->word->done) {
+    // The word that was set up first, still unrecognized, or NULL.
+    const WERD_RES* normalized = NULL;
     if (pass_n == 1) {
-      word->word->SetupForRecognition(unicharset, this, BestPix(),
-                                      tessedit_ocr_engine_mode, NULL,
-                                      classify_bln_numeric_mode,
-                                      textord_use_cjk_fp_model,
-                                      poly_allow_detailed_fx,
-                                      word->row, word->block);
+      if (word->word->SetupForRecognition(unicharset, this, BestPix(),
+                                          tessedit_ocr_engine_mode, NULL,
+                                          classify_bln_numeric_mode,
+                                          textord_use_cjk_fp_model,
+                                          poly_allow_detailed_fx,
+                                          word->row, word->block))
+        normalized = word->word;
     } else if (pass_n == 2) {
       // TODO(rays) Should we do this on pass1 too?
       word->word->caps_height = 0.0;
@@ -189,12 +205,19 @@ void Tesseract::SetupWordPassN(int pass_n, WordData* word) {
       word->lang_words.push_back(word_res);
       // Cube doesn't get setup for pass2.
       if (pass_n == 1 || lang_t->tessedit_ocr_engine_mode != OEM_CUBE_ONLY) {
-        word_res->SetupForRecognition(
+        if (normalized != NULL &&
+            SameNormalization(normalized->tesseract, lang_t)) {
+          word_res->SetupForRecognitionAs(*normalized, lang_t->unicharset,
+                                          lang_t);
+        } else if (word_res->SetupForRecognition(
               lang_t->unicharset, lang_t, BestPix(),
               lang_t->tessedit_ocr_engine_mode, NULL,
               lang_t->classify_bln_numeric_mode,
               lang_t->textord_use_cjk_fp_model,
-              lang_t->poly_allow_detailed_fx, word->row, word->block);
+              lang_t->poly_allow_detailed_fx, word->row, word->block) &&
+                   normalized == NULL) {
+          normalized = word_res;
+        }
       }
     }
   }
@@ -209,30 +232,37 @@ bool Tesseract::RecogAllWordsPassN(int pass_n, ETEXT_DESC* monitor,
   // (eg set_pass1 and set_pass2) and an intermediate adaption pass needs to be
   // added. The results will be significantly different with adaption on, and
   // deterioration will need investigation.
+  // tessedit_parallel_words does that for pass 1, on separate engines.
+  // It recognizes whole lines at a time, so can't stop after any word.
+  if (pass_n == 1 && tessedit_parallel_words && tessedit_parallelize > 1 &&
+      !word_workers_.empty() && !recognizing_in_parallel_ &&
+      (monitor == NULL || monitor->word_callback == NULL))
+    return RecogAllWordsPass1Par(monitor, pr_it, words);
+  gating_block_ = NULL;
+  GenericVector<int> order;
+  PrioritizeWords(*words, &order);
+  // The words taken so far, as only those give context to the next word.
+  GenericVector<bool> taken;
+  taken.init_to_size(words->size(), false);
   pr_it->restart_page();
-  for (int w = 0; w < words->size(); ++w) {
+  for (int i = 0; i < order.size(); ++i) {
+    int w = order[i];
     WordData* word = &(*words)[w];
-    if (w > 0) word->prev_word = &(*words)[w - 1];
-    if (monitor != NULL) {
-      monitor->ocr_alive = TRUE;
-      if (pass_n == 1)
-        monitor->progress = 70 * w / words->size();
-      else
-        monitor->progress = 70 + 30 * w / words->size();
-      if (monitor->progress_callback != NULL) {
-        TBOX box = word->word->word->bounding_box();
-        (*monitor->progress_callback)(monitor->progress_this, monitor->progress,
-                box.left(), box.right(), box.top(), box.bottom());
-      }
-      if (monitor->deadline_exceeded() ||
-          (monitor->cancel != NULL && (*monitor->cancel)(monitor->cancel_this,
-                                                         words->size()))) {
-        // Timeout. Fake out the rest of the words.
-        for (; w < words->size(); ++w) {
-          (*words)[w].word->SetupFake(unicharset);
-        }
-        return false;
+    word->prev_word = w > 0 && taken[w - 1] ? &(*words)[w - 1] : NULL;
+    if (i > 0 && order[i - 1] != w - 1) {
+      // Out of page order, so no word can continue a hyphenated one.
+      getDict().reset_hyphen_vars(true);
+      for (int s = 0; s < sub_langs_.size(); ++s)
+        sub_langs_[s]->getDict().reset_hyphen_vars(true);
+    }
+    taken[w] = true;
+    if (monitor != NULL && UpdateWordProgress(pass_n, i, w, *words, true,
+                                              monitor)) {
+      // Timeout. Fake out the rest of the words.
+      for (; i < order.size(); ++i) {
+        (*words)[order[i]].word->SetupFake(unicharset);
       }
+      return false;
     }
     if (word->word->tess_failed) {
       int s;
@@ -241,10 +271,18 @@ bool Tesseract::RecogAllWordsPassN(int pass_n, ETEXT_DESC* monitor,
       // If all are failed, skip it. Image words are skipped by this test.
       if (s > word->lang_words.size()) continue;
     }
-    // Sync pr_it with the wth WordData.
-    while (pr_it->word() != NULL && pr_it->word() != word->word)
-      pr_it->forward();
-    ASSERT_HOST(pr_it->word() != NULL);
+    // Sync pr_it with the wth WordData, which is behind it if the words are
+    // out of page order.
+    bool restarted = false;
+    while (pr_it->word() != word->word) {
+      if (pr_it->word() == NULL) {
+        ASSERT_HOST(!restarted);
+        pr_it->restart_page();
+        restarted = true;
+      } else {
+        pr_it->forward();
+      }
+    }
     bool make_next_word_fuzzy = false;
     if (ReassignDiacritics(pass_n, pr_it, &make_next_word_fuzzy)) {
       // Needs to be setup again to see the new outlines in the chopped_word.
@@ -257,14 +295,94 @@ bool Tesseract::RecogAllWordsPassN(int pass_n, ETEXT_DESC* monitor,
               word->word->best_choice->unichar_string().string(),
               word->word->best_choice->debug_string().string());
     }
+    if (pass_n == 1 && priority_boxes_.empty() &&
+        (w + 1 == words->size() || (*words)[w + 1].block != word->block)) {
+      // The block is done with pass 1, and may be final already.
+      StreamBlockIfFastConfident(pr_it->page_res, pr_it->block());
+    }
     pr_it->forward();
     if (make_next_word_fuzzy && pr_it->word() != NULL) {
       pr_it->MakeCurrentWordFuzzy();
     }
+    if (pass_n == 1 && monitor != NULL && monitor->word_callback != NULL) {
+      TBOX box = word->word->word->bounding_box();
+      if ((*monitor->word_callback)(
+              monitor->word_this,
+              word->word->best_choice->unichar_string().string(),
+              box.left(), box.right(), box.top(), box.bottom())) {
+        // The app has what it needs. Fake out the rest of the words.
+        for (++i; i < order.size(); ++i) {
+          (*words)[order[i]].word->SetupFake(unicharset);
+        }
+        return false;
+      }
+    }
   }
   return true;
 }
 
+// A word to recognize and its distance from the nearest priority box.
+struct WordPriority {
+  int index;
+  double sq_distance;
+};
+
+// Sorts WordPriority nearest first, and in page order at equal distance.
+static int SortByPriority(const void* a, const void* b) {
+  const WordPriority* pa = static_cast<const WordPriority*>(a);
+  const WordPriority* pb = static_cast<const WordPriority*>(b);
+  if (pa->sq_distance != pb->sq_distance)
+    return pa->sq_distance < pb->sq_distance ? -1 : 1;
+  return pa->index - pb->index;
+}
+
+void Tesseract::PrioritizeWords(const GenericVector<WordData>& words,
+                                GenericVector<int>* order) const {
+  order->truncate(0);
+  GenericVector<WordPriority> priorities;
+  for (int w = 0; w < words.size(); ++w) {
+    TBOX box = words[w].word->word->bounding_box();
+    WordPriority priority = {w, 0.0};
+    for (int b = 0; b < priority_boxes_.size(); ++b) {
+      const TBOX& target = priority_boxes_[b];
+      // The gaps between the boxes, 0 where they overlap.
+      double x_gap = MAX(0, MAX(target.left() - box.right(),
+                                box.left() - target.right()));
+      double y_gap = MAX(0, MAX(target.bottom() - box.top(),
+                                box.bottom() - target.top()));
+      double sq_distance = x_gap * x_gap + y_gap * y_gap;
+      if (b == 0 || sq_distance < priority.sq_distance)
+        priority.sq_distance = sq_distance;
+    }
+    priorities.push_back(priority);
+  }
+  if (!priority_boxes_.empty()) priorities.sort(&SortByPriority);
+  for (int p = 0; p < priorities.size(); ++p)
+    order->push_back(priorities[p].index);
+}
+
+// Reports the progress of pass pass_n, with num_done of words done and word
+// w next, to monitor, and returns true if recognition must stop there, as the
+// user cancelled or, if check_deadline, the deadline has passed.
+bool Tesseract::UpdateWordProgress(int pass_n, int num_done, int w,
+                                   const GenericVector<WordData>& words,
+                                   bool check_deadline, ETEXT_DESC* monitor) {
+  monitor->ocr_alive = TRUE;
+  monitor->words_out_of_time = SegSearchWordsOutOfTime();
+  if (pass_n == 1)
+    monitor->progress = 70 * num_done / words.size();
+  else
+    monitor->progress = 70 + 30 * num_done / words.size();
+  if (monitor->progress_callback != NULL) {
+    TBOX box = words[w].word->word->bounding_box();
+    (*monitor->progress_callback)(monitor->progress_this, monitor->progress,
+            box.left(), box.right(), box.top(), box.bottom());
+  }
+  return (check_deadline && monitor->deadline_exceeded()) ||
+      (monitor->cancel != NULL && (*monitor->cancel)(monitor->cancel_this,
+                                                     words.size()));
+}
+
 /**
  * recog_all_words()
  *
@@ -292,6 +410,9 @@ bool Tesseract::recog_all_words(PAGE_RES* page_res,
                                 const char* word_config,
                                 int dopasses) {
   PAGE_RES_IT page_res_it(page_res);
+  if (monitor != NULL) monitor->timings = &stage_timings_;
+  page_res->fonts_recognized = FALSE;
+  streamed_blocks_.truncate(0);
 
   if (tessedit_minimal_rej_pass1) {
     tessedit_test_adaption.set_value (TRUE);
@@ -299,7 +420,9 @@ bool Tesseract::recog_all_words(PAGE_RES* page_res,
   }
 
   if (dopasses==0 || dopasses==1) {
+    StageTimer pass1_timer(&stage_timings_, STAGE_PASS1);
     page_res_it.restart_page();
+    ResetSegSearchBudgets();
     // ****************** Pass 1 *******************
 
     // If the adaptive classifier is full switch to one we prepared earlier,
@@ -323,7 +446,7 @@ bool Tesseract::recog_all_words(PAGE_RES* page_res,
     // all the input and output classes are ready to run the classifier.
     GenericVector<WordData> words;
     SetupAllWordsPassN(1, target_word_box, word_config, page_res, &words);
-    if (tessedit_parallelize) {
+    if (tessedit_parallelize || tessedit_cluster_glyphs) {
       PrerecAllWordsPar(words);
     }
 
@@ -361,11 +484,33 @@ bool Tesseract::recog_all_words(PAGE_RES* page_res,
     }
   }
 
-  if (dopasses == 1) return true;
+  if (dopasses == 1) {
+    StreamRemainingLines(page_res);
+    return true;
+  }
+
+  // Blocks that are already good skip the rest. The rejection passes pool
+  // their statistics over the page, so they are only skipped when all the
+  // blocks are fast.
+  int num_blocks = 0;
+  int fast_blocks = MarkFastConfidentBlocks(page_res, &num_blocks);
+  bool all_fast = fast_blocks > 0 && fast_blocks == num_blocks;
+  // The fast blocks are final now, unless already streamed by pass 1.
+  if (fast_blocks > 0 && line_callback_ != NULL) {
+    BLOCK_RES_IT block_it(&page_res->block_res_list);
+    for (block_it.mark_cycle_pt(); !block_it.cycled_list();
+         block_it.forward()) {
+      if (block_it.data()->fast_confident)
+        StreamBlockIfFastConfident(page_res, block_it.data());
+    }
+  }
+  int skipped_passes = 0;
 
   // ****************** Pass 2 *******************
   if (tessedit_tess_adaption_mode != 0x0 && !tessedit_test_adaption &&
       AnyTessLang()) {
+    if (fast_blocks > 0) ++skipped_passes;
+    StageTimer pass2_timer(&stage_timings_, STAGE_PASS2);
     page_res_it.restart_page();
     GenericVector<WordData> words;
     SetupAllWordsPassN(2, target_word_box, word_config, page_res, &words);
@@ -385,33 +530,47 @@ bool Tesseract::recog_all_words(PAGE_RES* page_res,
     set_global_loc_code(LOC_FUZZY_SPACE);
 
     if (!tessedit_test_adaption && tessedit_fix_fuzzy_spaces
-        && !tessedit_word_for_word && !right_to_left())
+        && !tessedit_word_for_word && !right_to_left()) {
+      if (fast_blocks > 0) ++skipped_passes;
+      StageTimer timer(&stage_timings_, STAGE_FIX_SPACES);
       fix_fuzzy_spaces(monitor, stats_.word_count, page_res);
+    }
 
     // ****************** Pass 4 *******************
-    if (tessedit_enable_dict_correction) dictionary_correction_pass(page_res);
+    if (tessedit_enable_dict_correction) {
+      if (fast_blocks > 0) ++skipped_passes;
+      dictionary_correction_pass(page_res);
+    }
     if (tessedit_enable_bigram_correction) bigram_correction_pass(page_res);
 
     // ****************** Pass 5,6 *******************
-    rejection_passes(page_res, monitor, target_word_box, word_config);
+    if (all_fast)
+      ++skipped_passes;
+    else
+      rejection_passes(page_res, monitor, target_word_box, word_config);
 
 #ifndef NO_CUBE_BUILD
     // ****************** Pass 7 *******************
     // Cube combiner.
     // If cube is loaded and its combiner is present, run it.
     if (tessedit_ocr_engine_mode == OEM_TESSERACT_CUBE_COMBINED) {
+      StageTimer timer(&stage_timings_, STAGE_CUBE);
       run_cube_combiner(page_res);
     }
 #endif
 
     // ****************** Pass 8 *******************
-    font_recognition_pass(page_res);
+    // The fonts are only recognized when asked for, by
+    // RecognizeFontsIfNeeded.
 
     // ****************** Pass 9 *******************
     // Check the correctness of the final results.
     blamer_pass(page_res);
     script_pos_pass(page_res);
+    if (fast_blocks > 0) ++skipped_passes;
   }
+  PageCounts::Count(COUNTER_FAST_BLOCKS, fast_blocks);
+  PageCounts::Count(COUNTER_SKIPPED_PASSES, skipped_passes * fast_blocks);
 
   // Write results pass.
   set_global_loc_code(LOC_WRITE_RESULTS);
@@ -435,28 +594,127 @@ bool Tesseract::recog_all_words(PAGE_RES* page_res,
       page_res_it.DeleteCurrentWord();
   }
 
+  // Adaption and cube run in the sub-languages on their own words.
+  for (int i = 0; i < sub_langs_.size(); ++i) {
+    stage_timings_.Add(sub_langs_[i]->stage_timings());
+    sub_langs_[i]->mutable_stage_timings()->Clear();
+  }
+  page_counts_.Collect();
   if (monitor != NULL) {
     monitor->progress = 100;
+    monitor->words_out_of_time = SegSearchWordsOutOfTime();
   }
+  StreamRemainingLines(page_res);
   return true;
 }
 
+int Tesseract::MarkFastConfidentBlocks(PAGE_RES* page_res, int* num_blocks) {
+  *num_blocks = 0;
+  PAGE_RES_IT page_res_it(page_res);
+  BLOCK_RES* block = NULL;
+  for (page_res_it.restart_page(); page_res_it.word() != NULL;
+       page_res_it.forward()) {
+    if (page_res_it.block() != block) {
+      block = page_res_it.block();
+      block->fast_confident = tessedit_fast_confident;
+      ++*num_blocks;
+    }
+    if (block->fast_confident && !FastConfidentWord(*page_res_it.word()))
+      block->fast_confident = FALSE;
+  }
+  int fast_blocks = 0;
+  BLOCK_RES_IT block_it(&page_res->block_res_list);
+  for (block_it.mark_cycle_pt(); !block_it.cycled_list(); block_it.forward()) {
+    if (block_it.data()->fast_confident) ++fast_blocks;
+  }
+  return fast_blocks;
+}
+
+bool Tesseract::FastConfidentWord(const WERD_RES& word) {
+  // Words that tesseract did not recognize, or that need their pass 1
+  // post-processing, keep the block for the later passes.
+  return !word.tess_failed && word.rebuild_word != NULL &&
+         word.best_choice != NULL && !word.word->flag(W_REP_CHAR) &&
+         word.best_choice->certainty() >= tessedit_fast_confident_certainty &&
+         acceptable_word_string(*word.uch_set,
+                                word.best_choice->unichar_string().string(),
+                                word.best_choice->unichar_lengths().string())
+             != AC_UNACCEPTABLE;
+}
+
+void Tesseract::StreamBlockLines(PAGE_RES* page_res, BLOCK_RES* block) {
+  if (line_callback_ == NULL || streamed_blocks_.contains(block)) return;
+  streamed_blocks_.push_back(block);
+  PAGE_RES_IT page_res_it(page_res);
+  ROW_RES* row = NULL;
+  for (page_res_it.restart_page(); page_res_it.word() != NULL;
+       page_res_it.forward()) {
+    if (page_res_it.block() != block || page_res_it.row() == row) continue;
+    row = page_res_it.row();
+    line_callback_->Run(page_res_it);
+  }
+}
+
+void Tesseract::StreamRemainingLines(PAGE_RES* page_res) {
+  BLOCK_RES_IT block_it(&page_res->block_res_list);
+  for (block_it.mark_cycle_pt(); !block_it.cycled_list(); block_it.forward())
+    StreamBlockLines(page_res, block_it.data());
+  streamed_blocks_.truncate(0);
+}
+
+void Tesseract::StreamBlockIfFastConfident(PAGE_RES* page_res,
+                                           BLOCK_RES* block) {
+  if (line_callback_ == NULL || !tessedit_fast_confident) return;
+  // The single row modes pick their best row at the very end.
+  PageSegMode pageseg_mode = static_cast<PageSegMode>(
+      static_cast<int>(tessedit_pageseg_mode));
+  if (!PSM_LINE_FIND_ENABLED(pageseg_mode) && !PSM_SPARSE(pageseg_mode))
+    return;
+  PAGE_RES_IT page_res_it(page_res);
+  bool any_words = false;
+  for (page_res_it.restart_page(); page_res_it.word() != NULL;
+       page_res_it.forward()) {
+    if (page_res_it.block() != block) continue;
+    if (!FastConfidentWord(*page_res_it.word())) return;
+    any_words = true;
+  }
+  if (any_words) StreamBlockLines(page_res, block);
+}
+
+void Tesseract::ResetSegSearchBudgets() {
+  ResetSegSearchBudget();
+  for (int i = 0; i < sub_langs_.size(); ++i)
+    sub_langs_[i]->ResetSegSearchBudget();
+}
+
+int Tesseract::SegSearchWordsOutOfTime() const {
+  int count = segsearch_words_out_of_time();
+  for (int i = 0; i < sub_langs_.size(); ++i)
+    count += sub_langs_[i]->segsearch_words_out_of_time();
+  return count;
+}
+
 void Tesseract::bigram_correction_pass(PAGE_RES *page_res) {
   PAGE_RES_IT word_it(page_res);
 
   WERD_RES *w_prev = NULL;
   WERD_RES *w = word_it.word();
+  BLOCK_RES *block = word_it.block();
   while (1) {
     w_prev = w;
+    BLOCK_RES *prev_block = block;
     while (word_it.forward() != NULL &&
            (!word_it.word() || word_it.word()->part_of_combo)) {
       // advance word_it, skipping over parts of combos
     }
     if (!word_it.word()) break;
     w = word_it.word();
+    block = word_it.block();
     if (!w || !w_prev || w->uch_set != w_prev->uch_set) {
       continue;
     }
+    if (prev_block->fast_confident || block->fast_confident)
+      continue;  // The blocks are good enough already.
     if (w_prev->word->flag(W_REP_CHAR) || w->word->flag(W_REP_CHAR)) {
       if (tessedit_bigram_debug) {
         tprintf("Skipping because one of the words is W_REP_CHAR\n");
@@ -686,7 +944,7 @@ void Tesseract::rejection_passes(PAGE_RES* page_res,
 }
 
 void Tesseract::blamer_pass(PAGE_RES* page_res) {
-  if (!wordrec_run_blamer) return;
+  if (!kBlamerEnabled || !wordrec_run_blamer) return;
   PAGE_RES_IT page_res_it(page_res);
   for (page_res_it.restart_page(); page_res_it.word() != NULL;
       page_res_it.forward()) {
@@ -714,6 +972,7 @@ void Tesseract::script_pos_pass(PAGE_RES* page_res) {
   for (page_res_it.restart_page(); page_res_it.word() != NULL;
       page_res_it.forward()) {
     WERD_RES* word = page_res_it.word();
+    if (page_res_it.block()->fast_confident) continue;
      if (word->word->flag(W_REP_CHAR)) {
       page_res_it.forward();
       continue;
@@ -872,30 +1131,47 @@ int Tesseract::RetryWithLanguage(const WordData& word_data,
                                  WordRecognizer recognizer,
                                  WERD_RES** in_word,
                                  PointerVector<WERD_RES>* best_words) {
+  PointerVector<WERD_RES> new_words;
+  RecognizeWithLanguage(word_data, recognizer, in_word, &new_words);
+  return SelectLanguageWords(&new_words, best_words);
+}
+
+// The first half of RetryWithLanguage: runs the recognizer, leaving the
+// output words in new_words.
+void Tesseract::RecognizeWithLanguage(const WordData& word_data,
+                                      WordRecognizer recognizer,
+                                      WERD_RES** in_word,
+                                      PointerVector<WERD_RES>* new_words) {
   bool debug = classify_debug_level || cube_debug_level;
   if (debug) {
     tprintf("Trying word using lang %s, oem %d\n",
             lang.string(), static_cast<int>(tessedit_ocr_engine_mode));
   }
   // Run the recognizer on the word.
-  PointerVector<WERD_RES> new_words;
-  (this->*recognizer)(word_data, in_word, &new_words);
-  if (new_words.empty()) {
+  (this->*recognizer)(word_data, in_word, new_words);
+  if (new_words->empty()) {
     // Transfer input word to new_words, as the classifier must have put
     // the result back in the input.
-    new_words.push_back(*in_word);
+    new_words->push_back(*in_word);
     *in_word = NULL;
   }
   if (debug) {
-    for (int i = 0; i < new_words.size(); ++i)
-      new_words[i]->DebugTopChoice("Lang result");
+    for (int i = 0; i < new_words->size(); ++i)
+      (*new_words)[i]->DebugTopChoice("Lang result");
   }
+}
+
+// The second half of RetryWithLanguage: consumes new_words, moving the
+// better ones to best_words.
+int Tesseract::SelectLanguageWords(PointerVector<WERD_RES>* new_words,
+                                   PointerVector<WERD_RES>* best_words) {
+  bool debug = classify_debug_level || cube_debug_level;
   // Initial version is a bit of a hack based on better certainty and rating
   // (to reduce false positives from cube) or a dictionary vs non-dictionary
   // word.
   return SelectBestWords(classify_max_rating_ratio,
                          classify_max_certainty_margin,
-                         debug, &new_words, best_words);
+                         debug, new_words, best_words);
 }
 
 // Helper returns true if all the words are acceptable.
@@ -921,10 +1197,13 @@ bool Tesseract::ReassignDiacritics(int pass, PAGE_RES_IT* pr_it,
   // Get the noise outlines into a vector with matching bool map.
   GenericVector<C_OUTLINE*> outlines;
   real_word->GetNoiseOutlines(&outlines);
+  PageCounts::Count(COUNTER_DIACRITICS, outlines.size());
   GenericVector<bool> word_wanted;
   GenericVector<bool> overlapped_any_blob;
   GenericVector<C_BLOB*> target_blobs;
-  AssignDiacriticsToOverlappingBlobs(outlines, pass, real_word, pr_it,
+  DiacriticSearch search(noise_maxclassifications > 0 ? noise_maxclassifications
+                                                      : -1);
+  AssignDiacriticsToOverlappingBlobs(outlines, pass, real_word, pr_it, &search,
                                      &word_wanted, &overlapped_any_blob,
                                      &target_blobs);
   // Filter the outlines that overlapped any blob and put them into the word
@@ -946,8 +1225,10 @@ bool Tesseract::ReassignDiacritics(int pass, PAGE_RES_IT* pr_it,
     }
   }
   real_word->AddSelectedOutlines(wanted, wanted_blobs, wanted_outlines, NULL);
-  AssignDiacriticsToNewBlobs(outlines, pass, real_word, pr_it, &word_wanted,
-                             &target_blobs);
+  // The blobs may have changed, so their classifications are stale.
+  search.Clear();
+  AssignDiacriticsToNewBlobs(outlines, pass, real_word, pr_it, &search,
+                             &word_wanted, &target_blobs);
   int non_overlapped = 0;
   int non_overlapped_used = 0;
   for (int i = 0; i < word_wanted.size(); ++i) {
@@ -977,8 +1258,8 @@ bool Tesseract::ReassignDiacritics(int pass, PAGE_RES_IT* pr_it,
 //   true for all outlines that overlapped a blob.
 void Tesseract::AssignDiacriticsToOverlappingBlobs(
     const GenericVector<C_OUTLINE*>& outlines, int pass, WERD* real_word,
-    PAGE_RES_IT* pr_it, GenericVector<bool>* word_wanted,
-    GenericVector<bool>* overlapped_any_blob,
+    PAGE_RES_IT* pr_it, DiacriticSearch* search,
+    GenericVector<bool>* word_wanted, GenericVector<bool>* overlapped_any_blob,
     GenericVector<C_BLOB*>* target_blobs) {
   GenericVector<bool> blob_wanted;
   word_wanted->init_to_size(outlines.size(), false);
@@ -1012,7 +1293,7 @@ void Tesseract::AssignDiacriticsToOverlappingBlobs(
     // by too much. Mark them as wanted.
     if (0 < num_blob_outlines && num_blob_outlines < noise_maxperblob) {
       if (SelectGoodDiacriticOutlines(pass, noise_cert_basechar, pr_it, blob,
-                                      outlines, num_blob_outlines,
+                                      outlines, num_blob_outlines, search,
                                       &blob_wanted)) {
         for (int i = 0; i < blob_wanted.size(); ++i) {
           if (blob_wanted[i]) {
@@ -1030,8 +1311,8 @@ void Tesseract::AssignDiacriticsToOverlappingBlobs(
 // make new blobs out of them.
 void Tesseract::AssignDiacriticsToNewBlobs(
     const GenericVector<C_OUTLINE*>& outlines, int pass, WERD* real_word,
-    PAGE_RES_IT* pr_it, GenericVector<bool>* word_wanted,
-    GenericVector<C_BLOB*>* target_blobs) {
+    PAGE_RES_IT* pr_it, DiacriticSearch* search,
+    GenericVector<bool>* word_wanted, GenericVector<C_BLOB*>* target_blobs) {
   GenericVector<bool> blob_wanted;
   word_wanted->init_to_size(outlines.size(), false);
   target_blobs->init_to_size(outlines.size(), NULL);
@@ -1065,7 +1346,7 @@ void Tesseract::AssignDiacriticsToNewBlobs(
     if ((left_box.x_overlap(total_ol_box) || right_blob == NULL ||
          !right_blob->bounding_box().x_overlap(total_ol_box)) &&
         SelectGoodDiacriticOutlines(pass, noise_cert_disjoint, pr_it, left_blob,
-                                    outlines, num_blob_outlines,
+                                    outlines, num_blob_outlines, search,
                                     &blob_wanted)) {
       if (debug_noise_removal) tprintf("Added to left blob\n");
       for (int j = 0; j < blob_wanted.size(); ++j) {
@@ -1079,7 +1360,8 @@ void Tesseract::AssignDiacriticsToNewBlobs(
                 right_blob->bounding_box().x_overlap(total_ol_box)) &&
                SelectGoodDiacriticOutlines(pass, noise_cert_disjoint, pr_it,
                                            right_blob, outlines,
-                                           num_blob_outlines, &blob_wanted)) {
+                                           num_blob_outlines, search,
+                                           &blob_wanted)) {
       if (debug_noise_removal) tprintf("Added to right blob\n");
       for (int j = 0; j < blob_wanted.size(); ++j) {
         if (blob_wanted[j]) {
@@ -1088,7 +1370,7 @@ void Tesseract::AssignDiacriticsToNewBlobs(
         }
       }
     } else if (SelectGoodDiacriticOutlines(pass, noise_cert_punc, pr_it, NULL,
-                                           outlines, num_blob_outlines,
+                                           outlines, num_blob_outlines, search,
                                            &blob_wanted)) {
       if (debug_noise_removal) tprintf("Fitted between blobs\n");
       for (int j = 0; j < blob_wanted.size(); ++j) {
@@ -1107,15 +1389,19 @@ void Tesseract::AssignDiacriticsToNewBlobs(
 bool Tesseract::SelectGoodDiacriticOutlines(
     int pass, float certainty_threshold, PAGE_RES_IT* pr_it, C_BLOB* blob,
     const GenericVector<C_OUTLINE*>& outlines, int num_outlines,
-    GenericVector<bool>* ok_outlines) {
+    DiacriticSearch* search, GenericVector<bool>* ok_outlines) {
   STRING best_str;
   float target_cert = certainty_threshold;
   if (blob != NULL) {
-    float target_c2;
-    target_cert = ClassifyBlobAsWord(pass, pr_it, blob, &best_str, &target_c2);
+    GenericVector<bool> no_outlines;
+    no_outlines.init_to_size(outlines.size(), false);
+    if (!ClassifyDiacriticSubset(no_outlines, outlines, pass, pr_it, blob,
+                                 search, &target_cert, &best_str)) {
+      return false;
+    }
     if (debug_noise_removal) {
-      tprintf("No Noise blob classified as %s=%g(%g) at:", best_str.string(),
-              target_cert, target_c2);
+      tprintf("No Noise blob classified as %s=%g at:", best_str.string(),
+              target_cert);
       blob->bounding_box().print();
     }
     target_cert -= (target_cert - certainty_threshold) * noise_cert_factor;
@@ -1124,8 +1410,11 @@ bool Tesseract::SelectGoodDiacriticOutlines(
   // Start with all the outlines in.
   STRING all_str;
   GenericVector<bool> best_outlines = *ok_outlines;
-  float best_cert = ClassifyBlobPlusOutlines(test_outlines, outlines, pass,
-                                             pr_it, blob, &all_str);
+  float best_cert;
+  if (!ClassifyDiacriticSubset(test_outlines, outlines, pass, pr_it, blob,
+                               search, &best_cert, &all_str)) {
+    return false;
+  }
   if (debug_noise_removal) {
     TBOX ol_box;
     for (int i = 0; i < test_outlines.size(); ++i) {
@@ -1146,8 +1435,12 @@ bool Tesseract::SelectGoodDiacriticOutlines(
       if (test_outlines[i]) {
         test_outlines[i] = false;
         STRING str;
-        float cert = ClassifyBlobPlusOutlines(test_outlines, outlines, pass,
-                                              pr_it, blob, &str);
+        float cert;
+        if (!ClassifyDiacriticSubset(test_outlines, outlines, pass, pr_it,
+                                     blob, search, &cert, &str)) {
+          test_outlines[i] = true;
+          continue;
+        }
         if (debug_noise_removal) {
           TBOX ol_box;
           for (int j = 0; j < outlines.size(); ++j) {
@@ -1187,6 +1480,39 @@ bool Tesseract::SelectGoodDiacriticOutlines(
   return false;
 }
 
+bool Tesseract::ClassifyDiacriticSubset(
+    const GenericVector<bool>& ok_outlines,
+    const GenericVector<C_OUTLINE*>& outlines, int pass_n, PAGE_RES_IT* pr_it,
+    C_BLOB* blob, DiacriticSearch* search, float* cert, STRING* best_str) {
+  // The subsets are remembered as bit masks, so only for words that have
+  // few enough outlines.
+  bool remember = outlines.size() <= 64;
+  uinT64 mask = 0;
+  if (remember) {
+    for (int i = 0; i < ok_outlines.size(); ++i) {
+      if (ok_outlines[i]) mask |= static_cast<uinT64>(1) << i;
+    }
+    for (int e = 0; e < search->masks.size(); ++e) {
+      if (search->masks[e] == mask && search->blobs[e] == blob) {
+        *cert = search->certs[e];
+        *best_str = search->strs[e];
+        return true;
+      }
+    }
+  }
+  if (search->remaining == 0) return false;
+  if (search->remaining > 0) --search->remaining;
+  *cert = ClassifyBlobPlusOutlines(ok_outlines, outlines, pass_n, pr_it, blob,
+                                   best_str);
+  if (remember) {
+    search->blobs.push_back(blob);
+    search->masks.push_back(mask);
+    search->certs.push_back(*cert);
+    search->strs.push_back(*best_str);
+  }
+  return true;
+}
+
 // Classifies the given blob plus the outlines flagged by ok_outlines, undoes
 // the inclusion of the outlines, and returns the certainty of the raw choice.
 float Tesseract::ClassifyBlobPlusOutlines(
@@ -1259,11 +1585,68 @@ float Tesseract::ClassifyBlobAsWord(int pass_n, PAGE_RES_IT* pr_it,
   return cert;
 }
 
+// Fewest accepted characters in a block before tessedit_lang_gating trusts
+// its script.
+const int kMinGatingChars = 20;
+// Fraction of the accepted characters of a block that must be in one script
+// for tessedit_lang_gating to rule out languages without it.
+const double kMinGatingScriptFraction = 0.95;
+
+// Returns true if tessedit_lang_gating rules out lang for the current block,
+// as the block so far is clearly in a script lang doesn't have.
+bool Tesseract::LanguageGatedOut(const BLOCK* block,
+                                 const Tesseract* lang) const {
+  if (!tessedit_lang_gating || block != gating_block_ ||
+      gating_total_ < kMinGatingChars)
+    return false;
+  for (int s = 0; s < gating_scripts_.size(); ++s) {
+    if (gating_counts_[s] >= gating_total_ * kMinGatingScriptFraction) {
+      // get_script_id_from_name returns the null script for a script that
+      // the unicharset doesn't have.
+      const UNICHARSET& lang_set = lang->unicharset;
+      return lang_set.get_script_id_from_name(gating_scripts_[s].string()) ==
+          lang_set.null_sid();
+    }
+  }
+  return false;
+}
+
+// Counts the scripts of the characters of the result for word_data, if it
+// was accepted, for tessedit_lang_gating. Characters common to all scripts
+// don't count.
+void Tesseract::CountBlockScripts(const WordData& word_data) {
+  if (word_data.block != gating_block_) {
+    gating_block_ = word_data.block;
+    gating_scripts_.truncate(0);
+    gating_counts_.truncate(0);
+    gating_total_ = 0;
+  }
+  const WERD_RES* word = word_data.word;
+  if (word->tess_failed || !word->tess_accepted || word->best_choice == NULL)
+    return;
+  const UNICHARSET& word_set = *word->uch_set;
+  for (int i = 0; i < word->best_choice->length(); ++i) {
+    int script_id = word_set.get_script(word->best_choice->unichar_id(i));
+    if (script_id == word_set.null_sid() || script_id == word_set.common_sid())
+      continue;
+    const char* script = word_set.get_script_from_script_id(script_id);
+    if (strcmp(script, "Inherited") == 0) continue;
+    int s = 0;
+    while (s < gating_scripts_.size() && gating_scripts_[s] != script) ++s;
+    if (s == gating_scripts_.size()) {
+      gating_scripts_.push_back(STRING(script));
+      gating_counts_.push_back(0);
+    }
+    ++gating_counts_[s];
+    ++gating_total_;
+  }
+}
+
 // Generic function for classifying a word. Can be used either for pass1 or
 // pass2 according to the function passed to recognizer.
 // word_data holds the word to be recognized, and its block and row, and
 // pr_it points to the word as well, in case we are running LSTM and it wants
-// to output multiple words.
+// to output multiple words. It may be NULL for recognizers that never do.
 // Recognizes in the current language, and if successful that is all.
 // If recognition was not successful, tries all available languages until
 // it gets a successful result or runs out of languages. Keeps the best result.
@@ -1298,20 +1681,45 @@ void Tesseract::classify_word_and_language(int pass_n, PAGE_RES_IT* pr_it,
       *word_data, recognizer, &word_data->lang_words[sub], &best_words);
   Tesseract* best_lang_tess = most_recently_used_;
   if (!WordsAcceptable(best_words)) {
-    // Try all the other languages to see if they are any better.
-    if (most_recently_used_ != this &&
-        this->RetryWithLanguage(*word_data, recognizer,
-                                &word_data->lang_words[sub_langs_.size()],
-                                &best_words) > 0) {
-      best_lang_tess = this;
-    }
-    for (int i = 0; !WordsAcceptable(best_words) && i < sub_langs_.size();
-         ++i) {
-      if (most_recently_used_ != sub_langs_[i] &&
-          sub_langs_[i]->RetryWithLanguage(*word_data, recognizer,
-                                           &word_data->lang_words[i],
-                                           &best_words) > 0) {
-        best_lang_tess = sub_langs_[i];
+    // Try all the other languages to see if they are any better, in the
+    // order this first, then the sub_langs_.
+    GenericVector<Tesseract*> langs;
+    GenericVector<int> lang_indices;
+    for (int i = -1; i < sub_langs_.size(); ++i) {
+      Tesseract* lang_tess = i < 0 ? this : sub_langs_[i];
+      if (lang_tess != most_recently_used_ &&
+          !LanguageGatedOut(word_data->block, lang_tess)) {
+        langs.push_back(lang_tess);
+        lang_indices.push_back(i < 0 ? sub_langs_.size() : i);
+      }
+    }
+    ThreadPool* pool = langs.size() > 1 ? RecognitionThreadPool() : NULL;
+    if (pool != NULL) {
+      // Recognize with all of them at once, then take the results in order
+      // up to the first acceptable one, as the serial loop would have. The
+      // learning of pass 1 was held back, to be done in the same order.
+      PointerVector<WERD_RES>* results =
+          new PointerVector<WERD_RES>[langs.size()];
+      RecognizeLanguagesPar(recognizer, langs, lang_indices, word_data,
+                            results);
+      for (int l = 0; l < langs.size() && !WordsAcceptable(best_words);
+           ++l) {
+        if (pass_n == 1) {
+          for (int i = 0; i < results[l].size(); ++i)
+            langs[l]->LearnFromWordPass1(results[l][i]);
+        }
+        if (langs[l]->SelectLanguageWords(&results[l], &best_words) > 0)
+          best_lang_tess = langs[l];
+      }
+      delete [] results;
+    } else {
+      for (int l = 0; l < langs.size() && !WordsAcceptable(best_words);
+           ++l) {
+        if (langs[l]->RetryWithLanguage(*word_data, recognizer,
+                                        &word_data->lang_words[lang_indices[l]],
+                                        &best_words) > 0) {
+          best_lang_tess = langs[l];
+        }
       }
     }
   }
@@ -1322,10 +1730,12 @@ void Tesseract::classify_word_and_language(int pass_n, PAGE_RES_IT* pr_it,
       word_data->word->ConsumeWordResults(best_words[0]);
     } else {
       // Words came from LSTM, and must be moved to the PAGE_RES properly.
+      ASSERT_HOST(pr_it != NULL);
       word_data->word = best_words.back();
       pr_it->ReplaceCurrentWord(&best_words);
     }
     ASSERT_HOST(word_data->word->box_word != NULL);
+    if (tessedit_lang_gating) CountBlockScripts(*word_data);
   } else {
     tprintf("no best words!!\n");
   }
@@ -1353,6 +1763,7 @@ void Tesseract::classify_word_pass1(const WordData& word_data,
 #ifndef NO_CUBE_BUILD
   // If we only intend to run cube - run it and return.
   if (tessedit_ocr_engine_mode == OEM_CUBE_ONLY) {
+    StageTimer timer(&stage_timings_, STAGE_CUBE);
     cube_word_pass1(block, row, *in_word);
     return;
   }
@@ -1361,22 +1772,35 @@ void Tesseract::classify_word_pass1(const WordData& word_data,
   match_word_pass_n(1, word, row, block);
   if (!word->tess_failed && !word->word->flag(W_REP_CHAR)) {
     word->tess_would_adapt = AdaptableWord(word);
-    bool adapt_ok = word_adaptable(word, tessedit_tess_adaption_mode);
-
-    if (adapt_ok) {
-      // Send word to adaptive classifier for training.
-      word->BestChoiceToCorrectText();
-      LearnWord(NULL, word);
-      // Mark misadaptions if running blamer.
-      if (word->blamer_bundle != NULL) {
-        word->blamer_bundle->SetMisAdaptionDebug(word->best_choice,
-                                                 wordrec_debug_blamer);
-      }
-    }
+  }
+  if (!recognizing_in_parallel_) LearnFromWordPass1(word);
+}
+
+// Adapts to the result of pass 1 on word if it is good enough, and adds it to
+// the document dictionary. Returns true if it was added to that.
+bool Tesseract::LearnFromWordPass1(WERD_RES* word) {
+  if (word->tess_failed || word->word->flag(W_REP_CHAR) ||
+      tessedit_ocr_engine_mode == OEM_CUBE_ONLY)
+    return false;
+  bool adapt_ok = word_adaptable(word, tessedit_tess_adaption_mode);
 
-    if (tessedit_enable_doc_dict && !word->IsAmbiguous())
-      tess_add_doc_word(word->best_choice);
+  if (adapt_ok) {
+    // Send word to adaptive classifier for training.
+    StageTimer timer(&stage_timings_, STAGE_ADAPTION);
+    // The adapted configs record the font of the word.
+    set_word_fonts(word);
+    word->BestChoiceToCorrectText();
+    LearnWord(NULL, word);
+    // Mark misadaptions if running blamer.
+    if (kBlamerEnabled && word->blamer_bundle != NULL) {
+      word->blamer_bundle->SetMisAdaptionDebug(word->best_choice,
+                                               wordrec_debug_blamer);
+    }
   }
+
+  if (!tessedit_enable_doc_dict || word->IsAmbiguous()) return false;
+  tess_add_doc_word(word->best_choice);
+  return true;
 }
 
 // Helper to report the result of the xheight fix.
@@ -1402,8 +1826,10 @@ void Tesseract::ReportXhtFixResult(bool accept_new_word, float new_x_ht,
 // Returns true if the word was changed.
 // See the comment in fixxht.cpp for a description of the overall process.
 bool Tesseract::TrainedXheightFix(WERD_RES *word, BLOCK* block, ROW *row) {
-  int original_misfits = CountMisfitTops(word);
-  if (original_misfits == 0)
+  int num_tops = 0;
+  int original_misfits = CountMisfitTops(word, &num_tops);
+  if (original_misfits == 0 ||
+      original_misfits < x_ht_min_misfit_fraction * num_tops)
     return false;
   float baseline_shift = 0.0f;
   float new_x_ht = ComputeCompatibleXheight(word, &baseline_shift);
@@ -1451,6 +1877,7 @@ bool Tesseract::TestNewNormalization(int original_misfits,
         unicharset, this, BestPix(), tessedit_ocr_engine_mode, NULL,
         classify_bln_numeric_mode, textord_use_cjk_fp_model,
       poly_allow_detailed_fx, row, block);
+  PageCounts::Count(COUNTER_XHEIGHT_TRIES, 1);
   match_word_pass_n(2, &new_x_ht_word, row, block);
   if (!new_x_ht_word.tess_failed) {
     int new_misfits = CountMisfitTops(&new_x_ht_word);
@@ -1474,6 +1901,7 @@ bool Tesseract::TestNewNormalization(int original_misfits,
     }
   }
   if (accept_new_x_ht) {
+    PageCounts::Count(COUNTER_XHEIGHT_FIXES, 1);
     word->ConsumeWordResults(&new_x_ht_word);
     return true;
   }
@@ -1572,7 +2000,7 @@ void Tesseract::match_word_pass_n(int pass_n, WERD_RES *word,
       make_reject_map(word, row, pass_n);
     }
   }
-  set_word_fonts(word);
+  // The fonts are set by RecognizeFontsIfNeeded, when they are wanted.
 
   ASSERT_HOST(word->raw_choice != NULL);
 }
@@ -1906,6 +2334,11 @@ void Tesseract::set_word_fonts(WERD_RES *word) {
         font_total_score[fontinfo_id] += fonts[f].score;
       }
     }
+    // Without classify_blob_fonts there is only the best font, which gets
+    // a perfect score.
+    int fontinfo_id = choice->fontinfo_id();
+    if (fonts.empty() && 0 <= fontinfo_id && fontinfo_id < fontinfo_size)
+      font_total_score[fontinfo_id] += MAX_UINT16;
   }
   // Find the top and 2nd choice for the word.
   int score1 = 0, score2 = 0;
@@ -1950,6 +2383,20 @@ void Tesseract::set_word_fonts(WERD_RES *word) {
 }
 
 
+void Tesseract::RecognizeFontsIfNeeded(PAGE_RES* page_res) {
+  if (page_res->fonts_recognized) return;
+  page_res->fonts_recognized = TRUE;
+  // The fonts of each word are those of the language that recognized it.
+  PAGE_RES_IT page_res_it(page_res);
+  for (page_res_it.restart_page(); page_res_it.word() != NULL;
+       page_res_it.forward()) {
+    WERD_RES* word = page_res_it.word();
+    if (word->tesseract != NULL && word->best_choice != NULL)
+      word->tesseract->set_word_fonts(word);
+  }
+  font_recognition_pass(page_res);
+}
+
 /**
  * font_recognition_pass
  *
@@ -1996,6 +2443,7 @@ void Tesseract::font_recognition_pass(PAGE_RES* page_res) {
   // Assign modal font to weak words.
   for (page_res_it.restart_page(); page_res_it.word() != NULL;
        page_res_it.forward()) {
+    if (page_res_it.block()->fast_confident) continue;
     word = page_res_it.word();
     int length = word->best_choice->length();
 
@@ -2017,6 +2465,8 @@ void Tesseract::dictionary_correction_pass(PAGE_RES *page_res) {
   PAGE_RES_IT word_it(page_res);
   for (WERD_RES* word = word_it.word(); word != NULL;
        word = word_it.forward()) {
+    if (word_it.block()->fast_confident)
+      continue;  // The block is good enough already.
     if (word->best_choices.singleton())
       continue;  // There are no alternates.
 
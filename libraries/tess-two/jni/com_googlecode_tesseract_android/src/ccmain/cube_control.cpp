@@ -202,6 +202,13 @@ void Tesseract::run_cube_combiner(PAGE_RES *page_res) {
   if (page_res == NULL || tess_cube_combiner_ == NULL)
     return;
   PAGE_RES_IT page_res_it(page_res);
+  int combiner_run_thresh = convert_prob_to_tess_certainty(
+      cube_cntxt_->Params()->CombinerRunThresh());
+  // Counts of the words seen, and of those not given to cube because
+  // tesseract's result is certain enough, or an accepted dictionary word.
+  int word_count = 0;
+  int certain_count = 0;
+  int accepted_count = 0;
   // Iterate through the word results and call cube on each word.
   for (page_res_it.restart_page(); page_res_it.word () != NULL;
        page_res_it.forward()) {
@@ -209,14 +216,27 @@ void Tesseract::run_cube_combiner(PAGE_RES *page_res) {
     if (block->poly_block() != NULL && !block->poly_block()->IsText())
       continue;  // Don't deal with non-text blocks.
     WERD_RES* word = page_res_it.word();
+    ++word_count;
     // Skip cube entirely if tesseract's certainty is greater than threshold.
-    int combiner_run_thresh = convert_prob_to_tess_certainty(
-        cube_cntxt_->Params()->CombinerRunThresh());
     if (word->best_choice->certainty() >= combiner_run_thresh) {
+      ++certain_count;
       continue;
     }
     // Use the same language as Tesseract used for the word.
     Tesseract* lang_tess = word->tesseract;
+    // Optionally trust Tesseract on a dictionary word with an acceptable case
+    // and punctuation pattern and a fair certainty, and save running cube.
+    // The combiner might still have preferred cube's answer, so this can
+    // change the output, and is off by default.
+    if (cube_combiner_skip_accepted &&
+        word->best_choice->certainty() >= cube_combiner_skip_certainty &&
+        lang_tess->getDict().valid_word(*word->best_choice) &&
+        lang_tess->acceptable_word_string(
+            *word->uch_set, word->best_choice->unichar_string().string(),
+            word->best_choice->unichar_lengths().string()) != AC_UNACCEPTABLE) {
+      ++accepted_count;
+      continue;
+    }
 
     // Setup a trial WERD_RES in which to classify with cube.
     WERD_RES cube_word;
@@ -232,6 +252,12 @@ void Tesseract::run_cube_combiner(PAGE_RES *page_res) {
       lang_tess->cube_combine_word(cube_obj, &cube_word, word);
     delete cube_obj;
   }
+  if (cube_debug_level > 0) {
+    tprintf("Cube combiner: ran cube on %d of %d words, skipping %d certain"
+            " and %d accepted dictionary words\n",
+            word_count - certain_count - accepted_count, word_count,
+            certain_count, accepted_count);
+  }
 }
 
 /**
@@ -86,6 +86,30 @@ bool CubeRecoContext::GetDataFilePath(string *path) const {
   return true;
 }
 
+/**
+ * Returns the bytes of memory held by the models, estimated from the sizes
+ * of the data files they are loaded from.
+ */
+int CubeRecoContext::MemoryUsed() const {
+  static const char* const kModelFiles[] = {
+    ".cube.lm", ".cube.bigrams", ".cube.word-freq", ".cube.size",
+    ".cube.params", ".cube.nn", ".cube.hybrid", ".cube.fold",
+    ".tesseract_cube.nn"
+  };
+  string data_file_path;
+  if (!GetDataFilePath(&data_file_path)) return 0;
+  int bytes = 0;
+  const int kNumModelFiles = sizeof(kModelFiles) / sizeof(kModelFiles[0]);
+  for (int i = 0; i < kNumModelFiles; ++i) {
+    string file_name = data_file_path + lang_ + kModelFiles[i];
+    FILE *fp = fopen(file_name.c_str(), "rb");
+    if (fp == NULL) continue;
+    if (fseek(fp, 0, SEEK_END) == 0) bytes += ftell(fp);
+    fclose(fp);
+  }
+  return bytes;
+}
+
 /**
  * The object initialization function that loads all the necessary
  * components of a RecoContext.  TessdataManager is used to load the
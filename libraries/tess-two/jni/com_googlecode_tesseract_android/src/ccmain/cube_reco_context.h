@@ -124,6 +124,10 @@ class CubeRecoContext {
 
   // Returns the path of the data files
   bool GetDataFilePath(string *path) const;
+  // Returns the bytes of memory held by the models, and by the combiner net
+  // that goes with them. They are held in about as many bytes as their data
+  // files take, so the sizes of the files stand for them.
+  int MemoryUsed() const;
   // Creates a CubeRecoContext object using a tesseract object. Data
   // files are loaded via the tessdata_manager, and the tesseract
   // unicharset is provided in order to map Cube's unicharset to
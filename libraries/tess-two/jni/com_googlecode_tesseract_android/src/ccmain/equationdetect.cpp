@@ -246,18 +246,14 @@ BlobSpecialTextType EquationDetect::EstimateTypeForUnichar(
 
   if (unicharset.get_ispunctuation(id)) {
     // Exclude some special texts that are likely to be confused as math symbol.
-    static GenericVector<UNICHAR_ID> ids_to_exclude;
-    if (ids_to_exclude.empty()) {
-      static const STRING kCharsToEx[] = {"'", "`", "\"", "\\", ",", ".",
-          "〈", "〉", "《", "》", "」", "「", ""};
-      int i = 0;
-      while (kCharsToEx[i] != "") {
-        ids_to_exclude.push_back(
-            unicharset.unichar_to_id(kCharsToEx[i++].string()));
-      }
-      ids_to_exclude.sort();
+    // They are compared as text, as the ids depend on the unicharset, and
+    // different instances may use different ones at the same time.
+    static const char* const kCharsToEx[] = {"'", "`", "\"", "\\", ",", ".",
+        "〈", "〉", "《", "》", "」", "「", NULL};
+    for (int i = 0; kCharsToEx[i] != NULL; ++i) {
+      if (strcmp(s.string(), kCharsToEx[i]) == 0) return BSTT_NONE;
     }
-    return ids_to_exclude.bool_binary_search(id) ? BSTT_NONE : BSTT_MATH;
+    return BSTT_MATH;
   }
 
   // Check if it is digit. In addition to the isdigit attribute, we also check
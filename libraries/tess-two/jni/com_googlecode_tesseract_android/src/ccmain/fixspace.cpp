@@ -62,6 +62,7 @@ void Tesseract::fix_fuzzy_spaces(ETEXT_DESC *monitor,
   word_index = 0;
   for (block_res_it.mark_cycle_pt(); !block_res_it.cycled_list();
        block_res_it.forward()) {
+    if (block_res_it.data()->fast_confident) continue;
     row_res_it.set_to_list(&block_res_it.data()->row_res_list);
     for (row_res_it.mark_cycle_pt(); !row_res_it.cycled_list();
          row_res_it.forward()) {
@@ -156,9 +157,21 @@ void Tesseract::fix_fuzzy_space_list(WERD_RES_LIST &best_perm,
   if (best_score != PERFECT_WERDS)
     initialise_search(best_perm, current_perm);
 
+  // Each permutation only changes the words that it joins, so only those
+  // are recognized and scored again.
+  GenericVector<WordSpacingTerms> terms;
+  GenericVector<WERD_RES*> changed;
   while ((best_score != PERFECT_WERDS) && !current_perm.empty()) {
+    changed.truncate(0);
+    WERD_RES_IT word_it(&current_perm);
+    for (word_it.mark_cycle_pt(); !word_it.cycled_list(); word_it.forward()) {
+      WERD_RES* word = word_it.data();
+      if (!word->part_of_combo && word->box_word == NULL)
+        changed.push_back(word);
+    }
     match_current_words(current_perm, row, block);
-    current_score = eval_word_spacing(current_perm);
+    update_word_spacing_terms(current_perm, changed, &terms);
+    current_score = score_word_spacing(terms);
     dump_words(current_perm, current_score, 2, improved);
     if (current_score > best_score) {
       best_perm.clear();
@@ -167,7 +180,7 @@ void Tesseract::fix_fuzzy_space_list(WERD_RES_LIST &best_perm,
       improved = TRUE;
     }
     if (current_score < PERFECT_WERDS)
-      transform_to_next_perm(current_perm);
+      transform_to_next_perm(current_perm, fixsp_max_combo_blobs);
   }
   dump_words(best_perm, best_score, 3, improved);
 }
@@ -237,104 +250,137 @@ void Tesseract::match_current_words(WERD_RES_LIST &words, ROW *row,
  *
  */
 inT16 Tesseract::eval_word_spacing(WERD_RES_LIST &word_res_list) {
-  WERD_RES_IT word_res_it(&word_res_list);
+  GenericVector<WordSpacingTerms> terms;
+  GenericVector<WERD_RES*> changed;
+  update_word_spacing_terms(word_res_list, changed, &terms);
+  return score_word_spacing(terms);
+}
+
+// Returns whether c, which is not the end of the string, is in chars.
+static bool CharIsIn(const char* chars, char c) {
+  return c != '\0' && strchr(chars, c) != NULL;
+}
+
+void Tesseract::word_spacing_terms(WERD_RES *word, WordSpacingTerms *terms) {
+  terms->word = word;
+  terms->failed = word->tess_failed;
+  if (terms->failed) return;
+  const char* str = word->best_choice->unichar_string().string();
+  const char* lengths = word->best_choice->unichar_lengths().string();
+  int word_len = word->reject_map.length();
+  bool word_done = fixspace_thinks_word_done(word);
+  terms->done = word_done;
+  terms->length = word_len;
+  terms->starts_with_digit = digit_or_numeric_punct(word, 0);
+  terms->starts_with_1 =
+      (word_done && lengths[0] == 1 && str[0] == '1') ||
+      (!word_done && CharIsIn(conflict_set_I_l_1.string(), str[0]));
+
+  /* Add 1 to total score for every joined 1 regardless of context and
+     rejtn */
+  int i;
+  int offset;
+  int joined = 0;
+  bool prev_char_1 = false;
+  for (i = 0; i < word_len; i++) {
+    bool current_char_1 = str[i] == '1';
+    if (prev_char_1 || (current_char_1 && (i > 0)))
+      joined++;
+    prev_char_1 = current_char_1;
+  }
+
+  /* Add 1 to total score for every joined punctuation regardless of context
+    and rejtn */
+  if (tessedit_prefer_joined_punct) {
+    const char* punct_chars = "!\"`',.:;";
+    bool prev_char_punct = false;
+    for (i = 0, offset = 0; i < word_len; offset += lengths[i++]) {
+      bool current_char_punct = CharIsIn(punct_chars, str[offset]);
+      if (prev_char_punct || (current_char_punct && i > 0))
+        joined++;
+      prev_char_punct = current_char_punct;
+    }
+  }
+  terms->joined_score = joined;
+  terms->ends_with_digit = digit_or_numeric_punct(word, word_len - 1);
+  for (i = 0, offset = 0; i < word_len - 1; offset += lengths[i++]);
+  terms->ends_with_1 =
+      (word_done && str[offset] == '1') ||
+      (!word_done && CharIsIn(conflict_set_I_l_1.string(), str[offset]));
+}
+
+void Tesseract::update_word_spacing_terms(
+    WERD_RES_LIST &words, const GenericVector<WERD_RES*> &changed,
+    GenericVector<WordSpacingTerms> *terms) {
+  GenericVector<WordSpacingTerms> old_terms;
+  old_terms.move(terms);
+  int old_index = 0;
+  int changed_index = 0;
+  WERD_RES_IT word_it(&words);
+  for (word_it.mark_cycle_pt(); !word_it.cycled_list(); word_it.forward()) {
+    WERD_RES* word = word_it.data();
+    if (word->part_of_combo && !word_it.at_first()) continue;
+    WordSpacingTerms word_terms;
+    if (changed_index < changed.size() && changed[changed_index] == word) {
+      ++changed_index;
+      word_spacing_terms(word, &word_terms);
+    } else {
+      // The words keep their order, so the old terms are found in order too.
+      while (old_index < old_terms.size() && old_terms[old_index].word != word)
+        ++old_index;
+      if (old_index < old_terms.size())
+        word_terms = old_terms[old_index++];
+      else
+        word_spacing_terms(word, &word_terms);
+    }
+    terms->push_back(word_terms);
+  }
+}
+
+inT16 Tesseract::score_word_spacing(
+    const GenericVector<WordSpacingTerms> &terms) {
   inT16 total_score = 0;
-  inT16 word_count = 0;
   inT16 done_word_count = 0;
-  inT16 word_len;
-  inT16 i;
-  inT16 offset;
-  WERD_RES *word;                 // current word
   inT16 prev_word_score = 0;
-  BOOL8 prev_word_done = FALSE;
-  BOOL8 prev_char_1 = FALSE;      // prev ch a "1/I/l"?
-  BOOL8 prev_char_digit = FALSE;  // prev ch 2..9 or 0
-  BOOL8 current_char_1 = FALSE;
-  BOOL8 current_word_ok_so_far;
-  STRING punct_chars = "!\"`',.:;";
-  BOOL8 prev_char_punct = FALSE;
-  BOOL8 current_char_punct = FALSE;
-  BOOL8 word_done = FALSE;
-
-  do {
-    word = word_res_it.data();
-    word_done = fixspace_thinks_word_done(word);
-    word_count++;
-    if (word->tess_failed) {
+  bool prev_word_done = false;
+  bool prev_char_1 = false;      // prev ch a "1/I/l"?
+  bool prev_char_digit = false;  // prev ch 2..9 or 0
+
+  for (int w = 0; w < terms.size(); ++w) {
+    const WordSpacingTerms& word = terms[w];
+    if (word.failed) {
       total_score += prev_word_score;
       if (prev_word_done)
         done_word_count++;
       prev_word_score = 0;
-      prev_char_1 = FALSE;
-      prev_char_digit = FALSE;
-      prev_word_done = FALSE;
-    } else {
-      /*
-        Can we add the prev word score and potentially count this word?
-        Yes IF it didn't end in a 1 when the first char of this word is a digit
-          AND it didn't end in a digit when the first char of this word is a 1
-      */
-      word_len = word->reject_map.length();
-      current_word_ok_so_far = FALSE;
-      if (!((prev_char_1 && digit_or_numeric_punct(word, 0)) ||
-            (prev_char_digit && (
-                (word_done &&
-                 word->best_choice->unichar_lengths().string()[0] == 1 &&
-                 word->best_choice->unichar_string()[0] == '1') ||
-                (!word_done && STRING(conflict_set_I_l_1).contains(
-                      word->best_choice->unichar_string()[0])))))) {
-        total_score += prev_word_score;
-        if (prev_word_done)
-          done_word_count++;
-        current_word_ok_so_far = word_done;
-      }
-
-      if (current_word_ok_so_far) {
-        prev_word_done = TRUE;
-        prev_word_score = word_len;
-      } else {
-        prev_word_done = FALSE;
-        prev_word_score = 0;
-      }
-
-      /* Add 1 to total score for every joined 1 regardless of context and
-         rejtn */
-      for (i = 0, prev_char_1 = FALSE; i < word_len; i++) {
-        current_char_1 = word->best_choice->unichar_string()[i] == '1';
-        if (prev_char_1 || (current_char_1 && (i > 0)))
-          total_score++;
-        prev_char_1 = current_char_1;
-      }
-
-      /* Add 1 to total score for every joined punctuation regardless of context
-        and rejtn */
-      if (tessedit_prefer_joined_punct) {
-        for (i = 0, offset = 0, prev_char_punct = FALSE; i < word_len;
-             offset += word->best_choice->unichar_lengths()[i++]) {
-          current_char_punct =
-            punct_chars.contains(word->best_choice->unichar_string()[offset]);
-          if (prev_char_punct || (current_char_punct && i > 0))
-            total_score++;
-          prev_char_punct = current_char_punct;
-        }
-      }
-      prev_char_digit = digit_or_numeric_punct(word, word_len - 1);
-      for (i = 0, offset = 0; i < word_len - 1;
-           offset += word->best_choice->unichar_lengths()[i++]);
-      prev_char_1 =
-          ((word_done && (word->best_choice->unichar_string()[offset] == '1'))
-           || (!word_done && STRING(conflict_set_I_l_1).contains(
-                   word->best_choice->unichar_string()[offset])));
+      prev_char_1 = false;
+      prev_char_digit = false;
+      prev_word_done = false;
+      continue;
     }
-    /* Find next word */
-    do {
-      word_res_it.forward();
-    } while (word_res_it.data()->part_of_combo);
-  } while (!word_res_it.at_first());
+    /*
+      Can we add the prev word score and potentially count this word?
+      Yes IF it didn't end in a 1 when the first char of this word is a digit
+        AND it didn't end in a digit when the first char of this word is a 1
+    */
+    bool current_word_ok_so_far = false;
+    if (!((prev_char_1 && word.starts_with_digit) ||
+          (prev_char_digit && word.starts_with_1))) {
+      total_score += prev_word_score;
+      if (prev_word_done)
+        done_word_count++;
+      current_word_ok_so_far = word.done;
+    }
+    prev_word_done = current_word_ok_so_far;
+    prev_word_score = current_word_ok_so_far ? word.length : 0;
+    total_score += word.joined_score;
+    prev_char_digit = word.ends_with_digit;
+    prev_char_1 = word.ends_with_1;
+  }
   total_score += prev_word_score;
   if (prev_word_done)
     done_word_count++;
-  if (done_word_count == word_count)
+  if (done_word_count == terms.size())
     return PERFECT_WERDS;
   else
     return total_score;
@@ -364,12 +410,18 @@ BOOL8 Tesseract::digit_or_numeric_punct(WERD_RES *word, int char_position) {
  * the word list closing any gaps of this size by either inserted new
  * combination words, or extending existing ones.
  *
- * The routine COULD be limited to stop it building words longer than N blobs.
+ * If max_combo_blobs > 0, gaps are not closed where that would build a word
+ * of more than max_combo_blobs blobs.
  *
  * If there are no more gaps then it DELETES the entire list and returns the
  * empty list to cause termination.
  */
-void transform_to_next_perm(WERD_RES_LIST &words) {
+// Returns the number of blobs of word, including those of a combination.
+static int WordBlobCount(WERD_RES *word) {
+  return word->word->cblob_list()->length();
+}
+
+void transform_to_next_perm(WERD_RES_LIST &words, int max_combo_blobs) {
   WERD_RES_IT word_it(&words);
   WERD_RES_IT prev_word_it(&words);
   WERD_RES *word;
@@ -380,17 +432,21 @@ void transform_to_next_perm(WERD_RES_LIST &words) {
   TBOX box;
   inT16 gap;
   inT16 min_gap = MAX_INT16;
+  int prev_blobs = 0;
 
   for (word_it.mark_cycle_pt(); !word_it.cycled_list(); word_it.forward()) {
     word = word_it.data();
     if (!word->part_of_combo) {
       box = word->word->bounding_box();
-      if (prev_right > -MAX_INT16) {
+      int blobs = WordBlobCount(word);
+      if (prev_right > -MAX_INT16 &&
+          (max_combo_blobs <= 0 || prev_blobs + blobs <= max_combo_blobs)) {
         gap = box.left() - prev_right;
         if (gap < min_gap)
           min_gap = gap;
       }
       prev_right = box.right();
+      prev_blobs = blobs;
     }
   }
   if (min_gap < MAX_INT16) {
@@ -404,7 +460,10 @@ void transform_to_next_perm(WERD_RES_LIST &words) {
         box = word->word->bounding_box();
         if (prev_right > -MAX_INT16) {
           gap = box.left() - prev_right;
-          if (gap <= min_gap) {
+          if (gap <= min_gap &&
+              (max_combo_blobs <= 0 ||
+               WordBlobCount(prev_word_it.data()) + WordBlobCount(word) <=
+                   max_combo_blobs)) {
             prev_word = prev_word_it.data();
             if (prev_word->combination) {
               combo = prev_word;
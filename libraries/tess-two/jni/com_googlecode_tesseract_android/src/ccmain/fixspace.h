@@ -25,7 +25,21 @@
 #include          "pageres.h"
 #include          "params.h"
 
+// The parts of the eval_word_spacing score of a word that depend on the word
+// alone, so they need only be worked out again when it is re-recognized.
+struct WordSpacingTerms {
+  WERD_RES* word;
+  bool failed;             // tess_failed, and none of the rest is set.
+  bool done;               // fixspace_thinks_word_done.
+  int length;              // Score of the word if it is done.
+  int joined_score;        // Score for 1s and punctuation joined inside it.
+  bool starts_with_digit;
+  bool starts_with_1;      // A 1, or an I/l/1 lookalike if not done.
+  bool ends_with_digit;
+  bool ends_with_1;
+};
+
 void initialise_search(WERD_RES_LIST &src_list, WERD_RES_LIST &new_list);
-void transform_to_next_perm(WERD_RES_LIST &words);
+void transform_to_next_perm(WERD_RES_LIST &words, int max_combo_blobs);
 void fixspace_dbg(WERD_RES *word);
 #endif
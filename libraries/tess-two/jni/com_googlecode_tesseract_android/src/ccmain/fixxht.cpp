@@ -66,8 +66,9 @@ namespace tesseract {
 const int kMaxCharTopRange = 48;
 
 // Returns the number of misfit blob tops in this word.
-int Tesseract::CountMisfitTops(WERD_RES *word_res) {
+int Tesseract::CountMisfitTops(WERD_RES *word_res, int* num_tops) {
   int bad_blobs = 0;
+  int tops = 0;
   int num_blobs = word_res->rebuild_word->NumBlobs();
   for (int blob_id = 0; blob_id < num_blobs; ++blob_id) {
     TBLOB* blob = word_res->rebuild_word->blobs[blob_id];
@@ -81,6 +82,7 @@ int Tesseract::CountMisfitTops(WERD_RES *word_res) {
                                 &min_top, &max_top);
       if (max_top - min_top > kMaxCharTopRange)
         continue;
+      ++tops;
       bool bad =  top < min_top - x_ht_acceptance_tolerance ||
                   top > max_top + x_ht_acceptance_tolerance;
       if (bad)
@@ -93,6 +95,7 @@ int Tesseract::CountMisfitTops(WERD_RES *word_res) {
       }
     }
   }
+  if (num_tops != NULL) *num_tops = tops;
   return bad_blobs;
 }
 
@@ -0,0 +1,147 @@
+///////////////////////////////////////////////////////////////////////
+// File:        framehistory.cpp
+// Description: Memory of the previous frame of a video stream, used to
+//              recognize only the text lines that changed.
+//
+// (C) Copyright 2016, Google Inc.
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////
+
+#include "framehistory.h"
+
+#include <math.h>
+#include <stdlib.h>
+
+#include "allheaders.h"
+
+namespace tesseract {
+
+FrameHistory::FrameHistory() : binary_(NULL), dx_(0), dy_(0) {}
+
+FrameHistory::~FrameHistory() {
+  Clear();
+}
+
+void FrameHistory::Clear() {
+  pixDestroy(&binary_);
+  dx_ = dy_ = 0;
+  lines_.clear();
+}
+
+void FrameHistory::Reset(Pix* binary) {
+  Clear();
+  binary_ = pixClone(binary);
+}
+
+void FrameHistory::SetFrame(Pix* binary) {
+  pixDestroy(&binary_);
+  binary_ = pixClone(binary);
+}
+
+bool FrameHistory::Align(Pix* binary, int max_shift) {
+  if (binary_ == NULL || binary == NULL ||
+      pixGetWidth(binary) != pixGetWidth(binary_) ||
+      pixGetHeight(binary) != pixGetHeight(binary_))
+    return false;
+  Numa* prev_rows = pixCountPixelsByRow(binary_, NULL);
+  Numa* rows = pixCountPixelsByRow(binary, NULL);
+  Numa* prev_cols = pixCountPixelsByColumn(binary_);
+  Numa* cols = pixCountPixelsByColumn(binary);
+  int dx = 0, dy = 0;
+  bool found = BestShift(prev_rows, rows, max_shift, &dy) &&
+               BestShift(prev_cols, cols, max_shift, &dx);
+  numaDestroy(&prev_rows);
+  numaDestroy(&rows);
+  numaDestroy(&prev_cols);
+  numaDestroy(&cols);
+  if (!found) return false;
+  dx_ = dx;
+  dy_ = dy;
+  if (dx != 0 || dy != 0) {
+    Pix* moved = pixTranslate(NULL, binary_, dx, dy, L_BRING_IN_WHITE);
+    pixDestroy(&binary_);
+    binary_ = moved;
+    for (int i = 0; i < lines_.size(); ++i) {
+      lines_[i].left += dx;
+      lines_[i].top += dy;
+    }
+  }
+  return true;
+}
+
+double FrameHistory::ChangedFraction(Pix* binary, int left, int top,
+                                     int width, int height) const {
+  Box* box = boxCreate(left, top, width, height);
+  Pix* prev_part = pixClipRectangle(binary_, box, NULL);
+  Pix* part = pixClipRectangle(binary, box, NULL);
+  boxDestroy(&box);
+  if (prev_part == NULL || part == NULL) {
+    pixDestroy(&prev_part);
+    pixDestroy(&part);
+    return 1.0;
+  }
+  l_int32 prev_count = 0, count = 0, changed = 0;
+  pixCountPixels(prev_part, &prev_count, NULL);
+  pixCountPixels(part, &count, NULL);
+  pixXor(part, part, prev_part);
+  pixCountPixels(part, &changed, NULL);
+  pixDestroy(&prev_part);
+  pixDestroy(&part);
+  int total = prev_count + count;
+  return total > 0 ? static_cast<double>(changed) / total : 0.0;
+}
+
+double FrameHistory::ChangedFractionOutsideLines(Pix* binary) const {
+  l_int32 prev_count = 0, count = 0, changed = 0;
+  pixCountPixels(binary_, &prev_count, NULL);
+  pixCountPixels(binary, &count, NULL);
+  Pix* diff = pixXor(NULL, binary, binary_);
+  for (int i = 0; i < lines_.size(); ++i) {
+    const FrameLine& line = lines_[i];
+    Box* box = boxCreate(line.left, line.top, line.width, line.height);
+    pixClearInRect(diff, box);
+    boxDestroy(&box);
+  }
+  pixCountPixels(diff, &changed, NULL);
+  pixDestroy(&diff);
+  int total = prev_count + count;
+  return total > 0 ? static_cast<double>(changed) / total : 0.0;
+}
+
+bool FrameHistory::BestShift(Numa* previous, Numa* current, int max_shift,
+                             int* shift) {
+  int n = numaGetCount(current);
+  if (numaGetCount(previous) != n) return false;
+  l_float32* prev_counts = numaGetFArray(previous, L_NOCOPY);
+  l_float32* counts = numaGetFArray(current, L_NOCOPY);
+  if (max_shift > n / 2) max_shift = n / 2;
+  int best_shift = 0;
+  double best_score = 0.0;
+  // Try 0, 1, -1, 2, -2... so that ties go to the smallest shift.
+  for (int step = 0; step <= 2 * max_shift; ++step) {
+    int s = step % 2 == 0 ? -step / 2 : (step + 1) / 2;
+    int start = s > 0 ? s : 0;
+    int end = s < 0 ? n + s : n;
+    double sum = 0.0;
+    for (int i = start; i < end; ++i)
+      sum += fabs(counts[i] - prev_counts[i - s]);
+    double score = end > start ? sum / (end - start) : 0.0;
+    if (step == 0 || score < best_score) {
+      best_score = score;
+      best_shift = s;
+    }
+  }
+  *shift = best_shift;
+  return max_shift == 0 || abs(best_shift) < max_shift;
+}
+
+}  // namespace tesseract
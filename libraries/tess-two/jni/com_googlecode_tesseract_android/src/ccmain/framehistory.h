@@ -0,0 +1,104 @@
+///////////////////////////////////////////////////////////////////////
+// File:        framehistory.h
+// Description: Memory of the previous frame of a video stream, used to
+//              recognize only the text lines that changed.
+//
+// (C) Copyright 2016, Google Inc.
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////
+
+#ifndef TESSERACT_CCMAIN_FRAMEHISTORY_H_
+#define TESSERACT_CCMAIN_FRAMEHISTORY_H_
+
+#include "genericvector.h"
+#include "strngs.h"
+
+struct Numa;
+struct Pix;
+
+namespace tesseract {
+
+// A text line recognized in a frame, with its box in image coordinates
+// (top-down, as a leptonica Box).
+struct FrameLine {
+  FrameLine() : left(0), top(0), width(0), height(0), confidence(0) {}
+
+  int left;
+  int top;
+  int width;
+  int height;
+  STRING text;
+  int confidence;
+};
+
+// Holds the thresholded image and the recognized text lines of the last
+// frame of a video stream. For the next frame, Align estimates the global
+// motion between the two frames from their row and column projections, and
+// ChangedFraction then tells which lines differ enough to be recognized
+// again. The result of all other lines can be reused.
+class FrameHistory {
+ public:
+  FrameHistory();
+  ~FrameHistory();
+
+  // Forgets the previous frame and its lines.
+  void Clear();
+  // Returns true if there is no previous frame.
+  bool empty() const { return binary_ == NULL; }
+
+  // Makes binary the previous frame, keeping a clone of it, with no lines.
+  void Reset(Pix* binary);
+  // Replaces the previous frame with binary, keeping the lines, which must
+  // already be in the coordinates of binary, as after Align.
+  void SetFrame(Pix* binary);
+
+  const GenericVector<FrameLine>& lines() const { return lines_; }
+  GenericVector<FrameLine>* mutable_lines() { return &lines_; }
+
+  // Finds the shift, of at most max_shift pixels each way, that best maps
+  // the previous frame onto binary, then moves the previous frame and the
+  // lines by it. Returns false if the frames differ in size or no shift
+  // within range matches, in which case nothing is changed.
+  bool Align(Pix* binary, int max_shift);
+  // The shift found by the last successful Align.
+  int dx() const { return dx_; }
+  int dy() const { return dy_; }
+
+  // Returns the number of differing black pixels between the aligned
+  // previous frame and binary, inside the given rectangle, as a fraction of
+  // the black pixels of both, so 0 means identical and 1 completely
+  // different.
+  double ChangedFraction(Pix* binary, int left, int top,
+                         int width, int height) const;
+  // Returns the number of differing black pixels outside all the lines, as
+  // a fraction of all the black pixels of both frames. A large value means
+  // that text has appeared where there was none before.
+  double ChangedFractionOutsideLines(Pix* binary) const;
+
+ private:
+  // Finds the shift of current against previous, which are projection
+  // profiles, that has the smallest mean absolute difference. Returns false
+  // if the best shift is at the limit of the search, as the true shift is
+  // then probably outside it.
+  static bool BestShift(Numa* previous, Numa* current, int max_shift,
+                        int* shift);
+
+  // Previous frame, moved by the last Align.
+  Pix* binary_;
+  int dx_;
+  int dy_;
+  GenericVector<FrameLine> lines_;
+};
+
+}  // namespace tesseract
+
+#endif  // TESSERACT_CCMAIN_FRAMEHISTORY_H_
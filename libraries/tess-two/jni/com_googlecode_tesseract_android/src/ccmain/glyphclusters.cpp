@@ -0,0 +1,92 @@
+///////////////////////////////////////////////////////////////////////
+// File:        glyphclusters.cpp
+// Description: Groups the blobs of a page by shape, so that each distinct
+//              shape need only be classified once.
+//
+// (C) Copyright 2016, Google Inc.
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////
+
+#include "glyphclusters.h"
+
+#include <stdlib.h>
+
+#include "allheaders.h"
+#include "stepblob.h"
+
+namespace tesseract {
+
+// Weight of the template's foreground in the correlation threshold, to be
+// more tolerant of heavy glyphs, as used by the jbclass correlation
+// examples.
+const float kCorrelationWeight = 0.6f;
+
+// Returns true if the normalized boxes a and b differ by at most max_diff
+// on every side.
+static bool SimilarNormBoxes(const TBOX& a, const TBOX& b, int max_diff) {
+  return abs(a.left() - b.left()) <= max_diff &&
+         abs(a.right() - b.right()) <= max_diff &&
+         abs(a.bottom() - b.bottom()) <= max_diff &&
+         abs(a.top() - b.top()) <= max_diff;
+}
+
+void ClusterGlyphs(const GenericVector<PageGlyph>& glyphs, double thresh,
+                   int max_norm_diff, GenericVector<int>* reps) {
+  int num_glyphs = glyphs.size();
+  reps->truncate(0);
+  for (int g = 0; g < num_glyphs; ++g) reps->push_back(g);
+  if (num_glyphs < 2) return;
+  JBCLASSER* classer = jbCorrelationInit(JB_CONN_COMPS, 0, 0, thresh,
+                                         kCorrelationWeight);
+  if (classer == NULL) return;
+  // The glyphs that render to something, as the components of the classer.
+  GenericVector<int> comp_glyphs;
+  Boxa* boxa = boxaCreate(num_glyphs);
+  Pixa* pixa = pixaCreate(num_glyphs);
+  for (int g = 0; g < num_glyphs; ++g) {
+    TBOX box = glyphs[g].blob->bounding_box();
+    if (box.null_box() || box.area() == 0) continue;
+    // Only the size of the boxes matters to the classifier.
+    boxaAddBox(boxa, boxCreate(box.left(), box.bottom(), box.width(),
+                               box.height()), L_INSERT);
+    pixaAddPix(pixa, glyphs[g].blob->render(), L_INSERT);
+    comp_glyphs.push_back(g);
+  }
+  if (!comp_glyphs.empty() &&
+      jbClassifyCorrelation(classer, boxa, pixa) == 0) {
+    // The representatives found so far of each class, which split it by
+    // normalized box.
+    GenericVector<GenericVector<int> > class_reps;
+    class_reps.init_to_size(classer->nclass, GenericVector<int>());
+    for (int c = 0; c < comp_glyphs.size(); ++c) {
+      int g = comp_glyphs[c];
+      int class_id = 0;
+      numaGetIValue(classer->naclass, c, &class_id);
+      GenericVector<int>* cluster_reps = &class_reps[class_id];
+      int r = 0;
+      while (r < cluster_reps->size() &&
+             !SimilarNormBoxes(glyphs[(*cluster_reps)[r]].norm_box,
+                               glyphs[g].norm_box, max_norm_diff)) {
+        ++r;
+      }
+      if (r < cluster_reps->size())
+        (*reps)[g] = (*cluster_reps)[r];
+      else
+        cluster_reps->push_back(g);
+    }
+  }
+  pixaDestroy(&pixa);
+  boxaDestroy(&boxa);
+  jbClasserDestroy(&classer);
+}
+
+}  // namespace tesseract
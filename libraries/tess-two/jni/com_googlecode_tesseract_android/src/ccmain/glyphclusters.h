@@ -0,0 +1,51 @@
+///////////////////////////////////////////////////////////////////////
+// File:        glyphclusters.h
+// Description: Groups the blobs of a page by shape, so that each distinct
+//              shape need only be classified once.
+//
+// (C) Copyright 2016, Google Inc.
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////
+
+#ifndef TESSERACT_CCMAIN_GLYPHCLUSTERS_H_
+#define TESSERACT_CCMAIN_GLYPHCLUSTERS_H_
+
+#include "genericvector.h"
+#include "rect.h"
+
+class C_BLOB;
+
+namespace tesseract {
+
+// A blob of a page to cluster: its outlines, in image coordinates, and the
+// box of its baseline-normalized copy that the classifier sees.
+struct PageGlyph {
+  PageGlyph() : blob(NULL) {}
+  PageGlyph(C_BLOB* b, const TBOX& box) : blob(b), norm_box(box) {}
+
+  C_BLOB* blob;
+  TBOX norm_box;
+};
+
+// Sets (*reps)[g] to the index of the glyph that represents glyph g, which
+// is the first glyph of its cluster, so g itself if it starts one. Glyphs
+// are clustered by leptonica's correlation classifier (as jbclass does for
+// JBIG2) with the given correlation threshold, and then a cluster is split
+// wherever the normalized boxes differ by more than max_norm_diff on any
+// side, as the classifier also rates the position of a blob relative to
+// the baseline and the x-height.
+void ClusterGlyphs(const GenericVector<PageGlyph>& glyphs, double thresh,
+                   int max_norm_diff, GenericVector<int>* reps);
+
+}  // namespace tesseract
+
+#endif  // TESSERACT_CCMAIN_GLYPHCLUSTERS_H_
@@ -30,9 +30,10 @@ namespace tesseract {
 LTRResultIterator::LTRResultIterator(PAGE_RES* page_res, Tesseract* tesseract,
                                      int scale, int scaled_yres,
                                      int rect_left, int rect_top,
-                                     int rect_width, int rect_height)
+                                     int rect_width, int rect_height,
+                                     int reduction)
   : PageIterator(page_res, tesseract, scale, scaled_yres,
-                 rect_left, rect_top, rect_width, rect_height),
+                 rect_left, rect_top, rect_width, rect_height, reduction),
     line_separator_("\n"),
     paragraph_separator_("\n") {
 }
@@ -53,6 +54,7 @@ char* LTRResultIterator::GetUTF8Text(PageIteratorLevel level) const {
   } else if (level == RIL_WORD) {
     text = best_choice->unichar_string();
   } else {
+    DetectParagraphsIfNeeded();
     bool eol = false;  // end of line?
     bool eop = false;  // end of paragraph?
     do {  // for each paragraph in a block
@@ -109,6 +111,7 @@ float LTRResultIterator::Confidence(PageIteratorLevel level) const {
       } while (res_it.block() == res_it.prev_block());
       break;
     case RIL_PARA:
+      DetectParagraphsIfNeeded();
       do {
         best_choice = res_it.word()->best_choice;
         ASSERT_HOST(best_choice != NULL);
@@ -170,6 +173,7 @@ const char* LTRResultIterator::WordFontAttributes(bool* is_bold,
                                                   int* pointsize,
                                                   int* font_id) const {
   if (it_->word() == NULL) return NULL;  // Already at the end!
+  if (tesseract_ != NULL) tesseract_->RecognizeFontsIfNeeded(page_res_);
   if (it_->word()->fontinfo == NULL) {
     *font_id = -1;
     return NULL;  // No font information.
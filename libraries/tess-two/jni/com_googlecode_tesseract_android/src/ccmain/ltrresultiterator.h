@@ -57,11 +57,13 @@ class TESS_API LTRResultIterator : public PageIterator {
   // must be divided by scale before adding (rect_left, rect_top).
   // The scaled_yres indicates the effective resolution of the binary image
   // that tesseract has been given by the Thresholder.
+  // The reduction is in case the Thresholder reduced the image rectangle
+  // instead, and coordinates in tesseract's image are then multiplied by it.
   // After the constructor, Begin has already been called.
   LTRResultIterator(PAGE_RES* page_res, Tesseract* tesseract,
                     int scale, int scaled_yres,
                     int rect_left, int rect_top,
-                    int rect_width, int rect_height);
+                    int rect_width, int rect_height, int reduction = 1);
   virtual ~LTRResultIterator();
 
   // LTRResultIterators may be copied! This makes it possible to iterate over
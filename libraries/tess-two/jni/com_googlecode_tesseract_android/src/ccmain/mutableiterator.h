@@ -47,10 +47,10 @@ class MutableIterator : public ResultIterator {
   MutableIterator(PAGE_RES* page_res, Tesseract* tesseract,
                   int scale, int scaled_yres,
                   int rect_left, int rect_top,
-                  int rect_width, int rect_height)
+                  int rect_width, int rect_height, int reduction = 1)
       : ResultIterator(
           LTRResultIterator(page_res, tesseract, scale, scaled_yres, rect_left,
-                            rect_top, rect_width, rect_height)) {}
+                            rect_top, rect_width, rect_height, reduction)) {}
   virtual ~MutableIterator() {}
 
   // See PageIterator and ResultIterator for most calls.
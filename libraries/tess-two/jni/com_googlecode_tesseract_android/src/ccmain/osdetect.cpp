@@ -30,8 +30,10 @@
 #include "ratngs.h"
 #include "strngs.h"
 #include "tabvector.h"
+#include "tesscallback.h"
 #include "tesseractclass.h"
 #include "textord.h"
+#include "threadpool.h"
 
 const int kMinCharactersToTry = 50;
 const int kMaxCharactersToTry = 5 * kMinCharactersToTry;
@@ -175,7 +177,7 @@ void remove_nontext_regions(tesseract::Tesseract *tess, BLOCK_LIST *blocks,
 
   tesseract::LineFinder::FindAndRemoveLines(resolution, false, pix,
                                             &vertical_x, &vertical_y,
-                                            NULL, &v_lines, &h_lines);
+                                            NULL, &v_lines, &h_lines, NULL);
   Pix* im_pix = tesseract::ImageFind::FindImages(pix);
   if (im_pix != NULL) {
     pixSubtract(pix, pix, im_pix);
@@ -267,6 +269,72 @@ int os_detect(TO_BLOCK_LIST* port_blocks, OSResults* osr,
   return os_detect_blobs(NULL, &filtered_list, osr, tess);
 }
 
+// Classifies the blob in each of the 4 orientations into ratings[0..3].
+// Only reads the classifier, so blobs may be classified concurrently.
+static void ClassifyRotations(BLOBNBOX* bbox, tesseract::Tesseract* tess,
+                              BLOB_CHOICE_LIST* ratings) {
+  C_BLOB* blob = bbox->cblob();
+  TBLOB* tblob = TBLOB::PolygonalCopy(tess->poly_allow_detailed_fx, blob);
+  TBOX box = tblob->bounding_box();
+  FCOORD current_rotation(1.0f, 0.0f);
+  FCOORD rotation90(0.0f, 1.0f);
+  // Test the 4 orientations
+  for (int i = 0; i < 4; ++i) {
+    // Normalize the blob. Set the origin to the place we want to be the
+    // bottom-middle after rotation.
+    // Scaling is to make the rotated height the x-height.
+    float scaling = static_cast<float>(kBlnXHeight) / box.height();
+    float x_origin = (box.left() + box.right()) / 2.0f;
+    float y_origin = (box.bottom() + box.top()) / 2.0f;
+    if (i == 0 || i == 2) {
+      // Rotation is 0 or 180.
+      y_origin = i == 0 ? box.bottom() : box.top();
+    } else {
+      // Rotation is 90 or 270.
+      scaling = static_cast<float>(kBlnXHeight) / box.width();
+      x_origin = i == 1 ? box.left() : box.right();
+    }
+    TBLOB* rotated_blob = new TBLOB(*tblob);
+    rotated_blob->Normalize(NULL, &current_rotation, NULL,
+                            x_origin, y_origin, scaling, scaling,
+                            0.0f, static_cast<float>(kBlnBaselineOffset),
+                            false, NULL);
+    tess->AdaptiveClassifier(rotated_blob, ratings + i);
+    delete rotated_blob;
+    current_rotation.rotate(rotation90);
+  }
+  delete tblob;
+}
+
+// Adds the ratings of a blob in the 4 orientations to the detectors.
+// Return true if estimate of orientation and script satisfies stopping
+// criteria.
+static bool DetectFromRatings(BLOB_CHOICE_LIST* ratings,
+                              OrientationDetector* o, ScriptDetector* s) {
+  bool stop = o->detect_blob(ratings);
+  s->detect_blob(ratings);
+  int orientation = o->get_orientation();
+  stop = s->must_stop(orientation) && stop;
+  return stop;
+}
+
+// The blobs tried by os_detect_blobs, in sequence order, with their ratings
+// in the 4 orientations, 4 lists per blob.
+struct OSDetectBlobs {
+  BLOBNBOX** blobs;
+  BLOB_CHOICE_LIST* ratings;
+  tesseract::Tesseract* tess;
+  // First blob of the round being classified.
+  int start;
+};
+
+// Classifies blob start + b of the job. Each blob has its own ratings, so
+// the calls may run concurrently.
+static void ClassifyOSDetectBlob(OSDetectBlobs* job, int b) {
+  int index = job->start + b;
+  ClassifyRotations(job->blobs[index], job->tess, job->ratings + 4 * index);
+}
+
 // Detect orientation and script from a list of blobs.
 // Returns a non-zero number of blobs if the list was successfully processed, or
 // zero if the list had too few characters to be reliable.
@@ -281,7 +349,8 @@ int os_detect_blobs(const GenericVector<int>* allowed_scripts,
     osr = &osr_;
 
   osr->unicharset = &tess->unicharset;
-  OrientationDetector o(allowed_scripts, osr);
+  OrientationDetector o(allowed_scripts, osr,
+                        2.0 * tess->min_orientation_margin);
   ScriptDetector s(allowed_scripts, osr, tess);
 
   BLOBNBOX_C_IT filtered_it(blob_list);
@@ -302,16 +371,56 @@ int os_detect_blobs(const GenericVector<int>* allowed_scripts,
        filtered_it.forward ()) {
     blobs[number_of_blobs++] = (BLOBNBOX*)filtered_it.data();
   }
+  OSDetectBlobs job;
+  job.blobs = new BLOBNBOX*[real_max];
+  job.ratings = new BLOB_CHOICE_LIST[4 * real_max];
+  job.tess = tess;
+  job.start = 0;
   QRSequenceGenerator sequence(number_of_blobs);
+  for (int i = 0; i < real_max; ++i)
+    job.blobs[i] = blobs[sequence.GetVal()];
+  delete [] blobs;
+
+  tess->tess_cn_matching.set_value(true); // turn it on
+  tess->tess_bn_matching.set_value(false);
+  // The blobs are classified in rounds, concurrently if there is a thread
+  // pool, and then given to the detectors in sequence order, so the result
+  // is that of the serial loop. As there is no stopping before blob
+  // kMinCharactersToTry + 1, the first round goes up to it, and after that
+  // each round has a blob per thread, so at most one round is wasted.
+  tesseract::ThreadPool* pool = tess->RecognitionThreadPool();
+  TessCallback1<int>* classify = NULL;
+  int round_size = 1;
+  if (pool != NULL) {
+    tess->SetClassifyFromSnapshot(true);
+    classify = NewPermanentTessCallback(&ClassifyOSDetectBlob, &job);
+    round_size = MAX(kMinCharactersToTry + 2, pool->num_threads());
+  }
   int num_blobs_evaluated = 0;
-  for (int i = 0; i < real_max; ++i) {
-    if (os_detect_blob(blobs[sequence.GetVal()], &o, &s, osr, tess)
-        && i > kMinCharactersToTry) {
-      break;
+  bool stop = false;
+  while (!stop && job.start < real_max) {
+    int end = MIN(job.start + round_size, real_max);
+    if (classify != NULL)
+      pool->ParallelFor(end - job.start, classify);
+    else
+      ClassifyOSDetectBlob(&job, 0);
+    for (int i = job.start; i < end; ++i) {
+      if (DetectFromRatings(job.ratings + 4 * i, &o, &s) &&
+          i > kMinCharactersToTry) {
+        stop = true;
+        break;
+      }
+      ++num_blobs_evaluated;
     }
-    ++num_blobs_evaluated;
+    job.start = end;
+    if (pool != NULL) round_size = pool->num_threads();
   }
-  delete [] blobs;
+  if (classify != NULL) {
+    delete classify;
+    tess->SetClassifyFromSnapshot(false);
+  }
+  delete [] job.blobs;
+  delete [] job.ratings;
 
   // Make sure the best_result is up-to-date
   int orientation = o.get_orientation();
@@ -327,51 +436,17 @@ bool os_detect_blob(BLOBNBOX* bbox, OrientationDetector* o,
                     tesseract::Tesseract* tess) {
   tess->tess_cn_matching.set_value(true); // turn it on
   tess->tess_bn_matching.set_value(false);
-  C_BLOB* blob = bbox->cblob();
-  TBLOB* tblob = TBLOB::PolygonalCopy(tess->poly_allow_detailed_fx, blob);
-  TBOX box = tblob->bounding_box();
-  FCOORD current_rotation(1.0f, 0.0f);
-  FCOORD rotation90(0.0f, 1.0f);
   BLOB_CHOICE_LIST ratings[4];
-  // Test the 4 orientations
-  for (int i = 0; i < 4; ++i) {
-    // Normalize the blob. Set the origin to the place we want to be the
-    // bottom-middle after rotation.
-    // Scaling is to make the rotated height the x-height.
-    float scaling = static_cast<float>(kBlnXHeight) / box.height();
-    float x_origin = (box.left() + box.right()) / 2.0f;
-    float y_origin = (box.bottom() + box.top()) / 2.0f;
-    if (i == 0 || i == 2) {
-      // Rotation is 0 or 180.
-      y_origin = i == 0 ? box.bottom() : box.top();
-    } else {
-      // Rotation is 90 or 270.
-      scaling = static_cast<float>(kBlnXHeight) / box.width();
-      x_origin = i == 1 ? box.left() : box.right();
-    }
-    TBLOB* rotated_blob = new TBLOB(*tblob);
-    rotated_blob->Normalize(NULL, &current_rotation, NULL,
-                            x_origin, y_origin, scaling, scaling,
-                            0.0f, static_cast<float>(kBlnBaselineOffset),
-                            false, NULL);
-    tess->AdaptiveClassifier(rotated_blob, ratings + i);
-    delete rotated_blob;
-    current_rotation.rotate(rotation90);
-  }
-  delete tblob;
-
-  bool stop = o->detect_blob(ratings);
-  s->detect_blob(ratings);
-  int orientation = o->get_orientation();
-  stop = s->must_stop(orientation) && stop;
-  return stop;
+  ClassifyRotations(bbox, tess, ratings);
+  return DetectFromRatings(ratings, o, s);
 }
 
-
 OrientationDetector::OrientationDetector(
-    const GenericVector<int>* allowed_scripts, OSResults* osr) {
+    const GenericVector<int>* allowed_scripts, OSResults* osr,
+    double min_margin) {
   osr_ = osr;
   allowed_scripts_ = allowed_scripts;
+  min_margin_ = min_margin;
 }
 
 // Score the given blob and return true if it is now sure of the orientation
@@ -436,9 +511,9 @@ bool OrientationDetector::detect_blob(BLOB_CHOICE_LIST* scores) {
     osr_->orientations[i] += log(blob_o_score[i] / total_blob_o_score);
   }
 
-  // TODO(ranjith) Add an early exit test, based on min_orientation_margin,
-  // as used in pagesegmain.cpp.
-  return false;
+  // Sure once the best orientation leads the next by min_margin_.
+  osr_->update_best_orientation();
+  return osr_->best_result.oconfidence > min_margin_;
 }
 
 int OrientationDetector::get_orientation() {
@@ -81,13 +81,16 @@ struct OSResults {
 
 class OrientationDetector {
  public:
+  // The orientation is taken to be sure once the log score of the best one
+  // exceeds that of the next by min_margin.
   OrientationDetector(const GenericVector<int>* allowed_scripts,
-                      OSResults* results);
+                      OSResults* results, double min_margin);
   bool detect_blob(BLOB_CHOICE_LIST* scores);
   int get_orientation();
  private:
   OSResults* osr_;
   const GenericVector<int>* allowed_scripts_;
+  double min_margin_;
 };
 
 class ScriptDetector {
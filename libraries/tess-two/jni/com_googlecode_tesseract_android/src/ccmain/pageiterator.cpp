@@ -28,7 +28,7 @@ namespace tesseract {
 
 PageIterator::PageIterator(PAGE_RES* page_res, Tesseract* tesseract, int scale,
                            int scaled_yres, int rect_left, int rect_top,
-                           int rect_width, int rect_height)
+                           int rect_width, int rect_height, int reduction)
     : page_res_(page_res),
       tesseract_(tesseract),
       word_(NULL),
@@ -38,6 +38,7 @@ PageIterator::PageIterator(PAGE_RES* page_res, Tesseract* tesseract, int scale,
       include_upper_dots_(false),
       include_lower_dots_(false),
       scale_(scale),
+      reduction_(reduction),
       scaled_yres_(scaled_yres),
       rect_left_(rect_left),
       rect_top_(rect_top),
@@ -67,6 +68,7 @@ PageIterator::PageIterator(const PageIterator& src)
       include_upper_dots_(src.include_upper_dots_),
       include_lower_dots_(src.include_lower_dots_),
       scale_(src.scale_),
+      reduction_(src.reduction_),
       scaled_yres_(src.scaled_yres_),
       rect_left_(src.rect_left_),
       rect_top_(src.rect_top_),
@@ -82,6 +84,7 @@ const PageIterator& PageIterator::operator=(const PageIterator& src) {
   include_upper_dots_ = src.include_upper_dots_;
   include_lower_dots_ = src.include_lower_dots_;
   scale_ = src.scale_;
+  reduction_ = src.reduction_;
   scaled_yres_ = src.scaled_yres_;
   rect_left_ = src.rect_left_;
   rect_top_ = src.rect_top_;
@@ -106,10 +109,23 @@ void PageIterator::Begin() {
   BeginWord(0);
 }
 
+void PageIterator::DetectParagraphsIfNeeded() const {
+  if (page_res_ != NULL) page_res_->DetectParagraphsIfNeeded();
+}
+
 void PageIterator::RestartParagraph() {
   if (it_->block() == NULL) return; // At end of the document.
+  DetectParagraphsIfNeeded();
   PAGE_RES_IT para(page_res_);
   PAGE_RES_IT next_para(para);
+  // Paragraphs don't span blocks, so find the start of the block first, and
+  // leave the paragraphs of other blocks alone.
+  next_para.forward_block();
+  while (next_para.cmp(*it_) <= 0) {
+    para = next_para;
+    next_para.forward_block();
+  }
+  next_para = para;
   next_para.forward_paragraph();
   while (next_para.cmp(*it_) <= 0) {
     para = next_para;
@@ -153,6 +169,7 @@ bool PageIterator::Next(PageIteratorLevel level) {
       it_->forward_block();
       break;
     case RIL_PARA:
+      DetectParagraphsIfNeeded();
       it_->forward_paragraph();
       break;
     case RIL_TEXTLINE:
@@ -188,6 +205,7 @@ bool PageIterator::IsAtBeginningOf(PageIteratorLevel level) const {
     case RIL_BLOCK:
       return blob_index_ == 0 && it_->block() != it_->prev_block();
     case RIL_PARA:
+      DetectParagraphsIfNeeded();
       return blob_index_ == 0 &&
           (it_->block() != it_->prev_block() ||
            it_->row()->row->para() != it_->prev_row()->row->para());
@@ -274,6 +292,7 @@ bool PageIterator::BoundingBoxInternal(PageIteratorLevel level,
                                                          include_lower_dots_);
       break;
     case RIL_PARA:
+      DetectParagraphsIfNeeded();
       para = it_->row()->row->para();
       // explicit fall-through.
     case RIL_TEXTLINE:
@@ -333,13 +352,15 @@ bool PageIterator::BoundingBox(PageIteratorLevel level, const int padding,
   if (!BoundingBoxInternal(level, left, top, right, bottom))
     return false;
   // Convert to the coordinate system of the original image.
-  *left = ClipToRange(*left / scale_ + rect_left_ - padding,
+  *left = ClipToRange(*left * reduction_ / scale_ + rect_left_ - padding,
                       rect_left_, rect_left_ + rect_width_);
-  *top = ClipToRange(*top / scale_ + rect_top_ - padding,
+  *top = ClipToRange(*top * reduction_ / scale_ + rect_top_ - padding,
                      rect_top_, rect_top_ + rect_height_);
-  *right = ClipToRange((*right + scale_ - 1) / scale_ + rect_left_ + padding,
+  *right = ClipToRange((*right * reduction_ + scale_ - 1) / scale_ +
+                       rect_left_ + padding,
                        *left, rect_left_ + rect_width_);
-  *bottom = ClipToRange((*bottom + scale_ - 1) / scale_ + rect_top_ + padding,
+  *bottom = ClipToRange((*bottom * reduction_ + scale_ - 1) / scale_ +
+                        rect_top_ + padding,
                         *top, rect_top_ + rect_height_);
   return true;
 }
@@ -372,11 +393,13 @@ Pta* PageIterator::BlockPolygon() const {
   ICOORDELT_IT it(it_->block()->block->poly_block()->points());
   Pta* pta = ptaCreate(it.length());
   int num_pts = 0;
+  // Height of tesseract's image, to flip y within it.
+  float height = pixGetHeight(tesseract_->pix_binary());
   for (it.mark_cycle_pt(); !it.cycled_list(); it.forward(), ++num_pts) {
     ICOORD* pt = it.data();
     // Convert to top-down coords within the input image.
-    float x = static_cast<float>(pt->x()) / scale_ + rect_left_;
-    float y = rect_top_ + rect_height_ - static_cast<float>(pt->y()) / scale_;
+    float x = static_cast<float>(pt->x()) * reduction_ / scale_ + rect_left_;
+    float y = rect_top_ + (height - pt->y()) * reduction_ / scale_;
     ptaAddPt(pta, x, y);
   }
   return pta;
@@ -499,10 +522,12 @@ bool PageIterator::Baseline(PageIteratorLevel level,
   // Rotate to image coordinates and convert to global image coords.
   startpt.rotate(it_->block()->block->re_rotation());
   endpt.rotate(it_->block()->block->re_rotation());
-  *x1 = startpt.x() / scale_ + rect_left_;
-  *y1 = (rect_height_ - startpt.y()) / scale_ + rect_top_;
-  *x2 = endpt.x() / scale_ + rect_left_;
-  *y2 = (rect_height_ - endpt.y()) / scale_ + rect_top_;
+  // Height of tesseract's image, to flip y within it.
+  int height = pixGetHeight(tesseract_->pix_binary());
+  *x1 = startpt.x() * reduction_ / scale_ + rect_left_;
+  *y1 = (height - startpt.y()) * reduction_ / scale_ + rect_top_;
+  *x2 = endpt.x() * reduction_ / scale_ + rect_left_;
+  *y2 = (height - endpt.y()) * reduction_ / scale_ + rect_top_;
   return true;
 }
 
@@ -557,6 +582,7 @@ void PageIterator::ParagraphInfo(tesseract::ParagraphJustification *just,
                                  bool *is_crown,
                                  int *first_line_indent) const {
   *just = tesseract::JUSTIFICATION_UNKNOWN;
+  DetectParagraphsIfNeeded();
   if (!it_->row() || !it_->row()->row || !it_->row()->row->para() ||
       !it_->row()->row->para()->model)
     return;
@@ -614,7 +640,7 @@ void PageIterator::BeginWord(int offset) {
 }
 
 bool PageIterator::SetWordBlamerBundle(BlamerBundle *blamer_bundle) {
-  if (it_->word() != NULL) {
+  if (kBlamerEnabled && it_->word() != NULL) {
     it_->word()->blamer_bundle = blamer_bundle;
     return true;
   } else {
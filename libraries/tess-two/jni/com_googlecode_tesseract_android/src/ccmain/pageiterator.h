@@ -63,12 +63,14 @@ class TESS_API PageIterator {
    * must be divided by scale before adding (rect_left, rect_top).
    * The scaled_yres indicates the effective resolution of the binary image
    * that tesseract has been given by the Thresholder.
+   * The reduction is in case the Thresholder reduced the image rectangle
+   * instead, and coordinates in tesseract's image are then multiplied by it.
    * After the constructor, Begin has already been called.
    */
   PageIterator(PAGE_RES* page_res, Tesseract* tesseract,
                int scale, int scaled_yres,
                int rect_left, int rect_top,
-               int rect_width, int rect_height);
+               int rect_width, int rect_height, int reduction = 1);
   virtual ~PageIterator();
 
   /**
@@ -312,7 +314,8 @@ class TESS_API PageIterator {
 
   // If the current WERD_RES (it_->word()) is not NULL, sets the BlamerBundle
   // of the current word to the given pointer (takes ownership of the pointer)
-  // and returns true.
+  // and returns true. Returns false, without taking ownership, in builds
+  // without the blamer (NO_BLAMER).
   // Can only be used when iterating on the word level.
   bool SetWordBlamerBundle(BlamerBundle *blamer_bundle);
 
@@ -323,6 +326,12 @@ class TESS_API PageIterator {
    */
   TESS_LOCAL void BeginWord(int offset);
 
+  /**
+   * Detects the paragraphs of the page, if the API put that off until they
+   * are needed. Must be called before reading the paragraphs of rows.
+   */
+  TESS_LOCAL void DetectParagraphsIfNeeded() const;
+
   /** Pointer to the page_res owned by the API. */
   PAGE_RES* page_res_;
   /** Pointer to the Tesseract object owned by the API. */
@@ -352,6 +361,7 @@ class TESS_API PageIterator {
   bool include_lower_dots_;
   /** Parameters saved from the Thresholder. Needed to rebuild coordinates.*/
   int scale_;
+  int reduction_;
   int scaled_yres_;
   int rect_left_;
   int rect_top_;
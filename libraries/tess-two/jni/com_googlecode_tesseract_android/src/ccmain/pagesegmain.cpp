@@ -36,15 +36,21 @@
 #include "allheaders.h"
 #include "blobbox.h"
 #include "blread.h"
+#include "ccnontextdetect.h"
 #include "colfind.h"
 #include "equationdetect.h"
 #include "imagefind.h"
 #include "linefind.h"
 #include "makerow.h"
+#include "ocrclass.h"
 #include "osdetect.h"
+#include "strokewidth.h"
 #include "tabvector.h"
+#include "tesscallback.h"
 #include "tesseractclass.h"
+#include "threadpool.h"
 #include "tessvars.h"
+#include "textlineprojection.h"
 #include "textord.h"
 #include "tordmain.h"
 #include "wordseg.h"
@@ -53,6 +59,30 @@ namespace tesseract {
 
 // Max erosions to perform in removing an enclosing circle.
 const int kMaxCircleErosions = 8;
+// The page skew is found by a coarse sweep over +/- kSkewSweepRange degrees
+// in kSkewSweepDelta steps on a kCoarseSkewReduction reduced image,
+// followed, unless the coarse result is already confident, by a fine sweep
+// over +/- kSkewFineRange degrees about it at kFineSkewReduction.
+const float kSkewSweepRange = 30.0f;
+const float kSkewSweepDelta = 1.0f;
+const int kCoarseSkewReduction = 8;
+const float kCoarseSkewMinDelta = 0.1f;
+const float kSkewFineRange = 1.0f;
+const float kSkewFineDelta = 0.2f;
+const int kFineSkewSweepReduction = 4;
+const int kFineSkewReduction = 2;
+const float kFineSkewMinDelta = 0.01f;
+// Leptonica confidence at which the coarse skew needs no refinement, and
+// below which no skew is trusted at all.
+const float kSkewEarlyExitConfidence = 6.0f;
+const float kMinSkewConfidence = 3.0f;
+
+// Returns the time of day in milliseconds.
+static double NowMillis() {
+  struct timeval now;
+  gettimeofday(&now, NULL);
+  return now.tv_sec * 1000.0 + now.tv_usec / 1000.0;
+}
 
 // Helper to remove an enclosing circle from an image.
 // If there isn't one, then the image will most likely get badly mangled.
@@ -94,10 +124,19 @@ static Pix* RemoveEnclosingCircle(Pix* pixs) {
   return pixout;
 }
 
+bool Tesseract::LayoutCancelled() {
+  if (layout_monitor_ == NULL) return false;
+  // No words are done yet, so the cancel function is told none.
+  return layout_monitor_->deadline_exceeded() ||
+      (layout_monitor_->cancel != NULL &&
+       (*layout_monitor_->cancel)(layout_monitor_->cancel_this, 0));
+}
+
 /**
  * Segment the page according to the current value of tessedit_pageseg_mode.
  * pix_binary_ is used as the source image and should not be NULL.
  * On return the blocks list owns all the constructed page layout.
+ * Returns -1 if the layout monitor stops it part way.
  */
 int Tesseract::SegmentPage(const STRING* input_file, BLOCK_LIST* blocks,
                            Tesseract* osd_tess, OSResults* osr) {
@@ -136,11 +175,25 @@ int Tesseract::SegmentPage(const STRING* input_file, BLOCK_LIST* blocks,
   BLOBNBOX_LIST diacritic_blobs;
   int auto_page_seg_ret_val = 0;
   TO_BLOCK_LIST to_blocks;
-  if (PSM_OSD_ENABLED(pageseg_mode) || PSM_BLOCK_FIND_ENABLED(pageseg_mode) ||
-      PSM_SPARSE(pageseg_mode)) {
-    auto_page_seg_ret_val = AutoPageSeg(
-        pageseg_mode, blocks, &to_blocks,
-        enable_noise_removal ? &diacritic_blobs : NULL, osd_tess, osr);
+  // Reduced layout gives up the blobs found by layout analysis, so it can't
+  // be used where they are needed: for osd and for sparse text, which has
+  // its textlines made by the ColumnFinder.
+  int layout_reduction = tessedit_layout_reduction;
+  if ((layout_reduction == 2 || layout_reduction == 4) &&
+      PSM_BLOCK_FIND_ENABLED(pageseg_mode) &&
+      !PSM_OSD_ENABLED(pageseg_mode) && !PSM_SPARSE(pageseg_mode)) {
+    StageTimer timer(&stage_timings_, STAGE_LAYOUT);
+    auto_page_seg_ret_val = ReducedAutoPageSeg(pageseg_mode, layout_reduction,
+                                               blocks, &to_blocks);
+  } else if (PSM_OSD_ENABLED(pageseg_mode) ||
+             PSM_BLOCK_FIND_ENABLED(pageseg_mode) ||
+             PSM_SPARSE(pageseg_mode)) {
+    {
+      StageTimer timer(&stage_timings_, STAGE_LAYOUT);
+      auto_page_seg_ret_val = AutoPageSeg(
+          pageseg_mode, blocks, &to_blocks,
+          enable_noise_removal ? &diacritic_blobs : NULL, osd_tess, osr);
+    }
     if (pageseg_mode == PSM_OSD_ONLY)
       return auto_page_seg_ret_val;
     // To create blobs from the image region bounds uncomment this line:
@@ -170,9 +223,17 @@ int Tesseract::SegmentPage(const STRING* input_file, BLOCK_LIST* blocks,
       pageseg_devanagari_split_strategy != ShiroRekhaSplitter::NO_SPLIT;
   bool cjk_mode = textord_use_cjk_fp_model;
 
-  textord_.TextordPage(pageseg_mode, reskew_, width, height, pix_binary_,
-                       pix_thresholds_, pix_grey_, splitting || cjk_mode,
-                       &diacritic_blobs, blocks, &to_blocks);
+  StageTimer timer(&stage_timings_, STAGE_TEXTORD);
+  if (LayoutCancelled() ||
+      !textord_.TextordPage(pageseg_mode, reskew_, width, height, pix_binary_,
+                            pix_thresholds_, pix_grey_, splitting || cjk_mode,
+                            &diacritic_blobs, blocks, &to_blocks,
+                            tessedit_parallel_layout ? RecognitionThreadPool()
+                                                     : NULL)) {
+    to_blocks.clear();
+    blocks->clear();
+    return -1;
+  }
   return auto_page_seg_ret_val;
 }
 
@@ -226,6 +287,9 @@ int Tesseract::AutoPageSeg(PageSegMode pageseg_mode, BLOCK_LIST* blocks,
                            TO_BLOCK_LIST* to_blocks,
                            BLOBNBOX_LIST* diacritic_blobs, Tesseract* osd_tess,
                            OSResults* osr) {
+  double start_time = NowMillis();
+  layout_timings_ = LayoutTimings();
+  table_cells_.clear();
   if (textord_debug_images) {
     WriteDebugBackgroundImage(textord_debug_printable, pix_binary_);
   }
@@ -250,15 +314,22 @@ int Tesseract::AutoPageSeg(PageSegMode pageseg_mode, BLOCK_LIST* blocks,
     if (equ_detect_) {
       finder->SetEquationDetect(equ_detect_);
     }
+    finder->set_table_cells(&table_cells_);
+    finder->set_cancel(layout_cancel_);
+    double find_blocks_start = NowMillis();
     result = finder->FindBlocks(
         pageseg_mode, scaled_color_, scaled_factor_, to_block, photomask_pix,
         pix_thresholds_, pix_grey_, &found_blocks, diacritic_blobs, to_blocks);
+    layout_timings_.find_blocks = NowMillis() - find_blocks_start;
     if (result >= 0)
       finder->GetDeskewVectors(&deskew_, &reskew_);
     delete finder;
+  } else if (LayoutCancelled()) {
+    result = -1;
   }
   pixDestroy(&photomask_pix);
   pixDestroy(&musicmask_pix);
+  layout_timings_.total = NowMillis() - start_time;
   if (result < 0) return result;
 
   blocks->clear();
@@ -273,6 +344,226 @@ int Tesseract::AutoPageSeg(PageSegMode pageseg_mode, BLOCK_LIST* blocks,
   return result;
 }
 
+/**
+ * Fast layout for camera frames and other images where full resolution is
+ * more than layout analysis needs. pix_binary_ is reduced by reduction (2 or
+ * 4), keeping any pixel that covers a black one, and AutoPageSeg runs on
+ * that, without the grey, thresholds or color images, which don't match it.
+ * The blocks found are then scaled back up, and their blobs thrown away, so
+ * the full resolution image is used to find the blobs for recognition, as if
+ * the blocks came from a zone file.
+ */
+int Tesseract::ReducedAutoPageSeg(PageSegMode pageseg_mode, int reduction,
+                                  BLOCK_LIST* blocks,
+                                  TO_BLOCK_LIST* to_blocks) {
+  Pix* full_binary = pix_binary_;
+  Pix* reduced = reduction == 4
+      ? pixReduceRankBinaryCascade(full_binary, 1, 1, 0, 0)
+      : pixReduceRankBinary2(full_binary, 1, NULL);
+  if (reduced == NULL) {
+    return AutoPageSeg(pageseg_mode, blocks, to_blocks, NULL, NULL, NULL);
+  }
+  Pix* full_grey = pix_grey_;
+  Pix* full_thresholds = pix_thresholds_;
+  Pix* full_color = scaled_color_;
+  int full_resolution = source_resolution_;
+  pix_binary_ = reduced;
+  pix_grey_ = NULL;
+  pix_thresholds_ = NULL;
+  scaled_color_ = NULL;
+  source_resolution_ = MAX(full_resolution / reduction, 1);
+  // Replace the full page block with one covering the reduced page.
+  bool rtl = right_to_left();
+  blocks->clear();
+  BLOCK_IT block_it(blocks);
+  BLOCK* page_block = new BLOCK("", TRUE, 0, 0, 0, 0, pixGetWidth(reduced),
+                                pixGetHeight(reduced));
+  page_block->set_right_to_left(rtl);
+  block_it.add_to_end(page_block);
+
+  int result = AutoPageSeg(pageseg_mode, blocks, to_blocks, NULL, NULL, NULL);
+
+  pixDestroy(&pix_binary_);
+  pix_binary_ = full_binary;
+  pix_grey_ = full_grey;
+  pix_thresholds_ = full_thresholds;
+  scaled_color_ = full_color;
+  source_resolution_ = full_resolution;
+  // Deleting the TO_BLOCKs deletes the reduced blobs with them.
+  to_blocks->clear();
+  for (block_it.mark_cycle_pt(); !block_it.cycled_list(); block_it.forward()) {
+    BLOCK* block = block_it.data();
+    block->blob_list()->clear();
+    block->reject_blobs()->clear();
+    block->scale(reduction);
+  }
+  for (int t = 0; t < table_cells_.size(); ++t) {
+    for (int c = 0; c < table_cells_[t].cells.size(); ++c)
+      table_cells_[t].cells[c].scale(reduction);
+  }
+  return result;
+}
+
+// Returns the likelihood, in [0, 1], that a partition of the given text flow
+// is a real text line, or 0 if it is not text at all.
+static float TextLineLikelihood(BlobTextFlowType flow) {
+  switch (flow) {
+    case BTFT_STRONG_CHAIN:
+      return 1.0f;
+    case BTFT_CHAIN:
+    case BTFT_TEXT_ON_IMAGE:
+      return 0.75f;
+    case BTFT_NEIGHBOURS:
+      return 0.5f;
+    default:
+      return 0.0f;
+  }
+}
+
+// Sets the rule edges of the blobs to the page edges, as there are no tab
+// vectors to limit them.
+static void SetBlobRulesToPage(int left, int right, BLOBNBOX_LIST* blobs) {
+  BLOBNBOX_IT blob_it(blobs);
+  for (blob_it.mark_cycle_pt(); !blob_it.cycled_list(); blob_it.forward()) {
+    BLOBNBOX* blob = blob_it.data();
+    blob->set_left_rule(left);
+    blob->set_right_rule(right);
+    blob->set_left_crossing_rule(left);
+    blob->set_right_crossing_rule(right);
+  }
+}
+
+/**
+ * Text line detection for deciding whether and where there is text, without
+ * recognition or full layout analysis. The connected components of
+ * pix_binary_, reduced as in ReducedAutoPageSeg if tessedit_layout_reduction
+ * is 2 or 4, are graded into text line partitions by the StrokeWidth and
+ * TextlineProjection, as at the start of ColumnFinder::FindBlocks, but line
+ * finding, image finding, tab finding and column finding are all skipped and
+ * no blocks are made. The boxes of the text partitions are returned in lines,
+ * in full resolution tesseract coordinates, with the likelihood of each
+ * being text, in [0, 1], in scores.
+ */
+void Tesseract::DetectTextLines(GenericVector<TBOX>* lines,
+                                GenericVector<float>* scores) {
+  ASSERT_HOST(pix_binary_ != NULL);
+  StageTimer timer(&stage_timings_, STAGE_LAYOUT);
+  lines->truncate(0);
+  scores->truncate(0);
+  int reduction = tessedit_layout_reduction;
+  Pix* pix = NULL;
+  if (reduction == 2 || reduction == 4) {
+    pix = reduction == 4
+        ? pixReduceRankBinaryCascade(pix_binary_, 1, 1, 0, 0)
+        : pixReduceRankBinary2(pix_binary_, 1, NULL);
+  }
+  if (pix == NULL) {
+    reduction = 1;
+    pix = pixClone(pix_binary_);
+  }
+  int width = pixGetWidth(pix);
+  int height = pixGetHeight(pix);
+  BLOCK_LIST blocks;
+  BLOCK_IT block_it(&blocks);
+  BLOCK* page_block = new BLOCK("", TRUE, 0, 0, 0, 0, width, height);
+  page_block->set_right_to_left(right_to_left());
+  block_it.add_to_end(page_block);
+  TO_BLOCK_LIST to_blocks;
+  textord_.find_components(pix, &blocks, &to_blocks);
+  TO_BLOCK_IT to_block_it(&to_blocks);
+  TO_BLOCK* to_block = to_blocks.empty() ? NULL : to_block_it.data();
+  if (to_block == NULL || to_block->line_size < 2) {
+    pixDestroy(&pix);
+    return;
+  }
+  PageSegMode pageseg_mode = static_cast<PageSegMode>(
+      static_cast<int>(tessedit_pageseg_mode));
+  bool cjk_script = textord_use_cjk_fp_model;
+  int gridsize = static_cast<int>(to_block->line_size);
+  ICOORD bleft(0, 0);
+  ICOORD tright(width, height);
+  to_block->ReSetAndReFilterBlobs();
+  SetBlobRulesToPage(0, width, &to_block->blobs);
+  SetBlobRulesToPage(0, width, &to_block->small_blobs);
+  SetBlobRulesToPage(0, width, &to_block->noise_blobs);
+  SetBlobRulesToPage(0, width, &to_block->large_blobs);
+  StrokeWidth stroke_width(gridsize, bleft, tright);
+  stroke_width.SetNeighboursOnMediumBlobs(to_block);
+  // There is no photo mask, so the noise density alone marks non-text.
+  Pix* photo_mask = pixCreate(width, height, 1);
+  CCNonTextDetect nontext_detect(gridsize, bleft, tright);
+  Pix* nontext_map = nontext_detect.ComputeNonTextMask(false, photo_mask,
+                                                       to_block);
+  pixDestroy(&photo_mask);
+  stroke_width.FindTextlineDirectionAndFixBrokenCJK(pageseg_mode, cjk_script,
+                                                    to_block);
+  stroke_width.Clear();
+
+  ColPartitionGrid part_grid(gridsize, bleft, tright);
+  ColPartition_LIST big_parts;
+  TextlineProjection projection(MAX(source_resolution_ / reduction, 1));
+  stroke_width.GradeBlobsIntoPartitions(
+      pageseg_mode, FCOORD(1.0f, 0.0f), to_block, nontext_map, NULL,
+      cjk_script, &projection, NULL, &part_grid, &big_parts);
+  TBOX page_box(0, 0, pixGetWidth(pix_binary_), pixGetHeight(pix_binary_));
+  ColPartitionGridSearch gsearch(&part_grid);
+  gsearch.StartFullSearch();
+  ColPartition* part;
+  while ((part = gsearch.NextFullSearch()) != NULL) {
+    if (!BLOBNBOX::IsTextType(part->blob_type())) continue;
+    float score = TextLineLikelihood(part->flow());
+    if (score <= 0.0f) continue;
+    TBOX box = part->bounding_box();
+    box.scale(reduction);
+    lines->push_back(box.intersection(page_box));
+    scores->push_back(score);
+  }
+  part_grid.DeleteParts();
+  ColPartition_IT p_it(&big_parts);
+  for (p_it.mark_cycle_pt(); !p_it.cycled_list(); p_it.forward())
+    p_it.data()->DisownBoxesNoAssert();
+  big_parts.clear();
+  pixDestroy(&nontext_map);
+  pixDestroy(&pix);
+}
+
+/**
+ * Finds the skew of pix_binary_ coarse to fine, unless it is already known.
+ * A quick sweep on a heavily reduced image is enough for a page with clear
+ * text lines; only a less confident result is refined by a narrow sweep
+ * about it at higher resolution.
+ * Returns false if no skew is known and textord_estimate_page_skew is off,
+ * or if the image doesn't give a confident skew.
+ */
+bool Tesseract::EstimatePageSkew(float* angle) {
+  if (GetPageSkew(angle)) return true;
+  if (!textord_estimate_page_skew || pix_binary_ == NULL) return false;
+  l_float32 coarse_angle, conf;
+  if (pixFindSkewSweepAndSearch(pix_binary_, &coarse_angle, &conf,
+                                kCoarseSkewReduction, kCoarseSkewReduction,
+                                kSkewSweepRange, kSkewSweepDelta,
+                                kCoarseSkewMinDelta) != 0) {
+    return false;
+  }
+  if (conf < kSkewEarlyExitConfidence) {
+    l_float32 fine_angle, fine_conf, end_score;
+    if (pixFindSkewSweepAndSearchScorePivot(
+            pix_binary_, &fine_angle, &fine_conf, &end_score,
+            kFineSkewSweepReduction, kFineSkewReduction, coarse_angle,
+            kSkewFineRange, kSkewFineDelta, kFineSkewMinDelta,
+            L_SHEAR_ABOUT_CORNER) == 0 && fine_conf > conf) {
+      coarse_angle = fine_angle;
+      conf = fine_conf;
+    }
+  }
+  if (textord_debug_tabfind)
+    tprintf("Page skew=%g, conf=%g\n", coarse_angle, conf);
+  if (conf < kMinSkewConfidence) return false;
+  SetPageSkew(coarse_angle);
+  *angle = coarse_angle;
+  return true;
+}
+
 // Helper adds all the scripts from sid_set converted to ids from osd_set to
 // allowed_ids.
 static void AddAllScriptsConverted(const UNICHARSET& sid_set,
@@ -297,7 +588,8 @@ static void AddAllScriptsConverted(const UNICHARSET& sid_set,
  * because of the possibility of a unlv zone file.
  * TODO(rays) clean this up.
  * See AutoPageSeg for other arguments.
- * The returned ColumnFinder must be deleted after use.
+ * The returned ColumnFinder must be deleted after use. Returns NULL if the
+ * layout monitor stops it after line finding or the connected components.
  */
 ColumnFinder* Tesseract::SetupPageSegAndDetectOrientation(
     PageSegMode pageseg_mode, BLOCK_LIST* blocks, Tesseract* osd_tess,
@@ -313,21 +605,36 @@ ColumnFinder* Tesseract::SetupPageSegAndDetectOrientation(
   if (tessedit_dump_pageseg_images) {
     pixWrite("tessinput.png", pix_binary_, IFF_PNG);
   }
+  ThreadPool* thread_pool =
+      tessedit_parallel_layout ? RecognitionThreadPool() : NULL;
   // Leptonica is used to find the rule/separator lines in the input.
+  double stage_start = NowMillis();
   LineFinder::FindAndRemoveLines(source_resolution_,
                                  textord_tabfind_show_vlines, pix_binary_,
                                  &vertical_x, &vertical_y, music_mask_pix,
-                                 &v_lines, &h_lines);
+                                 &v_lines, &h_lines, thread_pool);
+  layout_timings_.line_finding = NowMillis() - stage_start;
   if (tessedit_dump_pageseg_images)
     pixWrite("tessnolines.png", pix_binary_, IFF_PNG);
-  // Leptonica is used to find a mask of the photo regions in the input.
-  *photo_mask_pix = ImageFind::FindImages(pix_binary_);
+  if (LayoutCancelled()) return NULL;
+  // Leptonica is used to find a mask of the photo regions in the input, and
+  // the rest of the algorithm uses the usual connected components. Both only
+  // read pix_binary_, so they can run at the same time.
+  if (thread_pool != NULL) {
+    TessCallback1<int>* stage = NewPermanentTessCallback(
+        this, &Tesseract::RunIndependentLayoutStage, photo_mask_pix, blocks,
+        to_blocks);
+    thread_pool->ParallelFor(2, stage);
+    delete stage;
+  } else {
+    RunIndependentLayoutStage(photo_mask_pix, blocks, to_blocks, 0);
+    RunIndependentLayoutStage(photo_mask_pix, blocks, to_blocks, 1);
+  }
   if (tessedit_dump_pageseg_images)
     pixWrite("tessnoimages.png", pix_binary_, IFF_PNG);
+  if (LayoutCancelled()) return NULL;
   if (!PSM_COL_FIND_ENABLED(pageseg_mode)) v_lines.clear();
-
-  // The rest of the algorithm uses the usual connected components.
-  textord_.find_components(pix_binary_, blocks, to_blocks);
+  stage_start = NowMillis();
 
   TO_BLOCK_IT to_block_it(to_blocks);
   // There must be exactly one input block.
@@ -343,6 +650,13 @@ ColumnFinder* Tesseract::SetupPageSegAndDetectOrientation(
                               source_resolution_, textord_use_cjk_fp_model,
                               textord_tabfind_aligned_gap_fraction,
                               &v_lines, &h_lines, vertical_x, vertical_y);
+    float skew_angle;
+    if (EstimatePageSkew(&skew_angle)) {
+      // The angle deskews by a clockwise rotation, so the text lines rise
+      // to the right by it, and the true vertical leans to the left.
+      double radians = skew_angle * M_PI / 180.0;
+      finder->SetVerticalEstimate(FCOORD(-sin(radians), cos(radians)));
+    }
 
     finder->SetupAndFilterNoise(pageseg_mode, *photo_mask_pix, to_block);
 
@@ -419,8 +733,27 @@ ColumnFinder* Tesseract::SetupPageSegAndDetectOrientation(
     osd_blobs.shallow_clear();
     finder->CorrectOrientation(to_block, vertical_text, osd_orientation);
   }
+  layout_timings_.setup = NowMillis() - stage_start;
 
   return finder;
 }
 
+void Tesseract::RunIndependentLayoutStage(Pix** photo_mask_pix,
+                                          BLOCK_LIST* blocks,
+                                          TO_BLOCK_LIST* to_blocks,
+                                          int stage) {
+  double start = NowMillis();
+  if (stage == 0) {
+    *photo_mask_pix = ImageFind::FindImages(pix_binary_);
+    layout_timings_.image_finding = NowMillis() - start;
+  } else {
+    // When the stages run concurrently the pool is busy running them, so
+    // the blocks are not split into stripes.
+    textord_.find_components(
+        pix_binary_, blocks, to_blocks,
+        tessedit_parallel_layout ? NULL : RecognitionThreadPool());
+    layout_timings_.components = NowMillis() - start;
+  }
+}
+
 }  // namespace tesseract.
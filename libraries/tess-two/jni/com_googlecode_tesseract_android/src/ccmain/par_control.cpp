@@ -17,7 +17,13 @@
 //
 ///////////////////////////////////////////////////////////////////////
 
+#include <string.h>
+
+#include "glyphclusters.h"
 #include "tesseractclass.h"
+#include "taskscheduler.h"
+#include "tesscallback.h"
+#include "threadpool.h"
 
 namespace tesseract {
 
@@ -33,34 +39,477 @@ struct BlobData {
   BLOB_CHOICE_LIST** choices;
 };
 
+// Most blobs that are classified together in one call to the classifier.
+const int kBlobsPerBatch = 16;
+
+// A run of consecutive blobs that share a Tesseract, [start, end).
+struct BlobBatch {
+  BlobBatch() : start(0), end(0) {}
+  BlobBatch(int s, int e) : start(s), end(e) {}
+
+  int start;
+  int end;
+};
+
+// Classifies a batch of blobs, each into its own ratings cell. Each blob has
+// a distinct cell, so batches may be classified concurrently in any order
+// and the results are the same as for the serial loop.
+static void ClassifyBatch(const GenericVector<BlobData>* blobs,
+                          const GenericVector<BlobBatch>* batches,
+                          int b) {
+  const BlobBatch& batch = (*batches)[b];
+  GenericVector<TBLOB*> batch_blobs;
+  batch_blobs.reserve(batch.end - batch.start);
+  for (int i = batch.start; i < batch.end; ++i)
+    batch_blobs.push_back((*blobs)[i].blob);
+  GenericVector<BLOB_CHOICE_LIST*> choices;
+  (*blobs)[batch.start].tesseract->classify_blobs(batch_blobs, "par", White,
+                                                  &choices);
+  for (int i = batch.start; i < batch.end; ++i)
+    *(*blobs)[i].choices = choices[i - batch.start];
+}
+
+// The words of one text line, [start, end), which one engine recognizes in
+// order in RecogAllWordsPass1Par. Words [start, done_end) were recognized.
+struct WordRun {
+  WordRun() : start(0), end(0), done_end(0) {}
+  WordRun(int s, int e) : start(s), end(e), done_end(s) {}
+
+  int start;
+  int end;
+  int done_end;
+};
+
+// The runs of RecogAllWordsPass1Par, and the engines to recognize them. No
+// more runs are recognized at once than there are engines, so each run can
+// take an engine that is idle.
+struct WordRunJob {
+  WordRunJob(GenericVector<WordData>* w, ETEXT_DESC* m)
+    : words(w), monitor(m) {}
+
+  GenericVector<Tesseract*> engines;
+  GenericVector<Tesseract*> idle_engines;
+  GenericVector<WordRun> runs;
+  GenericVector<WordData>* words;
+  ETEXT_DESC* monitor;
+  CCUtilMutex mutex;
+};
+
+// Recognizes run r of job with an idle engine. Each run starts afresh, so
+// which engine recognizes a run doesn't change the results.
+static void RecognizeRun(WordRunJob* job, int r) {
+  job->mutex.Lock();
+  ASSERT_HOST(!job->idle_engines.empty());
+  Tesseract* engine = job->idle_engines.back();
+  job->idle_engines.pop_back();
+  job->mutex.Unlock();
+  WordRun* run = &job->runs[r];
+  run->done_end = engine->RecognizeWordRun(run->start, run->end,
+                                           job->monitor, job->words);
+  job->mutex.Lock();
+  job->idle_engines.push_back(engine);
+  job->mutex.Unlock();
+}
+
+// Returns true if recognition under monitor must stop, as the user
+// cancelled or the deadline has passed.
+static bool RecognitionCancelled(ETEXT_DESC* monitor, int num_words) {
+  return monitor->deadline_exceeded() ||
+      (monitor->cancel != NULL &&
+       (*monitor->cancel)(monitor->cancel_this, num_words));
+}
+
+// Forgets any hyphenated word in the dictionaries of tess and its
+// sub-languages.
+static void ResetHyphenVars(Tesseract* tess) {
+  tess->getDict().reset_hyphen_vars(true);
+  for (int s = 0; s < tess->num_sub_langs(); ++s)
+    tess->get_sub_lang(s)->getDict().reset_hyphen_vars(true);
+}
+
+// Returns true if word ends its line with a hyphen, so recognizing it may
+// leave the dictionary expecting the rest of the word on the next line.
+static bool EndsLineWithHyphen(const WERD_RES& word) {
+  if (!word.word->flag(W_EOL) || word.best_choice == NULL ||
+      word.best_choice->length() < 2)
+    return false;
+  UNICHAR_ID last =
+      word.best_choice->unichar_id(word.best_choice->length() - 1);
+  return strcmp(word.uch_set->get_normed_unichar(last), kHyphenSymbol) == 0;
+}
+
+// Returns the language of master that matches lang, which is master, one of
+// its sub-languages, or the same language of one of workers.
+static Tesseract* MasterLanguage(Tesseract* master,
+                                 const GenericVector<Tesseract*>& workers,
+                                 Tesseract* lang) {
+  for (int w = 0; w < workers.size(); ++w) {
+    if (lang == workers[w]) return master;
+    for (int s = 0; s < workers[w]->num_sub_langs(); ++s) {
+      if (lang == workers[w]->get_sub_lang(s)) return master->get_sub_lang(s);
+    }
+  }
+  return lang;
+}
+
+// Returns the language of worker that matches lang, which is master or one
+// of its sub-languages.
+static Tesseract* WorkerLanguage(Tesseract* worker, const Tesseract* master,
+                                 Tesseract* lang) {
+  for (int s = 0; s < master->num_sub_langs(); ++s) {
+    if (lang == master->get_sub_lang(s)) return worker->get_sub_lang(s);
+  }
+  return worker;
+}
+
+// The languages to recognize a word with in RecognizeLanguagesPar.
+struct LanguageJob {
+  LanguageJob(WordRecognizer r, const GenericVector<Tesseract*>& l,
+              const GenericVector<int>& i, WordData* w,
+              PointerVector<WERD_RES>* res)
+    : recognizer(r), langs(l), lang_indices(i), word_data(w), results(res) {}
+
+  WordRecognizer recognizer;
+  const GenericVector<Tesseract*>& langs;
+  const GenericVector<int>& lang_indices;
+  WordData* word_data;
+  PointerVector<WERD_RES>* results;
+};
+
+// Recognizes the word of job with language l. Each language has its own
+// classifier, dictionary and input word, and writes only its own results.
+static void RecognizeLanguage(const LanguageJob* job, int l) {
+  WERD_RES** in_word = &job->word_data->lang_words[job->lang_indices[l]];
+  job->langs[l]->RecognizeWithLanguage(*job->word_data, job->recognizer,
+                                       in_word, &job->results[l]);
+}
+
+ThreadPool* Tesseract::GetThreadPool() {
+  int num_threads = MAX(tessedit_parallelize, 1);
+  if (thread_pool_ == NULL || thread_pool_->max_threads() != num_threads) {
+    delete thread_pool_;
+    thread_pool_ = new ThreadPool(num_threads);
+  }
+  return thread_pool_;
+}
+
+ThreadPool* Tesseract::RecognitionThreadPool() {
+  // The runs of RecogAllWordsPass1Par already occupy the pool.
+  return tessedit_parallelize > 1 && !recognizing_in_parallel_ ? GetThreadPool()
+                                                        : NULL;
+}
+
+void Tesseract::SetClassifyFromSnapshot(bool from_snapshot) {
+  if (from_snapshot) PublishAdaptedTemplates();
+  set_classify_from_snapshot(from_snapshot);
+  for (int i = 0; i < sub_langs_.size(); ++i) {
+    if (from_snapshot) sub_langs_[i]->PublishAdaptedTemplates();
+    sub_langs_[i]->set_classify_from_snapshot(from_snapshot);
+  }
+}
+
+// Returns true if the word still needs its blobs classified.
+static bool NeedsPrerec(const WordData& word) {
+  return word.word->ratings != NULL && word.word->ratings->get(0, 0) == NULL;
+}
+
+// Returns true if the blobs of word, in every language, are its outlines one
+// for one, so the blobs can be clustered by the shapes of the outlines.
+static bool CanClusterWord(const WordData& word) {
+  if (word.word->chopped_word == NULL) return false;
+  int num_blobs = word.word->chopped_word->NumBlobs();
+  if (word.word->word->cblob_list()->length() != num_blobs) return false;
+  for (int s = 0; s < word.lang_words.size(); ++s) {
+    const TWERD* chopped_word = word.lang_words[s]->chopped_word;
+    if (chopped_word == NULL || chopped_word->NumBlobs() != num_blobs)
+      return false;
+  }
+  return true;
+}
+
+// Most that the normalized boxes of the blobs of a cluster may differ on any
+// side, in baseline-normalized units, where the x-height is kBlnXHeight.
+const int kMaxGlyphNormDiff = 3;
+
+// Clusters the blobs of the words that need prerecognition and can be
+// clustered, and sets (*first_glyphs)[w] to the index of the first glyph of
+// the wth word, or -1 if its blobs are not clustered. (*reps)[g] is the
+// representative of glyph g, as given by ClusterGlyphs.
+static void ClusterWordGlyphs(const GenericVector<WordData>& words,
+                              double thresh, GenericVector<int>* first_glyphs,
+                              GenericVector<int>* reps) {
+  GenericVector<PageGlyph> glyphs;
+  first_glyphs->init_to_size(words.size(), -1);
+  for (int w = 0; w < words.size(); ++w) {
+    if (!NeedsPrerec(words[w]) || !CanClusterWord(words[w])) continue;
+    (*first_glyphs)[w] = glyphs.size();
+    const TWERD* chopped_word = words[w].word->chopped_word;
+    C_BLOB_IT b_it(words[w].word->word->cblob_list());
+    for (int b = 0; b < chopped_word->NumBlobs(); ++b, b_it.forward()) {
+      glyphs.push_back(PageGlyph(b_it.data(),
+                                 chopped_word->blobs[b]->bounding_box()));
+    }
+  }
+  ClusterGlyphs(glyphs, thresh, kMaxGlyphNormDiff, reps);
+}
+
 void Tesseract::PrerecAllWordsPar(const GenericVector<WordData>& words) {
-  // Prepare all the blobs.
+  // With tessedit_cluster_glyphs, only the representative of each cluster of
+  // blobs is classified, and its choices are copied to the other blobs of
+  // the cluster.
+  GenericVector<int> first_glyphs;
+  GenericVector<int> reps;
+  if (tessedit_cluster_glyphs) {
+    ClusterWordGlyphs(words, tessedit_glyph_cluster_thresh, &first_glyphs,
+                      &reps);
+  }
+  int num_langs = sub_langs_.size() + 1;
+  // Index in blobs of the blob of each glyph and language, when classified.
+  GenericVector<int> glyph_blobs;
+  glyph_blobs.init_to_size(reps.size() * num_langs, -1);
+  // Prepare all the blobs, and the blobs that copy the choices of another.
   GenericVector<BlobData> blobs;
+  GenericVector<BlobData> copies;
+  GenericVector<int> copy_sources;
   for (int w = 0; w < words.size(); ++w) {
-    if (words[w].word->ratings != NULL &&
-        words[w].word->ratings->get(0, 0) == NULL) {
+    if (NeedsPrerec(words[w])) {
       for (int s = 0; s < words[w].lang_words.size(); ++s) {
         Tesseract* sub = s < sub_langs_.size() ? sub_langs_[s] : this;
         const WERD_RES& word = *words[w].lang_words[s];
         for (int b = 0; b < word.chopped_word->NumBlobs(); ++b) {
-          blobs.push_back(BlobData(b, sub, word));
+          int glyph = first_glyphs.empty() || first_glyphs[w] < 0
+                          ? -1 : first_glyphs[w] + b;
+          if (glyph >= 0 && reps[glyph] != glyph) {
+            // The representative comes first, so it is already in blobs.
+            copies.push_back(BlobData(b, sub, word));
+            copy_sources.push_back(glyph_blobs[reps[glyph] * num_langs + s]);
+          } else {
+            if (glyph >= 0) glyph_blobs[glyph * num_langs + s] = blobs.size();
+            blobs.push_back(BlobData(b, sub, word));
+          }
         }
       }
     }
   }
-  // Pre-classify all the blobs.
-  if (tessedit_parallelize > 1) {
-    for (int b = 0; b < blobs.size(); ++b) {
-      *blobs[b].choices =
-          blobs[b].tesseract->classify_blob(blobs[b].blob, "par", White, NULL);
+  // Group the blobs into batches of the same language.
+  GenericVector<BlobBatch> batches;
+  for (int b = 0; b < blobs.size(); ++b) {
+    if (batches.empty() ||
+        batches.back().end - batches.back().start >= kBlobsPerBatch ||
+        blobs[batches.back().start].tesseract != blobs[b].tesseract) {
+      batches.push_back(BlobBatch(b, b));
     }
+    ++batches.back().end;
+  }
+  // Pre-classify all the blobs.
+  // The classifier only reads the static templates and a published snapshot
+  // of the adapted templates here, and the IntegerMatcher keeps its scratch
+  // evidence per call, so the blobs are independent. Adaptation happens
+  // later, serially, during pass 1, into the live adapted templates.
+  ThreadPool* pool = RecognitionThreadPool();
+  if (pool != NULL) {
+    SetClassifyFromSnapshot(true);
+    TessCallback1<int>* classify =
+        NewPermanentTessCallback(&ClassifyBatch, &blobs, &batches);
+    pool->ParallelFor(batches.size(), classify);
+    delete classify;
+    SetClassifyFromSnapshot(false);
   } else {
-    // TODO(AMD) parallelize this.
-    for (int b = 0; b < blobs.size(); ++b) {
-      *blobs[b].choices =
-          blobs[b].tesseract->classify_blob(blobs[b].blob, "par", White, NULL);
+    for (int b = 0; b < batches.size(); ++b)
+      ClassifyBatch(&blobs, &batches, b);
+  }
+  for (int c = 0; c < copies.size(); ++c) {
+    BLOB_CHOICE_LIST* choices = new BLOB_CHOICE_LIST;
+    choices->deep_copy(*blobs[copy_sources[c]].choices,
+                       &BLOB_CHOICE::deep_copy);
+    *copies[c].choices = choices;
+  }
+}
+
+void Tesseract::PrepareWordWorker(const Tesseract& master) {
+  SharePageImages(&master);
+  AdoptAdaptedTemplates(master);
+  set_classify_from_snapshot(true);
+  for (int i = 0; i < sub_langs_.size() && i < master.sub_langs_.size();
+       ++i) {
+    sub_langs_[i]->AdoptAdaptedTemplates(*master.sub_langs_[i]);
+    sub_langs_[i]->set_classify_from_snapshot(true);
+  }
+  SetRecognizingInParallel(true);
+}
+
+// Returns a clone of pix, or NULL if there is no pix.
+static Pix* CloneOrNull(Pix* pix) {
+  return pix != NULL ? pixClone(pix) : NULL;
+}
+
+void Tesseract::SharePageImages(const Tesseract* source) {
+  pixDestroy(&pix_binary_);
+  pixDestroy(&cube_binary_);
+  pixDestroy(&pix_grey_);
+  pixDestroy(&pix_original_);
+  if (source != NULL) {
+    pix_binary_ = CloneOrNull(source->pix_binary_);
+    cube_binary_ = CloneOrNull(source->cube_binary_);
+    pix_grey_ = CloneOrNull(source->pix_grey_);
+    pix_original_ = CloneOrNull(source->pix_original_);
+    source_resolution_ = source->source_resolution_;
+  }
+  for (int i = 0; i < sub_langs_.size(); ++i) {
+    sub_langs_[i]->SharePageImages(
+        source != NULL && i < source->sub_langs_.size()
+            ? source->sub_langs_[i] : NULL);
+  }
+}
+
+void Tesseract::SetRecognizingInParallel(bool recognizing) {
+  recognizing_in_parallel_ = recognizing;
+  for (int i = 0; i < sub_langs_.size(); ++i)
+    sub_langs_[i]->recognizing_in_parallel_ = recognizing;
+}
+
+void Tesseract::RecognizeLanguagesPar(WordRecognizer recognizer,
+                                      const GenericVector<Tesseract*>& langs,
+                                      const GenericVector<int>& lang_indices,
+                                      WordData* word_data,
+                                      PointerVector<WERD_RES>* results) {
+  LanguageJob job(recognizer, langs, lang_indices, word_data, results);
+  TessCallback1<int>* recognize =
+      NewPermanentTessCallback(&RecognizeLanguage, &job);
+  // The languages may not use the pool themselves while it runs them.
+  SetRecognizingInParallel(true);
+  GetThreadPool()->ParallelFor(langs.size(), recognize);
+  SetRecognizingInParallel(false);
+  delete recognize;
+}
+
+int Tesseract::RecognizeWordRun(int start, int end, ETEXT_DESC* monitor,
+                                GenericVector<WordData>* words) {
+  // The previous word may be in a run that another engine is recognizing.
+  most_recently_used_ = this;
+  ResetHyphenVars(this);
+  gating_block_ = NULL;
+  (*words)[start].prev_word = NULL;
+  for (int w = start; w < end; ++w) {
+    if (monitor != NULL && monitor->deadline_exceeded()) return w;
+    // Words that are already done (fakes) would switch the language to one
+    // of the master.
+    if ((*words)[w].word->done) continue;
+    classify_word_and_language(1, NULL, &(*words)[w]);
+  }
+  return end;
+}
+
+bool Tesseract::RecogAllWordsPass1Par(ETEXT_DESC* monitor, PAGE_RES_IT* pr_it,
+                                      GenericVector<WordData>* words) {
+  // Moving the diacritics may change the next word as well, so do that for
+  // all the words first.
+  pr_it->restart_page();
+  for (int w = 0; w < words->size(); ++w) {
+    WordData* word = &(*words)[w];
+    while (pr_it->word() != NULL && pr_it->word() != word->word)
+      pr_it->forward();
+    ASSERT_HOST(pr_it->word() != NULL);
+    bool make_next_word_fuzzy = false;
+    if (ReassignDiacritics(1, pr_it, &make_next_word_fuzzy)) {
+      // Needs to be setup again to see the new outlines in the chopped_word.
+      SetupWordPassN(1, word);
+    }
+    pr_it->forward();
+    if (make_next_word_fuzzy && pr_it->word() != NULL) {
+      pr_it->MakeCurrentWordFuzzy();
+    }
+  }
+  // Each text line is a run. Within a line, words depend on the words before
+  // them through the language model and the dictionary, as in the serial
+  // pass.
+  WordRunJob job(words, monitor);
+  for (int w = 0; w < words->size(); ++w) {
+    if (w == 0 || (*words)[w].row != (*words)[w - 1].row)
+      job.runs.push_back(WordRun(w, w));
+    ++job.runs.back().end;
+  }
+  // All the engines classify from a snapshot of the adapted templates of
+  // this, so the results don't depend on which engine recognizes a run, or
+  // on the order of the runs.
+  SetClassifyFromSnapshot(true);
+  SetRecognizingInParallel(true);
+  job.engines.push_back(this);
+  for (int i = 0; i < word_workers_.size(); ++i) {
+    word_workers_[i]->PrepareWordWorker(*this);
+    job.engines.push_back(word_workers_[i]);
+  }
+  job.idle_engines = job.engines;
+  TessCallback1<int>* recognize = NewPermanentTessCallback(&RecognizeRun,
+                                                           &job);
+  // The runs not yet started are dropped as soon as the user cancels.
+  TessResultCallback<bool>* cancel = monitor == NULL ? NULL
+      : NewPermanentTessCallback(&RecognitionCancelled, monitor,
+                                 words->size());
+  TaskScheduler::Get()->ParallelFor(job.runs.size(), job.engines.size(),
+                                    recognize, cancel);
+  delete cancel;
+  delete recognize;
+  for (int i = 0; i < word_workers_.size(); ++i)
+    word_workers_[i]->SharePageImages(NULL);
+  // A line that ends with a hyphen makes the dictionary look for the rest
+  // of the word at the start of the next line, which another engine
+  // recognized without it. Recognize such pairs of words again, in order.
+  int redone = -1;
+  for (int r = 1; r < job.runs.size(); ++r) {
+    int w = job.runs[r].start;
+    if (job.runs[r].done_end == w || job.runs[r - 1].done_end != w ||
+        !EndsLineWithHyphen(*(*words)[w - 1].word))
+      continue;
+    if (redone != w - 1) {
+      most_recently_used_ = this;
+      ResetHyphenVars(this);
+      gating_block_ = NULL;
+      SetupWordPassN(1, &(*words)[w - 1]);
+      classify_word_and_language(1, NULL, &(*words)[w - 1]);
+    }
+    (*words)[w].prev_word = &(*words)[w - 1];
+    SetupWordPassN(1, &(*words)[w]);
+    classify_word_and_language(1, NULL, &(*words)[w]);
+    redone = w;
+  }
+  SetRecognizingInParallel(false);
+  SetClassifyFromSnapshot(false);
+  GenericVector<bool> recognized;
+  recognized.init_to_size(words->size(), false);
+  for (int r = 0; r < job.runs.size(); ++r) {
+    for (int w = job.runs[r].start; w < job.runs[r].done_end; ++w)
+      recognized[w] = true;
+  }
+  // Learn from the words in order, as the serial pass would have, had it
+  // not adapted until the end of the page.
+  for (int w = 0; w < words->size(); ++w) {
+    WERD_RES* word = (*words)[w].word;
+    if (!recognized[w] ||
+        (monitor != NULL && UpdateWordProgress(1, w, w, *words, false,
+                                                  monitor))) {
+      // Timeout or cancelled. Fake out the rest of the words.
+      for (; w < words->size(); ++w) {
+        (*words)[w].word->SetupFake(unicharset);
+      }
+      return false;
+    }
+    Tesseract* lang = MasterLanguage(this, word_workers_, word->tesseract);
+    word->tesseract = lang;
+    if (lang->LearnFromWordPass1(word)) {
+      // The workers keep their own copies of the document dictionaries.
+      for (int i = 0; i < word_workers_.size(); ++i) {
+        WorkerLanguage(word_workers_[i], this, lang)->tess_add_doc_word(
+            word->best_choice);
+      }
+    }
+    if (tessedit_dump_choices || debug_noise_removal) {
+      tprintf("Pass1: %s [%s]\n",
+              word->best_choice->unichar_string().string(),
+              word->best_choice->debug_string().string());
     }
   }
+  return true;
 }
 
 }  // namespace tesseract.
@@ -30,11 +30,28 @@
 
 namespace tesseract {
 
+// The words of a textline in left-to-right order, with their reading order.
+struct ResultIterator::LineOrder {
+  LineOrder() : row(NULL), paragraph_is_ltr(true), index(-1) {}
+
+  // The row of the words, or NULL if there are no words.
+  ROW_RES* row;
+  // The paragraph direction that order was computed for.
+  bool paragraph_is_ltr;
+  // Iterators positioned at each of the words of the row.
+  GenericVector<PAGE_RES_IT> words;
+  // Indices into words in reading order, as given by CalculateTextlineOrder.
+  GenericVectorEqEq<int> order;
+  // Index into order of the word that was current when last looked up.
+  int index;
+};
+
 ResultIterator::ResultIterator(const LTRResultIterator &resit)
     : LTRResultIterator(resit) {
   in_minor_direction_ = false;
   at_beginning_of_minor_run_ = false;
   preserve_interword_spaces_ = false;
+  line_order_ = new LineOrder;
 
   BoolParam *p = ParamUtils::FindParam<BoolParam>(
       "preserve_interword_spaces", GlobalParams()->bool_params,
@@ -45,6 +62,29 @@ ResultIterator::ResultIterator(const LTRResultIterator &resit)
   MoveToLogicalStartOfTextline();
 }
 
+ResultIterator::ResultIterator(const ResultIterator &src)
+    : LTRResultIterator(src),
+      current_paragraph_is_ltr_(src.current_paragraph_is_ltr_),
+      at_beginning_of_minor_run_(src.at_beginning_of_minor_run_),
+      in_minor_direction_(src.in_minor_direction_),
+      preserve_interword_spaces_(src.preserve_interword_spaces_),
+      line_order_(new LineOrder(*src.line_order_)) {
+}
+
+const ResultIterator &ResultIterator::operator=(const ResultIterator &src) {
+  LTRResultIterator::operator=(src);
+  current_paragraph_is_ltr_ = src.current_paragraph_is_ltr_;
+  at_beginning_of_minor_run_ = src.at_beginning_of_minor_run_;
+  in_minor_direction_ = src.in_minor_direction_;
+  preserve_interword_spaces_ = src.preserve_interword_spaces_;
+  *line_order_ = *src.line_order_;
+  return *this;
+}
+
+ResultIterator::~ResultIterator() {
+  delete line_order_;
+}
+
 ResultIterator *ResultIterator::StartOfParagraph(
     const LTRResultIterator &resit) {
   return new ResultIterator(resit);
@@ -58,7 +98,8 @@ bool ResultIterator::CurrentParagraphIsLtr() const {
   if (!it_->word())
     return true;  // doesn't matter.
   LTRResultIterator it(*this);
-  it.RestartParagraph();
+  if (!StartsParagraph(*it_))
+    it.RestartParagraph();
   // Try to figure out the ltr-ness of the paragraph.  The rules below
   // make more sense in the context of a difficult paragraph example.
   // Here we denote {ltr characters, RTL CHARACTERS}:
@@ -111,12 +152,16 @@ const int ResultIterator::kMinorRunStart = -1;
 const int ResultIterator::kMinorRunEnd = -2;
 const int ResultIterator::kComplexWord = -3;
 
+bool ResultIterator::BlobsInReadingOrder() const {
+  bool context_is_ltr = current_paragraph_is_ltr_ ^ in_minor_direction_;
+  return context_is_ltr || it_->word()->UnicharsInReadingOrder();
+}
+
 void ResultIterator::CalculateBlobOrder(
     GenericVector<int> *blob_indices) const {
-  bool context_is_ltr = current_paragraph_is_ltr_ ^ in_minor_direction_;
   blob_indices->clear();
   if (Empty(RIL_WORD)) return;
-  if (context_is_ltr || it_->word()->UnicharsInReadingOrder()) {
+  if (BlobsInReadingOrder()) {
     // Easy! just return the blobs in order;
     for (int i = 0; i < word_length_; i++)
       blob_indices->push_back(i);
@@ -323,15 +368,70 @@ void ResultIterator::CalculateTextlineOrder(
   }
 }
 
-int ResultIterator::LTRWordIndex() const {
-  int this_word_index = 0;
-  LTRResultIterator textline(*this);
-  textline.RestartRow();
-  while (!textline.PositionedAtSameWord(it_)) {
-    this_word_index++;
-    textline.Next(RIL_WORD);
+// Returns the strong script direction of the word, the same way as
+// LTRResultIterator::WordDirection.
+static StrongScriptDirection WordResDirection(WERD_RES* word) {
+  bool has_rtl = word->AnyRtlCharsInWord();
+  bool has_ltr = word->AnyLtrCharsInWord();
+  if (has_rtl && !has_ltr)
+    return DIR_RIGHT_TO_LEFT;
+  if (has_ltr && !has_rtl)
+    return DIR_LEFT_TO_RIGHT;
+  if (!has_ltr && !has_rtl)
+    return DIR_NEUTRAL;
+  return DIR_MIX;
+}
+
+void ResultIterator::UpdateLineOrder() const {
+  ROW_RES* row = it_->word() != NULL ? it_->row() : NULL;
+  if (row == line_order_->row &&
+      current_paragraph_is_ltr_ == line_order_->paragraph_is_ltr)
+    return;
+  line_order_->row = row;
+  line_order_->paragraph_is_ltr = current_paragraph_is_ltr_;
+  line_order_->words.truncate(0);
+  line_order_->order.truncate(0);
+  line_order_->index = -1;
+  if (row == NULL) return;
+  // Restarting the row walks from the start of the page, so only do it if
+  // we aren't already at the leftmost word.
+  PAGE_RES_IT pos(*it_);
+  if (pos.prev_row() == row) pos.restart_row();
+  GenericVector<StrongScriptDirection> dirs;
+  for (; pos.word() != NULL && pos.row() == row; pos.forward_with_empties()) {
+    line_order_->words.push_back(pos);
+    dirs.push_back(WordResDirection(pos.word()));
+  }
+  CalculateTextlineOrder(current_paragraph_is_ltr_, dirs, &line_order_->order);
+}
+
+int ResultIterator::LineOrderIndex() const {
+  UpdateLineOrder();
+  const GenericVector<int> &order = line_order_->order;
+  int index = line_order_->index;
+  if (index >= 0 && index < order.size() && order[index] >= 0 &&
+      line_order_->words[order[index]] == *it_)
+    return index;
+  for (index = 0; index < order.size(); ++index) {
+    if (order[index] >= 0 && line_order_->words[order[index]] == *it_) {
+      line_order_->index = index;
+      return index;
+    }
   }
-  return this_word_index;
+  return -1;
+}
+
+void ResultIterator::MoveToLTRWord(int ltr_index) {
+  *it_ = line_order_->words[ltr_index];
+  BeginWord(0);
+}
+
+bool ResultIterator::StartsParagraph(const PAGE_RES_IT &pos) const {
+  if (pos.block() == NULL) return false;
+  if (pos.block() != pos.prev_block()) return true;
+  if (pos.row() == pos.prev_row()) return false;
+  DetectParagraphsIfNeeded();
+  return pos.row()->row->para() != pos.prev_row()->row->para();
 }
 
 void ResultIterator::MoveToLogicalStartOfWord() {
@@ -339,6 +439,7 @@ void ResultIterator::MoveToLogicalStartOfWord() {
     BeginWord(0);
     return;
   }
+  if (BlobsInReadingOrder()) return;
   GenericVector<int> blob_order;
   CalculateBlobOrder(&blob_order);
   if (blob_order.size() == 0 || blob_order[0] == 0) return;
@@ -347,6 +448,8 @@ void ResultIterator::MoveToLogicalStartOfWord() {
 
 bool ResultIterator::IsAtFinalSymbolOfWord() const {
   if (!it_->word()) return true;
+  if (BlobsInReadingOrder())
+    return word_length_ == 0 || blob_index_ == word_length_ - 1;
   GenericVector<int> blob_order;
   CalculateBlobOrder(&blob_order);
   return blob_order.size() == 0 || blob_order.back() == blob_index_;
@@ -354,6 +457,7 @@ bool ResultIterator::IsAtFinalSymbolOfWord() const {
 
 bool ResultIterator::IsAtFirstSymbolOfWord() const {
   if (!it_->word()) return true;
+  if (BlobsInReadingOrder()) return word_length_ == 0 || blob_index_ == 0;
   GenericVector<int> blob_order;
   CalculateBlobOrder(&blob_order);
   return blob_order.size() == 0 || blob_order[0] == blob_index_;
@@ -368,11 +472,8 @@ void ResultIterator::AppendSuffixMarks(STRING *text) const {
   // If this word is at the  *end* of a minor run, insert the other
   // direction's mark;  else if this was a complex word, insert the
   // current reading order's mark.
-  GenericVectorEqEq<int> textline_order;
-  CalculateTextlineOrder(current_paragraph_is_ltr_,
-                         *this, &textline_order);
-  int this_word_index = LTRWordIndex();
-  int i = textline_order.get_index(this_word_index);
+  const GenericVector<int> &textline_order = line_order_->order;
+  int i = LineOrderIndex();
   if (i < 0) return;
 
   int last_non_word_mark = 0;
@@ -391,22 +492,24 @@ void ResultIterator::AppendSuffixMarks(STRING *text) const {
 }
 
 void ResultIterator::MoveToLogicalStartOfTextline() {
-  GenericVectorEqEq<int> word_indices;
-  RestartRow();
-  CalculateTextlineOrder(current_paragraph_is_ltr_,
-                         dynamic_cast<const LTRResultIterator&>(*this),
-                         &word_indices);
+  UpdateLineOrder();
+  const GenericVector<int> &word_indices = line_order_->order;
+  if (word_indices.empty()) {
+    BeginWord(0);
+    return;
+  }
   int i = 0;
   for (; i < word_indices.size() && word_indices[i] < 0; i++) {
     if (word_indices[i] == kMinorRunStart) in_minor_direction_ = true;
     else if (word_indices[i] == kMinorRunEnd) in_minor_direction_ = false;
   }
   if (in_minor_direction_) at_beginning_of_minor_run_ = true;
-  if (i >= word_indices.size()) return;
-  int first_word_index = word_indices[i];
-  for (int j = 0; j < first_word_index; j++) {
-    PageIterator::Next(RIL_WORD);
+  if (i >= word_indices.size()) {
+    MoveToLTRWord(0);
+    return;
   }
+  line_order_->index = i;
+  MoveToLTRWord(word_indices[i]);
   MoveToLogicalStartOfWord();
 }
 
@@ -425,7 +528,8 @@ bool ResultIterator::Next(PageIteratorLevel level) {
     case RIL_PARA:   // explicit fall-through
     case RIL_TEXTLINE:
       if (!PageIterator::Next(level)) return false;
-      if (IsWithinFirstTextlineOfParagraph()) {
+      // Next always leaves us at the leftmost word of a textline.
+      if (StartsParagraph(*it_)) {
         // if we've advanced to a new paragraph,
         // recalculate current_paragraph_is_ltr_
         current_paragraph_is_ltr_ = CurrentParagraphIsLtr();
@@ -453,34 +557,28 @@ bool ResultIterator::Next(PageIteratorLevel level) {
     case RIL_WORD:  // explicit fall-through.
     {
       if (it_->word() == NULL) return Next(RIL_BLOCK);
-      GenericVectorEqEq<int> word_indices;
-      int this_word_index = LTRWordIndex();
-      CalculateTextlineOrder(current_paragraph_is_ltr_,
-                             *this,
-                             &word_indices);
+      int i = LineOrderIndex();
+      const GenericVector<int> &word_indices = line_order_->order;
+      int this_word_index = i >= 0 ? word_indices[i] : -1;
       int final_real_index = word_indices.size() - 1;
       while (final_real_index > 0 && word_indices[final_real_index] < 0)
         final_real_index--;
-      for (int i = 0; i < final_real_index; i++) {
-        if (word_indices[i] == this_word_index) {
-          int j = i + 1;
-          for (; j < final_real_index && word_indices[j] < 0; j++) {
-            if (word_indices[j] == kMinorRunStart) in_minor_direction_ = true;
-            if (word_indices[j] == kMinorRunEnd) in_minor_direction_ = false;
-          }
-          at_beginning_of_minor_run_ = (word_indices[j - 1] == kMinorRunStart);
-          // awesome, we move to word_indices[j]
-          if (BidiDebug(3)) {
-            tprintf("Next(RIL_WORD): %d -> %d\n",
-                    this_word_index, word_indices[j]);
-          }
-          PageIterator::RestartRow();
-          for (int k = 0; k < word_indices[j]; k++) {
-            PageIterator::Next(RIL_WORD);
-          }
-          MoveToLogicalStartOfWord();
-          return true;
+      if (i >= 0 && i < final_real_index) {
+        int j = i + 1;
+        for (; j < final_real_index && word_indices[j] < 0; j++) {
+          if (word_indices[j] == kMinorRunStart) in_minor_direction_ = true;
+          if (word_indices[j] == kMinorRunEnd) in_minor_direction_ = false;
         }
+        at_beginning_of_minor_run_ = (word_indices[j - 1] == kMinorRunStart);
+        // awesome, we move to word_indices[j]
+        if (BidiDebug(3)) {
+          tprintf("Next(RIL_WORD): %d -> %d\n",
+                  this_word_index, word_indices[j]);
+        }
+        line_order_->index = j;
+        MoveToLTRWord(word_indices[j]);
+        MoveToLogicalStartOfWord();
+        return true;
       }
       if (BidiDebug(3)) {
         tprintf("Next(RIL_WORD): %d -> EOL\n", this_word_index);
@@ -501,23 +599,25 @@ bool ResultIterator::IsAtBeginningOf(PageIteratorLevel level) const {
   bool at_word_start = IsAtFirstSymbolOfWord();
   if (level == RIL_WORD) return at_word_start;
 
-  ResultIterator line_start(*this);
-  // move to the first word in the line...
-  line_start.MoveToLogicalStartOfTextline();
-
-  bool at_textline_start = at_word_start && *line_start.it_ == *it_;
+  // find the first word in the line...
+  UpdateLineOrder();
+  const GenericVector<int> &word_indices = line_order_->order;
+  int first = 0;
+  while (first < word_indices.size() && word_indices[first] < 0) ++first;
+  bool at_textline_start = at_word_start && first < word_indices.size() &&
+      line_order_->words[word_indices[first]] == *it_;
   if (level == RIL_TEXTLINE) return at_textline_start;
 
-  // now we move to the left-most word...
-  line_start.RestartRow();
+  // now look at the left-most word...
+  const PAGE_RES_IT &line_start = line_order_->words[0];
   bool at_block_start = at_textline_start &&
-      line_start.it_->block() != line_start.it_->prev_block();
+      line_start.block() != line_start.prev_block();
   if (level == RIL_BLOCK) return at_block_start;
 
+  if (level == RIL_PARA) DetectParagraphsIfNeeded();
   bool at_para_start = at_block_start ||
       (at_textline_start &&
-       line_start.it_->row()->row->para() !=
-           line_start.it_->prev_row()->row->para());
+       line_start.row()->row->para() != line_start.prev_row()->row->para());
   if (level == RIL_PARA) return at_para_start;
 
   ASSERT_HOST(false);  // shouldn't happen.
@@ -655,7 +755,12 @@ void ResultIterator::IterateAndAppendUTF8TextlineText(STRING *text) {
 
 void ResultIterator::AppendUTF8ParagraphText(STRING *text) const {
   ResultIterator it(*this);
-  it.RestartParagraph();
+  // Finding the start of the paragraph walks from the start of the page, so
+  // only do it if we aren't already in its first textline.
+  it.UpdateLineOrder();
+  if (it.line_order_->words.empty() ||
+      !StartsParagraph(it.line_order_->words[0]))
+    it.RestartParagraph();
   it.MoveToLogicalStartOfTextline();
   if (it.Empty(RIL_WORD)) return;
   do {
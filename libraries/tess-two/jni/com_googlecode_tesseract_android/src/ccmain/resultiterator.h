@@ -41,9 +41,10 @@ class TESS_API ResultIterator : public LTRResultIterator {
 
   /**
    * ResultIterator is copy constructible!
-   * The default copy constructor works just fine for us.
    */
-  virtual ~ResultIterator() {}
+  ResultIterator(const ResultIterator &src);
+  const ResultIterator &operator=(const ResultIterator &src);
+  virtual ~ResultIterator();
 
   // ============= Moving around within the page ============.
   /**
@@ -166,10 +167,34 @@ class TESS_API ResultIterator : public LTRResultIterator {
                               GenericVectorEqEq<int> *indices) const;
 
   /**
-   * What is the index of the current word in a strict left-to-right reading
-   * of the row?
+   * Makes line_order_ hold the words of the textline of the current word and
+   * their reading order, unless it already does.
    */
-  int LTRWordIndex() const;
+  void UpdateLineOrder() const;
+
+  /**
+   * Returns the index in line_order_->order of the current word, or -1 if
+   * there is no current word.
+   */
+  int LineOrderIndex() const;
+
+  /**
+   * Moves to the start of the word at the given index in a strict
+   * left-to-right reading of the row held in line_order_.
+   */
+  void MoveToLTRWord(int ltr_index);
+
+  /**
+   * Returns whether pos is at the leftmost word of the first textline of a
+   * paragraph.
+   */
+  bool StartsParagraph(const PAGE_RES_IT &pos) const;
+
+  /**
+   * Returns whether the blobs of the current word are read left-to-right
+   * in the current reading context.
+   */
+  bool BlobsInReadingOrder() const;
 
   /**
    * Given an iterator pointing at a word, returns the logical reading order
@@ -237,6 +262,16 @@ class TESS_API ResultIterator : public LTRResultIterator {
    * space character (default behavior).
    */
   bool preserve_interword_spaces_;
+
+  /**
+   * The words of the textline of the current word, with their reading order.
+   * Rebuilt only when the iterator moves to another textline, so moving
+   * between the words of a textline doesn't have to find its start again.
+   * Owned by this ResultIterator. A pointer just to avoid dragging in
+   * Tesseract includes.
+   */
+  struct LineOrder;
+  LineOrder *line_order_;
 };
 
 }  // namespace tesseract.
@@ -34,6 +34,13 @@ static int TrailingUnicharsToChopped(WERD_RES *word, int num_unichars) {
   return num_chopped;
 }
 
+// Returns true if the given chopped blob is above super_y_bottom or below
+// sub_y_top.
+static bool IsYOutlier(const TBLOB* blob, int super_y_bottom, int sub_y_top) {
+  TBOX box = blob->bounding_box();
+  return box.bottom() >= super_y_bottom || box.top() <= sub_y_top;
+}
+
 
 namespace tesseract {
 
@@ -103,6 +110,21 @@ bool Tesseract::SubAndSuperscriptFix(WERD_RES *word) {
       !word->best_choice) {
     return false;
   }
+  // Every candidate, whole or partial, starts or ends with an outlying
+  // chopped blob, and the rebuilt blobs contain the chopped ones, so a word
+  // with normally placed ends has nothing to split off.
+  TWERD* chopped = word->chopped_word;
+  int num_chopped = chopped != NULL ? chopped->NumBlobs() : 0;
+  int super_y_bottom =
+      kBlnBaselineOffset + kBlnXHeight * superscript_min_y_bottom;
+  int sub_y_top =
+      kBlnBaselineOffset + kBlnXHeight * subscript_max_y_top;
+  if (num_chopped == 0 ||
+      (!IsYOutlier(chopped->blobs[0], super_y_bottom, sub_y_top) &&
+       !IsYOutlier(chopped->blobs[num_chopped - 1], super_y_bottom,
+                   sub_y_top))) {
+    return false;
+  }
   int num_leading, num_trailing;
   ScriptPos sp_leading, sp_trailing;
   float leading_certainty, trailing_certainty;
@@ -125,10 +147,6 @@ bool Tesseract::SubAndSuperscriptFix(WERD_RES *word) {
   // (that is we accidentally thought the 2 was attached to the period).
   int num_remainder_leading = 0, num_remainder_trailing = 0;
   if (num_leading + num_trailing < num_blobs && unlikely_threshold < 0.0) {
-    int super_y_bottom =
-        kBlnBaselineOffset + kBlnXHeight * superscript_min_y_bottom;
-    int sub_y_top =
-        kBlnBaselineOffset + kBlnXHeight * subscript_max_y_top;
     int last_word_char = num_blobs - 1 - num_trailing;
     float last_char_certainty = word->best_choice->certainty(last_word_char);
     if (word->best_choice->unichar_id(last_word_char) != 0 &&
@@ -202,6 +220,7 @@ bool Tesseract::SubAndSuperscriptFix(WERD_RES *word) {
   int retry_leading = 0;
   int retry_trailing = 0;
   bool is_good = false;
+  PageCounts::Count(COUNTER_SUPERSCRIPT_TRIES, 1);
   WERD_RES *revised = TrySuperscriptSplits(
       num_chopped_leading, leading_certainty, sp_leading,
       num_chopped_trailing, trailing_certainty, sp_trailing,
@@ -223,6 +242,7 @@ bool Tesseract::SubAndSuperscriptFix(WERD_RES *word) {
     delete revised2;
   }
   delete revised;
+  if (is_good) PageCounts::Count(COUNTER_SUPERSCRIPT_FIXES, 1);
   return is_good;
 }
 
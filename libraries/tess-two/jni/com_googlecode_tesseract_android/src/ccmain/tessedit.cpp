@@ -42,13 +42,12 @@
 #include "globals.h"
 #include "tesseractclass.h"
 #include "params.h"
+#include "serialis.h"
 
 #define VARDIR        "configs/" /*variables files */
                                  // config under api
 #define API_CONFIG      "configs/api_config"
 
-ETEXT_DESC *global_monitor = NULL;  // progress monitor
-
 namespace tesseract {
 
 // Read a "config" file containing a set of variable, value pairs.
@@ -107,8 +106,21 @@ bool Tesseract::init_tesseract_lang_data(
     return false;
   }
 
+  // A snapshot of the params left by an earlier Init replaces the language
+  // config and the config files, which are much slower to parse.
+  bool params_restored = false;
+  if (params_snapshot_ != NULL && !params_snapshot_->empty()) {
+    TFile fp;
+    fp.Open(&(*params_snapshot_)[0], params_snapshot_->size());
+    params_restored = ParamUtils::DeSerializeParams(&fp, this->params());
+    if (!params_restored) {
+      tprintf("Invalid params snapshot, reading config files instead\n");
+    }
+  }
+
   // If a language specific config file (lang.config) exists, load it in.
-  if (tessdata_manager.SeekToStart(TESSDATA_LANG_CONFIG)) {
+  if (!params_restored &&
+      tessdata_manager.SeekToStart(TESSDATA_LANG_CONFIG)) {
     ParamUtils::ReadParamsFromFp(
         tessdata_manager.GetDataFilePtr(),
         tessdata_manager.GetEndOffset(TESSDATA_LANG_CONFIG),
@@ -123,7 +135,7 @@ bool Tesseract::init_tesseract_lang_data(
   // Load tesseract variables from config files. This is done after loading
   // language-specific variables from [lang].traineddata file, so that custom
   // config files can override values in [lang].traineddata file.
-  for (int i = 0; i < configs_size; ++i) {
+  for (int i = 0; !params_restored && i < configs_size; ++i) {
     read_config_file(configs[i], set_params_constraint);
   }
 
@@ -232,6 +244,15 @@ bool Tesseract::init_tesseract_lang_data(
     }
   }
   if (tessdata_manager_debug_level) language_model_->getParamsModel().Print();
+  // Load the compiled character ngram model, if there is one, or have the
+  // dict load it when it is first used.
+  if (!tessdata_manager.IsComponentAvailable(TESSDATA_CHAR_NGRAM)) {
+    getDict().SetCharNgramTable(NULL);
+  } else if (getDict().lazy_load_components) {
+    getDict().SetCharNgramFile(tessdata_path.string());
+  } else {
+    getDict().LoadCharNgramTable(&tessdata_manager);
+  }
 
   return true;
 }
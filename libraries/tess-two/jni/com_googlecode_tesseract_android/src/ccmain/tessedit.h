@@ -23,7 +23,4 @@
 #include          "blobs.h"
 #include          "pgedit.h"
 
-                                 //progress monitor
-extern ETEXT_DESC *global_monitor;
-
 #endif
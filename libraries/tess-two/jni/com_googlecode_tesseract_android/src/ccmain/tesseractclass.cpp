@@ -45,9 +45,10 @@
 #ifndef NO_CUBE_BUILD
 #include "cube_reco_context.h"
 #endif
-#include "edgblob.h"
 #include "equationdetect.h"
 #include "globals.h"
+#include "memoryusage.h"
+#include "threadpool.h"
 #ifndef NO_CUBE_BUILD
 #include "tesseract_cube_combiner.h"
 #endif
@@ -82,6 +83,28 @@ Tesseract::Tesseract()
                       " (no Cube,no combiner)."
                       " Values from OcrEngineMode enum in tesseractclass.h)",
                       this->params()),
+      INT_MEMBER(tessedit_thresholding_method, tesseract::THRESHOLD_OTSU,
+                 "Thresholding method: 0=global Otsu, 1=tiled Otsu, 2=Sauvola"
+                 " (Values from ThresholdMethod enum in thresholder.h)",
+                 this->params()),
+      double_MEMBER(thresholding_window_size, 0.33,
+                    "Width in inches of the window of Sauvola thresholding",
+                    this->params()),
+      double_MEMBER(thresholding_kfactor, 0.34,
+                    "Factor reducing the Sauvola threshold for the local"
+                    " deviation; >= 0",
+                    this->params()),
+      double_MEMBER(thresholding_tile_size, 0.33,
+                    "Width in inches of the tiles of tiled Otsu thresholding",
+                    this->params()),
+      double_MEMBER(thresholding_smooth_kernel_size, 0.0,
+                    "Width in inches of the kernel smoothing the thresholds"
+                    " of tiled Otsu thresholding",
+                    this->params()),
+      double_MEMBER(thresholding_score_fraction, 0.1,
+                    "Fraction of the best Otsu score over which tiled Otsu"
+                    " thresholding looks for a histogram minimum",
+                    this->params()),
       STRING_MEMBER(tessedit_char_blacklist, "",
                     "Blacklist of chars not to recognize", this->params()),
       STRING_MEMBER(tessedit_char_whitelist, "",
@@ -183,6 +206,9 @@ Tesseract::Tesseract()
                  this->params()),
       INT_MEMBER(noise_maxperword, 16, "Max diacritics to apply to a word",
                  this->params()),
+      INT_MEMBER(noise_maxclassifications, 0,
+                 "Max blob classifications to try diacritics on a word, if > 0",
+                 this->params()),
       INT_MEMBER(debug_x_ht_level, 0, "Reestimate debug", this->params()),
       BOOL_MEMBER(debug_acceptable_wds, false, "Dump word pass/fail chk",
                   this->params()),
@@ -217,11 +243,24 @@ Tesseract::Tesseract()
       double_MEMBER(test_pt_y, 99999.99, "ycoord", this->params()),
       INT_MEMBER(paragraph_debug_level, 0, "Print paragraph debug info.",
                  this->params()),
+      BOOL_MEMBER(paragraph_on_demand, false,
+                  "Detect the paragraphs of a recognized page only when the"
+                  " result iterators first need them",
+                  this->params()),
       BOOL_MEMBER(paragraph_text_based, true,
                   "Run paragraph detection on the post-text-recognition "
                   "(more accurate)",
                   this->params()),
       INT_MEMBER(cube_debug_level, 0, "Print cube debug info.", this->params()),
+      BOOL_MEMBER(cube_combiner_skip_accepted, false,
+                  "Don't run cube in the combined mode on dictionary words"
+                  " that Tesseract accepts with certainty of at least"
+                  " cube_combiner_skip_certainty",
+                  this->params()),
+      double_MEMBER(cube_combiner_skip_certainty, -4.0,
+                    "Certainty above which an accepted dictionary word is"
+                    " not rechecked by cube in the combined mode",
+                    this->params()),
       STRING_MEMBER(outlines_odd, "%| ", "Non standard number of outlines",
                     this->params()),
       STRING_MEMBER(outlines_2, "ij!?%\":;", "Non standard number of outlines",
@@ -331,6 +370,10 @@ Tesseract::Tesseract()
                  "How many non-noise blbs either side?", this->params()),
       double_MEMBER(fixsp_small_outlines_size, 0.28, "Small if lt xht x this",
                     this->params()),
+      INT_MEMBER(fixsp_max_combo_blobs, 0,
+                 "Don't join fuzzy spaced words into words of more than this"
+                 " many blobs, if > 0",
+                 this->params()),
       BOOL_MEMBER(tessedit_prefer_joined_punct, false,
                   "Reward punctation joins", this->params()),
       INT_MEMBER(fixsp_done_mode, 1, "What constitues done for spacing",
@@ -344,6 +387,10 @@ Tesseract::Tesseract()
                  this->params()),
       INT_MEMBER(x_ht_min_change, 8,
                  "Min change in xht before actually trying it", this->params()),
+      double_MEMBER(x_ht_min_misfit_fraction, 0.0,
+                    "Min fraction of the judged blob tops of a word that must"
+                    " be misfits before trying a new xht on it",
+                    this->params()),
       INT_MEMBER(superscript_debug, 0,
                  "Debug level for sub & superscript fixer", this->params()),
       double_MEMBER(
@@ -387,6 +434,11 @@ Tesseract::Tesseract()
                   this->params()),
       BOOL_MEMBER(tessedit_create_tsv, false, "Write .tsv output file",
                   this->params()),
+      BOOL_MEMBER(tessedit_create_json, false, "Write .json output file",
+                  this->params()),
+      BOOL_MEMBER(tessedit_create_counters, false,
+                  "Write .counters output file of the work done per page",
+                  this->params()),
       BOOL_MEMBER(tessedit_create_pdf, false, "Write .pdf output file",
                   this->params()),
       STRING_MEMBER(unrecognised_char, "|",
@@ -502,6 +554,74 @@ Tesseract::Tesseract()
           this->params()),
       INT_MEMBER(tessedit_parallelize, 0, "Run in parallel where possible",
                  this->params()),
+      BOOL_MEMBER(tessedit_parallel_layout, true,
+                  "Run independent page layout stages concurrently when"
+                  " tessedit_parallelize > 1",
+                  this->params()),
+      BOOL_MEMBER(tessedit_lang_gating, false,
+                  "Don't retry words in languages that lack the script of the"
+                  " rest of their block",
+                  this->params()),
+      BOOL_MEMBER(tessedit_fast_confident, false,
+                  "Skip the passes after pass 1 on blocks whose words all look"
+                  " acceptable with tessedit_fast_confident_certainty",
+                  this->params()),
+      double_MEMBER(tessedit_fast_confident_certainty, -2.5,
+                    "Min pass 1 certainty of every word of a block that skips"
+                    " the later passes",
+                    this->params()),
+      BOOL_MEMBER(tessedit_parallel_words, false,
+                  "Recognize the text lines of pass 1 concurrently against a"
+                  " snapshot of the adapted templates, and adapt after, when"
+                  " tessedit_parallelize > 1",
+                  this->params()),
+      BOOL_MEMBER(tessedit_cluster_glyphs, false,
+                  "Cluster the blobs of each page by shape before pass 1, and"
+                  " classify only one blob of each cluster, copying its result"
+                  " to the others",
+                  this->params()),
+      double_MEMBER(tessedit_glyph_cluster_thresh, 0.9,
+                    "Min correlation (0.4-0.98) of blobs that share a cluster"
+                    " with tessedit_cluster_glyphs",
+                    this->params()),
+      BOOL_MEMBER(tessedit_page_arena, false,
+                  "Allocate the words of each page in an arena that is freed"
+                  " at once with the page",
+                  this->params()),
+      INT_MEMBER(tessedit_auto_scale_xheight, 0,
+                 "If not 0, the largest x-height in pixels to recognize text"
+                 " at. Images with larger text are reduced by an integer"
+                 " factor before layout analysis, and the results are mapped"
+                 " back to the source image",
+                 this->params()),
+      BOOL_MEMBER(tessedit_result_cache, false,
+                  "Keep the results of the last page, and return them again"
+                  " without layout analysis or recognition for a page with"
+                  " the same rectangle, parameters and nearly the same binary"
+                  " image",
+                  this->params()),
+      double_MEMBER(tessedit_result_cache_diff, 2.0,
+                    "Max mean difference, in percent of the area of a cell,"
+                    " in the black pixels of a coarse grid over two pages"
+                    " that the result cache takes as the same",
+                    this->params()),
+      BOOL_MEMBER(textord_estimate_page_skew, false,
+                  "Find the page skew from the image before tab finding, so"
+                  " the tab search starts from it",
+                  this->params()),
+      INT_MEMBER(tessedit_layout_reduction, 1,
+                 "Reduction (2 or 4) of the binary image used for automatic"
+                 " page layout, which is mapped back to full resolution for"
+                 " recognition. 1 runs layout at full resolution",
+                 this->params()),
+      INT_MEMBER(stream_max_motion, 32,
+                 "Largest shift in pixels between video frames that is looked"
+                 " for in RecognizeFrame",
+                 this->params()),
+      double_MEMBER(stream_line_change_fraction, 0.1,
+                    "Fraction of changed pixels above which RecognizeFrame"
+                    " recognizes a text line again",
+                    this->params()),
       BOOL_MEMBER(preserve_interword_spaces, false,
                   "Preserve multiple interword spaces", this->params()),
       BOOL_MEMBER(include_page_breaks, FALSE,
@@ -620,7 +740,18 @@ Tesseract::Tesseract()
       cube_cntxt_(NULL),
       tess_cube_combiner_(NULL),
 #endif
-      equ_detect_(NULL) {
+      equ_detect_(NULL),
+      thread_pool_(NULL),
+      recognizing_in_parallel_(false),
+      gating_block_(NULL),
+      gating_total_(0),
+      line_callback_(NULL),
+      layout_monitor_(NULL),
+      page_skew_known_(false),
+      page_skew_(0.0f),
+      params_snapshot_(NULL) {
+  layout_cancel_ = NewPermanentTessCallback(this, &Tesseract::LayoutCancelled);
+  textord_.set_cancel(layout_cancel_);
 }
 
 Tesseract::~Tesseract() {
@@ -628,6 +759,8 @@ Tesseract::~Tesseract() {
   pixDestroy(&pix_original_);
   end_tesseract();
   sub_langs_.delete_data_pointers();
+  delete thread_pool_;
+  delete layout_cancel_;
 #ifndef NO_CUBE_BUILD
   // Delete cube objects.
   if (cube_cntxt_ != NULL) {
@@ -649,12 +782,62 @@ void Tesseract::Clear() {
   pixDestroy(&scaled_color_);
   deskew_ = FCOORD(1.0f, 0.0f);
   reskew_ = FCOORD(1.0f, 0.0f);
+  page_skew_known_ = false;
   splitter_.Clear();
   scaled_factor_ = -1;
+  stage_timings_.Clear();
+  page_counts_.Clear();
+  PageCounts::ResetAll();
+  table_cells_.clear();
   for (int i = 0; i < sub_langs_.size(); ++i)
     sub_langs_[i]->Clear();
 }
 
+// Returns the name of the dawg for MemoryUsage, as lang.kind.
+static STRING DawgName(const Dawg* dawg) {
+  STRING name = dawg->lang();
+  switch (dawg->permuter()) {
+    case PUNC_PERM: name += ".punc"; break;
+    case NUMBER_PERM: name += ".number"; break;
+    case SYSTEM_DAWG_PERM: name += ".word"; break;
+    case FREQ_DAWG_PERM: name += ".freq"; break;
+    case USER_DAWG_PERM: name += ".user-words"; break;
+    case DOC_DAWG_PERM: name += ".document-words"; break;
+    case USER_PATTERN_PERM: name += ".user-patterns"; break;
+    default: name += ".dawg"; break;
+  }
+  return name;
+}
+
+void Tesseract::AddMemoryUsage(MemoryUsage* usage) const {
+  usage->bytes[MEMORY_UNICHARSET] += unicharset.MemoryUsed();
+  if (PreTrainedTemplates != NULL) {
+    usage->bytes[MEMORY_INT_TEMPLATES] +=
+        IntTemplatesMemoryUsed(PreTrainedTemplates);
+  }
+  if (shape_table_ != NULL)
+    usage->bytes[MEMORY_SHAPE_TABLE] += shape_table_->MemoryUsed();
+  const Dict& dict = const_cast<Tesseract*>(this)->getDict();
+  for (int i = 0; i < dict.NumDawgs(); ++i) {
+    const Dawg* dawg = dict.GetDawg(i);
+    if (dawg != NULL) usage->AddDawg(DawgName(dawg), dawg->MemoryUsed());
+  }
+#ifndef NO_CUBE_BUILD
+  if (cube_cntxt_ != NULL)
+    usage->bytes[MEMORY_CUBE] += cube_cntxt_->MemoryUsed();
+#endif
+  if (AdaptedTemplates != NULL) {
+    usage->bytes[MEMORY_ADAPTIVE_TEMPLATES] +=
+        AdaptedTemplatesMemoryUsed(AdaptedTemplates);
+  }
+  if (BackupAdaptedTemplates != NULL) {
+    usage->bytes[MEMORY_ADAPTIVE_TEMPLATES] +=
+        AdaptedTemplatesMemoryUsed(BackupAdaptedTemplates);
+  }
+  for (int i = 0; i < sub_langs_.size(); ++i)
+    sub_langs_[i]->AddMemoryUsage(usage);
+}
+
 void Tesseract::SetEquationDetect(EquationDetect* detector) {
   equ_detect_ = detector;
   equ_detect_->SetLangTesseract(this);
@@ -674,18 +857,71 @@ void Tesseract::ResetDocumentDictionary() {
   for (int i = 0; i < sub_langs_.size(); ++i) {
     sub_langs_[i]->getDict().ResetDocumentDictionary();
   }
+  // The word workers keep copies of the document dictionaries.
+  for (int w = 0; w < word_workers_.size(); ++w)
+    word_workers_[w]->ResetDocumentDictionary();
+}
+
+void Tesseract::ResetForNewDocument(bool keep_adaptive) {
+  if (!keep_adaptive) ResetAdaptiveClassifier();
+  ResetDocumentDictionary();
+  prev_word_best_choice_ = NULL;
+  getDict().reset_hyphen_vars(true);
+  for (int i = 0; i < sub_langs_.size(); ++i) {
+    sub_langs_[i]->prev_word_best_choice_ = NULL;
+    sub_langs_[i]->getDict().reset_hyphen_vars(true);
+  }
+}
+
+int Tesseract::AddUserWords(const char* const* words) {
+  int num_added = getDict().AddUserWords(words);
+  for (int i = 0; i < sub_langs_.size(); ++i) {
+    num_added = MAX(num_added, sub_langs_[i]->getDict().AddUserWords(words));
+  }
+  return num_added;
+}
+
+int Tesseract::AddUserPatterns(const char* const* patterns) {
+  int num_added = getDict().AddUserPatterns(patterns);
+  for (int i = 0; i < sub_langs_.size(); ++i) {
+    num_added = MAX(num_added,
+                    sub_langs_[i]->getDict().AddUserPatterns(patterns));
+  }
+  return num_added;
+}
+
+void Tesseract::ClearUserWords() {
+  getDict().ClearUserWords();
+  for (int i = 0; i < sub_langs_.size(); ++i) {
+    sub_langs_[i]->getDict().ClearUserWords();
+  }
 }
 
 void Tesseract::SetBlackAndWhitelist() {
+  // Cached classifier results only hold for the unichars enabled when they
+  // were made.
+  bool lists_changed =
+      applied_blacklist_ != tessedit_char_blacklist.string() ||
+      applied_whitelist_ != tessedit_char_whitelist.string() ||
+      applied_unblacklist_ != tessedit_char_unblacklist.string();
+  if (lists_changed) {
+    applied_blacklist_ = tessedit_char_blacklist.string();
+    applied_whitelist_ = tessedit_char_whitelist.string();
+    applied_unblacklist_ = tessedit_char_unblacklist.string();
+    ClearClassifyCache();
+  }
   // Set the white and blacklists (if any)
   unicharset.set_black_and_whitelist(tessedit_char_blacklist.string(),
                                      tessedit_char_whitelist.string(),
                                      tessedit_char_unblacklist.string());
+  SetUpWhitelistPruner();
   // Black and white lists should apply to all loaded classifiers.
   for (int i = 0; i < sub_langs_.size(); ++i) {
     sub_langs_[i]->unicharset.set_black_and_whitelist(
         tessedit_char_blacklist.string(), tessedit_char_whitelist.string(),
         tessedit_char_unblacklist.string());
+    sub_langs_[i]->SetUpWhitelistPruner();
+    if (lists_changed) sub_langs_[i]->ClearClassifyCache();
   }
 }
 
@@ -715,7 +951,8 @@ void Tesseract::PrepareForPageseg() {
   // the newly splitted image.
   splitter_.set_orig_pix(pix_binary());
   splitter_.set_pageseg_split_strategy(max_pageseg_strategy);
-  if (splitter_.Split(true)) {
+  if (splitter_.Split(true, tessedit_parallel_layout ? RecognitionThreadPool()
+                                                     : NULL)) {
     ASSERT_HOST(splitter_.splitted_image());
     pixDestroy(&pix_binary_);
     pix_binary_ = pixClone(splitter_.splitted_image());
@@ -743,23 +980,25 @@ void Tesseract::PrepareForTessOCR(BLOCK_LIST* block_list,
   // Utilize the segmentation information available.
   splitter_.set_segmentation_block_list(block_list);
   splitter_.set_ocr_split_strategy(max_ocr_strategy);
+  ThreadPool* thread_pool =
+      tessedit_parallel_layout ? RecognitionThreadPool() : NULL;
   // Run the splitter for OCR
-  bool split_for_ocr = splitter_.Split(false);
+  bool split_for_ocr = splitter_.Split(false, thread_pool);
+  // The current segmentation was found on the image in pix_binary_.
+  Pix* pix_for_pageseg = pix_binary_;
   // Restore pix_binary to the binarized original pix for future reference.
   ASSERT_HOST(splitter_.orig_pix());
-  pixDestroy(&pix_binary_);
   pix_binary_ = pixClone(splitter_.orig_pix());
-  // If the pageseg and ocr strategies are different, refresh the block list
-  // (from the last SegmentImage call) with blobs from the real image to be used
-  // for OCR.
+  // If the pageseg and ocr strategies are different, refresh the words of the
+  // block list (from the last SegmentImage call) that differ in the real image
+  // to be used for OCR.
   if (splitter_.HasDifferentSplitStrategies()) {
-    BLOCK block("", TRUE, 0, 0, 0, 0, pixGetWidth(pix_binary_),
-                pixGetHeight(pix_binary_));
     Pix* pix_for_ocr = split_for_ocr ? splitter_.splitted_image() :
         splitter_.orig_pix();
-    extract_edges(pix_for_ocr, &block);
-    splitter_.RefreshSegmentationWithNewBlobs(block.blob_list());
+    splitter_.RefreshSegmentationWithNewImage(pix_for_pageseg, pix_for_ocr,
+                                              thread_pool);
   }
+  pixDestroy(&pix_for_pageseg);
   // The splitter isn't needed any more after this, so save memory by clearing.
   splitter_.Clear();
 }
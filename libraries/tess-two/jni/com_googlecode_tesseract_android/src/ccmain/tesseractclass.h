@@ -33,7 +33,12 @@
 #include "genericvector.h"
 #include "params.h"
 #include "ocrclass.h"
+#include "pagecounters.h"
+#include "stagetimer.h"
+#include "tablefind.h"
+#include "tesscallback.h"
 #include "textord.h"
+#include "thresholder.h"
 #include "wordrec.h"
 
 class BLOB_CHOICE_LIST_CLIST;
@@ -49,6 +54,7 @@ class TO_BLOCK_LIST;
 class WERD;
 class WERD_CHOICE;
 class WERD_RES;
+struct WordSpacingTerms;
 
 
 // Top-level class for all tesseract global instance data.
@@ -103,10 +109,12 @@ class CubeObject;
 class CubeRecoContext;
 #endif
 class EquationDetect;
+struct MemoryUsage;
 class Tesseract;
 #ifndef NO_CUBE_BUILD
 class TesseractCubeCombiner;
 #endif
+class ThreadPool;
 
 // A collection of various variables for statistics and debugging.
 struct TesseractStats {
@@ -140,6 +148,29 @@ struct TesseractStats {
   bool write_results_empty_block;
 };
 
+// Wall-clock milliseconds spent in each stage of the layout analysis of the
+// last page run through AutoPageSeg. Stages that ran concurrently (see
+// tessedit_parallel_layout) each count their own time, so the stages may
+// add up to more than the total.
+struct LayoutTimings {
+  LayoutTimings()
+    : line_finding(0.0), image_finding(0.0), components(0.0), setup(0.0),
+      find_blocks(0.0), total(0.0) {}
+
+  // LineFinder::FindAndRemoveLines.
+  double line_finding;
+  // ImageFind::FindImages.
+  double image_finding;
+  // Textord::find_components.
+  double components;
+  // Making the ColumnFinder, filtering noise and detecting orientation.
+  double setup;
+  // ColumnFinder::FindBlocks.
+  double find_blocks;
+  // All of AutoPageSeg.
+  double total;
+};
+
 // Struct to hold all the pointers to relevant data for processing a word.
 struct WordData {
   WordData() : word(NULL), row(NULL), block(NULL), prev_word(NULL) {}
@@ -156,6 +187,30 @@ struct WordData {
   PointerVector<WERD_RES> lang_words;
 };
 
+// The classifications that ReassignDiacritics has made on the current word,
+// so that a blob with the same subset of the noise outlines is not
+// classified again, and how many more it may make.
+struct DiacriticSearch {
+  explicit DiacriticSearch(int budget) : remaining(budget) {}
+
+  // Forgets the classifications, as the blobs of the word have changed.
+  void Clear() {
+    blobs.truncate(0);
+    masks.truncate(0);
+    certs.truncate(0);
+    strs.truncate(0);
+  }
+
+  // The blob, or NULL for a new blob, and the bits of the outlines added to
+  // it, of each classification, with its certainty and best string.
+  GenericVector<const C_BLOB*> blobs;
+  GenericVector<uinT64> masks;
+  GenericVector<float> certs;
+  GenericVector<STRING> strs;
+  // Classifications left, or -1 for no limit.
+  int remaining;
+};
+
 // Definition of a Tesseract WordRecognizer. The WordData provides the context
 // of row/block, in_word holds an initialized, possibly pre-classified word,
 // that the recognizer may or may not consume (but if so it sets *in_word=NULL)
@@ -179,6 +234,16 @@ class Tesseract : public Wordrec {
   void ResetAdaptiveClassifier();
   // Clear the document dictionary for this and all subclassifiers.
   void ResetDocumentDictionary();
+  // Forgets everything learned from the current document by this and all
+  // subclassifiers: the document dictionary, the hyphenated word carried
+  // over from the last line, and the adaptive classifier unless
+  // keep_adaptive. Loaded models and params are kept. Does not Clear.
+  void ResetForNewDocument(bool keep_adaptive);
+  // Add user words or patterns to the dictionary of this and all
+  // subclassifiers, returning the most any of them took, or clear them all.
+  int AddUserWords(const char* const* words);
+  int AddUserPatterns(const char* const* patterns);
+  void ClearUserWords();
 
   // Set the equation detector.
   void SetEquationDetect(EquationDetect* detector);
@@ -216,6 +281,7 @@ class Tesseract : public Wordrec {
   // In any case, the return value is a borrowed Pix, and should not be
   // deleted or pixDestroyed.
   Pix* BestPix() const { return pix_original_; }
+  Pix* pix_thresholds() const { return pix_thresholds_; }
   void set_pix_thresholds(Pix* thresholds) {
     pixDestroy(&pix_thresholds_);
     pix_thresholds_ = thresholds;
@@ -294,8 +360,134 @@ class Tesseract : public Wordrec {
       PageSegMode pageseg_mode, BLOCK_LIST* blocks, Tesseract* osd_tess,
       OSResults* osr, TO_BLOCK_LIST* to_blocks, Pix** photo_mask_pix,
       Pix** music_mask_pix);
+  // Runs AutoPageSeg on pix_binary_ reduced by the given factor (2 or 4),
+  // and scales the resulting blocks back up to full resolution. to_blocks
+  // is left empty, so Textord finds the blobs at full resolution.
+  int ReducedAutoPageSeg(PageSegMode pageseg_mode, int reduction,
+                         BLOCK_LIST* blocks, TO_BLOCK_LIST* to_blocks);
+  // Finds the text lines of pix_binary_ with only the connected components,
+  // stroke widths and textline projection, skipping the rest of layout
+  // analysis. Fills lines with their boxes and scores with the likelihood
+  // that each is text, in [0, 1].
+  void DetectTextLines(GenericVector<TBOX>* lines,
+                       GenericVector<float>* scores);
+  // Runs one of the layout stages that only read pix_binary_ once the lines
+  // are removed: 0 finds the photo mask, 1 the connected components.
+  void RunIndependentLayoutStage(Pix** photo_mask_pix, BLOCK_LIST* blocks,
+                                 TO_BLOCK_LIST* to_blocks, int stage);
+  const LayoutTimings& layout_timings() const {
+    return layout_timings_;
+  }
+  // Sets the monitor whose cancel function and deadline SegmentPage checks
+  // between the stages of layout analysis, so it can give up part way
+  // through a page. Not owned. NULL (the default) for none.
+  void set_layout_monitor(ETEXT_DESC* monitor) {
+    layout_monitor_ = monitor;
+  }
+  // Returns true if the layout monitor asks to stop, as the user cancelled
+  // or the deadline has passed.
+  bool LayoutCancelled();
+  // The cells of the tables recognized by the last AutoPageSeg, in the
+  // coordinates of pix_binary_, if textord_tablefind_recognize_tables is set.
+  // Cleared by Clear.
+  const GenericVector<TableCells>& table_cells() const {
+    return table_cells_;
+  }
+  // The time of each stage of the current page, cleared by Clear. The
+  // sub-languages' own adaption and cube times are added to these at the
+  // end of recog_all_words.
+  const StageTimings& stage_timings() const {
+    return stage_timings_;
+  }
+  StageTimings* mutable_stage_timings() {
+    return &stage_timings_;
+  }
+  // The hot-path counts of the current page, collected from all the
+  // threads at the end of recog_all_words.
+  const PageCounts& page_counts() const {
+    return page_counts_;
+  }
+  // Adds the bytes of memory used by the models of this and the
+  // sub-languages to usage.
+  void AddMemoryUsage(MemoryUsage* usage) const;
+  // Sets the skew angle of the page, in degrees with the sign convention of
+  // Leptonica's pixFindSkew (the clockwise rotation that deskews it), when it
+  // is already known, eg from Skew.findSkew, so layout analysis starts from
+  // it instead of estimating the skew again. Cleared by Clear.
+  void SetPageSkew(float angle) {
+    page_skew_ = angle;
+    page_skew_known_ = true;
+  }
+  // Returns true, with the angle in *angle, if the page skew has been set
+  // by SetPageSkew or found by EstimatePageSkew.
+  bool GetPageSkew(float* angle) const {
+    if (page_skew_known_) *angle = page_skew_;
+    return page_skew_known_;
+  }
+  // Returns the page skew as GetPageSkew, first finding it from pix_binary_
+  // if it isn't yet known and textord_estimate_page_skew is set.
+  bool EstimatePageSkew(float* angle);
+  // Makes the next init_tesseract_lang_data set the params from data, as
+  // written by ParamUtils::SerializeParams after an earlier Init with the
+  // same language and configs, instead of reading the language config and
+  // the config files. data is not owned and must outlive the Init.
+  void set_params_snapshot(const GenericVector<char>* data) {
+    params_snapshot_ = data;
+  }
   // par_control.cpp
+  // Classifies the single blobs of all the words ahead of recognition, in
+  // parallel if tessedit_parallelize is above 1, and with
+  // tessedit_cluster_glyphs, only one blob of each shape.
   void PrerecAllWordsPar(const GenericVector<WordData>& words);
+  // Switches this and all the sub-languages to classifying from a published
+  // snapshot of their adapted templates, or back to the live ones.
+  void SetClassifyFromSnapshot(bool from_snapshot);
+  // Returns the thread pool used for parallel recognition, (re)creating it if
+  // tessedit_parallelize has changed since it was last used.
+  ThreadPool* GetThreadPool();
+  // Lets the chopper classify blobs on the thread pool when
+  // tessedit_parallelize is above 1.
+  virtual ThreadPool* RecognitionThreadPool();
+  // Sets the engines, each initialized with the same languages as this, that
+  // recognize the words of pass 1 alongside this one when
+  // tessedit_parallel_words is set. They are not owned and must stay alive
+  // until the next call.
+  void set_word_workers(const GenericVector<Tesseract*>& workers) {
+    word_workers_ = workers;
+  }
+  // Runs pass 1 over the words with this and the word workers, each
+  // recognizing whole text lines against a snapshot of the adapted templates
+  // of this, then adapts to the results serially in word order.
+  bool RecogAllWordsPass1Par(ETEXT_DESC* monitor, PAGE_RES_IT* pr_it,
+                             GenericVector<WordData>* words);
+  // Recognizes words [start, end) in order as pass 1 does, but without
+  // learning from them, starting with no context from earlier words.
+  // Returns the end of the words recognized before the deadline of monitor.
+  int RecognizeWordRun(int start, int end, ETEXT_DESC* monitor,
+                       GenericVector<WordData>* words);
+  // Makes this and its sub-languages classify from the snapshots that
+  // master and its sub-languages last published, and leave learning to
+  // master.
+  void PrepareWordWorker(const Tesseract& master);
+  // Shares the page images of source and its sub-languages, or drops the
+  // images if source is NULL.
+  void SharePageImages(const Tesseract* source);
+  // Sets, for this and all the sub-languages, whether they are recognizing
+  // alongside each other or other engines on the thread pool. While they
+  // are, classify_word_pass1 leaves learning to LearnFromWordPass1, to be
+  // done in a fixed order, and RecognitionThreadPool returns NULL.
+  void SetRecognizingInParallel(bool recognizing);
+  bool recognizing_in_parallel() const {
+    return recognizing_in_parallel_;
+  }
+  // Runs recognizer on the word with each of langs concurrently, with
+  // lang_words[lang_indices[l]] as the input word of langs[l], and the
+  // output words in results[l].
+  void RecognizeLanguagesPar(WordRecognizer recognizer,
+                             const GenericVector<Tesseract*>& langs,
+                             const GenericVector<int>& lang_indices,
+                             WordData* word_data,
+                             PointerVector<WERD_RES>* results);
 
   //// control.h /////////////////////////////////////////////////////////
   bool ProcessTargetWord(const TBOX& word_box, const TBOX& target_word_box,
@@ -312,11 +504,55 @@ class Tesseract : public Wordrec {
   bool RecogAllWordsPassN(int pass_n, ETEXT_DESC* monitor,
                           PAGE_RES_IT* pr_it,
                           GenericVector<WordData>* words);
+  // Reports the progress of pass pass_n, with num_done of words done and
+  // word w next, to monitor, and returns true if recognition must stop
+  // there, as the user cancelled or, if check_deadline, the deadline has
+  // passed.
+  bool UpdateWordProgress(int pass_n, int num_done, int w,
+                          const GenericVector<WordData>& words,
+                          bool check_deadline, ETEXT_DESC* monitor);
+  // Sets the regions of the page, in page coordinates, whose words the
+  // serial passes recognize first, nearest first, so a deadline or the word
+  // callback of the monitor can stop recognition once they are done. Empty
+  // for page order.
+  void set_priority_boxes(const GenericVector<TBOX>& boxes) {
+    priority_boxes_ = boxes;
+  }
+  // Sets *order to the indices of words in the order to recognize them in,
+  // by distance from the priority boxes, or page order if there are none.
+  void PrioritizeWords(const GenericVector<WordData>& words,
+                       GenericVector<int>* order) const;
   bool recog_all_words(PAGE_RES* page_res,
                        ETEXT_DESC* monitor,
                        const TBOX* target_word_box,
                        const char* word_config,
                        int dopasses);
+  // Resets the segmentation search time budget of this and all the
+  // sub-languages, and returns their total number of words that ran out of
+  // time since.
+  void ResetSegSearchBudgets();
+  int SegSearchWordsOutOfTime() const;
+  // Marks the blocks whose words all look acceptable and are at least as
+  // certain as tessedit_fast_confident_certainty after pass 1, so the later
+  // passes skip them, when tessedit_fast_confident is set. Returns the number
+  // of blocks marked, out of *num_blocks with words.
+  int MarkFastConfidentBlocks(PAGE_RES* page_res, int* num_blocks);
+  // Returns true if word lets its block be fast confident, as above.
+  bool FastConfidentWord(const WERD_RES& word);
+  // Sets the callback that recog_all_words runs with each text line of the
+  // page, at its first word, as soon as the results of the line are final.
+  // Not owned. NULL for none.
+  void set_line_callback(TessCallback1<const PAGE_RES_IT&>* callback) {
+    line_callback_ = callback;
+  }
+  // Runs the line callback on the lines of block, unless it already did.
+  void StreamBlockLines(PAGE_RES* page_res, BLOCK_RES* block);
+  // Streams the lines of all the blocks not yet streamed, as the page is
+  // done, and forgets which were.
+  void StreamRemainingLines(PAGE_RES* page_res);
+  // With a line callback and tessedit_fast_confident, streams the lines of
+  // block right away if its words are recognized and all fast confident.
+  void StreamBlockIfFastConfident(PAGE_RES* page_res, BLOCK_RES* block);
   void rejection_passes(PAGE_RES* page_res,
                         ETEXT_DESC* monitor,
                         const TBOX* target_word_box,
@@ -332,6 +568,21 @@ class Tesseract : public Wordrec {
                         WordRecognizer recognizer,
                         WERD_RES** in_word,
                         PointerVector<WERD_RES>* best_words);
+  // The first half of RetryWithLanguage: runs the recognizer, leaving the
+  // output words in new_words.
+  void RecognizeWithLanguage(const WordData& word_data,
+                             WordRecognizer recognizer,
+                             WERD_RES** in_word,
+                             PointerVector<WERD_RES>* new_words);
+  // The second half of RetryWithLanguage: consumes new_words, moving the
+  // better ones to best_words.
+  int SelectLanguageWords(PointerVector<WERD_RES>* new_words,
+                          PointerVector<WERD_RES>* best_words);
+  // Returns true if tessedit_lang_gating rules out lang for the current
+  // block, as the block so far is clearly in a script lang doesn't have.
+  bool LanguageGatedOut(const BLOCK* block, const Tesseract* lang) const;
+  // Counts the scripts of the accepted word for tessedit_lang_gating.
+  void CountBlockScripts(const WordData& word_data);
   // Moves good-looking "noise"/diacritics from the reject list to the main
   // blob list on the current word. Returns true if anything was done, and
   // sets make_next_word_fuzzy if blob(s) were added to the end of the word.
@@ -343,23 +594,34 @@ class Tesseract : public Wordrec {
   // the word, either in the blobs or in the reject list.
   void AssignDiacriticsToOverlappingBlobs(
       const GenericVector<C_OUTLINE*>& outlines, int pass, WERD* real_word,
-      PAGE_RES_IT* pr_it, GenericVector<bool>* word_wanted,
+      PAGE_RES_IT* pr_it, DiacriticSearch* search,
+      GenericVector<bool>* word_wanted,
       GenericVector<bool>* overlapped_any_blob,
       GenericVector<C_BLOB*>* target_blobs);
   // Attempts to assign non-overlapping outlines to their nearest blobs or
   // make new blobs out of them.
   void AssignDiacriticsToNewBlobs(const GenericVector<C_OUTLINE*>& outlines,
                                   int pass, WERD* real_word, PAGE_RES_IT* pr_it,
+                                  DiacriticSearch* search,
                                   GenericVector<bool>* word_wanted,
                                   GenericVector<C_BLOB*>* target_blobs);
   // Starting with ok_outlines set to indicate which outlines overlap the blob,
   // chooses the optimal set (approximately) and returns true if any outlines
-  // are desired, in which case ok_outlines indicates which ones.
+  // are desired, in which case ok_outlines indicates which ones. Gives up on
+  // the combinations that search has no classifications left for.
   bool SelectGoodDiacriticOutlines(int pass, float certainty_threshold,
                                    PAGE_RES_IT* pr_it, C_BLOB* blob,
                                    const GenericVector<C_OUTLINE*>& outlines,
-                                   int num_outlines,
+                                   int num_outlines, DiacriticSearch* search,
                                    GenericVector<bool>* ok_outlines);
+  // Sets *cert and *best_str to the result of ClassifyBlobPlusOutlines on the
+  // arguments, taken from search if it has classified them already. Returns
+  // false if search has no classifications left for them.
+  bool ClassifyDiacriticSubset(const GenericVector<bool>& ok_outlines,
+                               const GenericVector<C_OUTLINE*>& outlines,
+                               int pass_n, PAGE_RES_IT* pr_it, C_BLOB* blob,
+                               DiacriticSearch* search, float* cert,
+                               STRING* best_str);
   // Classifies the given blob plus the outlines flagged by ok_outlines, undoes
   // the inclusion of the outlines, and returns the certainty of the raw choice.
   float ClassifyBlobPlusOutlines(const GenericVector<bool>& ok_outlines,
@@ -373,6 +635,9 @@ class Tesseract : public Wordrec {
                            STRING* best_str, float* c2);
   void classify_word_and_language(int pass_n, PAGE_RES_IT* pr_it,
                                   WordData* word_data);
+  // Adapts to the result of pass 1 on word if it is good enough, and adds
+  // it to the document dictionary. Returns true if it was added to that.
+  bool LearnFromWordPass1(WERD_RES* word);
   void classify_word_pass1(const WordData& word_data,
                            WERD_RES** in_word,
                            PointerVector<WERD_RES>* out_words);
@@ -400,6 +665,10 @@ class Tesseract : public Wordrec {
   BOOL8 recog_interactive(PAGE_RES_IT* pr_it);
 
   // Set fonts of this word.
+  // Sets the fonts of all the words of page_res and smooths them over the
+  // page, unless that was done since it was last recognized. Recognition
+  // itself leaves the fonts alone, for callers that don't want them.
+  void RecognizeFontsIfNeeded(PAGE_RES* page_res);
   void set_word_fonts(WERD_RES *word);
   void font_recognition_pass(PAGE_RES* page_res);
   void dictionary_correction_pass(PAGE_RES* page_res);
@@ -617,6 +886,15 @@ class Tesseract : public Wordrec {
   //// fixspace.cpp ///////////////////////////////////////////////////////
   BOOL8 digit_or_numeric_punct(WERD_RES *word, int char_position);
   inT16 eval_word_spacing(WERD_RES_LIST &word_res_list);
+  // Fills *terms with the parts of the eval_word_spacing score of word.
+  void word_spacing_terms(WERD_RES *word, WordSpacingTerms *terms);
+  // Replaces *terms with the terms of the words of the list, reusing the old
+  // ones of the words that are not in changed, which is in list order.
+  void update_word_spacing_terms(WERD_RES_LIST &words,
+                                 const GenericVector<WERD_RES*> &changed,
+                                 GenericVector<WordSpacingTerms> *terms);
+  // Returns the eval_word_spacing score of the words with the given terms.
+  inT16 score_word_spacing(const GenericVector<WordSpacingTerms> &terms);
   void match_current_words(WERD_RES_LIST &words, ROW *row, BLOCK* block);
   inT16 fp_eval_word_spacing(WERD_RES_LIST &word_res_list);
   void fix_noisy_space_list(WERD_RES_LIST &best_perm, ROW *row, BLOCK* block);
@@ -770,8 +1048,9 @@ class Tesseract : public Wordrec {
   void ApplyBoxTraining(const STRING& fontname, PAGE_RES* page_res);
 
   //// fixxht.cpp ///////////////////////////////////////////////////////
-  // Returns the number of misfit blob tops in this word.
-  int CountMisfitTops(WERD_RES *word_res);
+  // Returns the number of misfit blob tops in this word. If num_tops is not
+  // NULL, it receives the number of tops that were judged.
+  int CountMisfitTops(WERD_RES *word_res, int* num_tops = NULL);
   // Returns a new x-height in pixels (original image coords) that is
   // maximally compatible with the result in word_res.
   // Returns 0.0f if no x-height is found that is better than the current
@@ -797,6 +1076,22 @@ class Tesseract : public Wordrec {
             "Which OCR engine(s) to run (Tesseract, Cube, both). Defaults"
             " to loading and running only Tesseract (no Cube, no combiner)."
             " (Values from OcrEngineMode enum in tesseractclass.h)");
+  INT_VAR_H(tessedit_thresholding_method, tesseract::THRESHOLD_OTSU,
+            "Thresholding method: 0=global Otsu, 1=tiled Otsu, 2=Sauvola"
+            " (Values from ThresholdMethod enum in thresholder.h)");
+  double_VAR_H(thresholding_window_size, 0.33,
+               "Width in inches of the window of Sauvola thresholding");
+  double_VAR_H(thresholding_kfactor, 0.34,
+               "Factor reducing the Sauvola threshold for the local"
+               " deviation; >= 0");
+  double_VAR_H(thresholding_tile_size, 0.33,
+               "Width in inches of the tiles of tiled Otsu thresholding");
+  double_VAR_H(thresholding_smooth_kernel_size, 0.0,
+               "Width in inches of the kernel smoothing the thresholds of"
+               " tiled Otsu thresholding");
+  double_VAR_H(thresholding_score_fraction, 0.1,
+               "Fraction of the best Otsu score over which tiled Otsu"
+               " thresholding looks for a histogram minimum");
   STRING_VAR_H(tessedit_char_blacklist, "",
                "Blacklist of chars not to recognize");
   STRING_VAR_H(tessedit_char_whitelist, "",
@@ -868,6 +1163,8 @@ class Tesseract : public Wordrec {
                "Scaling on certainty diff from Hingepoint");
   INT_VAR_H(noise_maxperblob, 8, "Max diacritics to apply to a blob");
   INT_VAR_H(noise_maxperword, 16, "Max diacritics to apply to a word");
+  INT_VAR_H(noise_maxclassifications, 0,
+            "Max blob classifications to try diacritics on a word, if > 0");
   INT_VAR_H(debug_x_ht_level, 0, "Reestimate debug");
   BOOL_VAR_H(debug_acceptable_wds, false, "Dump word pass/fail chk");
   STRING_VAR_H(chs_leading_punct, "('`\"", "Leading punctuation");
@@ -891,10 +1188,20 @@ class Tesseract : public Wordrec {
   double_VAR_H(test_pt_x, 99999.99, "xcoord");
   double_VAR_H(test_pt_y, 99999.99, "ycoord");
   INT_VAR_H(paragraph_debug_level, 0, "Print paragraph debug info.");
+  BOOL_VAR_H(paragraph_on_demand, false,
+             "Detect the paragraphs of a recognized page only when the"
+             " result iterators first need them");
   BOOL_VAR_H(paragraph_text_based, true,
              "Run paragraph detection on the post-text-recognition "
              "(more accurate)");
   INT_VAR_H(cube_debug_level, 1, "Print cube debug info.");
+  BOOL_VAR_H(cube_combiner_skip_accepted, false,
+             "Don't run cube in the combined mode on dictionary words that"
+             " Tesseract accepts with certainty of at least"
+             " cube_combiner_skip_certainty");
+  double_VAR_H(cube_combiner_skip_certainty, -4.0,
+               "Certainty above which an accepted dictionary word is not"
+               " rechecked by cube in the combined mode");
   STRING_VAR_H(outlines_odd, "%| ", "Non standard number of outlines");
   STRING_VAR_H(outlines_2, "ij!?%\":;", "Non standard number of outlines");
   BOOL_VAR_H(docqual_excuse_outline_errs, false,
@@ -972,6 +1279,9 @@ class Tesseract : public Wordrec {
   INT_VAR_H(fixsp_non_noise_limit, 1,
             "How many non-noise blbs either side?");
   double_VAR_H(fixsp_small_outlines_size, 0.28, "Small if lt xht x this");
+  INT_VAR_H(fixsp_max_combo_blobs, 0,
+            "Don't join fuzzy spaced words into words of more than this many"
+            " blobs, if > 0");
   BOOL_VAR_H(tessedit_prefer_joined_punct, false, "Reward punctation joins");
   INT_VAR_H(fixsp_done_mode, 1, "What constitues done for spacing");
   INT_VAR_H(debug_fix_space_level, 0, "Contextual fixspace debug");
@@ -980,6 +1290,9 @@ class Tesseract : public Wordrec {
   INT_VAR_H(x_ht_acceptance_tolerance, 8,
             "Max allowed deviation of blob top outside of font data");
   INT_VAR_H(x_ht_min_change, 8, "Min change in xht before actually trying it");
+  double_VAR_H(x_ht_min_misfit_fraction, 0.0,
+               "Min fraction of the judged blob tops of a word that must be"
+               " misfits before trying a new xht on it");
   INT_VAR_H(superscript_debug, 0, "Debug level for sub & superscript fixer");
   double_VAR_H(superscript_worse_certainty, 2.0, "How many times worse "
                "certainty does a superscript position glyph need to be for us "
@@ -1008,6 +1321,9 @@ class Tesseract : public Wordrec {
   BOOL_VAR_H(tessedit_create_txt, false, "Write .txt output file");
   BOOL_VAR_H(tessedit_create_hocr, false, "Write .html hOCR output file");
   BOOL_VAR_H(tessedit_create_tsv, false, "Write .tsv output file");
+  BOOL_VAR_H(tessedit_create_json, false, "Write .json output file");
+  BOOL_VAR_H(tessedit_create_counters, false,
+             "Write .counters output file of the work done per page");
   BOOL_VAR_H(tessedit_create_pdf, false, "Write .pdf output file");
   STRING_VAR_H(unrecognised_char, "|",
                "Output char for unidentified blobs");
@@ -1080,6 +1396,58 @@ class Tesseract : public Wordrec {
   double_VAR_H(textord_tabfind_aligned_gap_fraction, 0.75,
                "Fraction of height used as a minimum gap for aligned blobs.");
   INT_VAR_H(tessedit_parallelize, 0, "Run in parallel where possible");
+  BOOL_VAR_H(tessedit_parallel_layout, true,
+             "Run independent page layout stages concurrently when"
+             " tessedit_parallelize > 1");
+  BOOL_VAR_H(tessedit_lang_gating, false,
+             "Don't retry words in languages that lack the script of the"
+             " rest of their block");
+  BOOL_VAR_H(tessedit_fast_confident, false,
+             "Skip the passes after pass 1 on blocks whose words all look"
+             " acceptable with tessedit_fast_confident_certainty");
+  double_VAR_H(tessedit_fast_confident_certainty, -2.5,
+               "Min pass 1 certainty of every word of a block that skips the"
+               " later passes");
+  BOOL_VAR_H(tessedit_parallel_words, false,
+             "Recognize the text lines of pass 1 concurrently against a"
+             " snapshot of the adapted templates, and adapt after, when"
+             " tessedit_parallelize > 1");
+  BOOL_VAR_H(tessedit_cluster_glyphs, false,
+             "Cluster the blobs of each page by shape before pass 1, and"
+             " classify only one blob of each cluster, copying its result to"
+             " the others");
+  double_VAR_H(tessedit_glyph_cluster_thresh, 0.9,
+               "Min correlation (0.4-0.98) of blobs that share a cluster with"
+               " tessedit_cluster_glyphs");
+  BOOL_VAR_H(tessedit_page_arena, false,
+             "Allocate the words of each page in an arena that is freed"
+             " at once with the page");
+  INT_VAR_H(tessedit_auto_scale_xheight, 0,
+            "If not 0, the largest x-height in pixels to recognize text at."
+            " Images with larger text are reduced by an integer factor"
+            " before layout analysis, and the results are mapped back to"
+            " the source image");
+  BOOL_VAR_H(tessedit_result_cache, false,
+             "Keep the results of the last page, and return them again"
+             " without layout analysis or recognition for a page with the"
+             " same rectangle, parameters and nearly the same binary image");
+  double_VAR_H(tessedit_result_cache_diff, 2.0,
+               "Max mean difference, in percent of the area of a cell, in the"
+               " black pixels of a coarse grid over two pages that the result"
+               " cache takes as the same");
+  BOOL_VAR_H(textord_estimate_page_skew, false,
+             "Find the page skew from the image before tab finding, so the"
+             " tab search starts from it");
+  INT_VAR_H(tessedit_layout_reduction, 1,
+            "Reduction (2 or 4) of the binary image used for automatic page"
+            " layout, which is mapped back to full resolution for"
+            " recognition. 1 runs layout at full resolution");
+  INT_VAR_H(stream_max_motion, 32,
+            "Largest shift in pixels between video frames that is looked for"
+            " in RecognizeFrame");
+  double_VAR_H(stream_line_change_fraction, 0.1,
+               "Fraction of changed pixels above which RecognizeFrame"
+               " recognizes a text line again");
   BOOL_VAR_H(preserve_interword_spaces, false,
              "Preserve multiple interword spaces");
   BOOL_VAR_H(include_page_breaks, false,
@@ -1171,6 +1539,11 @@ class Tesseract : public Wordrec {
   const char* backup_config_file_;
   // The filename of a config file to read when processing a debug word.
   STRING word_config_;
+  // The black, white and unblack lists that SetBlackAndWhitelist last applied,
+  // so it only clears the classifier caches when the enabled unichars change.
+  STRING applied_blacklist_;
+  STRING applied_whitelist_;
+  STRING applied_unblacklist_;
   // Image used for input to layout analysis and tesseract recognition.
   // May be modified by the ShiroRekhaSplitter to eliminate the top-line.
   Pix* pix_binary_;
@@ -1211,6 +1584,43 @@ class Tesseract : public Wordrec {
 #endif
   // Equation detector. Note: this pointer is NOT owned by the class.
   EquationDetect* equ_detect_;
+  // Worker threads for parallel recognition, sized by tessedit_parallelize.
+  // Created on first use.
+  ThreadPool* thread_pool_;
+  // Engines that recognize words of pass 1 alongside this one. Not owned.
+  GenericVector<Tesseract*> word_workers_;
+  // See SetRecognizingInParallel.
+  bool recognizing_in_parallel_;
+  // For tessedit_lang_gating, the block of the last word counted by
+  // CountBlockScripts, and the number of accepted characters of each script
+  // name in it so far.
+  const BLOCK* gating_block_;
+  GenericVector<STRING> gating_scripts_;
+  GenericVector<int> gating_counts_;
+  int gating_total_;
+  // Time taken by the stages of the last AutoPageSeg.
+  LayoutTimings layout_timings_;
+  // See table_cells.
+  GenericVector<TableCells> table_cells_;
+  // Time taken by the stages of the current page.
+  StageTimings stage_timings_;
+  // Counts of the work done on the current page.
+  PageCounts page_counts_;
+  // See set_line_callback.
+  TessCallback1<const PAGE_RES_IT&>* line_callback_;
+  // The blocks whose lines the line callback already had on this page.
+  GenericVector<const BLOCK_RES*> streamed_blocks_;
+  // See set_priority_boxes.
+  GenericVector<TBOX> priority_boxes_;
+  // See set_layout_monitor.
+  ETEXT_DESC* layout_monitor_;
+  // Permanent callback to LayoutCancelled, for the ColumnFinder and Textord.
+  TessResultCallback<bool>* layout_cancel_;
+  // Skew of the current page, if page_skew_known_. See SetPageSkew.
+  bool page_skew_known_;
+  float page_skew_;
+  // Params to restore in init_tesseract_lang_data, if not NULL. Not owned.
+  const GenericVector<char>* params_snapshot_;
 };
 
 }  // namespace tesseract
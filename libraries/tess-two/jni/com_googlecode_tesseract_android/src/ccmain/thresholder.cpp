@@ -23,17 +23,76 @@
 
 #include <string.h>
 
+#include "helpers.h"
 #include "otsuthr.h"
+#include "simddetect.h"
+#include "thresholdsimd.h"
 
 #include "openclwrapper.h"
+#include "vulkanwrapper.h"
 
 namespace tesseract {
 
+// Returns the fastest row kernel for 8 bit grey images on this CPU, or NULL
+// if there is none and the scalar code must be used.
+static GreyRowThresholdFunc BestGreyRowKernel() {
+#ifndef L_BIG_ENDIAN
+  if (SIMDDetect::IsAVX2Available()) return ThresholdGreyRowAVX2;
+  if (SIMDDetect::IsSSE2Available()) return ThresholdGreyRowSSE2;
+  if (SIMDDetect::IsNEONAvailable()) return ThresholdGreyRowNEON;
+#endif
+  return NULL;
+}
+
+// As BestGreyRowKernel, but for 32 bit images.
+static ColorRowThresholdFunc BestColorRowKernel() {
+#ifndef L_BIG_ENDIAN
+  if (SIMDDetect::IsAVX2Available()) return ThresholdColorRowAVX2;
+  if (SIMDDetect::IsSSE2Available()) return ThresholdColorRowSSE2;
+  if (SIMDDetect::IsNEONAvailable()) return ThresholdColorRowNEON;
+#endif
+  return NULL;
+}
+
+// Width and height in pixels of the tiles in which pixSauvolaBinarizeTiled
+// is run, which bound the size of its accumulators.
+const int kSauvolaTileSize = 250;
+
+// Expands the thresholds found by pixOtsuAdaptiveThreshold for each tile of
+// a width x height image, which it tiles as pixTilingCreate does, into an
+// image of the threshold at each pixel.
+static Pix* ExpandTileThresholds(Pix* tile_thresholds, int width, int height) {
+  int num_x = pixGetWidth(tile_thresholds);
+  int num_y = pixGetHeight(tile_thresholds);
+  int tile_width = width / num_x;
+  int tile_height = height / num_y;
+  Pix* pix_thresholds = pixCreate(width, height, 8);
+  for (int y = 0; y < num_y; ++y) {
+    int top = y * tile_height;
+    int box_height = y == num_y - 1 ? height - top : tile_height;
+    for (int x = 0; x < num_x; ++x) {
+      int left = x * tile_width;
+      int box_width = x == num_x - 1 ? width - left : tile_width;
+      l_uint32 threshold;
+      pixGetPixel(tile_thresholds, x, y, &threshold);
+      Box* box = boxCreate(left, top, box_width, box_height);
+      pixSetInRectArbitrary(pix_thresholds, box, threshold);
+      boxDestroy(&box);
+    }
+  }
+  return pix_thresholds;
+}
+
 ImageThresholder::ImageThresholder()
   : pix_(NULL),
     image_width_(0), image_height_(0),
     pix_channels_(0), pix_wpl_(0),
-    scale_(1), yres_(300), estimated_res_(300) {
+    scale_(1), yres_(300), estimated_res_(300), grey_histogram_(NULL),
+    threshold_method_(THRESHOLD_OTSU), window_size_(0.0), kfactor_(0.0),
+    tile_size_(0.0), smooth_size_(0.0), score_fraction_(0.0),
+    pix_thresholds_(NULL), reduction_(1), unreduced_pix_(NULL),
+    unreduced_left_(0), unreduced_top_(0), unreduced_width_(0),
+    unreduced_height_(0), unreduced_yres_(0), unreduced_estimated_res_(0) {
   SetRectangle(0, 0, 0, 0);
 }
 
@@ -44,6 +103,11 @@ ImageThresholder::~ImageThresholder() {
 // Destroy the Pix if there is one, freeing memory.
 void ImageThresholder::Clear() {
   pixDestroy(&pix_);
+  pixDestroy(&unreduced_pix_);
+  reduction_ = 1;
+  pixDestroy(&pix_thresholds_);
+  delete [] grey_histogram_;
+  grey_histogram_ = NULL;
 }
 
 // Return true if no image has been set.
@@ -116,13 +180,100 @@ void ImageThresholder::SetImage(const unsigned char* imagedata,
   pixDestroy(&pix);
 }
 
+// Sets the image from rows of 32 bit RGBA pixels, with the bytes in R, G,
+// B, A order in memory, as locked from an Android RGBA_8888 bitmap.
+// Each pixel is reduced to 8 bit grey as the mean of R, G and B, and the
+// grey histogram is accumulated in the same pass, so the full-image Otsu
+// threshold needs no further pass over the pixels. Like SetImage, this
+// makes its own copy, so rgba may be released immediately after the call.
+void ImageThresholder::SetRGBAImageAsGrey(const unsigned char* rgba,
+                                          int width, int height,
+                                          int bytes_per_line) {
+  Clear();
+  pix_ = pixCreateNoInit(width, height, 8);
+  grey_histogram_ = new int[kHistogramSize];
+  memset(grey_histogram_, 0, sizeof(*grey_histogram_) * kHistogramSize);
+  l_uint32* data = pixGetData(pix_);
+  int wpl = pixGetWpl(pix_);
+  for (int y = 0; y < height; ++y, data += wpl, rgba += bytes_per_line) {
+    const unsigned char* src = rgba;
+    // Assemble whole words of 4 grey pixels, most significant byte first,
+    // which is the Leptonica layout regardless of the host byte order.
+    int x = 0;
+    for (int w = 0; x + 4 <= width; ++w, x += 4, src += 16) {
+      uinT32 g0 = (src[0] + src[1] + src[2]) / 3;
+      uinT32 g1 = (src[4] + src[5] + src[6]) / 3;
+      uinT32 g2 = (src[8] + src[9] + src[10]) / 3;
+      uinT32 g3 = (src[12] + src[13] + src[14]) / 3;
+      ++grey_histogram_[g0];
+      ++grey_histogram_[g1];
+      ++grey_histogram_[g2];
+      ++grey_histogram_[g3];
+      data[w] = (g0 << 24) | (g1 << 16) | (g2 << 8) | g3;
+    }
+    if (x < width) data[x / 4] = 0;
+    for (; x < width; ++x, src += 4) {
+      int grey = (src[0] + src[1] + src[2]) / 3;
+      ++grey_histogram_[grey];
+      SET_DATA_BYTE(data, x, grey);
+    }
+  }
+  image_width_ = width;
+  image_height_ = height;
+  pix_channels_ = 1;
+  pix_wpl_ = wpl;
+  scale_ = 1;
+  estimated_res_ = yres_ = pixGetYRes(pix_);
+  Init();
+}
+
+// Sets the image from rows of 8 bit grey pixels, such as the Y plane of a
+// camera frame, gathering the grey histogram as the rows are copied.
+void ImageThresholder::SetGreyImage(const unsigned char* grey,
+                                    int width, int height,
+                                    int bytes_per_line) {
+  Clear();
+  pix_ = pixCreateNoInit(width, height, 8);
+  grey_histogram_ = new int[kHistogramSize];
+  memset(grey_histogram_, 0, sizeof(*grey_histogram_) * kHistogramSize);
+  l_uint32* data = pixGetData(pix_);
+  int wpl = pixGetWpl(pix_);
+  for (int y = 0; y < height; ++y, data += wpl, grey += bytes_per_line) {
+    const unsigned char* src = grey;
+    // Assemble whole words, most significant byte first, as above.
+    int x = 0;
+    for (int w = 0; x + 4 <= width; ++w, x += 4, src += 4) {
+      ++grey_histogram_[src[0]];
+      ++grey_histogram_[src[1]];
+      ++grey_histogram_[src[2]];
+      ++grey_histogram_[src[3]];
+      data[w] = (static_cast<uinT32>(src[0]) << 24) | (src[1] << 16) |
+                (src[2] << 8) | src[3];
+    }
+    if (x < width) data[x / 4] = 0;
+    for (; x < width; ++x, ++src) {
+      ++grey_histogram_[*src];
+      SET_DATA_BYTE(data, x, *src);
+    }
+  }
+  image_width_ = width;
+  image_height_ = height;
+  pix_channels_ = 1;
+  pix_wpl_ = wpl;
+  scale_ = 1;
+  estimated_res_ = yres_ = pixGetYRes(pix_);
+  Init();
+}
+
 // Store the coordinates of the rectangle to process for later use.
 // Doesn't actually do any thresholding.
 void ImageThresholder::SetRectangle(int left, int top, int width, int height) {
+  RestoreUnreducedImage();
   rect_left_ = left;
   rect_top_ = top;
   rect_width_ = width;
   rect_height_ = height;
+  pixDestroy(&pix_thresholds_);
 }
 
 // Get enough parameters to be able to rebuild bounding boxes in the
@@ -132,6 +283,15 @@ void ImageThresholder::SetRectangle(int left, int top, int width, int height) {
 void ImageThresholder::GetImageSizes(int* left, int* top,
                                      int* width, int* height,
                                      int* imagewidth, int* imageheight) {
+  if (unreduced_pix_ != NULL) {
+    *left = unreduced_left_;
+    *top = unreduced_top_;
+    *width = unreduced_width_;
+    *height = unreduced_height_;
+    *imagewidth = pixGetWidth(unreduced_pix_);
+    *imageheight = pixGetHeight(unreduced_pix_);
+    return;
+  }
   *left = rect_left_;
   *top = rect_top_;
   *width = rect_width_;
@@ -140,14 +300,63 @@ void ImageThresholder::GetImageSizes(int* left, int* top,
   *imageheight = image_height_;
 }
 
+// Reduces the rectangle by the integer factor reduction, replacing pix_
+// with the reduced rectangle, which becomes the whole image.
+void ImageThresholder::ReduceRectangle(int reduction) {
+  if (pix_ == NULL || reduction <= 1 || reduction_ > 1) return;
+  Pix* rect = GetPixRect();
+  float scale = 1.0f / reduction;
+  // Binary images are reduced to grey, to be thresholded again, as area
+  // mapping keeps more of fine text than subsampling the binary does.
+  Pix* reduced = pixGetDepth(rect) == 1 ? pixScaleToGray(rect, scale)
+                                        : pixScaleAreaMap(rect, scale, scale);
+  pixDestroy(&rect);
+  if (reduced == NULL) return;
+  unreduced_pix_ = pix_;
+  unreduced_left_ = rect_left_;
+  unreduced_top_ = rect_top_;
+  unreduced_width_ = rect_width_;
+  unreduced_height_ = rect_height_;
+  unreduced_yres_ = yres_;
+  unreduced_estimated_res_ = estimated_res_;
+  pix_ = reduced;
+  reduction_ = reduction;
+  pixGetDimensions(pix_, &image_width_, &image_height_, NULL);
+  pix_channels_ = pixGetDepth(pix_) / 8;
+  pix_wpl_ = pixGetWpl(pix_);
+  yres_ = MAX(1, yres_ / reduction);
+  estimated_res_ = MAX(1, estimated_res_ / reduction);
+  // The histogram was of the source image.
+  delete [] grey_histogram_;
+  grey_histogram_ = NULL;
+  rect_left_ = 0;
+  rect_top_ = 0;
+  rect_width_ = image_width_;
+  rect_height_ = image_height_;
+  pixDestroy(&pix_thresholds_);
+}
+
+// Puts back the source image of ReduceRectangle, if it was reduced.
+void ImageThresholder::RestoreUnreducedImage() {
+  if (unreduced_pix_ == NULL) return;
+  pixDestroy(&pix_);
+  pix_ = unreduced_pix_;
+  unreduced_pix_ = NULL;
+  pixGetDimensions(pix_, &image_width_, &image_height_, NULL);
+  pix_channels_ = pixGetDepth(pix_) / 8;
+  pix_wpl_ = pixGetWpl(pix_);
+  yres_ = unreduced_yres_;
+  estimated_res_ = unreduced_estimated_res_;
+  reduction_ = 1;
+}
+
 // Pix vs raw, which to use? Pix is the preferred input for efficiency,
 // since raw buffers are copied.
 // SetImage for Pix clones its input, so the source pix may be pixDestroyed
 // immediately after, but may not go away until after the Thresholder has
 // finished with it.
 void ImageThresholder::SetImage(const Pix* pix) {
-  if (pix_ != NULL)
-    pixDestroy(&pix_);
+  Clear();
   Pix* src = const_cast<Pix*>(pix);
   int depth;
   pixGetDimensions(src, &image_width_, &image_height_, &depth);
@@ -176,17 +385,34 @@ void ImageThresholder::SetImage(const Pix* pix) {
   Init();
 }
 
+// Sets the method used by ThresholdToPix, with the sizes of its windows
+// in inches of the source image.
+void ImageThresholder::SetThresholdMethod(ThresholdMethod method,
+                                          double window_size, double kfactor,
+                                          double tile_size, double smooth_size,
+                                          double score_fraction) {
+  threshold_method_ = method >= 0 && method < THRESHOLD_METHOD_COUNT
+      ? method : THRESHOLD_OTSU;
+  window_size_ = window_size;
+  kfactor_ = kfactor;
+  tile_size_ = tile_size;
+  smooth_size_ = smooth_size;
+  score_fraction_ = score_fraction;
+}
+
 // Threshold the source image as efficiently as possible to the output Pix.
 // Creates a Pix and sets pix to point to the resulting pointer.
 // Caller must use pixDestroy to free the created Pix.
 void ImageThresholder::ThresholdToPix(PageSegMode pageseg_mode, Pix** pix) {
+  pixDestroy(&pix_thresholds_);
   if (pix_channels_ == 0) {
     // We have a binary image, but it still has to be copied, as this API
     // allows the caller to modify the output.
     Pix* original = GetPixRect();
     *pix = pixCopy(NULL, original);
     pixDestroy(&original);
-  } else {
+  } else if (threshold_method_ == THRESHOLD_OTSU ||
+             !AdaptiveThresholdRectToPix(pix)) {
     OtsuThresholdRectToPix(pix_, pix);
   }
 }
@@ -200,12 +426,14 @@ void ImageThresholder::ThresholdToPix(PageSegMode pageseg_mode, Pix** pix) {
 // Returns NULL if the input is binary. PixDestroy after use.
 Pix* ImageThresholder::GetPixRectThresholds() {
   if (IsBinary()) return NULL;
+  if (pix_thresholds_ != NULL) return pixClone(pix_thresholds_);
   Pix* pix_grey = GetPixRectGrey();
   int width = pixGetWidth(pix_grey);
   int height = pixGetHeight(pix_grey);
   int* thresholds;
   int* hi_values;
-  OtsuThreshold(pix_grey, 0, 0, width, height, &thresholds, &hi_values);
+  if (OtsuThresholdFromCachedHistogram(&thresholds, &hi_values) == 0)
+    OtsuThreshold(pix_grey, 0, 0, width, height, &thresholds, &hi_values);
   pixDestroy(&pix_grey);
   Pix* pix_thresholds = pixCreate(width, height, 8);
   int threshold = thresholds[0] > 0 ? thresholds[0] : 128;
@@ -261,22 +489,38 @@ void ImageThresholder::OtsuThresholdRectToPix(Pix* src_pix,
   int* thresholds;
   int* hi_values;
 
-  int num_channels = OtsuThreshold(src_pix, rect_left_, rect_top_, rect_width_,
-                                   rect_height_, &thresholds, &hi_values);
+  int num_channels = 0;
+  if (src_pix == pix_)
+    num_channels = OtsuThresholdFromCachedHistogram(&thresholds, &hi_values);
+  if (num_channels == 0) {
+    num_channels = OtsuThreshold(src_pix, rect_left_, rect_top_, rect_width_,
+                                 rect_height_, &thresholds, &hi_values);
+  }
   // only use opencl if compiled w/ OpenCL and selected device is opencl
 #ifdef USE_OPENCL
-  OpenclDevice od;
-  if ((num_channels == 4 || num_channels == 1) &&
-      od.selectedDeviceIsOpenCL() && rect_top_ == 0 && rect_left_ == 0 ) {
-    od.ThresholdRectToPixOCL((unsigned char*)pixGetData(src_pix), num_channels,
-                             pixGetWpl(src_pix) * 4, thresholds, hi_values,
-                             out_pix /*pix_OCL*/, rect_height_, rect_width_,
-                             rect_top_, rect_left_);
+  OpenclRoute route(OCL_THRESHOLD_RECT_TO_PIX, rect_width_ * rect_height_,
+                    (num_channels == 4 || num_channels == 1) &&
+                    rect_top_ == 0 && rect_left_ == 0);
+  if (route.opencl()) {
+    OpenclDevice::ThresholdRectToPixOCL(
+        (unsigned char*)pixGetData(src_pix), num_channels,
+        pixGetWpl(src_pix) * 4, thresholds, hi_values, out_pix /*pix_OCL*/,
+        rect_height_, rect_width_, rect_top_, rect_left_);
   } else {
+#endif
+#ifdef USE_VULKAN
+  if (!VulkanDevice::ThresholdRectToPixVK(src_pix, num_channels, thresholds,
+                                          hi_values, rect_left_, rect_top_,
+                                          rect_width_, rect_height_,
+                                          out_pix)) {
 #endif
     ThresholdRectToPix(src_pix, num_channels, thresholds, hi_values, out_pix);
+#ifdef USE_VULKAN
+  }
+#endif
 #ifdef USE_OPENCL
   }
+  route.Finish();
 #endif
   delete [] thresholds;
   delete [] hi_values;
@@ -284,6 +528,63 @@ void ImageThresholder::OtsuThresholdRectToPix(Pix* src_pix,
   PERF_COUNT_END
 }
 
+// Thresholds the grey rectangle by the adaptive threshold_method_, keeping
+// its thresholds for GetPixRectThresholds. Only the rectangle is cropped
+// and reduced to grey, so nothing outside it is processed.
+bool ImageThresholder::AdaptiveThresholdRectToPix(Pix** out_pix) {
+  PERF_COUNT_START("AdaptiveThresholdRectToPix")
+  Pix* pix_grey = GetPixRectGrey();
+  int width = pixGetWidth(pix_grey);
+  int height = pixGetHeight(pix_grey);
+  Pix* pix_binary = NULL;
+  Pix* pix_thresholds = NULL;
+  if (threshold_method_ == THRESHOLD_SAUVOLA) {
+    int half_window = MAX(2, IntCastRounded(window_size_ * yres_ / 2));
+    // The window must fit in the rectangle.
+    half_window = MIN(half_window, (MIN(width, height) - 3) / 2);
+    if (half_window >= 2) {
+      int num_x = MAX(1, IntCastRounded(static_cast<double>(width) /
+                                        kSauvolaTileSize));
+      int num_y = MAX(1, IntCastRounded(static_cast<double>(height) /
+                                        kSauvolaTileSize));
+      pixSauvolaBinarizeTiled(pix_grey, half_window, MAX(0.0, kfactor_),
+                              num_x, num_y, &pix_thresholds, &pix_binary);
+    }
+  } else {
+    // Leptonica requires tiles of at least 16 pixels.
+    int tile_size = MAX(16, IntCastRounded(tile_size_ * yres_));
+    int half_smooth = MAX(0, IntCastRounded(smooth_size_ * yres_ / 2));
+    Pix* tile_thresholds = NULL;
+    if (pixOtsuAdaptiveThreshold(pix_grey, tile_size, tile_size, half_smooth,
+                                 half_smooth, score_fraction_,
+                                 &tile_thresholds, &pix_binary) == 0) {
+      pix_thresholds = ExpandTileThresholds(tile_thresholds, width, height);
+    }
+    pixDestroy(&tile_thresholds);
+  }
+  pixDestroy(&pix_grey);
+  PERF_COUNT_END
+  if (pix_binary == NULL || pix_thresholds == NULL) {
+    pixDestroy(&pix_binary);
+    pixDestroy(&pix_thresholds);
+    return false;
+  }
+  *out_pix = pix_binary;
+  pix_thresholds_ = pix_thresholds;
+  return true;
+}
+
+// Computes the Otsu threshold of the full grey image from the histogram
+// gathered by SetRGBAImageAsGrey. Returns the number of channels (always 1)
+// on success, or 0 if there is no cached histogram or only a sub-rectangle
+// of the image is being processed.
+int ImageThresholder::OtsuThresholdFromCachedHistogram(int** thresholds,
+                                                       int** hi_values) const {
+  if (grey_histogram_ == NULL || !IsFullImage())
+    return 0;
+  return OtsuThresholdFromHistograms(grey_histogram_, 1, thresholds, hi_values);
+}
+
 /// Threshold the rectangle, taking everything except the src_pix
 /// from the class, using thresholds/hi_values to the output pix.
 /// NOTE that num_channels is the size of the thresholds and hi_values
@@ -299,10 +600,34 @@ void ImageThresholder::ThresholdRectToPix(Pix* src_pix,
   int wpl = pixGetWpl(*pix);
   int src_wpl = pixGetWpl(src_pix);
   uinT32* srcdata = pixGetData(src_pix);
+  // The SIMD kernels take whole runs of 32 pixels, which for 8 bit images
+  // must start on a word boundary, and leave the remainder of each row to
+  // the scalar loop below.
+  bool thresholds_in_range = true;
+  for (int ch = 0; ch < num_channels; ++ch) {
+    if (hi_values[ch] >= 0 && thresholds[ch] < 0)
+      thresholds_in_range = false;
+  }
+  GreyRowThresholdFunc grey_kernel = NULL;
+  ColorRowThresholdFunc color_kernel = NULL;
+  if (thresholds_in_range && num_channels == 1 && hi_values[0] >= 0 &&
+      rect_left_ % 4 == 0) {
+    grey_kernel = BestGreyRowKernel();
+  } else if (thresholds_in_range && num_channels == 4) {
+    color_kernel = BestColorRowKernel();
+  }
   for (int y = 0; y < rect_height_; ++y) {
     const uinT32* linedata = srcdata + (y + rect_top_) * src_wpl;
     uinT32* pixline = pixdata + y * wpl;
-    for (int x = 0; x < rect_width_; ++x) {
+    int x = 0;
+    if (grey_kernel != NULL) {
+      x = grey_kernel(linedata + rect_left_ / 4, rect_width_, thresholds[0],
+                      hi_values[0], pixline);
+    } else if (color_kernel != NULL) {
+      x = color_kernel(linedata + rect_left_, rect_width_, thresholds,
+                       hi_values, pixline);
+    }
+    for (; x < rect_width_; ++x) {
       bool white_result = true;
       for (int ch = 0; ch < num_channels; ++ch) {
         int pixel = GET_DATA_BYTE(const_cast<void*>(
@@ -27,6 +27,15 @@ struct Pix;
 
 namespace tesseract {
 
+/// Methods of binarizing a grey or color image in ThresholdToPix, as set by
+/// tessedit_thresholding_method.
+enum ThresholdMethod {
+  THRESHOLD_OTSU,           ///< Global Otsu threshold for each channel.
+  THRESHOLD_ADAPTIVE_OTSU,  ///< Otsu threshold for each tile of the grey image.
+  THRESHOLD_SAUVOLA,        ///< Sauvola threshold for each grey pixel.
+  THRESHOLD_METHOD_COUNT
+};
+
 /// Base class for all tesseract image thresholding classes.
 /// Specific classes can add new thresholding methods by
 /// overriding ThresholdToPix.
@@ -55,6 +64,23 @@ class TESS_API ImageThresholder {
   void SetImage(const unsigned char* imagedata, int width, int height,
                 int bytes_per_pixel, int bytes_per_line);
 
+  /// Sets the image from rows of 32 bit RGBA pixels, with the bytes in R, G,
+  /// B, A order in memory, as locked from an Android RGBA_8888 bitmap.
+  /// Each pixel is reduced to 8 bit grey as the mean of R, G and B, and the
+  /// grey histogram is accumulated in the same pass, so the full-image Otsu
+  /// threshold needs no further pass over the pixels. Like SetImage, this
+  /// makes its own copy, so rgba may be released immediately after the call.
+  void SetRGBAImageAsGrey(const unsigned char* rgba, int width, int height,
+                          int bytes_per_line);
+
+  /// Sets the image from rows of 8 bit grey pixels, such as the Y (luma)
+  /// plane at the start of an Android NV21 or YUV_420_888 camera frame.
+  /// The rows are copied into place in a single pass that also accumulates
+  /// the grey histogram, as SetRGBAImageAsGrey does. grey may be released
+  /// immediately after the call.
+  void SetGreyImage(const unsigned char* grey, int width, int height,
+                    int bytes_per_line);
+
   /// Store the coordinates of the rectangle to process for later use.
   /// Doesn't actually do any thresholding.
   void SetRectangle(int left, int top, int width, int height);
@@ -80,6 +106,16 @@ class TESS_API ImageThresholder {
     return scale_;
   }
 
+  /// Reduces the rectangle by the integer factor reduction (> 1), so it is
+  /// thresholded and recognized at 1/reduction of its size. GetImageSizes
+  /// still gives the rectangle and image of the source, and coordinates in
+  /// the reduced image must be multiplied by GetReductionFactor to map them
+  /// back to it. SetRectangle undoes the reduction.
+  void ReduceRectangle(int reduction);
+  int GetReductionFactor() const {
+    return reduction_;
+  }
+
   // Set the resolution of the source image in pixels per inch.
   // This should be called right after SetImage(), and will let us return
   // appropriate font sizes for the text.
@@ -114,6 +150,15 @@ class TESS_API ImageThresholder {
   /// finished with it.
   void SetImage(const Pix* pix);
 
+  /// Sets the method used by ThresholdToPix, with the sizes of its windows
+  /// in inches of the source image. window_size and kfactor are the window
+  /// width and k factor of Sauvola; tile_size, smooth_size and score_fraction
+  /// are the tile width, width of the kernel smoothing the tile thresholds,
+  /// and score fraction of pixOtsuAdaptiveThreshold.
+  void SetThresholdMethod(ThresholdMethod method, double window_size,
+                          double kfactor, double tile_size, double smooth_size,
+                          double score_fraction);
+
   /// Threshold the source image as efficiently as possible to the output Pix.
   /// Creates a Pix and sets pix to point to the resulting pointer.
   /// Caller must use pixDestroy to free the created Pix.
@@ -148,6 +193,9 @@ class TESS_API ImageThresholder {
   /// Common initialization shared between SetImage methods.
   virtual void Init();
 
+  /// Puts back the source image of ReduceRectangle, if it was reduced.
+  void RestoreUnreducedImage();
+
   /// Return true if we are processing the full image.
   bool IsFullImage() const {
     return rect_left_ == 0 && rect_top_ == 0 &&
@@ -157,6 +205,18 @@ class TESS_API ImageThresholder {
   // Otsu thresholds the rectangle, taking the rectangle from *this.
   void OtsuThresholdRectToPix(Pix* src_pix, Pix** out_pix) const;
 
+  // Thresholds the grey rectangle by the adaptive threshold_method_, keeping
+  // its thresholds for GetPixRectThresholds. Returns false, with *out_pix
+  // untouched, if the method could not be applied, as to a rectangle smaller
+  // than the window.
+  bool AdaptiveThresholdRectToPix(Pix** out_pix);
+
+  // Computes the Otsu threshold of the full grey image from the histogram
+  // gathered by SetRGBAImageAsGrey. Returns the number of channels (always 1)
+  // on success, or 0 if there is no cached histogram or only a sub-rectangle
+  // of the image is being processed.
+  int OtsuThresholdFromCachedHistogram(int** thresholds, int** hi_values) const;
+
   /// Threshold the rectangle, taking everything except the src_pix
   /// from the class, using thresholds/hi_values to the output pix.
   /// NOTE that num_channels is the size of the thresholds and hi_values
@@ -182,6 +242,29 @@ class TESS_API ImageThresholder {
   int                  rect_top_;
   int                  rect_width_;
   int                  rect_height_;
+  /// Histogram of the whole grey pix_, if it was gathered while setting the
+  /// image, otherwise NULL.
+  int*                 grey_histogram_;
+  /// Method used by ThresholdToPix, and its sizes in inches.
+  ThresholdMethod      threshold_method_;
+  double               window_size_;
+  double               kfactor_;
+  double               tile_size_;
+  double               smooth_size_;
+  double               score_fraction_;
+  /// Thresholds of the rectangle found by the last ThresholdToPix, if it used
+  /// an adaptive method, otherwise NULL.
+  Pix*                 pix_thresholds_;
+  /// Reduction of pix_ from the source image, by ReduceRectangle, which keeps
+  /// the source image and its rectangle to report and restore them.
+  int                  reduction_;
+  Pix*                 unreduced_pix_;
+  int                  unreduced_left_;
+  int                  unreduced_top_;
+  int                  unreduced_width_;
+  int                  unreduced_height_;
+  int                  unreduced_yres_;
+  int                  unreduced_estimated_res_;
 };
 
 }  // namespace tesseract.
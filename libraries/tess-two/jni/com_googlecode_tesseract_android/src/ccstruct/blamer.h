@@ -32,6 +32,15 @@
 
 static const inT16 kBlamerBoxTolerance = 5;
 
+// Builds that never look for the causes of errors define NO_BLAMER, so that
+// the blamer hooks on the recognition path fold away at compile time. Words
+// then never get a BlamerBundle, and wordrec_run_blamer does nothing.
+#ifdef NO_BLAMER
+static const bool kBlamerEnabled = false;
+#else
+static const bool kBlamerEnabled = true;
+#endif
+
 // Enum for expressing the source of error.
 // Note: Please update kIncorrectResultReasonNames when modifying this enum.
 enum IncorrectResultReason {
@@ -209,6 +209,42 @@ void TESSLINE::Scale(float factor) {
   SetupFromPos();
 }
 
+void TESSLINE::ShiftScaleRotate(const ICOORD& pre_shift, float scale,
+                                const FCOORD* rotation,
+                                const ICOORD& post_shift) {
+  EDGEPT* pt = loop;
+  if (scale == 1.0f && rotation == NULL) {
+    // Only integer additions are left.
+    int x_shift = pre_shift.x() + post_shift.x();
+    int y_shift = pre_shift.y() + post_shift.y();
+    do {
+      pt->pos.x += x_shift;
+      pt->pos.y += y_shift;
+      pt = pt->next;
+    } while (pt != loop);
+  } else {
+    do {
+      int x = pt->pos.x + pre_shift.x();
+      int y = pt->pos.y + pre_shift.y();
+      if (scale != 1.0f) {
+        x = static_cast<int>(floor(x * scale + 0.5));
+        y = static_cast<int>(floor(y * scale + 0.5));
+      }
+      if (rotation != NULL) {
+        int tmp = static_cast<int>(floor(x * rotation->x() -
+                                         y * rotation->y() + 0.5));
+        y = static_cast<int>(floor(y * rotation->x() +
+                                   x * rotation->y() + 0.5));
+        x = tmp;
+      }
+      pt->pos.x = x + post_shift.x();
+      pt->pos.y = y + post_shift.y();
+      pt = pt->next;
+    } while (pt != loop);
+  }
+  SetupFromPos();
+}
+
 // Sets up the start and vec members of the loop from the pos members.
 void TESSLINE::SetupFromPos() {
   EDGEPT* pt = loop;
@@ -458,6 +494,14 @@ void TBLOB::Scale(float factor) {
   }
 }
 
+void TBLOB::ShiftScaleRotate(const ICOORD& pre_shift, float scale,
+                             const FCOORD* rotation,
+                             const ICOORD& post_shift) {
+  for (TESSLINE* outline = outlines; outline != NULL; outline = outline->next) {
+    outline->ShiftScaleRotate(pre_shift, scale, rotation, post_shift);
+  }
+}
+
 // Recomputes the bounding boxes of the outlines.
 void TBLOB::ComputeBoundingBoxes() {
   for (TESSLINE* outline = outlines; outline != NULL; outline = outline->next) {
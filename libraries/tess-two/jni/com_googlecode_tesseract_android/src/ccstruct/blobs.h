@@ -31,6 +31,7 @@
 ----------------------------------------------------------------------*/
 #include "clst.h"
 #include "normalis.h"
+#include "pagearena.h"
 #include "publictypes.h"
 #include "rect.h"
 #include "vecfuncs.h"
@@ -73,7 +74,7 @@ struct TPOINT {
 };
 typedef TPOINT VECTOR;           // structure for coordinates.
 
-struct EDGEPT {
+struct EDGEPT : public tesseract::PageArenaAllocated {
   EDGEPT()
   : next(NULL), prev(NULL), src_outline(NULL), start_step(0), step_count(0) {
     memset(flags, 0, EDGEPTFLAGS * sizeof(flags[0]));
@@ -177,7 +178,7 @@ struct EDGEPT {
 // For use in chop and findseam to keep a list of which EDGEPTs were inserted.
 CLISTIZEH(EDGEPT);
 
-struct TESSLINE {
+struct TESSLINE : public tesseract::PageArenaAllocated {
   TESSLINE() : is_hole(false), loop(NULL), next(NULL) {}
   TESSLINE(const TESSLINE& src) : loop(NULL), next(NULL) {
     CopyFrom(src);
@@ -203,6 +204,11 @@ struct TESSLINE {
   void Move(const ICOORD vec);
   // Scales by the given factor in place.
   void Scale(float factor);
+  // Moves by pre_shift, scales by scale, rotates by *rotation unless it is
+  // NULL, and moves by post_shift, in place, with the same rounding as
+  // Move, Scale, Rotate and Move in turn but in a single pass.
+  void ShiftScaleRotate(const ICOORD& pre_shift, float scale,
+                        const FCOORD* rotation, const ICOORD& post_shift);
   // Sets up the start and vec members of the loop from the pos members.
   void SetupFromPos();
   // Recomputes the bounding box from the points in the loop.
@@ -258,7 +264,7 @@ struct TESSLINE {
   TESSLINE *next;                // Next outline in blob.
 };                               // Outline structure.
 
-struct TBLOB {
+struct TBLOB : public tesseract::PageArenaAllocated {
   TBLOB() : outlines(NULL) {}
   TBLOB(const TBLOB& src) : outlines(NULL) {
     CopyFrom(src);
@@ -304,6 +310,11 @@ struct TBLOB {
   void Move(const ICOORD vec);
   // Scales by the given factor in place.
   void Scale(float factor);
+  // Moves by pre_shift, scales by scale, rotates by *rotation unless it is
+  // NULL, and moves by post_shift, in place, with the same rounding as
+  // Move, Scale, Rotate and Move in turn but in a single pass.
+  void ShiftScaleRotate(const ICOORD& pre_shift, float scale,
+                        const FCOORD* rotation, const ICOORD& post_shift);
   // Recomputes the bounding boxes of the outlines.
   void ComputeBoundingBoxes();
 
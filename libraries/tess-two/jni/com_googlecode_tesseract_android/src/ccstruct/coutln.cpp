@@ -50,7 +50,8 @@ ICOORD C_OUTLINE::step_coords[4] = {
 
 C_OUTLINE::C_OUTLINE(CRACKEDGE* startpt, ICOORD bot_left, ICOORD top_right,
                      inT16 length)
-    : box(bot_left, top_right), start(startpt->pos), offsets(NULL) {
+    : box(bot_left, top_right), start(startpt->pos), offsets(NULL),
+      step_area_(kUnknownArea) {
   inT16 stepindex;               //index to step
   CRACKEDGE *edgept;             //current point
 
@@ -59,9 +60,7 @@ C_OUTLINE::C_OUTLINE(CRACKEDGE* startpt, ICOORD bot_left, ICOORD top_right,
     steps = NULL;
     return;
   }
-                                 //get memory
-  steps = (uinT8 *) alloc_mem (step_mem());
-  memset(steps, 0, step_mem());
+  alloc_steps();                 //get memory
   edgept = startpt;
 
   for (stepindex = 0; stepindex < length; stepindex++) {
@@ -81,7 +80,7 @@ C_OUTLINE::C_OUTLINE (
                                  //steps to copy
 ICOORD startpt, DIR128 * new_steps,
 inT16 length                     //length of loop
-):start (startpt), offsets(NULL) {
+):start (startpt), offsets(NULL), step_area_(kUnknownArea) {
   inT8 dirdiff;                  //direction difference
   DIR128 prevdir;                //previous direction
   DIR128 dir;                    //current direction
@@ -94,8 +93,7 @@ inT16 length                     //length of loop
   pos = startpt;
   stepcount = length;            // No. of steps.
   ASSERT_HOST(length >= 0);
-  steps = reinterpret_cast<uinT8*>(alloc_mem(step_mem()));  // Get memory.
-  memset(steps, 0, step_mem());
+  alloc_steps();                 // Get memory.
 
   lastdir = new_steps[length - 1];
   prevdir = lastdir;
@@ -138,7 +136,8 @@ inT16 length                     //length of loop
  * @param rotation rotate to coord
  */
 
-C_OUTLINE::C_OUTLINE(C_OUTLINE* srcline, FCOORD rotation) : offsets(NULL) {
+C_OUTLINE::C_OUTLINE(C_OUTLINE* srcline, FCOORD rotation)
+    : offsets(NULL), step_area_(kUnknownArea) {
   TBOX new_box;                   //easy bounding
   inT16 stepindex;               //index to step
   inT16 dirdiff;                 //direction change
@@ -157,9 +156,7 @@ C_OUTLINE::C_OUTLINE(C_OUTLINE* srcline, FCOORD rotation) : offsets(NULL) {
     box.rotate(rotation);
     return;
   }
-                                 //get memory
-  steps = (uinT8 *) alloc_mem (step_mem());
-  memset(steps, 0, step_mem());
+  alloc_steps();                 //get memory
 
   for (int iteration = 0; iteration < 2; ++iteration) {
     DIR128 round1 = iteration == 0 ? 32 : 0;
@@ -235,6 +232,17 @@ C_OUTLINE::C_OUTLINE(C_OUTLINE* srcline, FCOORD rotation) : offsets(NULL) {
   ASSERT_HOST (destpos.x () == start.x () && destpos.y () == start.y ());
 }
 
+// Returns the number of bytes of heap used by the outline and its children.
+int C_OUTLINE::MemoryUsed() const {
+  int bytes = sizeof(*this);
+  if (steps != NULL && steps != inline_steps) bytes += step_mem();
+  if (offsets != NULL) bytes += stepcount * sizeof(*offsets);
+  C_OUTLINE_IT it(const_cast<C_OUTLINE_LIST*>(&children));
+  for (it.mark_cycle_pt(); !it.cycled_list(); it.forward())
+    bytes += it.data()->MemoryUsed();
+  return bytes;
+}
+
 // Build a fake outline, given just a bounding box and append to the list.
 void C_OUTLINE::FakeOutline(const TBOX& box, C_OUTLINE_LIST* outlines) {
   C_OUTLINE_IT ol_it(outlines);
@@ -253,27 +261,12 @@ void C_OUTLINE::FakeOutline(const TBOX& box, C_OUTLINE_LIST* outlines) {
  */
 
 inT32 C_OUTLINE::area() const {
-  int stepindex;                 //current step
-  inT32 total_steps;             //steps to do
   inT32 total;                   //total area
-  ICOORD pos;                    //position of point
-  ICOORD next_step;              //step to next pix
   // We aren't going to modify the list, or its contents, but there is
   // no const iterator.
   C_OUTLINE_IT it(const_cast<C_OUTLINE_LIST*>(&children));
 
-  pos = start_pos ();
-  total_steps = pathlength ();
-  total = 0;
-  for (stepindex = 0; stepindex < total_steps; stepindex++) {
-                                 //all intersected
-    next_step = step (stepindex);
-    if (next_step.x () < 0)
-      total += pos.y ();
-    else if (next_step.x () > 0)
-      total -= pos.y ();
-    pos += next_step;
-  }
+  total = step_area ();
   for (it.mark_cycle_pt (); !it.cycled_list (); it.forward ())
     total += it.data ()->area ();//add areas of children
 
@@ -306,6 +299,18 @@ inT32 C_OUTLINE::perimeter() const {
  */
 
 inT32 C_OUTLINE::outer_area() const {
+  if (pathlength () == 0)
+    return box.area();
+  return step_area ();
+}
+
+/**
+ * @name C_OUTLINE::compute_step_area
+ *
+ * Compute the area enclosed by the steps, without the children.
+ */
+
+inT32 C_OUTLINE::compute_step_area() const {
   int stepindex;                 //current step
   inT32 total_steps;             //steps to do
   inT32 total;                   //total area
@@ -314,8 +319,6 @@ inT32 C_OUTLINE::outer_area() const {
 
   pos = start_pos ();
   total_steps = pathlength ();
-  if (total_steps == 0)
-    return box.area();
   total = 0;
   for (stepindex = 0; stepindex < total_steps; stepindex++) {
                                  //all intersected
@@ -504,6 +507,10 @@ inT16 C_OUTLINE::winding_number(ICOORD point) const {
   ICOORD stepvec;                //step vector
   inT32 cross;                   //cross product
 
+  // A point outside the bounding box can't be on or inside the outline.
+  if (point.x() < box.left() || point.x() > box.right() ||
+      point.y() < box.bottom() || point.y() > box.top())
+    return 0;
   vec = start - point;           //vector to it
   count = 0;
   for (stepindex = 0; stepindex < stepcount; stepindex++) {
@@ -1023,6 +1030,20 @@ void C_OUTLINE::plot_normed(const DENORM& denorm, ScrollView::Color colour,
 }
 #endif
 
+/**
+ * @name C_OUTLINE::alloc_steps
+ *
+ * Get zeroed memory for the steps, inside the outline when they fit.
+ */
+
+void C_OUTLINE::alloc_steps() {
+  if (step_mem() <= kInlineStepBytes)
+    steps = inline_steps;
+  else
+    steps = (uinT8 *) alloc_mem (step_mem());
+  memset(steps, 0, step_mem());
+}
+
 /**
  * @name C_OUTLINE::operator=
  *
@@ -1033,11 +1054,11 @@ void C_OUTLINE::plot_normed(const DENORM& denorm, ScrollView::Color colour,
 C_OUTLINE& C_OUTLINE::operator=(const C_OUTLINE& source) {
   box = source.box;
   start = source.start;
-  if (steps != NULL)
-    free_mem(steps);
+  free_steps();
   stepcount = source.stepcount;
-  steps = (uinT8 *) alloc_mem (step_mem());
+  alloc_steps();
   memmove (steps, source.steps, step_mem());
+  step_area_ = source.step_area_;
   if (!children.empty ())
     children.clear ();
   children.deep_copy(&source.children, &deep_copy);
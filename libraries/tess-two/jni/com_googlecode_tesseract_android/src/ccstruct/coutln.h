@@ -71,6 +71,7 @@ class DLLSYM C_OUTLINE:public ELIST_LINK {
   C_OUTLINE() {  //empty constructor
       steps = NULL;
       offsets = NULL;
+      step_area_ = kUnknownArea;
     }
     C_OUTLINE(                     //constructor
               CRACKEDGE *startpt,  //from edge detector
@@ -86,10 +87,12 @@ class DLLSYM C_OUTLINE:public ELIST_LINK {
     // Build a fake outline, given just a bounding box and append to the list.
     static void FakeOutline(const TBOX& box, C_OUTLINE_LIST* outlines);
 
+    // Returns the number of bytes of heap used by the outline and its
+    // children.
+    int MemoryUsed() const;
+
     ~C_OUTLINE () {              //destructor
-      if (steps != NULL)
-        free_mem(steps);
-      steps = NULL;
+      free_steps();
       delete [] offsets;
     }
 
@@ -118,6 +121,7 @@ class DLLSYM C_OUTLINE:public ELIST_LINK {
       uinT8 mask = 3 << shift;
       steps[stepindex/4] = ((stepdir << shift) & mask) |
                            (steps[stepindex/4] & ~mask);
+      step_area_ = kUnknownArea;
       //squeeze 4 into byte
     }
     void set_step(                    //set a step
@@ -278,13 +282,38 @@ class DLLSYM C_OUTLINE:public ELIST_LINK {
     void increment_step(int s, int increment, ICOORD* pos, int* dir_counts,
                         int* pos_totals) const;
     int step_mem() const { return (stepcount+3) / 4; }
+    // Returns the area enclosed by the steps alone, computed on first use
+    // after any change to the steps.
+    inT32 step_area() const {
+      if (step_area_ == kUnknownArea) step_area_ = compute_step_area();
+      return step_area_;
+    }
+    inT32 compute_step_area() const;
+    // Points steps at step_mem() zeroed bytes, held in inline_steps if they
+    // fit, so most outlines need no allocation of their own.
+    void alloc_steps();
+    void free_steps() {
+      if (steps != NULL && steps != inline_steps)
+        free_mem(steps);
+      steps = NULL;
+    }
+
+    // Bytes of steps kept inside the outline, enough for 128 steps.
+    static const int kInlineStepBytes = 32;
+    // Value of step_area_ when it has to be recomputed. Outlines are
+    // limited to kMaxOutlineLength steps, so no real area comes close.
+    static const inT32 kUnknownArea = MAX_INT32;
 
     TBOX box;                    // bounding box
     ICOORD start;                // start coord
     inT16 stepcount;             // no of steps
     BITS16 flags;                // flags about outline
     uinT8 *steps;                // step array
+    uinT8 inline_steps[kInlineStepBytes];  // steps of short outlines
     EdgeOffset* offsets;         // Higher precision edge.
+    // Cache of step_area(), or kUnknownArea. The area does not change
+    // when the outline moves, as the steps form a closed loop.
+    mutable inT32 step_area_;
     C_OUTLINE_LIST children;     // child elements
     static ICOORD step_coords[4];
 };
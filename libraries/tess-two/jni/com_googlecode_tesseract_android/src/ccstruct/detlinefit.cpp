@@ -36,16 +36,18 @@ const int kMinPointsForErrorCount = 16;
 // mis-fitted points, which will get square-rooted for true distance.
 const int kMaxRealDistance = 2.0;
 
-DetLineFit::DetLineFit() : square_length_(0.0) {
+DetLineFit::DetLineFit() : num_distances_(0), square_length_(0.0) {
 }
 
 DetLineFit::~DetLineFit() {
 }
 
-// Delete all Added points.
+// Delete all Added points. The buffers are kept for reuse by the next fit.
 void DetLineFit::Clear() {
-  pts_.clear();
-  distances_.clear();
+  pts_.truncate(0);
+  distances_.truncate(0);
+  abs_distances_.truncate(0);
+  num_distances_ = 0;
 }
 
 // Add a new point. Takes a copy - the pt doesn't need to stay in scope.
@@ -107,9 +109,9 @@ double DetLineFit::Fit(int skip_first, int skip_last,
     for (int j = 0; j < end_count; ++j) {
       ICOORD* end = ends[j];
       if (*start != *end) {
-        ComputeDistances(*start, *end);
+        ComputeAbsDistances(*start, *end);
         // Compute the upper quartile error from the line.
-        double dist = EvaluateLineFit();
+        double dist = EvaluateAbsLineFit();
         if (dist < best_uq || best_uq < 0.0) {
           best_uq = dist;
           *pt1 = *start;
@@ -161,7 +163,7 @@ double DetLineFit::ConstrainedFit(const FCOORD& direction,
 // Returns true if there were enough points at the last call to Fit or
 // ConstrainedFit for the fitted points to be used on a badly fitted line.
 bool DetLineFit::SufficientPointsForIndependentFit() const {
-  return distances_.size() >= kMinPointsForErrorCount;
+  return num_distances_ >= kMinPointsForErrorCount;
 }
 
 // Backwards compatible fit returning a gradient and constant.
@@ -213,6 +215,28 @@ double DetLineFit::EvaluateLineFit() {
   return dist;
 }
 
+// As EvaluateLineFit, but for the distances computed by ComputeAbsDistances.
+double DetLineFit::EvaluateAbsLineFit() {
+  int num_dists = abs_distances_.size();
+  if (num_dists == 0) return 0.0;
+  // Compute the squared upper quartile error from the line.
+  int index = abs_distances_.choose_nth_item(3 * num_dists / 4);
+  double dist = abs_distances_[index];
+  dist = square_length_ > 0.0 ? dist * dist / square_length_ : 0.0;
+  if (num_dists >= kMinPointsForErrorCount &&
+      dist > kMaxRealDistance * kMaxRealDistance) {
+    // Use the number of mis-fitted points, as in EvaluateLineFit.
+    double threshold = kMaxRealDistance * sqrt(square_length_);
+    int num_misfits = 0;
+    for (int i = 0; i < num_dists; ++i) {
+      if (abs_distances_[i] > threshold)
+        ++num_misfits;
+    }
+    dist = num_misfits;
+  }
+  return dist;
+}
+
 // Computes the absolute error distances of the points from the line,
 // and returns the squared upper-quartile error distance.
 double DetLineFit::ComputeUpperQuartileError() {
@@ -242,17 +266,16 @@ int DetLineFit::NumberOfMisfittedPoints(double threshold) const {
   return num_misfits;
 }
 
-// Computes all the cross product distances of the points from the line,
-// storing the actual (signed) cross products in distances.
+// Computes all the absolute cross product distances of the points from the
+// line, storing them in abs_distances_.
 // Ignores distances of points that are further away than the previous point,
 // and overlaps the previous point by at least half.
-void DetLineFit::ComputeDistances(const ICOORD& start, const ICOORD& end) {
-  distances_.truncate(0);
+void DetLineFit::ComputeAbsDistances(const ICOORD& start, const ICOORD& end) {
+  abs_distances_.truncate(0);
   ICOORD line_vector = end;
   line_vector -= start;
   square_length_ = line_vector.sqlength();
   int line_length = IntCastRounded(sqrt(square_length_));
-  // Compute the distance of each point from the line.
   int prev_abs_dist = 0;
   int prev_dot = 0;
   for (int i = 0; i < pts_.size(); ++i) {
@@ -269,10 +292,11 @@ void DetLineFit::ComputeDistances(const ICOORD& start, const ICOORD& end) {
           separation < line_length * pts_[i - 1].halfwidth)
         continue;
     }
-    distances_.push_back(DistPointPair(dist, pts_[i].pt));
+    abs_distances_.push_back(abs_dist);
     prev_abs_dist = abs_dist;
     prev_dot = dot;
   }
+  num_distances_ = abs_distances_.size();
 }
 
 // Computes all the cross product distances of the points perpendicular to
@@ -290,6 +314,7 @@ void DetLineFit::ComputeConstrainedDistances(const FCOORD& direction,
     if (min_dist <= dist && dist <= max_dist)
       distances_.push_back(DistPointPair(dist, pts_[i].pt));
   }
+  num_distances_ = distances_.size();
 }
 
 }  // namespace tesseract.
@@ -49,7 +49,9 @@ namespace tesseract {
 // randomness does not affect the determinism of the algorithm. The random
 // numbers are only there to guarantee average linear time.
 // Fitting time is linear, but with a high constant, as it tries 9 different
-// lines and computes the distance of all points each time.
+// lines and computes the distance of all points each time. The distances of
+// the 9 lines are kept as bare integers, so that selecting the upper quartile
+// only moves ints around.
 // This class is aimed at replacing the LLSQ (linear least squares) and
 // LMS (least median of squares) classes that are currently used for most
 // of the line fitting in Tesseract.
@@ -58,7 +60,7 @@ class DetLineFit {
   DetLineFit();
   ~DetLineFit();
 
-  // Delete all Added points.
+  // Delete all Added points. The buffers are kept for reuse by the next fit.
   void Clear();
 
   // Adds a new point. Takes a copy - the pt doesn't need to stay in scope.
@@ -125,6 +127,9 @@ class DetLineFit {
   // Computes and returns the squared evaluation metric for a line fit.
   double EvaluateLineFit();
 
+  // As EvaluateLineFit, but for the distances computed by ComputeAbsDistances.
+  double EvaluateAbsLineFit();
+
   // Computes the absolute values of the precomputed distances_,
   // and returns the squared upper-quartile error distance.
   double ComputeUpperQuartileError();
@@ -132,11 +137,11 @@ class DetLineFit {
   // Returns the number of sample points that have an error more than threshold.
   int NumberOfMisfittedPoints(double threshold) const;
 
-  // Computes all the cross product distances of the points from the line,
-  // storing the actual (signed) cross products in distances_.
+  // Computes all the absolute cross product distances of the points from the
+  // line, storing them in abs_distances_.
   // Ignores distances of points that are further away than the previous point,
   // and overlaps the previous point by at least half.
-  void ComputeDistances(const ICOORD& start, const ICOORD& end);
+  void ComputeAbsDistances(const ICOORD& start, const ICOORD& end);
 
   // Computes all the cross product distances of the points perpendicular to
   // the given direction, ignoring distances outside of the give distance range,
@@ -153,7 +158,13 @@ class DetLineFit {
   // re-ordered by the nth_item function, the original point is stored
   // along side the distance.
   GenericVector<DistPointPair> distances_;  // Distances of points.
-  // The squared length of the vector used to compute distances_.
+  // The absolute distances of (some of) the pts_ from the line being
+  // evaluated by Fit.
+  GenericVector<int> abs_distances_;
+  // The number of distances computed at the last call to Fit or
+  // ConstrainedFit.
+  int num_distances_;
+  // The squared length of the vector used to compute the distances.
   double square_length_;
 };
 
@@ -35,6 +35,12 @@
 #elif __cplusplus > 199711L   // in C++11
 # include <thread>
 #endif
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 // Number of documents to read ahead while training. Doesn't need to be very
 // large.
@@ -548,6 +554,201 @@ bool DocumentData::ReCachePages() {
   return !pages_.empty();
 }
 
+MappedDocument::MappedDocument()
+    : data_(NULL),
+      size_(0),
+      mapped_(false),
+      newest_(-1),
+      oldest_(-1),
+      memory_used_(0),
+      max_memory_(0) {}
+
+MappedDocument::~MappedDocument() {
+  Close();
+}
+
+// Maps the given lstmf filename and indexes its pages. max_memory <= 0
+// means no limit. Returns false on error.
+bool MappedDocument::Open(const char* filename, const char* lang,
+                          inT64 max_memory) {
+  Close();
+  document_name_ = filename;
+  lang_ = lang;
+  max_memory_ = max_memory;
+#ifndef _WIN32
+  int fd = open(filename, O_RDONLY);
+  if (fd >= 0) {
+    struct stat st;
+    if (fstat(fd, &st) == 0 && st.st_size > 0 && st.st_size <= MAX_INT32) {
+      void* map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (map != MAP_FAILED) {
+        data_ = static_cast<const char*>(map);
+        size_ = st.st_size;
+        mapped_ = true;
+      }
+    }
+    close(fd);
+  }
+#endif
+  if (!mapped_) {
+    if (!LoadDataFromFile(document_name_, &buffer_) || buffer_.empty()) {
+      tprintf("Can't read document %s\n", filename);
+      return false;
+    }
+    data_ = &buffer_[0];
+    size_ = buffer_.size();
+  }
+  // Index the pages by skipping over each of them once.
+  TFile fp;
+  fp.OpenNoCopy(data_, size_);
+  inT32 num_pages = 0;
+  if (!PointerVector<ImageData>::DeSerializeSize(false, &fp, &num_pages) ||
+      num_pages <= 0) {
+    tprintf("Deserialize header failed: %s\n", filename);
+    Close();
+    return false;
+  }
+  entries_.reserve(num_pages);
+  for (int page = 0; page < num_pages; ++page) {
+    Entry entry;
+    entry.offset = fp.Tell();
+    if (!PointerVector<ImageData>::DeSerializeSkip(false, &fp)) {
+      tprintf("Deserialize failed: %s indexed %d/%d pages\n", filename, page,
+              num_pages);
+      Close();
+      return false;
+    }
+    entry.size = fp.Tell() - entry.offset;
+    entry.page = NULL;
+    entry.pix = NULL;
+    entry.memory = 0;
+    entry.newer = -1;
+    entry.older = -1;
+    entries_.push_back(entry);
+  }
+  return true;
+}
+
+// Returns the page with the given index, modulo the number of pages, or
+// NULL if the document is empty or the page cannot be read.
+const ImageData* MappedDocument::GetPage(int index) {
+  int e = Use(index);
+  return e >= 0 ? entries_[e].page : NULL;
+}
+
+// Returns the image of the page with the given index, decoding it only if
+// it is not cached. Must be pixDestroyed after use.
+Pix* MappedDocument::GetPix(int index) {
+  int e = Use(index);
+  if (e < 0) return NULL;
+  if (entries_[e].pix == NULL) {
+    Pix* pix = entries_[e].page->GetPix();
+    if (pix == NULL) return NULL;
+    entries_[e].pix = pix;
+    Charge(e, pixGetWpl(pix) * 4 * pixGetHeight(pix));
+  }
+  return pixClone(entries_[e].pix);
+}
+
+// Releases the mapping and all the cached pages.
+void MappedDocument::Close() {
+  for (int e = 0; e < entries_.size(); ++e) Drop(e);
+  entries_.clear();
+#ifndef _WIN32
+  if (mapped_) munmap(const_cast<char*>(data_), size_);
+#endif
+  buffer_.clear();
+  data_ = NULL;
+  size_ = 0;
+  mapped_ = false;
+}
+
+// Returns the entry index of the given page index, loading the page if it
+// is not cached, and makes it the most recently used. Returns -1 on error.
+int MappedDocument::Use(int index) {
+  if (entries_.empty()) return -1;
+  index = Modulo(index, entries_.size());
+  Entry* entry = &entries_[index];
+  if (entry->page != NULL) {
+    if (newest_ != index) {
+      Unlink(index);
+      LinkNewest(index);
+    }
+    return index;
+  }
+  TFile fp;
+  fp.OpenNoCopy(data_ + entry->offset, entry->size);
+  inT8 non_null = 0;
+  ImageData* page = new ImageData;
+  if (fp.FRead(&non_null, sizeof(non_null), 1) != 1 || !non_null ||
+      !page->DeSerialize(false, &fp)) {
+    tprintf("Deserialize failed: %s page %d\n", document_name_.string(),
+            index);
+    delete page;
+    return -1;
+  }
+  if (page->imagefilename().length() == 0) {
+    page->set_imagefilename(document_name_);
+    page->set_page_number(index);
+  }
+  page->set_language(lang_);
+  entry->page = page;
+  LinkNewest(index);
+  Charge(index, page->MemoryUsed());
+  return index;
+}
+
+// Links the entry at index into the list of cached pages as the most
+// recently used.
+void MappedDocument::LinkNewest(int index) {
+  Entry& entry = entries_[index];
+  entry.newer = -1;
+  entry.older = newest_;
+  if (newest_ >= 0)
+    entries_[newest_].newer = index;
+  else
+    oldest_ = index;
+  newest_ = index;
+}
+
+// Adds memory to the count of the entry at index, and drops the least
+// recently used pages other than it until the cache fits.
+void MappedDocument::Charge(int index, int memory) {
+  entries_[index].memory += memory;
+  memory_used_ += memory;
+  while (max_memory_ > 0 && memory_used_ > max_memory_ && oldest_ >= 0 &&
+         oldest_ != index) {
+    Drop(oldest_);
+  }
+}
+
+// Unlinks the entry at index from the list of cached pages.
+void MappedDocument::Unlink(int index) {
+  Entry& entry = entries_[index];
+  if (entry.newer >= 0)
+    entries_[entry.newer].older = entry.older;
+  else
+    newest_ = entry.older;
+  if (entry.older >= 0)
+    entries_[entry.older].newer = entry.newer;
+  else
+    oldest_ = entry.newer;
+  entry.newer = -1;
+  entry.older = -1;
+}
+
+// Drops the cached page and image of the entry at index.
+void MappedDocument::Drop(int index) {
+  Entry& entry = entries_[index];
+  if (entry.page == NULL) return;
+  Unlink(index);
+  delete entry.page;
+  entry.page = NULL;
+  pixDestroy(&entry.pix);
+  memory_used_ -= entry.memory;
+  entry.memory = 0;
+}
+
 // A collection of DocumentData that knows roughly how much memory it is using.
 DocumentCache::DocumentCache(inT64 max_memory)
     : num_pages_per_doc_(0), max_memory_(max_memory) {}
@@ -306,6 +306,87 @@ class DocumentData {
   mutable SVMutex general_mutex_;
 };
 
+// A document of pages as written by DocumentData::SaveDocument, that is
+// memory-mapped instead of read, with an index of where each page starts so
+// that any page is deserialized on its own when it is first needed. Pages
+// and their decoded images are kept in a cache of at most max_memory
+// bytes, counted with MemoryUsed and the size of the Pix, that drops the
+// least recently used pages first, so repeated passes over a corpus that
+// fits do no decoding after the first, and one that does not fit costs
+// only the pages that were dropped.
+// Not thread-safe.
+class MappedDocument {
+ public:
+  MappedDocument();
+  ~MappedDocument();
+
+  // Maps the given lstmf filename and indexes its pages. max_memory <= 0
+  // means no limit. Returns false on error.
+  bool Open(const char* filename, const char* lang, inT64 max_memory);
+
+  const STRING& document_name() const {
+    return document_name_;
+  }
+  int NumPages() const {
+    return entries_.size();
+  }
+  inT64 memory_used() const {
+    return memory_used_;
+  }
+
+  // Returns the page with the given index, modulo the number of pages, or
+  // NULL if the document is empty or the page cannot be read. The page
+  // stays valid until another page has to be loaded.
+  const ImageData* GetPage(int index);
+  // Returns the image of the page with the given index, as its GetPix
+  // would, but decodes it only if it is not cached. Must be pixDestroyed
+  // after use. Returns NULL on error.
+  Pix* GetPix(int index);
+
+ private:
+  // A page of the document, in the list of cached pages if page is set.
+  struct Entry {
+    int offset;       // Start of the serialized page in data_.
+    int size;         // Size of the serialized page.
+    ImageData* page;  // The page, if it is cached.
+    Pix* pix;         // Its decoded image, if there is one.
+    int memory;       // Memory counted for page and pix.
+    int newer;        // Next more recently used cached entry or -1.
+    int older;        // Next less recently used cached entry or -1.
+  };
+
+  // Releases the mapping and all the cached pages.
+  void Close();
+  // Returns the entry index of the given page index, loading the page if
+  // it is not cached, and makes it the most recently used. Returns -1 on
+  // error.
+  int Use(int index);
+  // Links the entry at index into the list of cached pages as the most
+  // recently used.
+  void LinkNewest(int index);
+  // Adds memory to the count of the entry at index, and drops the least
+  // recently used pages other than it until the cache fits.
+  void Charge(int index, int memory);
+  // Unlinks the entry at index from the list of cached pages.
+  void Unlink(int index);
+  // Drops the cached page and image of the entry at index.
+  void Drop(int index);
+
+  STRING document_name_;
+  STRING lang_;
+  // The mapped file, or the file read into buffer_ where mmap is missing.
+  const char* data_;
+  int size_;
+  GenericVector<char> buffer_;
+  bool mapped_;
+  GenericVector<Entry> entries_;
+  // Most and least recently used cached entries, or -1.
+  int newest_;
+  int oldest_;
+  inT64 memory_used_;
+  inT64 max_memory_;
+};
+
 // A collection of DocumentData that knows roughly how much memory it is using.
 // Note that while it supports background read-ahead, it assumes that a single
 // thread is accessing documents, ie it is not safe for multiple threads to
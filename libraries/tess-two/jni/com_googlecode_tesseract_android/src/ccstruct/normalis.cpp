@@ -409,16 +409,10 @@ void DENORM::DenormTransform(const DENORM* last_denorm, const FCOORD& pt,
 // Normalize a blob using blob transformations. Less accurate, but
 // more accurately copies the old way.
 void DENORM::LocalNormBlob(TBLOB* blob) const {
-  TBOX blob_box = blob->bounding_box();
   ICOORD translation(-IntCastRounded(x_origin_), -IntCastRounded(y_origin_));
-  blob->Move(translation);
-  if (y_scale_ != 1.0f)
-    blob->Scale(y_scale_);
-  if (rotation_ != NULL)
-    blob->Rotate(*rotation_);
-  translation.set_x(IntCastRounded(final_xshift_));
-  translation.set_y(IntCastRounded(final_yshift_));
-  blob->Move(translation);
+  ICOORD final_shift(IntCastRounded(final_xshift_),
+                     IntCastRounded(final_yshift_));
+  blob->ShiftScaleRotate(translation, y_scale_, rotation_, final_shift);
 }
 
 // Fills in the x-height range accepted by the given unichar_id, given its
@@ -23,6 +23,7 @@
 #include "allheaders.h"
 #include "helpers.h"
 #include "openclwrapper.h"
+#include "vulkanwrapper.h"
 
 
 namespace tesseract {
@@ -39,108 +40,99 @@ namespace tesseract {
 int OtsuThreshold(Pix* src_pix, int left, int top, int width, int height,
                   int** thresholds, int** hi_values) {
   int num_channels = pixGetDepth(src_pix) / 8;
-  // Of all channels with no good hi_value, keep the best so we can always
-  // produce at least one answer.
   PERF_COUNT_START("OtsuThreshold")
-  int best_hi_value = 1;
-  int best_hi_index = 0;
-  bool any_good_hivalue = false;
-  double best_hi_dist = 0.0;
-  *thresholds = new int[num_channels];
-  *hi_values = new int[num_channels];
-
-  // only use opencl if compiled w/ OpenCL and selected device is opencl
-#ifdef USE_OPENCL
   // all of channel 0 then all of channel 1...
   int* histogramAllChannels = new int[kHistogramSize * num_channels];
 
+  // only use opencl if compiled w/ OpenCL and selected device is opencl
+#ifdef USE_OPENCL
   // Calculate Histogram on GPU
-  OpenclDevice od;
-  if (od.selectedDeviceIsOpenCL() && (num_channels == 1 || num_channels == 4) &&
-      top == 0 && left == 0) {
-    od.HistogramRectOCL((unsigned char*)pixGetData(src_pix), num_channels,
-                        pixGetWpl(src_pix) * 4, left, top, width, height,
-                        kHistogramSize, histogramAllChannels);
-
-    // Calculate Threshold from Histogram on cpu
-    for (int ch = 0; ch < num_channels; ++ch) {
-      (*thresholds)[ch] = -1;
-      (*hi_values)[ch] = -1;
-      int *histogram = &histogramAllChannels[kHistogramSize * ch];
-      int H;
-      int best_omega_0;
-      int best_t = OtsuStats(histogram, &H, &best_omega_0);
-      if (best_omega_0 == 0 || best_omega_0 == H) {
-         // This channel is empty.
-         continue;
-       }
-      // To be a convincing foreground we must have a small fraction of H
-      // or to be a convincing background we must have a large fraction of H.
-      // In between we assume this channel contains no thresholding information.
-      int hi_value = best_omega_0 < H * 0.5;
-      (*thresholds)[ch] = best_t;
-      if (best_omega_0 > H * 0.75) {
-        any_good_hivalue = true;
-        (*hi_values)[ch] = 0;
-      } else if (best_omega_0 < H * 0.25) {
-        any_good_hivalue = true;
-        (*hi_values)[ch] = 1;
-      } else {
-        // In case all channels are like this, keep the best of the bad lot.
-        double hi_dist = hi_value ? (H - best_omega_0) : best_omega_0;
-        if (hi_dist > best_hi_dist) {
-          best_hi_dist = hi_dist;
-          best_hi_value = hi_value;
-          best_hi_index = ch;
-        }
-      }
-    }
+  OpenclRoute route(OCL_HISTOGRAM_RECT, width * height,
+                    (num_channels == 1 || num_channels == 4) &&
+                    top == 0 && left == 0);
+  if (route.opencl()) {
+    OpenclDevice::HistogramRectOCL((unsigned char*)pixGetData(src_pix),
+                                   num_channels, pixGetWpl(src_pix) * 4,
+                                   left, top, width, height, kHistogramSize,
+                                   histogramAllChannels);
   } else {
+#endif
+#ifdef USE_VULKAN
+  if (!VulkanDevice::HistogramRectVK(src_pix, left, top, width, height,
+                                     histogramAllChannels)) {
 #endif
     for (int ch = 0; ch < num_channels; ++ch) {
-      (*thresholds)[ch] = -1;
-      (*hi_values)[ch] = -1;
       // Compute the histogram of the image rectangle.
-      int histogram[kHistogramSize];
-      HistogramRect(src_pix, ch, left, top, width, height, histogram);
-      int H;
-      int best_omega_0;
-      int best_t = OtsuStats(histogram, &H, &best_omega_0);
-      if (best_omega_0 == 0 || best_omega_0 == H) {
-         // This channel is empty.
-         continue;
-       }
-      // To be a convincing foreground we must have a small fraction of H
-      // or to be a convincing background we must have a large fraction of H.
-      // In between we assume this channel contains no thresholding information.
-      int hi_value = best_omega_0 < H * 0.5;
-      (*thresholds)[ch] = best_t;
-      if (best_omega_0 > H * 0.75) {
-        any_good_hivalue = true;
-        (*hi_values)[ch] = 0;
-      } else if (best_omega_0 < H * 0.25) {
-        any_good_hivalue = true;
-        (*hi_values)[ch] = 1;
-      } else {
-        // In case all channels are like this, keep the best of the bad lot.
-        double hi_dist = hi_value ? (H - best_omega_0) : best_omega_0;
-        if (hi_dist > best_hi_dist) {
-          best_hi_dist = hi_dist;
-          best_hi_value = hi_value;
-          best_hi_index = ch;
-        }
-      }
+      HistogramRect(src_pix, ch, left, top, width, height,
+                    &histogramAllChannels[kHistogramSize * ch]);
     }
+#ifdef USE_VULKAN
+  }
+#endif
 #ifdef USE_OPENCL
   }
-  delete[] histogramAllChannels;
+  route.Finish();
 #endif  // USE_OPENCL
 
+  // Calculate Threshold from Histogram on cpu
+  OtsuThresholdFromHistograms(histogramAllChannels, num_channels,
+                              thresholds, hi_values);
+  delete[] histogramAllChannels;
+  PERF_COUNT_END
+  return num_channels;
+}
+
+// Computes the Otsu threshold(s) from precomputed histograms, laid out as
+// all kHistogramSize entries of channel 0, then all of channel 1...
+// Outputs and return value are exactly as for OtsuThreshold above.
+int OtsuThresholdFromHistograms(const int* histograms, int num_channels,
+                                int** thresholds, int** hi_values) {
+  // Of all channels with no good hi_value, keep the best so we can always
+  // produce at least one answer.
+  int best_hi_value = 1;
+  int best_hi_index = 0;
+  bool any_good_hivalue = false;
+  double best_hi_dist = 0.0;
+  *thresholds = new int[num_channels];
+  *hi_values = new int[num_channels];
+
+  for (int ch = 0; ch < num_channels; ++ch) {
+    (*thresholds)[ch] = -1;
+    (*hi_values)[ch] = -1;
+    const int* histogram = &histograms[kHistogramSize * ch];
+    int H;
+    int best_omega_0;
+    int best_t = OtsuStats(histogram, &H, &best_omega_0);
+    if (best_omega_0 == 0 || best_omega_0 == H) {
+       // This channel is empty.
+       continue;
+     }
+    // To be a convincing foreground we must have a small fraction of H
+    // or to be a convincing background we must have a large fraction of H.
+    // In between we assume this channel contains no thresholding information.
+    int hi_value = best_omega_0 < H * 0.5;
+    (*thresholds)[ch] = best_t;
+    if (best_omega_0 > H * 0.75) {
+      any_good_hivalue = true;
+      (*hi_values)[ch] = 0;
+    } else if (best_omega_0 < H * 0.25) {
+      any_good_hivalue = true;
+      (*hi_values)[ch] = 1;
+    } else {
+      // In case all channels are like this, keep the best of the bad lot.
+      double hi_dist = hi_value ? (H - best_omega_0) : best_omega_0;
+      if (hi_dist > best_hi_dist) {
+        best_hi_dist = hi_dist;
+        best_hi_value = hi_value;
+        best_hi_index = ch;
+      }
+    }
+  }
+
   if (!any_good_hivalue) {
     // Use the best of the ones that were not good enough.
     (*hi_values)[best_hi_index] = best_hi_value;
   }
-  PERF_COUNT_END
   return num_channels;
 }
 
@@ -158,15 +150,51 @@ void HistogramRect(Pix* src_pix, int channel,
   memset(histogram, 0, sizeof(*histogram) * kHistogramSize);
   int src_wpl = pixGetWpl(src_pix);
   l_uint32* srcdata = pixGetData(src_pix);
+  // Counting into one histogram makes every increment wait for the previous
+  // one whenever neighbouring pixels are equal, which is most of the time,
+  // so the counts are spread over interleaved sub-histograms and summed at
+  // the end. Whole words are read at a time instead of one GET_DATA_BYTE per
+  // pixel.
+  int sub_histograms[4][kHistogramSize];
+  memset(sub_histograms, 0, sizeof(sub_histograms));
   for (int y = top; y < bottom; ++y) {
     const l_uint32* linedata = srcdata + y * src_wpl;
-    for (int x = 0; x < width; ++x) {
+    int x = 0;
+    if (num_channels == 1) {
+      // Count single bytes up to the first word boundary.
+      for (; x < width && (x + left) % 4 != 0; ++x) {
+        ++histogram[GET_DATA_BYTE(const_cast<l_uint32*>(linedata), x + left)];
+      }
+      const l_uint32* words = linedata + (x + left) / 4;
+      for (; x + 4 <= width; x += 4, ++words) {
+        l_uint32 word = *words;
+        ++sub_histograms[0][word >> 24];
+        ++sub_histograms[1][(word >> 16) & 0xff];
+        ++sub_histograms[2][(word >> 8) & 0xff];
+        ++sub_histograms[3][word & 0xff];
+      }
+    } else if (num_channels == 4) {
+      // Each pixel is a word, with channel 0 in the most significant byte.
+      int shift = 24 - 8 * channel;
+      const l_uint32* words = linedata + left;
+      for (; x + 4 <= width; x += 4, words += 4) {
+        ++sub_histograms[0][(words[0] >> shift) & 0xff];
+        ++sub_histograms[1][(words[1] >> shift) & 0xff];
+        ++sub_histograms[2][(words[2] >> shift) & 0xff];
+        ++sub_histograms[3][(words[3] >> shift) & 0xff];
+      }
+    }
+    for (; x < width; ++x) {
       int pixel = GET_DATA_BYTE(const_cast<void*>(
           reinterpret_cast<const void *>(linedata)),
           (x + left) * num_channels + channel);
       ++histogram[pixel];
     }
   }
+  for (int i = 0; i < kHistogramSize; ++i) {
+    histogram[i] += sub_histograms[0][i] + sub_histograms[1][i] +
+                    sub_histograms[2][i] + sub_histograms[3][i];
+  }
   PERF_COUNT_END
 }
 
@@ -20,6 +20,8 @@
 #ifndef TESSERACT_CCMAIN_OTSUTHR_H__
 #define TESSERACT_CCMAIN_OTSUTHR_H__
 
+#include "platform.h"
+
 struct Pix;
 
 namespace tesseract {
@@ -35,16 +37,23 @@ const int kHistogramSize = 256;  // The size of a histogram of pixel values.
 // Delete thresholds and hi_values with delete [] after use.
 // The return value is the number of channels in the input image, being
 // the size of the output thresholds and hi_values arrays.
-int OtsuThreshold(Pix* src_pix, int left, int top, int width, int height,
-                  int** thresholds, int** hi_values);
+TESS_API int OtsuThreshold(Pix* src_pix, int left, int top,
+                           int width, int height,
+                           int** thresholds, int** hi_values);
+
+// Computes the Otsu threshold(s) from precomputed histograms, laid out as
+// all kHistogramSize entries of channel 0, then all of channel 1...
+// Outputs and return value are exactly as for OtsuThreshold above.
+int OtsuThresholdFromHistograms(const int* histograms, int num_channels,
+                                int** thresholds, int** hi_values);
 
 // Computes the histogram for the given image rectangle, and the given
 // single channel. Each channel is always one byte per pixel.
 // Histogram is always a kHistogramSize(256) element array to count
 // occurrences of each pixel value.
-void HistogramRect(Pix* src_pix, int channel,
-                   int left, int top, int width, int height,
-                   int* histogram);
+TESS_API void HistogramRect(Pix* src_pix, int channel,
+                            int left, int top, int width, int height,
+                            int* histogram);
 
 // Computes the Otsu threshold(s) for the given histogram.
 // Also returns H = total count in histogram, and
@@ -92,6 +92,7 @@ BLOCK_RES::BLOCK_RES(bool merge_similar_words, BLOCK *the_block) {
   font_assigned = FALSE;
   bold = FALSE;
   italic = FALSE;
+  fast_confident = FALSE;
   row_count = 0;
 
   block = the_block;
@@ -328,6 +329,23 @@ bool WERD_RES::SetupForRecognition(const UNICHARSET& unicharset_in,
   return true;
 }
 
+// As SetupForRecognition, but copies the normalized words of source.
+void WERD_RES::SetupForRecognitionAs(const WERD_RES& source,
+                                     const UNICHARSET& unicharset_in,
+                                     tesseract::Tesseract* tess) {
+  tesseract = tess;
+  ClearResults();
+  SetupWordScript(unicharset_in);
+  chopped_word = new TWERD(*source.chopped_word);
+  denorm = source.denorm;
+  blob_row = source.blob_row;
+  SetupBasicsFromChoppedWord(unicharset_in);
+  SetupBlamerBundle();
+  int num_blobs = chopped_word->NumBlobs();
+  ratings = new MATRIX(num_blobs, kWordrecMaxNumJoinChunks);
+  tess_failed = false;
+}
+
 // Set up the seam array, bln_boxes, best_choice, and raw_choice to empty
 // accumulators from a made chopped word.  We presume the fields are already
 // empty.
@@ -382,7 +400,7 @@ void WERD_RES::SetupWordScript(const UNICHARSET& uch) {
 
 // Sets up the blamer_bundle if it is not null, using the initialized denorm.
 void WERD_RES::SetupBlamerBundle() {
-  if (blamer_bundle != NULL) {
+  if (kBlamerEnabled && blamer_bundle != NULL) {
     blamer_bundle->SetupNormTruthWord(denorm);
   }
 }
@@ -595,8 +613,11 @@ void WERD_RES::ComputeAdaptionThresholds(float certainty_scale,
 // Returns true if the word_choice was the new best.
 bool WERD_RES::LogNewRawChoice(WERD_CHOICE* word_choice) {
   if (raw_choice == NULL || word_choice->rating() < raw_choice->rating()) {
-    delete raw_choice;
-    raw_choice = new WERD_CHOICE(*word_choice);
+    // The old raw choice is overwritten in place to reuse its arrays.
+    if (raw_choice == NULL)
+      raw_choice = new WERD_CHOICE(*word_choice);
+    else
+      *raw_choice = *word_choice;
     raw_choice->set_permuter(TOP_CHOICE_PERM);
     return true;
   }
@@ -761,8 +782,7 @@ void WERD_RES::ConsumeWordResults(WERD_RES* word) {
   MovePointerData(&rebuild_word, &word->rebuild_word);
   MovePointerData(&box_word, &word->box_word);
   seam_array.delete_data_pointers();
-  seam_array = word->seam_array;
-  word->seam_array.clear();
+  seam_array.move(&word->seam_array);
   best_state.move(&word->best_state);
   correct_text.move(&word->correct_text);
   blob_widths.move(&word->blob_widths);
@@ -1128,6 +1148,86 @@ void WERD_RES::InitPointers() {
   blamer_bundle = NULL;
 }
 
+// Returns the number of bytes of heap used by the blobs of the word.
+static int TWerdMemoryUsed(const TWERD* word) {
+  if (word == NULL) return 0;
+  int bytes = sizeof(*word) + word->blobs.size_reserved() * sizeof(TBLOB*);
+  for (int b = 0; b < word->NumBlobs(); ++b) {
+    bytes += sizeof(TBLOB);
+    for (TESSLINE* outline = word->blobs[b]->outlines; outline != NULL;
+         outline = outline->next) {
+      bytes += sizeof(*outline);
+      EDGEPT* pt = outline->loop;
+      if (pt == NULL) continue;
+      do {
+        bytes += sizeof(*pt);
+        pt = pt->next;
+      } while (pt != outline->loop);
+    }
+  }
+  return bytes;
+}
+
+int WERD_RES::MemoryUsed() const {
+  int bytes = sizeof(*this);
+  if (word != NULL) {
+    C_BLOB_IT b_it(word->cblob_list());
+    for (b_it.mark_cycle_pt(); !b_it.cycled_list(); b_it.forward()) {
+      bytes += sizeof(C_BLOB);
+      C_OUTLINE_IT o_it(b_it.data()->out_list());
+      for (o_it.mark_cycle_pt(); !o_it.cycled_list(); o_it.forward())
+        bytes += o_it.data()->MemoryUsed();
+    }
+  }
+  bytes += TWerdMemoryUsed(chopped_word);
+  bytes += TWerdMemoryUsed(rebuild_word);
+  bytes += seam_array.size() * sizeof(SEAM);
+  bytes += (blob_widths.size_reserved() + blob_gaps.size_reserved() +
+            best_state.size_reserved()) * sizeof(int);
+  if (ratings != NULL) {
+    int dim = ratings->dimension();
+    int band = ratings->bandwidth();
+    bytes += dim * band * sizeof(BLOB_CHOICE_LIST*);
+    for (int col = 0; col < dim; ++col) {
+      for (int row = col; row < dim && row < col + band; ++row) {
+        BLOB_CHOICE_LIST* choices = ratings->get(col, row);
+        if (choices != NOT_CLASSIFIED)
+          bytes += sizeof(*choices) + choices->length() * sizeof(BLOB_CHOICE);
+      }
+    }
+  }
+  WERD_CHOICE_IT wc_it(const_cast<WERD_CHOICE_LIST*>(&best_choices));
+  for (wc_it.mark_cycle_pt(); !wc_it.cycled_list(); wc_it.forward())
+    bytes += wc_it.data()->MemoryUsed();
+  if (raw_choice != NULL) bytes += raw_choice->MemoryUsed();
+  if (ep_choice != NULL) bytes += ep_choice->MemoryUsed();
+  return bytes;
+}
+
+void PAGE_RES::DetectParagraphsIfNeeded() {
+  if (paragraph_detector == NULL) return;
+  // The detector iterates the page itself, so it must not run again.
+  TessClosure* detector = paragraph_detector;
+  paragraph_detector = NULL;
+  detector->Run();
+}
+
+int PAGE_RES::MemoryUsed() const {
+  int bytes = sizeof(*this);
+  BLOCK_RES_IT block_it(const_cast<BLOCK_RES_LIST*>(&block_res_list));
+  for (block_it.mark_cycle_pt(); !block_it.cycled_list(); block_it.forward()) {
+    bytes += sizeof(BLOCK_RES);
+    ROW_RES_IT row_it(&block_it.data()->row_res_list);
+    for (row_it.mark_cycle_pt(); !row_it.cycled_list(); row_it.forward()) {
+      bytes += sizeof(ROW_RES);
+      WERD_RES_IT word_it(&row_it.data()->word_res_list);
+      for (word_it.mark_cycle_pt(); !word_it.cycled_list(); word_it.forward())
+        bytes += word_it.data()->MemoryUsed();
+    }
+  }
+  return bytes;
+}
+
 void WERD_RES::Clear() {
   if (word != NULL && combination) {
     delete word;
@@ -1169,7 +1269,7 @@ void WERD_RES::ClearResults() {
   blob_gaps.clear();
   ClearRatings();
   ClearWordChoices();
-  if (blamer_bundle != NULL) blamer_bundle->ClearResults();
+  if (kBlamerEnabled && blamer_bundle != NULL) blamer_bundle->ClearResults();
 }
 void WERD_RES::ClearWordChoices() {
   best_choice = NULL;
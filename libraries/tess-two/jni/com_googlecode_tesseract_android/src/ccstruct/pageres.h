@@ -31,6 +31,7 @@
 #include "ratngs.h"
 #include "rejctmap.h"
 #include "seam.h"
+#include "tesscallback.h"
 #include "werd.h"
 
 namespace tesseract {
@@ -71,6 +72,15 @@ class PAGE_RES {                 // page result
   // caused misadaption could be marked. However, since words could be
   // deleted/split/merged, the log is stored on the PAGE_RES level.
   GenericVector<STRING> misadaption_log;
+  // Holds the words of the page if they were made with it current, or NULL.
+  // Owned, and released after the words.
+  tesseract::PageArena* arena;
+  // Whether the fonts of the words have been set since recognition.
+  BOOL8 fonts_recognized;
+  // Detects the paragraphs of the page, if that was put off until they are
+  // needed, or NULL. Owned, and a one-shot closure that deletes itself when
+  // run.
+  TessClosure* paragraph_detector;
 
   inline void Init() {
     char_count = 0;
@@ -78,6 +88,9 @@ class PAGE_RES {                 // page result
     rejected = FALSE;
     prev_word_best_choice = NULL;
     blame_reasons.init_to_size(IRR_NUM_REASONS, 0);
+    arena = NULL;
+    fonts_recognized = FALSE;
+    paragraph_detector = NULL;
   }
 
   PAGE_RES() { Init(); }  // empty constructor
@@ -87,7 +100,18 @@ class PAGE_RES {                 // page result
            WERD_CHOICE **prev_word_best_choice_ptr);
 
   ~PAGE_RES () {               // destructor
+    delete paragraph_detector;
+    block_res_list.clear();
+    delete arena;
   }
+
+  // Runs and deletes paragraph_detector, if there is one. The iterators call
+  // this before they read the paragraphs.
+  void DetectParagraphsIfNeeded();
+
+  // Returns an estimate of the bytes of heap used by the results of the
+  // page: the words with their outlines, blobs, choices and ratings.
+  int MemoryUsed() const;
 };
 
 /*************************************************************************
@@ -106,10 +130,12 @@ class BLOCK_RES:public ELIST_LINK {
   //      processed
   BOOL8 bold;                  // all bold
   BOOL8 italic;                // all italic
+  // Every word is confident after pass 1, so the later passes skip the block.
+  BOOL8 fast_confident;
 
   ROW_RES_LIST row_res_list;
 
-  BLOCK_RES() {
+  BLOCK_RES() : fast_confident(FALSE) {
   }                            // empty constructor
 
   BLOCK_RES(bool merge_similar_words, BLOCK *the_block);  // real block
@@ -152,7 +178,7 @@ enum CRUNCH_MODE
 
 // WERD_RES is a collection of publicly accessible members that gathers
 // information about a word result.
-class WERD_RES : public ELIST_LINK {
+class WERD_RES : public ELIST_LINK, public tesseract::PageArenaAllocated {
  public:
   // Which word is which?
   // There are 3 coordinate spaces in use here: a possibly rotated pixel space,
@@ -414,6 +440,9 @@ class WERD_RES : public ELIST_LINK {
   void InitPointers();
   void Clear();
   void ClearResults();
+  // Returns an estimate of the bytes of heap used by the word, its blobs,
+  // outlines, choices and ratings.
+  int MemoryUsed() const;
   void ClearWordChoices();
   void ClearRatings();
 
@@ -450,6 +479,14 @@ class WERD_RES : public ELIST_LINK {
                            const TBOX* norm_box, bool numeric_mode,
                            bool use_body_size, bool allow_detailed_fx,
                            ROW *row, const BLOCK* block);
+  // As SetupForRecognition, but copies the normalized chopped_word and denorm
+  // of source instead of approximating and normalizing the outlines again.
+  // source must be a word of the same WERD, with the same x_height and
+  // baseline_shift, that SetupForRecognition returned true for with the same
+  // normalization arguments, and that has not been recognized since.
+  void SetupForRecognitionAs(const WERD_RES& source,
+                             const UNICHARSET& unicharset_in,
+                             tesseract::Tesseract* tesseract);
 
   // Set up the seam array, bln_boxes, best_choice, and raw_choice to empty
   // accumulators from a made chopped word.  We presume the fields are already
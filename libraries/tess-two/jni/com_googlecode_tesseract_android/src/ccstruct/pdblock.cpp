@@ -123,6 +123,31 @@ void PDBLK::move(                  // reposition block
   box.move (vec);
 }
 
+/**********************************************************************
+ * PDBLK::scale
+ *
+ * Scale the block, its sides and any polygon about the origin.
+ **********************************************************************/
+
+void PDBLK::scale(int factor) {
+  ICOORDELT_IT it(&leftside);
+
+  for (it.mark_cycle_pt(); !it.cycled_list(); it.forward())
+    *(it.data()) *= factor;
+
+  it.set_to_list(&rightside);
+
+  for (it.mark_cycle_pt(); !it.cycled_list(); it.forward())
+    *(it.data()) *= factor;
+
+  if (hand_poly != NULL) {
+    hand_poly->scale(factor);
+    box = *hand_poly->bounding_box();
+  } else {
+    box.scale(static_cast<float>(factor));
+  }
+}
+
 // Returns a binary Pix mask with a 1 pixel for every pixel within the
 // block. Rotates the coordinate system by rerotation prior to rendering.
 Pix* PDBLK::render_mask(const FCOORD& rerotation, TBOX* mask_box) {
@@ -73,6 +73,9 @@ class PDBLK {
   /// reposition block
   void move(const ICOORD vec);  // by vector
 
+  /// scale block, sides and polygon about the origin
+  void scale(int factor);
+
   // Returns a binary Pix mask with a 1 pixel for every pixel within the
   // block. Rotates the coordinate system by rerotation prior to rendering.
   // If not NULL, mask_box is filled with the position box of the returned
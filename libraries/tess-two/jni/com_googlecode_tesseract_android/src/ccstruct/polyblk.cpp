@@ -241,6 +241,22 @@ void POLY_BLOCK::move(ICOORD shift) {
 }
 
 
+/**
+ * POLY_BLOCK::scale
+ *
+ * Scale the POLY_BLOCK about the origin.
+ * @param factor multiplier of all coordinates
+ */
+
+void POLY_BLOCK::scale(int factor) {
+  ICOORDELT_IT pts = &vertices;
+
+  for (pts.mark_cycle_pt(); !pts.cycled_list(); pts.forward())
+    *pts.data() *= factor;
+  compute_bb();
+}
+
+
 #ifndef GRAPHICS_DISABLED
 void POLY_BLOCK::plot(ScrollView* window, inT32 num) {
   ICOORDELT_IT v = &vertices;
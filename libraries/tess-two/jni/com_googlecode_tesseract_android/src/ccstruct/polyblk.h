@@ -60,6 +60,8 @@ class DLLSYM POLY_BLOCK {
   void reflect_in_y_axis();
   // Move by adding shift to all coordinates.
   void move(ICOORD shift);
+  // Multiply all coordinates by factor.
+  void scale(int factor);
 
   void plot(ScrollView* window, inT32 num);
 
@@ -171,6 +171,35 @@ BLOB_CHOICE* FindMatchingChoice(UNICHAR_ID char_id,
   return NULL;
 }
 
+void TruncateBlobChoices(int max_choices, const UNICHARSET &unicharset,
+                         BLOB_CHOICE_LIST *bc_list) {
+  if (max_choices <= 0) return;
+  // As LanguageModel::GetTopLowerUpperDigit, alpha counts as upper case for
+  // languages without case.
+  bool found_lower = false;
+  bool found_upper = false;
+  bool found_digit = false;
+  int num_kept = 0;
+  BLOB_CHOICE_IT choice_it(bc_list);
+  for (choice_it.mark_cycle_pt(); !choice_it.cycled_list();
+       choice_it.forward()) {
+    UNICHAR_ID unichar_id = choice_it.data()->unichar_id();
+    if (unicharset.get_fragment(unichar_id)) continue;
+    bool lower = unicharset.get_islower(unichar_id);
+    bool upper = unicharset.get_isalpha(unichar_id) && !lower;
+    bool digit = unicharset.get_isdigit(unichar_id);
+    bool first_of_kind = (lower && !found_lower) || (upper && !found_upper) ||
+                         (digit && !found_digit);
+    found_lower |= lower;
+    found_upper |= upper;
+    found_digit |= digit;
+    if (num_kept < max_choices)
+      ++num_kept;
+    else if (!first_of_kind)
+      delete choice_it.extract();
+  }
+}
+
 const char *WERD_CHOICE::permuter_name(uinT8 permuter) {
   return kPermuterTypeNames[permuter];
 }
@@ -198,8 +227,8 @@ const char *ScriptPosToString(enum ScriptPos script_pos) {
 WERD_CHOICE::WERD_CHOICE(const char *src_string,
                          const UNICHARSET &unicharset)
     : unicharset_(&unicharset){
-  GenericVector<UNICHAR_ID> encoding;
-  GenericVector<char> lengths;
+  SmallVector<UNICHAR_ID, 16> encoding;
+  SmallVector<char, 16> lengths;
   if (unicharset.encode_string(src_string, true, &encoding, &lengths, NULL)) {
     lengths.push_back('\0');
     STRING src_lengths = &lengths[0];
@@ -520,6 +549,27 @@ WERD_CHOICE& WERD_CHOICE::operator=(const WERD_CHOICE& source) {
   return *this;
 }
 
+// Exchanges every member but the list link, so the arrays change hands
+// instead of being copied.
+void WERD_CHOICE::swap(WERD_CHOICE& other) {
+  Swap(&unicharset_, &other.unicharset_);
+  Swap(&unichar_ids_, &other.unichar_ids_);
+  Swap(&script_pos_, &other.script_pos_);
+  Swap(&state_, &other.state_);
+  Swap(&certainties_, &other.certainties_);
+  Swap(&reserved_, &other.reserved_);
+  Swap(&length_, &other.length_);
+  Swap(&adjust_factor_, &other.adjust_factor_);
+  Swap(&rating_, &other.rating_);
+  Swap(&certainty_, &other.certainty_);
+  Swap(&min_x_height_, &other.min_x_height_);
+  Swap(&max_x_height_, &other.max_x_height_);
+  Swap(&permuter_, &other.permuter_);
+  Swap(&unichars_in_script_order_, &other.unichars_in_script_order_);
+  Swap(&dangerous_ambig_found_, &other.dangerous_ambig_found_);
+  // unichar_string_ and unichar_lengths_ are rebuilt on every use.
+}
+
 // Sets up the script_pos_ member using the blobs_list to get the bln
 // bounding boxes, *this to get the unichars, and this->unicharset
 // to get the target positions. If small_caps is true, sub/super are not
@@ -27,6 +27,7 @@
 #include "fontinfo.h"
 #include "genericvector.h"
 #include "matrix.h"
+#include "pagearena.h"
 #include "unichar.h"
 #include "unicharset.h"
 #include "werd.h"
@@ -45,7 +46,7 @@ enum BlobChoiceClassifier {
   BCC_FAKE,                // From some other process.
 };
 
-class BLOB_CHOICE: public ELIST_LINK
+class BLOB_CHOICE: public ELIST_LINK, public tesseract::PageArenaAllocated
 {
   public:
     BLOB_CHOICE() {
@@ -93,20 +94,13 @@ class BLOB_CHOICE: public ELIST_LINK
     }
     void set_fonts(const GenericVector<tesseract::ScoredFont>& fonts) {
       fonts_ = fonts;
-      int score1 = 0, score2 = 0;
-      fontinfo_id_ = -1;
-      fontinfo_id2_ = -1;
-      for (int f = 0; f < fonts_.size(); ++f) {
-        if (fonts_[f].score > score1) {
-          score2 = score1;
-          fontinfo_id2_ = fontinfo_id_;
-          score1 = fonts_[f].score;
-          fontinfo_id_ = fonts_[f].fontinfo_id;
-        } else if (fonts_[f].score > score2) {
-          score2 = fonts_[f].score;
-          fontinfo_id2_ = fonts_[f].fontinfo_id;
-        }
-      }
+      FindTopFonts(fonts_);
+    }
+    // Sets only the best two of fonts, which the language model uses, and
+    // not the fonts list, for when the fonts of words are not wanted.
+    void set_top_fonts(const GenericVector<tesseract::ScoredFont>& fonts) {
+      fonts_.truncate(0);
+      FindTopFonts(fonts);
     }
     int script_id() const {
       return script_id_;
@@ -198,6 +192,24 @@ class BLOB_CHOICE: public ELIST_LINK
     }
 
  private:
+  // Sets fontinfo_id_ and fontinfo_id2_ to the best two of fonts.
+  void FindTopFonts(const GenericVector<tesseract::ScoredFont>& fonts) {
+    int score1 = 0, score2 = 0;
+    fontinfo_id_ = -1;
+    fontinfo_id2_ = -1;
+    for (int f = 0; f < fonts.size(); ++f) {
+      if (fonts[f].score > score1) {
+        score2 = score1;
+        fontinfo_id2_ = fontinfo_id_;
+        score1 = fonts[f].score;
+        fontinfo_id_ = fonts[f].fontinfo_id;
+      } else if (fonts[f].score > score2) {
+        score2 = fonts[f].score;
+        fontinfo_id2_ = fonts[f].fontinfo_id;
+      }
+    }
+  }
+
   UNICHAR_ID unichar_id_;          // unichar id
   // Fonts and scores. Allowed to be empty.
   GenericVector<tesseract::ScoredFont> fonts_;
@@ -236,6 +248,14 @@ ELISTIZEH(BLOB_CHOICE)
 // or NULL if there is no match.
 BLOB_CHOICE *FindMatchingChoice(UNICHAR_ID char_id, BLOB_CHOICE_LIST *bc_list);
 
+// Deletes the choices of bc_list, which must be sorted best first, after the
+// first max_choices, except the first lower case, upper case and digit
+// choices, which the language model flags as the top choices of their kind,
+// and the character fragments, which are merged into whole characters
+// later. Does nothing if max_choices is not positive.
+void TruncateBlobChoices(int max_choices, const UNICHARSET &unicharset,
+                         BLOB_CHOICE_LIST *bc_list);
+
 // Permuter codes used in WERD_CHOICEs.
 enum PermuterType {
   NO_PERM,            // 0
@@ -268,7 +288,8 @@ const char *ScriptPosToString(tesseract::ScriptPos script_pos);
 
 }  // namespace tesseract.
 
-class TESS_API WERD_CHOICE : public ELIST_LINK {
+class TESS_API WERD_CHOICE : public ELIST_LINK,
+                             public tesseract::PageArenaAllocated {
  public:
   static const float kBadRating;
   static const char *permuter_name(uinT8 permuter);
@@ -293,6 +314,14 @@ class TESS_API WERD_CHOICE : public ELIST_LINK {
     this->init(word.length());
     this->operator=(word);
   }
+#if TESS_HAS_MOVE
+  // Takes the arrays of word, leaving it empty. The list link is not moved.
+  WERD_CHOICE(WERD_CHOICE &&word)
+      : ELIST_LINK(), unicharset_(word.unicharset_) {
+    this->init(0);
+    this->swap(word);
+  }
+#endif
   ~WERD_CHOICE();
 
   const UNICHARSET *unicharset() const {
@@ -301,6 +330,12 @@ class TESS_API WERD_CHOICE : public ELIST_LINK {
   inline int length() const {
     return length_;
   }
+  // Returns the number of bytes of heap used by the choice.
+  int MemoryUsed() const {
+    return sizeof(*this) +
+        reserved_ * (sizeof(*unichar_ids_) + sizeof(*script_pos_) +
+                     sizeof(*state_) + sizeof(*certainties_));
+  }
   float adjust_factor() const {
     return adjust_factor_;
   }
@@ -574,6 +609,16 @@ class TESS_API WERD_CHOICE : public ELIST_LINK {
     const WERD_CHOICE & second);// second on first
 
   WERD_CHOICE& operator= (const WERD_CHOICE& source);
+#if TESS_HAS_MOVE
+  // Swaps with source, which is left holding the old contents of *this.
+  WERD_CHOICE& operator= (WERD_CHOICE&& source) {
+    this->swap(source);
+    return *this;
+  }
+#endif
+  // Exchanges the contents of *this and other without copying the arrays.
+  // Neither is moved in or out of the list it is on.
+  void swap(WERD_CHOICE& other);
 
  private:
   const UNICHARSET *unicharset_;
@@ -623,6 +668,10 @@ class TESS_API WERD_CHOICE : public ELIST_LINK {
   mutable STRING unichar_lengths_;
 };
 
+inline void swap(WERD_CHOICE& word1, WERD_CHOICE& word2) {
+  word1.swap(word2);
+}
+
 // Make WERD_CHOICE listable.
 ELISTIZEH(WERD_CHOICE)
 typedef GenericVector<BLOB_CHOICE_LIST *> BLOB_CHOICE_LIST_VECTOR;
@@ -22,6 +22,7 @@
 
 #include <stdio.h>
 #include "helpers.h"
+#include "object_cache.h"
 #include "universalambigs.h"
 
 #if defined _WIN32
@@ -49,6 +50,50 @@ AmbigSpec::AmbigSpec() {
 
 ELISTIZE(AmbigSpec);
 
+void AmbigTrie::Build(const UnicharAmbigsVector &table) {
+  starts_.init_to_size(table.size(), -1);
+  nodes_.clear();
+  for (int id = 0; id < table.size(); ++id) {
+    if (table[id] == NULL || table[id]->empty()) continue;
+    starts_[id] = nodes_.size();
+    nodes_.push_back(Node());
+    // The lists are sorted, so the specs of each node keep their order.
+    AmbigSpec_IT spec_it(table[id]);
+    for (spec_it.mark_cycle_pt(); !spec_it.cycled_list(); spec_it.forward()) {
+      const AmbigSpec *spec = spec_it.data();
+      int node = starts_[id];
+      for (int i = 1; i < spec->wrong_ngram_size; ++i)
+        node = AddChild(node, spec->wrong_ngram[i]);
+      nodes_[node].specs.push_back(spec);
+    }
+  }
+}
+
+int AmbigTrie::Next(int node, UNICHAR_ID unichar_id) const {
+  const GenericVector<UNICHAR_ID> &ids = nodes_[node].child_ids;
+  for (int c = 0; c < ids.size() && ids[c] <= unichar_id; ++c) {
+    if (ids[c] == unichar_id) return nodes_[node].children[c];
+  }
+  return -1;
+}
+
+int AmbigTrie::AddChild(int node, UNICHAR_ID unichar_id) {
+  int c = 0;
+  while (c < nodes_[node].child_ids.size() &&
+         nodes_[node].child_ids[c] < unichar_id) {
+    ++c;
+  }
+  if (c < nodes_[node].child_ids.size() &&
+      nodes_[node].child_ids[c] == unichar_id) {
+    return nodes_[node].children[c];
+  }
+  int child = nodes_.size();
+  nodes_.push_back(Node());
+  nodes_[node].child_ids.insert(unichar_id, c);
+  nodes_[node].children.insert(child, c);
+  return child;
+}
+
 // Initializes the ambigs by adding a NULL pointer to each table.
 void UnicharAmbigs::InitUnicharAmbigs(const UNICHARSET& unicharset,
                                       bool use_ambigs_for_adaption) {
@@ -63,12 +108,36 @@ void UnicharAmbigs::InitUnicharAmbigs(const UNICHARSET& unicharset,
   }
 }
 
+// Returns a key that is the same for unicharsets that encode strings the
+// same way, ie have the same unichars with the same ids.
+static STRING EncoderKey(const UNICHARSET& encoder_set) {
+  STRING key;
+  for (int id = 0; id < encoder_set.size(); ++id) {
+    key += encoder_set.id_to_unichar(id);
+    key += '\n';
+  }
+  return key;
+}
+
 // Loads the universal ambigs that are useful for any language.
 void UnicharAmbigs::LoadUniversal(const UNICHARSET& encoder_set,
                                   UNICHARSET* unicharset) {
+  static ObjectCache<ParsedAmbigs> cache;
+  ParsedAmbigs *ambigs = cache.Get(
+      EncoderKey(encoder_set),
+      NewTessCallback(this, &UnicharAmbigs::ParseUniversal, &encoder_set));
+  if (ambigs == NULL) return;
+  AddAmbigs(*ambigs, 0, false, unicharset);
+  cache.Free(ambigs);
+}
+
+ParsedAmbigs *UnicharAmbigs::ParseUniversal(const UNICHARSET *encoder_set) {
   TFile file;
-  if (!file.Open(kUniversalAmbigsFile, ksizeofUniversalAmbigsFile)) return;
-  LoadUnicharAmbigs(encoder_set, &file, 0, false, unicharset);
+  if (!file.Open(kUniversalAmbigsFile, ksizeofUniversalAmbigsFile))
+    return NULL;
+  ParsedAmbigs *ambigs = new ParsedAmbigs;
+  ParseAmbigs(*encoder_set, &file, 0, ambigs);
+  return ambigs;
 }
 
 void UnicharAmbigs::LoadUnicharAmbigs(const UNICHARSET& encoder_set,
@@ -76,20 +145,21 @@ void UnicharAmbigs::LoadUnicharAmbigs(const UNICHARSET& encoder_set,
                                       int debug_level,
                                       bool use_ambigs_for_adaption,
                                       UNICHARSET *unicharset) {
-  int i, j;
-  UnicharIdVector *adaption_ambigs_entry;
   if (debug_level) tprintf("Reading ambiguities\n");
+  ParsedAmbigs ambigs;
+  ParseAmbigs(encoder_set, ambig_file, debug_level, &ambigs);
+  AddAmbigs(ambigs, debug_level, use_ambigs_for_adaption, unicharset);
+}
 
-  int test_ambig_part_size;
-  int replacement_ambig_part_size;
+void UnicharAmbigs::ParseAmbigs(const UNICHARSET& encoder_set,
+                                TFile *ambig_file, int debug_level,
+                                ParsedAmbigs *ambigs) {
   // The space for buffer is allocated on the heap to avoid
   // GCC frame size warning.
   const int kBufferSize = 10 + 2 * kMaxAmbigStringSize;
   char *buffer = new char[kBufferSize];
   char replacement_string[kMaxAmbigStringSize];
-  UNICHAR_ID test_unichar_ids[MAX_AMBIG_SIZE + 1];
   int line_num = 0;
-  int type = NOT_AMBIG;
 
   // Determine the version of the ambigs file.
   int version = 0;
@@ -101,26 +171,46 @@ void UnicharAmbigs::LoadUnicharAmbigs(const UNICHARSET& encoder_set,
   } else {
     ambig_file->Rewind();
   }
+  ParsedAmbig ambig;
+  ambig.type = NOT_AMBIG;
   while (ambig_file->FGets(buffer, kBufferSize) != NULL) {
     chomp_string(buffer);
     if (debug_level > 2) tprintf("read line %s\n", buffer);
     ++line_num;
     if (!ParseAmbiguityLine(line_num, version, debug_level, encoder_set,
-                            buffer, &test_ambig_part_size, test_unichar_ids,
-                            &replacement_ambig_part_size,
-                            replacement_string, &type)) continue;
+                            buffer, &ambig.test_ambig_part_size,
+                            ambig.test_unichar_ids,
+                            &ambig.replacement_ambig_part_size,
+                            replacement_string, &ambig.type)) continue;
+    ambig.replacement_string = replacement_string;
+    ambigs->push_back(ambig);
+  }
+  delete[] buffer;
+}
+
+void UnicharAmbigs::AddAmbigs(const ParsedAmbigs &ambigs, int debug_level,
+                              bool use_ambigs_for_adaption,
+                              UNICHARSET *unicharset) {
+  int i, j;
+  UnicharIdVector *adaption_ambigs_entry;
+  for (int a = 0; a < ambigs.size(); ++a) {
+    const ParsedAmbig &ambig = ambigs[a];
+    const UNICHAR_ID *test_unichar_ids = ambig.test_unichar_ids;
+    const char *replacement_string = ambig.replacement_string.string();
     // Construct AmbigSpec and add it to the appropriate AmbigSpec_LIST.
     AmbigSpec *ambig_spec = new AmbigSpec();
-    if (!InsertIntoTable((type == REPLACE_AMBIG) ? replace_ambigs_
-                                                 : dang_ambigs_,
-                         test_ambig_part_size, test_unichar_ids,
-                         replacement_ambig_part_size, replacement_string, type,
+    if (!InsertIntoTable((ambig.type == REPLACE_AMBIG) ? replace_ambigs_
+                                                       : dang_ambigs_,
+                         ambig.test_ambig_part_size, test_unichar_ids,
+                         ambig.replacement_ambig_part_size,
+                         replacement_string, ambig.type,
                          ambig_spec, unicharset))
       continue;
 
     // Update one_to_one_definite_ambigs_.
-    if (test_ambig_part_size == 1 &&
-        replacement_ambig_part_size == 1 && type == DEFINITE_AMBIG) {
+    if (ambig.test_ambig_part_size == 1 &&
+        ambig.replacement_ambig_part_size == 1 &&
+        ambig.type == DEFINITE_AMBIG) {
       if (one_to_one_definite_ambigs_[test_unichar_ids[0]] == NULL) {
         one_to_one_definite_ambigs_[test_unichar_ids[0]] = new UnicharIdVector();
       }
@@ -134,7 +224,7 @@ void UnicharAmbigs::LoadUnicharAmbigs(const UNICHARSET& encoder_set,
       // universal ambigs file.
       if (unicharset->encode_string(replacement_string, true, &encoding,
                                     NULL, NULL)) {
-        for (i = 0; i < test_ambig_part_size; ++i) {
+        for (i = 0; i < ambig.test_ambig_part_size; ++i) {
           if (ambigs_for_adaption_[test_unichar_ids[i]] == NULL) {
             ambigs_for_adaption_[test_unichar_ids[i]] = new UnicharIdVector();
           }
@@ -158,7 +248,6 @@ void UnicharAmbigs::LoadUnicharAmbigs(const UNICHARSET& encoder_set,
       }
     }
   }
-  delete[] buffer;
 
   // Fill in reverse_ambigs_for_adaption from ambigs_for_adaption vector.
   if (use_ambigs_for_adaption) {
@@ -175,6 +264,9 @@ void UnicharAmbigs::LoadUnicharAmbigs(const UNICHARSET& encoder_set,
     }
   }
 
+  dang_trie_.Build(dang_ambigs_);
+  replace_trie_.Build(replace_ambigs_);
+
   // Print what was read from the input file.
   if (debug_level > 1) {
     for (int tbl = 0; tbl < 2; ++tbl) {
@@ -337,7 +429,7 @@ bool UnicharAmbigs::ParseAmbiguityLine(
 
 bool UnicharAmbigs::InsertIntoTable(
     UnicharAmbigsVector &table, int test_ambig_part_size,
-    UNICHAR_ID *test_unichar_ids, int replacement_ambig_part_size,
+    const UNICHAR_ID *test_unichar_ids, int replacement_ambig_part_size,
     const char *replacement_string, int type,
     AmbigSpec *ambig_spec, UNICHARSET *unicharset) {
   ambig_spec->type = static_cast<AmbigType>(type);
@@ -22,6 +22,7 @@
 #define TESSERACT_CCUTIL_AMBIGS_H_
 
 #include "elst.h"
+#include "strngs.h"
 #include "tprintf.h"
 #include "unichar.h"
 #include "unicharset.h"
@@ -138,10 +139,60 @@ class AmbigSpec : public ELIST_LINK {
 };
 ELISTIZEH(AmbigSpec);
 
+// One ambiguity read from an ambigs file and encoded with the encoder
+// unicharset, but not yet added to the tables of a UnicharAmbigs.
+struct ParsedAmbig {
+  int test_ambig_part_size;
+  UNICHAR_ID test_unichar_ids[MAX_AMBIG_SIZE + 1];
+  int replacement_ambig_part_size;
+  STRING replacement_string;
+  int type;
+};
+typedef GenericVector<ParsedAmbig> ParsedAmbigs;
+
 // AMBIG_TABLE[i] stores a set of ambiguities whose
 // wrong ngram starts with unichar id i.
 typedef GenericVector<AmbigSpec_LIST *> UnicharAmbigsVector;
 
+// The wrong ngrams of an ambiguity table as a trie over unichar ids, so
+// that the ambiguities starting at a position of a word are found by
+// following the word from there, instead of comparing it with every entry
+// of the list for its first unichar.
+class AmbigTrie {
+ public:
+  // Rebuilds the trie from the sorted lists of table, which must outlive it.
+  void Build(const UnicharAmbigsVector &table);
+
+  // Returns the node of the ngram made of just unichar_id, or -1 if no
+  // ambiguity starts with it.
+  int Start(UNICHAR_ID unichar_id) const {
+    if (unichar_id < 0 || unichar_id >= starts_.size()) return -1;
+    return starts_[unichar_id];
+  }
+  // Returns the node of the ngram of node extended by unichar_id, or -1 if
+  // no ambiguity starts with that.
+  int Next(int node, UNICHAR_ID unichar_id) const;
+  // Returns the ambiguities whose wrong ngram is that of node, in the order
+  // of the table.
+  const GenericVector<const AmbigSpec *> &Specs(int node) const {
+    return nodes_[node].specs;
+  }
+
+ private:
+  struct Node {
+    // The unichar ids of the children, sorted, and their nodes.
+    GenericVector<UNICHAR_ID> child_ids;
+    GenericVector<int> children;
+    GenericVector<const AmbigSpec *> specs;
+  };
+  // Returns the child of node for unichar_id, adding it if needed.
+  int AddChild(int node, UNICHAR_ID unichar_id);
+
+  // The node of each unichar id that starts an ambiguity, or -1.
+  GenericVector<int> starts_;
+  GenericVector<Node> nodes_;
+};
+
 class UnicharAmbigs {
  public:
   UnicharAmbigs() {}
@@ -153,12 +204,16 @@ class UnicharAmbigs {
 
   const UnicharAmbigsVector &dang_ambigs() const { return dang_ambigs_; }
   const UnicharAmbigsVector &replace_ambigs() const { return replace_ambigs_; }
+  const AmbigTrie &dang_trie() const { return dang_trie_; }
+  const AmbigTrie &replace_trie() const { return replace_trie_; }
 
   // Initializes the ambigs by adding a NULL pointer to each table.
   void InitUnicharAmbigs(const UNICHARSET& unicharset,
                          bool use_ambigs_for_adaption);
 
   // Loads the universal ambigs that are useful for any language.
+  // The universal ambigs file is large, so it is parsed once per distinct
+  // encoder unicharset and the result is kept in a process-wide cache.
   void LoadUniversal(const UNICHARSET& encoder_set, UNICHARSET* unicharset);
 
   // Fills in two ambiguity tables (replaceable and dangerous) with information
@@ -205,6 +260,15 @@ class UnicharAmbigs {
   }
 
  private:
+  // Reads and encodes all the ambiguities of ambigs_file.
+  void ParseAmbigs(const UNICHARSET& encoder_set, TFile *ambigs_file,
+                   int debug_level, ParsedAmbigs *ambigs);
+  // Loader for the universal ambigs cache.
+  ParsedAmbigs *ParseUniversal(const UNICHARSET *encoder_set);
+  // Adds the parsed ambigs to the tables, inserting the unichars they need
+  // into unicharset.
+  void AddAmbigs(const ParsedAmbigs &ambigs, int debug_level,
+                 bool use_ambigs_for_adaption, UNICHARSET *unicharset);
   bool ParseAmbiguityLine(int line_num, int version, int debug_level,
                           const UNICHARSET &unicharset, char *buffer,
                           int *test_ambig_part_size,
@@ -212,13 +276,17 @@ class UnicharAmbigs {
                           int *replacement_ambig_part_size,
                           char *replacement_string, int *type);
   bool InsertIntoTable(UnicharAmbigsVector &table,
-                       int test_ambig_part_size, UNICHAR_ID *test_unichar_ids,
+                       int test_ambig_part_size,
+                       const UNICHAR_ID *test_unichar_ids,
                        int replacement_ambig_part_size,
                        const char *replacement_string, int type,
                        AmbigSpec *ambig_spec, UNICHARSET *unicharset);
 
   UnicharAmbigsVector dang_ambigs_;
   UnicharAmbigsVector replace_ambigs_;
+  // The tables above as tries, rebuilt whenever ambiguities are added.
+  AmbigTrie dang_trie_;
+  AmbigTrie replace_trie_;
   GenericVector<UnicharIdVector *> one_to_one_definite_ambigs_;
   GenericVector<UnicharIdVector *> ambigs_for_adaption_;
   GenericVector<UnicharIdVector *> reverse_ambigs_for_adaption_;
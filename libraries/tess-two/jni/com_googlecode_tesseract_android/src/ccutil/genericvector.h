@@ -28,6 +28,7 @@
 #include "errcode.h"
 #include "helpers.h"
 #include "ndminx.h"
+#include "platform.h"
 #include "serialis.h"
 #include "strngs.h"
 
@@ -52,6 +53,17 @@ class GenericVector {
   }
   GenericVector<T> &operator+=(const GenericVector& other);
   GenericVector<T> &operator=(const GenericVector& other);
+#if TESS_HAS_MOVE
+  // Move, taking the elements and callbacks of other and leaving it empty.
+  GenericVector(GenericVector&& other) {
+    init(0);
+    move(&other);
+  }
+  GenericVector<T> &operator=(GenericVector&& other) {
+    if (&other != this) move(&other);
+    return *this;
+  }
+#endif
 
   ~GenericVector();
 
@@ -330,6 +342,15 @@ class GenericVector {
   // Internal recursive version of choose_nth_item.
   int choose_nth_item(int target_index, int start, int end, unsigned int* seed);
 
+  // Makes an empty vector that stores its first inline_size elements in
+  // inline_data, which is owned by the derived class. See SmallVector.
+  GenericVector(T* inline_data, int inline_size) {
+    init(0);
+    inline_data_ = inline_data;
+    data_ = inline_data;
+    size_reserved_ = inline_size;
+  }
+
   // Init the object, allocating size memory.
   void init(int size);
 
@@ -340,6 +361,9 @@ class GenericVector {
   inT32   size_used_;
   inT32   size_reserved_;
   T*    data_;
+  // Storage in the derived class that data_ points to until it is
+  // outgrown, or NULL. It is never deleted here.
+  T*    inline_data_;
   TessCallback1<T>* clear_cb_;
   // Mutable because Run method is not const
   mutable TessResultCallback2<bool, T const &, T const &>* compare_cb_;
@@ -625,11 +649,45 @@ class GenericVectorEqEq : public GenericVector<T> {
   }
 };
 
+// A GenericVector that keeps its first N elements inside itself, so the
+// short vectors made and thrown away for every blob or word don't touch
+// the heap. Once it outgrows N it moves to the heap like any other
+// GenericVector, and stays there until destroyed.
+template <typename T, int N>
+class SmallVector : public GenericVector<T> {
+ public:
+  SmallVector() : GenericVector<T>(inline_, N) {}
+  SmallVector(const SmallVector& other) : GenericVector<T>(inline_, N) {
+    this->operator+=(other);
+  }
+  explicit SmallVector(const GenericVector<T>& other)
+    : GenericVector<T>(inline_, N) {
+    this->operator+=(other);
+  }
+  ~SmallVector() {
+    // The elements must be cleared while inline_ still exists.
+    this->clear();
+  }
+
+  SmallVector<T, N>& operator=(const SmallVector& other) {
+    GenericVector<T>::operator=(other);
+    return *this;
+  }
+  SmallVector<T, N>& operator=(const GenericVector<T>& other) {
+    GenericVector<T>::operator=(other);
+    return *this;
+  }
+
+ private:
+  T inline_[N];
+};
+
 template <typename T>
 void GenericVector<T>::init(int size) {
   size_used_ = 0;
   size_reserved_ = 0;
   data_ = 0;
+  inline_data_ = 0;
   clear_cb_ = 0;
   compare_cb_ = 0;
   reserve(size);
@@ -649,7 +707,7 @@ void GenericVector<T>::reserve(int size) {
   T* new_array = new T[size];
   for (int i = 0; i < size_used_; ++i)
     new_array[i] = data_[i];
-  if (data_ != NULL) delete[] data_;
+  if (data_ != NULL && data_ != inline_data_) delete[] data_;
   data_ = new_array;
   size_reserved_ = size;
 }
@@ -831,10 +889,13 @@ void GenericVector<T>::clear() {
     if (clear_cb_ != NULL)
       for (int i = 0; i < size_used_; ++i)
         clear_cb_->Run(data_[i]);
-    delete[] data_;
-    data_ = NULL;
     size_used_ = 0;
-    size_reserved_ = 0;
+    // Inline storage is kept for reuse.
+    if (data_ != inline_data_) {
+      delete[] data_;
+      data_ = NULL;
+      size_reserved_ = 0;
+    }
   }
   if (clear_cb_ != NULL) {
     delete clear_cb_;
@@ -1022,16 +1083,25 @@ bool GenericVector<T>::SkipDeSerializeClasses(bool swap, tesseract::TFile* fp) {
 template <typename T>
 void GenericVector<T>::move(GenericVector<T>* from) {
   this->clear();
-  this->data_ = from->data_;
-  this->size_reserved_ = from->size_reserved_;
-  this->size_used_ = from->size_used_;
+  if (from->data_ != NULL && from->data_ == from->inline_data_) {
+    // Inline storage can't be taken, so the elements are copied, but it
+    // stays with from for reuse.
+    this->reserve(from->size_used_);
+    for (int i = 0; i < from->size_used_; ++i)
+      this->data_[i] = from->data_[i];
+    this->size_used_ = from->size_used_;
+  } else {
+    this->data_ = from->data_;
+    this->size_reserved_ = from->size_reserved_;
+    this->size_used_ = from->size_used_;
+    from->data_ = NULL;
+    from->size_reserved_ = 0;
+  }
   this->compare_cb_ = from->compare_cb_;
   this->clear_cb_ = from->clear_cb_;
-  from->data_ = NULL;
   from->clear_cb_ = NULL;
   from->compare_cb_ = NULL;
   from->size_used_ = 0;
-  from->size_reserved_ = 0;
 }
 
 template <typename T>
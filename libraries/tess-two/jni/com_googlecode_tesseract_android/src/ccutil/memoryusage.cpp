@@ -0,0 +1,71 @@
+///////////////////////////////////////////////////////////////////////
+// File:        memoryusage.cpp
+// Description: Bytes of memory used by each component of a loaded engine.
+//
+// (C) Copyright 2016, Google Inc.
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////
+
+#include "memoryusage.h"
+
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+namespace tesseract {
+
+static const char* const kComponentNames[MEMORY_COUNT] = {
+  "unicharset", "int_templates", "shape_table", "dawgs", "cube",
+  "adaptive_templates", "images", "page_results"
+};
+
+void MemoryUsage::Clear() {
+  for (int i = 0; i < MEMORY_COUNT; ++i) bytes[i] = 0;
+  dawg_names.clear();
+  dawg_bytes.clear();
+  page_peak_bytes = 0;
+  peak_resident_bytes = 0;
+}
+
+inT64 MemoryUsage::Total() const {
+  inT64 total = 0;
+  for (int i = 0; i < MEMORY_COUNT; ++i) total += bytes[i];
+  return total;
+}
+
+void MemoryUsage::AddDawg(const STRING& name, inT64 dawg_size) {
+  bytes[MEMORY_DAWGS] += dawg_size;
+  dawg_names.push_back(name);
+  dawg_bytes.push_back(dawg_size);
+}
+
+const char* MemoryUsage::Name(MemoryComponent component) {
+  return component >= 0 && component < MEMORY_COUNT
+      ? kComponentNames[component] : "unknown";
+}
+
+inT64 MemoryUsage::PeakResidentBytes() {
+#ifndef _WIN32
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+#ifdef __APPLE__
+  return usage.ru_maxrss;
+#else
+  // Linux and Android give kilobytes.
+  return static_cast<inT64>(usage.ru_maxrss) * 1024;
+#endif
+#else
+  return 0;
+#endif
+}
+
+}  // namespace tesseract
@@ -0,0 +1,73 @@
+///////////////////////////////////////////////////////////////////////
+// File:        memoryusage.h
+// Description: Bytes of memory used by each component of a loaded engine.
+//
+// (C) Copyright 2016, Google Inc.
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////
+
+#ifndef TESSERACT_CCUTIL_MEMORYUSAGE_H_
+#define TESSERACT_CCUTIL_MEMORYUSAGE_H_
+
+#include "genericvector.h"
+#include "host.h"
+#include "platform.h"
+#include "strngs.h"
+
+namespace tesseract {
+
+// The parts of an engine that hold memory, each summed over the languages
+// loaded. Keep in step with kComponentNames and the Java
+// TessBaseAPI.MemoryUsage.
+enum MemoryComponent {
+  MEMORY_UNICHARSET,           // The unicharsets.
+  MEMORY_INT_TEMPLATES,        // The pre-trained templates.
+  MEMORY_SHAPE_TABLE,          // The shape tables.
+  MEMORY_DAWGS,                // All the dawgs, listed one by one below.
+  MEMORY_CUBE,                 // Cube's models, from the size of their files.
+  MEMORY_ADAPTIVE_TEMPLATES,   // The templates learned from the pages.
+  MEMORY_IMAGES,               // The source and thresholded images.
+  MEMORY_PAGE_RESULTS,         // The results of the last page.
+  MEMORY_COUNT
+};
+
+// A breakdown of the bytes of memory used by an engine. The counts are
+// worked out from the sizes of the data structures, so they leave out
+// allocator overhead and small members, and may be off by a few percent.
+struct TESS_API MemoryUsage {
+  MemoryUsage() { Clear(); }
+
+  void Clear();
+  // Returns the sum of the components.
+  inT64 Total() const;
+  // Adds bytes to MEMORY_DAWGS, and to the list of dawgs under name.
+  void AddDawg(const STRING& name, inT64 bytes);
+  // Returns the short lower case name of the component, for reports.
+  static const char* Name(MemoryComponent component);
+  // Returns the largest number of bytes the process has been resident in,
+  // or 0 where that is unknown.
+  static inT64 PeakResidentBytes();
+
+  inT64 bytes[MEMORY_COUNT];
+  // The name, as lang.type, and bytes of each dawg.
+  GenericVector<STRING> dawg_names;
+  GenericVector<inT64> dawg_bytes;
+  // The most bytes of images and page results held at the end of any page
+  // recognized so far.
+  inT64 page_peak_bytes;
+  // PeakResidentBytes when the usage was taken.
+  inT64 peak_resident_bytes;
+};
+
+}  // namespace tesseract
+
+#endif  // TESSERACT_CCUTIL_MEMORYUSAGE_H_
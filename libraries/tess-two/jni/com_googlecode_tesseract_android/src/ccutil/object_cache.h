@@ -31,24 +31,32 @@ namespace tesseract {
 // Usually, these are expensive objects that are loaded from disk.
 // Reference counting is performed, so every Get() needs to be followed later
 // by a Free().  Actual deletion is accomplished by DeleteUnusedObjects().
+// The ids are hashed over a fixed set of stripes, each with its own lock, so
+// threads getting different objects do not wait for each other, and the
+// loader runs outside the stripe lock. A Get() for an object that another
+// thread is still loading waits for that load instead of loading it again.
 template<typename T>
 class ObjectCache {
  public:
   ObjectCache() {}
   ~ObjectCache() {
-    mu_.Lock();
-    for (int i = 0; i < cache_.size(); i++) {
-      if (cache_[i].count > 0) {
-        tprintf("ObjectCache(%p)::~ObjectCache(): WARNING! LEAK! object %p "
-                "still has count %d (id %s)\n",
-                this, cache_[i].object, cache_[i].count,
-                cache_[i].id.string());
-      } else {
-        delete cache_[i].object;
-        cache_[i].object = NULL;
+    for (int s = 0; s < kNumStripes; ++s) {
+      Stripe &stripe = stripes_[s];
+      stripe.mu.Lock();
+      for (int i = 0; i < stripe.entries.size(); i++) {
+        Entry *entry = stripe.entries[i];
+        if (entry->count > 0) {
+          tprintf("ObjectCache(%p)::~ObjectCache(): WARNING! LEAK! object %p "
+                  "still has count %d (id %s)\n",
+                  this, entry->object, entry->count, entry->id.string());
+        } else {
+          delete entry->object;
+          delete entry;
+        }
       }
+      stripe.entries.clear();
+      stripe.mu.Unlock();
     }
-    mu_.Unlock();
   }
 
   // Return a pointer to the object identified by id.
@@ -59,25 +67,40 @@ class ObjectCache {
   // We delete the given loader.
   T *Get(STRING id,
          TessResultCallback<T *> *loader) {
-    T *retval = NULL;
-    mu_.Lock();
-    for (int i = 0; i < cache_.size(); i++) {
-      if (id == cache_[i].id) {
-        retval = cache_[i].object;
-        if (cache_[i].object != NULL) {
-          cache_[i].count++;
-        }
-        mu_.Unlock();
-        delete loader;
-        return retval;
+    uinT32 hash = HashId(id);
+    Stripe &stripe = stripes_[hash % kNumStripes];
+    stripe.mu.Lock();
+    Entry *entry = FindEntry(stripe, hash, id);
+    if (entry != NULL) {
+      if (entry->loading) {
+        // The loading thread holds load_mu until the object is in place.
+        // Being a waiter keeps the entry from being deleted meanwhile.
+        ++entry->waiters;
+        stripe.mu.Unlock();
+        entry->load_mu.Lock();
+        entry->load_mu.Unlock();
+        stripe.mu.Lock();
+        --entry->waiters;
       }
+      T *retval = entry->object;
+      if (retval != NULL) entry->count++;
+      stripe.mu.Unlock();
+      delete loader;
+      return retval;
     }
-    cache_.push_back(ReferenceCount());
-    ReferenceCount &rc = cache_.back();
-    rc.id = id;
-    retval = rc.object = loader->Run();
-    rc.count = (retval != NULL) ? 1 : 0;
-    mu_.Unlock();
+    entry = new Entry;
+    entry->id = id;
+    entry->hash = hash;
+    entry->load_mu.Lock();
+    stripe.entries.push_back(entry);
+    stripe.mu.Unlock();
+    T *retval = loader->Run();
+    stripe.mu.Lock();
+    entry->object = retval;
+    entry->count = (retval != NULL) ? 1 : 0;
+    entry->loading = false;
+    stripe.mu.Unlock();
+    entry->load_mu.Unlock();
     return retval;
   }
 
@@ -85,38 +108,84 @@ class ObjectCache {
   // Return whether we knew about the given pointer.
   bool Free(T *t) {
     if (t == NULL) return false;
-    mu_.Lock();
-    for (int i = 0; i < cache_.size(); i++) {
-      if (cache_[i].object == t) {
-        --cache_[i].count;
-        mu_.Unlock();
-        return true;
+    for (int s = 0; s < kNumStripes; ++s) {
+      Stripe &stripe = stripes_[s];
+      stripe.mu.Lock();
+      for (int i = 0; i < stripe.entries.size(); i++) {
+        if (stripe.entries[i]->object == t) {
+          --stripe.entries[i]->count;
+          stripe.mu.Unlock();
+          return true;
+        }
       }
+      stripe.mu.Unlock();
     }
-    mu_.Unlock();
     return false;
   }
 
   void DeleteUnusedObjects() {
-    mu_.Lock();
-    for (int i = cache_.size() - 1; i >= 0; i--) {
-      if (cache_[i].count <= 0) {
-        delete cache_[i].object;
-        cache_.remove(i);
+    for (int s = 0; s < kNumStripes; ++s) {
+      Stripe &stripe = stripes_[s];
+      stripe.mu.Lock();
+      for (int i = stripe.entries.size() - 1; i >= 0; i--) {
+        Entry *entry = stripe.entries[i];
+        if (entry->count <= 0 && !entry->loading && entry->waiters == 0) {
+          delete entry->object;
+          delete entry;
+          stripe.entries.remove(i);
+        }
       }
+      stripe.mu.Unlock();
     }
-    mu_.Unlock();
   }
 
  private:
-  struct ReferenceCount {
+  // Enough stripes that a handful of languages loading at once rarely share
+  // one.
+  static const int kNumStripes = 16;
+
+  struct Entry {
+    Entry() : hash(0), object(NULL), count(0), loading(true), waiters(0) {}
+
     STRING id;  // A unique ID to identify the object (think path on disk)
+    uinT32 hash;  // HashId(id).
     T *object;  // A copy of the object in memory.  Can be delete'd.
     int count;  // A count of the number of active users of this object.
+    // True until the loader has returned. The loading thread holds load_mu
+    // until then.
+    bool loading;
+    CCUtilMutex load_mu;
+    // Number of threads waiting for the load to finish.
+    int waiters;
   };
+  struct Stripe {
+    CCUtilMutex mu;
+    // Entries are allocated separately so that waiters can keep a pointer
+    // while the vector grows.
+    GenericVector<Entry *> entries;
+  };
+
+  // FNV-1a of the characters of id.
+  static uinT32 HashId(const STRING &id) {
+    uinT32 hash = 2166136261U;
+    const char *str = id.string();
+    for (int i = 0; i < id.length(); ++i) {
+      hash ^= static_cast<unsigned char>(str[i]);
+      hash *= 16777619U;
+    }
+    return hash;
+  }
+  // Returns the entry for id in stripe, which must be locked, or NULL.
+  static Entry *FindEntry(const Stripe &stripe, uinT32 hash,
+                          const STRING &id) {
+    for (int i = 0; i < stripe.entries.size(); i++) {
+      Entry *entry = stripe.entries[i];
+      if (entry->hash == hash && entry->id == id) return entry;
+    }
+    return NULL;
+  }
 
-  CCUtilMutex mu_;
-  GenericVector<ReferenceCount> cache_;
+  Stripe stripes_[kNumStripes];
 };
 
 }  // namespace tesseract
@@ -37,6 +37,11 @@
 #include          <time.h>
 #include          "host.h"
 
+namespace tesseract {
+struct StageTimings;  // stagetimer.h
+class LTRResultIterator;  // ltrresultiterator.h
+}
+
 /*Maximum lengths of various strings*/
 #define MAX_FONT_NAME   34       /*name of font */
 #define MAX_OCR_NAME    32       /*name of engine */
@@ -107,10 +112,28 @@ typedef struct {                  /*single character */
  * to 1 indicates that the OCR engine is dead.
  * If the cancel function is not null then it is called with the number of
  * user words found. If it returns true then operation is cancelled.
+ * It and the deadline are also checked between the stages of layout
+ * analysis, when the number of words is 0, and if either stops it there,
+ * the page has no results.
+ * If the line function is not null then it is called with each text line of
+ * the page as soon as its results are final, with an iterator at the first
+ * word of the line that is only valid during the call. The lines of blocks
+ * that are final after pass 1 (see tessedit_fast_confident) come first, so
+ * the lines are not necessarily in page order.
+ * If the word function is not null then it is called with the UTF-8 text and
+ * the box (as for the progress callback) of each word as soon as pass 1 has
+ * recognized it. If it returns true then recognition stops there, as if
+ * cancelled, but the words recognized so far keep their results. With
+ * priority regions (see TessBaseAPI::SetPriorityRegions) the words come
+ * nearest first, so an app can stop once it has found what it needs.
  **********************************************************************/
 typedef bool (*CANCEL_FUNC)(void* cancel_this, int words);
 typedef bool (*PROGRESS_FUNC)(void* progress_this, int progress,
 		int left, int right, int top, int bottom);
+typedef void (*LINE_FUNC)(void* line_this,
+                          const tesseract::LTRResultIterator* line);
+typedef bool (*WORD_FUNC)(void* word_this, const char* utf8_text,
+                          int left, int right, int top, int bottom);
 
 class ETEXT_DESC {             // output header
  public:
@@ -123,13 +146,24 @@ class ETEXT_DESC {             // output header
   PROGRESS_FUNC progress_callback;//called whenever progress increases
   void* cancel_this;           // this or other data for cancel
   void* progress_this;         // this or other data for progress
+  LINE_FUNC line_callback;     // called with each final text line (NULL)
+  void* line_this;             // this or other data for line_callback
+  WORD_FUNC word_callback;     // returns true to stop after a word (NULL)
+  void* word_this;             // this or other data for word_callback
   struct timeval end_time;     // time to stop. expected to be set only by call
                                // to set_deadline_msecs()
+  inT32 words_out_of_time;     // words whose segmentation search was cut
+                               // short by segsearch_*_budget_us
+  const tesseract::StageTimings* timings;  // time of each stage of the page
+                               // so far, set by the OCR engine (NULL)
   EANYCODE_CHAR text[1];       // character data
 
   ETEXT_DESC() : count(0), progress(0), more_to_come(0), ocr_alive(0),
                    err_code(0), cancel(NULL), progress_callback(NULL),
-                   cancel_this(NULL), progress_this(NULL) {
+                   cancel_this(NULL), progress_this(NULL),
+                   line_callback(NULL), line_this(NULL),
+                   word_callback(NULL), word_this(NULL),
+                   words_out_of_time(0), timings(NULL) {
     end_time.tv_sec = 0;
     end_time.tv_usec = 0;
   }
@@ -0,0 +1,123 @@
+///////////////////////////////////////////////////////////////////////
+// File:        pagearena.cpp
+// Description: Arena for the many small objects of a recognized page.
+//
+// (C) Copyright 2016, Google Inc.
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////
+
+#include "pagearena.h"
+
+#include <stdlib.h>
+#ifndef _WIN32
+#include <pthread.h>
+#endif
+
+namespace tesseract {
+
+#ifndef _WIN32
+// Holds the current arena of each thread.
+static pthread_key_t current_arena_key;
+static pthread_once_t current_arena_once = PTHREAD_ONCE_INIT;
+
+static void CreateCurrentArenaKey() {
+  pthread_key_create(&current_arena_key, NULL);
+}
+#endif
+
+void PageArenaStats::Add(const PageArena& arena) {
+  ++pages;
+  objects += arena.num_objects();
+  last_bytes_used = arena.bytes_used();
+  last_bytes_reserved = arena.bytes_reserved();
+  if (last_bytes_reserved > peak_bytes_reserved)
+    peak_bytes_reserved = last_bytes_reserved;
+}
+
+PageArena::PageArena(PageArenaStats* stats)
+  : stats_(stats), next_(NULL), end_(NULL), num_objects_(0), bytes_used_(0),
+    bytes_reserved_(0) {}
+
+PageArena::~PageArena() {
+  if (stats_ != NULL) stats_->Add(*this);
+  for (int b = 0; b < blocks_.size(); ++b) free(blocks_[b]);
+}
+
+PageArena::Scope::Scope(PageArena* arena) : previous_(Current()) {
+  SetCurrent(arena);
+}
+
+PageArena::Scope::~Scope() {
+  SetCurrent(previous_);
+}
+
+void* PageArena::Alloc(size_t size) {
+  size = (size + kAlignment - 1) / kAlignment * kAlignment;
+  PageArena* arena = Current();
+  Header* header;
+  if (arena == NULL) {
+    header = static_cast<Header*>(malloc(kAlignment + size));
+  } else {
+    header = reinterpret_cast<Header*>(arena->Carve(kAlignment + size));
+    ++arena->num_objects_;
+    arena->bytes_used_ += kAlignment + size;
+  }
+  header->arena = arena;
+  return reinterpret_cast<char*>(header) + kAlignment;
+}
+
+void PageArena::Free(void* ptr) {
+  if (ptr == NULL) return;
+  Header* header =
+      reinterpret_cast<Header*>(static_cast<char*>(ptr) - kAlignment);
+  // Arena memory is only given back with the whole arena, so deleting an
+  // object never touches the arena, and may happen on any thread.
+  if (header->arena == NULL) free(header);
+}
+
+PageArena* PageArena::Current() {
+#ifndef _WIN32
+  pthread_once(&current_arena_once, &CreateCurrentArenaKey);
+  return static_cast<PageArena*>(pthread_getspecific(current_arena_key));
+#else
+  return NULL;
+#endif
+}
+
+void PageArena::SetCurrent(PageArena* arena) {
+#ifndef _WIN32
+  pthread_once(&current_arena_once, &CreateCurrentArenaKey);
+  pthread_setspecific(current_arena_key, arena);
+#endif
+}
+
+char* PageArena::Carve(size_t size) {
+  if (size > kBlockSize / 4) {
+    // Too big to share a block, so it gets one of its own and the free
+    // space of the last block is kept for later objects.
+    char* block = static_cast<char*>(malloc(size));
+    blocks_.push_back(block);
+    bytes_reserved_ += size;
+    return block;
+  }
+  if (static_cast<size_t>(end_ - next_) < size) {
+    next_ = static_cast<char*>(malloc(kBlockSize));
+    end_ = next_ + kBlockSize;
+    blocks_.push_back(next_);
+    bytes_reserved_ += kBlockSize;
+  }
+  char* result = next_;
+  next_ += size;
+  return result;
+}
+
+}  // namespace tesseract
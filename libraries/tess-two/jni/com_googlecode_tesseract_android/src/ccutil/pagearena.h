@@ -0,0 +1,125 @@
+///////////////////////////////////////////////////////////////////////
+// File:        pagearena.h
+// Description: Arena for the many small objects of a recognized page.
+//
+// (C) Copyright 2016, Google Inc.
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////
+
+#ifndef TESSERACT_CCUTIL_PAGEARENA_H_
+#define TESSERACT_CCUTIL_PAGEARENA_H_
+
+#include <stddef.h>
+#include "genericvector.h"
+#include "host.h"
+#include "platform.h"
+
+namespace tesseract {
+
+class PageArena;
+
+// Totals over the arenas of a sequence of pages, added to as each arena is
+// released.
+struct TESS_API PageArenaStats {
+  PageArenaStats()
+    : pages(0), objects(0), last_bytes_used(0), last_bytes_reserved(0),
+      peak_bytes_reserved(0) {}
+
+  void Add(const PageArena& arena);
+
+  // Number of page arenas released.
+  int pages;
+  // Number of objects allocated in them.
+  inT64 objects;
+  // Bytes given to objects, and taken from the heap, by the last page.
+  inT64 last_bytes_used;
+  inT64 last_bytes_reserved;
+  // The most bytes taken from the heap by any one page.
+  inT64 peak_bytes_reserved;
+};
+
+// Memory for the words, choices and blobs of one page. While an arena is
+// current on a thread, the classes derived from PageArenaAllocated that are
+// made on that thread are carved out of large blocks, and deleting them
+// does not free anything, so destroying a page only runs the destructors
+// and the blocks are then freed all at once with the arena. Objects made on
+// other threads, or with no current arena, get heap memory of their own as
+// usual, and the two kinds may be mixed freely in the same lists.
+// Every object allocated in an arena must be deleted before the arena is,
+// so objects that outlive the page must be made in a Scope with no arena.
+// Without pthreads there is never a current arena.
+class TESS_API PageArena {
+ public:
+  // If stats is not NULL, the totals of the arena are added to it when
+  // the arena is deleted.
+  explicit PageArena(PageArenaStats* stats);
+  ~PageArena();
+
+  // Makes arena, which may be NULL for the heap, the current arena of the
+  // calling thread until the end of the scope.
+  class Scope {
+   public:
+    explicit Scope(PageArena* arena);
+    ~Scope();
+
+   private:
+    PageArena* previous_;
+  };
+
+  // Returns memory for an object of the given size from the current arena,
+  // or the heap if there is none.
+  static void* Alloc(size_t size);
+  // Frees the memory of an object made by Alloc, if it is heap memory.
+  static void Free(void* ptr);
+
+  inT64 num_objects() const { return num_objects_; }
+  inT64 bytes_used() const { return bytes_used_; }
+  inT64 bytes_reserved() const { return bytes_reserved_; }
+
+ private:
+  // Objects and the header before each are aligned to this.
+  static const int kAlignment = 16;
+  // Size of the blocks taken from the heap. Larger objects get a block of
+  // their own.
+  static const int kBlockSize = 64 * 1024;
+
+  // Placed kAlignment bytes before each object.
+  struct Header {
+    // The arena that holds the object, or NULL for heap memory.
+    PageArena* arena;
+  };
+
+  // Returns the current arena of the calling thread, or NULL.
+  static PageArena* Current();
+  static void SetCurrent(PageArena* arena);
+  // Returns size bytes, a multiple of kAlignment, from the blocks.
+  char* Carve(size_t size);
+
+  PageArenaStats* stats_;
+  GenericVector<char*> blocks_;
+  // Free space left in the last block.
+  char* next_;
+  char* end_;
+  inT64 num_objects_;
+  inT64 bytes_used_;
+  inT64 bytes_reserved_;
+};
+
+// Base of the classes allocated from the current PageArena with plain new.
+struct PageArenaAllocated {
+  static void* operator new(size_t size) { return PageArena::Alloc(size); }
+  static void operator delete(void* ptr) { PageArena::Free(ptr); }
+};
+
+}  // namespace tesseract
+
+#endif  // TESSERACT_CCUTIL_PAGEARENA_H_
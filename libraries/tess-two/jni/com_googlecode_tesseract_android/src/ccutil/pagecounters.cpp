@@ -0,0 +1,116 @@
+///////////////////////////////////////////////////////////////////////
+// File:        pagecounters.cpp
+// Description: Counts of the hot-path work done to recognize a page.
+//
+// (C) Copyright 2016, Google Inc.
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////
+
+#include "pagecounters.h"
+
+#ifndef _WIN32
+#include <pthread.h>
+#endif
+#include "genericvector.h"
+
+namespace tesseract {
+
+static const char* const kCounterNames[COUNTER_COUNT] = {
+  "blobs_classified", "class_matches", "chops", "pain_points",
+  "dawg_lookups", "diacritics", "fast_blocks", "skipped_passes",
+  "superscript_tries", "superscript_fixes", "xheight_tries", "xheight_fixes"
+};
+
+#ifndef _WIN32
+// Holds the counts of each thread.
+static pthread_key_t thread_counts_key;
+static pthread_once_t thread_counts_once = PTHREAD_ONCE_INIT;
+// Guards the list of all the thread counts, and those of exited threads.
+static pthread_mutex_t thread_counts_mutex = PTHREAD_MUTEX_INITIALIZER;
+static GenericVector<PageCounts*>* all_thread_counts = NULL;
+static PageCounts* exited_thread_counts = NULL;
+
+// Keeps the counts of an exiting thread until the next Collect.
+static void ReleaseThreadCounts(void* arg) {
+  PageCounts* counts = static_cast<PageCounts*>(arg);
+  pthread_mutex_lock(&thread_counts_mutex);
+  exited_thread_counts->Add(*counts);
+  for (int i = 0; i < all_thread_counts->size(); ++i) {
+    if ((*all_thread_counts)[i] == counts) {
+      all_thread_counts->remove(i);
+      break;
+    }
+  }
+  pthread_mutex_unlock(&thread_counts_mutex);
+  delete counts;
+}
+
+static void CreateThreadCountsKey() {
+  pthread_key_create(&thread_counts_key, &ReleaseThreadCounts);
+  all_thread_counts = new GenericVector<PageCounts*>;
+  exited_thread_counts = new PageCounts;
+}
+
+static PageCounts* ThreadCounts() {
+  pthread_once(&thread_counts_once, &CreateThreadCountsKey);
+  PageCounts* counts =
+      static_cast<PageCounts*>(pthread_getspecific(thread_counts_key));
+  if (counts == NULL) {
+    counts = new PageCounts;
+    pthread_mutex_lock(&thread_counts_mutex);
+    all_thread_counts->push_back(counts);
+    pthread_mutex_unlock(&thread_counts_mutex);
+    pthread_setspecific(thread_counts_key, counts);
+  }
+  return counts;
+}
+#else
+// Without pthreads all the threads count into the same set.
+static PageCounts shared_counts;
+#endif
+
+void PageCounts::Count(PageCounter counter, int n) {
+#ifndef _WIN32
+  ThreadCounts()->counts[counter] += n;
+#else
+  shared_counts.counts[counter] += n;
+#endif
+}
+
+void PageCounts::Collect() {
+#ifndef _WIN32
+  pthread_once(&thread_counts_once, &CreateThreadCountsKey);
+  pthread_mutex_lock(&thread_counts_mutex);
+  for (int i = 0; i < all_thread_counts->size(); ++i) {
+    Add(*(*all_thread_counts)[i]);
+    (*all_thread_counts)[i]->Clear();
+  }
+  Add(*exited_thread_counts);
+  exited_thread_counts->Clear();
+  pthread_mutex_unlock(&thread_counts_mutex);
+#else
+  Add(shared_counts);
+  shared_counts.Clear();
+#endif
+}
+
+void PageCounts::ResetAll() {
+  PageCounts discarded;
+  discarded.Collect();
+}
+
+const char* PageCounts::Name(PageCounter counter) {
+  return counter >= 0 && counter < COUNTER_COUNT ? kCounterNames[counter]
+                                                 : "unknown";
+}
+
+}  // namespace tesseract
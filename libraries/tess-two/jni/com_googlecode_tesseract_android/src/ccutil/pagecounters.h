@@ -0,0 +1,72 @@
+///////////////////////////////////////////////////////////////////////
+// File:        pagecounters.h
+// Description: Counts of the hot-path work done to recognize a page.
+//
+// (C) Copyright 2016, Google Inc.
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////
+
+#ifndef TESSERACT_CCUTIL_PAGECOUNTERS_H_
+#define TESSERACT_CCUTIL_PAGECOUNTERS_H_
+
+#include "host.h"
+#include "platform.h"
+
+namespace tesseract {
+
+// The events counted, to tell a slow page from a fast one. Keep in step
+// with kCounterNames and the Java TessBaseAPI.PageCounters.
+enum PageCounter {
+  COUNTER_BLOBS_CLASSIFIED,  // Classify::AdaptiveClassifier.
+  COUNTER_CLASS_MATCHES,     // IntegerMatcher::Match.
+  COUNTER_CHOPS,             // Wordrec::attempt_blob_chop.
+  COUNTER_PAIN_POINTS,       // Wordrec::ProcessSegSearchPainPoint.
+  COUNTER_DAWG_LOOKUPS,      // Dict::def_letter_is_okay.
+  COUNTER_DIACRITICS,        // Noise outlines tried by ReassignDiacritics.
+  COUNTER_FAST_BLOCKS,       // Blocks confident after pass 1.
+  COUNTER_SKIPPED_PASSES,    // Passes after pass 1 skipped, once per block.
+  COUNTER_SUPERSCRIPT_TRIES,  // Words re-recognized by SubAndSuperscriptFix.
+  COUNTER_SUPERSCRIPT_FIXES,  // Those of them that were improved.
+  COUNTER_XHEIGHT_TRIES,     // Words re-recognized by TestNewNormalization.
+  COUNTER_XHEIGHT_FIXES,     // Those of them that were improved.
+  COUNTER_COUNT
+};
+
+// A set of counts. Each thread counts into a set of its own, without
+// locking, and Collect adds those of all the threads together at the end
+// of a page. The thread sets are shared by the whole process, so they only
+// describe one page when one page is recognized at a time.
+struct TESS_API PageCounts {
+  PageCounts() { Clear(); }
+
+  void Clear() {
+    for (int i = 0; i < COUNTER_COUNT; ++i) counts[i] = 0;
+  }
+  void Add(const PageCounts& other) {
+    for (int i = 0; i < COUNTER_COUNT; ++i) counts[i] += other.counts[i];
+  }
+
+  // Counts n events on the calling thread.
+  static void Count(PageCounter counter, int n = 1);
+  // Adds the counts of every thread to these, and zeros them.
+  void Collect();
+  // Zeros the counts of every thread, as a page starts.
+  static void ResetAll();
+  // Returns the short lower case name of the counter, for reports.
+  static const char* Name(PageCounter counter);
+
+  inT64 counts[COUNTER_COUNT];
+};
+
+}  // namespace tesseract
+
+#endif  // TESSERACT_CCUTIL_PAGECOUNTERS_H_
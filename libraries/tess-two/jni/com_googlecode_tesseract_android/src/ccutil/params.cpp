@@ -21,22 +21,103 @@
 #include          <string.h>
 #include          <stdlib.h>
 
+#include          "ccutil.h"
 #include          "genericvector.h"
 #include          "scanutils.h"
 #include          "tprintf.h"
 #include          "params.h"
+#include          "serialis.h"
 
 #define PLUS          '+'        //flag states
 #define MINUS         '-'
 #define EQUAL         '='
 
 tesseract::ParamsVectors *GlobalParams() {
-  static tesseract::ParamsVectors global_params = tesseract::ParamsVectors();
+  static tesseract::ParamsVectors global_params;
   return &global_params;
 }
 
 namespace tesseract {
 
+// Guards the building of indices, as GlobalParams() is shared by threads.
+static CCUtilMutex params_index_mutex;
+
+// Hash table from param names to the params of each type with that name,
+// using open addressing with linear probing.
+class ParamsIndex {
+ public:
+  explicit ParamsIndex(const ParamsVectors& vec) {
+    int num_params = vec.int_params.size() + vec.bool_params.size() +
+        vec.string_params.size() + vec.double_params.size();
+    int size = 16;
+    while (size < 2 * num_params) size *= 2;
+    Entry empty;
+    empty.name = NULL;
+    for (int t = 0; t < NUM_PARAM_TYPES; ++t) empty.params[t] = NULL;
+    table_.init_to_size(size, empty);
+    for (int i = 0; i < vec.int_params.size(); ++i)
+      Add(vec.int_params[i], INT_PARAM);
+    for (int i = 0; i < vec.bool_params.size(); ++i)
+      Add(vec.bool_params[i], BOOL_PARAM);
+    for (int i = 0; i < vec.string_params.size(); ++i)
+      Add(vec.string_params[i], STRING_PARAM);
+    for (int i = 0; i < vec.double_params.size(); ++i)
+      Add(vec.double_params[i], DOUBLE_PARAM);
+  }
+
+  Param* Lookup(const char* name, ParamType type) const {
+    return table_[FindSlot(name)].params[type];
+  }
+
+ private:
+  struct Entry {
+    // Name shared by the params, or NULL if the slot is empty.
+    const char* name;
+    Param* params[NUM_PARAM_TYPES];
+  };
+
+  // If there are two params with the same name and type, the first is kept,
+  // as the scan of the vectors would find it first.
+  void Add(Param* param, ParamType type) {
+    Entry& entry = table_[FindSlot(param->name_str())];
+    entry.name = param->name_str();
+    if (entry.params[type] == NULL) entry.params[type] = param;
+  }
+
+  // Returns the slot holding name, or the empty slot where it belongs.
+  int FindSlot(const char* name) const {
+    unsigned int hash = 2166136261u;
+    for (const char* c = name; *c != '\0'; ++c) {
+      hash ^= static_cast<unsigned char>(*c);
+      hash *= 16777619u;
+    }
+    int mask = table_.size() - 1;
+    int slot = hash & mask;
+    while (table_[slot].name != NULL && strcmp(table_[slot].name, name) != 0)
+      slot = (slot + 1) & mask;
+    return slot;
+  }
+
+  GenericVector<Entry> table_;
+};
+
+ParamsVectors::~ParamsVectors() {
+  delete index;
+}
+
+Param* ParamsVectors::Lookup(const char* name, ParamType type) const {
+  params_index_mutex.Lock();
+  if (index == NULL) index = new ParamsIndex(*this);
+  Param* param = index->Lookup(name, type);
+  params_index_mutex.Unlock();
+  return param;
+}
+
+void ParamsVectors::InvalidateIndex() {
+  delete index;
+  index = NULL;
+}
+
 bool ParamUtils::ReadParamsFile(const char *file,
                                 SetParamConstraint constraint,
                                 ParamsVectors *member_params) {
@@ -94,25 +175,43 @@ bool ParamUtils::ReadParamsFromFp(FILE *fp, inT64 end_offset,
   return anyerr;
 }
 
+int ParamUtils::SetParams(const char* const* name_values, int num_params,
+                          SetParamConstraint constraint,
+                          ParamsVectors *member_params) {
+  int num_found = 0;
+  for (int i = 0; i < num_params; ++i) {
+    if (SetParam(name_values[2 * i], name_values[2 * i + 1], constraint,
+                 member_params)) {
+      ++num_found;
+    }
+  }
+  return num_found;
+}
+
+Param *ParamUtils::FindParam(const char *name, ParamType type,
+                             const ParamsVectors *member_params) {
+  Param *param = GlobalParams()->Lookup(name, type);
+  if (param == NULL && member_params != NULL)
+    param = member_params->Lookup(name, type);
+  return param;
+}
+
 bool ParamUtils::SetParam(const char *name, const char* value,
                           SetParamConstraint constraint,
                           ParamsVectors *member_params) {
   // Look for the parameter among string parameters.
-  StringParam *sp = FindParam<StringParam>(name, GlobalParams()->string_params,
-                                           member_params->string_params);
+  StringParam *sp = FindParam<StringParam>(name, member_params);
   if (sp != NULL && sp->constraint_ok(constraint)) sp->set_value(value);
   if (*value == '\0') return (sp != NULL);
 
   // Look for the parameter among int parameters.
   int intval;
-  IntParam *ip = FindParam<IntParam>(name, GlobalParams()->int_params,
-                                     member_params->int_params);
+  IntParam *ip = FindParam<IntParam>(name, member_params);
   if (ip && ip->constraint_ok(constraint) &&
       sscanf(value, INT32FORMAT, &intval) == 1) ip->set_value(intval);
 
   // Look for the parameter among bool parameters.
-  BoolParam *bp = FindParam<BoolParam>(name, GlobalParams()->bool_params,
-                                       member_params->bool_params);
+  BoolParam *bp = FindParam<BoolParam>(name, member_params);
   if (bp != NULL && bp->constraint_ok(constraint)) {
     if (*value == 'T' || *value == 't' ||
         *value == 'Y' || *value == 'y' || *value == '1') {
@@ -125,8 +224,7 @@ bool ParamUtils::SetParam(const char *name, const char* value,
 
   // Look for the parameter among double parameters.
   double doubleval;
-  DoubleParam *dp = FindParam<DoubleParam>(name, GlobalParams()->double_params,
-                                           member_params->double_params);
+  DoubleParam *dp = FindParam<DoubleParam>(name, member_params);
   if (dp != NULL && dp->constraint_ok(constraint)) {
 #ifdef EMBEDDED
       doubleval = strtofloat(value);
@@ -142,15 +240,13 @@ bool ParamUtils::GetParamAsString(const char *name,
                                   const ParamsVectors* member_params,
                                   STRING *value) {
   // Look for the parameter among string parameters.
-  StringParam *sp = FindParam<StringParam>(name, GlobalParams()->string_params,
-                                           member_params->string_params);
+  StringParam *sp = FindParam<StringParam>(name, member_params);
   if (sp) {
     *value = sp->string();
     return true;
   }
   // Look for the parameter among int parameters.
-  IntParam *ip = FindParam<IntParam>(name, GlobalParams()->int_params,
-                                     member_params->int_params);
+  IntParam *ip = FindParam<IntParam>(name, member_params);
   if (ip) {
     char buf[128];
     snprintf(buf, sizeof(buf), "%d", inT32(*ip));
@@ -158,15 +254,13 @@ bool ParamUtils::GetParamAsString(const char *name,
     return true;
   }
   // Look for the parameter among bool parameters.
-  BoolParam *bp = FindParam<BoolParam>(name, GlobalParams()->bool_params,
-                                       member_params->bool_params);
+  BoolParam *bp = FindParam<BoolParam>(name, member_params);
   if (bp != NULL) {
     *value = BOOL8(*bp) ? "1": "0";
     return true;
   }
   // Look for the parameter among double parameters.
-  DoubleParam *dp = FindParam<DoubleParam>(name, GlobalParams()->double_params,
-                                           member_params->double_params);
+  DoubleParam *dp = FindParam<DoubleParam>(name, member_params);
   if (dp != NULL) {
     char buf[128];
     snprintf(buf, sizeof(buf), "%g", double(*dp));
@@ -176,6 +270,100 @@ bool ParamUtils::GetParamAsString(const char *name,
   return false;
 }
 
+// Identifies a serialization of params.
+static const inT32 kParamsSnapshotMagic = 0x50415231;  // "PAR1"
+
+// Writes the count of each type of param in vec, followed by the params.
+static bool SerializeParamsVectors(const ParamsVectors *vec, TFile *fp) {
+  inT32 count = vec->int_params.size();
+  if (fp->FWrite(&count, sizeof(count), 1) != 1) return false;
+  for (int i = 0; i < count; ++i) {
+    STRING name = vec->int_params[i]->name_str();
+    inT32 value = *vec->int_params[i];
+    if (!name.Serialize(fp) ||
+        fp->FWrite(&value, sizeof(value), 1) != 1) return false;
+  }
+  count = vec->bool_params.size();
+  if (fp->FWrite(&count, sizeof(count), 1) != 1) return false;
+  for (int i = 0; i < count; ++i) {
+    STRING name = vec->bool_params[i]->name_str();
+    inT8 value = BOOL8(*vec->bool_params[i]);
+    if (!name.Serialize(fp) ||
+        fp->FWrite(&value, sizeof(value), 1) != 1) return false;
+  }
+  count = vec->string_params.size();
+  if (fp->FWrite(&count, sizeof(count), 1) != 1) return false;
+  for (int i = 0; i < count; ++i) {
+    STRING name = vec->string_params[i]->name_str();
+    STRING value = vec->string_params[i]->string();
+    if (!name.Serialize(fp) || !value.Serialize(fp)) return false;
+  }
+  count = vec->double_params.size();
+  if (fp->FWrite(&count, sizeof(count), 1) != 1) return false;
+  for (int i = 0; i < count; ++i) {
+    STRING name = vec->double_params[i]->name_str();
+    double value = *vec->double_params[i];
+    if (!name.Serialize(fp) ||
+        fp->FWrite(&value, sizeof(value), 1) != 1) return false;
+  }
+  return true;
+}
+
+// Reads params written by SerializeParamsVectors into vec.
+static bool DeSerializeParamsVectors(TFile *fp, ParamsVectors *vec) {
+  STRING name;
+  inT32 count;
+  if (fp->FRead(&count, sizeof(count), 1) != 1) return false;
+  for (int i = 0; i < count; ++i) {
+    inT32 value;
+    if (!name.DeSerialize(false, fp) ||
+        fp->FRead(&value, sizeof(value), 1) != 1) return false;
+    Param *param = vec->Lookup(name.string(), INT_PARAM);
+    if (param != NULL) static_cast<IntParam *>(param)->set_value(value);
+  }
+  if (fp->FRead(&count, sizeof(count), 1) != 1) return false;
+  for (int i = 0; i < count; ++i) {
+    inT8 value;
+    if (!name.DeSerialize(false, fp) ||
+        fp->FRead(&value, sizeof(value), 1) != 1) return false;
+    Param *param = vec->Lookup(name.string(), BOOL_PARAM);
+    if (param != NULL) static_cast<BoolParam *>(param)->set_value(value != 0);
+  }
+  if (fp->FRead(&count, sizeof(count), 1) != 1) return false;
+  for (int i = 0; i < count; ++i) {
+    STRING value;
+    if (!name.DeSerialize(false, fp) || !value.DeSerialize(false, fp))
+      return false;
+    Param *param = vec->Lookup(name.string(), STRING_PARAM);
+    if (param != NULL) static_cast<StringParam *>(param)->set_value(value);
+  }
+  if (fp->FRead(&count, sizeof(count), 1) != 1) return false;
+  for (int i = 0; i < count; ++i) {
+    double value;
+    if (!name.DeSerialize(false, fp) ||
+        fp->FRead(&value, sizeof(value), 1) != 1) return false;
+    Param *param = vec->Lookup(name.string(), DOUBLE_PARAM);
+    if (param != NULL) static_cast<DoubleParam *>(param)->set_value(value);
+  }
+  return true;
+}
+
+bool ParamUtils::SerializeParams(const ParamsVectors *member_params,
+                                 TFile *fp) {
+  if (fp->FWrite(&kParamsSnapshotMagic, sizeof(kParamsSnapshotMagic), 1) != 1)
+    return false;
+  return SerializeParamsVectors(GlobalParams(), fp) &&
+         SerializeParamsVectors(member_params, fp);
+}
+
+bool ParamUtils::DeSerializeParams(TFile *fp, ParamsVectors *member_params) {
+  inT32 magic;
+  if (fp->FRead(&magic, sizeof(magic), 1) != 1 ||
+      magic != kParamsSnapshotMagic) return false;
+  return DeSerializeParamsVectors(fp, GlobalParams()) &&
+         DeSerializeParamsVectors(fp, member_params);
+}
+
 void ParamUtils::PrintParams(FILE *fp, const ParamsVectors *member_params) {
   int v, i;
   int num_iterations = (member_params == NULL) ? 1 : 2;
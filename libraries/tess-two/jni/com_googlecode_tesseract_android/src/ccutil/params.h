@@ -27,10 +27,21 @@
 
 namespace tesseract {
 
+class Param;
 class IntParam;
 class BoolParam;
 class StringParam;
 class DoubleParam;
+class ParamsIndex;
+
+// The types of parameter, each of which has its own vector in ParamsVectors.
+enum ParamType {
+  INT_PARAM,
+  BOOL_PARAM,
+  STRING_PARAM,
+  DOUBLE_PARAM,
+  NUM_PARAM_TYPES
+};
 
 // Enum for constraints on what kind of params should be set by SetParam().
 enum SetParamConstraint {
@@ -41,10 +52,27 @@ enum SetParamConstraint {
 };
 
 struct ParamsVectors {
+  ParamsVectors() : index(NULL) {}
+  ~ParamsVectors();
+
+  // Returns the param of the given type and name in these vectors, or NULL.
+  // The lookup is hashed, using an index that is built on the first call
+  // after any param was added or removed.
+  Param* Lookup(const char* name, ParamType type) const;
+  // Drops the index, which must be done whenever the vectors change.
+  void InvalidateIndex();
+
   GenericVector<IntParam *> int_params;
   GenericVector<BoolParam *> bool_params;
   GenericVector<StringParam *> string_params;
   GenericVector<DoubleParam *> double_params;
+
+ private:
+  // The params hold pointers to the vectors, so they can't be copied.
+  ParamsVectors(const ParamsVectors&);
+  void operator=(const ParamsVectors&);
+
+  mutable ParamsIndex* index;
 };
 
 // Utility functions for working with Tesseract parameters.
@@ -69,10 +97,25 @@ class ParamUtils {
   static bool SetParam(const char *name, const char* value,
                        SetParamConstraint constraint,
                        ParamsVectors *member_params);
+  // Sets num_params parameters from name_values, which holds each name
+  // followed by its value. Returns the number that were found.
+  static int SetParams(const char* const* name_values, int num_params,
+                       SetParamConstraint constraint,
+                       ParamsVectors *member_params);
+
+  // Returns the parameter of type T with the given name from GlobalParams()
+  // or else member_params, which may be NULL, using their hashed indices.
+  template<class T>
+  static T *FindParam(const char *name, const ParamsVectors *member_params) {
+    return static_cast<T *>(FindParam(name, T::kType, member_params));
+  }
+  static Param *FindParam(const char *name, ParamType type,
+                          const ParamsVectors *member_params);
 
   // Returns the pointer to the parameter with the given name (of the
   // appropriate type) if it was found in the vector obtained from
-  // GlobalParams() or in the given member_params.
+  // GlobalParams() or in the given member_params. This scans the vectors,
+  // so prefer the hashed version above.
   template<class T>
   static T *FindParam(const char *name,
                       const GenericVector<T *> &global_vec,
@@ -105,6 +148,17 @@ class ParamUtils {
   // Print parameters to the given file.
   static void PrintParams(FILE *fp, const ParamsVectors *member_params);
 
+  // Writes the names and values of all the params of GlobalParams() and
+  // member_params to fp, in the byte order of this machine, so that
+  // DeSerializeParams can restore them much faster than config files can
+  // be read. Returns false in case of error.
+  static bool SerializeParams(const ParamsVectors *member_params, TFile *fp);
+  // Sets the params of GlobalParams() and member_params to the values
+  // written by SerializeParams, ignoring constraints, as the values are
+  // the ones they had after an Init. Names that don't exist are skipped.
+  // Returns false if the data is not a snapshot of params.
+  static bool DeSerializeParams(TFile *fp, ParamsVectors *member_params);
+
   // Resets all parameters back to default values;
   static void ResetToDefaults(ParamsVectors* member_params);
 };
@@ -142,14 +196,20 @@ class Param {
 
 class IntParam : public Param {
   public:
+  static const ParamType kType = INT_PARAM;
+
    IntParam(inT32 value, const char *name, const char *comment, bool init,
             ParamsVectors *vec) : Param(name, comment, init) {
     value_ = value;
     default_ = value;
-    params_vec_ = &(vec->int_params);
+    params_vec_ = vec;
     vec->int_params.push_back(this);
+    vec->InvalidateIndex();
+  }
+  ~IntParam() {
+    ParamUtils::RemoveParam<IntParam>(this, &params_vec_->int_params);
+    params_vec_->InvalidateIndex();
   }
-  ~IntParam() { ParamUtils::RemoveParam<IntParam>(this, params_vec_); }
   operator inT32() const { return value_; }
   void operator=(inT32 value) { value_ = value; }
   void set_value(inT32 value) { value_ = value; }
@@ -160,20 +220,26 @@ class IntParam : public Param {
  private:
   inT32 value_;
   inT32 default_;
-  // Pointer to the vector that contains this param (not owened by this class).
-  GenericVector<IntParam *> *params_vec_;
+  // The vectors that contain this param (not owned by this class).
+  ParamsVectors *params_vec_;
 };
 
 class BoolParam : public Param {
  public:
+  static const ParamType kType = BOOL_PARAM;
+
   BoolParam(bool value, const char *name, const char *comment, bool init,
             ParamsVectors *vec) : Param(name, comment, init) {
     value_ = value;
     default_ = value;
-    params_vec_ = &(vec->bool_params);
+    params_vec_ = vec;
     vec->bool_params.push_back(this);
+    vec->InvalidateIndex();
+  }
+  ~BoolParam() {
+    ParamUtils::RemoveParam<BoolParam>(this, &params_vec_->bool_params);
+    params_vec_->InvalidateIndex();
   }
-  ~BoolParam() { ParamUtils::RemoveParam<BoolParam>(this, params_vec_); }
   operator BOOL8() const { return value_; }
   void operator=(BOOL8 value) { value_ = value; }
   void set_value(BOOL8 value) { value_ = value; }
@@ -184,21 +250,27 @@ class BoolParam : public Param {
  private:
   BOOL8 value_;
   BOOL8 default_;
-  // Pointer to the vector that contains this param (not owned by this class).
-  GenericVector<BoolParam *> *params_vec_;
+  // The vectors that contain this param (not owned by this class).
+  ParamsVectors *params_vec_;
 };
 
 class StringParam : public Param {
  public:
+  static const ParamType kType = STRING_PARAM;
+
   StringParam(const char *value, const char *name,
               const char *comment, bool init,
               ParamsVectors *vec) : Param(name, comment, init) {
     value_ = value;
     default_ = value;
-    params_vec_ = &(vec->string_params);
+    params_vec_ = vec;
     vec->string_params.push_back(this);
+    vec->InvalidateIndex();
+  }
+  ~StringParam() {
+    ParamUtils::RemoveParam<StringParam>(this, &params_vec_->string_params);
+    params_vec_->InvalidateIndex();
   }
-  ~StringParam() { ParamUtils::RemoveParam<StringParam>(this, params_vec_); }
   operator STRING &() { return value_; }
   const char *string() const { return value_.string(); }
   const char *c_str() const { return value_.string(); }
@@ -213,20 +285,26 @@ class StringParam : public Param {
  private:
   STRING value_;
   STRING default_;
-  // Pointer to the vector that contains this param (not owened by this class).
-  GenericVector<StringParam *> *params_vec_;
+  // The vectors that contain this param (not owned by this class).
+  ParamsVectors *params_vec_;
 };
 
 class DoubleParam : public Param {
  public:
+  static const ParamType kType = DOUBLE_PARAM;
+
   DoubleParam(double value, const char *name, const char *comment,
               bool init, ParamsVectors *vec) : Param(name, comment, init) {
     value_ = value;
     default_ = value;
-    params_vec_ = &(vec->double_params);
+    params_vec_ = vec;
     vec->double_params.push_back(this);
+    vec->InvalidateIndex();
+  }
+  ~DoubleParam() {
+    ParamUtils::RemoveParam<DoubleParam>(this, &params_vec_->double_params);
+    params_vec_->InvalidateIndex();
   }
-  ~DoubleParam() { ParamUtils::RemoveParam<DoubleParam>(this, params_vec_); }
   operator double() const { return value_; }
   void operator=(double value) { value_ = value; }
   void set_value(double value) { value_ = value; }
@@ -237,8 +315,8 @@ class DoubleParam : public Param {
  private:
   double value_;
   double default_;
-  // Pointer to the vector that contains this param (not owned by this class).
-  GenericVector<DoubleParam *> *params_vec_;
+  // The vectors that contain this param (not owned by this class).
+  ParamsVectors *params_vec_;
 };
 
 }  // namespace tesseract
@@ -51,6 +51,14 @@
 #define SIGNED signed
 #endif
 
+// Whether rvalue references are available, so classes can have move
+// constructors and move assignment.
+#if (__cplusplus >= 201103L) || (defined(_MSC_VER) && _MSC_VER >= 1600)
+#define TESS_HAS_MOVE 1
+#else
+#define TESS_HAS_MOVE 0
+#endif
+
 #if defined(_WIN32) || defined(__CYGWIN__)
 #ifndef M_PI
 #define M_PI 3.14159265358979323846
@@ -24,7 +24,8 @@
 namespace tesseract {
 
 TFile::TFile()
-    : offset_(0), data_(NULL), data_is_owned_(false), is_writing_(false) {
+    : offset_(0), data_(NULL), read_data_(NULL), read_size_(0),
+      data_is_owned_(false), is_writing_(false) {
 }
 
 TFile::~TFile() {
@@ -39,10 +40,10 @@ bool TFile::Open(const STRING& filename, FileReader reader) {
   }
   offset_ = 0;
   is_writing_ = false;
-  if (reader == NULL)
-    return LoadDataFromFile(filename, data_);
-  else
-    return (*reader)(filename, data_);
+  bool result = reader == NULL ? LoadDataFromFile(filename, data_)
+                               : (*reader)(filename, data_);
+  SetReadData();
+  return result;
 }
 
 bool TFile::Open(const char* data, int size) {
@@ -54,6 +55,15 @@ bool TFile::Open(const char* data, int size) {
   is_writing_ = false;
   data_->init_to_size(size, 0);
   memcpy(&(*data_)[0], data, size);
+  SetReadData();
+  return true;
+}
+
+bool TFile::OpenNoCopy(const char* data, int size) {
+  offset_ = 0;
+  is_writing_ = false;
+  read_data_ = data;
+  read_size_ = size;
   return true;
 }
 
@@ -74,15 +84,16 @@ bool TFile::Open(FILE* fp, inT64 end_offset) {
     data_is_owned_ = true;
   }
   data_->init_to_size(size, 0);
+  SetReadData();
   return static_cast<int>(fread(&(*data_)[0], 1, size, fp)) == size;
 }
 
 char* TFile::FGets(char* buffer, int buffer_size) {
   ASSERT_HOST(!is_writing_);
   int size = 0;
-  while (size + 1 < buffer_size && offset_ < data_->size()) {
-    buffer[size++] = (*data_)[offset_++];
-    if ((*data_)[offset_ - 1] == '\n') break;
+  while (size + 1 < buffer_size && offset_ < read_size_) {
+    buffer[size++] = read_data_[offset_++];
+    if (read_data_[offset_ - 1] == '\n') break;
   }
   if (size < buffer_size) buffer[size] = '\0';
   return size > 0 ? buffer : NULL;
@@ -93,10 +104,10 @@ int TFile::FRead(void* buffer, int size, int count) {
   int required_size = size * count;
   if (required_size <= 0) return 0;
   char* char_buffer = reinterpret_cast<char*>(buffer);
-  if (data_->size() - offset_ < required_size)
-    required_size = data_->size() - offset_;
+  if (read_size_ - offset_ < required_size)
+    required_size = read_size_ - offset_;
   if (required_size > 0 && char_buffer != NULL)
-    memcpy(char_buffer, &(*data_)[offset_], required_size);
+    memcpy(char_buffer, read_data_ + offset_, required_size);
   offset_ += required_size;
   return required_size / size;
 }
@@ -120,6 +131,11 @@ void TFile::OpenWrite(GenericVector<char>* data) {
   data_->truncate(0);
 }
 
+void TFile::SetReadData() {
+  read_data_ = data_->empty() ? NULL : &(*data_)[0];
+  read_size_ = data_->size();
+}
+
 bool TFile::CloseWrite(const STRING& filename, FileWriter writer) {
   ASSERT_HOST(is_writing_);
   if (writer == NULL)
@@ -61,6 +61,9 @@ class TFile {
   bool Open(const char* data, int size);
   // From an open file and an end offset.
   bool Open(FILE* fp, inT64 end_offset);
+  // From an existing memory buffer that is read in place instead of being
+  // copied, such as a memory-mapped file, so it must outlive the reading.
+  bool OpenNoCopy(const char* data, int size);
 
   // Reads a line like fgets. Returns NULL on EOF, otherwise buffer.
   // Reads at most buffer_size bytes, including '\0' terminator, even if
@@ -72,6 +75,8 @@ class TFile {
   // Resets the TFile as if it has been Opened, but nothing read.
   // Only allowed while reading!
   void Rewind();
+  // Returns the number of bytes read so far. Only allowed while reading!
+  int Tell() const { return offset_; }
 
   // Open for writing. Either supply a non-NULL data with OpenWrite before
   // calling FWrite, (no close required), or supply a NULL data to OpenWrite
@@ -84,10 +89,17 @@ class TFile {
   int FWrite(const void* buffer, int size, int count);
 
  private:
+  // Points the reading at the contents of data_.
+  void SetReadData();
+
   // The number of bytes used so far.
   int offset_;
   // The buffered data from the file.
   GenericVector<char>* data_;
+  // The data being read, either in data_ or in a buffer given to
+  // OpenNoCopy, and its size.
+  const char* read_data_;
+  int read_size_;
   // True if the data_ pointer is owned by *this.
   bool data_is_owned_;
   // True if the TFile is open for writing.
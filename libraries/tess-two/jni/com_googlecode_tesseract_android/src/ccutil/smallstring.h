@@ -0,0 +1,114 @@
+///////////////////////////////////////////////////////////////////////
+// File:        smallstring.h
+// Description: String that keeps short contents inside itself.
+//
+// (C) Copyright 2016, Google Inc.
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////
+
+#ifndef TESSERACT_CCUTIL_SMALLSTRING_H_
+#define TESSERACT_CCUTIL_SMALLSTRING_H_
+
+#include <string.h>
+#include "host.h"
+
+namespace tesseract {
+
+// A small subset of STRING for the short strings that are made for every
+// classifier choice, such as the context of the character ngram model.
+// Strings of less than N bytes are held inside the object, so making and
+// deleting them never touches the heap. Longer strings move to the heap.
+template <int N>
+class SmallString {
+ public:
+  SmallString() : data_(inline_), length_(0), capacity_(N) {
+    inline_[0] = '\0';
+  }
+  explicit SmallString(const char* str)
+    : data_(inline_), length_(0), capacity_(N) {
+    inline_[0] = '\0';
+    *this += str;
+  }
+  SmallString(const SmallString& other)
+    : data_(inline_), length_(0), capacity_(N) {
+    inline_[0] = '\0';
+    *this += other.data_;
+  }
+  ~SmallString() {
+    if (data_ != inline_) delete[] data_;
+  }
+
+  SmallString& operator=(const SmallString& other) {
+    if (&other != this) {
+      truncate_at(0);
+      *this += other.data_;
+    }
+    return *this;
+  }
+  SmallString& operator=(const char* str) {
+    // str may point into this string.
+    SmallString copy(str);
+    truncate_at(0);
+    *this += copy.data_;
+    return *this;
+  }
+
+  // str must not point into this string.
+  SmallString& operator+=(const char* str) {
+    if (str == NULL) return *this;
+    inT32 len = strlen(str);
+    Reserve(length_ + len + 1);
+    memcpy(data_ + length_, str, len + 1);
+    length_ += len;
+    return *this;
+  }
+  SmallString& operator+=(char ch) {
+    if (ch == '\0') return *this;
+    Reserve(length_ + 2);
+    data_[length_++] = ch;
+    data_[length_] = '\0';
+    return *this;
+  }
+
+  // Shortens the string to index bytes.
+  void truncate_at(inT32 index) {
+    if (index < length_) {
+      length_ = index;
+      data_[length_] = '\0';
+    }
+  }
+
+  inT32 length() const { return length_; }
+  const char* string() const { return data_; }
+  const char* c_str() const { return data_; }
+
+ private:
+  // Makes room for capacity bytes, including the terminating '\0'.
+  void Reserve(inT32 capacity) {
+    if (capacity <= capacity_) return;
+    if (capacity < 2 * capacity_) capacity = 2 * capacity_;
+    char* new_data = new char[capacity];
+    memcpy(new_data, data_, length_ + 1);
+    if (data_ != inline_) delete[] data_;
+    data_ = new_data;
+    capacity_ = capacity;
+  }
+
+  char* data_;
+  inT32 length_;
+  inT32 capacity_;
+  char inline_[N];
+};
+
+}  // namespace tesseract
+
+#endif  // TESSERACT_CCUTIL_SMALLSTRING_H_
@@ -0,0 +1,44 @@
+///////////////////////////////////////////////////////////////////////
+// File:        stagetimer.cpp
+// Description: Wall-clock time spent in each stage of recognizing a page.
+//
+// (C) Copyright 2016, Google Inc.
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////
+
+#include "stagetimer.h"
+
+#ifdef _WIN32
+#include "gettimeofday.h"
+#else
+#include <sys/time.h>
+#endif
+#include <stddef.h>
+
+namespace tesseract {
+
+static const char* const kStageNames[STAGE_COUNT] = {
+  "threshold", "layout", "textord", "pass1", "pass2", "adaption", "cube",
+  "fix_spaces", "rendering"
+};
+
+const char* StageTimings::Name(PageStage stage) {
+  return stage >= 0 && stage < STAGE_COUNT ? kStageNames[stage] : "unknown";
+}
+
+double StageTimings::NowMillis() {
+  struct timeval now;
+  gettimeofday(&now, NULL);
+  return now.tv_sec * 1000.0 + now.tv_usec / 1000.0;
+}
+
+}  // namespace tesseract
@@ -0,0 +1,82 @@
+///////////////////////////////////////////////////////////////////////
+// File:        stagetimer.h
+// Description: Wall-clock time spent in each stage of recognizing a page.
+//
+// (C) Copyright 2016, Google Inc.
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////
+
+#ifndef TESSERACT_CCUTIL_STAGETIMER_H_
+#define TESSERACT_CCUTIL_STAGETIMER_H_
+
+#include "platform.h"
+
+namespace tesseract {
+
+// The timed stages of a page. Adaption and cube run inside the recognition
+// passes, so their time is also part of STAGE_PASS1 and STAGE_PASS2.
+// Keep in step with kStageNames and the Java TessBaseAPI.StageTimings.
+enum PageStage {
+  STAGE_THRESHOLD,   // TessBaseAPI::Threshold.
+  STAGE_LAYOUT,      // Tesseract::AutoPageSeg, or its reduced variant.
+  STAGE_TEXTORD,     // Textord::TextordPage.
+  STAGE_PASS1,       // The first recognition pass.
+  STAGE_PASS2,       // The second, adapted, recognition pass.
+  STAGE_ADAPTION,    // Training the adaptive classifier on pass 1 words.
+  STAGE_CUBE,        // Cube recognition and the cube combiner.
+  STAGE_FIX_SPACES,  // Tesseract::fix_fuzzy_spaces.
+  STAGE_RENDERING,   // TessResultRenderer::AddImage.
+  STAGE_COUNT
+};
+
+// Milliseconds spent in each stage of the current page. Cleared with the
+// page, and added to as the stages run.
+struct TESS_API StageTimings {
+  StageTimings() { Clear(); }
+
+  void Clear() {
+    for (int i = 0; i < STAGE_COUNT; ++i) msecs[i] = 0.0;
+  }
+  // Adds the times of other, as when gathering those of the sub-languages.
+  void Add(const StageTimings& other) {
+    for (int i = 0; i < STAGE_COUNT; ++i) msecs[i] += other.msecs[i];
+  }
+
+  // Returns the short lower case name of the stage, for reports.
+  static const char* Name(PageStage stage);
+  // Returns the wall-clock time in milliseconds.
+  static double NowMillis();
+
+  double msecs[STAGE_COUNT];
+};
+
+// Adds the time from its construction to its destruction to one stage of
+// timings, which may be NULL to time nothing.
+class StageTimer {
+ public:
+  StageTimer(StageTimings* timings, PageStage stage)
+    : timings_(timings), stage_(stage),
+      start_(timings != NULL ? StageTimings::NowMillis() : 0.0) {}
+  ~StageTimer() {
+    if (timings_ != NULL)
+      timings_->msecs[stage_] += StageTimings::NowMillis() - start_;
+  }
+
+ private:
+  StageTimings* timings_;
+  PageStage stage_;
+  double start_;
+};
+
+}  // namespace tesseract
+
+#endif  // TESSERACT_CCUTIL_STAGETIMER_H_
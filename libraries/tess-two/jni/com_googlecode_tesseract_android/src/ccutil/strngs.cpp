@@ -139,6 +139,15 @@ STRING::STRING(const char *data, int length) {
   }
 }
 
+#if TESS_HAS_MOVE
+STRING::STRING(STRING&& str) {
+  data_ = str.data_;
+  // str still needs a buffer of its own, but only the smallest one.
+  memcpy(str.AllocData(1, kMinCapacity), "", 1);
+  assert(InvariantOk());
+}
+#endif
+
 STRING::~STRING() {
   DiscardData();
 }
@@ -358,6 +367,15 @@ STRING& STRING::operator=(const STRING& str) {
   return *this;
 }
 
+#if TESS_HAS_MOVE
+STRING& STRING::operator=(STRING&& str) {
+  STRING_HEADER* this_data = data_;
+  data_ = str.data_;
+  str.data_ = this_data;
+  return *this;
+}
+#endif
+
 STRING & STRING::operator+=(const STRING& str) {
   FixHeader();
   str.FixHeader();
@@ -48,6 +48,10 @@ class TESS_API STRING
     STRING(const STRING &string);
     STRING(const char *string);
     STRING(const char *data, int length);
+#if TESS_HAS_MOVE
+    // Takes the buffer of string, leaving it empty.
+    STRING(STRING &&string);
+#endif
     ~STRING ();
 
     // Writes to the given file. Returns false in case of error.
@@ -91,6 +95,10 @@ class TESS_API STRING
 
     STRING & operator= (const char *string);
     STRING & operator= (const STRING & string);
+#if TESS_HAS_MOVE
+    // Swaps buffers with string, which is left with the old contents.
+    STRING & operator= (STRING && string);
+#endif
 
     STRING operator+ (const STRING & string) const;
     STRING operator+ (const char ch) const;
@@ -0,0 +1,238 @@
+///////////////////////////////////////////////////////////////////////
+// File:        taskscheduler.cpp
+// Description: Process-wide worker threads shared by the loops of all the
+//              thread pools, and by any other parallel work.
+//
+// (C) Copyright 2017, Google Inc.
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////
+
+#include "taskscheduler.h"
+
+#include <stdio.h>
+#ifdef __linux__
+#include <sched.h>
+#endif
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+#include "tprintf.h"
+
+namespace tesseract {
+
+// A loop of ParallelFor. next_index is the next iteration to hand out, and
+// helpers the number of workers running iterations of it.
+struct TaskScheduler::Job {
+  Job(TessCallback1<int>* f, int c, int max_helpers)
+    : func(f), count(c), next_index(0), max_helpers(max_helpers),
+      helpers(0) {}
+
+  TessCallback1<int>* func;
+  int count;
+  int next_index;
+  int max_helpers;
+  int helpers;
+};
+
+#ifndef _WIN32
+// Guards the scheduler of the process and its settings.
+static pthread_mutex_t scheduler_mutex = PTHREAD_MUTEX_INITIALIZER;
+#endif
+static TaskScheduler* scheduler = NULL;
+static int configured_workers = -1;
+static bool configured_big_cores_only = false;
+
+// Sets *cores to the cores with the highest maximum frequency, unless that
+// is all of them or the frequencies are unknown, in which case it is empty.
+static void FindBigCores(GenericVector<int>* cores) {
+  cores->truncate(0);
+#ifdef __linux__
+  int num_cores = sysconf(_SC_NPROCESSORS_CONF);
+  GenericVector<long> max_freqs;
+  long top_freq = 0;
+  for (int c = 0; c < num_cores; ++c) {
+    char path[80];
+    snprintf(path, sizeof(path),
+             "/sys/devices/system/cpu/cpu%d/cpufreq/cpuinfo_max_freq", c);
+    long freq = 0;
+    FILE* fp = fopen(path, "r");
+    if (fp != NULL) {
+      if (fscanf(fp, "%ld", &freq) != 1) freq = 0;
+      fclose(fp);
+    }
+    max_freqs.push_back(freq);
+    if (freq > top_freq) top_freq = freq;
+  }
+  for (int c = 0; c < num_cores; ++c) {
+    if (max_freqs[c] == top_freq) cores->push_back(c);
+  }
+  if (top_freq == 0 || cores->size() == num_cores) cores->truncate(0);
+#endif
+}
+
+TaskScheduler* TaskScheduler::Get() {
+#ifndef _WIN32
+  pthread_mutex_lock(&scheduler_mutex);
+#endif
+  if (scheduler == NULL)
+    scheduler = new TaskScheduler(configured_workers,
+                                  configured_big_cores_only);
+#ifndef _WIN32
+  pthread_mutex_unlock(&scheduler_mutex);
+#endif
+  return scheduler;
+}
+
+void TaskScheduler::Configure(int num_workers, bool big_cores_only) {
+#ifndef _WIN32
+  pthread_mutex_lock(&scheduler_mutex);
+#endif
+  configured_workers = num_workers;
+  configured_big_cores_only = big_cores_only;
+  delete scheduler;
+  scheduler = NULL;
+#ifndef _WIN32
+  pthread_mutex_unlock(&scheduler_mutex);
+#endif
+}
+
+TaskScheduler::TaskScheduler(int num_workers, bool big_cores_only)
+  : shutdown_(false) {
+#ifndef _WIN32
+  if (big_cores_only) FindBigCores(&cores_);
+  if (num_workers < 0) {
+    int num_cores = cores_.empty() ? sysconf(_SC_NPROCESSORS_ONLN)
+                                   : cores_.size();
+    num_workers = num_cores - 1;
+  }
+  pthread_mutex_init(&mutex_, NULL);
+  pthread_cond_init(&work_cond_, NULL);
+  pthread_cond_init(&done_cond_, NULL);
+  for (int t = 0; t < num_workers; ++t) {
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, &TaskScheduler::WorkerEntry,
+                       this) != 0) {
+      tprintf("Warning: could only start %d of %d workers\n", t, num_workers);
+      break;
+    }
+    workers_.push_back(thread);
+  }
+#endif
+}
+
+TaskScheduler::~TaskScheduler() {
+#ifndef _WIN32
+  pthread_mutex_lock(&mutex_);
+  shutdown_ = true;
+  pthread_cond_broadcast(&work_cond_);
+  pthread_mutex_unlock(&mutex_);
+  for (int t = 0; t < workers_.size(); ++t)
+    pthread_join(workers_[t], NULL);
+  pthread_cond_destroy(&done_cond_);
+  pthread_cond_destroy(&work_cond_);
+  pthread_mutex_destroy(&mutex_);
+#endif
+}
+
+void TaskScheduler::ParallelFor(int count, int max_threads,
+                                TessCallback1<int>* func,
+                                TessResultCallback<bool>* cancel) {
+  if (count <= 0) return;
+  Job job(func, count, MIN(max_threads, count) - 1);
+  if (job.max_helpers <= 0 || workers_.empty()) {
+    RunJob(&job, cancel);
+    return;
+  }
+#ifndef _WIN32
+  pthread_mutex_lock(&mutex_);
+  jobs_.push_back(&job);
+  pthread_cond_broadcast(&work_cond_);
+  pthread_mutex_unlock(&mutex_);
+  RunJob(&job, cancel);
+  pthread_mutex_lock(&mutex_);
+  while (job.helpers > 0)
+    pthread_cond_wait(&done_cond_, &mutex_);
+  for (int j = 0; j < jobs_.size(); ++j) {
+    if (jobs_[j] == &job) {
+      jobs_.remove(j);
+      break;
+    }
+  }
+  pthread_mutex_unlock(&mutex_);
+#endif
+}
+
+void TaskScheduler::RunJob(Job* job, TessResultCallback<bool>* cancel) {
+  for (;;) {
+    bool cancelled = cancel != NULL && cancel->Run();
+#ifndef _WIN32
+    pthread_mutex_lock(&mutex_);
+#endif
+    // Once cancelled, the workers find no more iterations either.
+    if (cancelled) job->next_index = job->count;
+    int index = job->next_index < job->count ? job->next_index++ : -1;
+#ifndef _WIN32
+    pthread_mutex_unlock(&mutex_);
+#endif
+    if (index < 0) break;
+    job->func->Run(index);
+  }
+}
+
+#ifndef _WIN32
+void* TaskScheduler::WorkerEntry(void* scheduler) {
+  TaskScheduler* self = static_cast<TaskScheduler*>(scheduler);
+#ifdef __linux__
+  if (!self->cores_.empty()) {
+    cpu_set_t cores;
+    CPU_ZERO(&cores);
+    for (int c = 0; c < self->cores_.size(); ++c)
+      CPU_SET(self->cores_[c], &cores);
+    // Pid 0 is the calling thread.
+    sched_setaffinity(0, sizeof(cores), &cores);
+  }
+#endif
+  self->WorkerLoop();
+  return NULL;
+}
+
+TaskScheduler::Job* TaskScheduler::JobToJoin() const {
+  Job* best = NULL;
+  for (int j = 0; j < jobs_.size(); ++j) {
+    Job* job = jobs_[j];
+    if (job->next_index < job->count && job->helpers < job->max_helpers &&
+        (best == NULL || job->helpers < best->helpers))
+      best = job;
+  }
+  return best;
+}
+
+void TaskScheduler::WorkerLoop() {
+  pthread_mutex_lock(&mutex_);
+  for (;;) {
+    Job* job = NULL;
+    while (!shutdown_ && (job = JobToJoin()) == NULL)
+      pthread_cond_wait(&work_cond_, &mutex_);
+    if (shutdown_) break;
+    ++job->helpers;
+    pthread_mutex_unlock(&mutex_);
+    RunJob(job, NULL);
+    pthread_mutex_lock(&mutex_);
+    if (--job->helpers == 0)
+      pthread_cond_broadcast(&done_cond_);
+  }
+  pthread_mutex_unlock(&mutex_);
+}
+#endif
+
+}  // namespace tesseract
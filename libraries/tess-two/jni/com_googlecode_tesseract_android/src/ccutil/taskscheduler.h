@@ -0,0 +1,95 @@
+///////////////////////////////////////////////////////////////////////
+// File:        taskscheduler.h
+// Description: Process-wide worker threads shared by the loops of all the
+//              thread pools, and by any other parallel work.
+//
+// (C) Copyright 2017, Google Inc.
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////
+
+#ifndef TESSERACT_CCUTIL_TASKSCHEDULER_H_
+#define TESSERACT_CCUTIL_TASKSCHEDULER_H_
+
+#ifndef _WIN32
+#include <pthread.h>
+#endif
+
+#include "genericvector.h"
+#include "platform.h"
+#include "tesscallback.h"
+
+namespace tesseract {
+
+// One set of worker threads for the whole process, so that any number of
+// engines, each with its own thread pool, don't start more threads than
+// there are cores. Any number of threads may run loops on it at once. The
+// caller of a loop always runs iterations of it, and each idle worker joins
+// the loop with the fewest workers that still has iterations left, so a
+// loop never waits for another to finish, and loops may nest. On platforms
+// without pthreads there are no workers and the loops run serially.
+class TESS_API TaskScheduler {
+ public:
+  // Returns the scheduler, starting its workers on first use.
+  static TaskScheduler* Get();
+  // Sets the number of worker threads, or if num_workers is negative, one
+  // less than the number of cores, and whether they only run on the fastest
+  // cores of CPUs that have cores of different speeds (big.LITTLE), where
+  // the number of cores counts only those. Stops the workers of the current
+  // scheduler, if any, so it must not be called while any loop runs.
+  static void Configure(int num_workers, bool big_cores_only);
+
+  int num_workers() const { return workers_.size(); }
+
+  // Calls func->Run(i) for every i in [0, count), on the calling thread and
+  // at most max_threads - 1 workers, and returns when all the calls that
+  // started have completed. The order of the calls is not defined, so each
+  // iteration must only write state that belongs to its own index. If cancel
+  // is not NULL, the calling thread runs it before each of its iterations,
+  // and once it returns true no more iterations start. Does not take
+  // ownership of func or cancel.
+  void ParallelFor(int count, int max_threads, TessCallback1<int>* func,
+                   TessResultCallback<bool>* cancel);
+
+ private:
+  struct Job;
+
+  TaskScheduler(int num_workers, bool big_cores_only);
+  ~TaskScheduler();
+
+  // Runs iterations of job until none are left, or cancel returns true.
+  void RunJob(Job* job, TessResultCallback<bool>* cancel);
+#ifndef _WIN32
+  static void* WorkerEntry(void* scheduler);
+  void WorkerLoop();
+  // Returns the job that an idle worker should join, or NULL for none.
+  // Requires mutex_.
+  Job* JobToJoin() const;
+
+  pthread_mutex_t mutex_;
+  // Signalled when a new job is posted or the scheduler is shutting down.
+  pthread_cond_t work_cond_;
+  // Signalled when the last worker leaves a job.
+  pthread_cond_t done_cond_;
+  GenericVector<pthread_t> workers_;
+#else
+  GenericVector<int> workers_;
+#endif
+  // The jobs that are running.
+  GenericVector<Job*> jobs_;
+  // The cores that the workers run on, or empty for any core.
+  GenericVector<int> cores_;
+  bool shutdown_;
+};
+
+}  // namespace tesseract
+
+#endif  // TESSERACT_CCUTIL_TASKSCHEDULER_H_
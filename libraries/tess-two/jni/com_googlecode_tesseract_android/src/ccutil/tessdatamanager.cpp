@@ -24,7 +24,14 @@
 #include "tessdatamanager.h"
 
 #include <stdio.h>
+#include <string.h>
+#ifndef _WIN32
+#include <unistd.h>
+#endif
 
+#include "allheaders.h"
+#include "ccutil.h"
+#include "genericvector.h"
 #include "helpers.h"
 #include "serialis.h"
 #include "strngs.h"
@@ -33,17 +40,84 @@
 
 namespace tesseract {
 
+// A data file name registered with RegisterFileDescriptor.
+struct RegisteredDataFile {
+  STRING name;
+  int fd;
+  inT64 start;
+  inT64 length;
+};
+
+static CCUtilMutex registered_files_mutex;
+static GenericVector<RegisteredDataFile> registered_files;
+
+bool TessdataManager::RegisterFileDescriptor(const char *data_file_name,
+                                             int fd, inT64 start,
+                                             inT64 length) {
+#ifdef _WIN32
+  return false;
+#else
+  int own_fd = dup(fd);
+  if (own_fd < 0) return false;
+  registered_files_mutex.Lock();
+  int i = 0;
+  while (i < registered_files.size() &&
+         registered_files[i].name != data_file_name) {
+    ++i;
+  }
+  if (i == registered_files.size()) {
+    registered_files.push_back(RegisteredDataFile());
+    registered_files.back().name = data_file_name;
+  } else {
+    close(registered_files[i].fd);
+  }
+  registered_files[i].fd = own_fd;
+  registered_files[i].start = start;
+  registered_files[i].length = length;
+  registered_files_mutex.Unlock();
+  return true;
+#endif
+}
+
 bool TessdataManager::Init(const char *data_file_name, int debug_level) {
   int i;
+  CloseComponent();
   debug_level_ = debug_level;
   data_file_name_ = data_file_name;
-  data_file_ = fopen(data_file_name, "rb");
+  data_file_ = NULL;
+  data_end_ = -1;
+  has_end_table_ = false;
+  inT64 data_start = 0;
+#ifndef _WIN32
+  registered_files_mutex.Lock();
+  for (i = 0; i < registered_files.size(); ++i) {
+    const RegisteredDataFile &file = registered_files[i];
+    if (file.name == data_file_name) {
+      int fd = dup(file.fd);
+      if (fd >= 0) {
+        data_file_ = fdopen(fd, "rb");
+        if (data_file_ == NULL) close(fd);
+      }
+      data_start = file.start;
+      data_end_ = file.start + file.length - 1;
+      break;
+    }
+  }
+  registered_files_mutex.Unlock();
+  if (i == registered_files.size())
+#endif
+    data_file_ = fopen(data_file_name, "rb");
   if (data_file_ == NULL) {
     tprintf("Error opening data file %s\n", data_file_name);
     tprintf("Please make sure the TESSDATA_PREFIX environment variable is set "
             "to the parent directory of your \"tessdata\" directory.\n");
     return false;
   }
+  if (data_start > 0 && fseek(data_file_, data_start, SEEK_SET) != 0) {
+    tprintf("Error seeking to the start of data file %s\n", data_file_name);
+    End();
+    return false;
+  }
   fread(&actual_tessdata_num_entries_, sizeof(inT32), 1, data_file_);
   swap_ = (actual_tessdata_num_entries_ > kMaxNumTessdataEntries);
   if (swap_) {
@@ -61,6 +135,12 @@ bool TessdataManager::Init(const char *data_file_name, int debug_level) {
       ReverseN(&offset_table_[i], sizeof(offset_table_[i]));
     }
   }
+  if (data_start > 0) {
+    for (i = 0 ; i < actual_tessdata_num_entries_; ++i) {
+      if (offset_table_[i] >= 0) offset_table_[i] += data_start;
+    }
+  }
+  ReadEndTable(data_start);
   if (debug_level_) {
     tprintf("TessdataManager loaded %d types of tesseract data files.\n",
             actual_tessdata_num_entries_);
@@ -71,6 +151,175 @@ bool TessdataManager::Init(const char *data_file_name, int debug_level) {
   return true;
 }
 
+bool TessdataManager::ReadEndTable(inT64 data_start) {
+  inT64 tail = data_end_ + 1;
+  if (data_end_ < 0) {
+    if (fseek(data_file_, 0, SEEK_END) != 0) return false;
+    tail = ftell(data_file_);
+  }
+  inT32 num_entries = 0;
+  char magic[kTessdataTableMagicLength];
+  inT64 footer = tail - sizeof(num_entries) - sizeof(magic);
+  if (footer < data_start || fseek(data_file_, footer, SEEK_SET) != 0 ||
+      fread(&num_entries, sizeof(num_entries), 1, data_file_) != 1 ||
+      fread(magic, sizeof(magic), 1, data_file_) != 1 ||
+      memcmp(magic, kTessdataTableMagic, sizeof(magic)) != 0) {
+    return false;
+  }
+  if (swap_) ReverseN(&num_entries, sizeof(num_entries));
+  if (num_entries <= 0 || num_entries > kMaxNumTessdataEntries) return false;
+  GenericVector<inT64> table;
+  table.init_to_size(2 * num_entries, -1);
+  inT64 table_start = footer - sizeof(inT64) * table.size();
+  if (table_start < data_start || fseek(data_file_, table_start, SEEK_SET) ||
+      static_cast<int>(fread(&table[0], sizeof(inT64), table.size(),
+                             data_file_)) != table.size()) {
+    return false;
+  }
+  // For forward compatibility, truncate to the number we can handle.
+  actual_tessdata_num_entries_ = MIN(num_entries, TESSDATA_NUM_ENTRIES);
+  for (int i = 0; i < actual_tessdata_num_entries_; ++i) {
+    offset_table_[i] = table[i];
+    end_table_[i] = table[num_entries + i];
+    if (swap_) {
+      ReverseN(&offset_table_[i], sizeof(offset_table_[i]));
+      ReverseN(&end_table_[i], sizeof(end_table_[i]));
+    }
+    if (offset_table_[i] < 0) {
+      end_table_[i] = -1;
+    } else {
+      offset_table_[i] += data_start;
+      end_table_[i] += data_start;
+    }
+  }
+  has_end_table_ = true;
+  return true;
+}
+
+bool TessdataManager::SeekToStart(TessdataType tessdata_type) {
+  if (debug_level_) {
+    tprintf("TessdataManager: seek to offset %lld - start of tessdata"
+            "type %d (%s))\n", offset_table_[tessdata_type],
+            tessdata_type, kTessdataFileSuffixes[tessdata_type]);
+  }
+  CloseComponent();
+  if (!SeekToStoredStart(tessdata_type)) return false;
+  if (IsCompressed(tessdata_type))
+    return OpenCompressedComponent(tessdata_type);
+  return true;
+}
+
+bool TessdataManager::SeekToStoredStart(TessdataType tessdata_type) {
+  if (offset_table_[tessdata_type] < 0) return false;
+  ASSERT_HOST(fseek(data_file_,
+                    static_cast<size_t>(offset_table_[tessdata_type]),
+                    SEEK_SET) == 0);
+  return true;
+}
+
+bool TessdataManager::IsCompressed(TessdataType tessdata_type) {
+  if (!SeekToStoredStart(tessdata_type)) return false;
+  inT64 end = GetStoredEndOffset(tessdata_type);
+  char magic[kTessdataZlibMagicLength];
+  bool compressed =
+      (end < 0 || end - offset_table_[tessdata_type] + 1 >=
+                  kTessdataZlibMagicLength +
+                      static_cast<inT64>(sizeof(inT64))) &&
+      fread(magic, sizeof(magic), 1, data_file_) == 1 &&
+      memcmp(magic, kTessdataZlibMagic, sizeof(magic)) == 0;
+  SeekToStoredStart(tessdata_type);
+  return compressed;
+}
+
+bool TessdataManager::OpenCompressedComponent(TessdataType tessdata_type) {
+  inT64 end = GetStoredEndOffset(tessdata_type);
+  if (end < 0) {
+    ASSERT_HOST(fseek(data_file_, 0, SEEK_END) == 0);
+    end = ftell(data_file_) - 1;
+  }
+  inT64 start = offset_table_[tessdata_type] + kTessdataZlibMagicLength;
+  ASSERT_HOST(fseek(data_file_, start, SEEK_SET) == 0);
+  inT64 size = 0;
+  GenericVector<char> stored;
+  stored.init_to_size(end - start + 1 - static_cast<inT64>(sizeof(size)), 0);
+  size_t decompressed_size = 0;
+  if (fread(&size, sizeof(size), 1, data_file_) == 1 &&
+      (stored.empty() ||
+       static_cast<int>(fread(&stored[0], 1, stored.size(), data_file_)) ==
+           stored.size())) {
+    if (swap_) ReverseN(&size, sizeof(size));
+    // A negative stored size can only come from a corrupt file.
+    if (size >= 0) {
+      component_data_ = zlibUncompress(
+          reinterpret_cast<l_uint8 *>(stored.empty() ? NULL : &stored[0]),
+          stored.size(), &decompressed_size);
+    }
+  }
+  if (component_data_ != NULL &&
+      decompressed_size == static_cast<size_t>(size)) {
+    component_file_ = fopenReadFromMemory(component_data_, decompressed_size);
+  }
+  if (component_file_ == NULL) {
+    tprintf("Error decompressing %s from %s\n",
+            kTessdataFileSuffixes[tessdata_type], data_file_name_.string());
+    CloseComponent();
+    return false;
+  }
+  component_size_ = size;
+  component_type_ = tessdata_type;
+  if (debug_level_) {
+    tprintf("TessdataManager: decompressed %lld bytes of %s\n", size,
+            kTessdataFileSuffixes[tessdata_type]);
+  }
+  return true;
+}
+
+void TessdataManager::CloseComponent() {
+  if (component_file_ != NULL) {
+    fclose(component_file_);
+    component_file_ = NULL;
+  }
+  if (component_data_ != NULL) {
+    lept_free(component_data_);
+    component_data_ = NULL;
+  }
+  component_size_ = 0;
+  component_type_ = TESSDATA_NUM_ENTRIES;
+}
+
+bool TessdataManager::CopyCompressedFile(FILE *input_file, FILE *output_file,
+                                         bool text_file) {
+  if (fseek(input_file, 0, SEEK_END) != 0) return false;
+  inT64 size = ftell(input_file);
+  if (size < 0 || fseek(input_file, 0, SEEK_SET) != 0) return false;
+  GenericVector<char> data;
+  data.init_to_size(size, 0);
+  if (size > 0 &&
+      fread(&data[0], 1, size, input_file) != static_cast<size_t>(size)) {
+    return false;
+  }
+  if (text_file) ASSERT_HOST(size > 0 && data.back() == '\n');
+  size_t compressed_size = 0;
+  l_uint8 *compressed = size > 0 ?
+      zlibCompress(reinterpret_cast<l_uint8 *>(&data[0]), size,
+                   &compressed_size) : NULL;
+  bool result;
+  if (compressed != NULL && compressed_size + kTessdataZlibMagicLength +
+                            sizeof(size) < static_cast<size_t>(size)) {
+    result =
+        fwrite(kTessdataZlibMagic, kTessdataZlibMagicLength, 1,
+               output_file) == 1 &&
+        fwrite(&size, sizeof(size), 1, output_file) == 1 &&
+        fwrite(compressed, 1, compressed_size, output_file) == compressed_size;
+  } else {
+    result = size == 0 ||
+             fwrite(&data[0], 1, size, output_file) ==
+                 static_cast<size_t>(size);
+  }
+  if (compressed != NULL) lept_free(compressed);
+  return result;
+}
+
 void TessdataManager::CopyFile(FILE *input_file, FILE *output_file,
                                bool newline_end, inT64 num_bytes_to_copy) {
   if (num_bytes_to_copy == 0) return;
@@ -127,6 +376,12 @@ bool TessdataManager::WriteMetadata(inT64 *offset_table,
 bool TessdataManager::CombineDataFiles(
     const char *language_data_path_prefix,
     const char *output_filename) {
+  return CombineDataFiles(language_data_path_prefix, output_filename, false);
+}
+
+bool TessdataManager::CombineDataFiles(
+    const char *language_data_path_prefix,
+    const char *output_filename, bool compress) {
   int i;
   inT64 offset_table[TESSDATA_NUM_ENTRIES];
   for (i = 0; i < TESSDATA_NUM_ENTRIES; ++i) offset_table[i] = -1;
@@ -156,7 +411,14 @@ bool TessdataManager::CombineDataFiles(
     file_ptr[i] =  fopen(filename.string(), "rb");
     if (file_ptr[i] != NULL) {
       offset_table[type] = ftell(output_file);
-      CopyFile(file_ptr[i], output_file, text_file, -1);
+      if (!compress) {
+        CopyFile(file_ptr[i], output_file, text_file, -1);
+      } else if (!CopyCompressedFile(file_ptr[i], output_file, text_file)) {
+        tprintf("Error compressing %s\n", filename.string());
+        fclose(file_ptr[i]);
+        fclose(output_file);
+        return false;
+      }
       fclose(file_ptr[i]);
     }
   }
@@ -221,12 +483,13 @@ bool TessdataManager::OverwriteComponents(
       CopyFile(file_ptr[i], output_file, kTessdataFileIsText[i], -1);
       fclose(file_ptr[i]);
     } else {
-      // Get this data component from the loaded data file.
-      if (SeekToStart(static_cast<TessdataType>(i))) {
+      // Get this data component from the loaded data file, as stored.
+      type = static_cast<TessdataType>(i);
+      if (SeekToStoredStart(type)) {
         offset_table[i] = ftell(output_file);
-        CopyFile(data_file_, output_file, kTessdataFileIsText[i],
-                 GetEndOffset(static_cast<TessdataType>(i)) -
-                 ftell(data_file_) + 1);
+        bool newline_end = kTessdataFileIsText[i] && !IsCompressed(type);
+        CopyFile(data_file_, output_file, newline_end,
+                 GetStoredEndOffset(type) - ftell(data_file_) + 1);
       }
     }
   }
@@ -234,6 +497,91 @@ bool TessdataManager::OverwriteComponents(
   return WriteMetadata(offset_table, language_data_path_prefix, output_file);
 }
 
+bool TessdataManager::AppendComponents(const char *traineddata_filename,
+                                       char **component_filenames,
+                                       int num_new_components) {
+  int i;
+  inT64 offset_table[TESSDATA_NUM_ENTRIES];
+  inT64 end_table[TESSDATA_NUM_ENTRIES];
+  TessdataManager tm;
+  if (!tm.Init(traineddata_filename, 0)) return false;
+  for (i = 0; i < TESSDATA_NUM_ENTRIES; ++i) {
+    offset_table[i] = tm.offset_table_[i];
+    end_table[i] = offset_table[i] < 0 ? -1 :
+        tm.GetStoredEndOffset(static_cast<TessdataType>(i));
+  }
+  bool swap = tm.swap();
+  tm.End();
+  if (swap) {
+    tprintf("Can't append to %s, which has the other byte order\n",
+            traineddata_filename);
+    return false;
+  }
+  FILE *output_file = fopen(traineddata_filename, "r+b");
+  if (output_file == NULL || fseek(output_file, 0, SEEK_END) != 0) {
+    tprintf("Error opening %s for appending\n", traineddata_filename);
+    if (output_file != NULL) fclose(output_file);
+    return false;
+  }
+  // The last component of a file without a table runs to the end of it.
+  inT64 file_end = ftell(output_file) - 1;
+  for (i = 0; i < TESSDATA_NUM_ENTRIES; ++i) {
+    if (offset_table[i] >= 0 && end_table[i] < 0) end_table[i] = file_end;
+  }
+  TessdataType type = TESSDATA_NUM_ENTRIES;
+  bool text_file = false;
+  bool result = true;
+  for (i = 0; result && i < num_new_components; ++i) {
+    if (!TessdataTypeFromFileName(component_filenames[i], &type, &text_file))
+      continue;
+    FILE *input_file = fopen(component_filenames[i], "rb");
+    if (input_file == NULL) {
+      tprintf("Error opening %s\n", component_filenames[i]);
+      result = false;
+      break;
+    }
+    // Keep the components 8-byte aligned, so dawgs can be mapped in place.
+    inT64 offset = ftell(output_file);
+    for (; result && offset % sizeof(inT64) != 0; ++offset)
+      result = fputc(0, output_file) != EOF;
+    offset_table[type] = offset;
+    CopyFile(input_file, output_file, text_file, -1);
+    fclose(input_file);
+    end_table[type] = ftell(output_file) - 1;
+  }
+  inT32 num_entries = TESSDATA_NUM_ENTRIES;
+  if (!result ||
+      fwrite(offset_table, sizeof(inT64), TESSDATA_NUM_ENTRIES,
+             output_file) != TESSDATA_NUM_ENTRIES ||
+      fwrite(end_table, sizeof(inT64), TESSDATA_NUM_ENTRIES,
+             output_file) != TESSDATA_NUM_ENTRIES ||
+      fwrite(&num_entries, sizeof(num_entries), 1, output_file) != 1 ||
+      fwrite(kTessdataTableMagic, kTessdataTableMagicLength, 1,
+             output_file) != 1) {
+    result = false;
+  }
+  if (fclose(output_file) != 0) result = false;
+  if (!result)
+    tprintf("AppendComponents failed to update %s!\n", traineddata_filename);
+  return result;
+}
+
+bool TessdataManager::CompactDataFile(const char *traineddata_filename) {
+  STRING tmp_filename = traineddata_filename;
+  tmp_filename += ".__tmp__";
+  TessdataManager tm;
+  if (!tm.Init(traineddata_filename, 0)) return false;
+  bool result = tm.OverwriteComponents(tmp_filename.string(), NULL, 0);
+  tm.End();
+  if (result && rename(tmp_filename.string(), traineddata_filename) != 0) {
+    tprintf("Failed to replace %s with %s\n", traineddata_filename,
+            tmp_filename.string());
+    result = false;
+  }
+  if (!result) remove(tmp_filename.string());
+  return result;
+}
+
 bool TessdataManager::TessdataTypeFromFileSuffix(
     const char *suffix, TessdataType *type, bool *text_file) {
   for (int i = 0; i < TESSDATA_NUM_ENTRIES; ++i) {
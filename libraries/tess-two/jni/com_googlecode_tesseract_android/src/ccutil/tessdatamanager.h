@@ -47,6 +47,7 @@ static const char kShapeTableFileSuffix[] = "shapetable";
 static const char kBigramDawgFileSuffix[] = "bigram-dawg";
 static const char kUnambigDawgFileSuffix[] = "unambig-dawg";
 static const char kParamsModelFileSuffix[] = "params-model";
+static const char kCharNgramFileSuffix[] = "char-ngram";
 
 namespace tesseract {
 
@@ -68,6 +69,7 @@ enum TessdataType {
   TESSDATA_BIGRAM_DAWG,         // 14
   TESSDATA_UNAMBIG_DAWG,        // 15
   TESSDATA_PARAMS_MODEL,        // 16
+  TESSDATA_CHAR_NGRAM,          // 17
 
   TESSDATA_NUM_ENTRIES
 };
@@ -94,6 +96,7 @@ static const char *const kTessdataFileSuffixes[] = {
     kBigramDawgFileSuffix,        // 14
     kUnambigDawgFileSuffix,       // 15
     kParamsModelFileSuffix,       // 16
+    kCharNgramFileSuffix,         // 17
 };
 
 /**
@@ -118,6 +121,7 @@ static const bool kTessdataFileIsText[] = {
     false,  // 14
     false,  // 15
     true,   // 16
+    false,  // 17
 };
 
 /**
@@ -129,14 +133,36 @@ static const bool kTessdataFileIsText[] = {
  */
 static const int kMaxNumTessdataEntries = 1000;
 
+/**
+ * Marks the end of a traineddata file updated by AppendComponents. It is
+ * preceded by the number of entries as an inT32, and before that by the
+ * offset and then the end offset of each entry, as inT64s.
+ */
+static const char kTessdataTableMagic[] = "tdtable1";
+static const int kTessdataTableMagicLength = 8;
+
+/**
+ * Starts a component compressed by CombineDataFiles. It is followed by the
+ * size of the decompressed data as an inT64, and then the zlib stream.
+ */
+static const char kTessdataZlibMagic[] = "tdzlib01";
+static const int kTessdataZlibMagicLength = 8;
+
 
 class TessdataManager {
  public:
   TessdataManager() {
     data_file_ = NULL;
+    data_end_ = -1;
+    component_file_ = NULL;
+    component_data_ = NULL;
+    component_size_ = 0;
+    component_type_ = TESSDATA_NUM_ENTRIES;
     actual_tessdata_num_entries_ = 0;
+    has_end_table_ = false;
     for (int i = 0; i < TESSDATA_NUM_ENTRIES; ++i) {
       offset_table_[i] = -1;
+      end_table_[i] = -1;
     }
   }
   ~TessdataManager() {}
@@ -148,48 +174,52 @@ class TessdataManager {
    */
   bool Init(const char *data_file_name, int debug_level);
 
+  /**
+   * Makes data_file_name refer to the length bytes at offset start of the
+   * open file descriptor fd, for traineddata that is not a file of its own,
+   * such as an uncompressed Android asset from AAsset_openFileDescriptor.
+   * Later calls to Init with data_file_name read from a duplicate of fd, so
+   * the caller may close fd. Returns false if fd could not be duplicated.
+   */
+  static bool RegisterFileDescriptor(const char *data_file_name, int fd,
+                                     inT64 start, inT64 length);
+
   // Return the name of the underlying data file.
   const STRING &GetDataFileName() const { return data_file_name_; }
 
-  /** Returns data file pointer. */
-  inline FILE *GetDataFilePtr() const { return data_file_; }
+  /**
+   * Returns data file pointer, or the pointer to the decompressed data of the
+   * last component sought with SeekToStart, if it was compressed.
+   */
+  inline FILE *GetDataFilePtr() const {
+    return component_file_ != NULL ? component_file_ : data_file_;
+  }
+
+  /** Returns true if there is data of the given type, without reading it. */
+  inline bool IsComponentAvailable(TessdataType tessdata_type) const {
+    return offset_table_[tessdata_type] >= 0;
+  }
 
   /**
    * Returns false if there is no data of the given type.
    * Otherwise does a seek on the data_file_ to position the pointer
-   * at the start of the data of the given type.
+   * at the start of the data of the given type. If the data is compressed,
+   * it is decompressed into memory, and GetDataFilePtr and GetEndOffset
+   * refer to the decompressed data instead, until the next SeekToStart.
+   */
+  bool SeekToStart(TessdataType tessdata_type);
+  /**
+   * Returns the end offset for the given tesseract data file type, in the
+   * file returned by GetDataFilePtr after SeekToStart(tessdata_type).
    */
-  inline bool SeekToStart(TessdataType tessdata_type) {
-    if (debug_level_) {
-      tprintf("TessdataManager: seek to offset %lld - start of tessdata"
-              "type %d (%s))\n", offset_table_[tessdata_type],
-              tessdata_type, kTessdataFileSuffixes[tessdata_type]);
-    }
-    if (offset_table_[tessdata_type] < 0) {
-      return false;
-    } else {
-      ASSERT_HOST(fseek(data_file_,
-                        static_cast<size_t>(offset_table_[tessdata_type]),
-                        SEEK_SET) == 0);
-      return true;
-    }
-  }
-  /** Returns the end offset for the given tesseract data file type. */
   inline inT64 GetEndOffset(TessdataType tessdata_type) const {
-    int index = tessdata_type + 1;
-    while (index < actual_tessdata_num_entries_ && offset_table_[index] == -1) {
-      ++index;  // skip tessdata types not present in the combined file
-    }
-    if (debug_level_) {
-      tprintf("TessdataManager: end offset for type %d is %lld\n",
-              tessdata_type,
-              (index == actual_tessdata_num_entries_) ? -1
-              : offset_table_[index]);
-    }
-    return (index == actual_tessdata_num_entries_) ? -1 : offset_table_[index] - 1;
+    if (component_file_ != NULL && tessdata_type == component_type_)
+      return component_size_ - 1;
+    return GetStoredEndOffset(tessdata_type);
   }
   /** Closes data_file_ (if it was opened by Init()). */
   inline void End() {
+    CloseComponent();
     if (data_file_ != NULL) {
       fclose(data_file_);
       data_file_ = NULL;
@@ -213,6 +243,13 @@ class TessdataManager {
    */
   static bool CombineDataFiles(const char *language_data_path_prefix,
                                const char *output_filename);
+  /**
+   * As CombineDataFiles, but if compress is true, stores each component
+   * compressed with zlib wherever that makes it smaller. Compressed
+   * components are decompressed by SeekToStart only when they are loaded.
+   */
+  static bool CombineDataFiles(const char *language_data_path_prefix,
+                               const char *output_filename, bool compress);
 
   /**
    * Gets the individual components from the data_file_ with which the class was
@@ -223,6 +260,28 @@ class TessdataManager {
                             char **component_filenames,
                             int num_new_components);
 
+  /**
+   * Updates the traineddata file in place with the components in
+   * component_filenames, without copying the rest of it. Each component is
+   * written to the end of the file, followed by a new table of the offsets
+   * and ends of all the components, so the space of a replaced component is
+   * left unused until the file is compacted. Files updated this way can only
+   * be read by a TessdataManager that knows the table, and the dawg and
+   * classifier caches must be cleared for an engine to see the changes.
+   * The update is not atomic; a file whose update was interrupted must be
+   * recreated. Returns false on error.
+   */
+  static bool AppendComponents(const char *traineddata_filename,
+                               char **component_filenames,
+                               int num_new_components);
+
+  /**
+   * Rewrites the traineddata file with its components stored in order and no
+   * unused space, as written by CombineDataFiles, replacing it only once the
+   * new file has been written. Returns false on error.
+   */
+  static bool CompactDataFile(const char *traineddata_filename);
+
   /**
    * Extracts tessdata component implied by the name of the input file from
    * the combined traineddata loaded into TessdataManager.
@@ -265,6 +324,62 @@ class TessdataManager {
 
  private:
 
+  /**
+   * Returns the end offset in data_file_ of the stored data of the given type,
+   * which is -1 for the end of the file.
+   */
+  inT64 GetStoredEndOffset(TessdataType tessdata_type) const {
+    if (has_end_table_) return end_table_[tessdata_type];
+    int index = tessdata_type + 1;
+    while (index < actual_tessdata_num_entries_ && offset_table_[index] == -1) {
+      ++index;  // skip tessdata types not present in the combined file
+    }
+    if (debug_level_) {
+      tprintf("TessdataManager: end offset for type %d is %lld\n",
+              tessdata_type,
+              (index == actual_tessdata_num_entries_) ? data_end_
+              : offset_table_[index]);
+    }
+    return (index == actual_tessdata_num_entries_) ? data_end_
+                                                   : offset_table_[index] - 1;
+  }
+
+  /**
+   * Seeks data_file_ to the stored data of the given type, without
+   * decompressing it. Returns false if there is no data of the type.
+   */
+  bool SeekToStoredStart(TessdataType tessdata_type);
+
+  /**
+   * Returns true if the stored data of the given type is compressed, leaving
+   * data_file_ at the start of the stored data.
+   */
+  bool IsCompressed(TessdataType tessdata_type);
+
+  /**
+   * Decompresses the stored data of the given type into component_file_.
+   * Returns false on error.
+   */
+  bool OpenCompressedComponent(TessdataType tessdata_type);
+
+  /** Frees the decompressed data of the last component, if any. */
+  void CloseComponent();
+
+  /**
+   * Copies input_file to output_file, compressed if that makes it smaller.
+   * Returns false on error.
+   */
+  static bool CopyCompressedFile(FILE *input_file, FILE *output_file,
+                                 bool text_file);
+
+  /**
+   * Reads the table written by AppendComponents from the end of data_file_,
+   * if there is one, into offset_table_ and end_table_. data_start is the
+   * offset of the traineddata in data_file_. Returns false if there is no
+   * valid table, leaving the tables as they were.
+   */
+  bool ReadEndTable(inT64 data_start);
+
   /**
    * Opens the file whose name is a concatenation of language_data_path_prefix
    * and file_suffix. Returns a file pointer to the opened file.
@@ -288,6 +403,26 @@ class TessdataManager {
   inT32 actual_tessdata_num_entries_;
   STRING data_file_name_;  // name of the data file.
   FILE *data_file_;  ///< pointer to the data file.
+  /**
+   * Offset of the last byte of the data in data_file_, or -1 if it runs to
+   * the end of the file. Offsets in offset_table_ are always relative to the
+   * start of data_file_, even when the traineddata starts further in.
+   */
+  inT64 data_end_;
+  /**
+   * Offset of the last byte of each tessdata type, or -1 if it is not present.
+   * Only used if has_end_table_, as otherwise each type ends where the next
+   * present one starts.
+   */
+  inT64 end_table_[TESSDATA_NUM_ENTRIES];
+  // True if the file has a table written by AppendComponents.
+  bool has_end_table_;
+  // The decompressed data of the last component sought, if it was compressed,
+  // and a file reading it.
+  FILE *component_file_;
+  unsigned char *component_data_;
+  inT64 component_size_;
+  TessdataType component_type_;
   int debug_level_;
   // True if the bytes need swapping.
   bool swap_;
@@ -0,0 +1,132 @@
+///////////////////////////////////////////////////////////////////////
+// File:        textbuffer.cpp
+// Description: Growable buffer for writing out large amounts of text.
+//
+// (C) Copyright 2016, Google Inc.
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////
+
+#include "textbuffer.h"
+
+#include <stdio.h>
+
+namespace tesseract {
+
+// Longest text of an int, "-2147483648".
+const int kMaxIntText = 11;
+// Longest text of a double as "%.8g", as STRING::add_str_double allows.
+const int kMaxDoubleText = 15;
+
+TextBuffer::TextBuffer(int capacity)
+  : data_(new char[capacity > 0 ? capacity : 1]), used_(0),
+    capacity_(capacity > 0 ? capacity : 1) {}
+
+TextBuffer::~TextBuffer() {
+  delete[] data_;
+}
+
+void TextBuffer::AppendInt(const char* prefix, int number) {
+  Append(prefix);
+  Reserve(kMaxIntText);
+  // Unsigned so that negating INT_MIN is well defined.
+  unsigned int value = number;
+  if (number < 0) {
+    data_[used_++] = '-';
+    value = 0u - value;
+  }
+  char digits[kMaxIntText];
+  int count = 0;
+  do {
+    digits[count++] = '0' + value % 10;
+    value /= 10;
+  } while (value != 0);
+  while (count > 0)
+    data_[used_++] = digits[--count];
+}
+
+void TextBuffer::AppendDouble(const char* prefix, double number) {
+  Append(prefix);
+  Reserve(kMaxDoubleText + 1);
+  int n = snprintf(data_ + used_, kMaxDoubleText + 1, "%.8g", number);
+  if (n > 0) used_ += n < kMaxDoubleText ? n : kMaxDoubleText;
+}
+
+void TextBuffer::AppendHex4(int value) {
+  static const char kHexDigits[] = "0123456789ABCDEF";
+  Reserve(4);
+  for (int shift = 12; shift >= 0; shift -= 4)
+    data_[used_++] = kHexDigits[(value >> shift) & 0xF];
+}
+
+void TextBuffer::AppendEscaped(const char* text) {
+  const char* run = text;
+  for (const char* ptr = text;; ++ptr) {
+    const char* entity;
+    switch (*ptr) {
+      case '\0': Append(run, ptr - run); return;
+      case '<': entity = "&lt;"; break;
+      case '>': entity = "&gt;"; break;
+      case '&': entity = "&amp;"; break;
+      case '"': entity = "&quot;"; break;
+      case '\'': entity = "&#39;"; break;
+      default: continue;
+    }
+    Append(run, ptr - run);
+    Append(entity);
+    run = ptr + 1;
+  }
+}
+
+void TextBuffer::AppendJsonEscaped(const char* text) {
+  const char* run = text;
+  for (const char* ptr = text;; ++ptr) {
+    const char* escape;
+    switch (*ptr) {
+      case '\0': Append(run, ptr - run); return;
+      case '"': escape = "\\\""; break;
+      case '\\': escape = "\\\\"; break;
+      case '\n': escape = "\\n"; break;
+      case '\r': escape = "\\r"; break;
+      case '\t': escape = "\\t"; break;
+      default:
+        if (static_cast<unsigned char>(*ptr) >= 0x20) continue;
+        Append(run, ptr - run);
+        Append("\\u");
+        AppendHex4(static_cast<unsigned char>(*ptr));
+        run = ptr + 1;
+        continue;
+    }
+    Append(run, ptr - run);
+    Append(escape);
+    run = ptr + 1;
+  }
+}
+
+char* TextBuffer::Release() {
+  Append('\0');
+  char* text = data_;
+  data_ = NULL;
+  used_ = capacity_ = 0;
+  return text;
+}
+
+void TextBuffer::Grow(int min_capacity) {
+  int capacity = 2 * capacity_;
+  if (capacity < min_capacity) capacity = min_capacity;
+  char* data = new char[capacity];
+  memcpy(data, data_, used_);
+  delete[] data_;
+  data_ = data;
+  capacity_ = capacity;
+}
+
+}  // namespace tesseract
@@ -0,0 +1,85 @@
+///////////////////////////////////////////////////////////////////////
+// File:        textbuffer.h
+// Description: Growable buffer for writing out large amounts of text.
+//
+// (C) Copyright 2016, Google Inc.
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////
+
+#ifndef TESSERACT_CCUTIL_TEXTBUFFER_H_
+#define TESSERACT_CCUTIL_TEXTBUFFER_H_
+
+#include <string.h>
+#include "platform.h"
+
+namespace tesseract {
+
+// Text written a piece at a time into one buffer, for output such as hOCR
+// or a PDF content stream that is made of many small pieces. Unlike
+// STRING, appending does not go through a header fix-up and a terminator
+// every time, numbers are formatted without snprintf where possible, and
+// the result is handed over by Release without a final copy. The buffer
+// doubles when it is full, so a good initial capacity means it is never
+// reallocated.
+class TESS_API TextBuffer {
+ public:
+  explicit TextBuffer(int capacity);
+  ~TextBuffer();
+
+  const char* data() const { return data_; }
+  int length() const { return used_; }
+  void clear() { used_ = 0; }
+
+  void Append(const char* text, int length) {
+    Reserve(length);
+    memcpy(data_ + used_, text, length);
+    used_ += length;
+  }
+  void Append(const char* text) { Append(text, strlen(text)); }
+  void Append(const TextBuffer& other) { Append(other.data_, other.used_); }
+  void Append(char c) {
+    Reserve(1);
+    data_[used_++] = c;
+  }
+
+  // Appends prefix, then number as "%d" would.
+  void AppendInt(const char* prefix, int number);
+  // Appends prefix, then number as STRING::add_str_double does.
+  void AppendDouble(const char* prefix, double number);
+  // Appends value as 4 upper case hexadecimal digits.
+  void AppendHex4(int value);
+  // Appends text with the characters that are special in XML replaced by
+  // their entities, as HOcrEscape does, copying the runs in between whole.
+  void AppendEscaped(const char* text);
+  // Appends text as the inside of a JSON string, with quotes, backslashes
+  // and control characters escaped.
+  void AppendJsonEscaped(const char* text);
+
+  // Returns the text as a null terminated new[] string owned by the
+  // caller, and leaves the buffer unusable.
+  char* Release();
+
+ private:
+  // Makes room for length more characters.
+  void Reserve(int length) {
+    if (used_ + length > capacity_) Grow(used_ + length);
+  }
+  void Grow(int min_capacity);
+
+  char* data_;
+  int used_;
+  int capacity_;
+};
+
+}  // namespace tesseract
+
+#endif  // TESSERACT_CCUTIL_TEXTBUFFER_H_
@@ -0,0 +1,36 @@
+///////////////////////////////////////////////////////////////////////
+// File:        threadpool.cpp
+// Description: Limit on the threads that run independent loop
+//              iterations in parallel.
+//
+// (C) Copyright 2016, Google Inc.
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////
+
+#include "threadpool.h"
+
+#include "taskscheduler.h"
+
+namespace tesseract {
+
+ThreadPool::ThreadPool(int num_threads) : max_threads_(MAX(num_threads, 1)) {
+}
+
+int ThreadPool::num_threads() const {
+  return MIN(max_threads_, TaskScheduler::Get()->num_workers() + 1);
+}
+
+void ThreadPool::ParallelFor(int count, TessCallback1<int>* func) {
+  TaskScheduler::Get()->ParallelFor(count, max_threads_, func, NULL);
+}
+
+}  // namespace tesseract
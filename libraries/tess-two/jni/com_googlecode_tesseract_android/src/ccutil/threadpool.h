@@ -0,0 +1,58 @@
+///////////////////////////////////////////////////////////////////////
+// File:        threadpool.h
+// Description: Limit on the threads that run independent loop
+//              iterations in parallel.
+//
+// (C) Copyright 2016, Google Inc.
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////
+
+#ifndef TESSERACT_CCUTIL_THREADPOOL_H_
+#define TESSERACT_CCUTIL_THREADPOOL_H_
+
+#include "genericvector.h"
+#include "platform.h"
+#include "tesscallback.h"
+
+namespace tesseract {
+
+// A limit on the number of threads that run the iterations of a loop in
+// parallel, on the workers of the TaskScheduler of the process, which all
+// the pools share. Creating one starts no threads, so it is cheap to keep one
+// per engine, as the limit of that engine.
+// The calling thread takes part in the work, so a pool of num_threads uses
+// at most num_threads - 1 workers for each loop. Loops may run on the same
+// pool from several threads at once. On platforms without pthreads
+// everything runs serially.
+class TESS_API ThreadPool {
+ public:
+  explicit ThreadPool(int num_threads);
+
+  // Total number of threads, including the caller, that run the iterations,
+  // which is less than max_threads if the scheduler has too few workers.
+  int num_threads() const;
+  // The number of threads the pool was created with.
+  int max_threads() const { return max_threads_; }
+
+  // Calls func->Run(i) for every i in [0, count), spread over the pool, and
+  // returns when all of them have completed. The order of the calls is not
+  // defined, so each iteration must only write state that belongs to its own
+  // index. Does not take ownership of func.
+  void ParallelFor(int count, TessCallback1<int>* func);
+
+ private:
+  int max_threads_;
+};
+
+}  // namespace tesseract
+
+#endif  // TESSERACT_CCUTIL_THREADPOOL_H_
@@ -24,48 +24,147 @@
 
 #include          <stdio.h>
 #include          <stdarg.h>
+#ifdef ANDROID
+#include          <android/log.h>
+#include          <pthread.h>
+#endif
 #include          "ccutil.h"
 #include          "params.h"
 #include          "strngs.h"
 #include          "tprintf.h"
 
 #define MAX_MSG_LEN     65536
+// Messages up to this long are formatted on the stack.
+#define STACK_MSG_LEN   512
 
 #define EXTERN
 // Since tprintf is protected by a mutex, these parameters can remain global.
 DLLSYM STRING_VAR(debug_file, "", "File to send tprintf output to");
 
-DLLSYM void
-tprintf_internal(                       // Trace printf
-    const char *format, ...             // Message
-) {
-  tesseract::tprintfMutex.Lock();
-  va_list args;                  // variable args
-  static FILE *debugfp = NULL;   // debug file
-                                 // debug window
-  inT32 offset = 0;              // into message
-  static char msg[MAX_MSG_LEN + 1];
+#ifdef ANDROID
+// Without a debug_file, messages go to logcat, where stderr is lost. They
+// are written by a thread of their own, so that a slow logd never holds up
+// recognition. If the thread falls behind by kMaxQueuedMessages, further
+// messages are dropped and counted instead.
+static const int kMaxQueuedMessages = 1024;
+static const char kLogTag[] = "Tesseract(native)";
+static pthread_mutex_t log_queue_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t log_queue_cond = PTHREAD_COND_INITIALIZER;
+static char* log_queue[kMaxQueuedMessages];
+static int log_queue_head = 0;
+static int log_queue_count = 0;
+static int log_queue_dropped = 0;
+static bool log_thread_started = false;
 
-  va_start(args, format);  // variable list
-  // Format into msg
+static void* LogcatWriter(void*) {
+  pthread_mutex_lock(&log_queue_mutex);
+  while (true) {
+    while (log_queue_count == 0)
+      pthread_cond_wait(&log_queue_cond, &log_queue_mutex);
+    char* msg = log_queue[log_queue_head];
+    log_queue_head = (log_queue_head + 1) % kMaxQueuedMessages;
+    --log_queue_count;
+    int dropped = log_queue_dropped;
+    log_queue_dropped = 0;
+    pthread_mutex_unlock(&log_queue_mutex);
+    __android_log_write(ANDROID_LOG_DEBUG, kLogTag, msg);
+    if (dropped > 0) {
+      __android_log_print(ANDROID_LOG_WARN, kLogTag,
+                          "%d tprintf messages dropped", dropped);
+    }
+    delete[] msg;
+    pthread_mutex_lock(&log_queue_mutex);
+  }
+  return NULL;
+}
+
+// Hands msg to the logcat thread, starting it if need be.
+static void QueueLogcatMessage(const char* msg) {
+  pthread_mutex_lock(&log_queue_mutex);
+  if (!log_thread_started) {
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, &LogcatWriter, NULL) == 0) {
+      pthread_detach(thread);
+      log_thread_started = true;
+    }
+  }
+  if (!log_thread_started) {
+    pthread_mutex_unlock(&log_queue_mutex);
+    __android_log_write(ANDROID_LOG_DEBUG, kLogTag, msg);
+    return;
+  }
+  if (log_queue_count == kMaxQueuedMessages) {
+    ++log_queue_dropped;
+  } else {
+    int length = strlen(msg) + 1;
+    char* copy = new char[length];
+    memcpy(copy, msg, length);
+    log_queue[(log_queue_head + log_queue_count) % kMaxQueuedMessages] = copy;
+    ++log_queue_count;
+    pthread_cond_signal(&log_queue_cond);
+  }
+  pthread_mutex_unlock(&log_queue_mutex);
+}
+#endif  // ANDROID
+
+// Writes msg to the debug_file, or if there is none, to stderr or logcat.
+static void WriteMessage(const char* msg) {
+  static FILE *debugfp = NULL;   // debug file
+  tesseract::tprintfMutex.Lock();
   #ifdef _WIN32
-  offset += _vsnprintf(msg + offset, MAX_MSG_LEN - offset, format, args);
   if (strcmp(debug_file.string(), "/dev/null") == 0)
     debug_file.set_value("nul");
-  #else
-  offset += vsnprintf(msg + offset, MAX_MSG_LEN - offset, format, args);
   #endif
-  va_end(args);
-
-  if (debugfp == NULL && strlen(debug_file.string()) > 0) {
+  if (debugfp == NULL && debug_file.string()[0] != '\0') {
     debugfp = fopen(debug_file.string(), "wb");
-  } else if (debugfp != NULL && strlen(debug_file.string()) == 0) {
+  } else if (debugfp != NULL && debug_file.string()[0] == '\0') {
     fclose(debugfp);
     debugfp = NULL;
   }
-  if (debugfp != NULL)
+  if (debugfp != NULL) {
     fprintf(debugfp, "%s", msg);
-  else
-    fprintf(stderr, "%s", msg);
+    tesseract::tprintfMutex.Unlock();
+    return;
+  }
   tesseract::tprintfMutex.Unlock();
+#ifdef ANDROID
+  QueueLogcatMessage(msg);
+#else
+  fprintf(stderr, "%s", msg);
+#endif
+}
+
+// The message is formatted before taking the lock, in a stack buffer if it
+// fits, so threads only queue up to write it.
+DLLSYM void
+tprintf_internal(                       // Trace printf
+    const char *format, ...             // Message
+) {
+  char stack_msg[STACK_MSG_LEN];
+  va_list args;                  // variable args
+  va_start(args, format);  // variable list
+  #ifdef _WIN32
+  int length = _vsnprintf(stack_msg, STACK_MSG_LEN, format, args);
+  #else
+  int length = vsnprintf(stack_msg, STACK_MSG_LEN, format, args);
+  #endif
+  va_end(args);
+  if (length >= 0 && length < STACK_MSG_LEN) {
+    WriteMessage(stack_msg);
+    return;
+  }
+  // Too long for the stack, or _vsnprintf, which doesn't give the length,
+  // ran out of room.
+  if (length < 0 || length > MAX_MSG_LEN) length = MAX_MSG_LEN;
+  char* heap_msg = new char[length + 1];
+  va_start(args, format);
+  #ifdef _WIN32
+  _vsnprintf(heap_msg, length, format, args);
+  #else
+  vsnprintf(heap_msg, length + 1, format, args);
+  #endif
+  va_end(args);
+  heap_msg[length] = '\0';
+  WriteMessage(heap_msg);
+  delete[] heap_msg;
 }
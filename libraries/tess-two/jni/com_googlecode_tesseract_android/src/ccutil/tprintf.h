@@ -33,4 +33,31 @@ extern DLLSYM BOOL_VAR_H(debug_window_on, TRUE,
 extern TESS_API void tprintf_internal(  // Trace printf
     const char *format, ...);           // Message
 
+// Debug output below this verbosity is compiled in. Builds that never want
+// verbose tracing can define it lower, so that the calls to tdebug above it
+// and the work of their arguments vanish entirely.
+#ifndef TESS_MAX_DEBUG_LEVEL
+#define TESS_MAX_DEBUG_LEVEL 100
+#endif
+
+// Prints with tprintf if debug_level, usually a *_debug param, is greater
+// than level, which must be a constant:
+//   tdebug(language_model_debug_level, 2, "Letter %d OK\n", unichar_id);
+// is the same as the usual
+//   if (language_model_debug_level > 2) tprintf("Letter %d OK\n", unichar_id);
+// except that it compiles to nothing if level is not below
+// TESS_MAX_DEBUG_LEVEL. The message arguments are only evaluated when it
+// is printed.
+#define tdebug(debug_level, level, ...) \
+  do { \
+    if (tdebug_on(debug_level, level)) tprintf(__VA_ARGS__); \
+  } while (0)
+
+// The condition of tdebug, to guard debug code that does more than print:
+//   if (tdebug_on(language_model_debug_level, 0)) word->print("Best");
+// is false at compile time, and the guarded code dropped, if level is not
+// below TESS_MAX_DEBUG_LEVEL.
+#define tdebug_on(debug_level, level) \
+  ((level) < TESS_MAX_DEBUG_LEVEL && (debug_level) > (level))
+
 #endif  // define TESSERACT_CCUTIL_TPRINTF_H
@@ -18,155 +18,163 @@
 ///////////////////////////////////////////////////////////////////////
 
 #include <assert.h>
+#include <string.h>
 #include "unichar.h"
 #include "host.h"
 #include "unicharmap.h"
 
+// Size of the first table. The table is doubled whenever it gets half full.
+static const int kInitialTableSize = 64;
+
 UNICHARMAP::UNICHARMAP() :
-nodes(0) {
+table_size(0), size_used(0), table(0), keys(0), keys_used(0),
+keys_reserved(0), max_length(0) {
 }
 
 UNICHARMAP::~UNICHARMAP() {
-  if (nodes != 0)
-    delete[] nodes;
+  clear();
 }
 
-// Search the given unichar representation in the tree. Each character in the
-// string is interpreted as an index in an array of nodes.
-UNICHAR_ID UNICHARMAP::unichar_to_id(const char* const unichar_repr) const {
-  const char* current_char = unichar_repr;
-  UNICHARMAP_NODE* current_nodes = nodes;
+// The key is the string up to its terminating '\0' or length bytes,
+// whichever comes first.
+int UNICHARMAP::KeyLength(const char* unichar_repr, int length) {
+  int key_length = 0;
+  while (key_length < length && unichar_repr[key_length] != '\0')
+    ++key_length;
+  return key_length;
+}
 
-  assert(*unichar_repr != '\0');
+// FNV-1a, which is quick on the few bytes of a unichar.
+unsigned int UNICHARMAP::Hash(const char* unichar_repr, int length) {
+  unsigned int hash = 2166136261u;
+  for (int i = 0; i < length; ++i) {
+    hash ^= static_cast<unsigned char>(unichar_repr[i]);
+    hash *= 16777619u;
+  }
+  return hash;
+}
 
-  do {
-    if (*(current_char + 1) == '\0')
-      return current_nodes[static_cast<unsigned char>(*current_char)].id;
-    current_nodes =
-        current_nodes[static_cast<unsigned char>(*current_char)].children;
-    ++current_char;
-  } while (true);
+// Probes linearly from the hashed slot. The table is never more than half
+// full, so an empty slot is always reached.
+int UNICHARMAP::find_slot(const char* unichar_repr, int length) const {
+  int mask = table_size - 1;
+  int slot = Hash(unichar_repr, length) & mask;
+  while (table[slot].key >= 0 &&
+         (table[slot].length != length ||
+          memcmp(keys + table[slot].key, unichar_repr, length) != 0)) {
+    slot = (slot + 1) & mask;
+  }
+  return slot;
+}
+
+UNICHAR_ID UNICHARMAP::find(const char* unichar_repr, int length) const {
+  if (table == 0 || length == 0 || length > max_length)
+    return INVALID_UNICHAR_ID;
+  const UNICHARMAP_SLOT& slot = table[find_slot(unichar_repr, length)];
+  return slot.key >= 0 ? slot.id : INVALID_UNICHAR_ID;
+}
+
+UNICHAR_ID UNICHARMAP::unichar_to_id(const char* const unichar_repr) const {
+  assert(*unichar_repr != '\0');
+  return find(unichar_repr, strlen(unichar_repr));
 }
 
-// Search the given unichar representation in the tree, using length characters
-// from it maximum. Each character in the string is interpreted as an index in
-// an array of nodes.
 UNICHAR_ID UNICHARMAP::unichar_to_id(const char* const unichar_repr,
                                      int length) const {
-  const char* current_char = unichar_repr;
-  UNICHARMAP_NODE* current_nodes = nodes;
-
   assert(*unichar_repr != '\0');
   assert(length > 0 && length <= UNICHAR_LEN);
-
-  do {
-    if (length == 1 || *(current_char + 1) == '\0')
-      return current_nodes[static_cast<unsigned char>(*current_char)].id;
-    current_nodes =
-        current_nodes[static_cast<unsigned char>(*current_char)].children;
-    ++current_char;
-    --length;
-  } while (true);
+  return find(unichar_repr, KeyLength(unichar_repr, length));
 }
 
-// Search the given unichar representation in the tree, creating the possibly
-// missing nodes. Once the right place has been found, insert the given id and
-// update the inserted flag to keep track of the insert. Each character in the
-// string is interpreted as an index in an array of nodes.
+// Adds the given unichar representation to the pool and the table, or
+// replaces its id if it is already there.
 void UNICHARMAP::insert(const char* const unichar_repr, UNICHAR_ID id) {
-  const char* current_char = unichar_repr;
-  UNICHARMAP_NODE** current_nodes_pointer = &nodes;
-
   assert(*unichar_repr != '\0');
   assert(id >= 0);
 
-  do {
-    if (*current_nodes_pointer == 0)
-      *current_nodes_pointer = new UNICHARMAP_NODE[256];
-    if (*(current_char + 1) == '\0') {
-      (*current_nodes_pointer)
-          [static_cast<unsigned char>(*current_char)].id = id;
-      return;
+  if (2 * (size_used + 1) > table_size)
+    grow();
+  int length = strlen(unichar_repr);
+  int slot = find_slot(unichar_repr, length);
+  if (table[slot].key >= 0) {
+    table[slot].id = id;
+    return;
+  }
+  if (keys_used + length > keys_reserved) {
+    int new_reserved = keys_reserved > 0 ? 2 * keys_reserved : 256;
+    if (new_reserved < keys_used + length)
+      new_reserved = keys_used + length;
+    char* new_keys = new char[new_reserved];
+    if (keys != 0) {
+      memcpy(new_keys, keys, keys_used);
+      delete[] keys;
     }
-    current_nodes_pointer =
-        &((*current_nodes_pointer)
-          [static_cast<unsigned char>(*current_char)].children);
-    ++current_char;
-  } while (true);
+    keys = new_keys;
+    keys_reserved = new_reserved;
+  }
+  memcpy(keys + keys_used, unichar_repr, length);
+  table[slot].key = keys_used;
+  table[slot].length = length;
+  table[slot].id = id;
+  keys_used += length;
+  ++size_used;
+  if (length > max_length)
+    max_length = length;
 }
 
-// Search the given unichar representation in the tree. Each character in the
-// string is interpreted as an index in an array of nodes. Stop once the tree
-// does not have anymore nodes or once we found the right unichar_repr.
 bool UNICHARMAP::contains(const char* const unichar_repr) const {
   if (unichar_repr == NULL || *unichar_repr == '\0') return false;
-
-  const char* current_char = unichar_repr;
-  UNICHARMAP_NODE* current_nodes = nodes;
-
-  while (current_nodes != 0 && *(current_char + 1) != '\0') {
-    current_nodes =
-        current_nodes[static_cast<unsigned char>(*current_char)].children;
-    ++current_char;
-  }
-  return current_nodes != 0 && *(current_char + 1) == '\0' &&
-      current_nodes[static_cast<unsigned char>(*current_char)].id >= 0;
+  return find(unichar_repr, strlen(unichar_repr)) != INVALID_UNICHAR_ID;
 }
 
-// Search the given unichar representation in the tree, using length characters
-// from it maximum. Each character in the string is interpreted as an index in
-// an array of nodes. Stop once the tree does not have anymore nodes or once we
-// found the right unichar_repr.
 bool UNICHARMAP::contains(const char* const unichar_repr,
                           int length) const {
   if (unichar_repr == NULL || *unichar_repr == '\0') return false;
   if (length <= 0 || length > UNICHAR_LEN) return false;
-
-  const char* current_char = unichar_repr;
-  UNICHARMAP_NODE* current_nodes = nodes;
-
-  while (current_nodes != 0 && (length > 1 && *(current_char + 1) != '\0')) {
-    current_nodes =
-        current_nodes[static_cast<unsigned char>(*current_char)].children;
-    --length;
-    ++current_char;
-  }
-  return current_nodes != 0 && (length == 1 || *(current_char + 1) == '\0') &&
-      current_nodes[static_cast<unsigned char>(*current_char)].id >= 0;
+  return find(unichar_repr, KeyLength(unichar_repr, length)) !=
+      INVALID_UNICHAR_ID;
 }
 
-// Return the minimum number of characters that must be used from this string
-// to obtain a match in the UNICHARMAP.
+// Tries each prefix in turn, which is no longer than the longest unichar.
 int UNICHARMAP::minmatch(const char* const unichar_repr) const {
-  const char* current_char = unichar_repr;
-  UNICHARMAP_NODE* current_nodes = nodes;
-
-  while (current_nodes != NULL && *current_char != '\0') {
-    if (current_nodes[static_cast<unsigned char>(*current_char)].id >= 0)
-      return current_char + 1 - unichar_repr;
-    current_nodes =
-        current_nodes[static_cast<unsigned char>(*current_char)].children;
-    ++current_char;
+  for (int length = 1; length <= max_length &&
+       unichar_repr[length - 1] != '\0'; ++length) {
+    if (find(unichar_repr, length) != INVALID_UNICHAR_ID)
+      return length;
   }
   return 0;
 }
 
 void UNICHARMAP::clear() {
-  if (nodes != 0)
-  {
-    delete[] nodes;
-    nodes = 0;
-  }
+  delete[] table;
+  table = 0;
+  table_size = 0;
+  size_used = 0;
+  delete[] keys;
+  keys = 0;
+  keys_used = 0;
+  keys_reserved = 0;
+  max_length = 0;
 }
 
-UNICHARMAP::UNICHARMAP_NODE::UNICHARMAP_NODE() :
-children(0),
-id(-1) {
+// Returns the number of bytes of heap used by the UNICHARMAP.
+int UNICHARMAP::MemoryUsed() const {
+  return table_size * sizeof(UNICHARMAP_SLOT) + keys_reserved;
 }
 
-// Recursively delete the children
-UNICHARMAP::UNICHARMAP_NODE::~UNICHARMAP_NODE() {
-  if (children != 0) {
-    delete[] children;
+// Rehashes every unichar into a table of twice the size. Their bytes stay
+// where they are in the pool.
+void UNICHARMAP::grow() {
+  UNICHARMAP_SLOT* old_table = table;
+  int old_size = table_size;
+  table_size = old_size > 0 ? 2 * old_size : kInitialTableSize;
+  table = new UNICHARMAP_SLOT[table_size];
+  for (int i = 0; i < table_size; ++i)
+    table[i].key = -1;
+  for (int i = 0; i < old_size; ++i) {
+    if (old_table[i].key < 0) continue;
+    table[find_slot(keys + old_table[i].key, old_table[i].length)] =
+        old_table[i];
   }
+  delete[] old_table;
 }
@@ -24,6 +24,10 @@
 
 // A UNICHARMAP stores unique unichars. Each of them is associated with one
 // UNICHAR_ID.
+// The unichars are kept in a flat open-addressing hash table, with their
+// bytes packed one after another in a single pool, so a lookup hashes the
+// string once and usually touches one slot, and a large set such as a CJK
+// one costs a few bytes per unichar over its text.
 class UNICHARMAP {
  public:
 
@@ -37,12 +41,12 @@ class UNICHARMAP {
   void insert(const char* const unichar_repr, UNICHAR_ID id);
 
   // Return the id associated with the given unichar representation,
-  // this representation MUST exist within the UNICHARMAP.
+  // or INVALID_UNICHAR_ID if it is not within the UNICHARMAP.
   // The length of the representation MUST be non-zero.
   UNICHAR_ID unichar_to_id(const char* const unichar_repr) const;
 
   // Return the id associated with the given unichar representation,
-  // this representation MUST exist within the UNICHARMAP. The first
+  // or INVALID_UNICHAR_ID if it is not within the UNICHARMAP. The first
   // length characters (maximum) from unichar_repr are used. The length
   // MUST be non-zero.
   UNICHAR_ID unichar_to_id(const char* const unichar_repr, int length) const;
@@ -63,20 +67,41 @@ class UNICHARMAP {
   // Clear the UNICHARMAP. All previous data is lost.
   void clear();
 
- private:
-
-  // The UNICHARMAP is represented as a tree whose nodes are of type
-  // UNICHARMAP_NODE.
-  struct UNICHARMAP_NODE {
+  // Returns the number of bytes of heap used by the UNICHARMAP.
+  int MemoryUsed() const;
 
-    UNICHARMAP_NODE();
-    ~UNICHARMAP_NODE();
-
-    UNICHARMAP_NODE* children;
+ private:
+  // A slot of the hash table.
+  struct UNICHARMAP_SLOT {
+    // Offset of the unichar in keys, or -1 if the slot is empty.
+    int key;
+    // Length of the unichar in bytes.
+    int length;
     UNICHAR_ID id;
   };
 
-  UNICHARMAP_NODE* nodes;
+  // Returns the number of bytes of unichar_repr, up to length, that make up
+  // the key to look up.
+  static int KeyLength(const char* unichar_repr, int length);
+  static unsigned int Hash(const char* unichar_repr, int length);
+  // Returns the slot holding the given key, or the empty slot where it
+  // belongs. There must be a table.
+  int find_slot(const char* unichar_repr, int length) const;
+  // Returns the id of the given key, or INVALID_UNICHAR_ID.
+  UNICHAR_ID find(const char* unichar_repr, int length) const;
+  // Doubles the size of the table.
+  void grow();
+
+  // Number of slots, a power of 2, and the number that are used.
+  int table_size;
+  int size_used;
+  UNICHARMAP_SLOT* table;
+  // The bytes of all the unichars, one after another.
+  char* keys;
+  int keys_used;
+  int keys_reserved;
+  // Length of the longest unichar.
+  int max_length;
 };
 
 #endif  // TESSERACT_CCUTIL_UNICHARMAP_H__
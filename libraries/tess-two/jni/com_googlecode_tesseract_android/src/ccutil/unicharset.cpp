@@ -176,6 +176,21 @@ UNICHARSET::~UNICHARSET() {
   clear();
 }
 
+int UNICHARSET::MemoryUsed() const {
+  int bytes = size_reserved * sizeof(UNICHAR_SLOT);
+  for (int id = 0; id < size_used; ++id) {
+    const UNICHAR_PROPERTIES& properties = unichars[id].properties;
+    bytes += properties.normed_ids.size_reserved() * sizeof(UNICHAR_ID);
+    bytes += properties.normed.length() + 1;
+    if (properties.fragment != NULL) bytes += sizeof(CHAR_FRAGMENT);
+  }
+  bytes += ids.MemoryUsed();
+  bytes += script_table_size_reserved * sizeof(char*);
+  for (int i = 0; i < script_table_size_used; ++i)
+    bytes += strlen(script_table[i]) + 1;
+  return bytes;
+}
+
 void UNICHARSET::reserve(int unichars_number) {
   if (unichars_number > size_reserved) {
     UNICHAR_SLOT* unichars_new = new UNICHAR_SLOT[unichars_number];
@@ -192,15 +207,15 @@ void UNICHARSET::reserve(int unichars_number) {
 
 UNICHAR_ID
 UNICHARSET::unichar_to_id(const char* const unichar_repr) const {
-  return ids.contains(unichar_repr) ?
-    ids.unichar_to_id(unichar_repr) : INVALID_UNICHAR_ID;
+  if (unichar_repr == NULL || *unichar_repr == '\0') return INVALID_UNICHAR_ID;
+  return ids.unichar_to_id(unichar_repr);
 }
 
 UNICHAR_ID UNICHARSET::unichar_to_id(const char* const unichar_repr,
                                      int length) const {
   assert(length > 0 && length <= UNICHAR_LEN);
-  return ids.contains(unichar_repr, length) ?
-    ids.unichar_to_id(unichar_repr, length) : INVALID_UNICHAR_ID;
+  if (*unichar_repr == '\0') return INVALID_UNICHAR_ID;
+  return ids.unichar_to_id(unichar_repr, length);
 }
 
 // Return the minimum number of bytes that matches a legal UNICHAR_ID,
@@ -504,9 +519,9 @@ void UNICHARSET::encode_string(const char* str, int str_index, int str_length,
   int length = ids.minmatch(str + str_index);
   if (length == 0 || str_index + length > str_length) return;
   do {
-    if (ids.contains(str + str_index, length)) {
+    UNICHAR_ID id = ids.unichar_to_id(str + str_index, length);
+    if (id != INVALID_UNICHAR_ID) {
       // Successful encoding so far.
-      UNICHAR_ID id = ids.unichar_to_id(str + str_index, length);
       encoding->push_back(id);
       lengths->push_back(length);
       encode_string(str, str_index + length, str_length, encoding, lengths,
@@ -297,6 +297,11 @@ class UNICHARSET {
     return size_used;
   }
 
+  // Returns the number of bytes of heap used by the set: the slots, the
+  // normed strings and fragments of the unichars, the map from their text
+  // to their ids and the script table.
+  int MemoryUsed() const;
+
   // Reserve enough memory space for the given number of UNICHARS
   void reserve(int unichars_number);
 
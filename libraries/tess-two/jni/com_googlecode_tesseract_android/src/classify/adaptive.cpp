@@ -24,6 +24,7 @@
 #include "freelist.h"
 #include "globals.h"
 #include "classify.h"
+#include "serialis.h"
 
 #ifdef __UNIX__
 #include <assert.h>
@@ -208,6 +209,49 @@ void free_adapted_templates(ADAPT_TEMPLATES templates) {
 }
 
 
+/*---------------------------------------------------------------------------*/
+/**
+ * This routine returns the number of bytes of heap held by templates,
+ * including the integer templates the adapted classes are matched with.
+ *
+ * @param templates adapted templates to measure
+ * @return Bytes used by templates.
+ *
+ * @note Globals: none
+ * @note Exceptions: none
+ */
+int AdaptedTemplatesMemoryUsed(ADAPT_TEMPLATES templates) {
+  int bytes = sizeof(*templates);
+  INT_TEMPLATES int_templates = templates->Templates;
+  bytes += IntTemplatesMemoryUsed(int_templates);
+  for (int c = 0; c < int_templates->NumClasses; ++c) {
+    ADAPT_CLASS adapt_class = templates->Class[c];
+    if (adapt_class == NULL) continue;
+    bytes += sizeof(*adapt_class);
+    bytes += (WordsInVectorOfSize(MAX_NUM_PROTOS) +
+              WordsInVectorOfSize(MAX_NUM_CONFIGS)) * sizeof(uinT32);
+    for (LIST protos = adapt_class->TempProtos; protos != NIL_LIST;
+         protos = list_rest(protos)) {
+      bytes += sizeof(TEMP_PROTO_STRUCT) + sizeof(list_rec);
+    }
+    for (int i = 0; i < MAX_NUM_CONFIGS; ++i) {
+      if (ConfigIsPermanent(adapt_class, i)) {
+        PERM_CONFIG config = PermConfigFor(adapt_class, i);
+        if (config == NULL) continue;
+        int num_ambigs = 0;
+        while (config->Ambigs != NULL && config->Ambigs[num_ambigs] >= 0)
+          ++num_ambigs;
+        bytes += sizeof(*config) + (num_ambigs + 1) * sizeof(UNICHAR_ID);
+      } else if (TempConfigFor(adapt_class, i) != NULL) {
+        TEMP_CONFIG config = TempConfigFor(adapt_class, i);
+        bytes += sizeof(*config) + config->ProtoVectorSize * sizeof(uinT32);
+      }
+    }
+  }
+  return bytes;
+}
+
+
 /*---------------------------------------------------------------------------*/
 /**
  * This routine allocates and returns a new temporary config.
@@ -566,3 +610,265 @@ void WriteTempConfig(FILE *File, TEMP_CONFIG Config) {
     Config->ProtoVectorSize, File);
 
 }                                /* WriteTempConfig */
+
+
+/*---------------------------------------------------------------------------*/
+/**
+ * This routine writes Class, whose int class has NumConfigs configs, to fp
+ * in the native byte order, for DeSerializeAdaptedClass to read back.
+ *
+ * @param Class adapted class to write
+ * @param NumConfigs number of configs in Class
+ * @param fp file to write to
+ * @return false on a write error.
+ *
+ * @note Exceptions: none
+ */
+bool SerializeAdaptedClass(ADAPT_CLASS Class, int NumConfigs,
+                           tesseract::TFile* fp) {
+  int proto_words = WordsInVectorOfSize(MAX_NUM_PROTOS);
+  int config_words = WordsInVectorOfSize(MAX_NUM_CONFIGS);
+  if (fp->FWrite(&Class->NumPermConfigs, sizeof(Class->NumPermConfigs),
+                 1) != 1 ||
+      fp->FWrite(&Class->MaxNumTimesSeen, sizeof(Class->MaxNumTimesSeen),
+                 1) != 1 ||
+      fp->FWrite(Class->PermProtos, sizeof(uinT32),
+                 proto_words) != proto_words ||
+      fp->FWrite(Class->PermConfigs, sizeof(uinT32),
+                 config_words) != config_words)
+    return false;
+
+  inT32 NumTempProtos = count(Class->TempProtos);
+  if (fp->FWrite(&NumTempProtos, sizeof(NumTempProtos), 1) != 1)
+    return false;
+  LIST TempProtos = Class->TempProtos;
+  iterate(TempProtos) {
+    TEMP_PROTO proto = reinterpret_cast<TEMP_PROTO>(first_node(TempProtos));
+    if (fp->FWrite(&proto->ProtoId, sizeof(proto->ProtoId), 1) != 1 ||
+        fp->FWrite(&proto->Proto, sizeof(proto->Proto), 1) != 1)
+      return false;
+  }
+
+  for (int i = 0; i < NumConfigs; i++) {
+    if (ConfigIsPermanent(Class, i)) {
+      PERM_CONFIG Config = PermConfigFor(Class, i);
+      inT32 NumAmbigs = 0;
+      while (Config->Ambigs[NumAmbigs] >= 0) ++NumAmbigs;
+      if (fp->FWrite(&NumAmbigs, sizeof(NumAmbigs), 1) != 1 ||
+          fp->FWrite(Config->Ambigs, sizeof(UNICHAR_ID),
+                     NumAmbigs) != NumAmbigs ||
+          fp->FWrite(&Config->FontinfoId, sizeof(Config->FontinfoId),
+                     1) != 1)
+        return false;
+    } else {
+      TEMP_CONFIG Config = TempConfigFor(Class, i);
+      if (fp->FWrite(&Config->NumTimesSeen, sizeof(Config->NumTimesSeen),
+                     1) != 1 ||
+          fp->FWrite(&Config->MaxProtoId, sizeof(Config->MaxProtoId),
+                     1) != 1 ||
+          fp->FWrite(&Config->FontinfoId, sizeof(Config->FontinfoId),
+                     1) != 1 ||
+          fp->FWrite(Config->Protos, sizeof(uinT32),
+                     Config->ProtoVectorSize) != Config->ProtoVectorSize)
+        return false;
+    }
+  }
+  return true;
+}                                /* SerializeAdaptedClass */
+
+
+/*---------------------------------------------------------------------------*/
+/**
+ * This routine reads an adapted class written by SerializeAdaptedClass.
+ *
+ * @param NumConfigs number of configs in the int class of the class
+ * @param fp file to read from
+ * @return New adapted class, or NULL if the data is truncated or invalid.
+ *
+ * @note Exceptions: none
+ */
+ADAPT_CLASS DeSerializeAdaptedClass(int NumConfigs, tesseract::TFile* fp) {
+  int proto_words = WordsInVectorOfSize(MAX_NUM_PROTOS);
+  int config_words = WordsInVectorOfSize(MAX_NUM_CONFIGS);
+  ADAPT_CLASS Class = NewAdaptedClass();
+  inT32 NumTempProtos;
+  if (fp->FRead(&Class->NumPermConfigs, sizeof(Class->NumPermConfigs),
+                1) != 1 ||
+      fp->FRead(&Class->MaxNumTimesSeen, sizeof(Class->MaxNumTimesSeen),
+                1) != 1 ||
+      fp->FRead(Class->PermProtos, sizeof(uinT32),
+                proto_words) != proto_words ||
+      fp->FRead(Class->PermConfigs, sizeof(uinT32),
+                config_words) != config_words ||
+      fp->FRead(&NumTempProtos, sizeof(NumTempProtos), 1) != 1 ||
+      NumTempProtos < 0 || NumTempProtos > MAX_NUM_PROTOS) {
+    free_adapted_class(Class);
+    return NULL;
+  }
+  // Configs beyond NumConfigs are never set, and must not look permanent to
+  // free_adapted_class.
+  for (int i = NumConfigs; i < MAX_NUM_CONFIGS; ++i)
+    reset_bit(Class->PermConfigs, i);
+
+  for (int p = 0; p < NumTempProtos; ++p) {
+    TEMP_PROTO TempProto = NewTempProto();
+    if (fp->FRead(&TempProto->ProtoId, sizeof(TempProto->ProtoId), 1) != 1 ||
+        fp->FRead(&TempProto->Proto, sizeof(TempProto->Proto), 1) != 1) {
+      FreeTempProto(TempProto);
+      free_adapted_class(Class);
+      return NULL;
+    }
+    Class->TempProtos = push_last(Class->TempProtos, TempProto);
+  }
+
+  for (int i = 0; i < NumConfigs; i++) {
+    bool ok;
+    if (ConfigIsPermanent(Class, i)) {
+      inT32 NumAmbigs;
+      ok = fp->FRead(&NumAmbigs, sizeof(NumAmbigs), 1) == 1 &&
+          NumAmbigs >= 0 && NumAmbigs <= MAX_NUM_CLASSES;
+      if (!ok) {
+        free_adapted_class(Class);
+        return NULL;
+      }
+      PERM_CONFIG Config = (PERM_CONFIG) alloc_struct(
+          sizeof(PERM_CONFIG_STRUCT), "PERM_CONFIG_STRUCT");
+      Config->Ambigs = new UNICHAR_ID[NumAmbigs + 1];
+      Config->Ambigs[NumAmbigs] = -1;
+      PermConfigFor(Class, i) = Config;
+      ok = fp->FRead(Config->Ambigs, sizeof(UNICHAR_ID),
+                     NumAmbigs) == NumAmbigs &&
+          fp->FRead(&Config->FontinfoId, sizeof(Config->FontinfoId),
+                    1) == 1;
+    } else {
+      uinT8 NumTimesSeen;
+      PROTO_ID MaxProtoId;
+      ok = fp->FRead(&NumTimesSeen, sizeof(NumTimesSeen), 1) == 1 &&
+          fp->FRead(&MaxProtoId, sizeof(MaxProtoId), 1) == 1 &&
+          MaxProtoId >= 0 && MaxProtoId < MAX_NUM_PROTOS;
+      if (!ok) {
+        free_adapted_class(Class);
+        return NULL;
+      }
+      TEMP_CONFIG Config = NewTempConfig(MaxProtoId, 0);
+      Config->NumTimesSeen = NumTimesSeen;
+      TempConfigFor(Class, i) = Config;
+      ok = fp->FRead(&Config->FontinfoId, sizeof(Config->FontinfoId),
+                     1) == 1 &&
+          fp->FRead(Config->Protos, sizeof(uinT32),
+                    Config->ProtoVectorSize) == Config->ProtoVectorSize;
+    }
+    if (!ok) {
+      free_adapted_class(Class);
+      return NULL;
+    }
+  }
+  return Class;
+}                                /* DeSerializeAdaptedClass */
+
+
+/*---------------------------------------------------------------------------*/
+namespace tesseract {
+
+// Identifies adaptive state in the native byte order, and its version.
+const inT32 kAdaptiveStateMagic = 0x54415331;  // "TAS1"
+
+// Returns a checksum of the unichars of unicharset, in id order.
+static uinT32 UnicharsetChecksum(const UNICHARSET& unicharset) {
+  uinT32 checksum = 2166136261U;
+  for (int id = 0; id < unicharset.size(); ++id) {
+    const char* unichar = unicharset.id_to_unichar(id);
+    // Include the terminating NUL to separate the unichars.
+    for (const char* c = unichar; c == unichar || c[-1] != '\0'; ++c) {
+      checksum ^= static_cast<uinT8>(*c);
+      checksum *= 16777619U;
+    }
+  }
+  return checksum;
+}
+
+bool Classify::SerializeAdaptedTemplates(ADAPT_TEMPLATES Templates,
+                                         TFile* fp) const {
+  inT32 header[5] = {
+    kAdaptiveStateMagic,
+    static_cast<inT32>(UnicharsetChecksum(unicharset)),
+    unicharset.size(),
+    fontinfo_table_.size(),
+    Templates->NumNonEmptyClasses
+  };
+  if (fp->FWrite(header, sizeof(header[0]), 5) != 5 ||
+      fp->FWrite(&Templates->NumPermClasses,
+                 sizeof(Templates->NumPermClasses), 1) != 1 ||
+      !SerializeIntTemplates(Templates->Templates, fp))
+    return false;
+  for (int i = 0; i < Templates->Templates->NumClasses; i++) {
+    if (!SerializeAdaptedClass(Templates->Class[i],
+                               Templates->Templates->Class[i]->NumConfigs, fp))
+      return false;
+  }
+  return true;
+}
+
+ADAPT_TEMPLATES Classify::DeSerializeAdaptedTemplates(TFile* fp) {
+  inT32 header[5];
+  uinT8 NumPermClasses;
+  if (fp->FRead(header, sizeof(header[0]), 5) != 5 ||
+      header[0] != kAdaptiveStateMagic ||
+      header[1] != static_cast<inT32>(UnicharsetChecksum(unicharset)) ||
+      header[2] != unicharset.size() ||
+      header[3] != fontinfo_table_.size() ||
+      fp->FRead(&NumPermClasses, sizeof(NumPermClasses), 1) != 1)
+    return NULL;
+  INT_TEMPLATES int_templates = DeSerializeIntTemplates(fp);
+  if (int_templates == NULL) return NULL;
+  if (int_templates->NumClasses != unicharset.size()) {
+    free_int_templates(int_templates);
+    return NULL;
+  }
+  ADAPT_TEMPLATES Templates = NewAdaptedTemplates(false);
+  free_int_templates(Templates->Templates);
+  Templates->Templates = int_templates;
+  Templates->NumNonEmptyClasses = header[4];
+  Templates->NumPermClasses = NumPermClasses;
+  for (int i = 0; i < int_templates->NumClasses; i++) {
+    Templates->Class[i] =
+        DeSerializeAdaptedClass(int_templates->Class[i]->NumConfigs, fp);
+    if (Templates->Class[i] == NULL) {
+      // free_adapted_templates needs every class, so fill in the rest.
+      for (int j = i; j < int_templates->NumClasses; ++j)
+        Templates->Class[j] = NewAdaptedClass();
+      free_adapted_templates(Templates);
+      return NULL;
+    }
+  }
+  return Templates;
+}
+
+bool Classify::SaveAdaptiveState(GenericVector<char>* data) const {
+  if (AdaptedTemplates == NULL) return false;
+  TFile fp;
+  fp.OpenWrite(data);
+  return SerializeAdaptedTemplates(AdaptedTemplates, &fp);
+}
+
+bool Classify::LoadAdaptiveState(const char* data, int size) {
+  if (AdaptedTemplates == NULL) return false;
+  TFile fp;
+  if (!fp.Open(data, size)) return false;
+  ADAPT_TEMPLATES Templates = DeSerializeAdaptedTemplates(&fp);
+  if (Templates == NULL) return false;
+  free_adapted_templates(AdaptedTemplates);
+  AdaptedTemplates = Templates;
+  if (BackupAdaptedTemplates != NULL) {
+    free_adapted_templates(BackupAdaptedTemplates);
+    BackupAdaptedTemplates = NULL;
+  }
+  NumAdaptationsFailed = 0;
+  for (int i = 0; i < AdaptedTemplates->Templates->NumClasses; i++) {
+    BaselineCutoffs[i] = CharNormCutoffs[i];
+  }
+  AdaptedTemplatesChanged();
+  return true;
+}
+
+}  // namespace tesseract
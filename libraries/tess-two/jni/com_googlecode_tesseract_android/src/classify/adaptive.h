@@ -122,6 +122,8 @@ void free_adapted_class(ADAPT_CLASS adapt_class);
 
 void free_adapted_templates(ADAPT_TEMPLATES templates);
 
+int AdaptedTemplatesMemoryUsed(ADAPT_TEMPLATES templates);
+
 TEMP_CONFIG NewTempConfig(int MaxProtoId, int FontinfoId);
 
 TEMP_PROTO NewTempProto();
@@ -138,4 +140,9 @@ void WritePermConfig(FILE *File, PERM_CONFIG Config);
 
 void WriteTempConfig(FILE *File, TEMP_CONFIG Config);
 
+bool SerializeAdaptedClass(ADAPT_CLASS Class, int NumConfigs,
+                           tesseract::TFile* fp);
+
+ADAPT_CLASS DeSerializeAdaptedClass(int NumConfigs, tesseract::TFile* fp);
+
 #endif
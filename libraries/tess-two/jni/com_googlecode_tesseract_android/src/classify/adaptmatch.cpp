@@ -46,6 +46,7 @@
 #include "normfeat.h"
 #include "normmatch.h"
 #include "outfeat.h"
+#include "pagecounters.h"
 #include "pageres.h"
 #include "params.h"
 #include "picofeat.h"
@@ -87,6 +88,13 @@ struct ADAPT_RESULTS {
   FLOAT32 best_rating;
   GenericVector<UnicharRating> match;
   GenericVector<CP_RESULT_STRUCT> CPResults;
+  // Buffers of the matchers that write to these results, kept with them so
+  // that pooled results (see Classify::AcquireAdaptResults) allocate nothing
+  // once they have grown to fit.
+  GenericVector<UnicharRating> unichar_results;
+  GenericVector<UnicharRating> mapped_results;
+  GenericVector<uinT8> char_norm_array;
+  GenericVector<uinT8> pruner_norm_array;
 
   /// Initializes data members to the default values. Sets the initial
   /// rating of each class to be the worst possible rating (1.0).
@@ -95,6 +103,11 @@ struct ADAPT_RESULTS {
     HasNonfragment = false;
     ComputeBest();
   }
+  // Returns buffer resized to size, with undefined contents.
+  static uinT8* SizedArray(int size, GenericVector<uinT8>* buffer) {
+    buffer->resize_no_init(size);
+    return &(*buffer)[0];
+  }
   // Computes best_unichar_id, best_match_index and best_rating.
   void ComputeBest() {
     best_unichar_id = INVALID_UNICHAR_ID;
@@ -126,6 +139,42 @@ inline bool MarginalMatch(float confidence, float matcher_great_threshold) {
 /*-----------------------------------------------------------------------------
           Private Function Prototypes
 -----------------------------------------------------------------------------*/
+// Appends the size bytes at data to key.
+static void AppendToKey(const void* data, int size, GenericVector<uinT8>* key) {
+  const uinT8* bytes = static_cast<const uinT8*>(data);
+  for (int i = 0; i < size; ++i) key->push_back(bytes[i]);
+}
+
+// Builds the key under which the result of DoAdaptiveMatch for a blob is
+// cached, from the version of the adapted templates used and everything that
+// the classifiers read of the blob: its baseline-normalized box, the feature
+// extraction summary (which carries the char-norm parameters) and both sets
+// of integer features.
+static void BuildClassifyCacheKey(
+    int version, const TBOX& blob_box, const INT_FX_RESULT_STRUCT& fx_info,
+    const GenericVector<INT_FEATURE_STRUCT>& bl_features,
+    const tesseract::TrainingSample& sample, GenericVector<uinT8>* key) {
+  AppendToKey(&version, sizeof(version), key);
+  inT16 box[4] = { blob_box.left(), blob_box.bottom(),
+                   blob_box.right(), blob_box.top() };
+  AppendToKey(box, sizeof(box), key);
+  inT16 fx[8] = { fx_info.Xmean, fx_info.Ymean, fx_info.Rx, fx_info.Ry,
+                  fx_info.NumBL, fx_info.NumCN, fx_info.Width,
+                  static_cast<inT16>(fx_info.YBottom << 8 | fx_info.YTop) };
+  AppendToKey(&fx_info.Length, sizeof(fx_info.Length), key);
+  AppendToKey(fx, sizeof(fx), key);
+  for (int f = 0; f < bl_features.size(); ++f) {
+    const INT_FEATURE_STRUCT& feature = bl_features[f];
+    uinT8 bytes[3] = { feature.X, feature.Y, feature.Theta };
+    AppendToKey(bytes, sizeof(bytes), key);
+  }
+  const INT_FEATURE_STRUCT* features = sample.features();
+  for (int f = 0; f < sample.num_features(); ++f) {
+    uinT8 bytes[3] = { features[f].X, features[f].Y, features[f].Theta };
+    AppendToKey(bytes, sizeof(bytes), key);
+  }
+}
+
 // Returns the index of the given id in results, if present, or the size of the
 // vector (index it will go at) if not present.
 static int FindScoredUnichar(UNICHAR_ID id, const ADAPT_RESULTS& results) {
@@ -184,12 +233,59 @@ namespace tesseract {
  */
 void Classify::AdaptiveClassifier(TBLOB *Blob, BLOB_CHOICE_LIST *Choices) {
   assert(Choices != NULL);
-  ADAPT_RESULTS *Results = new ADAPT_RESULTS;
-  Results->Initialize();
+  ADAPT_RESULTS *Results = AcquireAdaptResults();
+  IntFxScratch* scratch = AcquireFxScratch();
+  AdaptiveClassifier(Blob, scratch, Results, Choices);
+  ReleaseFxScratch(scratch);
+  ReleaseAdaptResults(Results);
+}                                /* AdaptiveClassifier */
+
+void Classify::ClassifyBlobBatch(const GenericVector<TBLOB*>& blobs,
+                                 GenericVector<BLOB_CHOICE_LIST*>* choices) {
+  ADAPT_RESULTS *Results = AcquireAdaptResults();
+  IntFxScratch* scratch = AcquireFxScratch();
+  for (int b = 0; b < blobs.size(); ++b) {
+    // Initialize leaves the matches alone, so clear them for each blob.
+    Results->match.truncate(0);
+    Results->CPResults.truncate(0);
+    Results->Initialize();
+    BLOB_CHOICE_LIST* blob_choices = new BLOB_CHOICE_LIST;
+    AdaptiveClassifier(blobs[b], scratch, Results, blob_choices);
+    choices->push_back(blob_choices);
+  }
+  ReleaseFxScratch(scratch);
+  ReleaseAdaptResults(Results);
+}
+
+ADAPT_RESULTS* Classify::AcquireAdaptResults() {
+  ADAPT_RESULTS* results = NULL;
+  adapt_results_mutex_.Lock();
+  if (!adapt_results_pool_.empty()) results = adapt_results_pool_.pop_back();
+  adapt_results_mutex_.Unlock();
+  if (results == NULL) {
+    results = new ADAPT_RESULTS;
+  } else {
+    // Truncating keeps the memory of the matches and their fonts.
+    results->match.truncate(0);
+    results->CPResults.truncate(0);
+  }
+  results->Initialize();
+  return results;
+}
 
+void Classify::ReleaseAdaptResults(ADAPT_RESULTS* results) {
+  adapt_results_mutex_.Lock();
+  adapt_results_pool_.push_back(results);
+  adapt_results_mutex_.Unlock();
+}
+
+void Classify::AdaptiveClassifier(TBLOB *Blob, IntFxScratch* scratch,
+                                  ADAPT_RESULTS *Results,
+                                  BLOB_CHOICE_LIST *Choices) {
   ASSERT_HOST(AdaptedTemplates != NULL);
+  PageCounts::Count(COUNTER_BLOBS_CLASSIFIED);
 
-  DoAdaptiveMatch(Blob, Results);
+  DoAdaptiveMatch(Blob, scratch, Results);
 
   RemoveBadMatches(Results);
   Results->match.sort(&UnicharRating::SortDescendingRating);
@@ -202,7 +298,7 @@ void Classify::AdaptiveClassifier(TBLOB *Blob, BLOB_CHOICE_LIST *Choices) {
   if (LargeSpeckle(*Blob) || Choices->length() == 0)
     AddLargeSpeckleTo(Results->BlobLength, Choices);
 
-  if (matcher_debug_level >= 1) {
+  if (tdebug_on(matcher_debug_level, 0)) {
     tprintf("AD Matches =  ");
     PrintAdaptiveMatchResults(*Results);
   }
@@ -211,9 +307,7 @@ void Classify::AdaptiveClassifier(TBLOB *Blob, BLOB_CHOICE_LIST *Choices) {
   if (classify_enable_adaptive_debugger)
     DebugAdaptiveClassifier(Blob, Results);
 #endif
-
-  delete Results;
-}                                /* AdaptiveClassifier */
+}
 
 // If *win is NULL, sets it to a new ScrollView() object with title msg.
 // Clears the window and draws baselines.
@@ -251,7 +345,7 @@ void Classify::LearnWord(const char* fontname, WERD_RES* word) {
     if (!EnableLearning || word->best_choice == NULL)
       return;  // Can't or won't adapt.
 
-    if (classify_learning_debug_level >= 1)
+    if (tdebug_on(classify_learning_debug_level, 0))
       tprintf("\n\nAdapting to word = %s\n",
               word->best_choice->debug_string().string());
     thresholds = new float[word_len];
@@ -415,7 +509,7 @@ void Classify::LearnPieces(const char* fontname, int start, int length,
     int font_id = word->fontinfo != NULL
                 ? fontinfo_table_.get_id(*word->fontinfo)
                 : 0;
-    if (classify_learning_debug_level >= 1)
+    if (tdebug_on(classify_learning_debug_level, 0))
       tprintf("Adapting to char = %s, thr= %g font_id= %d\n",
               unicharset.id_to_unichar(class_id), threshold, font_id);
     // If filename is not NULL we are doing recognition
@@ -427,7 +521,7 @@ void Classify::LearnPieces(const char* fontname, int start, int length,
       AdaptToChar(rotated_blob, class_id, font_id, threshold,
                   BackupAdaptedTemplates);
     }
-  } else if (classify_debug_level >= 1) {
+  } else if (tdebug_on(classify_debug_level, 0)) {
     tprintf("Can't adapt to %s not in unicharset\n", correct_text);
   }
   if (rotated_blob != blob) {
@@ -480,7 +574,34 @@ void Classify::EndAdaptiveClassifier() {
     free_adapted_templates(BackupAdaptedTemplates);
     BackupAdaptedTemplates = NULL;
   }
-
+  if (snapshot_templates_ != NULL) {
+    free_adapted_templates(snapshot_templates_);
+    snapshot_templates_ = NULL;
+  }
+  delete classify_cache_;
+  classify_cache_ = NULL;
+  // ADAPT_RESULTS is only complete in this file, so the pool is freed here.
+  adapt_results_pool_.delete_data_pointers();
+  adapt_results_pool_.clear();
+  if (classify_bound_matcher && tdebug_on(classify_debug_level, 0) &&
+      bound_matches_ > 0) {
+    tprintf("Matcher bound: cut %d of %d class matches,"
+            " skipping %.1f%% of features\n",
+            bound_match_cuts_, bound_matches_,
+            100.0 * bound_features_skipped_ / MAX(bound_features_, 1));
+  }
+  bound_matches_ = bound_match_cuts_ = 0;
+  bound_features_ = bound_features_skipped_ = 0;
+
+  ClearWhitelistPruners();
+  if (model_ != NULL) {
+    // The static templates belong to the shared model.
+    GlobalModelCache()->FreeModel(model_);
+    model_ = NULL;
+    PreTrainedTemplates = NULL;
+    shape_table_ = NULL;
+    NormProtos = NULL;
+  }
   if (PreTrainedTemplates != NULL) {
     free_int_templates(PreTrainedTemplates);
     PreTrainedTemplates = NULL;
@@ -534,22 +655,25 @@ void Classify::InitAdaptiveClassifier(bool load_pre_trained_templates) {
   // adaptive only.
   if (language_data_path_prefix.length() > 0 &&
       load_pre_trained_templates) {
-    ASSERT_HOST(tessdata_manager.SeekToStart(TESSDATA_INTTEMP));
-    PreTrainedTemplates =
-      ReadIntTemplates(tessdata_manager.GetDataFilePtr());
-    if (tessdata_manager.DebugLevel() > 0) tprintf("Loaded inttemp\n");
-
-    if (tessdata_manager.SeekToStart(TESSDATA_SHAPE_TABLE)) {
-      shape_table_ = new ShapeTable(unicharset);
-      if (!shape_table_->DeSerialize(tessdata_manager.swap(),
-                                     tessdata_manager.GetDataFilePtr())) {
-        tprintf("Error loading shape table!\n");
-        delete shape_table_;
-        shape_table_ = NULL;
-      } else if (tessdata_manager.DebugLevel() > 0) {
-        tprintf("Successfully loaded shape table!\n");
-      }
+    // The static templates are shared with any other instance using the
+    // same traineddata file, and loaded here only if there is none.
+    STRING data_file_name = language_data_path_prefix + kTrainedDataSuffix;
+    bool loaded = false;
+    model_ = GlobalModelCache()->GetModel(
+        data_file_name,
+        NewTessCallback(this, &Classify::LoadTessModel, &loaded));
+    ASSERT_HOST(model_ != NULL);
+    if (!loaded) {
+      // The font tables are per instance, as Tesseract renumbers them.
+      ASSERT_HOST(tessdata_manager.SeekToStart(TESSDATA_INTTEMP));
+      ReadIntTemplatesFontTables(tessdata_manager.GetDataFilePtr(),
+                                 model_->font_tables_offset);
+      if (tessdata_manager.DebugLevel() > 0)
+        tprintf("Using shared inttemp, shape table and normproto\n");
     }
+    PreTrainedTemplates = model_->int_templates;
+    shape_table_ = model_->shape_table;
+    NormProtos = model_->norm_protos;
 
     ASSERT_HOST(tessdata_manager.SeekToStart(TESSDATA_PFFMTABLE));
     ReadNewCutoffs(tessdata_manager.GetDataFilePtr(),
@@ -557,16 +681,12 @@ void Classify::InitAdaptiveClassifier(bool load_pre_trained_templates) {
                    tessdata_manager.GetEndOffset(TESSDATA_PFFMTABLE),
                    CharNormCutoffs);
     if (tessdata_manager.DebugLevel() > 0) tprintf("Loaded pffmtable\n");
-
-    ASSERT_HOST(tessdata_manager.SeekToStart(TESSDATA_NORMPROTO));
-    NormProtos =
-      ReadNormProtos(tessdata_manager.GetDataFilePtr(),
-                     tessdata_manager.GetEndOffset(TESSDATA_NORMPROTO));
-    if (tessdata_manager.DebugLevel() > 0) tprintf("Loaded normproto\n");
     static_classifier_ = new TessClassifier(false, this);
   }
 
-  im_.Init(&classify_debug_level);
+  im_.Init(&classify_debug_level, &classify_verify_simd_matcher);
+  if (classify_cache_size > 0)
+    classify_cache_ = new ClassifyCache(classify_cache_size);
   InitIntegerFX();
 
   AllProtosOn = NewBitVector(MAX_NUM_PROTOS);
@@ -608,10 +728,51 @@ void Classify::InitAdaptiveClassifier(bool load_pre_trained_templates) {
       free_adapted_templates(AdaptedTemplates);
     AdaptedTemplates = NewAdaptedTemplates(true);
   }
+  AdaptedTemplatesChanged();
 }                                /* InitAdaptiveClassifier */
 
+// Loads the shareable static classifier data from tessdata_manager into a
+// new TessModel, and sets *loaded to true. The font tables are read into this.
+TessModel* Classify::LoadTessModel(bool* loaded) {
+  TessModel* model = new TessModel;
+  ASSERT_HOST(tessdata_manager.SeekToStart(TESSDATA_INTTEMP));
+  model->int_templates = ReadIntTemplates(tessdata_manager.GetDataFilePtr(),
+                                          &model->font_tables_offset);
+  if (classify_pack_int_templates) PackIntTemplates(model->int_templates);
+  if (classify_bound_class_pruner)
+    BuildClassPrunerBounds(model->int_templates);
+  if (tessdata_manager.DebugLevel() > 0) tprintf("Loaded inttemp\n");
+
+  if (tessdata_manager.SeekToStart(TESSDATA_SHAPE_TABLE)) {
+    model->unicharset.CopyFrom(unicharset);
+    model->shape_table = new ShapeTable(model->unicharset);
+    if (!model->shape_table->DeSerialize(tessdata_manager.swap(),
+                                         tessdata_manager.GetDataFilePtr())) {
+      tprintf("Error loading shape table!\n");
+      delete model->shape_table;
+      model->shape_table = NULL;
+    } else if (tessdata_manager.DebugLevel() > 0) {
+      tprintf("Successfully loaded shape table!\n");
+    }
+  }
+
+  ASSERT_HOST(tessdata_manager.SeekToStart(TESSDATA_NORMPROTO));
+  model->norm_protos =
+    ReadNormProtos(tessdata_manager.GetDataFilePtr(),
+                   tessdata_manager.GetEndOffset(TESSDATA_NORMPROTO));
+  if (tessdata_manager.DebugLevel() > 0) tprintf("Loaded normproto\n");
+  *loaded = true;
+  return model;
+}
+
+TessModelCache* Classify::GlobalModelCache() {
+  // Like the DawgCache, this singleton outlives every Tesseract instance.
+  static TessModelCache cache;
+  return &cache;
+}
+
 void Classify::ResetAdaptiveClassifierInternal() {
-  if (classify_learning_debug_level > 0) {
+  if (tdebug_on(classify_learning_debug_level, 0)) {
     tprintf("Resetting adaptive classifier (NumAdaptationsFailed=%d)\n",
             NumAdaptationsFailed);
   }
@@ -621,6 +782,7 @@ void Classify::ResetAdaptiveClassifierInternal() {
     free_adapted_templates(BackupAdaptedTemplates);
   BackupAdaptedTemplates = NULL;
   NumAdaptationsFailed = 0;
+  AdaptedTemplatesChanged();
 }
 
 // If there are backup adapted templates, switches to those, otherwise resets
@@ -630,7 +792,7 @@ void Classify::SwitchAdaptiveClassifier() {
     ResetAdaptiveClassifierInternal();
     return;
   }
-  if (classify_learning_debug_level > 0) {
+  if (tdebug_on(classify_learning_debug_level, 0)) {
     tprintf("Switch to backup adaptive classifier (NumAdaptationsFailed=%d)\n",
             NumAdaptationsFailed);
   }
@@ -638,6 +800,7 @@ void Classify::SwitchAdaptiveClassifier() {
   AdaptedTemplates = BackupAdaptedTemplates;
   BackupAdaptedTemplates = NULL;
   NumAdaptationsFailed = 0;
+  AdaptedTemplatesChanged();
 }
 
 // Resets the backup adaptive classifier to empty.
@@ -767,7 +930,7 @@ void Classify::InitAdaptedClass(TBLOB *Blob,
 
     ConvertProto(Proto, Pid, IClass);
     AddProtoToProtoPruner(Proto, Pid, IClass,
-                          classify_learning_debug_level >= 2);
+                          tdebug_on(classify_learning_debug_level, 1));
 
     Class->TempProtos = push (Class->TempProtos, TempProto);
   }
@@ -776,10 +939,10 @@ void Classify::InitAdaptedClass(TBLOB *Blob,
   AddIntConfig(IClass);
   ConvertConfig (AllProtosOn, 0, IClass);
 
-  if (classify_learning_debug_level >= 1) {
+  if (tdebug_on(classify_learning_debug_level, 0)) {
     tprintf("Added new class '%s' with class id %d and %d protos.\n",
             unicharset.id_to_unichar(ClassId), ClassId, NumFeatures);
-    if (classify_learning_debug_level > 1)
+    if (tdebug_on(classify_learning_debug_level, 1))
       DisplayAdaptedChar(Blob, IClass);
   }
 
@@ -897,6 +1060,7 @@ void Classify::AdaptToChar(TBLOB* Blob, CLASS_ID ClassId, int FontinfoId,
 
   if (!LegalClassId (ClassId))
     return;
+  if (adaptive_templates == AdaptedTemplates) AdaptedTemplatesChanged();
 
   int_result.unichar_id = ClassId;
   Class = adaptive_templates->Class[ClassId];
@@ -930,7 +1094,7 @@ void Classify::AdaptToChar(TBLOB* Blob, CLASS_ID ClassId, int FontinfoId,
 
     if (1.0f - int_result.rating <= Threshold) {
       if (ConfigIsPermanent(Class, int_result.config)) {
-        if (classify_learning_debug_level >= 1)
+        if (tdebug_on(classify_learning_debug_level, 0))
           tprintf("Found good match to perm config %d = %4.1f%%.\n",
                   int_result.config, int_result.rating * 100.0);
         FreeFeatureSet(FloatFeatures);
@@ -942,7 +1106,7 @@ void Classify::AdaptToChar(TBLOB* Blob, CLASS_ID ClassId, int FontinfoId,
       if (TempConfig->NumTimesSeen > Class->MaxNumTimesSeen) {
         Class->MaxNumTimesSeen = TempConfig->NumTimesSeen;
       }
-      if (classify_learning_debug_level >= 1)
+      if (tdebug_on(classify_learning_debug_level, 0))
         tprintf("Increasing reliability of temp config %d to %d.\n",
                 int_result.config, TempConfig->NumTimesSeen);
 
@@ -951,10 +1115,10 @@ void Classify::AdaptToChar(TBLOB* Blob, CLASS_ID ClassId, int FontinfoId,
         UpdateAmbigsGroup(ClassId, Blob);
       }
     } else {
-      if (classify_learning_debug_level >= 1) {
+      if (tdebug_on(classify_learning_debug_level, 0)) {
         tprintf("Found poor match to temp config %d = %4.1f%%.\n",
                 int_result.config, int_result.rating * 100.0);
-        if (classify_learning_debug_level > 2)
+        if (tdebug_on(classify_learning_debug_level, 2))
           DisplayAdaptedChar(Blob, IClass);
       }
       NewTempConfigId =
@@ -967,7 +1131,7 @@ void Classify::AdaptToChar(TBLOB* Blob, CLASS_ID ClassId, int FontinfoId,
       }
 
 #ifndef GRAPHICS_DISABLED
-      if (classify_learning_debug_level > 1) {
+      if (tdebug_on(classify_learning_debug_level, 1)) {
         DisplayAdaptedChar(Blob, IClass);
       }
 #endif
@@ -992,7 +1156,7 @@ void Classify::DisplayAdaptedChar(TBLOB* blob, INT_CLASS_STRUCT* int_class) {
             NO_DEBUG, matcher_debug_separate_windows);
   tprintf("Best match to temp config %d = %4.1f%%.\n",
           int_result.config, int_result.rating * 100.0);
-  if (classify_learning_debug_level >= 2) {
+  if (tdebug_on(classify_learning_debug_level, 1)) {
     uinT32 ConfigMask;
     ConfigMask = 1 << int_result.config;
     ShowMatchDisplay();
@@ -1090,12 +1254,14 @@ void Classify::AmbigClassifier(
     UNICHAR_ID *ambiguities,
     ADAPT_RESULTS *results) {
   if (int_features.empty()) return;
-  uinT8* CharNormArray = new uinT8[unicharset.size()];
+  uinT8* CharNormArray = ADAPT_RESULTS::SizedArray(unicharset.size(),
+                                                   &results->char_norm_array);
   UnicharRating int_result;
 
   results->BlobLength = GetCharNormFeature(fx_info, templates, NULL,
                                            CharNormArray);
-  bool debug = matcher_debug_level >= 2 || classify_debug_level > 1;
+  bool debug = tdebug_on(matcher_debug_level, 1) ||
+               tdebug_on(classify_debug_level, 1);
   if (debug)
     tprintf("AM Matches =  ");
 
@@ -1118,7 +1284,6 @@ void Classify::AmbigClassifier(
                                     CharNormArray, &int_result, results);
     ambiguities++;
   }
-  delete [] CharNormArray;
 }                                /* AmbigClassifier */
 
 /*---------------------------------------------------------------------------*/
@@ -1137,26 +1302,67 @@ void Classify::MasterMatcher(INT_TEMPLATES templates,
   int top = blob_box.top();
   int bottom = blob_box.bottom();
   UnicharRating int_result;
+  int num_cuts = 0;
+  int num_matched = 0;
   for (int c = 0; c < results.size(); c++) {
     CLASS_ID class_id = results[c].Class;
     BIT_VECTOR protos = classes != NULL ? classes[class_id]->PermProtos
                                         : AllProtosOn;
     BIT_VECTOR configs = classes != NULL ? classes[class_id]->PermConfigs
                                          : AllConfigsOn;
+    // The results come best first from the class pruner, so the bound soon
+    // rules out the classes that AddNewResult would reject anyway.
+    float min_rating = 0.0f;
+    if (classify_bound_matcher && debug == NO_DEBUG) {
+      min_rating = MinUsefulMatchRating(final_results->BlobLength,
+                                        matcher_multiplier, *final_results);
+    }
 
     int_result.unichar_id = class_id;
-    im_.Match(ClassForClassId(templates, class_id),
-              protos, configs,
-              num_features, features,
-              &int_result, classify_adapt_feature_threshold, debug,
-              matcher_debug_separate_windows);
-    bool debug = matcher_debug_level >= 2 || classify_debug_level > 1;
+    int matched = im_.Match(ClassForClassId(templates, class_id),
+                            protos, configs,
+                            num_features, features,
+                            &int_result, classify_adapt_feature_threshold,
+                            debug, matcher_debug_separate_windows,
+                            min_rating);
+    num_matched += matched;
+    if (matched < num_features) {
+      ++num_cuts;
+      continue;  // It could not have made the results.
+    }
+    bool debug = tdebug_on(matcher_debug_level, 1) ||
+                 tdebug_on(classify_debug_level, 1);
     ExpandShapesAndApplyCorrections(classes, debug, class_id, bottom, top,
                                     results[c].Rating,
                                     final_results->BlobLength,
                                     matcher_multiplier, norm_factors,
                                     &int_result, final_results);
   }
+  if (classify_bound_matcher) {
+    bound_stats_mutex_.Lock();
+    bound_matches_ += results.size();
+    bound_match_cuts_ += num_cuts;
+    bound_features_ += results.size() * num_features;
+    bound_features_skipped_ += results.size() * num_features - num_matched;
+    bound_stats_mutex_.Unlock();
+  }
+}
+
+float Classify::MinUsefulMatchRating(int blob_length, int matcher_multiplier,
+                                     const ADAPT_RESULTS& final_results) const {
+  // AddNewResult rejects ratings below this.
+  double min_result = final_results.best_rating - matcher_bad_match_pad;
+  // The corrected rating is clipped to WORST_POSSIBLE_RATING, and the bound
+  // relies on the penalties never adding to a rating.
+  if (min_result <= WORST_POSSIBLE_RATING || blob_length <= 0 ||
+      matcher_multiplier < 0 || tessedit_class_miss_scale < 0.0)
+    return 0.0f;
+  // With penalties of 0 and a CN factor of 0, ComputeCorrectedRating gives
+  // 1 - (1 - im_rating) * blob_length / (blob_length + matcher_multiplier),
+  // which is the most it can give for im_rating.
+  double min_rating = 1.0 - (1.0 - min_result) *
+      (blob_length + matcher_multiplier) / blob_length;
+  return min_rating > 0.0 ? static_cast<float>(min_rating) : 0.0f;
 }
 
 // Converts configs to fonts, and if the result is not adapted, and a
@@ -1192,7 +1398,9 @@ void Classify::ExpandShapesAndApplyCorrections(
       // 2. Multi-unichar shapetable. Variable unichars in the shapes referenced
       // by int_result. In this case, build a vector of UnicharRating to
       // gather together different font-ids for each unichar. Also covers case1.
-      GenericVector<UnicharRating> mapped_results;
+      GenericVector<UnicharRating>& mapped_results =
+          final_results->mapped_results;
+      mapped_results.truncate(0);
       for (int f = 0; f < int_result->fonts.size(); ++f) {
         int shape_id = int_result->fonts[f].fontinfo_id;
         const Shape& shape = shape_table_->GetShape(shape_id);
@@ -1308,14 +1516,15 @@ UNICHAR_ID *Classify::BaselineClassifier(
     const INT_FX_RESULT_STRUCT& fx_info,
     ADAPT_TEMPLATES Templates, ADAPT_RESULTS *Results) {
   if (int_features.empty()) return NULL;
-  uinT8* CharNormArray = new uinT8[unicharset.size()];
+  uinT8* CharNormArray = ADAPT_RESULTS::SizedArray(unicharset.size(),
+                                                   &Results->char_norm_array);
   ClearCharNormArray(CharNormArray);
 
   Results->BlobLength = IntCastRounded(fx_info.Length / kStandardFeatureLength);
   PruneClasses(Templates->Templates, int_features.size(), -1, &int_features[0],
                CharNormArray, BaselineCutoffs, &Results->CPResults);
 
-  if (matcher_debug_level >= 2 || classify_debug_level > 1)
+  if (tdebug_on(matcher_debug_level, 1) || tdebug_on(classify_debug_level, 1))
     tprintf("BL Matches =  ");
 
   MasterMatcher(Templates->Templates, int_features.size(), &int_features[0],
@@ -1323,7 +1532,6 @@ UNICHAR_ID *Classify::BaselineClassifier(
                 Templates->Class, matcher_debug_flags, 0,
                 Blob->bounding_box(), Results->CPResults, Results);
 
-  delete [] CharNormArray;
   CLASS_ID ClassId = Results->best_unichar_id;
   if (ClassId == INVALID_UNICHAR_ID || Results->best_match_index < 0)
     return NULL;
@@ -1358,7 +1566,8 @@ int Classify::CharNormClassifier(TBLOB *blob,
   // This is the length that is used for scaling ratings vs certainty.
   adapt_results->BlobLength =
       IntCastRounded(sample.outline_length() / kStandardFeatureLength);
-  GenericVector<UnicharRating> unichar_results;
+  GenericVector<UnicharRating>& unichar_results =
+      adapt_results->unichar_results;
   static_classifier_->UnicharClassifySample(sample, blob->denorm().pix(), 0,
                                             -1, &unichar_results);
   // Convert results to the format used internally by AdaptiveClassifier.
@@ -1374,9 +1583,9 @@ int Classify::CharNormTrainingSample(bool pruner_only,
                                      int keep_this,
                                      const TrainingSample& sample,
                                      GenericVector<UnicharRating>* results) {
-  results->clear();
-  ADAPT_RESULTS* adapt_results = new ADAPT_RESULTS();
-  adapt_results->Initialize();
+  // Truncated rather than cleared, to keep the memory of a reused vector.
+  results->truncate(0);
+  ADAPT_RESULTS* adapt_results = AcquireAdaptResults();
   // Compute the bounding box of the features.
   int num_features = sample.num_features();
   // Only the top and bottom of the blob_box are used by MasterMatcher, so
@@ -1385,10 +1594,12 @@ int Classify::CharNormTrainingSample(bool pruner_only,
                 sample.geo_feature(GeoTop), sample.geo_feature(GeoTop));
   // Compute the char_norm_array from the saved cn_feature.
   FEATURE norm_feature = sample.GetCNFeature();
-  uinT8* char_norm_array = new uinT8[unicharset.size()];
+  uinT8* char_norm_array = ADAPT_RESULTS::SizedArray(
+      unicharset.size(), &adapt_results->char_norm_array);
   int num_pruner_classes = MAX(unicharset.size(),
                                PreTrainedTemplates->NumClasses);
-  uinT8* pruner_norm_array = new uinT8[num_pruner_classes];
+  uinT8* pruner_norm_array = ADAPT_RESULTS::SizedArray(
+      num_pruner_classes, &adapt_results->pruner_norm_array);
   adapt_results->BlobLength =
       static_cast<int>(ActualOutlineLength(norm_feature) * 20 + 0.5);
   ComputeCharNormArrays(norm_feature, PreTrainedTemplates, char_norm_array,
@@ -1398,7 +1609,6 @@ int Classify::CharNormTrainingSample(bool pruner_only,
                pruner_norm_array,
                shape_table_ != NULL ? &shapetable_cutoffs_[0] : CharNormCutoffs,
                &adapt_results->CPResults);
-  delete [] pruner_norm_array;
   if (keep_this >= 0) {
     adapt_results->CPResults[0].Class = keep_this;
     adapt_results->CPResults.truncate(1);
@@ -1422,8 +1632,7 @@ int Classify::CharNormTrainingSample(bool pruner_only,
     }
     results->sort(&UnicharRating::SortDescendingRating);
   }
-  delete [] char_norm_array;
-  delete adapt_results;
+  ReleaseAdaptResults(adapt_results);
   return num_features;
 }                                /* CharNormTrainingSample */
 
@@ -1522,7 +1731,10 @@ void Classify::ConvertMatchesToChoices(const DENORM& denorm, const TBOX& box,
                         min_xheight, max_xheight, yshift,
                         adapted ? BCC_ADAPTED_CLASSIFIER
                                 : BCC_STATIC_CLASSIFIER);
-    choice->set_fonts(result.fonts);
+    if (classify_blob_fonts)
+      choice->set_fonts(result.fonts);
+    else
+      choice->set_top_fonts(result.fonts);
     temp_it.add_to_end(choice);
     contains_nonfrag |= !current_is_frag;  // update contains_nonfrag
     choices_length++;
@@ -1581,21 +1793,54 @@ void Classify::DebugAdaptiveClassifier(TBLOB *blob,
  * @note History: Tue Mar 12 08:50:11 1991, DSJ, Created.
  */
 void Classify::DoAdaptiveMatch(TBLOB *Blob, ADAPT_RESULTS *Results) {
+  IntFxScratch* scratch = AcquireFxScratch();
+  DoAdaptiveMatch(Blob, scratch, Results);
+  ReleaseFxScratch(scratch);
+}   /* DoAdaptiveMatch */
+
+void Classify::DoAdaptiveMatch(TBLOB *Blob, IntFxScratch* scratch,
+                               ADAPT_RESULTS *Results) {
   UNICHAR_ID *Ambiguities;
 
   INT_FX_RESULT_STRUCT fx_info;
-  GenericVector<INT_FEATURE_STRUCT> bl_features;
+  GenericVector<INT_FEATURE_STRUCT>& bl_features = scratch->bl_features;
   TrainingSample* sample =
       BlobToTrainingSample(*Blob, classify_nonlinear_norm, &fx_info,
-                           &bl_features);
+                           &bl_features, scratch);
   if (sample == NULL) return;
 
-  if (AdaptedTemplates->NumPermClasses < matcher_permanent_classes_min ||
+  // Learning never changes the snapshot, so parallel readers of it all see
+  // the same version.
+  ADAPT_TEMPLATES templates = AdaptedTemplates;
+  int version = adapted_templates_version_;
+  if (classify_from_snapshot_ && snapshot_templates_ != NULL) {
+    templates = snapshot_templates_;
+    version = snapshot_version_;
+  }
+
+  GenericVector<uinT8> cache_key;
+  if (classify_cache_ != NULL) {
+    BuildClassifyCacheKey(version, Blob->bounding_box(), fx_info, bl_features,
+                          *sample, &cache_key);
+    ClassifyCacheResult cached;
+    if (classify_cache_->Lookup(cache_key, &cached)) {
+      Results->BlobLength = cached.blob_length;
+      Results->HasNonfragment = cached.has_nonfragment;
+      Results->best_unichar_id = cached.best_unichar_id;
+      Results->best_match_index = cached.best_match_index;
+      Results->best_rating = cached.best_rating;
+      Results->match = cached.match;
+      delete sample;
+      return;
+    }
+  }
+
+  if (templates->NumPermClasses < matcher_permanent_classes_min ||
       tess_cn_matching) {
     CharNormClassifier(Blob, *sample, Results);
   } else {
     Ambiguities = BaselineClassifier(Blob, bl_features, fx_info,
-                                     AdaptedTemplates, Results);
+                                     templates, Results);
     if ((!Results->match.empty() &&
          MarginalMatch(Results->best_rating,
                        matcher_reliable_adaptive_result) &&
@@ -1605,7 +1850,7 @@ void Classify::DoAdaptiveMatch(TBLOB *Blob, ADAPT_RESULTS *Results) {
     } else if (Ambiguities && *Ambiguities >= 0 && !tess_bn_matching) {
       AmbigClassifier(bl_features, fx_info, Blob,
                       PreTrainedTemplates,
-                      AdaptedTemplates->Class,
+                      templates->Class,
                       Ambiguities,
                       Results);
     }
@@ -1617,8 +1862,19 @@ void Classify::DoAdaptiveMatch(TBLOB *Blob, ADAPT_RESULTS *Results) {
   // just adding a NULL classification.
   if (!Results->HasNonfragment || Results->match.empty())
     ClassifyAsNoise(Results);
+  if (classify_cache_ != NULL) {
+    ClassifyCacheResult result;
+    result.blob_length = Results->BlobLength;
+    result.has_nonfragment = Results->HasNonfragment;
+    result.best_unichar_id = Results->best_unichar_id;
+    result.best_match_index = Results->best_match_index;
+    result.best_rating = Results->best_rating;
+    result.match = Results->match;
+    classify_cache_->Insert(cache_key, result);
+  }
   delete sample;
-}   /* DoAdaptiveMatch */
+}
+
 
 /*---------------------------------------------------------------------------*/
 /**
@@ -1639,18 +1895,18 @@ void Classify::DoAdaptiveMatch(TBLOB *Blob, ADAPT_RESULTS *Results) {
  */
 UNICHAR_ID *Classify::GetAmbiguities(TBLOB *Blob,
                                      CLASS_ID CorrectClass) {
-  ADAPT_RESULTS *Results = new ADAPT_RESULTS();
+  ADAPT_RESULTS *Results = AcquireAdaptResults();
   UNICHAR_ID *Ambiguities;
   int i;
 
-  Results->Initialize();
   INT_FX_RESULT_STRUCT fx_info;
-  GenericVector<INT_FEATURE_STRUCT> bl_features;
+  IntFxScratch* scratch = AcquireFxScratch();
   TrainingSample* sample =
       BlobToTrainingSample(*Blob, classify_nonlinear_norm, &fx_info,
-                           &bl_features);
+                           &scratch->bl_features, scratch);
+  ReleaseFxScratch(scratch);
   if (sample == NULL) {
-    delete Results;
+    ReleaseAdaptResults(Results);
     return NULL;
   }
 
@@ -1672,7 +1928,7 @@ UNICHAR_ID *Classify::GetAmbiguities(TBLOB *Blob,
     Ambiguities[0] = -1;
   }
 
-  delete Results;
+  ReleaseAdaptResults(Results);
   return Ambiguities;
 }                              /* GetAmbiguities */
 
@@ -1809,7 +2065,7 @@ int Classify::MakeNewTemporaryConfig(ADAPT_TEMPLATES Templates,
   int i;
   int debug_level = NO_DEBUG;
 
-  if (classify_learning_debug_level >= 3)
+  if (tdebug_on(classify_learning_debug_level, 2))
     debug_level =
         PRINT_MATCH_SUMMARY | PRINT_FEATURE_MATCHES | PRINT_PROTO_MATCHES;
 
@@ -1818,7 +2074,7 @@ int Classify::MakeNewTemporaryConfig(ADAPT_TEMPLATES Templates,
 
   if (IClass->NumConfigs >= MAX_NUM_CONFIGS) {
     ++NumAdaptationsFailed;
-    if (classify_learning_debug_level >= 1)
+    if (tdebug_on(classify_learning_debug_level, 0))
       cprintf("Cannot make new temporary config: maximum number exceeded.\n");
     return -1;
   }
@@ -1845,7 +2101,7 @@ int Classify::MakeNewTemporaryConfig(ADAPT_TEMPLATES Templates,
                                  IClass, Class, TempProtoMask);
   if (MaxProtoId == NO_PROTO) {
     ++NumAdaptationsFailed;
-    if (classify_learning_debug_level >= 1)
+    if (tdebug_on(classify_learning_debug_level, 0))
       cprintf("Cannot make new temp protos: maximum number exceeded.\n");
     return -1;
   }
@@ -1856,7 +2112,7 @@ int Classify::MakeNewTemporaryConfig(ADAPT_TEMPLATES Templates,
   TempConfigFor(Class, ConfigId) = Config;
   copy_all_bits(TempProtoMask, Config->Protos, Config->ProtoVectorSize);
 
-  if (classify_learning_debug_level >= 1)
+  if (tdebug_on(classify_learning_debug_level, 0))
     cprintf("Making new temp config %d fontinfo id %d"
             " using %d old and %d new protos.\n",
             ConfigId, Config->FontinfoId,
@@ -1955,7 +2211,7 @@ PROTO_ID Classify::MakeNewTempProtos(FEATURE_SET Features,
 
     ConvertProto(Proto, Pid, IClass);
     AddProtoToProtoPruner(Proto, Pid, IClass,
-                          classify_learning_debug_level >= 2);
+                          tdebug_on(classify_learning_debug_level, 1));
 
     Class->TempProtos = push(Class->TempProtos, TempProto);
   }
@@ -1984,6 +2240,7 @@ void Classify::MakePermanent(ADAPT_TEMPLATES Templates,
   ADAPT_CLASS Class;
   PROTO_KEY ProtoKey;
 
+  if (Templates == AdaptedTemplates) AdaptedTemplatesChanged();
   Class = Templates->Class[ClassId];
   Config = TempConfigFor(Class, ConfigId);
 
@@ -2010,7 +2267,7 @@ void Classify::MakePermanent(ADAPT_TEMPLATES Templates,
   // Record permanent config.
   PermConfigFor(Class, ConfigId) = Perm;
 
-  if (classify_learning_debug_level >= 1) {
+  if (tdebug_on(classify_learning_debug_level, 0)) {
     tprintf("Making config %d for %s (ClassId %d) permanent:"
             " fontinfo id %d, ambiguities '",
             ConfigId, getDict().getUnicharset().debug_str(ClassId).string(),
@@ -2312,7 +2569,7 @@ int Classify::ShapeIDToClassID(int shape_id) const {
 // a permanent config.
 bool Classify::TempConfigReliable(CLASS_ID class_id,
                                   const TEMP_CONFIG &config) {
-  if (classify_learning_debug_level >= 1) {
+  if (tdebug_on(classify_learning_debug_level, 0)) {
     tprintf("NumTimesSeen for config of %s is %d\n",
             getDict().getUnicharset().debug_str(class_id).string(),
             config->NumTimesSeen);
@@ -2333,7 +2590,7 @@ bool Classify::TempConfigReliable(CLASS_ID class_id,
       if (ambig_class->NumPermConfigs == 0 &&
           ambig_class->MaxNumTimesSeen <
           matcher_min_examples_for_prototyping) {
-        if (classify_learning_debug_level >= 1) {
+        if (tdebug_on(classify_learning_debug_level, 0)) {
           tprintf("Ambig %s has not been seen enough times,"
                   " not making config for %s permanent\n",
                   getDict().getUnicharset().debug_str(
@@ -2351,7 +2608,7 @@ void Classify::UpdateAmbigsGroup(CLASS_ID class_id, TBLOB *Blob) {
   const UnicharIdVector *ambigs =
     getDict().getUnicharAmbigs().ReverseAmbigsForAdaption(class_id);
   int ambigs_size = (ambigs == NULL) ? 0 : ambigs->size();
-  if (classify_learning_debug_level >= 1) {
+  if (tdebug_on(classify_learning_debug_level, 0)) {
     tprintf("Running UpdateAmbigsGroup for %s class_id=%d\n",
             getDict().getUnicharset().debug_str(class_id).string(), class_id);
   }
@@ -2363,7 +2620,7 @@ void Classify::UpdateAmbigsGroup(CLASS_ID class_id, TBLOB *Blob) {
       const TEMP_CONFIG config =
         TempConfigFor(AdaptedTemplates->Class[ambig_class_id], cfg);
       if (config != NULL && TempConfigReliable(ambig_class_id, config)) {
-        if (classify_learning_debug_level >= 1) {
+        if (tdebug_on(classify_learning_debug_level, 0)) {
           tprintf("Making config %d of %s permanent\n", cfg,
                   getDict().getUnicharset().debug_str(
                       ambig_class_id).string());
@@ -26,6 +26,7 @@
 #include "intproto.h"
 #include "mfoutline.h"
 #include "scrollview.h"
+#include "serialis.h"
 #include "shapeclassifier.h"
 #include "shapetable.h"
 #include "unicity_table.h"
@@ -41,8 +42,32 @@ Classify::Classify()
                  this->params()),
       BOOL_MEMBER(classify_enable_learning, true, "Enable adaptive classifier",
                   this->params()),
+      BOOL_MEMBER(classify_blob_fonts, true,
+                  "Keep the scores of all the fonts of each blob choice, to"
+                  " find the fonts of words. Otherwise only the best two are"
+                  " kept",
+                  this->params()),
       INT_MEMBER(classify_debug_level, 0, "Classify debug level",
                  this->params()),
+      BOOL_MEMBER(classify_verify_simd_matcher, false,
+                  "Check the SIMD integer matcher against the scalar code",
+                  this->params()),
+      BOOL_MEMBER(classify_pack_int_templates, true,
+                  "Pack the static templates into one arena after loading",
+                  this->params()),
+      BOOL_MEMBER(classify_bound_class_pruner, true,
+                  "Skip class pruner tables that cannot reach the threshold",
+                  this->params()),
+      BOOL_MEMBER(classify_whitelist_pruner, false,
+                  "Class prune only the classes that can give a whitelisted"
+                  " char",
+                  this->params()),
+      INT_MEMBER(classify_cache_size, 0,
+                 "Number of blob classifications to cache, 0 for none",
+                 this->params()),
+      BOOL_MEMBER(classify_bound_matcher, false,
+                  "Stop matching a class once it cannot make the results",
+                  this->params()),
       INT_MEMBER(classify_norm_method, character, "Normalization Method   ...",
                  this->params()),
       double_MEMBER(classify_char_norm_range, 0.2,
@@ -172,12 +197,24 @@ Classify::Classify()
       NewPermanentTessCallback(FontSetDeleteCallback));
   AdaptedTemplates = NULL;
   BackupAdaptedTemplates = NULL;
+  model_ = NULL;
   PreTrainedTemplates = NULL;
   AllProtosOn = NULL;
   AllConfigsOn = NULL;
   AllConfigsOff = NULL;
   TempProtoMask = NULL;
   NormProtos = NULL;
+  classify_cache_ = NULL;
+  adapted_templates_version_ = 0;
+  results_version_ = 0;
+  snapshot_templates_ = NULL;
+  snapshot_version_ = -1;
+  classify_from_snapshot_ = false;
+  bound_matches_ = 0;
+  bound_match_cuts_ = 0;
+  bound_features_ = 0;
+  bound_features_skipped_ = 0;
+  whitelist_pruner_ = NULL;
 
   NumAdaptationsFailed = 0;
 
@@ -194,6 +231,8 @@ Classify::~Classify() {
   delete learn_debug_win_;
   delete learn_fragmented_word_debug_win_;
   delete learn_fragments_debug_win_;
+  delete classify_cache_;
+  fx_scratch_pool_.delete_data_pointers();
   delete[] CharNormCutoffs;
   delete[] BaselineCutoffs;
 }
@@ -204,6 +243,68 @@ Classify::~Classify() {
 void Classify::SetStaticClassifier(ShapeClassifier* static_classifier) {
   delete static_classifier_;
   static_classifier_ = static_classifier;
+  ClearClassifyCache();
+}
+
+void Classify::ClearClassifyCache() {
+  ++results_version_;
+  if (classify_cache_ != NULL) classify_cache_->Clear();
+}
+
+void Classify::AdaptedTemplatesChanged() {
+  ++adapted_templates_version_;
+  ClearClassifyCache();
+}
+
+void Classify::PublishAdaptedTemplates() {
+  if (AdaptedTemplates == NULL ||
+      (snapshot_templates_ != NULL &&
+       snapshot_version_ == adapted_templates_version_))
+    return;
+  ADAPT_TEMPLATES copy = CopyAdaptedTemplates(AdaptedTemplates);
+  if (snapshot_templates_ != NULL)
+    free_adapted_templates(snapshot_templates_);
+  snapshot_templates_ = copy;
+  snapshot_version_ = adapted_templates_version_;
+}
+
+void Classify::AdoptAdaptedTemplates(const Classify& source) {
+  // The versions of source only ever go up, so an equal version means the
+  // same templates.
+  if (snapshot_version_ == source.snapshot_version_ &&
+      (snapshot_templates_ != NULL) == (source.snapshot_templates_ != NULL))
+    return;
+  if (snapshot_templates_ != NULL)
+    free_adapted_templates(snapshot_templates_);
+  snapshot_templates_ = source.snapshot_templates_ != NULL
+      ? CopyAdaptedTemplates(source.snapshot_templates_) : NULL;
+  snapshot_version_ = source.snapshot_version_;
+}
+
+ADAPT_TEMPLATES Classify::CopyAdaptedTemplates(ADAPT_TEMPLATES templates) {
+  // Copy through the serialized form, which already knows how to walk all
+  // the pieces of the templates.
+  GenericVector<char> data;
+  TFile fp;
+  fp.OpenWrite(&data);
+  if (!SerializeAdaptedTemplates(templates, &fp)) return NULL;
+  TFile in;
+  in.Open(&data[0], data.size());
+  return DeSerializeAdaptedTemplates(&in);
+}
+
+IntFxScratch* Classify::AcquireFxScratch() {
+  IntFxScratch* scratch = NULL;
+  fx_scratch_mutex_.Lock();
+  if (!fx_scratch_pool_.empty()) scratch = fx_scratch_pool_.pop_back();
+  fx_scratch_mutex_.Unlock();
+  return scratch != NULL ? scratch : new IntFxScratch;
+}
+
+void Classify::ReleaseFxScratch(IntFxScratch* scratch) {
+  fx_scratch_mutex_.Lock();
+  fx_scratch_pool_.push_back(scratch);
+  fx_scratch_mutex_.Unlock();
 }
 
 // Moved from speckle.cpp
@@ -22,6 +22,7 @@
 #include "adaptive.h"
 #include "ccstruct.h"
 #include "classify.h"
+#include "classifycache.h"
 #include "dict.h"
 #include "featdefs.h"
 #include "fontinfo.h"
@@ -31,6 +32,7 @@
 #include "normalis.h"
 #include "ratngs.h"
 #include "ocrfeatures.h"
+#include "tessmodel.h"
 #include "unicity_table.h"
 
 class ScrollView;
@@ -44,6 +46,7 @@ static const int kBlankFontinfoId = -2;
 
 namespace tesseract {
 
+class ClassPruner;
 class ShapeClassifier;
 struct ShapeRating;
 class ShapeTable;
@@ -108,6 +111,20 @@ class Classify : public CCStruct {
   void PrintAdaptedTemplates(FILE *File, ADAPT_TEMPLATES Templates);
   void WriteAdaptedTemplates(FILE *File, ADAPT_TEMPLATES Templates);
   ADAPT_TEMPLATES ReadAdaptedTemplates(FILE *File);
+  // Writes Templates to fp in a binary form that DeSerializeAdaptedTemplates
+  // reads back, preceded by a checksum of the unicharset so that they are
+  // only ever read back with the same language data. Returns false on error.
+  bool SerializeAdaptedTemplates(ADAPT_TEMPLATES Templates, TFile* fp) const;
+  // Reads templates written by SerializeAdaptedTemplates, or returns NULL if
+  // the data is invalid or was written for a different unicharset.
+  ADAPT_TEMPLATES DeSerializeAdaptedTemplates(TFile* fp);
+  // Saves the adapted templates to data, so that a later LoadAdaptiveState,
+  // in this or another process, can start from what has been learned.
+  bool SaveAdaptiveState(GenericVector<char>* data) const;
+  // Replaces the adapted templates with ones saved by SaveAdaptiveState.
+  // Returns false, keeping the current templates, if they are invalid or
+  // were saved with different language data.
+  bool LoadAdaptiveState(const char* data, int size);
   /* normmatch.cpp ************************************************************/
   FLOAT32 ComputeNormMatch(CLASS_ID ClassId,
                            const FEATURE_STRUCT& feature, BOOL8 DebugMatch);
@@ -161,6 +178,11 @@ class Classify : public CCStruct {
                      const TBOX& blob_box,
                      const GenericVector<CP_RESULT_STRUCT>& results,
                      ADAPT_RESULTS* final_results);
+  // Returns the lowest integer matcher rating that, after the corrections of
+  // ComputeCorrectedRating, could still get a result added to final_results,
+  // or 0 if there is no such bound.
+  float MinUsefulMatchRating(int blob_length, int matcher_multiplier,
+                             const ADAPT_RESULTS& final_results) const;
   // Converts configs to fonts, and if the result is not adapted, and a
   // shape_table_ is present, the shape is expanded to include all
   // unichar_ids represented, before applying a set of corrections to the
@@ -253,14 +275,59 @@ class Classify : public CCStruct {
                              GenericVector<UnicharRating>* results);
   UNICHAR_ID *GetAmbiguities(TBLOB *Blob, CLASS_ID CorrectClass);
   void DoAdaptiveMatch(TBLOB *Blob, ADAPT_RESULTS *Results);
+  // Returns the cache of DoAdaptiveMatch results, or NULL if
+  // classify_cache_size was 0 when classification started.
+  const ClassifyCache* classify_cache() const { return classify_cache_; }
+  // Empties the cache of DoAdaptiveMatch results. Must be called whenever the
+  // static classifier changes.
+  void ClearClassifyCache();
+  // If classify_whitelist_pruner is set and the black and white lists
+  // disable some unichars, makes PruneClasses score only the classes of
+  // PreTrainedTemplates that can give an enabled unichar, so that the cost
+  // of the class pruner follows the size of the whitelist. Must be called
+  // whenever the enabled unichars change. The tables are cached for the
+  // last few sets of enabled unichars.
+  void SetUpWhitelistPruner();
+  // Returns a number that changes whenever ClearClassifyCache is called, so
+  // other caches of classifier results can tell when theirs are out of date.
+  int results_version() const { return results_version_; }
+  // Must be called whenever AdaptedTemplates changes. Clears the cache and
+  // marks any published snapshot as out of date.
+  void AdaptedTemplatesChanged();
+  // Makes a read-only copy of AdaptedTemplates, if they changed since the
+  // last call, for AdaptiveClassifier to use while classify_from_snapshot is
+  // set. Learning then goes on changing AdaptedTemplates without disturbing
+  // classification running in parallel, which sees a stable version until
+  // the next call. Must be called from the thread that runs the parallel
+  // classification, between runs, as it frees the previous copy.
+  void PublishAdaptedTemplates();
+  // Replaces the published snapshot with a copy of the one source last
+  // published, if that has changed since the last call, so that while
+  // classify_from_snapshot is set this classifies as source does. source
+  // must have loaded the same language.
+  void AdoptAdaptedTemplates(const Classify& source);
+  void set_classify_from_snapshot(bool value) {
+    if (value != classify_from_snapshot_) ++results_version_;
+    classify_from_snapshot_ = value;
+  }
   void AdaptToChar(TBLOB* Blob, CLASS_ID ClassId, int FontinfoId,
                    FLOAT32 Threshold, ADAPT_TEMPLATES adaptive_templates);
   void DisplayAdaptedChar(TBLOB* blob, INT_CLASS_STRUCT* int_class);
   bool AdaptableWord(WERD_RES* word);
   void EndAdaptiveClassifier();
+  TessModel* LoadTessModel(bool* loaded);
+  // Returns the process-wide cache of shared static classifier data.
+  static TessModelCache* GlobalModelCache();
+  // Returns a deep copy of templates, or NULL if it could not be made.
+  ADAPT_TEMPLATES CopyAdaptedTemplates(ADAPT_TEMPLATES templates);
   void SettupPass1();
   void SettupPass2();
   void AdaptiveClassifier(TBLOB *Blob, BLOB_CHOICE_LIST *Choices);
+  // Classifies each of blobs as AdaptiveClassifier does, appending a new
+  // BLOB_CHOICE_LIST for each to *choices, which the caller then owns. The
+  // results and feature buffers are set up once and shared by the batch.
+  void ClassifyBlobBatch(const GenericVector<TBLOB*>& blobs,
+                         GenericVector<BLOB_CHOICE_LIST*>* choices);
   void ClassifyAsNoise(ADAPT_RESULTS *Results);
   void ResetAdaptiveClassifierInternal();
   void SwitchAdaptiveClassifier();
@@ -313,7 +380,8 @@ class Classify : public CCStruct {
   // Ymean:  Rounded y center of mass of the blob.
   static void SetupBLCNDenorms(const TBLOB& blob, bool nonlinear_norm,
                                DENORM* bl_denorm, DENORM* cn_denorm,
-                               INT_FX_RESULT_STRUCT* fx_info);
+                               INT_FX_RESULT_STRUCT* fx_info,
+                               IntFxScratch* scratch = NULL);
 
   // Extracts sets of 3-D features of length kStandardFeatureLength (=12.8), as
   // (x,y) position and angle as measured counterclockwise from the vector
@@ -323,19 +391,34 @@ class Classify : public CCStruct {
   // number of cn features generated for each outline in the blob (in order).
   // Thus after the first outline, there were (*outline_cn_counts)[0] features,
   // after the second outline, there were (*outline_cn_counts)[1] features etc.
+  // If scratch is not NULL, its edge coordinate buffers are used for the
+  // non-linear normalization.
   static void ExtractFeatures(const TBLOB& blob,
                               bool nonlinear_norm,
                               GenericVector<INT_FEATURE_STRUCT>* bl_features,
                               GenericVector<INT_FEATURE_STRUCT>* cn_features,
                               INT_FX_RESULT_STRUCT* results,
-                              GenericVector<int>* outline_cn_counts);
+                              GenericVector<int>* outline_cn_counts,
+                              IntFxScratch* scratch = NULL);
+  // Returns feature extraction buffers for the sole use of the caller until
+  // it gives them back with ReleaseFxScratch. The blobs of one Classify may
+  // be classified on several threads at once, so each call gets its own.
+  IntFxScratch* AcquireFxScratch();
+  void ReleaseFxScratch(IntFxScratch* scratch);
+  // As AcquireFxScratch, for the match results of a blob, which come back
+  // initialized and empty, but keep their memory from the blobs before.
+  ADAPT_RESULTS* AcquireAdaptResults();
+  void ReleaseAdaptResults(ADAPT_RESULTS* results);
   /* float2int.cpp ************************************************************/
   void ClearCharNormArray(uinT8* char_norm_array);
   void ComputeIntCharNormArray(const FEATURE_STRUCT& norm_feature,
                                uinT8* char_norm_array);
   void ComputeIntFeatures(FEATURE_SET Features, INT_FEATURE_ARRAY IntFeatures);
   /* intproto.cpp *************************************************************/
-  INT_TEMPLATES ReadIntTemplates(FILE *File);
+  INT_TEMPLATES ReadIntTemplates(FILE *File,
+                                 inT64* font_tables_offset = NULL);
+  void ReadIntTemplatesFontTables(FILE *File, inT64 font_tables_offset);
+  void ReadFontTables(FILE *File, int version_id, bool swap);
   void WriteIntTemplates(FILE *File, INT_TEMPLATES Templates,
                          const UNICHARSET& target_unicharset);
   CLASS_ID GetClassToDebug(const char *Prompt, bool* adaptive_on,
@@ -387,7 +470,22 @@ class Classify : public CCStruct {
              "Prioritize blob division over chopping");
   INT_VAR_H(tessedit_single_match, FALSE, "Top choice only from CP");
   BOOL_VAR_H(classify_enable_learning, true, "Enable adaptive classifier");
+  BOOL_VAR_H(classify_blob_fonts, true,
+             "Keep the scores of all the fonts of each blob choice, to find"
+             " the fonts of words. Otherwise only the best two are kept");
   INT_VAR_H(classify_debug_level, 0, "Classify debug level");
+  BOOL_VAR_H(classify_verify_simd_matcher, false,
+             "Check the SIMD integer matcher against the scalar code");
+  BOOL_VAR_H(classify_pack_int_templates, true,
+             "Pack the static templates into one arena after loading");
+  BOOL_VAR_H(classify_bound_class_pruner, true,
+             "Skip class pruner tables that cannot reach the threshold");
+  BOOL_VAR_H(classify_whitelist_pruner, false,
+             "Class prune only the classes that can give a whitelisted char");
+  INT_VAR_H(classify_cache_size, 0,
+            "Number of blob classifications to cache, 0 for none");
+  BOOL_VAR_H(classify_bound_matcher, false,
+             "Stop matching a class once it cannot make the results");
 
   /* mfoutline.cpp ***********************************************************/
   /* control knobs used to control normalization of outlines */
@@ -469,6 +567,9 @@ class Classify : public CCStruct {
             "Integer Matcher Multiplier  0-255:   ");
 
   // Use class variables to hold onto built-in templates and adapted templates.
+  // When model_ is set, PreTrainedTemplates, NormProtos and shape_table_
+  // point into it and are not owned.
+  TessModel* model_;
   INT_TEMPLATES PreTrainedTemplates;
   ADAPT_TEMPLATES AdaptedTemplates;
   // The backup adapted templates are created from the previous page (only)
@@ -512,9 +613,65 @@ class Classify : public CCStruct {
   ShapeTable* shape_table_;
 
  private:
+  // AdaptiveClassifier and DoAdaptiveMatch using the given scratch buffers
+  // and a Results that is already initialized.
+  void AdaptiveClassifier(TBLOB *Blob, IntFxScratch* scratch,
+                          ADAPT_RESULTS *Results, BLOB_CHOICE_LIST *Choices);
+  void DoAdaptiveMatch(TBLOB *Blob, IntFxScratch* scratch,
+                       ADAPT_RESULTS *Results);
+  // Applies the count adjustments of PruneClasses to pruner.
+  void AdjustPrunerScores(const uinT16* expected_num_features,
+                          const uinT8* normalization_factors,
+                          ClassPruner* pruner);
+  // Returns true if class_id of PreTrainedTemplates can give a unichar that
+  // is enabled in unicharset.
+  bool ClassHasEnabledUnichar(int class_id) const;
+  // Frees the tables made by SetUpWhitelistPruner.
+  void ClearWhitelistPruners();
+
   Dict dict_;
   // The currently active static classifier.
   ShapeClassifier* static_classifier_;
+  // Results of DoAdaptiveMatch for recently seen features, if enabled.
+  ClassifyCache* classify_cache_;
+  // Incremented on every change to AdaptedTemplates.
+  int adapted_templates_version_;
+  // Incremented by ClearClassifyCache.
+  int results_version_;
+  // Copy of AdaptedTemplates as they were at snapshot_version_, made by
+  // PublishAdaptedTemplates, or NULL.
+  ADAPT_TEMPLATES snapshot_templates_;
+  int snapshot_version_;
+  // If true, AdaptiveClassifier reads snapshot_templates_, if there is one.
+  bool classify_from_snapshot_;
+  // Counts of the class matches and features matched by MasterMatcher, and
+  // of those that classify_bound_matcher cut short or skipped.
+  int bound_matches_;
+  int bound_match_cuts_;
+  inT64 bound_features_;
+  inT64 bound_features_skipped_;
+  CCUtilMutex bound_stats_mutex_;
+  // Feature extraction buffers not currently in use, kept for reuse.
+  GenericVector<IntFxScratch*> fx_scratch_pool_;
+  CCUtilMutex fx_scratch_mutex_;
+  // Match results not currently in use, kept for reuse. Freed by
+  // EndAdaptiveClassifier.
+  GenericVector<ADAPT_RESULTS*> adapt_results_pool_;
+  CCUtilMutex adapt_results_mutex_;
+  // The class pruners of PreTrainedTemplates for a set of enabled unichars,
+  // made by SetUpWhitelistPruner.
+  struct WhitelistPruner {
+    // The enabled flag of each unichar, as a string of '0' and '1'.
+    STRING enabled;
+    // Class pruners and bounds only, for the classes below.
+    INT_TEMPLATES templates;
+    // The class of PreTrainedTemplates of each class of templates.
+    GenericVector<int> classes;
+  };
+  // Tables for the most recently used sets of enabled unichars, last first.
+  GenericVector<WhitelistPruner*> whitelist_pruners_;
+  // The one that PruneClasses uses on PreTrainedTemplates, or NULL.
+  const WhitelistPruner* whitelist_pruner_;
 
   /* variables used to hold performance statistics */
   int NumAdaptationsFailed;
@@ -0,0 +1,148 @@
+///////////////////////////////////////////////////////////////////////
+// File:        classifycache.cpp
+// Description: Bounded LRU cache of adaptive classifier results, keyed
+//              on the integer features of a blob.
+//
+// (C) Copyright 2016, Google Inc.
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////
+
+#include "classifycache.h"
+
+#include <string.h>
+
+namespace tesseract {
+
+ClassifyCache::ClassifyCache(int capacity)
+  : capacity_(MAX(capacity, 1)), hits_(0), misses_(0),
+    newest_(-1), oldest_(-1) {
+  int num_buckets = 1;
+  while (num_buckets < 2 * capacity_) num_buckets *= 2;
+  buckets_.init_to_size(num_buckets, -1);
+  entries_.reserve(capacity_);
+}
+
+bool ClassifyCache::Lookup(const GenericVector<uinT8>& key,
+                           ClassifyCacheResult* result) {
+  uinT64 hash = Hash(key);
+  mutex_.Lock();
+  int index = Find(hash, key);
+  if (index < 0) {
+    ++misses_;
+    mutex_.Unlock();
+    return false;
+  }
+  ++hits_;
+  Unlink(index);
+  MakeNewest(index);
+  *result = entries_[index].result;
+  mutex_.Unlock();
+  return true;
+}
+
+void ClassifyCache::Insert(const GenericVector<uinT8>& key,
+                           const ClassifyCacheResult& result) {
+  uinT64 hash = Hash(key);
+  mutex_.Lock();
+  int index = Find(hash, key);
+  bool is_new = index < 0;
+  if (!is_new) {
+    // Another thread classified the same blob meanwhile.
+    Unlink(index);
+  } else if (entries_.size() < capacity_) {
+    index = entries_.size();
+    entries_.push_back(Entry());
+  } else {
+    index = oldest_;
+    Unlink(index);
+    UnlinkFromBucket(index);
+  }
+  Entry* entry = &entries_[index];
+  if (is_new) {
+    entry->hash = hash;
+    entry->key = key;
+    int bucket = static_cast<int>(hash & (buckets_.size() - 1));
+    entry->next_in_bucket = buckets_[bucket];
+    buckets_[bucket] = index;
+  }
+  entry->result = result;
+  MakeNewest(index);
+  mutex_.Unlock();
+}
+
+void ClassifyCache::Clear() {
+  mutex_.Lock();
+  entries_.truncate(0);
+  for (int b = 0; b < buckets_.size(); ++b) buckets_[b] = -1;
+  newest_ = oldest_ = -1;
+  mutex_.Unlock();
+}
+
+void ClassifyCache::ResetCounts() {
+  mutex_.Lock();
+  hits_ = misses_ = 0;
+  mutex_.Unlock();
+}
+
+// FNV-1a, which is plenty for keys that are compared in full anyway.
+uinT64 ClassifyCache::Hash(const GenericVector<uinT8>& key) {
+  uinT64 hash = 14695981039346656037ULL;
+  for (int i = 0; i < key.size(); ++i) {
+    hash ^= key[i];
+    hash *= 1099511628211ULL;
+  }
+  return hash;
+}
+
+int ClassifyCache::Find(uinT64 hash, const GenericVector<uinT8>& key) const {
+  int bucket = static_cast<int>(hash & (buckets_.size() - 1));
+  for (int index = buckets_[bucket]; index >= 0;
+       index = entries_[index].next_in_bucket) {
+    const Entry& entry = entries_[index];
+    if (entry.hash == hash && entry.key.size() == key.size() &&
+        (key.empty() || memcmp(&entry.key[0], &key[0], key.size()) == 0))
+      return index;
+  }
+  return -1;
+}
+
+void ClassifyCache::Unlink(int index) {
+  Entry* entry = &entries_[index];
+  if (entry->newer >= 0)
+    entries_[entry->newer].older = entry->older;
+  else
+    newest_ = entry->older;
+  if (entry->older >= 0)
+    entries_[entry->older].newer = entry->newer;
+  else
+    oldest_ = entry->newer;
+}
+
+void ClassifyCache::UnlinkFromBucket(int index) {
+  Entry* entry = &entries_[index];
+  int* link = &buckets_[static_cast<int>(entry->hash &
+                                         (buckets_.size() - 1))];
+  while (*link != index) link = &entries_[*link].next_in_bucket;
+  *link = entry->next_in_bucket;
+  entry->key.truncate(0);
+}
+
+void ClassifyCache::MakeNewest(int index) {
+  Entry* entry = &entries_[index];
+  entry->newer = -1;
+  entry->older = newest_;
+  if (newest_ >= 0) entries_[newest_].newer = index;
+  newest_ = index;
+  if (oldest_ < 0) oldest_ = index;
+}
+
+}  // namespace tesseract
@@ -0,0 +1,104 @@
+///////////////////////////////////////////////////////////////////////
+// File:        classifycache.h
+// Description: Bounded LRU cache of adaptive classifier results, keyed
+//              on the integer features of a blob.
+//
+// (C) Copyright 2016, Google Inc.
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////
+
+#ifndef TESSERACT_CLASSIFY_CLASSIFYCACHE_H_
+#define TESSERACT_CLASSIFY_CLASSIFYCACHE_H_
+
+#include "ccutil.h"
+#include "genericvector.h"
+#include "host.h"
+#include "shapetable.h"
+#include "unichar.h"
+
+namespace tesseract {
+
+// The parts of an ADAPT_RESULTS that DoAdaptiveMatch produces.
+struct ClassifyCacheResult {
+  ClassifyCacheResult()
+    : blob_length(0), has_nonfragment(false),
+      best_unichar_id(INVALID_UNICHAR_ID), best_match_index(-1),
+      best_rating(0.0f) {}
+
+  inT32 blob_length;
+  bool has_nonfragment;
+  UNICHAR_ID best_unichar_id;
+  int best_match_index;
+  float best_rating;
+  GenericVector<UnicharRating> match;
+};
+
+// Remembers the results of the last few blobs that were classified, so a
+// blob whose features are identical to an earlier one, as is common with
+// repeated glyphs in forms and tables, skips the classifiers. The key is an
+// arbitrary byte string built by the caller from everything the result
+// depends on. Keys are compared in full, so a hash collision can never
+// return the wrong result. All methods are thread-safe.
+class ClassifyCache {
+ public:
+  explicit ClassifyCache(int capacity);
+
+  int capacity() const { return capacity_; }
+  int hits() const { return hits_; }
+  int misses() const { return misses_; }
+
+  // Copies the result for key to *result and returns true, making it the
+  // most recently used, or returns false and counts a miss.
+  bool Lookup(const GenericVector<uinT8>& key, ClassifyCacheResult* result);
+  // Adds result for key, evicting the least recently used entry if the cache
+  // is full.
+  void Insert(const GenericVector<uinT8>& key,
+              const ClassifyCacheResult& result);
+  // Forgets all entries, but keeps the hit and miss counts.
+  void Clear();
+  // Sets the hit and miss counts to zero.
+  void ResetCounts();
+
+ private:
+  struct Entry {
+    uinT64 hash;
+    GenericVector<uinT8> key;
+    ClassifyCacheResult result;
+    // Neighbours in the recency list, which starts with the most recent.
+    int newer;
+    int older;
+    // Next entry in the same hash bucket.
+    int next_in_bucket;
+  };
+
+  static uinT64 Hash(const GenericVector<uinT8>& key);
+  // Returns the index of the entry for key or -1. Must hold mutex_.
+  int Find(uinT64 hash, const GenericVector<uinT8>& key) const;
+  // Removes entries_[index] from the recency list or its bucket.
+  void Unlink(int index);
+  void UnlinkFromBucket(int index);
+  // Puts entries_[index] at the front of the recency list.
+  void MakeNewest(int index);
+
+  int capacity_;
+  int hits_;
+  int misses_;
+  GenericVector<Entry> entries_;
+  GenericVector<int> buckets_;
+  int newest_;
+  int oldest_;
+  CCUtilMutex mutex_;
+};
+
+}  // namespace tesseract
+
+#endif  // TESSERACT_CLASSIFY_CLASSIFYCACHE_H_
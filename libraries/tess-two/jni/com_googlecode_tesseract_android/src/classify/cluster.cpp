@@ -17,11 +17,14 @@
  ******************************************************************************/
 #include "const.h"
 #include "cluster.h"
+#include "ccutil.h"
 #include "emalloc.h"
 #include "genericheap.h"
 #include "helpers.h"
 #include "kdpair.h"
 #include "matrix.h"
+#include "tesscallback.h"
+#include "threadpool.h"
 #include "tprintf.h"
 #include "danerror.h"
 #include "freelist.h"
@@ -200,6 +203,15 @@ struct ClusteringContext {
   inT32 next;  // next candidate to be used
 };
 
+// For use with KDWalk / CollectCluster and FindNeighborOf: the clusters of
+// the kd-tree in the order of the walk, and the nearest neighbor of each.
+struct NeighborJob {
+  KDTREE *tree;
+  GenericVector<CLUSTER *> clusters;
+  GenericVector<CLUSTER *> neighbors;
+  GenericVector<FLOAT32> distances;
+};
+
 typedef FLOAT64 (*DENSITYFUNC) (inT32);
 typedef FLOAT64 (*SOLVEFUNC) (CHISTRUCT *, double);
 
@@ -223,6 +235,9 @@ static const FLOAT64 kNormalMagnitude =
     (2.0 * NORMALEXTENT) / (SqrtOf2Pi * BUCKETTABLESIZE);
 static const FLOAT64 kNormalMean = BUCKETTABLESIZE / 2;
 
+// Guards the chi-squared values that ComputeChiSquared keeps.
+static tesseract::CCUtilMutex chi_squared_mutex;
+
 /** define lookup tables used to compute the number of histogram buckets
   that should be used for a given number of samples. */
 #define LOOKUPTABLESIZE   8
@@ -239,11 +254,19 @@ static const uinT16 kBucketsTable[LOOKUPTABLESIZE] = {
 /*-------------------------------------------------------------------------
           Private Function Prototypes
 --------------------------------------------------------------------------*/
-void CreateClusterTree(CLUSTERER *Clusterer);
+void CreateClusterTree(CLUSTERER *Clusterer, int NumThreads);
 
 void MakePotentialClusters(ClusteringContext *context, CLUSTER *Cluster,
                            inT32 Level);
 
+void AddPotentialCluster(ClusteringContext *context, CLUSTER *Cluster,
+                         CLUSTER *Neighbor, FLOAT32 Distance);
+
+void CollectCluster(GenericVector<CLUSTER *> *clusters, CLUSTER *Cluster,
+                    inT32 Level);
+
+void FindNeighborOf(NeighborJob *job, int index);
+
 CLUSTER *FindNearestNeighbor(KDTREE *Tree,
                              CLUSTER *Cluster,
                              FLOAT32 *Distance);
@@ -513,7 +536,7 @@ SAMPLE* MakeSample(CLUSTERER * Clusterer, const FLOAT32* Feature,
 LIST ClusterSamples(CLUSTERER *Clusterer, CLUSTERCONFIG *Config) {
   //only create cluster tree if samples have never been clustered before
   if (Clusterer->Root == NULL)
-    CreateClusterTree(Clusterer);
+    CreateClusterTree(Clusterer, Config->NumThreads);
 
   //deallocate the old prototype list if one exists
   FreeProtoList (&Clusterer->ProtoList);
@@ -697,11 +720,13 @@ FLOAT32 StandardDeviation(PROTOTYPE *Proto, uinT16 Dimension) {
  * sub-clusters.  The root node of the tree conceptually contains
  * all of the samples.
  * @param Clusterer data structure holdings samples to be clustered
+ * @param NumThreads  number of threads to find the initial nearest
+ *        neighbors with, 1 or less to find them serially
  * @return  None (the Clusterer data structure is changed)
  * @note Exceptions:  None
  * @note History: 5/29/89, DSJ, Created.
  */
-void CreateClusterTree(CLUSTERER *Clusterer) {
+void CreateClusterTree(CLUSTERER *Clusterer, int NumThreads) {
   ClusteringContext context;
   ClusterPair HeapEntry;
   TEMPCLUSTER *PotentialCluster;
@@ -713,7 +738,27 @@ void CreateClusterTree(CLUSTERER *Clusterer) {
     Emalloc(Clusterer->NumberOfSamples * sizeof(TEMPCLUSTER));
   context.next = 0;
   context.heap = new ClusterHeap(Clusterer->NumberOfSamples);
-  KDWalk(context.tree, (void_proc)MakePotentialClusters, &context);
+  if (NumThreads > 1) {
+    // The searches only read the kd-tree, so they can run in parallel. The
+    // potential clusters are then added in the order of the walk, which
+    // makes the heap, and so the cluster tree, the same as the serial one.
+    NeighborJob job;
+    job.tree = context.tree;
+    KDWalk(context.tree, (void_proc)CollectCluster, &job.clusters);
+    job.neighbors.init_to_size(job.clusters.size(), NULL);
+    job.distances.init_to_size(job.clusters.size(), 0.0f);
+    tesseract::ThreadPool pool(NumThreads);
+    TessCallback1<int> *find = NewPermanentTessCallback(&FindNeighborOf,
+                                                        &job);
+    pool.ParallelFor(job.clusters.size(), find);
+    delete find;
+    for (int i = 0; i < job.clusters.size(); ++i) {
+      AddPotentialCluster(&context, job.clusters[i], job.neighbors[i],
+                          job.distances[i]);
+    }
+  } else {
+    KDWalk(context.tree, (void_proc)MakePotentialClusters, &context);
+  }
 
   // form potential clusters into actual clusters - always do "best" first
   while (context.heap->Pop(&HeapEntry)) {
@@ -770,19 +815,57 @@ void CreateClusterTree(CLUSTERER *Clusterer) {
  */
 void MakePotentialClusters(ClusteringContext *context,
                            CLUSTER *Cluster, inT32 Level) {
+  FLOAT32 Distance;
+  CLUSTER *Neighbor = FindNearestNeighbor(context->tree, Cluster, &Distance);
+  AddPotentialCluster(context, Cluster, Neighbor, Distance);
+}                                // MakePotentialClusters
+
+/**
+ * This routine pushes the potential cluster of Cluster and its nearest
+ * neighbor on the heap of context, unless there is no neighbor.
+ * @param context  ClusteringContext (see definition above)
+ * @param Cluster  cluster to make a potential cluster of
+ * @param Neighbor  nearest neighbor of Cluster, or NULL
+ * @param Distance  distance from Cluster to Neighbor
+ */
+void AddPotentialCluster(ClusteringContext *context, CLUSTER *Cluster,
+                         CLUSTER *Neighbor, FLOAT32 Distance) {
+  if (Neighbor == NULL) return;
   ClusterPair HeapEntry;
   int next = context->next;
   context->candidates[next].Cluster = Cluster;
+  context->candidates[next].Neighbor = Neighbor;
   HeapEntry.data = &(context->candidates[next]);
-  context->candidates[next].Neighbor =
-      FindNearestNeighbor(context->tree,
-                          context->candidates[next].Cluster,
-                          &HeapEntry.key);
-  if (context->candidates[next].Neighbor != NULL) {
-    context->heap->Push(&HeapEntry);
-    context->next++;
-  }
-}                                // MakePotentialClusters
+  HeapEntry.key = Distance;
+  context->heap->Push(&HeapEntry);
+  context->next++;
+}                                // AddPotentialCluster
+
+/**
+ * This routine is designed to be used in concert with the
+ * KDWalk routine.  It appends each cluster in the kd-tree
+ * being walked to clusters.
+ * @param clusters  clusters visited so far
+ * @param Cluster  current cluster being visited in kd-tree walk
+ * @param Level  level of this cluster in the kd-tree
+ */
+void CollectCluster(GenericVector<CLUSTER *> *clusters, CLUSTER *Cluster,
+                    inT32 Level) {
+  clusters->push_back(Cluster);
+}                                // CollectCluster
+
+/**
+ * This routine finds the nearest neighbor of the cluster at
+ * index in job. Each index only writes its own results, so
+ * the indices may be run in parallel.
+ * @param job  NeighborJob (see definition above)
+ * @param index  index of the cluster in job
+ */
+void FindNeighborOf(NeighborJob *job, int index) {
+  job->neighbors[index] = FindNearestNeighbor(job->tree,
+                                              job->clusters[index],
+                                              &job->distances[index]);
+}                                // FindNeighborOf
 
 /**
  * This routine searches the specified kd-tree for the nearest
@@ -1880,6 +1963,7 @@ ComputeChiSquared (uinT16 DegreesOfFreedom, FLOAT64 Alpha)
 
   CHISTRUCT *OldChiSquared;
   CHISTRUCT SearchKey;
+  FLOAT64 ChiSquared;
 
   // limit the minimum alpha that can be used - if alpha is too small
   //      it may not be possible to compute chi-squared.
@@ -1891,6 +1975,8 @@ ComputeChiSquared (uinT16 DegreesOfFreedom, FLOAT64 Alpha)
      for the specified number of degrees of freedom.  Search the list for
      the desired chi-squared. */
   SearchKey.Alpha = Alpha;
+  // Classes may be clustered in parallel, sharing the lists.
+  chi_squared_mutex.Lock();
   OldChiSquared = (CHISTRUCT *) first_node (search (ChiWith[DegreesOfFreedom],
     &SearchKey, AlphaMatch));
 
@@ -1905,8 +1991,10 @@ ComputeChiSquared (uinT16 DegreesOfFreedom, FLOAT64 Alpha)
   else {
     // further optimization might move OldChiSquared to front of list
   }
+  ChiSquared = OldChiSquared->ChiSquared;
+  chi_squared_mutex.Unlock();
 
-  return (OldChiSquared->ChiSquared);
+  return (ChiSquared);
 
 }                                // ComputeChiSquared
 
@@ -2472,8 +2560,8 @@ MultipleCharSamples (CLUSTERER * Clusterer,
 CLUSTER * Cluster, FLOAT32 MaxIllegal)
 #define ILLEGAL_CHAR    2
 {
-  static BOOL8 *CharFlags = NULL;
-  static inT32 NumFlags = 0;
+  BOOL8 *CharFlags;
+  inT32 NumFlags;
   int i;
   LIST SearchState;
   SAMPLE *Sample;
@@ -2486,13 +2574,9 @@ CLUSTER * Cluster, FLOAT32 MaxIllegal)
   NumCharInCluster = Cluster->SampleCount;
   NumIllegalInCluster = 0;
 
-  if (Clusterer->NumChar > NumFlags) {
-    if (CharFlags != NULL)
-      memfree(CharFlags);
-    NumFlags = Clusterer->NumChar;
-    CharFlags = (BOOL8 *) Emalloc (NumFlags * sizeof (BOOL8));
-  }
-
+  // Classes may be clustered in parallel, so each call has its own flags.
+  NumFlags = Clusterer->NumChar;
+  CharFlags = (BOOL8 *) Emalloc (NumFlags * sizeof (BOOL8));
   for (i = 0; i < NumFlags; i++)
     CharFlags[i] = FALSE;
 
@@ -2512,10 +2596,12 @@ CLUSTER * Cluster, FLOAT32 MaxIllegal)
       PercentIllegal = (FLOAT32) NumIllegalInCluster / NumCharInCluster;
       if (PercentIllegal > MaxIllegal) {
         destroy(SearchState);
+        memfree(CharFlags);
         return (TRUE);
       }
     }
   }
+  memfree(CharFlags);
   return (FALSE);
 
 }                                // MultipleCharSamples
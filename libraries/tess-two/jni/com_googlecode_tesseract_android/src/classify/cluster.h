@@ -53,6 +53,7 @@ typedef struct {                 // parameters to control clustering
   FLOAT32 Independence;          // desired independence between dimensions
   FLOAT64 Confidence;            // desired confidence in prototypes created
   int MagicSamples;              // Ideal number of samples in a cluster.
+  int NumThreads;                // threads to build the cluster tree with
 } CLUSTERCONFIG;
 
 typedef enum {
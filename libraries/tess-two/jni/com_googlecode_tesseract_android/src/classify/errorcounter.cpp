@@ -21,6 +21,9 @@
 #include "sampleiterator.h"
 #include "shapeclassifier.h"
 #include "shapetable.h"
+#include "stagetimer.h"
+#include "tesscallback.h"
+#include "threadpool.h"
 #include "trainingsample.h"
 #include "trainingsampleset.h"
 #include "unicity_table.h"
@@ -97,6 +100,124 @@ double ErrorCounter::ComputeErrorRate(ShapeClassifier* classifier,
   return unscaled_error;
 }
 
+// Arguments for classifying the shards of the samples in parallel.
+struct ClassifyShardJob {
+  const GenericVector<ShapeClassifier*>* classifiers;
+  const GenericVector<Pix*>* page_images;
+  const GenericVector<TrainingSample*>* samples;
+  // Outputs, indexed by sample.
+  GenericVector<GenericVector<UnicharRating> >* results;
+  GenericVector<double>* latencies;
+};
+
+// Classifies the shard of the samples given to the classifier of the same
+// index, timing each sample.
+static void ClassifyShard(ClassifyShardJob* job, int shard) {
+  int num_samples = job->samples->size();
+  int num_shards = job->classifiers->size();
+  int end = static_cast<int>(static_cast<inT64>(num_samples) * (shard + 1) /
+                             num_shards);
+  ShapeClassifier* classifier = (*job->classifiers)[shard];
+  for (int s = static_cast<int>(static_cast<inT64>(num_samples) * shard /
+                                num_shards);
+       s < end; ++s) {
+    const TrainingSample& sample = *(*job->samples)[s];
+    int page_index = sample.page_num();
+    Pix* page_pix = 0 <= page_index && page_index < job->page_images->size()
+                  ? (*job->page_images)[page_index] : NULL;
+    double start = StageTimings::NowMillis();
+    classifier->UnicharClassifySample(sample, page_pix, 0, INVALID_UNICHAR_ID,
+                                      &(*job->results)[s]);
+    (*job->latencies)[s] = StageTimings::NowMillis() - start;
+  }
+}
+
+// Tests classifiers on shards of the samples in parallel, computing the error
+// rate and throughput. See errorcounter.h for description of arguments.
+double ErrorCounter::ComputeErrorRateInParallel(
+    const GenericVector<ShapeClassifier*>& classifiers,
+    int report_level, CountTypes boosting_mode,
+    const FontInfoTable& fontinfo_table,
+    const GenericVector<Pix*>& page_images, SampleIterator* it,
+    double* unichar_error,  double* scaled_error, STRING* fonts_report) {
+  int fontsize = it->sample_set()->NumFonts();
+  ErrorCounter counter(classifiers[0]->GetUnicharset(), fontsize);
+  GenericVector<TrainingSample*> samples;
+  GenericVector<int> global_indices;
+  for (it->Begin(); !it->AtEnd(); it->Next()) {
+    samples.push_back(it->MutableSample());
+    global_indices.push_back(it->GlobalSampleIndex());
+  }
+  int total_samples = samples.size();
+  GenericVector<GenericVector<UnicharRating> > results;
+  results.init_to_size(total_samples, GenericVector<UnicharRating>());
+  GenericVector<double> latencies;
+  latencies.init_to_size(total_samples, 0.0);
+  ClassifyShardJob job;
+  job.classifiers = &classifiers;
+  job.page_images = &page_images;
+  job.samples = &samples;
+  job.results = &results;
+  job.latencies = &latencies;
+  double start = StageTimings::NowMillis();
+  if (classifiers.size() > 1) {
+    ThreadPool pool(classifiers.size());
+    TessCallback1<int>* callback =
+        NewPermanentTessCallback(&ClassifyShard, &job);
+    pool.ParallelFor(classifiers.size(), callback);
+    delete callback;
+  } else {
+    ClassifyShard(&job, 0);
+  }
+  double total_time = (StageTimings::NowMillis() - start) / 1000.0;
+  // Accumulate the errors in sample order, exactly as ComputeErrorRate.
+  int error_samples = report_level > 3 ? report_level * report_level : 0;
+  for (int s = 0; s < total_samples; ++s) {
+    TrainingSample* mutable_sample = samples[s];
+    bool debug_it = false;
+    int correct_id = mutable_sample->class_id();
+    if (counter.unicharset_.has_special_codes() &&
+        (correct_id == UNICHAR_SPACE || correct_id == UNICHAR_JOINED ||
+         correct_id == UNICHAR_BROKEN)) {
+      debug_it = counter.AccumulateJunk(report_level > 3, results[s],
+                                        mutable_sample);
+    } else {
+      debug_it = counter.AccumulateErrors(report_level > 3, boosting_mode,
+                                          fontinfo_table, results[s],
+                                          mutable_sample);
+    }
+    if (debug_it && error_samples > 0) {
+      int page_index = mutable_sample->page_num();
+      Pix* page_pix = 0 <= page_index && page_index < page_images.size()
+                    ? page_images[page_index] : NULL;
+      tprintf("Error on sample %d: %s Classifier debug output:\n",
+              global_indices[s],
+              it->sample_set()->SampleToString(*mutable_sample).string());
+      classifiers[0]->DebugDisplay(*mutable_sample, page_pix, correct_id);
+      --error_samples;
+    }
+  }
+  double unscaled_error = counter.ReportErrors(report_level, boosting_mode,
+                                               fontinfo_table, *it,
+                                               unichar_error, fonts_report);
+  if (scaled_error != NULL) *scaled_error = counter.scaled_error_;
+  if (report_level > 1 && total_samples > 0) {
+    latencies.sort();
+    tprintf("Classified %d samples on %d threads in %.2fs"
+            " at %.1f samples/sec\n",
+            total_samples, classifiers.size(), total_time,
+            total_time > 0.0 ? total_samples / total_time : 0.0);
+    // Latencies in microseconds, as for the μs/char of ComputeErrorRate.
+    tprintf("Latency per sample: p50=%.1fμs p90=%.1fμs p99=%.1fμs"
+            " max=%.1fμs\n",
+            1000.0 * latencies[total_samples / 2],
+            1000.0 * latencies[total_samples * 9 / 10],
+            1000.0 * latencies[total_samples * 99 / 100],
+            1000.0 * latencies.back());
+  }
+  return unscaled_error;
+}
+
 // Tests a pair of classifiers, debugging errors of the new against the old.
 // See errorcounter.h for description of arguments.
 // Iterates over the samples, calling the classifiers in normal/silent mode.
@@ -127,6 +127,21 @@ class ErrorCounter {
                                  double* unichar_error,
                                  double* scaled_error,
                                  STRING* fonts_report);
+  // As ComputeErrorRate, but measures throughput, sharding the samples across
+  // one thread per classifier. The classifiers must not share mutable state,
+  // as each is called from its own thread. The errors are counted and reported
+  // exactly as by ComputeErrorRate, and at report_level > 1, the samples/sec
+  // and the distribution of the wall-clock latency of each sample are
+  // reported too. The debug output of report_level > 3 uses classifiers[0].
+  static double ComputeErrorRateInParallel(
+      const GenericVector<ShapeClassifier*>& classifiers,
+      int report_level, CountTypes boosting_mode,
+      const FontInfoTable& fontinfo_table,
+      const GenericVector<Pix*>& page_images,
+      SampleIterator* it,
+      double* unichar_error,
+      double* scaled_error,
+      STRING* fonts_report);
   // Tests a pair of classifiers, debugging errors of the new against the old.
   // See errorcounter.h for description of arguments.
   // Iterates over the samples, calling the classifiers in normal/silent mode.
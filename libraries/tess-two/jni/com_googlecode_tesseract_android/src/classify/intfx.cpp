@@ -80,10 +80,16 @@ namespace tesseract {
 // is now a member of Classify.
 TrainingSample* BlobToTrainingSample(
     const TBLOB& blob, bool nonlinear_norm, INT_FX_RESULT_STRUCT* fx_info,
-    GenericVector<INT_FEATURE_STRUCT>* bl_features) {
-  GenericVector<INT_FEATURE_STRUCT> cn_features;
+    GenericVector<INT_FEATURE_STRUCT>* bl_features, IntFxScratch* scratch) {
+  GenericVector<INT_FEATURE_STRUCT> local_cn_features;
+  GenericVector<INT_FEATURE_STRUCT>& cn_features =
+      scratch != NULL ? scratch->cn_features : local_cn_features;
+  if (scratch != NULL) {
+    bl_features->truncate(0);
+    cn_features.truncate(0);
+  }
   Classify::ExtractFeatures(blob, nonlinear_norm, bl_features,
-                            &cn_features, fx_info, NULL);
+                            &cn_features, fx_info, NULL, scratch);
   // TODO(rays) Use blob->PreciseBoundingBox() instead.
   TBOX box = blob.bounding_box();
   TrainingSample* sample = NULL;
@@ -132,7 +138,8 @@ TrainingSample* BlobToTrainingSample(
 // Ymean:  Rounded y center of mass of the blob.
 void Classify::SetupBLCNDenorms(const TBLOB& blob, bool nonlinear_norm,
                                 DENORM* bl_denorm, DENORM* cn_denorm,
-                                INT_FX_RESULT_STRUCT* fx_info) {
+                                INT_FX_RESULT_STRUCT* fx_info,
+                                IntFxScratch* scratch) {
   // Compute 1st and 2nd moments of the original outline.
   FCOORD center, second_moments;
   int length = blob.ComputeMoments(&center, &second_moments);
@@ -149,14 +156,18 @@ void Classify::SetupBLCNDenorms(const TBLOB& blob, bool nonlinear_norm,
                                 1.0f, 1.0f, 128.0f, 128.0f);
   // Setup the denorm for character normalization.
   if (nonlinear_norm) {
-    GenericVector<GenericVector<int> > x_coords;
-    GenericVector<GenericVector<int> > y_coords;
+    GenericVector<GenericVector<int> > local_x_coords;
+    GenericVector<GenericVector<int> > local_y_coords;
+    GenericVector<GenericVector<int> >* x_coords =
+        scratch != NULL ? &scratch->x_coords : &local_x_coords;
+    GenericVector<GenericVector<int> >* y_coords =
+        scratch != NULL ? &scratch->y_coords : &local_y_coords;
     TBOX box;
     blob.GetPreciseBoundingBox(&box);
     box.pad(1, 1);
-    blob.GetEdgeCoords(box, &x_coords, &y_coords);
+    blob.GetEdgeCoords(box, x_coords, y_coords);
     cn_denorm->SetupNonLinear(&blob.denorm(), box, MAX_UINT8, MAX_UINT8,
-                              0.0f, 0.0f, x_coords, y_coords);
+                              0.0f, 0.0f, *x_coords, *y_coords);
   } else {
     cn_denorm->SetupNormalization(NULL, NULL, &blob.denorm(),
                                   center.x(), center.y(),
@@ -320,6 +331,32 @@ static int GatherPoints(const C_OUTLINE* outline, double feature_length,
   return index;
 }
 
+// Extracts features from the polygonal approximation from startpt to
+// lastpt, inclusive, and appends them to features, and, if denorm2 is not
+// NULL, also extracts them with denorm2 and appends those to features2, in
+// the same walk of the polygon.
+static void ExtractPolygonFeatures(
+    const EDGEPT* startpt, const EDGEPT* lastpt,
+    const DENORM& denorm, const DENORM* denorm2, double feature_length,
+    GenericVector<INT_FEATURE_STRUCT>* features,
+    GenericVector<INT_FEATURE_STRUCT>* features2) {
+  const EDGEPT* endpt = lastpt->next;
+  const EDGEPT* pt = startpt;
+  do {
+    FCOORD start_pt(pt->pos.x, pt->pos.y);
+    FCOORD end_pt(pt->next->pos.x, pt->next->pos.y);
+    FCOORD start_pos, end_pos;
+    denorm.LocalNormTransform(start_pt, &start_pos);
+    denorm.LocalNormTransform(end_pt, &end_pos);
+    ComputeFeatures(start_pos, end_pos, feature_length, features);
+    if (denorm2 != NULL) {
+      denorm2->LocalNormTransform(start_pt, &start_pos);
+      denorm2->LocalNormTransform(end_pt, &end_pos);
+      ComputeFeatures(start_pos, end_pos, feature_length, features2);
+    }
+  } while ((pt = pt->next) != endpt);
+}
+
 // Extracts Tesseract features and appends them to the features vector.
 // Startpt to lastpt, inclusive, MUST have the same src_outline member,
 // which may be NULL. The vector from lastpt to its next is included in
@@ -423,14 +460,8 @@ static void ExtractFeaturesFromRun(
     }
   } else {
     // There is no outline, so we are forced to use the polygonal approximation.
-    const EDGEPT* pt = startpt;
-    do {
-      FCOORD start_pos(pt->pos.x, pt->pos.y);
-      FCOORD end_pos(pt->next->pos.x, pt->next->pos.y);
-      denorm.LocalNormTransform(start_pos, &start_pos);
-      denorm.LocalNormTransform(end_pos, &end_pos);
-      ComputeFeatures(start_pos, end_pos, feature_length, features);
-    } while ((pt = pt->next) != endpt);
+    ExtractPolygonFeatures(startpt, lastpt, denorm, NULL, feature_length,
+                           features, NULL);
   }
 }
 
@@ -447,10 +478,12 @@ void Classify::ExtractFeatures(const TBLOB& blob,
                                GenericVector<INT_FEATURE_STRUCT>* bl_features,
                                GenericVector<INT_FEATURE_STRUCT>* cn_features,
                                INT_FX_RESULT_STRUCT* results,
-                               GenericVector<int>* outline_cn_counts) {
+                               GenericVector<int>* outline_cn_counts,
+                               IntFxScratch* scratch) {
   DENORM bl_denorm, cn_denorm;
   tesseract::Classify::SetupBLCNDenorms(blob, nonlinear_norm,
-                                        &bl_denorm, &cn_denorm, results);
+                                        &bl_denorm, &cn_denorm, results,
+                                        scratch);
   if (outline_cn_counts != NULL)
     outline_cn_counts->truncate(0);
   // Iterate the outlines.
@@ -470,10 +503,18 @@ void Classify::ExtractFeatures(const TBLOB& blob,
       last_pt = last_pt->prev;
       // Until the adaptive classifier can be weaned off polygon segments,
       // we have to force extraction from the polygon for the bl_features.
-      ExtractFeaturesFromRun(pt, last_pt, bl_denorm, kStandardFeatureLength,
-                             true, bl_features);
-      ExtractFeaturesFromRun(pt, last_pt, cn_denorm, kStandardFeatureLength,
-                             false, cn_features);
+      // Without an outline, the cn_features come from the same polygon,
+      // so both sets are made in one walk of it.
+      if (pt->src_outline == NULL) {
+        ExtractPolygonFeatures(pt, last_pt, bl_denorm, &cn_denorm,
+                               kStandardFeatureLength, bl_features,
+                               cn_features);
+      } else {
+        ExtractPolygonFeatures(pt, last_pt, bl_denorm, NULL,
+                               kStandardFeatureLength, bl_features, NULL);
+        ExtractFeaturesFromRun(pt, last_pt, cn_denorm, kStandardFeatureLength,
+                               false, cn_features);
+      }
       pt = last_pt;
     } while ((pt = pt->next) != loop_pt);
     if (outline_cn_counts != NULL)
@@ -55,14 +55,29 @@ void TESS_API InitIntegerFX();
 FCOORD FeatureDirection(uinT8 theta);
 
 namespace tesseract {
+  // Buffers for extracting the features of one blob at a time. They keep
+  // their memory from blob to blob, so once they have grown to fit the
+  // largest blob, feature extraction allocates nothing but the
+  // TrainingSample. Not thread-safe: see Classify::AcquireFxScratch.
+  struct IntFxScratch {
+    GenericVector<INT_FEATURE_STRUCT> bl_features;
+    GenericVector<INT_FEATURE_STRUCT> cn_features;
+    // Edge coordinates for the non-linear normalization.
+    GenericVector<GenericVector<int> > x_coords;
+    GenericVector<GenericVector<int> > y_coords;
+  };
+
   // Generates a TrainingSample from a TBLOB. Extracts features and sets
   // the bounding box, so classifiers that operate on the image can work.
+  // If scratch is not NULL, its buffers are used for the intermediate
+  // results, and bl_features may be &scratch->bl_features.
   // TODO(rays) BlobToTrainingSample must remain a global function until
   // the FlexFx and FeatureDescription code can be removed and LearnBlob
   // made a member of Classify.
   TrainingSample* BlobToTrainingSample(
       const TBLOB& blob, bool nonlinear_norm, INT_FX_RESULT_STRUCT* fx_info,
-      GenericVector<INT_FEATURE_STRUCT>* bl_features);
+      GenericVector<INT_FEATURE_STRUCT>* bl_features,
+      IntFxScratch* scratch = NULL);
 }
 
 // Deprecated! Prefer tesseract::Classify::ExtractFeatures instead.
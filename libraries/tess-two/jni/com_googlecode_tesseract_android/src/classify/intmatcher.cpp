@@ -29,6 +29,7 @@
 
 #include "fontinfo.h"
 #include "intproto.h"
+#include "pagecounters.h"
 #include "callcpp.h"
 #include "scrollview.h"
 #include "float2int.h"
@@ -36,10 +37,14 @@
 #include "helpers.h"
 #include "classify.h"
 #include "shapetable.h"
+#include "classprunersimd.h"
+#include "simddetect.h"
 #include <math.h>
 
 using tesseract::ScoredFont;
 using tesseract::UnicharRating;
+using tesseract::ProtoEvidenceFunc;
+using tesseract::ProtoEvidenceSumFunc;
 
 /*----------------------------------------------------------------------------
                     Global Data Definitions and Declarations
@@ -98,6 +103,37 @@ static const uinT8* const next_table =
 
 namespace tesseract {
 
+// Returns the fastest class pruner kernel for this CPU, or NULL if there is
+// none and ComputeScores must use the scalar loop.
+static ClassPrunerScoresFunc BestClassPrunerKernel() {
+  if (NUM_BITS_PER_CLASS != 2 || CLASSES_PER_CP != kClassPrunerClasses ||
+      WERDS_PER_CP_VECTOR != kClassPrunerWordsPerBucket)
+    return NULL;
+  if (SIMDDetect::IsAVX2Available()) return ClassPrunerScoresAVX2;
+  if (SIMDDetect::IsSSE2Available()) return ClassPrunerScoresSSE2;
+  if (SIMDDetect::IsNEONAvailable()) return ClassPrunerScoresNEON;
+  return NULL;
+}
+
+// Returns the fastest kernel that updates the evidence tables for one proto,
+// or NULL if there is none and the scalar code must be used.
+static ProtoEvidenceFunc BestProtoEvidenceKernel() {
+  if (MAX_PROTO_INDEX != kProtoEvidenceLength ||
+      MAX_NUM_CONFIGS < kConfigEvidenceLength)
+    return NULL;
+  if (SIMDDetect::IsSSE2Available()) return UpdateProtoEvidenceSSE2;
+  if (SIMDDetect::IsNEONAvailable()) return UpdateProtoEvidenceNEON;
+  return NULL;
+}
+
+// As BestProtoEvidenceKernel, for the sums of proto evidence.
+static ProtoEvidenceSumFunc BestProtoEvidenceSumKernel() {
+  if (MAX_PROTO_INDEX != kProtoEvidenceLength) return NULL;
+  if (SIMDDetect::IsSSE2Available()) return SumProtoEvidenceSSE2;
+  if (SIMDDetect::IsNEONAvailable()) return SumProtoEvidenceNEON;
+  return NULL;
+}
+
 // Encapsulation of the intermediate data and computations made by the class
 // pruner. The class pruner implements a simple linear classifier on binary
 // features by heavily quantizing the feature space, and applying
@@ -125,7 +161,11 @@ class ClassPruner {
     }
     pruning_threshold_ = 0;
     num_features_ = 0;
+    features_ = NULL;
     num_classes_ = 0;
+    begin_ = 0;
+    end_ = max_classes;
+    class_map_ = NULL;
   }
 
   ~ClassPruner() {
@@ -135,22 +175,74 @@ class ClassPruner {
     delete []sort_index_;
   }
 
+  /// Makes class c of the class pruner tables stand for class class_map[c]
+  /// of the unicharset, the per class arrays and the results. NULL, the
+  /// default, is the identity.
+  void SetClassMap(const int* class_map) {
+    class_map_ = class_map;
+  }
+
+  /// Returns the class that class c of the class pruner tables stands for.
+  int ClassId(int c) const {
+    return class_map_ != NULL ? class_map_[c] : c;
+  }
+
   /// Computes the scores for every class in the character set, by summing the
   /// weights for each feature and stores the sums internally in class_count_.
   void ComputeScores(const INT_TEMPLATES_STRUCT* int_templates,
                      int num_features, const INT_FEATURE_STRUCT* features) {
+    SetFeatures(num_features, features);
+    ScorePruners(int_templates, 0, int_templates->NumClassPruners);
+  }
+
+  /// Keeps the features for ScorePruners and ComputeBounds, with the index
+  /// of the bucket each one falls in.
+  void SetFeatures(int num_features, const INT_FEATURE_STRUCT* features) {
     num_features_ = num_features;
-    int num_pruners = int_templates->NumClassPruners;
+    features_ = features;
+    offsets_.init_to_size(num_features, 0);
     for (int f = 0; f < num_features; ++f) {
       const INT_FEATURE_STRUCT* feature = &features[f];
+      int x = feature->X * NUM_CP_BUCKETS >> 8;
+      int y = feature->Y * NUM_CP_BUCKETS >> 8;
+      int theta = feature->Theta * NUM_CP_BUCKETS >> 8;
+      offsets_[f] = ((x * NUM_CP_BUCKETS + y) * NUM_CP_BUCKETS + theta) *
+                    WERDS_PER_CP_VECTOR;
+    }
+  }
+
+  /// Adds the weights of the features set by SetFeatures to class_count_ for
+  /// the classes of the class pruners [first_pruner, last_pruner).
+  void ScorePruners(const INT_TEMPLATES_STRUCT* int_templates,
+                    int first_pruner, int last_pruner) {
+    int num_features = num_features_;
+    const INT_FEATURE_STRUCT* features = features_;
+    int num_pruners = last_pruner;
+    // The SIMD kernels run over all the features one pruner at a time, which
+    // keeps a pruner's counts in registers. They give the same sums.
+    int first_scalar_pruner = first_pruner;
+    ClassPrunerScoresFunc kernel = BestClassPrunerKernel();
+    if (kernel != NULL && num_features > 0) {
+      const uinT32* pruners[MAX_NUM_CLASS_PRUNERS];
+      for (int p = first_pruner; p < num_pruners; ++p)
+        pruners[p - first_pruner] =
+            &int_templates->ClassPruners[p]->p[0][0][0][0];
+      first_scalar_pruner +=
+          kernel(pruners, num_pruners - first_pruner, &offsets_[0],
+                 num_features, class_count_ + first_pruner * CLASSES_PER_CP);
+    }
+    for (int f = 0; f < num_features && first_scalar_pruner < num_pruners;
+         ++f) {
+      const INT_FEATURE_STRUCT* feature = &features[f];
       // Quantize the feature to NUM_CP_BUCKETS*NUM_CP_BUCKETS*NUM_CP_BUCKETS.
       int x = feature->X * NUM_CP_BUCKETS >> 8;
       int y = feature->Y * NUM_CP_BUCKETS >> 8;
       int theta = feature->Theta * NUM_CP_BUCKETS >> 8;
-      int class_id = 0;
+      int class_id = first_scalar_pruner * CLASSES_PER_CP;
       // Each CLASS_PRUNER_STRUCT only covers CLASSES_PER_CP(32) classes, so
       // we need a collection of them, indexed by pruner_set.
-      for (int pruner_set = 0; pruner_set < num_pruners; ++pruner_set) {
+      for (int pruner_set = first_scalar_pruner; pruner_set < num_pruners;
+           ++pruner_set) {
         // Look up quantized feature in a 3-D array, an array of weights for
         // each class.
         const uinT32* pruner_word_ptr =
@@ -203,6 +295,69 @@ class ClassPruner {
     }
   }
 
+  /// Bounds the count of every class of each class pruner by the sum over
+  /// the features of the largest weight of any of its classes, using the
+  /// PrunerBounds of int_templates. The pruner with keep_this, if any, gets
+  /// the largest possible bound so it is always scored. Also zeroes
+  /// norm_count_, as the classes of pruners that are never scored keep it.
+  void ComputeBounds(const INT_TEMPLATES_STRUCT* int_templates,
+                     int keep_this) {
+    int num_pruners = int_templates->NumClassPruners;
+    const uinT8* bounds = int_templates->PrunerBounds;
+    bounds_.init_to_size(num_pruners, 0);
+    for (int f = 0; f < num_features_; ++f) {
+      const uinT8* bucket =
+          bounds + offsets_[f] / WERDS_PER_CP_VECTOR * num_pruners;
+      for (int p = 0; p < num_pruners; ++p)
+        bounds_[p] += bucket[p];
+    }
+    if (keep_this >= 0 && keep_this / CLASSES_PER_CP < num_pruners)
+      bounds_[keep_this / CLASSES_PER_CP] = MAX_INT32;
+    for (int c = 0; c < max_classes_; ++c)
+      norm_count_[c] = 0;
+  }
+  /// Returns the class pruner with the largest bound that has not been
+  /// returned yet, and its bound in *bound, or -1 when there are none left.
+  /// Usually only a few pruners are taken, so a scan beats sorting.
+  int TakeBestPruner(int* bound) {
+    int best = -1;
+    for (int p = 0; p < bounds_.size(); ++p) {
+      if (bounds_[p] >= 0 && (best < 0 || bounds_[p] > bounds_[best]))
+        best = p;
+    }
+    if (best >= 0) {
+      *bound = bounds_[best];
+      bounds_[best] = -1;
+    }
+    return best;
+  }
+
+  /// Restricts the adjustments below to the classes [begin, end).
+  void SetClassRange(int begin, int end) {
+    begin_ = begin;
+    end_ = MIN(end, max_classes_);
+  }
+
+  /// Returns the largest norm_count_ in the class range. If
+  /// max_of_non_fragments, then fragments are ignored.
+  int MaxNormCount(bool max_of_non_fragments,
+                   const UNICHARSET& unicharset) const {
+    int max_count = 0;
+    for (int c = begin_; c < end_; ++c) {
+      if (norm_count_[c] > max_count &&
+          // This additional check is added in order to ensure that
+          // the classifier will return at least one non-fragmented
+          // character match.
+          // TODO(daria): verify that this helps accuracy and does not
+          // hurt performance.
+          (!max_of_non_fragments ||
+           !unicharset.get_fragment(ClassId(c)))) {
+        max_count = norm_count_[c];
+      }
+    }
+    return max_count;
+  }
+
   /// Adjusts the scores according to the number of expected features. Used
   /// in lieu of a constant bias, this penalizes classes that expect more
   /// features than there are present. Thus an actual c will score higher for c
@@ -210,9 +365,10 @@ class ClassPruner {
   /// e expects more features to be present.
   void AdjustForExpectedNumFeatures(const uinT16* expected_num_features,
                                     int cutoff_strength) {
-    for (int class_id = 0; class_id < max_classes_; ++class_id) {
-      if (num_features_ < expected_num_features[class_id]) {
-        int deficit = expected_num_features[class_id] - num_features_;
+    for (int class_id = begin_; class_id < end_; ++class_id) {
+      int expected = expected_num_features[ClassId(class_id)];
+      if (num_features_ < expected) {
+        int deficit = expected - num_features_;
         class_count_[class_id] -= class_count_[class_id] * deficit /
           (num_features_ * cutoff_strength + deficit);
       }
@@ -222,18 +378,18 @@ class ClassPruner {
   /// Zeros the scores for classes disabled in the unicharset.
   /// Implements the black-list to recognize a subset of the character set.
   void DisableDisabledClasses(const UNICHARSET& unicharset) {
-    for (int class_id = 0; class_id < max_classes_; ++class_id) {
-      if (!unicharset.get_enabled(class_id))
+    for (int class_id = begin_; class_id < end_; ++class_id) {
+      if (!unicharset.get_enabled(ClassId(class_id)))
         class_count_[class_id] = 0;  // This char is disabled!
     }
   }
 
   /** Zeros the scores of fragments. */
   void DisableFragments(const UNICHARSET& unicharset) {
-    for (int class_id = 0; class_id < max_classes_; ++class_id) {
+    for (int class_id = begin_; class_id < end_; ++class_id) {
       // Do not include character fragments in the class pruner
       // results if disable_character_fragments is true.
-      if (unicharset.get_fragment(class_id)) {
+      if (unicharset.get_fragment(ClassId(class_id))) {
         class_count_[class_id] = 0;
       }
     }
@@ -245,15 +401,15 @@ class ClassPruner {
   /// character class, and scaled by the norm_multiplier.
   void NormalizeForXheight(int norm_multiplier,
                            const uinT8* normalization_factors) {
-    for (int class_id = 0; class_id < max_classes_; class_id++) {
+    for (int class_id = begin_; class_id < end_; ++class_id) {
       norm_count_[class_id] = class_count_[class_id] -
-          ((norm_multiplier * normalization_factors[class_id]) >> 8);
+          ((norm_multiplier * normalization_factors[ClassId(class_id)]) >> 8);
     }
   }
 
   /** The nop normalization copies the class_count_ array to norm_count_. */
   void NoNormalization() {
-    for (int class_id = 0; class_id < max_classes_; class_id++) {
+    for (int class_id = begin_; class_id < end_; ++class_id) {
       norm_count_[class_id] = class_count_[class_id];
     }
   }
@@ -263,18 +419,8 @@ class ClassPruner {
   /// fragments in computing the maximum count.
   void PruneAndSort(int pruning_factor, int keep_this,
                     bool max_of_non_fragments, const UNICHARSET& unicharset) {
-    int max_count = 0;
-    for (int c = 0; c < max_classes_; ++c) {
-      if (norm_count_[c] > max_count &&
-          // This additional check is added in order to ensure that
-          // the classifier will return at least one non-fragmented
-          // character match.
-          // TODO(daria): verify that this helps accuracy and does not
-          // hurt performance.
-          (!max_of_non_fragments || !unicharset.get_fragment(c))) {
-        max_count = norm_count_[c];
-      }
-    }
+    SetClassRange(0, max_classes_);
+    int max_count = MaxNormCount(max_of_non_fragments, unicharset);
     // Prune Classes.
     pruning_threshold_ = (max_count * pruning_factor) >> 8;
     // Select Classes.
@@ -283,7 +429,7 @@ class ClassPruner {
     num_classes_ = 0;
     for (int class_id = 0; class_id < max_classes_; class_id++) {
       if (norm_count_[class_id] >= pruning_threshold_ ||
-          class_id == keep_this) {
+          ClassId(class_id) == keep_this) {
           ++num_classes_;
         sort_index_[num_classes_] = class_id;
         sort_key_[num_classes_] = norm_count_[class_id];
@@ -296,12 +442,15 @@ class ClassPruner {
   }
 
   /** Prints debug info on the class pruner matches for the pruned classes only.
+   * pruner_templates are the ones scored, and int_templates the ones that
+   * the classes belong to.
    */
   void DebugMatch(const Classify& classify,
+                  const INT_TEMPLATES_STRUCT* pruner_templates,
                   const INT_TEMPLATES_STRUCT* int_templates,
                   const INT_FEATURE_STRUCT* features) const {
-    int num_pruners = int_templates->NumClassPruners;
-    int max_num_classes = int_templates->NumClasses;
+    int num_pruners = pruner_templates->NumClassPruners;
+    int max_num_classes = max_classes_;
     for (int f = 0; f < num_features_; ++f) {
       const INT_FEATURE_STRUCT* feature = &features[f];
       tprintf("F=%3d(%d,%d,%d),", f, feature->X, feature->Y, feature->Theta);
@@ -314,7 +463,7 @@ class ClassPruner {
         // Look up quantized feature in a 3-D array, an array of weights for
         // each class.
         const uinT32* pruner_word_ptr =
-            int_templates->ClassPruners[pruner_set]->p[x][y][theta];
+            pruner_templates->ClassPruners[pruner_set]->p[x][y][theta];
         for (int word = 0; word < WERDS_PER_CP_VECTOR; ++word) {
           uinT32 pruner_word = *pruner_word_ptr++;
           for (int word_class = 0; word_class < 16 &&
@@ -322,7 +471,8 @@ class ClassPruner {
             if (norm_count_[class_id] >= pruning_threshold_) {
               tprintf(" %s=%d,",
                       classify.ClassIDToDebugStr(int_templates,
-                                                 class_id, 0).string(),
+                                                 ClassId(class_id),
+                                                 0).string(),
                       pruner_word & CLASS_PRUNER_CLASS_MASK);
             }
             pruner_word >>= NUM_BITS_PER_CLASS;
@@ -343,12 +493,13 @@ class ClassPruner {
     for (int i = 0; i < num_classes_; ++i) {
       int class_id = sort_index_[num_classes_ - i];
       STRING class_string = classify.ClassIDToDebugStr(int_templates,
-                                                       class_id, 0);
+                                                       ClassId(class_id), 0);
       tprintf("%s:Initial=%d, E=%d, Xht-adj=%d, N=%d, Rat=%.2f\n",
               class_string.string(),
               class_count_[class_id],
-              expected_num_features[class_id],
-              (norm_multiplier * normalization_factors[class_id]) >> 8,
+              expected_num_features[ClassId(class_id)],
+              (norm_multiplier *
+               normalization_factors[ClassId(class_id)]) >> 8,
               sort_key_[num_classes_ - i],
               100.0 - 100.0 * sort_key_[num_classes_ - i] /
                 (CLASS_PRUNER_CLASS_MASK * num_features_));
@@ -361,7 +512,7 @@ class ClassPruner {
     CP_RESULT_STRUCT empty;
     results->init_to_size(num_classes_, empty);
     for (int c = 0; c < num_classes_; ++c) {
-      (*results)[c].Class = sort_index_[num_classes_ - c];
+      (*results)[c].Class = ClassId(sort_index_[num_classes_ - c]);
       (*results)[c].Rating = 1.0 - sort_key_[num_classes_ - c] /
         (static_cast<float>(CLASS_PRUNER_CLASS_MASK) * num_features_);
     }
@@ -387,6 +538,17 @@ class ClassPruner {
   int pruning_threshold_;
   /** The number of features used to compute the scores. */
   int num_features_;
+  /** The features, and the offset of the bucket of each in a pruner. */
+  const INT_FEATURE_STRUCT* features_;
+  GenericVector<int> offsets_;
+  /** Upper bounds of the counts of the classes of each class pruner, or -1
+      once taken by TakeBestPruner. */
+  GenericVector<int> bounds_;
+  /** The range of classes that the adjustments apply to. */
+  int begin_;
+  int end_;
+  /** The class each class of the pruner tables stands for, or NULL. */
+  const int* class_map_;
   /** Final number of pruned classes. */
   int num_classes_;
 };
@@ -394,6 +556,30 @@ class ClassPruner {
 /*----------------------------------------------------------------------------
               Public Code
 ----------------------------------------------------------------------------*/
+// Applies the adjustments of PruneClasses to the scores of the classes in the
+// current range of pruner, leaving the results in its norm_count_.
+void Classify::AdjustPrunerScores(const uinT16* expected_num_features,
+                                  const uinT8* normalization_factors,
+                                  ClassPruner* pruner) {
+  // Adjust match scores for number of expected features.
+  pruner->AdjustForExpectedNumFeatures(expected_num_features,
+                                       classify_cp_cutoff_strength);
+  // Apply disabled classes in unicharset - only works without a shape_table.
+  if (shape_table_ == NULL)
+    pruner->DisableDisabledClasses(unicharset);
+  // If fragments are disabled, remove them, also only without a shape table.
+  if (disable_character_fragments && shape_table_ == NULL)
+    pruner->DisableFragments(unicharset);
+
+  // If we have good x-heights, apply the given normalization factors.
+  if (normalization_factors != NULL) {
+    pruner->NormalizeForXheight(classify_class_pruner_multiplier,
+                                normalization_factors);
+  } else {
+    pruner->NoNormalization();
+  }
+}
+
 /**
  * Runs the class pruner from int_templates on the given features, returning
  * the number of classes output in results.
@@ -415,32 +601,56 @@ int Classify::PruneClasses(const INT_TEMPLATES_STRUCT* int_templates,
                            const uinT8* normalization_factors,
                            const uinT16* expected_num_features,
                            GenericVector<CP_RESULT_STRUCT>* results) {
-  ClassPruner pruner(int_templates->NumClasses);
-  // Compute initial match scores for all classes.
-  pruner.ComputeScores(int_templates, num_features, features);
-  // Adjust match scores for number of expected features.
-  pruner.AdjustForExpectedNumFeatures(expected_num_features,
-                                      classify_cp_cutoff_strength);
-  // Apply disabled classes in unicharset - only works without a shape_table.
-  if (shape_table_ == NULL)
-    pruner.DisableDisabledClasses(unicharset);
-  // If fragments are disabled, remove them, also only without a shape table.
-  if (disable_character_fragments && shape_table_ == NULL)
-    pruner.DisableFragments(unicharset);
-
-  // If we have good x-heights, apply the given normalization factors.
-  if (normalization_factors != NULL) {
-    pruner.NormalizeForXheight(classify_class_pruner_multiplier,
-                               normalization_factors);
+  // With a whitelist pruner, only the classes of the static templates that
+  // can give an enabled unichar are scored, in tables of their own.
+  const INT_TEMPLATES_STRUCT* pruner_templates = int_templates;
+  const WhitelistPruner* subset = NULL;
+  if (whitelist_pruner_ != NULL && int_templates == PreTrainedTemplates &&
+      keep_this < 0) {
+    subset = whitelist_pruner_;
+    pruner_templates = subset->templates;
+  }
+  ClassPruner pruner(subset != NULL ? subset->classes.size()
+                                    : int_templates->NumClasses);
+  if (subset != NULL && !subset->classes.empty())
+    pruner.SetClassMap(&subset->classes[0]);
+  // All the adjustments below can only lower a count, so a class pruner
+  // whose bound is below the pruning threshold of the classes scored so far
+  // has no class that could make the short-list, nor raise the threshold.
+  // Scoring the pruners by decreasing bound and stopping at the first such
+  // one then gives exactly the same short-list as scoring them all.
+  bool bounded = classify_bound_class_pruner &&
+                 pruner_templates->PrunerBounds != NULL && num_features > 0 &&
+                 classify_class_pruner_threshold <= 256 &&
+                 classify_class_pruner_multiplier >= 0 &&
+                 classify_cp_cutoff_strength >= 0;
+  if (bounded) {
+    pruner.SetFeatures(num_features, features);
+    pruner.ComputeBounds(pruner_templates, keep_this);
+    int max_count = 0;
+    int p, bound;
+    while ((p = pruner.TakeBestPruner(&bound)) >= 0) {
+      int threshold = MAX((max_count * classify_class_pruner_threshold) >> 8,
+                          1);
+      if (bound < threshold) break;
+      pruner.ScorePruners(pruner_templates, p, p + 1);
+      pruner.SetClassRange(p * CLASSES_PER_CP, (p + 1) * CLASSES_PER_CP);
+      AdjustPrunerScores(expected_num_features, normalization_factors,
+                         &pruner);
+      max_count = MAX(max_count,
+                      pruner.MaxNormCount(shape_table_ == NULL, unicharset));
+    }
   } else {
-    pruner.NoNormalization();
+    // Compute initial match scores for all classes.
+    pruner.ComputeScores(pruner_templates, num_features, features);
+    AdjustPrunerScores(expected_num_features, normalization_factors, &pruner);
   }
   // Do the actual pruning and sort the short-list.
   pruner.PruneAndSort(classify_class_pruner_threshold, keep_this,
                       shape_table_ == NULL, unicharset);
 
   if (classify_debug_level > 2) {
-    pruner.DebugMatch(*this, int_templates, features);
+    pruner.DebugMatch(*this, pruner_templates, int_templates, features);
   }
   if (classify_debug_level > 1) {
     pruner.SummarizeResult(*this, int_templates, expected_num_features,
@@ -451,6 +661,81 @@ int Classify::PruneClasses(const INT_TEMPLATES_STRUCT* int_templates,
   return pruner.SetupResults(results);
 }
 
+// Number of sets of enabled unichars that SetUpWhitelistPruner keeps the
+// class pruner tables of, for callers that switch between a few whitelists.
+const int kMaxWhitelistPruners = 4;
+
+void Classify::SetUpWhitelistPruner() {
+  const WhitelistPruner* previous = whitelist_pruner_;
+  whitelist_pruner_ = NULL;
+  if (classify_whitelist_pruner && PreTrainedTemplates != NULL) {
+    STRING enabled;
+    bool all_enabled = true;
+    for (int id = 0; id < unicharset.size(); ++id) {
+      bool on = unicharset.get_enabled(id);
+      enabled += on ? '1' : '0';
+      all_enabled = all_enabled && on;
+    }
+    if (!all_enabled) {
+      int index = 0;
+      while (index < whitelist_pruners_.size() &&
+             whitelist_pruners_[index]->enabled != enabled) {
+        ++index;
+      }
+      WhitelistPruner* subset = NULL;
+      if (index < whitelist_pruners_.size()) {
+        subset = whitelist_pruners_[index];
+        whitelist_pruners_.remove(index);
+      } else {
+        subset = new WhitelistPruner;
+        subset->enabled = enabled;
+        for (int c = 0; c < PreTrainedTemplates->NumClasses; ++c) {
+          if (ClassHasEnabledUnichar(c)) subset->classes.push_back(c);
+        }
+        subset->templates =
+            NewSubsetClassPruners(PreTrainedTemplates, subset->classes);
+        if (whitelist_pruners_.size() >= kMaxWhitelistPruners) {
+          free_int_templates(whitelist_pruners_.back()->templates);
+          delete whitelist_pruners_.back();
+          whitelist_pruners_.truncate(whitelist_pruners_.size() - 1);
+        }
+      }
+      whitelist_pruners_.insert(subset, 0);
+      // Nothing to gain if every class can give an enabled unichar.
+      if (subset->classes.size() < PreTrainedTemplates->NumClasses)
+        whitelist_pruner_ = subset;
+    }
+  }
+  // The short-lists, and so the cached results, change with the tables.
+  if (whitelist_pruner_ != previous) ClearClassifyCache();
+}
+
+bool Classify::ClassHasEnabledUnichar(int class_id) const {
+  if (shape_table_ == NULL)
+    return class_id < unicharset.size() && unicharset.get_enabled(class_id);
+  // With a shape table, the configs of the class are shapes, any unichar of
+  // which the class can give.
+  int font_set_id = PreTrainedTemplates->Class[class_id]->font_set_id;
+  if (font_set_id < 0) return true;
+  const FontSet& fs = fontset_table_.get(font_set_id);
+  for (int config = 0; config < fs.size; ++config) {
+    const Shape& shape = shape_table_->GetShape(fs.configs[config]);
+    for (int c = 0; c < shape.size(); ++c) {
+      if (unicharset.get_enabled(shape[c].unichar_id)) return true;
+    }
+  }
+  return false;
+}
+
+void Classify::ClearWhitelistPruners() {
+  for (int i = 0; i < whitelist_pruners_.size(); ++i) {
+    free_int_templates(whitelist_pruners_[i]->templates);
+    delete whitelist_pruners_[i];
+  }
+  whitelist_pruners_.clear();
+  whitelist_pruner_ = NULL;
+}
+
 }  // namespace tesseract
 
 /**
@@ -472,15 +757,59 @@ int Classify::PruneClasses(const INT_TEMPLATES_STRUCT* int_templates,
  * @note Exceptions: none
  * @note History: Tue Feb 19 16:36:23 MST 1991, RWM, Created.
  */
-void IntegerMatcher::Match(INT_CLASS ClassTemplate,
-                           BIT_VECTOR ProtoMask,
-                           BIT_VECTOR ConfigMask,
-                           inT16 NumFeatures,
-                           const INT_FEATURE_STRUCT* Features,
-                           UnicharRating* Result,
-                           int AdaptFeatureThreshold,
-                           int Debug,
-                           bool SeparateDebugWindows) {
+int IntegerMatcher::Match(INT_CLASS ClassTemplate,
+                          BIT_VECTOR ProtoMask,
+                          BIT_VECTOR ConfigMask,
+                          inT16 NumFeatures,
+                          const INT_FEATURE_STRUCT* Features,
+                          UnicharRating* Result,
+                          int AdaptFeatureThreshold,
+                          int Debug,
+                          bool SeparateDebugWindows,
+                          float min_rating) {
+  tesseract::PageCounts::Count(tesseract::COUNTER_CLASS_MATCHES);
+  int num_matched =
+      MatchWithKernels(ClassTemplate, ProtoMask, ConfigMask, NumFeatures,
+                       Features, Result, AdaptFeatureThreshold, Debug,
+                       SeparateDebugWindows, min_rating, evidence_kernel_,
+                       sum_kernel_);
+  if (verify_simd_ == NULL || !*verify_simd_ ||
+      (evidence_kernel_ == NULL && sum_kernel_ == NULL))
+    return num_matched;
+  UnicharRating scalar_result;
+  MatchWithKernels(ClassTemplate, ProtoMask, ConfigMask, NumFeatures,
+                   Features, &scalar_result, AdaptFeatureThreshold, 0,
+                   false, min_rating, NULL, NULL);
+  bool same = scalar_result.rating == Result->rating &&
+      scalar_result.config == Result->config &&
+      scalar_result.feature_misses == Result->feature_misses &&
+      scalar_result.fonts.size() == Result->fonts.size();
+  for (int f = 0; same && f < Result->fonts.size(); ++f) {
+    same = scalar_result.fonts[f].fontinfo_id == Result->fonts[f].fontinfo_id &&
+        scalar_result.fonts[f].score == Result->fonts[f].score;
+  }
+  if (!same) {
+    tprintf("SIMD matcher mismatch: rating %g config %d misses %d fonts %d,"
+            " scalar rating %g config %d misses %d fonts %d\n",
+            Result->rating, Result->config, Result->feature_misses,
+            Result->fonts.size(), scalar_result.rating, scalar_result.config,
+            scalar_result.feature_misses, scalar_result.fonts.size());
+  }
+  return num_matched;
+}
+
+int IntegerMatcher::MatchWithKernels(INT_CLASS ClassTemplate,
+                                     BIT_VECTOR ProtoMask,
+                                     BIT_VECTOR ConfigMask,
+                                     inT16 NumFeatures,
+                                     const INT_FEATURE_STRUCT* Features,
+                                     UnicharRating* Result,
+                                     int AdaptFeatureThreshold,
+                                     int Debug,
+                                     bool SeparateDebugWindows,
+                                     float min_rating,
+                                     ProtoEvidenceFunc evidence_kernel,
+                                     ProtoEvidenceSumFunc sum_kernel) {
   ScratchEvidence *tables = new ScratchEvidence();
   int Feature;
   int BestMatch;
@@ -491,13 +820,27 @@ void IntegerMatcher::Match(INT_CLASS ClassTemplate,
   tables->Clear(ClassTemplate);
   Result->feature_misses = 0;
 
+  int proto_bounds[MAX_NUM_CONFIGS];
+  bool bounded = min_rating > 0.0f;
+  if (bounded)
+    ComputeProtoEvidenceBounds(ClassTemplate, ConfigMask, proto_bounds);
   for (Feature = 0; Feature < NumFeatures; Feature++) {
     int csum = UpdateTablesForFeature(ClassTemplate, ProtoMask, ConfigMask,
                                       Feature, &Features[Feature],
-                                      tables, Debug);
+                                      tables, Debug, evidence_kernel);
     // Count features that were missed over all configs.
     if (csum == 0)
       ++Result->feature_misses;
+    if (bounded && (Feature + 1) % kBoundCheckInterval == 0 &&
+        Feature + 1 < NumFeatures &&
+        !CanReachRating(ClassTemplate, *tables, proto_bounds, NumFeatures,
+                        Feature + 1, min_rating)) {
+      Result->rating = 0.0f;
+      Result->config = 0;
+      Result->fonts.truncate(0);
+      delete tables;
+      return Feature + 1;
+    }
   }
 
 #ifndef GRAPHICS_DISABLED
@@ -518,7 +861,8 @@ void IntegerMatcher::Match(INT_CLASS ClassTemplate,
   }
 #endif
 
-  tables->UpdateSumOfProtoEvidences(ClassTemplate, ConfigMask, NumFeatures);
+  tables->UpdateSumOfProtoEvidences(ClassTemplate, ConfigMask, NumFeatures,
+                                    sum_kernel);
   tables->NormalizeSums(ClassTemplate, NumFeatures, NumFeatures);
 
   BestMatch = FindBestMatch(ClassTemplate, *tables, Result);
@@ -532,6 +876,42 @@ void IntegerMatcher::Match(INT_CLASS ClassTemplate,
 #endif
 
   delete tables;
+  return NumFeatures;
+}
+
+void IntegerMatcher::ComputeProtoEvidenceBounds(INT_CLASS ClassTemplate,
+                                                BIT_VECTOR ConfigMask,
+                                                int* proto_bounds) {
+  for (int c = 0; c < ClassTemplate->NumConfigs; ++c)
+    proto_bounds[c] = 0;
+  for (int p = 0; p < ClassTemplate->NumProtos; ++p) {
+    const INT_PROTO_STRUCT* proto = ProtoForProtoId(ClassTemplate, p);
+    int bound = MAX_UINT8 * ClassTemplate->ProtoLengths[p];
+    uinT32 config_word = proto->Configs[0] & *ConfigMask;
+    for (int c = 0; config_word != 0; ++c, config_word >>= 1) {
+      if (config_word & 1)
+        proto_bounds[c] += bound;
+    }
+  }
+}
+
+// The evidence of each config is the sum of its feature evidence and proto
+// evidence, normalized in NormalizeSums. Every feature still to be matched
+// adds at most MAX_UINT8 of feature evidence, so the rating of a config
+// cannot exceed that of its evidence so far plus that and the proto bound.
+bool IntegerMatcher::CanReachRating(INT_CLASS ClassTemplate,
+                                    const ScratchEvidence& tables,
+                                    const int* proto_bounds, int NumFeatures,
+                                    int num_matched, float min_rating) {
+  inT64 remaining = MAX_UINT8 * (NumFeatures - num_matched);
+  for (int c = 0; c < ClassTemplate->NumConfigs; ++c) {
+    inT64 evidence = tables.sum_feature_evidence_[c] + remaining +
+        proto_bounds[c];
+    inT64 bound = (evidence << 8) /
+        (NumFeatures + ClassTemplate->ConfigLengths[c]);
+    if (bound / 65536.0f >= min_rating) return true;
+  }
+  return false;
 }
 
 /**
@@ -577,7 +957,7 @@ int IntegerMatcher::FindGoodProtos(
   for (int Feature = 0; Feature < NumFeatures; Feature++)
     UpdateTablesForFeature(
         ClassTemplate, ProtoMask, ConfigMask, Feature, &(Features[Feature]),
-        tables, Debug);
+        tables, Debug, evidence_kernel_);
 
 #ifndef GRAPHICS_DISABLED
   if (PrintProtoMatchesOn (Debug) || PrintMatchSummaryOn (Debug))
@@ -646,7 +1026,7 @@ int IntegerMatcher::FindBadFeatures(
   for (int Feature = 0; Feature < NumFeatures; Feature++) {
     UpdateTablesForFeature(
         ClassTemplate, ProtoMask, ConfigMask, Feature, &Features[Feature],
-        tables, Debug);
+        tables, Debug, evidence_kernel_);
 
     /* Find Best Evidence for Current Feature */
     int best = 0;
@@ -676,8 +1056,12 @@ int IntegerMatcher::FindBadFeatures(
 }
 
 
-void IntegerMatcher::Init(tesseract::IntParam *classify_debug_level) {
+void IntegerMatcher::Init(tesseract::IntParam *classify_debug_level,
+                          tesseract::BoolParam *verify_simd) {
   classify_debug_level_ = classify_debug_level;
+  verify_simd_ = verify_simd;
+  evidence_kernel_ = tesseract::BestProtoEvidenceKernel();
+  sum_kernel_ = tesseract::BestProtoEvidenceSumKernel();
 
   /* Initialize table for evidence to similarity lookup */
   for (int i = 0; i < SE_TABLE_SIZE; i++) {
@@ -775,7 +1159,8 @@ int IntegerMatcher::UpdateTablesForFeature(
     int FeatureNum,
     const INT_FEATURE_STRUCT* Feature,
     ScratchEvidence *tables,
-    int Debug) {
+    int Debug,
+    ProtoEvidenceFunc evidence_kernel) {
   uinT32 ConfigWord;
   uinT32 ProtoWord;
   uinT32 ProtoNum;
@@ -866,6 +1251,14 @@ int IntegerMatcher::UpdateTablesForFeature(
 
           ConfigWord &= *ConfigMask;
 
+          int proto_index = ActualProtoNum + proto_offset;
+          if (evidence_kernel != NULL &&
+              evidence_kernel(ConfigWord, Evidence,
+                              ClassTemplate->ProtoLengths[proto_index],
+                              tables->feature_evidence_,
+                              tables->proto_evidence_[proto_index]))
+            continue;
+
           UINT8Pointer = tables->feature_evidence_ - 8;
           config_byte = 0;
           while (ConfigWord != 0 || config_byte != 0) {
@@ -1099,7 +1492,7 @@ void IntegerMatcher::DisplayFeatureDebugInfo(
   for (int Feature = 0; Feature < NumFeatures; Feature++) {
     UpdateTablesForFeature(
         ClassTemplate, ProtoMask, ConfigMask, Feature, &Features[Feature],
-        tables, 0);
+        tables, 0, evidence_kernel_);
 
     /* Find Best Evidence for Current Feature */
     int best = 0;
@@ -1126,7 +1519,8 @@ void IntegerMatcher::DisplayFeatureDebugInfo(
  * Add sum of Proto Evidences into Sum Of Feature Evidence Array
  */
 void ScratchEvidence::UpdateSumOfProtoEvidences(
-    INT_CLASS ClassTemplate, BIT_VECTOR ConfigMask, inT16 NumFeatures) {
+    INT_CLASS ClassTemplate, BIT_VECTOR ConfigMask, inT16 NumFeatures,
+    ProtoEvidenceSumFunc sum_kernel) {
 
   int *IntPointer;
   uinT32 ConfigWord;
@@ -1137,6 +1531,10 @@ void ScratchEvidence::UpdateSumOfProtoEvidences(
   uinT16 ActualProtoNum;
 
   NumProtos = ClassTemplate->NumProtos;
+  int proto_sums[MAX_NUM_PROTOS];
+  bool summed = sum_kernel != NULL &&
+      sum_kernel(&proto_evidence_[0][0], ClassTemplate->ProtoLengths,
+                 NumProtos, proto_sums);
 
   for (ProtoSetIndex = 0; ProtoSetIndex < ClassTemplate->NumProtoSets;
        ProtoSetIndex++) {
@@ -1146,8 +1544,12 @@ void ScratchEvidence::UpdateSumOfProtoEvidences(
          ((ProtoNum < PROTOS_PER_PROTO_SET) && (ActualProtoNum < NumProtos));
          ProtoNum++, ActualProtoNum++) {
       int temp = 0;
-      for (int i = 0; i < ClassTemplate->ProtoLengths[ActualProtoNum]; i++)
-        temp += proto_evidence_[ActualProtoNum] [i];
+      if (summed) {
+        temp = proto_sums[ActualProtoNum];
+      } else {
+        for (int i = 0; i < ClassTemplate->ProtoLengths[ActualProtoNum]; i++)
+          temp += proto_evidence_[ActualProtoNum] [i];
+      }
 
       ConfigWord = ProtoSet->Protos[ProtoNum].Configs[0];
       ConfigWord &= *ConfigMask;
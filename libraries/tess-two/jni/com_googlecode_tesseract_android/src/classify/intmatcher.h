@@ -37,6 +37,7 @@ extern INT_VAR_H(classify_integer_matcher_multiplier, 10,
 ----------------------------------------------------------------------------**/
 #include "intproto.h"
 #include "cutoffs.h"
+#include "matchersimd.h"
 
 namespace tesseract {
 struct UnicharRating;
@@ -75,8 +76,10 @@ struct ScratchEvidence {
   void ClearFeatureEvidence(const INT_CLASS class_template);
   void NormalizeSums(INT_CLASS ClassTemplate, inT16 NumFeatures,
                      inT32 used_features);
+  // sum_kernel may be NULL to use the scalar code.
   void UpdateSumOfProtoEvidences(
-    INT_CLASS ClassTemplate, BIT_VECTOR ConfigMask, inT16 NumFeatures);
+    INT_CLASS ClassTemplate, BIT_VECTOR ConfigMask, inT16 NumFeatures,
+    tesseract::ProtoEvidenceSumFunc sum_kernel);
 };
 
 
@@ -88,24 +91,36 @@ class IntegerMatcher {
   static const int kEvidenceTableBits = 9;
   // Integer Evidence Truncation Bits (8-14).
   static const int kIntEvidenceTruncBits = 14;
+  // Number of features between checks for giving up on a class in Match.
+  static const int kBoundCheckInterval = 4;
   // Similarity to Evidence Table Exponential Multiplier.
   static const float kSEExponentialMultiplier;
   // Center of Similarity Curve.
   static const float kSimilarityCenter;
 
-  IntegerMatcher() : classify_debug_level_(0) {}
-
-  void Init(tesseract::IntParam *classify_debug_level);
-
-  void Match(INT_CLASS ClassTemplate,
-             BIT_VECTOR ProtoMask,
-             BIT_VECTOR ConfigMask,
-             inT16 NumFeatures,
-             const INT_FEATURE_STRUCT* Features,
-             tesseract::UnicharRating* Result,
-             int AdaptFeatureThreshold,
-             int Debug,
-             bool SeparateDebugWindows);
+  IntegerMatcher()
+    : classify_debug_level_(0), verify_simd_(NULL),
+      evidence_kernel_(NULL), sum_kernel_(NULL) {}
+
+  // If verify_simd is not NULL and becomes true, Match also runs the scalar
+  // code after the SIMD kernels and reports any difference in the results.
+  void Init(tesseract::IntParam *classify_debug_level,
+            tesseract::BoolParam *verify_simd);
+
+  // If min_rating is greater than 0, Match gives up on the class as soon as
+  // no config can reach a rating of min_rating any more, and then sets
+  // Result to a rating of 0 with no fonts. Returns the number of features
+  // matched, which is less than NumFeatures if Match gave up.
+  int Match(INT_CLASS ClassTemplate,
+            BIT_VECTOR ProtoMask,
+            BIT_VECTOR ConfigMask,
+            inT16 NumFeatures,
+            const INT_FEATURE_STRUCT* Features,
+            tesseract::UnicharRating* Result,
+            int AdaptFeatureThreshold,
+            int Debug,
+            bool SeparateDebugWindows,
+            float min_rating = 0.0f);
 
   // Applies the CN normalization factor to the given rating and returns
   // the modified rating.
@@ -133,6 +148,33 @@ class IntegerMatcher {
                       int Debug);
 
  private:
+  // Does the work of Match with the given kernels, which may be NULL to use
+  // the scalar code.
+  int MatchWithKernels(INT_CLASS ClassTemplate,
+                       BIT_VECTOR ProtoMask,
+                       BIT_VECTOR ConfigMask,
+                       inT16 NumFeatures,
+                       const INT_FEATURE_STRUCT* Features,
+                       tesseract::UnicharRating* Result,
+                       int AdaptFeatureThreshold,
+                       int Debug,
+                       bool SeparateDebugWindows,
+                       float min_rating,
+                       tesseract::ProtoEvidenceFunc evidence_kernel,
+                       tesseract::ProtoEvidenceSumFunc sum_kernel);
+
+  // Sets proto_bounds[c] to the most proto evidence that config c can get,
+  // which is when all the protos of the config match perfectly.
+  static void ComputeProtoEvidenceBounds(INT_CLASS ClassTemplate,
+                                         BIT_VECTOR ConfigMask,
+                                         int* proto_bounds);
+  // Returns true if some config could still reach min_rating after the
+  // first num_matched of NumFeatures features have been matched into tables.
+  static bool CanReachRating(INT_CLASS ClassTemplate,
+                             const ScratchEvidence& tables,
+                             const int* proto_bounds, int NumFeatures,
+                             int num_matched, float min_rating);
+
   int UpdateTablesForFeature(
       INT_CLASS ClassTemplate,
       BIT_VECTOR ProtoMask,
@@ -140,7 +182,8 @@ class IntegerMatcher {
       int FeatureNum,
       const INT_FEATURE_STRUCT* Feature,
       ScratchEvidence *evidence,
-      int Debug);
+      int Debug,
+      tesseract::ProtoEvidenceFunc evidence_kernel);
 
   int FindBestMatch(INT_CLASS ClassTemplate,
                     const ScratchEvidence &tables,
@@ -181,6 +224,10 @@ class IntegerMatcher {
   uinT32 table_trunc_shift_bits_;
   tesseract::IntParam *classify_debug_level_;
   uinT32 evidence_mult_mask_;
+  tesseract::BoolParam *verify_simd_;
+  // Fastest kernels for this CPU, or NULL if there are none.
+  tesseract::ProtoEvidenceFunc evidence_kernel_;
+  tesseract::ProtoEvidenceSumFunc sum_kernel_;
 };
 
 /**----------------------------------------------------------------------------
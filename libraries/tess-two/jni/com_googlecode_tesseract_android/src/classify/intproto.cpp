@@ -22,6 +22,8 @@
 #include <math.h>
 #include <stdio.h>
 #include <assert.h>
+#include <stdint.h>
+#include <string.h>
 #ifdef __UNIX__
 #include <unistd.h>
 #endif
@@ -38,6 +40,7 @@
 #include "ndminx.h"
 #include "picofeat.h"
 #include "points.h"
+#include "serialis.h"
 #include "shapetable.h"
 #include "svmnode.h"
 
@@ -727,6 +730,8 @@ INT_TEMPLATES NewIntTemplates() {
   T = (INT_TEMPLATES) Emalloc (sizeof (INT_TEMPLATES_STRUCT));
   T->NumClasses = 0;
   T->NumClassPruners = 0;
+  T->PackedArena = NULL;
+  T->PrunerBounds = NULL;
 
   for (i = 0; i < MAX_NUM_CLASSES; i++)
     ClassForClassId (T, i) = NULL;
@@ -739,13 +744,294 @@ INT_TEMPLATES NewIntTemplates() {
 void free_int_templates(INT_TEMPLATES templates) {
   int i;
 
-  for (i = 0; i < templates->NumClasses; i++)
-    free_int_class(templates->Class[i]);
+  if (templates->PackedArena != NULL) {
+    Efree(templates->PackedArena);
+  } else {
+    for (i = 0; i < templates->NumClasses; i++)
+      free_int_class(templates->Class[i]);
+  }
   for (i = 0; i < templates->NumClassPruners; i++)
     delete templates->ClassPruners[i];
+  if (templates->PrunerBounds != NULL)
+    Efree(templates->PrunerBounds);
   Efree(templates);
 }
 
+/*---------------------------------------------------------------------------*/
+/**
+ * This routine returns the number of bytes of heap held by templates: the
+ * classes with their proto sets and proto lengths, the class pruners and
+ * the pruner bounds.
+ * @param templates templates to measure
+ * @return Bytes used by templates.
+ * @note Exceptions: none
+ */
+int IntTemplatesMemoryUsed(const INT_TEMPLATES_STRUCT* templates) {
+  int bytes = sizeof(*templates);
+  for (int c = 0; c < templates->NumClasses; ++c) {
+    INT_CLASS int_class = templates->Class[c];
+    if (int_class == NULL) continue;
+    bytes += sizeof(*int_class);
+    bytes += int_class->NumProtoSets * sizeof(PROTO_SET_STRUCT);
+    if (int_class->ProtoLengths != NULL)
+      bytes += MaxNumIntProtosIn(int_class);
+  }
+  bytes += templates->NumClassPruners * sizeof(CLASS_PRUNER_STRUCT);
+  if (templates->PrunerBounds != NULL) {
+    bytes += NUM_CP_BUCKETS * NUM_CP_BUCKETS * NUM_CP_BUCKETS *
+        templates->NumClassPruners;
+  }
+  return bytes;
+}
+
+// Alignment of each part of the arena made by PackIntTemplates, the size of
+// a cache line.
+const size_t kPackedAlignment = 64;
+
+static size_t PackedSize(size_t size) {
+  return (size + kPackedAlignment - 1) & ~(kPackedAlignment - 1);
+}
+
+/**
+ * This routine moves all the classes of templates, with their proto sets
+ * (proto pruners, protos and config bit vectors) and proto lengths, into one
+ * contiguous arena ordered by class id, in which every class and proto set
+ * starts on a cache line. Matching a class then reads a few neighbouring
+ * lines instead of separate heap blocks. The classes cannot have protos
+ * added once packed, so this is only for templates that are read-only after
+ * loading, such as the pre-trained templates.
+ * @param templates templates to pack
+ * @note Exceptions: none
+ */
+void PackIntTemplates(INT_TEMPLATES templates) {
+  if (templates->PackedArena != NULL) return;
+  size_t size = 0;
+  for (int c = 0; c < templates->NumClasses; ++c) {
+    INT_CLASS int_class = templates->Class[c];
+    if (int_class == NULL) continue;
+    size += PackedSize(sizeof(INT_CLASS_STRUCT));
+    size += int_class->NumProtoSets * PackedSize(sizeof(PROTO_SET_STRUCT));
+    if (int_class->ProtoLengths != NULL)
+      size += PackedSize(MaxNumIntProtosIn(int_class));
+  }
+  if (size == 0) return;
+  char* arena = static_cast<char*>(Emalloc(size + kPackedAlignment - 1));
+  char* next = reinterpret_cast<char*>(PackedSize(
+      reinterpret_cast<uintptr_t>(arena)));
+  for (int c = 0; c < templates->NumClasses; ++c) {
+    INT_CLASS int_class = templates->Class[c];
+    if (int_class == NULL) continue;
+    INT_CLASS packed = reinterpret_cast<INT_CLASS>(next);
+    next += PackedSize(sizeof(INT_CLASS_STRUCT));
+    memcpy(packed, int_class, sizeof(INT_CLASS_STRUCT));
+    for (int s = 0; s < int_class->NumProtoSets; ++s) {
+      packed->ProtoSets[s] = reinterpret_cast<PROTO_SET>(next);
+      next += PackedSize(sizeof(PROTO_SET_STRUCT));
+      memcpy(packed->ProtoSets[s], int_class->ProtoSets[s],
+             sizeof(PROTO_SET_STRUCT));
+    }
+    if (int_class->ProtoLengths != NULL) {
+      packed->ProtoLengths = reinterpret_cast<uinT8*>(next);
+      next += PackedSize(MaxNumIntProtosIn(int_class));
+      memcpy(packed->ProtoLengths, int_class->ProtoLengths,
+             MaxNumIntProtosIn(int_class));
+    }
+    free_int_class(int_class);
+    templates->Class[c] = packed;
+  }
+  templates->PackedArena = arena;
+}
+
+/**
+ * This routine computes, for every bucket of every class pruner of
+ * templates, the largest weight that any of the classes of the pruner has
+ * in that bucket. The class pruner can then bound the count of every class
+ * of a pruner by a single lookup per feature, and skip the pruners that
+ * cannot reach its threshold. The classes must not change afterwards.
+ * @param templates templates to compute the bounds of
+ * @note Exceptions: none
+ */
+void BuildClassPrunerBounds(INT_TEMPLATES templates) {
+  if (templates->PrunerBounds != NULL) return;
+  int num_pruners = templates->NumClassPruners;
+  const int kNumBuckets = NUM_CP_BUCKETS * NUM_CP_BUCKETS * NUM_CP_BUCKETS;
+  if (num_pruners == 0) return;
+  uinT8* bounds = static_cast<uinT8*>(Emalloc(kNumBuckets * num_pruners));
+  for (int p = 0; p < num_pruners; ++p) {
+    const uinT32* word = &templates->ClassPruners[p]->p[0][0][0][0];
+    for (int b = 0; b < kNumBuckets; ++b) {
+      int bound = 0;
+      for (int w = 0; w < WERDS_PER_CP_VECTOR; ++w, ++word) {
+        for (uinT32 weights = *word; weights != 0;
+             weights >>= NUM_BITS_PER_CLASS) {
+          bound = MAX(bound,
+                      static_cast<int>(weights & CLASS_PRUNER_CLASS_MASK));
+        }
+      }
+      bounds[b * num_pruners + p] = bound;
+    }
+  }
+  templates->PrunerBounds = bounds;
+}
+
+/**
+ * This routine makes new templates that hold only the class pruners of the
+ * given classes of templates: class i of the new class pruners has the
+ * weights of class classes[i] of templates. The new templates have no
+ * classes of their own, so the class pruner results on them must be mapped
+ * back through classes. They get pruner bounds if templates has them.
+ * @param templates templates to take the class pruner weights from
+ * @param classes the classes of templates to keep, in the order wanted
+ * @return New templates with only class pruners and bounds.
+ * @note Exceptions: none
+ */
+INT_TEMPLATES NewSubsetClassPruners(const INT_TEMPLATES_STRUCT* templates,
+                                    const GenericVector<int>& classes) {
+  INT_TEMPLATES subset = NewIntTemplates();
+  int num_classes = classes.size();
+  subset->NumClassPruners = (num_classes + CLASSES_PER_CP - 1) /
+                            CLASSES_PER_CP;
+  for (int p = 0; p < subset->NumClassPruners; ++p) {
+    subset->ClassPruners[p] = new CLASS_PRUNER_STRUCT;
+    memset(subset->ClassPruners[p], 0, sizeof(CLASS_PRUNER_STRUCT));
+  }
+  for (int i = 0; i < num_classes; ++i) {
+    int class_id = classes[i];
+    const CLASS_PRUNER_STRUCT* src = CPrunerFor(templates, class_id);
+    CLASS_PRUNER_STRUCT* dest = CPrunerFor(subset, i);
+    int src_word = CPrunerWordIndexFor(class_id);
+    int src_shift = CPrunerBitIndexFor(class_id) * NUM_BITS_PER_CLASS;
+    int dest_word = CPrunerWordIndexFor(i);
+    int dest_shift = CPrunerBitIndexFor(i) * NUM_BITS_PER_CLASS;
+    for (int x = 0; x < NUM_CP_BUCKETS; ++x) {
+      for (int y = 0; y < NUM_CP_BUCKETS; ++y) {
+        for (int theta = 0; theta < NUM_CP_BUCKETS; ++theta) {
+          uinT32 weight = (src->p[x][y][theta][src_word] >> src_shift) &
+                          CLASS_PRUNER_CLASS_MASK;
+          dest->p[x][y][theta][dest_word] |= weight << dest_shift;
+        }
+      }
+    }
+  }
+  if (templates->PrunerBounds != NULL)
+    BuildClassPrunerBounds(subset);
+  return subset;
+}
+
+/**
+ * This routine writes templates to fp in the native byte order, without the
+ * font tables, for DeSerializeIntTemplates to read back in the same process
+ * or another on the same platform.
+ * @param templates templates to write
+ * @param fp file to write to
+ * @return false on a write error.
+ * @note Exceptions: none
+ */
+bool SerializeIntTemplates(const INT_TEMPLATES_STRUCT* templates,
+                           tesseract::TFile* fp) {
+  inT32 num_classes = templates->NumClasses;
+  inT32 num_pruners = templates->NumClassPruners;
+  if (fp->FWrite(&num_classes, sizeof(num_classes), 1) != 1 ||
+      fp->FWrite(&num_pruners, sizeof(num_pruners), 1) != 1)
+    return false;
+  for (int p = 0; p < num_pruners; ++p) {
+    if (fp->FWrite(templates->ClassPruners[p],
+                   sizeof(CLASS_PRUNER_STRUCT), 1) != 1)
+      return false;
+  }
+  for (int c = 0; c < num_classes; ++c) {
+    const INT_CLASS_STRUCT* int_class = templates->Class[c];
+    if (int_class == NULL) return false;
+    inT32 font_set_id = int_class->font_set_id;
+    int num_lengths = MaxNumIntProtosIn(int_class);
+    if (fp->FWrite(&int_class->NumProtos, sizeof(int_class->NumProtos),
+                   1) != 1 ||
+        fp->FWrite(&int_class->NumProtoSets, sizeof(int_class->NumProtoSets),
+                   1) != 1 ||
+        fp->FWrite(&int_class->NumConfigs, sizeof(int_class->NumConfigs),
+                   1) != 1 ||
+        fp->FWrite(&font_set_id, sizeof(font_set_id), 1) != 1 ||
+        fp->FWrite(int_class->ConfigLengths, sizeof(uinT16),
+                   MAX_NUM_CONFIGS) != MAX_NUM_CONFIGS ||
+        (num_lengths > 0 &&
+         fp->FWrite(int_class->ProtoLengths, sizeof(uinT8),
+                    num_lengths) != num_lengths))
+      return false;
+    for (int s = 0; s < int_class->NumProtoSets; ++s) {
+      if (fp->FWrite(int_class->ProtoSets[s], sizeof(PROTO_SET_STRUCT),
+                     1) != 1)
+        return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * This routine reads templates written by SerializeIntTemplates.
+ * @param fp file to read from
+ * @return New templates, or NULL if the data is truncated or invalid.
+ * @note Exceptions: none
+ */
+INT_TEMPLATES DeSerializeIntTemplates(tesseract::TFile* fp) {
+  inT32 num_classes, num_pruners;
+  if (fp->FRead(&num_classes, sizeof(num_classes), 1) != 1 ||
+      fp->FRead(&num_pruners, sizeof(num_pruners), 1) != 1 ||
+      num_classes < 0 || num_classes > MAX_NUM_CLASSES ||
+      num_pruners < 0 || num_pruners > MAX_NUM_CLASS_PRUNERS ||
+      num_pruners * CLASSES_PER_CP < num_classes)
+    return NULL;
+  INT_TEMPLATES templates = NewIntTemplates();
+  for (int p = 0; p < num_pruners; ++p) {
+    templates->ClassPruners[p] = new CLASS_PRUNER_STRUCT;
+    templates->NumClassPruners = p + 1;
+    if (fp->FRead(templates->ClassPruners[p],
+                  sizeof(CLASS_PRUNER_STRUCT), 1) != 1) {
+      free_int_templates(templates);
+      return NULL;
+    }
+  }
+  for (int c = 0; c < num_classes; ++c) {
+    INT_CLASS_STRUCT header;
+    inT32 font_set_id;
+    if (fp->FRead(&header.NumProtos, sizeof(header.NumProtos), 1) != 1 ||
+        fp->FRead(&header.NumProtoSets, sizeof(header.NumProtoSets),
+                  1) != 1 ||
+        fp->FRead(&header.NumConfigs, sizeof(header.NumConfigs), 1) != 1 ||
+        fp->FRead(&font_set_id, sizeof(font_set_id), 1) != 1 ||
+        header.NumProtoSets > MAX_NUM_PROTO_SETS ||
+        header.NumProtos > header.NumProtoSets * PROTOS_PER_PROTO_SET ||
+        header.NumConfigs > MAX_NUM_CONFIGS) {
+      free_int_templates(templates);
+      return NULL;
+    }
+    INT_CLASS int_class =
+        NewIntClass(header.NumProtoSets * PROTOS_PER_PROTO_SET,
+                    header.NumConfigs);
+    templates->Class[c] = int_class;
+    templates->NumClasses = c + 1;
+    int_class->NumProtos = header.NumProtos;
+    int_class->NumConfigs = header.NumConfigs;
+    int_class->font_set_id = font_set_id;
+    int num_lengths = MaxNumIntProtosIn(int_class);
+    if (fp->FRead(int_class->ConfigLengths, sizeof(uinT16),
+                  MAX_NUM_CONFIGS) != MAX_NUM_CONFIGS ||
+        (num_lengths > 0 &&
+         fp->FRead(int_class->ProtoLengths, sizeof(uinT8),
+                   num_lengths) != num_lengths)) {
+      free_int_templates(templates);
+      return NULL;
+    }
+    for (int s = 0; s < int_class->NumProtoSets; ++s) {
+      if (fp->FRead(int_class->ProtoSets[s], sizeof(PROTO_SET_STRUCT),
+                    1) != 1) {
+        free_int_templates(templates);
+        return NULL;
+      }
+    }
+  }
+  return templates;
+}
+
 
 namespace tesseract {
 /**
@@ -753,12 +1039,17 @@ namespace tesseract {
  * File.  File must already be open and must be in the
  * correct binary format.
  * @param  File    open file to read templates from
+ * @param  font_tables_offset if not NULL, receives the offset of the font
+ *                  tables from the start of the templates, for use with
+ *                  ReadIntTemplatesFontTables.
  * @return Pointer to integer templates read from File.
  * @note Globals: none
  * @note Exceptions: none
  * @note History: Wed Feb 27 11:48:46 1991, DSJ, Created.
  */
-INT_TEMPLATES Classify::ReadIntTemplates(FILE *File) {
+INT_TEMPLATES Classify::ReadIntTemplates(FILE *File,
+                                         inT64* font_tables_offset) {
+  inT64 start_pos = ftell(File);
   int i, j, w, x, y, z;
   BOOL8 swap;
   int nread;
@@ -1036,6 +1327,44 @@ INT_TEMPLATES Classify::ReadIntTemplates(FILE *File) {
       }
     }
   }
+  if (font_tables_offset != NULL)
+    *font_tables_offset = ftell(File) - start_pos;
+  ReadFontTables(File, version_id, swap);
+
+  // Clean up.
+  delete[] IndexFor;
+  delete[] ClassIdFor;
+  delete[] TempClassPruner;
+
+  return (Templates);
+}                                /* ReadIntTemplates */
+
+/**
+ * Reads just the font tables of a set of integer templates, without the
+ * classes, into this classifier's fontinfo_table_ and fontset_table_.
+ * Used when the templates themselves are shared with another classifier.
+ * @param File open file positioned at the start of the templates
+ * @param font_tables_offset from ReadIntTemplates
+ */
+void Classify::ReadIntTemplatesFontTables(FILE *File,
+                                          inT64 font_tables_offset) {
+  inT64 start_pos = ftell(File);
+  int header[4];
+  if (fread(header, sizeof(header[0]), 4, File) != 4) {
+    cprintf("Bad read of inttemp!\n");
+    return;
+  }
+  // Same swap and version detection as ReadIntTemplates.
+  bool swap = header[2] < 0 || header[2] > MAX_NUM_CLASS_PRUNERS;
+  if (swap) Reverse32(&header[1]);
+  int version_id = header[1] < 0 ? -header[1] : 0;
+  fseek(File, start_pos + font_tables_offset, SEEK_SET);
+  ReadFontTables(File, version_id, swap);
+}
+
+// Reads the font tables that follow the classes in integer templates of the
+// given version.
+void Classify::ReadFontTables(FILE *File, int version_id, bool swap) {
   if (version_id >= 4) {
     this->fontinfo_table_.read(File, NewPermanentTessCallback(read_info), swap);
     if (version_id >= 5) {
@@ -1045,14 +1374,7 @@ INT_TEMPLATES Classify::ReadIntTemplates(FILE *File) {
     }
     this->fontset_table_.read(File, NewPermanentTessCallback(read_set), swap);
   }
-
-  // Clean up.
-  delete[] IndexFor;
-  delete[] ClassIdFor;
-  delete[] TempClassPruner;
-
-  return (Templates);
-}                                /* ReadIntTemplates */
+}
 
 
 #ifndef GRAPHICS_DISABLED
@@ -29,6 +29,9 @@
 #include "unicharset.h"
 
 class FCOORD;
+namespace tesseract {
+class TFile;
+}
 
 /* define order of params in pruners */
 #define PRUNER_X      0
@@ -123,6 +126,14 @@ typedef struct
   int NumClassPruners;
   INT_CLASS Class[MAX_NUM_CLASSES];
   CLASS_PRUNER_STRUCT* ClassPruners[MAX_NUM_CLASS_PRUNERS];
+  // If not NULL, the classes, their proto sets and proto lengths all live in
+  // this one allocation, made by PackIntTemplates, and cannot be changed.
+  void* PackedArena;
+  // If not NULL, the largest weight of any class of class pruner p in bucket
+  // b is PrunerBounds[b * NumClassPruners + p], where b is the index of the
+  // bucket in CLASS_PRUNER_STRUCT::p. Made by BuildClassPrunerBounds for
+  // templates that do not change after loading.
+  uinT8* PrunerBounds;
 }
 
 
@@ -237,6 +248,20 @@ INT_TEMPLATES NewIntTemplates();
 
 void free_int_templates(INT_TEMPLATES templates);
 
+int IntTemplatesMemoryUsed(const INT_TEMPLATES_STRUCT* templates);
+
+void PackIntTemplates(INT_TEMPLATES templates);
+
+void BuildClassPrunerBounds(INT_TEMPLATES templates);
+
+INT_TEMPLATES NewSubsetClassPruners(const INT_TEMPLATES_STRUCT* templates,
+                                    const GenericVector<int>& classes);
+
+bool SerializeIntTemplates(const INT_TEMPLATES_STRUCT* templates,
+                           tesseract::TFile* fp);
+
+INT_TEMPLATES DeSerializeIntTemplates(tesseract::TFile* fp);
+
 void ShowMatchDisplay();
 
 namespace tesseract {
@@ -37,6 +37,8 @@
 #include "shapeclassifier.h"
 #include "shapetable.h"
 #include "svmnode.h"
+#include "tesscallback.h"
+#include "threadpool.h"
 
 #include "scanutils.h"
 
@@ -50,6 +52,11 @@ const int kMinClusteredShapes = 1;
 const int kMaxUnicharsPerCluster = 2000;
 // Mean font distance below which to merge fonts and unichars.
 const float kFontMergeDistance = 0.025;
+// Min number of shapes in a shape table for its distance matrix to be worth
+// checkpointing.
+const int kMinCheckpointShapes = 100;
+// Number of rows of the shape distance matrix to compute between checkpoints.
+const int kShapeDistRowsPerCheckpoint = 32;
 
 MasterTrainer::MasterTrainer(NormalizationMode norm_mode,
                              bool shape_analysis,
@@ -60,10 +67,12 @@ MasterTrainer::MasterTrainer(NormalizationMode norm_mode,
     charsetsize_(0),
     enable_shape_anaylsis_(shape_analysis),
     enable_replication_(replicate_samples),
-    fragments_(NULL), prev_unichar_id_(-1), debug_level_(debug_level) {
+    fragments_(NULL), prev_unichar_id_(-1), debug_level_(debug_level),
+    thread_pool_(NULL) {
 }
 
 MasterTrainer::~MasterTrainer() {
+  delete thread_pool_;
   delete [] fragments_;
   for (int p = 0; p < page_images_.size(); ++p)
     pixDestroy(&page_images_[p]);
@@ -100,6 +109,9 @@ bool MasterTrainer::DeSerialize(bool swap, FILE* fp) {
   if (!samples_.DeSerialize(swap, fp)) return false;
   if (!junk_samples_.DeSerialize(swap, fp)) return false;
   if (!verify_samples_.DeSerialize(swap, fp)) return false;
+  samples_.StoreNewFeatures();
+  junk_samples_.StoreNewFeatures();
+  verify_samples_.StoreNewFeatures();
   if (!master_shapes_.DeSerialize(swap, fp)) return false;
   if (!flat_shapes_.DeSerialize(swap, fp)) return false;
   if (!fontinfo_table_.DeSerialize(swap, fp)) return false;
@@ -179,6 +191,9 @@ void MasterTrainer::ReadTrainingSamples(const char* page_name,
   }
   charsetsize_ = unicharset_.size();
   fclose(fp);
+  samples_.StoreNewFeatures();
+  junk_samples_.StoreNewFeatures();
+  verify_samples_.StoreNewFeatures();
 }
 
 // Adds the given single sample to the trainer, setting the classid
@@ -820,6 +835,28 @@ double MasterTrainer::TestClassifier(CountTypes error_mode,
   return unichar_error;
 }
 
+// As TestClassifierOnSamples, but shards the internal samples across one
+// thread per classifier, and also reports the throughput and the latency
+// per sample.
+double MasterTrainer::TestClassifiersInParallel(
+    CountTypes error_mode, int report_level, bool replicate_samples,
+    const GenericVector<ShapeClassifier*>& test_classifiers,
+    STRING* report_string) {
+  SampleIterator sample_it;
+  sample_it.Init(NULL, NULL, replicate_samples, &samples_);
+  if (report_level > 0) {
+    tprintf("Testing %sREPLICATED on %d threads:\n",
+            replicate_samples ? "" : "NON-", test_classifiers.size());
+  }
+  double unichar_error = 0.0;
+  ErrorCounter::ComputeErrorRateInParallel(test_classifiers, report_level,
+                                           error_mode, fontinfo_table_,
+                                           page_images_, &sample_it,
+                                           &unichar_error, NULL,
+                                           report_string);
+  return unichar_error;
+}
+
 // Returns the average (in some sense) distance between the two given
 // shapes, which may contain multiple fonts and/or unichars.
 float MasterTrainer::ShapeDistance(const ShapeTable& shapes, int s1, int s2) {
@@ -913,6 +950,206 @@ void MasterTrainer::ReplaceFragmentedSamples() {
   fragments_ = NULL;
 }
 
+// Arguments for computing rows of the shape distance matrix in parallel.
+struct ShapeDistRowJob {
+  MasterTrainer* trainer;
+  const ShapeTable* shapes;
+  GenericVector<ShapeDist>* shape_dists;
+  // Indices of the rows to compute.
+  GenericVector<int> rows;
+};
+
+// Computes the row of the shape distance matrix given by job->rows[index].
+static void ComputeShapeDistRow(ShapeDistRowJob* job, int index) {
+  int s1 = job->rows[index];
+  int num_shapes = job->shapes->NumShapes();
+  GenericVector<ShapeDist>* row = &job->shape_dists[s1];
+  row->reserve(num_shapes - s1 - 1);
+  for (int s2 = s1 + 1; s2 < num_shapes; ++s2) {
+    row->push_back(ShapeDist(s1, s2,
+                             job->trainer->ShapeDistance(*job->shapes,
+                                                         s1, s2)));
+  }
+}
+
+// Arguments for recomputing individual shape distances in parallel.
+struct ShapeDistUpdateJob {
+  MasterTrainer* trainer;
+  const ShapeTable* shapes;
+  const GenericVector<ShapeDist*>* dists;
+};
+
+// Recomputes the distance of job->dists[index].
+static void UpdateShapeDist(ShapeDistUpdateJob* job, int index) {
+  ShapeDist* dist = (*job->dists)[index];
+  dist->distance = job->trainer->ShapeDistance(*job->shapes,
+                                               dist->shape1, dist->shape2);
+}
+
+// Reads the rows of a shape distance matrix from a checkpoint file written
+// by WriteShapeDistRow, into shape_dists, marking the rows read in
+// done_rows. A missing file, or one that was written for a different shape
+// table, is ignored, as is a truncated last row.
+static void ReadShapeDistCheckpoint(const STRING& filename, int num_shapes,
+                                    inT32 table_hash,
+                                    GenericVector<ShapeDist>* shape_dists,
+                                    GenericVector<bool>* done_rows) {
+  FILE* fp = fopen(filename.string(), "rb");
+  if (fp == NULL) return;
+  inT32 header[2];
+  if (fread(header, sizeof(header[0]), 2, fp) == 2 &&
+      header[0] == num_shapes && header[1] == table_hash) {
+    inT32 s1;
+    GenericVector<float> distances;
+    while (fread(&s1, sizeof(s1), 1, fp) == 1 && s1 >= 0 && s1 < num_shapes) {
+      int row_size = num_shapes - s1 - 1;
+      distances.init_to_size(row_size, 0.0f);
+      if (row_size > 0 &&
+          static_cast<int>(fread(&distances[0], sizeof(distances[0]),
+                                 row_size, fp)) != row_size)
+        break;
+      shape_dists[s1].truncate(0);
+      for (int i = 0; i < row_size; ++i)
+        shape_dists[s1].push_back(ShapeDist(s1, s1 + 1 + i, distances[i]));
+      (*done_rows)[s1] = true;
+    }
+  }
+  fclose(fp);
+}
+
+// Appends the given row of a shape distance matrix to a checkpoint file.
+static bool WriteShapeDistRow(const GenericVector<ShapeDist>& row, int s1,
+                              FILE* fp) {
+  inT32 row_index = s1;
+  if (fwrite(&row_index, sizeof(row_index), 1, fp) != 1) return false;
+  for (int i = 0; i < row.size(); ++i) {
+    if (fwrite(&row[i].distance, sizeof(row[i].distance), 1, fp) != 1)
+      return false;
+  }
+  return true;
+}
+
+// Returns a hash of the contents of the given shape table, so a checkpoint
+// can tell whether it belongs to it.
+static inT32 ShapeTableHash(const ShapeTable& shapes) {
+  uinT32 hash = 0;
+  for (int s = 0; s < shapes.NumShapes(); ++s) {
+    STRING shape_str = shapes.DebugStr(s);
+    for (int i = 0; i < shape_str.length(); ++i)
+      hash = hash * 31 + static_cast<unsigned char>(shape_str[i]);
+  }
+  return static_cast<inT32>(hash & 0x7fffffff);
+}
+
+// Returns the name of the checkpoint file for the distance matrix of the
+// given shapes, or an empty string if it should not be checkpointed.
+STRING MasterTrainer::ShapeCheckpointName(const ShapeTable& shapes) const {
+  STRING filename;
+  if (shape_checkpoint_.length() == 0 ||
+      shapes.NumShapes() < kMinCheckpointShapes)
+    return filename;
+  filename = shape_checkpoint_;
+  filename.add_str_int(".", shapes.NumShapes());
+  filename.add_str_int(".", ShapeTableHash(shapes));
+  return filename;
+}
+
+// Fills shape_dists[s1] with the distances from shape s1 to every shape
+// s2 > s1, in order of s2, using thread_pool_ if there is one. Rows that
+// are found in the given checkpoint file are read instead of computed, and
+// newly computed rows are added to it. An empty checkpoint disables that.
+void MasterTrainer::ComputeShapeDistances(
+    const ShapeTable& shapes, const STRING& checkpoint,
+    GenericVector<ShapeDist>* shape_dists) {
+  int num_shapes = shapes.NumShapes();
+  GenericVector<bool> done_rows;
+  done_rows.init_to_size(num_shapes, false);
+  FILE* checkpoint_fp = NULL;
+  if (checkpoint.length() > 0) {
+    inT32 table_hash = ShapeTableHash(shapes);
+    ReadShapeDistCheckpoint(checkpoint, num_shapes, table_hash, shape_dists,
+                            &done_rows);
+    // Rewrite the checkpoint from what was read, dropping anything truncated
+    // by an interruption, so new rows can be appended to it.
+    checkpoint_fp = fopen(checkpoint.string(), "wb");
+    inT32 header[2] = { num_shapes, table_hash };
+    if (checkpoint_fp != NULL &&
+        fwrite(header, sizeof(header[0]), 2, checkpoint_fp) != 2) {
+      fclose(checkpoint_fp);
+      checkpoint_fp = NULL;
+    }
+    int num_resumed = 0;
+    for (int s1 = 0; s1 < num_shapes; ++s1) {
+      if (!done_rows[s1]) continue;
+      ++num_resumed;
+      if (checkpoint_fp != NULL &&
+          !WriteShapeDistRow(shape_dists[s1], s1, checkpoint_fp)) {
+        fclose(checkpoint_fp);
+        checkpoint_fp = NULL;
+      }
+    }
+    if (num_resumed > 0)
+      tprintf("Resumed %d of %d rows from %s...", num_resumed, num_shapes,
+              checkpoint.string());
+    if (checkpoint_fp == NULL)
+      tprintf("Can't write shape distance checkpoint %s\n",
+              checkpoint.string());
+  }
+  ShapeDistRowJob job;
+  job.trainer = this;
+  job.shapes = &shapes;
+  job.shape_dists = shape_dists;
+  TessCallback1<int>* row_callback =
+      NewPermanentTessCallback(&ComputeShapeDistRow, &job);
+  for (int s1 = 0; s1 < num_shapes;) {
+    // Gather the next batch of rows still to compute.
+    job.rows.truncate(0);
+    for (; s1 < num_shapes && job.rows.size() < kShapeDistRowsPerCheckpoint;
+         ++s1) {
+      if (!done_rows[s1]) job.rows.push_back(s1);
+    }
+    if (thread_pool_ != NULL && job.rows.size() > 1) {
+      thread_pool_->ParallelFor(job.rows.size(), row_callback);
+    } else {
+      for (int i = 0; i < job.rows.size(); ++i)
+        ComputeShapeDistRow(&job, i);
+    }
+    for (int i = 0; i < job.rows.size(); ++i) {
+      if (checkpoint_fp != NULL &&
+          !WriteShapeDistRow(shape_dists[job.rows[i]], job.rows[i],
+                             checkpoint_fp)) {
+        tprintf("Can't write shape distance checkpoint %s\n",
+                checkpoint.string());
+        fclose(checkpoint_fp);
+        checkpoint_fp = NULL;
+      }
+      tprintf(" %d", job.rows[i]);
+    }
+    if (checkpoint_fp != NULL) fflush(checkpoint_fp);
+  }
+  delete row_callback;
+  if (checkpoint_fp != NULL) fclose(checkpoint_fp);
+}
+
+// Recomputes the distance of each of the given ShapeDists, using
+// thread_pool_ if there is one.
+void MasterTrainer::UpdateShapeDistances(
+    const ShapeTable& shapes, const GenericVector<ShapeDist*>& dists) {
+  ShapeDistUpdateJob job;
+  job.trainer = this;
+  job.shapes = &shapes;
+  job.dists = &dists;
+  if (thread_pool_ != NULL && dists.size() > 1) {
+    TessCallback1<int>* callback =
+        NewPermanentTessCallback(&UpdateShapeDist, &job);
+    thread_pool_->ParallelFor(dists.size(), callback);
+    delete callback;
+  } else {
+    for (int i = 0; i < dists.size(); ++i)
+      UpdateShapeDist(&job, i);
+  }
+}
+
 // Runs a hierarchical agglomerative clustering to merge shapes in the given
 // shape_table, while satisfying the given constraints:
 // * End with at least min_shapes left in shape_table,
@@ -928,18 +1165,17 @@ void MasterTrainer::ClusterShapes(int min_shapes,  int max_shape_unichars,
   float min_dist = kInfiniteDist;
   int min_s1 = 0;
   int min_s2 = 0;
+  STRING checkpoint = ShapeCheckpointName(*shapes);
   tprintf("Computing shape distances...");
+  ComputeShapeDistances(*shapes, checkpoint, shape_dists);
   for (int s1 = 0; s1 < num_shapes; ++s1) {
-    for (int s2 = s1 + 1; s2 < num_shapes; ++s2) {
-      ShapeDist dist(s1, s2, ShapeDistance(*shapes, s1, s2));
-      shape_dists[s1].push_back(dist);
-      if (dist.distance < min_dist) {
-        min_dist = dist.distance;
+    for (int i = 0; i < shape_dists[s1].size(); ++i) {
+      if (shape_dists[s1][i].distance < min_dist) {
+        min_dist = shape_dists[s1][i].distance;
         min_s1 = s1;
-        min_s2 = s2;
+        min_s2 = s1 + 1 + i;
       }
     }
-    tprintf(" %d", s1);
   }
   tprintf("\n");
   int num_merged = 0;
@@ -955,18 +1191,18 @@ void MasterTrainer::ClusterShapes(int min_shapes,  int max_shape_unichars,
       shape_dists[min_s2].clear();
       ++num_merged;
 
+      GenericVector<ShapeDist*> stale_dists;
       for (int s = 0; s < min_s1; ++s) {
         if (!shape_dists[s].empty()) {
-          shape_dists[s][min_s1 - s - 1].distance =
-              ShapeDistance(*shapes, s, min_s1);
+          stale_dists.push_back(&shape_dists[s][min_s1 - s - 1]);
           shape_dists[s][min_s2 - s -1].distance = kInfiniteDist;
         }
       }
       for (int s2 = min_s1 + 1; s2 < num_shapes; ++s2) {
         if (shape_dists[min_s1][s2 - min_s1 - 1].distance < kInfiniteDist)
-          shape_dists[min_s1][s2 - min_s1 - 1].distance =
-              ShapeDistance(*shapes, min_s1, s2);
+          stale_dists.push_back(&shape_dists[min_s1][s2 - min_s1 - 1]);
       }
+      UpdateShapeDistances(*shapes, stale_dists);
       for (int s = min_s1 + 1; s < min_s2; ++s) {
         if (!shape_dists[s].empty()) {
           shape_dists[s][min_s2 - s - 1].distance = kInfiniteDist;
@@ -986,6 +1222,9 @@ void MasterTrainer::ClusterShapes(int min_shapes,  int max_shape_unichars,
   }
   tprintf("Stopped with %d merged, min dist %f\n", num_merged, min_dist);
   delete [] shape_dists;
+  // The clustering is complete, so the checkpoint is no longer needed.
+  if (checkpoint.length() > 0)
+    remove(checkpoint.string());
   if (debug_level_ > 1) {
     for (int s1 = 0; s1 < num_shapes; ++s1) {
       if (shapes->MasterDestinationIndex(s1) == s1) {
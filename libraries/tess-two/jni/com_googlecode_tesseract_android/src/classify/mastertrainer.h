@@ -45,6 +45,7 @@
 namespace tesseract {
 
 class ShapeClassifier;
+class ThreadPool;
 
 // Simple struct to hold the distance between two shapes during clustering.
 struct ShapeDist {
@@ -81,6 +82,22 @@ class TESS_API MasterTrainer {
   // Loads an initial unicharset, or sets one up if the file cannot be read.
   void LoadUnicharset(const char* filename);
 
+  // Sets the number of threads used to compute shape distances in
+  // SetupMasterShapes. The resulting shape table is the same for any number.
+  void SetNumThreads(int num_threads);
+  // Sets the file name prefix for the checkpoints of the shape distance
+  // matrix, so that an interrupted SetupMasterShapes can resume without
+  // recomputing the distances it already had. Empty disables checkpoints.
+  void SetShapeCheckpoint(const char* filename_prefix) {
+    shape_checkpoint_ = filename_prefix;
+  }
+
+  // Keeps the features of the training, junk and verification samples in
+  // scratch files named from the given prefix, instead of in memory, so that
+  // large corpora can be trained with modest memory. Call before reading or
+  // deserializing the samples. Returns false if the files can't be created.
+  bool SetSampleStore(const char* filename_prefix);
+
   // Sets the feature space definition.
   void SetFeatureSpace(const IntFeatureSpace& fs) {
     feature_space_ = fs;
@@ -244,6 +261,14 @@ class TESS_API MasterTrainer {
                         TrainingSampleSet* samples,
                         ShapeClassifier* test_classifier,
                         STRING* report_string);
+  // As TestClassifierOnSamples, but shards the internal samples across one
+  // thread per classifier, and also reports the throughput and the latency
+  // per sample. Each classifier must have its own mutable state, such as
+  // a separately initialized Classify, though they may share templates.
+  double TestClassifiersInParallel(
+      CountTypes error_mode, int report_level, bool replicate_samples,
+      const GenericVector<ShapeClassifier*>& test_classifiers,
+      STRING* report_string);
 
   // Returns the average (in some sense) distance between the two given
   // shapes, which may contain multiple fonts and/or unichars.
@@ -263,6 +288,21 @@ class TESS_API MasterTrainer {
   void ClusterShapes(int min_shapes, int max_shape_unichars,
                      float max_dist, ShapeTable* shape_table);
 
+  // Fills shape_dists[s1] with the distances from shape s1 to every shape
+  // s2 > s1, in order of s2, using thread_pool_ if there is one. Rows that
+  // are found in the given checkpoint file are read instead of computed, and
+  // newly computed rows are added to it. An empty checkpoint disables that.
+  void ComputeShapeDistances(const ShapeTable& shapes,
+                             const STRING& checkpoint,
+                             GenericVector<ShapeDist>* shape_dists);
+  // Recomputes the distance of each of the given ShapeDists, using
+  // thread_pool_ if there is one.
+  void UpdateShapeDistances(const ShapeTable& shapes,
+                            const GenericVector<ShapeDist*>& dists);
+  // Returns the name of the checkpoint file for the distance matrix of the
+  // given shapes, or an empty string if it should not be checkpointed.
+  STRING ShapeCheckpointName(const ShapeTable& shapes) const;
+
  private:
   NormalizationMode norm_mode_;
   // Character set we are training for.
@@ -305,6 +345,10 @@ class TESS_API MasterTrainer {
   GenericVector<Pix*> page_images_;
   // Vector of filenames of loaded tr files.
   GenericVector<STRING> tr_filenames_;
+  // Pool of threads used to compute shape distances. NULL if single-threaded.
+  ThreadPool* thread_pool_;
+  // File name prefix for checkpoints of the shape distance matrix.
+  STRING shape_checkpoint_;
 };
 
 }  // namespace tesseract.
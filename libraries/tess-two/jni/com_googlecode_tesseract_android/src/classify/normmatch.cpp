@@ -161,16 +161,21 @@ FLOAT32 Classify::ComputeNormMatch(CLASS_ID ClassId,
 
 void Classify::FreeNormProtos() {
   if (NormProtos != NULL) {
-    for (int i = 0; i < NormProtos->NumProtos; i++)
-      FreeProtoList(&NormProtos->Protos[i]);
-    Efree(NormProtos->Protos);
-    Efree(NormProtos->ParamDesc);
-    Efree(NormProtos);
+    free_norm_protos(NormProtos);
     NormProtos = NULL;
   }
 }
 }  // namespace tesseract
 
+/*---------------------------------------------------------------------------*/
+void free_norm_protos(NORM_PROTOS *norm_protos) {
+  for (int i = 0; i < norm_protos->NumProtos; i++)
+    FreeProtoList(&norm_protos->Protos[i]);
+  Efree(norm_protos->Protos);
+  Efree(norm_protos->ParamDesc);
+  Efree(norm_protos);
+}
+
 /*----------------------------------------------------------------------------
               Private Code
 ----------------------------------------------------------------------------*/
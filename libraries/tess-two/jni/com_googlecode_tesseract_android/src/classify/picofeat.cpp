@@ -230,9 +230,10 @@ namespace tesseract {
 FEATURE_SET Classify::ExtractIntCNFeatures(
     const TBLOB& blob, const INT_FX_RESULT_STRUCT& fx_info) {
   INT_FX_RESULT_STRUCT local_fx_info(fx_info);
-  GenericVector<INT_FEATURE_STRUCT> bl_features;
+  IntFxScratch* scratch = AcquireFxScratch();
   tesseract::TrainingSample* sample = tesseract::BlobToTrainingSample(
-      blob, false, &local_fx_info, &bl_features);
+      blob, false, &local_fx_info, &scratch->bl_features, scratch);
+  ReleaseFxScratch(scratch);
   if (sample == NULL) return NULL;
 
   int num_features = sample->num_features();
@@ -262,9 +263,10 @@ FEATURE_SET Classify::ExtractIntCNFeatures(
 FEATURE_SET Classify::ExtractIntGeoFeatures(
     const TBLOB& blob, const INT_FX_RESULT_STRUCT& fx_info) {
   INT_FX_RESULT_STRUCT local_fx_info(fx_info);
-  GenericVector<INT_FEATURE_STRUCT> bl_features;
+  IntFxScratch* scratch = AcquireFxScratch();
   tesseract::TrainingSample* sample = tesseract::BlobToTrainingSample(
-      blob, false, &local_fx_info, &bl_features);
+      blob, false, &local_fx_info, &scratch->bl_features, scratch);
+  ReleaseFxScratch(scratch);
   if (sample == NULL) return NULL;
 
   FEATURE_SET feature_set = NewFeatureSet(1);
@@ -0,0 +1,167 @@
+///////////////////////////////////////////////////////////////////////
+// File:        samplefeaturestore.cpp
+// Description: Disk file holding the features of TrainingSamples, mapped
+//              into memory so they are paged in only when used.
+//
+// (C) Copyright 2016, Google Inc.
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////
+
+#include "samplefeaturestore.h"
+
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <sys/types.h>
+#include <unistd.h>
+#endif
+
+#include "trainingsample.h"
+#include "tprintf.h"
+
+namespace tesseract {
+
+// Writes zeros to fp to advance *size to a multiple of alignment.
+// Returns false on error.
+static bool WritePadding(inT64 alignment, FILE* fp, inT64* size) {
+  for (; *size % alignment != 0; ++*size) {
+    if (fputc(0, fp) == EOF) return false;
+  }
+  return true;
+}
+
+SampleFeatureStore::SampleFeatureStore() : fp_(NULL), size_(0) {}
+
+SampleFeatureStore::~SampleFeatureStore() {
+  Close();
+}
+
+// Creates the store in the given file, overwriting any existing file.
+// Returns false on error.
+bool SampleFeatureStore::Open(const char* filename) {
+  Close();
+#ifdef _WIN32
+  tprintf("Can't map sample feature store %s on this platform\n", filename);
+  return false;
+#else
+  fp_ = fopen(filename, "w+b");
+  if (fp_ == NULL) {
+    tprintf("Can't create sample feature store %s\n", filename);
+    return false;
+  }
+  filename_ = filename;
+  size_ = 0;
+  return true;
+#endif
+}
+
+// Unmaps and deletes the file. Samples that use the stored features must
+// not be used after this.
+void SampleFeatureStore::Close() {
+#ifndef _WIN32
+  for (int i = 0; i < segments_.size(); ++i)
+    munmap(segments_[i].data, segments_[i].size);
+#endif
+  segments_.clear();
+  if (fp_ != NULL) {
+    fclose(fp_);
+    fp_ = NULL;
+    remove(filename_.string());
+  }
+  size_ = 0;
+}
+
+// Moves the features of those of the given samples that are not already
+// stored into the store. NULL samples are skipped. On error, returns false
+// and leaves the samples as they were.
+bool SampleFeatureStore::Store(const GenericVector<TrainingSample*>& samples) {
+#ifdef _WIN32
+  return false;
+#else
+  if (fp_ == NULL) return false;
+  // Write the new features after the last segment, recording where the
+  // features of each sample start relative to the segment.
+  GenericVector<int> stored_samples;
+  GenericVector<inT64> offsets;
+  inT64 segment_size = 0;
+  bool ok = true;
+  for (int s = 0; ok && s < samples.size(); ++s) {
+    const TrainingSample* sample = samples[s];
+    if (sample == NULL || sample->features_are_stored()) continue;
+    stored_samples.push_back(s);
+    // The micro features are floats, so keep everything float-aligned.
+    ok = WritePadding(sizeof(float), fp_, &segment_size);
+    offsets.push_back(segment_size);
+    int num_features = sample->num_features();
+    int num_micro_features = sample->num_micro_features();
+    if (ok && num_features > 0) {
+      ok = static_cast<int>(fwrite(sample->features(),
+                                   sizeof(*sample->features()),
+                                   num_features, fp_)) == num_features;
+      segment_size += num_features * sizeof(*sample->features());
+    }
+    if (ok) ok = WritePadding(sizeof(float), fp_, &segment_size);
+    offsets.push_back(segment_size);
+    if (ok && num_micro_features > 0) {
+      ok = static_cast<int>(fwrite(sample->micro_features(),
+                                   sizeof(*sample->micro_features()),
+                                   num_micro_features,
+                                   fp_)) == num_micro_features;
+      segment_size += num_micro_features * sizeof(*sample->micro_features());
+    }
+  }
+  if (segment_size == 0) return ok;
+  // Pad to a whole page, so the next segment can be mapped too.
+  inT64 file_size = size_ + segment_size;
+  if (ok) ok = WritePadding(sysconf(_SC_PAGESIZE), fp_, &file_size);
+  void* map = MAP_FAILED;
+  if (ok && fflush(fp_) == 0) {
+    map = mmap(NULL, segment_size, PROT_READ, MAP_SHARED, fileno(fp_),
+               static_cast<off_t>(size_));
+  }
+  if (map == MAP_FAILED) {
+    tprintf("Can't add %d samples to feature store %s\n",
+            stored_samples.size(), filename_.string());
+    // Drop the partial segment so the next one starts at the same place.
+    fflush(fp_);
+    if (ftruncate(fileno(fp_), static_cast<off_t>(size_)) != 0 ||
+        fseek(fp_, 0, SEEK_END) != 0) {
+      // Give up on adding more, but keep the existing segments mapped, as
+      // samples are using them. The mappings outlive the deleted file.
+      fclose(fp_);
+      fp_ = NULL;
+      remove(filename_.string());
+    }
+    return false;
+  }
+  Segment segment = { map, segment_size };
+  segments_.push_back(segment);
+  size_ = file_size;
+  const char* data = static_cast<const char*>(map);
+  for (int i = 0; i < stored_samples.size(); ++i) {
+    TrainingSample* sample = samples[stored_samples[i]];
+    const INT_FEATURE_STRUCT* features = NULL;
+    if (sample->num_features() > 0) {
+      features =
+          reinterpret_cast<const INT_FEATURE_STRUCT*>(data + offsets[2 * i]);
+    }
+    const MicroFeature* micro_features = NULL;
+    if (sample->num_micro_features() > 0) {
+      micro_features =
+          reinterpret_cast<const MicroFeature*>(data + offsets[2 * i + 1]);
+    }
+    sample->UseStoredFeatures(features, micro_features);
+  }
+  return true;
+#endif
+}
+
+}  // namespace tesseract
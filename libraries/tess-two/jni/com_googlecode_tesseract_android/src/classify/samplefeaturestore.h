@@ -0,0 +1,78 @@
+///////////////////////////////////////////////////////////////////////
+// File:        samplefeaturestore.h
+// Description: Disk file holding the features of TrainingSamples, mapped
+//              into memory so they are paged in only when used.
+//
+// (C) Copyright 2016, Google Inc.
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////
+
+#ifndef TESSERACT_CLASSIFY_SAMPLEFEATURESTORE_H_
+#define TESSERACT_CLASSIFY_SAMPLEFEATURESTORE_H_
+
+#include <stdio.h>
+#include "genericvector.h"
+#include "host.h"
+#include "strngs.h"
+
+namespace tesseract {
+
+class TrainingSample;
+
+// An append-only scratch file of the int and micro features of
+// TrainingSamples. Each batch of samples that is stored is written to the
+// end of the file and mapped back into memory read-only, and the samples are
+// switched to use the mapped copies, freeing their own. The features are
+// then paged in by the kernel only when something, such as a SampleIterator,
+// reads them, and can be dropped again under memory pressure, so a very large
+// set of samples needs little more resident memory than what is in use.
+// The file is native-endian, and is deleted when the store is closed.
+// Needs mmap, so on Windows Open fails and the samples stay in memory.
+class SampleFeatureStore {
+ public:
+  SampleFeatureStore();
+  ~SampleFeatureStore();
+
+  // Creates the store in the given file, overwriting any existing file.
+  // Returns false on error.
+  bool Open(const char* filename);
+  // Unmaps and deletes the file. Samples that use the stored features must
+  // not be used after this.
+  void Close();
+
+  bool is_open() const {
+    return fp_ != NULL;
+  }
+
+  // Moves the features of those of the given samples that are not already
+  // stored into the store. NULL samples are skipped. On error, returns false
+  // and leaves the samples as they were.
+  bool Store(const GenericVector<TrainingSample*>& samples);
+
+ private:
+  // A mapped region of the file.
+  struct Segment {
+    void* data;
+    inT64 size;
+  };
+
+  STRING filename_;
+  FILE* fp_;
+  // Size of the file so far. Always a multiple of the page size, as segments
+  // are mapped from page-aligned offsets.
+  inT64 size_;
+  GenericVector<Segment> segments_;
+};
+
+}  // namespace tesseract
+
+#endif  // TESSERACT_CLASSIFY_SAMPLEFEATURESTORE_H_
@@ -105,6 +105,14 @@ bool Shape::DeSerialize(bool swap, FILE* fp) {
   return true;
 }
 
+// Returns the number of bytes of heap used by the shape.
+int Shape::MemoryUsed() const {
+  int bytes = unichars_.size_reserved() * sizeof(UnicharAndFonts);
+  for (int c = 0; c < unichars_.size(); ++c)
+    bytes += unichars_[c].font_ids.size_reserved() * sizeof(inT32);
+  return bytes;
+}
+
 // Adds a font_id for the given unichar_id. If the unichar_id is not
 // in the shape, it is added.
 void Shape::AddToShape(int unichar_id, int font_id) {
@@ -259,6 +267,14 @@ bool ShapeTable::DeSerialize(bool swap, FILE* fp) {
   return true;
 }
 
+// Returns the number of bytes of heap used by the table and its shapes.
+int ShapeTable::MemoryUsed() const {
+  int bytes = shape_table_.size_reserved() * sizeof(Shape*);
+  for (int s = 0; s < shape_table_.size(); ++s)
+    bytes += sizeof(Shape) + shape_table_[s]->MemoryUsed();
+  return bytes;
+}
+
 // Returns the number of fonts used in this ShapeTable, computing it if
 // necessary.
 int ShapeTable::NumFonts() const {
@@ -192,6 +192,8 @@ class Shape {
   // Reads from the given file. Returns false in case of error.
   // If swap is true, assumes a big/little-endian swap is needed.
   bool DeSerialize(bool swap, FILE* fp);
+  // Returns the number of bytes of heap used by the shape.
+  int MemoryUsed() const;
 
   int destination_index() const {
     return destination_index_;
@@ -273,6 +275,8 @@ class TESS_API ShapeTable {
   // Reads from the given file. Returns false in case of error.
   // If swap is true, assumes a big/little-endian swap is needed.
   bool DeSerialize(bool swap, FILE* fp);
+  // Returns the number of bytes of heap used by the table and its shapes.
+  int MemoryUsed() const;
 
   // Accessors.
   int NumShapes() const {
@@ -0,0 +1,37 @@
+///////////////////////////////////////////////////////////////////////
+// File:        tessmodel.cpp
+// Description: Immutable classifier data shared between Tesseract
+//              instances that use the same traineddata file.
+//
+// (C) Copyright 2016, Google Inc.
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////
+
+#include "tessmodel.h"
+
+#include "normmatch.h"
+#include "shapetable.h"
+
+namespace tesseract {
+
+TessModel::TessModel()
+  : int_templates(NULL), shape_table(NULL), norm_protos(NULL),
+    font_tables_offset(0) {
+}
+
+TessModel::~TessModel() {
+  if (int_templates != NULL) free_int_templates(int_templates);
+  delete shape_table;
+  if (norm_protos != NULL) free_norm_protos(norm_protos);
+}
+
+}  // namespace tesseract
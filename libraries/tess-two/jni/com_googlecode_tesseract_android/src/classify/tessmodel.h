@@ -0,0 +1,86 @@
+///////////////////////////////////////////////////////////////////////
+// File:        tessmodel.h
+// Description: Immutable classifier data shared between Tesseract
+//              instances that use the same traineddata file.
+//
+// (C) Copyright 2016, Google Inc.
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////
+
+#ifndef TESSERACT_CLASSIFY_TESSMODEL_H_
+#define TESSERACT_CLASSIFY_TESSMODEL_H_
+
+#include "host.h"
+#include "intproto.h"
+#include "object_cache.h"
+#include "strngs.h"
+#include "tesscallback.h"
+#include "unicharset.h"
+
+struct NORM_PROTOS;
+
+namespace tesseract {
+
+class ShapeTable;
+
+// The parts of a loaded language that never change after loading and are
+// the bulk of its memory: the static integer templates, the shape table and
+// the normalization protos. A TessModel is shared, read-only, by every
+// Classify that loads the same traineddata file, so N TessBaseAPI instances
+// on one language cost one copy of these. Everything an instance may modify
+// (adapted templates, font tables, cutoffs, the unicharset) stays in the
+// Classify. The dawgs are shared separately through the DawgCache.
+class TessModel {
+ public:
+  TessModel();
+  ~TessModel();
+
+  INT_TEMPLATES int_templates;
+  // May be NULL for old traineddata without a shape table.
+  ShapeTable* shape_table;
+  NORM_PROTOS* norm_protos;
+  // Offset of the font tables from the start of the inttemp component, so
+  // that other instances can read their own copy of just the tables.
+  inT64 font_tables_offset;
+  // Private copy of the unicharset for shape_table to refer to, so the model
+  // does not depend on the lifetime of the Classify that loaded it.
+  UNICHARSET unicharset;
+};
+
+// Reference counted global cache of TessModels keyed by traineddata file.
+class TessModelCache {
+ public:
+  // Returns the model for data_file_name, loading it with loader if it is not
+  // already cached. Deletes loader. Every successful Get must be matched by
+  // a FreeModel.
+  TessModel* GetModel(const STRING& data_file_name,
+                      TessResultCallback<TessModel*>* loader) {
+    return models_.Get(data_file_name, loader);
+  }
+
+  // Decrements the count of model. Returns false if the model is unknown.
+  bool FreeModel(TessModel* model) {
+    return models_.Free(model);
+  }
+
+  // Frees all currently unused models.
+  void DeleteUnusedModels() {
+    models_.DeleteUnusedObjects();
+  }
+
+ private:
+  ObjectCache<TessModel> models_;
+};
+
+}  // namespace tesseract
+
+#endif  // TESSERACT_CLASSIFY_TESSMODEL_H_
@@ -43,8 +43,18 @@ const double TrainingSample::kScaleValues[kSampleScaleSize] = {
 };
 
 TrainingSample::~TrainingSample() {
-  delete [] features_;
-  delete [] micro_features_;
+  FreeFeatures();
+}
+
+// Deletes the features_ and micro_features_, unless they are stored.
+void TrainingSample::FreeFeatures() {
+  if (!features_are_stored_) {
+    delete [] features_;
+    delete [] micro_features_;
+  }
+  features_ = NULL;
+  micro_features_ = NULL;
+  features_are_stored_ = false;
 }
 
 // WARNING! Serialize/DeSerialize do not save/restore the "cache" data
@@ -102,12 +112,11 @@ bool TrainingSample::DeSerialize(bool swap, FILE* fp) {
     ReverseN(&num_micro_features_, sizeof(num_micro_features_));
     ReverseN(&outline_length_, sizeof(outline_length_));
   }
-  delete [] features_;
+  FreeFeatures();
   features_ = new INT_FEATURE_STRUCT[num_features_];
   if (static_cast<int>(fread(features_, sizeof(*features_), num_features_, fp))
       != num_features_)
     return false;
-  delete [] micro_features_;
   micro_features_ = new MicroFeature[num_micro_features_];
   if (static_cast<int>(fread(micro_features_, sizeof(*micro_features_),
                              num_micro_features_,
@@ -209,7 +218,7 @@ void TrainingSample::ExtractCharDesc(int int_feature_type,
                                      int geo_type,
                                      CHAR_DESC_STRUCT* char_desc) {
   // Extract the INT features.
-  delete[] features_;
+  FreeFeatures();
   FEATURE_SET_STRUCT* char_features = char_desc->FeatureSets[int_feature_type];
   if (char_features == NULL) {
     tprintf("Error: no features to train on of type %s\n",
@@ -230,7 +239,6 @@ void TrainingSample::ExtractCharDesc(int int_feature_type,
     }
   }
   // Extract the Micro features.
-  delete[] micro_features_;
   char_features = char_desc->FeatureSets[micro_type];
   if (char_features == NULL) {
     tprintf("Error: no features to train on of type %s\n",
@@ -293,6 +301,16 @@ void TrainingSample::MapFeatures(const IntFeatureMap& feature_map) {
   features_are_mapped_ = true;
 }
 
+// Replaces the features_ and micro_features_ with the given copies of them,
+// which are owned by a SampleFeatureStore that must outlive this.
+void TrainingSample::UseStoredFeatures(const INT_FEATURE_STRUCT* features,
+                                       const MicroFeature* micro_features) {
+  FreeFeatures();
+  features_ = const_cast<INT_FEATURE_STRUCT*>(features);
+  micro_features_ = const_cast<MicroFeature*>(micro_features);
+  features_are_stored_ = true;
+}
+
 // Returns a pix representing the sample. (Int features only.)
 Pix* TrainingSample::RenderToPix(const UNICHARSET* unicharset) const {
   Pix* pix = pixCreate(kIntFeatureExtent, kIntFeatureExtent, 1);
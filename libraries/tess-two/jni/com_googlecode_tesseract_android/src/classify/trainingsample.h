@@ -58,7 +58,7 @@ class TrainingSample : public ELIST_LINK {
       features_(NULL), micro_features_(NULL), weight_(1.0),
       max_dist_(0.0), sample_index_(0),
       features_are_indexed_(false), features_are_mapped_(false),
-      is_error_(false) {
+      is_error_(false), features_are_stored_(false) {
   }
   ~TrainingSample();
 
@@ -101,6 +101,11 @@ class TrainingSample : public ELIST_LINK {
   // feature_map.
   void MapFeatures(const IntFeatureMap& feature_map);
 
+  // Replaces the features_ and micro_features_ with the given copies of them,
+  // which are owned by a SampleFeatureStore that must outlive this.
+  void UseStoredFeatures(const INT_FEATURE_STRUCT* features,
+                         const MicroFeature* micro_features);
+
   // Returns a pix representing the sample. (Int features only.)
   Pix* RenderToPix(const UNICHARSET* unicharset) const;
   // Displays the features in the given window with the given color.
@@ -179,6 +184,9 @@ class TrainingSample : public ELIST_LINK {
   bool features_are_mapped() const {
     return features_are_mapped_;
   }
+  bool features_are_stored() const {
+    return features_are_stored_;
+  }
   const GenericVector<int>& mapped_features() const {
     ASSERT_HOST(features_are_mapped_);
     return mapped_features_;
@@ -195,6 +203,9 @@ class TrainingSample : public ELIST_LINK {
   }
 
  private:
+  // Deletes the features_ and micro_features_, unless they are stored.
+  void FreeFeatures();
+
   // Unichar id that this sample represents. There obviously must be a
   // reference UNICHARSET somewhere. Usually in TrainingSampleSet.
   UNICHAR_ID class_id_;
@@ -237,6 +248,9 @@ class TrainingSample : public ELIST_LINK {
   bool features_are_mapped_;
   // True if the last classification was an error by the current definition.
   bool is_error_;
+  // True if features_ and micro_features_ belong to a SampleFeatureStore.
+  // They are never written while stored.
+  bool features_are_stored_;
 
   // Randomizing factors.
   static const int kYShiftValues[kSampleYShiftSize];
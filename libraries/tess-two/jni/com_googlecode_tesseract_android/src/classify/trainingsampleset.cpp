@@ -149,6 +149,23 @@ void TrainingSampleSet::AddSample(int unichar_id, TrainingSample* sample) {
   unicharset_size_ = unicharset_.size();
 }
 
+// Keeps the features of the samples in the given scratch file from now on,
+// instead of in memory. Samples already in the set are moved there at once,
+// and samples added later by StoreNewFeatures. Returns false if the store
+// cannot be created, in which case all features stay in memory.
+bool TrainingSampleSet::OpenFeatureStore(const char* filename) {
+  if (!feature_store_.Open(filename)) return false;
+  StoreNewFeatures();
+  return true;
+}
+
+// Moves the features of the samples added since the last call into the
+// feature store, if there is one.
+void TrainingSampleSet::StoreNewFeatures() {
+  if (feature_store_.is_open())
+    feature_store_.Store(samples_);
+}
+
 // Returns the number of samples for the given font,class pair.
 // If randomize is true, returns the number of samples accessible
 // with randomizing on. (Increases the number of samples if small.)
@@ -293,6 +310,10 @@ float TrainingSampleSet::UnicharDistance(const UnicharAndFonts& uf1,
 // Returns the distance between the given pair of font/class pairs.
 // Finds in cache or computes and caches.
 // OrganizeByFontAndClass must have been already called.
+// Safe to call from multiple threads at once, as long as nothing else is
+// modifying the samples. The distance itself is computed outside the lock,
+// so two threads may occasionally compute the same distance, which is
+// harmless, as they get the same answer.
 float TrainingSampleSet::ClusterDistance(int font_id1, int class_id1,
                                          int font_id2, int class_id2,
                                          const IntFeatureMap& feature_map) {
@@ -301,66 +322,82 @@ float TrainingSampleSet::ClusterDistance(int font_id1, int class_id1,
   int font_index2 = font_id_map_.SparseToCompact(font_id2);
   if (font_index1 < 0 || font_index2 < 0)
     return 0.0f;
-  FontClassInfo& fc_info = (*font_class_array_)(font_index1, class_id1);
+  float result;
+  cache_mutex_.Lock();
+  bool cached = LookupClusterDistance(font_id1, class_id1, font_id2, class_id2,
+                                      &result);
+  cache_mutex_.Unlock();
+  if (cached) return result;
+  // Distance has to be calculated.
+  result = ComputeClusterDistance(font_id1, class_id1, font_id2, class_id2,
+                                  feature_map);
+  cache_mutex_.Lock();
+  CacheClusterDistance(font_id1, class_id1, font_id2, class_id2, result);
+  // Copy to the symmetric cache entry.
+  CacheClusterDistance(font_id2, class_id2, font_id1, class_id1, result);
+  cache_mutex_.Unlock();
+  return result;
+}
+
+// Finds the distance between the given pair of font/class pairs in the
+// cache, returning false if it has not been computed yet.
+// The caller must hold cache_mutex_.
+bool TrainingSampleSet::LookupClusterDistance(int font_id1, int class_id1,
+                                              int font_id2, int class_id2,
+                                              float* distance) const {
+  int font_index1 = font_id_map_.SparseToCompact(font_id1);
+  int font_index2 = font_id_map_.SparseToCompact(font_id2);
+  const FontClassInfo& fc_info = (*font_class_array_)(font_index1, class_id1);
   if (font_id1 == font_id2) {
     // Special case cache for speed.
+    if (fc_info.unichar_distance_cache.size() == 0) return false;
+    *distance = fc_info.unichar_distance_cache[class_id2];
+    return *distance >= 0.0f;
+  } else if (class_id1 == class_id2) {
+    // Another special-case cache for equal class-id.
+    if (fc_info.font_distance_cache.size() == 0) return false;
+    *distance = fc_info.font_distance_cache[font_index2];
+    return *distance >= 0.0f;
+  }
+  // Both font and class are different. Linear search for class_id2/font_id2
+  // in what is a hopefully short list of distances.
+  for (int i = 0; i < fc_info.distance_cache.size(); ++i) {
+    if (fc_info.distance_cache[i].unichar_id == class_id2 &&
+        fc_info.distance_cache[i].font_id == font_id2) {
+      *distance = fc_info.distance_cache[i].distance;
+      return true;
+    }
+  }
+  return false;
+}
+
+// Stores the distance between the given pair of font/class pairs in the
+// cache of font/class 1 only. Does nothing if it is already there.
+// The caller must hold cache_mutex_.
+void TrainingSampleSet::CacheClusterDistance(int font_id1, int class_id1,
+                                             int font_id2, int class_id2,
+                                             float distance) {
+  int font_index1 = font_id_map_.SparseToCompact(font_id1);
+  int font_index2 = font_id_map_.SparseToCompact(font_id2);
+  FontClassInfo& fc_info = (*font_class_array_)(font_index1, class_id1);
+  if (font_id1 == font_id2) {
     if (fc_info.unichar_distance_cache.size() == 0)
       fc_info.unichar_distance_cache.init_to_size(unicharset_size_, -1.0f);
-    if (fc_info.unichar_distance_cache[class_id2] < 0) {
-      // Distance has to be calculated.
-      float result = ComputeClusterDistance(font_id1, class_id1,
-                                            font_id2, class_id2,
-                                            feature_map);
-      fc_info.unichar_distance_cache[class_id2] = result;
-      // Copy to the symmetric cache entry.
-      FontClassInfo& fc_info2 = (*font_class_array_)(font_index2, class_id2);
-      if (fc_info2.unichar_distance_cache.size() == 0)
-        fc_info2.unichar_distance_cache.init_to_size(unicharset_size_, -1.0f);
-      fc_info2.unichar_distance_cache[class_id1] = result;
-    }
-    return fc_info.unichar_distance_cache[class_id2];
+    fc_info.unichar_distance_cache[class_id2] = distance;
   } else if (class_id1 == class_id2) {
-    // Another special-case cache for equal class-id.
     if (fc_info.font_distance_cache.size() == 0)
       fc_info.font_distance_cache.init_to_size(font_id_map_.CompactSize(),
                                                -1.0f);
-    if (fc_info.font_distance_cache[font_index2] < 0) {
-      // Distance has to be calculated.
-      float result = ComputeClusterDistance(font_id1, class_id1,
-                                            font_id2, class_id2,
-                                            feature_map);
-      fc_info.font_distance_cache[font_index2] = result;
-      // Copy to the symmetric cache entry.
-      FontClassInfo& fc_info2 = (*font_class_array_)(font_index2, class_id2);
-      if (fc_info2.font_distance_cache.size() == 0)
-        fc_info2.font_distance_cache.init_to_size(font_id_map_.CompactSize(),
-                                                  -1.0f);
-      fc_info2.font_distance_cache[font_index1] = result;
-    }
-    return fc_info.font_distance_cache[font_index2];
-  }
-  // Both font and class are different. Linear search for class_id2/font_id2
-  // in what is a hopefully short list of distances.
-  int cache_index = 0;
-  while (cache_index < fc_info.distance_cache.size() &&
-         (fc_info.distance_cache[cache_index].unichar_id != class_id2 ||
-          fc_info.distance_cache[cache_index].font_id != font_id2))
-    ++cache_index;
-  if (cache_index == fc_info.distance_cache.size()) {
-    // Distance has to be calculated.
-    float result = ComputeClusterDistance(font_id1, class_id1,
-                                          font_id2, class_id2,
-                                          feature_map);
-    FontClassDistance fc_dist = { class_id2, font_id2, result };
+    fc_info.font_distance_cache[font_index2] = distance;
+  } else {
+    float cached_distance;
+    // Another thread may have beaten us to it.
+    if (LookupClusterDistance(font_id1, class_id1, font_id2, class_id2,
+                              &cached_distance))
+      return;
+    FontClassDistance fc_dist = { class_id2, font_id2, distance };
     fc_info.distance_cache.push_back(fc_dist);
-    // Copy to the symmetric cache entry. We know it isn't there already, as
-    // we always copy to the symmetric entry.
-    FontClassInfo& fc_info2 = (*font_class_array_)(font_index2, class_id2);
-    fc_dist.unichar_id = class_id1;
-    fc_dist.font_id = font_id1;
-    fc_info2.distance_cache.push_back(fc_dist);
   }
-  return fc_info.distance_cache[cache_index].distance;
 }
 
 // Computes the distance between the given pair of font/class pairs.
@@ -781,6 +818,7 @@ void TrainingSampleSet::ReplicateAndRandomizeSamples() {
         }
       }
     }
+    StoreNewFeatures();
   }
 }
 
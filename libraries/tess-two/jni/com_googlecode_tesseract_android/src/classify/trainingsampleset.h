@@ -17,9 +17,11 @@
 #define TESSERACT_TRAINING_TRAININGSAMPLESET_H__
 
 #include "bitvector.h"
+#include "ccutil.h"
 #include "genericvector.h"
 #include "indexmapbidi.h"
 #include "matrix.h"
+#include "samplefeaturestore.h"
 #include "shapetable.h"
 #include "trainingsample.h"
 
@@ -82,6 +84,15 @@ class TrainingSampleSet {
   // which must correspond to the local unicharset (in this).
   void AddSample(int unichar_id, TrainingSample* sample);
 
+  // Keeps the features of the samples in the given scratch file from now on,
+  // instead of in memory. Samples already in the set are moved there at once,
+  // and samples added later by StoreNewFeatures. Returns false if the store
+  // cannot be created, in which case all features stay in memory.
+  bool OpenFeatureStore(const char* filename);
+  // Moves the features of the samples added since the last call into the
+  // feature store, if there is one.
+  void StoreNewFeatures();
+
   // Returns the number of samples for the given font,class pair.
   // If randomize is true, returns the number of samples accessible
   // with randomizing on. (Increases the number of samples if small.)
@@ -121,6 +132,7 @@ class TrainingSampleSet {
   // Returns the distance between the given pair of font/class pairs.
   // Finds in cache or computes and caches.
   // OrganizeByFontAndClass must have been already called.
+  // May be called from multiple threads at once.
   float ClusterDistance(int font_id1, int class_id1,
                         int font_id2, int class_id2,
                         const IntFeatureMap& feature_map);
@@ -225,6 +237,18 @@ class TrainingSampleSet {
                                  ScrollView* window) const;
 
  private:
+  // Finds the distance between the given pair of font/class pairs in the
+  // cache, returning false if it has not been computed yet.
+  // The caller must hold cache_mutex_.
+  bool LookupClusterDistance(int font_id1, int class_id1,
+                             int font_id2, int class_id2,
+                             float* distance) const;
+  // Stores the distance between the given pair of font/class pairs in the
+  // cache of font/class 1 only. Does nothing if it is already there.
+  // The caller must hold cache_mutex_.
+  void CacheClusterDistance(int font_id1, int class_id1,
+                            int font_id2, int class_id2, float distance);
+
   // Struct to store a triplet of unichar, font, distance in the distance cache.
   struct FontClassDistance {
     int unichar_id;
@@ -267,6 +291,9 @@ class TrainingSampleSet {
     GenericVector<FontClassDistance> distance_cache;
   };
 
+  // Optional disk store for the features of the samples_. Declared first,
+  // so it is destroyed after them.
+  SampleFeatureStore feature_store_;
   PointerVector<TrainingSample> samples_;
   // Number of samples before replication/randomization.
   int num_raw_samples_;
@@ -281,6 +308,9 @@ class TrainingSampleSet {
   // A 2-d array of FontClassInfo holding information related to each
   // (font_id, class_id) pair.
   GENERIC_2D_ARRAY<FontClassInfo>* font_class_array_;
+  // Guards the distance caches in font_class_array_, so that ClusterDistance
+  // can be called from multiple threads.
+  CCUtilMutex cache_mutex_;
 
   // Reference to the fontinfo_table_ in MasterTrainer. Provides names
   // for font_ids in the samples. Not serialized!
@@ -21,6 +21,7 @@
 
 #include "beam_search.h"
 #include "tesseractclass.h"
+#include "threadpool.h"
 
 namespace tesseract {
 
@@ -30,6 +31,8 @@ BeamSearch::BeamSearch(CubeRecoContext *cntxt, bool word_mode) {
   col_cnt_ = 1;
   col_ = NULL;
   word_mode_ = word_mode;
+  job_cnt_ = 0;
+  edge_arena_ = NULL;
 }
 
 // Cleanup the lattice corresponding to the last search
@@ -41,28 +44,46 @@ void BeamSearch::Cleanup() {
     delete []col_;
   }
   col_ = NULL;
+  // The edges of the lattice are gone, so their memory can go too.
+  delete edge_arena_;
+  edge_arena_ = NULL;
 }
 
 BeamSearch::~BeamSearch() {
   Cleanup();
 }
 
-// Creates a set of children nodes emerging from a parent node based on
-// the character alternate list and the language model.
-void BeamSearch::CreateChildren(SearchColumn *out_col, LangModel *lang_mod,
-                                SearchNode *parent_node,
+void BeamSearch::AddChildrenJob(SearchNode *parent_node,
                                 LangModEdge *lm_parent_edge,
                                 CharAltList *char_alt_list, int extra_cost) {
+  if (job_cnt_ == static_cast<int>(jobs_.size())) {
+    jobs_.resize(job_cnt_ + 1);
+  }
+  ChildrenJob &job = jobs_[job_cnt_++];
+  job.parent_node = parent_node;
+  job.lm_parent_edge = lm_parent_edge;
+  job.char_alt_list = char_alt_list;
+  job.extra_cost = extra_cost;
+  job.edges.clear();
+  job.costs.clear();
+}
+
+// Creates a set of children nodes emerging from a parent node based on
+// the character alternate list and the language model.
+void BeamSearch::CreateChildren(LangModel *lang_mod, int col_idx,
+                                int job_idx) {
+  ChildrenJob &job = jobs_[job_idx];
+  CharAltList *char_alt_list = job.char_alt_list;
   // get all the edges from this parent
   int edge_cnt;
   LangModEdge **lm_edges = lang_mod->GetEdges(char_alt_list,
-                                              lm_parent_edge, &edge_cnt);
+                                              job.lm_parent_edge, &edge_cnt);
   if (lm_edges) {
-    // add them to the ending column with the appropriate parent
+    // keep them for the ending column with the appropriate parent
     for (int edge = 0; edge < edge_cnt; edge++) {
       // add a node to the column if the current column is not the
       // last one, or if the lang model edge indicates it is valid EOW
-      if (!cntxt_->NoisyInput() && out_col->ColIdx() >= seg_pt_cnt_ &&
+      if (!cntxt_->NoisyInput() && col_idx >= seg_pt_cnt_ &&
           !lm_edges[edge]->IsEOW()) {
         // free edge since no object is going to own it
         delete lm_edges[edge];
@@ -75,14 +96,14 @@ void BeamSearch::CreateChildren(SearchColumn *out_col, LangModel *lang_mod,
         recognition_cost = MAX(0, char_alt_list->ClassCost(
             lm_edges[edge]->ClassID()));
         // Add the no space cost. This should zero in word mode
-        recognition_cost += extra_cost;
+        recognition_cost += job.extra_cost;
       }
 
-      // Note that the edge will be freed inside the column if
-      // AddNode is called
+      // Note that the edge will be freed inside the column when it is
+      // added
       if (recognition_cost >= 0) {
-        out_col->AddNode(lm_edges[edge], recognition_cost, parent_node,
-                         cntxt_);
+        job.edges.push_back(lm_edges[edge]);
+        job.costs.push_back(recognition_cost);
       } else {
         delete lm_edges[edge];
       }
@@ -106,6 +127,8 @@ WordAltList * BeamSearch::Search(SearchObject *srch_obj, LangModel *lang_mod) {
 
   // free existing state
   Cleanup();
+  edge_arena_ = new PageArena(NULL);
+  PageArena::Scope arena_scope(edge_arena_);
 
   // get seg pt count
   seg_pt_cnt_ = srch_obj->SegPtCnt();
@@ -125,6 +148,11 @@ WordAltList * BeamSearch::Search(SearchObject *srch_obj, LangModel *lang_mod) {
   col_ = new SearchColumn *[col_cnt_];
   memset(col_, 0, col_cnt_ * sizeof(*col_));
 
+  // the parents of a column are expanded on the recognition thread pool
+  Tesseract *tess_obj = cntxt_->TesseractObject();
+  ThreadPool *thread_pool =
+      tess_obj != NULL ? tess_obj->RecognitionThreadPool() : NULL;
+
   // for all possible segments
   for (int end_seg = 1; end_seg <= (seg_pt_cnt_ + 1); end_seg++) {
     // create a search column
@@ -133,6 +161,9 @@ WordAltList * BeamSearch::Search(SearchObject *srch_obj, LangModel *lang_mod) {
 
     // for all possible start segments
     int init_seg = MAX(0, end_seg - cntxt_->Params()->MaxSegPerChar());
+    // recognize the segments ending here together
+    srch_obj->RecognizeSegments(init_seg - 1, end_seg - 1);
+    job_cnt_ = 0;
     for (int strt_seg = init_seg; strt_seg < end_seg; strt_seg++) {
       int parent_nodes_cnt;
       SearchNode **parent_nodes;
@@ -171,8 +202,7 @@ WordAltList * BeamSearch::Search(SearchObject *srch_obj, LangModel *lang_mod) {
         // if the no space cost is low enough
         if ((contig_cost + no_space_cost) < MIN_PROB_COST) {
           // Add the children nodes
-          CreateChildren(col_[end_seg - 1], lang_mod, parent_node,
-                         lm_parent_edge, char_alt_list,
+          AddChildrenJob(parent_node, lm_parent_edge, char_alt_list,
                          contig_cost + no_space_cost);
         }
 
@@ -186,14 +216,35 @@ WordAltList * BeamSearch::Search(SearchObject *srch_obj, LangModel *lang_mod) {
             if ((contig_cost + space_cost) < MIN_PROB_COST) {
               // Restart the language model and add nodes as children to the
               // space node.
-              CreateChildren(col_[end_seg - 1], lang_mod, parent_node, NULL,
-                             char_alt_list, contig_cost + space_cost);
+              AddChildrenJob(parent_node, NULL, char_alt_list,
+                             contig_cost + space_cost);
             }
           }
         }
       }  // parent
     }  // strt_seg
 
+    // Make the children of all the parents, then add them to the column in
+    // order. The first column has the root as its only parent, so any lazy
+    // initialization of the language model is done before going parallel.
+    TessCallback1<int> *create_children = NewPermanentTessCallback(
+        this, &BeamSearch::CreateChildren, lang_mod, end_seg - 1);
+    if (thread_pool != NULL && job_cnt_ > 1) {
+      thread_pool->ParallelFor(job_cnt_, create_children);
+    } else {
+      for (int job_idx = 0; job_idx < job_cnt_; job_idx++) {
+        create_children->Run(job_idx);
+      }
+    }
+    delete create_children;
+    for (int job_idx = 0; job_idx < job_cnt_; job_idx++) {
+      const ChildrenJob &job = jobs_[job_idx];
+      for (size_t child = 0; child < job.edges.size(); child++) {
+        col_[end_seg - 1]->AddNode(job.edges[child], job.costs[child],
+                                   job.parent_node, cntxt_);
+      }
+    }
+
     // prune the column nodes
     col_[end_seg - 1]->Prune();
 
@@ -31,6 +31,8 @@
 #ifndef BEAM_SEARCH_H
 #define BEAM_SEARCH_H
 
+#include <vector>
+
 #include "search_column.h"
 #include "word_altlist.h"
 #include "search_object.h"
@@ -38,6 +40,7 @@
 #include "cube_utils.h"
 #include "cube_reco_context.h"
 #include "allheaders.h"
+#include "pagearena.h"
 
 namespace tesseract {
 
@@ -99,6 +102,27 @@ class BeamSearch {
   bool word_mode_;
   // Node index of best-cost node, before alternates are merged and sorted
   int best_presorted_node_idx_;
+  // A parent node to make the children of in the column being expanded,
+  // with the character alternates and extra cost to make them with, and
+  // the children made: their language model edges and recognition costs.
+  // The jobs of a column are independent, so they may run in parallel,
+  // each into its own buffers, which are then added to the column in job
+  // order, as the serial search would add them.
+  struct ChildrenJob {
+    SearchNode *parent_node;
+    LangModEdge *lm_parent_edge;
+    CharAltList *char_alt_list;
+    int extra_cost;
+    vector<LangModEdge *> edges;
+    vector<int> costs;
+  };
+  // Jobs of the column being expanded. Kept between columns to reuse the
+  // buffers of the jobs.
+  vector<ChildrenJob> jobs_;
+  int job_cnt_;
+  // Holds the language model edges made on the searching thread during the
+  // last search, which are all freed at once with its lattice.
+  PageArena *edge_arena_;
   // Cleans up beam search state
   void Cleanup();
   // Creates a Word alternate list from the results in the lattice.
@@ -109,11 +133,13 @@ class BeamSearch {
   // CubeTuningParams, which are learned together with the character
   // classifiers.
   WordAltList *CreateWordAltList(SearchObject *srch_obj);
-  // Creates a set of children nodes emerging from a parent node based on
-  // the character alternate list and the language model.
-  void CreateChildren(SearchColumn *out_col, LangModel *lang_mod,
-                      SearchNode *parent_node, LangModEdge *lm_parent_edge,
+  // Queues a ChildrenJob for the column being expanded.
+  void AddChildrenJob(SearchNode *parent_node, LangModEdge *lm_parent_edge,
                       CharAltList *char_alt_list, int extra_cost);
+  // Creates the children of the given job, emerging from its parent node
+  // based on the character alternate list and the language model, into the
+  // job's buffers. Only reads shared state, so jobs may run in parallel.
+  void CreateChildren(LangModel *lang_mod, int col_idx, int job_idx);
   // Backtracks from the given lattice node and returns the corresponding
   // char mapped segments, character count, and character bounding boxes (if
   // char_boxes is not NULL). If the segments cannot be constructed,
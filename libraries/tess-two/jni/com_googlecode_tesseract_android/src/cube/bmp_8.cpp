@@ -36,21 +36,28 @@ const int Bmp8::kDeslantAngleCount = (1 + static_cast<int>(0.5f +
 float *Bmp8::tan_table_ = NULL;
 
 Bmp8::Bmp8(unsigned short wid, unsigned short hgt)
-    : wid_(wid)
-    , hgt_(hgt) {
-  line_buff_ = CreateBmpBuffer();
+    : bmp_buff_(NULL)
+    , scale_buff_(NULL)
+    , scale_buff_size_(0)
+    , wid_(wid)
+    , hgt_(hgt)
+    , line_buff_(NULL) {
+  SetBmpBuffer(CreateBmpBuffer());
 }
 
 Bmp8::~Bmp8() {
-  FreeBmpBuffer(line_buff_);
+  SetBmpBuffer(NULL);
+  delete []scale_buff_;
 }
 
-// free buffer
-void Bmp8::FreeBmpBuffer(unsigned char **buff) {
-  if (buff != NULL) {
-    delete []buff[0];
-    delete []buff;
+// free the current buffer and take ownership of the specified one
+void Bmp8::SetBmpBuffer(unsigned char **buff) {
+  if (line_buff_ != NULL) {
+    delete []bmp_buff_;
+    delete []line_buff_;
   }
+  line_buff_ = buff;
+  bmp_buff_ = (buff == NULL ? NULL : buff[0]);
 }
 
 void Bmp8::FreeBmpBuffer(unsigned int **buff) {
@@ -112,7 +119,14 @@ bool Bmp8::Clear() {
     return false;
   }
 
-  memset(line_buff_[0], 0xff, stride_ * hgt_ * sizeof(*line_buff_[0]));
+  if (line_buff_[0] == bmp_buff_) {
+    memset(line_buff_[0], 0xff, stride_ * hgt_ * sizeof(*line_buff_[0]));
+  } else {
+    // a trimmed bitmap: its rows are not contiguous
+    for (int y = 0; y < hgt_; y++) {
+      memset(line_buff_[y], 0xff, wid_ * sizeof(*line_buff_[y]));
+    }
+  }
   return true;
 }
 
@@ -168,7 +182,7 @@ bool Bmp8::LoadFromCharDumpFile(CachedFile *fp) {
   wid_ = wid;
   hgt_ = hgt;
 
-  line_buff_ = CreateBmpBuffer();
+  SetBmpBuffer(CreateBmpBuffer());
   if (line_buff_ == NULL) {
     delete []buff;
     return false;
@@ -257,7 +271,7 @@ bool Bmp8::LoadFromCharDumpFile(FILE *fp) {
   wid_ = wid;
   hgt_ = hgt;
 
-  line_buff_ = CreateBmpBuffer();
+  SetBmpBuffer(CreateBmpBuffer());
   if (line_buff_ == NULL) {
     delete []buff;
     return false;
@@ -358,6 +372,16 @@ void Bmp8::Crop(int *xst, int *yst, int *wid, int *hgt) {
   (*hgt) = yend - (*yst) + 1;
 }
 
+// restrict the bitmap to a sub-rectangle of itself by moving its row
+// pointers, leaving the pixels where they are
+void Bmp8::Trim(int x, int y, int wid, int hgt) {
+  for (int row = 0; row < hgt; row++) {
+    line_buff_[row] = line_buff_[y + row] + x;
+  }
+  wid_ = wid;
+  hgt_ = hgt;
+}
+
 // generates a scaled bitmap with dimensions the new bmp will have the
 // same aspect ratio and will be centered in the box
 bool Bmp8::ScaleFrom(Bmp8 *bmp, bool isotropic) {
@@ -428,8 +452,15 @@ bool Bmp8::ScaleFrom(Bmp8 *bmp, bool isotropic) {
     // or scale down
     // scaling down is a bit tricky: we'll accumulate pixels
     // and then compute the means
-    unsigned int **dest_line_buff = CreateBmpBuffer(wid_, hgt_, 0),
-      **dest_pix_cnt =  CreateBmpBuffer(wid_, hgt_, 0);
+    int pix_cnt = wid_ * hgt_;
+    if (scale_buff_size_ < pix_cnt) {
+      delete []scale_buff_;
+      scale_buff_ = new unsigned int[2 * pix_cnt];
+      scale_buff_size_ = pix_cnt;
+    }
+    unsigned int *dest_sum = scale_buff_;
+    unsigned int *dest_pix_cnt = scale_buff_ + pix_cnt;
+    memset(scale_buff_, 0, 2 * pix_cnt * sizeof(*scale_buff_));
 
     for (ysrc = 0; ysrc < hgt_src; ysrc++) {
       // compute scaled y
@@ -445,27 +476,23 @@ bool Bmp8::ScaleFrom(Bmp8 *bmp, bool isotropic) {
           continue;
         }
 
-        dest_line_buff[ydest][xdest] +=
+        dest_sum[ydest * wid_ + xdest] +=
             bmp->line_buff_[ysrc + yst_src][xsrc + xst_src];
-        dest_pix_cnt[ydest][xdest]++;
+        dest_pix_cnt[ydest * wid_ + xdest]++;
       }
     }
 
     for (ydest = 0; ydest < hgt_; ydest++) {
       for (xdest = 0; xdest < wid_; xdest++) {
-        if (dest_pix_cnt[ydest][xdest] > 0) {
-          unsigned int pixval =
-              dest_line_buff[ydest][xdest] / dest_pix_cnt[ydest][xdest];
+        int dest_idx = ydest * wid_ + xdest;
+        if (dest_pix_cnt[dest_idx] > 0) {
+          unsigned int pixval = dest_sum[dest_idx] / dest_pix_cnt[dest_idx];
 
           line_buff_[ydest][xdest] =
               (unsigned char) min((unsigned int)255, pixval);
         }
       }
     }
-
-    // we no longer need these temp buffers
-    FreeBmpBuffer(dest_line_buff);
-    FreeBmpBuffer(dest_pix_cnt);
   }
 
   return true;
@@ -853,8 +880,7 @@ bool Bmp8::Deslant() {
     }
 
     // free old buffer
-    FreeBmpBuffer(line_buff_);
-    line_buff_ = dest_lines;
+    SetBmpBuffer(dest_lines);
   }
   return true;
 }
@@ -897,7 +923,7 @@ bool Bmp8::LoadFromCharDumpFile(unsigned char **raw_data_ptr) {
   wid_ = wid;
   hgt_ = hgt;
 
-  line_buff_ = CreateBmpBuffer();
+  SetBmpBuffer(CreateBmpBuffer());
   if (line_buff_ == NULL) {
     return false;
   }
@@ -1037,8 +1063,7 @@ bool Bmp8::HorizontalDeslant(double *deslant_angle) {
     }
 
     // free old buffer
-    FreeBmpBuffer(line_buff_);
-    line_buff_ = dest_lines;
+    SetBmpBuffer(dest_lines);
 
     (*deslant_angle) = kMinDeslantAngle + (best_ang * kDeslantAngleDelta);
   }
@@ -52,7 +52,9 @@ class Bmp8 {
     return (line_buff_ == NULL ? NULL : line_buff_[0]);
   }
   // creates a scaled version of the specified bitmap
-  // Optionally, scaling can be isotropic (preserving aspect ratio) or not
+  // Optionally, scaling can be isotropic (preserving aspect ratio) or not.
+  // The bitmap is expected to be clear, so a bitmap reused as the target of
+  // repeated scalings must be cleared in between
   bool ScaleFrom(Bmp8 *bmp, bool isotropic = true);
   // Deslant the bitmap vertically
   bool Deslant();
@@ -80,8 +82,9 @@ class Bmp8 {
   static unsigned int ** CreateBmpBuffer(int wid, int hgt,
             unsigned char init_val = 0xff);
   // Free a bitmap buffer
-  static void FreeBmpBuffer(unsigned char **buff);
   static void FreeBmpBuffer(unsigned int **buff);
+  // Frees the bitmap contents and replaces them with the given buffer
+  void SetBmpBuffer(unsigned char **buff);
 
   // a static array that holds the tan lookup table
   static float *tan_table_;
@@ -89,6 +92,13 @@ class Bmp8 {
   unsigned short stride_;
   // Bmp8 magic number used to validate saved bitmaps
   static const unsigned int kMagicNumber = 0xdeadbeef;
+  // start of the pixel memory owned by the bitmap. After Trim, the rows in
+  // line_buff_ point inside it rather than at its start
+  unsigned char *bmp_buff_;
+  // accumulators of ScaleFrom when scaling down, kept to be reused by
+  // bitmaps that are scaled into repeatedly
+  unsigned int *scale_buff_;
+  int scale_buff_size_;
 
  protected:
   // bitmap dimensions
@@ -114,6 +124,9 @@ class Bmp8 {
   bool IsBlankRow(int y) const;
   // crop the bitmap returning new dimensions
   void Crop(int *xst_src, int *yst_src, int *wid, int *hgt);
+  // restricts the bitmap to the specified part of it without copying: the
+  // rows are pointed into the existing buffer, keeping its stride
+  void Trim(int x, int y, int wid, int hgt);
   // copy part of the specified bitmap
   void Copy(int x, int y, int wid, int hgt, Bmp8 *bmp_dest) const;
 };
@@ -20,57 +20,97 @@
 #include <algorithm>
 #include <math.h>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "char_bigrams.h"
 #include "cube_utils.h"
 #include "ndminx.h"
 #include "cube_const.h"
+#ifdef USE_STD_NAMESPACE
+using std::lower_bound;
+using std::make_pair;
+using std::pair;
+using std::stable_sort;
+#endif
 
 namespace tesseract {
 
+namespace {
+
+// Orders the (key, count) pairs of bigrams by key.
+bool BigramKeyLess(const pair<uinT64, int> &bigram1,
+                   const pair<uinT64, int> &bigram2) {
+  return bigram1.first < bigram2.first;
+}
+
+}  // namespace
+
 CharBigrams::CharBigrams() {
-  memset(&bigram_table_, 0, sizeof(bigram_table_));
+  bigram_cnt_ = 0;
+  worst_cost_ = 0;
+  keys_ = NULL;
+  costs_ = NULL;
+  mapped_data_ = NULL;
+  mapped_size_ = 0;
 }
 
 CharBigrams::~CharBigrams() {
-  if (bigram_table_.char_bigram != NULL) {
-    for (int ch1 = 0; ch1 <= bigram_table_.max_char; ch1++) {
-      CharBigram *char_bigram = bigram_table_.char_bigram + ch1;
-
-      if (char_bigram->bigram != NULL) {
-        delete []char_bigram->bigram;
-      }
-    }
-    delete []bigram_table_.char_bigram;
-  }
+  CubeUtils::UnmapFile(mapped_data_, mapped_size_);
 }
 
 CharBigrams *CharBigrams::Create(const string &data_file_path,
                                  const string &lang) {
   string file_name;
-  string str;
 
   file_name = data_file_path + lang;
   file_name += ".cube.bigrams";
 
+  // construct a new object
+  CharBigrams *char_bigrams_obj = new CharBigrams();
+
+  // a binary table is used in place
+  size_t mapped_size;
+  const char *mapped_data = CubeUtils::MapFile(file_name, &mapped_size);
+  if (mapped_data != NULL) {
+    if (char_bigrams_obj->LoadBinary(mapped_data, mapped_size)) {
+      char_bigrams_obj->mapped_data_ = mapped_data;
+      char_bigrams_obj->mapped_size_ = mapped_size;
+      return char_bigrams_obj;
+    }
+    CubeUtils::UnmapFile(mapped_data, mapped_size);
+  }
+
   // load the string into memory
+  string str;
   if (!CubeUtils::ReadFileToString(file_name, &str)) {
+    delete char_bigrams_obj;
     return NULL;
   }
+  // a binary table that could not be mapped is kept as read
+  char_bigrams_obj->data_buff_.swap(str);
+  const string &data = char_bigrams_obj->data_buff_;
+  if (char_bigrams_obj->LoadBinary(data.data(), data.length())) {
+    return char_bigrams_obj;
+  }
+  str.swap(char_bigrams_obj->data_buff_);
+  if (!char_bigrams_obj->LoadText(str)) {
+    delete char_bigrams_obj;
+    return NULL;
+  }
+  return char_bigrams_obj;
+}
 
-  // construct a new object
-  CharBigrams *char_bigrams_obj = new CharBigrams();
-  CharBigramTable *table = &char_bigrams_obj->bigram_table_;
-
-  table->total_cnt = 0;
-  table->max_char = -1;
-  table->char_bigram = NULL;
-
+// Parses the text form of the table: lines of a count followed by the two
+// characters of the bigram in hex
+bool CharBigrams::LoadText(const string &str) {
   // split into lines
   vector<string> str_vec;
   CubeUtils::SplitStringUsing(str, "\r\n", &str_vec);
 
+  int total_cnt = 0;
+  vector<pair<uinT64, int> > bigrams;
+  bigrams.reserve(str_vec.size());
   for (int big = 0; big < str_vec.size(); big++) {
     char_32 ch1;
     char_32 ch2;
@@ -78,83 +118,85 @@ CharBigrams *CharBigrams::Create(const string &data_file_path,
     if (sscanf(str_vec[big].c_str(), "%d %x %x", &cnt, &ch1, &ch2) != 3) {
       fprintf(stderr, "Cube ERROR (CharBigrams::Create): invalid format "
               "reading line: %s\n", str_vec[big].c_str());
-      delete char_bigrams_obj;
-      return NULL;
-    }
-
-    // expand the bigram table
-    if (ch1 > table->max_char) {
-      CharBigram *char_bigram = new CharBigram[ch1 + 1];
-
-      if (table->char_bigram != NULL && table->max_char >= 0) {
-        memcpy(char_bigram, table->char_bigram,
-          (table->max_char + 1) * sizeof(*char_bigram));
-
-        delete []table->char_bigram;
-      }
-      table->char_bigram = char_bigram;
-
-      // init
-      for (int new_big = table->max_char + 1; new_big <= ch1; new_big++) {
-        table->char_bigram[new_big].total_cnt = 0;
-        table->char_bigram[new_big].max_char = -1;
-        table->char_bigram[new_big].bigram = NULL;
-      }
-      table->max_char = ch1;
+      return false;
     }
-
-    if (ch2 > table->char_bigram[ch1].max_char) {
-      Bigram *bigram = new Bigram[ch2 + 1];
-
-      if (table->char_bigram[ch1].bigram != NULL &&
-          table->char_bigram[ch1].max_char >= 0) {
-        memcpy(bigram, table->char_bigram[ch1].bigram,
-          (table->char_bigram[ch1].max_char + 1) * sizeof(*bigram));
-        delete []table->char_bigram[ch1].bigram;
-      }
-      table->char_bigram[ch1].bigram = bigram;
-
-      // init
-      for (int new_big = table->char_bigram[ch1].max_char + 1;
-           new_big <= ch2; new_big++) {
-        table->char_bigram[ch1].bigram[new_big].cnt = 0;
-      }
-      table->char_bigram[ch1].max_char = ch2;
+    bigrams.push_back(make_pair(BigramKey(ch1, ch2), cnt));
+    total_cnt += cnt;
+  }
+  // a bigram listed more than once keeps its last count
+  stable_sort(bigrams.begin(), bigrams.end(), BigramKeyLess);
+  for (int big = 0; big < bigrams.size(); big++) {
+    if (big + 1 < bigrams.size() &&
+        bigrams[big + 1].first == bigrams[big].first) {
+      continue;
     }
-
-    table->char_bigram[ch1].bigram[ch2].cnt = cnt;
-    table->char_bigram[ch1].total_cnt += cnt;
-    table->total_cnt += cnt;
+    keys_buff_.push_back(bigrams[big].first);
+    costs_buff_.push_back(bigrams[big].second);
   }
 
   // compute costs (-log probs)
-  table->worst_cost = static_cast<int>(
-      -PROB2COST_SCALE * log(0.5 / table->total_cnt));
-  for (char_32 ch1 = 0; ch1 <= table->max_char; ch1++) {
-    for (char_32 ch2 = 0; ch2 <= table->char_bigram[ch1].max_char; ch2++) {
-      int cnt = table->char_bigram[ch1].bigram[ch2].cnt;
-      table->char_bigram[ch1].bigram[ch2].cost =
-          static_cast<int>(-PROB2COST_SCALE *
-                           log(MAX(0.5, static_cast<double>(cnt)) /
-                               table->total_cnt));
-    }
+  worst_cost_ = static_cast<int>(-PROB2COST_SCALE * log(0.5 / total_cnt));
+  for (int big = 0; big < costs_buff_.size(); big++) {
+    int cnt = costs_buff_[big];
+    costs_buff_[big] = static_cast<int>(
+        -PROB2COST_SCALE * log(MAX(0.5, static_cast<double>(cnt)) /
+                               total_cnt));
   }
-  return char_bigrams_obj;
+  bigram_cnt_ = keys_buff_.size();
+  keys_ = keys_buff_.empty() ? NULL : &keys_buff_[0];
+  costs_ = costs_buff_.empty() ? NULL : &costs_buff_[0];
+  return true;
 }
 
-int CharBigrams::PairCost(char_32 ch1, char_32 ch2) const {
-  if (ch1 > bigram_table_.max_char) {
-    return bigram_table_.worst_cost;
+// Points the table at its binary form
+bool CharBigrams::LoadBinary(const char *data, size_t size) {
+  const size_t kHeaderSize = 4 * sizeof(inT32);
+  if (size < kHeaderSize) {
+    return false;
+  }
+  const inT32 *header = reinterpret_cast<const inT32 *>(data);
+  if (static_cast<unsigned int>(header[0]) != kBinaryMagic) {
+    return false;
   }
-  if (ch2 > bigram_table_.char_bigram[ch1].max_char) {
-    return bigram_table_.worst_cost;
+  int bigram_cnt = header[1];
+  if (bigram_cnt < 0 || size != kHeaderSize + static_cast<size_t>(bigram_cnt) *
+      (sizeof(*keys_) + sizeof(*costs_))) {
+    fprintf(stderr, "Cube ERROR (CharBigrams::Create): invalid binary "
+            "bigram data\n");
+    return false;
+  }
+  bigram_cnt_ = bigram_cnt;
+  worst_cost_ = header[2];
+  keys_ = reinterpret_cast<const uinT64 *>(data + kHeaderSize);
+  costs_ = reinterpret_cast<const inT32 *>(keys_ + bigram_cnt);
+  return true;
+}
+
+// Writes the binary form of the table
+bool CharBigrams::Save(FILE *fp) const {
+  inT32 header[4];
+  header[0] = kBinaryMagic;
+  header[1] = bigram_cnt_;
+  header[2] = worst_cost_;
+  header[3] = 0;
+  return fwrite(header, sizeof(header), 1, fp) == 1 &&
+      fwrite(keys_, sizeof(*keys_), bigram_cnt_, fp) == bigram_cnt_ &&
+      fwrite(costs_, sizeof(*costs_), bigram_cnt_, fp) == bigram_cnt_;
+}
+
+int CharBigrams::PairCost(char_32 ch1, char_32 ch2) const {
+  uinT64 key = BigramKey(ch1, ch2);
+  const uinT64 *end = keys_ + bigram_cnt_;
+  const uinT64 *found = lower_bound(keys_, end, key);
+  if (found == end || *found != key) {
+    return worst_cost_;
   }
-  return bigram_table_.char_bigram[ch1].bigram[ch2].cost;
+  return costs_[found - keys_];
 }
 
 int CharBigrams::Cost(const char_32 *char_32_ptr, CharSet *char_set) const {
   if (!char_32_ptr || char_32_ptr[0] == 0) {
-    return bigram_table_.worst_cost;
+    return worst_cost_;
   }
   int cost = MeanCostWithSpaces(char_32_ptr);
   if (CubeUtils::StrLen(char_32_ptr) >= kMinLengthCaseInvariant &&
@@ -177,7 +219,7 @@ int CharBigrams::Cost(const char_32 *char_32_ptr, CharSet *char_set) const {
 
 int CharBigrams::MeanCostWithSpaces(const char_32 *char_32_ptr) const {
   if (!char_32_ptr)
-    return bigram_table_.worst_cost;
+    return worst_cost_;
   int len = CubeUtils::StrLen(char_32_ptr);
   int cost = 0;
   int c = 0;
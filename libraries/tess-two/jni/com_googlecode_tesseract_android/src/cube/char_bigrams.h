@@ -22,37 +22,26 @@
 // A CharBigram object can be constructed from the Char Bigrams file
 // Given a sequence of characters, the "Cost" method returns the Char Bigram
 // cost of the string according to the table
+// The <lang>.cube.bigrams file is either a text list of bigram counts or the
+// binary form written by Save, which is mapped into memory as is rather than
+// parsed. The binary form is laid out in host byte order as:
+//   uinT32 kBinaryMagic
+//   inT32 bigram count, inT32 worst cost, inT32 unused
+//   uinT64 keys[bigram count]: sorted, the first character in the high
+//     32 bits and the second character in the low ones
+//   inT32 costs[bigram count]
 
 #ifndef CHAR_BIGRAMS_H
 #define CHAR_BIGRAMS_H
 
+#include <stdio.h>
 #include <string>
+#include <vector>
 #include "char_set.h"
+#include "host.h"
 
 namespace tesseract {
 
-// structure representing a single bigram value
-struct Bigram {
-  int cnt;
-  int cost;
-};
-
-// structure representing the char bigram array of characters
-// following a specific character
-struct CharBigram {
-  int total_cnt;
-  char_32 max_char;
-  Bigram *bigram;
-};
-
-// structure representing the whole bigram table
-struct CharBigramTable {
-  int total_cnt;
-  int worst_cost;
-  char_32 max_char;
-  CharBigram *char_bigram;
-};
-
 class CharBigrams {
  public:
   CharBigrams();
@@ -60,6 +49,8 @@ class CharBigrams {
   // Construct the CharBigrams class from a file
   static CharBigrams *Create(const string &data_file_path,
                              const string &lang);
+  // Writes the bigram table in its binary form. Returns false on error.
+  bool Save(FILE *fp) const;
   // Top-level function to return the mean character bigram cost of a
   // sequence of characters.  If char_set is not NULL, use
   // tesseract functions to return a case-invariant cost.
@@ -80,9 +71,33 @@ class CharBigrams {
   // Only words this length or greater qualify for case-invariant character
   // bigram cost.
   static const int kMinLengthCaseInvariant = 4;
+  // Marks a binary bigrams file.
+  static const unsigned int kBinaryMagic = 0x43424731;
 
+  // Returns the key of the bigram of the two characters.
+  static uinT64 BigramKey(char_32 ch1, char_32 ch2) {
+    return (static_cast<uinT64>(static_cast<uinT32>(ch1)) << 32) |
+        static_cast<uinT32>(ch2);
+  }
+  // Parses the text form of the bigram table into the owned buffers.
+  bool LoadText(const string &str);
+  // Points the bigram table at the binary form held in data. Returns false
+  // if data does not hold a valid binary bigram table.
+  bool LoadBinary(const char *data, size_t size);
 
-  CharBigramTable bigram_table_;
+  int bigram_cnt_;
+  // cost of the bigrams missing from the table
+  int worst_cost_;
+  // sorted keys of the bigrams in the table and their costs
+  const uinT64 *keys_;
+  const inT32 *costs_;
+  // storage of the table when it is not mapped from its file
+  vector<uinT64> keys_buff_;
+  vector<inT32> costs_buff_;
+  string data_buff_;
+  // mapping of a binary bigrams file
+  const char *mapped_data_;
+  size_t mapped_size_;
 };
 }
 
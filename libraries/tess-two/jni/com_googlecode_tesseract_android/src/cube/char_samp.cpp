@@ -367,6 +367,29 @@ CharSamp *CharSamp::Crop() {
   return cropped_samp;
 }
 
+// Crop the char samp in place. Same as Crop, but no new char samp is created
+// and the bitmap is not copied.
+bool CharSamp::CropInPlace() {
+  int cropped_left = 0;
+  int cropped_top = 0;
+  int cropped_wid = wid_;
+  int cropped_hgt = hgt_;
+  Bmp8::Crop(&cropped_left, &cropped_top,
+             &cropped_wid, &cropped_hgt);
+
+  if (cropped_wid == 0 || cropped_hgt == 0) {
+    return false;
+  }
+  Trim(cropped_left, cropped_top, cropped_wid, cropped_hgt);
+  left_ += cropped_left;
+  top_ += cropped_top;
+  // as in Crop, these may/should be reset by the calling function
+  SetNormAspectRatio(255 * cropped_wid / (cropped_wid + cropped_hgt));
+  SetNormTop(0);
+  SetNormBottom(255);
+  return true;
+}
+
 // segment the char samp to connected components
 // based on contiguity and vertical pixel density histogram
 ConComp **CharSamp::Segment(int *segment_cnt, bool right_2_left,
@@ -616,8 +639,17 @@ CharSamp *CharSamp::FromCharDumpFile(unsigned char **raw_data_ptr) {
 // computes the features corresponding to the char sample
 bool CharSamp::ComputeFeatures(int conv_grid_size, float *features) {
   // Create a scaled BMP
-  CharSamp *scaled_bmp = Scale(conv_grid_size, conv_grid_size);
-  if (!scaled_bmp) {
+  Bmp8 scaled_bmp(conv_grid_size, conv_grid_size);
+  return ComputeFeatures(conv_grid_size, features, &scaled_bmp);
+}
+
+// computes the features corresponding to the char sample, scaling it into
+// the specified bitmap
+bool CharSamp::ComputeFeatures(int conv_grid_size, float *features,
+                               Bmp8 *scaled_bmp) {
+  if (scaled_bmp->Width() != conv_grid_size ||
+      scaled_bmp->Height() != conv_grid_size ||
+      !scaled_bmp->Clear() || !scaled_bmp->ScaleFrom(this)) {
     return false;
   }
   // prepare input
@@ -634,7 +666,6 @@ bool CharSamp::ComputeFeatures(int conv_grid_size, float *features) {
   features[input++] = NormTop();
   features[input++] = NormBottom();
   features[input++] = NormAspectRatio();
-  delete scaled_bmp;
   return true;
 }
 }  // namespace tesseract
@@ -107,6 +107,10 @@ class CharSamp : public Bmp8 {
   // necessarily set the normalized top and bottom correctly since
   // those depend on its location within the word (or CubeSearchObject).
   CharSamp *Crop();
+  // Crops the sample the same way Crop does, but in place: the bitmap is
+  // not copied, its rows are pointed at the cropped area of the existing
+  // buffer. Returns false, leaving the sample unchanged, if it is blank.
+  bool CropInPlace();
   // Computes the connected components of the char sample
   ConComp **Segment(int *seg_cnt, bool right_2_left, int max_hist_wnd,
                     int min_con_comp_size) const;
@@ -117,6 +121,11 @@ class CharSamp : public Bmp8 {
   CharSamp *Clone() const;
   // computes the features corresponding to the char sample
   bool ComputeFeatures(int conv_grid_size, float *features);
+  // same as above, but scales the sample into the given conv_grid_size
+  // square bitmap instead of allocating one, so that callers computing
+  // features repeatedly can reuse it
+  bool ComputeFeatures(int conv_grid_size, float *features,
+                       Bmp8 *scaled_bmp);
   // Load a Char Samp from a dump file
   static CharSamp *FromCharDumpFile(CachedFile *fp);
   static CharSamp *FromCharDumpFile(FILE *fp);
@@ -67,6 +67,19 @@ class CharClassifier {
   virtual bool SetLearnParam(char *var_name, float val) = 0;
   virtual bool Init(const string &data_file_path, const string &lang,
                     LangModel *lang_mod) = 0;
+  // Classifies samp_cnt charsamps at once, setting alt_lists[i] to what
+  // Classify(char_samps[i]) would return. Classifiers that can share work
+  // across the batch override this; by default each sample is classified
+  // in turn. Returns false if none could be classified.
+  virtual bool ClassifyBatch(CharSamp **char_samps, int samp_cnt,
+                             CharAltList **alt_lists) {
+    bool any_classified = false;
+    for (int samp = 0; samp < samp_cnt; samp++) {
+      alt_lists[samp] = Classify(char_samps[samp]);
+      if (alt_lists[samp] != NULL) any_classified = true;
+    }
+    return any_classified;
+  }
 
   // accessors
   FeatureBase *FeatureExtractor() {return feat_extract_;}
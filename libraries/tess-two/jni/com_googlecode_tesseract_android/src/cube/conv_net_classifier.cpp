@@ -20,6 +20,7 @@
 #include <algorithm>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <string>
 #include <vector>
 #include <wctype.h>
@@ -189,7 +190,67 @@ CharAltList *ConvNetCharClassifier::Classify(CharSamp *char_samp) {
   if (RunNets(char_samp) == false) {
     return NULL;
   }
+  return MakeAltList();
+}
+
+/**
+ * classifies a batch of charsamps. The features of all the samples that
+ * yield them are stacked and fed forward together, then each sample's
+ * outputs are folded and listed as in Classify
+ */
+bool ConvNetCharClassifier::ClassifyBatch(CharSamp **char_samps,
+                                          int samp_cnt,
+                                          CharAltList **alt_lists) {
+  if (char_net_ == NULL) {
+    fprintf(stderr, "Cube ERROR (ConvNetCharClassifier::ClassifyBatch): "
+            "NeuralNet is NULL\n");
+    return false;
+  }
+  int feat_cnt = char_net_->in_cnt();
+  int class_cnt = char_set_->ClassCount();
+  if (net_input_ == NULL) {
+    net_input_ = new float[feat_cnt];
+    net_output_ = new float[class_cnt];
+  }
 
+  // compute the features of each sample, skipping those that fail
+  batch_input_.resize(samp_cnt * feat_cnt);
+  vector<int> batch_samps;
+  for (int samp = 0; samp < samp_cnt; samp++) {
+    alt_lists[samp] = NULL;
+    float *features = &batch_input_[batch_samps.size() * feat_cnt];
+    if (feat_extract_->ComputeFeatures(char_samps[samp], features)) {
+      batch_samps.push_back(samp);
+    } else {
+      fprintf(stderr, "Cube ERROR (ConvNetCharClassifier::ClassifyBatch): "
+              "unable to compute features\n");
+    }
+  }
+  if (batch_samps.empty()) {
+    return false;
+  }
+
+  int batch_cnt = batch_samps.size();
+  batch_output_.resize(batch_cnt * class_cnt);
+  if (!char_net_->FeedForwardBatch(&batch_input_[0], batch_cnt,
+                                   &batch_output_[0])) {
+    fprintf(stderr, "Cube ERROR (ConvNetCharClassifier::ClassifyBatch): "
+            "unable to run feed-forward\n");
+    return false;
+  }
+  for (int b = 0; b < batch_cnt; b++) {
+    memcpy(net_output_, &batch_output_[b * class_cnt],
+           class_cnt * sizeof(*net_output_));
+    Fold();
+    alt_lists[batch_samps[b]] = MakeAltList();
+  }
+  return true;
+}
+
+/**
+ * makes the alternate list of the folded net outputs, sorted by char costs
+ */
+CharAltList *ConvNetCharClassifier::MakeAltList() {
   int class_cnt = char_set_->ClassCount();
 
   // create an altlist
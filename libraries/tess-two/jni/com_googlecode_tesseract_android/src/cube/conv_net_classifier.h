@@ -30,6 +30,7 @@
 #define CONV_NET_CLASSIFIER_H
 
 #include <string>
+#include <vector>
 #include "char_samp.h"
 #include "char_altlist.h"
 #include "char_set.h"
@@ -64,6 +65,10 @@ class ConvNetCharClassifier : public CharClassifier {
   // Classifies an input charsamp and return a CharAltList object containing
   // the possible candidates and corresponding scores
   virtual CharAltList * Classify(CharSamp *char_samp);
+  // Classifies a batch of charsamps, feeding all their features through the
+  // net together so that its weights are loaded once per batch.
+  virtual bool ClassifyBatch(CharSamp **char_samps, int samp_cnt,
+                             CharAltList **alt_lists);
   // Computes the cost of a specific charsamp being a character (versus a
   // non-character: part-of-a-character OR more-than-one-character)
   virtual int CharCost(CharSamp *char_samp);
@@ -75,6 +80,9 @@ class ConvNetCharClassifier : public CharClassifier {
   // data buffers used to hold Neural Net inputs and outputs
   float *net_input_;
   float *net_output_;
+  // features and outputs of each sample of a batch, one after the other
+  vector<float> batch_input_;
+  vector<float> batch_output_;
 
   // Init the classifier provided a data-path and a language string
   virtual bool Init(const string &data_file_path, const string &lang,
@@ -89,6 +97,8 @@ class ConvNetCharClassifier : public CharClassifier {
   virtual void Fold();
   // Scales the input char_samp and feeds it to the NeuralNet as input
   bool RunNets(CharSamp *char_samp);
+  // Makes the alternate list of the folded net_output_
+  CharAltList *MakeAltList();
 };
 }
 #endif  // CONV_NET_CLASSIFIER_H
@@ -46,6 +46,7 @@ void CubeObject::Init() {
   deslanted_alt_list_ = NULL;
   deslanted_srch_obj_ = NULL;
   deslanted_ = false;
+  normalized_ = false;
   deslanted_char_samp_ = NULL;
   beam_obj_ = NULL;
   deslanted_beam_obj_ = NULL;
@@ -105,7 +106,7 @@ WordAltList *CubeObject::Recognize(LangModel *lang_mod, bool word_mode) {
   }
 
   // normalize if necessary
-  if (cntxt_->SizeNormalization()) {
+  if (cntxt_->SizeNormalization() && !normalized_) {
     Normalize();
   }
 
@@ -217,13 +218,17 @@ CharAltList *CubeObject::RecognizeChar() {
 
 // Normalize the input word bitmap to have a minimum aspect ratio
 bool CubeObject::Normalize() {
-  // create a cube search object
-  CubeSearchObject *srch_obj = new CubeSearchObject(cntxt_, char_samp_);
+  normalized_ = true;
+  // create a cube search object, unless recognition already made one
+  CubeSearchObject *srch_obj = srch_obj_;
+  if (srch_obj == NULL) {
+    srch_obj = new CubeSearchObject(cntxt_, char_samp_);
+  }
   // Perform over-segmentation
   int seg_cnt = srch_obj->SegPtCnt();
   // Only perform normalization if segment count is large enough
   if (seg_cnt < kMinNormalizationSegmentCnt) {
-    delete srch_obj;
+    srch_obj_ = srch_obj;
     return true;
   }
   // compute the mean AR of the segments
@@ -249,9 +254,13 @@ bool CubeObject::Normalize() {
       // update with new scaled charsamp and set ownership flag
       char_samp_ = new_samp;
       own_char_samp_ = true;
+      // the segments of the old char samp are no use for the new one
+      delete srch_obj;
+      srch_obj_ = NULL;
+      return true;
     }
   }
-  delete srch_obj;
+  srch_obj_ = srch_obj;
   return true;
 }
 }
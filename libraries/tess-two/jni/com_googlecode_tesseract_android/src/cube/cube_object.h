@@ -138,6 +138,11 @@ class CubeObject {
 
  protected:
   // Normalize the CharSamp if its aspect ratio exceeds the below constant.
+  // Done once per object: the search object made to measure the segments
+  // becomes srch_obj_ if the CharSamp is left as it is, so its segmentation
+  // and the CharSamps, features and results it caches per segment range are
+  // shared by every later Recognize call, such as the WordCost calls of the
+  // combiner.
   bool Normalize();
 
  private:
@@ -159,6 +164,7 @@ class CubeObject {
   BeamSearch *deslanted_beam_obj_;
   bool own_char_samp_;
   bool deslanted_;
+  bool normalized_;
   CharSamp *char_samp_;
   CharSamp *deslanted_char_samp_;
   CubeSearchObject *srch_obj_;
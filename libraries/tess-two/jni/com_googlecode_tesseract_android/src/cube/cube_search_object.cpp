@@ -165,13 +165,10 @@ CharSamp *CubeSearchObject::CharSample(int start_pt, int end_pt) {
   if (!samp)
     return NULL;
 
-  if (kUseCroppedChars) {
-    CharSamp *cropped_samp = samp->Crop();
-    // we no longer need the orig sample
+  // crop without copying the bitmap
+  if (kUseCroppedChars && !samp->CropInPlace()) {
     delete samp;
-    if (!cropped_samp)
-      return NULL;
-    samp = cropped_samp;
+    return NULL;
   }
 
   // get the dimensions of the new cropped sample
@@ -221,13 +218,9 @@ Box *CubeSearchObject::CharBox(int start_pt, int end_pt) {
                                           &left_most, &right_most, hgt_);
   if (!samp)
     return NULL;
-  if (kUseCroppedChars) {
-    CharSamp *cropped_samp = samp->Crop();
+  if (kUseCroppedChars && !samp->CropInPlace()) {
     delete samp;
-    if (!cropped_samp) {
-      return NULL;
-    }
-    samp = cropped_samp;
+    return NULL;
   }
   Box *box = boxCreate(samp->Left(), samp->Top(),
                        samp->Width(), samp->Height());
@@ -292,6 +285,38 @@ CharAltList * CubeSearchObject::RecognizeSegment(int start_pt, int end_pt) {
   return reco_cache_[start_pt + 1][end_pt];
 }
 
+// call from Beam Search before the RecognizeSegment calls of a column, to
+// classify all the bitmaps that end at the column in one batch
+void CubeSearchObject::RecognizeSegments(int first_start_pt, int end_pt) {
+  if (!init_ && !Init())
+    return;
+  CharClassifier *char_classifier = cntxt_->Classifier();
+  if (!char_classifier || !reco_cache_)
+    return;
+
+  vector<CharSamp *> samps;
+  vector<int> start_pts;
+  for (int start_pt = first_start_pt; start_pt < end_pt; start_pt++) {
+    if (!IsValidSegmentRange(start_pt, end_pt) ||
+        !reco_cache_[start_pt + 1] || reco_cache_[start_pt + 1][end_pt])
+      continue;
+    CharSamp *samp = CharSample(start_pt, end_pt);
+    if (samp) {
+      samps.push_back(samp);
+      start_pts.push_back(start_pt);
+    }
+  }
+  // a single bitmap gains nothing from batching
+  if (samps.size() < 2)
+    return;
+
+  vector<CharAltList *> alt_lists(samps.size());
+  char_classifier->ClassifyBatch(&samps[0], samps.size(), &alt_lists[0]);
+  for (int samp = 0; samp < samps.size(); samp++) {
+    reco_cache_[start_pts[samp] + 1][end_pt] = alt_lists[samp];
+  }
+}
+
 // Perform segmentation of the bitmap by detecting connected components,
 // segmenting each connected component using windowed vertical pixel density
 // histogram and sorting the resulting segments in reading order
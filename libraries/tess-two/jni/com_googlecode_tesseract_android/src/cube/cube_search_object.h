@@ -48,6 +48,9 @@ class CubeSearchObject : public SearchObject {
   // Recognize the set of segments given by the specified range and return
   // a list of possible alternate answers
   CharAltList * RecognizeSegment(int start_pt, int end_pt);
+  // Classifies the uncached segment ranges ending at end_pt as one batch,
+  // and caches the results for RecognizeSegment.
+  void RecognizeSegments(int first_start_pt, int end_pt);
   // Returns the CharSamp corresponding to the specified segment range
   CharSamp *CharSample(int start_pt, int end_pt);
   // Returns a leptonica box corresponding to the specified segment range
@@ -20,6 +20,12 @@
 #include <math.h>
 #include <string>
 #include <vector>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 #include "cube_utils.h"
 #include "char_set.h"
 #include "unichar.h"
@@ -96,21 +102,31 @@ char_32 *CubeUtils::StrDup(const char_32 *str32) {
 }
 
 /**
- * creates a char samp from a specified portion of the image
+ * creates a char samp from a specified portion of the image, converting
+ * the pixels straight into the bitmap of the char samp
  */
 CharSamp *CubeUtils::CharSampleFromPix(Pix *pix, int left, int top,
                                        int wid, int hgt) {
-  // get the raw img data from the image
-  unsigned char *temp_buff = GetImageData(pix, left, top, wid, hgt);
-  if (temp_buff == NULL) {
+  // skip invalid dimensions
+  if (left < 0 || top < 0 || wid < 0 || hgt < 0 ||
+      (left + wid) > pix->w || (top + hgt) > pix->h ||
+      pix->d != 1) {
     return NULL;
   }
 
-  // create a char samp from temp buffer
-  CharSamp *char_samp = CharSamp::FromRawData(left, top, wid, hgt, temp_buff);
+  CharSamp *char_samp = new CharSamp(left, top, wid, hgt);
+  int stride = char_samp->Stride();
+  unsigned char *samp_line = char_samp->RawData();
+  l_int32 wpl = pixGetWpl(pix);
+  l_uint32 *line = pixGetData(pix) + (top * wpl);
 
-  // clean up temp buffer
-  delete []temp_buff;
+  for (int y = 0; y < hgt; y++) {
+    for (int x = 0; x < wid; x++) {
+      samp_line[x] = GET_DATA_BIT(line, x + left) ? 0 : 255;
+    }
+    line += wpl;
+    samp_line += stride;
+  }
   return char_samp;
 }
 
@@ -148,41 +164,6 @@ Pix *CubeUtils::PixFromCharSample(CharSamp *char_samp) {
   return pix;
 }
 
-/**
- * creates a raw buffer from the specified location of the pix
- */
-unsigned char *CubeUtils::GetImageData(Pix *pix, int left, int top,
-                                       int wid, int hgt) {
-  // skip invalid dimensions
-  if (left < 0 || top < 0 || wid < 0 || hgt < 0 ||
-      (left + wid) > pix->w || (top + hgt) > pix->h ||
-      pix->d != 1) {
-    return NULL;
-  }
-
-  // copy the char img to a temp buffer
-  unsigned char *temp_buff = new unsigned char[wid * hgt];
-  l_int32 w;
-  l_int32 h;
-  l_int32 d;
-  l_int32 wpl;
-  l_uint32 *line;
-  l_uint32 *data;
-
-  pixGetDimensions(pix, &w, &h, &d);
-  wpl = pixGetWpl(pix);
-  data = pixGetData(pix);
-  line = data + (top * wpl);
-
-  for (int y = 0, off = 0; y < hgt ; y++) {
-    for (int x = 0; x < wid; x++, off++) {
-      temp_buff[off] = GET_DATA_BIT(line, x + left) ? 0 : 255;
-    }
-    line += wpl;
-  }
-  return temp_buff;
-}
-
 /**
  * read file contents to a string
  */
@@ -214,6 +195,44 @@ bool CubeUtils::ReadFileToString(const string &file_name, string *str) {
   return (read_bytes == file_size);
 }
 
+/**
+ * maps the contents of a file into memory
+ */
+const char *CubeUtils::MapFile(const string &file_name, size_t *size) {
+#ifdef _WIN32
+  return NULL;
+#else
+  int fd = open(file_name.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return NULL;
+  }
+  struct stat file_stat;
+  if (fstat(fd, &file_stat) != 0 || file_stat.st_size < 1) {
+    close(fd);
+    return NULL;
+  }
+  void *data = mmap(NULL, file_stat.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  // the mapping stays valid once the file is closed
+  close(fd);
+  if (data == MAP_FAILED) {
+    return NULL;
+  }
+  (*size) = file_stat.st_size;
+  return static_cast<const char *>(data);
+#endif
+}
+
+/**
+ * releases a mapping made by MapFile
+ */
+void CubeUtils::UnmapFile(const char *data, size_t size) {
+#ifndef _WIN32
+  if (data != NULL) {
+    munmap(const_cast<char *>(data), size);
+  }
+#endif
+}
+
 /**
  * splits a string into vectors based on specified delimiters
  */
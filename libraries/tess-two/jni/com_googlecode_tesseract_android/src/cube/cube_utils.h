@@ -55,6 +55,11 @@ class CubeUtils {
   static Pix *PixFromCharSample(CharSamp *char_samp);
   // read the contents of a file to a string
   static bool ReadFileToString(const string &file_name, string *str);
+  // Maps the whole of a file read-only into memory, returning its contents
+  // and setting *size, or NULL if the file can not be mapped. The mapping
+  // must be released with UnmapFile.
+  static const char *MapFile(const string &file_name, size_t *size);
+  static void UnmapFile(const char *data, size_t size);
   // split a string into vectors using any of the specified delimiters
   static void SplitStringUsing(const string &str, const string &delims,
                                vector<string> *str_vec);
@@ -75,9 +80,6 @@ class CubeUtils {
   // the input string or NULL on error. If char_set is NULL returns NULL.
   // Return array must be freed by caller.
   static char_32 *ToUpper(const char_32 *str32, CharSet *char_set);
- private:
-  static unsigned char *GetImageData(Pix *pix,
-                                     int left, int top, int wid, int hgt);
 };
 }  // namespace tesseract
 #endif  // CUBE_UTILS_H
@@ -31,9 +31,11 @@ namespace tesseract {
 FeatureBmp::FeatureBmp(TuningParams *params)
     :FeatureBase(params) {
   conv_grid_size_ = params->ConvGridSize();
+  scaled_bmp_ = new Bmp8(conv_grid_size_, conv_grid_size_);
 }
 
 FeatureBmp::~FeatureBmp() {
+  delete scaled_bmp_;
 }
 
 // Render a visualization of the features to a CharSamp.
@@ -44,7 +46,7 @@ CharSamp *FeatureBmp::ComputeFeatureBitmap(CharSamp *char_samp) {
 
 // Compute the features for a given CharSamp
 bool FeatureBmp::ComputeFeatures(CharSamp *char_samp, float *features) {
-  return char_samp->ComputeFeatures(conv_grid_size_, features);
+  return char_samp->ComputeFeatures(conv_grid_size_, features, scaled_bmp_);
 }
 }
 
@@ -47,6 +47,9 @@ class FeatureBmp : public FeatureBase {
  protected:
   // grid size, cached from the TuningParams object
   int conv_grid_size_;
+  // conv_grid_size_ square bitmap the samples are scaled into, reused
+  // across calls to ComputeFeatures
+  Bmp8 *scaled_bmp_;
 };
 }
 
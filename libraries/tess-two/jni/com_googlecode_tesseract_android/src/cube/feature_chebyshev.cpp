@@ -28,11 +28,30 @@
 #include "cube_utils.h"
 #include "const.h"
 #include "char_samp.h"
+#include "simddetect.h"
 
 namespace tesseract {
 
 FeatureChebyshev::FeatureChebyshev(TuningParams *params)
     : FeatureBase(params) {
+  const int coeff_cnt = kChebychevCoefficientCnt;
+  float normalizer = 2.0 / coeff_cnt;
+  for (int samp_idx = 0; samp_idx < coeff_cnt; samp_idx++) {
+    samp_pos_[samp_idx] = (1 + cos(M_PI * (samp_idx + 0.5) / coeff_cnt)) / 2;
+  }
+  for (int coeff_idx = 0; coeff_idx < coeff_cnt; coeff_idx++) {
+    for (int samp_idx = 0; samp_idx < coeff_cnt; samp_idx++) {
+      basis_[coeff_idx * coeff_cnt + samp_idx] = normalizer *
+          cos(M_PI * coeff_idx * (samp_idx + 0.5) / coeff_cnt);
+    }
+  }
+  if (SIMDDetect::IsSSE2Available()) {
+    mat_vec_kernel_ = DenseLayerSSE2;
+  } else if (SIMDDetect::IsNEONAvailable()) {
+    mat_vec_kernel_ = DenseLayerNEON;
+  } else {
+    mat_vec_kernel_ = NULL;
+  }
 }
 
 FeatureChebyshev::~FeatureChebyshev() {
@@ -45,31 +64,33 @@ CharSamp *FeatureChebyshev::ComputeFeatureBitmap(CharSamp *char_samp) {
 }
 
 // Compute Chebyshev coefficients for the specified vector
-void FeatureChebyshev::ChebyshevCoefficients(const vector<float> &input,
-                                             int coeff_cnt, float *coeff) {
+void FeatureChebyshev::ChebyshevCoefficients(const float *input,
+                                             int input_cnt, float *coeff) {
+  const int coeff_cnt = kChebychevCoefficientCnt;
   // re-sample function
-  int input_range = (input.size() - 1);
-  vector<float> resamp(coeff_cnt);
+  int input_range = (input_cnt - 1);
   for (int samp_idx = 0; samp_idx < coeff_cnt; samp_idx++) {
     // compute sampling position
-    float samp_pos = input_range *
-                     (1 + cos(M_PI * (samp_idx + 0.5) / coeff_cnt)) / 2;
+    float samp_pos = input_range * samp_pos_[samp_idx];
     // interpolate
     int samp_start = static_cast<int>(samp_pos);
     int samp_end = static_cast<int>(samp_pos + 0.5);
     float func_delta = input[samp_end] - input[samp_start];
-    resamp[samp_idx] = input[samp_start] +
-                       ((samp_pos - samp_start) * func_delta);
+    resamp_[samp_idx] = input[samp_start] +
+                        ((samp_pos - samp_start) * func_delta);
   }
   // compute the coefficients
-  float normalizer = 2.0 / coeff_cnt;
-  for (int coeff_idx = 0; coeff_idx < coeff_cnt; coeff_idx++, coeff++) {
-    double sum = 0.0;
-    for (int samp_idx = 0; samp_idx < coeff_cnt; samp_idx++) {
-        sum += resamp[samp_idx] * cos(M_PI * coeff_idx * (samp_idx + 0.5) /
-                                      coeff_cnt);
+  if (mat_vec_kernel_ == NULL ||
+      !mat_vec_kernel_(basis_, resamp_, coeff_cnt, coeff_cnt, coeff)) {
+    const float *basis_row = basis_;
+    for (int coeff_idx = 0; coeff_idx < coeff_cnt; coeff_idx++) {
+      float sum = 0.0f;
+      for (int samp_idx = 0; samp_idx < coeff_cnt; samp_idx++) {
+        sum += resamp_[samp_idx] * basis_row[samp_idx];
+      }
+      coeff[coeff_idx] = sum;
+      basis_row += coeff_cnt;
     }
-    (*coeff) = (normalizer * sum);
   }
 }
 
@@ -89,9 +110,14 @@ bool FeatureChebyshev::ComputeChebyshevCoefficients(CharSamp *char_samp,
   // compute the height of the word
   int word_hgt = (255 * (char_samp->Top() + char_samp->Height()) /
                   char_samp->NormBottom());
+  // lay the 4 profiles out one after the other
+  int wid = char_samp->Width();
+  profiles_.assign(2 * (word_hgt + wid), 0.0f);
+  float *left_profile = &profiles_[0];
+  float *right_profile = left_profile + word_hgt;
+  float *top_profile = right_profile + word_hgt;
+  float *bottom_profile = top_profile + wid;
   // compute left & right profiles
-  vector<float> left_profile(word_hgt, 0.0);
-  vector<float> right_profile(word_hgt, 0.0);
   unsigned char *line_data = raw_data;
   for (int y = 0; y < char_samp->Height(); y++, line_data += stride) {
     int min_x = char_samp->Width();
@@ -110,8 +136,6 @@ bool FeatureChebyshev::ComputeChebyshevCoefficients(CharSamp *char_samp,
   }
 
   // compute top and bottom profiles
-  vector<float> top_profile(char_samp->Width(), 0);
-  vector<float> bottom_profile(char_samp->Width(), 0);
   for (int x = 0; x < char_samp->Width(); x++) {
     int min_y = word_hgt;
     int max_y = -1;
@@ -126,12 +150,12 @@ bool FeatureChebyshev::ComputeChebyshevCoefficients(CharSamp *char_samp,
   }
 
   // compute the chebyshev coefficients of each profile
-  ChebyshevCoefficients(left_profile, kChebychevCoefficientCnt, features);
-  ChebyshevCoefficients(top_profile, kChebychevCoefficientCnt,
+  ChebyshevCoefficients(left_profile, word_hgt, features);
+  ChebyshevCoefficients(top_profile, wid,
                         features + kChebychevCoefficientCnt);
-  ChebyshevCoefficients(right_profile, kChebychevCoefficientCnt,
+  ChebyshevCoefficients(right_profile, word_hgt,
                         features + (2 * kChebychevCoefficientCnt));
-  ChebyshevCoefficients(bottom_profile, kChebychevCoefficientCnt,
+  ChebyshevCoefficients(bottom_profile, wid,
                         features + (3 * kChebychevCoefficientCnt));
   return true;
 }
@@ -26,8 +26,10 @@
 #ifndef FEATURE_CHEBYSHEV_H
 #define FEATURE_CHEBYSHEV_H
 
+#include <vector>
 #include "char_samp.h"
 #include "feature_base.h"
+#include "netsimd.h"
 
 namespace tesseract {
 class FeatureChebyshev : public FeatureBase {
@@ -45,12 +47,28 @@ class FeatureChebyshev : public FeatureBase {
   }
 
  protected:
+  // a multiple of kDenseLayerPadding, as the SIMD kernels require
   static const int kChebychevCoefficientCnt = 40;
-  // Compute Chebychev coefficients for the specified vector
-  void ChebyshevCoefficients(const vector<float> &input,
-                             int coeff_cnt, float *coeff);
+  // Compute the kChebychevCoefficientCnt Chebychev coefficients of the
+  // input_cnt values of input
+  void ChebyshevCoefficients(const float *input, int input_cnt, float *coeff);
   // Compute the features for a given CharSamp
   bool ComputeChebyshevCoefficients(CharSamp *samp, float *features);
+
+ private:
+  // Positions of the resampling points of ChebyshevCoefficients, as
+  // fractions of the input range
+  double samp_pos_[kChebychevCoefficientCnt];
+  // Cosine basis of the coefficients, one row per coefficient, scaled by
+  // the normalizer, so that the coefficients are its product with the
+  // resampled input
+  float basis_[kChebychevCoefficientCnt * kChebychevCoefficientCnt];
+  // Resampled input of ChebyshevCoefficients
+  float resamp_[kChebychevCoefficientCnt];
+  // The 4 profiles of the sample, reused across calls
+  vector<float> profiles_;
+  // SIMD matrix-vector product, or NULL to use the scalar loop
+  DenseLayerFunc mat_vec_kernel_;
 };
 }
 
@@ -26,6 +26,7 @@ SearchColumn::SearchColumn(int col_idx, int max_node) {
   col_idx_ = col_idx;
   node_cnt_ = 0;
   node_array_ = NULL;
+  node_array_size_ = 0;
   max_node_cnt_ = max_node;
   node_hash_table_ = NULL;
   init_ = false;
@@ -44,6 +45,7 @@ void SearchColumn::Cleanup() {
 
     delete []node_array_;
     node_array_ = NULL;
+    node_array_size_ = 0;
   }
   FreeHashTable();
   init_ = false;
@@ -150,11 +152,13 @@ SearchNode *SearchColumn::AddNode(LangModEdge *edge, int reco_cost,
       return NULL;
     }
 
-    // expand the node buffer if necc
-    if ((node_cnt_ % kNodeAllocChunk) == 0) {
+    // expand the node buffer if necc, doubling it so the copies stay
+    // linear in the node count
+    if (node_cnt_ == node_array_size_) {
       // alloc a new buff
-      SearchNode **new_node_buff =
-          new SearchNode *[node_cnt_ + kNodeAllocChunk];
+      node_array_size_ = node_array_size_ == 0 ? kNodeAllocChunk
+                                               : 2 * node_array_size_;
+      SearchNode **new_node_buff = new SearchNode *[node_array_size_];
 
       // free existing after copying contents
       if (node_array_ != NULL) {
@@ -168,11 +172,7 @@ SearchNode *SearchColumn::AddNode(LangModEdge *edge, int reco_cost,
     // add the node to the hash table only if it is non-OOD edge
     // because the langmod state is not unique
     if (edge->IsOOD() == false) {
-      if (!node_hash_table_->Insert(edge, new_node)) {
-        tprintf("Hash table full!!!");
-        delete new_node;
-        return NULL;
-      }
+      node_hash_table_->Insert(edge, new_node);
     }
 
     node_array_[node_cnt_++] = new_node;
@@ -69,6 +69,8 @@ class SearchColumn {
   int max_cost_;
   int max_node_cnt_;
   int node_cnt_;
+  // allocated size of node_array_
+  int node_array_size_;
   int col_idx_;
   int score_bins_[kScoreBins];
   SearchNode **node_array_;
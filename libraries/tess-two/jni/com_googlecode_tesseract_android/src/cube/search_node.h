@@ -27,6 +27,8 @@
 #ifndef SEARCH_NODE_H
 #define SEARCH_NODE_H
 
+#include <vector>
+
 #include "lang_mod_edge.h"
 #include "cube_reco_context.h"
 
@@ -106,62 +108,90 @@ class SearchNode {
 // Implments a SearchNode hash table used to detect if a Search Node exists
 // or not. This is needed to make sure that identical paths in the BeamSearch
 // converge
+// The table is open addressed with linear probing, keyed on the hash of the
+// node's edge plus that of its parent's edge, and doubles whenever it gets
+// half full, so lookups stay O(1) however wide the beam is.
 class SearchNodeHashTable {
  public:
-  SearchNodeHashTable() {
-    memset(bin_size_array_, 0, sizeof(bin_size_array_));
+  SearchNodeHashTable() : entry_cnt_(0) {
+    Resize(kInitialLog2Size);
   }
 
   ~SearchNodeHashTable() {
   }
 
   // inserts an entry in the hash table
-  inline bool Insert(LangModEdge *lang_mod_edge, SearchNode *srch_node) {
-    // compute hash based on the edge and its parent node edge
-    unsigned int edge_hash = lang_mod_edge->Hash();
-    unsigned int parent_hash = (srch_node->ParentNode() == NULL ?
-        0 : srch_node->ParentNode()->LangModelEdge()->Hash());
-    unsigned int hash_bin = (edge_hash + parent_hash) % kSearchNodeHashBins;
-
-    // already maxed out, just fail
-    if (bin_size_array_[hash_bin] >= kMaxSearchNodePerBin) {
-      return false;
+  inline void Insert(LangModEdge *lang_mod_edge, SearchNode *srch_node) {
+    if (2 * (entry_cnt_ + 1) > entries_.size()) {
+      Resize(log2_size_ + 1);
     }
-
-    bin_array_[hash_bin][bin_size_array_[hash_bin]++] = srch_node;
-
-    return true;
+    Place(Hash(lang_mod_edge, srch_node->ParentNode()), srch_node);
+    entry_cnt_++;
   }
 
   // Looks up an entry in the hash table
   inline SearchNode *Lookup(LangModEdge *lang_mod_edge,
                             SearchNode *parent_node) {
-    // compute hash based on the edge and its parent node edge
+    unsigned int hash = Hash(lang_mod_edge, parent_node);
+    unsigned int mask = entries_.size() - 1;
+    for (unsigned int slot = Slot(hash); entries_[slot].node != NULL;
+         slot = (slot + 1) & mask) {
+      const Entry &entry = entries_[slot];
+      if (entry.hash == hash &&
+          lang_mod_edge->IsIdentical(entry.node->LangModelEdge()) == true &&
+          SearchNode::IdenticalPath(entry.node->ParentNode(),
+                                    parent_node) == true) {
+        return entry.node;
+      }
+    }
+    return NULL;
+  }
+
+ private:
+  static const int kInitialLog2Size = 8;
+  struct Entry {
+    unsigned int hash;
+    SearchNode *node;
+  };
+
+  // compute hash based on the edge and its parent node edge
+  static inline unsigned int Hash(LangModEdge *lang_mod_edge,
+                                  SearchNode *parent_node) {
     unsigned int edge_hash = lang_mod_edge->Hash();
     unsigned int parent_hash = (parent_node == NULL ?
         0 : parent_node->LangModelEdge()->Hash());
-    unsigned int hash_bin = (edge_hash + parent_hash) % kSearchNodeHashBins;
-
-    // lookup the entries in the hash bin
-    for (int node_idx = 0; node_idx < bin_size_array_[hash_bin]; node_idx++) {
-      if (lang_mod_edge->IsIdentical(
-          bin_array_[hash_bin][node_idx]->LangModelEdge()) == true &&
-          SearchNode::IdenticalPath(
-          bin_array_[hash_bin][node_idx]->ParentNode(), parent_node) == true) {
-        return bin_array_[hash_bin][node_idx];
+    return edge_hash + parent_hash;
+  }
+  // Fibonacci hashing spreads the edge hashes, whose low bits are often
+  // alike, over the table.
+  inline unsigned int Slot(unsigned int hash) const {
+    return (hash * 2654435769u) >> (32 - log2_size_);
+  }
+  inline void Place(unsigned int hash, SearchNode *srch_node) {
+    unsigned int mask = entries_.size() - 1;
+    unsigned int slot = Slot(hash);
+    while (entries_[slot].node != NULL) {
+      slot = (slot + 1) & mask;
+    }
+    entries_[slot].hash = hash;
+    entries_[slot].node = srch_node;
+  }
+  void Resize(int log2_size) {
+    vector<Entry> old_entries;
+    old_entries.swap(entries_);
+    Entry empty = { 0, NULL };
+    log2_size_ = log2_size;
+    entries_.assign(1 << log2_size_, empty);
+    for (size_t e = 0; e < old_entries.size(); ++e) {
+      if (old_entries[e].node != NULL) {
+        Place(old_entries[e].hash, old_entries[e].node);
       }
     }
-
-    return NULL;
   }
 
- private:
-  // Hash bin size parameters. These were determined emperically. These affect
-  // the speed of the beam search but have no impact on accuracy
-  static const int kSearchNodeHashBins = 4096;
-  static const int kMaxSearchNodePerBin = 512;
-  int bin_size_array_[kSearchNodeHashBins];
-  SearchNode *bin_array_[kSearchNodeHashBins][kMaxSearchNodePerBin];
+  int log2_size_;
+  size_t entry_cnt_;
+  vector<Entry> entries_;
 };
 }
 
@@ -40,6 +40,10 @@ class SearchObject {
 
   virtual int SegPtCnt() = 0;
   virtual CharAltList *RecognizeSegment(int start_pt, int end_pt) = 0;
+  // Gives the search object the chance to recognize all the segment ranges
+  // (start_pt, end_pt) with first_start_pt <= start_pt < end_pt together,
+  // ahead of the RecognizeSegment calls for them.
+  virtual void RecognizeSegments(int first_start_pt, int end_pt) {}
   virtual CharSamp *CharSample(int start_pt, int end_pt) = 0;
   virtual Box* CharBox(int start_pt, int end_pt) = 0;
 
@@ -28,6 +28,7 @@
 
 #include "lang_mod_edge.h"
 #include "cube_reco_context.h"
+#include "pagearena.h"
 #include "cube_utils.h"
 
 // Macros needed to identify punctuation in the langmodel state
@@ -65,7 +66,9 @@
 #define DAWG_NUMBER   1
 
 namespace tesseract {
-class TessLangModEdge : public LangModEdge {
+// The edges are made by the thousand for each column of a beam search, so
+// they come from the arena of the search while one is current.
+class TessLangModEdge : public LangModEdge, public PageArenaAllocated {
  public:
   // Different ways of constructing a TessLangModEdge
   TessLangModEdge(CubeRecoContext *cntxt, const Dawg *edge_array,
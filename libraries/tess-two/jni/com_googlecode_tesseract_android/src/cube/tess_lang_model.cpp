@@ -64,6 +64,7 @@ TessLangModel::TessLangModel(const string &lm_params,
                              CubeRecoContext *cntxt) {
   cntxt_ = cntxt;
   has_case_ = cntxt_->HasCase();
+  fan_out_cache_edges_ = 0;
   // Load the rest of the language model elements from file
   LoadLangModelElements(lm_params);
   // Load word_dawgs_ if needed.
@@ -188,12 +189,12 @@ LangModEdge ** TessLangModel::GetEdges(CharAltList *alt_list,
       // Only look through word Dawgs (since there is a special way of
       // handling numbers and punctuation).
       if (curr_dawg->type() == DAWG_TYPE_WORD) {
-        (*edge_cnt) += FanOut(alt_list, curr_dawg, 0, 0, NULL, true,
+        (*edge_cnt) += CachedFanOut(alt_list, curr_dawg, 0, 0, NULL, true,
                               edge_array + (*edge_cnt));
       }
     }  // dawg
 
-    (*edge_cnt) += FanOut(alt_list, number_dawg_, 0, 0, NULL, true,
+    (*edge_cnt) += CachedFanOut(alt_list, number_dawg_, 0, 0, NULL, true,
                           edge_array + (*edge_cnt));
 
     // OOD: it is intentionally not added to the list to make sure it comes
@@ -212,14 +213,61 @@ LangModEdge ** TessLangModel::GetEdges(CharAltList *alt_list,
     edge_array = new LangModEdge *[(*edge_cnt)];
 
     // get the FanOut edges from the root of each dawg
-    (*edge_cnt) = FanOut(alt_list,
-                         tess_lm_edge->GetDawg(),
-                         tess_lm_edge->EndEdge(), tess_lm_edge->EdgeMask(),
-                         tess_lm_edge->EdgeString(), false, edge_array);
+    (*edge_cnt) = CachedFanOut(alt_list,
+                               tess_lm_edge->GetDawg(),
+                               tess_lm_edge->EndEdge(),
+                               tess_lm_edge->EdgeMask(),
+                               tess_lm_edge->EdgeString(), false, edge_array);
   }
   return edge_array;
 }
 
+int TessLangModel::CachedFanOut(CharAltList *alt_list, const Dawg *dawg,
+                                EDGE_REF edge_ref, EDGE_REF edge_mask,
+                                const char_32 *str, bool root_flag,
+                                LangModEdge **edge_array) {
+  if (dawg == ood_dawg_) {
+    return FanOut(alt_list, dawg, edge_ref, edge_mask, str, root_flag,
+                  edge_array);
+  }
+  FanOutKey key;
+  key.dawg = dawg;
+  key.edge_ref = edge_ref;
+  key.edge_mask = edge_mask;
+  key.flags = (root_flag ? 1 : 0) | (numeric_enabled_ ? 2 : 0) |
+              (word_list_enabled_ ? 4 : 0) | (punc_enabled_ ? 8 : 0);
+  fan_out_mutex_.Lock();
+  std::map<FanOutKey, vector<TessLangModEdge> >::const_iterator it =
+      fan_out_cache_.find(key);
+  if (it != fan_out_cache_.end()) {
+    const vector<TessLangModEdge> &edges = it->second;
+    for (int edge = 0; edge < edges.size(); edge++) {
+      edge_array[edge] = new TessLangModEdge(edges[edge]);
+    }
+    fan_out_mutex_.Unlock();
+    return edges.size();
+  }
+  fan_out_mutex_.Unlock();
+
+  int edge_cnt = FanOut(alt_list, dawg, edge_ref, edge_mask, str, root_flag,
+                        edge_array);
+  vector<TessLangModEdge> edges;
+  edges.reserve(edge_cnt);
+  for (int edge = 0; edge < edge_cnt; edge++) {
+    edges.push_back(*static_cast<TessLangModEdge *>(edge_array[edge]));
+  }
+  fan_out_mutex_.Lock();
+  if (fan_out_cache_edges_ + edge_cnt > kMaxFanOutCacheEdges) {
+    fan_out_cache_.clear();
+    fan_out_cache_edges_ = 0;
+  }
+  if (fan_out_cache_.insert(std::make_pair(key, edges)).second) {
+    fan_out_cache_edges_ += edge_cnt;
+  }
+  fan_out_mutex_.Unlock();
+  return edge_cnt;
+}
+
 // generate edges from an NULL terminated string
 // (used for punctuation, operators and digits)
 int TessLangModel::Edges(const char *strng, const Dawg *dawg,
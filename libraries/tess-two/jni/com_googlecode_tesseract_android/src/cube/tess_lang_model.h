@@ -20,7 +20,9 @@
 #ifndef TESS_LANG_MODEL_H
 #define TESS_LANG_MODEL_H
 
+#include <map>
 #include <string>
+#include <vector>
 
 #include "char_altlist.h"
 #include "cube_reco_context.h"
@@ -85,6 +87,32 @@ class TessLangModel : public LangModel {
 
   static int max_edge_;
   static int max_ood_shape_cost_;
+  // Most edges kept in fan_out_cache_ before it is emptied.
+  static const int kMaxFanOutCacheEdges = 1 << 16;
+
+  // A node of a dawg or state machine, and the settings its fan-out
+  // depends on.
+  struct FanOutKey {
+    const Dawg *dawg;
+    EDGE_REF edge_ref;
+    EDGE_REF edge_mask;
+    int flags;
+
+    bool operator<(const FanOutKey &other) const {
+      if (dawg != other.dawg) return dawg < other.dawg;
+      if (edge_ref != other.edge_ref) return edge_ref < other.edge_ref;
+      if (edge_mask != other.edge_mask) return edge_mask < other.edge_mask;
+      return flags < other.flags;
+    }
+  };
+  // Copies of the edges fanning out of the nodes expanded so far, except
+  // those of the OOD state machine, which depend on the character
+  // alternates. A beam search expands the same few prefixes from many
+  // parents in every column, so most fan-outs are found here. Guarded by
+  // fan_out_mutex_, as the parents of a column are expanded in parallel.
+  std::map<FanOutKey, vector<TessLangModEdge> > fan_out_cache_;
+  int fan_out_cache_edges_;
+  CCUtilMutex fan_out_mutex_;
 
   // remaining language model elements needed by cube. These get loaded from
   // the .lm file
@@ -108,6 +136,11 @@ class TessLangModel : public LangModel {
   int FanOut(CharAltList *alt_list,
              const Dawg *dawg, EDGE_REF edge_ref, EDGE_REF edge_ref_mask,
              const char_32 *str, bool root_flag, LangModEdge **edge_array);
+  // As FanOut, but copies the edges from fan_out_cache_ when it has them.
+  int CachedFanOut(CharAltList *alt_list,
+                   const Dawg *dawg, EDGE_REF edge_ref, EDGE_REF edge_ref_mask,
+                   const char_32 *str, bool root_flag,
+                   LangModEdge **edge_array);
   // generate edges from an NULL terminated string
   // (used for punctuation, operators and digits)
   int Edges(const char *strng, const Dawg *dawg,
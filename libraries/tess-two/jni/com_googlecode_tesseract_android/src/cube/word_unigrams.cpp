@@ -18,6 +18,7 @@
  **********************************************************************/
 
 #include <math.h>
+#include <string.h>
 #include <string>
 #include <vector>
 #include <algorithm>
@@ -26,28 +27,54 @@
 #include "cube_utils.h"
 #include "ndminx.h"
 #include "word_unigrams.h"
+#ifdef USE_STD_NAMESPACE
+using std::stable_sort;
+#endif
 
 namespace tesseract {
 
+namespace {
+
+// Compares two unterminated strings the way strcmp compares terminated ones.
+int CompareStrings(const char *str1, int len1, const char *str2, int len2) {
+  int comp = memcmp(str1, str2, MIN(len1, len2));
+  if (comp != 0) {
+    return comp;
+  }
+  return len1 - len2;
+}
+
+// Orders the indices of words held in a string pool by their words.
+class WordOrder {
+ public:
+  WordOrder(const char *pool, const inT32 *offsets)
+      : pool_(pool), offsets_(offsets) {}
+  bool operator()(int idx1, int idx2) const {
+    return CompareStrings(pool_ + offsets_[idx1],
+                          offsets_[idx1 + 1] - offsets_[idx1],
+                          pool_ + offsets_[idx2],
+                          offsets_[idx2 + 1] - offsets_[idx2]) < 0;
+  }
+
+ private:
+  const char *pool_;
+  const inT32 *offsets_;
+};
+
+}  // namespace
+
 WordUnigrams::WordUnigrams() {
-  costs_ = NULL;
-  words_ = NULL;
   word_cnt_ = 0;
+  offsets_ = NULL;
+  costs_ = NULL;
+  pool_ = NULL;
+  not_in_list_cost_ = 0;
+  mapped_data_ = NULL;
+  mapped_size_ = 0;
 }
 
 WordUnigrams::~WordUnigrams() {
-  if (words_ != NULL) {
-    if (words_[0] != NULL) {
-      delete []words_[0];
-    }
-
-    delete []words_;
-    words_ = NULL;
-  }
-
-  if (costs_ != NULL) {
-    delete []costs_;
-  }
+  CubeUtils::UnmapFile(mapped_data_, mapped_size_);
 }
 
 /**
@@ -57,57 +84,85 @@ WordUnigrams::~WordUnigrams() {
 WordUnigrams *WordUnigrams::Create(const string &data_file_path,
                                    const string &lang) {
   string file_name;
-  string str;
 
   file_name = data_file_path + lang;
   file_name += ".cube.word-freq";
 
+  WordUnigrams *word_unigrams_obj = new WordUnigrams();
+
+  // a binary word list is used in place
+  size_t mapped_size;
+  const char *mapped_data = CubeUtils::MapFile(file_name, &mapped_size);
+  if (mapped_data != NULL) {
+    if (word_unigrams_obj->LoadBinary(mapped_data, mapped_size)) {
+      word_unigrams_obj->mapped_data_ = mapped_data;
+      word_unigrams_obj->mapped_size_ = mapped_size;
+      return word_unigrams_obj;
+    }
+    CubeUtils::UnmapFile(mapped_data, mapped_size);
+  }
+
   // load the string into memory
+  string str;
   if (CubeUtils::ReadFileToString(file_name, &str) == false) {
+    delete word_unigrams_obj;
     return NULL;
   }
+  // a binary word list that could not be mapped is kept as read
+  word_unigrams_obj->data_buff_.swap(str);
+  const string &data = word_unigrams_obj->data_buff_;
+  if (word_unigrams_obj->LoadBinary(data.data(), data.length())) {
+    return word_unigrams_obj;
+  }
+  str.swap(word_unigrams_obj->data_buff_);
+  if (!word_unigrams_obj->LoadText(str)) {
+    delete word_unigrams_obj;
+    return NULL;
+  }
+  return word_unigrams_obj;
+}
 
+/**
+ * Parse the text form of the word list: pairs of words and costs
+ */
+bool WordUnigrams::LoadText(const string &str) {
   // split into lines
   vector<string> str_vec;
   CubeUtils::SplitStringUsing(str, "\r\n \t", &str_vec);
   if (str_vec.size() < 2) {
-    return NULL;
+    return false;
   }
 
-  // allocate memory
-  WordUnigrams *word_unigrams_obj = new WordUnigrams();
-
-  int full_len = str.length();
   int word_cnt = str_vec.size() / 2;
-  word_unigrams_obj->words_ = new char*[word_cnt];
-  word_unigrams_obj->costs_ = new int[word_cnt];
-
-  word_unigrams_obj->words_[0] = new char[full_len];
+  offsets_buff_.reserve(word_cnt + 1);
+  costs_buff_.reserve(word_cnt);
+  string pool;
+  pool.reserve(str.length());
 
   // construct sorted list of words and costs
-  word_unigrams_obj->word_cnt_ = 0;
-  char *char_buff = word_unigrams_obj->words_[0];
-  word_cnt = 0;
   int max_cost = 0;
+  for (int wrd = 0; wrd < word_cnt * 2; wrd += 2) {
+    offsets_buff_.push_back(pool.length());
+    pool += str_vec[wrd];
 
-  for (int wrd = 0; wrd < str_vec.size(); wrd += 2) {
-    word_unigrams_obj->words_[word_cnt] = char_buff;
-
-    strcpy(char_buff, str_vec[wrd].c_str());
-    char_buff += (str_vec[wrd].length() + 1);
-
-    if (sscanf(str_vec[wrd + 1].c_str(), "%d",
-               word_unigrams_obj->costs_ + word_cnt) != 1) {
+    int cost;
+    if (sscanf(str_vec[wrd + 1].c_str(), "%d", &cost) != 1) {
       fprintf(stderr, "Cube ERROR (WordUnigrams::Create): error reading "
               "word unigram data.\n");
-      delete word_unigrams_obj;
-      return NULL;
+      return false;
     }
+    costs_buff_.push_back(cost);
     // update max cost
-    max_cost = MAX(max_cost, word_unigrams_obj->costs_[word_cnt]);
-    word_cnt++;
+    max_cost = MAX(max_cost, cost);
   }
-  word_unigrams_obj->word_cnt_ = word_cnt;
+  offsets_buff_.push_back(pool.length());
+  // the words are kept where the text of the file was
+  data_buff_.swap(pool);
+
+  word_cnt_ = word_cnt;
+  offsets_ = &offsets_buff_[0];
+  costs_ = &costs_buff_[0];
+  pool_ = data_buff_.data();
 
   // compute the not-in-list-cost by assuming that a word not in the list
   // [ahmadab]: This can be computed as follows:
@@ -120,10 +175,78 @@ WordUnigrams *WordUnigrams::Create(const string &data_file_path,
   //   (K * S) / (N ^ (S + 1)) ~= K / (N ^ 2)
   // - Given that cost = -LOG(prob), the cost of an unlisted word would be
   //   = max_cost + 2*LOG(N)
-  word_unigrams_obj->not_in_list_cost_ = max_cost +
-      (2 * CubeUtils::Prob2Cost(1.0 / word_cnt));
-  // success
-  return word_unigrams_obj;
+  not_in_list_cost_ = max_cost + (2 * CubeUtils::Prob2Cost(1.0 / word_cnt));
+  return true;
+}
+
+/**
+ * Point the word list at its binary form
+ */
+bool WordUnigrams::LoadBinary(const char *data, size_t size) {
+  const size_t kHeaderSize = 4 * sizeof(inT32);
+  if (size < kHeaderSize) {
+    return false;
+  }
+  const inT32 *header = reinterpret_cast<const inT32 *>(data);
+  if (static_cast<unsigned int>(header[0]) != kBinaryMagic) {
+    return false;
+  }
+  int word_cnt = header[1];
+  int pool_size = header[3];
+  if (word_cnt < 1 || pool_size < 0 ||
+      size != kHeaderSize + (2 * static_cast<size_t>(word_cnt) + 1) *
+                  sizeof(inT32) + pool_size) {
+    fprintf(stderr, "Cube ERROR (WordUnigrams::Create): invalid binary "
+            "word unigram data.\n");
+    return false;
+  }
+  const inT32 *offsets = header + 4;
+  if (offsets[0] != 0 || offsets[word_cnt] != pool_size) {
+    fprintf(stderr, "Cube ERROR (WordUnigrams::Create): invalid binary "
+            "word unigram data.\n");
+    return false;
+  }
+  word_cnt_ = word_cnt;
+  not_in_list_cost_ = header[2];
+  offsets_ = offsets;
+  costs_ = offsets + word_cnt + 1;
+  pool_ = reinterpret_cast<const char *>(costs_ + word_cnt);
+  return true;
+}
+
+/**
+ * Write the binary form of the word list
+ */
+bool WordUnigrams::Save(FILE *fp) const {
+  // order the words the way CostInternal searches them
+  vector<int> order(word_cnt_);
+  for (int wrd = 0; wrd < word_cnt_; wrd++) {
+    order[wrd] = wrd;
+  }
+  stable_sort(order.begin(), order.end(), WordOrder(pool_, offsets_));
+
+  inT32 header[4];
+  header[0] = kBinaryMagic;
+  header[1] = word_cnt_;
+  header[2] = not_in_list_cost_;
+  header[3] = offsets_[word_cnt_];
+  vector<inT32> offsets;
+  vector<inT32> costs;
+  string pool;
+  pool.reserve(header[3]);
+  for (int wrd = 0; wrd < word_cnt_; wrd++) {
+    offsets.push_back(pool.length());
+    costs.push_back(costs_[order[wrd]]);
+    pool.append(pool_ + offsets_[order[wrd]],
+                offsets_[order[wrd] + 1] - offsets_[order[wrd]]);
+  }
+  offsets.push_back(pool.length());
+
+  return fwrite(header, sizeof(header), 1, fp) == 1 &&
+      fwrite(&offsets[0], sizeof(offsets[0]), offsets.size(), fp) ==
+          offsets.size() &&
+      fwrite(&costs[0], sizeof(costs[0]), costs.size(), fp) == costs.size() &&
+      fwrite(pool.data(), 1, pool.length(), fp) == pool.length();
 }
 
 /**
@@ -225,16 +348,25 @@ int WordUnigrams::Cost(const char_32 *key_str32,
 }
 
 /**
- * Search for UTF-8 string using binary search of sorted words_ array.
+ * Compare a string to one of the words, as strcmp would
+ */
+int WordUnigrams::CompareWord(const char *str, int len, int idx) const {
+  return CompareStrings(str, len, pool_ + offsets_[idx],
+                        offsets_[idx + 1] - offsets_[idx]);
+}
+
+/**
+ * Search for UTF-8 string using binary search of the sorted words.
  */
 int WordUnigrams::CostInternal(const char *key_str) const {
-  if (strlen(key_str) == 0)
+  int key_len = strlen(key_str);
+  if (key_len == 0)
     return not_in_list_cost_;
   int hi = word_cnt_ - 1;
   int lo = 0;
   while (lo <= hi) {
     int current = (hi + lo) / 2;
-    int comp = strcmp(key_str, words_[current]);
+    int comp = CompareWord(key_str, key_len, current);
     // a match
     if (comp == 0) {
       return costs_[current];
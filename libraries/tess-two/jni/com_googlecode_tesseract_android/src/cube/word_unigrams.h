@@ -22,12 +22,23 @@
 // present, the unigram cost of a word is aggregated with the other costs
 // (Recognition, Language Model, Size) to compute a cost for a word.
 // The word list is assumed to be sorted in lexicographic order.
+// The <lang>.cube.word-freq file is either a text list of word/cost pairs
+// or the binary form written by Save, which is mapped into memory as is
+// rather than parsed. The binary form is laid out in host byte order as:
+//   uinT32 kBinaryMagic
+//   inT32 word count, inT32 not-in-list cost, inT32 string pool size
+//   inT32 offsets[word count + 1] of the words in the string pool
+//   inT32 costs[word count]
+//   char string pool: the sorted words, unterminated
 
 #ifndef WORD_UNIGRAMS_H
 #define WORD_UNIGRAMS_H
 
+#include <stdio.h>
 #include <string>
+#include <vector>
 #include "char_set.h"
+#include "host.h"
 #include "lang_model.h"
 
 namespace tesseract {
@@ -39,6 +50,9 @@ class WordUnigrams {
   // The word list is assumed to be sorted
   static WordUnigrams *Create(const string &data_file_path,
                               const string &lang);
+  // Writes the word list in its binary form, sorting it if needed.
+  // Returns false on error.
+  bool Save(FILE *fp) const;
   // Compute the unigram cost of a UTF-32 string. Splits into
   // space-separated tokens, strips trailing punctuation from each
   // token, evaluates case properties, and calls internal Cost()
@@ -52,17 +66,38 @@ class WordUnigrams {
            CharSet *char_set) const;
  protected:
   // Compute the word unigram cost of a UTF-8 string with binary
-  // search of sorted words_ array.
+  // search of the sorted word list.
   int CostInternal(const char *str) const;
  private:
   // Only words this length or greater qualify for all-numeric or
   // case-invariant word unigram cost.
   static const int kMinLengthNumOrCaseInvariant = 4;
+  // Marks a binary word-freq file.
+  static const unsigned int kBinaryMagic = 0x43574631;
+
+  // Parses the text form of the word list into the owned buffers.
+  bool LoadText(const string &str);
+  // Points the word list at the binary form held in data. Returns false
+  // if data does not hold a valid binary word list.
+  bool LoadBinary(const char *data, size_t size);
+  // Compares str, of the given length, to the word at index idx the way
+  // strcmp would.
+  int CompareWord(const char *str, int len, int idx) const;
 
   int word_cnt_;
-  char **words_;
-  int *costs_;
+  // offsets_[i] is the start of word i in pool_, which ends where
+  // word i + 1 starts
+  const inT32 *offsets_;
+  const inT32 *costs_;
+  const char *pool_;
   int not_in_list_cost_;
+  // storage of the word list when it is not mapped from its file
+  vector<inT32> offsets_buff_;
+  vector<inT32> costs_buff_;
+  string data_buff_;
+  // mapping of a binary word-freq file
+  const char *mapped_data_;
+  size_t mapped_size_;
 };
 }
 
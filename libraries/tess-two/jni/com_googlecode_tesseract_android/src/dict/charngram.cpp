@@ -0,0 +1,152 @@
+///////////////////////////////////////////////////////////////////////
+// File:        charngram.cpp
+// Description: Compiled table of character ngram probabilities.
+//
+// (C) Copyright 2017, Google Inc.
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+///////////////////////////////////////////////////////////////////////
+
+#include "charngram.h"
+
+#include <string.h>
+
+#include "helpers.h"
+#include "kdpair.h"
+#include "serialis.h"
+#include "unichar.h"
+
+namespace tesseract {
+
+// Version of the serialized table.
+const inT32 kCharNgramVersion = 1;
+// Largest order accepted, which bounds the context positions kept on the
+// stack by Probability.
+const int kMaxCharNgramOrder = 16;
+// Byte that separates the context from the character in HashNgram, which
+// can not occur in UTF-8.
+const unsigned char kNgramSeparator = 0xff;
+
+CharNgramTable::CharNgramTable()
+  : order_(0), backoff_(0.0f), unseen_prob_(0.0f) {}
+
+void CharNgramTable::Init(int order, float backoff, float unseen_prob) {
+  order_ = ClipToRange(order, 1, kMaxCharNgramOrder);
+  backoff_ = backoff;
+  unseen_prob_ = unseen_prob;
+  keys_.clear();
+  probs_.clear();
+}
+
+void CharNgramTable::Add(const char *context, const char *character,
+                         float prob) {
+  keys_.push_back(HashNgram(context, strlen(context),
+                            character, strlen(character)));
+  probs_.push_back(prob);
+}
+
+void CharNgramTable::Compile() {
+  GenericVector<KDPairInc<uinT64, float> > ngrams;
+  ngrams.reserve(keys_.size());
+  for (int i = 0; i < keys_.size(); ++i) {
+    ngrams.push_back(KDPairInc<uinT64, float>(keys_[i], probs_[i]));
+  }
+  ngrams.sort();
+  keys_.clear();
+  probs_.clear();
+  for (int i = 0; i < ngrams.size(); ++i) {
+    // An ngram added twice keeps the last probability given.
+    if (!keys_.empty() && keys_.back() == ngrams[i].key) {
+      probs_.back() = ngrams[i].data;
+    } else {
+      keys_.push_back(ngrams[i].key);
+      probs_.push_back(ngrams[i].data);
+    }
+  }
+}
+
+double CharNgramTable::Probability(const char *context, int context_bytes,
+                                   const char *character,
+                                   int character_bytes) const {
+  if (context_bytes < 0) context_bytes = strlen(context);
+  // Start of each of the last order_ - 1 characters of the context, oldest
+  // first, in a ring.
+  int starts[kMaxCharNgramOrder];
+  int max_context = order_ - 1;
+  int num_starts = 0;
+  for (int pos = 0; pos < context_bytes;) {
+    starts[num_starts % kMaxCharNgramOrder] = pos;
+    ++num_starts;
+    int step = UNICHAR::utf8_step(context + pos);
+    pos += step > 0 ? step : 1;
+  }
+  int num_chars = MIN(num_starts, max_context);
+  double scale = 1.0;
+  for (int n = num_chars; n >= 0; --n) {
+    int start = n == 0 ? context_bytes
+                       : starts[(num_starts - n) % kMaxCharNgramOrder];
+    uinT64 key = HashNgram(context + start, context_bytes - start,
+                           character, character_bytes);
+    int index = keys_.binary_search(key);
+    if (index < keys_.size() && keys_[index] == key)
+      return probs_[index] * scale;
+    scale *= backoff_;
+  }
+  return unseen_prob_;
+}
+
+// FNV-1a.
+uinT64 CharNgramTable::HashNgram(const char *context, int context_bytes,
+                                 const char *character, int character_bytes) {
+  uinT64 hash = 14695981039346656037ULL;
+  for (int i = 0; i < context_bytes; ++i) {
+    hash ^= static_cast<unsigned char>(context[i]);
+    hash *= 1099511628211ULL;
+  }
+  hash ^= kNgramSeparator;
+  hash *= 1099511628211ULL;
+  for (int i = 0; i < character_bytes; ++i) {
+    hash ^= static_cast<unsigned char>(character[i]);
+    hash *= 1099511628211ULL;
+  }
+  return hash;
+}
+
+bool CharNgramTable::Serialize(FILE *fp) const {
+  if (fwrite(&kCharNgramVersion, sizeof(kCharNgramVersion), 1, fp) != 1)
+    return false;
+  if (fwrite(&order_, sizeof(order_), 1, fp) != 1) return false;
+  if (fwrite(&backoff_, sizeof(backoff_), 1, fp) != 1) return false;
+  if (fwrite(&unseen_prob_, sizeof(unseen_prob_), 1, fp) != 1) return false;
+  if (!keys_.Serialize(fp)) return false;
+  if (!probs_.Serialize(fp)) return false;
+  return true;
+}
+
+bool CharNgramTable::DeSerialize(bool swap, TFile *fp) {
+  inT32 version;
+  if (fp->FRead(&version, sizeof(version), 1) != 1) return false;
+  if (fp->FRead(&order_, sizeof(order_), 1) != 1) return false;
+  if (fp->FRead(&backoff_, sizeof(backoff_), 1) != 1) return false;
+  if (fp->FRead(&unseen_prob_, sizeof(unseen_prob_), 1) != 1) return false;
+  if (swap) {
+    ReverseN(&version, sizeof(version));
+    ReverseN(&order_, sizeof(order_));
+    ReverseN(&backoff_, sizeof(backoff_));
+    ReverseN(&unseen_prob_, sizeof(unseen_prob_));
+  }
+  if (version != kCharNgramVersion) return false;
+  if (order_ < 1 || order_ > kMaxCharNgramOrder) return false;
+  if (!keys_.DeSerialize(swap, fp)) return false;
+  if (!probs_.DeSerialize(swap, fp)) return false;
+  return keys_.size() == probs_.size();
+}
+
+}  // namespace tesseract
@@ -0,0 +1,85 @@
+///////////////////////////////////////////////////////////////////////
+// File:        charngram.h
+// Description: Compiled table of character ngram probabilities.
+//
+// (C) Copyright 2017, Google Inc.
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+///////////////////////////////////////////////////////////////////////
+
+#ifndef TESSERACT_DICT_CHARNGRAM_H_
+#define TESSERACT_DICT_CHARNGRAM_H_
+
+#include <stdio.h>
+
+#include "genericvector.h"
+#include "host.h"
+
+namespace tesseract {
+
+class TFile;
+
+// Gives p(character | context) for the character ngram model of the
+// LanguageModel from a table compiled ahead of time, as the tessdata
+// component TESSDATA_CHAR_NGRAM or a buffer given by the embedder.
+// Each ngram, a context of up to order - 1 UTF-8 characters followed by one
+// character, is stored only as a 64 bit hash, in a sorted vector next to its
+// probability, so a lookup is a binary search per context length tried.
+// Contexts missing from the table back off to shorter ones, each step
+// multiplying the probability by the backoff factor ("stupid backoff"), down
+// to the probability of an unseen character.
+class CharNgramTable {
+ public:
+  CharNgramTable();
+
+  // Sets up an empty table for Add, with the given maximum ngram order,
+  // backoff factor and probability of a character seen in no context.
+  void Init(int order, float backoff, float unseen_prob);
+  // Adds p(character | context), where context holds at most order - 1
+  // UTF-8 characters. Call Compile after the last Add.
+  void Add(const char *context, const char *character, float prob);
+  // Sorts the ngrams added, ready for Probability and Serialize.
+  void Compile();
+
+  // Returns p(character | context), of which only the last order - 1
+  // characters are used. context_bytes may be -1 if context is
+  // NUL-terminated. Has the signature of Dict::probability_in_context_.
+  double Probability(const char *context, int context_bytes,
+                     const char *character, int character_bytes) const;
+
+  // Hash of the ngram made of the given context and character bytes.
+  static uinT64 HashNgram(const char *context, int context_bytes,
+                          const char *character, int character_bytes);
+
+  // Writes to the given file. Returns false on error.
+  bool Serialize(FILE *fp) const;
+  // Reads from the given file. Returns false on error.
+  // If swap is true, assumes a big/little-endian swap is needed.
+  bool DeSerialize(bool swap, TFile *fp);
+
+  int order() const { return order_; }
+  int size() const { return keys_.size(); }
+
+ private:
+  // Maximum number of characters in an ngram, the predicted one included.
+  inT32 order_;
+  // Multiplier of the probability for each character dropped from the
+  // context.
+  float backoff_;
+  // Probability of a character found in no context.
+  float unseen_prob_;
+  // Sorted hashes of the ngrams and their probabilities.
+  GenericVector<uinT64> keys_;
+  GenericVector<float> probs_;
+};
+
+}  // namespace tesseract
+
+#endif  // TESSERACT_DICT_CHARNGRAM_H_
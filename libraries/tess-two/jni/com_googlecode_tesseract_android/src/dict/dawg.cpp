@@ -32,11 +32,19 @@
 #endif
 #include "dawg.h"
 
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
 #include "cutil.h"
+#include "dawgindex.h"
+#include "dawgsimd.h"
 #include "dict.h"
 #include "emalloc.h"
 #include "freelist.h"
 #include "helpers.h"
+#include "simddetect.h"
 #include "strngs.h"
 #include "tesscallback.h"
 #include "tprintf.h"
@@ -197,28 +205,40 @@ void Dawg::init(DawgType type, const STRING &lang,
          F u n c t i o n s   f o r   S q u i s h e d    D a w g
 ----------------------------------------------------------------------*/
 
-SquishedDawg::~SquishedDawg() { memfree(edges_); }
+SquishedDawg::~SquishedDawg() {
+  delete word_index_;
+#ifndef _WIN32
+  if (mapped_region_ != NULL) {
+    munmap(mapped_region_, mapped_size_);
+    return;
+  }
+#endif
+  memfree(edges_);
+}
+
+// Nodes with at least this many children get a direct table, if the table
+// has no more than kMaxDirectEntriesPerEdge entries per child.
+const int kMinDirectFanOut = 16;
+const int kMaxDirectEntriesPerEdge = 16;
+// Key of the edge_keys_ padding, which matches no letter.
+const uinT32 kNoEdgeKey = 0xffffffff;
+
+// Returns the fastest kernel that searches the compiled edge keys, or NULL
+// if there is none and the scalar loop must be used.
+static EdgeKeySearchFunc BestEdgeKeyKernel() {
+  if (SIMDDetect::IsSSE2Available()) return FindEdgeKeySSE2;
+  if (SIMDDetect::IsNEONAvailable()) return FindEdgeKeyNEON;
+  return NULL;
+}
 
 EDGE_REF SquishedDawg::edge_char_of(NODE_REF node,
                                     UNICHAR_ID unichar_id,
                                     bool word_end) const {
+  if (!edge_keys_.empty())
+    return compiled_edge_char_of(node, unichar_id, word_end);
   EDGE_REF edge = node;
   if (node == 0) {  // binary search
-    EDGE_REF start = 0;
-    EDGE_REF end = num_forward_edges_in_node0 - 1;
-    int compare;
-    while (start <= end) {
-      edge = (start + end) >> 1;  // (start + end) / 2
-      compare = given_greater_than_edge_rec(NO_EDGE, word_end,
-                                            unichar_id, edges_[edge]);
-      if (compare == 0) {  // given == vec[k]
-        return edge;
-      } else if (compare == 1) {  // given > vec[k]
-        start = edge + 1;
-      } else {  // given < vec[k]
-        end = edge - 1;
-      }
-    }
+    return binary_search_node0(unichar_id, word_end);
   } else {  // linear search
     if (edge != NO_EDGE && edge_occupied(edge)) {
       do {
@@ -231,6 +251,131 @@ EDGE_REF SquishedDawg::edge_char_of(NODE_REF node,
   return (NO_EDGE);  // not found
 }
 
+EDGE_REF SquishedDawg::binary_search_node0(UNICHAR_ID unichar_id,
+                                           bool word_end) const {
+  EDGE_REF start = 0;
+  EDGE_REF end = num_forward_edges_in_node0 - 1;
+  int compare;
+  while (start <= end) {
+    EDGE_REF edge = (start + end) >> 1;  // (start + end) / 2
+    compare = given_greater_than_edge_rec(NO_EDGE, word_end,
+                                          unichar_id, edges_[edge]);
+    if (compare == 0) {  // given == vec[k]
+      return edge;
+    } else if (compare == 1) {  // given > vec[k]
+      start = edge + 1;
+    } else {  // given < vec[k]
+      end = edge - 1;
+    }
+  }
+  return (NO_EDGE);  // not found
+}
+
+EDGE_REF SquishedDawg::compiled_edge_char_of(NODE_REF node,
+                                             UNICHAR_ID unichar_id,
+                                             bool word_end) const {
+  // No edge has a negative letter, and the keys can not represent one.
+  if (node == NO_EDGE || unichar_id < 0) return NO_EDGE;
+  EDGE_REF start = node;
+  int run = edge_runs_[node];
+  if (run < 0) {
+    const inT32 *table = &direct_edges_[-1 - run];
+    if (unichar_id > unicharset_size_) return NO_EDGE;
+    inT32 offset = table[1 + unichar_id];
+    if (offset < 0) return NO_EDGE;
+    EDGE_REF edge = node + offset;
+    if (!word_end || (edge_keys_[edge] & 1) != 0) return edge;
+    // Node 0 only has a table if its letters are unique, so as not to
+    // differ from the binary search.
+    if (node == 0) return NO_EDGE;
+    // Look for a later edge with the same letter that ends a word.
+    start = edge + 1;
+    run = table[0] - offset - 1;
+  } else if (node == 0) {
+    return binary_search_node0(unichar_id, word_end);
+  }
+  uinT32 mask = word_end ? kNoEdgeKey : ~1u;
+  uinT32 target = (static_cast<uinT32>(unichar_id) << 1) | (word_end ? 1 : 0);
+  const uinT32 *keys = &edge_keys_[start];
+  int index;
+  if (edge_key_kernel_ == NULL ||
+      !edge_key_kernel_(keys, run, mask, target, &index)) {
+    for (index = 0; index < run && (keys[index] & mask) != target; ++index);
+    if (index == run) index = -1;
+  }
+  return index < 0 ? NO_EDGE : start + index;
+}
+
+void SquishedDawg::CompileLookup() {
+  if (!edge_keys_.empty()) return;
+  edge_keys_.reserve(num_edges_ + kDawgEdgeKeyPadding);
+  for (EDGE_REF edge = 0; edge < num_edges_; ++edge) {
+    edge_keys_.push_back(
+        (static_cast<uinT32>(unichar_id_from_edge_rec(edges_[edge])) << 1) |
+        (end_of_word_from_edge_rec(edges_[edge]) ? 1 : 0));
+  }
+  for (int i = 0; i < kDawgEdgeKeyPadding; ++i) edge_keys_.push_back(kNoEdgeKey);
+  // Count the edges left in each node from the back.
+  edge_runs_.init_to_size(num_edges_, 0);
+  int run = 0;
+  for (EDGE_REF edge = num_edges_ - 1; edge >= 0; --edge) {
+    run = last_edge(edge) ? 1 : run + 1;
+    edge_runs_[edge] = edge_occupied(edge) ? run : 0;
+  }
+  // Add tables for the nodes with many children, which start at 0 and after
+  // each last edge.
+  int num_tables = 0;
+  GenericVector<inT32> table;
+  for (EDGE_REF node = 0; node < num_edges_; node += MAX(run, 1)) {
+    run = edge_runs_[node];
+    if (node == 0) {
+      // Node 0 is searched with a binary search over its forward edges.
+      if (num_forward_edges_in_node0 != run) continue;
+    } else if (run < kMinDirectFanOut ||
+               unicharset_size_ + 1 > run * kMaxDirectEntriesPerEdge) {
+      continue;
+    }
+    table.init_to_size(unicharset_size_ + 2, -1);
+    table[0] = run;
+    bool usable = true;
+    bool unique = true;
+    // Going backwards leaves the first edge with each letter in the table.
+    for (int offset = run - 1; offset >= 0 && usable; --offset) {
+      int entry = 1 + (edge_keys_[node + offset] >> 1);
+      if (entry >= table.size()) {
+        usable = false;
+      } else {
+        if (table[entry] >= 0) unique = false;
+        table[entry] = offset;
+      }
+    }
+    if (!usable || (node == 0 && !unique)) continue;
+    edge_runs_[node] = -1 - direct_edges_.size();
+    direct_edges_ += table;
+    ++num_tables;
+  }
+  edge_key_kernel_ = BestEdgeKeyKernel();
+  if (debug_level_) {
+    tprintf("Compiled dawg lookup for %d edges with %d direct tables\n",
+            num_edges_, num_tables);
+  }
+}
+
+void SquishedDawg::BuildWordIndex() {
+  if (word_index_ != NULL) return;
+  DawgWordIndex *index = new DawgWordIndex;
+  if (!index->Build(*this)) {
+    if (debug_level_) tprintf("Failed to index the words of the dawg\n");
+    delete index;
+    return;
+  }
+  word_index_ = index;
+  if (debug_level_) {
+    tprintf("Indexed %d dawg words in %d bytes\n", index->num_words(),
+            index->MemoryUsed());
+  }
+}
+
 inT32 SquishedDawg::num_forward_edges(NODE_REF node) const {
   EDGE_REF   edge = node;
   inT32        num  = 0;
@@ -244,6 +389,17 @@ inT32 SquishedDawg::num_forward_edges(NODE_REF node) const {
   return (num);
 }
 
+int SquishedDawg::MemoryUsed() const {
+  int bytes = 0;
+  if (mapped_region_ == NULL) bytes += num_edges_ * sizeof(EDGE_RECORD);
+  bytes += edge_keys_.size_reserved() * sizeof(edge_keys_[0]);
+  bytes += edge_runs_.size_reserved() * sizeof(edge_runs_[0]);
+  bytes += direct_edges_.size_reserved() * sizeof(direct_edges_[0]);
+  if (word_index_ != NULL)
+    bytes += sizeof(*word_index_) + word_index_->MemoryUsed();
+  return bytes;
+}
+
 void SquishedDawg::print_node(NODE_REF node, int max_num_edges) const {
   if (node == NO_EDGE) return;  // nothing to print
 
@@ -319,7 +475,8 @@ void SquishedDawg::read_squished_dawg(FILE *file,
                                       DawgType type,
                                       const STRING &lang,
                                       PermuterType perm,
-                                      int debug_level) {
+                                      int debug_level,
+                                      bool map_edges) {
   if (debug_level) tprintf("Reading squished dawg\n");
 
   // Read the magic number and if it does not match kDawgMagicNumber
@@ -339,9 +496,14 @@ void SquishedDawg::read_squished_dawg(FILE *file,
   ASSERT_HOST(num_edges_ > 0);  // DAWG should not be empty
   Dawg::init(type, lang, perm, unicharset_size, debug_level);
 
+  EDGE_REF edge;
+  // Swapped edges have to be rewritten, so they can not be mapped.
+  if (map_edges && !swap && map_squished_edges(file)) {
+    if (debug_level) tprintf("Mapped %d dawg edges in place\n", num_edges_);
+    return;
+  }
   edges_ = (EDGE_ARRAY) memalloc(sizeof(EDGE_RECORD) * num_edges_);
   fread(&edges_[0], sizeof(EDGE_RECORD), num_edges_, file);
-  EDGE_REF edge;
   if (swap) {
     for (edge = 0; edge < num_edges_; ++edge) {
       ReverseN(&edges_[edge], sizeof(edges_[edge]));
@@ -355,6 +517,36 @@ void SquishedDawg::read_squished_dawg(FILE *file,
   }
 }
 
+bool SquishedDawg::map_squished_edges(FILE *file) {
+#ifdef _WIN32
+  return false;
+#else
+  long offset = ftell(file);
+  if (offset < 0) return false;
+#if !defined(__i386__) && !defined(__x86_64__) && !defined(__aarch64__)
+  // Other targets (notably 32-bit ARM) may fault on unaligned 64-bit loads.
+  if (offset % sizeof(EDGE_RECORD) != 0) return false;
+#endif
+  long page_size = sysconf(_SC_PAGESIZE);
+  if (page_size <= 0) return false;
+  off_t region_start = offset - offset % page_size;
+  size_t edge_bytes = sizeof(EDGE_RECORD) * num_edges_;
+  size_t region_size = offset - region_start + edge_bytes;
+  void *region = mmap(NULL, region_size, PROT_READ, MAP_SHARED, fileno(file),
+                      region_start);
+  if (region == MAP_FAILED) return false;
+  if (fseek(file, offset + edge_bytes, SEEK_SET) != 0) {
+    munmap(region, region_size);
+    return false;
+  }
+  mapped_region_ = region;
+  mapped_size_ = region_size;
+  edges_ = reinterpret_cast<EDGE_ARRAY>(static_cast<char *>(region) +
+                                        (offset - region_start));
+  return true;
+#endif
+}
+
 NODE_MAP SquishedDawg::build_node_map(inT32 *num_nodes) const {
   EDGE_REF   edge;
   NODE_MAP   node_map;
@@ -418,11 +610,11 @@ void SquishedDawg::write_squished_dawg(FILE *file) {
   for (edge = 0; edge < num_edges_; edge++) {
     if (forward_edge(edge)) {  // write forward edges
       do {
-        old_index = next_node_from_edge_rec(edges_[edge]);
-        set_next_node(edge, node_map[old_index]);
+        // Renumber a copy, as edges_ may be a read-only mapping.
         temp_record = edges_[edge];
+        old_index = next_node_from_edge_rec(temp_record);
+        set_next_node_in_edge_rec(&temp_record, node_map[old_index]);
         fwrite(&(temp_record), sizeof(EDGE_RECORD), 1, file);
-        set_next_node(edge, old_index);
       } while (!last_edge(edge++));
 
       if (edge >= num_edges_) break;
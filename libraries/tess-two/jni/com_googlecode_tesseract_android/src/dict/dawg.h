@@ -57,6 +57,8 @@ typedef EDGE_REF *NODE_MAP;
 
 namespace tesseract {
 
+class DawgWordIndex;
+
 struct NodeChild {
   UNICHAR_ID unichar_id;
   EDGE_REF edge_ref;
@@ -133,6 +135,10 @@ class Dawg {
   /// Returns true if the given word is in the Dawg.
   bool word_in_dawg(const WERD_CHOICE &word) const;
 
+  /// Returns the index of the whole words of the Dawg, or NULL if it has
+  /// none, in which case words must be looked up edge by edge.
+  virtual const DawgWordIndex *word_index() const { return NULL; }
+
   // Returns true if the given word prefix is not contraindicated by the dawg.
   // If requires_complete is true, then the exact complete word must be present.
   bool prefix_in_dawg(const WERD_CHOICE &prefix, bool requires_complete) const;
@@ -179,6 +185,9 @@ class Dawg {
   /// At most max_num_edges will be printed.
   virtual void print_node(NODE_REF node, int max_num_edges) const = 0;
 
+  /// Returns the number of bytes of heap used by the Dawg.
+  virtual int MemoryUsed() const = 0;
+
   /// Fills vec with unichar ids that represent the character classes
   /// of the given unichar_id.
   virtual void unichar_id_to_patterns(UNICHAR_ID unichar_id,
@@ -407,26 +416,34 @@ class DawgPositionVector : public GenericVector<DawgPosition> {
 //
 class SquishedDawg : public Dawg {
  public:
+  /// If map_edges is true, the edge array is used in place from a read-only
+  /// mapping of file where possible, instead of being copied to the heap.
   SquishedDawg(FILE *file, DawgType type, const STRING &lang,
-               PermuterType perm, int debug_level) {
-    read_squished_dawg(file, type, lang, perm, debug_level);
+               PermuterType perm, int debug_level, bool map_edges = false)
+    : mapped_region_(NULL), mapped_size_(0), edge_key_kernel_(NULL),
+      word_index_(NULL) {
+    read_squished_dawg(file, type, lang, perm, debug_level, map_edges);
     num_forward_edges_in_node0 = num_forward_edges(0);
   }
   SquishedDawg(const char* filename, DawgType type,
-               const STRING &lang, PermuterType perm, int debug_level) {
+               const STRING &lang, PermuterType perm, int debug_level)
+    : mapped_region_(NULL), mapped_size_(0), edge_key_kernel_(NULL),
+      word_index_(NULL) {
     FILE *file = fopen(filename, "rb");
     if (file == NULL) {
       tprintf("Failed to open dawg file %s\n", filename);
       exit(1);
     }
-    read_squished_dawg(file, type, lang, perm, debug_level);
+    read_squished_dawg(file, type, lang, perm, debug_level, false);
     num_forward_edges_in_node0 = num_forward_edges(0);
     fclose(file);
   }
   SquishedDawg(EDGE_ARRAY edges, int num_edges, DawgType type,
                const STRING &lang, PermuterType perm,
                int unicharset_size, int debug_level) :
-    edges_(edges), num_edges_(num_edges) {
+    edges_(edges), num_edges_(num_edges),
+    mapped_region_(NULL), mapped_size_(0), edge_key_kernel_(NULL),
+    word_index_(NULL) {
     init(type, lang, perm, unicharset_size, debug_level);
     num_forward_edges_in_node0 = num_forward_edges(0);
     if (debug_level > 3) print_all("SquishedDawg:");
@@ -435,6 +452,20 @@ class SquishedDawg : public Dawg {
 
   int NumEdges() { return num_edges_; }
 
+  /// Builds the lookup tables that edge_char_of uses from then on instead of
+  /// the edge records: the letters and end of word flags of the edges in a
+  /// contiguous array that is searched a vector at a time, and a table
+  /// indexed by unichar id for each node with many children. The edges are
+  /// left as they are, so that the dawg is written out as before.
+  /// Call before the dawg is shared, as it is not thread-safe.
+  void CompileLookup();
+  bool lookup_compiled() const { return !edge_keys_.empty(); }
+
+  /// Builds the index of the whole words of the dawg that word_index
+  /// returns from then on. Like CompileLookup, call before sharing the dawg.
+  void BuildWordIndex();
+  const DawgWordIndex *word_index() const { return word_index_; }
+
   /// Returns the edge that corresponds to the letter out of this node.
   EDGE_REF edge_char_of(NODE_REF node, UNICHAR_ID unichar_id,
                         bool word_end) const;
@@ -474,6 +505,11 @@ class SquishedDawg : public Dawg {
   /// At most max_num_edges will be printed.
   void print_node(NODE_REF node, int max_num_edges) const;
 
+  /// Returns the number of bytes of heap used by the Dawg. Edges used in
+  /// place from a file mapping are not counted, as they are not heap and
+  /// the system can drop them from memory at any time.
+  int MemoryUsed() const;
+
   /// Writes the squished/reduced Dawg to a file.
   void write_squished_dawg(FILE *file);
 
@@ -528,9 +564,20 @@ class SquishedDawg : public Dawg {
   /// Counts and returns the number of forward edges in this node.
   inT32 num_forward_edges(NODE_REF node) const;
 
+  /// edge_char_of for node 0 without a direct table, a binary search of the
+  /// edge records.
+  EDGE_REF binary_search_node0(UNICHAR_ID unichar_id, bool word_end) const;
+  /// edge_char_of once CompileLookup has been called.
+  EDGE_REF compiled_edge_char_of(NODE_REF node, UNICHAR_ID unichar_id,
+                                 bool word_end) const;
+
   /// Reads SquishedDawg from a file.
   void read_squished_dawg(FILE *file, DawgType type, const STRING &lang,
-                          PermuterType perm, int debug_level);
+                          PermuterType perm, int debug_level, bool map_edges);
+  /// Points edges_ at a read-only mapping of the num_edges_ records at the
+  /// current position of file, and skips the file past them.
+  /// Returns false if the edges can not be used in place.
+  bool map_squished_edges(FILE *file);
 
   /// Prints the contents of an edge indicated by the given EDGE_REF.
   void print_edge(EDGE_REF edge) const;
@@ -549,6 +596,29 @@ class SquishedDawg : public Dawg {
   EDGE_ARRAY edges_;
   int num_edges_;
   int num_forward_edges_in_node0;
+  // If not NULL, edges_ points into this read-only file mapping, which is
+  // owned by the dawg, instead of to heap memory.
+  void *mapped_region_;
+  size_t mapped_size_;
+  // The tables built by CompileLookup, empty until then.
+  // edge_keys_[e] is the unichar id of edge e shifted up by one, with the
+  // end of word flag in the low bit, followed by keys that match nothing to
+  // pad the array for the vector kernels.
+  GenericVector<uinT32> edge_keys_;
+  // edge_runs_[e] is the number of edges from e to the last edge of its
+  // node, 0 if e is empty, or, if e starts a node with a direct table,
+  // -1 - the index of the table in direct_edges_.
+  GenericVector<inT32> edge_runs_;
+  // Each direct table is the number of edges in its node followed, for
+  // each unichar id, by the offset from the start of the node of the first
+  // edge with that letter, or -1.
+  GenericVector<inT32> direct_edges_;
+  // One of the kernels in dawgsimd.h, or NULL to search edge_keys_ with the
+  // scalar loop.
+  bool (*edge_key_kernel_)(const uinT32* keys, int count, uinT32 mask,
+                           uinT32 target, int* index);
+  // Owned index of the whole words, built by BuildWordIndex, or NULL.
+  DawgWordIndex *word_index_;
 };
 
 }  // namespace tesseract
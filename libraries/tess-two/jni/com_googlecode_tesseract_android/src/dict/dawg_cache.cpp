@@ -30,11 +30,17 @@ struct DawgLoader {
   DawgLoader(const STRING &lang,
              const char *data_file_name,
              TessdataType tessdata_dawg_type,
-             int dawg_debug_level)
+             int dawg_debug_level,
+             bool map_edges,
+             bool compile_lookup,
+             bool index_words)
       : lang_(lang),
         data_file_name_(data_file_name),
         tessdata_dawg_type_(tessdata_dawg_type),
-        dawg_debug_level_(dawg_debug_level) {}
+        dawg_debug_level_(dawg_debug_level),
+        map_edges_(map_edges),
+        compile_lookup_(compile_lookup),
+        index_words_(index_words) {}
 
   Dawg *Load();
 
@@ -42,19 +48,55 @@ struct DawgLoader {
   const char *data_file_name_;
   TessdataType tessdata_dawg_type_;
   int dawg_debug_level_;
+  bool map_edges_;
+  bool compile_lookup_;
+  bool index_words_;
 };
 
 Dawg *DawgCache::GetSquishedDawg(
     const STRING &lang,
     const char *data_file_name,
     TessdataType tessdata_dawg_type,
-    int debug_level) {
+    int debug_level,
+    bool map_edges,
+    bool compile_lookup,
+    bool index_words) {
   STRING data_id = data_file_name;
   data_id += kTessdataFileSuffixes[tessdata_dawg_type];
-  DawgLoader loader(lang, data_file_name, tessdata_dawg_type, debug_level);
+  DawgLoader loader(lang, data_file_name, tessdata_dawg_type, debug_level,
+                    map_edges, compile_lookup, index_words);
   return dawgs_.Get(data_id, NewTessCallback(&loader, &DawgLoader::Load));
 }
 
+int DawgCache::PreloadDawgs(const STRING &lang, const char *data_file_name,
+                            int debug_level, bool map_edges,
+                            bool compile_lookup, bool index_words) {
+  static const TessdataType kDawgTypes[] = {
+    TESSDATA_PUNC_DAWG, TESSDATA_SYSTEM_DAWG, TESSDATA_NUMBER_DAWG,
+    TESSDATA_BIGRAM_DAWG, TESSDATA_FREQ_DAWG, TESSDATA_UNAMBIG_DAWG
+  };
+  const int kNumDawgTypes = sizeof(kDawgTypes) / sizeof(kDawgTypes[0]);
+  int num_loaded = 0;
+  for (int i = 0; i < kNumDawgTypes; ++i) {
+    Dawg *dawg = GetSquishedDawg(lang, data_file_name, kDawgTypes[i],
+                                 debug_level, map_edges, compile_lookup,
+                                 index_words);
+    if (dawg == NULL) continue;
+    ++num_loaded;
+    preloaded_mu_.Lock();
+    preloaded_.push_back(dawg);
+    preloaded_mu_.Unlock();
+  }
+  return num_loaded;
+}
+
+void DawgCache::ReleasePreloadedDawgs() {
+  preloaded_mu_.Lock();
+  for (int i = 0; i < preloaded_.size(); ++i) FreeDawg(preloaded_[i]);
+  preloaded_.clear();
+  preloaded_mu_.Unlock();
+}
+
 Dawg *DawgLoader::Load() {
   TessdataManager data_loader;
   if (!data_loader.Init(data_file_name_, dawg_debug_level_)) {
@@ -97,7 +139,15 @@ Dawg *DawgLoader::Load() {
       return NULL;
   }
   SquishedDawg *retval =
-      new SquishedDawg(fp, dawg_type, lang_, perm_type, dawg_debug_level_);
+      new SquishedDawg(fp, dawg_type, lang_, perm_type, dawg_debug_level_,
+                       map_edges_);
+  if (compile_lookup_) retval->CompileLookup();
+  // Only whole words of the word dawgs are looked up; the bigram dawg is
+  // walked a word at a time.
+  if (index_words_ && dawg_type == DAWG_TYPE_WORD &&
+      tessdata_dawg_type_ != TESSDATA_BIGRAM_DAWG) {
+    retval->BuildWordIndex();
+  }
   data_loader.End();
   return retval;
 }
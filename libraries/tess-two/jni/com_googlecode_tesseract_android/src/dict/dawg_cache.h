@@ -29,11 +29,17 @@ namespace tesseract {
 
 class DawgCache {
  public:
+  DawgCache() {}
+  ~DawgCache() { ReleasePreloadedDawgs(); }
+
   Dawg *GetSquishedDawg(
       const STRING &lang,
       const char *data_file_name,
       TessdataType tessdata_dawg_type,
-      int debug_level);
+      int debug_level,
+      bool map_edges = false,
+      bool compile_lookup = false,
+      bool index_words = false);
 
   // If we manage the given dawg, decrement its count,
   // and possibly delete it if the count reaches zero.
@@ -47,8 +53,25 @@ class DawgCache {
     dawgs_.DeleteUnusedObjects();
   }
 
+  // Loads every dawg in data_file_name into the cache, the way Dict::Load
+  // asks for them, and keeps a reference to each until
+  // ReleasePreloadedDawgs(), so that a later Dict::Load of the same
+  // language finds them already loaded. Safe to call from a background
+  // thread while other threads use the cache. Returns the number of dawgs
+  // that were found.
+  int PreloadDawgs(const STRING &lang, const char *data_file_name,
+                   int debug_level, bool map_edges, bool compile_lookup,
+                   bool index_words);
+
+  // Drops the references taken by PreloadDawgs. The dawgs stay in the
+  // cache while any Dict still uses them.
+  void ReleasePreloadedDawgs();
+
  private:
   ObjectCache<Dawg> dawgs_;
+  // References held by PreloadDawgs.
+  CCUtilMutex preloaded_mu_;
+  GenericVector<Dawg *> preloaded_;
 };
 
 }  // namespace tesseract
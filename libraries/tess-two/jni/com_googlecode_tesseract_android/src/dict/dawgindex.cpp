@@ -0,0 +1,169 @@
+///////////////////////////////////////////////////////////////////////
+// File:        dawgindex.cpp
+// Description: Perfect hash index of the whole words of a dawg.
+//
+// (C) Copyright 2017, Google Inc.
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+///////////////////////////////////////////////////////////////////////
+
+#include "dawgindex.h"
+
+#include "dawg.h"
+
+namespace tesseract {
+
+// Average number of words per bucket. Fewer words per bucket make the
+// perfect hash quicker to find but the seeds bigger.
+const int kWordsPerBucket = 4;
+// Number of slots per empty slot in the table.
+const int kSlotsPerEmptySlot = 16;
+// Number of seeds to try for a bucket before giving up.
+const uinT32 kMaxSeed = 1 << 20;
+
+// The finalizer of MurmurHash3, which spreads every bit of value over all
+// the bits of the result.
+static inline uinT64 Mix64(uinT64 value) {
+  value ^= value >> 33;
+  value *= 0xff51afd7ed558ccdULL;
+  value ^= value >> 33;
+  value *= 0xc4ceb9fe1a85ec53ULL;
+  value ^= value >> 33;
+  return value;
+}
+
+// Returns true if the length unichar ids starting at word are a word of
+// dawg, following its edges as Dawg::prefix_in_dawg does.
+static bool WalkWord(const Dawg &dawg, const UNICHAR_ID *word, int length) {
+  NODE_REF node = 0;
+  for (int i = 0; i < length; ++i) {
+    bool word_end = i == length - 1;
+    EDGE_REF edge = dawg.edge_char_of(node, word[i], word_end);
+    if (edge == NO_EDGE) return false;
+    if (word_end) return true;
+    if ((node = dawg.next_node(edge)) == 0) return false;
+  }
+  return false;
+}
+
+// Adds the hashes of all the words of dawg under node, which follow word,
+// to hashes. Only the words that the edge lookups of the dawg find are
+// added, in case of a dawg with more than one edge for a letter.
+static void AddWordHashes(const Dawg &dawg, NODE_REF node,
+                          GenericVector<UNICHAR_ID> *word,
+                          GenericVector<uinT64> *hashes) {
+  NodeChildVector children;
+  dawg.unichar_ids_of(node, &children, false);
+  for (int c = 0; c < children.size(); ++c) {
+    word->push_back(children[c].unichar_id);
+    if (dawg.end_of_word(children[c].edge_ref) &&
+        WalkWord(dawg, &(*word)[0], word->size())) {
+      hashes->push_back(DawgWordIndex::HashWord(&(*word)[0], word->size()));
+    }
+    NODE_REF next = dawg.next_node(children[c].edge_ref);
+    if (next != 0) AddWordHashes(dawg, next, word, hashes);
+    word->truncate(word->size() - 1);
+  }
+}
+
+bool DawgWordIndex::Build(const Dawg &dawg) {
+  num_words_ = 0;
+  seeds_.clear();
+  fingerprints_.clear();
+  GenericVector<uinT64> hashes;
+  GenericVector<UNICHAR_ID> word;
+  AddWordHashes(dawg, 0, &word, &hashes);
+  // Words found on more than one path only need placing once. (Different
+  // words with the same hash are also harmless, as both are in the dawg.)
+  hashes.sort();
+  int num_hashes = 0;
+  for (int h = 0; h < hashes.size(); ++h) {
+    if (h == 0 || hashes[h] != hashes[h - 1]) hashes[num_hashes++] = hashes[h];
+  }
+  hashes.truncate(num_hashes);
+  if (hashes.empty()) return false;
+
+  int num_buckets = num_hashes / kWordsPerBucket + 1;
+  int num_slots = num_hashes + num_hashes / kSlotsPerEmptySlot + 1;
+  seeds_.init_to_size(num_buckets, 0);
+  // Sort the words by bucket, and the buckets by decreasing size, so that
+  // the biggest buckets are placed while the table is still empty.
+  GenericVector<int> bucket_starts;
+  bucket_starts.init_to_size(num_buckets + 1, 0);
+  for (int h = 0; h < num_hashes; ++h) ++bucket_starts[Bucket(hashes[h]) + 1];
+  GenericVector<inT64> buckets_by_size;
+  for (int b = 0; b < num_buckets; ++b) {
+    int size = bucket_starts[b + 1];
+    if (size > 0) {
+      buckets_by_size.push_back(
+          (static_cast<inT64>(num_hashes - size) << 32) | b);
+    }
+    bucket_starts[b + 1] += bucket_starts[b];
+  }
+  buckets_by_size.sort();
+  GenericVector<uinT64> bucket_hashes;
+  bucket_hashes.init_to_size(num_hashes, 0);
+  GenericVector<int> fill(bucket_starts);
+  for (int h = 0; h < num_hashes; ++h)
+    bucket_hashes[fill[Bucket(hashes[h])]++] = hashes[h];
+
+  fingerprints_.init_to_size(num_slots, 0);
+  GenericVector<inT32> slots;
+  for (int i = 0; i < buckets_by_size.size(); ++i) {
+    int b = static_cast<int>(buckets_by_size[i] & 0xffffffff);
+    int start = bucket_starts[b];
+    int size = bucket_starts[b + 1] - start;
+    uinT32 seed = 0;
+    for (; seed < kMaxSeed; ++seed) {
+      slots.truncate(0);
+      for (int h = 0; h < size; ++h) {
+        inT32 slot = Slot(bucket_hashes[start + h], seed);
+        if (fingerprints_[slot] != 0) break;
+        int s = 0;
+        while (s < slots.size() && slots[s] != slot) ++s;
+        if (s < slots.size()) break;
+        slots.push_back(slot);
+      }
+      if (slots.size() == size) break;
+    }
+    if (seed == kMaxSeed) {
+      seeds_.clear();
+      fingerprints_.clear();
+      return false;
+    }
+    seeds_[b] = seed;
+    for (int h = 0; h < size; ++h)
+      fingerprints_[slots[h]] = Fingerprint(bucket_hashes[start + h]);
+  }
+  num_words_ = num_hashes;
+  return true;
+}
+
+bool DawgWordIndex::Contains(const UNICHAR_ID *word, int length) const {
+  if (fingerprints_.empty() || length <= 0) return false;
+  uinT64 hash = HashWord(word, length);
+  return fingerprints_[Slot(hash, seeds_[Bucket(hash)])] == Fingerprint(hash);
+}
+
+uinT64 DawgWordIndex::HashWord(const UNICHAR_ID *word, int length) {
+  uinT64 hash = 0x9e3779b97f4a7c15ULL ^ length;
+  for (int i = 0; i < length; ++i) {
+    hash = (hash ^ static_cast<uinT32>(word[i])) * 0x100000001b3ULL;
+    hash ^= hash >> 29;
+  }
+  return Mix64(hash);
+}
+
+inT32 DawgWordIndex::Slot(uinT64 hash, uinT32 seed) const {
+  uinT64 mixed = Mix64(hash + seed * 0x9e3779b97f4a7c15ULL);
+  return Reduce(static_cast<uinT32>(mixed), fingerprints_.size());
+}
+
+}  // namespace tesseract
@@ -0,0 +1,82 @@
+///////////////////////////////////////////////////////////////////////
+// File:        dawgindex.h
+// Description: Perfect hash index of the whole words of a dawg.
+//
+// (C) Copyright 2017, Google Inc.
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+///////////////////////////////////////////////////////////////////////
+
+#ifndef TESSERACT_DICT_DAWGINDEX_H_
+#define TESSERACT_DICT_DAWGINDEX_H_
+
+#include "genericvector.h"
+#include "host.h"
+#include "unichar.h"
+
+namespace tesseract {
+
+class Dawg;
+
+// Answers whether a whole word is in a dawg with a fixed number of memory
+// reads, however long the word, instead of following the edges of the dawg
+// letter by letter. The words are placed with a perfect hash function of
+// the hash-and-displace kind: each word hashes to a bucket, and each bucket
+// stores the seed that sends its few words to distinct slots of a table
+// with very few empty slots. As the words themselves are not stored, each
+// slot only holds a fingerprint of its word, so a word that is not in the
+// dawg is reported as present with a probability of about 2^-31.
+class DawgWordIndex {
+ public:
+  DawgWordIndex() : num_words_(0) {}
+
+  // Indexes all the words of dawg. Returns false, leaving the index empty,
+  // if two words hash the same or no perfect hash is found.
+  bool Build(const Dawg &dawg);
+
+  // Returns true if the length unichar ids starting at word are a word of
+  // the dawg, exactly as Dawg::word_in_dawg would, up to false positives.
+  bool Contains(const UNICHAR_ID *word, int length) const;
+
+  // Hash of the length unichar ids starting at word.
+  static uinT64 HashWord(const UNICHAR_ID *word, int length);
+
+  bool empty() const { return fingerprints_.empty(); }
+  int num_words() const { return num_words_; }
+  // Bytes used by the index.
+  int MemoryUsed() const {
+    return seeds_.size() * sizeof(seeds_[0]) +
+        fingerprints_.size() * sizeof(fingerprints_[0]);
+  }
+
+ private:
+  // Maps a 32 bit value onto [0, range).
+  static inT32 Reduce(uinT32 value, inT32 range) {
+    return static_cast<inT32>((static_cast<uinT64>(value) * range) >> 32);
+  }
+  inT32 Bucket(uinT64 hash) const {
+    return Reduce(static_cast<uinT32>(hash), seeds_.size());
+  }
+  inT32 Slot(uinT64 hash, uinT32 seed) const;
+  // The fingerprint stored for hash, which is never 0, the empty slot.
+  static uinT32 Fingerprint(uinT64 hash) {
+    return static_cast<uinT32>(hash >> 32) | 1;
+  }
+
+  int num_words_;
+  // Seed of each bucket.
+  GenericVector<uinT32> seeds_;
+  // Fingerprint of the word in each slot, or 0.
+  GenericVector<uinT32> fingerprints_;
+};
+
+}  // namespace tesseract
+
+#endif  // TESSERACT_DICT_DAWGINDEX_H_
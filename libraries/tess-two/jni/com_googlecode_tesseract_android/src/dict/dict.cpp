@@ -19,6 +19,10 @@
 #include <stdio.h>
 
 #include "dict.h"
+#include "dawgindex.h"
+#include "pagearena.h"
+#include "pagecounters.h"
+#include "tessdatamanager.h"
 #include "unicodes.h"
 
 #ifdef _MSC_VER
@@ -65,6 +69,23 @@ Dict::Dict(CCUtil *ccutil)
                        "Load dawg with special word "
                        "bigrams.",
                        getCCUtil()->params()),
+      BOOL_INIT_MEMBER(map_dawgs_in_place, false,
+                       "Map dawg edges read-only from the traineddata file"
+                       " instead of copying them to the heap.",
+                       getCCUtil()->params()),
+      BOOL_INIT_MEMBER(compile_dawg_lookup, true,
+                       "Build tables of the letters of the dawg edges at load"
+                       " time to find the children of nodes faster.",
+                       getCCUtil()->params()),
+      BOOL_INIT_MEMBER(index_dawg_words, true,
+                       "Index the whole words of the word dawgs at load time,"
+                       " and look up words without punctuation in the"
+                       " indexes.",
+                       getCCUtil()->params()),
+      BOOL_INIT_MEMBER(lazy_load_components, true,
+                       "Load the bigram dawg and the character ngram table"
+                       " when they are first used instead of at Init.",
+                       getCCUtil()->params()),
       double_MEMBER(xheight_penalty_subscripts, 0.125,
                     "Score penalty (0.1 = 10%) added if there are subscripts "
                     "or superscripts in a word, but it is otherwise OK.",
@@ -178,23 +199,91 @@ Dict::Dict(CCUtil *ccutil)
   last_word_on_line_ = false;
   hyphen_unichar_id_ = INVALID_UNICHAR_ID;
   document_words_ = NULL;
+  user_words_ = NULL;
+  user_patterns_ = NULL;
   dawg_cache_ = NULL;
   dawg_cache_is_ours_ = false;
   pending_words_ = NULL;
+  bigram_dawg_pending_ = false;
+  char_ngram_pending_ = false;
   bigram_dawg_ = NULL;
   freq_dawg_ = NULL;
   punc_dawg_ = NULL;
   unambig_dawg_ = NULL;
+  char_ngram_table_ = NULL;
   wordseg_rating_adjust_factor_ = -1.0f;
   output_ambig_words_file_ = NULL;
 }
 
 Dict::~Dict() {
   End();
+  SetCharNgramTable(NULL);
+  dawg_scratch_pool_.delete_data_pointers();
   delete hyphen_word_;
   if (output_ambig_words_file_ != NULL) fclose(output_ambig_words_file_);
 }
 
+DawgScratch* Dict::AcquireDawgScratch() const {
+  DawgScratch* scratch = NULL;
+  dawg_scratch_mutex_.Lock();
+  if (!dawg_scratch_pool_.empty()) scratch = dawg_scratch_pool_.pop_back();
+  dawg_scratch_mutex_.Unlock();
+  return scratch != NULL ? scratch : new DawgScratch;
+}
+
+void Dict::ReleaseDawgScratch(DawgScratch* scratch) const {
+  dawg_scratch_mutex_.Lock();
+  dawg_scratch_pool_.push_back(scratch);
+  dawg_scratch_mutex_.Unlock();
+}
+
+DawgScratch::~DawgScratch() {
+  delete[] positions_;
+  delete word_;
+  spare_positions_.delete_data_pointers();
+}
+
+DawgPositionVector *DawgScratch::Positions(int size) {
+  if (size > num_positions_) {
+    delete[] positions_;
+    num_positions_ = MAX(size, 2 * num_positions_);
+    positions_ = new DawgPositionVector[num_positions_];
+  }
+  for (int i = 0; i < size; ++i) positions_[i].clear();
+  return positions_;
+}
+
+WERD_CHOICE *DawgScratch::Word(const UNICHARSET *unicharset) {
+  if (word_ == NULL || word_->unicharset() != unicharset) {
+    delete word_;
+    // Kept from one page to the next, so it cannot be in a page arena.
+    PageArena::Scope heap(NULL);
+    word_ = new WERD_CHOICE(unicharset, MAX_WERD_LENGTH);
+  } else {
+    // As the constructor leaves it.
+    word_->set_length(0);
+    word_->set_adjust_factor(1.0f);
+    word_->set_rating(0.0f);
+    word_->set_certainty(MAX_FLOAT32);
+    word_->set_x_heights(0.0f, MAX_FLOAT32);
+    word_->set_permuter(NO_PERM);
+    word_->set_dangerous_ambig_found_(false);
+  }
+  return word_;
+}
+
+DawgPositionVector *DawgScratch::CopyPositions(
+    const DawgPositionVector &positions) {
+  DawgPositionVector *copy = spare_positions_.empty()
+      ? new DawgPositionVector : spare_positions_.pop_back();
+  *copy = positions;
+  return copy;
+}
+
+void DawgScratch::FreePositions(DawgPositionVector *positions) {
+  spare_positions_.push_back(positions);
+}
+
 DawgCache *Dict::GlobalDawgCache() {
   // This global cache (a singleton) will outlive every Tesseract instance
   // (even those that someone else might declare as global statics).
@@ -222,34 +311,45 @@ void Dict::SetupForLoad(DawgCache *dawg_cache) {
 
 // Loads the dawgs needed by Tesseract. Call FinishLoad() after.
 void Dict::Load(const char *data_file_name, const STRING &lang) {
+  lazy_data_file_name_ = data_file_name;
+  lazy_lang_ = lang;
   // Load dawgs_.
   if (load_punc_dawg) {
     punc_dawg_ = dawg_cache_->GetSquishedDawg(
-        lang, data_file_name, TESSDATA_PUNC_DAWG, dawg_debug_level);
+        lang, data_file_name, TESSDATA_PUNC_DAWG, dawg_debug_level,
+        map_dawgs_in_place, compile_dawg_lookup, index_dawg_words);
     if (punc_dawg_) dawgs_ += punc_dawg_;
   }
   if (load_system_dawg) {
     Dawg *system_dawg = dawg_cache_->GetSquishedDawg(
-        lang, data_file_name, TESSDATA_SYSTEM_DAWG, dawg_debug_level);
+        lang, data_file_name, TESSDATA_SYSTEM_DAWG, dawg_debug_level,
+        map_dawgs_in_place, compile_dawg_lookup, index_dawg_words);
     if (system_dawg) dawgs_ += system_dawg;
   }
   if (load_number_dawg) {
     Dawg *number_dawg = dawg_cache_->GetSquishedDawg(
-        lang, data_file_name, TESSDATA_NUMBER_DAWG, dawg_debug_level);
+        lang, data_file_name, TESSDATA_NUMBER_DAWG, dawg_debug_level,
+        map_dawgs_in_place, compile_dawg_lookup, index_dawg_words);
     if (number_dawg) dawgs_ += number_dawg;
   }
-  if (load_bigram_dawg) {
+  if (load_bigram_dawg && lazy_load_components) {
+    // It is only used by valid_bigram, so GetBigramDawg loads it from there.
+    bigram_dawg_pending_ = true;
+  } else if (load_bigram_dawg) {
     bigram_dawg_ = dawg_cache_->GetSquishedDawg(
-        lang, data_file_name, TESSDATA_BIGRAM_DAWG, dawg_debug_level);
+        lang, data_file_name, TESSDATA_BIGRAM_DAWG, dawg_debug_level,
+        map_dawgs_in_place, compile_dawg_lookup, index_dawg_words);
   }
   if (load_freq_dawg) {
     freq_dawg_ = dawg_cache_->GetSquishedDawg(
-        lang, data_file_name, TESSDATA_FREQ_DAWG, dawg_debug_level);
+        lang, data_file_name, TESSDATA_FREQ_DAWG, dawg_debug_level,
+        map_dawgs_in_place, compile_dawg_lookup, index_dawg_words);
     if (freq_dawg_) { dawgs_ += freq_dawg_; }
   }
   if (load_unambig_dawg) {
     unambig_dawg_ = dawg_cache_->GetSquishedDawg(
-        lang, data_file_name, TESSDATA_UNAMBIG_DAWG, dawg_debug_level);
+        lang, data_file_name, TESSDATA_UNAMBIG_DAWG, dawg_debug_level,
+        map_dawgs_in_place, compile_dawg_lookup, index_dawg_words);
     if (unambig_dawg_) dawgs_ += unambig_dawg_;
   }
 
@@ -270,6 +370,7 @@ void Dict::Load(const char *data_file_name, const STRING &lang) {
       delete trie_ptr;
     } else {
       dawgs_ += trie_ptr;
+      user_words_ = trie_ptr;
     }
   }
 
@@ -289,6 +390,7 @@ void Dict::Load(const char *data_file_name, const STRING &lang) {
       delete trie_ptr;
     } else {
       dawgs_ += trie_ptr;
+      user_patterns_ = trie_ptr;
     }
   }
 
@@ -305,6 +407,14 @@ void Dict::Load(const char *data_file_name, const STRING &lang) {
 // Returns false if no dictionaries were loaded.
 bool Dict::FinishLoad() {
   if (dawgs_.empty()) return false;
+  SetupSuccessors();
+  SetupWholeWordLookup();
+  return true;
+}
+
+void Dict::SetupSuccessors() {
+  successors_.delete_data_pointers();
+  successors_.clear();
   // Construct a list of corresponding successors for each dawg. Each entry, i,
   // in the successors_ vector is a vector of integers that represent the
   // indices into the dawgs_ vector of the successors for dawg i.
@@ -320,9 +430,197 @@ bool Dict::FinishLoad() {
     }
     successors_ += lst;
   }
+}
+
+int Dict::AddUserWords(const char* const* words) {
+  if (document_words_ == NULL || words == NULL) return 0;
+  Trie *trie = user_words_;
+  if (trie == NULL) {
+    trie = new Trie(DAWG_TYPE_WORD, document_words_->lang(), USER_DAWG_PERM,
+                    getUnicharset().size(), dawg_debug_level);
+  }
+  int num_added = 0;
+  for (int i = 0; words[i] != NULL; ++i) {
+    // Converted the way read_word_list converts the lines of a word file.
+    WERD_CHOICE word(words[i], getUnicharset());
+    if (word.has_rtl_unichar_id()) word.reverse_and_mirror_unichar_ids();
+    if (word.length() == 0 || word.contains_unichar_id(INVALID_UNICHAR_ID)) {
+      if (dawg_debug_level) tprintf("Skipping invalid word %s\n", words[i]);
+      continue;
+    }
+    if (!trie->word_in_dawg(word)) trie->add_word_to_dawg(word);
+    ++num_added;
+  }
+  if (trie != user_words_) {
+    if (num_added == 0) {
+      delete trie;
+      return 0;
+    }
+    AddUserDawg(trie);
+    user_words_ = trie;
+  }
+  return num_added;
+}
+
+int Dict::AddUserPatterns(const char* const* patterns) {
+  if (document_words_ == NULL || patterns == NULL) return 0;
+  Trie *trie = user_patterns_;
+  if (trie == NULL) {
+    // initialize_patterns inserts the pattern unichars into the unicharset,
+    // which the classifier has already been sized by, so a new pattern dawg
+    // can only be made if they are there already.
+    if (!getUnicharset().contains_unichar(Trie::kAlphaPatternUnicode)) {
+      tprintf("Error: user patterns need user_patterns_suffix at Init\n");
+      return 0;
+    }
+    trie = new Trie(DAWG_TYPE_PATTERN, document_words_->lang(),
+                    USER_PATTERN_PERM, getUnicharset().size(),
+                    dawg_debug_level);
+    trie->initialize_patterns(&(getUnicharset()));
+  }
+  int num_added = 0;
+  for (int i = 0; patterns[i] != NULL; ++i) {
+    if (trie->add_pattern(patterns[i], getUnicharset())) ++num_added;
+  }
+  if (trie != user_patterns_) {
+    if (num_added == 0) {
+      delete trie;
+      return 0;
+    }
+    AddUserDawg(trie);
+    user_patterns_ = trie;
+  }
+  return num_added;
+}
+
+void Dict::ClearUserWords() {
+  if (user_words_ != NULL) user_words_->clear();
+  if (user_patterns_ != NULL) user_patterns_->clear();
+}
+
+void Dict::AddUserDawg(Trie *trie) {
+  dawgs_ += trie;
+  SetupSuccessors();
+  SetupWholeWordLookup();
+}
+
+// Marks the unichar ids of word in marks.
+static void MarkUnicharIds(GenericVector<bool> *marks,
+                           const WERD_CHOICE *word) {
+  for (int i = 0; i < word->length(); ++i) {
+    UNICHAR_ID id = word->unichar_id(i);
+    if (id >= 0 && id < marks->size()) (*marks)[id] = true;
+  }
+}
+
+void Dict::SetupWholeWordLookup() {
+  punc_unichars_.clear();
+  bare_word_dawgs_.clear();
+  bare_letter_dawgs_.clear();
+  dawgs_by_permuter_.clear();
+  // def_letter_is_okay does not take the highest permuter of the dawgs that
+  // match once one of them is COMPOUND_PERM, and the punctuation has to be
+  // in punc_dawg_ alone.
+  int punc_index = -1;
+  for (int i = 0; i < dawgs_.size(); ++i) {
+    if (dawgs_[i] == NULL || dawgs_[i]->permuter() == COMPOUND_PERM) return;
+    if (dawgs_[i]->type() == DAWG_TYPE_PUNCTUATION) {
+      if (dawgs_[i] != punc_dawg_ || punc_index >= 0) return;
+      punc_index = i;
+    }
+  }
+  punc_unichars_.init_to_size(getUnicharset().size(), false);
+  // A word without punctuation starts from the pattern edge out of the root
+  // of the punctuation dawg, chosen as the first letter is matched, and has
+  // to finish on it.
+  bool punc_letter_ok = false;
+  bool punc_word_ok = false;
+  if (punc_index >= 0) {
+    TessCallback1<const WERD_CHOICE *> *mark =
+        NewPermanentTessCallback(MarkUnicharIds, &punc_unichars_);
+    punc_dawg_->iterate_words(getUnicharset(), mark);
+    delete mark;
+    punc_unichars_[Dawg::kPatternUnicharID] = false;
+    punc_letter_ok =
+        punc_dawg_->edge_char_of(0, Dawg::kPatternUnicharID, true) != NO_EDGE;
+    EDGE_REF edge = punc_dawg_->edge_char_of(0, Dawg::kPatternUnicharID,
+                                             false);
+    punc_word_ok = edge != NO_EDGE && punc_dawg_->end_of_word(edge);
+  }
+  for (int i = 0; i < dawgs_.size(); ++i) {
+    // As in default_dawgs, the dawgs that can follow punctuation are only
+    // reached through the punctuation dawg, if it can be empty.
+    bool direct = !punc_letter_ok ||
+        !kDawgSuccessors[DAWG_TYPE_PUNCTUATION][dawgs_[i]->type()];
+    bool via_punc = false;
+    if (punc_index >= 0) {
+      const SuccessorList &slist = *successors_[punc_index];
+      for (int s = 0; s < slist.size(); ++s) {
+        if (slist[s] == i) via_punc = true;
+      }
+    }
+    bare_word_dawgs_.push_back(direct || (via_punc && punc_word_ok));
+    bare_letter_dawgs_.push_back(direct || (via_punc && punc_letter_ok));
+    // Insertion sort, as there are only a few dawgs.
+    int pos = dawgs_by_permuter_.size();
+    dawgs_by_permuter_.push_back(i);
+    while (pos > 0 && dawgs_[dawgs_by_permuter_[pos - 1]]->permuter() <
+           dawgs_[i]->permuter()) {
+      dawgs_by_permuter_[pos] = dawgs_by_permuter_[pos - 1];
+      dawgs_by_permuter_[--pos] = i;
+    }
+  }
+}
+
+bool Dict::valid_word_from_index(const WERD_CHOICE &word, bool numbers_ok,
+                                 int *permuter) const {
+  if (!index_dawg_words || dawgs_by_permuter_.empty() || hyphenated() ||
+      letter_is_okay_ != &tesseract::Dict::def_letter_is_okay)
+    return false;
+  int length = word.length();
+  if (length == 0) return false;
+  // Punctuation can split the word between dawgs, and the ids that
+  // def_letter_is_okay rejects are left to it.
+  for (int i = 0; i < length; ++i) {
+    UNICHAR_ID id = word.unichar_id(i);
+    if (id < 0 || id == Dawg::kPatternUnicharID ||
+        id >= punc_unichars_.size() || punc_unichars_[id])
+      return false;
+  }
+  // Without punctuation, def_letter_is_okay ends with the highest permuter
+  // of the dawgs that contain the word.
+  int best = NO_PERM;
+  for (int d = 0; d < dawgs_by_permuter_.size(); ++d) {
+    int index = dawgs_by_permuter_[d];
+    const Dawg *dawg = dawgs_[index];
+    if (dawg->permuter() <= best) break;
+    if (dawg->type() == DAWG_TYPE_PATTERN) return false;
+    if (dawg->type() == DAWG_TYPE_PUNCTUATION) continue;
+    if (!(length == 1 ? bare_letter_dawgs_[index] : bare_word_dawgs_[index]))
+      continue;
+    if (bare_word_in_dawg(dawg, word)) best = dawg->permuter();
+  }
+  *permuter = valid_word_permuter(best, numbers_ok) ? best : NO_PERM;
   return true;
 }
 
+bool Dict::bare_word_in_dawg(const Dawg *dawg, const WERD_CHOICE &word) const {
+  const DawgWordIndex *index = dawg->word_index();
+  if (index != NULL) return index->Contains(word.unichar_ids(), word.length());
+  // Follow the edges as def_letter_is_okay would.
+  NODE_REF node = 0;
+  int last_index = word.length() - 1;
+  for (int i = 0; i <= last_index; ++i) {
+    EDGE_REF edge = dawg->edge_char_of(
+        node, char_for_dawg(word.unichar_id(i), dawg), i == last_index);
+    if (edge == NO_EDGE) return false;
+    if (i == last_index) return true;
+    node = GetStartingNode(dawg, edge);
+    if (node == NO_EDGE) return false;
+  }
+  return false;
+}
+
 void Dict::End() {
   if (dawgs_.length() == 0)
     return;  // Not safe to call twice.
@@ -332,6 +630,8 @@ void Dict::End() {
     }
   }
   dawg_cache_->FreeDawg(bigram_dawg_);
+  bigram_dawg_ = NULL;
+  bigram_dawg_pending_ = false;
   if (dawg_cache_is_ours_) {
     delete dawg_cache_;
     dawg_cache_ = NULL;
@@ -339,7 +639,13 @@ void Dict::End() {
   successors_.delete_data_pointers();
   dawgs_.clear();
   successors_.clear();
+  punc_unichars_.clear();
+  bare_word_dawgs_.clear();
+  bare_letter_dawgs_.clear();
+  dawgs_by_permuter_.clear();
   document_words_ = NULL;
+  user_words_ = NULL;
+  user_patterns_ = NULL;
   delete pending_words_;
   pending_words_ = NULL;
 }
@@ -351,6 +657,7 @@ int Dict::def_letter_is_okay(void* void_dawg_args,
                              UNICHAR_ID unichar_id,
                              bool word_end) const {
   DawgArgs *dawg_args = reinterpret_cast<DawgArgs*>(void_dawg_args);
+  PageCounts::Count(COUNTER_DAWG_LOOKUPS);
 
   if (dawg_debug_level >= 3) {
     tprintf("def_letter_is_okay: current unichar=%s word_end=%d"
@@ -736,9 +1043,12 @@ int Dict::valid_word(const WERD_CHOICE &word, bool numbers_ok) const {
     word_ptr = &temp_word;
   }
   if (word_ptr->length() == 0) return NO_PERM;
-  // Allocate vectors for holding current and updated
+  int permuter;
+  if (valid_word_from_index(*word_ptr, numbers_ok, &permuter)) return permuter;
+  // Get vectors for holding current and updated
   // active_dawgs and initialize them.
-  DawgPositionVector *active_dawgs = new DawgPositionVector[2];
+  DawgScratch *scratch = AcquireDawgScratch();
+  DawgPositionVector *active_dawgs = scratch->Positions(2);
   init_active_dawgs(&(active_dawgs[0]), false);
   DawgArgs dawg_args(&(active_dawgs[0]), &(active_dawgs[1]), NO_PERM);
   int last_index = word_ptr->length() - 1;
@@ -755,14 +1065,93 @@ int Dict::valid_word(const WERD_CHOICE &word, bool numbers_ok) const {
       dawg_args.active_dawgs = &(active_dawgs[0]);
     }
   }
-  delete[] active_dawgs;
+  ReleaseDawgScratch(scratch);
   return valid_word_permuter(dawg_args.permuter, numbers_ok) ?
     dawg_args.permuter : NO_PERM;
 }
 
+// Returns the character ngram table of the given traineddata, or NULL if it
+// has none or it can not be read.
+static CharNgramTable *ReadCharNgramTable(TessdataManager *tessdata_manager,
+                                          int debug_level) {
+  if (!tessdata_manager->SeekToStart(TESSDATA_CHAR_NGRAM)) return NULL;
+  TFile fp;
+  CharNgramTable *table = new CharNgramTable;
+  if (fp.Open(tessdata_manager->GetDataFilePtr(),
+              tessdata_manager->GetEndOffset(TESSDATA_CHAR_NGRAM) + 1) &&
+      table->DeSerialize(tessdata_manager->swap(), &fp)) {
+    if (debug_level) tprintf("Loaded %d character ngrams\n", table->size());
+    return table;
+  }
+  tprintf("Error: failed to load the character ngram table\n");
+  delete table;
+  return NULL;
+}
+
+double Dict::ngram_probability_in_context(const char* lang,
+                                          const char* context,
+                                          int context_bytes,
+                                          const char* character,
+                                          int character_bytes) {
+  (void)lang;
+  lazy_load_mutex_.Lock();
+  if (char_ngram_pending_) {
+    char_ngram_pending_ = false;
+    TessdataManager tessdata_manager;
+    if (tessdata_manager.Init(lazy_data_file_name_.string(),
+                              dawg_debug_level)) {
+      char_ngram_table_ = ReadCharNgramTable(&tessdata_manager,
+                                             dawg_debug_level);
+      tessdata_manager.End();
+    }
+  }
+  const CharNgramTable *table = char_ngram_table_;
+  lazy_load_mutex_.Unlock();
+  if (table == NULL) return 0.0;
+  return table->Probability(context, context_bytes,
+                            character, character_bytes);
+}
+
+void Dict::SetCharNgramTable(CharNgramTable *table) {
+  lazy_load_mutex_.Lock();
+  char_ngram_pending_ = false;
+  lazy_load_mutex_.Unlock();
+  delete char_ngram_table_;
+  char_ngram_table_ = table;
+  probability_in_context_ = table != NULL
+      ? &tesseract::Dict::ngram_probability_in_context
+      : &tesseract::Dict::def_probability_in_context;
+}
+
+void Dict::LoadCharNgramTable(TessdataManager *tessdata_manager) {
+  SetCharNgramTable(ReadCharNgramTable(tessdata_manager, dawg_debug_level));
+}
+
+void Dict::SetCharNgramFile(const char *data_file_name) {
+  SetCharNgramTable(NULL);
+  lazy_data_file_name_ = data_file_name;
+  char_ngram_pending_ = true;
+  probability_in_context_ = &tesseract::Dict::ngram_probability_in_context;
+}
+
+const Dawg *Dict::GetBigramDawg() const {
+  lazy_load_mutex_.Lock();
+  if (bigram_dawg_pending_) {
+    bigram_dawg_pending_ = false;
+    bigram_dawg_ = dawg_cache_->GetSquishedDawg(
+        lazy_lang_, lazy_data_file_name_.string(), TESSDATA_BIGRAM_DAWG,
+        dawg_debug_level, map_dawgs_in_place, compile_dawg_lookup,
+        index_dawg_words);
+  }
+  const Dawg *bigram_dawg = bigram_dawg_;
+  lazy_load_mutex_.Unlock();
+  return bigram_dawg;
+}
+
 bool Dict::valid_bigram(const WERD_CHOICE &word1,
                         const WERD_CHOICE &word2) const {
-  if (bigram_dawg_ == NULL) return false;
+  const Dawg *bigram_dawg = GetBigramDawg();
+  if (bigram_dawg == NULL) return false;
 
   // Extract the core word from the middle of each word with any digits
   //         replaced with question marks.
@@ -776,7 +1165,7 @@ bool Dict::valid_bigram(const WERD_CHOICE &word1,
   if (w2start >= w2end) return word2.length() < 3;
 
   const UNICHARSET& uchset = getUnicharset();
-  GenericVector<UNICHAR_ID> bigram_string;
+  SmallVector<UNICHAR_ID, 32> bigram_string;
   bigram_string.reserve(w1end + w2end + 1);
   for (int i = w1start; i < w1end; i++) {
     const GenericVector<UNICHAR_ID>& normed_ids =
@@ -795,12 +1184,15 @@ bool Dict::valid_bigram(const WERD_CHOICE &word1,
     else
       bigram_string += normed_ids;
   }
+  const DawgWordIndex *index = bigram_dawg->word_index();
+  if (index != NULL)
+    return index->Contains(&bigram_string[0], bigram_string.size());
   WERD_CHOICE normalized_word(&uchset, bigram_string.size());
   for (int i = 0; i < bigram_string.size(); ++i) {
     normalized_word.append_unichar_id_space_allocated(bigram_string[i], 1,
                                                       0.0f, 0.0f);
   }
-  return bigram_dawg_->word_in_dawg(normalized_word);
+  return bigram_dawg->word_in_dawg(normalized_word);
 }
 
 bool Dict::valid_punctuation(const WERD_CHOICE &word) {
@@ -20,6 +20,8 @@
 #define TESSERACT_DICT_DICT_H_
 
 #include "ambigs.h"
+#include "ccutil.h"
+#include "charngram.h"
 #include "dawg.h"
 #include "dawg_cache.h"
 #include "host.h"
@@ -73,15 +75,52 @@ static const int kDocDictMaxRepChars = 4;
 //  2 - the word is inconsistent.
 enum XHeightConsistencyEnum {XH_GOOD, XH_SUBNORMAL, XH_INCONSISTENT};
 
+// Working storage of the dawg searches, kept from one word to the next so
+// that, once it has grown to fit, a search makes no heap allocations. Get
+// one with Dict::AcquireDawgScratch and give it back with
+// ReleaseDawgScratch. A scratch is not thread-safe, but each thread that
+// searches with the same Dict gets one of its own.
+class DawgScratch {
+ public:
+  DawgScratch() : positions_(NULL), num_positions_(0), word_(NULL) {}
+  ~DawgScratch();
+
+  // Returns an array of at least size empty position vectors, which is
+  // valid until the next call.
+  DawgPositionVector *Positions(int size);
+  // Returns an empty word of unicharset with room for MAX_WERD_LENGTH
+  // unichars, which is valid until the next call.
+  WERD_CHOICE *Word(const UNICHARSET *unicharset);
+  // Returns a copy of positions, to be given back with FreePositions.
+  DawgPositionVector *CopyPositions(const DawgPositionVector &positions);
+  void FreePositions(DawgPositionVector *positions);
+
+  // For matching the parts of a unichar, such as the unigrams of an ngram,
+  // one at a time.
+  DawgPositionVector part_active_dawgs;
+  DawgPositionVector part_updated_dawgs;
+  GenericVector<UNICHAR_ID> part_ids;
+
+ private:
+  DawgPositionVector *positions_;
+  int num_positions_;
+  WERD_CHOICE *word_;
+  // Vectors given back with FreePositions, which keep their memory.
+  GenericVector<DawgPositionVector *> spare_positions_;
+};
+
 struct DawgArgs {
   DawgArgs(DawgPositionVector *d, DawgPositionVector *up, PermuterType p)
-      : active_dawgs(d), updated_dawgs(up), permuter(p), valid_end(false) {}
+      : active_dawgs(d), updated_dawgs(up), permuter(p), valid_end(false),
+        scratch(NULL) {}
 
   DawgPositionVector *active_dawgs;
   DawgPositionVector *updated_dawgs;
   PermuterType permuter;
   // True if the current position is a valid word end.
   bool valid_end;
+  // Storage for go_deeper_dawg_fxn to use. Must not be NULL there.
+  DawgScratch *scratch;
 };
 
 class Dict {
@@ -97,6 +136,10 @@ class Dict {
   const UNICHARSET& getUnicharset() const {
     return getCCUtil()->unicharset;
   }
+  // Returns dawg search storage for the sole use of the caller until it
+  // gives it back with ReleaseDawgScratch.
+  DawgScratch* AcquireDawgScratch() const;
+  void ReleaseDawgScratch(DawgScratch* scratch) const;
   UNICHARSET& getUnicharset() {
     return getCCUtil()->unicharset;
   }
@@ -312,6 +355,20 @@ class Dict {
       document_words_->clear();
   }
 
+  // Adds the given UTF-8 words, terminated by a NULL pointer, to the user
+  // words dawg after FinishLoad, creating it if user_words_suffix gave none.
+  // Returns the number of words that could be expressed in the unicharset.
+  // The tries are searched directly, so the words are valid at once. Must
+  // not be called while a recognition is using the Dict.
+  int AddUserWords(const char* const* words);
+  // As AddUserWords for patterns in the syntax of Trie::read_pattern_list.
+  // A pattern dawg can only be created here if the unicharset already has
+  // the pattern unichars, as when user_patterns_suffix was set at Init.
+  int AddUserPatterns(const char* const* patterns);
+  // Removes every user word and user pattern, including any loaded from
+  // user_words_suffix and user_patterns_suffix.
+  void ClearUserWords();
+
   /**
    * Returns the maximal permuter code (from ccstruct/ratngs.h) if in light
    * of the current state the letter at word_index in the given word
@@ -388,11 +445,23 @@ class Dict {
     (void)character_bytes;
     return 0.0;
   }
+  /// Probability in context function that looks up char_ngram_table_.
   double ngram_probability_in_context(const char* lang,
                                       const char* context,
                                       int context_bytes,
                                       const char* character,
                                       int character_bytes);
+  /// Takes ownership of table, deleting any previous one, and makes
+  /// ProbabilityInContext answer from it, or from the default (no-op)
+  /// function if table is NULL.
+  void SetCharNgramTable(CharNgramTable *table);
+  /// Reads the character ngram table from the traineddata of the given
+  /// TessdataManager and uses it as SetCharNgramTable does.
+  void LoadCharNgramTable(TessdataManager *tessdata_manager);
+  /// As LoadCharNgramTable, but only records the name of the traineddata
+  /// file, and reads the table the first time ProbabilityInContext is called.
+  void SetCharNgramFile(const char *data_file_name);
+  const CharNgramTable *char_ngram_table() const { return char_ngram_table_; }
 
   // Interface with params model.
   float (Dict::*params_model_classify_)(const char *lang, void *path);
@@ -493,6 +562,25 @@ class Dict {
   bool IsSpaceDelimitedLang() const;
 
  private:
+  // Sets up the tables for valid_word_from_index, once the dawgs and their
+  // successors are loaded.
+  // Builds successors_ from the dawgs in dawgs_.
+  void SetupSuccessors();
+  void SetupWholeWordLookup();
+  // Appends a user dawg to dawgs_ after FinishLoad and rebuilds the tables
+  // that depend on the set of dawgs.
+  void AddUserDawg(Trie *trie);
+  // Sets *permuter to what valid_word would return for word, and returns
+  // true, if that does not depend on the punctuation dawg, using the whole
+  // word indexes of the dawgs that have one. Returns false, with *permuter
+  // unchanged, if valid_word has to follow the dawgs a letter at a time.
+  bool valid_word_from_index(const WERD_CHOICE &word, bool numbers_ok,
+                             int *permuter) const;
+  // Returns true if the whole of word, without any punctuation, is in dawg.
+  bool bare_word_in_dawg(const Dawg *dawg, const WERD_CHOICE &word) const;
+  // Returns the bigram dawg, loading it first if it is still pending.
+  const Dawg *GetBigramDawg() const;
+
   /** Private member variables. */
   CCUtil* ccutil_;
   /**
@@ -527,13 +615,33 @@ class Dict {
   // Dawgs.
   DawgVector dawgs_;
   SuccessorListsVector successors_;
+  // The tables of valid_word_from_index, all empty if it can not be used:
+  // whether each unichar id is a letter of the punctuation dawg, whether
+  // each dawg can match a word of more than one letter, or of one letter,
+  // that has no punctuation, and the indices of the dawgs in order of
+  // decreasing permuter.
+  GenericVector<bool> punc_unichars_;
+  GenericVector<bool> bare_word_dawgs_;
+  GenericVector<bool> bare_letter_dawgs_;
+  GenericVector<int> dawgs_by_permuter_;
+  // Scratches given back with ReleaseDawgScratch, and the lock on them.
+  mutable GenericVector<DawgScratch*> dawg_scratch_pool_;
+  mutable CCUtilMutex dawg_scratch_mutex_;
   Trie *pending_words_;
+  // The traineddata file of the components that are loaded on first use when
+  // lazy_load_components is set, whether they still have to be loaded, and
+  // the lock on loading them.
+  STRING lazy_data_file_name_;
+  STRING lazy_lang_;
+  mutable bool bigram_dawg_pending_;
+  bool char_ngram_pending_;
+  mutable CCUtilMutex lazy_load_mutex_;
   // bigram_dawg_ points to a dawg of two-word bigrams which always supercede if
   // any of them are present on the best choices list for a word pair.
   // the bigrams are stored as space-separated words where:
   // (1) leading and trailing punctuation has been removed from each word and
   // (2) any digits have been replaced with '?' marks.
-  Dawg *bigram_dawg_;
+  mutable Dawg *bigram_dawg_;
   /// The following pointers are only cached for convenience.
   /// The dawgs will be deleted when dawgs_ vector is destroyed.
   // TODO(daria): need to support multiple languages in the future,
@@ -542,6 +650,11 @@ class Dict {
   Dawg *unambig_dawg_;
   Dawg *punc_dawg_;
   Trie *document_words_;
+  // The user words and user patterns dawgs, if any, also owned by dawgs_.
+  Trie *user_words_;
+  Trie *user_patterns_;
+  // Compiled character ngram model, if one is loaded.
+  CharNgramTable *char_ngram_table_;
   /// Current segmentation cost adjust factor for word rating.
   /// See comments in incorporate_segcost.
   float wordseg_rating_adjust_factor_;
@@ -567,6 +680,18 @@ class Dict {
   BOOL_VAR_H(load_number_dawg, true, "Load dawg with number patterns.");
   BOOL_VAR_H(load_bigram_dawg, true,
              "Load dawg with special word bigrams.");
+  BOOL_VAR_H(map_dawgs_in_place, false,
+             "Map dawg edges read-only from the traineddata file instead"
+             " of copying them to the heap.");
+  BOOL_VAR_H(compile_dawg_lookup, true,
+             "Build tables of the letters of the dawg edges at load time to"
+             " find the children of nodes faster.");
+  BOOL_VAR_H(index_dawg_words, true,
+             "Index the whole words of the word dawgs at load time, and look"
+             " up words without punctuation in the indexes.");
+  BOOL_VAR_H(lazy_load_components, true,
+             "Load the bigram dawg and the character ngram table when they"
+             " are first used instead of at Init.");
   double_VAR_H(xheight_penalty_subscripts, 0.125,
                "Score penalty (0.1 = 10%) added if there are subscripts "
                "or superscripts in a word, but it is otherwise OK.");
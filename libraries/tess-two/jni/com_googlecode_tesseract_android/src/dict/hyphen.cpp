@@ -23,6 +23,7 @@
  *********************************************************************************/
 
 #include "dict.h"
+#include "pagearena.h"
 
 namespace tesseract {
 
@@ -49,6 +50,8 @@ void Dict::reset_hyphen_vars(bool last_word_on_line) {
 void Dict::set_hyphen_word(const WERD_CHOICE &word,
                            const DawgPositionVector &active_dawgs) {
   if (hyphen_word_ == NULL) {
+    // Carried over to the next page, so it cannot be in a page arena.
+    PageArena::Scope heap(NULL);
     hyphen_word_ = new WERD_CHOICE(word.unicharset());
     hyphen_word_->make_bad();
   }
@@ -71,15 +71,21 @@ void Dict::go_deeper_dawg_fxn(
     }
     int num_unigrams = 0;
     word->remove_last_unichar_id();
-    GenericVector<UNICHAR_ID> encoding;
+    // Use the storage of the scratch, as the state does not have to
+    // outlive this call.
+    DawgScratch *scratch = more_args->scratch;
+    ASSERT_HOST(scratch != NULL);
+    GenericVector<UNICHAR_ID> &encoding = scratch->part_ids;
+    DawgPositionVector &unigram_active_dawgs = scratch->part_active_dawgs;
+    DawgPositionVector &unigram_updated_dawgs = scratch->part_updated_dawgs;
     const char *ngram_str = getUnicharset().id_to_unichar(orig_uch_id);
     // Since the string came out of the unicharset, failure is impossible.
     ASSERT_HOST(getUnicharset().encode_string(ngram_str, true, &encoding, NULL,
                                               NULL));
     bool unigrams_ok = true;
     // Construct DawgArgs that reflect the current state.
-    DawgPositionVector unigram_active_dawgs = *(more_args->active_dawgs);
-    DawgPositionVector unigram_updated_dawgs;
+    unigram_active_dawgs = *(more_args->active_dawgs);
+    unigram_updated_dawgs.clear();
     DawgArgs unigram_dawg_args(&unigram_active_dawgs,
                                &unigram_updated_dawgs,
                                more_args->permuter);
@@ -179,11 +185,13 @@ WERD_CHOICE *Dict::dawg_permute_and_select(
   best_choice->set_rating(rating_limit);
   if (char_choices.length() == 0 || char_choices.length() > MAX_WERD_LENGTH)
     return best_choice;
+  DawgScratch *scratch = AcquireDawgScratch();
   DawgPositionVector *active_dawgs =
-      new DawgPositionVector[char_choices.length() + 1];
+      scratch->Positions(char_choices.length() + 1);
   init_active_dawgs(&(active_dawgs[0]), true);
   DawgArgs dawg_args(&(active_dawgs[0]), &(active_dawgs[1]), NO_PERM);
-  WERD_CHOICE word(&getUnicharset(), MAX_WERD_LENGTH);
+  dawg_args.scratch = scratch;
+  WERD_CHOICE &word = *scratch->Word(&getUnicharset());
 
   float certainties[MAX_WERD_LENGTH];
   this->go_deeper_fxn_ = &tesseract::Dict::go_deeper_dawg_fxn;
@@ -191,7 +199,7 @@ WERD_CHOICE *Dict::dawg_permute_and_select(
   permute_choices((dawg_debug_level) ? "permute_dawg_debug" : NULL,
       char_choices, 0, NULL, &word, certainties, &rating_limit, best_choice,
       &attempts_left, &dawg_args);
-  delete[] active_dawgs;
+  ReleaseDawgScratch(scratch);
   return best_choice;
 }
 
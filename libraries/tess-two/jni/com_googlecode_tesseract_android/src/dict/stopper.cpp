@@ -163,10 +163,10 @@ bool Dict::NoDangerousAmbig(WERD_CHOICE *best_choice,
   int i;
   bool ambigs_found = false;
   // For each position in best_choice:
-  // -- choose AMBIG_SPEC_LIST that corresponds to unichar_id at best_choice[i]
-  // -- initialize wrong_ngram with a single unichar_id at best_choice[i]
-  // -- look for ambiguities corresponding to wrong_ngram in the list while
-  //    adding the following unichar_ids from best_choice to wrong_ngram
+  // -- start at the node of the ambiguity trie for unichar_id at
+  //    best_choice[i]
+  // -- collect the ambiguities of each node while following the next
+  //    unichar_ids of best_choice down the trie
   //
   // Repeat the above procedure twice: first time look through
   // ambigs to be replaced and replace all the ambiguities found;
@@ -179,8 +179,8 @@ bool Dict::NoDangerousAmbig(WERD_CHOICE *best_choice,
   // if replacements are made the length of best_choice might change.
   for (int pass = 0; pass < (fix_replaceable ? 2 : 1); ++pass) {
     bool replace = (fix_replaceable && pass == 0);
-    const UnicharAmbigsVector &table = replace ?
-      getUnicharAmbigs().replace_ambigs() : getUnicharAmbigs().dang_ambigs();
+    const AmbigTrie &trie = replace ?
+      getUnicharAmbigs().replace_trie() : getUnicharAmbigs().dang_trie();
     if (!replace) {
       // Initialize ambig_blob_choices with lists containing a single
       // unichar id for the correspoding position in best_choice.
@@ -195,9 +195,6 @@ bool Dict::NoDangerousAmbig(WERD_CHOICE *best_choice,
         ambig_blob_choices.push_back(lst);
       }
     }
-    UNICHAR_ID wrong_ngram[MAX_AMBIG_SIZE + 1];
-    int wrong_ngram_index;
-    int next_index;
     int blob_index = 0;
     for (i = 0; i < best_choice->length(); blob_index += best_choice->state(i),
          ++i) {
@@ -208,27 +205,13 @@ bool Dict::NoDangerousAmbig(WERD_CHOICE *best_choice,
                 getUnicharset().debug_str(curr_unichar_id).string());
       }
       int num_wrong_blobs = best_choice->state(i);
-      wrong_ngram_index = 0;
-      wrong_ngram[wrong_ngram_index] = curr_unichar_id;
-      if (curr_unichar_id == INVALID_UNICHAR_ID ||
-          curr_unichar_id >= table.size() ||
-          table[curr_unichar_id] == NULL) {
-        continue;  // there is no ambig spec for this unichar id
-      }
-      AmbigSpec_IT spec_it(table[curr_unichar_id]);
-      for (spec_it.mark_cycle_pt(); !spec_it.cycled_list();) {
-        const AmbigSpec *ambig_spec = spec_it.data();
-        wrong_ngram[wrong_ngram_index+1] = INVALID_UNICHAR_ID;
-        int compare = UnicharIdArrayUtils::compare(wrong_ngram,
-                                                   ambig_spec->wrong_ngram);
-        if (stopper_debug_level > 2) {
-          tprintf("candidate ngram: ");
-          UnicharIdArrayUtils::print(wrong_ngram, getUnicharset());
-          tprintf("current ngram from spec: ");
-          UnicharIdArrayUtils::print(ambig_spec->wrong_ngram, getUnicharset());
-          tprintf("comparison result: %d\n", compare);
-        }
-        if (compare == 0) {
+      int wrong_ngram_index = 0;
+      // The ngrams of a node are prefixes of those of its children, so the
+      // ambiguities are found in the order of the sorted AmbigSpec_LIST.
+      for (int node = trie.Start(curr_unichar_id); node >= 0;) {
+        const GenericVector<const AmbigSpec *> &specs = trie.Specs(node);
+        for (int s = 0; s < specs.size(); ++s) {
+          const AmbigSpec *ambig_spec = specs[s];
           // Record the place where we found an ambiguity.
           if (fixpt != NULL) {
             UNICHAR_ID leftmost_id = ambig_spec->correct_fragments[0];
@@ -279,22 +262,15 @@ bool Dict::NoDangerousAmbig(WERD_CHOICE *best_choice,
                   -1, 0, 1, 0, BCC_AMBIG));
             }
           }
-          spec_it.forward();
-        } else if (compare == -1) {
-          if (wrong_ngram_index+1 < ambig_spec->wrong_ngram_size &&
-              ((next_index = wrong_ngram_index+1+i) < best_choice->length())) {
-            // Add the next unichar id to wrong_ngram and keep looking for
-            // more ambigs starting with curr_unichar_id in AMBIG_SPEC_LIST.
-            wrong_ngram[++wrong_ngram_index] =
-              best_choice->unichar_id(next_index);
-            num_wrong_blobs += best_choice->state(next_index);
-          } else {
-            break;  // no more matching ambigs in this AMBIG_SPEC_LIST
-          }
-        } else {
-          spec_it.forward();
         }
-      }  // end searching AmbigSpec_LIST
+        // Extend the ngram with the next unichar id, which a replacement
+        // above may have changed, and keep looking for longer ambigs.
+        int next_index = wrong_ngram_index + 1 + i;
+        if (next_index >= best_choice->length()) break;
+        node = trie.Next(node, best_choice->unichar_id(next_index));
+        ++wrong_ngram_index;
+        num_wrong_blobs += best_choice->state(next_index);
+      }  // end following the ambiguity trie
     }  // end searching best_choice
   }  // end searching replace and dangerous ambigs
 
@@ -31,6 +31,8 @@
 #endif
 #include "trie.h"
 
+#include <algorithm>
+
 #include "callcpp.h"
 #include "dawg.h"
 #include "dict.h"
@@ -38,6 +40,8 @@
 #include "genericvector.h"
 #include "helpers.h"
 #include "kdpair.h"
+#include "tesscallback.h"
+#include "threadpool.h"
 
 namespace tesseract {
 
@@ -422,68 +426,70 @@ bool Trie::read_pattern_list(const char *filename,
   char string[CHARS_PER_LINE];
   while (fgets(string, CHARS_PER_LINE, pattern_file) != NULL) {
     chomp_string(string);  // remove newline
-    // Parse the pattern and construct a unichar id vector.
-    // Record the number of repetitions of each unichar in the parallel vector.
-    WERD_CHOICE word(&unicharset);
-    GenericVector<bool> repetitions_vec;
-    const char *str_ptr = string;
-    int step = unicharset.step(str_ptr);
-    bool failed = false;
-    while (step > 0) {
-      UNICHAR_ID curr_unichar_id = INVALID_UNICHAR_ID;
-      if (step == 1 && *str_ptr == '\\') {
-        ++str_ptr;
-        if (*str_ptr == '\\') {  // regular '\' unichar that was escaped
-          curr_unichar_id = unicharset.unichar_to_id(str_ptr, step);
+    if (add_pattern(string, unicharset)) ++pattern_count;
+  }
+  if (debug_level_) {
+    tprintf("Read %d valid patterns from %s\n", pattern_count, filename);
+  }
+  fclose(pattern_file);
+  return true;
+}
+
+bool Trie::add_pattern(const char *string, const UNICHARSET &unicharset) {
+  if (!initialized_patterns_) {
+    tprintf("please call initialize_patterns() before add_pattern()\n");
+    return false;
+  }
+  // Parse the pattern and construct a unichar id vector.
+  // Record the number of repetitions of each unichar in the parallel vector.
+  WERD_CHOICE word(&unicharset);
+  GenericVector<bool> repetitions_vec;
+  const char *str_ptr = string;
+  int step = unicharset.step(str_ptr);
+  while (step > 0) {
+    UNICHAR_ID curr_unichar_id = INVALID_UNICHAR_ID;
+    if (step == 1 && *str_ptr == '\\') {
+      ++str_ptr;
+      if (*str_ptr == '\\') {  // regular '\' unichar that was escaped
+        curr_unichar_id = unicharset.unichar_to_id(str_ptr, step);
+      } else {
+        if (word.length() < kSaneNumConcreteChars) {
+          tprintf("Please provide at least %d concrete characters at the"
+                  " beginning of the pattern\n", kSaneNumConcreteChars);
         } else {
-          if (word.length() < kSaneNumConcreteChars) {
-            tprintf("Please provide at least %d concrete characters at the"
-                    " beginning of the pattern\n", kSaneNumConcreteChars);
-            failed = true;
-            break;
-          }
           // Parse character class from expression.
           curr_unichar_id = character_class_to_pattern(*str_ptr);
         }
-      } else {
-        curr_unichar_id = unicharset.unichar_to_id(str_ptr, step);
-      }
-      if (curr_unichar_id ==  INVALID_UNICHAR_ID) {
-        failed = true;
-        break;  // failed to parse this pattern
-      }
-      word.append_unichar_id(curr_unichar_id, 1, 0.0, 0.0);
-      repetitions_vec.push_back(false);
-      str_ptr += step;
-      step = unicharset.step(str_ptr);
-      // Check if there is a repetition pattern specified after this unichar.
-      if (step == 1 && *str_ptr == '\\' && *(str_ptr+1) == '*') {
-        repetitions_vec[repetitions_vec.size()-1] = true;
-        str_ptr += 2;
-        step = unicharset.step(str_ptr);
       }
+    } else {
+      curr_unichar_id = unicharset.unichar_to_id(str_ptr, step);
     }
-    if (failed) {
+    if (curr_unichar_id ==  INVALID_UNICHAR_ID) {
       tprintf("Invalid user pattern %s\n", string);
-      continue;
+      return false;  // failed to parse this pattern
     }
-    // Insert the pattern into the trie.
-    if (debug_level_ > 2) {
-      tprintf("Inserting expanded user pattern %s\n",
-              word.debug_string().string());
+    word.append_unichar_id(curr_unichar_id, 1, 0.0, 0.0);
+    repetitions_vec.push_back(false);
+    str_ptr += step;
+    step = unicharset.step(str_ptr);
+    // Check if there is a repetition pattern specified after this unichar.
+    if (step == 1 && *str_ptr == '\\' && *(str_ptr+1) == '*') {
+      repetitions_vec[repetitions_vec.size()-1] = true;
+      str_ptr += 2;
+      step = unicharset.step(str_ptr);
     }
+  }
+  // Insert the pattern into the trie.
+  if (debug_level_ > 2) {
+    tprintf("Inserting expanded user pattern %s\n",
+            word.debug_string().string());
+  }
+  if (!this->word_in_dawg(word)) {
+    this->add_word_to_dawg(word, &repetitions_vec);
     if (!this->word_in_dawg(word)) {
-      this->add_word_to_dawg(word, &repetitions_vec);
-      if (!this->word_in_dawg(word)) {
-        tprintf("Error: failed to insert pattern '%s'\n", string);
-      }
+      tprintf("Error: failed to insert pattern '%s'\n", string);
     }
-    ++pattern_count;
   }
-  if (debug_level_) {
-    tprintf("Read %d valid patterns from %s\n", pattern_count, filename);
-  }
-  fclose(pattern_file);
   return true;
 }
 
@@ -570,6 +576,338 @@ SquishedDawg *Trie::trie_to_dawg() {
                           perm_, unicharset_size_, debug_level_);
 }
 
+// Orders the indices of words, held as runs of unichar ids, by their ids.
+class WordIdsLess {
+ public:
+  WordIdsLess(const GenericVector<UNICHAR_ID>& ids,
+              const GenericVector<int>& starts,
+              const GenericVector<int>& lengths)
+    : ids_(ids), starts_(starts), lengths_(lengths) {}
+
+  // Returns the length of the common prefix of the given words.
+  int CommonPrefix(int w1, int w2) const {
+    const UNICHAR_ID* ids1 = &ids_[0] + starts_[w1];
+    const UNICHAR_ID* ids2 = &ids_[0] + starts_[w2];
+    int length = MIN(lengths_[w1], lengths_[w2]);
+    int i = 0;
+    while (i < length && ids1[i] == ids2[i]) ++i;
+    return i;
+  }
+  bool operator()(int w1, int w2) const {
+    int prefix = CommonPrefix(w1, w2);
+    if (prefix == lengths_[w1] || prefix == lengths_[w2])
+      return lengths_[w1] < lengths_[w2];
+    return ids_[starts_[w1] + prefix] < ids_[starts_[w2] + prefix];
+  }
+
+ private:
+  const GenericVector<UNICHAR_ID>& ids_;
+  const GenericVector<int>& starts_;
+  const GenericVector<int>& lengths_;
+};
+
+// Arguments for encoding and sorting a word list in parallel.
+struct WordListJob {
+  const GenericVector<STRING>* words;
+  const UNICHARSET* unicharset;
+  int unicharset_size;
+  // Number of words in each chunk of the encoding, and in each run of the
+  // sorting.
+  int chunk_size;
+  // The unichar ids of the words of each chunk, end to end.
+  GenericVector<GenericVector<UNICHAR_ID> > chunk_ids;
+  // The length of each word, or 0 if it can't be added to a dawg.
+  GenericVector<int> lengths;
+  const WordIdsLess* less;
+  // The word indices being sorted, and a buffer to merge them into.
+  GenericVector<int>* order;
+  GenericVector<int>* merged;
+};
+
+// Encodes the words of the given chunk as unichar ids.
+static void EncodeWordChunk(WordListJob* job, int chunk) {
+  int end = MIN(job->words->size(), (chunk + 1) * job->chunk_size);
+  GenericVector<UNICHAR_ID>* ids = &job->chunk_ids[chunk];
+  for (int w = chunk * job->chunk_size; w < end; ++w) {
+    WERD_CHOICE word((*job->words)[w].string(), *job->unicharset);
+    // Same checks as add_word_to_dawg.
+    bool valid = word.length() > 0;
+    for (int i = 0; valid && i < word.length(); ++i) {
+      valid = word.unichar_id(i) >= 0 &&
+              word.unichar_id(i) < job->unicharset_size;
+    }
+    job->lengths[w] = valid ? word.length() : 0;
+    for (int i = 0; i < job->lengths[w]; ++i)
+      ids->push_back(word.unichar_id(i));
+  }
+}
+
+// Sorts the given run of job->order.
+static void SortWordRun(WordListJob* job, int run) {
+  int* start = &(*job->order)[0] + run * job->chunk_size;
+  int* end = &(*job->order)[0] +
+             MIN(job->order->size(), (run + 1) * job->chunk_size);
+  std::sort(start, end, *job->less);
+}
+
+// Merges the given pair of sorted runs of job->order into job->merged.
+static void MergeWordRuns(WordListJob* job, int pair) {
+  int size = job->order->size();
+  int start = MIN(size, 2 * pair * job->chunk_size);
+  int middle = MIN(size, (2 * pair + 1) * job->chunk_size);
+  int end = MIN(size, (2 * pair + 2) * job->chunk_size);
+  const int* order = &(*job->order)[0];
+  std::merge(order + start, order + middle, order + middle, order + end,
+             &(*job->merged)[0] + start, *job->less);
+}
+
+// An edge of a node of MinimalDawgBuilder. next is the index of a
+// registered node, or -1 for the end of every word through the edge.
+struct BuilderEdge {
+  UNICHAR_ID unichar_id;
+  bool word_end;
+  int next;
+};
+
+// Builds a minimal dawg incrementally from words that are added in sorted
+// order, using the algorithm of Daciuk, Mihov, Watson and Watson,
+// "Incremental Construction of Minimal Acyclic Finite-State Automata" (2000).
+// Only the nodes on the path of the last word added can still change. The
+// others are "registered" in a hash table of all the nodes that are final,
+// and each node on the path is replaced by an equivalent registered node, if
+// there is one, as soon as the next word no longer goes through it.
+class MinimalDawgBuilder {
+ public:
+  MinimalDawgBuilder() : path_length_(1), num_registered_(0) {
+    path_.push_back(GenericVector<BuilderEdge>());
+    table_.init_to_size(1024, -1);
+  }
+
+  // Adds the given word, which must sort after the last word added, and share
+  // the first prefix_length unichar ids with it.
+  void AddWord(const UNICHAR_ID* ids, int length, int prefix_length) {
+    Minimize(prefix_length);
+    while (path_.size() < length + 1)
+      path_.push_back(GenericVector<BuilderEdge>());
+    for (int i = prefix_length; i < length; ++i) {
+      BuilderEdge edge = { ids[i], i == length - 1, -1 };
+      path_[i].push_back(edge);
+      path_[i + 1].truncate(0);
+    }
+    path_length_ = length + 1;
+  }
+
+  // Registers the rest of the path. Only the root edges are left after this.
+  void Finish() {
+    Minimize(0);
+  }
+
+  const GenericVector<BuilderEdge>& root_edges() const { return path_[0]; }
+  int num_registered() const { return num_registered_; }
+  // Returns the edges of the registered nodes, end to end.
+  const GenericVector<BuilderEdge>& edges() const { return edges_; }
+  // Returns the index in edges() of the first edge of the given node.
+  int first_edge(int node) const { return first_edges_[node]; }
+  // Returns the number of edges of the given node.
+  int num_edges(int node) const {
+    return first_edges_[node + 1] - first_edges_[node];
+  }
+
+ private:
+  // Replaces the nodes of the path deeper than the given depth with their
+  // registered equivalents.
+  void Minimize(int depth) {
+    for (int d = path_length_ - 1; d > depth; --d) {
+      path_[d - 1].back().next = Register(path_[d]);
+      path_[d].truncate(0);
+    }
+    path_length_ = depth + 1;
+  }
+
+  // Returns a hash of the given edges.
+  static uinT32 Hash(const BuilderEdge* edges, int num_edges) {
+    uinT32 hash = num_edges;
+    for (int e = 0; e < num_edges; ++e) {
+      hash = hash * 31 + edges[e].unichar_id;
+      hash = hash * 31 + edges[e].next;
+      hash = hash * 2 + edges[e].word_end;
+    }
+    return hash;
+  }
+
+  // Returns true if the given registered node has the given edges.
+  bool NodeHasEdges(int node, const GenericVector<BuilderEdge>& edges) const {
+    if (num_edges(node) != edges.size()) return false;
+    const BuilderEdge* node_edges = &edges_[0] + first_edges_[node];
+    for (int e = 0; e < edges.size(); ++e) {
+      if (node_edges[e].unichar_id != edges[e].unichar_id ||
+          node_edges[e].word_end != edges[e].word_end ||
+          node_edges[e].next != edges[e].next)
+        return false;
+    }
+    return true;
+  }
+
+  // Returns the registered node with the given edges, registering it if it
+  // is new. A node with no edges is the end of every word, -1.
+  int Register(const GenericVector<BuilderEdge>& edges) {
+    if (edges.empty()) return -1;
+    int mask = table_.size() - 1;
+    int slot = Hash(&edges[0], edges.size()) & mask;
+    while (table_[slot] >= 0) {
+      if (NodeHasEdges(table_[slot], edges)) return table_[slot];
+      slot = (slot + 1) & mask;
+    }
+    int node = num_registered_++;
+    if (first_edges_.empty()) first_edges_.push_back(0);
+    for (int e = 0; e < edges.size(); ++e) edges_.push_back(edges[e]);
+    first_edges_.push_back(edges_.size());
+    table_[slot] = node;
+    if (num_registered_ * 2 > table_.size()) GrowTable();
+    return node;
+  }
+
+  // Doubles the size of the hash table, to keep it at most half full.
+  void GrowTable() {
+    table_.init_to_size(table_.size() * 2, -1);
+    int mask = table_.size() - 1;
+    for (int node = 0; node < num_registered_; ++node) {
+      int slot = Hash(&edges_[0] + first_edges_[node], num_edges(node)) & mask;
+      while (table_[slot] >= 0) slot = (slot + 1) & mask;
+      table_[slot] = node;
+    }
+  }
+
+  // The edges of the nodes on the path of the last word, from the root.
+  GenericVector<GenericVector<BuilderEdge> > path_;
+  // Number of nodes of path_ in use.
+  int path_length_;
+  // The registered nodes.
+  int num_registered_;
+  GenericVector<BuilderEdge> edges_;
+  GenericVector<int> first_edges_;
+  // Open addressing hash table of registered nodes, -1 for an empty slot.
+  GenericVector<int> table_;
+};
+
+// Builds a minimal SquishedDawg straight from the given words, which is much
+// faster than adding them to the trie and reducing it with trie_to_dawg.
+// The words are encoded and sorted using num_threads threads, and any that
+// can't be added to the trie are skipped. The trie itself is not used.
+SquishedDawg *Trie::words_to_dawg(const GenericVector<STRING>& words,
+                                  const UNICHARSET &unicharset,
+                                  int num_threads) {
+  int num_words = words.size();
+  ThreadPool* pool = num_threads > 1 ? new ThreadPool(num_threads) : NULL;
+  WordListJob job;
+  job.words = &words;
+  job.unicharset = &unicharset;
+  job.unicharset_size = unicharset_size_;
+  job.chunk_size = MAX(1, (num_words + num_threads * 4 - 1) /
+                          (num_threads * 4));
+  int num_chunks = (num_words + job.chunk_size - 1) / job.chunk_size;
+  job.chunk_ids.init_to_size(num_chunks, GenericVector<UNICHAR_ID>());
+  job.lengths.init_to_size(num_words, 0);
+  TessCallback1<int>* encode = NewPermanentTessCallback(&EncodeWordChunk, &job);
+  if (pool != NULL) {
+    pool->ParallelFor(num_chunks, encode);
+  } else {
+    for (int c = 0; c < num_chunks; ++c) encode->Run(c);
+  }
+  delete encode;
+  // Put the words end to end, and sort the valid ones.
+  GenericVector<UNICHAR_ID> ids;
+  GenericVector<int> starts;
+  GenericVector<int> order;
+  for (int c = 0; c < num_chunks; ++c) {
+    int start = ids.size();
+    ids += job.chunk_ids[c];
+    job.chunk_ids[c].clear();
+    int end = MIN(num_words, (c + 1) * job.chunk_size);
+    for (int w = c * job.chunk_size; w < end; ++w) {
+      starts.push_back(start);
+      start += job.lengths[w];
+      if (job.lengths[w] > 0) order.push_back(w);
+    }
+  }
+  if (debug_level_)
+    tprintf("Sorting %d words to build the dawg\n", order.size());
+  WordIdsLess less(ids, starts, job.lengths);
+  job.less = &less;
+  GenericVector<int> merged;
+  merged.init_to_size(order.size(), 0);
+  job.order = &order;
+  job.merged = &merged;
+  int num_runs = (order.size() + job.chunk_size - 1) / job.chunk_size;
+  TessCallback1<int>* sort = NewPermanentTessCallback(&SortWordRun, &job);
+  TessCallback1<int>* merge = NewPermanentTessCallback(&MergeWordRuns, &job);
+  if (pool != NULL) {
+    pool->ParallelFor(num_runs, sort);
+  } else {
+    for (int r = 0; r < num_runs; ++r) sort->Run(r);
+  }
+  for (; num_runs > 1; num_runs = (num_runs + 1) / 2) {
+    int num_pairs = (num_runs + 1) / 2;
+    if (pool != NULL) {
+      pool->ParallelFor(num_pairs, merge);
+    } else {
+      for (int p = 0; p < num_pairs; ++p) merge->Run(p);
+    }
+    GenericVector<int>* swap = job.order;
+    job.order = job.merged;
+    job.merged = swap;
+    job.chunk_size *= 2;
+  }
+  delete sort;
+  delete merge;
+  delete pool;
+  const GenericVector<int>& sorted = *job.order;
+
+  MinimalDawgBuilder builder;
+  int prev_word = -1;
+  for (int i = 0; i < sorted.size(); ++i) {
+    int w = sorted[i];
+    int prefix_length = 0;
+    if (prev_word >= 0) {
+      prefix_length = less.CommonPrefix(prev_word, w);
+      if (prefix_length == job.lengths[w] &&
+          prefix_length == job.lengths[prev_word])
+        continue;  // Duplicate.
+    }
+    builder.AddWord(&ids[0] + starts[w], job.lengths[w], prefix_length);
+    prev_word = w;
+  }
+  builder.Finish();
+
+  // The root goes first, as node 0, followed by the registered nodes.
+  const GenericVector<BuilderEdge>& root_edges = builder.root_edges();
+  const GenericVector<BuilderEdge>& node_edges = builder.edges();
+  int num_edges = root_edges.size() + node_edges.size();
+  if (debug_level_) {
+    tprintf("Built dawg of %d nodes and %d edges from %d words\n",
+            builder.num_registered() + 1, num_edges, sorted.size());
+  }
+  EDGE_ARRAY edge_array =
+    (EDGE_ARRAY) memalloc(MAX(1, num_edges) * sizeof(EDGE_RECORD));
+  EDGE_ARRAY edge_ptr = edge_array;
+  for (int node = -1; node < builder.num_registered(); ++node) {
+    const BuilderEdge* edges = node < 0 ? &root_edges[0]
+                                        : &node_edges[0] +
+                                          builder.first_edge(node);
+    int count = node < 0 ? root_edges.size() : builder.num_edges(node);
+    for (int e = 0; e < count; ++e, ++edge_ptr) {
+      NODE_REF next = 0;
+      if (edges[e].next >= 0)
+        next = root_edges.size() + builder.first_edge(edges[e].next);
+      link_edge(edge_ptr, next, false, FORWARD_EDGE, edges[e].word_end,
+                edges[e].unichar_id);
+      if (e == count - 1) set_marker_flag_in_edge_rec(edge_ptr);
+    }
+  }
+  return new SquishedDawg(edge_array, num_edges, type_, lang_,
+                          perm_, unicharset_size_, debug_level_);
+}
+
 bool Trie::eliminate_redundant_edges(NODE_REF node,
                                      const EDGE_RECORD &edge1,
                                      const EDGE_RECORD &edge2) {
@@ -709,6 +1047,17 @@ void Trie::reduce_node_input(NODE_REF node,
   }
 }
 
+int Trie::MemoryUsed() const {
+  int bytes = nodes_.size_reserved() * sizeof(TRIE_NODE_RECORD *);
+  for (int n = 0; n < nodes_.size(); ++n) {
+    bytes += sizeof(TRIE_NODE_RECORD);
+    bytes += nodes_[n]->forward_edges.size_reserved() * sizeof(EDGE_RECORD);
+    bytes += nodes_[n]->backward_edges.size_reserved() * sizeof(EDGE_RECORD);
+  }
+  bytes += root_back_freelist_.size_reserved() * sizeof(EDGE_INDEX);
+  return bytes;
+}
+
 void Trie::print_node(NODE_REF node, int max_num_edges) const {
   if (node == NO_EDGE) return;  // nothing to print
   TRIE_NODE_RECORD *node_ptr = nodes_[node];
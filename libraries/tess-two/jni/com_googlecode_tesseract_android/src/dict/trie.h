@@ -162,12 +162,23 @@ class Trie : public Dawg {
   // At most max_num_edges will be printed.
   void print_node(NODE_REF node, int max_num_edges) const;
 
+  // Returns the number of bytes of heap used by the nodes and edges.
+  int MemoryUsed() const;
+
   // Writes edges from nodes_ to an EDGE_ARRAY and creates a SquishedDawg.
   // Eliminates redundant edges and returns the pointer to the SquishedDawg.
   // Note: the caller is responsible for deallocating memory associated
   // with the returned SquishedDawg pointer.
   SquishedDawg *trie_to_dawg();
 
+  // Builds a minimal SquishedDawg straight from the given words, which is much
+  // faster than adding them to the trie and reducing it with trie_to_dawg.
+  // The words are encoded and sorted using num_threads threads, and any that
+  // can't be added to the trie are skipped. The trie itself is not used.
+  // Note: the caller is responsible for deleting the returned SquishedDawg.
+  SquishedDawg *words_to_dawg(const GenericVector<STRING>& words,
+                              const UNICHARSET &unicharset, int num_threads);
+
   // Reads a list of words from the given file and adds into the Trie.
   // Calls WERD_CHOICE::reverse_unichar_ids_if_rtl() according to the reverse
   // policy and information in the unicharset.
@@ -232,6 +243,10 @@ class Trie : public Dawg {
   // concrete characters from the unicharset at the beginning.
   bool read_pattern_list(const char *filename, const UNICHARSET &unicharset);
 
+  // Inserts a single pattern, written as in the pattern list file above,
+  // into the Trie. Returns false if the pattern could not be parsed.
+  bool add_pattern(const char *pattern, const UNICHARSET &unicharset);
+
   // Initializes the values of *_pattern_ unichar ids.
   // This function should be called before calling read_pattern_list().
   void initialize_patterns(UNICHARSET *unicharset);
@@ -18,9 +18,55 @@
 #include <string>
 #include "neural_net.h"
 #include "input_file_buffer.h"
+#include "simddetect.h"
 
 namespace tesseract {
 
+// Largest magnitude of the int8 weights, and largest quantized input.
+static const int kInt8Max = 127;
+
+// Scalar version of the DenseLayerFunc kernels.
+static bool DenseLayerScalar(const float *weights, const float *inputs,
+                             int stride, int num_outputs, float *sums) {
+  for (int o = 0; o < num_outputs; ++o, weights += stride) {
+    float sum = 0.0f;
+    for (int i = 0; i < stride; ++i) {
+      sum += weights[i] * inputs[i];
+    }
+    sums[o] = sum;
+  }
+  return true;
+}
+
+// Scalar version of the DenseLayerInt8Func kernels.
+static bool DenseLayerInt8Scalar(const inT8 *weights, const uinT8 *inputs,
+                                 int stride, int num_outputs, inT32 *sums) {
+  for (int o = 0; o < num_outputs; ++o, weights += stride) {
+    inT32 sum = 0;
+    for (int i = 0; i < stride; ++i) {
+      sum += weights[i] * inputs[i];
+    }
+    sums[o] = sum;
+  }
+  return true;
+}
+
+// Returns the fastest kernel for the dense layers, or NULL if there is none
+// and the scalar loop must be used.
+static DenseLayerFunc BestDenseLayerKernel() {
+  if (SIMDDetect::IsSSE2Available()) return DenseLayerSSE2;
+  if (SIMDDetect::IsNEONAvailable()) return DenseLayerNEON;
+  return NULL;
+}
+
+// As BestDenseLayerKernel, for the int8 weights of a quantized net.
+static DenseLayerInt8Func BestDenseLayerInt8Kernel() {
+  if (SIMDDetect::IsAVX2Available()) return DenseLayerInt8AVX2;
+  if (SIMDDetect::IsSSSE3Available()) return DenseLayerInt8SSSE3;
+  if (SIMDDetect::IsNEONAvailable()) return DenseLayerInt8NEON;
+  return NULL;
+}
+
 NeuralNet::NeuralNet() {
   Init();
 }
@@ -54,12 +100,36 @@ void NeuralNet::Init() {
   inputs_std_dev_.clear();
   inputs_min_.clear();
   inputs_max_.clear();
+  dense_layers_.clear();
+  dense_wts_.clear();
+  dense_acts_.clear();
+  dense_sums_.clear();
+  dense_qwts_.clear();
+  dense_qrow_sums_.clear();
+  dense_qacts_.clear();
+  dense_qsums_.clear();
+  dense_kernel_ = NULL;
+  dense_int8_kernel_ = NULL;
 }
 
 // Does a fast feedforward for read_only nets
 // Templatized for float and double Types
 template <typename Type> bool NeuralNet::FastFeedForward(const Type *inputs,
                                                          Type *outputs) {
+  if (!dense_layers_.empty()) {
+    for (int in = 0; in < in_cnt_; in++) {
+      dense_acts_[in] = inputs[in] - fast_nodes_[in].bias;
+    }
+    for (int l = 0; l < dense_layers_.size(); l++) {
+      DenseLayerForward(dense_layers_[l], 0, dense_layers_[l].out_cnt,
+                        &dense_acts_[0]);
+    }
+    const float *dense_outputs = &dense_acts_[dense_layers_.back().out_offset];
+    for (int out = 0; out < out_cnt_; out++) {
+      outputs[out] = dense_outputs[out];
+    }
+    return true;
+  }
   int node_idx = 0;
   Node *node = &fast_nodes_[0];
   // feed inputs in and offset them by the pre-computed bias
@@ -83,6 +153,52 @@ template <typename Type> bool NeuralNet::FastFeedForward(const Type *inputs,
   return true;
 }
 
+// Feeds a batch of inputs forward. The dense layers are run a block of
+// kDenseBatchRows rows at a time over every input of the batch, so the
+// block stays in cache while it is used for the whole batch.
+bool NeuralNet::FeedForwardBatch(const float *inputs, int batch_cnt,
+                                 float *outputs) {
+  if (dense_layers_.empty()) {
+    for (int b = 0; b < batch_cnt; b++) {
+      if (!FeedForward(inputs + b * in_cnt_, outputs + b * out_cnt_)) {
+        return false;
+      }
+    }
+    return true;
+  }
+  const int kDenseBatchRows = 16;
+  int acts_size = dense_acts_.size();
+  // Only the real activations are ever written, so the padding stays zero.
+  if (dense_batch_acts_.size() < batch_cnt * acts_size) {
+    dense_batch_acts_.assign(batch_cnt * acts_size, 0.0f);
+  }
+  for (int b = 0; b < batch_cnt; b++) {
+    float *acts = &dense_batch_acts_[b * acts_size];
+    for (int in = 0; in < in_cnt_; in++) {
+      acts[in] = inputs[b * in_cnt_ + in] - fast_nodes_[in].bias;
+    }
+  }
+  for (int l = 0; l < dense_layers_.size(); l++) {
+    const DenseLayer &layer = dense_layers_[l];
+    for (int row = 0; row < layer.out_cnt; row += kDenseBatchRows) {
+      int row_cnt = layer.out_cnt - row < kDenseBatchRows ?
+          layer.out_cnt - row : kDenseBatchRows;
+      for (int b = 0; b < batch_cnt; b++) {
+        DenseLayerForward(layer, row, row_cnt,
+                          &dense_batch_acts_[b * acts_size]);
+      }
+    }
+  }
+  int out_offset = dense_layers_.back().out_offset;
+  for (int b = 0; b < batch_cnt; b++) {
+    const float *acts = &dense_batch_acts_[b * acts_size + out_offset];
+    for (int out = 0; out < out_cnt_; out++) {
+      outputs[b * out_cnt_ + out] = acts[out];
+    }
+  }
+  return true;
+}
+
 // Performs a feedforward for general nets. Used mainly in training mode
 // Templatized for float and double Types
 template <typename Type> bool NeuralNet::FeedForward(const Type *inputs,
@@ -187,7 +303,259 @@ bool NeuralNet::CreateFastNet() {
     }
   }
   // sanity check
-  return wts_cnt_ == wts_cnt;
+  if (wts_cnt_ != wts_cnt) {
+    return false;
+  }
+  CreateDenseNet();
+  return true;
+}
+
+// Compiles the fast nodes into dense layers when the net is made of fully
+// connected layers, as the cube character nets are, so the feedforward is
+// a matrix-vector product per layer instead of a pointer walk per weight.
+void NeuralNet::CreateDenseNet() {
+  dense_layers_.clear();
+  dense_wts_.clear();
+  int prev_start = 0;
+  int prev_cnt = in_cnt_;
+  int acts_size = DensePadded(in_cnt_);
+  int node_idx = in_cnt_;
+  vector<float> row;
+  while (node_idx < neuron_cnt_) {
+    DenseLayer layer;
+    layer.in_offset = dense_layers_.empty() ? 0 :
+        dense_layers_.back().out_offset;
+    layer.in_cnt = prev_cnt;
+    layer.stride = DensePadded(prev_cnt);
+    layer.out_offset = acts_size;
+    layer.out_cnt = 0;
+    layer.wts_offset = dense_wts_.size();
+    layer.first_node = node_idx;
+    layer.qstride = 0;
+    layer.qwts_offset = 0;
+    layer.qscale = 0.0f;
+    // Take the following nodes that are fed by exactly all the previous
+    // layer, placing each weight in the column of its input.
+    for (; node_idx < neuron_cnt_; node_idx++) {
+      const Node &node = fast_nodes_[node_idx];
+      if (node.fan_in_cnt != prev_cnt) {
+        break;
+      }
+      row.assign(layer.stride, 0.0f);
+      vector<bool> seen(prev_cnt, false);
+      bool complete = true;
+      for (int fan_in = 0; fan_in < node.fan_in_cnt && complete; fan_in++) {
+        int col = node.inputs[fan_in].input_node - &fast_nodes_[prev_start];
+        if (col < 0 || col >= prev_cnt || seen[col]) {
+          complete = false;
+        } else {
+          seen[col] = true;
+          row[col] = node.inputs[fan_in].input_weight;
+        }
+      }
+      if (!complete) {
+        break;
+      }
+      dense_wts_.insert(dense_wts_.end(), row.begin(), row.end());
+      layer.out_cnt++;
+    }
+    if (layer.out_cnt == 0) {
+      // An irregular net. Keep walking the nodes.
+      dense_layers_.clear();
+      dense_wts_.clear();
+      return;
+    }
+    dense_layers_.push_back(layer);
+    acts_size += DensePadded(layer.out_cnt);
+    prev_start = layer.first_node;
+    prev_cnt = layer.out_cnt;
+  }
+  if (dense_layers_.back().out_cnt != out_cnt_) {
+    dense_layers_.clear();
+    dense_wts_.clear();
+    return;
+  }
+  AllocDenseBuffers(acts_size);
+}
+
+void NeuralNet::AllocDenseBuffers(int acts_size) {
+  // The padding of the activations stays zero.
+  dense_acts_.assign(acts_size, 0.0f);
+  dense_batch_acts_.clear();
+  int max_in_cnt = 0;
+  int max_out_cnt = 0;
+  for (int l = 0; l < dense_layers_.size(); l++) {
+    if (dense_layers_[l].in_cnt > max_in_cnt) {
+      max_in_cnt = dense_layers_[l].in_cnt;
+    }
+    if (dense_layers_[l].out_cnt > max_out_cnt) {
+      max_out_cnt = dense_layers_[l].out_cnt;
+    }
+  }
+  dense_sums_.resize(max_out_cnt);
+  dense_kernel_ = BestDenseLayerKernel();
+  if (!dense_qwts_.empty()) {
+    dense_qacts_.assign(DenseInt8Padded(max_in_cnt), 0);
+    dense_qsums_.resize(max_out_cnt);
+    dense_int8_kernel_ = BestDenseLayerInt8Kernel();
+  }
+}
+
+void NeuralNet::ComputeQRowSums() {
+  dense_qrow_sums_.clear();
+  for (int l = 0; l < dense_layers_.size(); l++) {
+    const DenseLayer &layer = dense_layers_[l];
+    const inT8 *row = &dense_qwts_[layer.qwts_offset];
+    for (int out = 0; out < layer.out_cnt; out++, row += layer.qstride) {
+      inT32 sum = 0;
+      for (int in = 0; in < layer.in_cnt; in++) {
+        sum += row[in];
+      }
+      dense_qrow_sums_.push_back(sum);
+    }
+  }
+}
+
+// Quantizes each layer with the scale that maps its largest weight to
+// kInt8Max. The activations are quantized when they are used, in
+// DenseLayerForwardInt8.
+bool NeuralNet::Quantize() {
+  if (dense_layers_.empty()) {
+    return false;
+  }
+  if (!dense_qwts_.empty()) {
+    return true;
+  }
+  for (int l = 0; l < dense_layers_.size(); l++) {
+    DenseLayer &layer = dense_layers_[l];
+    const float *wts = &dense_wts_[layer.wts_offset];
+    float max_wt = 0.0f;
+    for (int i = 0; i < layer.out_cnt * layer.stride; i++) {
+      if (fabs(wts[i]) > max_wt) {
+        max_wt = fabs(wts[i]);
+      }
+    }
+    layer.qscale = max_wt > 0.0f ? max_wt / kInt8Max : 1.0f;
+    layer.qstride = DenseInt8Padded(layer.in_cnt);
+    layer.qwts_offset = dense_qwts_.size();
+    dense_qwts_.resize(dense_qwts_.size() + layer.out_cnt * layer.qstride, 0);
+    inT8 *qwts = &dense_qwts_[layer.qwts_offset];
+    for (int out = 0; out < layer.out_cnt; out++) {
+      for (int in = 0; in < layer.in_cnt; in++) {
+        qwts[out * layer.qstride + in] = static_cast<inT8>(
+            floor(wts[out * layer.stride + in] / layer.qscale + 0.5f));
+      }
+    }
+  }
+  // Release the float weights.
+  vector<float>().swap(dense_wts_);
+  ComputeQRowSums();
+  AllocDenseBuffers(dense_acts_.size());
+  return true;
+}
+
+bool NeuralNet::WriteInt8Binary(FILE *fp) const {
+  if (dense_qwts_.empty()) {
+    return false;
+  }
+  unsigned int signature = kInt8NetSignature;
+  inT32 layer_cnt = dense_layers_.size();
+  if (fwrite(&signature, sizeof(signature), 1, fp) != 1 ||
+      fwrite(&in_cnt_, sizeof(in_cnt_), 1, fp) != 1 ||
+      fwrite(&layer_cnt, sizeof(layer_cnt), 1, fp) != 1) {
+    return false;
+  }
+  vector<float> biases;
+  for (int in = 0; in < in_cnt_; in++) {
+    biases.push_back(fast_nodes_[in].bias);
+  }
+  if (fwrite(&biases[0], sizeof(biases[0]), in_cnt_, fp) != in_cnt_) {
+    return false;
+  }
+  for (int l = 0; l < layer_cnt; l++) {
+    const DenseLayer &layer = dense_layers_[l];
+    if (fwrite(&layer.out_cnt, sizeof(layer.out_cnt), 1, fp) != 1 ||
+        fwrite(&layer.qscale, sizeof(layer.qscale), 1, fp) != 1) {
+      return false;
+    }
+    biases.clear();
+    for (int out = 0; out < layer.out_cnt; out++) {
+      biases.push_back(fast_nodes_[layer.first_node + out].bias);
+    }
+    if (fwrite(&biases[0], sizeof(biases[0]), layer.out_cnt, fp) !=
+        layer.out_cnt) {
+      return false;
+    }
+    const inT8 *row = &dense_qwts_[layer.qwts_offset];
+    for (int out = 0; out < layer.out_cnt; out++, row += layer.qstride) {
+      if (fwrite(row, 1, layer.in_cnt, fp) != layer.in_cnt) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+// Runs the rows of one dense layer through the SIMD kernel, or the scalar
+// loop, then the sigmoid.
+void NeuralNet::DenseLayerForward(const DenseLayer &layer, int first_row,
+                                  int row_cnt, float *acts) {
+  if (!dense_qwts_.empty()) {
+    DenseLayerForwardInt8(layer, first_row, row_cnt, acts);
+    return;
+  }
+  const float *wts = &dense_wts_[layer.wts_offset + first_row * layer.stride];
+  const float *ins = acts + layer.in_offset;
+  float *sums = &dense_sums_[0];
+  if (dense_kernel_ == NULL ||
+      !dense_kernel_(wts, ins, layer.stride, row_cnt, sums)) {
+    DenseLayerScalar(wts, ins, layer.stride, row_cnt, sums);
+  }
+  float *outs = acts + layer.out_offset + first_row;
+  const Node *node = &fast_nodes_[layer.first_node + first_row];
+  for (int r = 0; r < row_cnt; r++, node++) {
+    outs[r] = Neuron::Sigmoid(sums[r] - node->bias);
+  }
+}
+
+// Quantizes the inputs of the layer to q in [0, kInt8Max], each standing
+// for lo + step * q, so that the sum of the int8 weights w times the inputs
+// is qscale * (step * sum(w * q) + lo * sum(w)).
+void NeuralNet::DenseLayerForwardInt8(const DenseLayer &layer, int first_row,
+                                      int row_cnt, float *acts) {
+  const float *ins = acts + layer.in_offset;
+  float lo = ins[0];
+  float hi = ins[0];
+  for (int in = 1; in < layer.in_cnt; in++) {
+    if (ins[in] < lo) {
+      lo = ins[in];
+    } else if (ins[in] > hi) {
+      hi = ins[in];
+    }
+  }
+  float step = (hi - lo) / kInt8Max;
+  float inv_step = step > 0.0f ? 1.0f / step : 0.0f;
+  // Columns past in_cnt have zero weights, so whatever a wider layer left
+  // there does not count.
+  uinT8 *qins = &dense_qacts_[0];
+  for (int in = 0; in < layer.in_cnt; in++) {
+    qins[in] = static_cast<uinT8>((ins[in] - lo) * inv_step + 0.5f);
+  }
+  const inT8 *wts =
+      &dense_qwts_[layer.qwts_offset + first_row * layer.qstride];
+  inT32 *sums = &dense_qsums_[0];
+  if (dense_int8_kernel_ == NULL ||
+      !dense_int8_kernel_(wts, qins, layer.qstride, row_cnt, sums)) {
+    DenseLayerInt8Scalar(wts, qins, layer.qstride, row_cnt, sums);
+  }
+  int first_node = layer.first_node + first_row;
+  const inT32 *row_sums = &dense_qrow_sums_[first_node - in_cnt_];
+  float *outs = acts + layer.out_offset + first_row;
+  const Node *node = &fast_nodes_[first_node];
+  for (int r = 0; r < row_cnt; r++, node++) {
+    float sum = layer.qscale * (step * sums[r] + lo * row_sums[r]);
+    outs[r] = Neuron::Sigmoid(sum - node->bias);
+  }
 }
 
 // returns a pointer to the requested set of weights
@@ -234,6 +602,20 @@ NeuralNet *NeuralNet::FromInputBuffer(InputFileBuffer *ib) {
 template <typename Type> bool NeuralNet::FastGetNetOutput(const Type *inputs,
                                                           int output_id,
                                                           Type *output) {
+  if (!dense_layers_.empty()) {
+    for (int in = 0; in < in_cnt_; in++) {
+      dense_acts_[in] = inputs[in] - fast_nodes_[in].bias;
+    }
+    int last = dense_layers_.size() - 1;
+    for (int l = 0; l < last; l++) {
+      DenseLayerForward(dense_layers_[l], 0, dense_layers_[l].out_cnt,
+                        &dense_acts_[0]);
+    }
+    // The last layer is the outputs, so only the requested row is needed.
+    DenseLayerForward(dense_layers_[last], output_id, 1, &dense_acts_[0]);
+    (*output) = dense_acts_[dense_layers_[last].out_offset + output_id];
+    return true;
+  }
   // feed inputs in and offset them by the pre-computed bias
   int node_idx = 0;
   Node *node = &fast_nodes_[0];
@@ -22,6 +22,7 @@
 #include <vector>
 #include "neuron.h"
 #include "input_file_buffer.h"
+#include "netsimd.h"
 
 namespace tesseract {
 
@@ -45,6 +46,19 @@ class NeuralNet {
     template <typename Type> bool GetNetOutput(const Type *inputs,
                                                int output_id,
                                                Type *output);
+    // Feeds batch_cnt input vectors of in_cnt() floats, stored one after the
+    // other, forward, writing the out_cnt() outputs of each in turn. For nets
+    // with a dense version, each block of weights is loaded once for the
+    // whole batch instead of once per input.
+    bool FeedForwardBatch(const float *inputs, int batch_cnt, float *outputs);
+    // Replaces the float weights of the dense version of the net by int8
+    // weights with a scale per layer, which are a quarter of the size and
+    // run through the integer kernel. Returns false, leaving the net as it
+    // was, if the net has no dense version.
+    bool Quantize();
+    // Writes a quantized net in the int8 format, which ReadBinary loads
+    // straight into the dense layers. Returns false on error.
+    bool WriteInt8Binary(FILE *fp) const;
     // Accessor functions
     int in_cnt() const { return in_cnt_; }
     int out_cnt() const { return out_cnt_; }
@@ -86,6 +100,8 @@ class NeuralNet {
     // Magic number expected at the beginning of the NN
     // binary file
     static const unsigned int kNetSignature = 0xFEFEABD0;
+    // Magic number of a net written by WriteInt8Binary
+    static const unsigned int kInt8NetSignature = 0xFEFEABD1;
     // count of allocated wgts in the last chunk
     int alloc_wgt_cnt_;
     // vector of weights buffers
@@ -103,6 +119,43 @@ class NeuralNet {
     // vector of input offsets used by fast read-only
     // feedforward function
     vector<Node> fast_nodes_;
+    // A fully connected layer of the dense version of a read-only net.
+    // The inputs and outputs are padded regions of dense_acts_, and the
+    // weights a matrix of out_cnt rows of stride weights in dense_wts_,
+    // with a zero weight in each padding column. Once quantized, the
+    // weights are instead qscale times the rows of qstride int8 weights in
+    // dense_qwts_.
+    struct DenseLayer {
+      int in_offset;
+      int in_cnt;
+      int stride;
+      int out_offset;
+      int out_cnt;
+      int wts_offset;
+      // index in fast_nodes_ of the node of the first output
+      int first_node;
+      int qstride;
+      int qwts_offset;
+      float qscale;
+    };
+    // Layers of the dense version of the net, empty if the net is not made
+    // of fully connected layers, in which case fast_nodes_ is walked.
+    vector<DenseLayer> dense_layers_;
+    vector<float> dense_wts_;
+    vector<float> dense_acts_;
+    vector<float> dense_sums_;
+    // dense_acts_ for each input of a batch, one after the other.
+    vector<float> dense_batch_acts_;
+    // Int8 weights of a quantized net, empty if the net is not quantized,
+    // the sum of each row of them, in node order, and the inputs of a layer
+    // quantized to [0, 127].
+    vector<inT8> dense_qwts_;
+    vector<inT32> dense_qrow_sums_;
+    vector<uinT8> dense_qacts_;
+    vector<inT32> dense_qsums_;
+    // SIMD kernels for the dense layers, or NULL for the scalar loops.
+    DenseLayerFunc dense_kernel_;
+    DenseLayerInt8Func dense_int8_kernel_;
     // Network Initialization function
     void Init();
     // Clears all neurons
@@ -122,6 +175,9 @@ class NeuralNet {
       if (input_buff->Read(&read_val, sizeof(read_val)) != sizeof(read_val)) {
         return false;
       }
+      if (read_val == kInt8NetSignature) {
+        return ReadInt8Binary(input_buff);
+      }
       if (read_val != kNetSignature) {
         return false;
       }
@@ -227,11 +283,117 @@ class NeuralNet {
       return true;
     }
 
+    // Reads the rest of a net in the int8 format, after its signature:
+    // the input count, layer count and input biases, then for each layer
+    // its output count, weight scale, biases and int8 weights, one row of
+    // the previous layer's count per output.
+    template<class ReadBuffType> bool ReadInt8Binary(ReadBuffType *input_buff) {
+      inT32 layer_cnt;
+      if (input_buff->Read(&in_cnt_, sizeof(in_cnt_)) != sizeof(in_cnt_) ||
+          input_buff->Read(&layer_cnt, sizeof(layer_cnt)) !=
+          sizeof(layer_cnt)) {
+        return false;
+      }
+      if (in_cnt_ <= 0 || layer_cnt <= 0) {
+        return false;
+      }
+      vector<Node> nodes(in_cnt_);
+      vector<float> floats(in_cnt_);
+      if (input_buff->Read(&floats[0], sizeof(floats[0]) * in_cnt_) !=
+          sizeof(floats[0]) * in_cnt_) {
+        return false;
+      }
+      for (int in = 0; in < in_cnt_; in++) {
+        nodes[in].bias = floats[in];
+      }
+      vector<inT8> row;
+      int prev_cnt = in_cnt_;
+      int acts_size = DensePadded(in_cnt_);
+      for (int l = 0; l < layer_cnt; l++) {
+        DenseLayer layer;
+        float qscale;
+        if (input_buff->Read(&layer.out_cnt, sizeof(layer.out_cnt)) !=
+            sizeof(layer.out_cnt) ||
+            input_buff->Read(&qscale, sizeof(qscale)) != sizeof(qscale)) {
+          return false;
+        }
+        if (layer.out_cnt <= 0) {
+          return false;
+        }
+        layer.in_offset = dense_layers_.empty() ? 0 :
+            dense_layers_.back().out_offset;
+        layer.in_cnt = prev_cnt;
+        layer.stride = DensePadded(prev_cnt);
+        layer.out_offset = acts_size;
+        layer.wts_offset = 0;
+        layer.first_node = nodes.size();
+        layer.qstride = DenseInt8Padded(prev_cnt);
+        layer.qwts_offset = dense_qwts_.size();
+        layer.qscale = qscale;
+        floats.resize(layer.out_cnt);
+        if (input_buff->Read(&floats[0], sizeof(floats[0]) * layer.out_cnt) !=
+            sizeof(floats[0]) * layer.out_cnt) {
+          return false;
+        }
+        row.assign(layer.qstride, 0);
+        for (int out = 0; out < layer.out_cnt; out++) {
+          if (input_buff->Read(&row[0], prev_cnt) != prev_cnt) {
+            return false;
+          }
+          dense_qwts_.insert(dense_qwts_.end(), row.begin(), row.end());
+          Node node;
+          node.bias = floats[out];
+          nodes.push_back(node);
+        }
+        dense_layers_.push_back(layer);
+        acts_size += DensePadded(layer.out_cnt);
+        prev_cnt = layer.out_cnt;
+      }
+      // The int8 net has no neurons: every node is only a bias.
+      for (int node_idx = 0; node_idx < nodes.size(); node_idx++) {
+        nodes[node_idx].out = 0.0f;
+        nodes[node_idx].fan_in_cnt = 0;
+        nodes[node_idx].inputs = NULL;
+      }
+      fast_nodes_.swap(nodes);
+      neuron_cnt_ = fast_nodes_.size();
+      out_cnt_ = prev_cnt;
+      ComputeQRowSums();
+      AllocDenseBuffers(acts_size);
+      return true;
+    }
+    // Rounds count up to a whole number of kDenseLayerPadding floats, or
+    // kDenseLayerInt8Padding int8 weights.
+    static int DensePadded(int count) {
+      return (count + kDenseLayerPadding - 1) / kDenseLayerPadding *
+          kDenseLayerPadding;
+    }
+    static int DenseInt8Padded(int count) {
+      return (count + kDenseLayerInt8Padding - 1) / kDenseLayerInt8Padding *
+          kDenseLayerInt8Padding;
+    }
     // creates a connection between two nodes
     bool SetConnection(int from, int to);
     // Create a read only version of the net that
     // has faster feedforward performance
     bool CreateFastNet();
+    // Compiles fast_nodes_ into dense_layers_ if every node past the inputs
+    // is fed by exactly all the nodes of the layer before it, and the last
+    // layer is the outputs.
+    void CreateDenseNet();
+    // Sizes the activation and sum buffers of the dense layers, given the
+    // total size of the activations, and picks the kernels.
+    void AllocDenseBuffers(int acts_size);
+    // Fills dense_qrow_sums_ from dense_qwts_.
+    void ComputeQRowSums();
+    // Computes the outputs of rows [first_row, first_row + row_cnt) of the
+    // given dense layer from its inputs, in the activations acts, laid out
+    // as dense_acts_.
+    void DenseLayerForward(const DenseLayer &layer, int first_row,
+                           int row_cnt, float *acts);
+    // DenseLayerForward for a quantized net.
+    void DenseLayerForwardInt8(const DenseLayer &layer, int first_row,
+                               int row_cnt, float *acts);
     // internal function to allocate a new set of weights
     // Centralized weight allocation attempts to increase
     // weights locality of reference making it more cache friendly
@@ -25,6 +25,7 @@
 #else
 #include <CL/cl.h>
 #endif
+#include "opencl_loader.h"
 
 #define DS_DEVICE_NAME_LENGTH 256
 
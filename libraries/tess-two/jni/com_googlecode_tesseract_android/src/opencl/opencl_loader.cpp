@@ -0,0 +1,90 @@
+///////////////////////////////////////////////////////////////////////
+// File:        opencl_loader.cpp
+// Description: Run-time loading of the OpenCL library on Android.
+//
+// (C) Copyright 2016, Google Inc.
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////
+
+#if defined(USE_OPENCL) && defined(ANDROID)
+
+#include <dlfcn.h>
+#include <CL/cl.h>
+#include "opencl_loader.h"
+#include "tprintf.h"
+
+#define TESS_DEFINE_OPENCL_FUNCTION(name) tess_##name##_fn tess_##name = NULL;
+TESS_OPENCL_FUNCTIONS(TESS_DEFINE_OPENCL_FUNCTION)
+#undef TESS_DEFINE_OPENCL_FUNCTION
+
+namespace tesseract {
+
+// Where the GPU vendors put their OpenCL library, most common first.
+static const char* const kOpenclLibraries[] = {
+  "libOpenCL.so",
+#if defined(__LP64__)
+  "/system/vendor/lib64/libOpenCL.so",
+  "/vendor/lib64/libOpenCL.so",
+  "/system/lib64/libOpenCL.so",
+  "/system/vendor/lib64/egl/libGLES_mali.so",
+  "/system/lib64/egl/libGLES_mali.so",
+  "/system/vendor/lib64/libPVROCL.so",
+#else
+  "/system/vendor/lib/libOpenCL.so",
+  "/vendor/lib/libOpenCL.so",
+  "/system/lib/libOpenCL.so",
+  "/system/vendor/lib/egl/libGLES_mali.so",
+  "/system/lib/egl/libGLES_mali.so",
+  "/system/vendor/lib/libPVROCL.so",
+#endif
+  NULL
+};
+
+// Sets all the function pointers from handle, or none of them, returning
+// false, if any is missing.
+static bool LoadFunctions(void* handle) {
+#define TESS_LOAD_OPENCL_FUNCTION(name) \
+  tess_##name##_fn name##_ptr = \
+      reinterpret_cast<tess_##name##_fn>(dlsym(handle, #name)); \
+  if (name##_ptr == NULL) { \
+    tprintf("OpenCL library lacks %s\n", #name); \
+    return false; \
+  }
+  TESS_OPENCL_FUNCTIONS(TESS_LOAD_OPENCL_FUNCTION)
+#undef TESS_LOAD_OPENCL_FUNCTION
+#define TESS_SET_OPENCL_FUNCTION(name) tess_##name = name##_ptr;
+  TESS_OPENCL_FUNCTIONS(TESS_SET_OPENCL_FUNCTION)
+#undef TESS_SET_OPENCL_FUNCTION
+  return true;
+}
+
+static bool LoadLibraryOnce() {
+  for (int i = 0; kOpenclLibraries[i] != NULL; ++i) {
+    void* handle = dlopen(kOpenclLibraries[i], RTLD_NOW | RTLD_LOCAL);
+    if (handle == NULL) continue;
+    if (LoadFunctions(handle)) {
+      // The library stays loaded for the life of the process.
+      return true;
+    }
+    dlclose(handle);
+  }
+  return false;
+}
+
+bool LoadOpenclLibrary() {
+  static const bool loaded = LoadLibraryOnce();
+  return loaded;
+}
+
+}  // namespace tesseract
+
+#endif  // USE_OPENCL && ANDROID
@@ -0,0 +1,99 @@
+///////////////////////////////////////////////////////////////////////
+// File:        opencl_loader.h
+// Description: Run-time loading of the OpenCL library on Android.
+//
+// (C) Copyright 2016, Google Inc.
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////
+
+// Android has no system OpenCL library to link with: where there is one,
+// it comes with the GPU driver of the vendor, under one of several names.
+// So on Android, every OpenCL function that Tesseract uses is called
+// through a pointer, set by LoadOpenclLibrary from whichever library is
+// found at run time. Include after CL/cl.h.
+
+#ifndef TESSERACT_OPENCL_OPENCL_LOADER_H_
+#define TESSERACT_OPENCL_OPENCL_LOADER_H_
+
+#if defined(USE_OPENCL) && defined(ANDROID)
+
+// The OpenCL functions used by Tesseract.
+#define TESS_OPENCL_FUNCTIONS(X) \
+  X(clBuildProgram) \
+  X(clCreateBuffer) \
+  X(clCreateCommandQueue) \
+  X(clCreateContext) \
+  X(clCreateKernel) \
+  X(clCreateProgramWithBinary) \
+  X(clCreateProgramWithSource) \
+  X(clEnqueueCopyBuffer) \
+  X(clEnqueueMapBuffer) \
+  X(clEnqueueNDRangeKernel) \
+  X(clEnqueueUnmapMemObject) \
+  X(clFinish) \
+  X(clGetContextInfo) \
+  X(clGetDeviceIDs) \
+  X(clGetDeviceInfo) \
+  X(clGetPlatformIDs) \
+  X(clGetProgramBuildInfo) \
+  X(clGetProgramInfo) \
+  X(clReleaseCommandQueue) \
+  X(clReleaseContext) \
+  X(clReleaseMemObject) \
+  X(clReleaseProgram) \
+  X(clSetKernelArg)
+
+// Declares the type of a pointer to each function, taken from its
+// declaration in CL/cl.h, and the pointer itself.
+#define TESS_DECLARE_OPENCL_FUNCTION(name) \
+  typedef decltype(&::name) tess_##name##_fn; \
+  extern tess_##name##_fn tess_##name;
+TESS_OPENCL_FUNCTIONS(TESS_DECLARE_OPENCL_FUNCTION)
+#undef TESS_DECLARE_OPENCL_FUNCTION
+
+namespace tesseract {
+
+// Loads the OpenCL library of the device and sets the function pointers,
+// the first time it is called. Returns false, leaving Tesseract to run
+// without OpenCL, if there is no library or it lacks any of the functions.
+bool LoadOpenclLibrary();
+
+}  // namespace tesseract
+
+// Makes the calls of the OpenCL code go through the pointers.
+#define clBuildProgram (*tess_clBuildProgram)
+#define clCreateBuffer (*tess_clCreateBuffer)
+#define clCreateCommandQueue (*tess_clCreateCommandQueue)
+#define clCreateContext (*tess_clCreateContext)
+#define clCreateKernel (*tess_clCreateKernel)
+#define clCreateProgramWithBinary (*tess_clCreateProgramWithBinary)
+#define clCreateProgramWithSource (*tess_clCreateProgramWithSource)
+#define clEnqueueCopyBuffer (*tess_clEnqueueCopyBuffer)
+#define clEnqueueMapBuffer (*tess_clEnqueueMapBuffer)
+#define clEnqueueNDRangeKernel (*tess_clEnqueueNDRangeKernel)
+#define clEnqueueUnmapMemObject (*tess_clEnqueueUnmapMemObject)
+#define clFinish (*tess_clFinish)
+#define clGetContextInfo (*tess_clGetContextInfo)
+#define clGetDeviceIDs (*tess_clGetDeviceIDs)
+#define clGetDeviceInfo (*tess_clGetDeviceInfo)
+#define clGetPlatformIDs (*tess_clGetPlatformIDs)
+#define clGetProgramBuildInfo (*tess_clGetProgramBuildInfo)
+#define clGetProgramInfo (*tess_clGetProgramInfo)
+#define clReleaseCommandQueue (*tess_clReleaseCommandQueue)
+#define clReleaseContext (*tess_clReleaseContext)
+#define clReleaseMemObject (*tess_clReleaseMemObject)
+#define clReleaseProgram (*tess_clReleaseProgram)
+#define clSetKernelArg (*tess_clSetKernelArg)
+
+#endif  // USE_OPENCL && ANDROID
+
+#endif  // TESSERACT_OPENCL_OPENCL_LOADER_H_
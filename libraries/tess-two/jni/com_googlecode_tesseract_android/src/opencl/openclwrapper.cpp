@@ -17,6 +17,7 @@
 
 #include "openclwrapper.h"
 #include "oclkernels.h"
+#include "svutil.h"
 
 // for micro-benchmark
 #include "otsuthr.h"
@@ -53,6 +54,17 @@ ds_device OpenclDevice::selectedDevice;
 
 int OpenclDevice::isInited = 0;
 
+// Serializes InitEnv.
+static SVMutex init_mutex;
+// Guards init_pending and the cache directory. Never held across InitEnv,
+// so that checking init_pending does not wait for the kernels to compile.
+static SVMutex state_mutex;
+// True while InitEnvAsync is running InitEnv on its thread.
+static bool init_pending = false;
+// Set by SetCacheDir, with a trailing separator unless empty.
+static STRING cache_dir;
+static bool cache_dir_set = false;
+
 static l_int32 MORPH_BC = ASYMMETRIC_MORPH_BC;
 
 static const l_uint32 lmask32[] = {
@@ -71,6 +83,7 @@ static const l_uint32 rmask32[] = {
     0x01ffffff, 0x03ffffff, 0x07ffffff, 0x0fffffff, 0x1fffffff, 0x3fffffff,
     0x7fffffff, 0xffffffff};
 
+#ifdef USE_OPENCL_TIFF
 struct tiff_transform {
     int vflip;    /* if non-zero, image needs a vertical fip */
     int hflip;    /* if non-zero, image needs a horizontal flip */
@@ -91,9 +104,18 @@ static struct tiff_transform tiff_orientation_transforms[] = {
 };
 
 static const l_int32 MAX_PAGES_IN_TIFF_FILE = 3000;
+#endif  // USE_OPENCL_TIFF
 
 cl_mem pixsCLBuffer, pixdCLBuffer, pixdCLIntermediate; //Morph operations buffers
 cl_mem pixThBuffer; //output from thresholdtopix calculation
+// The morph buffers are kept from page to page while the image size stays
+// the same. morphBufferWords is their size in words.
+static size_t morphBufferWords = 0;
+// The host data of the Pix that pixThBuffer maps, and its size in words, so
+// that the morph operations use the thresholded image still on the device
+// only if they are run on that same Pix.
+static l_uint32 *pixThData = NULL;
+static size_t pixThWords = 0;
 cl_int clStatus;
 KernelEnv rEnv;
 
@@ -121,6 +143,54 @@ void legalizeFileName( char *fileName) {
     }
 }
 
+// Sets cache_dir from dir. state_mutex must be held.
+static void SetCacheDirLocked(const char* dir) {
+  cache_dir = dir != NULL ? dir : "";
+  if (cache_dir.length() > 0 && cache_dir[cache_dir.length() - 1] != '/')
+    cache_dir += '/';
+  cache_dir_set = true;
+}
+
+void OpenclDevice::SetCacheDir(const char* dir) {
+  SVAutoLock lock(&state_mutex);
+  SetCacheDirLocked(dir);
+}
+
+STRING OpenclDevice::CachePath(const char* fileName) {
+  SVAutoLock lock(&state_mutex);
+  if (!cache_dir_set)
+    SetCacheDirLocked(getenv("TESSERACT_OPENCL_CACHE_DIR"));
+  return cache_dir + fileName;
+}
+
+// Returns the path of the compiled clFileName for device. The name holds
+// the device name, the driver version and a hash of the kernel source, so
+// that a driver update or a change to the kernels never loads a stale
+// binary.
+static STRING KernelBinaryPath(cl_device_id device, const char* clFileName) {
+  char deviceName[1024] = {0};
+  char driverVersion[256] = {0};
+  if (clGetDeviceInfo(device, CL_DEVICE_NAME, sizeof(deviceName), deviceName,
+                      NULL) != CL_SUCCESS)
+    deviceName[0] = '\0';
+  if (clGetDeviceInfo(device, CL_DRIVER_VERSION, sizeof(driverVersion),
+                      driverVersion, NULL) != CL_SUCCESS)
+    driverVersion[0] = '\0';
+  // FNV-1a.
+  l_uint32 hash = 2166136261u;
+  for (const char* src = kernel_src; *src != '\0'; ++src) {
+    hash ^= static_cast<unsigned char>(*src);
+    hash *= 16777619u;
+  }
+  const char* ext = strstr(clFileName, ".cl");
+  int name_length = ext != NULL ? ext - clFileName : strlen(clFileName);
+  char fileName[1400];
+  snprintf(fileName, sizeof(fileName), "%.*s-%s-%s-%08x.bin", name_length,
+           clFileName, deviceName, driverVersion, hash);
+  legalizeFileName(fileName);
+  return OpenclDevice::CachePath(fileName);
+}
+
 void populateGPUEnvFromDevice( GPUEnv *gpuInfo, cl_device_id device ) {
     //printf("[DS] populateGPUEnvFromDevice\n");
     size_t size;
@@ -166,6 +236,12 @@ int OpenclDevice::LoadOpencl()
     return 0;
     }
     fprintf(stderr, "[OD] Load opencl.dll successful!\n");
+#elif defined(ANDROID)
+  // The vendor library is found at run time, if the device has one.
+  if (!tesseract::LoadOpenclLibrary()) {
+    tprintf("[OD] No usable OpenCL library, using the CPU.\n");
+    return 0;
+  }
 #endif
     return 1;
 }
@@ -243,48 +319,82 @@ PIX *mapOutputCLBuffer(KernelEnv rEnv, cl_mem clbuffer, PIX *pixd, PIX *pixs,
 }
 
 
+// Releases pixThBuffer, which maps the data of a Pix that may not outlive
+// the page.
+static void releaseThresholdCLBuffer()
+{
+  if (pixThBuffer != NULL) clReleaseMemObject(pixThBuffer);
+  pixThBuffer = NULL;
+  pixThData = NULL;
+  pixThWords = 0;
+}
+
 void OpenclDevice::releaseMorphCLBuffers()
 {
   if (pixdCLIntermediate != NULL) clReleaseMemObject(pixdCLIntermediate);
   if (pixsCLBuffer != NULL) clReleaseMemObject(pixsCLBuffer);
   if (pixdCLBuffer != NULL) clReleaseMemObject(pixdCLBuffer);
-  if (pixThBuffer != NULL) clReleaseMemObject(pixThBuffer);
-  pixdCLIntermediate = pixsCLBuffer = pixdCLBuffer = pixThBuffer = NULL;
+  pixdCLIntermediate = pixsCLBuffer = pixdCLBuffer = NULL;
+  morphBufferWords = 0;
+  releaseThresholdCLBuffer();
 }
 
 int OpenclDevice::initMorphCLAllocations(l_int32 wpl, l_int32 h, PIX* pixs)
 {
     SetKernelEnv( &rEnv );
+    size_t words = (size_t)wpl * h;
+    clStatus = CL_SUCCESS;
+
+    // The buffers stay allocated, in host-visible memory, from the last
+    // page of the same size.
+    if (words != morphBufferWords || pixsCLBuffer == NULL) {
+      if (pixdCLIntermediate != NULL) clReleaseMemObject(pixdCLIntermediate);
+      if (pixsCLBuffer != NULL) clReleaseMemObject(pixsCLBuffer);
+      if (pixdCLBuffer != NULL) clReleaseMemObject(pixdCLBuffer);
+      pixdCLIntermediate = pixsCLBuffer = pixdCLBuffer = NULL;
+      morphBufferWords = 0;
+      cl_int status[3];
+      pixsCLBuffer = allocateZeroCopyBuffer(rEnv, NULL, words,
+                                            CL_MEM_ALLOC_HOST_PTR, &status[0]);
+      pixdCLBuffer = allocateZeroCopyBuffer(rEnv, NULL, words,
+                                            CL_MEM_ALLOC_HOST_PTR, &status[1]);
+      pixdCLIntermediate = allocateZeroCopyBuffer(
+          rEnv, NULL, words, CL_MEM_ALLOC_HOST_PTR, &status[2]);
+      for (int i = 0; i < 3; ++i) {
+        if (status[i] != CL_SUCCESS) {
+          releaseMorphCLBuffers();
+          return (int)status[i];
+        }
+      }
+      morphBufferWords = words;
+    }
 
-    if (pixThBuffer != NULL) {
-      pixsCLBuffer = allocateZeroCopyBuffer(rEnv, NULL, wpl * h,
-                                            CL_MEM_ALLOC_HOST_PTR, &clStatus);
-
-      // Get the output from ThresholdToPix operation
+    if (pixThBuffer != NULL && pixThData == pixGetData(pixs) &&
+        pixThWords == words) {
+      // The thresholded image is still on the device: copy it there.
       clStatus =
           clEnqueueCopyBuffer(rEnv.mpkCmdQueue, pixThBuffer, pixsCLBuffer, 0, 0,
-                              sizeof(l_uint32) * wpl * h, 0, NULL, NULL);
-    }
-    else
-    {
-        //Get data from the source image
-        l_uint32* srcdata = (l_uint32*) malloc(wpl*h*sizeof(l_uint32));
-        memcpy(srcdata, pixGetData(pixs), wpl*h*sizeof(l_uint32));
-
-        pixsCLBuffer = allocateZeroCopyBuffer(rEnv, srcdata, wpl*h, CL_MEM_USE_HOST_PTR, &clStatus);
+                              sizeof(l_uint32) * words, 0, NULL, NULL);
+    } else {
+      // Write the source image straight into the mapped device buffer.
+      l_uint32 *pValues = (l_uint32 *)clEnqueueMapBuffer(
+          rEnv.mpkCmdQueue, pixsCLBuffer, CL_TRUE, CL_MAP_WRITE, 0,
+          words * sizeof(l_uint32), 0, NULL, NULL, &clStatus);
+      if (pValues != NULL) {
+        memcpy(pValues, pixGetData(pixs), words * sizeof(l_uint32));
+        clStatus = clEnqueueUnmapMemObject(rEnv.mpkCmdQueue, pixsCLBuffer,
+                                           pValues, 0, NULL, NULL);
+      }
     }
-
-    pixdCLBuffer = allocateZeroCopyBuffer(rEnv, NULL, wpl * h,
-                                          CL_MEM_ALLOC_HOST_PTR, &clStatus);
-
-    pixdCLIntermediate = allocateZeroCopyBuffer(
-        rEnv, NULL, wpl * h, CL_MEM_ALLOC_HOST_PTR, &clStatus);
+    // pixThBuffer is used at most once.
+    releaseThresholdCLBuffer();
 
     return (int)clStatus;
 }
 
 int OpenclDevice::InitEnv()
 {
+    SVAutoLock lock(&init_mutex);
 //PERF_COUNT_START("OD::InitEnv")
 //    printf("[OD] OpenclDevice::InitEnv()\n");
 #ifdef SAL_WIN32
@@ -303,6 +413,23 @@ PERF_COUNT_SUB("LoadOpencl")
     return 1;
 }
 
+// Runs InitEnv for InitEnvAsync.
+static void* InitEnvThread(void* arg) {
+  OpenclDevice::InitEnv();
+  SVAutoLock lock(&state_mutex);
+  init_pending = false;
+  return NULL;
+}
+
+void OpenclDevice::InitEnvAsync() {
+  {
+    SVAutoLock lock(&state_mutex);
+    if (isInited || init_pending) return;
+    init_pending = true;
+  }
+  SVSync::StartThread(InitEnvThread, NULL);
+}
+
 int OpenclDevice::ReleaseOpenclRunEnv()
 {
     ReleaseOpenclEnv( &gpuEnv );
@@ -378,6 +505,7 @@ int OpenclDevice::ReleaseOpenclEnv( GPUEnv *gpuInfo )
         return 1;
     }
 
+    releaseMorphCLBuffers();
     for ( i = 0; i < gpuEnv.mnFileCount; i++ )
     {
         if ( gpuEnv.mpArryPrograms[i] )
@@ -405,21 +533,10 @@ int OpenclDevice::ReleaseOpenclEnv( GPUEnv *gpuInfo )
 int OpenclDevice::BinaryGenerated( const char * clFileName, FILE ** fhandle )
 {
     unsigned int i = 0;
-    cl_int clStatus;
     int status = 0;
-    char *str = NULL;
     FILE *fd = NULL;
-    char fileName[256] = {0}, cl_name[128] = {0};
-    char deviceName[1024];
-    clStatus = clGetDeviceInfo(gpuEnv.mpArryDevsID[i], CL_DEVICE_NAME,
-                               sizeof(deviceName), deviceName, NULL);
-    CHECK_OPENCL(clStatus, "clGetDeviceInfo");
-    str = (char *)strstr(clFileName, (char *)".cl");
-    memcpy(cl_name, clFileName, str - clFileName);
-    cl_name[str - clFileName] = '\0';
-    sprintf(fileName, "%s-%s.bin", cl_name, deviceName);
-    legalizeFileName(fileName);
-    fd = fopen(fileName, "rb");
+    STRING fileName = KernelBinaryPath(gpuEnv.mpArryDevsID[i], clFileName);
+    fd = fopen(fileName.string(), "rb");
     status = (fd != NULL) ? 1 : 0;
     if (fd != NULL) {
       *fhandle = fd;
@@ -515,26 +632,15 @@ int OpenclDevice::GeneratBinFromKernelSource( cl_program program, const char * c
     /* dump out each binary into its own separate file. */
     for ( i = 0; i < numDevices; i++ )
     {
-        char fileName[256] = { 0 }, cl_name[128] = { 0 };
-
         if ( binarySizes[i] != 0 )
         {
-            char deviceName[1024];
-            clStatus = clGetDeviceInfo(mpArryDevsID[i], CL_DEVICE_NAME,
-                                       sizeof(deviceName), deviceName, NULL);
-            CHECK_OPENCL( clStatus, "clGetDeviceInfo" );
-
-            str = (char*) strstr( clFileName, (char*) ".cl" );
-            memcpy( cl_name, clFileName, str - clFileName );
-            cl_name[str - clFileName] = '\0';
-            sprintf( fileName, "%s-%s.bin", cl_name, deviceName );
-            legalizeFileName(fileName);
-            if ( !WriteBinaryToFile( fileName, binaries[i], binarySizes[i] ) )
+            STRING fileName = KernelBinaryPath(mpArryDevsID[i], clFileName);
+            if ( !WriteBinaryToFile( fileName.string(), binaries[i], binarySizes[i] ) )
             {
-                printf("[OD] write binary[%s] failed\n", fileName);
+                printf("[OD] write binary[%s] failed\n", fileName.string());
                 return 0;
             } //else
-            printf("[OD] write binary[%s] successfully\n", fileName);
+            printf("[OD] write binary[%s] successfully\n", fileName.string());
         }
     }
 
@@ -724,7 +830,7 @@ PERF_COUNT_END
             return 0;
         }
 
-        fd1 = fopen( "kernel-build.log", "w+" );
+        fd1 = fopen( CachePath("kernel-build.log").string(), "w+" );
         if (fd1 != NULL) {
           fwrite(buildLog, sizeof(char), length, fd1);
           fclose(fd1);
@@ -809,6 +915,7 @@ PERF_COUNT_END
     return pResult;
 }
 
+#ifdef USE_OPENCL_TIFF
 PIX * OpenclDevice::pixReadTiffCl ( const char *filename, l_int32 n )
 {
 PERF_COUNT_START("pixReadTiffCL")
@@ -1377,6 +1484,7 @@ PIXCMAP   *cmap;
 
     return pix;
 }
+#endif  // USE_OPENCL_TIFF
 
 //Morphology Dilate operation for 5x5 structuring element. Invokes the relevant OpenCL kernels
 cl_int
@@ -2325,10 +2433,14 @@ int OpenclDevice::ThresholdRectToPixOCL(unsigned char *imageData,
   CHECK_OPENCL(clStatus, "clCreateBuffer imageBuffer");
 
   /* map pix as write only */
+  // It stays on the device for initMorphCLAllocations.
+  releaseThresholdCLBuffer();
   pixThBuffer =
       clCreateBuffer(rEnv.mpkContext, CL_MEM_READ_WRITE | CL_MEM_USE_HOST_PTR,
                      pixSize, pixData, &clStatus);
   CHECK_OPENCL(clStatus, "clCreateBuffer pix");
+  pixThData = pixData;
+  pixThWords = wpl * height;
 
   /* map thresholds and hi_values */
   cl_mem thresholdsBuffer =
@@ -2836,6 +2948,8 @@ double getLineMasksMorphMicroBench( GPUEnv *env, TessScoreEvaluationInputData in
 #endif
         Pix *src_pix = input.pix;
         OpenclDevice::gpuEnv = *env;
+        // Drop any buffers made in another context.
+        OpenclDevice::releaseMorphCLBuffers();
         OpenclDevice::initMorphCLAllocations(wpl, input.height, input.pix);
         Pix *pix_vline = NULL, *pix_hline = NULL, *pix_closed = NULL;
         OpenclDevice::pixGetLinesCL(
@@ -2989,7 +3103,8 @@ ds_device OpenclDevice::getDeviceSelection( ) {
       status = initDSProfile(&profile, "v0.1");
       PERF_COUNT_SUB("initDSProfile")
       // try reading scores from file
-      const char *fileName = "tesseract_opencl_profile_devices.dat";
+      STRING profilePath = CachePath("tesseract_opencl_profile_devices.dat");
+      const char *fileName = profilePath.string();
       status = readProfileFromFile(profile, deserializeScore, fileName);
       if (status != DS_SUCCESS) {
         // need to run evaluation
@@ -3099,6 +3214,11 @@ ds_device OpenclDevice::getDeviceSelection( ) {
 
 
 bool OpenclDevice::selectedDeviceIsOpenCL() {
+  {
+    // Use the CPU until InitEnvAsync is done.
+    SVAutoLock lock(&state_mutex);
+    if (init_pending) return false;
+  }
   ds_device device = getDeviceSelection();
   return (device.type == DS_DEVICE_OPENCL_DEVICE);
 }
@@ -3108,6 +3228,114 @@ bool OpenclDevice::selectedDeviceIsNativeCPU() {
   return (device.type == DS_DEVICE_NATIVE_CPU);
 }
 
+// Images are put in these classes by size, as the device wins by more, or
+// loses, depending on how much work there is to pay for its overheads.
+static const int kNumRouteSizeClasses = 4;
+static const int kRouteSizeLimits[kNumRouteSizeClasses - 1] = {
+  500000, 2000000, 8000000
+};
+static const char* const kRouteSizeNames[kNumRouteSizeClasses] = {
+  "<0.5MP", "<2MP", "<8MP", ">=8MP"
+};
+static const char* const kOperationNames[OCL_OPERATION_COUNT] = {
+  "HistogramRect", "ThresholdRectToPix", "GetLineMasks"
+};
+// Each route is tried this many times before the times are compared.
+static const int kMinRouteSamples = 2;
+// Every kRouteProbeInterval calls, the slower route is taken to see
+// whether it has become faster.
+static const int kRouteProbeInterval = 16;
+// Weight of each new time in the decaying average.
+static const double kRouteDecay = 0.25;
+
+// Decaying average times, in seconds per megapixel, of the CPU ([0]) and
+// the OpenCL ([1]) routes of one operation and size class.
+struct RouteStats {
+  double seconds_per_mp[2];
+  int samples[2];
+  int calls;
+};
+static RouteStats route_stats[OCL_OPERATION_COUNT][kNumRouteSizeClasses];
+static SVMutex route_mutex;
+
+static int RouteSizeClass(int num_pixels) {
+  int size_class = 0;
+  while (size_class < kNumRouteSizeClasses - 1 &&
+         num_pixels >= kRouteSizeLimits[size_class])
+    ++size_class;
+  return size_class;
+}
+
+// Returns the route that is faster on average. Untried routes count as
+// fastest, so the device, which was selected, is tried first.
+static bool FasterRouteIsOpencl(const RouteStats& stats) {
+  if (stats.samples[1] < kMinRouteSamples) return true;
+  if (stats.samples[0] < kMinRouteSamples) return false;
+  return stats.seconds_per_mp[1] <= stats.seconds_per_mp[0];
+}
+
+bool OpenclDevice::RouteToOpencl(OpenclOperation op, int num_pixels) {
+  SVAutoLock lock(&route_mutex);
+  RouteStats& stats = route_stats[op][RouteSizeClass(num_pixels)];
+  bool opencl = FasterRouteIsOpencl(stats);
+  if (stats.samples[0] >= kMinRouteSamples &&
+      stats.samples[1] >= kMinRouteSamples &&
+      ++stats.calls % kRouteProbeInterval == 0)
+    opencl = !opencl;
+  return opencl;
+}
+
+void OpenclDevice::RecordRouteTime(OpenclOperation op, int num_pixels,
+                                   bool opencl, double seconds) {
+  if (num_pixels <= 0) return;
+  double seconds_per_mp = seconds * 1000000.0 / num_pixels;
+  SVAutoLock lock(&route_mutex);
+  RouteStats& stats = route_stats[op][RouteSizeClass(num_pixels)];
+  int route = opencl ? 1 : 0;
+  if (stats.samples[route] == 0)
+    stats.seconds_per_mp[route] = seconds_per_mp;
+  else
+    stats.seconds_per_mp[route] +=
+        kRouteDecay * (seconds_per_mp - stats.seconds_per_mp[route]);
+  ++stats.samples[route];
+}
+
+void OpenclDevice::GetRoutes(STRING* report) {
+  SVAutoLock lock(&route_mutex);
+  for (int op = 0; op < OCL_OPERATION_COUNT; ++op) {
+    for (int size_class = 0; size_class < kNumRouteSizeClasses;
+         ++size_class) {
+      const RouteStats& stats = route_stats[op][size_class];
+      if (stats.samples[0] == 0 && stats.samples[1] == 0) continue;
+      char line[256];
+      snprintf(line, sizeof(line),
+               "%s %s: %s (CPU %.3fs/MP n=%d, OpenCL %.3fs/MP n=%d)\n",
+               kOperationNames[op], kRouteSizeNames[size_class],
+               FasterRouteIsOpencl(stats) ? "OpenCL" : "CPU",
+               stats.seconds_per_mp[0], stats.samples[0],
+               stats.seconds_per_mp[1], stats.samples[1]);
+      *report += line;
+    }
+  }
+}
+
+double OpenclDevice::RouteClock() {
+#if ON_WINDOWS
+  LARGE_INTEGER freq, now;
+  QueryPerformanceFrequency(&freq);
+  QueryPerformanceCounter(&now);
+  return now.QuadPart / (double)freq.QuadPart;
+#elif ON_APPLE
+  mach_timebase_info_data_t info = {0, 0};
+  mach_timebase_info(&info);
+  return (mach_absolute_time() * (double)info.numer / info.denom) / 1.0E9;
+#else
+  timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return now.tv_sec + now.tv_nsec / 1000000000.0;
+#endif
+}
+
 /*!
  *  pixConvertRGBToGray() from leptonica, converted to opencl kernel
  *
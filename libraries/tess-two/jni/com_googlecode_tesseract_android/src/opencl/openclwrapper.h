@@ -10,10 +10,15 @@
 #include <stdio.h>
 #include "allheaders.h"
 #include "pix.h"
-#ifdef USE_OPENCL
+// Android has no libtiff, so the OpenCL TIFF readers are left out there.
+#if defined(USE_OPENCL) && !defined(ANDROID)
+#define USE_OPENCL_TIFF
+#endif
+#ifdef USE_OPENCL_TIFF
 #include "tiff.h"
 #include "tiffio.h"
 #endif
+#include "strngs.h"
 #include "tprintf.h"
 
 // including CL/cl.h doesn't occur until USE_OPENCL defined below
@@ -215,6 +220,14 @@ typedef struct _GPUEnv
 
 } GPUEnv;
 
+// The operations that have both an OpenCL and a CPU implementation, and
+// are routed to one or the other by OpenclRoute.
+enum OpenclOperation {
+  OCL_HISTOGRAM_RECT,
+  OCL_THRESHOLD_RECT_TO_PIX,
+  OCL_GET_LINE_MASKS,
+  OCL_OPERATION_COUNT
+};
 
 class OpenclDevice
 {
@@ -225,6 +238,17 @@ public:
     OpenclDevice();
     ~OpenclDevice();
     static int InitEnv(); // load dll, call InitOpenclRunEnv(0)
+    // Runs InitEnv on a background thread and returns at once, so that
+    // selecting the device and compiling the kernels does not hold up the
+    // first pages: selectedDeviceIsOpenCL is false, and the CPU code is
+    // used, until it has finished.
+    static void InitEnvAsync();
+    // Sets the directory that keeps the compiled kernels and the device
+    // profile between runs, instead of the current directory or the
+    // TESSERACT_OPENCL_CACHE_DIR environment variable. Call before InitEnv.
+    static void SetCacheDir(const char* dir);
+    // Returns the path of the given file in the cache directory.
+    static STRING CachePath(const char* fileName);
     static int InitOpenclRunEnv( int argc ); // RegistOpenclKernel, double flags, compile kernels
     static int InitOpenclRunEnv_DeviceSelection( int argc ); // RegistOpenclKernel, double flags, compile kernels
     static int RegistOpenclKernel();
@@ -237,6 +261,7 @@ public:
     static int BinaryGenerated( const char * clFileName, FILE ** fhandle );
     //static int CompileKernelFile( const char *filename, GPUEnv *gpuInfo, const char *buildOption );
     static l_uint32* pixReadFromTiffKernel(l_uint32 *tiffdata,l_int32 w,l_int32 h,l_int32 wpl, l_uint32 *line);
+#ifdef USE_OPENCL_TIFF
     static Pix* pixReadTiffCl( const char *filename, l_int32 n );
     static PIX * pixReadStreamTiffCl ( FILE *fp, l_int32 n );
 	static PIX * pixReadMemTiffCl(const l_uint8 *data, size_t size, l_int32  n);
@@ -244,6 +269,7 @@ public:
     static int composeRGBPixelCl(int *tiffdata,int *line,int h,int w);
     static l_int32 getTiffStreamResolutionCl(TIFF *tif,l_int32  *pxres,l_int32  *pyres);
     static TIFF* fopenTiffCl(FILE *fp,const char  *modestring);
+#endif  // USE_OPENCL_TIFF
 
 /* OpenCL implementations of Morphological operations*/
 
@@ -319,6 +345,58 @@ public:
     static bool selectedDeviceIsOpenCL();
     static bool selectedDeviceIsNativeCPU();
 
+    // Per-operation routing. When the selected device is OpenCL, each call
+    // of an operation on an image of num_pixels goes to whichever of the
+    // device and the CPU has been faster lately on images of that size,
+    // now and then trying the other to keep its time current.
+    static bool RouteToOpencl(OpenclOperation op, int num_pixels);
+    // Adds the time taken by a call routed by RouteToOpencl.
+    static void RecordRouteTime(OpenclOperation op, int num_pixels,
+                                bool opencl, double seconds);
+    // Appends a line per operation and image size, with the route taken
+    // and the times it was chosen by, to report.
+    static void GetRoutes(STRING* report);
+    // Returns a monotonic time in seconds.
+    static double RouteClock();
+};
+
+// Routes one call of an operation, and times it for the statistics.
+// Usage:
+//   OpenclRoute route(OCL_HISTOGRAM_RECT, width * height, can_use_opencl);
+//   if (route.opencl()) { ... } else { ... }
+//   route.Finish();
+class OpenclRoute {
+ public:
+  // If eligible is false, the call runs on the CPU and is not timed.
+  OpenclRoute(OpenclOperation op, int num_pixels, bool eligible)
+    : op_(op), num_pixels_(num_pixels), timed_(false), opencl_(false),
+      start_(0.0) {
+    if (eligible && OpenclDevice::selectedDeviceIsOpenCL()) {
+      timed_ = true;
+      opencl_ = OpenclDevice::RouteToOpencl(op, num_pixels);
+      start_ = OpenclDevice::RouteClock();
+    }
+  }
+  ~OpenclRoute() {
+    Finish();
+  }
+  bool opencl() const {
+    return opencl_;
+  }
+  // Records the time since the construction. Only the first call counts.
+  void Finish() {
+    if (!timed_) return;
+    timed_ = false;
+    OpenclDevice::RecordRouteTime(op_, num_pixels_, opencl_,
+                                  OpenclDevice::RouteClock() - start_);
+  }
+
+ private:
+  OpenclOperation op_;
+  int num_pixels_;
+  bool timed_;
+  bool opencl_;
+  double start_;
 };
 
 
@@ -0,0 +1,226 @@
+///////////////////////////////////////////////////////////////////////
+// File:        vkkernels.h
+// Description: GLSL compute shaders of the Vulkan image operations.
+//
+// (C) Copyright 2016, Google Inc.
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////
+
+// The Vulkan counterparts of the kernels in oclkernels.h, compiled to
+// SPIR-V when VulkanDevice starts. Every shader has the same three storage
+// buffer bindings and takes its sizes as push constants. Images are
+// Leptonica raster data: rows of wpl 32-bit words, the first pixel in the
+// most significant bits.
+
+#ifndef TESSERACT_OPENCL_VKKERNELS_H_
+#define TESSERACT_OPENCL_VKKERNELS_H_
+
+// Thresholds one 32-pixel word of the output per invocation, exactly as
+// ImageThresholder::ThresholdRectToPix does. binding 2 holds the
+// thresholds of the channels followed, from index 4, by their hi_values.
+static const char kVkThresholdShader[] = R"(
+#version 450
+layout(local_size_x = 64) in;
+layout(std430, binding = 0) readonly buffer Src { uint src[]; };
+layout(std430, binding = 1) writeonly buffer Dst { uint dst[]; };
+layout(std430, binding = 2) readonly buffer Params { int thresholds[]; };
+layout(push_constant) uniform Sizes {
+  int src_wpl;
+  int dst_wpl;
+  int width;
+  int height;
+  int left;
+  int top;
+  int num_channels;
+} p;
+
+uint GetByte(int line, int n) {
+  return (src[line + (n >> 2)] >> (24 - 8 * (n & 3))) & 0xffu;
+}
+
+void main() {
+  int index = int(gl_GlobalInvocationID.x);
+  if (index >= p.dst_wpl * p.height) return;
+  int y = index / p.dst_wpl;
+  int x0 = (index - y * p.dst_wpl) * 32;
+  int line = (y + p.top) * p.src_wpl;
+  uint word = 0u;
+  for (int b = 0; b < 32 && x0 + b < p.width; ++b) {
+    bool white = true;
+    for (int ch = 0; ch < p.num_channels; ++ch) {
+      int pixel = int(GetByte(line, (x0 + b + p.left) * p.num_channels + ch));
+      int hi_value = thresholds[4 + ch];
+      if (hi_value >= 0 && (pixel > thresholds[ch]) == (hi_value == 0)) {
+        white = false;
+        break;
+      }
+    }
+    if (!white) word |= 0x80000000u >> b;
+  }
+  dst[index] = word;
+}
+)";
+
+// Counts the bytes of one row of the rectangle per work group into a
+// shared histogram, then adds it to the histograms of all the channels in
+// binding 1, laid out as in OtsuThreshold. binding 1 must be zeroed first.
+static const char kVkHistogramShader[] = R"(
+#version 450
+layout(local_size_x = 256) in;
+layout(std430, binding = 0) readonly buffer Src { uint src[]; };
+layout(std430, binding = 1) buffer Histogram { uint histogram[]; };
+layout(push_constant) uniform Sizes {
+  int src_wpl;
+  int width;
+  int height;
+  int left;
+  int top;
+  int num_channels;
+} p;
+
+shared uint local_histogram[1024];
+
+uint GetByte(int line, int n) {
+  return (src[line + (n >> 2)] >> (24 - 8 * (n & 3))) & 0xffu;
+}
+
+void main() {
+  int t = int(gl_LocalInvocationID.x);
+  int bins = 256 * p.num_channels;
+  for (int i = t; i < bins; i += 256) local_histogram[i] = 0u;
+  memoryBarrierShared();
+  barrier();
+  int line = (int(gl_WorkGroupID.x) + p.top) * p.src_wpl;
+  int start = p.left * p.num_channels;
+  int count = p.width * p.num_channels;
+  for (int i = t; i < count; i += 256) {
+    uint value = GetByte(line, start + i);
+    atomicAdd(local_histogram[(i % p.num_channels) * 256 + int(value)], 1u);
+  }
+  memoryBarrierShared();
+  barrier();
+  for (int i = t; i < bins; i += 256) {
+    if (local_histogram[i] != 0u)
+      atomicAdd(histogram[i], local_histogram[i]);
+  }
+}
+)";
+
+// One horizontal pass of a brick dilation (OR) or erosion (AND) of a
+// binary image: each output pixel x combines the input pixels x + lo to
+// x + hi, pixels outside the image counting as off, as with Leptonica's
+// asymmetric boundary condition.
+static const char kVkMorphHorShader[] = R"(
+#version 450
+layout(local_size_x = 64) in;
+layout(std430, binding = 0) readonly buffer Src { uint src[]; };
+layout(std430, binding = 1) writeonly buffer Dst { uint dst[]; };
+layout(push_constant) uniform Sizes {
+  int wpl;
+  int height;
+  int width;
+  int lo;
+  int hi;
+  int erode;
+} p;
+
+uint LastWordMask() {
+  return (p.width & 31) == 0 ? 0xffffffffu : ~(0xffffffffu >> (p.width & 31));
+}
+
+uint WordAt(int line, int i) {
+  if (i < 0 || i >= p.wpl) return 0u;
+  uint word = src[line + i];
+  return i == p.wpl - 1 ? word & LastWordMask() : word;
+}
+
+// Returns the 32 pixels of the row starting at pixel x.
+uint BitsAt(int line, int x) {
+  int i = x >> 5;
+  int b = x & 31;
+  uint word = WordAt(line, i);
+  if (b == 0) return word;
+  return (word << b) | (WordAt(line, i + 1) >> (32 - b));
+}
+
+void main() {
+  int index = int(gl_GlobalInvocationID.x);
+  if (index >= p.wpl * p.height) return;
+  int y = index / p.wpl;
+  int col = index - y * p.wpl;
+  int line = y * p.wpl;
+  uint result = p.erode != 0 ? 0xffffffffu : 0u;
+  for (int k = p.lo; k <= p.hi; ++k) {
+    uint bits = BitsAt(line, col * 32 + k);
+    result = p.erode != 0 ? result & bits : result | bits;
+  }
+  if (col == p.wpl - 1) result &= LastWordMask();
+  dst[index] = result;
+}
+)";
+
+// The vertical pass of the same: each output pixel at row y combines the
+// input pixels of rows y + lo to y + hi.
+static const char kVkMorphVerShader[] = R"(
+#version 450
+layout(local_size_x = 64) in;
+layout(std430, binding = 0) readonly buffer Src { uint src[]; };
+layout(std430, binding = 1) writeonly buffer Dst { uint dst[]; };
+layout(push_constant) uniform Sizes {
+  int wpl;
+  int height;
+  int width;
+  int lo;
+  int hi;
+  int erode;
+} p;
+
+void main() {
+  int index = int(gl_GlobalInvocationID.x);
+  if (index >= p.wpl * p.height) return;
+  int y = index / p.wpl;
+  int col = index - y * p.wpl;
+  uint result = p.erode != 0 ? 0xffffffffu : 0u;
+  for (int k = p.lo; k <= p.hi; ++k) {
+    int row = y + k;
+    uint bits = row < 0 || row >= p.height ? 0u : src[row * p.wpl + col];
+    result = p.erode != 0 ? result & bits : result | bits;
+  }
+  if (col == p.wpl - 1 && (p.width & 31) != 0)
+    result &= ~(0xffffffffu >> (p.width & 31));
+  dst[index] = result;
+}
+)";
+
+// Binary image logic, word by word: dst = src AND NOT binding 2
+// (pixSubtract), src AND binding 2, or src OR binding 2.
+static const char kVkLogicShader[] = R"(
+#version 450
+layout(local_size_x = 64) in;
+layout(std430, binding = 0) readonly buffer Src { uint src[]; };
+layout(std430, binding = 1) writeonly buffer Dst { uint dst[]; };
+layout(std430, binding = 2) readonly buffer Src2 { uint src2[]; };
+layout(push_constant) uniform Sizes {
+  int words;
+  int op;
+} p;
+
+void main() {
+  int index = int(gl_GlobalInvocationID.x);
+  if (index >= p.words) return;
+  uint a = src[index];
+  uint b = src2[index];
+  dst[index] = p.op == 0 ? a & ~b : (p.op == 1 ? a & b : a | b);
+}
+)";
+
+#endif  // TESSERACT_OPENCL_VKKERNELS_H_
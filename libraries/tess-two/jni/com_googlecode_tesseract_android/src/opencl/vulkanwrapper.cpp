@@ -0,0 +1,784 @@
+///////////////////////////////////////////////////////////////////////
+// File:        vulkanwrapper.cpp
+// Description: Image preprocessing on the GPU through Vulkan compute.
+//
+// (C) Copyright 2016, Google Inc.
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////
+
+#ifdef USE_VULKAN
+
+#include <dlfcn.h>
+#include <stdlib.h>
+#include <string.h>
+// The Vulkan functions are looked up at run time, not linked.
+#ifndef VK_NO_PROTOTYPES
+#define VK_NO_PROTOTYPES
+#endif
+#include <vulkan/vulkan.h>
+#include <shaderc/shaderc.h>
+#include "allheaders.h"
+#include "svutil.h"
+#include "tprintf.h"
+#include "vkkernels.h"
+#include "vulkanwrapper.h"
+
+// The Vulkan functions used, found through vkGetInstanceProcAddr.
+#define TESS_VK_INSTANCE_FUNCTIONS(X) \
+  X(vkDestroyInstance) \
+  X(vkEnumeratePhysicalDevices) \
+  X(vkGetPhysicalDeviceProperties) \
+  X(vkGetPhysicalDeviceQueueFamilyProperties) \
+  X(vkGetPhysicalDeviceMemoryProperties) \
+  X(vkCreateDevice) \
+  X(vkGetDeviceProcAddr)
+
+// And through vkGetDeviceProcAddr.
+#define TESS_VK_DEVICE_FUNCTIONS(X) \
+  X(vkDestroyDevice) \
+  X(vkGetDeviceQueue) \
+  X(vkCreateBuffer) \
+  X(vkDestroyBuffer) \
+  X(vkGetBufferMemoryRequirements) \
+  X(vkAllocateMemory) \
+  X(vkFreeMemory) \
+  X(vkBindBufferMemory) \
+  X(vkMapMemory) \
+  X(vkCreateShaderModule) \
+  X(vkDestroyShaderModule) \
+  X(vkCreateDescriptorSetLayout) \
+  X(vkDestroyDescriptorSetLayout) \
+  X(vkCreatePipelineLayout) \
+  X(vkDestroyPipelineLayout) \
+  X(vkCreateComputePipelines) \
+  X(vkDestroyPipeline) \
+  X(vkCreateDescriptorPool) \
+  X(vkDestroyDescriptorPool) \
+  X(vkResetDescriptorPool) \
+  X(vkAllocateDescriptorSets) \
+  X(vkUpdateDescriptorSets) \
+  X(vkCreateCommandPool) \
+  X(vkDestroyCommandPool) \
+  X(vkAllocateCommandBuffers) \
+  X(vkResetCommandBuffer) \
+  X(vkBeginCommandBuffer) \
+  X(vkEndCommandBuffer) \
+  X(vkCmdBindPipeline) \
+  X(vkCmdBindDescriptorSets) \
+  X(vkCmdPushConstants) \
+  X(vkCmdDispatch) \
+  X(vkCmdPipelineBarrier) \
+  X(vkCreateFence) \
+  X(vkDestroyFence) \
+  X(vkResetFences) \
+  X(vkWaitForFences) \
+  X(vkQueueSubmit)
+
+#define TESS_VK_DECLARE_FUNCTION(name) static PFN_##name name = NULL;
+static PFN_vkGetInstanceProcAddr vkGetInstanceProcAddr = NULL;
+static PFN_vkCreateInstance vkCreateInstance = NULL;
+TESS_VK_INSTANCE_FUNCTIONS(TESS_VK_DECLARE_FUNCTION)
+TESS_VK_DEVICE_FUNCTIONS(TESS_VK_DECLARE_FUNCTION)
+#undef TESS_VK_DECLARE_FUNCTION
+
+// The shaders, in the order of their pipelines.
+enum VkShader {
+  VK_SHADER_THRESHOLD,
+  VK_SHADER_HISTOGRAM,
+  VK_SHADER_MORPH_HOR,
+  VK_SHADER_MORPH_VER,
+  VK_SHADER_LOGIC,
+  VK_SHADER_COUNT
+};
+static const char* const kShaderSources[VK_SHADER_COUNT] = {
+  kVkThresholdShader, kVkHistogramShader, kVkMorphHorShader,
+  kVkMorphVerShader, kVkLogicShader
+};
+static const char* const kShaderNames[VK_SHADER_COUNT] = {
+  "threshold", "histogram", "morph_hor", "morph_ver", "logic"
+};
+// Local size of the one-dimensional shaders.
+static const int kVkGroupSize = 64;
+// Bindings of every shader, and the most push constants of any.
+static const int kNumBindings = 3;
+static const int kMaxPushConstants = 8;
+// Most dispatches in one submission, which is in GetLinesVK.
+static const int kMaxDispatches = 32;
+// Images used by GetLinesVK: the source, the closed image, the solid
+// image, the two line masks and two for the intermediate passes.
+enum VkImage {
+  VK_IMAGE_SRC,
+  VK_IMAGE_CLOSED,
+  VK_IMAGE_SOLID,
+  VK_IMAGE_VLINE,
+  VK_IMAGE_HLINE,
+  VK_IMAGE_TEMP1,
+  VK_IMAGE_TEMP2,
+  VK_IMAGE_COUNT
+};
+// Words of the small buffer, which holds the histograms or the thresholds.
+static const int kSmallBufferWords = 1024;
+
+// A storage buffer kept mapped in host memory that the device can see.
+struct VkHostBuffer {
+  VkBuffer buffer;
+  VkDeviceMemory memory;
+  void* data;
+  VkDeviceSize size;
+};
+
+static void* vulkan_library = NULL;
+static VkInstance instance = VK_NULL_HANDLE;
+static VkPhysicalDevice physical_device = VK_NULL_HANDLE;
+static VkDevice device = VK_NULL_HANDLE;
+static VkQueue queue = VK_NULL_HANDLE;
+static uint32_t memory_type = 0;
+static VkDescriptorSetLayout set_layout = VK_NULL_HANDLE;
+static VkPipelineLayout pipeline_layout = VK_NULL_HANDLE;
+static VkPipeline pipelines[VK_SHADER_COUNT];
+static VkDescriptorPool descriptor_pool = VK_NULL_HANDLE;
+static VkCommandPool command_pool = VK_NULL_HANDLE;
+static VkCommandBuffer command_buffer = VK_NULL_HANDLE;
+static VkFence fence = VK_NULL_HANDLE;
+static VkHostBuffer src_buffer;
+static VkHostBuffer small_buffer;
+static VkHostBuffer image_buffers[VK_IMAGE_COUNT];
+// Dispatches recorded since BeginCommands.
+static int num_dispatches = 0;
+// The data and size in words of the Pix that ThresholdRectToPixVK left in
+// image_buffers[VK_IMAGE_SRC], so GetLinesVK need not upload it again.
+static const l_uint32* resident_data = NULL;
+static int resident_words = 0;
+
+// Serializes the use of the device, which has one queue and one set of
+// buffers.
+static SVMutex vk_mutex;
+// Guard vk_ready and vk_pending.
+static SVMutex vk_state_mutex;
+static bool vk_ready = false;
+static bool vk_pending = false;
+static bool vk_tried = false;
+
+// Creates buffer of at least size bytes, or keeps it if it is big enough.
+static bool EnsureBuffer(VkDeviceSize size, VkHostBuffer* buffer) {
+  if (buffer->buffer != VK_NULL_HANDLE && buffer->size >= size) return true;
+  if (buffer->buffer != VK_NULL_HANDLE) {
+    vkDestroyBuffer(device, buffer->buffer, NULL);
+    vkFreeMemory(device, buffer->memory, NULL);
+  }
+  memset(buffer, 0, sizeof(*buffer));
+  VkBufferCreateInfo buffer_info = {};
+  buffer_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+  buffer_info.size = size;
+  buffer_info.usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+  buffer_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+  if (vkCreateBuffer(device, &buffer_info, NULL, &buffer->buffer) !=
+      VK_SUCCESS) {
+    buffer->buffer = VK_NULL_HANDLE;
+    return false;
+  }
+  VkMemoryRequirements requirements;
+  vkGetBufferMemoryRequirements(device, buffer->buffer, &requirements);
+  VkMemoryAllocateInfo alloc_info = {};
+  alloc_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+  alloc_info.allocationSize = requirements.size;
+  alloc_info.memoryTypeIndex = memory_type;
+  if ((requirements.memoryTypeBits & (1u << memory_type)) == 0 ||
+      vkAllocateMemory(device, &alloc_info, NULL, &buffer->memory) !=
+          VK_SUCCESS) {
+    vkDestroyBuffer(device, buffer->buffer, NULL);
+    memset(buffer, 0, sizeof(*buffer));
+    return false;
+  }
+  if (vkBindBufferMemory(device, buffer->buffer, buffer->memory, 0) !=
+          VK_SUCCESS ||
+      vkMapMemory(device, buffer->memory, 0, VK_WHOLE_SIZE, 0,
+                  &buffer->data) != VK_SUCCESS) {
+    vkDestroyBuffer(device, buffer->buffer, NULL);
+    vkFreeMemory(device, buffer->memory, NULL);
+    memset(buffer, 0, sizeof(*buffer));
+    return false;
+  }
+  buffer->size = size;
+  return true;
+}
+
+static void FreeBuffer(VkHostBuffer* buffer) {
+  if (buffer->buffer != VK_NULL_HANDLE) {
+    vkDestroyBuffer(device, buffer->buffer, NULL);
+    vkFreeMemory(device, buffer->memory, NULL);
+  }
+  memset(buffer, 0, sizeof(*buffer));
+}
+
+// Picks the memory that the host can map without flushing, preferring the
+// memory of the device, which on phones is the same RAM.
+static bool FindMemoryType() {
+  VkPhysicalDeviceMemoryProperties properties;
+  vkGetPhysicalDeviceMemoryProperties(physical_device, &properties);
+  const VkMemoryPropertyFlags host = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+                                     VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+  int best = -1;
+  for (uint32_t i = 0; i < properties.memoryTypeCount; ++i) {
+    VkMemoryPropertyFlags flags = properties.memoryTypes[i].propertyFlags;
+    if ((flags & host) != host) continue;
+    if (best < 0 || (flags & VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)) {
+      best = i;
+      if (flags & VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT) break;
+    }
+  }
+  if (best < 0) return false;
+  memory_type = best;
+  return true;
+}
+
+// Compiles the shaders and makes their pipelines, which share one layout.
+static bool CreatePipelines() {
+  VkDescriptorSetLayoutBinding bindings[kNumBindings];
+  memset(bindings, 0, sizeof(bindings));
+  for (int b = 0; b < kNumBindings; ++b) {
+    bindings[b].binding = b;
+    bindings[b].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    bindings[b].descriptorCount = 1;
+    bindings[b].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+  }
+  VkDescriptorSetLayoutCreateInfo set_info = {};
+  set_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+  set_info.bindingCount = kNumBindings;
+  set_info.pBindings = bindings;
+  if (vkCreateDescriptorSetLayout(device, &set_info, NULL, &set_layout) !=
+      VK_SUCCESS)
+    return false;
+  VkPushConstantRange push_range = {};
+  push_range.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+  push_range.size = kMaxPushConstants * sizeof(int32_t);
+  VkPipelineLayoutCreateInfo layout_info = {};
+  layout_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+  layout_info.setLayoutCount = 1;
+  layout_info.pSetLayouts = &set_layout;
+  layout_info.pushConstantRangeCount = 1;
+  layout_info.pPushConstantRanges = &push_range;
+  if (vkCreatePipelineLayout(device, &layout_info, NULL, &pipeline_layout) !=
+      VK_SUCCESS)
+    return false;
+
+  shaderc_compiler_t compiler = shaderc_compiler_initialize();
+  if (compiler == NULL) return false;
+  bool ok = true;
+  for (int s = 0; s < VK_SHADER_COUNT && ok; ++s) {
+    shaderc_compilation_result_t result = shaderc_compile_into_spv(
+        compiler, kShaderSources[s], strlen(kShaderSources[s]),
+        shaderc_glsl_compute_shader, kShaderNames[s], "main", NULL);
+    if (shaderc_result_get_compilation_status(result) !=
+        shaderc_compilation_status_success) {
+      tprintf("Vulkan shader %s failed to compile: %s\n", kShaderNames[s],
+              shaderc_result_get_error_message(result));
+      shaderc_result_release(result);
+      ok = false;
+      break;
+    }
+    VkShaderModuleCreateInfo module_info = {};
+    module_info.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+    module_info.codeSize = shaderc_result_get_length(result);
+    module_info.pCode =
+        reinterpret_cast<const uint32_t*>(shaderc_result_get_bytes(result));
+    VkShaderModule module;
+    ok = vkCreateShaderModule(device, &module_info, NULL, &module) ==
+         VK_SUCCESS;
+    shaderc_result_release(result);
+    if (!ok) break;
+    VkComputePipelineCreateInfo pipeline_info = {};
+    pipeline_info.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+    pipeline_info.stage.sType =
+        VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    pipeline_info.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+    pipeline_info.stage.module = module;
+    pipeline_info.stage.pName = "main";
+    pipeline_info.layout = pipeline_layout;
+    ok = vkCreateComputePipelines(device, VK_NULL_HANDLE, 1, &pipeline_info,
+                                  NULL, &pipelines[s]) == VK_SUCCESS;
+    if (!ok) pipelines[s] = VK_NULL_HANDLE;
+    vkDestroyShaderModule(device, module, NULL);
+  }
+  shaderc_compiler_release(compiler);
+  return ok;
+}
+
+// Makes the descriptor pool, the command buffer and its fence.
+static bool CreateCommandObjects(uint32_t queue_family) {
+  VkDescriptorPoolSize pool_size = {};
+  pool_size.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+  pool_size.descriptorCount = kMaxDispatches * kNumBindings;
+  VkDescriptorPoolCreateInfo pool_info = {};
+  pool_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+  pool_info.maxSets = kMaxDispatches;
+  pool_info.poolSizeCount = 1;
+  pool_info.pPoolSizes = &pool_size;
+  if (vkCreateDescriptorPool(device, &pool_info, NULL, &descriptor_pool) !=
+      VK_SUCCESS)
+    return false;
+  VkCommandPoolCreateInfo command_pool_info = {};
+  command_pool_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+  command_pool_info.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+  command_pool_info.queueFamilyIndex = queue_family;
+  if (vkCreateCommandPool(device, &command_pool_info, NULL, &command_pool) !=
+      VK_SUCCESS)
+    return false;
+  VkCommandBufferAllocateInfo command_info = {};
+  command_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+  command_info.commandPool = command_pool;
+  command_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+  command_info.commandBufferCount = 1;
+  if (vkAllocateCommandBuffers(device, &command_info, &command_buffer) !=
+      VK_SUCCESS)
+    return false;
+  VkFenceCreateInfo fence_info = {};
+  fence_info.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+  return vkCreateFence(device, &fence_info, NULL, &fence) == VK_SUCCESS;
+}
+
+// Loads the library, and makes the instance and the device, choosing the
+// first GPU with a compute queue.
+static bool CreateDevice() {
+  const char* env = getenv("TESSERACT_VULKAN");
+  if (env != NULL && strcmp(env, "0") == 0) return false;
+  vulkan_library = dlopen("libvulkan.so", RTLD_NOW | RTLD_LOCAL);
+  if (vulkan_library == NULL)
+    vulkan_library = dlopen("libvulkan.so.1", RTLD_NOW | RTLD_LOCAL);
+  if (vulkan_library == NULL) return false;
+  vkGetInstanceProcAddr = reinterpret_cast<PFN_vkGetInstanceProcAddr>(
+      dlsym(vulkan_library, "vkGetInstanceProcAddr"));
+  if (vkGetInstanceProcAddr == NULL) return false;
+  vkCreateInstance = reinterpret_cast<PFN_vkCreateInstance>(
+      vkGetInstanceProcAddr(VK_NULL_HANDLE, "vkCreateInstance"));
+  if (vkCreateInstance == NULL) return false;
+
+  VkApplicationInfo app_info = {};
+  app_info.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
+  app_info.pApplicationName = "tesseract";
+  app_info.pEngineName = "tesseract";
+  app_info.apiVersion = VK_MAKE_VERSION(1, 0, 0);
+  VkInstanceCreateInfo instance_info = {};
+  instance_info.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
+  instance_info.pApplicationInfo = &app_info;
+  if (vkCreateInstance(&instance_info, NULL, &instance) != VK_SUCCESS) {
+    instance = VK_NULL_HANDLE;
+    return false;
+  }
+#define TESS_VK_LOAD_INSTANCE_FUNCTION(name) \
+  name = reinterpret_cast<PFN_##name>(vkGetInstanceProcAddr(instance, #name)); \
+  if (name == NULL) return false;
+  TESS_VK_INSTANCE_FUNCTIONS(TESS_VK_LOAD_INSTANCE_FUNCTION)
+#undef TESS_VK_LOAD_INSTANCE_FUNCTION
+
+  uint32_t num_devices = 0;
+  vkEnumeratePhysicalDevices(instance, &num_devices, NULL);
+  if (num_devices == 0) return false;
+  VkPhysicalDevice* devices = new VkPhysicalDevice[num_devices];
+  vkEnumeratePhysicalDevices(instance, &num_devices, devices);
+  uint32_t queue_family = 0;
+  for (uint32_t d = 0; d < num_devices && physical_device == VK_NULL_HANDLE;
+       ++d) {
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(devices[d], &properties);
+    // A software device is no faster than the CPU code.
+    if (properties.deviceType != VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU &&
+        properties.deviceType != VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU)
+      continue;
+    uint32_t num_families = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(devices[d], &num_families, NULL);
+    VkQueueFamilyProperties* families = new VkQueueFamilyProperties[num_families];
+    vkGetPhysicalDeviceQueueFamilyProperties(devices[d], &num_families,
+                                             families);
+    for (uint32_t f = 0; f < num_families; ++f) {
+      if (families[f].queueFlags & VK_QUEUE_COMPUTE_BIT) {
+        physical_device = devices[d];
+        queue_family = f;
+        tprintf("Vulkan device: %s\n", properties.deviceName);
+        break;
+      }
+    }
+    delete[] families;
+  }
+  delete[] devices;
+  if (physical_device == VK_NULL_HANDLE || !FindMemoryType()) return false;
+
+  float priority = 1.0f;
+  VkDeviceQueueCreateInfo queue_info = {};
+  queue_info.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+  queue_info.queueFamilyIndex = queue_family;
+  queue_info.queueCount = 1;
+  queue_info.pQueuePriorities = &priority;
+  VkDeviceCreateInfo device_info = {};
+  device_info.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+  device_info.queueCreateInfoCount = 1;
+  device_info.pQueueCreateInfos = &queue_info;
+  if (vkCreateDevice(physical_device, &device_info, NULL, &device) !=
+      VK_SUCCESS) {
+    device = VK_NULL_HANDLE;
+    return false;
+  }
+#define TESS_VK_LOAD_DEVICE_FUNCTION(name) \
+  name = reinterpret_cast<PFN_##name>(vkGetDeviceProcAddr(device, #name)); \
+  if (name == NULL) return false;
+  TESS_VK_DEVICE_FUNCTIONS(TESS_VK_LOAD_DEVICE_FUNCTION)
+#undef TESS_VK_LOAD_DEVICE_FUNCTION
+  vkGetDeviceQueue(device, queue_family, 0, &queue);
+  return CreatePipelines() && CreateCommandObjects(queue_family) &&
+         EnsureBuffer(kSmallBufferWords * sizeof(l_uint32), &small_buffer);
+}
+
+// Frees whatever CreateDevice made. vk_mutex must be held.
+static void DestroyDevice() {
+  if (device != VK_NULL_HANDLE) {
+    FreeBuffer(&src_buffer);
+    FreeBuffer(&small_buffer);
+    for (int i = 0; i < VK_IMAGE_COUNT; ++i)
+      FreeBuffer(&image_buffers[i]);
+    if (fence != VK_NULL_HANDLE) vkDestroyFence(device, fence, NULL);
+    if (command_pool != VK_NULL_HANDLE)
+      vkDestroyCommandPool(device, command_pool, NULL);
+    if (descriptor_pool != VK_NULL_HANDLE)
+      vkDestroyDescriptorPool(device, descriptor_pool, NULL);
+    for (int s = 0; s < VK_SHADER_COUNT; ++s) {
+      if (pipelines[s] != VK_NULL_HANDLE)
+        vkDestroyPipeline(device, pipelines[s], NULL);
+      pipelines[s] = VK_NULL_HANDLE;
+    }
+    if (pipeline_layout != VK_NULL_HANDLE)
+      vkDestroyPipelineLayout(device, pipeline_layout, NULL);
+    if (set_layout != VK_NULL_HANDLE)
+      vkDestroyDescriptorSetLayout(device, set_layout, NULL);
+    if (vkDestroyDevice != NULL) vkDestroyDevice(device, NULL);
+  }
+  if (instance != VK_NULL_HANDLE && vkDestroyInstance != NULL)
+    vkDestroyInstance(instance, NULL);
+  fence = VK_NULL_HANDLE;
+  command_pool = VK_NULL_HANDLE;
+  command_buffer = VK_NULL_HANDLE;
+  descriptor_pool = VK_NULL_HANDLE;
+  pipeline_layout = VK_NULL_HANDLE;
+  set_layout = VK_NULL_HANDLE;
+  device = VK_NULL_HANDLE;
+  queue = VK_NULL_HANDLE;
+  physical_device = VK_NULL_HANDLE;
+  instance = VK_NULL_HANDLE;
+  resident_data = NULL;
+  resident_words = 0;
+  // The library stays loaded: the function pointers may still be set.
+}
+
+// Starts recording a submission.
+static bool BeginCommands() {
+  num_dispatches = 0;
+  if (vkResetDescriptorPool(device, descriptor_pool, 0) != VK_SUCCESS ||
+      vkResetCommandBuffer(command_buffer, 0) != VK_SUCCESS)
+    return false;
+  VkCommandBufferBeginInfo begin_info = {};
+  begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+  begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+  return vkBeginCommandBuffer(command_buffer, &begin_info) == VK_SUCCESS;
+}
+
+// Records a dispatch of shader over num_groups work groups, with the given
+// buffers bound to its three bindings and the given push constants. Waits
+// for the writes of the previous dispatch first.
+static bool Dispatch(VkShader shader, const VkHostBuffer* b0,
+                     const VkHostBuffer* b1, const VkHostBuffer* b2,
+                     const int32_t* constants, int num_constants,
+                     uint32_t num_groups) {
+  if (num_dispatches >= kMaxDispatches || num_groups == 0) return false;
+  VkDescriptorSetAllocateInfo set_info = {};
+  set_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+  set_info.descriptorPool = descriptor_pool;
+  set_info.descriptorSetCount = 1;
+  set_info.pSetLayouts = &set_layout;
+  VkDescriptorSet set;
+  if (vkAllocateDescriptorSets(device, &set_info, &set) != VK_SUCCESS)
+    return false;
+  const VkHostBuffer* buffers[kNumBindings] = {b0, b1, b2};
+  VkDescriptorBufferInfo buffer_infos[kNumBindings];
+  VkWriteDescriptorSet writes[kNumBindings];
+  memset(writes, 0, sizeof(writes));
+  for (int b = 0; b < kNumBindings; ++b) {
+    buffer_infos[b].buffer = buffers[b]->buffer;
+    buffer_infos[b].offset = 0;
+    buffer_infos[b].range = VK_WHOLE_SIZE;
+    writes[b].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    writes[b].dstSet = set;
+    writes[b].dstBinding = b;
+    writes[b].descriptorCount = 1;
+    writes[b].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    writes[b].pBufferInfo = &buffer_infos[b];
+  }
+  vkUpdateDescriptorSets(device, kNumBindings, writes, 0, NULL);
+  if (num_dispatches > 0) {
+    VkMemoryBarrier barrier = {};
+    barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT |
+                            VK_ACCESS_SHADER_WRITE_BIT;
+    vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                         VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &barrier,
+                         0, NULL, 0, NULL);
+  }
+  int32_t push[kMaxPushConstants];
+  memset(push, 0, sizeof(push));
+  memcpy(push, constants, num_constants * sizeof(int32_t));
+  vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE,
+                    pipelines[shader]);
+  vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE,
+                          pipeline_layout, 0, 1, &set, 0, NULL);
+  vkCmdPushConstants(command_buffer, pipeline_layout,
+                     VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(push), push);
+  vkCmdDispatch(command_buffer, num_groups, 1, 1);
+  ++num_dispatches;
+  return true;
+}
+
+// Ends the recording, runs it and waits for the results to be readable by
+// the host.
+static bool SubmitAndWait() {
+  VkMemoryBarrier barrier = {};
+  barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+  barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+  barrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+  vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                       VK_PIPELINE_STAGE_HOST_BIT, 0, 1, &barrier, 0, NULL, 0,
+                       NULL);
+  if (vkEndCommandBuffer(command_buffer) != VK_SUCCESS) return false;
+  VkSubmitInfo submit_info = {};
+  submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+  submit_info.commandBufferCount = 1;
+  submit_info.pCommandBuffers = &command_buffer;
+  if (vkQueueSubmit(queue, 1, &submit_info, fence) != VK_SUCCESS)
+    return false;
+  bool ok = vkWaitForFences(device, 1, &fence, VK_TRUE, UINT64_MAX) ==
+            VK_SUCCESS;
+  vkResetFences(device, 1, &fence);
+  return ok;
+}
+
+// Returns the number of one-dimensional work groups to cover num_items.
+static uint32_t GroupsFor(int num_items) {
+  return (num_items + kVkGroupSize - 1) / kVkGroupSize;
+}
+
+// Copies rows top to top + height of pix into src_buffer.
+static bool UploadRows(Pix* pix, int top, int height) {
+  int wpl = pixGetWpl(pix);
+  size_t bytes = static_cast<size_t>(wpl) * height * sizeof(l_uint32);
+  if (!EnsureBuffer(bytes, &src_buffer)) return false;
+  memcpy(src_buffer.data, pixGetData(pix) + top * wpl, bytes);
+  return true;
+}
+
+// Records a horizontal and a vertical pass of a brick dilation or erosion
+// of the image in buffer src into buffer dst, through buffer temp. A brick
+// of 1x1 copies src.
+static bool RecordBrick(bool dilate, int hsize, int vsize, int width,
+                        int height, int wpl, VkImage src, VkImage temp,
+                        VkImage dst) {
+  if (hsize < 1) hsize = 1;
+  if (vsize < 1) vsize = 1;
+  // The origin of a Leptonica brick is at its center, so a dilation takes
+  // the pixels from -(size - 1 - size / 2) to size / 2 away, and an
+  // erosion the opposite.
+  int xp = hsize / 2, xn = hsize - 1 - xp;
+  int yp = vsize / 2, yn = vsize - 1 - yp;
+  int h_lo = dilate ? -xn : -xp, h_hi = dilate ? xp : xn;
+  int v_lo = dilate ? -yn : -yp, v_hi = dilate ? yp : yn;
+  int erode = dilate ? 0 : 1;
+  uint32_t groups = GroupsFor(wpl * height);
+  VkImage hor_dst = vsize > 1 ? temp : dst;
+  if (hsize > 1) {
+    int32_t hor[] = {wpl, height, width, h_lo, h_hi, erode};
+    if (!Dispatch(VK_SHADER_MORPH_HOR, &image_buffers[src],
+                  &image_buffers[hor_dst], &small_buffer, hor, 6, groups))
+      return false;
+  }
+  if (vsize > 1 || hsize == 1) {
+    VkImage ver_src = hsize > 1 ? temp : src;
+    int32_t ver[] = {wpl, height, width, v_lo, v_hi, erode};
+    if (!Dispatch(VK_SHADER_MORPH_VER, &image_buffers[ver_src],
+                  &image_buffers[dst], &small_buffer, ver, 6, groups))
+      return false;
+  }
+  return true;
+}
+
+// Returns a new Pix like pixs holding the image in buffer image.
+static Pix* ReadImage(Pix* pixs, VkImage image, int words) {
+  Pix* pix = pixCreateTemplate(pixs);
+  if (pix != NULL)
+    memcpy(pixGetData(pix), image_buffers[image].data,
+           words * sizeof(l_uint32));
+  return pix;
+}
+
+static void* InitEnvThread(void* arg) {
+  VulkanDevice::InitEnv();
+  SVAutoLock lock(&vk_state_mutex);
+  vk_pending = false;
+  return NULL;
+}
+
+bool VulkanDevice::InitEnv() {
+  SVAutoLock lock(&vk_mutex);
+  {
+    SVAutoLock state_lock(&vk_state_mutex);
+    if (vk_tried) return vk_ready;
+  }
+  bool ready = CreateDevice();
+  if (!ready) DestroyDevice();
+  SVAutoLock state_lock(&vk_state_mutex);
+  vk_tried = true;
+  vk_ready = ready;
+  return ready;
+}
+
+void VulkanDevice::InitEnvAsync() {
+  {
+    SVAutoLock lock(&vk_state_mutex);
+    if (vk_tried || vk_pending) return;
+    vk_pending = true;
+  }
+  SVSync::StartThread(InitEnvThread, NULL);
+}
+
+bool VulkanDevice::IsAvailable() {
+  SVAutoLock lock(&vk_state_mutex);
+  return vk_ready && !vk_pending;
+}
+
+void VulkanDevice::ReleaseEnv() {
+  SVAutoLock lock(&vk_mutex);
+  DestroyDevice();
+  SVAutoLock state_lock(&vk_state_mutex);
+  vk_ready = false;
+}
+
+bool VulkanDevice::HistogramRectVK(Pix* src_pix, int left, int top,
+                                   int width, int height,
+                                   int* histogramAllChannels) {
+  int num_channels = pixGetDepth(src_pix) / 8;
+  // The rows are work groups, of which there may be no more than 65535.
+  if ((num_channels != 1 && num_channels != 4) || width <= 0 ||
+      height <= 0 || height > 65535 || !IsAvailable())
+    return false;
+  SVAutoLock lock(&vk_mutex);
+  if (!UploadRows(src_pix, top, height)) return false;
+  memset(small_buffer.data, 0, kSmallBufferWords * sizeof(l_uint32));
+  // One work group per row.
+  int32_t sizes[] = {pixGetWpl(src_pix), width, height, left, 0,
+                     num_channels};
+  if (!BeginCommands() ||
+      !Dispatch(VK_SHADER_HISTOGRAM, &src_buffer, &small_buffer,
+                &small_buffer, sizes, 6, height) ||
+      !SubmitAndWait())
+    return false;
+  memcpy(histogramAllChannels, small_buffer.data,
+         256 * num_channels * sizeof(int));
+  return true;
+}
+
+bool VulkanDevice::ThresholdRectToPixVK(Pix* src_pix, int num_channels,
+                                        const int* thresholds,
+                                        const int* hi_values, int left,
+                                        int top, int width, int height,
+                                        Pix** pix) {
+  if (num_channels < 1 || num_channels > 4 || width <= 0 || height <= 0 ||
+      !IsAvailable())
+    return false;
+  SVAutoLock lock(&vk_mutex);
+  resident_data = NULL;
+  int dst_wpl = (width + 31) / 32;
+  int words = dst_wpl * height;
+  if (!UploadRows(src_pix, top, height) ||
+      !EnsureBuffer(words * sizeof(l_uint32), &image_buffers[VK_IMAGE_SRC]))
+    return false;
+  int32_t* params = static_cast<int32_t*>(small_buffer.data);
+  for (int ch = 0; ch < num_channels; ++ch) {
+    params[ch] = thresholds[ch];
+    params[4 + ch] = hi_values[ch];
+  }
+  int32_t sizes[] = {pixGetWpl(src_pix), dst_wpl, width, height, left, 0,
+                     num_channels};
+  if (!BeginCommands() ||
+      !Dispatch(VK_SHADER_THRESHOLD, &src_buffer,
+                &image_buffers[VK_IMAGE_SRC], &small_buffer, sizes, 7,
+                GroupsFor(words)) ||
+      !SubmitAndWait())
+    return false;
+  *pix = pixCreate(width, height, 1);
+  if (*pix == NULL) return false;
+  memcpy(pixGetData(*pix), image_buffers[VK_IMAGE_SRC].data,
+         words * sizeof(l_uint32));
+  resident_data = pixGetData(*pix);
+  resident_words = words;
+  return true;
+}
+
+bool VulkanDevice::GetLinesVK(Pix* pixs, Pix** pix_vline, Pix** pix_hline,
+                              Pix** pix_closed, bool get_pix_closed,
+                              int close_hsize, int close_vsize,
+                              int open_hsize, int open_vsize, int line_hsize,
+                              int line_vsize) {
+  if (pixGetDepth(pixs) != 1 || !IsAvailable()) return false;
+  SVAutoLock lock(&vk_mutex);
+  int width = pixGetWidth(pixs);
+  int height = pixGetHeight(pixs);
+  int wpl = pixGetWpl(pixs);
+  int words = wpl * height;
+  for (int i = 0; i < VK_IMAGE_COUNT; ++i) {
+    if (!EnsureBuffer(words * sizeof(l_uint32), &image_buffers[i]))
+      return false;
+  }
+  // The thresholded image may still be in the source buffer.
+  if (resident_data != pixGetData(pixs) || resident_words != words)
+    memcpy(image_buffers[VK_IMAGE_SRC].data, pixGetData(pixs),
+           words * sizeof(l_uint32));
+  resident_data = NULL;
+  int32_t logic[] = {words, 0};
+  bool ok = BeginCommands() &&
+      // Closed = close(src).
+      RecordBrick(true, close_hsize, close_vsize, width, height, wpl,
+                  VK_IMAGE_SRC, VK_IMAGE_TEMP2, VK_IMAGE_TEMP1) &&
+      RecordBrick(false, close_hsize, close_vsize, width, height, wpl,
+                  VK_IMAGE_TEMP1, VK_IMAGE_TEMP2, VK_IMAGE_CLOSED) &&
+      // Solid = open(closed).
+      RecordBrick(false, open_hsize, open_vsize, width, height, wpl,
+                  VK_IMAGE_CLOSED, VK_IMAGE_TEMP2, VK_IMAGE_TEMP1) &&
+      RecordBrick(true, open_hsize, open_vsize, width, height, wpl,
+                  VK_IMAGE_TEMP1, VK_IMAGE_TEMP2, VK_IMAGE_SOLID) &&
+      // Hollow = closed - solid, in place of the source.
+      Dispatch(VK_SHADER_LOGIC, &image_buffers[VK_IMAGE_CLOSED],
+               &image_buffers[VK_IMAGE_SRC], &image_buffers[VK_IMAGE_SOLID],
+               logic, 2, GroupsFor(words)) &&
+      // The line masks are the openings of hollow by the line bricks.
+      RecordBrick(false, 1, line_vsize, width, height, wpl, VK_IMAGE_SRC,
+                  VK_IMAGE_TEMP2, VK_IMAGE_TEMP1) &&
+      RecordBrick(true, 1, line_vsize, width, height, wpl, VK_IMAGE_TEMP1,
+                  VK_IMAGE_TEMP2, VK_IMAGE_VLINE) &&
+      RecordBrick(false, line_hsize, 1, width, height, wpl, VK_IMAGE_SRC,
+                  VK_IMAGE_TEMP2, VK_IMAGE_TEMP1) &&
+      RecordBrick(true, line_hsize, 1, width, height, wpl, VK_IMAGE_TEMP1,
+                  VK_IMAGE_TEMP2, VK_IMAGE_HLINE) &&
+      SubmitAndWait();
+  if (!ok) return false;
+  *pix_vline = ReadImage(pixs, VK_IMAGE_VLINE, words);
+  *pix_hline = ReadImage(pixs, VK_IMAGE_HLINE, words);
+  if (get_pix_closed) *pix_closed = ReadImage(pixs, VK_IMAGE_CLOSED, words);
+  return true;
+}
+
+#endif  // USE_VULKAN
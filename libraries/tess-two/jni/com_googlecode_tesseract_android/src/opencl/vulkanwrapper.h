@@ -0,0 +1,71 @@
+///////////////////////////////////////////////////////////////////////
+// File:        vulkanwrapper.h
+// Description: Image preprocessing on the GPU through Vulkan compute.
+//
+// (C) Copyright 2016, Google Inc.
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////
+
+// A second GPU backend, for the many Android devices that have a Vulkan
+// driver but no OpenCL one. It runs the thresholding, histogram and line
+// finding morphology that OpenclDevice offloads, with the shaders of
+// vkkernels.h. libvulkan.so is loaded at run time, and every operation
+// returns false, for the caller to run its CPU code, if there is no usable
+// device. Built with USE_VULKAN; where OpenCL is also built and routes an
+// operation to its device, that takes precedence.
+
+#ifndef TESSERACT_OPENCL_VULKANWRAPPER_H_
+#define TESSERACT_OPENCL_VULKANWRAPPER_H_
+
+#ifdef USE_VULKAN
+
+struct Pix;
+
+class VulkanDevice {
+ public:
+  // Sets up the device and compiles the shaders, the first time it is
+  // called. Returns whether Vulkan can be used.
+  static bool InitEnv();
+  // Runs InitEnv on a background thread and returns at once. The
+  // operations run on the CPU until it has finished.
+  static void InitEnvAsync();
+  // Returns true once InitEnv has succeeded.
+  static bool IsAvailable();
+  // Frees the device and everything made on it.
+  static void ReleaseEnv();
+
+  // Computes the histograms of all the channels of the rectangle of
+  // src_pix (8 or 32 bit), laid out as in OtsuThreshold.
+  static bool HistogramRectVK(Pix* src_pix, int left, int top, int width,
+                              int height, int* histogramAllChannels);
+
+  // Thresholds the rectangle of src_pix into a new 1 bit *pix, as
+  // ImageThresholder::ThresholdRectToPix does. The result stays on the
+  // device for GetLinesVK.
+  static bool ThresholdRectToPixVK(Pix* src_pix, int num_channels,
+                                   const int* thresholds,
+                                   const int* hi_values, int left, int top,
+                                   int width, int height, Pix** pix);
+
+  // The line finding morphology of LineFinder: closes pixs, subtracts its
+  // opening by the solid brick and opens the rest by vertical and
+  // horizontal line bricks into new *pix_vline and *pix_hline. The closed
+  // image is returned in *pix_closed if get_pix_closed.
+  static bool GetLinesVK(Pix* pixs, Pix** pix_vline, Pix** pix_hline,
+                         Pix** pix_closed, bool get_pix_closed,
+                         int close_hsize, int close_vsize, int open_hsize,
+                         int open_vsize, int line_hsize, int line_vsize);
+};
+
+#endif  // USE_VULKAN
+
+#endif  // TESSERACT_OPENCL_VULKANWRAPPER_H_
@@ -35,7 +35,9 @@
 #include "helpers.h"
 #include "linlsq.h"
 #include "makerow.h"
+#include "tesscallback.h"
 #include "textord.h"
+#include "threadpool.h"
 #include "tprintf.h"
 #include "underlin.h"
 
@@ -142,8 +144,6 @@ double BaselineRow::StraightYAtX(double x) const {
 bool BaselineRow::FitBaseline(bool use_box_bottoms) {
   // Deterministic fitting is used wherever possible.
   fitter_.Clear();
-  // Linear least squares is a backup if the DetLineFit produces a bad line.
-  LLSQ llsq;
   BLOBNBOX_IT blob_it(blobs_);
 
   for (blob_it.mark_cycle_pt(); !blob_it.cycled_list(); blob_it.forward()) {
@@ -159,7 +159,6 @@ bool BaselineRow::FitBaseline(bool use_box_bottoms) {
     }
 #endif
     fitter_.Add(ICOORD(x_middle, blob->baseline_position()), box.width() / 2);
-    llsq.add(x_middle, blob->baseline_position());
   }
   // Fit the line.
   ICOORD pt1, pt2;
@@ -197,7 +196,14 @@ bool BaselineRow::FitBaseline(bool use_box_bottoms) {
   // on very short lines.
   double angle = BaselineAngle();
   if (fabs(angle) > M_PI * 0.25) {
-    // Use the llsq fit as a backup.
+    // Use a linear least squares fit as a backup. It is only needed here, so
+    // the points are only accumulated here.
+    LLSQ llsq;
+    for (blob_it.mark_cycle_pt(); !blob_it.cycled_list(); blob_it.forward()) {
+      const TBOX& box = blob_it.data()->bounding_box();
+      llsq.add((box.left() + box.right()) / 2,
+               blob_it.data()->baseline_position());
+    }
     baseline_pt1_ = llsq.mean_point();
     baseline_pt2_ = baseline_pt1_ + FCOORD(1.0f, llsq.m());
     // TODO(rays) get rid of this when m and c are no longer used.
@@ -422,16 +428,45 @@ double BaselineBlock::SpacingModelError(double perp_disp, double line_spacing,
   return fabs(perp_disp - model_y);
 }
 
+// The rows of a block, whose straight baselines are fitted independently.
+struct RowFitJob {
+  PointerVector<BaselineRow>* rows;
+  bool use_box_bottoms;
+  // The result of FitBaseline for each row.
+  GenericVector<bool> good_baselines;
+};
+
+static void FitRowBaseline(RowFitJob* job, int r) {
+  job->good_baselines[r] = (*job->rows)[r]->FitBaseline(job->use_box_bottoms);
+}
+
 // Fits straight line baselines and computes the skew angle from the
 // median angle. Returns true if a good angle is found.
 // If use_box_bottoms is false, baseline positions are formed by
 // considering the outlines of the blobs.
-bool BaselineBlock::FitBaselinesAndFindSkew(bool use_box_bottoms) {
+// The rows are fitted on thread_pool if given.
+bool BaselineBlock::FitBaselinesAndFindSkew(bool use_box_bottoms,
+                                            ThreadPool* thread_pool) {
   if (non_text_block_) return false;
+  // Each row only fits its own blobs, so the rows are fitted independently.
+  RowFitJob job;
+  job.rows = &rows_;
+  job.use_box_bottoms = use_box_bottoms;
+  job.good_baselines.init_to_size(rows_.size(), false);
+  if (thread_pool != NULL && thread_pool->num_threads() > 1 &&
+      rows_.size() > 1) {
+    TessCallback1<int>* fit_row = NewPermanentTessCallback(&FitRowBaseline,
+                                                           &job);
+    thread_pool->ParallelFor(rows_.size(), fit_row);
+    delete fit_row;
+  } else {
+    for (int r = 0; r < rows_.size(); ++r)
+      FitRowBaseline(&job, r);
+  }
   GenericVector<double> angles;
   for (int r = 0; r < rows_.size(); ++r) {
     BaselineRow* row = rows_[r];
-    if (row->FitBaseline(use_box_bottoms)) {
+    if (job.good_baselines[r]) {
       double angle = row->BaselineAngle();
       angles.push_back(angle);
     }
@@ -810,13 +845,15 @@ BaselineDetect::~BaselineDetect() {
 // Finds the initial baselines for each TO_ROW in each TO_BLOCK, gathers
 // block-wise and page-wise data to smooth small blocks/rows, and applies
 // smoothing based on block/page-level skew and block-level linespacing.
-void BaselineDetect::ComputeStraightBaselines(bool use_box_bottoms) {
+// The rows of each block are fitted on thread_pool if given.
+void BaselineDetect::ComputeStraightBaselines(bool use_box_bottoms,
+                                              ThreadPool* thread_pool) {
   GenericVector<double> block_skew_angles;
   for (int i = 0; i < blocks_.size(); ++i) {
     BaselineBlock* bl_block = blocks_[i];
     if (debug_level_ > 0)
       tprintf("Fitting initial baselines...\n");
-    if (bl_block->FitBaselinesAndFindSkew(use_box_bottoms)) {
+    if (bl_block->FitBaselinesAndFindSkew(use_box_bottoms, thread_pool)) {
       block_skew_angles.push_back(bl_block->skew_angle());
     }
   }
@@ -35,6 +35,7 @@ struct Pix;
 namespace tesseract {
 
 class Textord;
+class ThreadPool;
 
 // Class to compute and hold baseline data for a TO_ROW.
 class BaselineRow {
@@ -146,7 +147,9 @@ class BaselineBlock {
   // median angle. Returns true if a good angle is found.
   // If use_box_bottoms is false, baseline positions are formed by
   // considering the outlines of the blobs.
-  bool FitBaselinesAndFindSkew(bool use_box_bottoms);
+  // The rows are fitted on thread_pool if given.
+  bool FitBaselinesAndFindSkew(bool use_box_bottoms,
+                               ThreadPool* thread_pool = NULL);
 
   // Refits the baseline to a constrained angle, using the stored block
   // skew if good enough, otherwise the supplied default skew.
@@ -249,7 +252,9 @@ class BaselineDetect {
   // Finds the initial baselines for each TO_ROW in each TO_BLOCK, gathers
   // block-wise and page-wise data to smooth small blocks/rows, and applies
   // smoothing based on block/page-level skew and block-level linespacing.
-  void ComputeStraightBaselines(bool use_box_bottoms);
+  // The rows of each block are fitted on thread_pool if given.
+  void ComputeStraightBaselines(bool use_box_bottoms,
+                                ThreadPool* thread_pool = NULL);
 
   // Computes the baseline splines for each TO_ROW in each TO_BLOCK and
   // other associated side-effects, including pre-associating blobs, computing
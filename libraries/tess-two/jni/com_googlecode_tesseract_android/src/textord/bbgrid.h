@@ -23,6 +23,7 @@
 
 #include "clst.h"
 #include "coutln.h"
+#include "genericvector.h"
 #include "hashfn.h"
 #include "rect.h"
 #include "scrollview.h"
@@ -155,6 +156,11 @@ class IntGrid : public GridBase {
 // thereby making most of the ugly template notation go away.
 // The friend class GridSearch, with the same template arguments, is
 // used to search a grid efficiently in one of several search patterns.
+// For read-mostly phases, Freeze packs the cells into flat arrays (in
+// compressed-sparse-row form: per-cell start offsets into one array of
+// element pointers and a parallel array of their boxes), which GridSearch
+// then walks instead of the C_LISTs. The C_LISTs remain the master copy,
+// so any change to the grid simply thaws it again.
 template<class BBC, class BBC_CLIST, class BBC_C_IT> class BBGrid
   : public GridBase {
   friend class GridSearch<BBC, BBC_CLIST, BBC_C_IT>;
@@ -196,6 +202,17 @@ template<class BBC, class BBC_CLIST, class BBC_C_IT> class BBGrid
   // If a GridSearch is operating, call GridSearch::RemoveBBox() instead.
   void RemoveBBox(BBC* bbox);
 
+  // Packs the cells into flat arrays for fast searching. The boxes of the
+  // elements are cached, so they must not change while the grid is frozen.
+  // Any insertion or removal thaws the grid, and any GridSearch active at
+  // the time must then be repositioned, as with an unfrozen grid.
+  void Freeze();
+  // Discards the flat arrays, returning to searching the C_LISTs.
+  void Thaw();
+  bool frozen() const {
+    return frozen_;
+  }
+
   // Returns true if the given rectangle has no overlapping elements.
   bool RectangleEmpty(const TBOX& rect);
 
@@ -221,6 +238,13 @@ template<class BBC, class BBC_CLIST, class BBC_C_IT> class BBGrid
   BBC_CLIST* grid_;  // 2-d array of CLISTS of BBC elements.
 
  private:
+  // True while the flat arrays below hold a copy of grid_.
+  bool frozen_;
+  // Elements of cell i are at [cell_starts_[i], cell_starts_[i + 1]) in
+  // cell_elements_, in list order, with their boxes in cell_boxes_.
+  GenericVector<int> cell_starts_;
+  GenericVector<BBC*> cell_elements_;
+  GenericVector<TBOX> cell_boxes_;
 };
 
 // Hash functor for generic pointers.
@@ -236,7 +260,8 @@ template<class BBC, class BBC_CLIST, class BBC_C_IT> class GridSearch {
  public:
   GridSearch(BBGrid<BBC, BBC_CLIST, BBC_C_IT>* grid)
       : grid_(grid), unique_mode_(false),
-        previous_return_(NULL), next_return_(NULL) {
+        previous_return_(NULL), next_return_(NULL),
+        search_frozen_(false), cell_index_(0), cell_pos_(0), cell_end_(0) {
   }
 
   // Get the grid x, y coords of the most recently returned BBC.
@@ -343,6 +368,10 @@ template<class BBC, class BBC_CLIST, class BBC_C_IT> class GridSearch {
   // Factored out function to set the iterator to the current x_, y_
   // grid coords and mark the cycle pt.
   void SetIterator();
+  // Returns true when the current cell has been fully returned.
+  bool CellExhausted();
+  // Returns the bounding box of previous_return_, from the cache if frozen.
+  const TBOX& PreviousBox() const;
 
  private:
   // The grid we are searching.
@@ -363,6 +392,14 @@ template<class BBC, class BBC_CLIST, class BBC_C_IT> class GridSearch {
   BBC* next_return_;  // Current value of it_.data() used for repositioning.
   // An iterator over the list at (x_, y_) in the grid_.
   BBC_C_IT it_;
+  // True if the current cell is being read from the frozen arrays of grid_
+  // instead of it_.
+  bool search_frozen_;
+  // Index of the current cell and, when frozen, the position of the next
+  // element in it and the end of the cell in the flat arrays.
+  int cell_index_;
+  int cell_pos_;
+  int cell_end_;
   // Set of unique returned elements used when unique_mode_ is true.
   TessHashSet<BBC*, PtrHash<BBC> > returns_;
 };
@@ -425,13 +462,13 @@ int SortByBoxBottom(const void* void1, const void* void2) {
 // BBGrid IMPLEMENTATION.
 ///////////////////////////////////////////////////////////////////////
 template<class BBC, class BBC_CLIST, class BBC_C_IT>
-BBGrid<BBC, BBC_CLIST, BBC_C_IT>::BBGrid() : grid_(NULL) {
+BBGrid<BBC, BBC_CLIST, BBC_C_IT>::BBGrid() : grid_(NULL), frozen_(false) {
 }
 
 template<class BBC, class BBC_CLIST, class BBC_C_IT>
 BBGrid<BBC, BBC_CLIST, BBC_C_IT>::BBGrid(
   int gridsize, const ICOORD& bleft, const ICOORD& tright)
-    : grid_(NULL) {
+    : grid_(NULL), frozen_(false) {
   Init(gridsize, bleft, tright);
 }
 
@@ -447,6 +484,7 @@ template<class BBC, class BBC_CLIST, class BBC_C_IT>
 void BBGrid<BBC, BBC_CLIST, BBC_C_IT>::Init(int gridsize,
                                             const ICOORD& bleft,
                                             const ICOORD& tright) {
+  Thaw();
   GridBase::Init(gridsize, bleft, tright);
   if (grid_ != NULL)
     delete [] grid_;
@@ -456,6 +494,7 @@ void BBGrid<BBC, BBC_CLIST, BBC_C_IT>::Init(int gridsize,
 // Clear all lists, but leave the array of lists present.
 template<class BBC, class BBC_CLIST, class BBC_C_IT>
 void BBGrid<BBC, BBC_CLIST, BBC_C_IT>::Clear() {
+  Thaw();
   for (int i = 0; i < gridbuckets_; ++i) {
     grid_[i].shallow_clear();
   }
@@ -475,6 +514,7 @@ void BBGrid<BBC, BBC_CLIST, BBC_C_IT>::ClearGridData(
   while ((bb = search.NextFullSearch()) != NULL) {
     it.add_after_then_move(bb);
   }
+  Thaw();
   for (it.mark_cycle_pt(); !it.cycled_list(); it.forward()) {
     free_method(it.data());
   }
@@ -488,6 +528,7 @@ void BBGrid<BBC, BBC_CLIST, BBC_C_IT>::ClearGridData(
 template<class BBC, class BBC_CLIST, class BBC_C_IT>
 void BBGrid<BBC, BBC_CLIST, BBC_C_IT>::InsertBBox(bool h_spread, bool v_spread,
                                                   BBC* bbox) {
+  Thaw();
   TBOX box = bbox->bounding_box();
   int start_x, start_y, end_x, end_y;
   GridCoords(box.left(), box.bottom(), &start_x, &start_y);
@@ -516,6 +557,7 @@ void BBGrid<BBC, BBC_CLIST, BBC_C_IT>::InsertBBox(bool h_spread, bool v_spread,
 template<class BBC, class BBC_CLIST, class BBC_C_IT>
 void BBGrid<BBC, BBC_CLIST, BBC_C_IT>::InsertPixPtBBox(int left, int bottom,
                                                        Pix* pix, BBC* bbox) {
+  Thaw();
   int width = pixGetWidth(pix);
   int height = pixGetHeight(pix);
   for (int y = 0; y < height; ++y) {
@@ -534,6 +576,7 @@ void BBGrid<BBC, BBC_CLIST, BBC_C_IT>::InsertPixPtBBox(int left, int bottom,
 // If a GridSearch is operating, call GridSearch::RemoveBBox() instead.
 template<class BBC, class BBC_CLIST, class BBC_C_IT>
 void BBGrid<BBC, BBC_CLIST, BBC_C_IT>::RemoveBBox(BBC* bbox) {
+  Thaw();
   TBOX box = bbox->bounding_box();
   int start_x, start_y, end_x, end_y;
   GridCoords(box.left(), box.bottom(), &start_x, &start_y);
@@ -550,6 +593,39 @@ void BBGrid<BBC, BBC_CLIST, BBC_C_IT>::RemoveBBox(BBC* bbox) {
   }
 }
 
+// Packs the cells into flat arrays for fast searching. The boxes of the
+// elements are cached, so they must not change while the grid is frozen.
+template<class BBC, class BBC_CLIST, class BBC_C_IT>
+void BBGrid<BBC, BBC_CLIST, BBC_C_IT>::Freeze() {
+  if (frozen_ || grid_ == NULL) return;
+  int total = 0;
+  for (int i = 0; i < gridbuckets_; ++i)
+    total += grid_[i].length();
+  cell_starts_.reserve(gridbuckets_ + 1);
+  cell_elements_.reserve(total);
+  cell_boxes_.reserve(total);
+  for (int i = 0; i < gridbuckets_; ++i) {
+    cell_starts_.push_back(cell_elements_.size());
+    BBC_C_IT it(&grid_[i]);
+    for (it.mark_cycle_pt(); !it.cycled_list(); it.forward()) {
+      cell_elements_.push_back(it.data());
+      cell_boxes_.push_back(it.data()->bounding_box());
+    }
+  }
+  cell_starts_.push_back(cell_elements_.size());
+  frozen_ = true;
+}
+
+// Discards the flat arrays, returning to searching the C_LISTs.
+template<class BBC, class BBC_CLIST, class BBC_C_IT>
+void BBGrid<BBC, BBC_CLIST, BBC_C_IT>::Thaw() {
+  if (!frozen_) return;
+  frozen_ = false;
+  cell_starts_.clear();
+  cell_elements_.clear();
+  cell_boxes_.clear();
+}
+
 // Returns true if the given rectangle has no overlapping elements.
 template<class BBC, class BBC_CLIST, class BBC_C_IT>
 bool BBGrid<BBC, BBC_CLIST, BBC_C_IT>::RectangleEmpty(const TBOX& rect) {
@@ -565,7 +641,10 @@ IntGrid* BBGrid<BBC, BBC_CLIST, BBC_C_IT>::CountCellElements() {
   IntGrid* intgrid = new IntGrid(gridsize(), bleft(), tright());
   for (int y = 0; y < gridheight(); ++y) {
     for (int x = 0; x < gridwidth(); ++x) {
-      int cell_count = grid_[y * gridwidth() + x].length();
+      int index = y * gridwidth() + x;
+      int cell_count = frozen_
+          ? cell_starts_[index + 1] - cell_starts_[index]
+          : grid_[index].length();
       intgrid->SetGridCell(x, y, cell_count);
     }
   }
@@ -679,7 +758,7 @@ BBC* GridSearch<BBC, BBC_CLIST, BBC_C_IT>::NextFullSearch() {
   int x;
   int y;
   do {
-    while (it_.cycled_list()) {
+    while (CellExhausted()) {
       ++x_;
       if (x_ >= grid_->gridwidth_) {
         --y_;
@@ -690,7 +769,7 @@ BBC* GridSearch<BBC, BBC_CLIST, BBC_C_IT>::NextFullSearch() {
       SetIterator();
     }
     CommonNext();
-    TBOX box = previous_return_->bounding_box();
+    const TBOX& box = PreviousBox();
     grid_->GridCoords(box.left(), box.bottom(), &x, &y);
   } while (x != x_ || y != y_);
   return previous_return_;
@@ -715,7 +794,7 @@ void GridSearch<BBC, BBC_CLIST, BBC_C_IT>::StartRadSearch(int x, int y,
 template<class BBC, class BBC_CLIST, class BBC_C_IT>
 BBC* GridSearch<BBC, BBC_CLIST, BBC_C_IT>::NextRadSearch() {
   do {
-    while (it_.cycled_list()) {
+    while (CellExhausted()) {
       ++rad_index_;
       if (rad_index_ >= radius_) {
         ++rad_dir_;
@@ -763,7 +842,7 @@ void GridSearch<BBC, BBC_CLIST, BBC_C_IT>::StartSideSearch(int x,
 template<class BBC, class BBC_CLIST, class BBC_C_IT>
 BBC* GridSearch<BBC, BBC_CLIST, BBC_C_IT>::NextSideSearch(bool right_to_left) {
   do {
-    while (it_.cycled_list()) {
+    while (CellExhausted()) {
       ++rad_index_;
       if (rad_index_ > radius_) {
         if (right_to_left)
@@ -805,7 +884,7 @@ template<class BBC, class BBC_CLIST, class BBC_C_IT>
 BBC* GridSearch<BBC, BBC_CLIST, BBC_C_IT>::NextVerticalSearch(
     bool top_to_bottom) {
   do {
-    while (it_.cycled_list()) {
+    while (CellExhausted()) {
       ++rad_index_;
       if (rad_index_ > radius_) {
         if (top_to_bottom)
@@ -844,7 +923,7 @@ void GridSearch<BBC, BBC_CLIST, BBC_C_IT>::StartRectSearch(const TBOX& rect) {
 template<class BBC, class BBC_CLIST, class BBC_C_IT>
 BBC* GridSearch<BBC, BBC_CLIST, BBC_C_IT>::NextRectSearch() {
   do {
-    while (it_.cycled_list()) {
+    while (CellExhausted()) {
       ++x_;
       if (x_ > max_radius_) {
         --y_;
@@ -855,7 +934,7 @@ BBC* GridSearch<BBC, BBC_CLIST, BBC_C_IT>::NextRectSearch() {
       SetIterator();
     }
     CommonNext();
-  } while (!rect_.overlap(previous_return_->bounding_box()) ||
+  } while (!rect_.overlap(PreviousBox()) ||
            (unique_mode_ && returns_.find(previous_return_) != returns_.end()));
   if (unique_mode_)
     returns_.insert(previous_return_);
@@ -867,7 +946,16 @@ BBC* GridSearch<BBC, BBC_CLIST, BBC_C_IT>::NextRectSearch() {
 // in use, call RepositionIterator on those, to continue without harm.
 template<class BBC, class BBC_CLIST, class BBC_C_IT>
 void GridSearch<BBC, BBC_CLIST, BBC_C_IT>::RemoveBBox() {
-  if (previous_return_ != NULL) {
+  if (previous_return_ != NULL && search_frozen_) {
+    // Removal thaws the grid, so find the element before previous_return_
+    // in the flat copy of the cell, and carry on with the list.
+    int cell_start = grid_->cell_starts_[cell_index_];
+    BBC* new_previous_return = cell_pos_ - 2 >= cell_start
+        ? grid_->cell_elements_[cell_pos_ - 2] : NULL;
+    grid_->RemoveBBox(previous_return_);
+    previous_return_ = new_previous_return;
+    RepositionIterator();
+  } else if (previous_return_ != NULL) {
     // Remove all instances of previous_return_ from the list, so the iterator
     // remains valid after removal from the rest of the grid cells.
     // if previous_return_ is not on the list, then it has been removed already.
@@ -896,6 +984,12 @@ void GridSearch<BBC, BBC_CLIST, BBC_C_IT>::RepositionIterator() {
   // Something was deleted, so we have little choice but to clear the
   // returns list.
   returns_.clear();
+  if (search_frozen_) {
+    if (grid_->frozen_) return;  // The flat arrays are still valid.
+    // The grid has been thawed, so continue on the list of the same cell.
+    search_frozen_ = false;
+    it_ = &(grid_->grid_[cell_index_]);
+  }
   // Reset the iterator back to one past the previous return.
   // If the previous_return_ is no longer in the list, then
   // next_return_ serves as a backup.
@@ -927,13 +1021,23 @@ void GridSearch<BBC, BBC_CLIST, BBC_C_IT>::CommonStart(int x, int y) {
   y_ = y_origin_;
   SetIterator();
   previous_return_ = NULL;
-  next_return_ = it_.empty() ? NULL : it_.data();
+  if (search_frozen_)
+    next_return_ = cell_pos_ < cell_end_ ? grid_->cell_elements_[cell_pos_]
+                                         : NULL;
+  else
+    next_return_ = it_.empty() ? NULL : it_.data();
   returns_.clear();
 }
 
 // Factored out helper to complete a next search.
 template<class BBC, class BBC_CLIST, class BBC_C_IT>
 BBC* GridSearch<BBC, BBC_CLIST, BBC_C_IT>::CommonNext() {
+  if (search_frozen_) {
+    previous_return_ = grid_->cell_elements_[cell_pos_++];
+    next_return_ = cell_pos_ < cell_end_ ? grid_->cell_elements_[cell_pos_]
+                                         : NULL;
+    return previous_return_;
+  }
   previous_return_ = it_.data();
   it_.forward();
   next_return_ = it_.cycled_list() ? NULL : it_.data();
@@ -952,8 +1056,37 @@ BBC* GridSearch<BBC, BBC_CLIST, BBC_C_IT>::CommonEnd() {
 // grid coords and mark the cycle pt.
 template<class BBC, class BBC_CLIST, class BBC_C_IT>
 void GridSearch<BBC, BBC_CLIST, BBC_C_IT>::SetIterator() {
-  it_= &(grid_->grid_[y_ * grid_->gridwidth_ + x_]);
-  it_.mark_cycle_pt();
+  cell_index_ = y_ * grid_->gridwidth_ + x_;
+  search_frozen_ = grid_->frozen_;
+  if (search_frozen_) {
+    cell_pos_ = grid_->cell_starts_[cell_index_];
+    cell_end_ = grid_->cell_starts_[cell_index_ + 1];
+  } else {
+    it_= &(grid_->grid_[cell_index_]);
+    it_.mark_cycle_pt();
+  }
+}
+
+// Returns true when the current cell has been fully returned.
+template<class BBC, class BBC_CLIST, class BBC_C_IT>
+bool GridSearch<BBC, BBC_CLIST, BBC_C_IT>::CellExhausted() {
+  if (search_frozen_) {
+    // If the grid was thawed without RepositionIterator being called, the
+    // flat arrays are gone, so move over to the list.
+    if (!grid_->frozen_)
+      RepositionIterator();
+    else
+      return cell_pos_ >= cell_end_;
+  }
+  return it_.cycled_list();
+}
+
+// Returns the bounding box of previous_return_, from the cache if frozen.
+template<class BBC, class BBC_CLIST, class BBC_C_IT>
+const TBOX& GridSearch<BBC, BBC_CLIST, BBC_C_IT>::PreviousBox() const {
+  if (search_frozen_)
+    return grid_->cell_boxes_[cell_pos_ - 1];
+  return previous_return_->bounding_box();
 }
 
 }  // namespace tesseract.
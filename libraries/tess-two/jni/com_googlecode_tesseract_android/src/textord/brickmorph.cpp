@@ -0,0 +1,308 @@
+///////////////////////////////////////////////////////////////////////
+// File:        brickmorph.cpp
+// Description: Binary morphology by rectangular bricks, a band of rows
+//              at a time and with SIMD row kernels.
+//
+// (C) Copyright 2017, Google Inc.
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////
+
+#ifdef HAVE_CONFIG_H
+#include "config_auto.h"
+#endif
+
+#include "brickmorph.h"
+
+#include <string.h>
+
+#include "allheaders.h"
+#include "genericvector.h"
+#include "morphsimd.h"
+#include "simddetect.h"
+#include "tesscallback.h"
+#include "threadpool.h"
+
+namespace tesseract {
+
+// Fewest rows in a band worth handing to another thread.
+const int kMinBrickBandHeight = 32;
+
+// Returns the fastest kernel to combine whole rows on this CPU, or NULL if
+// there is none and the scalar code must be used.
+static CombineRowsFunc BestCombineRowsKernel() {
+  if (SIMDDetect::IsAVX2Available()) return CombineRowsAVX2;
+  if (SIMDDetect::IsSSE2Available()) return CombineRowsSSE2;
+  if (SIMDDetect::IsNEONAvailable()) return CombineRowsNEON;
+  return NULL;
+}
+
+// As BestCombineRowsKernel, but for combining with a shifted row.
+static CombineShiftedRowFunc BestCombineShiftedRowKernel() {
+  if (SIMDDetect::IsAVX2Available()) return CombineShiftedRowAVX2;
+  if (SIMDDetect::IsSSE2Available()) return CombineShiftedRowSSE2;
+  if (SIMDDetect::IsNEONAvailable()) return CombineShiftedRowNEON;
+  return NULL;
+}
+
+// Sets dst[i] = a[i] | b[i], or a[i] & b[i] if erode, as CombineRowsFunc.
+static void CombineRows(const uinT32* a, const uinT32* b, int words,
+                        bool erode, uinT32* dst) {
+  static const CombineRowsFunc kernel = BestCombineRowsKernel();
+  int i = kernel != NULL ? kernel(a, b, words, erode, dst) : 0;
+  for (; i < words; ++i)
+    dst[i] = erode ? a[i] & b[i] : a[i] | b[i];
+}
+
+// Combines a with b moved left by shift pixels, as CombineShiftedRowFunc.
+static void CombineShiftedRow(const uinT32* a, const uinT32* b, int shift,
+                              int words, bool erode, uinT32* dst) {
+  static const CombineShiftedRowFunc kernel = BestCombineShiftedRowKernel();
+  int i = kernel != NULL ? kernel(a, b, shift, words, erode, dst) : 0;
+  for (; i < words; ++i) {
+    uinT32 s = b[i];
+    if (shift != 0)
+      s = (s << shift) | (b[i + 1] >> (32 - shift));
+    if (a != NULL)
+      s = erode ? a[i] & s : a[i] | s;
+    dst[i] = s;
+  }
+}
+
+// Clears pixels [start, end) of a 1 bpp line.
+static void ClearPixels(uinT32* line, int start, int end) {
+  for (int x = start; x < end; ) {
+    int bit = x & 31;
+    int count = MIN(32 - bit, end - x);
+    uinT32 mask = count == 32 ? 0xffffffffu
+                              : ((1u << count) - 1) << (32 - bit - count);
+    line[x >> 5] &= ~mask;
+    x += count;
+  }
+}
+
+// One separable step of a brick operation: a dilation or erosion of src
+// into dst by a brick of size pixels in one direction, with its origin at
+// size / 2 as Leptonica puts it.
+struct BrickPass {
+  Pix* src;
+  Pix* dst;
+  int size;
+  bool horizontal;
+  bool erode;
+  int num_bands;
+};
+
+// Does the rows of a horizontal pass in [first_row, last_row).
+// A row is copied into the middle of a buffer with pad words of the value
+// that does not change the result on either side. Then, with R_m(x) being
+// the combination of pixels [x, x + m) of it, R_2m(x) = R_m(x) op
+// R_m(x + m) builds R_size in place in log2(size) steps, and the result at
+// x is R_size at the start of the brick, x - origin for an erosion.
+// Leptonica takes the pixels outside the image to be off, even for an
+// erosion, so the pixels the brick overhangs the image from are then
+// cleared.
+static void HorizontalBrickRows(const BrickPass& pass, int first_row,
+                                int last_row) {
+  int width = pixGetWidth(pass.src);
+  int wpl_src = pixGetWpl(pass.src);
+  int wpl_dst = pixGetWpl(pass.dst);
+  int words = (width + 31) / 32;
+  int size = pass.size;
+  int origin = size / 2;
+  int start = pass.erode ? -origin : origin + 1 - size;
+  uinT32 fill = pass.erode ? 0xffffffffu : 0;
+  uinT32 last_mask = (width & 31) == 0 ? 0xffffffffu
+                                       : ~(0xffffffffu >> (width & 31));
+  int pad = size / 32 + 2;
+  GenericVector<uinT32> buffer;
+  buffer.init_to_size(words + 2 * pad + 1, fill);
+  uinT32* row = &buffer[pad];
+  int buffer_words = buffer.size();
+  for (int y = first_row; y < last_row; ++y) {
+    const uinT32* src_line = pixGetData(pass.src) + y * wpl_src;
+    uinT32* dst_line = pixGetData(pass.dst) + y * wpl_dst;
+    // The steps leave the pads changed, so they are filled again.
+    for (int i = 0; i < pad; ++i)
+      buffer[i] = fill;
+    memcpy(row, src_line, words * sizeof(*row));
+    row[words - 1] = (row[words - 1] & last_mask) | (fill & ~last_mask);
+    for (int i = pad + words; i < buffer_words; ++i)
+      buffer[i] = fill;
+    int span = 1;
+    while (span < size) {
+      int step = MIN(span, size - span);
+      CombineShiftedRow(&buffer[0], &buffer[step / 32], step % 32,
+                        buffer_words - 1 - step / 32, pass.erode, &buffer[0]);
+      span += step;
+    }
+    int begin = pad * 32 + start;
+    CombineShiftedRow(NULL, &buffer[begin / 32], begin % 32, words,
+                      pass.erode, dst_line);
+    dst_line[words - 1] &= last_mask;
+    if (pass.erode) {
+      ClearPixels(dst_line, 0, MIN(origin, width));
+      ClearPixels(dst_line, MAX(width - (size - 1 - origin), 0), width);
+    }
+  }
+}
+
+// Does the rows of a vertical pass in [first_row, last_row), each as the
+// combination of the rows of src that the brick covers.
+static void VerticalBrickRows(const BrickPass& pass, int first_row,
+                              int last_row) {
+  int height = pixGetHeight(pass.src);
+  int wpl_src = pixGetWpl(pass.src);
+  int wpl_dst = pixGetWpl(pass.dst);
+  int width = pixGetWidth(pass.src);
+  int words = (width + 31) / 32;
+  uinT32 last_mask = (width & 31) == 0 ? 0xffffffffu
+                                       : ~(0xffffffffu >> (width & 31));
+  int origin = pass.size / 2;
+  int start = pass.erode ? -origin : origin + 1 - pass.size;
+  const uinT32* src_data = pixGetData(pass.src);
+  for (int y = first_row; y < last_row; ++y) {
+    uinT32* dst_line = pixGetData(pass.dst) + y * wpl_dst;
+    int first = y + start;
+    int last = first + pass.size - 1;
+    if (pass.erode && (first < 0 || last >= height)) {
+      memset(dst_line, 0, words * sizeof(*dst_line));
+      continue;
+    }
+    first = MAX(first, 0);
+    last = MIN(last, height - 1);
+    memcpy(dst_line, src_data + first * wpl_src, words * sizeof(*dst_line));
+    for (int r = first + 1; r <= last; ++r) {
+      CombineRows(dst_line, src_data + r * wpl_src, words, pass.erode,
+                  dst_line);
+    }
+    dst_line[words - 1] &= last_mask;
+  }
+}
+
+// Does band b of num_bands equal bands of the rows of a pass.
+static void RunBrickBand(const BrickPass* pass, int b) {
+  int height = pixGetHeight(pass->src);
+  int first_row = static_cast<int>(static_cast<inT64>(height) * b /
+                                   pass->num_bands);
+  int last_row = static_cast<int>(static_cast<inT64>(height) * (b + 1) /
+                                  pass->num_bands);
+  if (pass->horizontal)
+    HorizontalBrickRows(*pass, first_row, last_row);
+  else
+    VerticalBrickRows(*pass, first_row, last_row);
+}
+
+// Runs a pass of src into dst, split into bands on thread_pool if given.
+static void RunBrickPass(Pix* src, Pix* dst, int size, bool horizontal,
+                         bool erode, ThreadPool* thread_pool) {
+  BrickPass pass;
+  pass.src = src;
+  pass.dst = dst;
+  pass.size = size;
+  pass.horizontal = horizontal;
+  pass.erode = erode;
+  pass.num_bands = 1;
+  if (thread_pool != NULL && thread_pool->num_threads() > 1) {
+    pass.num_bands = MIN(thread_pool->num_threads() * 2,
+                         pixGetHeight(src) / kMinBrickBandHeight);
+  }
+  if (pass.num_bands <= 1) {
+    pass.num_bands = 1;
+    RunBrickBand(&pass, 0);
+    return;
+  }
+  TessCallback1<int>* band = NewPermanentTessCallback(&RunBrickBand,
+                                                      &pass);
+  thread_pool->ParallelFor(pass.num_bands, band);
+  delete band;
+}
+
+// The brick operations, as a sequence of dilations and erosions.
+enum BrickOperation {
+  BRICK_DILATE,
+  BRICK_ERODE,
+  BRICK_OPEN,
+  BRICK_CLOSE
+};
+
+// Returns the result of Leptonica's own function for the operation.
+static Pix* LeptonicaBrick(BrickOperation operation, Pix* pix, int hsize,
+                           int vsize) {
+  switch (operation) {
+    case BRICK_DILATE:
+      return pixDilateBrick(NULL, pix, hsize, vsize);
+    case BRICK_ERODE:
+      return pixErodeBrick(NULL, pix, hsize, vsize);
+    case BRICK_OPEN:
+      return pixOpenBrick(NULL, pix, hsize, vsize);
+    case BRICK_CLOSE:
+      return pixCloseBrick(NULL, pix, hsize, vsize);
+  }
+  return NULL;
+}
+
+// Does the operation separably, horizontally first, as Leptonica does,
+// alternating between two images for the results of the passes.
+static Pix* Brick(BrickOperation operation, Pix* pix, int hsize, int vsize,
+                  ThreadPool* thread_pool) {
+  // Leptonica also handles the errors.
+  if (pix == NULL || pixGetDepth(pix) != 1 || hsize < 1 || vsize < 1 ||
+      getMorphBorderPixelColor(L_MORPH_ERODE, 1) != 0)
+    return LeptonicaBrick(operation, pix, hsize, vsize);
+  if (hsize == 1 && vsize == 1)
+    return pixCopy(NULL, pix);
+  bool erode_first = operation == BRICK_ERODE || operation == BRICK_OPEN;
+  int num_steps =
+      operation == BRICK_OPEN || operation == BRICK_CLOSE ? 2 : 1;
+  Pix* results[2] = { NULL, NULL };
+  Pix* src = pix;
+  int next = 0;
+  for (int step = 0; step < num_steps; ++step) {
+    bool erode = (step == 0) == erode_first;
+    for (int direction = 0; direction < 2; ++direction) {
+      bool horizontal = direction == 0;
+      int size = horizontal ? hsize : vsize;
+      if (size == 1)
+        continue;
+      if (results[next] == NULL)
+        results[next] = pixCreateTemplate(pix);
+      if (results[next] == NULL) {
+        pixDestroy(&results[1 - next]);
+        return NULL;
+      }
+      RunBrickPass(src, results[next], size, horizontal, erode, thread_pool);
+      src = results[next];
+      next = 1 - next;
+    }
+  }
+  // The last pass wrote results[1 - next].
+  pixDestroy(&results[next]);
+  return results[1 - next];
+}
+
+Pix* DilateBrick(Pix* pix, int hsize, int vsize, ThreadPool* thread_pool) {
+  return Brick(BRICK_DILATE, pix, hsize, vsize, thread_pool);
+}
+
+Pix* ErodeBrick(Pix* pix, int hsize, int vsize, ThreadPool* thread_pool) {
+  return Brick(BRICK_ERODE, pix, hsize, vsize, thread_pool);
+}
+
+Pix* OpenBrick(Pix* pix, int hsize, int vsize, ThreadPool* thread_pool) {
+  return Brick(BRICK_OPEN, pix, hsize, vsize, thread_pool);
+}
+
+Pix* CloseBrick(Pix* pix, int hsize, int vsize, ThreadPool* thread_pool) {
+  return Brick(BRICK_CLOSE, pix, hsize, vsize, thread_pool);
+}
+
+}  // namespace tesseract
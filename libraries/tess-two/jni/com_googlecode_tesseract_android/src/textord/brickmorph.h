@@ -0,0 +1,46 @@
+///////////////////////////////////////////////////////////////////////
+// File:        brickmorph.h
+// Description: Binary morphology by rectangular bricks, a band of rows
+//              at a time and with SIMD row kernels.
+//
+// (C) Copyright 2017, Google Inc.
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////
+
+#ifndef TESSERACT_TEXTORD_BRICKMORPH_H_
+#define TESSERACT_TEXTORD_BRICKMORPH_H_
+
+struct Pix;
+
+namespace tesseract {
+
+class ThreadPool;
+
+// Each of these returns a new Pix that is exactly what the Leptonica
+// function of the same name returns for pixd == NULL, such as
+// pixDilateBrick(NULL, pix, hsize, vsize), without modifying pix.
+// Leptonica does a brick with one rasterop of the whole image per element
+// of the brick. These instead build each row of a horizontal brick from
+// log2(hsize) shifted copies of the row, and combine vsize rows for a
+// vertical brick, with SSE2, AVX2 or NEON where the CPU has them. If
+// thread_pool is not NULL, the rows are split into bands that are done in
+// parallel on it.
+// Anything they do not handle, such as a pix that is not 1 bpp or the
+// symmetric boundary condition, is passed on to Leptonica.
+Pix* DilateBrick(Pix* pix, int hsize, int vsize, ThreadPool* thread_pool);
+Pix* ErodeBrick(Pix* pix, int hsize, int vsize, ThreadPool* thread_pool);
+Pix* OpenBrick(Pix* pix, int hsize, int vsize, ThreadPool* thread_pool);
+Pix* CloseBrick(Pix* pix, int hsize, int vsize, ThreadPool* thread_pool);
+
+}  // namespace tesseract
+
+#endif  // TESSERACT_TEXTORD_BRICKMORPH_H_
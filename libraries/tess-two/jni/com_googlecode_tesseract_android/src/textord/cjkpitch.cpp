@@ -20,6 +20,8 @@
 #include "cjkpitch.h"
 #include "genericvector.h"
 #include "ndminx.h"
+#include "tesscallback.h"
+#include "threadpool.h"
 #include "topitch.h"
 #include "tovars.h"
 
@@ -910,15 +912,64 @@ void FPRow::FinalizeLargeChars() {
   }
 }
 
+// The FPRows of a page, and a stage of the analysis to run on each of them.
+// Each FPRow only touches its own characters and its own TO_ROW, so the rows
+// are independent within a stage.
+struct FPRowJob {
+  GenericVector<FPRow>* rows;
+  bool (*stage)(FPRow* row);
+  // The result of the stage for each row.
+  GenericVector<bool> results;
+};
+
+void RunFPRowStage(FPRowJob* job, int i) {
+  job->results[i] = job->stage(&(*job->rows)[i]);
+}
+
+bool Pass1AnalyzeRow(FPRow* row) {
+  row->Pass1Analyze();
+  return false;
+}
+
+bool EstimatePitchPass1Row(FPRow* row) {
+  row->EstimatePitch(true);
+  return false;
+}
+
+bool EstimatePitchRow(FPRow* row) {
+  row->EstimatePitch(false);
+  return false;
+}
+
+bool MergeFragmentsRow(FPRow* row) {
+  row->MergeFragments();
+  return false;
+}
+
+bool FinalizeLargeCharsRow(FPRow* row) {
+  row->FinalizeLargeChars();
+  return false;
+}
+
+bool Pass2AnalyzeRow(FPRow* row) {
+  return row->Pass2Analyze();
+}
+
+bool OutputEstimationsRow(FPRow* row) {
+  row->OutputEstimations();
+  return false;
+}
+
 class FPAnalyzer {
  public:
-  FPAnalyzer(): page_tr_(), rows_() { }
+  explicit FPAnalyzer(tesseract::ThreadPool* thread_pool)
+    : page_tr_(), rows_(), thread_pool_(thread_pool) { }
   ~FPAnalyzer() { }
 
   void Init(ICOORD page_tr, TO_BLOCK_LIST *port_blocks);
 
   void Pass1Analyze() {
-    for (int i = 0; i < rows_.size(); i++) rows_[i].Pass1Analyze();
+    RunRowStage(&Pass1AnalyzeRow);
   }
 
   // Estimate character pitch for each row.  The argument pass1 can be
@@ -933,25 +984,19 @@ class FPAnalyzer {
   }
 
   void MergeFragments() {
-    for (int i = 0; i < rows_.size(); i++) rows_[i].MergeFragments();
+    RunRowStage(&MergeFragmentsRow);
   }
 
   void FinalizeLargeChars() {
-    for (int i = 0; i < rows_.size(); i++) rows_[i].FinalizeLargeChars();
+    RunRowStage(&FinalizeLargeCharsRow);
   }
 
   bool Pass2Analyze() {
-    bool changed = false;
-    for (int i = 0; i < rows_.size(); i++) {
-      if (rows_[i].Pass2Analyze()) {
-        changed = true;
-      }
-    }
-    return changed;
+    return RunRowStage(&Pass2AnalyzeRow);
   }
 
   void OutputEstimations() {
-    for (int i = 0; i < rows_.size(); i++) rows_[i].OutputEstimations();
+    RunRowStage(&OutputEstimationsRow);
     // Don't we need page-level estimation of gaps/spaces?
   }
 
@@ -972,14 +1017,41 @@ class FPAnalyzer {
   }
 
  private:
+  // Runs stage on every row, on thread_pool_ if it is worth using, and
+  // returns true if it returned true for any row.
+  bool RunRowStage(bool (*stage)(FPRow* row));
+
   ICOORD page_tr_;
   GenericVector<FPRow> rows_;
   int num_tall_rows_;
   int num_bad_rows_;
   int num_empty_rows_;
   int max_chars_per_row_;
+  // Not owned. NULL to analyze the rows serially.
+  tesseract::ThreadPool* thread_pool_;
 };
 
+bool FPAnalyzer::RunRowStage(bool (*stage)(FPRow* row)) {
+  FPRowJob job;
+  job.rows = &rows_;
+  job.stage = stage;
+  job.results.init_to_size(rows_.size(), false);
+  if (thread_pool_ != NULL && thread_pool_->num_threads() > 1 &&
+      rows_.size() > 1) {
+    TessCallback1<int>* callback = NewPermanentTessCallback(&RunFPRowStage,
+                                                            &job);
+    thread_pool_->ParallelFor(rows_.size(), callback);
+    delete callback;
+  } else {
+    for (int i = 0; i < rows_.size(); ++i)
+      RunFPRowStage(&job, i);
+  }
+  for (int i = 0; i < job.results.size(); ++i) {
+    if (job.results[i]) return true;
+  }
+  return false;
+}
+
 void FPAnalyzer::Init(ICOORD page_tr, TO_BLOCK_LIST *port_blocks) {
   page_tr_ = page_tr;
 
@@ -1017,8 +1089,8 @@ void FPAnalyzer::EstimatePitch(bool pass1) {
   num_tall_rows_ = 0;
   num_bad_rows_ = 0;
   pitch_height_stats.Clear();
+  RunRowStage(pass1 ? &EstimatePitchPass1Row : &EstimatePitchRow);
   for (int i = 0; i < rows_.size(); i++) {
-    rows_[i].EstimatePitch(pass1);
     if (rows_[i].good_pitches()) {
       pitch_height_stats.Add(rows_[i].height() + rows_[i].gap(),
                              rows_[i].pitch(), rows_[i].good_pitches());
@@ -1055,8 +1127,9 @@ void FPAnalyzer::EstimatePitch(bool pass1) {
 }  // namespace
 
 void compute_fixed_pitch_cjk(ICOORD page_tr,
-                             TO_BLOCK_LIST *port_blocks) {
-  FPAnalyzer analyzer;
+                             TO_BLOCK_LIST *port_blocks,
+                             tesseract::ThreadPool* thread_pool) {
+  FPAnalyzer analyzer(thread_pool);
   analyzer.Init(page_tr, port_blocks);
   if (analyzer.num_rows() == 0) return;
 
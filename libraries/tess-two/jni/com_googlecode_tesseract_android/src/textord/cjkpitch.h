@@ -22,6 +22,10 @@
 
 #include          "blobbox.h"
 
+namespace tesseract {
+class ThreadPool;
+}
+
 // Function to test "fixed-pitchness" of the input text and estimating
 // character pitch parameters for it, based on CJK fixed-pitch layout
 // model.
@@ -65,7 +69,11 @@
 // This function doesn't provide all information required by
 // fixed_pitch_words() and the rows need to be processed with
 // make_prop_words() even if they are fixed pitched.
+//
+// The rows are analyzed independently between the page-level pitch
+// estimations, so each pass over them runs on thread_pool if given.
 void compute_fixed_pitch_cjk(ICOORD page_tr,               // top right
-                             TO_BLOCK_LIST *port_blocks);  // input list
+                             TO_BLOCK_LIST *port_blocks,   // input list
+                             tesseract::ThreadPool* thread_pool = NULL);
 
 #endif  // CJKPITCH_H_
@@ -90,7 +90,8 @@ ColumnFinder::ColumnFinder(int gridsize,
     best_columns_(NULL), stroke_width_(NULL),
     part_grid_(gridsize, bleft, tright), nontext_map_(NULL),
     projection_(resolution),
-    denorm_(NULL), input_blobs_win_(NULL), equation_detect_(NULL) {
+    denorm_(NULL), input_blobs_win_(NULL), equation_detect_(NULL),
+    table_cells_(NULL), cancel_(NULL) {
   TabVector_IT h_it(&horizontal_lines_);
   h_it.add_list_after(hlines);
 }
@@ -293,6 +294,10 @@ int ColumnFinder::FindBlocks(PageSegMode pageseg_mode, Pix* scaled_color,
                              Pix* grey_pix, BLOCK_LIST* blocks,
                              BLOBNBOX_LIST* diacritic_blobs,
                              TO_BLOCK_LIST* to_blocks) {
+  if (cancel_ != NULL && cancel_->Run()) {
+    part_grid_.DeleteParts();
+    return -1;
+  }
   pixOr(photo_mask_pix, photo_mask_pix, nontext_map_);
   stroke_width_->FindLeaderPartitions(input_block, &part_grid_);
   stroke_width_->RemoveLineResidue(&big_parts_);
@@ -368,6 +373,12 @@ int ColumnFinder::FindBlocks(PageSegMode pageseg_mode, Pix* scaled_color,
     }
     SetBlockRuleEdges(input_block);
     part_grid_.SetTabStops(this);
+    // Until here the blobs are all still owned by the input_block, so the
+    // page can be given up as if it were empty.
+    if (cancel_ != NULL && cancel_->Run()) {
+      part_grid_.DeleteParts();
+      return -1;
+    }
 
     // Make the column_sets_.
     if (!MakeColumns(false)) {
@@ -424,8 +435,28 @@ int ColumnFinder::FindBlocks(PageSegMode pageseg_mode, Pix* scaled_color,
       // Copy cleaned partitions from part_grid_ to clean_part_grid_ and
       // insert dot-like noise into period_grid_
       table_finder.InsertCleanPartitions(&part_grid_, input_block);
+      GenericVector<TableCells> table_cells;
+      if (table_cells_ != NULL) table_finder.set_table_cells(&table_cells);
       // Get Table Regions
       table_finder.LocateTables(&part_grid_, best_columns_, WidthCB(), reskew_);
+      // The cells of tables on rotated pages would not be upright.
+      if (rotation_.x() == 1.0f && rotation_.y() == 0.0f) {
+        for (int t = 0; t < table_cells.size(); ++t) {
+          GenericVector<TBOX>* cells = &table_cells[t].cells;
+          for (int c = 0; c < cells->size(); ++c) {
+            TBOX* cell = &(*cells)[c];
+            // Undo the reflection and deskew as RotateAndReskewBlocks does.
+            if (input_is_rtl) {
+              *cell = TBOX(-cell->right(), cell->bottom(),
+                           -cell->left(), cell->top());
+              cell->rotate_large(deskew_);
+            } else {
+              cell->rotate_large(reskew_);
+            }
+          }
+          table_cells_->push_back(table_cells[t]);
+        }
+      }
     }
     GridRemoveUnderlinePartitions();
     part_grid_.DeleteUnknownParts(input_block);
@@ -26,6 +26,7 @@
 #include "colpartitionset.h"
 #include "ocrblock.h"
 #include "textlineprojection.h"
+#include "tesscallback.h"
 
 class BLOCK_LIST;
 struct Boxa;
@@ -47,6 +48,7 @@ class LineSpacing;
 class StrokeWidth;
 class TempColumn_LIST;
 class EquationDetectBase;
+struct TableCells;
 
 // The ColumnFinder class finds columns in the grid.
 class ColumnFinder : public TabFind {
@@ -160,7 +162,8 @@ class ColumnFinder : public TabFind {
   // diacritic_blobs, with the intention that they be put into the most
   // appropriate word after the rest of layout analysis.
   // Returns -1 if the user hits the 'd' key in the blocks window while running
-  // in debug mode, which requests a retry with more debug info.
+  // in debug mode, which requests a retry with more debug info, or if the
+  // cancel callback stops it, in which case there are no blocks.
   int FindBlocks(PageSegMode pageseg_mode, Pix* scaled_color, int scaled_factor,
                  TO_BLOCK* block, Pix* photo_mask_pix, Pix* thresholds_pix,
                  Pix* grey_pix, BLOCK_LIST* blocks,
@@ -172,6 +175,18 @@ class ColumnFinder : public TabFind {
   // Set the equation detection pointer.
   void SetEquationDetect(EquationDetectBase* detect);
 
+  // Sets where FindBlocks appends the cells of the tables it recognizes, in
+  // page coordinates, or NULL (the default) not to keep them.
+  void set_table_cells(GenericVector<TableCells>* table_cells) {
+    table_cells_ = table_cells;
+  }
+  // Sets the callback that FindBlocks runs before it starts and before it
+  // makes the columns, to stop once it returns true. Not owned. NULL (the
+  // default) for none.
+  void set_cancel(TessResultCallback<bool>* cancel) {
+    cancel_ = cancel;
+  }
+
  private:
   // Displays the blob and block bounding boxes in a window called Blocks.
   void DisplayBlocks(BLOCK_LIST* blocks);
@@ -357,6 +372,10 @@ class ColumnFinder : public TabFind {
   // member function SetEquationDetect, and releasing it is NOT owned by this
   // class.
   EquationDetectBase* equation_detect_;
+  // Cells of the recognized tables. Not owned. See set_table_cells.
+  GenericVector<TableCells>* table_cells_;
+  // See set_cancel.
+  TessResultCallback<bool>* cancel_;
 
   // Allow a subsequent instance to reuse the blocks window.
   // Not thread-safe, but multiple threads shouldn't be using windows anyway.
@@ -645,6 +645,58 @@ bool ColPartitionGrid::GridSmoothNeighbours(BlobTextFlowType source_type,
   return any_changed;
 }
 
+// Repeats GridSmoothNeighbours until nothing changes, with the same
+// result, but after the first pass only re-evaluates the partitions
+// whose search neighbourhood contains a partition that has changed since
+// they were last evaluated.
+void ColPartitionGrid::SmoothNeighboursUntilStable(
+    BlobTextFlowType source_type, Pix* nontext_map, const TBOX& im_box,
+    const FCOORD& rerotation) {
+  // Smoothing never moves a partition, so the full search order is the same
+  // on every pass and can be captured once.
+  GenericVector<ColPartition*> parts;
+  ColPartitionGridSearch gsearch(this);
+  gsearch.StartFullSearch();
+  ColPartition* part;
+  while ((part = gsearch.NextFullSearch()) != NULL)
+    parts.push_back(part);
+  // Boxes of the partitions changed so far, in order of change, and for
+  // each partition, the number of changes that had been made when it was
+  // last evaluated, or -1 if it has never been evaluated.
+  GenericVector<TBOX> changes;
+  GenericVector<int> last_evaluated;
+  last_evaluated.init_to_size(parts.size(), -1);
+  bool any_changed;
+  do {
+    any_changed = false;
+    for (int i = 0; i < parts.size(); ++i) {
+      part = parts[i];
+      if (part->flow() != source_type ||
+          BLOBNBOX::IsLineType(part->blob_type()))
+        continue;
+      const TBOX& box = part->bounding_box();
+      if (last_evaluated[i] >= 0) {
+        // The result only depends on the partitions found by the rect
+        // searches of SmoothInOneDirection, which can return anything in a
+        // grid cell touched by the padded search box.
+        int pad = MAX(MIN(box.height(), box.width()), gridsize());
+        pad = pad * kMaxPadFactor + gridsize();
+        TBOX search_box(box);
+        search_box.pad(pad, pad);
+        int c = last_evaluated[i];
+        while (c < changes.size() && !changes[c].overlap(search_box)) ++c;
+        if (c == changes.size()) continue;  // Would give the same result.
+      }
+      last_evaluated[i] = changes.size();
+      bool debug = AlignedBlob::WithinTestRegion(2, box.left(), box.bottom());
+      if (SmoothRegionType(nontext_map, im_box, rerotation, debug, part)) {
+        changes.push_back(box);
+        any_changed = true;
+      }
+    }
+  } while (any_changed);
+}
+
 // Compute the mean RGB of the light and dark pixels in each ColPartition
 // and also the rms error in the linearity of color.
 void ColPartitionGrid::ComputePartitionColors(Pix* scaled_color,
@@ -105,6 +105,13 @@ class ColPartitionGrid : public BBGrid<ColPartition,
   // Returns true if anything was changed.
   bool GridSmoothNeighbours(BlobTextFlowType source_type, Pix* nontext_map,
                             const TBOX& im_box, const FCOORD& rerotation);
+  // Repeats GridSmoothNeighbours until nothing changes, with the same
+  // result, but after the first pass only re-evaluates the partitions
+  // whose search neighbourhood contains a partition that has changed since
+  // they were last evaluated.
+  void SmoothNeighboursUntilStable(BlobTextFlowType source_type,
+                                   Pix* nontext_map, const TBOX& im_box,
+                                   const FCOORD& rerotation);
 
   // Compute the mean RGB of the light and dark pixels in each ColPartition
   // and also the rms error in the linearity of color.
@@ -24,8 +24,11 @@
 
 #include "devanagari_processing.h"
 #include "allheaders.h"
+#include "edgblob.h"
 #include "tordmain.h"
 #include "statistc.h"
+#include "tesscallback.h"
+#include "threadpool.h"
 
 // Flags controlling the debugging information for shiro-rekha splitting
 // strategies.
@@ -81,7 +84,8 @@ void ShiroRekhaSplitter::set_orig_pix(Pix* pix) {
 // split_for_pageseg should be true if the splitting is being done prior to
 // page segmentation. This mode uses the flag
 // pageseg_devanagari_split_strategy to determine the splitting strategy.
-bool ShiroRekhaSplitter::Split(bool split_for_pageseg) {
+bool ShiroRekhaSplitter::Split(bool split_for_pageseg,
+                               ThreadPool* thread_pool) {
   SplitStrategy split_strategy = split_for_pageseg ? pageseg_split_strategy_ :
       ocr_split_strategy_;
   if (split_strategy == NO_SPLIT) {
@@ -126,40 +130,32 @@ bool ShiroRekhaSplitter::Split(bool split_for_pageseg) {
   boxaDestroy(&tmp_boxa);
   pixDestroy(&pix_for_ccs);
 
-  // Iterate over all connected components. Get their bounding boxes and clip
-  // out the image regions corresponding to these boxes from the original image.
-  // Conditionally run splitting on each of them.
-  Boxa* regions_to_clear = boxaCreate(0);
-  for (int i = 0; i < pixaGetCount(ccs); ++i) {
-    Box* box = ccs->boxa->box[i];
-    Pix* word_pix = pixClipRectangle(orig_pix_, box, NULL);
-    ASSERT_HOST(word_pix);
-    int xheight = GetXheightForCC(box);
-    if (xheight == kUnspecifiedXheight && segmentation_block_list_ &&
-        devanagari_split_debugimage) {
-      pixRenderBoxArb(debug_image_, box, 1, 255, 0, 0);
-    }
-    // If some xheight measure is available, attempt to pre-eliminate small
-    // blobs from the shiro-rekha process. This is primarily to save the CCs
-    // corresponding to punctuation marks/small dots etc which are part of
-    // larger graphemes.
-    if (xheight == kUnspecifiedXheight ||
-        (box->w > xheight / 3 && box->h > xheight / 2)) {
-      SplitWordShiroRekha(split_strategy, word_pix, xheight,
-                          box->x, box->y, regions_to_clear);
-    } else if (devanagari_split_debuglevel > 0) {
-      tprintf("CC dropped from splitting: %d,%d (%d, %d)\n",
-              box->x, box->y, box->w, box->h);
-    }
-    pixDestroy(&word_pix);
+  // Run splitting on each of the connected components. Each one only reads
+  // the original image and finds its own regions to clear.
+  int num_ccs = pixaGetCount(ccs);
+  GenericVector<Boxa*> cc_regions;
+  cc_regions.init_to_size(num_ccs, NULL);
+  // The debug image is drawn on as the CCs are split, so keep to one thread.
+  if (devanagari_split_debugimage)
+    thread_pool = NULL;
+  TessCallback1<int>* split_cc = NewPermanentTessCallback(
+      this, &ShiroRekhaSplitter::SplitCC, split_strategy, ccs, &cc_regions);
+  if (thread_pool != NULL && thread_pool->num_threads() > 1 && num_ccs > 1) {
+    thread_pool->ParallelFor(num_ccs, split_cc);
+  } else {
+    for (int i = 0; i < num_ccs; ++i)
+      split_cc->Run(i);
   }
+  delete split_cc;
   // Actually clear the boxes now.
-  for (int i = 0; i < boxaGetCount(regions_to_clear); ++i) {
-    Box* box = boxaGetBox(regions_to_clear, i, L_CLONE);
-    pixClearInRect(splitted_image_, box);
-    boxDestroy(&box);
+  for (int i = 0; i < num_ccs; ++i) {
+    for (int j = 0; j < boxaGetCount(cc_regions[i]); ++j) {
+      Box* box = boxaGetBox(cc_regions[i], j, L_CLONE);
+      pixClearInRect(splitted_image_, box);
+      boxDestroy(&box);
+    }
+    boxaDestroy(&cc_regions[i]);
   }
-  boxaDestroy(&regions_to_clear);
   pixaDestroy(&ccs);
   if (devanagari_split_debugimage) {
     DumpDebugImage(split_for_pageseg ? "pageseg_split_debug.png" :
@@ -168,6 +164,37 @@ bool ShiroRekhaSplitter::Split(bool split_for_pageseg) {
   return true;
 }
 
+// Runs splitting on connected component cc_index of ccs, if it is big
+// enough, and sets (*regions)[cc_index] to the regions to clear for it.
+// Get the bounding box of the CC and clip out the image region corresponding
+// to it from the original image.
+void ShiroRekhaSplitter::SplitCC(SplitStrategy split_strategy, Pixa* ccs,
+                                 GenericVector<Boxa*>* regions, int cc_index) {
+  Boxa* regions_to_clear = boxaCreate(0);
+  (*regions)[cc_index] = regions_to_clear;
+  Box* box = ccs->boxa->box[cc_index];
+  Pix* word_pix = pixClipRectangle(orig_pix_, box, NULL);
+  ASSERT_HOST(word_pix);
+  int xheight = GetXheightForCC(box);
+  if (xheight == kUnspecifiedXheight && segmentation_block_list_ &&
+      devanagari_split_debugimage) {
+    pixRenderBoxArb(debug_image_, box, 1, 255, 0, 0);
+  }
+  // If some xheight measure is available, attempt to pre-eliminate small
+  // blobs from the shiro-rekha process. This is primarily to save the CCs
+  // corresponding to punctuation marks/small dots etc which are part of
+  // larger graphemes.
+  if (xheight == kUnspecifiedXheight ||
+      (box->w > xheight / 3 && box->h > xheight / 2)) {
+    SplitWordShiroRekha(split_strategy, word_pix, xheight,
+                        box->x, box->y, regions_to_clear);
+  } else if (devanagari_split_debuglevel > 0) {
+    tprintf("CC dropped from splitting: %d,%d (%d, %d)\n",
+            box->x, box->y, box->w, box->h);
+  }
+  pixDestroy(&word_pix);
+}
+
 // Method to perform a close operation on the input image. The xheight
 // estimate decides the size of sel used.
 void ShiroRekhaSplitter::PerformClose(Pix* pix, int xheight_estimate) {
@@ -352,50 +379,168 @@ void ShiroRekhaSplitter::SplitWordShiroRekha(SplitStrategy split_strategy,
   }
 }
 
-// Refreshes the words in the segmentation block list by using blobs in the
-// input block list.
+// A word of the segmentation block list to refresh with new blobs.
+struct WordRefresh {
+  explicit WordRefresh(WERD* w) : word(w), new_word(NULL) {}
+
+  WERD* word;
+  // The word made of the new blobs, or NULL to keep word.
+  WERD* new_word;
+  // The old blobs of word that matched no new blob, if they are wanted.
+  C_BLOB_LIST not_found_blobs;
+  // The new blobs in the area of word that matched no old blob.
+  C_BLOB_LIST unused_blobs;
+};
+
+// The words to refresh, and the images to refresh them from.
+struct WordRefreshJob {
+  // The pixels that differ between the old and the new image, or NULL if
+  // they can't be compared, in which case every word is refreshed.
+  Pix* diff_pix;
+  Pix* new_pix;
+  bool keep_not_found_blobs;
+  PointerVector<WordRefresh> words;
+};
+
+// Refreshes word i of the job with blobs extracted from its own area of the
+// new image, if any pixel in or next to the word has changed. Only writes
+// to its own word.
+static void RefreshWord(WordRefreshJob* job, int i) {
+  WordRefresh* refresh = job->words[i];
+  int width = pixGetWidth(job->new_pix);
+  int height = pixGetHeight(job->new_pix);
+  // A changed pixel just outside the word can still join or split its blobs.
+  TBOX box = refresh->word->bounding_box();
+  box.pad(1, 1);
+  box &= TBOX(0, 0, width, height);
+  if (box.null_box())
+    return;
+  if (job->diff_pix != NULL) {
+    Box* pix_box = boxCreate(box.left(), height - box.top(),
+                             box.width(), box.height());
+    Pix* diff = pixClipRectangle(job->diff_pix, pix_box, NULL);
+    boxDestroy(&pix_box);
+    l_int32 unchanged = 1;
+    if (diff != NULL)
+      pixZero(diff, &unchanged);
+    pixDestroy(&diff);
+    if (unchanged)
+      return;  // The blobs of the word are the same in the new image.
+  }
+  BLOCK block("", TRUE, 0, 0, box.left(), box.bottom(), box.right(),
+              box.top());
+  extract_edges(job->new_pix, &block);
+  refresh->new_word = refresh->word->ConstructWerdWithNewBlobs(
+      block.blob_list(),
+      job->keep_not_found_blobs ? &refresh->not_found_blobs : NULL);
+  C_BLOB_IT unused_it(&refresh->unused_blobs);
+  unused_it.add_list_after(block.blob_list());
+}
+
+// Refreshes the words in the segmentation block list, whose blobs were found
+// in old_pix, with blobs from new_pix. Only the words that touch pixels that
+// differ between the two images are refreshed, each with blobs extracted
+// from its own area of new_pix, on thread_pool if given. This avoids both
+// finding the blobs of the whole page again and matching every new blob
+// against every word.
 // The segmentation block list must be set.
-void ShiroRekhaSplitter::RefreshSegmentationWithNewBlobs(
-    C_BLOB_LIST* new_blobs) {
+void ShiroRekhaSplitter::RefreshSegmentationWithNewImage(
+    Pix* old_pix, Pix* new_pix, ThreadPool* thread_pool) {
   // The segmentation block list must have been specified.
   ASSERT_HOST(segmentation_block_list_);
   if (devanagari_split_debuglevel > 0) {
     tprintf("Before refreshing blobs:\n");
     PrintSegmentationStats(segmentation_block_list_);
-    tprintf("New Blobs found: %d\n", new_blobs->length());
   }
 
-  C_BLOB_LIST not_found_blobs;
-  RefreshWordBlobsFromNewBlobs(segmentation_block_list_,
-                               new_blobs,
-                               ((devanagari_split_debugimage && debug_image_) ?
-                                &not_found_blobs : NULL));
+  WordRefreshJob job;
+  job.diff_pix = pixXor(NULL, old_pix, new_pix);
+  job.new_pix = new_pix;
+  job.keep_not_found_blobs = devanagari_split_debugimage && debug_image_;
+  // Only the words of text blocks are refreshed.
+  BLOCK_IT block_it(segmentation_block_list_);
+  for (block_it.mark_cycle_pt(); !block_it.cycled_list(); block_it.forward()) {
+    BLOCK* block = block_it.data();
+    if (block->poly_block() != NULL && !block->poly_block()->IsText())
+      continue;
+    ROW_IT row_it(block->row_list());
+    for (row_it.mark_cycle_pt(); !row_it.cycled_list(); row_it.forward()) {
+      WERD_IT werd_it(row_it.data()->word_list());
+      for (werd_it.mark_cycle_pt(); !werd_it.cycled_list(); werd_it.forward())
+        job.words.push_back(new WordRefresh(werd_it.data()));
+    }
+  }
+  if (thread_pool != NULL && thread_pool->num_threads() > 1 &&
+      job.words.size() > 1) {
+    TessCallback1<int>* refresh_word =
+        NewPermanentTessCallback(&RefreshWord, &job);
+    thread_pool->ParallelFor(job.words.size(), refresh_word);
+    delete refresh_word;
+  } else {
+    for (int i = 0; i < job.words.size(); ++i)
+      RefreshWord(&job, i);
+  }
+  pixDestroy(&job.diff_pix);
+
+  // Replace the refreshed words, visiting them in the same order as above.
+  int num_refreshed = 0;
+  int w = 0;
+  for (block_it.mark_cycle_pt(); !block_it.cycled_list(); block_it.forward()) {
+    BLOCK* block = block_it.data();
+    if (block->poly_block() != NULL && !block->poly_block()->IsText())
+      continue;
+    ROW_IT row_it(block->row_list());
+    for (row_it.mark_cycle_pt(); !row_it.cycled_list(); row_it.forward()) {
+      ROW* row = row_it.data();
+      WERD_IT werd_it(row->word_list());
+      WERD_LIST new_words;
+      WERD_IT new_words_it(&new_words);
+      for (werd_it.mark_cycle_pt(); !werd_it.cycled_list(); werd_it.forward()) {
+        WERD* werd = werd_it.extract();
+        WordRefresh* refresh = job.words[w++];
+        ASSERT_HOST(refresh->word == werd);
+        if (refresh->new_word != NULL) {
+          new_words_it.add_after_then_move(refresh->new_word);
+          delete werd;
+          ++num_refreshed;
+        } else {
+          new_words_it.add_after_then_move(werd);
+        }
+      }
+      row->word_list()->clear();
+      werd_it.move_to_first();
+      werd_it.add_list_after(&new_words);
+    }
+  }
 
   if (devanagari_split_debuglevel > 0) {
-    tprintf("After refreshing blobs:\n");
+    tprintf("After refreshing %d of %d words:\n",
+            num_refreshed, job.words.size());
     PrintSegmentationStats(segmentation_block_list_);
   }
   if (devanagari_split_debugimage && debug_image_) {
-    // Plot out the original blobs for which no match was found in the new
-    // all_blobs list.
-    C_BLOB_IT not_found_it(&not_found_blobs);
-    for (not_found_it.mark_cycle_pt(); !not_found_it.cycled_list();
-         not_found_it.forward()) {
-      C_BLOB* not_found = not_found_it.data();
-      TBOX not_found_box = not_found->bounding_box();
-      Box* box_to_plot = GetBoxForTBOX(not_found_box);
-      pixRenderBoxArb(debug_image_, box_to_plot, 1, 255, 0, 255);
-      boxDestroy(&box_to_plot);
-    }
+    for (int i = 0; i < job.words.size(); ++i) {
+      // Plot out the original blobs for which no match was found in the new
+      // blobs.
+      C_BLOB_IT not_found_it(&job.words[i]->not_found_blobs);
+      for (not_found_it.mark_cycle_pt(); !not_found_it.cycled_list();
+           not_found_it.forward()) {
+        C_BLOB* not_found = not_found_it.data();
+        TBOX not_found_box = not_found->bounding_box();
+        Box* box_to_plot = GetBoxForTBOX(not_found_box);
+        pixRenderBoxArb(debug_image_, box_to_plot, 1, 255, 0, 255);
+        boxDestroy(&box_to_plot);
+      }
 
-    // Plot out the blobs unused from all blobs.
-    C_BLOB_IT all_blobs_it(new_blobs);
-    for (all_blobs_it.mark_cycle_pt(); !all_blobs_it.cycled_list();
-         all_blobs_it.forward()) {
-      C_BLOB* a_blob = all_blobs_it.data();
-      Box* box_to_plot = GetBoxForTBOX(a_blob->bounding_box());
-      pixRenderBoxArb(debug_image_, box_to_plot, 3, 0, 127, 0);
-      boxDestroy(&box_to_plot);
+      // Plot out the new blobs that were left unused.
+      C_BLOB_IT unused_it(&job.words[i]->unused_blobs);
+      for (unused_it.mark_cycle_pt(); !unused_it.cycled_list();
+           unused_it.forward()) {
+        C_BLOB* a_blob = unused_it.data();
+        Box* box_to_plot = GetBoxForTBOX(a_blob->bounding_box());
+        pixRenderBoxArb(debug_image_, box_to_plot, 3, 0, 127, 0);
+        boxDestroy(&box_to_plot);
+      }
     }
   }
 }
@@ -13,12 +13,14 @@
 #ifndef TESSERACT_TEXTORD_DEVNAGARI_PROCESSING_H_
 #define TESSERACT_TEXTORD_DEVNAGARI_PROCESSING_H_
 
+#include "genericvector.h"
 #include "ocrblock.h"
 #include "params.h"
 
 struct Pix;
 struct Box;
 struct Boxa;
+struct Pixa;
 
 extern
 INT_VAR_H(devanagari_split_debuglevel, 0,
@@ -32,6 +34,8 @@ class TBOX;
 
 namespace tesseract {
 
+class ThreadPool;
+
 class PixelHistogram {
  public:
   PixelHistogram() {
@@ -84,15 +88,19 @@ class ShiroRekhaSplitter {
   // Returns true if a split was actually performed.
   // If split_for_pageseg is true, the pageseg_split_strategy_ is used for
   // splitting. If false, the ocr_split_strategy_ is used.
-  bool Split(bool split_for_pageseg);
+  // The connected components are split on thread_pool if given.
+  bool Split(bool split_for_pageseg, ThreadPool* thread_pool = NULL);
 
   // Clears the memory held by this object.
   void Clear();
 
-  // Refreshes the words in the segmentation block list by using blobs in the
-  // input blob list.
+  // Refreshes the words in the segmentation block list, whose blobs were found
+  // in old_pix, with blobs from new_pix. Only the words that touch pixels that
+  // differ between the two images are refreshed, each with blobs extracted
+  // from its own area of new_pix, on thread_pool if given.
   // The segmentation block list must be set.
-  void RefreshSegmentationWithNewBlobs(C_BLOB_LIST* new_blobs);
+  void RefreshSegmentationWithNewImage(Pix* old_pix, Pix* new_pix,
+                                       ThreadPool* thread_pool = NULL);
 
   // Returns true if the split strategies for pageseg and ocr are different.
   bool HasDifferentSplitStrategies() const {
@@ -170,6 +178,11 @@ class ShiroRekhaSplitter {
   // global_xheight_ estimate currently set in the object.
   int GetXheightForCC(Box* cc_bbox);
 
+  // Runs splitting on connected component cc_index of ccs, if it is big
+  // enough, and sets (*regions)[cc_index] to the regions to clear for it.
+  void SplitCC(SplitStrategy split_strategy, Pixa* ccs,
+               GenericVector<Boxa*>* regions, int cc_index);
+
   // Returns a list of regions (boxes) which should be cleared in the original
   // image so as to perform shiro-rekha splitting. Pix is assumed to carry one
   // (or less) word only. Xheight measure could be the global estimate, the row
@@ -329,14 +329,23 @@ void OL_BUCKETS::extract_children(                     // recursive count
  * @name extract_edges
  *
  * Run the edge detector over the block and return a list of blobs.
+ * The crack edges come from the given pool, or one local to the call.
+ * Stripes of the block are scanned in parallel on thread_pool if given.
  */
 
 void extract_edges(Pix* pix,  // thresholded image
-                   BLOCK *block) {  // block to scan
+                   BLOCK *block,  // block to scan
+                   CrackEdgePool* pool,
+                   tesseract::ThreadPool* thread_pool) {
   C_OUTLINE_LIST outlines;       // outlines in block
   C_OUTLINE_IT out_it = &outlines;
 
-  block_edges(pix, block, &out_it);
+  if (pool != NULL) {
+    block_edges(pix, block, &out_it, pool, thread_pool);
+  } else {
+    CrackEdgePool local_pool;
+    block_edges(pix, block, &out_it, &local_pool, thread_pool);
+  }
   ICOORD bleft;                  // block box
   ICOORD tright;
   block->bounding_box(bleft, tright);
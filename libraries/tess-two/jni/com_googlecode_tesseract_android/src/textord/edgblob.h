@@ -28,6 +28,11 @@
 
 #define BUCKETSIZE      16
 
+class CrackEdgePool;
+namespace tesseract {
+class ThreadPool;
+}  // namespace tesseract
+
 class OL_BUCKETS
 {
   public:
@@ -72,8 +77,13 @@ class OL_BUCKETS
     inT32 index;                 //for extraction scan
 };
 
+// Runs the edge detector over the block and adds its blobs to it. Pass a
+// pool to share the crack edges between the blocks of a page, and a
+// thread_pool to scan stripes of the block in parallel.
 void extract_edges(Pix* pix,        // thresholded image
-                   BLOCK* block);   // block to scan
+                   BLOCK* block,    // block to scan
+                   CrackEdgePool* pool = NULL,
+                   tesseract::ThreadPool* thread_pool = NULL);
 void outlines_to_blobs(               //find blobs
                        BLOCK *block,  //block to scan
                        ICOORD bleft,  //block box //outlines in block
@@ -27,6 +27,7 @@
 #endif
 
 #include "imagefind.h"
+#include "brickmorph.h"
 #include "colpartitiongrid.h"
 #include "linlsq.h"
 #include "ndminx.h"
@@ -58,6 +59,14 @@ const int kMinColorDifference = 16;
 // will fatten out too much and have to be clipped to text.
 const int kNoisePadding = 4;
 
+// Replaces *pix with its dilation by an hsize x vsize brick. Image finding
+// runs concurrently with other layout stages, so it has no thread pool.
+static void DilateBrickInPlace(Pix** pix, int hsize, int vsize) {
+  Pix* dilated = DilateBrick(*pix, hsize, vsize, NULL);
+  pixDestroy(pix);
+  *pix = dilated;
+}
+
 // Finds image regions within the BINARY source pix (page image) and returns
 // the image regions as a mask image.
 // The returned pix may be NULL, meaning no images found.
@@ -103,12 +112,12 @@ Pix* ImageFind::FindImages(Pix* pix) {
 
   // Eliminate lines and bars that may be joined to images.
   Pix* pixfinemask = pixReduceRankBinaryCascade(pixht, 1, 1, 3, 3);
-  pixDilateBrick(pixfinemask, pixfinemask, 5, 5);
+  DilateBrickInPlace(&pixfinemask, 5, 5);
   pixDisplayWrite(pixfinemask, textord_tabfind_show_images);
   Pix* pixreduced = pixReduceRankBinaryCascade(pixht, 1, 1, 1, 1);
   Pix* pixreduced2 = pixReduceRankBinaryCascade(pixreduced, 3, 3, 3, 0);
   pixDestroy(&pixreduced);
-  pixDilateBrick(pixreduced2, pixreduced2, 5, 5);
+  DilateBrickInPlace(&pixreduced2, 5, 5);
   Pix* pixcoarsemask = pixExpandReplicate(pixreduced2, 8);
   pixDestroy(&pixreduced2);
   pixDisplayWrite(pixcoarsemask, textord_tabfind_show_images);
@@ -116,7 +125,7 @@ Pix* ImageFind::FindImages(Pix* pix) {
   pixAnd(pixcoarsemask, pixcoarsemask, pixfinemask);
   pixDestroy(&pixfinemask);
   // Dilate a bit to make sure we get everything.
-  pixDilateBrick(pixcoarsemask, pixcoarsemask, 3, 3);
+  DilateBrickInPlace(&pixcoarsemask, 3, 3);
   Pix* pixmask = pixExpandReplicate(pixcoarsemask, 16);
   pixDestroy(&pixcoarsemask);
   if (textord_tabfind_show_images)
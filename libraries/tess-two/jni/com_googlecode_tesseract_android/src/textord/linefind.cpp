@@ -30,8 +30,12 @@
 #include "alignedblob.h"
 #include "tabvector.h"
 #include "blobbox.h"
+#include "brickmorph.h"
 #include "edgblob.h"
 #include "openclwrapper.h"
+#include "vulkanwrapper.h"
+#include "tesscallback.h"
+#include "threadpool.h"
 
 #include "allheaders.h"
 
@@ -61,6 +65,151 @@ const double kMaxStaveHeight = 1.0;
 // Minimum fraction of pixels in a music rectangle connected to the staves.
 const double kMinMusicPixelFraction = 0.75;
 
+// Returns the index within its word of the first (leftmost) set bit of a
+// non-zero Leptonica image word.
+static inline int FirstSetBit(l_uint32 word) {
+#ifdef __GNUC__
+  return __builtin_clz(word);
+#else
+  int bit = 0;
+  for (; (word & 0x80000000u) == 0; word <<= 1)
+    ++bit;
+  return bit;
+#endif
+}
+
+// Sets the bits [start, end) of an image line.
+static void SetBitRange(l_uint32* line, int start, int end) {
+  for (int x = start; x < end;) {
+    int bit = x & 31;
+    int count = MIN(32 - bit, end - x);
+    l_uint32 mask = count == 32 ? 0xffffffffu
+                                : ((1u << count) - 1) << (32 - bit - count);
+    line[x >> 5] |= mask;
+    x += count;
+  }
+}
+
+// Returns word i of line y of src_pix less minus_pix, with the padding
+// beyond width clear.
+static inline l_uint32 DifferenceWord(const l_uint32* src_line,
+                                      const l_uint32* minus_line,
+                                      int i, int last_word,
+                                      l_uint32 last_mask) {
+  l_uint32 word = src_line[i] & ~minus_line[i];
+  return i == last_word ? word & last_mask : word;
+}
+
+// Returns a new Pix of the pixels of src_pix, less those in minus_pix, that
+// are in a run of at least min_length pixels in the given direction.
+// This is exactly pixOpenBrick of the difference image with a min_length x 1
+// (or 1 x min_length) brick, as an opening by a line keeps just the runs
+// that the line fits in, and Leptonica treats pixels outside the image as
+// off, but it takes one pass over the words of the image instead of two
+// rasterops per pixel of the brick.
+static Pix* LongRuns(Pix* src_pix, Pix* minus_pix, int min_length,
+                     bool horizontal) {
+  int width = pixGetWidth(src_pix);
+  int height = pixGetHeight(src_pix);
+  int wpl = pixGetWpl(src_pix);
+  Pix* pix_runs = pixCreateTemplate(src_pix);
+  l_uint32* src_data = pixGetData(src_pix);
+  l_uint32* minus_data = pixGetData(minus_pix);
+  l_uint32* run_data = pixGetData(pix_runs);
+  int words = (width + 31) / 32;
+  int last_word = words - 1;
+  l_uint32 last_mask = (width & 31) == 0 ? 0xffffffffu
+                                         : ~(0xffffffffu >> (width & 31));
+  if (horizontal) {
+    for (int y = 0; y < height; ++y) {
+      const l_uint32* src_line = src_data + y * wpl;
+      const l_uint32* minus_line = minus_data + y * wpl;
+      l_uint32* run_line = run_data + y * wpl;
+      int run_start = -1;
+      l_uint32 prev_bit = 0;
+      for (int i = 0; i < words; ++i) {
+        l_uint32 word = DifferenceWord(src_line, minus_line, i, last_word,
+                                       last_mask);
+        // A bit of changes is set where the pixel differs from its left
+        // neighbour, so only the ends of runs are visited.
+        l_uint32 changes = word ^ ((word >> 1) | (prev_bit << 31));
+        prev_bit = word & 1;
+        while (changes != 0) {
+          int bit = FirstSetBit(changes);
+          changes &= ~(0x80000000u >> bit);
+          int x = i * 32 + bit;
+          if (word & (0x80000000u >> bit)) {
+            run_start = x;
+          } else {
+            if (x - run_start >= min_length)
+              SetBitRange(run_line, run_start, x);
+            run_start = -1;
+          }
+        }
+      }
+      if (run_start >= 0 && width - run_start >= min_length)
+        SetBitRange(run_line, run_start, width);
+    }
+  } else {
+    // Start row of the run in progress in each column, and the previous
+    // line, so only the pixels that differ from the one above are visited.
+    int* run_starts = new int[words * 32];
+    l_uint32* prev_line = new l_uint32[words];
+    memset(prev_line, 0, words * sizeof(prev_line[0]));
+    // Line height is taken to be clear, to end all the runs.
+    for (int y = 0; y <= height; ++y) {
+      const l_uint32* src_line = src_data + y * wpl;
+      const l_uint32* minus_line = minus_data + y * wpl;
+      for (int i = 0; i < words; ++i) {
+        l_uint32 word = y < height
+            ? DifferenceWord(src_line, minus_line, i, last_word, last_mask)
+            : 0;
+        l_uint32 changes = word ^ prev_line[i];
+        prev_line[i] = word;
+        while (changes != 0) {
+          int bit = FirstSetBit(changes);
+          l_uint32 mask = 0x80000000u >> bit;
+          changes &= ~mask;
+          int x = i * 32 + bit;
+          if (word & mask) {
+            run_starts[x] = y;
+          } else if (y - run_starts[x] >= min_length) {
+            l_uint32* run_word = run_data + run_starts[x] * wpl + i;
+            for (int run_y = run_starts[x]; run_y < y; ++run_y) {
+              *run_word |= mask;
+              run_word += wpl;
+            }
+          }
+        }
+      }
+    }
+    delete [] prev_line;
+    delete [] run_starts;
+  }
+  return pix_runs;
+}
+
+// The two long thin openings of GetLineMasks, of pix_closed less pix_solid,
+// which only read their inputs.
+struct LineOpenings {
+  Pix* pix_closed;
+  Pix* pix_solid;
+  int min_line_length;
+  Pix* pix_vline;
+  Pix* pix_hline;
+};
+
+// Runs the vertical (0) or horizontal (1) opening of a LineOpenings.
+static void OpenLines(LineOpenings* openings, int direction) {
+  if (direction == 0) {
+    openings->pix_vline = LongRuns(openings->pix_closed, openings->pix_solid,
+                                   openings->min_line_length, false);
+  } else {
+    openings->pix_hline = LongRuns(openings->pix_closed, openings->pix_solid,
+                                   openings->min_line_length, true);
+  }
+}
+
 // Erases the unused blobs from the line_pix image, taking into account
 // whether this was a horizontal or vertical line set.
 static void RemoveUnusedLineSegments(bool horizontal_lines,
@@ -104,7 +253,7 @@ static void SubtractLinesAndResidue(Pix* line_pix, Pix* non_line_pix,
   // Subtract the non-lines from the image to get the residue.
   Pix* residue_pix = pixSubtract(NULL, src_pix, non_line_pix);
   // Dilate the lines so they touch the residue.
-  Pix* fat_line_pix = pixDilateBrick(NULL, line_pix, 3, 3);
+  Pix* fat_line_pix = DilateBrick(line_pix, 3, 3, NULL);
   // Seed fill the fat lines to get all the residue.
   pixSeedfillBinary(fat_line_pix, fat_line_pix, residue_pix, 8);
   // Subtract the residue from the original image.
@@ -244,7 +393,8 @@ void LineFinder::FindAndRemoveLines(int resolution, bool debug, Pix* pix,
                                     int* vertical_x, int* vertical_y,
                                     Pix** pix_music_mask,
                                     TabVector_LIST* v_lines,
-                                    TabVector_LIST* h_lines) {
+                                    TabVector_LIST* h_lines,
+                                    ThreadPool* thread_pool) {
   PERF_COUNT_START("FindAndRemoveLines")
   if (pix == NULL || vertical_x == NULL || vertical_y == NULL) {
     tprintf("Error in parameters for LineFinder::FindAndRemoveLines\n");
@@ -258,7 +408,7 @@ void LineFinder::FindAndRemoveLines(int resolution, bool debug, Pix* pix,
   Pixa* pixa_display = debug ? pixaCreate(0) : NULL;
   GetLineMasks(resolution, pix, &pix_vline, &pix_non_vline, &pix_hline,
                &pix_non_hline, &pix_intersections, pix_music_mask,
-               pixa_display);
+               pixa_display, thread_pool);
   // Find lines, convert to TabVector_LIST and remove those that are used.
   FindAndRemoveVLines(resolution, pix_intersections, vertical_x, vertical_y,
                       &pix_vline, pix_non_vline, pix, v_lines);
@@ -285,7 +435,7 @@ void LineFinder::FindAndRemoveLines(int resolution, bool debug, Pix* pix,
     pixAnd(pix_intersections, pix_vline, pix_hline);
     // Fatten up the intersections and seed-fill to get the intersection
     // residue.
-    Pix* pix_join_residue = pixDilateBrick(NULL, pix_intersections, 5, 5);
+    Pix* pix_join_residue = DilateBrick(pix_intersections, 5, 5, NULL);
     pixSeedfillBinary(pix_join_residue, pix_join_residue, pix, 8);
     // Now remove the intersection residue.
     pixSubtract(pix, pix, pix_join_residue);
@@ -570,14 +720,15 @@ static Pix* FilterMusic(int resolution, Pix* pix_closed,
 // This function promises to initialize all the output (2nd level) pointers,
 // but any of the returns that are empty will be NULL on output.
 // None of the input (1st level) pointers may be NULL except pix_music_mask,
-// which will disable music detection, and pixa_display.
+// which will disable music detection, pixa_display, and thread_pool, which
+// runs the vertical and horizontal openings concurrently and the brick
+// morphology in bands if given.
 void LineFinder::GetLineMasks(int resolution, Pix* src_pix,
                               Pix** pix_vline, Pix** pix_non_vline,
                               Pix** pix_hline, Pix** pix_non_hline,
                               Pix** pix_intersections, Pix** pix_music_mask,
-                              Pixa* pixa_display) {
+                              Pixa* pixa_display, ThreadPool* thread_pool) {
   Pix* pix_closed = NULL;
-  Pix* pix_hollow = NULL;
 
   int max_line_width = resolution / kThinLineFraction;
   int min_line_length = resolution / kMinLineLengthFraction;
@@ -590,7 +741,9 @@ void LineFinder::GetLineMasks(int resolution, Pix* src_pix,
   PERF_COUNT_START("GetLineMasksMorph")
 // only use opencl if compiled w/ OpenCL and selected device is opencl
 #ifdef USE_OPENCL
-  if (OpenclDevice::selectedDeviceIsOpenCL()) {
+  OpenclRoute route(OCL_GET_LINE_MASKS,
+                    pixGetWidth(src_pix) * pixGetHeight(src_pix), true);
+  if (route.opencl()) {
     // OpenCL pixGetLines Operation
     int clStatus = OpenclDevice::initMorphCLAllocations(pixGetWpl(src_pix),
                                                         pixGetHeight(src_pix),
@@ -601,33 +754,52 @@ void LineFinder::GetLineMasks(int resolution, Pix* src_pix,
                                 closing_brick, max_line_width, max_line_width,
                                 min_line_length, min_line_length);
   } else {
+#endif
+#ifdef USE_VULKAN
+  if (!VulkanDevice::GetLinesVK(src_pix, pix_vline, pix_hline, &pix_closed,
+                                pix_music_mask != NULL, closing_brick,
+                                closing_brick, max_line_width, max_line_width,
+                                min_line_length, min_line_length)) {
 #endif
   // Close up small holes, making it less likely that false alarms are found
   // in thickened text (as it will become more solid) and also smoothing over
   // some line breaks and nicks in the edges of the lines.
-  pix_closed = pixCloseBrick(NULL, src_pix, closing_brick, closing_brick);
+  pix_closed = CloseBrick(src_pix, closing_brick, closing_brick, thread_pool);
   if (pixa_display != NULL)
     pixaAddPix(pixa_display, pix_closed, L_CLONE);
   // Open up with a big box to detect solid areas, which can then be subtracted.
   // This is very generous and will leave in even quite wide lines.
-  Pix* pix_solid = pixOpenBrick(NULL, pix_closed, max_line_width,
-                                max_line_width);
-  if (pixa_display != NULL)
+  Pix* pix_solid = OpenBrick(pix_closed, max_line_width, max_line_width,
+                             thread_pool);
+  if (pixa_display != NULL) {
     pixaAddPix(pixa_display, pix_solid, L_CLONE);
-  pix_hollow = pixSubtract(NULL, pix_closed, pix_solid);
-
-  pixDestroy(&pix_solid);
+    pixaAddPix(pixa_display, pixSubtract(NULL, pix_closed, pix_solid),
+               L_INSERT);
+  }
 
-  // Now open up in both directions independently to find lines of at least
-  // 1 inch/kMinLineLengthFraction in length.
-  if (pixa_display != NULL)
-    pixaAddPix(pixa_display, pix_hollow, L_CLONE);
-  *pix_vline = pixOpenBrick(NULL, pix_hollow, 1, min_line_length);
-  *pix_hline = pixOpenBrick(NULL, pix_hollow, min_line_length, 1);
+  // Now open up the closed image less the solid areas in both directions
+  // independently to find lines of at least 1 inch/kMinLineLengthFraction in
+  // length. The subtraction is done on the fly by the run finding.
+  LineOpenings openings = { pix_closed, pix_solid, min_line_length,
+                            NULL, NULL };
+  if (thread_pool != NULL && thread_pool->num_threads() > 1) {
+    TessCallback1<int>* open = NewPermanentTessCallback(&OpenLines, &openings);
+    thread_pool->ParallelFor(2, open);
+    delete open;
+  } else {
+    OpenLines(&openings, 0);
+    OpenLines(&openings, 1);
+  }
+  *pix_vline = openings.pix_vline;
+  *pix_hline = openings.pix_hline;
 
-  pixDestroy(&pix_hollow);
+  pixDestroy(&pix_solid);
+#ifdef USE_VULKAN
+  }
+#endif
 #ifdef USE_OPENCL
   }
+  route.Finish();
 #endif
   PERF_COUNT_END
 
@@ -660,7 +832,8 @@ void LineFinder::GetLineMasks(int resolution, Pix* src_pix,
       // and vice versa.
       extra_non_hlines = pixSubtract(NULL, *pix_vline, *pix_intersections);
     }
-    *pix_non_vline = pixErodeBrick(NULL, pix_nonlines, kMaxLineResidue, 1);
+    *pix_non_vline = ErodeBrick(pix_nonlines, kMaxLineResidue, 1,
+                                thread_pool);
     pixSeedfillBinary(*pix_non_vline, *pix_non_vline, pix_nonlines, 8);
     if (!h_empty) {
       // Candidate hlines are not vlines.
@@ -685,7 +858,8 @@ void LineFinder::GetLineMasks(int resolution, Pix* src_pix,
       return;
     }
   } else {
-    *pix_non_hline = pixErodeBrick(NULL, pix_nonlines, 1, kMaxLineResidue);
+    *pix_non_hline = ErodeBrick(pix_nonlines, 1, kMaxLineResidue,
+                                thread_pool);
     pixSeedfillBinary(*pix_non_hline, *pix_non_hline, pix_nonlines, 8);
     if (extra_non_hlines != NULL) {
       pixOr(*pix_non_hline, *pix_non_hline, extra_non_hlines);
@@ -31,6 +31,7 @@ class ICOORD;
 namespace tesseract {
 
 class TabVector_LIST;
+class ThreadPool;
 
 /**
  * The LineFinder class is a simple static function wrapper class that mainly
@@ -57,12 +58,17 @@ class LineFinder {
    * having no boxes, as there is no need to refit or merge separator lines.
    *
    * The detected lines are removed from the pix.
+   *
+   * If thread_pool is not NULL, the vertical and horizontal line masks are
+   * found concurrently on it, and the morphology is split into bands of
+   * rows on it.
    */
   static void FindAndRemoveLines(int resolution,  bool debug, Pix* pix,
                                  int* vertical_x, int* vertical_y,
                                  Pix** pix_music_mask,
                                  TabVector_LIST* v_lines,
-                                 TabVector_LIST* h_lines);
+                                 TabVector_LIST* h_lines,
+                                 ThreadPool* thread_pool);
 
   /**
    * Converts the Boxa array to a list of C_BLOB, getting rid of severely
@@ -133,7 +139,7 @@ class LineFinder {
                            Pix** pix_vline, Pix** pix_non_vline,
                            Pix** pix_hline, Pix** pix_non_hline,
                            Pix** pix_intersections, Pix** pix_music_mask,
-                           Pixa* pixa_display);
+                           Pixa* pixa_display, ThreadPool* thread_pool);
 
   // Returns a list of boxes corresponding to the candidate line segments. Sets
   // the line_crossings member of the boxes so we can later determin the number
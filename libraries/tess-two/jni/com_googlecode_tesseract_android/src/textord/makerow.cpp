@@ -380,6 +380,14 @@ void compute_page_skew(                        //get average gradient
   free_mem(errors);
 }
 
+// Empties stats and sets its range as the STATS constructor would, reusing
+// its buckets if the size of the range is unchanged.
+static void reset_stats(STATS* stats, int min_bucket_value,
+                        int max_bucket_value_plus_1) {
+  if (!stats->set_range(min_bucket_value, max_bucket_value_plus_1))
+    stats->set_range(0, 1);
+}
+
 const double kNoiseSize = 0.5;  // Fraction of xheight.
 const int kMinSize = 8;  // Min pixels to be xheight.
 
@@ -1406,14 +1414,18 @@ void Textord::compute_row_xheight(TO_ROW *row,          // row to do
 
   int min_height, max_height;
   get_min_max_xheight(block_line_size, &min_height, &max_height);
-  STATS heights(min_height, max_height + 1);
-  STATS floating_heights(min_height, max_height + 1);
+  // The histograms are members, so their buckets are only reallocated when
+  // the range changes, not for every row of the page.
+  STATS* heights = &row_heights_;
+  STATS* floating_heights = &row_floating_heights_;
+  reset_stats(heights, min_height, max_height + 1);
+  reset_stats(floating_heights, min_height, max_height + 1);
   fill_heights(row, gradient, min_height, max_height,
-               &heights, &floating_heights);
+               heights, floating_heights);
   row->ascrise = 0.0f;
   row->xheight = 0.0f;
   row->xheight_evidence =
-    compute_xheight_from_modes(&heights, &floating_heights,
+    compute_xheight_from_modes(heights, floating_heights,
                                textord_single_height_mode &&
                                rotation.y() == 0.0,
                                min_height, max_height,
@@ -1421,7 +1433,8 @@ void Textord::compute_row_xheight(TO_ROW *row,          // row to do
   row->descdrop = 0.0f;
   if (row->xheight > 0.0) {
     row->descdrop = static_cast<float>(
-        compute_row_descdrop(row, gradient, row->xheight_evidence, &heights));
+        compute_row_descdrop(row, gradient, row->xheight_evidence, heights,
+                             &row_descdrop_heights_));
   }
 }
 
@@ -1591,7 +1604,8 @@ int compute_xheight_from_modes(
  * height, returns 0 otherwise.
  */
 inT32 compute_row_descdrop(TO_ROW *row, float gradient,
-                           int xheight_blob_count, STATS *asc_heights) {
+                           int xheight_blob_count, STATS *asc_heights,
+                           STATS *desc_heights) {
   // Count how many potential ascenders are in this row.
   int i_min = asc_heights->min_bucket();
   if ((i_min / row->xheight) < textord_ascx_ratio_min) {
@@ -1614,7 +1628,9 @@ inT32 compute_row_descdrop(TO_ROW *row, float gradient,
   float height;                  // height of blob
   BLOBNBOX_IT blob_it = row->blob_list();
   BLOBNBOX *blob;                // current blob
-  STATS heights (min_height, max_height + 1);
+  STATS local_heights;
+  STATS &heights = desc_heights != NULL ? *desc_heights : local_heights;
+  reset_stats(&heights, min_height, max_height + 1);
   for (blob_it.mark_cycle_pt(); !blob_it.cycled_list(); blob_it.forward()) {
     blob = blob_it.data();
     if (!blob->joined_to_prev()) {
@@ -1953,6 +1969,24 @@ void pre_associate_blobs(                  //make rough chars
 }
 
 
+/**
+ * @name rows_in_y_order
+ *
+ * Return TRUE if the rows are already sorted by row_y_order, which after
+ * fitting they nearly always are, so the sort can be skipped.
+ */
+static BOOL8 rows_in_y_order(TO_ROW_IT *row_it) {
+  TO_ROW *prev_row = NULL;
+  for (row_it->mark_cycle_pt (); !row_it->cycled_list (); row_it->forward ()) {
+    TO_ROW *row = row_it->data ();
+    if (prev_row != NULL && row_y_order (&prev_row, &row) > 0)
+      return FALSE;
+    prev_row = row;
+  }
+  return TRUE;
+}
+
+
 /**
  * @name fit_parallel_rows
  *
@@ -1989,10 +2023,13 @@ void fit_parallel_rows(                   //find lines
     }
   }
 #endif
-  row_it.sort (row_y_order);     //may have gone out of order
+                                 //may have gone out of order
+  if (!rows_in_y_order (&row_it))
+    row_it.sort (row_y_order);
 }
 
 
+
 /**
  * @name fit_parallel_lms
  *
@@ -2501,6 +2538,59 @@ void assign_blobs_to_rows(                      //find lines
 }
 
 
+/**
+ * @name blobs_in_x_order
+ *
+ * Return TRUE if the blobs of the list are sorted by blob_x_order.
+ */
+static BOOL8 blobs_in_x_order(BLOBNBOX_LIST *blobs) {
+  BLOBNBOX_IT blob_it = blobs;
+  int prev_left = -MAX_INT32;
+  for (blob_it.mark_cycle_pt (); !blob_it.cycled_list (); blob_it.forward ()) {
+    int left = blob_it.data ()->bounding_box ().left ();
+    if (left < prev_left)
+      return FALSE;
+    prev_left = left;
+  }
+  return TRUE;
+}
+
+
+/**
+ * @name merge_blobs_in_x
+ *
+ * Move the blobs of src into dest, keeping dest in blob_x_order.
+ * Both lists are normally already in order, so the blobs are merged in
+ * one pass instead of resorting the whole of dest.
+ */
+static void merge_blobs_in_x(BLOBNBOX_LIST *src, BLOBNBOX_LIST *dest) {
+  BLOBNBOX_IT src_it = src;
+  BLOBNBOX_IT dest_it = dest;
+  if (!blobs_in_x_order (src) || !blobs_in_x_order (dest)) {
+    dest_it.add_list_after (src);
+    dest_it.sort (blob_x_order);
+    return;
+  }
+  BOOL8 at_end = dest_it.empty ();
+  while (!src_it.empty ()) {
+    BLOBNBOX *blob = src_it.extract ();
+    src_it.forward ();
+    int left = blob->bounding_box ().left ();
+                                 //find first blob to the right
+    while (!at_end && dest_it.data ()->bounding_box ().left () <= left) {
+      if (dest_it.at_last ())
+        at_end = TRUE;
+      else
+        dest_it.forward ();
+    }
+    if (at_end)
+      dest_it.add_to_end (blob);
+    else
+      dest_it.add_before_stay_put (blob);
+  }
+}
+
+
 /**
  * @name most_overlapping_row
  *
@@ -2521,7 +2611,6 @@ OVERLAP_STATE most_overlapping_row(                    //find best row
   ICOORD testpt;                 //testing only
   TO_ROW *row;                   //current row
   TO_ROW *test_row;              //for multiple overlaps
-  BLOBNBOX_IT blob_it;           //for merging rows
 
   result = ASSIGN;
   row = row_it->data ();
@@ -2554,9 +2643,7 @@ OVERLAP_STATE most_overlapping_row(                    //find best row
               test_row->min_y (), test_row->max_y ());
           }
           test_row->set_limits (merge_bottom, merge_top);
-          blob_it.set_to_list (test_row->blob_list ());
-          blob_it.add_list_after (row->blob_list ());
-          blob_it.sort (blob_x_order);
+          merge_blobs_in_x (row->blob_list (), test_row->blob_list ());
           row_it->backward ();
           delete row_it->extract ();
           row_it->forward ();
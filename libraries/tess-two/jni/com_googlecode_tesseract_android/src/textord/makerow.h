@@ -215,10 +215,13 @@ int compute_xheight_from_modes(
     STATS *heights, STATS *floating_heights, bool cap_only, int min_height,
     int max_height, float *xheight, float *ascrise);
 
+// desc_heights, if given, is scratch space for the descender histogram, to
+// save allocating one per row.
 inT32 compute_row_descdrop(TO_ROW *row,     // row to do
                            float gradient,  // global skew
                            int xheight_blob_count,
-                           STATS *heights);
+                           STATS *heights,
+                           STATS *desc_heights = NULL);
 inT32 compute_height_modes(STATS *heights,    // stats to search
                            inT32 min_height,  // bottom of range
                            inT32 max_height,  // top of range
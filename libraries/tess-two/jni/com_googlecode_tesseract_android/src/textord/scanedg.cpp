@@ -21,21 +21,103 @@
 
 #include "allheaders.h"
 #include "edgloop.h"
+#include "tesscallback.h"
+#include "threadpool.h"
 
 #define WHITE_PIX     1          /*thresholded colours */
 #define BLACK_PIX     0
                                  /*W->B->W */
 #define FLIP_COLOUR(pix)  (1-(pix))
 
+BOOL_VAR(edges_use_bit_scan, TRUE,
+         "Find crack edges by scanning whole words of the image");
+
+// Number of CRACKEDGEs allocated at once by a CrackEdgePool.
+const int kCrackEdgeBlockSize = 1024;
+// Fewest rows in a stripe of a block scanned on its own thread.
+const int kMinEdgeStripeHeight = 64;
+
+// A horizontal stripe of a block for block_edges_bits, from row top down to
+// row bottom inclusive, where bottom is white or below the block, and the
+// outlines found in it.
+struct EdgeStripe {
+  int top;
+  int bottom;
+  C_OUTLINE_LIST outlines;
+};
+
+// The stripes of a block to scan in parallel.
+struct EdgeStripeJob {
+  Pix *t_pix;
+  PDBLK *block;
+  GenericVector<EdgeStripe*> stripes;
+};
+
+// Returns the index of the most significant set bit of a non-zero word,
+// counting from the top, which is the leftmost pixel in Leptonica order.
+static inline int first_set_bit(uinT32 word) {
+#ifdef __GNUC__
+  return __builtin_clz(word);
+#else
+  int bit = 0;
+  for (; (word & 0x80000000u) == 0; word <<= 1)
+    ++bit;
+  return bit;
+#endif
+}
+
+// Sets the bits [start, end) of a packed line, clipped to [0, xext).
+static void set_bit_range(uinT32 *bits, int start, int end, int xext) {
+  if (start < 0) start = 0;
+  if (end > xext) end = xext;
+  for (int x = start; x < end;) {
+    int bit = x & 31;
+    int count = MIN(32 - bit, end - x);
+    uinT32 mask = count == 32 ? 0xffffffffu
+                              : ((1u << count) - 1) << (32 - bit - count);
+    bits[x >> 5] |= mask;
+    x += count;
+  }
+}
+
+static void block_edges_bits(Pix *t_pix, PDBLK *block,
+                             C_OUTLINE_IT* outline_it, CrackEdgePool *pool,
+                             tesseract::ThreadPool* thread_pool);
+static void stripe_edges_bits(Pix *t_pix, PDBLK *block, int top, int bottom,
+                              C_OUTLINE_IT* outline_it, CrackEdgePool *pool);
+static void line_edges_bits(inT16 x, inT16 y, inT16 xext, uinT8 uppercolour,
+                            const uinT32 *bwbits, const uinT32 *upperbits,
+                            CRACKEDGE **prevline, CrackEdgePool *pool,
+                            C_OUTLINE_IT* outline_it);
+
+CrackEdgePool::~CrackEdgePool() {
+  for (int i = 0; i < blocks_.size(); ++i)
+    delete [] blocks_[i];
+}
+
+// Links a new block of edges onto the freelist.
+void CrackEdgePool::AddBlock() {
+  CRACKEDGE *block = new CRACKEDGE[kCrackEdgeBlockSize];
+  blocks_.push_back(block);
+  for (int i = 0; i + 1 < kCrackEdgeBlockSize; ++i)
+    block[i].next = &block[i + 1];
+  block[kCrackEdgeBlockSize - 1].next = free_cracks_;
+  free_cracks_ = block;
+}
+
 /**********************************************************************
  * block_edges
  *
- * Extract edges from a PDBLK.
+ * Extract edges from a PDBLK, taking the CRACKEDGEs from the given pool.
+ * If a thread_pool is given, tall blocks are split into stripes that are
+ * scanned in parallel.
  **********************************************************************/
 
 void block_edges(Pix *t_pix,           // thresholded image
                  PDBLK *block,         // block in image
-                 C_OUTLINE_IT* outline_it) {
+                 C_OUTLINE_IT* outline_it,
+                 CrackEdgePool* pool,
+                 tesseract::ThreadPool* thread_pool) {
   ICOORD bleft;                  // bounding box
   ICOORD tright;
   BLOCK_LINE_IT line_it = block; // line iterator
@@ -43,11 +125,15 @@ void block_edges(Pix *t_pix,           // thresholded image
   int width = pixGetWidth(t_pix);
   int height = pixGetHeight(t_pix);
   int wpl = pixGetWpl(t_pix);
+
+  block->bounding_box(bleft, tright);  // block box
+  if (edges_use_bit_scan && bleft.x() >= 0 && tright.x() <= width) {
+    block_edges_bits(t_pix, block, outline_it, pool, thread_pool);
+    return;
+  }
                                  // lines in progress
   CRACKEDGE **ptrline = new CRACKEDGE*[width + 1];
-  CRACKEDGE *free_cracks = NULL;
 
-  block->bounding_box(bleft, tright);  // block box
   int block_width = tright.x() - bleft.x();
   for (int x = block_width; x >= 0; x--)
     ptrline[x] = NULL;           //  no lines in progress
@@ -68,15 +154,197 @@ void block_edges(Pix *t_pix,           // thresholded image
       memset(bwline, margin, block_width * sizeof(bwline[0]));
     }
     line_edges(bleft.x(), y, block_width,
-               margin, bwline, ptrline, &free_cracks, outline_it);
+               margin, bwline, ptrline, pool, outline_it);
   }
 
-  free_crackedges(free_cracks);  // really free them
   delete[] ptrline;
   delete[] bwline;
 }
 
 
+/**********************************************************************
+ * white_row
+ *
+ * Return true if row y of the image is white from left to right.
+ **********************************************************************/
+
+static bool white_row(Pix *t_pix, int y, int left, int right) {
+  const l_uint32* line = pixGetData(t_pix) +
+      pixGetWpl(t_pix) * (pixGetHeight(t_pix) - 1 - y);
+  for (int x = left; x < right;) {
+    int bit = x & 31;
+    int count = MIN(32 - bit, right - x);
+    uinT32 mask = count == 32 ? 0xffffffffu
+                              : ((1u << count) - 1) << (32 - bit - count);
+    if (line[x >> 5] & mask)
+      return false;
+    x += count;
+  }
+  return true;
+}
+
+
+/**********************************************************************
+ * scan_edge_stripe
+ *
+ * Scan one stripe of an EdgeStripeJob with a CrackEdgePool of its own.
+ **********************************************************************/
+
+static void scan_edge_stripe(EdgeStripeJob *job, int index) {
+  EdgeStripe *stripe = job->stripes[index];
+  C_OUTLINE_IT outline_it = &stripe->outlines;
+  CrackEdgePool pool;
+  stripe_edges_bits(job->t_pix, job->block, stripe->top, stripe->bottom,
+                    &outline_it, &pool);
+}
+
+
+/**********************************************************************
+ * block_edges_bits
+ *
+ * Extract edges from a PDBLK exactly as block_edges does, but find the
+ * pixels that make edges by scanning 32 pixels at a time.
+ * No edge is left in progress below a white row, so with a thread_pool the
+ * block is cut at white rows into stripes that are scanned independently
+ * and their outlines joined in order, which gives the same list.
+ **********************************************************************/
+
+static void block_edges_bits(Pix *t_pix,           // thresholded image
+                             PDBLK *block,         // block in image
+                             C_OUTLINE_IT* outline_it,
+                             CrackEdgePool* pool,
+                             tesseract::ThreadPool* thread_pool) {
+  ICOORD bleft;                  // bounding box
+  ICOORD tright;
+  block->bounding_box(bleft, tright);
+  int block_height = tright.y() - bleft.y();
+  int num_stripes = 1;
+  if (thread_pool != NULL && thread_pool->num_threads() > 1) {
+    num_stripes = MIN(thread_pool->num_threads() * 2,
+                      block_height / kMinEdgeStripeHeight);
+  }
+  if (num_stripes <= 1) {
+    stripe_edges_bits(t_pix, block, tright.y() - 1, bleft.y() - 1,
+                      outline_it, pool);
+    return;
+  }
+  EdgeStripeJob job;
+  job.t_pix = t_pix;
+  job.block = block;
+  int top = tright.y() - 1;
+  for (int s = 1; s < num_stripes; ++s) {
+    // Cut at the first white row at or below the even split point.
+    int y = MIN(top - 1, tright.y() - 1 - s * block_height / num_stripes);
+    while (y > bleft.y() && !white_row(t_pix, y, bleft.x(), tright.x()))
+      --y;
+    if (y <= bleft.y())
+      break;
+    EdgeStripe *stripe = new EdgeStripe;
+    stripe->top = top;
+    stripe->bottom = y;
+    job.stripes.push_back(stripe);
+    top = y - 1;
+  }
+  EdgeStripe *stripe = new EdgeStripe;
+  stripe->top = top;
+  stripe->bottom = bleft.y() - 1;
+  job.stripes.push_back(stripe);
+
+  TessCallback1<int>* scan = NewPermanentTessCallback(&scan_edge_stripe, &job);
+  thread_pool->ParallelFor(job.stripes.size(), scan);
+  delete scan;
+  for (int s = 0; s < job.stripes.size(); ++s) {
+    outline_it->move_to_last();
+    outline_it->add_list_after(&job.stripes[s]->outlines);
+  }
+  outline_it->move_to_last();
+  job.stripes.delete_data_pointers();
+}
+
+
+/**********************************************************************
+ * stripe_edges_bits
+ *
+ * Extract the edges of the rows of a PDBLK from top down to bottom
+ * inclusive, starting with a white row above top.
+ **********************************************************************/
+
+static void stripe_edges_bits(Pix *t_pix,           // thresholded image
+                              PDBLK *block,         // block in image
+                              int top,              // first row
+                              int bottom,           // last row
+                              C_OUTLINE_IT* outline_it,
+                              CrackEdgePool* pool) {
+  ICOORD bleft;                  // bounding box
+  ICOORD tright;
+  BLOCK_LINE_IT line_it = block; // line iterator
+
+  int height = pixGetHeight(t_pix);
+  int wpl = pixGetWpl(t_pix);
+
+  block->bounding_box(bleft, tright);  // block box
+  int block_width = tright.x() - bleft.x();
+  if (block_width <= 0) return;  // No pixels, so no edges.
+  int words = (block_width + 31) / 32 + 1;
+                                 // lines in progress
+  CRACKEDGE **ptrline = new CRACKEDGE*[block_width + 1];
+  for (int x = block_width; x >= 0; x--)
+    ptrline[x] = NULL;           //  no lines in progress
+
+  uinT8 margin = WHITE_PIX;
+  // Current and previous lines, packed like the Pix, from bleft.x(), with
+  // 1 for white, so the line above top is all margin.
+  uinT32 *bwbits = new uinT32[words];
+  uinT32 *upperbits = new uinT32[words];
+  memset(upperbits, 0xff, words * sizeof(upperbits[0]));
+  // Margin pixels of a line of a polygonal block.
+  uinT8 *marginline = block->poly_block() != NULL ? new uinT8[block_width]
+                                                  : NULL;
+  int first_word = bleft.x() >> 5;
+  int shift = bleft.x() & 31;
+
+  for (int y = top; y >= bottom; y--) {
+    if (y >= bleft.y() && y < tright.y()) {
+      // Get the binary pixels from the image.
+      l_uint32* line = pixGetData(t_pix) + wpl * (height - 1 - y);
+      for (int i = 0; i * 32 < block_width; ++i) {
+        uinT32 word = line[first_word + i] << shift;
+        if (shift != 0 && first_word + i + 1 < wpl)
+          word |= line[first_word + i + 1] >> (32 - shift);
+        bwbits[i] = ~word;
+      }
+      if (marginline != NULL) {
+        memset(marginline, 0,
+               static_cast<size_t>(block_width) * sizeof(marginline[0]));
+        make_margins(block, &line_it, marginline, 1,
+                     bleft.x(), tright.x(), y);
+        for (int x = 0; x < block_width; ++x) {
+          if (marginline[x])
+            bwbits[x >> 5] |= 0x80000000u >> (x & 31);
+        }
+      } else {
+        inT16 xext;
+        int start = line_it.get_line(y, xext) - bleft.x();
+        set_bit_range(bwbits, 0, start, block_width);
+        set_bit_range(bwbits, start + xext, block_width, block_width);
+      }
+    } else {
+      memset(bwbits, 0xff, words * sizeof(bwbits[0]));
+    }
+    line_edges_bits(bleft.x(), y, block_width, margin, bwbits, upperbits,
+                    ptrline, pool, outline_it);
+    uinT32 *tmp = upperbits;
+    upperbits = bwbits;
+    bwbits = tmp;
+  }
+
+  delete[] ptrline;
+  delete[] bwbits;
+  delete[] upperbits;
+  delete[] marginline;
+}
+
+
 /**********************************************************************
  * make_margins
  *
@@ -134,6 +402,91 @@ void make_margins(                         //get a line
   }
 }
 
+/**********************************************************************
+ * pixel_edges
+ *
+ * Update the edges in progress for one pixel of a line, given the colours
+ * of the pixel, the one before it and the one above that.
+ **********************************************************************/
+
+static inline void pixel_edges(int colour,             // of current pixel
+                               int *prevcolour,        // of previous pixel
+                               int *uppercolour,       // above previous pixel
+                               CRACKEDGE **current,    // current h edge
+                               CRACKEDGE **prevline,   // edge in progress
+                               CrackPos *pos,
+                               C_OUTLINE_IT* outline_it) {
+  CRACKEDGE *newcurrent;         // new h edge
+
+  if (*prevline != NULL) {
+                                 // changed above
+                                 // change colour
+    *uppercolour = FLIP_COLOUR(*uppercolour);
+    if (colour == *prevcolour) {
+      if (colour == *uppercolour) {
+                                 // finish a line
+        join_edges(*current, *prevline, pos->pool, outline_it);
+        *current = NULL;         // no edge now
+      } else {
+                                 // new horiz edge
+        *current = h_edge(*uppercolour - colour, *prevline, pos);
+      }
+      *prevline = NULL;          // no change this time
+    } else {
+      if (colour == *uppercolour)
+        *prevline = v_edge(colour - *prevcolour, *prevline, pos);
+                                 // 8 vs 4 connection
+      else if (colour == WHITE_PIX) {
+        join_edges(*current, *prevline, pos->pool, outline_it);
+        *current = h_edge(*uppercolour - colour, NULL, pos);
+        *prevline = v_edge(colour - *prevcolour, *current, pos);
+      } else {
+        newcurrent = h_edge(*uppercolour - colour, *prevline, pos);
+        *prevline = v_edge(colour - *prevcolour, *current, pos);
+        *current = newcurrent;   // right going h edge
+      }
+      *prevcolour = colour;      // remember new colour
+    }
+  } else {
+    if (colour != *prevcolour) {
+      *prevline = *current = v_edge(colour - *prevcolour, *current, pos);
+      *prevcolour = colour;
+    }
+    if (colour != *uppercolour)
+      *current = h_edge(*uppercolour - colour, *current, pos);
+    else
+      *current = NULL;           // no edge now
+  }
+}
+
+
+/**********************************************************************
+ * finish_line_edges
+ *
+ * Close or continue the edges at the end of a line.
+ **********************************************************************/
+
+static inline void finish_line_edges(int prevcolour,     // of last pixel
+                                     CRACKEDGE *current, // current h edge
+                                     CRACKEDGE **prevline,
+                                     CrackPos *pos,
+                                     C_OUTLINE_IT* outline_it) {
+  if (current != NULL) {
+                                 // out of block
+    if (*prevline != NULL) {     // got one to join to?
+      join_edges(current, *prevline, pos->pool, outline_it);
+      *prevline = NULL;          // tidy now
+    } else {
+                                 // fake vertical
+      *prevline = v_edge(FLIP_COLOUR(prevcolour)-prevcolour, current, pos);
+    }
+  } else if (*prevline != NULL) {
+                                 //continue fake
+    *prevline = v_edge(FLIP_COLOUR(prevcolour)-prevcolour, *prevline, pos);
+  }
+}
+
+
 /**********************************************************************
  * line_edges
  *
@@ -147,14 +500,13 @@ void line_edges(inT16 x,                         // coord of line start
                 uinT8 uppercolour,               // start of prev line
                 uinT8 * bwpos,                   // thresholded line
                 CRACKEDGE ** prevline,           // edges in progress
-                CRACKEDGE **free_cracks,
+                CrackEdgePool* pool,
                 C_OUTLINE_IT* outline_it) {
-  CrackPos pos = {free_cracks, x, y };
+  CrackPos pos = {pool, x, y };
   int xmax;                      // max x coord
-  int colour;                    // of current pixel
+  int upper = uppercolour;       // colour above previous pixel
   int prevcolour;                // of previous pixel
   CRACKEDGE *current;            // current h edge
-  CRACKEDGE *newcurrent;         // new h edge
 
   xmax = x + xext;               // max allowable coord
   prevcolour = uppercolour;      // forced plain margin
@@ -162,60 +514,71 @@ void line_edges(inT16 x,                         // coord of line start
 
                                  // do each pixel
   for (; pos.x < xmax; pos.x++, prevline++) {
-    colour = *bwpos++;           // current pixel
-    if (*prevline != NULL) {
-                                 // changed above
-                                 // change colour
-      uppercolour = FLIP_COLOUR(uppercolour);
-      if (colour == prevcolour) {
-        if (colour == uppercolour) {
-                                 // finish a line
-          join_edges(current, *prevline, free_cracks, outline_it);
-          current = NULL;        // no edge now
-        } else {
-                                 // new horiz edge
-          current = h_edge(uppercolour - colour, *prevline, &pos);
-        }
-        *prevline = NULL;        // no change this time
-      } else {
-        if (colour == uppercolour)
-          *prevline = v_edge(colour - prevcolour, *prevline, &pos);
-                                 // 8 vs 4 connection
-        else if (colour == WHITE_PIX) {
-          join_edges(current, *prevline, free_cracks, outline_it);
-          current = h_edge(uppercolour - colour, NULL, &pos);
-          *prevline = v_edge(colour - prevcolour, current, &pos);
-        } else {
-          newcurrent = h_edge(uppercolour - colour, *prevline, &pos);
-          *prevline = v_edge(colour - prevcolour, current, &pos);
-          current = newcurrent;  // right going h edge
-        }
-        prevcolour = colour;     // remember new colour
-      }
-    } else {
-      if (colour != prevcolour) {
-        *prevline = current = v_edge(colour - prevcolour, current, &pos);
-        prevcolour = colour;
-      }
-      if (colour != uppercolour)
-        current = h_edge(uppercolour - colour, current, &pos);
-      else
-        current = NULL;          // no edge now
-    }
+    pixel_edges(*bwpos++, &prevcolour, &upper, &current, prevline,
+                &pos, outline_it);
   }
-  if (current != NULL) {
-                                 // out of block
-    if (*prevline != NULL) {     // got one to join to?
-      join_edges(current, *prevline, free_cracks, outline_it);
-      *prevline = NULL;          // tidy now
-    } else {
-                                 // fake vertical
-      *prevline = v_edge(FLIP_COLOUR(prevcolour)-prevcolour, current, &pos);
+  finish_line_edges(prevcolour, current, prevline, &pos, outline_it);
+}
+
+
+/**********************************************************************
+ * line_edges_bits
+ *
+ * As line_edges, for a line packed 32 pixels to a word, given the line
+ * above. A pixel the same colour as the one before it, the one above it
+ * and the one above that changes nothing but to end the current h edge,
+ * as an edge in progress above it would mean the line above changed colour
+ * there, so only the pixels where one of those differs are visited.
+ **********************************************************************/
+
+static void line_edges_bits(inT16 x,                 // coord of line start
+                            inT16 y,                 // coord of line
+                            inT16 xext,              // width of line
+                            uinT8 uppercolour,       // start of prev line
+                            const uinT32 *bwbits,    // thresholded line
+                            const uinT32 *upperbits, // line above
+                            CRACKEDGE **prevline,    // edges in progress
+                            CrackEdgePool *pool,
+                            C_OUTLINE_IT* outline_it) {
+  CrackPos pos = {pool, x, y };
+  CRACKEDGE *current = NULL;     // current h edge
+  int prevcolour = uppercolour;  // of previous pixel
+  uinT32 carry = uppercolour;    // last pixel of previous word
+  uinT32 uppercarry = uppercolour;
+  int last_index = -1;           // last pixel visited
+
+  for (int i = 0; i * 32 < xext; ++i) {
+    uinT32 bw = bwbits[i];
+    uinT32 upper = upperbits[i];
+                                 // pixels to the left
+    uinT32 before = (bw >> 1) | (carry << 31);
+    uinT32 upperbefore = (upper >> 1) | (uppercarry << 31);
+    uinT32 changes = (bw ^ before) | (bw ^ upper) | (upper ^ upperbefore);
+    if (xext - i * 32 < 32)
+      changes &= ~(0xffffffffu >> (xext - i * 32));
+    carry = bw & 1;
+    uppercarry = upper & 1;
+    while (changes != 0) {
+      int bit = first_set_bit(changes);
+      changes &= ~(0x80000000u >> bit);
+      int index = i * 32 + bit;
+      if (index != last_index + 1)
+        current = NULL;          // ended by a plain pixel
+      last_index = index;
+      int colour = (bw >> (31 - bit)) & 1;
+      prevcolour = (before >> (31 - bit)) & 1;
+      int upper_colour = (upperbefore >> (31 - bit)) & 1;
+      pos.x = x + index;
+      pixel_edges(colour, &prevcolour, &upper_colour, &current,
+                  prevline + index, &pos, outline_it);
     }
-  } else if (*prevline != NULL) {
-                                 //continue fake
-    *prevline = v_edge(FLIP_COLOUR(prevcolour)-prevcolour, *prevline, &pos);
   }
+  if (last_index != xext - 1)
+    current = NULL;
+  if (xext > 0)
+    prevcolour = (bwbits[(xext - 1) >> 5] >> (31 - ((xext - 1) & 31))) & 1;
+  pos.x = x + xext;
+  finish_line_edges(prevcolour, current, prevline + xext, &pos, outline_it);
 }
 
 
@@ -230,12 +593,7 @@ CRACKEDGE *h_edge(int sign,                       // sign of edge
                   CrackPos* pos) {
   CRACKEDGE *newpt;              // return value
 
-  if (*pos->free_cracks != NULL) {
-    newpt = *pos->free_cracks;
-    *pos->free_cracks = newpt->next;  // get one fast
-  } else {
-    newpt = new CRACKEDGE;
-  }
+  newpt = pos->pool->Get();      // get one fast
   newpt->pos.set_y(pos->y + 1);       // coords of pt
   newpt->stepy = 0;              // edge is horizontal
 
@@ -281,12 +639,7 @@ CRACKEDGE *v_edge(int sign,                       // sign of edge
                   CrackPos* pos) {
   CRACKEDGE *newpt;              // return value
 
-  if (*pos->free_cracks != NULL) {
-    newpt = *pos->free_cracks;
-    *pos->free_cracks = newpt->next;  // get one fast
-  } else {
-    newpt = new CRACKEDGE;
-  }
+  newpt = pos->pool->Get();      // get one fast
   newpt->pos.set_x(pos->x);           // coords of pt
   newpt->stepx = 0;              // edge is vertical
 
@@ -330,7 +683,7 @@ CRACKEDGE *v_edge(int sign,                       // sign of edge
 
 void join_edges(CRACKEDGE *edge1,  // edges to join
                 CRACKEDGE *edge2,   // no specific order
-                CRACKEDGE **free_cracks,
+                CrackEdgePool* pool,
                 C_OUTLINE_IT* outline_it) {
   if (edge1->pos.x() + edge1->stepx != edge2->pos.x()
   || edge1->pos.y() + edge1->stepy != edge2->pos.y()) {
@@ -342,9 +695,7 @@ void join_edges(CRACKEDGE *edge1,  // edges to join
   if (edge1->next == edge2) {
                                  // already closed
     complete_edge(edge1, outline_it);
-                                 // attach freelist to end
-    edge1->prev->next = *free_cracks;
-    *free_cracks = edge1;         // and free list
+    pool->FreeLoop(edge1);       // and free list
   } else {
                                  // update opposite ends
     edge2->prev->next = edge1->next;
@@ -353,20 +704,3 @@ void join_edges(CRACKEDGE *edge1,  // edges to join
     edge2->prev = edge1;
   }
 }
-
-
-/**********************************************************************
- * free_crackedges
- *
- * Really free the CRACKEDGEs by giving them back to delete.
- **********************************************************************/
-
-void free_crackedges(CRACKEDGE *start) {
-  CRACKEDGE *current;            // current edge to free
-  CRACKEDGE *next;               // next one to free
-
-  for (current = start; current != NULL; current = next) {
-    next = current->next;
-    delete current;              // delete them all
-  }
-}
@@ -27,17 +27,54 @@
 
 class C_OUTLINE_IT;
 
+// Page-scoped arena of CRACKEDGEs. Edges are allocated in blocks and
+// recycled through a freelist, so a page of blocks can share one pool and
+// the edges are all freed at once when it is destroyed.
+class CrackEdgePool {
+ public:
+  CrackEdgePool() : free_cracks_(NULL) {}
+  ~CrackEdgePool();
+
+  // Returns an unlinked edge from the freelist, refilling it if empty.
+  CRACKEDGE* Get() {
+    if (free_cracks_ == NULL)
+      AddBlock();
+    CRACKEDGE* edge = free_cracks_;
+    free_cracks_ = edge->next;
+    return edge;
+  }
+  // Gives back a closed loop of edges.
+  void FreeLoop(CRACKEDGE* loop) {
+    loop->prev->next = free_cracks_;
+    free_cracks_ = loop;
+  }
+
+ private:
+  void AddBlock();
+
+  CRACKEDGE* free_cracks_;              // Freelist for fast allocation.
+  GenericVector<CRACKEDGE*> blocks_;    // Memory owned by the pool.
+};
+
 struct CrackPos {
-  CRACKEDGE** free_cracks;   // Freelist for fast allocation.
+  CrackEdgePool* pool;       // Source of new edges.
   int x;                     // Position of new edge.
   int y;
 };
 
 struct Pix;
+namespace tesseract {
+class ThreadPool;
+}  // namespace tesseract
+
+extern BOOL_VAR_H(edges_use_bit_scan, TRUE,
+                  "Find crack edges by scanning whole words of the image");
 
 void block_edges(Pix *t_image,         // thresholded image
                  PDBLK *block,         // block in image
-                 C_OUTLINE_IT* outline_it);
+                 C_OUTLINE_IT* outline_it,
+                 CrackEdgePool* pool,
+                 tesseract::ThreadPool* thread_pool);
 void make_margins(PDBLK *block,            // block in image
                   BLOCK_LINE_IT *line_it,  // for old style
                   uinT8 *pixels,           // pixels to strip
@@ -51,7 +88,7 @@ void line_edges(inT16 x,                     // coord of line start
                 uinT8 uppercolour,           // start of prev line
                 uinT8 * bwpos,               // thresholded line
                 CRACKEDGE ** prevline,       // edges in progress
-                CRACKEDGE **free_cracks,
+                CrackEdgePool* pool,
                 C_OUTLINE_IT* outline_it);
 CRACKEDGE *h_edge(int sign,                  // sign of edge
                   CRACKEDGE * join,          // edge to join to
@@ -61,8 +98,7 @@ CRACKEDGE *v_edge(int sign,                  // sign of edge
                   CrackPos* pos);
 void join_edges(CRACKEDGE *edge1,            // edges to join
                 CRACKEDGE *edge2,            // no specific order
-                CRACKEDGE **free_cracks,
+                CrackEdgePool* pool,
                 C_OUTLINE_IT* outline_it);
-void free_crackedges(CRACKEDGE *start);
 
 #endif
@@ -802,6 +802,8 @@ void StrokeWidth::AccumulateOverlaps(const BLOBNBOX* not_this, bool debug,
 // so display_if_debugging is true on the final call to display the results.
 void StrokeWidth::FindTextlineFlowDirection(PageSegMode pageseg_mode,
                                             bool display_if_debugging) {
+  // None of the passes below move blobs in the grid, so search it packed.
+  Freeze();
   BlobGridSearch gsearch(this);
   BLOBNBOX* bbox;
   // For every bbox in the grid, set its neighbours.
@@ -850,6 +852,7 @@ void StrokeWidth::FindTextlineFlowDirection(PageSegMode pageseg_mode,
       textord_tabfind_show_strokewidths > 1) {
     widths_win_ = DisplayGoodBlobs("ImprovedStrokewidths", 800, 0);
   }
+  Thaw();
 }
 
 // Sets the neighbours and good_stroke_neighbours members of the blob by
@@ -1269,10 +1272,10 @@ PartitionFindResult StrokeWidth::FindInitialPartitions(
   EasyMerges(part_grid);
   RemoveLargeUnusedBlobs(block, part_grid, big_parts);
   TBOX grid_box(bleft(), tright());
-  while (part_grid->GridSmoothNeighbours(BTFT_CHAIN, nontext_map_, grid_box,
-                                         rerotation));
-  while (part_grid->GridSmoothNeighbours(BTFT_NEIGHBOURS, nontext_map_,
-                                         grid_box, rerotation));
+  part_grid->SmoothNeighboursUntilStable(BTFT_CHAIN, nontext_map_,
+                                         grid_box, rerotation);
+  part_grid->SmoothNeighboursUntilStable(BTFT_NEIGHBOURS, nontext_map_,
+                                         grid_box, rerotation);
   int pre_overlap = part_grid->ComputeTotalOverlap(NULL);
   TestDiacritics(part_grid, block);
   MergeDiacritics(block, part_grid);
@@ -1289,13 +1292,13 @@ PartitionFindResult StrokeWidth::FindInitialPartitions(
   PartitionRemainingBlobs(pageseg_mode, part_grid);
   part_grid->SplitOverlappingPartitions(big_parts);
   EasyMerges(part_grid);
-  while (part_grid->GridSmoothNeighbours(BTFT_CHAIN, nontext_map_, grid_box,
-                                         rerotation));
-  while (part_grid->GridSmoothNeighbours(BTFT_NEIGHBOURS, nontext_map_,
-                                         grid_box, rerotation));
+  part_grid->SmoothNeighboursUntilStable(BTFT_CHAIN, nontext_map_,
+                                         grid_box, rerotation);
+  part_grid->SmoothNeighboursUntilStable(BTFT_NEIGHBOURS, nontext_map_,
+                                         grid_box, rerotation);
   // Now eliminate strong stuff in a sea of the opposite.
-  while (part_grid->GridSmoothNeighbours(BTFT_STRONG_CHAIN, nontext_map_,
-                                         grid_box, rerotation));
+  part_grid->SmoothNeighboursUntilStable(BTFT_STRONG_CHAIN, nontext_map_,
+                                         grid_box, rerotation);
   if (textord_tabfind_show_strokewidths) {
     smoothed_win_ = MakeWindow(800, 400, "Smoothed blobs");
     part_grid->DisplayBoxes(smoothed_win_);
@@ -67,6 +67,7 @@ TabFind::TabFind(int gridsize, const ICOORD& bleft, const ICOORD& tright,
                  int resolution)
   : AlignedBlob(gridsize, bleft, tright),
     resolution_(resolution),
+    vertical_estimate_(0.0f, 0.0f),
     image_origin_(0, tright.y() - 1) {
   width_cb_ = NULL;
   v_it_.set_to_list(&vectors_);
@@ -812,20 +813,29 @@ void TabFind::FindAllTabVectors(int min_gutter_width) {
   // An estimate of the vertical direction, revised as more lines are added.
   int vertical_x = 0;
   int vertical_y = 1;
-  // Find an estimate of the vertical direction by finding some tab vectors.
-  // Slowly up the search size until we get some vectors.
-  for (int search_size = kMinVerticalSearch; search_size < kMaxVerticalSearch;
-       search_size += kMinVerticalSearch) {
-    int vector_count = FindTabVectors(search_size, TA_LEFT_ALIGNED,
-                                      min_gutter_width,
-                                      &dummy_vectors,
-                                      &vertical_x, &vertical_y);
-    vector_count += FindTabVectors(search_size, TA_RIGHT_ALIGNED,
-                                   min_gutter_width,
-                                   &dummy_vectors,
-                                   &vertical_x, &vertical_y);
-    if (vector_count > 0)
-      break;
+  if (vertical_estimate_.y() > 0.0f) {
+    // The skew is already known from the image, so start from it, weighted
+    // as a single tab vector the height of the page.
+    int length = tright_.y() - bleft_.y();
+    vertical_x = IntCastRounded(vertical_estimate_.x() * length);
+    vertical_y = IntCastRounded(vertical_estimate_.y() * length);
+  } else {
+    // Find an estimate of the vertical direction by finding some tab vectors.
+    // Slowly up the search size until we get some vectors.
+    for (int search_size = kMinVerticalSearch;
+         search_size < kMaxVerticalSearch;
+         search_size += kMinVerticalSearch) {
+      int vector_count = FindTabVectors(search_size, TA_LEFT_ALIGNED,
+                                        min_gutter_width,
+                                        &dummy_vectors,
+                                        &vertical_x, &vertical_y);
+      vector_count += FindTabVectors(search_size, TA_RIGHT_ALIGNED,
+                                     min_gutter_width,
+                                     &dummy_vectors,
+                                     &vertical_x, &vertical_y);
+      if (vector_count > 0)
+        break;
+    }
   }
   // Get rid of the test vectors and reset the types of the tabs.
   dummy_vectors.clear();
@@ -1332,6 +1342,8 @@ bool TabFind::Deskew(TabVector_LIST* hlines, BLOBNBOX_LIST* image_blobs,
 void TabFind::ResetForVerticalText(const FCOORD& rotate, const FCOORD& rerotate,
                                    TabVector_LIST* horizontal_lines,
                                    int* min_gutter_width) {
+  // The vertical estimate was of the unrotated page, so it no longer applies.
+  vertical_estimate_ = FCOORD(0.0f, 0.0f);
   // Rotate the horizontal and vertical vectors and swap them over.
   // Only the separators are kept and rotated; other tabs are used
   // to estimate the gutter width then thrown away.
@@ -166,6 +166,15 @@ class TabFind : public AlignedBlob {
     return image_origin_;
   }
 
+  /**
+   * Sets the true vertical direction, as found from the page image before
+   * tab finding, so FindAllTabVectors starts from it instead of first
+   * searching for a few tab vectors to estimate it.
+   */
+  void SetVerticalEstimate(const FCOORD& vertical) {
+    vertical_estimate_ = vertical;
+  }
+
  protected:
   /**
   // Accessors
@@ -366,6 +375,9 @@ class TabFind : public AlignedBlob {
  protected:
   ICOORD vertical_skew_;          //< Estimate of true vertical in this image.
   int resolution_;                //< Of source image in pixels per inch.
+  // Unit vector of the true vertical found from the page image before tab
+  // finding, or (0, 0) if there is none. See SetVerticalEstimate.
+  FCOORD vertical_estimate_;
  private:
   ICOORD image_origin_;           //< Top-left of image in deskewed coords
   TabVector_LIST vectors_;        //< List of rule line and tabstops.
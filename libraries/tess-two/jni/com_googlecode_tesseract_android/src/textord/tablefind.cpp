@@ -166,7 +166,8 @@ TableFinder::TableFinder()
       global_median_xheight_(0),
       global_median_blob_width_(0),
       global_median_ledding_(0),
-      left_to_right_language_(true) {
+      left_to_right_language_(true),
+      table_cells_(NULL) {
 }
 
 TableFinder::~TableFinder() {
@@ -1838,6 +1839,8 @@ void TableFinder::RecognizeTables() {
   recognizer.set_text_grid(&fragmented_text_grid_);
   recognizer.set_max_text_height(global_median_xheight_ * 2.0);
   recognizer.set_min_height(1.5 * gridheight());
+  // Only the cells of the last pass describe the final tables.
+  if (table_cells_ != NULL) table_cells_->clear();
   // Loop over all of the tables and try to fit them.
   // Store the good tables here.
   ColSegment_CLIST good_tables;
@@ -1861,6 +1864,16 @@ void TableFinder::RecognizeTables() {
         table_structure->Display(table_win, ScrollView::LIME_GREEN);
       }
       found_table->set_bounding_box(table_structure->bounding_box());
+      if (table_cells_ != NULL) {
+        TableCells cells;
+        cells.rows = table_structure->row_count();
+        cells.columns = table_structure->column_count();
+        for (int row = 0; row < cells.rows; ++row) {
+          for (int column = 0; column < cells.columns; ++column)
+            cells.cells.push_back(table_structure->CellBox(row, column));
+        }
+        table_cells_->push_back(cells);
+      }
       delete table_structure;
       good_it.add_after_then_move(found_table);
     } else {
@@ -120,6 +120,17 @@ typedef GridSearch<ColSegment,
                    ColSegment_CLIST,
                    ColSegment_C_IT> ColSegmentGridSearch;
 
+// The grid of cells of a table found by the TableRecognizer.
+struct TableCells {
+  TableCells() : rows(0), columns(0) {}
+
+  int rows;
+  int columns;
+  // rows * columns boxes, row by row from the top of the table, and left to
+  // right within a row.
+  GenericVector<TBOX> cells;
+};
+
 // TableFinder is a utility class to find a set of tables given a set of
 // ColPartitions and Columns. The TableFinder will mark candidate ColPartitions
 // based on research in "Table Detection in Heterogeneous Documents".
@@ -140,6 +151,12 @@ class TableFinder {
   }
   // Change the reading order. Initially it is left to right.
   void set_left_to_right_language(bool order);
+  // Sets where the cells of the recognized tables go, in the coordinates of
+  // the grid, or NULL (the default) not to keep them. Only filled when
+  // textord_tablefind_recognize_tables is set.
+  void set_table_cells(GenericVector<TableCells>* table_cells) {
+    table_cells_ = table_cells;
+  }
 
   // Initialize
   void Init(int grid_size, const ICOORD& bottom_left, const ICOORD& top_right);
@@ -428,6 +445,8 @@ class TableFinder {
   ColSegmentGrid table_grid_;
   // The reading order of text. Defaults to true, for languages such as English.
   bool left_to_right_language_;
+  // Cells of the recognized tables. Not owned. See set_table_cells.
+  GenericVector<TableCells>* table_cells_;
 };
 
 }  // namespace tesseract.
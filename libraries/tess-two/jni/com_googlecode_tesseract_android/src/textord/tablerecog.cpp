@@ -124,6 +124,14 @@ int StructuredTable::column_width(int column) const {
   ASSERT_HOST(0 <= column && column < column_count());
   return cell_x_[column + 1] - cell_x_[column];
 }
+TBOX StructuredTable::CellBox(int row, int column) const {
+  ASSERT_HOST(0 <= row && row < row_count());
+  ASSERT_HOST(0 <= column && column < column_count());
+  // cell_y_ is sorted bottom up.
+  int bottom_row = row_count() - 1 - row;
+  return TBOX(cell_x_[column], cell_y_[bottom_row],
+              cell_x_[column + 1], cell_y_[bottom_row + 1]);
+}
 int StructuredTable::space_above() const {
   return space_above_;
 }
@@ -97,6 +97,9 @@ class StructuredTable {
   int median_cell_width();
   int row_height(int row) const;
   int column_width(int column) const;
+  // Returns the box of a cell, with rows counted from the top of the table
+  // and columns from its left.
+  TBOX CellBox(int row, int column) const;
   int space_above() const;
   int space_below() const;
 
@@ -76,6 +76,7 @@ void TextlineProjection::ConstructProjection(TO_BLOCK* input_block,
 //  Pix* final_pix = pixBlockconv(pix_, 2, 2);
   pixDestroy(&pix_);
   pix_ = final_pix;
+  BuildIntegralImages();
 }
 
 // Display the blobs in the window colored according to textline quality.
@@ -280,6 +281,17 @@ int TextlineProjection::VerticalDistance(bool debug, int x,
   y1 = ImageYToProjectionY(y1);
   y2 = ImageYToProjectionY(y2);
   if (y1 == y2) return 0;
+  if (!debug) {
+    // Moving up the column swaps the meaning of the forward rises and falls.
+    int column = x * pixGetHeight(pix_);
+    int low = column + MIN(y1, y2);
+    int high = column + MAX(y1, y2);
+    int rises = col_rises_[high] - col_rises_[low];
+    int falls = col_falls_[high] - col_falls_[low];
+    if (y1 < y2)
+      return StepDistance(high - low, rises, falls);
+    return StepDistance(high - low, falls, rises);
+  }
   int wpl = pixGetWpl(pix_);
   int step = y1 < y2 ? 1 : -1;
   uinT32* data = pixGetData(pix_) + y1 * wpl;
@@ -313,6 +325,17 @@ int TextlineProjection::HorizontalDistance(bool debug, int x1, int x2,
   x2 = ImageXToProjectionX(x2);
   y = ImageYToProjectionY(y);
   if (x1 == x2) return 0;
+  if (!debug) {
+    // Moving left along the row swaps the meaning of the rises and falls.
+    int row = y * pixGetWidth(pix_);
+    int low = row + MIN(x1, x2);
+    int high = row + MAX(x1, x2);
+    int rises = row_rises_[high] - row_rises_[low];
+    int falls = row_falls_[high] - row_falls_[low];
+    if (x1 < x2)
+      return StepDistance(high - low, rises, falls);
+    return StepDistance(high - low, falls, rises);
+  }
   int wpl = pixGetWpl(pix_);
   int step = x1 < x2 ? 1 : -1;
   uinT32* data = pixGetData(pix_) + y * wpl;
@@ -545,6 +568,13 @@ int TextlineProjection::MeanPixelsInLineSegment(const DENORM* denorm,
     x_delta = end_pt.x - start_pt.x;
     y_delta = end_pt.y - start_pt.y;
     count = x_delta * x_step + 1;
+    if (y_delta == 0) {
+      // Unskewed, so the sum over [start, end) comes from the row sums.
+      const int* row = &row_sums_[start_pt.y * (pixGetWidth(pix_) + 1)];
+      total = x_step > 0 ? row[end_pt.x] - row[start_pt.x]
+                         : row[start_pt.x + 1] - row[end_pt.x + 1];
+      return DivRounded(total, count);
+    }
     for (int x = start_pt.x; x != end_pt.x; x += x_step) {
       int y = start_pt.y + DivRounded(y_delta * (x - start_pt.x), x_delta);
       total += GET_DATA_BYTE(data + wpl * y, x);
@@ -562,6 +592,12 @@ int TextlineProjection::MeanPixelsInLineSegment(const DENORM* denorm,
     x_delta = end_pt.x - start_pt.x;
     y_delta = end_pt.y - start_pt.y;
     count = y_delta * y_step + 1;
+    if (x_delta == 0) {
+      const int* column = &col_sums_[start_pt.x * (pixGetHeight(pix_) + 1)];
+      total = y_step > 0 ? column[end_pt.y] - column[start_pt.y]
+                         : column[start_pt.y + 1] - column[end_pt.y + 1];
+      return DivRounded(total, count);
+    }
     for (int y = start_pt.y; y != end_pt.y; y += y_step) {
       int x = start_pt.x + DivRounded(x_delta * (y - start_pt.y), y_delta);
       total += GET_DATA_BYTE(data + wpl * y, x);
@@ -644,6 +680,49 @@ void TextlineProjection::IncrementRectangle8Bit(const TBOX& box) {
   }
 }
 
+// Builds the running sums and step counts from the finished pix_.
+void TextlineProjection::BuildIntegralImages() {
+  int width = pixGetWidth(pix_);
+  int height = pixGetHeight(pix_);
+  int wpl = pixGetWpl(pix_);
+  row_sums_.init_to_size((width + 1) * height, 0);
+  col_sums_.init_to_size(width * (height + 1), 0);
+  row_rises_.init_to_size(width * height, 0);
+  row_falls_.init_to_size(width * height, 0);
+  col_rises_.init_to_size(width * height, 0);
+  col_falls_.init_to_size(width * height, 0);
+  uinT32* data = pixGetData(pix_);
+  for (int y = 0; y < height; ++y, data += wpl) {
+    int* row_sum = &row_sums_[y * (width + 1)];
+    for (int x = 0; x < width; ++x) {
+      int pixel = GET_DATA_BYTE(data, x);
+      row_sum[x + 1] = row_sum[x] + pixel;
+      int col_index = x * (height + 1) + y;
+      col_sums_[col_index + 1] = col_sums_[col_index] + pixel;
+      if (x > 0) {
+        int prev = GET_DATA_BYTE(data, x - 1);
+        int index = y * width + x;
+        row_rises_[index] = row_rises_[index - 1] + (pixel > prev);
+        row_falls_[index] = row_falls_[index - 1] + (pixel < prev);
+      }
+      if (y > 0) {
+        int prev = GET_DATA_BYTE(data - wpl, x);
+        int index = x * height + y;
+        col_rises_[index] = col_rises_[index - 1] + (pixel > prev);
+        col_falls_[index] = col_falls_[index - 1] + (pixel < prev);
+      }
+    }
+  }
+}
+
+// Helper returns the curved-space distance of a walk of num_steps pixels,
+// of which rises were increases and falls were decreases in the projection.
+int TextlineProjection::StepDistance(int num_steps, int rises,
+                                     int falls) const {
+  int distance = num_steps - rises - falls + falls * kWrongWayPenalty;
+  return distance * scale_factor_ + rises * scale_factor_ / kWrongWayPenalty;
+}
+
 // Inserts a list of blobs into the projection.
 // Rotation is a multiple of 90 degrees to get from blob coords to
 // nontext_map coords, nontext_map_box is the bounds of the nontext_map.
@@ -164,6 +164,11 @@ class TextlineProjection {
   // Helper function to add 1 to a rectangle in source image coords to the
   // internal projection pix_.
   void IncrementRectangle8Bit(const TBOX& box);
+  // Builds the running sums and step counts below from the finished pix_.
+  void BuildIntegralImages();
+  // Helper returns the curved-space distance of a walk of num_steps pixels,
+  // of which rises were increases and falls were decreases in the projection.
+  int StepDistance(int num_steps, int rises, int falls) const;
   // Inserts a list of blobs into the projection.
   // Rotation is a multiple of 90 degrees to get from blob coords to
   // nontext_map coords, image_box is the bounds of the nontext_map.
@@ -199,6 +204,21 @@ class TextlineProjection {
   // textline density map. As with a horizontal projection, the map has
   // dips in the gaps between textlines.
   Pix* pix_;
+  // Integral images of pix_, so that the sums along the axis-aligned line
+  // segments used by EvaluateBox and the walks of VerticalDistance and
+  // HorizontalDistance cost O(1) instead of O(length).
+  // row_sums_[y * (width + 1) + x] is the sum of pixels [0, x) of row y, and
+  // col_sums_[x * (height + 1) + y] the sum of pixels [0, y) of column x.
+  GenericVector<int> row_sums_;
+  GenericVector<int> col_sums_;
+  // row_rises_[y * width + x] counts the steps i < x in row y for which
+  // pixel i + 1 is greater than pixel i, and row_falls_ those for which it is
+  // less. The col_ versions are the same down the columns, indexed by
+  // x * height + y. Coordinates are inT16, so the counts fit in 16 bits.
+  GenericVector<uinT16> row_rises_;
+  GenericVector<uinT16> row_falls_;
+  GenericVector<uinT16> col_rises_;
+  GenericVector<uinT16> col_falls_;
 };
 
 }  // namespace tesseract.
@@ -35,6 +35,7 @@ namespace tesseract {
 Textord::Textord(CCStruct* ccstruct)
     : ccstruct_(ccstruct),
       use_cjk_fp_model_(false),
+      cancel_(NULL),
       // makerow.cpp ///////////////////////////////////////////
       BOOL_MEMBER(textord_single_height_mode, false,
                   "Script has no xheight, so use a single mode",
@@ -229,12 +230,30 @@ Textord::Textord(CCStruct* ccstruct)
 Textord::~Textord() {
 }
 
+// Deletes the blobs of the rows of to_blocks, which own them until the
+// words are made.
+static void DeleteRowBlobs(TO_BLOCK_LIST* to_blocks) {
+  TO_BLOCK_IT block_it(to_blocks);
+  for (block_it.mark_cycle_pt(); !block_it.cycled_list();
+       block_it.forward()) {
+    TO_ROW_IT row_it(block_it.data()->get_rows());
+    for (row_it.mark_cycle_pt(); !row_it.cycled_list(); row_it.forward()) {
+      BLOBNBOX_IT blob_it(row_it.data()->blob_list());
+      for (blob_it.mark_cycle_pt(); !blob_it.cycled_list();
+           blob_it.forward()) {
+        delete blob_it.data()->cblob();
+      }
+    }
+  }
+}
+
 // Make the textlines and words inside each block.
-void Textord::TextordPage(PageSegMode pageseg_mode, const FCOORD& reskew,
+bool Textord::TextordPage(PageSegMode pageseg_mode, const FCOORD& reskew,
                           int width, int height, Pix* binary_pix,
                           Pix* thresholds_pix, Pix* grey_pix,
                           bool use_box_bottoms, BLOBNBOX_LIST* diacritic_blobs,
-                          BLOCK_LIST* blocks, TO_BLOCK_LIST* to_blocks) {
+                          BLOCK_LIST* blocks, TO_BLOCK_LIST* to_blocks,
+                          ThreadPool* thread_pool) {
   page_tr_.set_x(width);
   page_tr_.set_y(height);
   if (to_blocks->empty()) {
@@ -274,6 +293,11 @@ void Textord::TextordPage(PageSegMode pageseg_mode, const FCOORD& reskew,
     }
   }
 
+  // Sparse text already has its rows, from the ColumnFinder.
+  if (cancel_ != NULL && cancel_->Run()) {
+    DeleteRowBlobs(to_blocks);
+    return false;
+  }
   TO_BLOCK_IT to_block_it(to_blocks);
   TO_BLOCK* to_block = to_block_it.data();
   // Make the rows in the block.
@@ -286,16 +310,26 @@ void Textord::TextordPage(PageSegMode pageseg_mode, const FCOORD& reskew,
     gradient = make_single_row(page_tr_, pageseg_mode != PSM_RAW_LINE,
                                to_block, to_blocks);
   }
+  if (cancel_ != NULL && cancel_->Run()) {
+    DeleteRowBlobs(to_blocks);
+    return false;
+  }
   BaselineDetect baseline_detector(textord_baseline_debug,
                                    reskew, to_blocks);
-  baseline_detector.ComputeStraightBaselines(use_box_bottoms);
+  baseline_detector.ComputeStraightBaselines(use_box_bottoms, thread_pool);
   baseline_detector.ComputeBaselineSplinesAndXheights(
       page_tr_, pageseg_mode != PSM_RAW_LINE, textord_heavy_nr,
       textord_show_final_rows, this);
+  // Word making moves the blobs to the blocks, so this is the last chance
+  // to stop.
+  if (cancel_ != NULL && cancel_->Run()) {
+    DeleteRowBlobs(to_blocks);
+    return false;
+  }
   // Now make the words in the lines.
   if (PSM_WORD_FIND_ENABLED(pageseg_mode)) {
     // SINGLE_LINE uses the old word maker on the single line.
-    make_words(this, page_tr_, gradient, blocks, to_blocks);
+    make_words(this, page_tr_, gradient, blocks, to_blocks, thread_pool);
   } else {
     // SINGLE_WORD and SINGLE_CHAR cram all the blobs into a
     // single word, and in SINGLE_CHAR mode, all the outlines
@@ -316,6 +350,7 @@ void Textord::TextordPage(PageSegMode pageseg_mode, const FCOORD& reskew,
 #ifndef GRAPHICS_DISABLED
   close_to_win();
 #endif
+  return true;
 }
 
 // If we were supposed to return only a single textline, and there is more
@@ -26,6 +26,7 @@
 #include "blobbox.h"
 #include "gap_map.h"
 #include "publictypes.h"  // For PageSegMode.
+#include "tesscallback.h"
 
 class FCOORD;
 class BLOCK_LIST;
@@ -36,6 +37,8 @@ class ScrollView;
 
 namespace tesseract {
 
+class ThreadPool;
+
 // A simple class that can be used by BBGrid to hold a word and an expanded
 // bounding box that makes it easy to find words to put diacritics.
 class WordWithBox {
@@ -79,11 +82,16 @@ class Textord {
   // thresholds that were used to create the binary_pix from the grey_pix.
   // diacritic_blobs contain small confusing components that should be added
   // to the appropriate word(s) in case they are really diacritics.
-  void TextordPage(PageSegMode pageseg_mode, const FCOORD &reskew, int width,
+  // If thread_pool is given, the baselines of the rows and the words of the
+  // blocks are made on it.
+  // Returns false if the cancel callback stops it before the words are made,
+  // in which case the blobs of the rows made so far are deleted, and the
+  // caller must clear the blocks and to_blocks.
+  bool TextordPage(PageSegMode pageseg_mode, const FCOORD &reskew, int width,
                    int height, Pix *binary_pix, Pix *thresholds_pix,
                    Pix *grey_pix, bool use_box_bottoms,
                    BLOBNBOX_LIST *diacritic_blobs, BLOCK_LIST *blocks,
-                   TO_BLOCK_LIST *to_blocks);
+                   TO_BLOCK_LIST *to_blocks, ThreadPool* thread_pool = NULL);
 
   // If we were supposed to return only a single textline, and there is more
   // than one, clean up and leave only the best.
@@ -95,11 +103,20 @@ class Textord {
   void set_use_cjk_fp_model(bool flag) {
     use_cjk_fp_model_ = flag;
   }
+  // Sets the callback that TextordPage runs between making the rows, the
+  // baselines and the words, to stop once it returns true. Not owned. NULL
+  // (the default) for none.
+  void set_cancel(TessResultCallback<bool>* cancel) {
+    cancel_ = cancel;
+  }
 
   // tospace.cpp ///////////////////////////////////////////
+  // Computes the spacing of the rows of each block, spacing the blocks on
+  // thread_pool if given.
   void to_spacing(
       ICOORD page_tr,        //topright of page
-      TO_BLOCK_LIST *blocks  //blocks on page
+      TO_BLOCK_LIST *blocks, //blocks on page
+      ThreadPool* thread_pool = NULL
                                          );
   ROW *make_prop_words(TO_ROW *row,     // row to make
                        FCOORD rotation  // for drawing
@@ -108,7 +125,10 @@ class Textord {
                        FCOORD rotation  // for drawing
                        );
   // tordmain.cpp ///////////////////////////////////////////
-  void find_components(Pix* pix, BLOCK_LIST *blocks, TO_BLOCK_LIST *to_blocks);
+  // Finds the connected components of each block of the page, scanning
+  // them on thread_pool if given.
+  void find_components(Pix* pix, BLOCK_LIST *blocks, TO_BLOCK_LIST *to_blocks,
+                       ThreadPool* thread_pool = NULL);
   void filter_blobs(ICOORD page_tr, TO_BLOCK_LIST *blocks, BOOL8 testing_on);
 
  private:
@@ -119,6 +139,13 @@ class Textord {
   ICOORD page_tr_;
 
   bool use_cjk_fp_model_;
+  // See set_cancel.
+  TessResultCallback<bool>* cancel_;
+
+  // Scratch histograms of compute_row_xheight, kept between rows.
+  STATS row_heights_;
+  STATS row_floating_heights_;
+  STATS row_descdrop_heights_;
 
   // makerow.cpp ///////////////////////////////////////////
   // Make the textlines inside each block.
@@ -155,6 +182,9 @@ class Textord {
                       int degree,       // required approximation
                       QSPLINE *spline);  // starting spline
   // tospace.cpp ///////////////////////////////////////////
+  // Spaces the rows of (*blocks)[block_vector_index] for to_spacing.
+  void to_spacing_block(GenericVector<TO_BLOCK*>* blocks,
+                        int block_vector_index);
   //DEBUG USE ONLY
   void block_spacing_stats(TO_BLOCK *block,
                            GAPMAP *gapmap,
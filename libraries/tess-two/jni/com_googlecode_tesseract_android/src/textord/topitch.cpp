@@ -31,6 +31,8 @@
 #include          "wordseg.h"
 #include          "topitch.h"
 #include          "helpers.h"
+#include          "tesscallback.h"
+#include          "threadpool.h"
 
 // Include automatically generated configuration file if running autoconf.
 #ifdef HAVE_CONFIG_H
@@ -62,19 +64,57 @@ EXTERN double_VAR (textord_balance_factor, 1.0,
 #define BLOCK_STATS_CLUSTERS  10
 #define MAX_ALLOWED_PITCH 100    //max pixel pitch.
 
+// The blocks of compute_fixed_pitch, whose per-block stages only touch
+// the block of their own index.
+struct BlockPitchJob {
+  GenericVector<TO_BLOCK*> blocks;
+  FCOORD rotation;
+  BOOL8 testing_on;
+};
+
+// Computes the pitch of block i of the job, numbered from 1 for debug.
+static void block_pitch_job(BlockPitchJob* job, int i) {
+  compute_block_pitch(job->blocks[i], job->rotation, i + 1, job->testing_on);
+}
+
+// Tests block i of the job, or else its rows, for fixed pitch.
+static void block_fixed_job(BlockPitchJob* job, int i) {
+  if (!try_block_fixed (job->blocks[i], i + 1))
+    try_rows_fixed(job->blocks[i], i + 1, job->testing_on);
+}
+
+// Runs func on each block of job, on thread_pool if it is worth using.
+static void run_block_pitch_job(BlockPitchJob* job,
+                                void (*func)(BlockPitchJob*, int),
+                                tesseract::ThreadPool* thread_pool) {
+  if (thread_pool != NULL && thread_pool->num_threads() > 1 &&
+      job->blocks.size() > 1) {
+    TessCallback1<int>* callback = NewPermanentTessCallback(func, job);
+    thread_pool->ParallelFor(job->blocks.size(), callback);
+    delete callback;
+  } else {
+    for (int i = 0; i < job->blocks.size(); ++i)
+      func(job, i);
+  }
+}
+
 /**********************************************************************
  * compute_fixed_pitch
  *
  * Decide whether each row is fixed pitch individually.
  * Correlate definite and uncertain results to obtain an individual
  * result for each row in the TO_ROW class.
+ * The blocks are independent until the page-level decisions, so their
+ * pitch is computed and tested on thread_pool if given. The final voting
+ * between rows of the page stays serial.
  **********************************************************************/
 
 void compute_fixed_pitch(ICOORD page_tr,              // top right
                          TO_BLOCK_LIST *port_blocks,  // input list
                          float gradient,              // page skew
                          FCOORD rotation,             // for drawing
-                         BOOL8 testing_on) {          // correct orientation
+                         BOOL8 testing_on,            // correct orientation
+                         tesseract::ThreadPool* thread_pool) {
   TO_BLOCK_IT block_it;          //iterator
   TO_BLOCK *block;               //current block;
   TO_ROW_IT row_it;              //row iterator
@@ -87,27 +127,21 @@ void compute_fixed_pitch(ICOORD page_tr,              // top right
     if (to_win == NULL)
       create_to_win(page_tr);
   }
+  if (to_win != NULL)
+    thread_pool = NULL;          //drawing must stay on one thread
 #endif
 
+  BlockPitchJob job;
+  job.rotation = rotation;
+  job.testing_on = testing_on;
   block_it.set_to_list (port_blocks);
-  block_index = 1;
   for (block_it.mark_cycle_pt (); !block_it.cycled_list ();
-  block_it.forward ()) {
-    block = block_it.data ();
-    compute_block_pitch(block, rotation, block_index, testing_on);
-    block_index++;
-  }
+  block_it.forward ())
+    job.blocks.push_back(block_it.data ());
+  run_block_pitch_job(&job, &block_pitch_job, thread_pool);
 
-  if (!try_doc_fixed (page_tr, port_blocks, gradient)) {
-    block_index = 1;
-    for (block_it.mark_cycle_pt (); !block_it.cycled_list ();
-    block_it.forward ()) {
-      block = block_it.data ();
-      if (!try_block_fixed (block, block_index))
-        try_rows_fixed(block, block_index, testing_on);
-      block_index++;
-    }
-  }
+  if (!try_doc_fixed (page_tr, port_blocks, gradient))
+    run_block_pitch_job(&job, &block_fixed_job, thread_pool);
 
   block_index = 1;
   for (block_it.mark_cycle_pt(); !block_it.cycled_list();
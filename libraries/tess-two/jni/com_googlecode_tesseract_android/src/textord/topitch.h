@@ -24,6 +24,7 @@
 
 namespace tesseract {
 class Tesseract;
+class ThreadPool;
 }
 extern BOOL_VAR_H (textord_debug_pitch_test, FALSE,
 "Debug on fixed pitch test");
@@ -42,11 +43,13 @@ extern double_VAR_H (textord_projection_scale, 0.125,
 extern double_VAR_H (textord_balance_factor, 2.0,
 "Ding rate for unbalanced char cells");
 
+// The per-block stages run on thread_pool if given.
 void compute_fixed_pitch(ICOORD page_tr,              // top right
                          TO_BLOCK_LIST *port_blocks,  // input list
                          float gradient,              // page skew
                          FCOORD rotation,             // for drawing
-                         BOOL8 testing_on);           // correct orientation
+                         BOOL8 testing_on,            // correct orientation
+                         tesseract::ThreadPool* thread_pool = NULL);
 void fix_row_pitch(                        //get some value
                    TO_ROW *bad_row,        //row to fix
                    TO_BLOCK *bad_block,    //block of bad_row
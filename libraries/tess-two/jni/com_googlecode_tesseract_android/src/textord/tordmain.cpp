@@ -32,6 +32,7 @@
 #include "edgblob.h"
 #include "drawtord.h"
 #include "makerow.h"
+#include "scanedg.h"
 #include "wordseg.h"
 #include "textord.h"
 #include "tordmain.h"
@@ -200,10 +201,12 @@ void assign_blobs_to_blocks2(Pix* pix,
  * Find the C_OUTLINEs of the connected components in each block, put them
  * in C_BLOBs, and filter them by size, putting the different size
  * grades on different lists in the matching TO_BLOCK in to_blocks.
+ * The blocks are scanned in stripes on thread_pool if not NULL.
  **********************************************************************/
 
 void Textord::find_components(Pix* pix, BLOCK_LIST *blocks,
-                              TO_BLOCK_LIST *to_blocks) {
+                              TO_BLOCK_LIST *to_blocks,
+                              ThreadPool* thread_pool) {
   int width = pixGetWidth(pix);
   int height = pixGetHeight(pix);
   if (width > MAX_INT16 || height > MAX_INT16) {
@@ -214,11 +217,12 @@ void Textord::find_components(Pix* pix, BLOCK_LIST *blocks,
   set_global_loc_code(LOC_EDGE_PROG);
 
   BLOCK_IT block_it(blocks);    // iterator
+  CrackEdgePool crack_pool;     // edges shared by the page
   for (block_it.mark_cycle_pt(); !block_it.cycled_list();
        block_it.forward()) {
     BLOCK* block = block_it.data();
     if (block->poly_block() == NULL || block->poly_block()->IsText()) {
-      extract_edges(pix, block);
+      extract_edges(pix, block, &crack_pool, thread_pool);
     }
   }
 
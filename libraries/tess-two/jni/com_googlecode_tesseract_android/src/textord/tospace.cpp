@@ -28,7 +28,9 @@
 #include "drawtord.h"
 #include "ndminx.h"
 #include "statistc.h"
+#include "tesscallback.h"
 #include "textord.h"
+#include "threadpool.h"
 #include "tovars.h"
 
 // Include automatically generated configuration file if running autoconf.
@@ -41,74 +43,101 @@
 namespace tesseract {
 void Textord::to_spacing(
     ICOORD page_tr,        //topright of page
-    TO_BLOCK_LIST *blocks  //blocks on page
+    TO_BLOCK_LIST *blocks, //blocks on page
+    ThreadPool* thread_pool
                          ) {
   TO_BLOCK_IT block_it;          //iterator
-  TO_BLOCK *block;               //current block;
+  GenericVector<TO_BLOCK*> block_vector;
+
+  block_it.set_to_list (blocks);
+  for (block_it.mark_cycle_pt (); !block_it.cycled_list ();
+  block_it.forward ())
+    block_vector.push_back(block_it.data ());
+  // The blocks are spaced independently, so they may run in parallel,
+  // except when drawing.
+#ifndef GRAPHICS_DISABLED
+  if (to_win != NULL)
+    thread_pool = NULL;
+#endif
+  if (thread_pool != NULL && thread_pool->num_threads() > 1 &&
+      block_vector.size() > 1) {
+    TessCallback1<int>* space_block =
+        NewPermanentTessCallback(this, &Textord::to_spacing_block,
+                                 &block_vector);
+    thread_pool->ParallelFor(block_vector.size(), space_block);
+    delete space_block;
+  } else {
+    for (int i = 0; i < block_vector.size(); ++i)
+      to_spacing_block(&block_vector, i);
+  }
+}
+
+
+/*************************************************************************
+ * to_spacing_block()
+ * Computes the spacing of the rows of the given block, numbered from 1
+ * in debug output.
+ *************************************************************************/
+
+void Textord::to_spacing_block(GenericVector<TO_BLOCK*>* blocks,
+                               int block_vector_index) {
+  TO_BLOCK *block = (*blocks)[block_vector_index];
   TO_ROW_IT row_it;              //row iterator
   TO_ROW *row;                   //current row
-  int block_index;               //block number
+  int block_index = block_vector_index + 1;  //block number
   int row_index;                 //row number
   //estimated width of real spaces for whole block
   inT16 block_space_gap_width;
   //estimated width of non space gaps for whole block
   inT16 block_non_space_gap_width;
   BOOL8 old_text_ord_proportional;//old fixed/prop result
-  GAPMAP *gapmap = NULL;          //map of big vert gaps in blk
+  GAPMAP *gapmap = new GAPMAP (block);  //map of big vert gaps in blk
 
-  block_it.set_to_list (blocks);
-  block_index = 1;
-  for (block_it.mark_cycle_pt (); !block_it.cycled_list ();
-  block_it.forward ()) {
-    block = block_it.data ();
-    gapmap = new GAPMAP (block);
-    block_spacing_stats(block,
+  block_spacing_stats(block,
+                      gapmap,
+                      old_text_ord_proportional,
+                      block_space_gap_width,
+                      block_non_space_gap_width);
+  // Make sure relative values of block-level space and non-space gap
+  // widths are reasonable. The ratio of 1:3 is also used in
+  // block_spacing_stats, to corrrect the block_space_gap_width
+  // Useful for arabic and hindi, when the non-space gap width is
+  // often over-estimated and should not be trusted. A similar ratio
+  // is found in block_spacing_stats.
+  if (tosp_old_to_method && tosp_old_to_constrain_sp_kn &&
+      (float) block_space_gap_width / block_non_space_gap_width < 3.0) {
+    block_non_space_gap_width = (inT16) floor (block_space_gap_width / 3.0);
+  }
+  row_it.set_to_list (block->get_rows ());
+  row_index = 1;
+  for (row_it.mark_cycle_pt (); !row_it.cycled_list (); row_it.forward ()) {
+    row = row_it.data ();
+    if ((row->pitch_decision == PITCH_DEF_PROP) ||
+    (row->pitch_decision == PITCH_CORR_PROP)) {
+      if ((tosp_debug_level > 0) && !old_text_ord_proportional)
+        tprintf ("Block %d Row %d: Now Proportional\n",
+          block_index, row_index);
+      row_spacing_stats(row,
                         gapmap,
-                        old_text_ord_proportional,
+                        block_index,
+                        row_index,
                         block_space_gap_width,
                         block_non_space_gap_width);
-    // Make sure relative values of block-level space and non-space gap
-    // widths are reasonable. The ratio of 1:3 is also used in
-    // block_spacing_stats, to corrrect the block_space_gap_width
-    // Useful for arabic and hindi, when the non-space gap width is
-    // often over-estimated and should not be trusted. A similar ratio
-    // is found in block_spacing_stats.
-    if (tosp_old_to_method && tosp_old_to_constrain_sp_kn &&
-        (float) block_space_gap_width / block_non_space_gap_width < 3.0) {
-      block_non_space_gap_width = (inT16) floor (block_space_gap_width / 3.0);
     }
-    row_it.set_to_list (block->get_rows ());
-    row_index = 1;
-    for (row_it.mark_cycle_pt (); !row_it.cycled_list (); row_it.forward ()) {
-      row = row_it.data ();
-      if ((row->pitch_decision == PITCH_DEF_PROP) ||
-      (row->pitch_decision == PITCH_CORR_PROP)) {
-        if ((tosp_debug_level > 0) && !old_text_ord_proportional)
-          tprintf ("Block %d Row %d: Now Proportional\n",
-            block_index, row_index);
-        row_spacing_stats(row,
-                          gapmap,
-                          block_index,
-                          row_index,
-                          block_space_gap_width,
-                          block_non_space_gap_width);
-      }
-      else {
-        if ((tosp_debug_level > 0) && old_text_ord_proportional)
-          tprintf
-            ("Block %d Row %d: Now Fixed Pitch Decision:%d fp flag:%f\n",
-            block_index, row_index, row->pitch_decision,
-            row->fixed_pitch);
-      }
+    else {
+      if ((tosp_debug_level > 0) && old_text_ord_proportional)
+        tprintf
+          ("Block %d Row %d: Now Fixed Pitch Decision:%d fp flag:%f\n",
+          block_index, row_index, row->pitch_decision,
+          row->fixed_pitch);
+    }
 #ifndef GRAPHICS_DISABLED
-      if (textord_show_initial_words)
-        plot_word_decisions (to_win, (inT16) row->fixed_pitch, row);
+    if (textord_show_initial_words)
+      plot_word_decisions (to_win, (inT16) row->fixed_pitch, row);
 #endif
-      row_index++;
-    }
-    delete gapmap;
-    block_index++;
+    row_index++;
   }
+  delete gapmap;
 }
 
 
@@ -32,6 +32,8 @@
 #include          "textord.h"
 #include          "fpchop.h"
 #include          "wordseg.h"
+#include          "tesscallback.h"
+#include          "threadpool.h"
 
 // Include automatically generated configuration file if running autoconf.
 #ifdef HAVE_CONFIG_H
@@ -96,30 +98,58 @@ void make_single_word(bool one_blob, TO_ROW_LIST *rows, ROW_LIST* real_rows) {
   }
 }
 
+// The blocks of make_words, each of which only adds rows to its own BLOCK.
+struct RealWordsJob {
+  tesseract::Textord *textord;
+  GenericVector<TO_BLOCK*> blocks;
+};
+
+// Makes the real words of block i of the job.
+static void real_words_job(RealWordsJob* job, int i) {
+  make_real_words(job->textord, job->blocks[i], FCOORD(1.0f, 0.0f));
+}
+
 /**
  * make_words
  *
  * Arrange the blobs into words.
+ * Apart from the page-level pitch decisions, the blocks are independent,
+ * so they are processed on thread_pool if given. Each block keeps its own
+ * output, so the result does not depend on the number of threads.
  */
 void make_words(tesseract::Textord *textord,
                 ICOORD page_tr,                // top right
                 float gradient,                // page skew
                 BLOCK_LIST *blocks,            // block list
-                TO_BLOCK_LIST *port_blocks) {  // output list
+                TO_BLOCK_LIST *port_blocks,    // output list
+                tesseract::ThreadPool* thread_pool) {
   TO_BLOCK_IT block_it;          // iterator
-  TO_BLOCK *block;               // current block
 
   if (textord->use_cjk_fp_model()) {
-    compute_fixed_pitch_cjk(page_tr, port_blocks);
+    compute_fixed_pitch_cjk(page_tr, port_blocks, thread_pool);
   } else {
     compute_fixed_pitch(page_tr, port_blocks, gradient, FCOORD(0.0f, -1.0f),
-                        !(BOOL8) textord_test_landscape);
+                        !(BOOL8) textord_test_landscape, thread_pool);
   }
-  textord->to_spacing(page_tr, port_blocks);
+  textord->to_spacing(page_tr, port_blocks, thread_pool);
+  RealWordsJob job;
+  job.textord = textord;
   block_it.set_to_list(port_blocks);
-  for (block_it.mark_cycle_pt(); !block_it.cycled_list(); block_it.forward()) {
-    block = block_it.data();
-    make_real_words(textord, block, FCOORD(1.0f, 0.0f));
+  for (block_it.mark_cycle_pt(); !block_it.cycled_list(); block_it.forward())
+    job.blocks.push_back(block_it.data());
+#ifndef GRAPHICS_DISABLED
+  if (to_win != NULL)
+    thread_pool = NULL;          // drawing must stay on one thread
+#endif
+  if (thread_pool != NULL && thread_pool->num_threads() > 1 &&
+      job.blocks.size() > 1) {
+    TessCallback1<int>* make_block_words =
+        NewPermanentTessCallback(&real_words_job, &job);
+    thread_pool->ParallelFor(job.blocks.size(), make_block_words);
+    delete make_block_words;
+  } else {
+    for (int i = 0; i < job.blocks.size(); ++i)
+      real_words_job(&job, i);
   }
 }
 
@@ -26,6 +26,7 @@
 
 namespace tesseract {
 class Tesseract;
+class ThreadPool;
 }
 
 extern BOOL_VAR_H (textord_fp_chopping, TRUE, "Do fixed pitch chopping");
@@ -35,11 +36,13 @@ extern BOOL_VAR_H (textord_chopper_test, FALSE,
                    "Chopper is being tested.");
 
 void make_single_word(bool one_blob, TO_ROW_LIST *rows, ROW_LIST* real_rows);
+// The blocks are processed on thread_pool if given.
 void make_words(tesseract::Textord *textord,
                 ICOORD page_tr,                // top right
                 float gradient,               // page skew
                 BLOCK_LIST *blocks,           // block list
-                TO_BLOCK_LIST *port_blocks);  // output list
+                TO_BLOCK_LIST *port_blocks,   // output list
+                tesseract::ThreadPool* thread_pool = NULL);
 void set_row_spaces(                  //find space sizes
                     TO_BLOCK *block,  //block to do
                     FCOORD rotation,  //for drawing
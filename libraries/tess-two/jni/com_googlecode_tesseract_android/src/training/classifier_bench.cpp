@@ -0,0 +1,316 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+//  Filename: classifier_bench.cpp
+//  Purpose:  Times the static classifier kernels on recorded features and
+//            checks that their results have not changed.
+
+#include <stdio.h>
+#include <string.h>
+#ifndef USE_STD_NAMESPACE
+#include "base/commandlineflags.h"
+#endif  // USE_STD_NAMESPACE
+#include "allheaders.h"
+#include "baseapi.h"
+#include "classify.h"
+#include "commontraining.h"
+#include "intfx.h"
+#include "pageiterator.h"
+#include "pagecounters.h"
+#include "pageres.h"
+#include "shapetable.h"
+#include "stagetimer.h"
+#include "strngs.h"
+#include "tesseractclass.h"
+#include "trainingsample.h"
+
+STRING_PARAM_FLAG(lang, "eng", "Language whose templates are timed");
+STRING_PARAM_FLAG(tessdata_dir, "", "Directory of traineddata files");
+STRING_PARAM_FLAG(samples, "", "Recorded feature file, and golden prefix");
+BOOL_PARAM_FLAG(record, false,
+                "Record samples and golden results from the images");
+INT_PARAM_FLAG(iterations, 10, "Times to classify every sample");
+
+// Gives access to the WERD_RES of a PageIterator, to get at the blobs that
+// were classified.
+class WordResIterator : public tesseract::PageIterator {
+ public:
+  explicit WordResIterator(const tesseract::PageIterator& src)
+    : PageIterator(src) {}
+  WERD_RES* word() const {
+    return it_->word();
+  }
+};
+
+// Recognizes the image and extracts the features of every blob of the
+// result into samples, timing the extraction alone in *extract_ms.
+static bool ExtractImageSamples(const char* filename,
+                                tesseract::TessBaseAPI* api,
+                                tesseract::Classify* classify,
+                                GenericVector<tesseract::TrainingSample*>* samples,
+                                double* extract_ms) {
+  Pix* pix = pixRead(filename);
+  if (pix == NULL) {
+    fprintf(stderr, "Can't read image %s\n", filename);
+    return false;
+  }
+  api->SetImage(pix);
+  bool ok = api->Recognize(NULL) == 0;
+  pixDestroy(&pix);
+  if (!ok) {
+    fprintf(stderr, "Recognition of %s failed\n", filename);
+    return false;
+  }
+  tesseract::ResultIterator* it = api->GetIterator();
+  if (it == NULL) return true;
+  WordResIterator words(*it);
+  delete it;
+  GenericVector<INT_FEATURE_STRUCT> bl_features;
+  do {
+    WERD_RES* word = words.word();
+    if (word == NULL) continue;
+    TWERD* blobs = word->rebuild_word != NULL ? word->rebuild_word
+                                              : word->chopped_word;
+    if (blobs == NULL) continue;
+    for (int b = 0; b < blobs->NumBlobs(); ++b) {
+      INT_FX_RESULT_STRUCT fx_info;
+      double start = tesseract::StageTimings::NowMillis();
+      tesseract::TrainingSample* sample = tesseract::BlobToTrainingSample(
+          *blobs->blobs[b], classify->classify_nonlinear_norm, &fx_info,
+          &bl_features);
+      *extract_ms += tesseract::StageTimings::NowMillis() - start;
+      if (sample != NULL) samples->push_back(sample);
+    }
+  } while (words.Next(tesseract::RIL_WORD));
+  return true;
+}
+
+// Returns true if the two samples hold the same features.
+static bool SameFeatures(const tesseract::TrainingSample& a,
+                         const tesseract::TrainingSample& b) {
+  return a.num_features() == b.num_features() &&
+         memcmp(a.features(), b.features(),
+                a.num_features() * sizeof(*a.features())) == 0;
+}
+
+// Appends the ratings to the golden text, one line per sample. The ratings
+// are printed with enough digits to tell any two floats apart.
+static void AppendRatings(const char* kind, int index,
+                          const GenericVector<tesseract::UnicharRating>& ratings,
+                          STRING* golden) {
+  golden->add_str_int(kind, index);
+  for (int r = 0; r < ratings.size(); ++r) {
+    char rating[32];
+    snprintf(rating, sizeof(rating), ":%.9g", ratings[r].rating);
+    golden->add_str_int(" ", ratings[r].unichar_id);
+    *golden += rating;
+  }
+  *golden += "\n";
+}
+
+// Runs the pruner, then the full classifier, on all the samples the given
+// number of times, adding the milliseconds of each to *prune_ms and
+// *full_ms. The results of the first iteration go in golden, and the class
+// matches of every iteration in *matches.
+static void ClassifySamples(
+    tesseract::Classify* classify,
+    const GenericVector<tesseract::TrainingSample*>& samples, int iterations,
+    double* prune_ms, double* full_ms, inT64* matches, STRING* golden) {
+  GenericVector<tesseract::UnicharRating> ratings;
+  tesseract::PageCounts counts;
+  tesseract::PageCounts::ResetAll();
+  for (int i = 0; i < iterations; ++i) {
+    double start = tesseract::StageTimings::NowMillis();
+    for (int s = 0; s < samples.size(); ++s) {
+      classify->CharNormTrainingSample(true, -1, *samples[s], &ratings);
+      if (i == 0) AppendRatings("p", s, ratings, golden);
+    }
+    double middle = tesseract::StageTimings::NowMillis();
+    for (int s = 0; s < samples.size(); ++s) {
+      classify->CharNormTrainingSample(false, -1, *samples[s], &ratings);
+      if (i == 0) AppendRatings("m", s, ratings, golden);
+    }
+    *prune_ms += middle - start;
+    *full_ms += tesseract::StageTimings::NowMillis() - middle;
+  }
+  counts.Collect();
+  *matches = counts.counts[tesseract::COUNTER_CLASS_MATCHES];
+}
+
+// Compares the text to the golden lines, printing the first few that
+// differ. Returns the number of lines that differ.
+static int CompareToGolden(STRING text, STRING golden) {
+  GenericVector<STRING> lines, golden_lines;
+  text.split('\n', &lines);
+  golden.split('\n', &golden_lines);
+  int mismatches = 0;
+  int max_lines = MAX(lines.size(), golden_lines.size());
+  for (int l = 0; l < max_lines; ++l) {
+    if (l < lines.size() && l < golden_lines.size() &&
+        lines[l] == golden_lines[l])
+      continue;
+    if (++mismatches <= 5) {
+      fprintf(stderr, "Golden mismatch at line %d:\n  want %s\n  got  %s\n",
+              l + 1, l < golden_lines.size() ? golden_lines[l].string() : "",
+              l < lines.size() ? lines[l].string() : "");
+    }
+  }
+  return mismatches;
+}
+
+// Micro benchmark of the static classifier, for changes to the pruner,
+// IntegerMatcher or feature extraction that must not change results.
+// Record the samples and golden results once, with the unchanged code:
+//   classifier_bench --record -samples base -lang eng image...
+// which writes base.samples and base.golden. Then after the change:
+//   classifier_bench -samples base -lang eng [image...]
+// replays base.samples through the pruner and the full classifier, and the
+// images, if given, through feature extraction, times them, and exits with
+// 1 if any result differs from the recording. The samples are also run with
+// classify_bound_class_pruner off, which must not change the results, to
+// time the pruner without its bounds. The times are printed as a line of
+// JSON.
+int main(int argc, char **argv) {
+  ParseArguments(&argc, &argv);
+  if (FLAGS_samples.empty()) {
+    fprintf(stderr, "Usage: %s [--record] -samples base [-lang lang]"
+            " [-tessdata_dir dir] [-iterations n] [image...]\n", argv[0]);
+    return 1;
+  }
+  STRING samples_file = FLAGS_samples.c_str();
+  samples_file += ".samples";
+  STRING golden_file = FLAGS_samples.c_str();
+  golden_file += ".golden";
+
+  tesseract::TessBaseAPI api;
+  if (api.Init(FLAGS_tessdata_dir.empty() ? NULL : FLAGS_tessdata_dir.c_str(),
+               FLAGS_lang.c_str(), tesseract::OEM_TESSERACT_ONLY) < 0) {
+    fprintf(stderr, "Tesseract initialization failed!\n");
+    return 1;
+  }
+  tesseract::Classify* classify = const_cast<tesseract::Tesseract*>(
+      api.tesseract());
+
+  // Feature extraction, from the images.
+  GenericVector<tesseract::TrainingSample*> extracted;
+  double extract_ms = 0.0;
+  for (int arg = 1; arg < argc; ++arg) {
+    if (!ExtractImageSamples(argv[arg], &api, classify, &extracted,
+                             &extract_ms))
+      return 1;
+  }
+  int mismatches = 0;
+  GenericVector<tesseract::TrainingSample*> samples;
+  if (FLAGS_record) {
+    if (extracted.empty()) {
+      fprintf(stderr, "No blobs to record: give some images\n");
+      return 1;
+    }
+    FILE* fp = fopen(samples_file.string(), "wb");
+    inT32 num_samples = extracted.size();
+    bool ok = fp != NULL && fwrite(&num_samples, sizeof(num_samples), 1, fp);
+    for (int s = 0; ok && s < extracted.size(); ++s)
+      ok = extracted[s]->Serialize(fp);
+    if (fp != NULL) fclose(fp);
+    if (!ok) {
+      fprintf(stderr, "Can't write %s\n", samples_file.string());
+      return 1;
+    }
+    samples = extracted;
+  } else {
+    FILE* fp = fopen(samples_file.string(), "rb");
+    inT32 num_samples = 0;
+    if (fp == NULL || fread(&num_samples, sizeof(num_samples), 1, fp) != 1) {
+      fprintf(stderr, "Can't read %s\n", samples_file.string());
+      return 1;
+    }
+    for (int s = 0; s < num_samples; ++s) {
+      tesseract::TrainingSample* sample =
+          tesseract::TrainingSample::DeSerializeCreate(false, fp);
+      if (sample == NULL) break;
+      samples.push_back(sample);
+    }
+    fclose(fp);
+    if (samples.size() != num_samples) {
+      fprintf(stderr, "%s is truncated\n", samples_file.string());
+      return 1;
+    }
+    // The features must be extracted exactly as they were recorded.
+    if (!extracted.empty()) {
+      int diffs = extracted.size() != samples.size();
+      for (int s = 0; s < extracted.size() && s < samples.size(); ++s) {
+        if (!SameFeatures(*extracted[s], *samples[s])) ++diffs;
+      }
+      if (diffs > 0)
+        fprintf(stderr, "%d blobs have different features\n", diffs);
+      mismatches += diffs;
+    }
+  }
+
+  // The pruner and the IntegerMatcher, on the samples.
+  double prune_ms = 0.0, full_ms = 0.0;
+  inT64 matches = 0;
+  STRING results;
+  ClassifySamples(classify, samples, FLAGS_iterations, &prune_ms, &full_ms,
+                  &matches, &results);
+  if (FLAGS_record) {
+    GenericVector<char> data;
+    data.init_to_size(results.length(), 0);
+    memcpy(&data[0], results.string(), results.length());
+    if (!tesseract::SaveDataToFile(data, golden_file)) {
+      fprintf(stderr, "Can't write %s\n", golden_file.string());
+      return 1;
+    }
+  } else {
+    GenericVector<char> data;
+    if (!tesseract::LoadDataFromFile(golden_file, &data)) {
+      fprintf(stderr, "Can't read %s\n", golden_file.string());
+      return 1;
+    }
+    mismatches += CompareToGolden(results, STRING(&data[0]));
+  }
+
+  // The pruner again with every class pruner table scored, for comparison
+  // with the bounded pruner above.
+  double unbounded_prune_ms = 0.0, unbounded_full_ms = 0.0;
+  inT64 unbounded_matches = 0;
+  STRING unbounded_results;
+  bool bound_class_pruner = classify->classify_bound_class_pruner;
+  classify->classify_bound_class_pruner.set_value(false);
+  ClassifySamples(classify, samples, FLAGS_iterations, &unbounded_prune_ms,
+                  &unbounded_full_ms, &unbounded_matches, &unbounded_results);
+  classify->classify_bound_class_pruner.set_value(bound_class_pruner);
+  if (unbounded_results != results) {
+    fprintf(stderr, "The class pruner bounds changed the results\n");
+    ++mismatches;
+  }
+
+  // The full classifier runs the pruner again, so the rest of its time is
+  // spent in the matcher.
+  int runs = MAX(samples.size() * FLAGS_iterations, 1);
+  double match_ms = MAX(full_ms - prune_ms, 0.0);
+  printf("{\"lang\": \"%s\", \"samples\": %d, \"iterations\": %d",
+         FLAGS_lang.c_str(), samples.size(), static_cast<int>(FLAGS_iterations));
+  printf(", \"extract_us_per_blob\": %.3f",
+         extracted.empty() ? 0.0 : extract_ms * 1000.0 / extracted.size());
+  printf(", \"prune_us_per_sample\": %.3f", prune_ms * 1000.0 / runs);
+  printf(", \"unbounded_prune_us_per_sample\": %.3f",
+         unbounded_prune_ms * 1000.0 / runs);
+  printf(", \"match_us_per_sample\": %.3f", match_ms * 1000.0 / runs);
+  printf(", \"class_matches_per_sample\": %.2f",
+         static_cast<double>(matches) / runs);
+  printf(", \"ns_per_class_match\": %.1f",
+         matches > 0 ? match_ms * 1e6 / matches : 0.0);
+  printf(", \"mismatches\": %d}\n", mismatches);
+
+  if (!FLAGS_record) extracted.delete_data_pointers();
+  samples.delete_data_pointers();
+  return mismatches > 0 ? 1 : 0;
+}
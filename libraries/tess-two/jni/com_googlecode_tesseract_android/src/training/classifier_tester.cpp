@@ -33,6 +33,9 @@
 STRING_PARAM_FLAG(classifier, "", "Classifier to test");
 STRING_PARAM_FLAG(lang, "eng", "Language to test");
 STRING_PARAM_FLAG(tessdata_dir, "", "Directory of traineddata files");
+INT_PARAM_FLAG(test_threads, 1,
+               "Number of threads to test on, each with its own classifier."
+               " Above 1, also reports samples/sec and latency per sample");
 DECLARE_INT_PARAM_FLAG(debug_level);
 DECLARE_STRING_PARAM_FLAG(T);
 
@@ -54,7 +57,7 @@ const char* names[] = {"pruner", "full",
 
 static tesseract::ShapeClassifier* InitializeClassifier(
     const char* classifer_name, const UNICHARSET& unicharset,
-    int argc, char **argv,
+    const GenericVector<STRING>& config_names,
     tesseract::TessBaseAPI** api) {
   // Decode the classifier string.
   ClassifierName classifier = CN_COUNT;
@@ -100,12 +103,9 @@ static tesseract::ShapeClassifier* InitializeClassifier(
   }
   tesseract::ShapeClassifier* shape_classifier = NULL;
 
-  if (!FLAGS_T.empty()) {
-    const char* config_name;
-    while ((config_name = GetNextFilename(argc, argv)) != NULL) {
-      tprintf("Reading config file %s ...\n", config_name);
-      (*api)->ReadConfigFile(config_name);
-    }
+  for (int i = 0; i < config_names.size(); ++i) {
+    tprintf("Reading config file %s ...\n", config_names[i].string());
+    (*api)->ReadConfigFile(config_names[i].string());
   }
   if (classifier == CN_PRUNER) {
     shape_classifier = new tesseract::TessClassifier(true, classify);
@@ -133,6 +133,10 @@ static tesseract::ShapeClassifier* InitializeClassifier(
 // From a serialized trainer:
 //  classifier_tester -input_trainer trainer [-lang lang] -classifier x
 //
+// Either way, -test_threads n tests on n threads at once, each with its own
+// instance of the classifier (the templates are shared), and also reports
+// the throughput and the distribution of the latency per sample.
+//
 // In the first case, the unicharset must be the unicharset from within
 // the classifier under test, and the font_properties and xheights files must
 // match the files used during training.
@@ -151,13 +155,27 @@ int main(int argc, char **argv) {
   STRING file_prefix;
   tesseract::MasterTrainer* trainer = tesseract::LoadTrainingData(
       argc, argv, false, NULL, &file_prefix);
-  tesseract::TessBaseAPI* api;
-  // Decode the classifier string.
-  tesseract::ShapeClassifier* shape_classifier = InitializeClassifier(
-      FLAGS_classifier.c_str(), trainer->unicharset(), argc, argv, &api);
-  if (shape_classifier == NULL) {
-    fprintf(stderr, "Classifier init failed!:%s\n", FLAGS_classifier.c_str());
-    return 1;
+  GenericVector<STRING> config_names;
+  if (!FLAGS_T.empty()) {
+    const char* config_name;
+    while ((config_name = GetNextFilename(argc, argv)) != NULL)
+      config_names.push_back(config_name);
+  }
+  int num_threads = MAX(1, FLAGS_test_threads);
+  tesseract::PointerVector<tesseract::TessBaseAPI> apis;
+  tesseract::PointerVector<tesseract::ShapeClassifier> shape_classifiers;
+  for (int t = 0; t < num_threads; ++t) {
+    tesseract::TessBaseAPI* api = NULL;
+    // Decode the classifier string.
+    tesseract::ShapeClassifier* shape_classifier = InitializeClassifier(
+        FLAGS_classifier.c_str(), trainer->unicharset(), config_names, &api);
+    apis.push_back(api);
+    if (shape_classifier == NULL) {
+      fprintf(stderr, "Classifier init failed!:%s\n",
+              FLAGS_classifier.c_str());
+      return 1;
+    }
+    shape_classifiers.push_back(shape_classifier);
   }
 
   // We want to test junk as well if it is available.
@@ -165,11 +183,18 @@ int main(int argc, char **argv) {
   // We want to test with replicated samples too.
   trainer->ReplicateAndRandomizeSamplesIfRequired();
 
-  trainer->TestClassifierOnSamples(tesseract:: CT_UNICHAR_TOP1_ERR,
-                                   MAX(3, FLAGS_debug_level), false,
-                                   shape_classifier, NULL);
-  delete shape_classifier;
-  delete api;
+  if (num_threads > 1) {
+    trainer->TestClassifiersInParallel(tesseract::CT_UNICHAR_TOP1_ERR,
+                                       MAX(3, FLAGS_debug_level), false,
+                                       shape_classifiers, NULL);
+  } else {
+    trainer->TestClassifierOnSamples(tesseract:: CT_UNICHAR_TOP1_ERR,
+                                     MAX(3, FLAGS_debug_level), false,
+                                     shape_classifiers[0], NULL);
+  }
+  // The classifiers use the apis, so delete them first.
+  shape_classifiers.clear();
+  apis.clear();
   delete trainer;
 
   return 0;
@@ -36,6 +36,8 @@
 #include <math.h>
 #include "unichar.h"
 #include "commontraining.h"
+#include "tesscallback.h"
+#include "threadpool.h"
 
 #define PROGRAM_FEATURE_TYPE "cn"
 
@@ -52,6 +54,16 @@ int main (
           Private Function Prototypes
 ----------------------------------------------------------------------------*/
 
+// The classes to cluster, and the protos found for each of them.
+struct ClassClusteringJob {
+  const FEATURE_DEFS_STRUCT *FeatureDefs;
+  GenericVector<LABELEDLIST> CharSamples;
+  GenericVector<LIST> ProtoLists;
+  GenericVector<bool> Failed;
+};
+
+void ClusterClass(ClassClusteringJob *Job, int Index);
+
 void WriteNormProtos(const char *Directory, LIST LabeledProtoList,
                      const FEATURE_DESC_STRUCT *feature_desc);
 
@@ -75,7 +87,7 @@ void WriteProtos(
 //-M 0.025   -B 0.05   -I 0.8   -C 1e-3
 CLUSTERCONFIG  CNConfig =
 {
-  elliptical, 0.025, 0.05, 0.8, 1e-3, 0
+  elliptical, 0.025, 0.05, 0.8, 1e-3, 0, 1
 };
 
 /*----------------------------------------------------------------------------
@@ -137,11 +149,8 @@ int main(int argc, char *argv[]) {
   const char  *PageName;
   FILE  *TrainingPage;
   LIST  CharList = NIL_LIST;
-  CLUSTERER  *Clusterer = NULL;
-  LIST    ProtoList = NIL_LIST;
   LIST    NormProtoList = NIL_LIST;
   LIST pCharList;
-  LABELEDLIST CharSample;
   FEATURE_DEFS_STRUCT FeatureDefs;
   InitFeatureDefs(&FeatureDefs);
 
@@ -163,35 +172,33 @@ int main(int argc, char *argv[]) {
   // The norm protos will count the source protos, so we keep them here in
   // freeable_protos, so they can be freed later.
   GenericVector<LIST> freeable_protos;
+  ClassClusteringJob Job;
+  Job.FeatureDefs = &FeatureDefs;
   iterate(pCharList) {
-    //Cluster
-    CharSample = (LABELEDLIST)first_node(pCharList);
-    Clusterer =
-      SetUpForClustering(FeatureDefs, CharSample, PROGRAM_FEATURE_TYPE);
-    if (Clusterer == NULL) {  // To avoid a SIGSEGV
+    Job.CharSamples.push_back((LABELEDLIST)first_node(pCharList));
+  }
+  Job.ProtoLists.init_to_size(Job.CharSamples.size(), NIL_LIST);
+  Job.Failed.init_to_size(Job.CharSamples.size(), false);
+  // The classes are independent, so they can be clustered in parallel, and
+  // are added to the norm protos in order afterwards.
+  if (Config.NumThreads > 1) {
+    tesseract::ThreadPool pool(Config.NumThreads);
+    TessCallback1<int> *cluster = NewPermanentTessCallback(&ClusterClass,
+                                                           &Job);
+    pool.ParallelFor(Job.CharSamples.size(), cluster);
+    delete cluster;
+  } else {
+    for (int c = 0; c < Job.CharSamples.size(); ++c)
+      ClusterClass(&Job, c);
+  }
+  for (int c = 0; c < Job.CharSamples.size(); ++c) {
+    if (Job.Failed[c]) {  // To avoid a SIGSEGV
       fprintf(stderr, "Error: NULL clusterer!\n");
       return 1;
     }
-    float SavedMinSamples = Config.MinSamples;
-    // To disable the tendency to produce a single cluster for all fonts,
-    // make MagicSamples an impossible to achieve number:
-    // Config.MagicSamples = CharSample->SampleCount * 10;
-    Config.MagicSamples = CharSample->SampleCount;
-    while (Config.MinSamples > 0.001) {
-      ProtoList = ClusterSamples(Clusterer, &Config);
-      if (NumberOfProtos(ProtoList, 1, 0) > 0) {
-        break;
-      } else {
-        Config.MinSamples *= 0.95;
-        printf("0 significant protos for %s."
-               " Retrying clustering with MinSamples = %f%%\n",
-               CharSample->Label, Config.MinSamples);
-      }
-    }
-    Config.MinSamples = SavedMinSamples;
-    AddToNormProtosList(&NormProtoList, ProtoList, CharSample->Label);
-    freeable_protos.push_back(ProtoList);
-    FreeClusterer(Clusterer);
+    AddToNormProtosList(&NormProtoList, Job.ProtoLists[c],
+                        Job.CharSamples[c]->Label);
+    freeable_protos.push_back(Job.ProtoLists[c]);
   }
   FreeTrainingSamples(CharList);
   int desc_index = ShortNameToFeatureType(FeatureDefs, PROGRAM_FEATURE_TYPE);
@@ -209,6 +216,48 @@ int main(int argc, char *argv[]) {
               Private Code
 ----------------------------------------------------------------------------*/
 
+/*----------------------------------------------------------------------------*/
+/**
+* This routine clusters the samples of the class at Index in
+* Job, retrying with fewer MinSamples until there is a
+* significant proto. It only writes the results for Index, so
+* the classes may be clustered in parallel.
+* @param Job  classes to cluster and their results
+* @param Index  index of the class to cluster
+* @return none
+*/
+void ClusterClass(ClassClusteringJob *Job, int Index) {
+  LABELEDLIST CharSample = Job->CharSamples[Index];
+  CLUSTERER *Clusterer =
+    SetUpForClustering(*Job->FeatureDefs, CharSample, PROGRAM_FEATURE_TYPE);
+  if (Clusterer == NULL) {
+    Job->Failed[Index] = true;
+    return;
+  }
+  // Each class has its own copy of the parameters, as they are changed.
+  CLUSTERCONFIG ClassConfig = Config;
+  // The classes are what runs in parallel, if anything.
+  ClassConfig.NumThreads = 1;
+  // To disable the tendency to produce a single cluster for all fonts,
+  // make MagicSamples an impossible to achieve number:
+  // ClassConfig.MagicSamples = CharSample->SampleCount * 10;
+  ClassConfig.MagicSamples = CharSample->SampleCount;
+  LIST ProtoList = NIL_LIST;
+  while (ClassConfig.MinSamples > 0.001) {
+    ProtoList = ClusterSamples(Clusterer, &ClassConfig);
+    if (NumberOfProtos(ProtoList, 1, 0) > 0) {
+      break;
+    } else {
+      ClassConfig.MinSamples *= 0.95;
+      printf("0 significant protos for %s."
+             " Retrying clustering with MinSamples = %f%%\n",
+             CharSample->Label, ClassConfig.MinSamples);
+    }
+  }
+  Job->ProtoLists[Index] = ProtoList;
+  FreeClusterer(Clusterer);
+}  // ClusterClass
+
 /*----------------------------------------------------------------------------*/
 /**
 * This routine writes the specified samples into files which
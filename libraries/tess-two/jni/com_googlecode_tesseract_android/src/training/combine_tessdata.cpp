@@ -31,6 +31,12 @@
 //
 // The result will be a combined tessdata file /home/$USER/temp/eng.traineddata
 //
+// Specify option -z to compress the components with zlib as they are combined.
+// This makes the file smaller, at the cost of decompressing each component
+// into memory when it is loaded:
+//
+//   combine_tessdata -z /home/$USER/temp/eng.
+//
 // Specify option -e if you would like to extract individual components
 // from a combined traineddata file. For example, to extract language config
 // file and the unicharset from tessdata/eng.traineddata run:
@@ -56,6 +62,20 @@
 // component type (.unicharset for the unicharset, .unicharambigs for unichar
 // ambigs, etc). See k*FileSuffix variable in ccutil/tessdatamanager.h.
 //
+// Specify option -a instead of -o to update the given [lang].traineddata file
+// in place, without copying the components that stay the same. The new
+// components are appended to the end of the file along with a new table of
+// where each component is, which is much faster for a large file, but leaves
+// the old copies as unused space:
+//
+//   combine_tessdata -a tessdata/eng.traineddata
+//   /home/$USER/temp/eng.word-dawg
+//
+// Specify option -c to compact a traineddata file updated with -a, removing
+// the unused space, so it can also be read by older versions of tesseract:
+//
+//   combine_tessdata -c tessdata/eng.traineddata
+//
 // Specify option -u to unpack all the components to the specified path:
 //
 // combine_tessdata -u tessdata/eng.traineddata /home/$USER/temp/eng.
@@ -65,16 +85,17 @@
 //
 int main(int argc, char **argv) {
   int i;
-  if (argc == 2) {
+  if (argc == 2 || (argc == 3 && strcmp(argv[1], "-z") == 0)) {
     printf("Combining tessdata files\n");
-    STRING lang = argv[1];
-    char* last = &argv[1][strlen(argv[1])-1];
+    bool compress = argc == 3;
+    STRING lang = argv[argc - 1];
+    char* last = &argv[argc - 1][strlen(argv[argc - 1])-1];
     if (*last != '.')
       lang += '.';
     STRING output_file = lang;
     output_file += kTrainedDataSuffix;
     if (!tesseract::TessdataManager::CombineDataFiles(
-        lang.string(), output_file.string())) {
+        lang.string(), output_file.string(), compress)) {
       printf("Error combining tessdata files into %s\n",
              output_file.string());
     } else {
@@ -126,9 +147,22 @@ int main(int argc, char **argv) {
     // Write the updated traineddata file.
     tm.OverwriteComponents(new_traineddata_filename, argv+3, argc-3);
     tm.End();
+  } else if (argc >= 4 && strcmp(argv[1], "-a") == 0) {
+    if (!tesseract::TessdataManager::AppendComponents(argv[2], argv + 3,
+                                                      argc - 3)) {
+      printf("Error appending components to %s\n", argv[2]);
+      return 1;
+    }
+    printf("Updated %s\n", argv[2]);
+  } else if (argc == 3 && strcmp(argv[1], "-c") == 0) {
+    if (!tesseract::TessdataManager::CompactDataFile(argv[2])) {
+      printf("Error compacting %s\n", argv[2]);
+      return 1;
+    }
+    printf("Compacted %s\n", argv[2]);
   } else {
     printf("Usage for combining tessdata components:\n"
-           "  %s language_data_path_prefix\n"
+           "  %s [-z] language_data_path_prefix\n"
            "  (e.g. %s tessdata/eng.)\n\n", argv[0], argv[0]);
     printf("Usage for extracting tessdata components:\n"
            "  %s -e traineddata_file [output_component_file...]\n"
@@ -138,6 +172,13 @@ int main(int argc, char **argv) {
            "  %s -o traineddata_file [input_component_file...]\n"
            "  (e.g. %s -o eng.traineddata eng.unicharset)\n\n",
            argv[0], argv[0]);
+    printf("Usage for updating tessdata components in place:\n"
+           "  %s -a traineddata_file [input_component_file...]\n"
+           "  (e.g. %s -a eng.traineddata eng.word-dawg)\n\n",
+           argv[0], argv[0]);
+    printf("Usage for compacting a traineddata file updated in place:\n"
+           "  %s -c traineddata_file\n"
+           "  (e.g. %s -c eng.traineddata)\n\n", argv[0], argv[0]);
     printf("Usage for unpacking all tessdata components:\n"
            "  %s -u traineddata_file output_path_prefix\n"
            "  (e.g. %s -u eng.traineddata tmp/eng.)\n", argv[0], argv[0]);
@@ -47,7 +47,7 @@ using tesseract::ShapeTable;
 
 // global variable to hold configuration parameters to control clustering
 // -M 0.625   -B 0.05   -I 1.0   -C 1e-6.
-CLUSTERCONFIG Config = { elliptical, 0.625, 0.05, 1.0, 1e-6, 0 };
+CLUSTERCONFIG Config = { elliptical, 0.625, 0.05, 1.0, 1e-6, 0, 1 };
 FEATURE_DEFS_STRUCT feature_defs;
 CCUtil ccutil;
 
@@ -71,6 +71,15 @@ DOUBLE_PARAM_FLAG(clusterconfig_independence, Config.Independence,
                   "Desired independence between dimensions");
 DOUBLE_PARAM_FLAG(clusterconfig_confidence, Config.Confidence,
                   "Desired confidence in prototypes created");
+INT_PARAM_FLAG(clusterconfig_threads, 1,
+               "Number of threads to cluster with. The output is the same"
+               " for any number");
+STRING_PARAM_FLAG(sample_store, "",
+                  "File name prefix for keeping the features of the training"
+                  " samples on disk instead of in memory");
+STRING_PARAM_FLAG(shape_checkpoint, "",
+                  "File name prefix for checkpoints of the shape distances,"
+                  " so that an interrupted shape clustering can be resumed");
 
 /**
  * This routine parses the command line arguments that were
@@ -103,6 +112,7 @@ void ParseArguments(int* argc, char ***argv) {
       MAX(0.0, MIN(1.0, double(FLAGS_clusterconfig_independence)));
   Config.Confidence =
       MAX(0.0, MIN(1.0, double(FLAGS_clusterconfig_confidence)));
+  Config.NumThreads = MAX(1, int(FLAGS_clusterconfig_threads));
   // Set additional parameters from config file if specified.
   if (!FLAGS_configfile.empty()) {
     tesseract::ParamUtils::ReadParamsFile(
@@ -198,6 +208,12 @@ MasterTrainer* LoadTrainingData(int argc, const char* const * argv,
                                              shape_analysis,
                                              replication,
                                              FLAGS_debug_level);
+  trainer->SetNumThreads(FLAGS_clusterconfig_threads);
+  trainer->SetShapeCheckpoint(FLAGS_shape_checkpoint.c_str());
+  if (!FLAGS_sample_store.empty() &&
+      !trainer->SetSampleStore(FLAGS_sample_store.c_str())) {
+    tprintf("Keeping the training samples in memory\n");
+  }
   IntFeatureSpace fs;
   fs.Init(kBoostXYBuckets, kBoostXYBuckets, kBoostDirBuckets);
   if (FLAGS_T.empty()) {
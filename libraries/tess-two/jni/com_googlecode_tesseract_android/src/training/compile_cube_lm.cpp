@@ -0,0 +1,81 @@
+///////////////////////////////////////////////////////////////////////
+// File:        compile_cube_lm.cpp
+// Description: Program to convert the cube word unigrams and character
+//              bigrams of a language to their binary form.
+//
+// (C) Copyright 2017, Google Inc.
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <string>
+
+#include "char_bigrams.h"
+#include "tprintf.h"
+#include "word_unigrams.h"
+
+// Writes the table to the file of the given name. Returns false on error.
+template <typename T>
+static bool SaveTable(const T &table, const string &file_name) {
+  FILE *fp = fopen(file_name.c_str(), "wb");
+  if (fp == NULL) {
+    tprintf("Could not open %s for writing.\n", file_name.c_str());
+    return false;
+  }
+  bool written = table.Save(fp);
+  if (fclose(fp) != 0 || !written) {
+    tprintf("Error writing %s.\n", file_name.c_str());
+    return false;
+  }
+  return true;
+}
+
+int main(int argc, char *argv[]) {
+  if (argc != 4) {
+    tprintf("Convert the <lang>.cube.word-freq and <lang>.cube.bigrams\n"
+            "files of a language to the binary form that cube maps into\n"
+            "memory instead of parsing. The files are written with the\n"
+            "same names to the output directory, which must differ from\n"
+            "the input one.\n");
+    tprintf("Usage: %s <input dir/> <lang> <output dir/>\n", argv[0]);
+    return 1;
+  }
+  string input_path = argv[1];
+  string lang = argv[2];
+  string output_path = argv[3];
+  int converted = 0;
+
+  tesseract::WordUnigrams *word_unigrams =
+      tesseract::WordUnigrams::Create(input_path, lang);
+  if (word_unigrams != NULL) {
+    bool saved = SaveTable(*word_unigrams,
+                           output_path + lang + ".cube.word-freq");
+    delete word_unigrams;
+    if (!saved) return 1;
+    ++converted;
+  }
+  tesseract::CharBigrams *char_bigrams =
+      tesseract::CharBigrams::Create(input_path, lang);
+  if (char_bigrams != NULL) {
+    bool saved = SaveTable(*char_bigrams,
+                           output_path + lang + ".cube.bigrams");
+    delete char_bigrams;
+    if (!saved) return 1;
+    ++converted;
+  }
+  if (converted == 0) {
+    tprintf("Found no cube word unigrams or bigrams for %s in %s.\n",
+            lang.c_str(), input_path.c_str());
+    return 1;
+  }
+  return 0;
+}
@@ -113,7 +113,7 @@ Pix* DegradeImage(Pix* input, int exposure, TRand* randomizer,
     if (*rotation) {
       radians_clockwise = *rotation;
     } else if (randomizer != NULL) {
-      radians_clockwise = randomizer->SignedRand(kRotationRange);
+      radians_clockwise = RandomRotation(randomizer);
     }
 
     input = pixRotate(pix, radians_clockwise,
@@ -170,6 +170,12 @@ Pix* DegradeImage(Pix* input, int exposure, TRand* randomizer,
   return input;
 }
 
+// Returns a random rotation in radians clockwise, of the size that
+// DegradeImage uses to make the edges jaggy.
+float RandomRotation(TRand* randomizer) {
+  return randomizer->SignedRand(kRotationRange);
+}
+
 // Creates and returns a Pix distorted by various means according to the bool
 // flags. If boxes is not NULL, the boxes are resized/positioned according to
 // any spatial distortion and also by the integer reduction factor box_scale
@@ -35,6 +35,10 @@ namespace tesseract {
 struct Pix* DegradeImage(struct Pix* input, int exposure, TRand* randomizer,
                          float* rotation);
 
+// Returns a random rotation in radians clockwise, of the size that
+// DegradeImage uses to make the edges jaggy.
+float RandomRotation(TRand* randomizer);
+
 // Creates and returns a Pix distorted by various means according to the bool
 // flags. If boxes is not NULL, the boxes are resized/positioned according to
 // any spatial distortion and also by the integer reduction factor box_scale
@@ -60,7 +60,9 @@
 #include "oldlist.h"
 #include "protos.h"
 #include "shapetable.h"
+#include "tesscallback.h"
 #include "tessopt.h"
+#include "threadpool.h"
 #include "tprintf.h"
 #include "unicity_table.h"
 
@@ -120,24 +122,29 @@ static void DisplayProtoList(const char* ch, LIST protolist) {
 }
 #endif  // GRAPHICS_DISABLED
 
-// Helper to run clustering on a single config.
+// Helper to run clustering on a single config, returning the protos that
+// will be used in the inttemp output file.
 // Mostly copied from the old mftraining, but with renamed variables.
+// Each call has its own copy of Config, so configs may be clustered in
+// parallel.
 static LIST ClusterOneConfig(int shape_id, const char* class_label,
-                             LIST mf_classes,
                              const ShapeTable& shape_table,
                              MasterTrainer* trainer) {
+  CLUSTERCONFIG config = Config;
+  // The configs are what runs in parallel, if anything.
+  config.NumThreads = 1;
   int num_samples;
   CLUSTERER  *clusterer = trainer->SetupForClustering(shape_table,
                                                       feature_defs,
                                                       shape_id,
                                                       &num_samples);
-  Config.MagicSamples = num_samples;
-  LIST proto_list = ClusterSamples(clusterer, &Config);
+  config.MagicSamples = num_samples;
+  LIST proto_list = ClusterSamples(clusterer, &config);
   CleanUpUnusedData(proto_list);
 
   // Merge protos where reasonable to make more of them significant by
   // representing almost all samples of the class/font.
-  MergeInsignificantProtos(proto_list, class_label, clusterer, &Config);
+  MergeInsignificantProtos(proto_list, class_label, clusterer, &config);
   #ifndef GRAPHICS_DISABLED
   if (strcmp(FLAGS_test_ch.c_str(), class_label) == 0)
     DisplayProtoList(FLAGS_test_ch.c_str(), proto_list);
@@ -147,6 +154,30 @@ static LIST ClusterOneConfig(int shape_id, const char* class_label,
                                          false,
                                          clusterer->SampleSize);
   FreeClusterer(clusterer);
+  return proto_list;
+}
+
+// The configs to cluster, with the protos found for each of them.
+struct ConfigClusteringJob {
+  const ShapeTable* shape_table;
+  MasterTrainer* trainer;
+  GenericVector<const char*> class_labels;
+  GenericVector<LIST> proto_lists;
+};
+
+// Clusters config shape_id of job. Only writes the results of shape_id.
+static void ClusterConfigOfJob(ConfigClusteringJob* job, int shape_id) {
+  job->proto_lists[shape_id] = ClusterOneConfig(shape_id,
+                                                job->class_labels[shape_id],
+                                                *job->shape_table,
+                                                job->trainer);
+}
+
+// Helper to add the protos of a config, from ClusterOneConfig, to its class,
+// merging them with the existing protos where they are close. Frees
+// proto_list.
+static LIST AddProtosToClass(int shape_id, const char* class_label,
+                             LIST proto_list, LIST mf_classes) {
   MERGE_CLASS merge_class = FindClass(mf_classes, class_label);
   if (merge_class == NULL) {
     merge_class = NewLabeledClass(class_label);
@@ -278,7 +309,9 @@ int main (int argc, char **argv) {
 
   // Now train each config separately.
   int num_configs = shape_table->NumShapes();
-  LIST mf_classes = NIL_LIST;
+  ConfigClusteringJob job;
+  job.shape_table = shape_table;
+  job.trainer = trainer;
   for (int s = 0; s < num_configs; ++s) {
     int unichar_id, font_id;
     if (unicharset == &shape_set) {
@@ -288,9 +321,25 @@ int main (int argc, char **argv) {
       // Get the real unichar_id from the shape table/unicharset.
       shape_table->GetFirstUnicharAndFont(s, &unichar_id, &font_id);
     }
-    const char* class_label = unicharset->id_to_unichar(unichar_id);
-    mf_classes = ClusterOneConfig(s, class_label, mf_classes, *shape_table,
-                                  trainer);
+    job.class_labels.push_back(unicharset->id_to_unichar(unichar_id));
+  }
+  job.proto_lists.init_to_size(num_configs, NIL_LIST);
+  // The configs are independent, so they can be clustered in parallel, and
+  // are added to their classes in order afterwards.
+  if (Config.NumThreads > 1) {
+    tesseract::ThreadPool pool(Config.NumThreads);
+    TessCallback1<int>* cluster =
+        NewPermanentTessCallback(&ClusterConfigOfJob, &job);
+    pool.ParallelFor(num_configs, cluster);
+    delete cluster;
+  } else {
+    for (int s = 0; s < num_configs; ++s)
+      ClusterConfigOfJob(&job, s);
+  }
+  LIST mf_classes = NIL_LIST;
+  for (int s = 0; s < num_configs; ++s) {
+    mf_classes = AddProtosToClass(s, job.class_labels[s], job.proto_lists[s],
+                                  mf_classes);
   }
   STRING inttemp_file = file_prefix;
   inttemp_file += "inttemp";
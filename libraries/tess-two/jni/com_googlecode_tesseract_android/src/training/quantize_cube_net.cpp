@@ -0,0 +1,54 @@
+///////////////////////////////////////////////////////////////////////
+// File:        quantize_cube_net.cpp
+// Description: Program to convert a cube neural net to int8 weights.
+//
+// (C) Copyright 2017, Google Inc.
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+
+#include "neural_net.h"
+#include "tprintf.h"
+
+int main(int argc, char *argv[]) {
+  if (argc != 3) {
+    tprintf("Convert a cube neural net, such as a .cube.nn or\n"
+            ".tesseract_cube.nn file, to int8 weights.\n");
+    tprintf("Usage: %s <input net> <output net>\n", argv[0]);
+    return 1;
+  }
+  tesseract::NeuralNet *net = tesseract::NeuralNet::FromFile(argv[1]);
+  if (net == NULL) {
+    tprintf("Error loading net from %s.\n", argv[1]);
+    return 1;
+  }
+  if (!net->Quantize()) {
+    tprintf("%s is not made of fully connected layers, so can not be "
+            "quantized.\n", argv[1]);
+    delete net;
+    return 1;
+  }
+  FILE *fp = fopen(argv[2], "wb");
+  if (fp == NULL) {
+    tprintf("Could not open %s for writing.\n", argv[2]);
+    delete net;
+    return 1;
+  }
+  bool written = net->WriteInt8Binary(fp);
+  delete net;
+  if (fclose(fp) != 0 || !written) {
+    tprintf("Error writing %s.\n", argv[2]);
+    return 1;
+  }
+  return 0;
+}
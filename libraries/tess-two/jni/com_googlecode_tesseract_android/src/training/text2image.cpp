@@ -46,6 +46,8 @@
 #include "helpers.h"
 #include "normstrngs.h"
 #include "stringrenderer.h"
+#include "tesscallback.h"
+#include "threadpool.h"
 #include "tlog.h"
 #include "unicharset.h"
 #include "util.h"
@@ -170,6 +172,14 @@ INT_PARAM_FLAG(glyph_resized_size, 0,
 INT_PARAM_FLAG(glyph_num_border_pixels_to_pad, 0,
                "Final_size=glyph_resized_size+2*glyph_num_border_pixels_to_pad");
 
+// Pages have to be laid out one after the other, but the degradation and
+// binarization of a batch of render_threads pages can run in parallel.
+INT_PARAM_FLAG(render_threads, 1,
+               "Number of threads to degrade and binarize the pages with."
+               " Values above 1 give each page its own random noise, so the"
+               " images differ from those of 1 thread, but not from each"
+               " other");
+
 namespace tesseract {
 
 struct SpacingProperties {
@@ -406,12 +416,46 @@ bool MakeIndividualGlyphs(Pix* pix,
     return true;
   }
 }
+
+// A rendered page waiting to be degraded and binarized.
+struct RenderedPage {
+  RenderedPage() : pix(NULL), rotation(0.0f), shared_randomizer(NULL), im(0) {}
+
+  // The rendered image, replaced by the binary result.
+  Pix* pix;
+  // Rotation to apply, in radians clockwise.
+  float rotation;
+  // Randomizer to degrade the page with. When pages are degraded in
+  // parallel, each has its own, otherwise they all share the same one.
+  TRand randomizer;
+  TRand* shared_randomizer;
+  // Index of the page in the output, and the font it was rendered with.
+  int im;
+  string font_used;
+};
+
+// Degrades and binarizes the page with the given index.
+static void DegradeRenderedPage(vector<RenderedPage>* pages, int index) {
+  RenderedPage* page = &(*pages)[index];
+  TRand* randomizer = page->shared_randomizer != NULL
+                          ? page->shared_randomizer : &page->randomizer;
+  if (FLAGS_degrade_image) {
+    page->pix = DegradeImage(page->pix, FLAGS_exposure, randomizer,
+                             FLAGS_rotate_image ? &page->rotation : NULL);
+  }
+  Pix* gray_pix = pixConvertTo8(page->pix, false);
+  pixDestroy(&page->pix);
+  page->pix = pixThresholdToBinary(gray_pix, 128);
+  pixDestroy(&gray_pix);
+}
 }  // namespace tesseract
 
-using tesseract::DegradeImage;
+using tesseract::DegradeRenderedPage;
 using tesseract::ExtractFontProperties;
 using tesseract::File;
 using tesseract::FontUtils;
+using tesseract::RandomRotation;
+using tesseract::RenderedPage;
 using tesseract::SpanUTF8NotWhitespace;
 using tesseract::SpanUTF8Whitespace;
 using tesseract::StringRenderer;
@@ -584,74 +628,109 @@ int main(int argc, char** argv) {
   // The first pass(0) will rotate the images in random directions and
   // the second pass(1) will mirror those rotations.
   int num_pass = FLAGS_bidirectional_rotation ? 2 : 1;
+  // Only the first page is rendered when finding fonts, so there is nothing
+  // to do in parallel.
+  int num_threads = FLAGS_find_fonts ? 1 : MAX(1, FLAGS_render_threads);
+  tesseract::ThreadPool* thread_pool =
+      num_threads > 1 ? new tesseract::ThreadPool(num_threads) : NULL;
+  vector<RenderedPage> pages;
+  TessCallback1<int>* degrade_callback =
+      NewPermanentTessCallback(&DegradeRenderedPage, &pages);
   for (int pass = 0; pass < num_pass; ++pass) {
     int page_num = 0;
     string font_used;
-    for (int offset = 0; offset < strlen(to_render_utf8); ++im, ++page_num) {
-      tlog(1, "Starting page %d\n", im);
-      Pix* pix = NULL;
-      if (FLAGS_find_fonts) {
-        offset += render.RenderAllFontsToImage(FLAGS_min_coverage,
-                                               to_render_utf8 + offset,
-                                               strlen(to_render_utf8 + offset),
-                                               &font_used, &pix);
-      } else {
-        offset += render.RenderToImage(to_render_utf8 + offset,
-                                       strlen(to_render_utf8 + offset), &pix);
-      }
-      if (pix != NULL) {
-        float rotation = 0;
-        if (pass == 1) {
-          // Pass 2, do mirror rotation.
-          rotation = -1 * page_rotation[page_num];
+    bool found_fonts = false;
+    for (int offset = 0; offset < strlen(to_render_utf8) && !found_fonts;) {
+      // Render a batch of pages. Each page starts where the previous one
+      // ended, so this part has to be serial.
+      pages.clear();
+      while (static_cast<int>(pages.size()) < num_threads &&
+             offset < strlen(to_render_utf8)) {
+        tlog(1, "Starting page %d\n", im);
+        Pix* pix = NULL;
+        if (FLAGS_find_fonts) {
+          offset += render.RenderAllFontsToImage(
+              FLAGS_min_coverage, to_render_utf8 + offset,
+              strlen(to_render_utf8 + offset), &font_used, &pix);
+        } else {
+          offset += render.RenderToImage(to_render_utf8 + offset,
+                                         strlen(to_render_utf8 + offset),
+                                         &pix);
         }
-        if (FLAGS_degrade_image) {
-          pix = DegradeImage(pix, FLAGS_exposure, &randomizer,
-                             FLAGS_rotate_image ? &rotation : NULL);
+        if (pix != NULL) {
+          RenderedPage page;
+          page.pix = pix;
+          page.im = im;
+          page.font_used = font_used;
+          if (thread_pool != NULL)
+            page.randomizer.set_seed(randomizer.IntRand());
+          else
+            page.shared_randomizer = &randomizer;
+          if (pass == 1) {
+            // Pass 2, do mirror rotation.
+            page.rotation = -1 * page_rotation[page_num];
+          } else if (FLAGS_degrade_image && FLAGS_rotate_image) {
+            // Pass 1, rotate randomly and store the rotation. It is chosen
+            // here, so the boxes of this page can be rotated to match before
+            // the next page is rendered.
+            page.rotation = RandomRotation(page.shared_randomizer != NULL
+                                           ? page.shared_randomizer
+                                           : &page.randomizer);
+          }
+          render.RotatePageBoxes(page.rotation);
+          if (pass == 0)
+            page_rotation.push_back(page.rotation);
+          pages.push_back(page);
         }
-        render.RotatePageBoxes(rotation);
-
-        if (pass == 0) {
-          // Pass 1, rotate randomly and store the rotation..
-          page_rotation.push_back(rotation);
+        if (FLAGS_find_fonts && offset != 0) {
+          // We just want a list of names, or some sample images so we don't
+          // need to render more than the first page of the text.
+          found_fonts = true;
+          break;
         }
-
-        Pix* gray_pix = pixConvertTo8(pix, false);
-        pixDestroy(&pix);
-        Pix* binary = pixThresholdToBinary(gray_pix, 128);
-        pixDestroy(&gray_pix);
+        ++im;
+        ++page_num;
+      }
+      if (thread_pool != NULL && pages.size() > 1) {
+        thread_pool->ParallelFor(pages.size(), degrade_callback);
+      } else {
+        for (int p = 0; p < pages.size(); ++p)
+          DegradeRenderedPage(&pages, p);
+      }
+      // Write the pages out in order.
+      for (int p = 0; p < pages.size(); ++p) {
+        Pix* binary = pages[p].pix;
+        int page_im = pages[p].im;
         char tiff_name[1024];
         if (FLAGS_find_fonts) {
           if (FLAGS_render_per_font) {
             string fontname_for_file = tesseract::StringReplace(
-                font_used, " ", "_");
+                pages[p].font_used, " ", "_");
             snprintf(tiff_name, 1024, "%s.%s.tif", FLAGS_outputbase.c_str(),
                      fontname_for_file.c_str());
             pixWriteTiff(tiff_name, binary, IFF_TIFF_G4, "w");
-            tprintf("Rendered page %d to file %s\n", im, tiff_name);
+            tprintf("Rendered page %d to file %s\n", page_im, tiff_name);
           } else {
-            font_names.push_back(font_used);
+            font_names.push_back(pages[p].font_used);
           }
         } else {
           snprintf(tiff_name, 1024, "%s.tif", FLAGS_outputbase.c_str());
-          pixWriteTiff(tiff_name, binary, IFF_TIFF_G4, im == 0 ? "w" : "a");
-          tprintf("Rendered page %d to file %s\n", im, tiff_name);
+          pixWriteTiff(tiff_name, binary, IFF_TIFF_G4,
+                       page_im == 0 ? "w" : "a");
+          tprintf("Rendered page %d to file %s\n", page_im, tiff_name);
         }
         // Make individual glyphs
         if (FLAGS_output_individual_glyph_images) {
-          if (!MakeIndividualGlyphs(binary, render.GetBoxes(), im)) {
+          if (!MakeIndividualGlyphs(binary, render.GetBoxes(), page_im)) {
             tprintf("ERROR: Individual glyphs not saved\n");
           }
         }
-        pixDestroy(&binary);
-      }
-      if (FLAGS_find_fonts && offset != 0) {
-        // We just want a list of names, or some sample images so we don't need
-        // to render more than the first page of the text.
-        break;
+        pixDestroy(&pages[p].pix);
       }
     }
   }
+  delete degrade_callback;
+  delete thread_pool;
   if (!FLAGS_find_fonts) {
     string box_name = FLAGS_outputbase.c_str();
     box_name += ".box";
@@ -21,6 +21,7 @@
 // generates the corresponding squished DAWG file.
 
 #include <stdio.h>
+#include <stdlib.h>
 
 #include "classify.h"
 #include "dawg.h"
@@ -33,9 +34,18 @@
 #include "unicharset.h"
 
 int main(int argc, char** argv) {
+  // An optional leading -j <threads> sets the number of threads used to
+  // build the dawg. Drop it from the arguments, keeping the program name.
+  int num_threads = 1;
+  if (argc > 2 && strcmp(argv[1], "-j") == 0) {
+    num_threads = MAX(1, atoi(argv[2]));
+    argv[2] = argv[0];
+    argc -= 2;
+    argv += 2;
+  }
   if (!(argc == 4 || (argc == 5 && strcmp(argv[1], "-t") == 0) ||
       (argc == 6 && strcmp(argv[1], "-r") == 0))) {
-    printf("Usage: %s [-t | -r [reverse policy] ] word_list_file"
+    printf("Usage: %s [-j threads] [-t | -r [reverse policy] ] word_list_file"
            " dawg_file unicharset_file\n", argv[0]);
     return 1;
   }
@@ -69,13 +79,15 @@ int main(int argc, char** argv) {
         tesseract::DAWG_TYPE_WORD, "", SYSTEM_DAWG_PERM,
         unicharset.size(), classify->getDict().dawg_debug_level);
     tprintf("Reading word list from '%s'\n", wordlist_filename);
-    if (!trie.read_and_add_word_list(wordlist_filename, unicharset,
-                                     reverse_policy)) {
-      tprintf("Failed to add word list from '%s'\n", wordlist_filename);
+    GenericVector<STRING> word_list;
+    if (!trie.read_word_list(wordlist_filename, unicharset, reverse_policy,
+                             &word_list)) {
+      tprintf("Failed to read word list from '%s'\n", wordlist_filename);
       exit(1);
     }
-    tprintf("Reducing Trie to SquishedDawg\n");
-    tesseract::SquishedDawg *dawg = trie.trie_to_dawg();
+    tprintf("Building SquishedDawg from %d words\n", word_list.size());
+    tesseract::SquishedDawg *dawg =
+        trie.words_to_dawg(word_list, unicharset, num_threads);
     if (dawg != NULL && dawg->NumEdges() > 0) {
       tprintf("Writing squished DAWG to '%s'\n", dawg_filename);
       dawg->write_squished_dawg(dawg_filename);
@@ -40,6 +40,7 @@
 #include "freelist.h"
 #include "globals.h"
 #include "render.h"
+#include "pagecounters.h"
 #include "pageres.h"
 #include "seam.h"
 #include "stopper.h"
@@ -170,6 +171,7 @@ namespace tesseract {
 SEAM *Wordrec::attempt_blob_chop(TWERD *word, TBLOB *blob, inT32 blob_number,
                                  bool italic_blob,
                                  const GenericVector<SEAM*>& seams) {
+  PageCounts::Count(COUNTER_CHOPS);
   if (repair_unchopped_blobs)
     preserve_outline_tree (blob->outlines);
   TBLOB *other_blob = TBLOB::ShallowCopy(*blob);       /* Make new blob */
@@ -398,11 +400,20 @@ void Wordrec::chop_word_main(WERD_RES *word) {
   }
   if (word->ratings->get(0, 0) == NULL) {
     // Run initial classification.
-    for (int b = 0; b < num_blobs; ++b) {
-      BLOB_CHOICE_LIST* choices = classify_piece(word->seam_array, b, b,
-                                                 "Initial:", word->chopped_word,
-                                                 word->blamer_bundle);
-      word->ratings->put(b, b, choices);
+    if (!kBlamerEnabled || word->blamer_bundle == NULL) {
+      GenericVector<BLOB_CHOICE_LIST*> choices;
+      classify_single_pieces(0, num_blobs - 1, "Initial:", word->chopped_word,
+                             &choices);
+      for (int b = 0; b < num_blobs; ++b)
+        word->ratings->put(b, b, choices[b]);
+    } else {
+      for (int b = 0; b < num_blobs; ++b) {
+        BLOB_CHOICE_LIST* choices = classify_piece(word->seam_array, b, b,
+                                                   "Initial:",
+                                                   word->chopped_word,
+                                                   word->blamer_bundle);
+        word->ratings->put(b, b, choices);
+      }
     }
   } else {
     // Blobs have been pre-classified. Set matrix cell for all blob choices
@@ -436,7 +447,8 @@ void Wordrec::chop_word_main(WERD_RES *word) {
     getDict().reset_hyphen_vars(true);
   }
 
-  if (word->blamer_bundle != NULL && this->fill_lattice_ != NULL) {
+  if (kBlamerEnabled && word->blamer_bundle != NULL &&
+      this->fill_lattice_ != NULL) {
     CallFillLattice(*word->ratings, word->best_choices,
                     *word->uch_set, word->blamer_bundle);
   }
@@ -464,7 +476,7 @@ void Wordrec::improve_by_chopping(float rating_cert_scale,
   do {  // improvement loop.
     // Make a simple vector of BLOB_CHOICEs to make it easy to pick which
     // one to chop.
-    GenericVector<BLOB_CHOICE*> blob_choices;
+    SmallVector<BLOB_CHOICE*, 32> blob_choices;
     int num_blobs = word->ratings->dimension();
     for (int i = 0; i < num_blobs; ++i) {
       BLOB_CHOICE_LIST* choices = word->ratings->get(i, i);
@@ -495,14 +507,23 @@ void Wordrec::improve_by_chopping(float rating_cert_scale,
 
     // Classify the two newly created blobs using ProcessSegSearchPainPoint,
     // as that updates the pending correctly and adds new pain points.
+    // Without a blamer, both are classified first, so that they can run in
+    // parallel.
+    SmallVector<BLOB_CHOICE_LIST*, 2> halves;
+    if (!kBlamerEnabled || blamer_bundle == NULL) {
+      classify_single_pieces(blob_number, blob_number + 1, "Chop",
+                             word->chopped_word, &halves);
+    } else {
+      halves.init_to_size(2, NULL);
+    }
     MATRIX_COORD pain_point(blob_number, blob_number);
     ProcessSegSearchPainPoint(0.0f, pain_point, "Chop1", pending, word,
-                              pain_points, blamer_bundle);
+                              pain_points, blamer_bundle, halves[0]);
     pain_point.col = blob_number + 1;
     pain_point.row = blob_number + 1;
     ProcessSegSearchPainPoint(0.0f, pain_point, "Chop2", pending, word,
-                              pain_points, blamer_bundle);
-    if (language_model_->language_model_ngram_on) {
+                              pain_points, blamer_bundle, halves[1]);
+    if (language_model_->NgramOn()) {
       // N-gram evaluation depends on the number of blobs in a chunk, so we
       // have to re-evaluate everything in the word.
       ResetNGramSearch(word, best_choice_bundle, pending);
@@ -512,14 +533,15 @@ void Wordrec::improve_by_chopping(float rating_cert_scale,
     UpdateSegSearchNodes(rating_cert_scale, blob_number, pending,
                          word, pain_points, best_choice_bundle, blamer_bundle);
   } while (!language_model_->AcceptableChoiceFound() &&
-           word->ratings->dimension() < kMaxNumChunks);
+           word->ratings->dimension() < kMaxNumChunks &&
+           !SegSearchOutOfTime());
 
   // If after running only the chopper best_choice is incorrect and no blame
   // has been yet set, blame the classifier if best_choice is classifier's
   // top choice and is a dictionary word (i.e. language model could not have
   // helped). Otherwise blame the tradeoff between the classifier and
   // the old language model (permuters).
-  if (word->blamer_bundle != NULL &&
+  if (kBlamerEnabled && word->blamer_bundle != NULL &&
       word->blamer_bundle->incorrect_result_reason() == IRR_CORRECT &&
       !word->blamer_bundle->ChoiceIsCorrect(word->best_choice)) {
     bool valid_permuter = word->best_choice != NULL &&
@@ -41,6 +41,8 @@ double log2(double n) {
 namespace tesseract {
 
 const float LanguageModel::kMaxAvgNgramCost = 25.0f;
+// Number of entries of the ngram probability cache, a power of 2.
+const int kNgramCacheSize = 1024;
 
 LanguageModel::LanguageModel(const UnicityTable<FontInfo> *fontinfo_table,
                              Dict *dict)
@@ -49,6 +51,10 @@ LanguageModel::LanguageModel(const UnicityTable<FontInfo> *fontinfo_table,
     BOOL_INIT_MEMBER(language_model_ngram_on, false,
                      "Turn on/off the use of character ngram model",
                      dict->getCCUtil()->params()),
+    BOOL_MEMBER(language_model_ngram_table_on, true,
+                "Use the character ngram model whenever a compiled ngram"
+                " table is loaded",
+                dict->getCCUtil()->params()),
     INT_MEMBER(language_model_ngram_order, 8,
                "Maximum order of the character ngram model",
                dict->getCCUtil()->params()),
@@ -119,6 +125,9 @@ LanguageModel::LanguageModel(const UnicityTable<FontInfo> *fontinfo_table,
     BOOL_INIT_MEMBER(language_model_use_sigmoidal_certainty, false,
                      "Use sigmoidal score for certainty",
                      dict->getCCUtil()->params()),
+    BOOL_MEMBER(language_model_pool_states, true,
+                "Recycle the memory of the segmentation search state",
+                dict->getCCUtil()->params()),
   fontinfo_table_(fontinfo_table), dict_(dict),
   fixed_pitch_(false), max_char_wh_ratio_(0.0),
   acceptable_choice_found_(false) {
@@ -126,13 +135,22 @@ LanguageModel::LanguageModel(const UnicityTable<FontInfo> *fontinfo_table,
   dawg_args_ = new DawgArgs(NULL, new DawgPositionVector(), NO_PERM);
   very_beginning_active_dawgs_ = new DawgPositionVector();
   beginning_active_dawgs_ = new DawgPositionVector();
+  dawg_scratch_ = dict_->AcquireDawgScratch();
+  ngram_cache_.init_to_size(kNgramCacheSize, NgramCacheEntry());
+  ngram_cache_stamp_ = 0;
 }
 
 LanguageModel::~LanguageModel() {
+  if (tdebug_on(language_model_debug_level, 0)) {
+    tprintf("LM state pool: %.0f allocations, %.0f from the heap\n",
+            static_cast<double>(state_pool_.num_allocs()),
+            static_cast<double>(state_pool_.num_heap_allocs()));
+  }
   delete very_beginning_active_dawgs_;
   delete beginning_active_dawgs_;
   delete dawg_args_->updated_dawgs;
   delete dawg_args_;
+  dict_->ReleaseDawgScratch(dawg_scratch_);
 }
 
 void LanguageModel::InitForWord(const WERD_CHOICE *prev_word,
@@ -143,6 +161,8 @@ void LanguageModel::InitForWord(const WERD_CHOICE *prev_word,
   rating_cert_scale_ = rating_cert_scale;
   acceptable_choice_found_ = false;
   correct_segmentation_explored_ = false;
+  state_pool_.set_enabled(language_model_pool_states);
+  ++ngram_cache_stamp_;
 
   // Initialize vectors with beginning DawgInfos.
   very_beginning_active_dawgs_->clear();
@@ -152,7 +172,7 @@ void LanguageModel::InitForWord(const WERD_CHOICE *prev_word,
 
   // Fill prev_word_str_ with the last language_model_ngram_order
   // unichars from prev_word.
-  if (language_model_ngram_on) {
+  if (NgramOn()) {
     if (prev_word != NULL && prev_word->unichar_string() != NULL) {
       prev_word_str_ = prev_word->unichar_string();
       if (language_model_ngram_space_delimited_language) prev_word_str_ += ' ';
@@ -261,10 +281,10 @@ bool LanguageModel::UpdateState(
     WERD_RES *word_res,
     BestChoiceBundle *best_choice_bundle,
     BlamerBundle *blamer_bundle) {
-  if (language_model_debug_level > 0) {
+  if (tdebug_on(language_model_debug_level, 0)) {
     tprintf("\nUpdateState: col=%d row=%d %s",
             curr_col, curr_row, just_classified ? "just_classified" : "");
-    if (language_model_debug_level > 5)
+    if (tdebug_on(language_model_debug_level, 5))
       tprintf("(parent=%p)\n", parent_node);
     else
       tprintf("\n");
@@ -272,7 +292,7 @@ bool LanguageModel::UpdateState(
   // Initialize helper variables.
   bool word_end = (curr_row+1 >= word_res->ratings->dimension());
   bool new_changed = false;
-  float denom = (language_model_ngram_on) ? ComputeDenom(curr_list) : 1.0f;
+  float denom = NgramOn() ? ComputeDenom(curr_list) : 1.0f;
   const UNICHARSET& unicharset = dict_->getUnicharset();
   BLOB_CHOICE *first_lower = NULL;
   BLOB_CHOICE *first_upper = NULL;
@@ -281,7 +301,7 @@ bool LanguageModel::UpdateState(
   if (parent_node != NULL) {
     int result = SetTopParentLowerUpperDigit(parent_node);
     if (result < 0) {
-      if (language_model_debug_level > 0)
+      if (tdebug_on(language_model_debug_level, 0))
         tprintf("No parents found to process\n");
       return false;
     }
@@ -292,7 +312,7 @@ bool LanguageModel::UpdateState(
                              &first_digit))
     has_alnum_mix = false;;
   ScanParentsForCaseMix(unicharset, parent_node);
-  if (language_model_debug_level > 3 && parent_node != NULL) {
+  if (tdebug_on(language_model_debug_level, 3) && parent_node != NULL) {
     parent_node->Print("Parent viterbi list");
   }
   LanguageModelState *curr_state = best_choice_bundle->beam[curr_row];
@@ -354,7 +374,7 @@ bool LanguageModel::UpdateState(
         // examined language_model_viterbi_list_max_num_prunable of those.
         if (PrunablePath(*parent_vse) &&
             (++vit_counter > language_model_viterbi_list_max_num_prunable ||
-             (language_model_ngram_on && parent_vse->ngram_info->pruned))) {
+             (NgramOn() && parent_vse->ngram_info->pruned))) {
           continue;
         }
         // If the parent has no alnum choice, (ie choice is the first in a
@@ -509,7 +529,7 @@ ViterbiStateEntry* LanguageModel::GetNextParentVSE(
     // Only consider the parent if it has been updated or
     // if the current ratings cell has just been classified.
     if (!just_classified && !parent_vse->updated) continue;
-    if (language_model_debug_level > 2)
+    if (tdebug_on(language_model_debug_level, 2))
       parent_vse->Print("Considering");
     // If the parent is non-alnum, then upper counts as lower.
     *top_choice_flags = blob_choice_flags;
@@ -539,7 +559,7 @@ ViterbiStateEntry* LanguageModel::GetNextParentVSE(
     if (parent_vse->competing_vse != NULL) {
       const BLOB_CHOICE* competing_b = parent_vse->competing_vse->curr_b;
       UNICHAR_ID other_id = competing_b->unichar_id();
-      if (language_model_debug_level >= 5) {
+      if (tdebug_on(language_model_debug_level, 4)) {
         tprintf("Parent %s has competition %s\n",
                 unicharset.id_to_unichar(parent_id),
                 unicharset.id_to_unichar(other_id));
@@ -548,9 +568,9 @@ ViterbiStateEntry* LanguageModel::GetNextParentVSE(
         // If other_id matches bc wrt position and size, and parent_id, doesn't,
         // don't bind to the current parent.
         if (bc->PosAndSizeAgree(*competing_b, word_res->x_height,
-                                language_model_debug_level >= 5) &&
+                                tdebug_on(language_model_debug_level, 4)) &&
             !bc->PosAndSizeAgree(*parent_b, word_res->x_height,
-                                language_model_debug_level >= 5))
+                                tdebug_on(language_model_debug_level, 4)))
           continue;  // Competing blobchoice has a better vertical match.
       }
     }
@@ -573,12 +593,12 @@ bool LanguageModel::AddViterbiStateEntry(
     BestChoiceBundle *best_choice_bundle,
     BlamerBundle *blamer_bundle) {
   ViterbiStateEntry_IT vit;
-  if (language_model_debug_level > 1) {
+  if (tdebug_on(language_model_debug_level, 1)) {
     tprintf("AddViterbiStateEntry for unichar %s rating=%.4f"
             " certainty=%.4f top_choice_flags=0x%x",
             dict_->getUnicharset().id_to_unichar(b->unichar_id()),
             b->rating(), b->certainty(), top_choice_flags);
-    if (language_model_debug_level > 5)
+    if (tdebug_on(language_model_debug_level, 5))
       tprintf(" parent_vse=%p\n", parent_vse);
     else
       tprintf("\n");
@@ -587,7 +607,7 @@ bool LanguageModel::AddViterbiStateEntry(
   if (curr_state != NULL &&
       curr_state->viterbi_state_entries_length >=
           language_model_viterbi_list_max_size) {
-    if (language_model_debug_level > 1) {
+    if (tdebug_on(language_model_debug_level, 1)) {
       tprintf("AddViterbiStateEntry: viterbi list is full!\n");
     }
     return false;
@@ -601,7 +621,7 @@ bool LanguageModel::AddViterbiStateEntry(
       AssociateUtils::ComputeOutlineLength(rating_cert_scale_, *b);
   // Invoke Ngram language model component.
   LanguageModelNgramInfo *ngram_info = NULL;
-  if (language_model_ngram_on) {
+  if (NgramOn()) {
     ngram_info = GenerateNgramInfo(
         dict_->getUnicharset().id_to_unichar(b->unichar_id()), b->certainty(),
         denom, curr_col, curr_row, outline_length, parent_vse);
@@ -612,7 +632,7 @@ bool LanguageModel::AddViterbiStateEntry(
   // Quick escape if not liked by the language model, can't be consistent
   // xheight, and not top choice.
   if (!liked_by_language_model && top_choice_flags == 0) {
-    if (language_model_debug_level > 1) {
+    if (tdebug_on(language_model_debug_level, 1)) {
       tprintf("Language model components very early pruned this entry\n");
     }
     delete ngram_info;
@@ -635,7 +655,7 @@ bool LanguageModel::AddViterbiStateEntry(
   // Quick escape if not liked by the language model, not consistent xheight,
   // and not top choice.
   if (!liked_by_language_model && top_choice_flags == 0) {
-    if (language_model_debug_level > 1) {
+    if (tdebug_on(language_model_debug_level, 1)) {
       tprintf("Language model components early pruned this entry\n");
     }
     delete ngram_info;
@@ -660,13 +680,13 @@ bool LanguageModel::AddViterbiStateEntry(
   }
 
   // Create the new ViterbiStateEntry compute the adjusted cost of the path.
-  ViterbiStateEntry *new_vse = new ViterbiStateEntry(
+  ViterbiStateEntry *new_vse = new (&state_pool_) ViterbiStateEntry(
       parent_vse, b, 0.0, outline_length,
       consistency_info, associate_stats, top_choice_flags, dawg_info,
-      ngram_info, (language_model_debug_level > 0) ?
+      ngram_info, tdebug_on(language_model_debug_level, 0) ?
           dict_->getUnicharset().id_to_unichar(b->unichar_id()) : NULL);
   new_vse->cost = ComputeAdjustedPathCost(new_vse);
-  if (language_model_debug_level >= 3)
+  if (tdebug_on(language_model_debug_level, 2))
     tprintf("Adjusted cost = %g\n", new_vse->cost);
 
   // Invoke Top Choice language model component to make the final adjustments
@@ -682,7 +702,7 @@ bool LanguageModel::AddViterbiStateEntry(
     keep = false;
   }
   if (!keep) {
-    if (language_model_debug_level > 1) {
+    if (tdebug_on(language_model_debug_level, 1)) {
       tprintf("Language model components did not like this entry\n");
     }
     delete new_vse;
@@ -696,7 +716,7 @@ bool LanguageModel::AddViterbiStateEntry(
       (curr_state->viterbi_state_entries_prunable_length >=
        language_model_viterbi_list_max_num_prunable) &&
       new_vse->cost >= curr_state->viterbi_state_entries_prunable_max_cost) {
-    if (language_model_debug_level > 1) {
+    if (tdebug_on(language_model_debug_level, 1)) {
       tprintf("Discarded ViterbiEntry with high cost %g max cost %g\n",
               new_vse->cost,
               curr_state->viterbi_state_entries_prunable_max_cost);
@@ -712,7 +732,7 @@ bool LanguageModel::AddViterbiStateEntry(
     // Discard the entry if UpdateBestChoice() found flaws in it.
     if (new_vse->cost >= WERD_CHOICE::kBadRating &&
         new_vse != best_choice_bundle->best_vse) {
-      if (language_model_debug_level > 1) {
+      if (tdebug_on(language_model_debug_level, 1)) {
         tprintf("Discarded ViterbiEntry with high cost %g\n", new_vse->cost);
       }
       delete new_vse;
@@ -749,7 +769,7 @@ bool LanguageModel::AddViterbiStateEntry(
       // Update curr_state->viterbi_state_entries_prunable_max_cost.
       if (prunable_counter == 0) {
         curr_state->viterbi_state_entries_prunable_max_cost = vit.data()->cost;
-        if (language_model_debug_level > 1) {
+        if (tdebug_on(language_model_debug_level, 1)) {
           tprintf("Set viterbi_state_entries_prunable_max_cost to %g\n",
                   curr_state->viterbi_state_entries_prunable_max_cost);
         }
@@ -759,9 +779,9 @@ bool LanguageModel::AddViterbiStateEntry(
   }
 
   // Print the newly created ViterbiStateEntry.
-  if (language_model_debug_level > 2) {
+  if (tdebug_on(language_model_debug_level, 2)) {
     new_vse->Print("New");
-    if (language_model_debug_level > 5)
+    if (tdebug_on(language_model_debug_level, 5))
       curr_state->Print("Updated viterbi list");
   }
 
@@ -778,7 +798,7 @@ void LanguageModel::GenerateTopChoiceInfo(ViterbiStateEntry *new_vse,
     // a top choice entry with a lower cost.
     new_vse->top_choice_flags &= ~(vit.data()->top_choice_flags);
   }
-  if (language_model_debug_level > 2) {
+  if (tdebug_on(language_model_debug_level, 2)) {
     tprintf("GenerateTopChoiceInfo: top_choice_flags=0x%x\n",
             new_vse->top_choice_flags);
   }
@@ -802,15 +822,15 @@ LanguageModelDawgInfo *LanguageModel::GenerateDawgInfo(
 
   // Deal with hyphenated words.
   if (word_end && dict_->has_hyphen_end(b.unichar_id(), curr_col == 0)) {
-    if (language_model_debug_level > 0) tprintf("Hyphenated word found\n");
-    return new LanguageModelDawgInfo(dawg_args_->active_dawgs,
-                                     COMPOUND_PERM);
+    tdebug(language_model_debug_level, 0, "Hyphenated word found\n");
+    return new (&state_pool_) LanguageModelDawgInfo(
+        dawg_args_->active_dawgs, COMPOUND_PERM, dawg_scratch_);
   }
 
   // Deal with compound words.
   if (dict_->compound_marker(b.unichar_id()) &&
       (parent_vse == NULL || parent_vse->dawg_info->permuter != NUMBER_PERM)) {
-    if (language_model_debug_level > 0) tprintf("Found compound marker\n");
+    tdebug(language_model_debug_level, 0, "Found compound marker\n");
     // Do not allow compound operators at the beginning and end of the word.
     // Do not allow more than one compound operator per word.
     // Do not allow compounding of words with lengths shorter than
@@ -835,8 +855,9 @@ LanguageModelDawgInfo *LanguageModel::GenerateDawgInfo(
     }
     if (!has_word_ending) return NULL;
 
-    if (language_model_debug_level > 0) tprintf("Compound word found\n");
-    return new LanguageModelDawgInfo(beginning_active_dawgs_, COMPOUND_PERM);
+    tdebug(language_model_debug_level, 0, "Compound word found\n");
+    return new (&state_pool_) LanguageModelDawgInfo(
+        beginning_active_dawgs_, COMPOUND_PERM, dawg_scratch_);
   }  // done dealing with compound words
 
   LanguageModelDawgInfo *dawg_info = NULL;
@@ -846,11 +867,11 @@ LanguageModelDawgInfo *LanguageModel::GenerateDawgInfo(
   // like don't.
   const GenericVector<UNICHAR_ID>& normed_ids =
       dict_->getUnicharset().normed_ids(b.unichar_id());
-  DawgPositionVector tmp_active_dawgs;
+  DawgPositionVector &tmp_active_dawgs = dawg_scratch_->part_active_dawgs;
   for (int i = 0; i < normed_ids.size(); ++i) {
-    if (language_model_debug_level > 2)
-      tprintf("Test Letter OK for unichar %d, normed %d\n",
-              b.unichar_id(), normed_ids[i]);
+    tdebug(language_model_debug_level, 2,
+           "Test Letter OK for unichar %d, normed %d\n",
+           b.unichar_id(), normed_ids[i]);
     dict_->LetterIsOkay(dawg_args_, normed_ids[i],
                         word_end && i == normed_ids.size() - 1);
     if (dawg_args_->permuter == NO_PERM) {
@@ -859,15 +880,15 @@ LanguageModelDawgInfo *LanguageModel::GenerateDawgInfo(
       tmp_active_dawgs = *dawg_args_->updated_dawgs;
       dawg_args_->active_dawgs = &tmp_active_dawgs;
     }
-    if (language_model_debug_level > 2)
-      tprintf("Letter was OK for unichar %d, normed %d\n",
-              b.unichar_id(), normed_ids[i]);
+    tdebug(language_model_debug_level, 2,
+           "Letter was OK for unichar %d, normed %d\n",
+           b.unichar_id(), normed_ids[i]);
   }
   dawg_args_->active_dawgs = NULL;
   if (dawg_args_->permuter != NO_PERM) {
-    dawg_info = new LanguageModelDawgInfo(dawg_args_->updated_dawgs,
-                                          dawg_args_->permuter);
-  } else if (language_model_debug_level > 3) {
+    dawg_info = new (&state_pool_) LanguageModelDawgInfo(
+        dawg_args_->updated_dawgs, dawg_args_->permuter, dawg_scratch_);
+  } else if (tdebug_on(language_model_debug_level, 3)) {
     tprintf("Letter %s not OK!\n",
             dict_->getUnicharset().id_to_unichar(b.unichar_id()));
   }
@@ -923,9 +944,10 @@ LanguageModelNgramInfo *LanguageModel::GenerateNgramInfo(
   if (parent_vse != NULL && parent_vse->ngram_info->pruned) pruned = true;
 
   // Construct and return the new LanguageModelNgramInfo.
-  LanguageModelNgramInfo *ngram_info = new LanguageModelNgramInfo(
-      pcontext_ptr, pcontext_unichar_step_len, pruned, ngram_cost,
-      ngram_and_classifier_cost);
+  LanguageModelNgramInfo *ngram_info =
+      new (&state_pool_) LanguageModelNgramInfo(
+          pcontext_ptr, pcontext_unichar_step_len, pruned, ngram_cost,
+          ngram_and_classifier_cost);
   ngram_info->context += unichar;
   ngram_info->context_unichar_step_len += unichar_step_len;
   assert(ngram_info->context_unichar_step_len <= language_model_ngram_order);
@@ -939,21 +961,55 @@ float LanguageModel::ComputeNgramCost(const char *unichar,
                                       int *unichar_step_len,
                                       bool *found_small_prob,
                                       float *ngram_cost) {
+  float prob = NgramProbability(unichar, context, unichar_step_len);
+  if (prob < language_model_ngram_small_prob) {
+    tdebug(language_model_debug_level, 0, "Found small prob %g\n", prob);
+    *found_small_prob = true;
+    prob = language_model_ngram_small_prob;
+  }
+  *ngram_cost = -1.0*log2(prob);
+  float ngram_and_classifier_cost =
+      -1.0*log2(CertaintyScore(certainty)/denom) +
+      *ngram_cost * language_model_ngram_scale_factor;
+  if (tdebug_on(language_model_debug_level, 1)) {
+    tprintf("-log [ p(%s) * p(%s | %s) ] = -log2(%g*%g) = %g\n", unichar,
+            unichar, context, CertaintyScore(certainty)/denom, prob,
+            ngram_and_classifier_cost);
+  }
+  return ngram_and_classifier_cost;
+}
+
+float LanguageModel::NgramProbability(const char *unichar,
+                                      const char *context,
+                                      int *unichar_step_len) {
+  const char *unichar_end = unichar + strlen(unichar);
+  // The per-character debug output is only printed on a miss.
+  NgramCacheEntry *entry = NULL;
+  uinT64 key = 0;
+  if (!tdebug_on(language_model_debug_level, 1)) {
+    key = CharNgramTable::HashNgram(context, strlen(context),
+                                    unichar, unichar_end - unichar);
+    entry = &ngram_cache_[key & (kNgramCacheSize - 1)];
+    if (entry->stamp == ngram_cache_stamp_ && entry->key == key) {
+      *unichar_step_len += entry->step_len;
+      return entry->prob;
+    }
+  }
   const char *context_ptr = context;
   char *modified_context = NULL;
   char *modified_context_end = NULL;
   const char *unichar_ptr = unichar;
-  const char *unichar_end = unichar_ptr + strlen(unichar_ptr);
   float prob = 0.0f;
+  int step_len = 0;
   int step = 0;
   while (unichar_ptr < unichar_end &&
          (step = UNICHAR::utf8_step(unichar_ptr)) > 0) {
-    if (language_model_debug_level > 1) {
+    if (tdebug_on(language_model_debug_level, 1)) {
       tprintf("prob(%s | %s)=%g\n", unichar_ptr, context_ptr,
               dict_->ProbabilityInContext(context_ptr, -1, unichar_ptr, step));
     }
     prob += dict_->ProbabilityInContext(context_ptr, -1, unichar_ptr, step);
-    ++(*unichar_step_len);
+    ++step_len;
     if (language_model_ngram_use_only_first_uft8_step) break;
     unichar_ptr += step;
     // If there are multiple UTF8 characters present in unichar, context is
@@ -973,23 +1029,16 @@ float LanguageModel::ComputeNgramCost(const char *unichar,
       *modified_context_end = '\0';
     }
   }
-  prob /= static_cast<float>(*unichar_step_len);  // normalize
-  if (prob < language_model_ngram_small_prob) {
-    if (language_model_debug_level > 0) tprintf("Found small prob %g\n", prob);
-    *found_small_prob = true;
-    prob = language_model_ngram_small_prob;
-  }
-  *ngram_cost = -1.0*log2(prob);
-  float ngram_and_classifier_cost =
-      -1.0*log2(CertaintyScore(certainty)/denom) +
-      *ngram_cost * language_model_ngram_scale_factor;
-  if (language_model_debug_level > 1) {
-    tprintf("-log [ p(%s) * p(%s | %s) ] = -log2(%g*%g) = %g\n", unichar,
-            unichar, context_ptr, CertaintyScore(certainty)/denom, prob,
-            ngram_and_classifier_cost);
-  }
   delete[] modified_context;
-  return ngram_and_classifier_cost;
+  prob /= static_cast<float>(step_len);  // normalize
+  *unichar_step_len += step_len;
+  if (entry != NULL) {
+    entry->key = key;
+    entry->prob = prob;
+    entry->step_len = step_len;
+    entry->stamp = ngram_cache_stamp_;
+  }
+  return prob;
 }
 
 float LanguageModel::ComputeDenom(BLOB_CHOICE_LIST *curr_list) {
@@ -1121,7 +1170,7 @@ void LanguageModel::FillConsistencyInfo(
                 parent_b->fontinfo_id2() == b->fontinfo_id2()) {
       fontinfo_id = b->fontinfo_id2();
     }
-    if(language_model_debug_level > 1) {
+    if (tdebug_on(language_model_debug_level, 1)) {
       tprintf("pfont %s pfont %s font %s font2 %s common %s(%d)\n",
               (parent_b->fontinfo_id() >= 0) ?
                   fontinfo_table_->get(parent_b->fontinfo_id()).name : "" ,
@@ -1184,7 +1233,7 @@ void LanguageModel::FillConsistencyInfo(
         if (gap_ratio < 0.0f || gap_ratio > 2.0f) {
           consistency_info->num_inconsistent_spaces++;
         }
-        if (language_model_debug_level > 1) {
+        if (tdebug_on(language_model_debug_level, 1)) {
           tprintf("spacing for %s(%d) %s(%d) col %d: expected %g actual %g\n",
                   unicharset.id_to_unichar(parent_b->unichar_id()),
                   parent_b->unichar_id(), unicharset.id_to_unichar(unichar_id),
@@ -1198,12 +1247,18 @@ void LanguageModel::FillConsistencyInfo(
 float LanguageModel::ComputeAdjustedPathCost(ViterbiStateEntry *vse) {
   ASSERT_HOST(vse != NULL);
   if (params_model_.Initialized()) {
-    float features[PTRAIN_NUM_FEATURE_TYPES];
-    ExtractFeaturesFromPath(*vse, features);
-    float cost = params_model_.ComputeCost(features);
-    if (language_model_debug_level > 3) {
+    // Most of the features are zero, so only the rest are scored.
+    int feature_ids[kMaxPathFeatures];
+    float values[kMaxPathFeatures];
+    int num_features = ExtractSparseFeaturesFromPath(*vse, feature_ids,
+                                                     values);
+    float cost = params_model_.ComputeSparseCost(feature_ids, values,
+                                                 num_features);
+    if (tdebug_on(language_model_debug_level, 3)) {
       tprintf("ComputeAdjustedPathCost %g ParamsModel features:\n", cost);
-      if (language_model_debug_level >= 5) {
+      if (tdebug_on(language_model_debug_level, 4)) {
+        float features[PTRAIN_NUM_FEATURE_TYPES];
+        ExtractFeaturesFromPath(*vse, features);
         for (int f = 0; f < PTRAIN_NUM_FEATURE_TYPES; ++f) {
           tprintf("%s=%g\n", kParamsTrainingFeatureTypeName[f], features[f]);
         }
@@ -1226,7 +1281,7 @@ float LanguageModel::ComputeAdjustedPathCost(ViterbiStateEntry *vse) {
       adjustment += vse->associate_stats.shape_cost /
           static_cast<float>(vse->length);
     }
-    if (language_model_ngram_on) {
+    if (NgramOn()) {
       ASSERT_HOST(vse->ngram_info != NULL);
       return vse->ngram_info->ngram_and_classifier_cost * adjustment;
     } else {
@@ -1247,23 +1302,23 @@ void LanguageModel::UpdateBestChoice(
   WERD_CHOICE *word = ConstructWord(vse, word_res, &best_choice_bundle->fixpt,
                                     blamer_bundle, &truth_path);
   ASSERT_HOST(word != NULL);
-  if (dict_->stopper_debug_level >= 1) {
+  if (tdebug_on(dict_->stopper_debug_level, 0)) {
     STRING word_str;
     word->string_and_lengths(&word_str, NULL);
     vse->Print(word_str.string());
   }
-  if (language_model_debug_level > 0) {
+  if (tdebug_on(language_model_debug_level, 0)) {
     word->print("UpdateBestChoice() constructed word");
   }
   // Record features from the current path if necessary.
   ParamsTrainingHypothesis curr_hyp;
-  if (blamer_bundle != NULL) {
+  if (kBlamerEnabled && blamer_bundle != NULL) {
     if (vse->dawg_info != NULL) vse->dawg_info->permuter =
         static_cast<PermuterType>(word->permuter());
     ExtractFeaturesFromPath(*vse, curr_hyp.features);
     word->string_and_lengths(&(curr_hyp.str), NULL);
     curr_hyp.cost = vse->cost;  // record cost for error rate computations
-    if (language_model_debug_level > 0) {
+    if (tdebug_on(language_model_debug_level, 0)) {
       tprintf("Raw features extracted from %s (cost=%g) [ ",
               curr_hyp.str.string(), curr_hyp.cost);
       for (int deb_i = 0; deb_i < PTRAIN_NUM_FEATURE_TYPES; ++deb_i) {
@@ -1276,7 +1331,8 @@ void LanguageModel::UpdateBestChoice(
     if (truth_path)
       blamer_bundle->UpdateBestRating(word->rating());
   }
-  if (blamer_bundle != NULL && blamer_bundle->GuidedSegsearchStillGoing()) {
+  if (kBlamerEnabled && blamer_bundle != NULL &&
+      blamer_bundle->GuidedSegsearchStillGoing()) {
     // The word was constructed solely for blamer_bundle->AddHypothesis, so
     // we no longer need it.
     delete word;
@@ -1287,8 +1343,8 @@ void LanguageModel::UpdateBestChoice(
   // Update and log new raw_choice if needed.
   if (word_res->raw_choice == NULL ||
       word->rating() < word_res->raw_choice->rating()) {
-    if (word_res->LogNewRawChoice(word) && language_model_debug_level > 0)
-      tprintf("Updated raw choice\n");
+    if (word_res->LogNewRawChoice(word))
+      tdebug(language_model_debug_level, 0, "Updated raw choice\n");
   }
   // Set the modified rating for best choice to vse->cost and log best choice.
   word->set_rating(vse->cost);
@@ -1298,10 +1354,11 @@ void LanguageModel::UpdateBestChoice(
   // Note: the rating of the word is not adjusted.
   dict_->adjust_word(word, vse->dawg_info == NULL,
                      vse->consistency_info.xht_decision, 0.0,
-                     false, language_model_debug_level > 0);
+                     false, tdebug_on(language_model_debug_level, 0));
   // Hand ownership of the word over to the word_res.
   if (!word_res->LogNewCookedChoice(dict_->tessedit_truncate_wordchoice_log,
-                                    dict_->stopper_debug_level >= 1, word)) {
+                                    tdebug_on(dict_->stopper_debug_level, 0),
+                                    word)) {
     // The word was so bad that it was deleted.
     return;
   }
@@ -1314,7 +1371,7 @@ void LanguageModel::UpdateBestChoice(
     // Update best_choice_bundle.
     best_choice_bundle->updated = true;
     best_choice_bundle->best_vse = vse;
-    if (language_model_debug_level > 0) {
+    if (tdebug_on(language_model_debug_level, 0)) {
       tprintf("Updated best choice\n");
       word->print_state("New state ");
     }
@@ -1327,7 +1384,7 @@ void LanguageModel::UpdateBestChoice(
       }
     }
 
-    if (blamer_bundle != NULL) {
+    if (kBlamerEnabled && blamer_bundle != NULL) {
       blamer_bundle->set_best_choice_is_dict_and_top_choice(
           vse->dawg_info != NULL && vse->top_choice_flags);
     }
@@ -1340,50 +1397,68 @@ void LanguageModel::UpdateBestChoice(
 void LanguageModel::ExtractFeaturesFromPath(
     const ViterbiStateEntry &vse, float features[]) {
   memset(features, 0, sizeof(float) * PTRAIN_NUM_FEATURE_TYPES);
+  int feature_ids[kMaxPathFeatures];
+  float values[kMaxPathFeatures];
+  int num_features = ExtractSparseFeaturesFromPath(vse, feature_ids, values);
+  for (int i = 0; i < num_features; ++i)
+    features[feature_ids[i]] = values[i];
+}
+
+int LanguageModel::ExtractSparseFeaturesFromPath(
+    const ViterbiStateEntry &vse, int feature_ids[], float values[]) {
+  int n = 0;
   // Record dictionary match info.
   int len = vse.length <= kMaxSmallWordUnichars ? 0 :
       vse.length <= kMaxMediumWordUnichars ? 1 : 2;
   if (vse.dawg_info != NULL) {
     int permuter = vse.dawg_info->permuter;
+    int dict_feature = -1;
     if (permuter == NUMBER_PERM || permuter == USER_PATTERN_PERM) {
       if (vse.consistency_info.num_digits == vse.length) {
-        features[PTRAIN_DIGITS_SHORT+len] = 1.0;
+        dict_feature = PTRAIN_DIGITS_SHORT + len;
       } else {
-        features[PTRAIN_NUM_SHORT+len] = 1.0;
+        dict_feature = PTRAIN_NUM_SHORT + len;
       }
     } else if (permuter == DOC_DAWG_PERM) {
-      features[PTRAIN_DOC_SHORT+len] = 1.0;
+      dict_feature = PTRAIN_DOC_SHORT + len;
     } else if (permuter == SYSTEM_DAWG_PERM || permuter == USER_DAWG_PERM ||
         permuter == COMPOUND_PERM) {
-      features[PTRAIN_DICT_SHORT+len] = 1.0;
+      dict_feature = PTRAIN_DICT_SHORT + len;
     } else if (permuter == FREQ_DAWG_PERM) {
-      features[PTRAIN_FREQ_SHORT+len] = 1.0;
+      dict_feature = PTRAIN_FREQ_SHORT + len;
+    }
+    if (dict_feature >= 0) {
+      feature_ids[n] = dict_feature;
+      values[n++] = 1.0;
     }
   }
   // Record shape cost feature (normalized by path length).
-  features[PTRAIN_SHAPE_COST_PER_CHAR] =
+  feature_ids[n] = PTRAIN_SHAPE_COST_PER_CHAR;
+  values[n++] =
       vse.associate_stats.shape_cost / static_cast<float>(vse.length);
   // Record ngram cost. (normalized by the path length).
-  features[PTRAIN_NGRAM_COST_PER_CHAR] = 0.0;
-  if (vse.ngram_info != NULL) {
-    features[PTRAIN_NGRAM_COST_PER_CHAR] =
-        vse.ngram_info->ngram_cost / static_cast<float>(vse.length);
-  }
+  feature_ids[n] = PTRAIN_NGRAM_COST_PER_CHAR;
+  values[n++] = vse.ngram_info != NULL
+      ? vse.ngram_info->ngram_cost / static_cast<float>(vse.length) : 0.0;
   // Record consistency-related features.
   // Disabled this feature for due to its poor performance.
-  // features[PTRAIN_NUM_BAD_PUNC] = vse.consistency_info.NumInconsistentPunc();
-  features[PTRAIN_NUM_BAD_CASE] = vse.consistency_info.NumInconsistentCase();
-  features[PTRAIN_XHEIGHT_CONSISTENCY] = vse.consistency_info.xht_decision;
-  features[PTRAIN_NUM_BAD_CHAR_TYPE] = vse.dawg_info == NULL ?
+  // PTRAIN_NUM_BAD_PUNC: vse.consistency_info.NumInconsistentPunc().
+  feature_ids[n] = PTRAIN_NUM_BAD_CASE;
+  values[n++] = vse.consistency_info.NumInconsistentCase();
+  feature_ids[n] = PTRAIN_XHEIGHT_CONSISTENCY;
+  values[n++] = vse.consistency_info.xht_decision;
+  feature_ids[n] = PTRAIN_NUM_BAD_CHAR_TYPE;
+  values[n++] = vse.dawg_info == NULL ?
       vse.consistency_info.NumInconsistentChartype() : 0.0;
-  features[PTRAIN_NUM_BAD_SPACING] =
-      vse.consistency_info.NumInconsistentSpaces();
+  feature_ids[n] = PTRAIN_NUM_BAD_SPACING;
+  values[n++] = vse.consistency_info.NumInconsistentSpaces();
   // Disabled this feature for now due to its poor performance.
-  // features[PTRAIN_NUM_BAD_FONT] = vse.consistency_info.inconsistent_font;
+  // PTRAIN_NUM_BAD_FONT: vse.consistency_info.inconsistent_font.
 
   // Classifier-related features.
-  features[PTRAIN_RATING_PER_CHAR] =
-      vse.ratings_sum / static_cast<float>(vse.outline_length);
+  feature_ids[n] = PTRAIN_RATING_PER_CHAR;
+  values[n++] = vse.ratings_sum / static_cast<float>(vse.outline_length);
+  return n;
 }
 
 WERD_CHOICE *LanguageModel::ConstructWord(
@@ -1394,7 +1469,7 @@ WERD_CHOICE *LanguageModel::ConstructWord(
     bool *truth_path) {
   if (truth_path != NULL) {
     *truth_path =
-        (blamer_bundle != NULL &&
+        (kBlamerEnabled && blamer_bundle != NULL &&
          vse->length == blamer_bundle->correct_segmentation_length());
   }
   BLOB_CHOICE *curr_b = vse->curr_b;
@@ -1418,7 +1493,8 @@ WERD_CHOICE *LanguageModel::ConstructWord(
   word->set_length(vse->length);
   int total_blobs = 0;
   for (i = (vse->length-1); i >= 0; --i) {
-    if (blamer_bundle != NULL && truth_path != NULL && *truth_path &&
+    if (kBlamerEnabled && blamer_bundle != NULL && truth_path != NULL &&
+        *truth_path &&
         !blamer_bundle->MatrixPositionCorrect(i, curr_b->matrix_cell())) {
         *truth_path = false;
     }
@@ -1434,7 +1510,7 @@ WERD_CHOICE *LanguageModel::ConstructWord(
           !dict_->getUnicharset().get_ispunctuation(curr_b->unichar_id())))) {
       vse->associate_stats.full_wh_ratio_var +=
         pow(full_wh_ratio_mean - curr_vse->associate_stats.full_wh_ratio, 2);
-      if (language_model_debug_level > 2) {
+      if (tdebug_on(language_model_debug_level, 2)) {
         tprintf("full_wh_ratio_var += (%g-%g)^2\n",
                 full_wh_ratio_mean, curr_vse->associate_stats.full_wh_ratio);
       }
@@ -1464,7 +1540,7 @@ WERD_CHOICE *LanguageModel::ConstructWord(
                       vse->consistency_info.BodyMaxXHeight());
   if (vse->dawg_info != NULL) {
     word->set_permuter(compound ? COMPOUND_PERM : vse->dawg_info->permuter);
-  } else if (language_model_ngram_on && !vse->ngram_info->pruned) {
+  } else if (NgramOn() && !vse->ngram_info->pruned) {
     word->set_permuter(NGRAM_PERM);
   } else if (vse->top_choice_flags) {
     word->set_permuter(TOP_CHOICE_PERM);
@@ -52,6 +52,10 @@ class LanguageModel {
   // penalty adjustments.
   static const float kMaxAvgNgramCost;
 
+  // Maximum number of features of a path that can be non-zero: one of the
+  // dictionary features and the rest, that are not one-hot.
+  static const int kMaxPathFeatures = 8;
+
   LanguageModel(const UnicityTable<FontInfo> *fontinfo_table, Dict *dict);
   ~LanguageModel();
 
@@ -62,6 +66,12 @@ class LanguageModel {
   // PTRAIN_NUM_FEATURE_TYPES.
   static void ExtractFeaturesFromPath(const ViterbiStateEntry &vse,
                                       float features[]);
+  // As ExtractFeaturesFromPath, but only the features that can be non-zero,
+  // in increasing order of their type, in the first n elements of
+  // feature_ids and values, which must have kMaxPathFeatures. Returns n.
+  static int ExtractSparseFeaturesFromPath(const ViterbiStateEntry &vse,
+                                           int feature_ids[],
+                                           float values[]);
 
   // Updates data structures that are used for the duration of the segmentation
   // search on the current word;
@@ -98,6 +108,12 @@ class LanguageModel {
   }
   // Returns the reference to ParamsModel.
   inline ParamsModel &getParamsModel() { return params_model_; }
+  // Returns true if the character ngram model is in use: if it is turned on,
+  // or if a compiled ngram table is loaded and may be used.
+  inline bool NgramOn() const {
+    return language_model_ngram_on ||
+        (language_model_ngram_table_on && dict_->char_ngram_table() != NULL);
+  }
 
  protected:
 
@@ -230,6 +246,12 @@ class LanguageModel {
                          const char *context, int *unichar_step_len,
                          bool *found_small_prob, float *ngram_prob);
 
+  // Returns the average over the UTF8 characters of unichar of their
+  // probability in context, as ComputeNgramCost uses it, adding the number
+  // of characters used to unichar_step_len. Looks in ngram_cache_ first.
+  float NgramProbability(const char *unichar, const char *context,
+                         int *unichar_step_len);
+
   // Computes the normalization factors for the classifier confidences
   // (used by ComputeNgramCost()).
   float ComputeDenom(BLOB_CHOICE_LIST *curr_list);
@@ -308,6 +330,9 @@ class LanguageModel {
   INT_VAR_H(language_model_debug_level, 0, "Language model debug level");
   BOOL_VAR_H(language_model_ngram_on, false,
              "Turn on/off the use of character ngram model");
+  BOOL_VAR_H(language_model_ngram_table_on, true,
+             "Use the character ngram model whenever a compiled ngram table"
+             " is loaded");
   INT_VAR_H(language_model_ngram_order, 8,
             "Maximum order of the character ngram model");
   INT_VAR_H(language_model_viterbi_list_max_num_prunable, 10,
@@ -354,6 +379,8 @@ class LanguageModel {
   INT_VAR_H(wordrec_display_segmentations, 0, "Display Segmentations");
   BOOL_VAR_H(language_model_use_sigmoidal_certainty, false,
              "Use sigmoidal score for certainty");
+  BOOL_VAR_H(language_model_pool_states, true,
+             "Recycle the memory of the segmentation search state");
 
 
  protected:
@@ -411,6 +438,30 @@ class LanguageModel {
 
   // Params models containing weights for for computing ViterbiStateEntry costs.
   ParamsModel params_model_;
+
+  // Memory for the ViterbiStateEntries of the current word and their
+  // dawg and ngram info.
+  LMStatePool state_pool_;
+  // Storage for the dawg infos and their generation, from dict_, for the
+  // life of the LanguageModel.
+  DawgScratch *dawg_scratch_;
+
+  // An entry of ngram_cache_.
+  struct NgramCacheEntry {
+    NgramCacheEntry() : key(0), prob(0.0f), step_len(0), stamp(-1) {}
+
+    uinT64 key;    // CharNgramTable::HashNgram of the context and unichar.
+    float prob;    // What NgramProbability returned for them.
+    int step_len;  // The number of characters it used.
+    int stamp;     // ngram_cache_stamp_ when the entry was filled.
+  };
+  // Direct-mapped cache of NgramProbability by the hash of its arguments,
+  // since the segmentation search asks for the same unichars in the same
+  // contexts many times over. Emptied by InitForWord, by moving on the
+  // stamp, in case the probability function or parameters change between
+  // words.
+  GenericVector<NgramCacheEntry> ngram_cache_;
+  int ngram_cache_stamp_;
 };
 
 }  // namespace tesseract
@@ -20,10 +20,70 @@
 
 #include "lm_state.h"
 
+#include <stdlib.h>
+
 namespace tesseract {
 
 ELISTIZE(ViterbiStateEntry);
 
+LMStatePool::LMStatePool()
+  : enabled_(true), num_allocs_(0), num_heap_allocs_(0), num_live_(0) {
+  for (int i = 0; i < kNumSizeClasses; ++i) free_lists_[i] = NULL;
+}
+
+LMStatePool::~LMStatePool() {
+  for (int b = 0; b < blocks_.size(); ++b) free(blocks_[b]);
+}
+
+void *LMStatePool::Alloc(LMStatePool *pool, size_t size) {
+  int size_class = (size + kAlignment - 1) / kAlignment - 1;
+  if (size_class < 0) size_class = 0;
+  if (pool != NULL) {
+    ++pool->num_allocs_;
+    ++pool->num_live_;
+  }
+  Header *header;
+  if (pool == NULL || !pool->enabled_ || size_class >= kNumSizeClasses) {
+    if (pool != NULL) ++pool->num_heap_allocs_;
+    char *memory = static_cast<char *>(malloc(kAlignment + size));
+    header = reinterpret_cast<Header *>(memory);
+    header->size_class = -1;
+  } else {
+    if (pool->free_lists_[size_class] == NULL) pool->AddBlock(size_class);
+    void *object = pool->free_lists_[size_class];
+    pool->free_lists_[size_class] = *static_cast<void **>(object);
+    header = HeaderOf(object);
+    header->size_class = size_class;
+  }
+  header->pool = pool;
+  return reinterpret_cast<char *>(header) + kAlignment;
+}
+
+void LMStatePool::Free(void *ptr) {
+  if (ptr == NULL) return;
+  Header *header = HeaderOf(ptr);
+  LMStatePool *pool = header->pool;
+  if (pool != NULL) --pool->num_live_;
+  if (header->size_class < 0) {
+    free(header);
+  } else {
+    *static_cast<void **>(ptr) = pool->free_lists_[header->size_class];
+    pool->free_lists_[header->size_class] = ptr;
+  }
+}
+
+void LMStatePool::AddBlock(int size_class) {
+  int stride = kAlignment + (size_class + 1) * kAlignment;
+  char *block = static_cast<char *>(malloc(stride * kObjectsPerBlock));
+  ++num_heap_allocs_;
+  blocks_.push_back(block);
+  for (int i = 0; i < kObjectsPerBlock; ++i) {
+    void *object = block + i * stride + kAlignment;
+    *static_cast<void **>(object) = free_lists_[size_class];
+    free_lists_[size_class] = object;
+  }
+}
+
 void ViterbiStateEntry::Print(const char *msg) const {
   tprintf("%s ViterbiStateEntry", msg);
   if (updated) tprintf("(NEW)");
@@ -24,10 +24,13 @@
 
 #include "associate.h"
 #include "elst.h"
+#include "genericvector.h"
 #include "dawg.h"
+#include "dict.h"
 #include "lm_consistency.h"
 #include "matrix.h"
 #include "ratngs.h"
+#include "smallstring.h"
 #include "stopper.h"
 #include "strngs.h"
 
@@ -55,27 +58,113 @@ typedef unsigned char LanguageModelFlagsType;
 /// that it represents (WERD_CHOICE) can be constructed by following these
 /// parent pointers.
 
+/// Recycles the memory of the ViterbiStateEntry, LanguageModelDawgInfo and
+/// LanguageModelNgramInfo objects of the segmentation search. A long word
+/// makes and discards a great many of them, so objects of each size are
+/// carved out of larger blocks, and go onto a free list when deleted, ready
+/// for the next path or word. A pool serves one word at a time, so it needs
+/// no locking, and it must outlive every object allocated from it.
+class LMStatePool {
+ public:
+  LMStatePool();
+  ~LMStatePool();
+
+  /// If false, each object gets a heap allocation of its own, as with plain
+  /// new, which still counts towards the statistics.
+  void set_enabled(bool enabled) { enabled_ = enabled; }
+
+  /// Returns memory for an object of the given size from pool, which may be
+  /// NULL for plain heap memory.
+  static void *Alloc(LMStatePool *pool, size_t size);
+  /// Gives the memory of an object made by Alloc back to its pool.
+  static void Free(void *ptr);
+
+  /// Number of objects allocated, and of calls to the heap made for them.
+  inT64 num_allocs() const { return num_allocs_; }
+  inT64 num_heap_allocs() const { return num_heap_allocs_; }
+  /// Number of objects not yet freed.
+  int num_live() const { return num_live_; }
+  void ResetCounts() { num_allocs_ = num_heap_allocs_ = 0; }
+
+ private:
+  /// Objects and the header before each are aligned to this.
+  static const int kAlignment = 16;
+  /// Number of object sizes, in steps of kAlignment, that are pooled.
+  static const int kNumSizeClasses = 32;
+  /// Number of objects in each block taken from the heap.
+  static const int kObjectsPerBlock = 64;
+
+  /// Placed kAlignment bytes before each object.
+  struct Header {
+    LMStatePool *pool;
+    /// Index into free_lists_, or -1 if the object has its own heap memory.
+    int size_class;
+  };
+
+  /// Returns the header of the object at ptr.
+  static Header *HeaderOf(void *ptr) {
+    return reinterpret_cast<Header *>(static_cast<char *>(ptr) - kAlignment);
+  }
+  /// Takes a block from the heap and adds its objects to
+  /// free_lists_[size_class].
+  void AddBlock(int size_class);
+
+  bool enabled_;
+  /// Heads of the lists of free objects of each size class, linked through
+  /// their first word.
+  void *free_lists_[kNumSizeClasses];
+  /// Memory taken from the heap by AddBlock.
+  GenericVector<char *> blocks_;
+  inT64 num_allocs_;
+  inT64 num_heap_allocs_;
+  int num_live_;
+};
+
+/// Base of the classes allocated from an LMStatePool, with
+/// new (pool) Class(...), and freed back to it with plain delete.
+struct LMStatePooled {
+  static void *operator new(size_t size, LMStatePool *pool) {
+    return LMStatePool::Alloc(pool, size);
+  }
+  static void operator delete(void *ptr, LMStatePool *pool) {
+    LMStatePool::Free(ptr);
+  }
+  static void operator delete(void *ptr) { LMStatePool::Free(ptr); }
+};
+
 /// Struct for storing additional information used by Dawg language model
 /// component. It stores the set of active dawgs in which the sequence of
 /// letters on a path can be found.
-struct LanguageModelDawgInfo {
-  LanguageModelDawgInfo(DawgPositionVector *a, PermuterType pt) : permuter(pt) {
-    active_dawgs = new DawgPositionVector(*a);
+struct LanguageModelDawgInfo : public LMStatePooled {
+  /// The copy of a is taken from scratch if it is not NULL, which must then
+  /// outlive the object.
+  LanguageModelDawgInfo(DawgPositionVector *a, PermuterType pt,
+                        DawgScratch *s = NULL) : permuter(pt), scratch(s) {
+    active_dawgs = scratch != NULL ? scratch->CopyPositions(*a)
+                                   : new DawgPositionVector(*a);
   }
   ~LanguageModelDawgInfo() {
-    delete active_dawgs;
+    if (scratch != NULL) {
+      scratch->FreePositions(active_dawgs);
+    } else {
+      delete active_dawgs;
+    }
   }
   DawgPositionVector *active_dawgs;
   PermuterType permuter;
+  /// Where active_dawgs came from, or NULL if from the heap.
+  DawgScratch *scratch;
 };
 
 /// Struct for storing additional information used by Ngram language model
 /// component.
-struct LanguageModelNgramInfo {
+struct LanguageModelNgramInfo : public LMStatePooled {
   LanguageModelNgramInfo(const char *c, int l, bool p, float nc, float ncc)
     : context(c), context_unichar_step_len(l), pruned(p), ngram_cost(nc),
       ngram_and_classifier_cost(ncc) {}
-  STRING context;  //< context string
+  /// Context string. Held inline, as it is at most the ngram order of
+  /// unichars long.
+  SmallString<32> context;
   /// Length of the context measured by advancing using UNICHAR::utf8_step()
   /// (should be at most the order of the character ngram model used).
   int context_unichar_step_len;
@@ -92,7 +181,7 @@ struct LanguageModelNgramInfo {
 
 /// Struct for storing the information about a path in the segmentation graph
 /// explored by Viterbi search.
-struct ViterbiStateEntry : public ELIST_LINK {
+struct ViterbiStateEntry : public ELIST_LINK, public LMStatePooled {
   ViterbiStateEntry(ViterbiStateEntry *pe,
                     BLOB_CHOICE *b, float c, float ol,
                     const LMConsistencyInfo &ci,
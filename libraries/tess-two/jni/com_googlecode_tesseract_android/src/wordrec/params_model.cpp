@@ -84,6 +84,20 @@ float ParamsModel::ComputeCost(const float features[]) const {
                      kMinFinalCost, kMaxFinalCost);
 }
 
+// The skipped features add exact zeros to the sum, and the rest are added
+// in the same order, so the cost matches ComputeCost bit for bit.
+float ParamsModel::ComputeSparseCost(const int feature_ids[],
+                                     const float values[],
+                                     int num_features) const {
+  const float* weights = &weights_vec_[pass_][0];
+  float unnorm_score = 0.0;
+  for (int i = 0; i < num_features; ++i) {
+    unnorm_score += weights[feature_ids[i]] * values[i];
+  }
+  return ClipToRange(-unnorm_score / kScoreScaleFactor,
+                     kMinFinalCost, kMaxFinalCost);
+}
+
 bool ParamsModel::Equivalent(const ParamsModel &that) const {
   float epsilon = 0.0001;
   for (int p = 0; p < PTRAIN_NUM_PASSES; ++p) {
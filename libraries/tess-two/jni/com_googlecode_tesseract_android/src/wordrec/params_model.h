@@ -54,6 +54,11 @@ class ParamsModel {
   // Applies params model weights to the given features.
   // Assumes that features is an array of size PTRAIN_NUM_FEATURE_TYPES.
   float ComputeCost(const float features[]) const;
+  // As ComputeCost, on features that are zero except for the num_features
+  // given by feature_ids, in increasing order, with the given values, so
+  // only the weights of those are read. The result is the same.
+  float ComputeSparseCost(const int feature_ids[], const float values[],
+                          int num_features) const;
   bool Equivalent(const ParamsModel &that) const;
 
   // Returns true on success.
@@ -0,0 +1,189 @@
+///////////////////////////////////////////////////////////////////////
+// File:        piececache.cpp
+// Description: Cache of the classifications of joined pieces of a word,
+//              keyed on the content of the joined blob.
+//
+// (C) Copyright 2016, Google Inc.
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////
+
+#include "piececache.h"
+
+#include <string.h>
+#include "blobs.h"
+#include "coutln.h"
+#include "normalis.h"
+#include "ocrblock.h"
+
+namespace tesseract {
+
+// Appends the size bytes at data to key.
+static void AppendToKey(const void* data, int size, GenericVector<uinT8>* key) {
+  const uinT8* bytes = static_cast<const uinT8*>(data);
+  for (int i = 0; i < size; ++i) key->push_back(bytes[i]);
+}
+
+// Appends all the steps of outline, with the edge offsets that the feature
+// extractor reads.
+static void AppendOutlineToKey(const C_OUTLINE& outline,
+                               GenericVector<uinT8>* key) {
+  ICOORD pos = outline.start_pos();
+  inT32 header[3] = { pos.x(), pos.y(), outline.pathlength() };
+  AppendToKey(header, sizeof(header), key);
+  for (int s = 0; s < outline.pathlength(); ++s) {
+    uinT8 step[3] = { static_cast<uinT8>(outline.chain_code(s)),
+                      static_cast<uinT8>(outline.edge_strength_at_index(s)),
+                      static_cast<uinT8>(outline.direction_at_index(s)) };
+    AppendToKey(step, sizeof(step), key);
+    if (outline.edge_strength_at_index(s) > 0) {
+      FCOORD sub_pixel = outline.sub_pixel_pos_at_index(pos, s);
+      float xy[2] = { sub_pixel.x(), sub_pixel.y() };
+      AppendToKey(xy, sizeof(xy), key);
+    }
+    pos += outline.step(s);
+  }
+}
+
+PieceCache::PieceCache(int capacity)
+  : hits_(0), misses_(0), next_entry_(0) {
+  capacity = MAX(capacity, 1);
+  entries_.init_to_size(capacity, Entry());
+  int num_buckets = 1;
+  while (num_buckets < 2 * capacity) num_buckets *= 2;
+  buckets_.init_to_size(num_buckets, -1);
+}
+
+PieceCache::~PieceCache() {
+  for (int e = 0; e < entries_.size(); ++e) delete entries_[e].choices;
+}
+
+void PieceCache::BuildKey(const TBLOB& blob, int results_version,
+                          int max_choices, GenericVector<uinT8>* key) {
+  key->truncate(0);
+  AppendToKey(&results_version, sizeof(results_version), key);
+  AppendToKey(&max_choices, sizeof(max_choices), key);
+  // Where the normalized blob lands in the image, and any rotation that
+  // classification applies first.
+  const DENORM& denorm = blob.denorm();
+  const FCOORD probes[3] = { FCOORD(0.0f, 0.0f), FCOORD(256.0f, 0.0f),
+                             FCOORD(0.0f, 256.0f) };
+  for (int p = 0; p < 3; ++p) {
+    FCOORD image_pt;
+    denorm.DenormTransform(NULL, probes[p], &image_pt);
+    float xy[2] = { image_pt.x(), image_pt.y() };
+    AppendToKey(xy, sizeof(xy), key);
+  }
+  FCOORD rotation(1.0f, 0.0f);
+  if (denorm.block() != NULL) rotation = denorm.block()->classify_rotation();
+  float flags[3] = { rotation.x(), rotation.y(),
+                     denorm.inverse() ? 1.0f : 0.0f };
+  AppendToKey(flags, sizeof(flags), key);
+  // The outlines, each source outline once, however many points use it.
+  GenericVector<const C_OUTLINE*> src_outlines;
+  for (const TESSLINE* ol = blob.outlines; ol != NULL; ol = ol->next) {
+    uinT8 is_hole = ol->is_hole;
+    AppendToKey(&is_hole, sizeof(is_hole), key);
+    const EDGEPT* pt = ol->loop;
+    if (pt == NULL) continue;
+    do {
+      inT16 pos[2] = { pt->pos.x, pt->pos.y };
+      AppendToKey(pos, sizeof(pos), key);
+      AppendToKey(pt->flags, sizeof(pt->flags), key);
+      int src_index = -1;
+      if (pt->src_outline != NULL) {
+        for (int i = 0; i < src_outlines.size() && src_index < 0; ++i) {
+          if (src_outlines[i] == pt->src_outline) src_index = i;
+        }
+        if (src_index < 0) {
+          src_index = src_outlines.size();
+          src_outlines.push_back(pt->src_outline);
+          AppendOutlineToKey(*pt->src_outline, key);
+        }
+      }
+      int steps[3] = { src_index, pt->start_step, pt->step_count };
+      AppendToKey(steps, sizeof(steps), key);
+      pt = pt->next;
+    } while (pt != ol->loop);
+    // Marks the end of the outline.
+    AppendToKey(&is_hole, sizeof(is_hole), key);
+  }
+}
+
+BLOB_CHOICE_LIST* PieceCache::Lookup(const GenericVector<uinT8>& key) {
+  int index = Find(Hash(key), key);
+  if (index < 0) {
+    ++misses_;
+    return NULL;
+  }
+  ++hits_;
+  BLOB_CHOICE_LIST* choices = new BLOB_CHOICE_LIST;
+  choices->deep_copy(entries_[index].choices, &BLOB_CHOICE::deep_copy);
+  return choices;
+}
+
+void PieceCache::Insert(const GenericVector<uinT8>& key,
+                        const BLOB_CHOICE_LIST& choices) {
+  uinT64 hash = Hash(key);
+  if (Find(hash, key) >= 0) return;
+  int index = next_entry_;
+  next_entry_ = (next_entry_ + 1) % entries_.size();
+  Remove(index);
+  Entry* entry = &entries_[index];
+  entry->hash = hash;
+  entry->key = key;
+  entry->choices = new BLOB_CHOICE_LIST;
+  entry->choices->deep_copy(&choices, &BLOB_CHOICE::deep_copy);
+  int bucket = static_cast<int>(hash & (buckets_.size() - 1));
+  entry->next_in_bucket = buckets_[bucket];
+  buckets_[bucket] = index;
+}
+
+void PieceCache::Clear() {
+  for (int e = 0; e < entries_.size(); ++e) Remove(e);
+  next_entry_ = 0;
+}
+
+// FNV-1a, which is plenty for keys that are compared in full anyway.
+uinT64 PieceCache::Hash(const GenericVector<uinT8>& key) {
+  uinT64 hash = 14695981039346656037ULL;
+  for (int i = 0; i < key.size(); ++i) {
+    hash ^= key[i];
+    hash *= 1099511628211ULL;
+  }
+  return hash;
+}
+
+int PieceCache::Find(uinT64 hash, const GenericVector<uinT8>& key) const {
+  int bucket = static_cast<int>(hash & (buckets_.size() - 1));
+  for (int index = buckets_[bucket]; index >= 0;
+       index = entries_[index].next_in_bucket) {
+    const Entry& entry = entries_[index];
+    if (entry.hash == hash && entry.key.size() == key.size() &&
+        (key.empty() || memcmp(&entry.key[0], &key[0], key.size()) == 0))
+      return index;
+  }
+  return -1;
+}
+
+void PieceCache::Remove(int index) {
+  Entry* entry = &entries_[index];
+  if (entry->choices == NULL) return;
+  int* link = &buckets_[static_cast<int>(entry->hash &
+                                         (buckets_.size() - 1))];
+  while (*link != index) link = &entries_[*link].next_in_bucket;
+  *link = entry->next_in_bucket;
+  delete entry->choices;
+  entry->choices = NULL;
+  entry->key.truncate(0);
+}
+
+}  // namespace tesseract
@@ -0,0 +1,90 @@
+///////////////////////////////////////////////////////////////////////
+// File:        piececache.h
+// Description: Cache of the classifications of joined pieces of a word,
+//              keyed on the content of the joined blob.
+//
+// (C) Copyright 2016, Google Inc.
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////
+
+#ifndef TESSERACT_WORDREC_PIECECACHE_H_
+#define TESSERACT_WORDREC_PIECECACHE_H_
+
+#include "genericvector.h"
+#include "host.h"
+#include "ratngs.h"
+
+struct TBLOB;
+
+namespace tesseract {
+
+// Remembers the choices that classify_piece returned for the last few
+// blobs, so that a joined blob that the chopper or SegSearch ask for again,
+// in another cell of the ratings matrix after a seam was inserted or on a
+// later pass over the word, is not classified again. The key describes
+// everything about the blob that the classifier reads, so the positions of
+// the pieces in the word and the seams between them do not matter. Entries
+// are replaced oldest first. Not thread-safe, like the rest of a Wordrec.
+class PieceCache {
+ public:
+  explicit PieceCache(int capacity);
+  ~PieceCache();
+
+  int capacity() const { return entries_.size(); }
+  int hits() const { return hits_; }
+  int misses() const { return misses_; }
+
+  // Replaces *key with a description of blob, its outlines to the chain
+  // code steps they came from and its normalization, and of the state of
+  // the classifier given by results_version and the limit on the number of
+  // choices kept given by max_choices.
+  static void BuildKey(const TBLOB& blob, int results_version,
+                       int max_choices, GenericVector<uinT8>* key);
+  // Returns a new copy of the choices stored for key, which the caller then
+  // owns, or NULL, counting a miss.
+  BLOB_CHOICE_LIST* Lookup(const GenericVector<uinT8>& key);
+  // Stores a copy of choices for key, replacing the oldest entry if the
+  // cache is full.
+  void Insert(const GenericVector<uinT8>& key,
+              const BLOB_CHOICE_LIST& choices);
+  // Forgets all entries, but keeps the hit and miss counts.
+  void Clear();
+
+ private:
+  struct Entry {
+    Entry() : hash(0), choices(NULL), next_in_bucket(-1) {}
+
+    uinT64 hash;
+    GenericVector<uinT8> key;
+    // NULL if the entry is unused.
+    BLOB_CHOICE_LIST* choices;
+    // Next entry in the same hash bucket.
+    int next_in_bucket;
+  };
+
+  static uinT64 Hash(const GenericVector<uinT8>& key);
+  // Returns the index of the entry for key or -1.
+  int Find(uinT64 hash, const GenericVector<uinT8>& key) const;
+  // Removes entries_[index] from its bucket and frees its choices.
+  void Remove(int index);
+
+  int hits_;
+  int misses_;
+  // Fixed size array of entries, used in turn.
+  GenericVector<Entry> entries_;
+  GenericVector<int> buckets_;
+  int next_entry_;
+};
+
+}  // namespace tesseract
+
+#endif  // TESSERACT_WORDREC_PIECECACHE_H_
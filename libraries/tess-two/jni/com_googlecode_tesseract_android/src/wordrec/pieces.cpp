@@ -31,8 +31,11 @@
 #include "helpers.h"
 #include "matrix.h"
 #include "ndminx.h"
+#include "piececache.h"
 #include "ratngs.h"
 #include "seam.h"
+#include "tesscallback.h"
+#include "threadpool.h"
 #include "wordrec.h"
 
 // Include automatically generated configuration file if running autoconf.
@@ -61,8 +64,20 @@ BLOB_CHOICE_LIST *Wordrec::classify_piece(const GenericVector<SEAM*>& seams,
                                           TWERD *word,
                                           BlamerBundle *blamer_bundle) {
   if (end > start) SEAM::JoinPieces(seams, word->blobs, start, end);
-  BLOB_CHOICE_LIST *choices = classify_blob(word->blobs[start], description,
-                                            White, blamer_bundle);
+  // The blamer needs to see every classification.
+  PieceCache* cache = blamer_bundle == NULL ? GetPieceCache() : NULL;
+  GenericVector<uinT8> key;
+  BLOB_CHOICE_LIST *choices = NULL;
+  if (cache != NULL) {
+    PieceCache::BuildKey(*word->blobs[start], results_version(),
+                         wordrec_max_blob_choices, &key);
+    choices = cache->Lookup(key);
+  }
+  if (choices == NULL) {
+    choices = classify_blob(word->blobs[start], description, White,
+                            blamer_bundle);
+    if (cache != NULL) cache->Insert(key, *choices);
+  }
   // Set the matrix_cell_ entries in all the BLOB_CHOICES.
   BLOB_CHOICE_IT bc_it(choices);
   for (bc_it.mark_cycle_pt(); !bc_it.cycled_list(); bc_it.forward()) {
@@ -74,6 +89,81 @@ BLOB_CHOICE_LIST *Wordrec::classify_piece(const GenericVector<SEAM*>& seams,
   return (choices);
 }
 
+// The blobs that classify_single_pieces has to classify, and their results.
+struct SinglePieceJob {
+  Wordrec* wordrec;
+  const char* description;
+  GenericVector<TBLOB*> blobs;
+  GenericVector<BLOB_CHOICE_LIST*> choices;
+};
+
+// Classifies one blob of a SinglePieceJob. Each blob has its own result, so
+// the blobs may be classified concurrently in any order.
+static void ClassifySinglePiece(SinglePieceJob* job, int i) {
+  job->choices[i] = job->wordrec->classify_blob(job->blobs[i],
+                                                job->description, White, NULL);
+}
+
+void Wordrec::classify_single_pieces(
+    int start, int end, const char* description, TWERD *word,
+    GenericVector<BLOB_CHOICE_LIST*>* choices) {
+  // The cache is only touched here, on the calling thread.
+  PieceCache* cache = GetPieceCache();
+  GenericVector<GenericVector<uinT8> > keys;
+  GenericVector<int> missed;
+  SinglePieceJob job;
+  job.wordrec = this;
+  job.description = description;
+  int first = choices->size();
+  for (int b = start; b <= end; ++b) {
+    BLOB_CHOICE_LIST* cached = NULL;
+    if (cache != NULL) {
+      keys.push_back(GenericVector<uinT8>());
+      PieceCache::BuildKey(*word->blobs[b], results_version(),
+                           wordrec_max_blob_choices, &keys.back());
+      cached = cache->Lookup(keys.back());
+    }
+    if (cached == NULL) {
+      missed.push_back(b - start);
+      job.blobs.push_back(word->blobs[b]);
+    }
+    choices->push_back(cached);
+  }
+  job.choices.init_to_size(job.blobs.size(), NULL);
+  ThreadPool* pool = job.blobs.size() > 1 ? RecognitionThreadPool() : NULL;
+  if (pool != NULL) {
+    TessCallback1<int>* classify =
+        NewPermanentTessCallback(&ClassifySinglePiece, &job);
+    pool->ParallelFor(job.blobs.size(), classify);
+    delete classify;
+  } else {
+    for (int i = 0; i < job.blobs.size(); ++i) ClassifySinglePiece(&job, i);
+  }
+  for (int i = 0; i < missed.size(); ++i) {
+    (*choices)[first + missed[i]] = job.choices[i];
+    if (cache != NULL) cache->Insert(keys[missed[i]], *job.choices[i]);
+  }
+  // Set the matrix_cell_ entries in all the BLOB_CHOICES.
+  for (int b = start; b <= end; ++b) {
+    BLOB_CHOICE_IT bc_it((*choices)[first + b - start]);
+    for (bc_it.mark_cycle_pt(); !bc_it.cycled_list(); bc_it.forward()) {
+      bc_it.data()->set_matrix_cell(b, b);
+    }
+  }
+}
+
+PieceCache* Wordrec::GetPieceCache() {
+  if (wordrec_piece_cache_size <= 0) {
+    delete piece_cache_;
+    piece_cache_ = NULL;
+  } else if (piece_cache_ == NULL ||
+             piece_cache_->capacity() != wordrec_piece_cache_size) {
+    delete piece_cache_;
+    piece_cache_ = new PieceCache(wordrec_piece_cache_size);
+  }
+  return piece_cache_;
+}
+
 template<class BLOB_CHOICE>
 int SortByUnicharID(const void *void1, const void *void2) {
   const BLOB_CHOICE *p1 = *reinterpret_cast<const BLOB_CHOICE * const *>(void1);
@@ -24,10 +24,19 @@
 #include "matrix.h"
 #include "params.h"
 #include "lm_pain_points.h"
+#include "ocrclass.h"
+#include "pagecounters.h"
 #include "ratngs.h"
 
 namespace tesseract {
 
+// Returns the time of day in microseconds.
+static inT64 NowMicros() {
+  struct timeval now;
+  gettimeofday(&now, NULL);
+  return static_cast<inT64>(now.tv_sec) * 1000000 + now.tv_usec;
+}
+
 void Wordrec::DoSegSearch(WERD_RES* word_res) {
   BestChoiceBundle best_choice_bundle(word_res->ratings->dimension());
   // Run Segmentation Search.
@@ -41,6 +50,17 @@ void Wordrec::SegSearch(WERD_RES* word_res,
                            segsearch_max_char_wh_ratio,
                            assume_fixed_pitch_char_segment,
                            &getDict(), segsearch_debug_level);
+  // The word gets its own budget, cut to what is left of the page's.
+  inT64 start_us = NowMicros();
+  inT64 budget_us = segsearch_word_budget_us > 0 ?
+      segsearch_word_budget_us : -1;
+  if (segsearch_page_budget_us > 0) {
+    inT64 page_left_us = segsearch_page_budget_us - segsearch_page_us_;
+    if (page_left_us < 0) page_left_us = 0;
+    if (budget_us < 0 || page_left_us < budget_us) budget_us = page_left_us;
+  }
+  segsearch_deadline_us_ = budget_us >= 0 ? start_us + budget_us : 0;
+  segsearch_out_of_time_ = false;
   // Compute scaling factor that will help us recover blob outline length
   // from classifier rating and certainty for the blob.
   float rating_cert_scale = -1.0 * getDict().certainty_scale / rating_scale;
@@ -55,7 +75,7 @@ void Wordrec::SegSearch(WERD_RES* word_res,
     }
     if (chop_debug) SEAM::PrintSeams("Final seam list:", word_res->seam_array);
 
-    if (blamer_bundle != NULL &&
+    if (kBlamerEnabled && blamer_bundle != NULL &&
         !blamer_bundle->ChoiceIsCorrect(word_res->best_choice)) {
       blamer_bundle->SetChopperBlame(word_res, wordrec_debug_blamer);
     }
@@ -68,7 +88,7 @@ void Wordrec::SegSearch(WERD_RES* word_res,
   STRING blamer_debug;
   while (wordrec_enable_assoc &&
       (!SegSearchDone(num_futile_classifications) ||
-          (blamer_bundle != NULL &&
+          (kBlamerEnabled && blamer_bundle != NULL &&
               blamer_bundle->GuidedSegsearchStillGoing()))) {
     // Get the next valid "pain point".
     bool found_nothing = true;
@@ -108,13 +128,13 @@ void Wordrec::SegSearch(WERD_RES* word_res,
     // See if it's time to terminate SegSearch or time for starting a guided
     // search for the true path to find the blame for the incorrect best_choice.
     if (SegSearchDone(num_futile_classifications) &&
-        blamer_bundle != NULL &&
+        kBlamerEnabled && blamer_bundle != NULL &&
         blamer_bundle->GuidedSegsearchNeeded(word_res->best_choice)) {
       InitBlamerForSegSearch(word_res, &pain_points, blamer_bundle,
                              &blamer_debug);
     }
   }  // end while loop exploring alternative paths
-  if (blamer_bundle != NULL) {
+  if (kBlamerEnabled && blamer_bundle != NULL) {
     blamer_bundle->FinishSegSearch(word_res->best_choice,
                                    wordrec_debug_blamer, &blamer_debug);
   }
@@ -123,6 +143,25 @@ void Wordrec::SegSearch(WERD_RES* word_res,
     tprintf("Done with SegSearch (AcceptableChoiceFound: %d)\n",
             language_model_->AcceptableChoiceFound());
   }
+  segsearch_page_us_ += NowMicros() - start_us;
+  if (segsearch_out_of_time_) {
+    ++segsearch_words_out_of_time_;
+    if (segsearch_debug_level > 0) tprintf("SegSearch ran out of time\n");
+  }
+  segsearch_deadline_us_ = 0;
+}
+
+void Wordrec::ResetSegSearchBudget() {
+  segsearch_page_us_ = 0;
+  segsearch_words_out_of_time_ = 0;
+}
+
+bool Wordrec::SegSearchOutOfTime() {
+  if (!segsearch_out_of_time_ && segsearch_deadline_us_ > 0 &&
+      NowMicros() >= segsearch_deadline_us_) {
+    segsearch_out_of_time_ = true;
+  }
+  return segsearch_out_of_time_;
 }
 
 // Setup and run just the initial segsearch on an established matrix,
@@ -171,7 +210,7 @@ void Wordrec::InitialSegSearch(WERD_RES* word_res, LMPainPoints* pain_points,
   // blamer_bundle->norm_truth_word to the corresponding i,j indices in the
   // ratings matrix. We expect this step to succeed, since when running the
   // chopper we checked that the correct chops are present.
-  if (blamer_bundle != NULL) {
+  if (kBlamerEnabled && blamer_bundle != NULL) {
     blamer_bundle->SetupCorrectSegmentation(word_res->chopped_word,
                                             wordrec_debug_blamer);
   }
@@ -263,7 +302,9 @@ void Wordrec::ProcessSegSearchPainPoint(
     float pain_point_priority,
     const MATRIX_COORD &pain_point, const char* pain_point_type,
     GenericVector<SegSearchPending>* pending, WERD_RES *word_res,
-    LMPainPoints *pain_points, BlamerBundle *blamer_bundle) {
+    LMPainPoints *pain_points, BlamerBundle *blamer_bundle,
+    BLOB_CHOICE_LIST *classified) {
+  PageCounts::Count(COUNTER_PAIN_POINTS);
   if (segsearch_debug_level > 0) {
     tprintf("Classifying pain point %s priority=%.4f, col=%d, row=%d\n",
             pain_point_type, pain_point_priority,
@@ -276,11 +317,11 @@ void Wordrec::ProcessSegSearchPainPoint(
     ratings->IncreaseBandSize(pain_point.row + 1 - pain_point.col);
   }
   ASSERT_HOST(pain_point.Valid(*ratings));
-  BLOB_CHOICE_LIST *classified = classify_piece(word_res->seam_array,
-                                                pain_point.col, pain_point.row,
-                                                pain_point_type,
-                                                word_res->chopped_word,
-                                                blamer_bundle);
+  if (classified == NULL) {
+    classified = classify_piece(word_res->seam_array, pain_point.col,
+                                pain_point.row, pain_point_type,
+                                word_res->chopped_word, blamer_bundle);
+  }
   BLOB_CHOICE_LIST *lst = ratings->get(pain_point.col, pain_point.row);
   if (lst == NULL) {
     ratings->put(pain_point.col, pain_point.row, classified);
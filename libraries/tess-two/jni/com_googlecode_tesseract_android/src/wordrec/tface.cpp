@@ -143,6 +143,8 @@ BLOB_CHOICE_LIST *Wordrec::call_matcher(TBLOB *tessblob) {
   }
   BLOB_CHOICE_LIST *ratings = new BLOB_CHOICE_LIST();  // matcher result
   AdaptiveClassifier(rotated_blob, ratings);
+  TruncateBlobChoices(wordrec_max_blob_choices, getDict().getUnicharset(),
+                      ratings);
   if (rotated_blob != tessblob) {
     delete rotated_blob;
   }
@@ -65,7 +65,7 @@ BLOB_CHOICE_LIST *Wordrec::classify_blob(TBLOB *blob,
   // If a blob with the same bounding box as one of the truth character
   // bounding boxes is not classified as the corresponding truth character
   // blame character classifier for incorrect answer.
-  if (blamer_bundle != NULL) {
+  if (kBlamerEnabled && blamer_bundle != NULL) {
     blamer_bundle->BlameClassifier(getDict().getUnicharset(),
                                    blob->bounding_box(),
                                    *choices,
@@ -82,4 +82,43 @@ BLOB_CHOICE_LIST *Wordrec::classify_blob(TBLOB *blob,
   return choices;
 }
 
+/**
+ * @name classify_blobs
+ *
+ * Classify each of blobs as classify_blob does, but in a single call to
+ * the classifier, and append the choices for each to choices.
+ * @param blobs The blobs to classify
+ * @param string The string to display in ScrollView
+ * @param color The colour to use when displayed with ScrollView
+ * @param choices The list to append the choices to
+ */
+void Wordrec::classify_blobs(const GenericVector<TBLOB*>& blobs,
+                             const char *string, C_COL color,
+                             GenericVector<BLOB_CHOICE_LIST*>* choices) {
+  // Rotate the blobs for classification if necessary, as call_matcher does.
+  GenericVector<TBLOB*> rotated_blobs;
+  rotated_blobs.reserve(blobs.size());
+  for (int b = 0; b < blobs.size(); ++b) {
+#ifndef GRAPHICS_DISABLED
+    if (wordrec_display_all_blobs)
+      display_blob(blobs[b], color);
+#endif
+    TBLOB* rotated_blob = blobs[b]->ClassifyNormalizeIfNeeded();
+    rotated_blobs.push_back(rotated_blob != NULL ? rotated_blob : blobs[b]);
+  }
+  int first = choices->size();
+  ClassifyBlobBatch(rotated_blobs, choices);
+  for (int b = 0; b < blobs.size(); ++b) {
+    if (rotated_blobs[b] != blobs[b])
+      delete rotated_blobs[b];
+    TruncateBlobChoices(wordrec_max_blob_choices, getDict().getUnicharset(),
+                        (*choices)[first + b]);
+#ifndef GRAPHICS_DISABLED
+    if (classify_debug_level && string)
+      print_ratings_list(string, (*choices)[first + b],
+                         getDict().getUnicharset());
+#endif
+  }
+}
+
 }  // namespace tesseract;
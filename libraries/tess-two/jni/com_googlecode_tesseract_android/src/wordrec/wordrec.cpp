@@ -20,6 +20,7 @@
 
 #include "language_model.h"
 #include "params.h"
+#include "piececache.h"
 
 
 namespace tesseract {
@@ -110,6 +111,19 @@ Wordrec::Wordrec() :
              params()),
   double_MEMBER(segsearch_max_char_wh_ratio, 2.0,
                 "Maximum character width-to-height ratio", params()),
+  INT_MEMBER(wordrec_piece_cache_size, 0,
+             "Number of recently classified pieces whose choices are kept"
+             " for reuse by classify_piece, or 0 for none", params()),
+  INT_MEMBER(wordrec_max_blob_choices, 0,
+             "Number of choices kept for each classified blob, besides the"
+             " first lower case, upper case and digit ones, or 0 for all",
+             params()),
+  INT_MEMBER(segsearch_word_budget_us, 0,
+             "Time limit in microseconds for the segmentation search of a"
+             " word, or 0 for none", params()),
+  INT_MEMBER(segsearch_page_budget_us, 0,
+             "Time limit in microseconds for the segmentation search of all"
+             " the words of a page, or 0 for none", params()),
   BOOL_MEMBER(save_alt_choices, true,
               "Save alternative paths found during chopping"
               " and segmentation search",
@@ -118,10 +132,16 @@ Wordrec::Wordrec() :
   language_model_ = new LanguageModel(&get_fontinfo_table(),
                                       &(getDict()));
   fill_lattice_ = NULL;
+  segsearch_deadline_us_ = 0;
+  segsearch_out_of_time_ = false;
+  segsearch_page_us_ = 0;
+  segsearch_words_out_of_time_ = 0;
+  piece_cache_ = NULL;
 }
 
 Wordrec::~Wordrec() {
   delete language_model_;
+  delete piece_cache_;
 }
 
 }  // namespace tesseract
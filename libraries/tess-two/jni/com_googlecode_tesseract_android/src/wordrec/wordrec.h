@@ -34,6 +34,9 @@ class WERD_RES;
 
 namespace tesseract {
 
+class PieceCache;
+class ThreadPool;
+
 // A class for storing which nodes are to be processed by the segmentation
 // search. There is a single SegSearchPending for each column in the ratings
 // matrix, and it indicates whether the segsearch should combine all
@@ -173,6 +176,18 @@ class Wordrec : public Classify {
             "Maximum number of pain point classifications per word.");
   double_VAR_H(segsearch_max_char_wh_ratio, 2.0,
                "Maximum character width-to-height ratio");
+  INT_VAR_H(wordrec_piece_cache_size, 0,
+            "Number of recently classified pieces whose choices are kept"
+            " for reuse by classify_piece, or 0 for none");
+  INT_VAR_H(wordrec_max_blob_choices, 0,
+            "Number of choices kept for each classified blob, besides the"
+            " first lower case, upper case and digit ones, or 0 for all");
+  INT_VAR_H(segsearch_word_budget_us, 0,
+            "Time limit in microseconds for the segmentation search of a"
+            " word, or 0 for none");
+  INT_VAR_H(segsearch_page_budget_us, 0,
+            "Time limit in microseconds for the segmentation search of all"
+            " the words of a page, or 0 for none");
   BOOL_VAR_H(save_alt_choices, true,
              "Save alternative paths found during chopping "
              "and segmentation search");
@@ -215,6 +230,10 @@ class Wordrec : public Classify {
                                   const char *string,
                                   C_COL color,
                                   BlamerBundle *blamer_bundle);
+  // As classify_blob for each of blobs, without blame, appending the new
+  // lists to *choices. The classifier set-up is shared by the whole batch.
+  void classify_blobs(const GenericVector<TBLOB*>& blobs, const char *string,
+                      C_COL color, GenericVector<BLOB_CHOICE_LIST*>* choices);
 
   // segsearch.cpp
   // SegSearch works on the lower diagonal matrix of BLOB_CHOICE_LISTs.
@@ -287,6 +306,16 @@ class Wordrec : public Classify {
   // or blamer_bundle. Used for testing.
   void DoSegSearch(WERD_RES* word_res);
 
+  // Starts a new page for segsearch_page_budget_us and the count of words
+  // that ran out of time.
+  void ResetSegSearchBudget();
+  // Returns the number of words since ResetSegSearchBudget whose search was
+  // stopped early by segsearch_word_budget_us or segsearch_page_budget_us,
+  // keeping the best choice found so far.
+  int segsearch_words_out_of_time() const {
+    return segsearch_words_out_of_time_;
+  }
+
   // chop.cpp
   PRIORITY point_priority(EDGEPT *point);
   void add_point_to_list(PointHeap* point_heap, EDGEPT *point);
@@ -369,6 +398,20 @@ class Wordrec : public Classify {
                                            const char* description,
                                            TWERD *word,
                                            BlamerBundle *blamer_bundle);
+  // As classify_piece for each single blob in [start, end] of word, without
+  // blame, appending the results to *choices. The blobs are classified
+  // concurrently if RecognitionThreadPool provides a pool, with the same
+  // results as in series.
+  void classify_single_pieces(int start, int end, const char* description,
+                              TWERD *word,
+                              GenericVector<BLOB_CHOICE_LIST*>* choices);
+  // Returns a pool of threads to classify independent blobs on, or NULL to
+  // classify them one at a time.
+  virtual ThreadPool* RecognitionThreadPool() { return NULL; }
+  // Returns the cache used by classify_piece, (re)creating it to match
+  // wordrec_piece_cache_size, or NULL if that is 0.
+  PieceCache* GetPieceCache();
+  const PieceCache* piece_cache() const { return piece_cache_; }
   // Try to merge fragments in the ratings matrix and put the result in
   // the corresponding row and column
   void merge_fragments(MATRIX *ratings,
@@ -421,13 +464,27 @@ class Wordrec : public Classify {
                                  const WERD_CHOICE_LIST &best_choices,
                                  const UNICHARSET &unicharset,
                                  BlamerBundle *blamer_bundle);
+  // Time of day in microseconds after which the search of the current word
+  // must stop, or 0 for no limit.
+  inT64 segsearch_deadline_us_;
+  // Set once the search of the current word has passed the deadline.
+  bool segsearch_out_of_time_;
+  // Microseconds spent in SegSearch, and number of words that ran out of
+  // time, since ResetSegSearchBudget.
+  inT64 segsearch_page_us_;
+  int segsearch_words_out_of_time_;
+  // Choices of recently classified pieces, if enabled.
+  PieceCache* piece_cache_;
 
  protected:
   inline bool SegSearchDone(int num_futile_classifications) {
     return (language_model_->AcceptableChoiceFound() ||
             num_futile_classifications >=
-            segsearch_max_futile_classifications);
+            segsearch_max_futile_classifications ||
+            SegSearchOutOfTime());
   }
+  // Returns true if the search of the current word has passed its deadline.
+  bool SegSearchOutOfTime();
 
   // Updates the language model state recorded for the child entries specified
   // in pending[starting_col]. Enqueues the children of the updated entries
@@ -465,13 +522,16 @@ class Wordrec : public Classify {
 
   // Process the given pain point: classify the corresponding blob, enqueue
   // new pain points to join the newly classified blob with its neighbors.
+  // If classified is not NULL, it is taken as the result of classifying the
+  // blob, and ProcessSegSearchPainPoint takes ownership of it.
   void ProcessSegSearchPainPoint(float pain_point_priority,
                                  const MATRIX_COORD &pain_point,
                                  const char* pain_point_type,
                                  GenericVector<SegSearchPending>* pending,
                                  WERD_RES *word_res,
                                  LMPainPoints *pain_points,
-                                 BlamerBundle *blamer_bundle);
+                                 BlamerBundle *blamer_bundle,
+                                 BLOB_CHOICE_LIST *classified = NULL);
   // Resets enough of the results so that the Viterbi search is re-run.
   // Needed when the n-gram model is enabled, as the multi-length comparison
   // implementation will re-value existing paths to worse values.
@@ -17,14 +17,44 @@
 
 #include <stdio.h>
 #include <malloc.h>
+#include <math.h>
+#include <pthread.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "android/asset_manager.h"
+#include "android/asset_manager_jni.h"
 #include "android/bitmap.h"
 #include "common.h"
 #include "baseapi.h"
+#include "docpipeline.h"
+#include "memoryusage.h"
 #include "ocrclass.h"
 #include "allheaders.h"
 #include "renderer.h"
+#include "tessdatamanager.h"
+#include "tesseractclass.h"
 
+static JavaVM *javaVm;
 static jmethodID method_onProgressValues;
+static jmethodID method_onAsyncRecognitionComplete;
+
+// Layout of the progress buffer returned by nativeSetProgressPolling, in
+// jints: a sequence number, which is odd while the values are being written,
+// followed by the values passed to onProgressValues.
+static const int kProgressSequence = 0;
+static const int kProgressValuesStart = 1;
+static const int kProgressValueCount = 9;
+static const int kProgressBufferSize = kProgressValuesStart + kProgressValueCount;
+
+// A page queued by nativeRecognizeAsync.
+struct async_job_t {
+  PIX *pix;
+  jobject callback;  // global reference
+  // Set by nativeStop, on another thread. Unlike cancel_ocr, never reset, so
+  // a stop that comes before the worker starts the page is not lost.
+  volatile bool cancelled;
+};
 
 struct native_data_t {
   tesseract::TessBaseAPI api;
@@ -34,11 +64,42 @@ struct native_data_t {
 
   Box* currentTextBox = NULL;
   l_int32 lastProgress;
-  bool cancel_ocr;
+  // Set by nativeStop, on another thread.
+  volatile bool cancel_ocr;
 
+  // The thread recognizing and its Java TessBaseAPI, to report progress to.
+  // Both are only valid on that thread.
   JNIEnv *cachedEnv;
   jobject* cachedObject;
 
+  // Worker thread that recognizes the pages queued by nativeRecognizeAsync,
+  // one at a time and in order. Started on first use.
+  pthread_t asyncWorker;
+  bool asyncWorkerStarted;
+  bool asyncShutdown;
+  pthread_mutex_t asyncMutex;
+  pthread_cond_t asyncCond;
+  GenericVector<async_job_t*> asyncJobs;
+  // The page the worker is on, or NULL. Guarded by asyncMutex.
+  async_job_t *asyncCurrentJob;
+  // Global reference to the Java TessBaseAPI, for calls from the worker.
+  jobject asyncObject;
+
+  // Buffer behind the ByteBuffer returned by nativeGetResultsPacked. Kept
+  // until the next call or nativeEnd.
+  char *packedResults;
+
+  // Progress is only sent to Java once it has advanced by progressMinStep
+  // percent, and progressMinIntervalMs have passed, since it was last sent.
+  int progressMinStep;
+  int progressMinIntervalMs;
+  long long lastProgressTimeMs;
+  // Buffer behind the ByteBuffer returned by nativeSetProgressPolling. Kept
+  // until nativeEnd, so that Java may still hold it after polling stops.
+  volatile jint *progressBuffer;
+  // Whether progress is written to progressBuffer instead of sent to Java.
+  bool progressPolling;
+
   bool isStateValid() {
     if (cancel_ocr == false && cachedEnv != NULL && cachedObject != NULL) {
       return true;
@@ -57,6 +118,7 @@ struct native_data_t {
     cachedEnv = env;
     cachedObject = object;
     lastProgress = 0;
+    lastProgressTimeMs = 0;
   }
 
   void resetStateVariables() {
@@ -76,10 +138,26 @@ struct native_data_t {
     cachedEnv = NULL;
     cachedObject = NULL;
     cancel_ocr = false;
+    asyncWorkerStarted = false;
+    asyncShutdown = false;
+    asyncCurrentJob = NULL;
+    asyncObject = NULL;
+    packedResults = NULL;
+    progressMinStep = 0;
+    progressMinIntervalMs = 0;
+    lastProgressTimeMs = 0;
+    progressBuffer = NULL;
+    progressPolling = false;
+    pthread_mutex_init(&asyncMutex, NULL);
+    pthread_cond_init(&asyncCond, NULL);
   }
 
   ~native_data_t() {
 	  boxDestroy(&currentTextBox);
+	  delete[] packedResults;
+	  delete[] progressBuffer;
+	  pthread_cond_destroy(&asyncCond);
+	  pthread_mutex_destroy(&asyncMutex);
   }
 };
 
@@ -91,14 +169,74 @@ bool cancelFunc(void* cancel_this, int words) {
   return nat->cancel_ocr;
 }
 
+/**
+ * Callback for Tesseract's monitor to cancel a page queued by
+ * nativeRecognizeAsync.
+ */
+bool asyncCancelFunc(void* cancel_this, int words) {
+  async_job_t *job = (async_job_t*)cancel_this;
+  return job->cancelled;
+}
+
+/**
+ * Cancels the page the worker is on and the pages still queued. Must be
+ * called with asyncMutex held.
+ */
+static void cancelAsyncJobs(native_data_t *nat) {
+  if (nat->asyncCurrentJob != NULL)
+    nat->asyncCurrentJob->cancelled = true;
+  for (int i = 0; i < nat->asyncJobs.size(); ++i)
+    nat->asyncJobs[i]->cancelled = true;
+}
+
+static long long monotonicTimeMs() {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (long long) now.tv_sec * 1000 + now.tv_nsec / 1000000;
+}
+
+/**
+ * Writes the given progress values to the polled progress buffer. The
+ * sequence number is odd while they are written, so that the reader can tell
+ * whether it saw a consistent set.
+ */
+static void writeProgressBuffer(volatile jint *buffer, const jint *values) {
+  buffer[kProgressSequence]++;
+  __sync_synchronize();
+  for (int i = 0; i < kProgressValueCount; i++)
+    buffer[kProgressValuesStart + i] = values[i];
+  __sync_synchronize();
+  buffer[kProgressSequence]++;
+}
+
 /**
  * Callback for Tesseract's monitor to update progress.
  */
 bool progressJavaCallback(void* progress_this, int progress, int left, int right,
 		int top, int bottom) {
   native_data_t *nat = (native_data_t*)progress_this;
+  if (nat->progressPolling) {
+    // Never blocks on Java, so it doesn't need throttling.
+    int x = 0, y = 0, width = 0, height = 0;
+    if (nat->currentTextBox != NULL)
+      boxGetGeometry(nat->currentTextBox, &x, &y, &width, &height);
+    jint values[kProgressValueCount] = { progress, left, right, top, bottom,
+        x, x + width, y + height, y };
+    writeProgressBuffer(nat->progressBuffer, values);
+    return true;
+  }
+  JNIEnv *env;
+  if (javaVm->GetEnv((void**) &env, JNI_VERSION_1_6) != JNI_OK ||
+      env != nat->cachedEnv)
+    return true;  // Called from a thread that can't use the cached state.
   if (nat->isStateValid() && nat->currentTextBox != NULL) {
-    if (progress > nat->lastProgress || left != 0 || right != 0 || top != 0 || bottom != 0) {
+    if ((progress > nat->lastProgress || left != 0 || right != 0 || top != 0 || bottom != 0) &&
+        progress - nat->lastProgress >= nat->progressMinStep) {
+      long long now = monotonicTimeMs();
+      if (nat->progressMinIntervalMs > 0 &&
+          now - nat->lastProgressTimeMs < nat->progressMinIntervalMs)
+        return true;
+      nat->lastProgressTimeMs = now;
       int x, y, width, height;
       boxGetGeometry(nat->currentTextBox, &x, &y, &width, &height);
       nat->cachedEnv->CallVoidMethod(*(nat->cachedObject), method_onProgressValues, progress,
@@ -110,6 +248,102 @@ bool progressJavaCallback(void* progress_this, int progress, int left, int right
   return true;
 }
 
+/**
+ * Recognizes one queued page on the worker thread and hands the result
+ * iterator to Java. The iterator is deleted by Java once the callback returns,
+ * before the next page is recognized.
+ */
+static void runAsyncJob(JNIEnv *env, native_data_t *nat, async_job_t *job) {
+  jlong iterator = 0;
+  if (job->cancelled) {
+    LOGI("Asynchronous recognition cancelled before it started");
+  } else {
+    nat->api.SetImage(job->pix);
+    nat->initStateVariables(env, &nat->asyncObject);
+
+    ETEXT_DESC monitor;
+    monitor.progress_callback = progressJavaCallback;
+    monitor.cancel = asyncCancelFunc;
+    monitor.cancel_this = job;
+    monitor.progress_this = nat;
+
+    if (nat->api.Recognize(&monitor) == 0) {
+      iterator = (jlong) nat->api.GetIterator();
+    } else if (job->cancelled) {
+      LOGI("Asynchronous recognition cancelled");
+    } else {
+      LOGE("Asynchronous recognition failed");
+    }
+    nat->resetStateVariables();
+  }
+
+  env->CallVoidMethod(nat->asyncObject, method_onAsyncRecognitionComplete,
+                      job->callback, iterator);
+  if (env->ExceptionCheck()) {
+    LOGE("Exception thrown by recognition callback");
+    env->ExceptionDescribe();
+    env->ExceptionClear();
+  }
+  env->DeleteGlobalRef(job->callback);
+  pixDestroy(&job->pix);
+}
+
+static void *asyncWorkerMain(void *arg) {
+  native_data_t *nat = (native_data_t*) arg;
+  JNIEnv *env;
+
+  if (javaVm->AttachCurrentThread(&env, NULL) != JNI_OK) {
+    LOGE("Failed to attach the recognition worker to the VM");
+    return NULL;
+  }
+  pthread_mutex_lock(&nat->asyncMutex);
+  while (!nat->asyncShutdown) {
+    if (nat->asyncJobs.empty()) {
+      pthread_cond_wait(&nat->asyncCond, &nat->asyncMutex);
+      continue;
+    }
+    async_job_t *job = nat->asyncJobs[0];
+    nat->asyncJobs.remove(0);
+    nat->asyncCurrentJob = job;
+    pthread_mutex_unlock(&nat->asyncMutex);
+    runAsyncJob(env, nat, job);
+    pthread_mutex_lock(&nat->asyncMutex);
+    nat->asyncCurrentJob = NULL;
+    delete job;
+  }
+  pthread_mutex_unlock(&nat->asyncMutex);
+  javaVm->DetachCurrentThread();
+  return NULL;
+}
+
+/**
+ * Stops the worker after the page it is working on, and drops the pages that
+ * are still queued without calling their callbacks.
+ */
+static void stopAsyncWorker(JNIEnv *env, native_data_t *nat) {
+  if (!nat->asyncWorkerStarted)
+    return;
+
+  pthread_mutex_lock(&nat->asyncMutex);
+  nat->asyncShutdown = true;
+  if (nat->asyncCurrentJob != NULL)
+    nat->asyncCurrentJob->cancelled = true;
+  pthread_cond_signal(&nat->asyncCond);
+  pthread_mutex_unlock(&nat->asyncMutex);
+  pthread_join(nat->asyncWorker, NULL);
+
+  for (int i = 0; i < nat->asyncJobs.size(); ++i) {
+    env->DeleteGlobalRef(nat->asyncJobs[i]->callback);
+    pixDestroy(&nat->asyncJobs[i]->pix);
+    delete nat->asyncJobs[i];
+  }
+  nat->asyncJobs.clear();
+  env->DeleteGlobalRef(nat->asyncObject);
+  nat->asyncObject = NULL;
+  nat->asyncWorkerStarted = false;
+  nat->asyncShutdown = false;
+}
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -122,6 +356,8 @@ jint JNI_OnLoad(JavaVM* vm, void* reserved) {
     return -1;
   }
 
+  javaVm = vm;
+
   return JNI_VERSION_1_6;
 }
 
@@ -129,6 +365,8 @@ void Java_com_googlecode_tesseract_android_TessBaseAPI_nativeClassInit(JNIEnv* e
                                                                        jclass clazz) {
 
   method_onProgressValues = env->GetMethodID(clazz, "onProgressValues", "(IIIIIIIII)V");
+  method_onAsyncRecognitionComplete = env->GetMethodID(clazz, "onAsyncRecognitionComplete",
+      "(Lcom/googlecode/tesseract/android/TessBaseAPI$RecognitionCallback;J)V");
 }
 
 jlong Java_com_googlecode_tesseract_android_TessBaseAPI_nativeConstruct(JNIEnv* env,
@@ -144,6 +382,27 @@ jlong Java_com_googlecode_tesseract_android_TessBaseAPI_nativeConstruct(JNIEnv*
   return (jlong) nat;
 }
 
+jboolean Java_com_googlecode_tesseract_android_TessBaseAPI_nativePreloadLanguages(JNIEnv *env,
+                                                                                  jobject thiz,
+                                                                                  jstring dir,
+                                                                                  jstring lang) {
+
+  const char *c_dir = env->GetStringUTFChars(dir, NULL);
+  const char *c_lang = env->GetStringUTFChars(lang, NULL);
+
+  jboolean res = JNI_TRUE;
+
+  if (!tesseract::TessBaseAPI::PreloadLanguages(c_dir, c_lang)) {
+    LOGE("Could not start preloading language=%s!", c_lang);
+    res = JNI_FALSE;
+  }
+
+  env->ReleaseStringUTFChars(dir, c_dir);
+  env->ReleaseStringUTFChars(lang, c_lang);
+
+  return res;
+}
+
 jboolean Java_com_googlecode_tesseract_android_TessBaseAPI_nativeInit(JNIEnv *env,
                                                                       jobject thiz,
                                                                       jlong mNativeData,
@@ -197,6 +456,86 @@ jboolean Java_com_googlecode_tesseract_android_TessBaseAPI_nativeInitOem(JNIEnv
   return res;
 }
 
+// Data path under which traineddata registered from the APK assets is found.
+static const char kAssetDataPath[] = "/android_asset/";
+
+// Makes kAssetDataPath/tessdata/<lang>.traineddata refer to the asset
+// tessdata/<lang>.traineddata, which must be stored uncompressed.
+static bool registerAssetTrainedData(AAssetManager *manager, const char *lang) {
+  STRING asset_name = "tessdata/";
+  asset_name += lang;
+  asset_name += ".";
+  asset_name += kTrainedDataSuffix;
+  AAsset *asset = AAssetManager_open(manager, asset_name.string(),
+                                     AASSET_MODE_UNKNOWN);
+  if (asset == NULL) {
+    return false;
+  }
+  off_t start, length;
+  int fd = AAsset_openFileDescriptor(asset, &start, &length);
+  AAsset_close(asset);
+  if (fd < 0) {
+    LOGE("Asset %s is compressed and can not be mapped", asset_name.string());
+    return false;
+  }
+  STRING data_file_name = kAssetDataPath;
+  data_file_name += asset_name;
+  bool res = tesseract::TessdataManager::RegisterFileDescriptor(
+      data_file_name.string(), fd, start, length);
+  close(fd);
+  return res;
+}
+
+jboolean Java_com_googlecode_tesseract_android_TessBaseAPI_nativeInitFromAssets(JNIEnv *env,
+                                                                                jobject thiz,
+                                                                                jlong mNativeData,
+                                                                                jobject assetManager,
+                                                                                jstring lang,
+                                                                                jint mode) {
+
+  native_data_t *nat = (native_data_t*) mNativeData;
+
+  AAssetManager *manager = AAssetManager_fromJava(env, assetManager);
+  if (manager == NULL) {
+    LOGE("Could not get the native asset manager");
+    return JNI_FALSE;
+  }
+
+  const char *c_lang = env->GetStringUTFChars(lang, NULL);
+
+  jboolean res = JNI_TRUE;
+
+  // Register every requested language, and osd for orientation detection.
+  GenericVector<STRING> langs;
+  STRING(c_lang).split('+', &langs);
+  for (int i = 0; i < langs.size() && res; ++i) {
+    if (langs[i].length() > 0 && langs[i][0] != '~' &&
+        !registerAssetTrainedData(manager, langs[i].string())) {
+      LOGE("Could not open asset tessdata/%s.traineddata", langs[i].string());
+      res = JNI_FALSE;
+    }
+  }
+  registerAssetTrainedData(manager, "osd");
+
+  if (res) {
+    // Assets can not change under us, so the dawgs can be used in place.
+    GenericVector<STRING> vars_vec, vars_values;
+    vars_vec.push_back("map_dawgs_in_place");
+    vars_values.push_back("1");
+    if (nat->api.Init(kAssetDataPath, c_lang, (tesseract::OcrEngineMode) mode,
+                      NULL, 0, &vars_vec, &vars_values, false)) {
+      LOGE("Could not initialize Tesseract API with language=%s!", c_lang);
+      res = JNI_FALSE;
+    } else {
+      LOGI("Initialized Tesseract API from assets with language=%s", c_lang);
+    }
+  }
+
+  env->ReleaseStringUTFChars(lang, c_lang);
+
+  return res;
+}
+
 jstring Java_com_googlecode_tesseract_android_TessBaseAPI_nativeGetInitLanguagesAsString(JNIEnv *env,
                                                                                          jobject thiz,
                                                                                          jlong mNativeData) {
@@ -212,6 +551,25 @@ jstring Java_com_googlecode_tesseract_android_TessBaseAPI_nativeGetInitLanguages
 }
 
 
+/**
+ * Hands raw image bytes to the thresholder and drops any image previously
+ * owned by the native struct. The thresholder converts the bytes into its own
+ * Pix during the call, so the source memory only needs to stay valid until
+ * this function returns.
+ */
+static void setImageRaw(native_data_t *nat, const unsigned char *imagedata, int width,
+                        int height, int bpp, int bpl) {
+  nat->api.SetImage(imagedata, width, height, bpp, bpl);
+  nat->setTextBoundaries(0, 0, width, height);
+
+  if (nat->data != NULL)
+    free(nat->data);
+  else if (nat->pix != NULL)
+    pixDestroy(&nat->pix);
+  nat->data = NULL;
+  nat->pix = NULL;
+}
+
 void Java_com_googlecode_tesseract_android_TessBaseAPI_nativeSetImageBytes(JNIEnv *env,
                                                                            jobject thiz,
                                                                            jlong mNativeData,
@@ -221,32 +579,183 @@ void Java_com_googlecode_tesseract_android_TessBaseAPI_nativeSetImageBytes(JNIEn
                                                                            jint bpp,
                                                                            jint bpl) {
 
-  jbyte *data_array = env->GetByteArrayElements(data, NULL);
-  int count = env->GetArrayLength(data);
-  unsigned char* imagedata = (unsigned char *) malloc(count * sizeof(unsigned char));
+  native_data_t *nat = (native_data_t*) mNativeData;
 
-  // This is painfully slow, but necessary because we don't know
-  // how many bits the JVM might be using to represent a byte
-  for (int i = 0; i < count; i++) {
-    imagedata[i] = (unsigned char) data_array[i];
+  // Pin the array instead of copying it. No JNI calls may be made until the
+  // critical section is released, and SetImage doesn't make any.
+  void *data_array = env->GetPrimitiveArrayCritical(data, NULL);
+  if (data_array == NULL) {
+    LOGE("%s: could not access image data!", __FUNCTION__);
+    return;
   }
 
-  env->ReleaseByteArrayElements(data, data_array, JNI_ABORT);
+  setImageRaw(nat, (const unsigned char *) data_array, (int) width, (int) height,
+              (int) bpp, (int) bpl);
+
+  env->ReleasePrimitiveArrayCritical(data, data_array, JNI_ABORT);
+}
+
+jboolean Java_com_googlecode_tesseract_android_TessBaseAPI_nativeSetImageDirectBuffer(JNIEnv *env,
+                                                                                    jobject thiz,
+                                                                                    jlong mNativeData,
+                                                                                    jobject buffer,
+                                                                                    jint width,
+                                                                                    jint height,
+                                                                                    jint bpp,
+                                                                                    jint bpl) {
 
   native_data_t *nat = (native_data_t*) mNativeData;
-  nat->api.SetImage(imagedata, (int) width, (int) height, (int) bpp, (int) bpl);
 
-  // Since Tesseract doesn't take ownership of the memory, we keep a pointer in the native
-  // code struct. We need to free that pointer when we release our instance of Tesseract or
-  // attempt to set a new image using one of the nativeSet* methods.
+  unsigned char *imagedata = (unsigned char *) env->GetDirectBufferAddress(buffer);
+  jlong capacity = env->GetDirectBufferCapacity(buffer);
+
+  if (imagedata == NULL || capacity < 0) {
+    LOGE("%s: buffer is not a direct buffer!", __FUNCTION__);
+    return JNI_FALSE;
+  }
+  if (capacity < (jlong) bpl * height) {
+    LOGE("%s: buffer holds %lld bytes, need %lld!", __FUNCTION__, (long long) capacity,
+         (long long) bpl * height);
+    return JNI_FALSE;
+  }
+
+  setImageRaw(nat, imagedata, (int) width, (int) height, (int) bpp, (int) bpl);
+
+  return JNI_TRUE;
+}
+
+jboolean Java_com_googlecode_tesseract_android_TessBaseAPI_nativeSetImageBitmap(JNIEnv *env,
+                                                                              jobject thiz,
+                                                                              jlong mNativeData,
+                                                                              jobject bitmap) {
+
+  native_data_t *nat = (native_data_t*) mNativeData;
+  AndroidBitmapInfo info;
+  void* pixels;
+  int ret;
+
+  if ((ret = AndroidBitmap_getInfo(env, bitmap, &info)) < 0) {
+    LOGE("AndroidBitmap_getInfo() failed! error=%d", ret);
+    return JNI_FALSE;
+  }
+
+  if (info.format != ANDROID_BITMAP_FORMAT_RGBA_8888) {
+    LOGE("Bitmap format is not RGBA_8888!");
+    return JNI_FALSE;
+  }
+
+  if ((ret = AndroidBitmap_lockPixels(env, bitmap, &pixels)) < 0) {
+    LOGE("AndroidBitmap_lockPixels() failed! error=%d", ret);
+    return JNI_FALSE;
+  }
+
+  // Convert the locked rows straight into the thresholder's grey image.
+  nat->api.SetRGBAImageAsGrey((const unsigned char *) pixels, (int) info.width,
+                              (int) info.height, (int) info.stride);
+
+  AndroidBitmap_unlockPixels(env, bitmap);
+
+  nat->setTextBoundaries(0, 0, info.width, info.height);
+
+  // Tesseract keeps its own copy, so there is nothing left for us to hold on to.
+  if (nat->data != NULL)
+    free(nat->data);
+  else if (nat->pix != NULL)
+    pixDestroy(&nat->pix);
+  nat->data = NULL;
+  nat->pix = NULL;
+
+  return JNI_TRUE;
+}
+
+/**
+ * Returns whether a plane of the given size fits in len bytes, logging why
+ * not if it doesn't. Only the first width bytes of the last row are needed.
+ */
+static bool checkPlaneSize(jlong len, int width, int height, int rowStride) {
+  if (width <= 0 || height <= 0 || rowStride < width) {
+    LOGE("Invalid plane size %dx%d with row stride %d!", width, height, rowStride);
+    return false;
+  }
+  jlong needed = (jlong) rowStride * (height - 1) + width;
+  if (len < needed) {
+    LOGE("Plane holds %lld bytes, need %lld!", (long long) len, (long long) needed);
+    return false;
+  }
+  return true;
+}
+
+/**
+ * Hands the Y plane of a camera frame to Tesseract as its grey image and drops
+ * any image previously owned by the native struct. Tesseract copies the plane
+ * during the call, so it only needs to stay valid until this returns.
+ */
+static void setImageGrey(native_data_t *nat, const unsigned char *grey, int width,
+                         int height, int rowStride) {
+  nat->api.SetGreyImage(grey, width, height, rowStride);
+  nat->setTextBoundaries(0, 0, width, height);
+
   if (nat->data != NULL)
     free(nat->data);
   else if (nat->pix != NULL)
     pixDestroy(&nat->pix);
-  nat->data = imagedata;
+  nat->data = NULL;
   nat->pix = NULL;
 }
 
+jboolean Java_com_googlecode_tesseract_android_TessBaseAPI_nativeSetImageYUVBytes(JNIEnv *env,
+                                                                                jobject thiz,
+                                                                                jlong mNativeData,
+                                                                                jbyteArray data,
+                                                                                jint width,
+                                                                                jint height,
+                                                                                jint rowStride) {
+
+  native_data_t *nat = (native_data_t*) mNativeData;
+
+  if (!checkPlaneSize(env->GetArrayLength(data), width, height, rowStride))
+    return JNI_FALSE;
+
+  // Pin the array as nativeSetImageBytes does.
+  void *data_array = env->GetPrimitiveArrayCritical(data, NULL);
+  if (data_array == NULL) {
+    LOGE("%s: could not access image data!", __FUNCTION__);
+    return JNI_FALSE;
+  }
+
+  setImageGrey(nat, (const unsigned char *) data_array, (int) width, (int) height,
+               (int) rowStride);
+
+  env->ReleasePrimitiveArrayCritical(data, data_array, JNI_ABORT);
+
+  return JNI_TRUE;
+}
+
+jboolean Java_com_googlecode_tesseract_android_TessBaseAPI_nativeSetImageYUVDirectBuffer(JNIEnv *env,
+                                                                                       jobject thiz,
+                                                                                       jlong mNativeData,
+                                                                                       jobject buffer,
+                                                                                       jint width,
+                                                                                       jint height,
+                                                                                       jint rowStride) {
+
+  native_data_t *nat = (native_data_t*) mNativeData;
+
+  unsigned char *grey = (unsigned char *) env->GetDirectBufferAddress(buffer);
+  jlong capacity = env->GetDirectBufferCapacity(buffer);
+
+  if (grey == NULL || capacity < 0) {
+    LOGE("%s: buffer is not a direct buffer!", __FUNCTION__);
+    return JNI_FALSE;
+  }
+  if (!checkPlaneSize(capacity, width, height, rowStride))
+    return JNI_FALSE;
+
+  setImageGrey(nat, grey, (int) width, (int) height, (int) rowStride);
+
+  return JNI_TRUE;
+}
+
 void Java_com_googlecode_tesseract_android_TessBaseAPI_nativeSetImagePix(JNIEnv *env,
                                                                          jobject thiz,
                                                                          jlong mNativeData,
@@ -303,7 +812,324 @@ jstring Java_com_googlecode_tesseract_android_TessBaseAPI_nativeGetUTF8Text(JNIE
   free(text);
   nat->resetStateVariables();
 
-  return result;
+  return result;
+}
+
+jstring Java_com_googlecode_tesseract_android_TessBaseAPI_nativeRecognizeFrame(JNIEnv *env,
+                                                                               jobject thiz,
+                                                                               jlong mNativeData) {
+
+  native_data_t *nat = (native_data_t*) mNativeData;
+
+  if (nat->api.RecognizeFrame(NULL) < 0) {
+    LOGE("Could not recognize frame!");
+    return NULL;
+  }
+
+  char *text = nat->api.GetFrameText();
+  jstring result = env->NewStringUTF(text != NULL ? text : "");
+  delete[] text;
+
+  return result;
+}
+
+jstring Java_com_googlecode_tesseract_android_TessBaseAPI_nativeRecognizeTextRegions(JNIEnv *env,
+                                                                                     jobject thiz,
+                                                                                     jlong mNativeData,
+                                                                                     jint reduction,
+                                                                                     jint pageSegMode) {
+
+  native_data_t *nat = (native_data_t*) mNativeData;
+
+  char *text = nat->api.RecognizeTextRegions(reduction,
+                                             (tesseract::PageSegMode) pageSegMode,
+                                             NULL, NULL, NULL);
+  if (text == NULL) {
+    LOGE("Could not recognize text regions!");
+    return NULL;
+  }
+
+  jstring result = env->NewStringUTF(text);
+  delete[] text;
+
+  return result;
+}
+
+void Java_com_googlecode_tesseract_android_TessBaseAPI_nativeClearFrameHistory(JNIEnv *env,
+                                                                               jobject thiz,
+                                                                               jlong mNativeData) {
+
+  native_data_t *nat = (native_data_t*) mNativeData;
+
+  nat->api.ClearFrameHistory();
+}
+
+void Java_com_googlecode_tesseract_android_TessBaseAPI_nativeResetForNewDocument(JNIEnv *env,
+                                                                                  jobject thiz,
+                                                                                  jlong mNativeData,
+                                                                                  jboolean keepAdaptive) {
+
+  native_data_t *nat = (native_data_t*) mNativeData;
+
+  nat->api.ResetForNewDocument(keepAdaptive == JNI_TRUE);
+}
+
+jbyteArray Java_com_googlecode_tesseract_android_TessBaseAPI_nativeSaveAdaptiveState(JNIEnv *env,
+                                                                                     jobject thiz,
+                                                                                     jlong mNativeData) {
+
+  native_data_t *nat = (native_data_t*) mNativeData;
+
+  GenericVector<char> buffer;
+  if (!nat->api.SaveAdaptiveState(&buffer)) {
+    LOGE("Could not save adaptive state!");
+    return NULL;
+  }
+
+  jbyteArray result = env->NewByteArray(buffer.size());
+  if (result != NULL && buffer.size() > 0)
+    env->SetByteArrayRegion(result, 0, buffer.size(), (jbyte*) &buffer[0]);
+
+  return result;
+}
+
+jboolean Java_com_googlecode_tesseract_android_TessBaseAPI_nativeLoadAdaptiveState(JNIEnv *env,
+                                                                                   jobject thiz,
+                                                                                   jlong mNativeData,
+                                                                                   jbyteArray state) {
+
+  native_data_t *nat = (native_data_t*) mNativeData;
+
+  jsize size = env->GetArrayLength(state);
+  jbyte *data = env->GetByteArrayElements(state, NULL);
+  bool loaded = nat->api.LoadAdaptiveState((const char*) data, size);
+  env->ReleaseByteArrayElements(state, data, JNI_ABORT);
+
+  if (!loaded)
+    LOGE("Could not load adaptive state!");
+
+  return loaded ? JNI_TRUE : JNI_FALSE;
+}
+
+jbyteArray Java_com_googlecode_tesseract_android_TessBaseAPI_nativeGetParamsSnapshot(JNIEnv *env,
+                                                                                     jobject thiz,
+                                                                                     jlong mNativeData) {
+
+  native_data_t *nat = (native_data_t*) mNativeData;
+
+  GenericVector<char> buffer;
+  if (!nat->api.GetParamsSnapshot(&buffer)) {
+    LOGE("Could not snapshot parameters!");
+    return NULL;
+  }
+
+  jbyteArray result = env->NewByteArray(buffer.size());
+  if (result != NULL && buffer.size() > 0)
+    env->SetByteArrayRegion(result, 0, buffer.size(), (jbyte*) &buffer[0]);
+
+  return result;
+}
+
+void Java_com_googlecode_tesseract_android_TessBaseAPI_nativeSetParamsSnapshot(JNIEnv *env,
+                                                                               jobject thiz,
+                                                                               jlong mNativeData,
+                                                                               jbyteArray snapshot) {
+
+  native_data_t *nat = (native_data_t*) mNativeData;
+
+  if (snapshot == NULL) {
+    nat->api.SetParamsSnapshot(NULL, 0);
+    return;
+  }
+
+  jsize size = env->GetArrayLength(snapshot);
+  jbyte *data = env->GetByteArrayElements(snapshot, NULL);
+  nat->api.SetParamsSnapshot((const char*) data, size);
+  env->ReleaseByteArrayElements(snapshot, data, JNI_ABORT);
+}
+
+jboolean Java_com_googlecode_tesseract_android_TessBaseAPI_nativeSetCharNgramTable(JNIEnv *env,
+                                                                                   jobject thiz,
+                                                                                   jlong mNativeData,
+                                                                                   jbyteArray table) {
+
+  native_data_t *nat = (native_data_t*) mNativeData;
+
+  jsize size = env->GetArrayLength(table);
+  jbyte *data = env->GetByteArrayElements(table, NULL);
+  bool set = nat->api.SetCharNgramTable((const char*) data, size);
+  env->ReleaseByteArrayElements(table, data, JNI_ABORT);
+
+  if (!set)
+    LOGE("Could not set character ngram table!");
+
+  return set ? JNI_TRUE : JNI_FALSE;
+}
+
+jobjectArray Java_com_googlecode_tesseract_android_TessBaseAPI_nativeRecognizeRegions(JNIEnv *env,
+                                                                                      jobject thiz,
+                                                                                      jlong mNativeData,
+                                                                                      jintArray boxes,
+                                                                                      jint pageSegMode,
+                                                                                      jintArray confidences) {
+
+  native_data_t *nat = (native_data_t*) mNativeData;
+
+  int count = env->GetArrayLength(boxes) / 4;
+  jint *coords = env->GetIntArrayElements(boxes, NULL);
+  BOXA *regions = boxaCreate(count);
+  for (int i = 0; i < count; i++) {
+    boxaAddBox(regions, boxCreate(coords[i * 4], coords[i * 4 + 1],
+                                  coords[i * 4 + 2], coords[i * 4 + 3]), L_INSERT);
+  }
+  env->ReleaseIntArrayElements(boxes, coords, JNI_ABORT);
+
+  int *confs = confidences != NULL ? new int[count] : NULL;
+  char *text = nat->api.RecognizeRegions(regions, (tesseract::PageSegMode) pageSegMode,
+                                         NULL, confs);
+  boxaDestroy(&regions);
+
+  if (text == NULL) {
+    LOGE("Could not recognize regions!");
+    delete[] confs;
+    return NULL;
+  }
+
+  jobjectArray result = env->NewObjectArray(count, env->FindClass("java/lang/String"), NULL);
+  const char *region_text = text;
+  for (int i = 0; i < count; i++) {
+    jstring str = env->NewStringUTF(region_text);
+    env->SetObjectArrayElement(result, i, str);
+    env->DeleteLocalRef(str);
+    region_text += strlen(region_text) + 1;
+  }
+  delete[] text;
+
+  if (confs != NULL) {
+    env->SetIntArrayRegion(confidences, 0, count, confs);
+    delete[] confs;
+  }
+
+  return result;
+}
+
+jfloatArray Java_com_googlecode_tesseract_android_TessBaseAPI_nativeDetectTextLines(JNIEnv *env,
+                                                                                   jobject thiz,
+                                                                                   jlong mNativeData) {
+
+  native_data_t *nat = (native_data_t*) mNativeData;
+
+  NUMA *scores = NULL;
+  BOXA *boxa = nat->api.DetectTextLines(&scores);
+
+  if (boxa == NULL) {
+    LOGE("Could not detect text lines!");
+    return NULL;
+  }
+
+  // Left, top, right, bottom and score of each line.
+  int count = boxaGetCount(boxa);
+  jfloat *values = new jfloat[count * 5];
+  for (int i = 0; i < count; i++) {
+    l_int32 x, y, w, h;
+    l_float32 score;
+    boxaGetBoxGeometry(boxa, i, &x, &y, &w, &h);
+    numaGetFValue(scores, i, &score);
+    values[i * 5] = x;
+    values[i * 5 + 1] = y;
+    values[i * 5 + 2] = x + w;
+    values[i * 5 + 3] = y + h;
+    values[i * 5 + 4] = score;
+  }
+  boxaDestroy(&boxa);
+  numaDestroy(&scores);
+
+  jfloatArray ret = env->NewFloatArray(count * 5);
+
+  LOG_ASSERT((ret != NULL), "Could not create Java text line array!");
+
+  env->SetFloatArrayRegion(ret, 0, count * 5, values);
+  delete[] values;
+
+  return ret;
+}
+
+jobjectArray Java_com_googlecode_tesseract_android_TessBaseAPI_nativeRecognizeTables(JNIEnv *env,
+                                                                                     jobject thiz,
+                                                                                     jlong mNativeData,
+                                                                                     jint pageSegMode) {
+
+  native_data_t *nat = (native_data_t*) mNativeData;
+
+  int count = nat->api.RecognizeTables((tesseract::PageSegMode) pageSegMode, NULL);
+  if (count < 0) {
+    LOGE("Could not recognize tables!");
+    return NULL;
+  }
+
+  jclass stringClass = env->FindClass("java/lang/String");
+  jclass rowClass = env->FindClass("[Ljava/lang/String;");
+  jclass tableClass = env->FindClass("[[Ljava/lang/String;");
+  jobjectArray result = env->NewObjectArray(count, tableClass, NULL);
+  for (int t = 0; t < count; t++) {
+    int rows, columns;
+    BOXA *cells = nat->api.GetTableCells(t, &rows, &columns, NULL);
+    boxaDestroy(&cells);
+    char *text = nat->api.GetTableText(t);
+    const char *cell_text = text;
+    jobjectArray table = env->NewObjectArray(rows, rowClass, NULL);
+    for (int r = 0; r < rows; r++) {
+      jobjectArray row = env->NewObjectArray(columns, stringClass, NULL);
+      for (int c = 0; c < columns; c++) {
+        jstring str = env->NewStringUTF(cell_text);
+        env->SetObjectArrayElement(row, c, str);
+        env->DeleteLocalRef(str);
+        cell_text += strlen(cell_text) + 1;
+      }
+      env->SetObjectArrayElement(table, r, row);
+      env->DeleteLocalRef(row);
+    }
+    delete[] text;
+    env->SetObjectArrayElement(result, t, table);
+    env->DeleteLocalRef(table);
+  }
+
+  return result;
+}
+
+jboolean Java_com_googlecode_tesseract_android_TessBaseAPI_nativeRecognizeAsync(JNIEnv *env,
+                                                                                jobject thiz,
+                                                                                jlong mNativeData,
+                                                                                jlong nativePix,
+                                                                                jobject callback) {
+
+  native_data_t *nat = (native_data_t*) mNativeData;
+
+  async_job_t *job = new async_job_t;
+  job->pix = pixClone((PIX *) nativePix);
+  job->callback = env->NewGlobalRef(callback);
+  job->cancelled = false;
+
+  pthread_mutex_lock(&nat->asyncMutex);
+  if (!nat->asyncWorkerStarted) {
+    nat->asyncObject = env->NewGlobalRef(thiz);
+    if (pthread_create(&nat->asyncWorker, NULL, asyncWorkerMain, nat) != 0) {
+      pthread_mutex_unlock(&nat->asyncMutex);
+      LOGE("Could not start the recognition worker");
+      env->DeleteGlobalRef(nat->asyncObject);
+      nat->asyncObject = NULL;
+      env->DeleteGlobalRef(job->callback);
+      pixDestroy(&job->pix);
+      delete job;
+      return JNI_FALSE;
+    }
+    nat->asyncWorkerStarted = true;
+  }
+  nat->asyncJobs.push_back(job);
+  pthread_cond_signal(&nat->asyncCond);
+  pthread_mutex_unlock(&nat->asyncMutex);
+
+  return JNI_TRUE;
 }
 
 void Java_com_googlecode_tesseract_android_TessBaseAPI_nativeStop(JNIEnv *env, 
@@ -312,9 +1138,13 @@ void Java_com_googlecode_tesseract_android_TessBaseAPI_nativeStop(JNIEnv *env,
 
   native_data_t *nat = (native_data_t*) mNativeData;
 
-  // Stop by setting a flag that's used by the monitor
-  nat->resetStateVariables();
+  // Stop by setting a flag that's used by the monitor. The recognizing thread
+  // resets the rest of the state itself once it has stopped, as it may still
+  // be using it.
   nat->cancel_ocr = true;
+  pthread_mutex_lock(&nat->asyncMutex);
+  cancelAsyncJobs(nat);
+  pthread_mutex_unlock(&nat->asyncMutex);
 }
 
 jint Java_com_googlecode_tesseract_android_TessBaseAPI_nativeMeanConfidence(JNIEnv *env,
@@ -326,6 +1156,58 @@ jint Java_com_googlecode_tesseract_android_TessBaseAPI_nativeMeanConfidence(JNIE
   return (jint) nat->api.MeanTextConf();
 }
 
+jobject Java_com_googlecode_tesseract_android_TessBaseAPI_nativeGetResultsPacked(JNIEnv *env,
+                                                                                  jobject thiz,
+                                                                                  jlong mNativeData,
+                                                                                  jint level) {
+
+  native_data_t *nat = (native_data_t*) mNativeData;
+
+  delete[] nat->packedResults;
+  int size = 0;
+  nat->packedResults = nat->api.GetResultsPacked((tesseract::PageIteratorLevel) level, &size);
+
+  if (nat->packedResults == NULL) {
+    LOGE("Could not pack results!");
+    return NULL;
+  }
+
+  return env->NewDirectByteBuffer(nat->packedResults, size);
+}
+
+void Java_com_googlecode_tesseract_android_TessBaseAPI_nativeSetProgressInterval(JNIEnv *env,
+                                                                                jobject thiz,
+                                                                                jlong mNativeData,
+                                                                                jint minIntervalMs,
+                                                                                jint minPercentStep) {
+
+  native_data_t *nat = (native_data_t*) mNativeData;
+
+  nat->progressMinIntervalMs = minIntervalMs;
+  nat->progressMinStep = minPercentStep;
+}
+
+jobject Java_com_googlecode_tesseract_android_TessBaseAPI_nativeSetProgressPolling(JNIEnv *env,
+                                                                                  jobject thiz,
+                                                                                  jlong mNativeData,
+                                                                                  jboolean enable) {
+
+  native_data_t *nat = (native_data_t*) mNativeData;
+
+  if (!enable) {
+    nat->progressPolling = false;
+    return NULL;
+  }
+  if (nat->progressBuffer == NULL) {
+    nat->progressBuffer = new jint[kProgressBufferSize];
+    memset((void*) nat->progressBuffer, 0, kProgressBufferSize * sizeof(jint));
+  }
+  nat->progressPolling = true;
+
+  return env->NewDirectByteBuffer((void*) nat->progressBuffer,
+                                  kProgressBufferSize * sizeof(jint));
+}
+
 jintArray Java_com_googlecode_tesseract_android_TessBaseAPI_nativeWordConfidences(JNIEnv *env,
                                                                                   jobject thiz,
                                                                                   jlong mNativeData) {
@@ -356,6 +1238,146 @@ jintArray Java_com_googlecode_tesseract_android_TessBaseAPI_nativeWordConfidence
   return ret;
 }
 
+jdoubleArray Java_com_googlecode_tesseract_android_TessBaseAPI_nativeGetLayoutTimings(JNIEnv *env,
+                                                                                     jobject thiz,
+                                                                                     jlong mNativeData) {
+
+  native_data_t *nat = (native_data_t*) mNativeData;
+
+  const tesseract::LayoutTimings *timings = nat->api.GetLayoutTimings();
+
+  if (timings == NULL) {
+    LOGE("Could not get layout timings!");
+    return NULL;
+  }
+
+  // Same order as the TessBaseAPI.LayoutTimings indices.
+  jdouble values[] = {
+    timings->line_finding,
+    timings->image_finding,
+    timings->components,
+    timings->setup,
+    timings->find_blocks,
+    timings->total
+  };
+  jsize len = sizeof(values) / sizeof(values[0]);
+
+  jdoubleArray ret = env->NewDoubleArray(len);
+
+  LOG_ASSERT((ret != NULL), "Could not create Java timings array!");
+
+  env->SetDoubleArrayRegion(ret, 0, len, values);
+
+  return ret;
+}
+
+jdoubleArray Java_com_googlecode_tesseract_android_TessBaseAPI_nativeGetTimings(JNIEnv *env,
+                                                                               jobject thiz,
+                                                                               jlong mNativeData) {
+
+  native_data_t *nat = (native_data_t*) mNativeData;
+
+  const tesseract::StageTimings *timings = nat->api.GetTimings();
+
+  if (timings == NULL) {
+    LOGE("Could not get stage timings!");
+    return NULL;
+  }
+
+  // The TessBaseAPI.StageTimings indices follow tesseract::PageStage.
+  jsize len = tesseract::STAGE_COUNT;
+
+  jdoubleArray ret = env->NewDoubleArray(len);
+
+  LOG_ASSERT((ret != NULL), "Could not create Java timings array!");
+
+  env->SetDoubleArrayRegion(ret, 0, len, timings->msecs);
+
+  return ret;
+}
+
+jlongArray Java_com_googlecode_tesseract_android_TessBaseAPI_nativeGetPageCounters(JNIEnv *env,
+                                                                                   jobject thiz,
+                                                                                   jlong mNativeData) {
+
+  native_data_t *nat = (native_data_t*) mNativeData;
+
+  const tesseract::PageCounts *counts = nat->api.GetPageCounts();
+
+  if (counts == NULL) {
+    LOGE("Could not get page counters!");
+    return NULL;
+  }
+
+  // The TessBaseAPI.PageCounters indices follow tesseract::PageCounter.
+  jsize len = tesseract::COUNTER_COUNT;
+  jlong values[tesseract::COUNTER_COUNT];
+  for (int i = 0; i < len; ++i)
+    values[i] = (jlong) counts->counts[i];
+
+  jlongArray ret = env->NewLongArray(len);
+
+  LOG_ASSERT((ret != NULL), "Could not create Java counters array!");
+
+  env->SetLongArrayRegion(ret, 0, len, values);
+
+  return ret;
+}
+
+jlongArray Java_com_googlecode_tesseract_android_TessBaseAPI_nativeGetMemoryUsage(JNIEnv *env,
+                                                                                 jobject thiz,
+                                                                                 jlong mNativeData) {
+
+  native_data_t *nat = (native_data_t*) mNativeData;
+
+  tesseract::MemoryUsage usage;
+
+  if (!nat->api.GetMemoryUsage(&usage)) {
+    LOGE("Could not get memory usage!");
+    return NULL;
+  }
+
+  // The TessBaseAPI.MemoryUsage indices follow tesseract::MemoryComponent,
+  // then the two peaks.
+  jsize len = tesseract::MEMORY_COUNT + 2;
+  jlong values[tesseract::MEMORY_COUNT + 2];
+  for (int i = 0; i < tesseract::MEMORY_COUNT; ++i)
+    values[i] = (jlong) usage.bytes[i];
+  values[tesseract::MEMORY_COUNT] = (jlong) usage.page_peak_bytes;
+  values[tesseract::MEMORY_COUNT + 1] = (jlong) usage.peak_resident_bytes;
+
+  jlongArray ret = env->NewLongArray(len);
+
+  LOG_ASSERT((ret != NULL), "Could not create Java memory usage array!");
+
+  env->SetLongArrayRegion(ret, 0, len, values);
+
+  return ret;
+}
+
+void Java_com_googlecode_tesseract_android_TessBaseAPI_nativeSetPageSkew(JNIEnv *env,
+                                                                        jobject thiz,
+                                                                        jlong mNativeData,
+                                                                        jfloat angle) {
+
+  native_data_t *nat = (native_data_t*) mNativeData;
+
+  nat->api.SetPageSkew((float) angle);
+}
+
+jfloat Java_com_googlecode_tesseract_android_TessBaseAPI_nativeGetPageSkew(JNIEnv *env,
+                                                                          jobject thiz,
+                                                                          jlong mNativeData) {
+
+  native_data_t *nat = (native_data_t*) mNativeData;
+
+  float angle;
+  if (!nat->api.GetPageSkew(&angle))
+    return NAN;
+
+  return (jfloat) angle;
+}
+
 jboolean Java_com_googlecode_tesseract_android_TessBaseAPI_nativeSetVariable(JNIEnv *env,
                                                                              jobject thiz,
                                                                              jlong mNativeData,
@@ -375,6 +1397,88 @@ jboolean Java_com_googlecode_tesseract_android_TessBaseAPI_nativeSetVariable(JNI
   return set;
 }
 
+jint Java_com_googlecode_tesseract_android_TessBaseAPI_nativeSetVariables(JNIEnv *env,
+                                                                          jobject thiz,
+                                                                          jlong mNativeData,
+                                                                          jobjectArray namesAndValues) {
+
+  native_data_t *nat = (native_data_t*) mNativeData;
+
+  int count = env->GetArrayLength(namesAndValues);
+  jstring *jstrings = new jstring[count];
+  const char **c_strings = new const char*[count];
+  for (int i = 0; i < count; ++i) {
+    jstrings[i] = (jstring) env->GetObjectArrayElement(namesAndValues, i);
+    c_strings[i] = env->GetStringUTFChars(jstrings[i], NULL);
+  }
+
+  jint set = nat->api.SetVariables(c_strings, count / 2);
+
+  for (int i = 0; i < count; ++i) {
+    env->ReleaseStringUTFChars(jstrings[i], c_strings[i]);
+    env->DeleteLocalRef(jstrings[i]);
+  }
+  delete[] c_strings;
+  delete[] jstrings;
+
+  return set;
+}
+
+// Passes the strings of the Java array to AddUserWords, or to
+// AddUserPatterns if patterns is set, as a NULL-terminated array.
+static jint addUserStrings(JNIEnv *env, native_data_t *nat, jobjectArray array,
+                           bool patterns) {
+  int count = env->GetArrayLength(array);
+  jstring *jstrings = new jstring[count];
+  const char **c_strings = new const char*[count + 1];
+  for (int i = 0; i < count; ++i) {
+    jstrings[i] = (jstring) env->GetObjectArrayElement(array, i);
+    c_strings[i] = env->GetStringUTFChars(jstrings[i], NULL);
+  }
+  c_strings[count] = NULL;
+
+  jint added = patterns ? nat->api.AddUserPatterns(c_strings)
+                        : nat->api.AddUserWords(c_strings);
+
+  for (int i = 0; i < count; ++i) {
+    env->ReleaseStringUTFChars(jstrings[i], c_strings[i]);
+    env->DeleteLocalRef(jstrings[i]);
+  }
+  delete[] c_strings;
+  delete[] jstrings;
+
+  return added;
+}
+
+jint Java_com_googlecode_tesseract_android_TessBaseAPI_nativeAddUserWords(JNIEnv *env,
+                                                                          jobject thiz,
+                                                                          jlong mNativeData,
+                                                                          jobjectArray words) {
+
+  native_data_t *nat = (native_data_t*) mNativeData;
+
+  return addUserStrings(env, nat, words, false);
+}
+
+jint Java_com_googlecode_tesseract_android_TessBaseAPI_nativeAddUserPatterns(JNIEnv *env,
+                                                                             jobject thiz,
+                                                                             jlong mNativeData,
+                                                                             jobjectArray patterns) {
+
+  native_data_t *nat = (native_data_t*) mNativeData;
+
+  return addUserStrings(env, nat, patterns, true);
+}
+
+void Java_com_googlecode_tesseract_android_TessBaseAPI_nativeClearUserWords(JNIEnv *env,
+                                                                            jobject thiz,
+                                                                            jlong mNativeData) {
+
+  native_data_t *nat = (native_data_t*) mNativeData;
+
+  nat->api.ClearUserWords();
+}
+
 void Java_com_googlecode_tesseract_android_TessBaseAPI_nativeClear(JNIEnv *env,
                                                                    jobject thiz,
                                                                    jlong mNativeData) {
@@ -403,8 +1507,12 @@ void Java_com_googlecode_tesseract_android_TessBaseAPI_nativeEnd(JNIEnv *env,
 
   native_data_t *nat = (native_data_t*) mNativeData;
 
+  stopAsyncWorker(env, nat);
   nat->api.End();
 
+  delete[] nat->packedResults;
+  nat->packedResults = NULL;
+
   // Since Tesseract doesn't take ownership of the memory, we keep a pointer in the native
   // code struct. We need to free that pointer when we release our instance of Tesseract or
   // attempt to set a new image using one of the nativeSet* methods.
@@ -530,6 +1638,60 @@ jlong Java_com_googlecode_tesseract_android_TessBaseAPI_nativeGetConnectedCompon
   return reinterpret_cast<jlong>(pixa);
 }
 
+jintArray Java_com_googlecode_tesseract_android_TessBaseAPI_nativeGetComponentBoxes(JNIEnv *env,
+                                                                                  jobject thiz,
+                                                                                  jlong mNativeData,
+                                                                                  jint level,
+                                                                                  jboolean textOnly) {
+
+  native_data_t *nat = (native_data_t*) mNativeData;
+
+  BOXA *boxa = nat->api.GetComponentImages((tesseract::PageIteratorLevel) level,
+                                           (bool) textOnly, NULL, NULL);
+
+  if (boxa == NULL) {
+    LOGE("Could not get component boxes!");
+    return NULL;
+  }
+
+  // Left, top, right and bottom of each component.
+  int count = boxaGetCount(boxa);
+  jint *values = new jint[count * 4];
+  for (int i = 0; i < count; i++) {
+    l_int32 x, y, w, h;
+    boxaGetBoxGeometry(boxa, i, &x, &y, &w, &h);
+    values[i * 4] = x;
+    values[i * 4 + 1] = y;
+    values[i * 4 + 2] = x + w;
+    values[i * 4 + 3] = y + h;
+  }
+  boxaDestroy(&boxa);
+
+  jintArray ret = env->NewIntArray(count * 4);
+
+  LOG_ASSERT((ret != NULL), "Could not create Java component box array!");
+
+  env->SetIntArrayRegion(ret, 0, count * 4, values);
+  delete[] values;
+
+  return ret;
+}
+
+jlong Java_com_googlecode_tesseract_android_TessBaseAPI_nativeGetComponentImage(JNIEnv *env,
+                                                                                jobject thiz,
+                                                                                jlong mNativeData,
+                                                                                jint level,
+                                                                                jboolean textOnly,
+                                                                                jint index) {
+
+  native_data_t *nat = (native_data_t*) mNativeData;
+
+  PIX *pix = nat->api.GetComponentImage((tesseract::PageIteratorLevel) level,
+                                        (bool) textOnly, false, 0, index);
+
+  return (jlong) pix;
+}
+
 jlong Java_com_googlecode_tesseract_android_TessBaseAPI_nativeGetResultIterator(JNIEnv *env,
                                                                                 jobject thiz,
                                                                                 jlong mNativeData) {
@@ -562,6 +1724,37 @@ jstring Java_com_googlecode_tesseract_android_TessBaseAPI_nativeGetHOCRText(JNIE
   return result;
 }
 
+jbyteArray Java_com_googlecode_tesseract_android_TessBaseAPI_nativeGetHOCRBytes(JNIEnv *env,
+                                                                              jobject thiz,
+                                                                              jlong mNativeData,
+                                                                              jint page) {
+
+  native_data_t *nat = (native_data_t*) mNativeData;
+  nat->initStateVariables(env, &thiz);
+
+  ETEXT_DESC monitor;
+  monitor.progress_callback = progressJavaCallback;
+  monitor.cancel = cancelFunc;
+  monitor.cancel_this = nat;
+  monitor.progress_this = nat;
+
+  char *text = nat->api.GetHOCRText(&monitor, page);
+
+  // The UTF-8 goes into the array as it is, with no decoding into a String.
+  jbyteArray result = NULL;
+  if (text != NULL) {
+    jsize length = strlen(text);
+    result = env->NewByteArray(length);
+    if (result != NULL)
+      env->SetByteArrayRegion(result, 0, length, (const jbyte*) text);
+  }
+
+  delete[] text;
+  nat->resetStateVariables();
+
+  return result;
+}
+
 jstring Java_com_googlecode_tesseract_android_TessBaseAPI_nativeGetBoxText(JNIEnv *env,
                                                                            jobject thiz,
                                                                            jlong mNativeData,
@@ -578,6 +1771,15 @@ jstring Java_com_googlecode_tesseract_android_TessBaseAPI_nativeGetBoxText(JNIEn
   return result;
 }
 
+jstring Java_com_googlecode_tesseract_android_TessBaseAPI_nativeGetOpenCLRoutes(JNIEnv *env,
+                                                                                jclass clazz) {
+
+  STRING report;
+  if (!tesseract::TessBaseAPI::GetOpenCLRoutes(&report))
+    return NULL;
+  return env->NewStringUTF(report.string());
+}
+
 jstring Java_com_googlecode_tesseract_android_TessBaseAPI_nativeGetVersion(JNIEnv *env,
                                                                            jobject thiz,
                                                                            jlong mNativeData) {
@@ -632,6 +1834,17 @@ jlong Java_com_googlecode_tesseract_android_TessPdfRenderer_nativeCreate(JNIEnv
   return (jlong) result;
 }
 
+jlong Java_com_googlecode_tesseract_android_TessPdfRenderer_nativeCreateForFd(JNIEnv *env,
+                                                                              jobject thiz,
+                                                                              jlong jTessBaseApi,
+                                                                              jint fd) {
+  native_data_t *nat = (native_data_t*) jTessBaseApi;
+
+  tesseract::TessPDFRenderer* result = new tesseract::TessPDFRenderer((int) fd, nat->api.GetDatapath());
+
+  return (jlong) result;
+}
+
 void Java_com_googlecode_tesseract_android_TessPdfRenderer_nativeRecycle(JNIEnv *env,
                                                                          jobject thiz,
                                                                          jlong jPointer) {
@@ -639,6 +1852,14 @@ void Java_com_googlecode_tesseract_android_TessPdfRenderer_nativeRecycle(JNIEnv
   delete renderer;
 }
 
+void Java_com_googlecode_tesseract_android_TessPdfRenderer_nativeSetGreyImageReduction(JNIEnv *env,
+                                                                                      jobject thiz,
+                                                                                      jlong jPointer,
+                                                                                      jint reduction) {
+  tesseract::TessPDFRenderer* renderer = (tesseract::TessPDFRenderer*) jPointer;
+  renderer->SetGreyImageReduction((int) reduction);
+}
+
 jboolean Java_com_googlecode_tesseract_android_TessBaseAPI_nativeBeginDocument(JNIEnv *env,
                                                                                jobject thiz,
                                                                                jlong jRenderer,
@@ -682,6 +1903,165 @@ jboolean Java_com_googlecode_tesseract_android_TessBaseAPI_nativeAddPageToDocume
   return true;
 }
 
+jboolean Java_com_googlecode_tesseract_android_TessBaseAPI_nativeAddPageToDocumentJpeg(JNIEnv *env,
+                                                                                       jobject thiz,
+                                                                                       jlong mNativeData,
+                                                                                       jlong jPix,
+                                                                                       jbyteArray jJpeg,
+                                                                                       jlong jRenderer) {
+
+  tesseract::TessPDFRenderer* pdfRenderer = (tesseract::TessPDFRenderer*) jRenderer;
+
+  native_data_t *nat = (native_data_t*) mNativeData;
+  PIX* pix = (PIX*) jPix;
+  jbyte *jpeg = env->GetByteArrayElements(jJpeg, NULL);
+  jsize size = env->GetArrayLength(jJpeg);
+
+  // The bytes stay pinned until the page has been written.
+  pdfRenderer->SetPageJpeg((const char*) jpeg, size);
+  bool result = nat->api.ProcessPage(pix, 0, "", NULL, 0, pdfRenderer);
+
+  env->ReleaseByteArrayElements(jJpeg, jpeg, JNI_ABORT);
+
+  return result;
+}
+
+jboolean Java_com_googlecode_tesseract_android_TessBaseAPI_nativeProcessDocument(JNIEnv *env,
+                                                                                 jobject thiz,
+                                                                                 jlong mNativeData,
+                                                                                 jobjectArray jPaths,
+                                                                                 jstring title,
+                                                                                 jlong jRenderer,
+                                                                                 jint numRecognizers) {
+
+  native_data_t *nat = (native_data_t*) mNativeData;
+  tesseract::TessPDFRenderer* pdfRenderer = (tesseract::TessPDFRenderer*) jRenderer;
+
+  GenericVector<STRING> paths;
+  int count = env->GetArrayLength(jPaths);
+  for (int i = 0; i < count; i++) {
+    jstring jPath = (jstring) env->GetObjectArrayElement(jPaths, i);
+    const char *c_path = env->GetStringUTFChars(jPath, NULL);
+    paths.push_back(c_path);
+    env->ReleaseStringUTFChars(jPath, c_path);
+    env->DeleteLocalRef(jPath);
+  }
+
+  if (numRecognizers <= 0) {
+    numRecognizers = (jint) sysconf(_SC_NPROCESSORS_ONLN);
+  }
+
+  const char *c_title = env->GetStringUTFChars(title, NULL);
+
+  // Two decoded pages keep the recognizers fed without holding many pages.
+  tesseract::DocumentPipeline pipeline(&nat->api, numRecognizers, 2);
+  bool res = pipeline.ProcessFiles(paths, c_title, 0, pdfRenderer);
+
+  env->ReleaseStringUTFChars(title, c_title);
+
+  return (jboolean) (res ? JNI_TRUE : JNI_FALSE);
+}
+
+jlong Java_com_googlecode_tesseract_android_TessResultRenderer_nativeCreate(JNIEnv *env,
+                                                                            jobject thiz,
+                                                                            jlong jTessBaseApi,
+                                                                            jstring outputBase,
+                                                                            jint format) {
+  native_data_t *nat = (native_data_t*) jTessBaseApi;
+  const char *c_output_base = env->GetStringUTFChars(outputBase, NULL);
+
+  // Must match the FORMAT_ constants of TessResultRenderer.java.
+  tesseract::TessResultRenderer* result = NULL;
+  switch (format) {
+    case 0:
+      result = new tesseract::TessTextRenderer(c_output_base);
+      break;
+    case 1:
+      result = new tesseract::TessHOcrRenderer(c_output_base);
+      break;
+    case 2:
+      result = new tesseract::TessTsvRenderer(c_output_base);
+      break;
+    case 3:
+      result = new tesseract::TessPDFRenderer(c_output_base, nat->api.GetDatapath());
+      break;
+    case 4:
+      result = new tesseract::TessUnlvRenderer(c_output_base);
+      break;
+    case 5:
+      result = new tesseract::TessBoxTextRenderer(c_output_base);
+      break;
+    case 6:
+      result = new tesseract::TessJsonRenderer(c_output_base);
+      break;
+    case 7:
+      result = new tesseract::TessCountersRenderer(c_output_base);
+      break;
+    default:
+      LOGE("Unknown renderer format %d", format);
+      break;
+  }
+
+  env->ReleaseStringUTFChars(outputBase, c_output_base);
+
+  return (jlong) result;
+}
+
+void Java_com_googlecode_tesseract_android_TessResultRenderer_nativeInsert(JNIEnv *env,
+                                                                           jobject thiz,
+                                                                           jlong jPointer,
+                                                                           jlong jNextPointer) {
+  tesseract::TessResultRenderer* renderer = (tesseract::TessResultRenderer*) jPointer;
+  renderer->insert((tesseract::TessResultRenderer*) jNextPointer);
+}
+
+void Java_com_googlecode_tesseract_android_TessResultRenderer_nativeRecycle(JNIEnv *env,
+                                                                            jobject thiz,
+                                                                            jlong jPointer) {
+  tesseract::TessResultRenderer* renderer = (tesseract::TessResultRenderer*) jPointer;
+  delete renderer;
+}
+
+jboolean Java_com_googlecode_tesseract_android_TessBaseAPI_nativeProcessPages(JNIEnv *env,
+                                                                              jobject thiz,
+                                                                              jlong mNativeData,
+                                                                              jstring jPath,
+                                                                              jint timeoutMillis,
+                                                                              jlong jRenderer) {
+  native_data_t *nat = (native_data_t*) mNativeData;
+  tesseract::TessResultRenderer* renderer = (tesseract::TessResultRenderer*) jRenderer;
+  const char *c_path = env->GetStringUTFChars(jPath, NULL);
+
+  bool res = nat->api.ProcessPages(c_path, NULL, timeoutMillis, renderer);
+
+  env->ReleaseStringUTFChars(jPath, c_path);
+
+  return (jboolean) (res ? JNI_TRUE : JNI_FALSE);
+}
+
+jboolean Java_com_googlecode_tesseract_android_TessBaseAPI_nativeProcessPagesFromMemory(JNIEnv *env,
+                                                                                        jobject thiz,
+                                                                                        jlong mNativeData,
+                                                                                        jbyteArray jData,
+                                                                                        jstring jName,
+                                                                                        jint timeoutMillis,
+                                                                                        jlong jRenderer) {
+  native_data_t *nat = (native_data_t*) mNativeData;
+  tesseract::TessResultRenderer* renderer = (tesseract::TessResultRenderer*) jRenderer;
+  const char *c_name = jName != NULL ? env->GetStringUTFChars(jName, NULL) : NULL;
+  jbyte *data = env->GetByteArrayElements(jData, NULL);
+  jsize size = env->GetArrayLength(jData);
+
+  bool res = nat->api.ProcessPagesFromMemory((const unsigned char*) data, size,
+                                             c_name, NULL, timeoutMillis, renderer);
+
+  env->ReleaseByteArrayElements(jData, data, JNI_ABORT);
+  if (c_name != NULL)
+    env->ReleaseStringUTFChars(jName, c_name);
+
+  return (jboolean) (res ? JNI_TRUE : JNI_FALSE);
+}
+
 #ifdef __cplusplus
 }
 #endif
@@ -60,4 +60,22 @@ LOCAL_CFLAGS := \
   -Wno-pointer-sign \
   -Wno-implicit-function-declaration
 
+# SIMD versions of the IDCT and YCbCr->RGB conversion. NEON is optional on
+# ARMv7, so there only jsimdvec.c is built with it, and jsimd.c checks for
+# it at run time.
+ifneq ($(filter armeabi-v7a arm64-v8a x86 x86_64,$(TARGET_ARCH_ABI)),)
+LOCAL_SRC_FILES += jsimd.c
+ifeq ($(TARGET_ARCH_ABI),armeabi-v7a)
+LOCAL_SRC_FILES += jsimdvec.c.neon
+LOCAL_STATIC_LIBRARIES := cpufeatures
+else
+LOCAL_SRC_FILES += jsimdvec.c
+endif
+LOCAL_CFLAGS += -DWITH_SIMD
+endif
+
 include $(BUILD_SHARED_LIBRARY)
+
+ifeq ($(TARGET_ARCH_ABI),armeabi-v7a)
+$(call import-module,android/cpufeatures)
+endif
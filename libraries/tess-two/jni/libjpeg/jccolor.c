@@ -12,6 +12,7 @@
 #define JPEG_INTERNALS
 #include "jinclude.h"
 #include "jpeglib.h"
+#include "jsimd.h"		/* SIMD version of RGB->YCbCr */
 
 
 /* Private subobject */
@@ -527,6 +528,12 @@ jinit_color_converter (j_compress_ptr cinfo)
       ERREXIT(cinfo, JERR_BAD_J_COLORSPACE);
     switch (cinfo->in_color_space) {
     case JCS_RGB:
+#ifdef WITH_SIMD
+      if (jsimd_can_rgb_ycc(cinfo)) {
+	cconvert->pub.color_convert = jsimd_rgb_ycc_convert;
+	break;
+      }
+#endif
       cconvert->pub.start_pass = rgb_ycc_start;
       cconvert->pub.color_convert = rgb_ycc_convert;
       break;
@@ -16,6 +16,7 @@
 #include "jinclude.h"
 #include "jpeglib.h"
 #include "jdct.h"		/* Private declarations for DCT subsystem */
+#include "jsimd.h"		/* SIMD versions of the FDCT and quantization */
 
 
 /* Private subobject for this module */
@@ -131,6 +132,35 @@ forward_DCT (j_compress_ptr cinfo, jpeg_component_info * compptr,
 }
 
 
+#ifdef WITH_SIMD
+
+/*
+ * Same as forward_DCT, but quantizes with jsimd_quantize.
+ */
+
+METHODDEF(void)
+forward_DCT_simd (j_compress_ptr cinfo, jpeg_component_info * compptr,
+		  JSAMPARRAY sample_data, JBLOCKROW coef_blocks,
+		  JDIMENSION start_row, JDIMENSION start_col,
+		  JDIMENSION num_blocks)
+{
+  my_fdct_ptr fdct = (my_fdct_ptr) cinfo->fdct;
+  forward_DCT_method_ptr do_dct = fdct->do_dct[compptr->component_index];
+  DCTELEM * divisors = (DCTELEM *) compptr->dct_table;
+  DCTELEM workspace[DCTSIZE2];	/* work area for FDCT subroutine */
+  JDIMENSION bi;
+
+  sample_data += start_row;	/* fold in the vertical offset once */
+
+  for (bi = 0; bi < num_blocks; bi++, start_col += compptr->DCT_h_scaled_size) {
+    (*do_dct) (workspace, sample_data, start_col);
+    jsimd_quantize(coef_blocks[bi], divisors, workspace);
+  }
+}
+
+#endif
+
+
 #ifdef DCT_FLOAT_SUPPORTED
 
 METHODDEF(void)
@@ -329,6 +359,11 @@ start_pass_fdctmgr (j_compress_ptr cinfo)
       switch (cinfo->dct_method) {
 #ifdef DCT_ISLOW_SUPPORTED
       case JDCT_ISLOW:
+#ifdef WITH_SIMD
+	if (jsimd_can_fdct_islow(cinfo))
+	  fdct->do_dct[ci] = jsimd_fdct_islow;
+	else
+#endif
 	fdct->do_dct[ci] = jpeg_fdct_islow;
 	method = JDCT_ISLOW;
 	break;
@@ -373,6 +408,12 @@ start_pass_fdctmgr (j_compress_ptr cinfo)
 	dtbl[i] =
 	  ((DCTELEM) qtbl->quantval[i]) << (compptr->component_needed ? 4 : 3);
       }
+#ifdef WITH_SIMD
+      if (jsimd_can_quantize(cinfo)) {
+	fdct->pub.forward_DCT[ci] = forward_DCT_simd;
+	break;
+      }
+#endif
       fdct->pub.forward_DCT[ci] = forward_DCT;
       break;
 #endif
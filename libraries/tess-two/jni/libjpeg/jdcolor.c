@@ -12,6 +12,7 @@
 #define JPEG_INTERNALS
 #include "jinclude.h"
 #include "jpeglib.h"
+#include "jsimd.h"		/* SIMD version of YCbCr->RGB */
 
 
 /* Private subobject */
@@ -652,6 +653,12 @@ jinit_color_deconverter (j_decompress_ptr cinfo)
       cconvert->pub.color_convert = gray_rgb_convert;
       break;
     case JCS_YCbCr:
+#ifdef WITH_SIMD
+      if (jsimd_can_ycc_rgb(cinfo)) {
+	cconvert->pub.color_convert = jsimd_ycc_rgb_convert;
+	break;
+      }
+#endif
       cconvert->pub.color_convert = ycc_rgb_convert;
       build_ycc_rgb_table(cinfo);
       break;
@@ -20,6 +20,7 @@
 #include "jinclude.h"
 #include "jpeglib.h"
 #include "jdct.h"		/* Private declarations for DCT subsystem */
+#include "jsimd.h"		/* SIMD versions of the IDCT */
 
 
 /*
@@ -230,6 +231,11 @@ start_pass (j_decompress_ptr cinfo)
       switch (cinfo->dct_method) {
 #ifdef DCT_ISLOW_SUPPORTED
       case JDCT_ISLOW:
+#ifdef WITH_SIMD
+	if (jsimd_can_idct_islow(cinfo))
+	  method_ptr = jsimd_idct_islow;
+	else
+#endif
 	method_ptr = jpeg_idct_islow;
 	method = JDCT_ISLOW;
 	break;
@@ -0,0 +1,97 @@
+/*
+ * jsimd.c
+ *
+ * This file is part of the tess-two build of the IJG software.
+ * For conditions of distribution and use, see the accompanying README file.
+ *
+ * This file decides whether the SIMD routines in jsimdvec.c may be used.
+ * It is compiled without NEON, so that the check itself is safe to run on
+ * ARMv7 CPUs that lack it.
+ */
+
+#define JPEG_INTERNALS
+#include "jinclude.h"
+#include "jpeglib.h"
+#include "jdct.h"		/* for ISLOW_MULT_TYPE */
+#include "jsimd.h"
+
+#ifdef WITH_SIMD
+
+#if defined(__arm__) && !defined(__aarch64__)
+#include <cpu-features.h>
+#endif
+
+
+/*
+ * Check once whether the CPU has the vector unit that jsimdvec.c was
+ * compiled for.  NEON is optional on ARMv7, but always present on ARMv8,
+ * and SSE2 is part of both Android x86 ABIs.
+ */
+
+LOCAL(boolean)
+have_simd (void)
+{
+#if defined(__arm__) && !defined(__aarch64__)
+  static int simd_support = -1;
+
+  if (simd_support < 0)
+    simd_support = android_getCpuFamily() == ANDROID_CPU_FAMILY_ARM &&
+		   (android_getCpuFeatures() & ANDROID_CPU_ARM_FEATURE_NEON) != 0;
+  return simd_support ? TRUE : FALSE;
+#else
+  return TRUE;
+#endif
+}
+
+
+GLOBAL(boolean)
+jsimd_can_ycc_rgb (j_decompress_ptr cinfo)
+{
+  /* The SIMD code assumes 8-bit samples and the default RGB layout. */
+  if (BITS_IN_JSAMPLE != 8 || RGB_PIXELSIZE != 3 ||
+      RGB_RED != 0 || RGB_GREEN != 1 || RGB_BLUE != 2)
+    return FALSE;
+  /* Only the sYCC coefficients are implemented, not bg-sYCC. */
+  if (cinfo->jpeg_color_space != JCS_YCbCr)
+    return FALSE;
+  return have_simd();
+}
+
+
+GLOBAL(boolean)
+jsimd_can_idct_islow (j_decompress_ptr cinfo)
+{
+  if (BITS_IN_JSAMPLE != 8 || DCTSIZE != 8 || SIZEOF(JCOEF) != 2 ||
+      SIZEOF(ISLOW_MULT_TYPE) != 4)
+    return FALSE;
+  return have_simd();
+}
+
+GLOBAL(boolean)
+jsimd_can_rgb_ycc (j_compress_ptr cinfo)
+{
+  if (BITS_IN_JSAMPLE != 8 || RGB_PIXELSIZE != 3 ||
+      RGB_RED != 0 || RGB_GREEN != 1 || RGB_BLUE != 2)
+    return FALSE;
+  return have_simd();
+}
+
+
+GLOBAL(boolean)
+jsimd_can_fdct_islow (j_compress_ptr cinfo)
+{
+  if (BITS_IN_JSAMPLE != 8 || DCTSIZE != 8 || SIZEOF(DCTELEM) != 4)
+    return FALSE;
+  return have_simd();
+}
+
+
+GLOBAL(boolean)
+jsimd_can_quantize (j_compress_ptr cinfo)
+{
+  if (DCTSIZE != 8 || SIZEOF(DCTELEM) != 4 || SIZEOF(JCOEF) != 2)
+    return FALSE;
+  return have_simd();
+}
+
+#endif /* WITH_SIMD */
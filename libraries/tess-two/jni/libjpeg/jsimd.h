@@ -0,0 +1,71 @@
+/*
+ * jsimd.h
+ *
+ * This file is part of the tess-two build of the IJG software.
+ * For conditions of distribution and use, see the accompanying README file.
+ *
+ * This include file declares the SIMD (NEON or SSE2) versions of the
+ * routines that dominate the time to decode or encode a photo: the 8x8
+ * islow inverse and forward DCTs, quantization, and YCbCr<->RGB color
+ * conversion.  They produce the same results as jidctint.c, jfdctint.c,
+ * jcdctmgr.c, jdcolor.c and jccolor.c; the scalar shortcuts for all-zero
+ * AC terms are simply not taken, which makes no difference for
+ * coefficients that fit the islow design range.
+ *
+ * The SIMD routines are only compiled when WITH_SIMD is defined, and must
+ * only be used when the matching jsimd_can_* function returns TRUE, as on
+ * ARMv7 the presence of NEON is checked at run time.
+ */
+
+#ifdef WITH_SIMD
+
+/* Short forms of external names for systems with brain-damaged linkers. */
+
+#ifdef NEED_SHORT_EXTERNAL_NAMES
+#define jsimd_can_ycc_rgb	jSCanYccRgb
+#define jsimd_ycc_rgb_convert	jSYccRgb
+#define jsimd_can_idct_islow	jSCanIslow
+#define jsimd_idct_islow	jSIslow
+#define jsimd_can_rgb_ycc	jSCanRgbYcc
+#define jsimd_rgb_ycc_convert	jSRgbYcc
+#define jsimd_can_fdct_islow	jSCanFislow
+#define jsimd_fdct_islow	jSFislow
+#define jsimd_can_quantize	jSCanQuant
+#define jsimd_quantize		jSQuant
+#endif /* NEED_SHORT_EXTERNAL_NAMES */
+
+EXTERN(boolean) jsimd_can_ycc_rgb JPP((j_decompress_ptr cinfo));
+EXTERN(void) jsimd_ycc_rgb_convert
+    JPP((j_decompress_ptr cinfo, JSAMPIMAGE input_buf, JDIMENSION input_row,
+	 JSAMPARRAY output_buf, int num_rows));
+
+EXTERN(boolean) jsimd_can_rgb_ycc JPP((j_compress_ptr cinfo));
+EXTERN(void) jsimd_rgb_ycc_convert
+    JPP((j_compress_ptr cinfo, JSAMPARRAY input_buf, JSAMPIMAGE output_buf,
+	 JDIMENSION output_row, int num_rows));
+
+/* The DCT routines use types from jdct.h, so they are only declared
+ * where it has been included.
+ */
+
+#ifdef RANGE_MASK
+
+EXTERN(boolean) jsimd_can_idct_islow JPP((j_decompress_ptr cinfo));
+EXTERN(void) jsimd_idct_islow
+    JPP((j_decompress_ptr cinfo, jpeg_component_info * compptr,
+	 JCOEFPTR coef_block, JSAMPARRAY output_buf, JDIMENSION output_col));
+
+EXTERN(boolean) jsimd_can_fdct_islow JPP((j_compress_ptr cinfo));
+EXTERN(void) jsimd_fdct_islow
+    JPP((DCTELEM * data, JSAMPARRAY sample_data, JDIMENSION start_col));
+
+/* Quantize a block of DCT output with the divisors of an ISLOW-style
+ * divisor table, rounding as forward_DCT in jcdctmgr.c does.
+ */
+EXTERN(boolean) jsimd_can_quantize JPP((j_compress_ptr cinfo));
+EXTERN(void) jsimd_quantize
+    JPP((JCOEFPTR coef_block, DCTELEM * divisors, DCTELEM * workspace));
+
+#endif /* RANGE_MASK */
+
+#endif /* WITH_SIMD */
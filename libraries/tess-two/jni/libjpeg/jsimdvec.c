@@ -0,0 +1,743 @@
+/*
+ * jsimdvec.c
+ *
+ * This file is part of the tess-two build of the IJG software.
+ * For conditions of distribution and use, see the accompanying README file.
+ *
+ * This file contains NEON and SSE2 versions of the islow inverse and
+ * forward DCTs, of quantization, and of YCbCr<->RGB color conversion.
+ * Each is written once, in terms of a few operations on vectors of four
+ * INT32s, which are defined below for each instruction set.  All
+ * arithmetic is done on 32 bits exactly as in jidctint.c, jfdctint.c,
+ * jcdctmgr.c, jdcolor.c and jccolor.c, so that the results are the same.
+ *
+ * On ARMv7 this file is compiled with NEON enabled, so its routines may
+ * only be called after jsimd_can_* (in jsimd.c) has returned TRUE.
+ */
+
+#define JPEG_INTERNALS
+#include "jinclude.h"
+#include "jpeglib.h"
+#include "jdct.h"		/* Private declarations for DCT subsystem */
+#include "jsimd.h"
+
+#ifdef WITH_SIMD
+
+
+/**************** Vector operations for each instruction set ****************/
+
+#if defined(__ARM_NEON__) || defined(__ARM_NEON) || defined(__aarch64__)
+
+#include <arm_neon.h>
+
+typedef int32x4_t jvec;
+
+#define VSPLAT(c)	vdupq_n_s32(c)
+#define VADD(a,b)	vaddq_s32(a, b)
+#define VSUB(a,b)	vsubq_s32(a, b)
+#define VMUL(a,b)	vmulq_s32(a, b)
+#define VMULC(a,c)	vmulq_n_s32(a, c)
+#define VAND(a,b)	vandq_s32(a, b)
+#define VXOR(a,b)	veorq_s32(a, b)
+#define VSHL(a,n)	vshlq_n_s32(a, n)
+#define VSHR(a,n)	vshrq_n_s32(a, n)
+
+/* Load four JCOEFs or four ISLOW_MULT_TYPEs or DCTELEMs as INT32s. */
+#define VLOAD_COEF(p)	vmovl_s16(vld1_s16(p))
+#define VLOAD_INT(p)	vld1q_s32(p)
+/* Store four DCTELEMs, or the low 16 bits of four INT32s as JCOEFs. */
+#define VSTORE_INT(p,v)	vst1q_s32(p, v)
+#define VSTORE_COEF(p,v)	vst1_s16(p, vmovn_s32(v))
+
+#ifdef __aarch64__
+#define VDIV(a,b)	vcvtq_s32_f32(vdivq_f32(vcvtq_f32_s32(a), \
+						vcvtq_f32_s32(b)))
+#else
+#define VDIV(a,b)	div32(a, b)
+
+/* Divide the non-negative a by the positive b, truncating.  ARMv7 has no
+ * vector division, so estimate the quotient from a reciprocal, which is
+ * within one of the truncated quotient, and correct it.
+ */
+LOCAL(jvec)
+div32 (jvec a, jvec b)
+{
+  float32x4_t fb = vcvtq_f32_s32(b);
+  float32x4_t r = vrecpeq_f32(fb);
+  jvec q;
+
+  r = vmulq_f32(vrecpsq_f32(fb, r), r);
+  r = vmulq_f32(vrecpsq_f32(fb, r), r);
+  q = vcvtq_s32_f32(vmulq_f32(vcvtq_f32_s32(a), r));
+  /* Comparisons give -1 where true. */
+  q = vaddq_s32(q, vreinterpretq_s32_u32(vcgtq_s32(vmulq_s32(q, b), a)));
+  q = vsubq_s32(q, vreinterpretq_s32_u32(
+		     vcleq_s32(vmulq_s32(vaddq_s32(q, vdupq_n_s32(1)), b), a)));
+  return q;
+}
+#endif
+
+/* Widen eight JSAMPLEs to two vectors of INT32s. */
+LOCAL(void)
+widen_samples (uint8x8_t x, jvec * lo, jvec * hi)
+{
+  uint16x8_t x16 = vmovl_u8(x);
+
+  *lo = vreinterpretq_s32_u32(vmovl_u16(vget_low_u16(x16)));
+  *hi = vreinterpretq_s32_u32(vmovl_u16(vget_high_u16(x16)));
+}
+
+/* Load eight JSAMPLEs as two vectors of INT32s. */
+LOCAL(void)
+load_samples (const JSAMPLE * p, jvec * lo, jvec * hi)
+{
+  widen_samples(vld1_u8((const uint8_t *) p), lo, hi);
+}
+
+/* Load eight interleaved RGB pixels as two vectors per channel. */
+LOCAL(void)
+load_rgb (const JSAMPLE * p, jvec * r, jvec * g, jvec * b)
+{
+  uint8x8x3_t rgb = vld3_u8((const uint8_t *) p);
+
+  widen_samples(rgb.val[0], &r[0], &r[1]);
+  widen_samples(rgb.val[1], &g[0], &g[1]);
+  widen_samples(rgb.val[2], &b[0], &b[1]);
+}
+
+/* Saturate two vectors to 0..MAXJSAMPLE and pack them into eight JSAMPLEs. */
+LOCAL(uint8x8_t)
+pack_samples (jvec lo, jvec hi)
+{
+  return vqmovun_s16(vcombine_s16(vqmovn_s32(lo), vqmovn_s32(hi)));
+}
+
+LOCAL(void)
+store_samples (jvec lo, jvec hi, JSAMPLE * p)
+{
+  vst1_u8((uint8_t *) p, pack_samples(lo, hi));
+}
+
+/* Store eight RGB pixels, interleaved, from the saturated channels. */
+LOCAL(void)
+store_rgb (jvec r_lo, jvec r_hi, jvec g_lo, jvec g_hi, jvec b_lo, jvec b_hi,
+	   JSAMPLE * p)
+{
+  uint8x8x3_t rgb;
+
+  rgb.val[0] = pack_samples(r_lo, r_hi);
+  rgb.val[1] = pack_samples(g_lo, g_hi);
+  rgb.val[2] = pack_samples(b_lo, b_hi);
+  vst3_u8((uint8_t *) p, rgb);
+}
+
+/* Transpose the 4x4 matrix whose rows are a, b, c and d. */
+LOCAL(void)
+transpose4 (jvec * a, jvec * b, jvec * c, jvec * d)
+{
+  int32x4x2_t ab = vtrnq_s32(*a, *b);
+  int32x4x2_t cd = vtrnq_s32(*c, *d);
+
+  *a = vcombine_s32(vget_low_s32(ab.val[0]), vget_low_s32(cd.val[0]));
+  *b = vcombine_s32(vget_low_s32(ab.val[1]), vget_low_s32(cd.val[1]));
+  *c = vcombine_s32(vget_high_s32(ab.val[0]), vget_high_s32(cd.val[0]));
+  *d = vcombine_s32(vget_high_s32(ab.val[1]), vget_high_s32(cd.val[1]));
+}
+
+#elif defined(__SSE2__)
+
+#include <emmintrin.h>
+
+typedef __m128i jvec;
+
+#define VSPLAT(c)	_mm_set1_epi32(c)
+#define VADD(a,b)	_mm_add_epi32(a, b)
+#define VSUB(a,b)	_mm_sub_epi32(a, b)
+#define VMUL(a,b)	mul32(a, b)
+#define VMULC(a,c)	mul32(a, _mm_set1_epi32(c))
+#define VAND(a,b)	_mm_and_si128(a, b)
+#define VXOR(a,b)	_mm_xor_si128(a, b)
+#define VSHL(a,n)	_mm_slli_epi32(a, n)
+#define VSHR(a,n)	_mm_srai_epi32(a, n)
+#define VDIV(a,b)	_mm_cvttps_epi32(_mm_div_ps(_mm_cvtepi32_ps(a), \
+						    _mm_cvtepi32_ps(b)))
+
+/* SSE2 has no 32x32->32 bit multiply, so build it from two 32x32->64 bit
+ * unsigned multiplies.  The low 32 bits are the same for signed inputs.
+ */
+LOCAL(jvec)
+mul32 (jvec a, jvec b)
+{
+  __m128i even = _mm_mul_epu32(a, b);
+  __m128i odd = _mm_mul_epu32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32));
+
+  return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)),
+			    _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+}
+
+/* Load four JCOEFs or four ISLOW_MULT_TYPEs or DCTELEMs as INT32s. */
+LOCAL(jvec)
+load_coef (const JCOEF * p)
+{
+  __m128i x = _mm_loadl_epi64((const __m128i *) p);
+
+  return _mm_srai_epi32(_mm_unpacklo_epi16(x, x), 16);
+}
+
+#define VLOAD_COEF(p)	load_coef(p)
+#define VLOAD_INT(p)	_mm_loadu_si128((const __m128i *) (p))
+
+/* Store four DCTELEMs, or the low 16 bits of four INT32s as JCOEFs. */
+LOCAL(void)
+store_coef (JCOEF * p, jvec v)
+{
+  /* Sign-extend the low 16 bits, so that packing doesn't saturate. */
+  v = _mm_srai_epi32(_mm_slli_epi32(v, 16), 16);
+  _mm_storel_epi64((__m128i *) p, _mm_packs_epi32(v, v));
+}
+
+#define VSTORE_INT(p,v)	_mm_storeu_si128((__m128i *) (p), v)
+#define VSTORE_COEF(p,v)	store_coef(p, v)
+
+/* Load eight JSAMPLEs as two vectors of INT32s. */
+LOCAL(void)
+load_samples (const JSAMPLE * p, jvec * lo, jvec * hi)
+{
+  __m128i zero = _mm_setzero_si128();
+  __m128i x = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *) p), zero);
+
+  *lo = _mm_unpacklo_epi16(x, zero);
+  *hi = _mm_unpackhi_epi16(x, zero);
+}
+
+/* Load eight interleaved RGB pixels as two vectors per channel.
+ * SSE2 has no deinterleaving load, so this part stays scalar.
+ */
+LOCAL(void)
+load_rgb (const JSAMPLE * p, jvec * r, jvec * g, jvec * b)
+{
+  JSAMPLE rs[8], gs[8], bs[8];
+  int i;
+
+  for (i = 0; i < 8; i++) {
+    rs[i] = p[RGB_RED];
+    gs[i] = p[RGB_GREEN];
+    bs[i] = p[RGB_BLUE];
+    p += RGB_PIXELSIZE;
+  }
+  load_samples(rs, &r[0], &r[1]);
+  load_samples(gs, &g[0], &g[1]);
+  load_samples(bs, &b[0], &b[1]);
+}
+
+/* Saturate two vectors to 0..MAXJSAMPLE and pack them into eight JSAMPLEs,
+ * in the low half of the result.
+ */
+LOCAL(__m128i)
+pack_samples (jvec lo, jvec hi)
+{
+  __m128i x = _mm_packs_epi32(lo, hi);
+
+  return _mm_packus_epi16(x, x);
+}
+
+LOCAL(void)
+store_samples (jvec lo, jvec hi, JSAMPLE * p)
+{
+  _mm_storel_epi64((__m128i *) p, pack_samples(lo, hi));
+}
+
+/* Store eight RGB pixels, interleaved, from the saturated channels.
+ * SSE2 has no interleaving store, so this part stays scalar.
+ */
+LOCAL(void)
+store_rgb (jvec r_lo, jvec r_hi, jvec g_lo, jvec g_hi, jvec b_lo, jvec b_hi,
+	   JSAMPLE * p)
+{
+  JSAMPLE r[8], g[8], b[8];
+  int i;
+
+  store_samples(r_lo, r_hi, r);
+  store_samples(g_lo, g_hi, g);
+  store_samples(b_lo, b_hi, b);
+  for (i = 0; i < 8; i++) {
+    p[RGB_RED] = r[i];
+    p[RGB_GREEN] = g[i];
+    p[RGB_BLUE] = b[i];
+    p += RGB_PIXELSIZE;
+  }
+}
+
+/* Transpose the 4x4 matrix whose rows are a, b, c and d. */
+LOCAL(void)
+transpose4 (jvec * a, jvec * b, jvec * c, jvec * d)
+{
+  __m128i t0 = _mm_unpacklo_epi32(*a, *b);
+  __m128i t1 = _mm_unpacklo_epi32(*c, *d);
+  __m128i t2 = _mm_unpackhi_epi32(*a, *b);
+  __m128i t3 = _mm_unpackhi_epi32(*c, *d);
+
+  *a = _mm_unpacklo_epi64(t0, t1);
+  *b = _mm_unpackhi_epi64(t0, t1);
+  *c = _mm_unpacklo_epi64(t2, t3);
+  *d = _mm_unpackhi_epi64(t2, t3);
+}
+
+#else
+  Sorry, WITH_SIMD needs NEON or SSE2. /* deliberate syntax err */
+#endif
+
+
+/***************************** Inverse DCT *****************************/
+
+/* These must match jidctint.c. */
+
+#define CONST_BITS  13
+#define PASS1_BITS  2
+
+#define FIX_0_298631336  ((INT32)  2446)	/* FIX(0.298631336) */
+#define FIX_0_390180644  ((INT32)  3196)	/* FIX(0.390180644) */
+#define FIX_0_541196100  ((INT32)  4433)	/* FIX(0.541196100) */
+#define FIX_0_765366865  ((INT32)  6270)	/* FIX(0.765366865) */
+#define FIX_0_899976223  ((INT32)  7373)	/* FIX(0.899976223) */
+#define FIX_1_175875602  ((INT32)  9633)	/* FIX(1.175875602) */
+#define FIX_1_501321110  ((INT32)  12299)	/* FIX(1.501321110) */
+#define FIX_1_847759065  ((INT32)  15137)	/* FIX(1.847759065) */
+#define FIX_1_961570560  ((INT32)  16069)	/* FIX(1.961570560) */
+#define FIX_2_053119869  ((INT32)  16819)	/* FIX(2.053119869) */
+#define FIX_2_562915447  ((INT32)  20995)	/* FIX(2.562915447) */
+#define FIX_3_072711026  ((INT32)  25172)	/* FIX(3.072711026) */
+
+
+/*
+ * One pass of the islow inverse DCT of jidctint.c, on four columns (or
+ * rows) at once: in[k] holds input k of each.  The constant fudge is added
+ * to the scaled-up DC term; the results are left for the caller to descale.
+ */
+
+LOCAL(void)
+idct_islow_pass (const jvec * in, INT32 fudge, jvec * out)
+{
+  jvec tmp0, tmp1, tmp2, tmp3;
+  jvec tmp10, tmp11, tmp12, tmp13;
+  jvec z1, z2, z3;
+
+  /* Even part */
+
+  tmp0 = VADD(VSHL(VADD(in[0], in[4]), CONST_BITS), VSPLAT(fudge));
+  tmp1 = VADD(VSHL(VSUB(in[0], in[4]), CONST_BITS), VSPLAT(fudge));
+
+  z2 = in[2];
+  z3 = in[6];
+
+  z1 = VMULC(VADD(z2, z3), FIX_0_541196100);
+  tmp2 = VADD(z1, VMULC(z2, FIX_0_765366865));
+  tmp3 = VSUB(z1, VMULC(z3, FIX_1_847759065));
+
+  tmp10 = VADD(tmp0, tmp2);
+  tmp13 = VSUB(tmp0, tmp2);
+  tmp11 = VADD(tmp1, tmp3);
+  tmp12 = VSUB(tmp1, tmp3);
+
+  /* Odd part */
+
+  tmp0 = in[7];
+  tmp1 = in[5];
+  tmp2 = in[3];
+  tmp3 = in[1];
+
+  z2 = VADD(tmp0, tmp2);
+  z3 = VADD(tmp1, tmp3);
+
+  z1 = VMULC(VADD(z2, z3), FIX_1_175875602);
+  z2 = VADD(VMULC(z2, - FIX_1_961570560), z1);
+  z3 = VADD(VMULC(z3, - FIX_0_390180644), z1);
+
+  z1 = VMULC(VADD(tmp0, tmp3), - FIX_0_899976223);
+  tmp0 = VADD(VMULC(tmp0, FIX_0_298631336), VADD(z1, z2));
+  tmp3 = VADD(VMULC(tmp3, FIX_1_501321110), VADD(z1, z3));
+
+  z1 = VMULC(VADD(tmp1, tmp2), - FIX_2_562915447);
+  tmp1 = VADD(VMULC(tmp1, FIX_2_053119869), VADD(z1, z3));
+  tmp2 = VADD(VMULC(tmp2, FIX_3_072711026), VADD(z1, z2));
+
+  out[0] = VADD(tmp10, tmp3);
+  out[7] = VSUB(tmp10, tmp3);
+  out[1] = VADD(tmp11, tmp2);
+  out[6] = VSUB(tmp11, tmp2);
+  out[2] = VADD(tmp12, tmp1);
+  out[5] = VSUB(tmp12, tmp1);
+  out[3] = VADD(tmp13, tmp0);
+  out[4] = VSUB(tmp13, tmp0);
+}
+
+
+/*
+ * Perform dequantization and inverse DCT on one block of coefficients,
+ * as jpeg_idct_islow does.  Pass 1 works on the left and right halves of
+ * the columns; the workspace is then transposed in 4x4 blocks so that
+ * pass 2 can work on the top and bottom halves of the rows.
+ */
+
+GLOBAL(void)
+jsimd_idct_islow (j_decompress_ptr cinfo, jpeg_component_info * compptr,
+		  JCOEFPTR coef_block,
+		  JSAMPARRAY output_buf, JDIMENSION output_col)
+{
+  ISLOW_MULT_TYPE * quantptr = (ISLOW_MULT_TYPE *) compptr->dct_table;
+  jvec workspace[DCTSIZE][2];	/* [row][half of the columns] */
+  jvec in[DCTSIZE], out[DCTSIZE];
+  jvec range_mask = VSPLAT(RANGE_MASK);
+  jvec range_subset = VSPLAT(RANGE_SUBSET);
+  int half, k;
+
+  /* Pass 1: process columns from input, store into work array. */
+
+  for (half = 0; half < 2; half++) {
+    for (k = 0; k < DCTSIZE; k++)
+      in[k] = VMUL(VLOAD_COEF(coef_block + k * DCTSIZE + half * 4),
+		   VLOAD_INT(quantptr + k * DCTSIZE + half * 4));
+    /* Add fudge factor here for final descale. */
+    idct_islow_pass(in, ONE << (CONST_BITS-PASS1_BITS-1), out);
+    for (k = 0; k < DCTSIZE; k++)
+      workspace[k][half] = VSHR(out[k], CONST_BITS-PASS1_BITS);
+  }
+
+  /* Pass 2: process rows from work array, store into output array. */
+
+  for (half = 0; half < 2; half++) {
+    jvec * ws = workspace[half * 4];
+    JSAMPROW outptr;
+
+    /* in[k] is column k of rows half*4 .. half*4+3. */
+    for (k = 0; k < 2; k++) {
+      in[k * 4 + 0] = ws[0 * 2 + k];
+      in[k * 4 + 1] = ws[1 * 2 + k];
+      in[k * 4 + 2] = ws[2 * 2 + k];
+      in[k * 4 + 3] = ws[3 * 2 + k];
+      transpose4(&in[k * 4 + 0], &in[k * 4 + 1],
+		 &in[k * 4 + 2], &in[k * 4 + 3]);
+    }
+
+    /* Add range center and fudge factor for final descale and range-limit. */
+    idct_islow_pass(in, ((((INT32) RANGE_CENTER) << (PASS1_BITS+3)) +
+			 (ONE << (PASS1_BITS+2))) << CONST_BITS, out);
+
+    /* Descale and map to sample values, as the range_limit table does. */
+    for (k = 0; k < DCTSIZE; k++)
+      out[k] = VSUB(VAND(VSHR(out[k], CONST_BITS+PASS1_BITS+3), range_mask),
+		    range_subset);
+
+    /* Back to rows, and out to the output array. */
+    transpose4(&out[0], &out[1], &out[2], &out[3]);
+    transpose4(&out[4], &out[5], &out[6], &out[7]);
+    for (k = 0; k < 4; k++) {
+      outptr = output_buf[half * 4 + k] + output_col;
+      store_samples(out[k], out[k + 4], outptr);
+    }
+  }
+}
+
+
+/******************** Forward DCT and quantization ********************/
+
+
+/*
+ * One pass of the islow forward DCT of jfdctint.c, on four rows (first
+ * pass) or columns (second pass) at once, in place: data[k] holds element
+ * k of each.
+ */
+
+LOCAL(void)
+fdct_islow_pass (jvec * data, boolean first_pass)
+{
+  jvec tmp0, tmp1, tmp2, tmp3;
+  jvec tmp10, tmp11, tmp12, tmp13;
+  jvec z1, fudge;
+
+  /* Even part */
+
+  tmp0 = VADD(data[0], data[7]);
+  tmp1 = VADD(data[1], data[6]);
+  tmp2 = VADD(data[2], data[5]);
+  tmp3 = VADD(data[3], data[4]);
+
+  tmp10 = VADD(tmp0, tmp3);
+  tmp12 = VSUB(tmp0, tmp3);
+  tmp11 = VADD(tmp1, tmp2);
+  tmp13 = VSUB(tmp1, tmp2);
+
+  tmp0 = VSUB(data[0], data[7]);
+  tmp1 = VSUB(data[1], data[6]);
+  tmp2 = VSUB(data[2], data[5]);
+  tmp3 = VSUB(data[3], data[4]);
+
+  if (first_pass) {
+    /* Apply unsigned->signed conversion. */
+    data[0] = VSHL(VSUB(VADD(tmp10, tmp11), VSPLAT(8 * CENTERJSAMPLE)),
+		   PASS1_BITS);
+    data[4] = VSHL(VSUB(tmp10, tmp11), PASS1_BITS);
+    fudge = VSPLAT(ONE << (CONST_BITS-PASS1_BITS-1));
+  } else {
+    tmp10 = VADD(tmp10, VSPLAT(ONE << (PASS1_BITS-1)));
+    data[0] = VSHR(VADD(tmp10, tmp11), PASS1_BITS);
+    data[4] = VSHR(VSUB(tmp10, tmp11), PASS1_BITS);
+    fudge = VSPLAT(ONE << (CONST_BITS+PASS1_BITS-1));
+  }
+
+  z1 = VADD(VMULC(VADD(tmp12, tmp13), FIX_0_541196100), fudge);
+  tmp10 = VADD(z1, VMULC(tmp12, FIX_0_765366865));
+  tmp11 = VSUB(z1, VMULC(tmp13, FIX_1_847759065));
+
+  /* Odd part */
+
+  tmp12 = VADD(tmp0, tmp2);
+  tmp13 = VADD(tmp1, tmp3);
+
+  z1 = VADD(VMULC(VADD(tmp12, tmp13), FIX_1_175875602), fudge);
+  tmp12 = VADD(VMULC(tmp12, - FIX_0_390180644), z1);
+  tmp13 = VADD(VMULC(tmp13, - FIX_1_961570560), z1);
+
+  z1 = VMULC(VADD(tmp0, tmp3), - FIX_0_899976223);
+  tmp0 = VADD(VMULC(tmp0, FIX_1_501321110), VADD(z1, tmp12));
+  tmp3 = VADD(VMULC(tmp3, FIX_0_298631336), VADD(z1, tmp13));
+
+  z1 = VMULC(VADD(tmp1, tmp2), - FIX_2_562915447);
+  tmp1 = VADD(VMULC(tmp1, FIX_3_072711026), VADD(z1, tmp13));
+  tmp2 = VADD(VMULC(tmp2, FIX_2_053119869), VADD(z1, tmp12));
+
+  if (first_pass) {
+    data[2] = VSHR(tmp10, CONST_BITS-PASS1_BITS);
+    data[6] = VSHR(tmp11, CONST_BITS-PASS1_BITS);
+    data[1] = VSHR(tmp0, CONST_BITS-PASS1_BITS);
+    data[3] = VSHR(tmp1, CONST_BITS-PASS1_BITS);
+    data[5] = VSHR(tmp2, CONST_BITS-PASS1_BITS);
+    data[7] = VSHR(tmp3, CONST_BITS-PASS1_BITS);
+  } else {
+    data[2] = VSHR(tmp10, CONST_BITS+PASS1_BITS);
+    data[6] = VSHR(tmp11, CONST_BITS+PASS1_BITS);
+    data[1] = VSHR(tmp0, CONST_BITS+PASS1_BITS);
+    data[3] = VSHR(tmp1, CONST_BITS+PASS1_BITS);
+    data[5] = VSHR(tmp2, CONST_BITS+PASS1_BITS);
+    data[7] = VSHR(tmp3, CONST_BITS+PASS1_BITS);
+  }
+}
+
+
+/*
+ * Perform the forward DCT on one block of samples, as jpeg_fdct_islow
+ * does.  The block is transposed in 4x4 blocks on the way in, between the
+ * passes and not on the way out, as the first pass works on rows and the
+ * second on columns.
+ */
+
+GLOBAL(void)
+jsimd_fdct_islow (DCTELEM * data, JSAMPARRAY sample_data, JDIMENSION start_col)
+{
+  jvec rows[2][DCTSIZE];	/* [half of the rows][element] */
+  jvec cols[DCTSIZE];
+  int half, k;
+
+  /* Pass 1: process rows. */
+
+  for (half = 0; half < 2; half++) {
+    jvec * d = rows[half];
+
+    for (k = 0; k < 4; k++)
+      load_samples(sample_data[half * 4 + k] + start_col, &d[k], &d[k + 4]);
+    /* d[k] is now element k of rows half*4 .. half*4+3. */
+    transpose4(&d[0], &d[1], &d[2], &d[3]);
+    transpose4(&d[4], &d[5], &d[6], &d[7]);
+    fdct_islow_pass(d, TRUE);
+  }
+
+  /* Pass 2: process columns. */
+
+  for (half = 0; half < 2; half++) {
+    /* cols[k] is row k of columns half*4 .. half*4+3. */
+    for (k = 0; k < 4; k++) {
+      cols[k] = rows[0][half * 4 + k];
+      cols[k + 4] = rows[1][half * 4 + k];
+    }
+    transpose4(&cols[0], &cols[1], &cols[2], &cols[3]);
+    transpose4(&cols[4], &cols[5], &cols[6], &cols[7]);
+    fdct_islow_pass(cols, FALSE);
+    for (k = 0; k < DCTSIZE; k++)
+      VSTORE_INT(data + k * DCTSIZE + half * 4, cols[k]);
+  }
+}
+
+
+/*
+ * Quantize/descale the coefficients of one block, as forward_DCT does.
+ * The rounded magnitude and the divisor are both below 2^24, so that the
+ * float quotient truncates to the same integer as the scalar division.
+ */
+
+GLOBAL(void)
+jsimd_quantize (JCOEFPTR coef_block, DCTELEM * divisors, DCTELEM * workspace)
+{
+  int i;
+
+  for (i = 0; i < DCTSIZE2; i += 4) {
+    jvec temp = VLOAD_INT(workspace + i);
+    jvec qval = VLOAD_INT(divisors + i);
+    jvec sign = VSHR(temp, 31);
+
+    temp = VSUB(VXOR(temp, sign), sign);	/* force the dividend positive */
+    temp = VADD(temp, VSHR(qval, 1));	/* for rounding */
+    temp = VDIV(temp, qval);
+    temp = VSUB(VXOR(temp, sign), sign);
+    VSTORE_COEF(coef_block + i, temp);
+  }
+}
+
+
+/*********************** YCbCr <-> RGB conversion ***********************/
+
+/* These must match jdcolor.c and jccolor.c.  FIX is redefined for their
+ * scale.
+ */
+
+#undef FIX
+#define SCALEBITS	16
+#define ONE_HALF	((INT32) 1 << (SCALEBITS-1))
+#define CBCR_OFFSET	((INT32) CENTERJSAMPLE << SCALEBITS)
+#define FIX(x)		((INT32) ((x) * (1L<<SCALEBITS) + 0.5))
+
+
+/*
+ * Convert some rows of samples to the output colorspace, as
+ * ycc_rgb_convert does for sYCC, but computing the products that it looks
+ * up in tables.  Eight pixels are converted at a time; the rest of each
+ * row is converted one pixel at a time with the same arithmetic.
+ */
+
+GLOBAL(void)
+jsimd_ycc_rgb_convert (j_decompress_ptr cinfo,
+		       JSAMPIMAGE input_buf, JDIMENSION input_row,
+		       JSAMPARRAY output_buf, int num_rows)
+{
+  JSAMPROW outptr;
+  JSAMPROW inptr0, inptr1, inptr2;
+  JDIMENSION col;
+  JDIMENSION num_cols = cinfo->output_width;
+  jvec center = VSPLAT(CENTERJSAMPLE);
+  jvec one_half = VSPLAT(ONE_HALF);
+  SHIFT_TEMPS
+
+  while (--num_rows >= 0) {
+    inptr0 = input_buf[0][input_row];
+    inptr1 = input_buf[1][input_row];
+    inptr2 = input_buf[2][input_row];
+    input_row++;
+    outptr = *output_buf++;
+    for (col = 0; col + 8 <= num_cols; col += 8) {
+      jvec y[2], cb[2], cr[2], r[2], g[2], b[2];
+      int i;
+
+      load_samples(inptr0 + col, &y[0], &y[1]);
+      load_samples(inptr1 + col, &cb[0], &cb[1]);
+      load_samples(inptr2 + col, &cr[0], &cr[1]);
+      for (i = 0; i < 2; i++) {
+	cb[i] = VSUB(cb[i], center);
+	cr[i] = VSUB(cr[i], center);
+	r[i] = VADD(y[i], VSHR(VADD(VMULC(cr[i], FIX(1.402)), one_half),
+			       SCALEBITS));
+	g[i] = VADD(y[i],
+		    VSHR(VADD(VADD(VMULC(cb[i], - FIX(0.344136286)), one_half),
+			      VMULC(cr[i], - FIX(0.714136286))),
+			 SCALEBITS));
+	b[i] = VADD(y[i], VSHR(VADD(VMULC(cb[i], FIX(1.772)), one_half),
+			       SCALEBITS));
+      }
+      store_rgb(r[0], r[1], g[0], g[1], b[0], b[1], outptr);
+      outptr += 8 * RGB_PIXELSIZE;
+    }
+    for (; col < num_cols; col++) {
+      int y  = GETJSAMPLE(inptr0[col]);
+      INT32 cb = GETJSAMPLE(inptr1[col]) - CENTERJSAMPLE;
+      INT32 cr = GETJSAMPLE(inptr2[col]) - CENTERJSAMPLE;
+      int v;
+
+      v = y + (int) RIGHT_SHIFT(FIX(1.402) * cr + ONE_HALF, SCALEBITS);
+      outptr[RGB_RED]   = (JSAMPLE) (v < 0 ? 0 : v > MAXJSAMPLE ? MAXJSAMPLE : v);
+      v = y + (int) RIGHT_SHIFT((- FIX(0.344136286)) * cb + ONE_HALF +
+				(- FIX(0.714136286)) * cr, SCALEBITS);
+      outptr[RGB_GREEN] = (JSAMPLE) (v < 0 ? 0 : v > MAXJSAMPLE ? MAXJSAMPLE : v);
+      v = y + (int) RIGHT_SHIFT(FIX(1.772) * cb + ONE_HALF, SCALEBITS);
+      outptr[RGB_BLUE]  = (JSAMPLE) (v < 0 ? 0 : v > MAXJSAMPLE ? MAXJSAMPLE : v);
+      outptr += RGB_PIXELSIZE;
+    }
+  }
+}
+
+
+/*
+ * Convert some rows of samples to the JPEG colorspace, as rgb_ycc_convert
+ * does, computing the products that it looks up in tables.
+ */
+
+GLOBAL(void)
+jsimd_rgb_ycc_convert (j_compress_ptr cinfo,
+		       JSAMPARRAY input_buf, JSAMPIMAGE output_buf,
+		       JDIMENSION output_row, int num_rows)
+{
+  JSAMPROW inptr;
+  JSAMPROW outptr0, outptr1, outptr2;
+  JDIMENSION col;
+  JDIMENSION num_cols = cinfo->image_width;
+  jvec one_half = VSPLAT(ONE_HALF);
+  /* Rounding fudge-factor of 0.5-epsilon for Cb and Cr, as in jccolor.c. */
+  jvec cbcr_offset = VSPLAT(CBCR_OFFSET + ONE_HALF-1);
+
+  while (--num_rows >= 0) {
+    inptr = *input_buf++;
+    outptr0 = output_buf[0][output_row];
+    outptr1 = output_buf[1][output_row];
+    outptr2 = output_buf[2][output_row];
+    output_row++;
+    for (col = 0; col + 8 <= num_cols; col += 8) {
+      jvec r[2], g[2], b[2], y[2], cb[2], cr[2];
+      int i;
+
+      load_rgb(inptr, r, g, b);
+      for (i = 0; i < 2; i++) {
+	y[i] = VSHR(VADD(VADD(VMULC(r[i], FIX(0.299)),
+			      VMULC(g[i], FIX(0.587))),
+			 VADD(VMULC(b[i], FIX(0.114)), one_half)),
+		    SCALEBITS);
+	cb[i] = VSHR(VADD(VADD(VMULC(r[i], - FIX(0.168735892)),
+			       VMULC(g[i], - FIX(0.331264108))),
+			  VADD(VMULC(b[i], FIX(0.5)), cbcr_offset)),
+		     SCALEBITS);
+	cr[i] = VSHR(VADD(VADD(VMULC(r[i], FIX(0.5)),
+			       VMULC(g[i], - FIX(0.418687589))),
+			  VADD(VMULC(b[i], - FIX(0.081312411)), cbcr_offset)),
+		     SCALEBITS);
+      }
+      store_samples(y[0], y[1], outptr0 + col);
+      store_samples(cb[0], cb[1], outptr1 + col);
+      store_samples(cr[0], cr[1], outptr2 + col);
+      inptr += 8 * RGB_PIXELSIZE;
+    }
+    for (; col < num_cols; col++) {
+      INT32 r = GETJSAMPLE(inptr[RGB_RED]);
+      INT32 g = GETJSAMPLE(inptr[RGB_GREEN]);
+      INT32 b = GETJSAMPLE(inptr[RGB_BLUE]);
+
+      outptr0[col] = (JSAMPLE)
+	((FIX(0.299) * r + FIX(0.587) * g + FIX(0.114) * b + ONE_HALF)
+	 >> SCALEBITS);
+      outptr1[col] = (JSAMPLE)
+	((- FIX(0.168735892) * r - FIX(0.331264108) * g + FIX(0.5) * b +
+	  CBCR_OFFSET + ONE_HALF-1) >> SCALEBITS);
+      outptr2[col] = (JSAMPLE)
+	((FIX(0.5) * r - FIX(0.418687589) * g - FIX(0.081312411) * b +
+	  CBCR_OFFSET + ONE_HALF-1) >> SCALEBITS);
+      inptr += RGB_PIXELSIZE;
+    }
+  }
+}
+
+#endif /* WITH_SIMD */
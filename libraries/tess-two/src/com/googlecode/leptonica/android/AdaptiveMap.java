@@ -46,8 +46,12 @@ public class AdaptiveMap {
 
     public final static int DEFAULT_TILE_HEIGHT = 15;
 
+    public final static int DEFAULT_FG_THRESHOLD = 60;
+
     public final static int DEFAULT_MIN_COUNT = 40;
 
+    public final static int DEFAULT_BG_VALUE = 200;
+
     public final static int DEFAULT_X_SMOOTH_SIZE = 2;
 
     public final static int DEFAULT_Y_SMOOTH_SIZE = 1;
@@ -90,6 +94,8 @@ public class AdaptiveMap {
      * <li>A 'bgval' target background value for the normalized image. This
      * should be at least 128. If set too close to 255, some clipping will occur
      * in the result.
+     * <li>For 8 bpp images, the closing and the mapping are split across
+     * all cores, with the same result.
      * </ol>
      *
      * @param pixs A source pix image.
@@ -112,6 +118,61 @@ public class AdaptiveMap {
         return new Pix(nativePix);
     }
 
+    /**
+     * Normalizes an image's background by tiles, using default parameters.
+     *
+     * @see #backgroundNorm(Pix, int, int, int, int, int, int, int)
+     *
+     * @param pixs A source pix image (8 or 32 bpp).
+     * @return the source pix image with a normalized background
+     */
+    public static Pix backgroundNorm(Pix pixs) {
+        return backgroundNorm(pixs, DEFAULT_TILE_WIDTH, DEFAULT_TILE_HEIGHT,
+                DEFAULT_FG_THRESHOLD, DEFAULT_MIN_COUNT, DEFAULT_BG_VALUE,
+                DEFAULT_X_SMOOTH_SIZE, DEFAULT_Y_SMOOTH_SIZE);
+    }
+
+    /**
+     * Normalizes an image's background to a specified value, measuring the
+     * background in tiles.
+     * <p>
+     * Notes:
+     * <ol>
+     * <li>The input image is either grayscale or rgb.
+     * <li>The background in each tile is the average of the pixels that are
+     * not near foreground, found by thresholding at thresh. Tiles with fewer
+     * than minCount such pixels take their value from their neighbors.
+     * <li>The map of tile values is smoothed with a kernel of (2 * smoothX
+     * + 1) by (2 * smoothY + 1) tiles, and the image is then scaled so that
+     * the background in each tile is near bgval.
+     * <li>The scaling of the image is split across all cores, with the same
+     * result as Leptonica's pixBackgroundNorm.
+     * </ol>
+     *
+     * @param pixs A source pix image (8 or 32 bpp).
+     * @param sizeX Tile width; at least 4
+     * @param sizeY Tile height; at least 4
+     * @param thresh Threshold for determining foreground
+     * @param minCount Minimum count of background pixels in a tile
+     * @param bgval Target background value; typically &gt; 128
+     * @param smoothX Half-width of the smoothing kernel, in tiles
+     * @param smoothY Half-height of the smoothing kernel, in tiles
+     * @return the source pix image with a normalized background
+     */
+    public static Pix backgroundNorm(Pix pixs, int sizeX, int sizeY, int thresh,
+            int minCount, int bgval, int smoothX, int smoothY) {
+        if (pixs == null)
+            throw new IllegalArgumentException("Source pix must be non-null");
+
+        long nativePix = nativeBackgroundNorm(pixs.getNativePix(), sizeX, sizeY,
+                thresh, minCount, bgval, smoothX, smoothY);
+
+        if (nativePix == 0)
+            throw new RuntimeException("Failed to normalize image background");
+
+        return new Pix(nativePix);
+    }
+
     /**
      * Adaptively attempts to expand the contrast to the full dynamic range in 
      * each tile using default parameters.
@@ -151,6 +212,8 @@ public class AdaptiveMap {
      * each tile. The result can subsequently be globally corrected, by 
      * applying pixGammaTRC() with arbitrary values of gamma and the 0 and 255 
      * points of the mapping.
+     * <li>The mapping of the image is split across all cores, with the same
+     * result.
      * </ol>
      *
      * @param pixs A source pix image
@@ -184,6 +247,9 @@ public class AdaptiveMap {
     private static native long nativeBackgroundNormMorph(
             long nativePix, int reduction, int size, int bgval);
 
+    private static native long nativeBackgroundNorm(long nativePix, int sizeX,
+            int sizeY, int thresh, int minCount, int bgval, int smoothX, int smoothY);
+
     private static native long nativePixContrastNorm(
             long nativePix, int sizeX, int sizeY, int minDiff, int smoothX, int smoothY);
 }
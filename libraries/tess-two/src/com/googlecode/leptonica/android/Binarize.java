@@ -203,6 +203,48 @@ public class Binarize {
         return new Pix(nativePix);        
     }
 
+    /**
+     * Performs Sauvola binarization like
+     * {@link #sauvolaBinarizeTiled(Pix, int, float, int, int)}, with the
+     * same result, but binarizes the tiles in parallel.
+     * <p>
+     * Notes:
+     * <ol>
+     * <li> Tiles are handed out to numThreads threads, the calling thread
+     * being one of them. Use numThreads &lt;= 0 for one thread per core.
+     * With more tiles than threads, a slow tile holds up less of the work.
+     * <li> Local sums over the window are kept in 32 bits, which is exact
+     * up to whsize 128 (larger windows are left to Leptonica), and needs
+     * memory for a few rows of each tile rather than for the whole tile.
+     * <li> The 1 bpp result may be given to TessBaseAPI.setImage(Pix), which
+     * then uses it as the thresholded image instead of binarizing again.
+     * </ol>
+     *
+     * @param pixs An 8 bpp PIX source image.
+     * @param whsize Window half-width for measuring local statistics
+     * @param factor Factor for reducing threshold due to variance; &gt;= 0
+     * @param nx Subdivision into tiles; &gt;= 1
+     * @param ny Subdivision into tiles; &gt;= 1
+     * @param numThreads Number of threads to use; &lt;= 0 for the number of cores
+     * @return A 1 bpp thresholded PIX image.
+     */
+    public static Pix sauvolaBinarizeTiledParallel(Pix pixs, int whsize,
+                                                   @FloatRange(from=0.0) float factor,
+                                                   int nx, int ny, int numThreads) {
+        if (pixs == null)
+            throw new IllegalArgumentException("Source pix must be non-null");
+        if (pixs.getDepth() != 8)
+            throw new IllegalArgumentException("Source pix depth must be 8bpp");
+
+        long nativePix = nativeSauvolaBinarizeTiledParallel(pixs.getNativePix(),
+                whsize, factor, nx, ny, numThreads);
+
+        if (nativePix == 0)
+            throw new RuntimeException("Failed to perform Sauvola binarization on image");
+
+        return new Pix(nativePix);
+    }
+
     // ***************
     // * NATIVE CODE *
     // ***************
@@ -212,4 +254,7 @@ public class Binarize {
 
     private static native long nativeSauvolaBinarizeTiled(
             long nativePix, int whsize, float factor, int nx, int ny);
+
+    private static native long nativeSauvolaBinarizeTiledParallel(
+            long nativePix, int whsize, float factor, int nx, int ny, int numThreads);
 }
@@ -129,6 +129,20 @@ public class Boxa {
         return nativeGetGeometry(mNativeBoxa, index, geometry);
     }
 
+    /**
+     * Returns the coordinates of all the boxes with one call into native
+     * code, as x, y, w and h of each box in turn, so box i starts at index
+     * 4 * i. See INDEX_* constants for the order within a box.
+     *
+     * @return an array of 4 * getCount() box coordinates
+     */
+    public int[] getAllGeometry() {
+        if (mRecycled)
+            throw new IllegalStateException();
+
+        return nativeGetAllGeometry(mNativeBoxa);
+    }
+
     /**
      * Releases resources and frees any memory associated with this Box.
      */
@@ -159,4 +173,5 @@ public class Boxa {
     private static native void nativeDestroy(long nativeBox);
     private static native boolean nativeGetGeometry(long nativeBoxa, int index,  int[] geometry);
     private static native int nativeGetCount(long nativeBoxa);
+    private static native int[] nativeGetAllGeometry(long nativeBoxa);
 }
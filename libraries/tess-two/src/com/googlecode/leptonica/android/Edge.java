@@ -91,9 +91,35 @@ public class Edge {
         return new Pix(nativePix);
     }
 
+    /**
+     * Performs a Sobel edge detecting filter in place, replacing the
+     * contents of pixs with its edges.
+     *
+     * @see #pixSobelEdgeFilter(Pix, int)
+     *
+     * @param pixs Source pix (8 bpp; no colormap), overwritten with the
+     *        result (edges are brighter)
+     * @param orientFlag Edge orientation flag (L_HORIZONTAL_EDGES,
+     *        L_VERTICAL_EDGES, L_ALL_EDGES)
+     * @return true on success
+     */
+    public static boolean pixSobelEdgeFilterInPlace(Pix pixs,
+            @EdgeOrientationFlag int orientFlag) {
+        if (pixs == null)
+            throw new IllegalArgumentException("Source pix must be non-null");
+        if (pixs.getDepth() != 8)
+            throw new IllegalArgumentException("Source pix depth must be 8bpp");
+        if (orientFlag < 0 || orientFlag > 2)
+            throw new IllegalArgumentException("Invalid orientation flag");
+
+        return nativePixSobelEdgeFilterInPlace(pixs.getNativePix(), orientFlag);
+    }
+
     // ***************
     // * NATIVE CODE *
     // ***************
 
     private static native long nativePixSobelEdgeFilter(long nativePix, int orientFlag);
+
+    private static native boolean nativePixSobelEdgeFilterInPlace(long nativePix, int orientFlag);
 }
@@ -80,9 +80,34 @@ public class Enhance {
         return new Pix(nativePix);
     }
 
+    /**
+     * Performs unsharp masking (edge enhancement) in place, without
+     * allocating a new image.
+     *
+     * @see #unsharpMasking(Pix, int, float)
+     *
+     * @param pixs The source image (8 or 32 bpp; no colormap), overwritten
+     *            with the result
+     * @param halfwidth The half-width of the smoothing filter.
+     * @param fraction The fraction of edge to be added back into the source
+     *            image.
+     * @return true on success
+     */
+    public static boolean unsharpMaskingInPlace(Pix pixs, int halfwidth,
+            float fraction) {
+        if (pixs == null)
+            throw new IllegalArgumentException("Source pix must be non-null");
+
+        return nativeUnsharpMaskingInPlace(pixs.getNativePix(), halfwidth,
+                fraction);
+    }
+
     // ***************
     // * NATIVE CODE *
     // ***************
 
     private static native long nativeUnsharpMasking(long nativePix, int halfwidth, float fract);
+
+    private static native boolean nativeUnsharpMaskingInPlace(long nativePix, int halfwidth,
+            float fract);
 }
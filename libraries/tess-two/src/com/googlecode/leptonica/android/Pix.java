@@ -20,6 +20,9 @@ import android.graphics.Rect;
 import android.support.annotation.ColorInt;
 import android.support.annotation.Size;
 
+import java.nio.ByteBuffer;
+import java.nio.ByteOrder;
+
 /**
  * Java representation of a native Leptonica PIX object.
  *
@@ -101,6 +104,26 @@ public class Pix {
         return buffer;
     }
 
+    /**
+     * Returns a direct buffer over the native PIX object's raw data, without
+     * copying it. The buffer holds getHeight() rows of 32-bit words in native
+     * byte order, and is only valid until this Pix is recycled.
+     *
+     * @return a view of this PIX object's raw data
+     */
+    public ByteBuffer getDataBuffer() {
+        if (mRecycled)
+            throw new IllegalStateException();
+
+        ByteBuffer buffer = (ByteBuffer) nativeGetDataBuffer(mNativePix);
+
+        if (buffer == null) {
+            throw new RuntimeException("native getDataBuffer failed");
+        }
+
+        return buffer.order(ByteOrder.nativeOrder());
+    }
+
     /**
      * Returns an array of this image's dimensions. See Pix.INDEX_* for indices.
      *
@@ -216,6 +239,86 @@ public class Pix {
         return new Pix(nativePix);
     }
 
+    /**
+     * Creates an 8bpp Pix from the Y (luma) plane of a camera frame, such as
+     * the data of an NV21 frame from <code>Camera.PreviewCallback</code>,
+     * whose Y plane comes first. The luma is used as the grey value, with no
+     * color conversion.
+     *
+     * @param data frame data starting with the Y plane
+     * @param width The width of the frame.
+     * @param height The height of the frame.
+     * @param rowStride Bytes per row of the Y plane; the width for NV21.
+     * @return a new Pix
+     */
+    public static Pix fromNV21(byte[] data, int width, int height, int rowStride) {
+        if (data == null)
+            throw new IllegalArgumentException("Frame data must be non-null");
+
+        long nativePix = nativeCreateFromYUVBytes(data, width, height, rowStride);
+
+        if (nativePix == 0)
+            throw new IllegalArgumentException("Invalid Y plane size");
+
+        return new Pix(nativePix);
+    }
+
+    /**
+     * Creates an 8bpp Pix from the Y (luma) plane of a camera frame held in a
+     * direct {@link ByteBuffer}, such as the buffer of plane 0 of a
+     * YUV_420_888 <code>android.media.Image</code>.
+     *
+     * @see #fromNV21(byte[], int, int, int)
+     *
+     * @param yPlane direct buffer holding the Y plane, starting at index 0
+     * @param width The width of the frame.
+     * @param height The height of the frame.
+     * @param rowStride Bytes per row of the Y plane.
+     * @return a new Pix
+     */
+    public static Pix fromNV21(ByteBuffer yPlane, int width, int height, int rowStride) {
+        if (yPlane == null || !yPlane.isDirect())
+            throw new IllegalArgumentException("Y plane must be a direct buffer");
+
+        long nativePix = nativeCreateFromYUVBuffer(yPlane, width, height, rowStride);
+
+        if (nativePix == 0)
+            throw new IllegalArgumentException("Invalid Y plane size");
+
+        return new Pix(nativePix);
+    }
+
+    /**
+     * Serves the image data of all Pix made from now on from a preallocated
+     * memory store, so that repeatedly making and recycling frames of the
+     * same sizes, as in camera OCR, no longer allocates and frees large
+     * buffers each time.
+     * <p>
+     * Notes:
+     * <ol>
+     * <li>The store holds chunks of smallest bytes, and of each power of 2
+     * larger, up to 2<sup>n - 1</sup> * smallest for n counts: counts[i]
+     * chunks of smallest * 2<sup>i</sup> bytes. A Pix takes the smallest
+     * free chunk that fits its data, which is 4 * wpl * height bytes, and
+     * e.g. width * height for an 8 bpp Pix whose width is a multiple of 4.
+     * <li>Data smaller than half of smallest, larger than the largest chunk,
+     * or needed when all the chunks that fit are in use, is allocated as
+     * before.
+     * <li>The store is never freed, and can only be set up once per process.
+     * Pix made earlier are unaffected.
+     * </ol>
+     *
+     * @param smallest Size in bytes of the smallest chunks.
+     * @param counts Number of chunks of each size, smallest first.
+     * @return <code>true</code> if the store was set up
+     */
+    public static boolean enablePool(int smallest, int... counts) {
+        if (smallest <= 0 || counts == null || counts.length == 0)
+            throw new IllegalArgumentException("Invalid pool size classes");
+
+        return nativeEnablePool(smallest, counts);
+    }
+
     /**
      * Returns a Rect with the width and height of this Pix.
      *
@@ -312,14 +415,72 @@ public class Pix {
         nativeSetPixel(mNativePix, x, y, color);
     }
 
+    /**
+     * Copies the argb {@link android.graphics.Color}s of a region into an
+     * array, row by row, with one call into native code for the whole region.
+     * Only depths 1, 2, 4, 8 and 32 are supported.
+     *
+     * @param region The region of the image to read.
+     * @param pixels An array of at least region.width() * region.height()
+     *            elements to fill.
+     * @return <code>true</code> on success
+     * @throws IllegalArgumentException If the region exceeds the image bounds
+     *             or the array is too small.
+     */
+    public boolean getPixels(Rect region, int[] pixels) {
+        if (mRecycled)
+            throw new IllegalStateException();
+
+        checkRegion(region, pixels);
+
+        return nativeGetPixels(mNativePix, region.left, region.top,
+                region.width(), region.height(), pixels);
+    }
+
+    /**
+     * Sets the argb {@link android.graphics.Color}s of a region from an
+     * array, row by row, with one call into native code for the whole region.
+     * Only depths 1, 2, 4, 8 and 32 are supported.
+     *
+     * @param region The region of the image to write.
+     * @param pixels An array of at least region.width() * region.height()
+     *            colors to set.
+     * @return <code>true</code> on success
+     * @throws IllegalArgumentException If the region exceeds the image bounds
+     *             or the array is too small.
+     */
+    public boolean setPixels(Rect region, @ColorInt int[] pixels) {
+        if (mRecycled)
+            throw new IllegalStateException();
+
+        checkRegion(region, pixels);
+
+        return nativeSetPixels(mNativePix, region.left, region.top,
+                region.width(), region.height(), pixels);
+    }
+
+    private void checkRegion(Rect region, int[] pixels) {
+        if (region.left < 0 || region.top < 0 || region.right > getWidth()
+                || region.bottom > getHeight() || region.isEmpty()) {
+            throw new IllegalArgumentException("Supplied region exceeds image bounds");
+        } else if (pixels.length < region.width() * region.height()) {
+            throw new IllegalArgumentException("Pixel array is smaller than the region");
+        }
+    }
+
     // ***************
     // * NATIVE CODE *
     // ***************
 
     private static native int nativeGetRefCount(long nativePix);
+    private static native boolean nativeEnablePool(int smallest, int[] counts);
     private static native long nativeCreatePix(int w, int h, int d);
     private static native long nativeCreateFromData(byte[] data, int w, int h, int d);
+    private static native long nativeCreateFromYUVBytes(byte[] data, int w, int h, int rowStride);
+    private static native long nativeCreateFromYUVBuffer(ByteBuffer buffer, int w, int h,
+                                                         int rowStride);
     private static native byte[] nativeGetData(long nativePix);
+    private static native Object nativeGetDataBuffer(long nativePix);
     private static native long nativeClone(long nativePix);
     private static native long nativeCopy(long nativePix);
     private static native boolean nativeInvert(long nativePix);
@@ -330,4 +491,8 @@ public class Pix {
     private static native int nativeGetDepth(long nativePix);
     private static native int nativeGetPixel(long nativePix, int x, int y);
     private static native void nativeSetPixel(long nativePix, int x, int y, int color);
+    private static native boolean nativeGetPixels(long nativePix, int x, int y, int w, int h,
+            int[] pixels);
+    private static native boolean nativeSetPixels(long nativePix, int x, int y, int w, int h,
+            int[] pixels);
 }
@@ -384,6 +384,20 @@ public class Pixa implements Iterable<Pix> {
         return new Rect(x, y, x + w, y + h);
     }
 
+    /**
+     * Returns the box coordinates of all the elements with one call into
+     * native code, as x, y, w and h of each box in turn, so box i starts at
+     * index 4 * i. See Box.INDEX_* for the order within a box.
+     *
+     * @return an array of 4 * size() box coordinates
+     */
+    public int[] getAllBoxGeometry() {
+        if (mRecycled)
+            throw new IllegalStateException();
+
+        return nativeGetAllBoxGeometry(mNativePixa);
+    }
+
     /**
      * Returns an ArrayList of Box bounding Rects.
      *
@@ -393,16 +407,16 @@ public class Pixa implements Iterable<Pix> {
         if (mRecycled)
             throw new IllegalStateException();
 
-        final int pixaCount = nativeGetCount(mNativePixa);
-        final int[] buffer = new int[4];
+        final int[] geometry = getAllBoxGeometry();
+        final int pixaCount = geometry.length / 4;
         final ArrayList<Rect> rects = new ArrayList<Rect>(pixaCount);
 
         for (int i = 0; i < pixaCount; i++) {
-            getBoxGeometry(i, buffer);
-
-            final int x = buffer[Box.INDEX_X];
-            final int y = buffer[Box.INDEX_Y];
-            final Rect bound = new Rect(x, y, x + buffer[Box.INDEX_W], y + buffer[Box.INDEX_H]);
+            final int offset = 4 * i;
+            final int x = geometry[offset + Box.INDEX_X];
+            final int y = geometry[offset + Box.INDEX_Y];
+            final Rect bound = new Rect(x, y, x + geometry[offset + Box.INDEX_W],
+                    y + geometry[offset + Box.INDEX_H]);
 
             rects.add(bound);
         }
@@ -515,4 +529,6 @@ public class Pixa implements Iterable<Pix> {
     private static native long nativeGetPix(long nativePix, int index);
 
     private static native boolean nativeGetBoxGeometry(long nativePixa, int index, int[] dimensions);
+
+    private static native int[] nativeGetAllBoxGeometry(long nativePixa);
 }
@@ -0,0 +1,409 @@
+/*
+ * Copyright (C) 2017 Google Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+
+package com.googlecode.leptonica.android;
+
+import android.support.annotation.FloatRange;
+import android.util.Log;
+
+import java.util.Arrays;
+
+/**
+ * A sequence of preprocessing operations, such as deskewing, background
+ * normalization and binarization, that runs on a page in a single native
+ * call.
+ * <p>
+ * Compared to calling {@link Skew}, {@link Rotate}, {@link AdaptiveMap} and
+ * {@link Binarize} in turn, no intermediate image is handed back to Java,
+ * each one is freed as soon as the next operation has read it, and the
+ * rotation is skipped when the skew is too small or too uncertain to be
+ * worth it.
+ * <p>
+ * For example:
+ * <pre>
+ * PreprocessPipeline pipeline = new PreprocessPipeline()
+ *         .convertToGrey()
+ *         .deskew()
+ *         .backgroundNormMorph()
+ *         .sauvolaBinarize();
+ * Pix binary = pipeline.process(pix);
+ * </pre>
+ * A pipeline may be reused for any number of pages, but not by several
+ * threads at once. A pipeline that dewarps holds the model of the last page
+ * and must be released with {@link #recycle()}.
+ */
+@SuppressWarnings("WeakerAccess")
+public class PreprocessPipeline {
+    static {
+        System.loadLibrary("jpgt");
+        System.loadLibrary("pngt");
+        System.loadLibrary("lept");
+    }
+
+    // Operation codes, matching the native PipelineOp values
+
+    private static final int OP_CONVERT_TO_GREY = 0;
+    private static final int OP_DESKEW = 1;
+    private static final int OP_BACKGROUND_NORM = 2;
+    private static final int OP_SAUVOLA = 3;
+    private static final int OP_OTSU = 4;
+    private static final int OP_DEWARP = 5;
+
+    /** Number of parameters stored for each operation. */
+    private static final int PARAMS_PER_OP = 6;
+
+    // Deskew defaults, as used by Leptonica's pixDeskew
+
+    /** Default sweep range, + or - 7 degrees. */
+    public final static float DESKEW_SWEEP_RANGE = 7.0f;
+
+    /** Default sweep delta, one degree. */
+    public final static float DESKEW_SWEEP_DELTA = 1.0f;
+
+    /** Default sweep reduction, one-fourth the size of the original image. */
+    public final static int DESKEW_SWEEP_REDUCTION = 4;
+
+    /** Default search reduction, half the size of the original image. */
+    public final static int DESKEW_SEARCH_REDUCTION = 2;
+
+    /** Default skew below which the image is not rotated, in degrees. */
+    public final static float DESKEW_MIN_ANGLE = 0.1f;
+
+    /** Default confidence below which the image is not rotated. */
+    public final static float DESKEW_MIN_CONFIDENCE = 3.0f;
+
+    // Background normalization defaults, as used by AdaptiveMap
+
+    public final static int NORM_REDUCTION = 16;
+
+    public final static int NORM_SIZE = 3;
+
+    public final static int NORM_BG_VALUE = 200;
+
+    // Dewarp defaults
+
+    /**
+     * Default sampling of the disparity arrays, in pixels of the half size
+     * image that the model is built on.
+     */
+    public final static int DEWARP_SAMPLING = 16;
+
+    /** Default number of long text lines required to build a model. */
+    public final static int DEWARP_MIN_LINES = 15;
+
+    /**
+     * Default mean difference, in percent, up to which a frame is taken to
+     * show the same page as the one the model was built for.
+     */
+    public final static float DEWARP_MAX_DIFF = 2.0f;
+
+    private static final String TAG = PreprocessPipeline.class.getSimpleName();
+
+    private int[] mOps = new int[4];
+
+    private float[] mParams = new float[4 * PARAMS_PER_OP];
+
+    private int mNumOps;
+
+    private double[] mTimings = new double[0];
+
+    private float mSkewAngle;
+
+    /** Native model of the last page dewarped, or 0 if there is no dewarp op. */
+    private long mNativeDewarpModel;
+
+    /**
+     * Adds a conversion to 8 bpp grey, which does nothing if the image
+     * already is. Colour images are best converted before any other
+     * operation so that they work on a quarter of the data.
+     *
+     * @return this pipeline
+     */
+    public PreprocessPipeline convertToGrey() {
+        return addOp(OP_CONVERT_TO_GREY);
+    }
+
+    /**
+     * Adds deskewing with default parameters.
+     *
+     * @see #deskew(float, float, int, int, float, float)
+     *
+     * @return this pipeline
+     */
+    public PreprocessPipeline deskew() {
+        return deskew(DESKEW_SWEEP_RANGE, DESKEW_SWEEP_DELTA, DESKEW_SWEEP_REDUCTION,
+                DESKEW_SEARCH_REDUCTION, DESKEW_MIN_ANGLE, DESKEW_MIN_CONFIDENCE);
+    }
+
+    /**
+     * Adds deskewing: the skew is found as by
+     * {@link Skew#findSkew(Pix, float, float, int, int, float)} on a
+     * binarized copy of the image, and the image is rotated by area mapping
+     * to straighten it. The rotation is skipped when the skew is smaller
+     * than minAngle or found with a confidence below minConfidence.
+     *
+     * @param sweepRange Half the full search range, assumed about 0; in
+     *            degrees.
+     * @param sweepDelta Angle increment of sweep; in degrees.
+     * @param sweepReduction Sweep reduction factor = 1, 2, 4 or 8.
+     * @param searchReduction Binary search reduction factor = 1, 2, 4 or 8;
+     *            and must not exceed sweepReduction.
+     * @param minAngle Skew below which the image is not rotated; in degrees.
+     * @param minConfidence Confidence below which the image is not rotated.
+     * @return this pipeline
+     */
+    public PreprocessPipeline deskew(float sweepRange, float sweepDelta, int sweepReduction,
+            int searchReduction, @FloatRange(from=0.0) float minAngle, float minConfidence) {
+        return addOp(OP_DESKEW, sweepRange, sweepDelta, sweepReduction, searchReduction,
+                minAngle, minConfidence);
+    }
+
+    /**
+     * Adds background normalization with default parameters.
+     *
+     * @return this pipeline
+     */
+    public PreprocessPipeline backgroundNormMorph() {
+        return backgroundNormMorph(NORM_REDUCTION, NORM_SIZE, NORM_BG_VALUE);
+    }
+
+    /**
+     * Adds background normalization, as by
+     * {@link AdaptiveMap#backgroundNormMorph(Pix, int, int, int)}.
+     *
+     * @param normReduction Reduction at which morphological closings are done.
+     * @param normSize Size of square Sel for the closing.
+     * @param normBgValue Target background value.
+     * @return this pipeline
+     */
+    public PreprocessPipeline backgroundNormMorph(int normReduction, int normSize,
+            int normBgValue) {
+        return addOp(OP_BACKGROUND_NORM, normReduction, normSize, normBgValue);
+    }
+
+    /**
+     * Adds Sauvola binarization with default parameters, using one thread
+     * per core.
+     *
+     * @return this pipeline
+     */
+    public PreprocessPipeline sauvolaBinarize() {
+        return sauvolaBinarize(Binarize.SAUVOLA_DEFAULT_WINDOW_HALFWIDTH,
+                Binarize.SAUVOLA_DEFAULT_REDUCTION_FACTOR, Binarize.SAUVOLA_DEFAULT_NUM_TILES_X,
+                Binarize.SAUVOLA_DEFAULT_NUM_TILES_Y, 0);
+    }
+
+    /**
+     * Adds Sauvola binarization, as by
+     * {@link Binarize#sauvolaBinarizeTiledParallel(Pix, int, float, int, int, int)}.
+     * The image must be 8 bpp by then.
+     *
+     * @param whsize Window half-width for measuring local statistics
+     * @param factor Factor for reducing threshold due to variance; &gt;= 0
+     * @param nx Subdivision into tiles; &gt;= 1
+     * @param ny Subdivision into tiles; &gt;= 1
+     * @param numThreads Number of threads to use; &lt;= 0 for the number of cores
+     * @return this pipeline
+     */
+    public PreprocessPipeline sauvolaBinarize(int whsize, @FloatRange(from=0.0) float factor,
+            int nx, int ny, int numThreads) {
+        return addOp(OP_SAUVOLA, whsize, factor, nx, ny, numThreads);
+    }
+
+    /**
+     * Adds Otsu adaptive threshold binarization with default parameters.
+     *
+     * @return this pipeline
+     */
+    public PreprocessPipeline otsuBinarize() {
+        return otsuBinarize(Binarize.OTSU_SIZE_X, Binarize.OTSU_SIZE_Y, Binarize.OTSU_SMOOTH_X,
+                Binarize.OTSU_SMOOTH_Y, Binarize.OTSU_SCORE_FRACTION);
+    }
+
+    /**
+     * Adds Otsu adaptive threshold binarization, as by
+     * {@link Binarize#otsuAdaptiveThreshold(Pix, int, int, int, int, float)}.
+     * The image must be 8 bpp by then.
+     *
+     * @param sizeX Desired tile X dimension; actual size may vary.
+     * @param sizeY Desired tile Y dimension; actual size may vary.
+     * @param smoothX Half-width of convolution kernel applied to threshold
+     *            array: use 0 for no smoothing.
+     * @param smoothY Half-height of convolution kernel applied to threshold
+     *            array: use 0 for no smoothing.
+     * @param scoreFraction Fraction of the max Otsu score; typ. 0.1 (use 0.0
+     *            for standard Otsu).
+     * @return this pipeline
+     */
+    public PreprocessPipeline otsuBinarize(int sizeX, int sizeY, int smoothX, int smoothY,
+            @FloatRange(from=0.0, to=1.0) float scoreFraction) {
+        return addOp(OP_OTSU, sizeX, sizeY, smoothX, smoothY, scoreFraction);
+    }
+
+    /**
+     * Adds dewarping with default parameters, correcting both vertical and
+     * horizontal disparity, using one thread per core.
+     *
+     * @return this pipeline
+     */
+    public PreprocessPipeline dewarp() {
+        return dewarp(DEWARP_SAMPLING, DEWARP_MIN_LINES, true, DEWARP_MAX_DIFF, 0);
+    }
+
+    /**
+     * Adds dewarping of curved pages, such as camera captures of books, with
+     * Leptonica's page model. The model is built on a binary copy of the
+     * image at half size, and the image is resampled in bands of rows on
+     * several threads. The image is left unchanged when no valid model can
+     * be built for it, for example when it has too few text lines. The image
+     * must be 1, 8 or 32 bpp by then.
+     * <p>
+     * The model of the last page is kept, and a frame of the same size that
+     * differs from that page by at most maxDiff percent, measured on a
+     * coarse grid, reuses it. Use {@link #resetDewarpModel()} when the page
+     * is known to have changed.
+     *
+     * @param sampling Sampling of the disparity arrays, in pixels of the
+     *            half size image; &gt;= 8.
+     * @param minLines Number of long text lines required to build a model.
+     * @param useBoth Whether to also correct horizontal disparity.
+     * @param maxDiff Mean difference, in percent, up to which a frame reuses
+     *            the model of the last page; use 0 to reuse it only for an
+     *            identical page.
+     * @param numThreads Number of threads to use; &lt;= 0 for the number of cores
+     * @return this pipeline
+     */
+    public PreprocessPipeline dewarp(int sampling, int minLines, boolean useBoth,
+            @FloatRange(from=0.0) float maxDiff, int numThreads) {
+        return addOp(OP_DEWARP, sampling, minLines, useBoth ? 1 : 0, maxDiff, numThreads);
+    }
+
+    /**
+     * Forgets the model of the last page dewarped, so that the next image
+     * builds one again.
+     */
+    public void resetDewarpModel() {
+        if (mNativeDewarpModel != 0) {
+            nativeResetDewarpModel(mNativeDewarpModel);
+        }
+    }
+
+    /**
+     * Releases the model of the last page dewarped. The pipeline may still
+     * be used, and builds a new model if it dewarps.
+     */
+    public synchronized void recycle() {
+        if (mNativeDewarpModel != 0) {
+            nativeDestroyDewarpModel(mNativeDewarpModel);
+            mNativeDewarpModel = 0;
+        }
+    }
+
+    @Override
+    protected void finalize() throws Throwable {
+        try {
+            if (mNativeDewarpModel != 0) {
+                Log.w(TAG, "PreprocessPipeline was not terminated using recycle()");
+                recycle();
+            }
+        } finally {
+            super.finalize();
+        }
+    }
+
+    /**
+     * Runs the operations, in the order they were added, on a source image.
+     * The source image is left unchanged.
+     *
+     * @param pixs A source pix image.
+     * @return the processed image
+     */
+    public Pix process(Pix pixs) {
+        if (pixs == null)
+            throw new IllegalArgumentException("Source pix must be non-null");
+
+        double[] timings = new double[mNumOps];
+        float[] angle = new float[1];
+        // Made on first use, and again after recycle().
+        if (mNativeDewarpModel == 0) {
+            for (int i = 0; i < mNumOps; i++) {
+                if (mOps[i] == OP_DEWARP) {
+                    mNativeDewarpModel = nativeCreateDewarpModel();
+                    break;
+                }
+            }
+        }
+
+        long nativePix = nativeProcess(pixs.getNativePix(), Arrays.copyOf(mOps, mNumOps),
+                mParams, mNativeDewarpModel, timings, angle);
+
+        mTimings = timings;
+        mSkewAngle = angle[0];
+
+        if (nativePix == 0)
+            throw new RuntimeException("Failed to preprocess image");
+
+        return new Pix(nativePix);
+    }
+
+    /**
+     * Returns the wall-clock time spent in each operation during the last
+     * call to {@link #process(Pix)}, in the order they were added.
+     * Operations after one that failed have a time of 0.
+     *
+     * @return an array of times in milliseconds, one per operation
+     */
+    public double[] getTimings() {
+        return mTimings.clone();
+    }
+
+    /**
+     * Returns the skew that the last call to {@link #process(Pix)} found and
+     * corrected. The processed image is already straight, so this is only
+     * of interest for mapping results back onto the source image.
+     *
+     * @return the skew angle in degrees, or 0.0 if the image was not rotated
+     */
+    public float getSkewAngle() {
+        return mSkewAngle;
+    }
+
+    private PreprocessPipeline addOp(int op, float... params) {
+        if (mNumOps == mOps.length) {
+            mOps = Arrays.copyOf(mOps, 2 * mNumOps);
+            mParams = Arrays.copyOf(mParams, 2 * mNumOps * PARAMS_PER_OP);
+        }
+
+        mOps[mNumOps] = op;
+        System.arraycopy(params, 0, mParams, mNumOps * PARAMS_PER_OP, params.length);
+        mNumOps++;
+
+        return this;
+    }
+
+    // ***************
+    // * NATIVE CODE *
+    // ***************
+
+    private static native long nativeProcess(long nativePix, int[] ops, float[] params,
+            long nativeDewarpModel, double[] timings, float[] angle);
+
+    private static native long nativeCreateDewarpModel();
+
+    private static native void nativeResetDewarpModel(long nativeDewarpModel);
+
+    private static native void nativeDestroyDewarpModel(long nativeDewarpModel);
+}
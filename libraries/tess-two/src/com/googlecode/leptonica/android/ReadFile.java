@@ -18,9 +18,14 @@ package com.googlecode.leptonica.android;
 
 import android.graphics.Bitmap;
 import android.graphics.BitmapFactory;
+import android.support.annotation.FloatRange;
+import android.support.annotation.IntDef;
 import android.util.Log;
 
 import java.io.File;
+import java.lang.annotation.Retention;
+
+import static java.lang.annotation.RetentionPolicy.SOURCE;
 
 /**
  * Image input and output methods.
@@ -36,6 +41,20 @@ public class ReadFile {
 
     private static final String LOG_TAG = ReadFile.class.getSimpleName();
 
+    // Formulas reducing color bitmaps to grey
+    @Retention(SOURCE)
+    @IntDef({LUMA_AVERAGE, LUMA_LEPTONICA, LUMA_BT601})
+    public @interface LumaFormula {}
+
+    /** Mean of red, green and blue */
+    public static final int LUMA_AVERAGE = 0;
+
+    /** 0.3 red + 0.5 green + 0.2 blue, as Leptonica's pixConvertRGBToGray */
+    public static final int LUMA_LEPTONICA = 1;
+
+    /** 0.299 red + 0.587 green + 0.114 blue, as ITU-R BT.601 */
+    public static final int LUMA_BT601 = 2;
+
     /**
      * Creates a 32bpp Pix object from encoded data. Supported formats are BMP,
      * JPEG, and PNG.
@@ -61,6 +80,42 @@ public class ReadFile {
         return pix;
     }
 
+    /**
+     * Creates a Pix object from encoded data, reduced in size and optionally
+     * to grey while it is decoded. Supported formats are those of Leptonica,
+     * which include BMP, JPEG and PNG.
+     * <p>
+     * JPEG images are reduced by a factor of 2, 4 or 8 in the DCT domain and
+     * only their luminance is decoded when grey is requested, which takes a
+     * fraction of the time and memory of decoding them in full. Any scaling
+     * that remains, and the conversion of other formats, follows decoding.
+     *
+     * @param encodedData Encoded image data.
+     * @param targetScale Size of the result relative to the encoded image;
+     *            in (0, 1].
+     * @param grey Whether to return an 8bpp grey image.
+     * @return a Pix object, or null if the data cannot be decoded
+     */
+    public static Pix readMem(byte[] encodedData,
+            @FloatRange(from=0.0, fromInclusive=false, to=1.0) float targetScale,
+            boolean grey) {
+        if (encodedData == null) {
+            Log.e(LOG_TAG, "Image data byte array must be non-null");
+            return null;
+        }
+        if (targetScale <= 0.0f || targetScale > 1.0f)
+            throw new IllegalArgumentException("Target scale must be in (0, 1]");
+
+        final long nativePix = nativeReadMemScaled(encodedData, targetScale, grey);
+
+        if (nativePix == 0) {
+            Log.e(LOG_TAG, "Cannot decode image data");
+            return null;
+        }
+
+        return new Pix(nativePix);
+    }
+
     /**
      * Creates an 8bpp Pix object from raw 8bpp grayscale pixels.
      *
@@ -160,23 +215,77 @@ public class ReadFile {
     }
 
     /**
-     * Creates a Pix object from Bitmap data. Currently supports only
-     * ARGB_8888-formatted bitmaps.
+     * Creates a Pix object from an encoded file, reduced in size and
+     * optionally to grey while it is decoded.
+     *
+     * @see #readMem(byte[], float, boolean)
+     *
+     * @param file The encoded file to read in as a Pix.
+     * @param targetScale Size of the result relative to the encoded image;
+     *            in (0, 1].
+     * @param grey Whether to return an 8bpp grey image.
+     * @return a Pix object, or null if the file cannot be decoded
+     */
+    public static Pix readFile(File file,
+            @FloatRange(from=0.0, fromInclusive=false, to=1.0) float targetScale,
+            boolean grey) {
+        if (file == null) {
+            Log.e(LOG_TAG, "File must be non-null");
+            return null;
+        }
+        if (!file.canRead()) {
+            Log.e(LOG_TAG, "Cannot read file");
+            return null;
+        }
+        if (targetScale <= 0.0f || targetScale > 1.0f)
+            throw new IllegalArgumentException("Target scale must be in (0, 1]");
+
+        final long nativePix = nativeReadFileScaled(file.getAbsolutePath(), targetScale, grey);
+
+        if (nativePix == 0) {
+            Log.e(LOG_TAG, "Cannot decode file");
+            return null;
+        }
+
+        return new Pix(nativePix);
+    }
+
+    /**
+     * Creates an 8bpp Pix object from Bitmap data, reducing color to grey by
+     * the mean of red, green and blue.
+     *
+     * @see #readBitmap(Bitmap, int)
      *
      * @param bmp The Bitmap object to convert to a Pix.
      * @return a Pix object
      */
     public static Pix readBitmap(Bitmap bmp) {
+        return readBitmap(bmp, LUMA_AVERAGE);
+    }
+
+    /**
+     * Creates an 8bpp Pix object from Bitmap data. Supports ARGB_8888,
+     * RGB_565 and ALPHA_8 bitmaps, so none needs converting first. Color is
+     * reduced to grey by the given formula; the values of an ALPHA_8 bitmap
+     * are used as grey.
+     *
+     * @param bmp The Bitmap object to convert to a Pix.
+     * @param lumaFormula Formula reducing color to grey; one of LUMA_*
+     * @return a Pix object
+     */
+    public static Pix readBitmap(Bitmap bmp, @LumaFormula int lumaFormula) {
         if (bmp == null) {
             Log.e(LOG_TAG, "Bitmap must be non-null");
             return null;
         }
-        if (bmp.getConfig() != Bitmap.Config.ARGB_8888) {
-            Log.e(LOG_TAG, "Bitmap config must be ARGB_8888");
+        final Bitmap.Config config = bmp.getConfig();
+        if (config != Bitmap.Config.ARGB_8888 && config != Bitmap.Config.RGB_565
+                && config != Bitmap.Config.ALPHA_8) {
+            Log.e(LOG_TAG, "Bitmap config must be ARGB_8888, RGB_565 or ALPHA_8");
             return null;
         }
 
-        long nativePix = nativeReadBitmap(bmp);
+        long nativePix = nativeReadBitmap(bmp, lumaFormula);
 
         if (nativePix == 0) {
             Log.e(LOG_TAG, "Failed to read pix from bitmap");
@@ -198,5 +307,9 @@ public class ReadFile {
 
     private static native long nativeReadFile(String filename);
 
-    private static native long nativeReadBitmap(Bitmap bitmap);
+    private static native long nativeReadMemScaled(byte[] data, float scale, boolean grey);
+
+    private static native long nativeReadFileScaled(String filename, float scale, boolean grey);
+
+    private static native long nativeReadBitmap(Bitmap bitmap, int lumaFormula);
 }
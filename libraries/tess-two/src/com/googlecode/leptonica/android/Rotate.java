@@ -68,6 +68,8 @@ public class Rotate {
      * image.
      * <li>Above 20 degrees, if rotation by shear is requested, we rotate by
      * sampling.
+     * <li>Without high quality, rotation is by shear, split across all cores,
+     * which takes a few milliseconds to deskew a page.
      * <li>Colormaps are removed for rotation by area map and shear.
      * <li>The dest can be expanded so that no image pixels are lost. To invoke
      * expansion, input the original width and height. For repeated rotation,
@@ -18,6 +18,9 @@ package com.googlecode.leptonica.android;
 
 /**
  * Image scaling methods.
+ * <p>
+ * Images of 2 bpp and more are scaled a band of rows per core, giving the
+ * same result as Leptonica's pixScaleGeneral.
  * 
  * @author alanv@google.com (Alan Viverette)
  */
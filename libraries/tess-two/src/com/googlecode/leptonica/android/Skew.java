@@ -46,6 +46,29 @@ public class Skew {
     /** Default search minimum delta, reasonably accurate within 0.05 degrees. */
     public final static float SEARCH_MIN_DELTA = 0.01f;
 
+    // Coarse-to-fine defaults
+
+    /** Default coarse sweep delta, one degree. */
+    public final static float COARSE_SWEEP_DELTA = 1.0f;
+
+    /** Default coarse reduction, one-eighth the size of the original image. */
+    public final static int COARSE_REDUCTION = 8;
+
+    /** Default fine sweep range about the coarse angle, + or - 1 degree. */
+    public final static float FINE_RANGE = 1.0f;
+
+    /** Default fine sweep delta. */
+    public final static float FINE_DELTA = 0.2f;
+
+    /** Default fine search reduction, half the size of the original image. */
+    public final static int FINE_REDUCTION = 2;
+
+    /** Default confidence at which the coarse angle is not refined. */
+    public final static float EARLY_EXIT_CONFIDENCE = 6.0f;
+
+    /** Default confidence below which no skew is reported. */
+    public final static float MIN_CONFIDENCE = 3.0f;
+
     /** 
      * Finds and returns the skew angle using default parameters.
      * 
@@ -91,6 +114,54 @@ public class Skew {
                 sweepReduction, searchReduction, searchMinDelta);
     }
 
+    /**
+     * Finds and returns the skew angle coarse to fine using default
+     * parameters. This is much faster than {@link #findSkew(Pix)} for most
+     * pages, and the result may be passed on to
+     * TessBaseAPI.setPageSkew so layout analysis doesn't find it again.
+     *
+     * @param pixs Input pix (1 bpp).
+     * @return the detected skew angle, or 0.0 on failure
+     */
+    public static float findSkewCoarseToFine(Pix pixs) {
+        return findSkewCoarseToFine(pixs, SWEEP_RANGE, COARSE_SWEEP_DELTA, COARSE_REDUCTION,
+                FINE_RANGE, FINE_DELTA, FINE_REDUCTION, SEARCH_MIN_DELTA,
+                EARLY_EXIT_CONFIDENCE, MIN_CONFIDENCE);
+    }
+
+    /**
+     * Finds and returns the skew angle, first by a sweep and search over the
+     * full range on a heavily reduced image, then, only if that result is not
+     * already confident, by a narrow sweep and search about it at a lower
+     * reduction.
+     *
+     * @param pixs Input pix (1 bpp).
+     * @param sweepRange Half the full search range, assumed about 0; in
+     *            degrees.
+     * @param coarseDelta Angle increment of the coarse sweep; in degrees.
+     * @param coarseReduction Coarse reduction factor = 1, 2, 4 or 8.
+     * @param fineRange Half the fine search range about the coarse angle; in
+     *            degrees.
+     * @param fineDelta Angle increment of the fine sweep; in degrees.
+     * @param fineReduction Fine search reduction factor = 1, 2, 4 or 8; and
+     *            must not exceed coarseReduction.
+     * @param minDelta Minimum fine binary search increment angle; in degrees.
+     * @param earlyExitConfidence Confidence of the coarse angle above which
+     *            it is returned without refinement.
+     * @param minConfidence Confidence below which 0.0 is returned.
+     * @return the detected skew angle, or 0.0 on failure
+     */
+    public static float findSkewCoarseToFine(Pix pixs, float sweepRange, float coarseDelta,
+            int coarseReduction, float fineRange, float fineDelta, int fineReduction,
+            float minDelta, float earlyExitConfidence, float minConfidence) {
+        if (pixs == null)
+            throw new IllegalArgumentException("Source pix must be non-null");
+
+        return nativeFindSkewCoarseToFine(pixs.getNativePix(), sweepRange, coarseDelta,
+                coarseReduction, fineRange, fineDelta, fineReduction, minDelta,
+                earlyExitConfidence, minConfidence);
+    }
+
     // ***************
     // * NATIVE CODE *
     // ***************
@@ -98,4 +169,8 @@ public class Skew {
     private static native float nativeFindSkew(long nativePix, float sweepRange, float sweepDelta,
             int sweepReduction, int searchReduction, float searchMinDelta);
 
+    private static native float nativeFindSkewCoarseToFine(long nativePix, float sweepRange,
+            float coarseDelta, int coarseReduction, float fineRange, float fineDelta,
+            int fineReduction, float minDelta, float earlyExitConfidence, float minConfidence);
+
 }
@@ -101,7 +101,8 @@ public class WriteFile {
 
     /**
      * Writes a Pix to an Android Bitmap object. The output Bitmap will always
-     * be in ARGB_8888 format, but the input Pixs may be any bit-depth.
+     * be in ARGB_8888 format, and opaque unless the Pix has an alpha channel.
+     * The input Pixs may be 1, 8 or 32 bpp, and is left unchanged.
      *
      * @param pixs The source image.
      * @return a Bitmap containing a copy of the source image, or <code>null
@@ -17,6 +17,7 @@
 
 package com.googlecode.tesseract.android;
 
+import android.content.res.AssetManager;
 import android.graphics.Bitmap;
 import android.graphics.Rect;
 import android.support.annotation.IntDef;
@@ -27,6 +28,8 @@ import com.googlecode.leptonica.android.Pixa;
 import com.googlecode.leptonica.android.ReadFile;
 
 import java.io.File;
+import java.nio.ByteBuffer;
+import java.nio.ByteOrder;
 import java.lang.annotation.Retention;
 
 import static java.lang.annotation.RetentionPolicy.SOURCE;
@@ -114,6 +117,23 @@ public class TessBaseAPI {
     /** Save blob choices allowing us to get alternative results. */
     public static final String VAR_SAVE_BLOB_CHOICES = "save_blob_choices";
 
+    /**
+     * Reduction (2 or 4) of the image used to find the page layout, which is
+     * mapped back to full resolution for recognition. Speeds up automatic page
+     * segmentation of camera frames. Does not apply to the OSD and sparse text
+     * modes.
+     */
+    public static final String VAR_LAYOUT_REDUCTION = "tessedit_layout_reduction";
+
+    /**
+     * Method of thresholding a grey or color image: 0 for a global Otsu
+     * threshold (the default), 1 for tiled Otsu and 2 for Sauvola. Only the
+     * rectangle being recognized is thresholded, in native code, so there is
+     * no need to binarize with {@link com.googlecode.leptonica.android.Binarize}
+     * first.
+     */
+    public static final String VAR_THRESHOLDING_METHOD = "tessedit_thresholding_method";
+
     /** String value used to assign a boolean variable to true. */
     public static final String VAR_TRUE = "T";
 
@@ -167,8 +187,219 @@ public class TessBaseAPI {
         public static final int RIL_SYMBOL = 4;
     }
 
+    /**
+     * Layout of the buffer returned by {@link #getResultsPacked(int)}. All
+     * values are 32-bit ints, except the confidence, which is a float. The
+     * buffer starts with a header of {@link #HEADER_SIZE} ints: the version,
+     * the level, the number of records, the record size in bytes and the
+     * string pool size in bytes. It is followed by the records and then by
+     * the string pool of UTF-8 text.
+     */
+    public static final class PackedResults {
+        /** Version of the layout described here. */
+        public static final int VERSION = 1;
+
+        /** Size of the header in bytes. */
+        public static final int HEADER_SIZE = 5 * 4;
+
+        /** Header offsets, in bytes. */
+        public static final int HEADER_VERSION = 0;
+        public static final int HEADER_LEVEL = 4;
+        public static final int HEADER_RECORD_COUNT = 8;
+        public static final int HEADER_RECORD_SIZE = 12;
+        public static final int HEADER_POOL_SIZE = 16;
+
+        /** Offsets within a record, in bytes. */
+        public static final int RECORD_LEFT = 0;
+        public static final int RECORD_TOP = 4;
+        public static final int RECORD_RIGHT = 8;
+        public static final int RECORD_BOTTOM = 12;
+        public static final int RECORD_CONFIDENCE = 16;
+        /** Offset of the text from the start of the string pool. */
+        public static final int RECORD_TEXT_OFFSET = 20;
+        /** Length of the text in bytes. */
+        public static final int RECORD_TEXT_LENGTH = 24;
+        public static final int RECORD_FLAGS = 28;
+        public static final int RECORD_POINT_SIZE = 32;
+        public static final int RECORD_FONT_ID = 36;
+
+        /** Bits of the flags value of a record. */
+        public static final int FLAG_BOLD = 0x001;
+        public static final int FLAG_ITALIC = 0x002;
+        public static final int FLAG_UNDERLINED = 0x004;
+        public static final int FLAG_MONOSPACE = 0x008;
+        public static final int FLAG_SERIF = 0x010;
+        public static final int FLAG_SMALLCAPS = 0x020;
+        public static final int FLAG_FROM_DICTIONARY = 0x040;
+        public static final int FLAG_NUMERIC = 0x080;
+        public static final int FLAG_BLOCK_START = 0x100;
+        public static final int FLAG_PARA_START = 0x200;
+        public static final int FLAG_LINE_START = 0x400;
+    }
+
+    /**
+     * Layout of the buffer returned by {@link #startProgressPolling()}. All
+     * values are 32-bit ints, in the order of the arguments of
+     * {@link #onProgressValues}, after a sequence number that is odd while
+     * native code is writing the values and is incremented on every update.
+     */
+    public static final class ProgressBuffer {
+        /** Size of the buffer in bytes. */
+        public static final int SIZE = 10 * 4;
+
+        /** Offsets, in bytes. */
+        public static final int SEQUENCE = 0;
+        public static final int PERCENT = 4;
+        public static final int WORD_LEFT = 8;
+        public static final int WORD_RIGHT = 12;
+        public static final int WORD_TOP = 16;
+        public static final int WORD_BOTTOM = 20;
+        public static final int TEXT_LEFT = 24;
+        public static final int TEXT_RIGHT = 28;
+        public static final int TEXT_TOP = 32;
+        public static final int TEXT_BOTTOM = 36;
+    }
+
+    /**
+     * A text line found by {@link #detectTextLines()}.
+     */
+    public static final class TextLine {
+        /** The bounds of the line, in image coordinates. */
+        public final Rect bounds;
+        /** The likelihood that the line is text, between 0 and 1. */
+        public final float score;
+
+        TextLine(Rect bounds, float score) {
+            this.bounds = bounds;
+            this.score = score;
+        }
+    }
+
+    /**
+     * Indices into the array returned by {@link #getLayoutTimings()}, which
+     * holds the wall-clock milliseconds spent in each stage of the layout
+     * analysis of the last page.
+     * <p>
+     * When the tessedit_parallelize variable is above 1, image finding and
+     * connected component extraction run concurrently, so the stages may add
+     * up to more than {@link #TOTAL}.
+     */
+    public static final class LayoutTimings {
+        /** Finding and removing rule lines. */
+        public static final int LINE_FINDING = 0;
+        /** Finding the photo regions. */
+        public static final int IMAGE_FINDING = 1;
+        /** Extracting the connected components. */
+        public static final int COMPONENTS = 2;
+        /** Filtering noise and detecting orientation. */
+        public static final int SETUP = 3;
+        /** Finding the columns and text blocks. */
+        public static final int FIND_BLOCKS = 4;
+        /** All of layout analysis. */
+        public static final int TOTAL = 5;
+        /** Length of the array. */
+        public static final int COUNT = 6;
+    }
+
+    /**
+     * Indices into the array returned by {@link #getTimings()}, which holds
+     * the wall-clock milliseconds spent in each stage of the current page.
+     * <p>
+     * Adaption and cube recognition run inside the recognition passes, so
+     * their time is also counted in {@link #PASS1} and {@link #PASS2}.
+     */
+    public static final class StageTimings {
+        /** Thresholding the image. */
+        public static final int THRESHOLD = 0;
+        /** Layout analysis, as timed in detail by {@link #getLayoutTimings()}. */
+        public static final int LAYOUT = 1;
+        /** Finding the text lines and words. */
+        public static final int TEXTORD = 2;
+        /** The first recognition pass. */
+        public static final int PASS1 = 3;
+        /** The second recognition pass, with the adapted classifier. */
+        public static final int PASS2 = 4;
+        /** Training the adaptive classifier. */
+        public static final int ADAPTION = 5;
+        /** Cube recognition and combining its results. */
+        public static final int CUBE = 6;
+        /** Fixing the spaces between words. */
+        public static final int FIX_SPACES = 7;
+        /** Rendering the results through a result renderer. */
+        public static final int RENDERING = 8;
+        /** Length of the array. */
+        public static final int COUNT = 9;
+    }
+
+    /**
+     * Indices into the array returned by {@link #getPageCounters()}, which
+     * holds counts of the work done to recognize the current page, to tell
+     * why one page takes much longer than another.
+     */
+    public static final class PageCounters {
+        /** Blobs run through the adaptive classifier. */
+        public static final int BLOBS_CLASSIFIED = 0;
+        /** Character classes matched by the integer matcher. */
+        public static final int CLASS_MATCHES = 1;
+        /** Chops of a blob tried. */
+        public static final int CHOPS = 2;
+        /** Pain points classified by the segmentation search. */
+        public static final int PAIN_POINTS = 3;
+        /** Letters looked up in the dictionaries. */
+        public static final int DAWG_LOOKUPS = 4;
+        /** Noise outlines tried as diacritics. */
+        public static final int DIACRITICS = 5;
+        /** Blocks confident enough after the first pass to skip the rest. */
+        public static final int FAST_BLOCKS = 6;
+        /** Later passes skipped on those blocks, counted once per block. */
+        public static final int SKIPPED_PASSES = 7;
+        /** Words re-recognized to split off sub and superscripts. */
+        public static final int SUPERSCRIPT_TRIES = 8;
+        /** Those of them that were improved. */
+        public static final int SUPERSCRIPT_FIXES = 9;
+        /** Words re-recognized with a new x-height or baseline. */
+        public static final int XHEIGHT_TRIES = 10;
+        /** Those of them that were improved. */
+        public static final int XHEIGHT_FIXES = 11;
+        /** Length of the array. */
+        public static final int COUNT = 12;
+    }
+
+    /**
+     * Indices into the array returned by {@link #getMemoryUsage()}, which
+     * holds the bytes of memory used by each part of the loaded languages
+     * and the current page, to size thread pools and language combinations
+     * to the memory of the device.
+     */
+    public static final class MemoryUsage {
+        /** The unicharsets. */
+        public static final int UNICHARSET = 0;
+        /** The pre-trained character templates. */
+        public static final int INT_TEMPLATES = 1;
+        /** The shape tables. */
+        public static final int SHAPE_TABLE = 2;
+        /** The dictionaries. */
+        public static final int DAWGS = 3;
+        /** Cube's models, estimated from the sizes of their files. */
+        public static final int CUBE = 4;
+        /** The templates adapted to the pages recognized. */
+        public static final int ADAPTIVE_TEMPLATES = 5;
+        /** The source and thresholded images of the current page. */
+        public static final int IMAGES = 6;
+        /** The results of the current page. */
+        public static final int PAGE_RESULTS = 7;
+        /** The most held by the images and results of any one page. */
+        public static final int PAGE_PEAK = 8;
+        /** The peak resident size of the whole process. */
+        public static final int PEAK_RESIDENT = 9;
+        /** Length of the array. */
+        public static final int COUNT = 10;
+    }
+
     private ProgressNotifier progressNotifier;
 
+    private ByteBuffer mProgressBuffer;
+
     private boolean mRecycled;
 
     /**
@@ -181,6 +412,22 @@ public class TessBaseAPI {
         void onProgressValues(ProgressValues progressValues);
     }
 
+    /**
+     * Interface to receive the results of
+     * {@link #recognizeAsync(Pix, RecognitionCallback)}.
+     */
+    public interface RecognitionCallback {
+        /**
+         * Called on the native recognition worker thread when a page has been
+         * recognized. The iterator is deleted when this method returns, and
+         * the next queued page is not started until then.
+         *
+         * @param iterator the results for the page, or <code>null</code> if
+         *            recognition failed
+         */
+        void onRecognitionComplete(ResultIterator iterator);
+    }
+
     /**
      * Represents values indicating recognition progress and status.
      */
@@ -361,6 +608,62 @@ public class TessBaseAPI {
         return success;
     }
 
+    /**
+     * Initializes the Tesseract engine with language model(s) packaged in the
+     * application's assets, without copying them to storage first. The data
+     * files are read from <code>tessdata/[lang].traineddata</code> in the
+     * assets and must be stored uncompressed, for example with
+     * <code>aaptOptions { noCompress "traineddata" }</code>. The dictionaries
+     * are used in place from the APK rather than copied to the heap.
+     * Cube data can not be loaded from assets.
+     *
+     * @see #init(String, String)
+     *
+     * @param assets the application's asset manager
+     * @param language an ISO 639-3 string representing the language(s)
+     * @param ocrEngineMode the OCR engine mode to be set
+     * @return <code>true</code> on success
+     */
+    public boolean initFromAssets(AssetManager assets, String language,
+            @OcrEngineMode int ocrEngineMode) {
+        if (assets == null)
+            throw new IllegalArgumentException("Asset manager must not be null!");
+        if (language == null)
+            throw new IllegalArgumentException("Language must not be null!");
+
+        boolean success = nativeInitFromAssets(mNativeData, assets, language, ocrEngineMode);
+
+        if (success) {
+            mRecycled = false;
+        }
+
+        return success;
+    }
+
+    /**
+     * Starts loading the dictionaries of the specified language model(s) on a
+     * background thread and returns at once. Call this early during app
+     * startup so that a later {@link #init(String, String)} with the same
+     * arguments finds the dictionaries already in memory. An init that runs
+     * while they are still loading waits for them instead of loading them
+     * again. They stay loaded for the life of the process.
+     *
+     * @param datapath the parent directory of tessdata ending in a forward
+     *            slash
+     * @param language an ISO 639-3 string representing the language(s)
+     * @return <code>true</code> if the background load was started
+     */
+    public static boolean preloadLanguages(String datapath, String language) {
+        if (datapath == null)
+            throw new IllegalArgumentException("Data path must not be null!");
+        if (language == null)
+            throw new IllegalArgumentException("Language must not be null!");
+        if (!datapath.endsWith(File.separator))
+            datapath += File.separator;
+
+        return nativePreloadLanguages(datapath, language);
+    }
+
     /**
      * Returns the languages string used in the last valid initialization.
      * If the last initialization specified "deu+hin" then that will be
@@ -398,6 +701,7 @@ public class TessBaseAPI {
      */
     public void end() {
         if (!mRecycled) {
+            mProgressBuffer = null;
             nativeEnd(mNativeData);
 
             mRecycled = true;
@@ -434,6 +738,69 @@ public class TessBaseAPI {
         return nativeSetVariable(mNativeData, var, value);
     }
 
+    /**
+     * Sets several internal parameters at once, as {@link #setVariable}
+     * would, crossing into native code only once.
+     * 
+     * @param namesAndValues each parameter name followed by its value
+     * @return the number of names that were found
+     */
+    public int setVariables(String[] namesAndValues) {
+        if (mRecycled)
+            throw new IllegalStateException();
+        if (namesAndValues.length % 2 != 0)
+            throw new IllegalArgumentException("Each name needs a value");
+
+        return nativeSetVariables(mNativeData, namesAndValues);
+    }
+
+    /**
+     * Adds words to the user dictionary of the loaded language(s) without
+     * reloading anything else, so that a profile switch does not need a new
+     * {@link #init(String, String)}. The words count from the next
+     * recognition on. Must not be called while a recognition is running.
+     *
+     * @param words the words to add
+     * @return the number of words that could be expressed in the character
+     *         set of the language(s)
+     */
+    public int addUserWords(String[] words) {
+        if (mRecycled)
+            throw new IllegalStateException();
+        if (words == null)
+            throw new IllegalArgumentException("Words must not be null!");
+
+        return nativeAddUserWords(mNativeData, words);
+    }
+
+    /**
+     * Adds patterns, written as in a user-patterns file, to the user patterns
+     * of the loaded language(s). Only works if <code>user_patterns_suffix</code>
+     * or <code>user_patterns_file</code> was set for init.
+     *
+     * @param patterns the patterns to add
+     * @return the number of patterns that could be parsed
+     */
+    public int addUserPatterns(String[] patterns) {
+        if (mRecycled)
+            throw new IllegalStateException();
+        if (patterns == null)
+            throw new IllegalArgumentException("Patterns must not be null!");
+
+        return nativeAddUserPatterns(mNativeData, patterns);
+    }
+
+    /**
+     * Removes all user words and user patterns, including any loaded during
+     * init.
+     */
+    public void clearUserWords() {
+        if (mRecycled)
+            throw new IllegalStateException();
+
+        nativeClearUserWords(mNativeData);
+    }
+
     /**
      * Return the current page segmentation mode.
      *
@@ -538,6 +905,10 @@ public class TessBaseAPI {
      * SetImage clears all recognition results, and sets the rectangle to the
      * full image, so it may be followed immediately by a GetUTF8Text, and it
      * will automatically perform recognition.
+     * <p>
+     * ARGB_8888 bitmaps are converted to greyscale directly into Tesseract's
+     * thresholder, without creating an intermediate Pix. Other configs
+     * are not supported.
      *
      * @param bmp bitmap representation of the image
      */
@@ -545,16 +916,12 @@ public class TessBaseAPI {
     public void setImage(Bitmap bmp) {
         if (mRecycled)
             throw new IllegalStateException();
+        if (bmp == null || bmp.getConfig() != Bitmap.Config.ARGB_8888)
+            throw new IllegalArgumentException("Bitmap config must be ARGB_8888");
 
-        Pix image = ReadFile.readBitmap(bmp);
-
-        if (image == null) {
+        if (!nativeSetImageBitmap(mNativeData, bmp)) {
             throw new RuntimeException("Failed to read bitmap");
         }
-
-        nativeSetImagePix(mNativeData, image.getNativePix());
-        
-        image.recycle();
     }
 
     /**
@@ -593,6 +960,81 @@ public class TessBaseAPI {
         nativeSetImageBytes(mNativeData, imagedata, width, height, bpp, bpl);
     }
 
+    /**
+     * Provides an image for Tesseract to recognize, read directly from a
+     * direct {@link ByteBuffer} without an intermediate copy on either side
+     * of JNI. The buffer only has to remain valid and unmodified for the
+     * duration of this call; the caller may reuse it for the next frame as
+     * soon as the method returns.
+     * SetImage clears all recognition results, and sets the rectangle to the
+     * full image, so it may be followed immediately by a GetUTF8Text, and it
+     * will automatically perform recognition.
+     *
+     * @param imagedata direct buffer holding the image, starting at index 0
+     * @param width image width
+     * @param height image height
+     * @param bpp bytes per pixel
+     * @param bpl bytes per line
+     */
+    @WorkerThread
+    public void setImage(ByteBuffer imagedata, int width, int height, int bpp, int bpl) {
+        if (mRecycled)
+            throw new IllegalStateException();
+        if (!imagedata.isDirect())
+            throw new IllegalArgumentException("Image buffer must be a direct buffer!");
+
+        if (!nativeSetImageDirectBuffer(mNativeData, imagedata, width, height, bpp, bpl))
+            throw new IllegalArgumentException("Image buffer is too small!");
+    }
+
+    /**
+     * Provides the Y (luma) plane of a camera frame for Tesseract to recognize
+     * as a greyscale image, such as the data of an NV21 frame from
+     * <code>Camera.PreviewCallback</code>, whose Y plane comes first. The
+     * plane is copied straight into Tesseract's own image in one pass, with
+     * no color conversion and no intermediate Bitmap or Pix, so the array
+     * may be reused for the next frame as soon as this method returns.
+     * SetImage clears all recognition results, and sets the rectangle to the
+     * full image, so it may be followed immediately by a GetUTF8Text, and it
+     * will automatically perform recognition.
+     *
+     * @param data frame data starting with the Y plane
+     * @param width image width
+     * @param height image height
+     * @param rowStride bytes per row of the Y plane; the width for NV21
+     */
+    @WorkerThread
+    public void setImageYUV(byte[] data, int width, int height, int rowStride) {
+        if (mRecycled)
+            throw new IllegalStateException();
+
+        if (!nativeSetImageYUVBytes(mNativeData, data, width, height, rowStride))
+            throw new IllegalArgumentException("Invalid Y plane size!");
+    }
+
+    /**
+     * Provides the Y (luma) plane of a camera frame for Tesseract to recognize
+     * as a greyscale image, as {@link #setImageYUV(byte[], int, int, int)}
+     * does, from a direct {@link ByteBuffer} such as the buffer of plane 0 of
+     * a YUV_420_888 <code>android.media.Image</code>.
+     *
+     * @param yPlane direct buffer holding the Y plane, starting at index 0
+     * @param width image width
+     * @param height image height
+     * @param rowStride bytes per row of the Y plane, as given by
+     *                  <code>Image.Plane.getRowStride()</code>
+     */
+    @WorkerThread
+    public void setImageYUV(ByteBuffer yPlane, int width, int height, int rowStride) {
+        if (mRecycled)
+            throw new IllegalStateException();
+        if (!yPlane.isDirect())
+            throw new IllegalArgumentException("Y plane must be a direct buffer!");
+
+        if (!nativeSetImageYUVDirectBuffer(mNativeData, yPlane, width, height, rowStride))
+            throw new IllegalArgumentException("Invalid Y plane size!");
+    }
+
     /**
      * The recognized text is returned as a String which is coded as UTF8.
      * This is a blocking operation that will not work with {@link #stop()}.
@@ -612,6 +1054,134 @@ public class TessBaseAPI {
         return text != null ? text.trim() : null;
     }
 
+    /**
+     * Recognizes several rectangles of the current image in one call. This
+     * gives the same kind of result as calling {@link #setRectangle(Rect)}
+     * and {@link #getUTF8Text()} for each rectangle, but the image is
+     * thresholded only once, which makes reading many small fields of one
+     * image much faster.
+     * <p>
+     * The page segmentation mode is only used for these regions; the
+     * previous mode and rectangle are restored afterwards and the previous
+     * recognition results are cleared.
+     *
+     * @param regions the rectangles to recognize, in image coordinates
+     * @param pageSegMode the page segmentation mode for every region, for
+     *                    example {@link PageSegMode#PSM_SINGLE_LINE}
+     * @param confidences if not null, must have at least as many entries as
+     *                    there are regions and receives the mean confidence
+     *                    of each region
+     * @return the recognized text of each region, in the order of
+     *         <code>regions</code>, or null on error
+     */
+    @WorkerThread
+    public String[] getUTF8Text(Rect[] regions, @PageSegMode.Mode int pageSegMode,
+            int[] confidences) {
+        if (mRecycled)
+            throw new IllegalStateException();
+        if (confidences != null && confidences.length < regions.length)
+            throw new IllegalArgumentException("Confidence array is too small!");
+
+        int[] boxes = new int[regions.length * 4];
+        for (int i = 0; i < regions.length; i++) {
+            boxes[i * 4] = regions[i].left;
+            boxes[i * 4 + 1] = regions[i].top;
+            boxes[i * 4 + 2] = regions[i].width();
+            boxes[i * 4 + 3] = regions[i].height();
+        }
+
+        String[] text = nativeRecognizeRegions(mNativeData, boxes, pageSegMode, confidences);
+        if (text != null) {
+            for (int i = 0; i < text.length; i++)
+                text[i] = text[i].trim();
+        }
+
+        return text;
+    }
+
+    /**
+     * Finds the tables of the current image and recognizes each of their
+     * cells on its own, sharing the cells out between
+     * <code>tessedit_parallelize</code> engines. Tables are only found when
+     * the <code>textord_tablefind_recognize_tables</code> variable is set,
+     * and the current page segmentation mode must find columns, for example
+     * {@link PageSegMode#PSM_AUTO}.
+     * <p>
+     * The previous rectangle is restored afterwards and the previous
+     * recognition results are cleared.
+     *
+     * @param cellPageSegMode the page segmentation mode for every cell, for
+     *                        example {@link PageSegMode#PSM_SINGLE_LINE}
+     * @return the recognized text of each table, indexed by row from the
+     *         top and then by column from the left, or null on error
+     */
+    @WorkerThread
+    public String[][][] recognizeTables(@PageSegMode.Mode int cellPageSegMode) {
+        if (mRecycled)
+            throw new IllegalStateException();
+
+        String[][][] tables = nativeRecognizeTables(mNativeData, cellPageSegMode);
+        if (tables != null) {
+            for (String[][] table : tables) {
+                for (String[] row : table) {
+                    for (int i = 0; i < row.length; i++)
+                        row[i] = row[i].trim();
+                }
+            }
+        }
+
+        return tables;
+    }
+
+    /**
+     * Queues an image for recognition on a native worker thread and returns
+     * immediately. Pages are recognized one at a time, in the order they were
+     * queued, and the results are delivered to the callback on the worker
+     * thread. Progress is reported to the {@link ProgressNotifier} as for
+     * {@link #getHOCRText(int)}, and {@link #stop()} cancels the current page
+     * and the pages queued before the call, whose callbacks then receive
+     * <code>null</code>.
+     * <p>
+     * Until the last callback has been received, this instance must not be
+     * used for anything other than queueing more pages or calling
+     * {@link #stop()}. Calling {@link #end()} drops the pages that have not
+     * been started yet without calling their callbacks; it must not be called
+     * from a callback.
+     *
+     * @param pix the image to recognize, which may be recycled once this
+     *            method returns
+     * @param callback the callback to receive the results
+     */
+    public void recognizeAsync(Pix pix, RecognitionCallback callback) {
+        if (mRecycled)
+            throw new IllegalStateException();
+        if (pix == null)
+            throw new IllegalArgumentException("Image must not be null!");
+        if (callback == null)
+            throw new IllegalArgumentException("Callback must not be null!");
+
+        if (!nativeRecognizeAsync(mNativeData, pix.getNativePix(), callback))
+            throw new IllegalStateException("Could not start the recognition worker!");
+    }
+
+    /**
+     * Called from the native recognition worker when a queued page is done.
+     *
+     * @param callback the callback that was queued with the page
+     * @param nativeResultIterator pointer to the result iterator, or 0
+     */
+    private void onAsyncRecognitionComplete(RecognitionCallback callback,
+            long nativeResultIterator) {
+        ResultIterator iterator = nativeResultIterator != 0
+                ? new ResultIterator(nativeResultIterator) : null;
+        try {
+            callback.onRecognitionComplete(iterator);
+        } finally {
+            if (iterator != null)
+                iterator.delete();
+        }
+    }
+
     /**
      * Returns the (average) confidence value between 0 and 100.
      *
@@ -645,6 +1215,303 @@ public class TessBaseAPI {
         return conf;
     }
 
+    /**
+     * Returns the time taken by each stage of the layout analysis of the last
+     * page, indexed by the {@link LayoutTimings} constants.
+     *
+     * @return an array of {@link LayoutTimings#COUNT} times in milliseconds
+     */
+    public double[] getLayoutTimings() {
+        if (mRecycled)
+            throw new IllegalStateException();
+
+        double[] timings = nativeGetLayoutTimings(mNativeData);
+
+        if (timings == null)
+            timings = new double[LayoutTimings.COUNT];
+
+        return timings;
+    }
+
+    /**
+     * Returns the time taken by each stage of the current page so far,
+     * indexed by the {@link StageTimings} constants.
+     *
+     * @return an array of {@link StageTimings#COUNT} times in milliseconds
+     */
+    public double[] getTimings() {
+        if (mRecycled)
+            throw new IllegalStateException();
+
+        double[] timings = nativeGetTimings(mNativeData);
+
+        if (timings == null)
+            timings = new double[StageTimings.COUNT];
+
+        return timings;
+    }
+
+    /**
+     * Returns the counts of the work done to recognize the current page,
+     * indexed by the {@link PageCounters} constants. The counts are only
+     * complete once recognition of the page has finished.
+     *
+     * @return an array of {@link PageCounters#COUNT} counts
+     */
+    public long[] getPageCounters() {
+        if (mRecycled)
+            throw new IllegalStateException();
+
+        long[] counters = nativeGetPageCounters(mNativeData);
+
+        if (counters == null)
+            counters = new long[PageCounters.COUNT];
+
+        return counters;
+    }
+
+    /**
+     * Returns the bytes of memory used by each part of the loaded languages
+     * and of the current page, indexed by the {@link MemoryUsage} constants.
+     * The sizes are worked out from the data structures, so they leave out
+     * allocator overhead.
+     *
+     * @return an array of {@link MemoryUsage#COUNT} sizes in bytes
+     */
+    public long[] getMemoryUsage() {
+        if (mRecycled)
+            throw new IllegalStateException();
+
+        long[] usage = nativeGetMemoryUsage(mNativeData);
+
+        if (usage == null)
+            usage = new long[MemoryUsage.COUNT];
+
+        return usage;
+    }
+
+    /**
+     * Sets the skew angle of the current image when it is already known, for
+     * example from {@link com.googlecode.leptonica.android.Skew#findSkew(Pix)},
+     * so layout analysis starts from it instead of estimating the skew again.
+     * Call after setting the image.
+     *
+     * @param degrees the skew angle, as returned by Skew.findSkew
+     */
+    public void setPageSkew(float degrees) {
+        if (mRecycled)
+            throw new IllegalStateException();
+
+        nativeSetPageSkew(mNativeData, degrees);
+    }
+
+    /**
+     * Returns the skew angle of the current image, as set by
+     * {@link #setPageSkew(float)} or, when the textord_estimate_page_skew
+     * variable is set, as found by layout analysis.
+     *
+     * @return the skew angle in degrees, with the sign convention of
+     *         Skew.findSkew, or Float.NaN if it is not known
+     */
+    public float getPageSkew() {
+        if (mRecycled)
+            throw new IllegalStateException();
+
+        return nativeGetPageSkew(mNativeData);
+    }
+
+    /**
+     * Recognizes the current image as the next frame of a camera or video
+     * stream. Text lines found in the previous frame are reused when they
+     * have not changed, allowing for movement of the camera, and only
+     * changed lines are recognized again. The whole frame is recognized
+     * again when there is no previous frame, when the image moved too far
+     * or when new text has appeared. Set the <code>stream_max_motion</code>
+     * and <code>stream_line_change_fraction</code> variables to tune this.
+     * <p>
+     * Call {@link #setImage(Pix)} or another setImage method for each frame
+     * first. The frames must all be the same size for results to be reused.
+     *
+     * @return the text of the frame, with a newline after each line, or
+     *         null on error
+     */
+    @WorkerThread
+    public String recognizeFrame() {
+        if (mRecycled)
+            throw new IllegalStateException();
+
+        return nativeRecognizeFrame(mNativeData);
+    }
+
+    /**
+     * Recognizes only the parts of the current image that contain text. The
+     * text lines are first found, as by {@link #detectTextLines()}, on a copy
+     * of the image reduced by <code>reduction</code>, and only the regions
+     * around them are then thresholded and recognized at full resolution.
+     * For camera frames that are mostly not text this is much faster than
+     * {@link #getUTF8Text()}, as the time taken depends on the amount of
+     * text rather than the size of the image.
+     * <p>
+     * The previous rectangle is restored afterwards and the previous
+     * recognition results are cleared.
+     *
+     * @param reduction how much to reduce the image to find the text, 1, 2,
+     *                  4 or 8
+     * @param pageSegMode the page segmentation mode for every region, for
+     *                    example {@link PageSegMode#PSM_SINGLE_BLOCK}
+     * @return the recognized text of the regions from top to bottom, or null
+     *         on error
+     */
+    @WorkerThread
+    public String recognizeTextRegions(int reduction, @PageSegMode.Mode int pageSegMode) {
+        if (mRecycled)
+            throw new IllegalStateException();
+
+        String text = nativeRecognizeTextRegions(mNativeData, reduction, pageSegMode);
+
+        return text != null ? text.trim() : null;
+    }
+
+    /**
+     * Forgets the previous frame, so that the next call to
+     * {@link #recognizeFrame()} recognizes the whole frame.
+     */
+    public void clearFrameHistory() {
+        if (mRecycled)
+            throw new IllegalStateException();
+
+        nativeClearFrameHistory(mNativeData);
+    }
+
+    /**
+     * Prepares for a new document without reinitializing: clears the image
+     * and results as {@link #clear()} does, and forgets the frame history,
+     * the words seen in the document and, unless <code>keepAdaptive</code>,
+     * the adaptive classifier. Loaded language data and variables are kept.
+     *
+     * @param keepAdaptive whether to keep what the adaptive classifier has
+     *            learned so far
+     */
+    public void resetForNewDocument(boolean keepAdaptive) {
+        if (mRecycled)
+            throw new IllegalStateException();
+
+        nativeResetForNewDocument(mNativeData, keepAdaptive);
+    }
+
+    /**
+     * Returns what the adaptive classifier has learned from the pages
+     * recognized so far. Pass it to {@link #loadAdaptiveState(byte[])}, for
+     * example after the app restarts, to start with a trained adaptive
+     * classifier instead of an empty one.
+     * <p>
+     * The state is only valid for the same language and traineddata files.
+     *
+     * @return the saved state, or <code>null</code> if there is no adaptive
+     *         classifier
+     */
+    @WorkerThread
+    public byte[] saveAdaptiveState() {
+        if (mRecycled)
+            throw new IllegalStateException();
+
+        return nativeSaveAdaptiveState(mNativeData);
+    }
+
+    /**
+     * Replaces the adaptive classifier with one returned by
+     * {@link #saveAdaptiveState()}.
+     * <p>
+     * Note that {@link #clear()} forgets the adaptive state again.
+     *
+     * @param state the saved state
+     * @return <code>false</code> if the state is invalid or was saved with
+     *         different language data, in which case nothing is changed
+     */
+    @WorkerThread
+    public boolean loadAdaptiveState(byte[] state) {
+        if (mRecycled)
+            throw new IllegalStateException();
+
+        if (state == null)
+            throw new IllegalArgumentException("State must not be null!");
+
+        return nativeLoadAdaptiveState(mNativeData, state);
+    }
+
+    /**
+     * Returns the values of all the parameters as left by the last
+     * initialization and any later {@link #setVariable}. Pass it to
+     * {@link #setParamsSnapshot(byte[])} before a later initialization with
+     * the same language and configs to skip parsing the config files.
+     *
+     * @return the snapshot, or <code>null</code> if not initialized
+     */
+    public byte[] getParamsSnapshot() {
+        if (mRecycled)
+            throw new IllegalStateException();
+
+        return nativeGetParamsSnapshot(mNativeData);
+    }
+
+    /**
+     * Makes the following initializations set the parameters from a
+     * snapshot returned by {@link #getParamsSnapshot()} instead of reading
+     * the language config and config files. The snapshot is only valid for
+     * the same language, configs and traineddata files.
+     *
+     * @param snapshot the snapshot, or <code>null</code> to stop using one
+     */
+    public void setParamsSnapshot(byte[] snapshot) {
+        if (mRecycled)
+            throw new IllegalStateException();
+
+        nativeSetParamsSnapshot(mNativeData, snapshot);
+    }
+
+    /**
+     * Replaces the character n-gram model used by the language model with a
+     * compiled table in the format of the <code>char-ngram</code> traineddata
+     * component. The model is used while the
+     * <code>language_model_ngram_table_on</code> variable is set, as it is by
+     * default.
+     *
+     * @param table the compiled table
+     * @return <code>false</code> if the table is invalid, in which case
+     *         nothing is changed
+     */
+    public boolean setCharNgramTable(byte[] table) {
+        if (mRecycled)
+            throw new IllegalStateException();
+
+        if (table == null)
+            throw new IllegalArgumentException("Table must not be null!");
+
+        return nativeSetCharNgramTable(mNativeData, table);
+    }
+
+    /**
+     * Returns all the results at the given level in one buffer, so that they
+     * can be read without a JNI call per element. See {@link PackedResults}
+     * for the layout. Runs recognition first if needed.
+     * <p>
+     * The buffer is direct, in native byte order, and points to memory owned
+     * by this object. It is only valid until the next call to this method or
+     * to {@link #end()}.
+     *
+     * @param level the {@link PageIteratorLevel} of the elements to return
+     * @return the packed results, or null on error
+     */
+    @WorkerThread
+    public ByteBuffer getResultsPacked(@PageIteratorLevel.Level int level) {
+        if (mRecycled)
+            throw new IllegalStateException();
+
+        ByteBuffer results = nativeGetResultsPacked(mNativeData, level);
+
+        return results != null ? results.order(ByteOrder.nativeOrder()) : null;
+    }
+
     /**
      * Get a copy of the internal thresholded image from Tesseract.
      * <p>
@@ -660,6 +1527,38 @@ public class TessBaseAPI {
         return new Pix(nativeGetThresholdedImage(mNativeData));
     }
 
+    /**
+     * Quickly finds the text lines of the current image, without
+     * recognizing them and without the column and table analysis of
+     * {@link #getRegions()} or {@link #getTextlines()}. Use it to decide
+     * whether, and where, there is text in a camera frame before running
+     * full recognition. Set the <code>tessedit_layout_reduction</code>
+     * variable to 2 or 4 to make it faster still on large images.
+     * <p>
+     * May be called any time after setImage. The current recognition
+     * results are not changed.
+     *
+     * @return the text lines found, or null on error
+     */
+    @WorkerThread
+    public TextLine[] detectTextLines() {
+        if (mRecycled)
+            throw new IllegalStateException();
+
+        float[] values = nativeDetectTextLines(mNativeData);
+        if (values == null)
+            return null;
+
+        TextLine[] lines = new TextLine[values.length / 5];
+        for (int i = 0; i < lines.length; i++) {
+            Rect bounds = new Rect((int) values[i * 5], (int) values[i * 5 + 1],
+                    (int) values[i * 5 + 2], (int) values[i * 5 + 3]);
+            lines[i] = new TextLine(bounds, values[i * 5 + 4]);
+        }
+
+        return lines;
+    }
+
     /**
      * Returns the result of page layout analysis as a Pixa, in reading order.
      * <p>
@@ -708,7 +1607,9 @@ public class TessBaseAPI {
     /**
      * Get the words as a Pixa, in reading order.
      * <p>
-     * Can be called before or after Recognize.
+     * Can be called before or after Recognize. If only the bounding boxes
+     * are needed, {@link #getComponentBoxes(int, boolean)} gets them without
+     * making an image of every word.
      * 
      * @return Pixa containing word bounding boxes 
      */
@@ -735,6 +1636,52 @@ public class TessBaseAPI {
         return new Pixa(nativeGetConnectedComponents(mNativeData), 0, 0);
     }
 
+    /**
+     * Gets the bounding boxes of the components at the given level, in
+     * reading order, without making their images. The boxes are in the
+     * coordinates of the thresholded image, as in the Pixa returned by
+     * {@link #getRegions()}, {@link #getStrips()}, {@link #getWords()} and
+     * so on, and are packed four ints per component: left, top, right and
+     * bottom.
+     * <p>
+     * Can be called before or after Recognize.
+     *
+     * @param level the level of the components, from
+     *              {@link PageIteratorLevel}
+     * @param textOnly whether to leave out components that are not text
+     * @return the packed boxes, or null on error
+     */
+    public int[] getComponentBoxes(@PageIteratorLevel.Level int level, boolean textOnly) {
+        if (mRecycled)
+            throw new IllegalStateException();
+
+        return nativeGetComponentBoxes(mNativeData, level, textOnly);
+    }
+
+    /**
+     * Gets the thresholded image of the component at the given index in the
+     * boxes returned by {@link #getComponentBoxes(int, boolean)} for the same
+     * level and textOnly, so that images are made only for the components
+     * that are used.
+     * <p>
+     * Caller takes ownership of the Pix and must recycle() it.
+     *
+     * @param level the level of the components, from
+     *              {@link PageIteratorLevel}
+     * @param textOnly whether to leave out components that are not text
+     * @param index the index of the component
+     * @return Pix of the component, or null if there is no such component
+     */
+    public Pix getComponentImage(@PageIteratorLevel.Level int level, boolean textOnly,
+            int index) {
+        if (mRecycled)
+            throw new IllegalStateException();
+
+        long nativePix = nativeGetComponentImage(mNativeData, level, textOnly, index);
+
+        return nativePix != 0 ? new Pix(nativePix) : null;
+    }
+
     /**
      * Get a reading-order iterator to the results of LayoutAnalysis and/or
      * Recognize. The returned iterator must be deleted after use.
@@ -769,6 +1716,24 @@ public class TessBaseAPI {
         return nativeGetHOCRText(mNativeData, page);
     }
 
+    /**
+     * Make HTML with hOCR markup from the internal data structures, as
+     * {@link #getHOCRText(int)} does, but return it as the UTF-8 bytes that
+     * the engine produced. This avoids converting a large document into a
+     * String when it is going to be written to a file or a stream anyway.
+     * Interruptible by {@link #stop()}.
+     *
+     * @param page is 0-based but will appear in the output as 1-based.
+     * @return UTF-8 encoded HTML with hOCR markup, or null on failure
+     */
+    @WorkerThread
+    public byte[] getHOCRBytes(int page) {
+        if (mRecycled)
+            throw new IllegalStateException();
+
+        return nativeGetHOCRBytes(mNativeData, page);
+    }
+
     /**
      * Set the name of the input file. Needed for training and reading a UNLV
      * zone file.
@@ -825,6 +1790,17 @@ public class TessBaseAPI {
         return nativeGetBoxText(mNativeData, page);
     }
 
+    /**
+     * Returns which OpenCL operations currently run on the device and which
+     * on the CPU, one line per operation and image size, with the recent
+     * times of both routes.
+     *
+     * @return the routes, or <code>null</code> if built without OpenCL
+     */
+    public static String getOpenCLRoutes() {
+        return nativeGetOpenCLRoutes();
+    }
+
     /**
      * Returns the version identifier as a string.
      *
@@ -835,7 +1811,11 @@ public class TessBaseAPI {
     }
 
     /**
-     * Cancel recognition started by {@link #getHOCRText(int)}.
+     * Cancel recognition started by {@link #getHOCRText(int)}, and the pages
+     * queued by {@link #recognizeAsync(Pix, RecognitionCallback)}.
+     * <p>
+     * Unlike the other methods, may be called from any thread while another
+     * thread is recognizing with this instance.
      */
     public void stop() {
         if (mRecycled)
@@ -862,14 +1842,109 @@ public class TessBaseAPI {
             final int textLeft, final int textRight, final int textTop, final int textBottom) {
 
         if (progressNotifier != null) {
-            Rect wordRect = new Rect(left, textTop - top, right, textTop - bottom);
-            Rect textRect = new Rect(textLeft, textBottom, textRight, textTop);
-
-            ProgressValues pv = new ProgressValues(percent, wordRect, textRect);
+            ProgressValues pv = newProgressValues(percent, left, right, top,
+                    bottom, textLeft, textRight, textTop, textBottom);
             progressNotifier.onProgressValues(pv);
         }
     }
 
+    private ProgressValues newProgressValues(int percent, int left, int right,
+            int top, int bottom, int textLeft, int textRight, int textTop,
+            int textBottom) {
+        Rect wordRect = new Rect(left, textTop - top, right, textTop - bottom);
+        Rect textRect = new Rect(textLeft, textBottom, textRight, textTop);
+
+        return new ProgressValues(percent, wordRect, textRect);
+    }
+
+    /**
+     * Limits how often progress is sent to the {@link ProgressNotifier}.
+     * After a value has been sent, the next one is only sent once progress
+     * has advanced by at least <code>minPercentStep</code> and at least
+     * <code>minIntervalMs</code> have passed. Fewer callbacks mean fewer
+     * transitions from native code into Java during recognition.
+     * <p>
+     * Both default to 0, which sends every change in progress.
+     *
+     * @param minIntervalMs minimum time between callbacks, in milliseconds
+     * @param minPercentStep minimum change in percent between callbacks
+     */
+    public void setProgressInterval(int minIntervalMs, int minPercentStep) {
+        if (mRecycled)
+            throw new IllegalStateException();
+
+        nativeSetProgressInterval(mNativeData, minIntervalMs, minPercentStep);
+    }
+
+    /**
+     * Stops sending progress to the {@link ProgressNotifier}, and instead
+     * has native code write it into a buffer that can be read from any
+     * thread with {@link #pollProgress()}, for example once per UI frame.
+     * Recognition then never calls into Java to report progress.
+     * <p>
+     * The buffer is direct, in native byte order, and points to memory owned
+     * by this object. See {@link ProgressBuffer} for the layout. It is valid
+     * until {@link #end()}.
+     *
+     * @return the progress buffer
+     */
+    public ByteBuffer startProgressPolling() {
+        if (mRecycled)
+            throw new IllegalStateException();
+
+        mProgressBuffer = nativeSetProgressPolling(mNativeData, true)
+                .order(ByteOrder.nativeOrder());
+
+        return mProgressBuffer;
+    }
+
+    /**
+     * Goes back to sending progress to the {@link ProgressNotifier}.
+     */
+    public void stopProgressPolling() {
+        if (mRecycled)
+            throw new IllegalStateException();
+
+        nativeSetProgressPolling(mNativeData, false);
+        mProgressBuffer = null;
+    }
+
+    /**
+     * Returns the latest progress written since
+     * {@link #startProgressPolling()} was called. May be called from any
+     * thread.
+     *
+     * @return the latest progress, or null if there is none yet or polling
+     *         was not started
+     */
+    public ProgressValues pollProgress() {
+        ByteBuffer buffer = mProgressBuffer;
+        if (buffer == null)
+            return null;
+
+        // Reread until the sequence number shows the values weren't being
+        // written while they were read.
+        while (true) {
+            int sequence = buffer.getInt(ProgressBuffer.SEQUENCE);
+            if (sequence == 0)
+                return null;
+            if ((sequence & 1) != 0)
+                continue;
+            ProgressValues pv = newProgressValues(
+                    buffer.getInt(ProgressBuffer.PERCENT),
+                    buffer.getInt(ProgressBuffer.WORD_LEFT),
+                    buffer.getInt(ProgressBuffer.WORD_RIGHT),
+                    buffer.getInt(ProgressBuffer.WORD_TOP),
+                    buffer.getInt(ProgressBuffer.WORD_BOTTOM),
+                    buffer.getInt(ProgressBuffer.TEXT_LEFT),
+                    buffer.getInt(ProgressBuffer.TEXT_RIGHT),
+                    buffer.getInt(ProgressBuffer.TEXT_TOP),
+                    buffer.getInt(ProgressBuffer.TEXT_BOTTOM));
+            if (buffer.getInt(ProgressBuffer.SEQUENCE) == sequence)
+                return pv;
+        }
+    }
+
     /**
      * Starts a new document. This clears the contents of the output data.
      * 
@@ -921,6 +1996,109 @@ public class TessBaseAPI {
                 imageToWrite, tessPdfRenderer.getNativePdfRenderer());
     }
 
+    /**
+     * Adds the given data to the opened document (if any), embedding the
+     * given JPEG file as the page image as it is instead of encoding the
+     * image again, which is faster and keeps the document from growing. The
+     * image is encoded as usual if the JPEG data does not have its size or
+     * cannot be embedded, as for CMYK files.
+     *
+     * @param imageToProcess image to be used for OCR, decoded from jpegData
+     * @param jpegData contents of the JPEG file to be written into the
+     *            resulting document
+     * @param tessPdfRenderer the renderer instance to use
+     *
+     * @return {@code true} on success. {@code false} on failure
+     */
+    public boolean addPageToDocument(Pix imageToProcess, byte[] jpegData,
+            TessPdfRenderer tessPdfRenderer) {
+        return nativeAddPageToDocumentJpeg(mNativeData, imageToProcess.getNativePix(),
+                jpegData, tessPdfRenderer.getNativePdfRenderer());
+    }
+
+    /**
+     * Recognizes the given images as the pages of a new document, one page
+     * per image, and writes them to it in order. Unlike calling
+     * {@link #addPageToDocument(Pix, String, TessPdfRenderer)} for each page,
+     * the next pages are decoded while earlier ones are recognized, and
+     * several pages are recognized at once by additional engine instances
+     * that are set up like this one and share its language data. A document
+     * then takes about as long as its slowest stage rather than the sum of
+     * them.
+     * <p>
+     * This replaces {@link #beginDocument(TessPdfRenderer, String)} and
+     * {@link #endDocument(TessPdfRenderer)}. It must not be called while
+     * pages queued by {@link #recognizeAsync(Pix, RecognitionCallback)} are
+     * being recognized.
+     *
+     * @param imagePaths paths of the page images, in page order
+     * @param tessPdfRenderer the renderer instance to use
+     * @param title a title to be used in the document metadata
+     * @param numRecognizers number of pages to recognize at once; &lt;= 0
+     *            for the number of cores
+     * @return {@code true} on success. {@code false} if a page could not be
+     *         read or recognized, or the document could not be written
+     */
+    public boolean processDocument(String[] imagePaths, TessPdfRenderer tessPdfRenderer,
+            String title, int numRecognizers) {
+        if (mRecycled)
+            throw new IllegalStateException();
+        if (imagePaths == null)
+            throw new IllegalArgumentException("Image paths must be non-null");
+
+        return nativeProcessDocument(mNativeData, imagePaths, title,
+                tessPdfRenderer.getNativePdfRenderer(), numRecognizers);
+    }
+
+    /**
+     * Recognizes every page of a document and writes it with the given
+     * renderer and the renderers inserted into it, all in one native call.
+     * The document may be a single image, a multi-page TIFF, or a plain text
+     * list of image paths, one per line.
+     * <p>
+     * This replaces {@link #beginDocument(TessPdfRenderer, String)} and
+     * {@link #endDocument(TessPdfRenderer)}.
+     *
+     * @param path path of the document
+     * @param timeoutMillis time a single page may take, or 0 for no limit
+     * @param renderer the renderer instance to use
+     * @return {@code true} on success. {@code false} if a page could not be
+     *         read or recognized, or the output could not be written
+     */
+    public boolean processPages(String path, int timeoutMillis,
+            TessResultRenderer renderer) {
+        if (mRecycled)
+            throw new IllegalStateException();
+        if (path == null)
+            throw new IllegalArgumentException("Path must be non-null");
+
+        return nativeProcessPages(mNativeData, path, timeoutMillis,
+                renderer.getNativeRenderer());
+    }
+
+    /**
+     * Recognizes every page of a document held in memory, as
+     * {@link #processPages(String, int, TessResultRenderer)} does for one in
+     * a file.
+     *
+     * @param data the encoded document
+     * @param name a name for the document in the output, or null
+     * @param timeoutMillis time a single page may take, or 0 for no limit
+     * @param renderer the renderer instance to use
+     * @return {@code true} on success. {@code false} if a page could not be
+     *         read or recognized, or the output could not be written
+     */
+    public boolean processPages(byte[] data, String name, int timeoutMillis,
+            TessResultRenderer renderer) {
+        if (mRecycled)
+            throw new IllegalStateException();
+        if (data == null)
+            throw new IllegalArgumentException("Data must be non-null");
+
+        return nativeProcessPagesFromMemory(mNativeData, data, name, timeoutMillis,
+                renderer.getNativeRenderer());
+    }
+
     /*package*/ long getNativeData() {
         return mNativeData;
     }
@@ -934,6 +2112,10 @@ public class TessBaseAPI {
      */
     private static native void nativeClassInit();
 
+    private static native boolean nativePreloadLanguages(String datapath, String language);
+
+    private static native String nativeGetOpenCLRoutes();
+
     /**
      * Initializes native data. Must be called on object construction.
      */
@@ -945,10 +2127,15 @@ public class TessBaseAPI {
      */
     private native void nativeEnd(long mNativeData);
 
+    private native boolean nativeRecognizeAsync(long mNativeData, long nativePix,
+            RecognitionCallback callback);
+
     private native boolean nativeInit(long mNativeData, String datapath, String language);
 
     private native boolean nativeInitOem(long mNativeData, String datapath, String language, int mode);
 
+    private native boolean nativeInitFromAssets(long mNativeData, AssetManager assets, String language, int mode);
+
     private native String nativeGetInitLanguagesAsString(long mNativeData);
 
     private native void nativeClear(long mNativeData);
@@ -956,18 +2143,80 @@ public class TessBaseAPI {
     private native void nativeSetImageBytes(
             long mNativeData,   byte[] imagedata, int width, int height, int bpp, int bpl);
 
+    private native boolean nativeSetImageDirectBuffer(
+            long mNativeData, ByteBuffer imagedata, int width, int height, int bpp, int bpl);
+
     private native void nativeSetImagePix(long mNativeData, long nativePix);
 
+    private native boolean nativeSetImageYUVBytes(
+            long mNativeData, byte[] data, int width, int height, int rowStride);
+
+    private native boolean nativeSetImageYUVDirectBuffer(
+            long mNativeData, ByteBuffer yPlane, int width, int height, int rowStride);
+
+    private native boolean nativeSetImageBitmap(long mNativeData, Bitmap bitmap);
+
     private native void nativeSetRectangle(long mNativeData, int left, int top, int width, int height);
 
     private native String nativeGetUTF8Text(long mNativeData);
 
+    private native String[] nativeRecognizeRegions(long mNativeData, int[] boxes,
+            int pageSegMode, int[] confidences);
+
+    private native String[][][] nativeRecognizeTables(long mNativeData, int pageSegMode);
+
     private native int nativeMeanConfidence(long mNativeData);
 
     private native int[] nativeWordConfidences(long mNativeData);
 
+    private native double[] nativeGetLayoutTimings(long mNativeData);
+
+    private native double[] nativeGetTimings(long mNativeData);
+
+    private native long[] nativeGetPageCounters(long mNativeData);
+
+    private native long[] nativeGetMemoryUsage(long mNativeData);
+
+    private native void nativeSetPageSkew(long mNativeData, float degrees);
+
+    private native float nativeGetPageSkew(long mNativeData);
+
+    private native ByteBuffer nativeGetResultsPacked(long mNativeData, int level);
+
+    private native void nativeSetProgressInterval(long mNativeData, int minIntervalMs,
+            int minPercentStep);
+
+    private native ByteBuffer nativeSetProgressPolling(long mNativeData, boolean enable);
+
+    private native String nativeRecognizeFrame(long mNativeData);
+
+    private native String nativeRecognizeTextRegions(long mNativeData, int reduction,
+            int pageSegMode);
+
+    private native void nativeClearFrameHistory(long mNativeData);
+
+    private native void nativeResetForNewDocument(long mNativeData, boolean keepAdaptive);
+
+    private native byte[] nativeSaveAdaptiveState(long mNativeData);
+
+    private native boolean nativeLoadAdaptiveState(long mNativeData, byte[] state);
+
+    private native byte[] nativeGetParamsSnapshot(long mNativeData);
+
+    private native void nativeSetParamsSnapshot(long mNativeData, byte[] snapshot);
+
+    private native boolean nativeSetCharNgramTable(long mNativeData, byte[] table);
+
     private native boolean nativeSetVariable(long mNativeData, String var, String value);
 
+    private native int nativeSetVariables(long mNativeData, String[] namesAndValues);
+
+    private native int nativeAddUserWords(long mNativeData, String[] words);
+
+    private native int nativeAddUserPatterns(long mNativeData, String[] patterns);
+
+    private native void nativeClearUserWords(long mNativeData);
+
     private native void nativeSetDebug(long mNativeData, boolean debug);
 
     @PageSegMode.Mode
@@ -981,18 +2230,27 @@ public class TessBaseAPI {
 
     private native long nativeGetTextlines(long mNativeData);
 
+    private native float[] nativeDetectTextLines(long mNativeData);
+
     private native long nativeGetStrips(long mNativeData);
 
     private native long nativeGetWords(long mNativeData);
 
     private native long nativeGetConnectedComponents(long mNativeData);
 
+    private native int[] nativeGetComponentBoxes(long mNativeData, int level, boolean textOnly);
+
+    private native long nativeGetComponentImage(long mNativeData, int level, boolean textOnly,
+            int index);
+
     private native long nativeGetResultIterator(long mNativeData);
 
     private native String nativeGetBoxText(long mNativeData, int page_number);
 
     private native String nativeGetHOCRText(long mNativeData, int page_number);
 
+    private native byte[] nativeGetHOCRBytes(long mNativeData, int page_number);
+
     private native void nativeSetInputName(long mNativeData, String name);
 
     private native void nativeSetOutputName(long mNativeData, String name);
@@ -1008,4 +2266,15 @@ public class TessBaseAPI {
     private native boolean nativeEndDocument(long rendererPointer);
 
     private native boolean nativeAddPageToDocument(long mNativeData, long nativePix, String imagePath, long rendererPointer);
+
+    private native boolean nativeAddPageToDocumentJpeg(long mNativeData, long nativePix, byte[] jpegData, long rendererPointer);
+
+    private native boolean nativeProcessDocument(long mNativeData, String[] imagePaths,
+            String title, long rendererPointer, int numRecognizers);
+
+    private native boolean nativeProcessPages(long mNativeData, String path,
+            int timeoutMillis, long rendererPointer);
+
+    private native boolean nativeProcessPagesFromMemory(long mNativeData, byte[] data,
+            String name, int timeoutMillis, long rendererPointer);
 }
@@ -16,6 +16,8 @@
 
 package com.googlecode.tesseract.android;
 
+import android.os.ParcelFileDescriptor;
+
 /**
  * Java representation of a native Tesseract PDF renderer
  */
@@ -50,6 +52,30 @@ public class TessPdfRenderer {
         mRecycled = false;
     }
 
+    /**
+     * Constructs an instance of a Tesseract PDF renderer that writes to an
+     * open file, such as one obtained from a content provider. Each page is
+     * written out as soon as it has been added, so memory use does not grow
+     * with the number of pages.
+     * 
+     * The renderer writes to its own duplicate of the descriptor, so the
+     * caller may close outputFile once this returns.
+     * 
+     * When the instance of TessPdfRenderer is no longer needed, its 
+     * {@link #recycle} method must be invoked to dispose of it.
+     * 
+     * @param baseApi API instance to use for performing OCR 
+     * @param outputFile Open file to write the resulting PDF to
+     */
+    public TessPdfRenderer(TessBaseAPI baseApi, ParcelFileDescriptor outputFile) {
+        if (outputFile == null)
+            throw new IllegalArgumentException("Output file must be non-null");
+
+        this.mNativePdfRenderer = nativeCreateForFd(baseApi.getNativeData(),
+                outputFile.getFd());
+        mRecycled = false;
+    }
+
     /**
      * @return A pointer to the native TessPdfRenderer object.
      */
@@ -60,6 +86,25 @@ public class TessPdfRenderer {
         return mNativePdfRenderer;
     }
 
+    /**
+     * Makes the renderer encode the image of every page added after this as
+     * a greyscale JPEG reduced by the given factor, rather than at its own
+     * color depth and size, whenever it has to be encoded. The text layer is
+     * unaffected. This makes searchable PDFs much quicker to write and much
+     * smaller. Binary images are always kept as they are.
+     * 
+     * @param reduction Factor to reduce the image by, 1 to convert it to
+     *         greyscale only, or 0, the default, to turn this off
+     */
+    public void setGreyImageReduction(int reduction) {
+        if (mRecycled)
+            throw new IllegalStateException();
+        if (reduction < 0)
+            throw new IllegalArgumentException("Reduction must be non-negative");
+
+        nativeSetGreyImageReduction(mNativePdfRenderer, reduction);
+    }
+
     /**
      * Releases resources and frees any memory associated with this 
      * TessPdfRenderer object. Must be called on object destruction.
@@ -71,6 +116,10 @@ public class TessPdfRenderer {
 
     private static native long nativeCreate(long tessBaseAPINativeData, String outputPath);
 
+    private static native long nativeCreateForFd(long tessBaseAPINativeData, int fd);
+
     private static native void nativeRecycle(long nativePointer);
 
+    private static native void nativeSetGreyImageReduction(long nativePointer, int reduction);
+
 }
\ No newline at end of file
@@ -0,0 +1,142 @@
+/*
+ * Copyright 2015 Robert Theis
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+
+package com.googlecode.tesseract.android;
+
+/**
+ * Java representation of a native Tesseract result renderer, which writes
+ * the recognized pages of a document to a file in one output format.
+ * Renderers can be chained with {@link #insert} so that
+ * {@link TessBaseAPI#processPages(String, int, TessResultRenderer)} writes
+ * every format in a single native call.
+ */
+public class TessResultRenderer {
+
+    /** Plain text, written to outputBase + ".txt" */
+    public static final int FORMAT_TEXT = 0;
+
+    /** hOCR, written to outputBase + ".hocr" */
+    public static final int FORMAT_HOCR = 1;
+
+    /** Tab separated values, written to outputBase + ".tsv" */
+    public static final int FORMAT_TSV = 2;
+
+    /** Searchable PDF, written to outputBase + ".pdf" */
+    public static final int FORMAT_PDF = 3;
+
+    /** UNLV text, written to outputBase + ".unlv" */
+    public static final int FORMAT_UNLV = 4;
+
+    /** Box file text, written to outputBase + ".box" */
+    public static final int FORMAT_BOX = 5;
+
+    /** JSON, written to outputBase + ".json" */
+    public static final int FORMAT_JSON = 6;
+
+    /**
+     * Per-page counts of the recognition work, as tab separated values
+     * indexed like {@link TessBaseAPI.PageCounters}, written to
+     * outputBase + ".counters"
+     */
+    public static final int FORMAT_COUNTERS = 7;
+
+    /**
+     * Used by the native implementation of the class.
+     */
+    private final long mNativeRenderer;
+
+    static {
+        System.loadLibrary("jpgt");
+        System.loadLibrary("pngt");
+        System.loadLibrary("lept");
+        System.loadLibrary("tess");
+    }
+
+    private boolean mRecycled;
+
+    /**
+     * Whether this renderer has been inserted into another one, which then
+     * owns its native object.
+     */
+    private boolean mInserted;
+
+    /**
+     * Constructs an instance of a Tesseract result renderer.
+     *
+     * When the instance of TessResultRenderer is no longer needed, its
+     * {@link #recycle} method must be invoked to dispose of it.
+     *
+     * @param baseApi API instance to use for performing OCR
+     * @param outputBase Full path to write the output to, not including
+     *         the extension of the format
+     * @param format One of the FORMAT_ constants
+     */
+    public TessResultRenderer(TessBaseAPI baseApi, String outputBase, int format) {
+        if (outputBase == null)
+            throw new IllegalArgumentException("Output base must be non-null");
+
+        this.mNativeRenderer = nativeCreate(baseApi.getNativeData(), outputBase, format);
+        if (mNativeRenderer == 0)
+            throw new IllegalArgumentException("Unknown format " + format);
+        mRecycled = false;
+        mInserted = false;
+    }
+
+    /**
+     * Adds next to the renderers that are given each page this one is given.
+     * This renderer takes ownership of next, so next must not be used on its
+     * own afterwards, and recycling this renderer recycles next as well.
+     *
+     * @param next Renderer to add
+     */
+    public void insert(TessResultRenderer next) {
+        if (next == this || next.mInserted)
+            throw new IllegalArgumentException("Renderer is already inserted");
+
+        nativeInsert(getNativeRenderer(), next.getNativeRenderer());
+        next.mInserted = true;
+    }
+
+    /**
+     * @return A pointer to the native TessResultRenderer object.
+     */
+    public long getNativeRenderer() {
+        if (mRecycled)
+            throw new IllegalStateException();
+
+        return mNativeRenderer;
+    }
+
+    /**
+     * Releases resources and frees any memory associated with this
+     * TessResultRenderer object and the renderers inserted into it. Must be
+     * called on object destruction. Does nothing for a renderer that has
+     * been inserted into another one.
+     */
+    public void recycle() {
+        if (!mInserted && !mRecycled)
+            nativeRecycle(mNativeRenderer);
+        mRecycled = true;
+    }
+
+    private static native long nativeCreate(long tessBaseAPINativeData, String outputBase,
+            int format);
+
+    private static native void nativeInsert(long nativePointer, long nextPointer);
+
+    private static native void nativeRecycle(long nativePointer);
+
+}